@@ -70,6 +70,8 @@
   SEL action;
 
   GSColorWheelMarker *marker;
+  NSBitmapImageRep *wheelRep;
+  NSBitmapImageRep *shadedRep;
   NSImage *image;
 }
 
@@ -77,6 +79,7 @@
 -(float) saturation;
 
 -(void) regenerateImage;
+-(void) shadeImage;
 -(NSRect) markerRect;
 
 -(void) setHue: (float)h saturation: (float)s brightness: (float)brightness;
@@ -115,6 +118,8 @@
 -(void) dealloc
 {
   [image release];
+  [wheelRep release];
+  [shadedRep release];
   [[NSNotificationCenter defaultCenter] removeObserver: self];
   [super dealloc];
 }
@@ -170,14 +175,15 @@
   
   if (hue != h || saturation != s || brightness != b)
     {
-      BOOL regenerate = (brightness != b);
+      if (brightness != b)
+	{
+	  /* The wheel is shaded again before it is next drawn. */
+	  DESTROY(image);
+	}
       
       hue = h;
       saturation = s;
       brightness = b;
-      
-      if (regenerate)
-	[self regenerateImage];
     
       [marker setFrame: [self markerRect]];
 
@@ -185,13 +191,17 @@
     }
 }
 
+/* Computes the wheel at full brightness for the current size.  Every
+   component of a color scales with its brightness, so -shadeImage can
+   derive the wheel for any brightness from this one. */
 -(void) regenerateImage
 {
   NSSize size = [self convertSizeToBase: [self bounds].size];
   CGFloat cx, cy, cr;
 
-  [image release];
-  image = nil;
+  DESTROY(image);
+  DESTROY(wheelRep);
+  DESTROY(shadedRep);
 
   cx = (size.width) / 2;
   cy = (size.height) / 2;
@@ -252,7 +262,7 @@
 	      if (s > 1)
 		s = 1;
 
-	      v = brightness;
+	      v = 1;
 	    }
 
 	    // calculate R,G,B from h,s,v
@@ -303,17 +313,67 @@
 	  }
       }
 
-    image = [[NSImage alloc] initWithSize: [self bounds].size];
-    [image addRepresentation: bmp];
-    [bmp release];
+    wheelRep = bmp;
   }
 }
 
+/* Makes the image to draw by scaling the colors of the full brightness
+   wheel to the current brightness.  This only takes a table lookup per
+   component, so it keeps up with the brightness slider. */
+-(void) shadeImage
+{
+  unsigned char scale[256];
+  const unsigned char *src;
+  unsigned char *dst;
+  NSUInteger i, count;
+
+  if (nil == wheelRep)
+    {
+      [self regenerateImage];
+      if (nil == wheelRep)
+	return;
+    }
+  if (nil == shadedRep)
+    {
+      shadedRep = [[NSBitmapImageRep alloc]
+		    initWithBitmapDataPlanes: NULL
+				  pixelsWide: [wheelRep pixelsWide]
+				  pixelsHigh: [wheelRep pixelsHigh]
+			       bitsPerSample: 8
+			     samplesPerPixel: 4
+				    hasAlpha: YES
+				    isPlanar: NO
+			      colorSpaceName: NSCalibratedRGBColorSpace
+				 bytesPerRow: [wheelRep bytesPerRow]
+				bitsPerPixel: 32];
+    }
+
+  for (i = 0; i < 256; i++)
+    {
+      scale[i] = (unsigned char)(i * brightness + 0.5);
+    }
+
+  src = [wheelRep bitmapData];
+  dst = [shadedRep bitmapData];
+  count = [wheelRep bytesPerRow] * [wheelRep pixelsHigh];
+  for (i = 0; i + 3 < count; i += 4)
+    {
+      dst[i] = scale[src[i]];
+      dst[i + 1] = scale[src[i + 1]];
+      dst[i + 2] = scale[src[i + 2]];
+      dst[i + 3] = src[i + 3];
+    }
+
+  /* A new image, so that no cached copy of the old shade is drawn. */
+  image = [[NSImage alloc] initWithSize: [self bounds].size];
+  [image addRepresentation: shadedRep];
+}
+
 -(void) drawRect: (NSRect)rect
 {
   if (nil == image)
     {
-      [self regenerateImage];
+      [self shadeImage];
     }
 
   [image drawInRect: [self bounds]
@@ -55,6 +55,9 @@
 /**
  * GSAnimator is the front of a class cluster. Instances of a subclass of 
  * GSAnimator manage the timing of an animation.
+ * All running animators are stepped together at the frame clock of the
+ * window display (see the GSAutodisplayFrameRate default), after which
+ * the windows they changed are displayed in one pass.
  */
 @interface GSAnimator : NSObject
 {
@@ -67,12 +70,11 @@
 
   NSArray *_runLoopModes;
   
-  NSTimer *_timer;            // Timer used for looping
-  NSTimeInterval _timerInterval;
+  NSTimeInterval _timerInterval; // 0 to step on every frame
 }
 
 /** Returns a GSAnimator object initialized with the specified object
- * to be animated as fast as possible. */
+ * to be animated on every frame. */
 + (GSAnimator*) animatorWithAnimation: (id<GSAnimation>)anAnimation;
 
 /** Returns a GSAnimator object initialized with the specified object
@@ -0,0 +1,78 @@
+/* GSDisplayList.h                                           -*-objc-*-
+
+   Recording drawing operators for replay
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of the GNUstep GUI Library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; see the file COPYING.LIB.
+   If not, see <http://www.gnu.org/licenses/> or write to the 
+   Free Software Foundation, 51 Franklin Street, Fifth Floor, 
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef _GNUstep_H_GSDISPLAY_LIST_
+#define _GNUstep_H_GSDISPLAY_LIST_
+
+#import <Foundation/NSObject.h>
+#import <AppKit/NSGraphicsContext.h>
+
+@class NSMutableArray;
+@class NSView;
+
+/**
+ * A display list holds a stream of drawing operators as recorded by a
+ * GSRecordingContext, and draws them again in any other context.
+ * Numbers are kept in a compact array and the objects the operators
+ * name (paths, images, fonts, transforms) are retained, so replaying a
+ * list sends the operators straight through the method table of the
+ * target context without recomputing the drawing.  Display lists can
+ * be archived and compared, for instance by tests.
+ */
+@interface GSDisplayList : NSObject <NSCoding, NSCopying>
+{
+  unsigned char *ops;
+  NSUInteger opCount;
+  NSUInteger opCapacity;
+  double *args;
+  NSUInteger argCount;
+  NSUInteger argCapacity;
+  NSMutableArray *objects;
+}
++ (GSDisplayList *) displayListForView: (NSView *)view rect: (NSRect)rect;
+
+- (NSUInteger) operatorCount;
+- (void) replayInContext: (NSGraphicsContext *)ctxt;
+- (void) removeAllOperators;
+@end
+
+/**
+ * A graphics context which draws nothing, and records the operators
+ * sent to it in a display list instead.  It keeps enough of a graphics
+ * state to answer the queries drawing code usually makes, such as the
+ * current matrix, point and line width.
+ */
+@interface GSRecordingContext : NSGraphicsContext
+{
+  GSDisplayList *displayList;
+  void *gstates;
+  NSUInteger gstateCount;
+  NSUInteger gstateCapacity;
+}
+- (id) initWithDisplayList: (GSDisplayList *)list;
+- (GSDisplayList *) displayList;
+@end
+
+#endif /* _GNUstep_H_GSDISPLAY_LIST_ */
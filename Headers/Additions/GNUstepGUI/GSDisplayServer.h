@@ -66,6 +66,8 @@ APPKIT_EXPORT NSString *GSScreenNumber;
   NSMutableDictionary	*server_info;
   NSMutableArray	*event_queue;
   NSMapTable		*drag_types;
+  void			*_transaction;
+  void			*_windowPool;
 }
 
 + (void) setDefaultServerClass: (Class)aClass;
@@ -103,6 +105,7 @@ APPKIT_EXPORT NSString *GSScreenNumber;
 - (NSWindowDepth) windowDepthForScreen: (NSInteger)screen;
 - (const NSWindowDepth *) availableDepthsForScreen: (NSInteger)screen;
 - (NSArray *) screenList;
+- (double) refreshRateForScreen: (NSInteger)screen;
 
 - (void *) serverDevice;
 - (void *) windowDevice: (NSInteger)win;
@@ -152,6 +155,8 @@ APPKIT_EXPORT NSString *GSScreenNumber;
 - (void) setminsize: (NSSize)size : (NSInteger)win;
 - (void) setresizeincrements: (NSSize)size : (NSInteger)win;
 - (void) flushwindowrect: (NSRect)rect : (NSInteger)win;
+- (void) flushwindowrects: (const NSRect*)rects : (NSUInteger)count
+                         : (NSInteger)win;
 - (void) styleoffsets: (CGFloat*)l : (CGFloat*)r : (CGFloat*)t : (CGFloat*)b 
                      : (NSUInteger)style;
 - (void) docedited: (NSInteger) edited : (NSInteger)win;
@@ -178,6 +183,34 @@ APPKIT_EXPORT NSString *GSScreenNumber;
 
 @end
 
+/* ----------------------------------------------------------------------- */
+/* GNUstep Window transactions */
+/* ----------------------------------------------------------------------- */
+@interface GSDisplayServer (WindowTransactions)
+- (void) beginWindowTransaction;
+- (void) commitWindowTransaction;
+- (BOOL) isInWindowTransaction;
+- (void) queuetitlewindow: (NSString *)window_title : (NSInteger)win;
+- (void) queueorderwindow: (NSInteger)op : (NSInteger)otherWin
+			 : (NSInteger)win;
+- (void) queueplacewindow: (NSRect)frame : (NSInteger)win;
+- (void) queuesetinputfocus: (NSInteger)win;
+- (void) discardQueuedOperationsForWindow: (NSInteger)win;
+@end
+
+/* ----------------------------------------------------------------------- */
+/* GNUstep Window pool */
+/* ----------------------------------------------------------------------- */
+@interface GSDisplayServer (WindowPool)
+- (NSInteger) leasewindow: (NSRect)frame : (NSBackingStoreType)type
+			 : (NSUInteger)style : (NSInteger)screen
+			 : (BOOL*)reused;
+- (void) returnwindow: (NSInteger)win : (NSBackingStoreType)type
+		     : (NSUInteger)style : (NSInteger)screen;
+- (void) fillWindowPool: (NSInteger)screen;
+- (void) emptyWindowPool;
+@end
+
 /* ----------------------------------------------------------------------- */
 /* GNUstep Event Operations */
 /* ----------------------------------------------------------------------- */
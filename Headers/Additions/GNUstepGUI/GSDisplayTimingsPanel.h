@@ -0,0 +1,66 @@
+/* GSDisplayTimingsPanel.h                                   -*-objc-*-
+
+   A GNUstep panel for finding slow windows and views.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of the GNUstep GUI Library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; see the file COPYING.LIB.
+   If not, see <http://www.gnu.org/licenses/> or write to the 
+   Free Software Foundation, 51 Franklin Street, Fifth Floor, 
+   Boston, MA 02110-1301, USA.
+*/
+
+/*
+ * Class displaying a panel showing the display timings of windows.
+ *
+ */
+
+#ifndef _GNUstep_H_GSDISPLAY_TIMINGS_PANEL_
+#define _GNUstep_H_GSDISPLAY_TIMINGS_PANEL_
+
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSPanel.h>
+
+@class NSTableView;
+@class NSMutableArray;
+
+@interface GSDisplayTimingsPanel: NSPanel
+{
+  NSTableView *windowTable;
+  NSTableView *viewTable;
+  NSMutableArray *windows;
+  NSMutableArray *timings;
+}
++ (id) sharedDisplayTimingsPanel;
+
+/* Updates the timings */
++ (void) update: (id)sender;
+- (void) update: (id)sender;
+
+/* Discards the timings recorded so far */
+- (void) reset: (id)sender;
+@end
+
+@interface NSApplication (GSDisplayTimingsPanel)
+- (void) orderFrontSharedDisplayTimingsPanel: (id)sender;
+
+/* Shows the input latency statistics in a small window floating over
+   the others, updated every second, and turns their recording on.  The
+   GSInputLatencyOverlay user default shows it at launch. */
+- (void) orderFrontInputLatencyOverlay: (id)sender;
+@end
+
+#endif /* _GNUstep_H_GSDISPLAY_TIMINGS_PANEL_ */
@@ -110,6 +110,11 @@
   // YES if we are currently dragging
   BOOL		isDragging;
 
+  // Position, time and view of the last dragging update sent to the target
+  NSPoint	lastUpdatePosition;
+  NSTimeInterval	lastUpdateTime;
+  NSView	*lastUpdateView;	// Only compared, not retained
+
   // Cache for cursors
   NSMutableDictionary	*cursors;
 }
@@ -43,14 +43,24 @@
   NSArray *allFontNames;
   NSMutableDictionary *allFontFamilies;
   NSArray *allFontDescriptors;
+
+  /* Indexes into the font list, built on first use. */
+  NSMutableDictionary *fontNamesByTraits;
+  NSMutableDictionary *fontDescriptorsByName;
+  NSMutableDictionary *fontDescriptorsByFamily;
+  NSMutableDictionary *fontDescriptorsByTraits;
 }
 
 + (void) setDefaultClass: (Class)defaultClass;
 + (GSFontEnumerator*) sharedEnumerator;
 - (void) enumerateFontsAndFamilies;
+/* Enumerates the fonts again, after fonts have been installed or
+   removed, and drops the indexes built on the old font list. */
+- (void) refreshFontList;
 - (NSArray*) availableFonts;
 - (NSArray*) availableFontFamilies;
 - (NSArray*) availableMembersOfFontFamily: (NSString*)family;
+- (NSArray*) availableFontNamesWithTraits: (NSFontTraitMask)fontTraitMask;
 - (NSArray*) availableFontDescriptors;
 - (NSArray *) availableFontNamesMatchingFontDescriptor: (NSFontDescriptor *)descriptor;
 - (NSArray *) matchingFontDescriptorsFor: (NSDictionary *)attributes;
@@ -89,6 +99,7 @@ values. Backends may override these. */
   unsigned numberOfGlyphs;
   NSCharacterSet *coveredCharacterSet;
   NSFontDescriptor *fontDescriptor;
+  void *glyphMetrics;		/* Cached advancements and bounding rects. */
 }
 
 + (GSFontInfo*) fontInfoForFontName: (NSString*)fontName 
@@ -99,6 +110,15 @@ values. Backends may override these. */
 + (int) weightForString: (NSString*)weightString;
 
 - (NSSize) advancementForGlyph: (NSGlyph)aGlyph;
+/* Return the advancements and bounding rects of count glyphs. The
+   metrics are asked for once per glyph with -advancementForGlyph: and
+   -boundingRectForGlyph: and kept in a table afterwards. */
+- (void) getAdvancements: (NSSize*)advancements
+	       forGlyphs: (const NSGlyph*)glyphs
+		   count: (NSUInteger)count;
+- (void) getBoundingRects: (NSRect*)bounds
+		forGlyphs: (const NSGlyph*)glyphs
+		    count: (NSUInteger)count;
 - (NSDictionary*) afmDictionary;
 - (NSString*) afmFileContents;
 - (void) appendBezierPathWithGlyphs: (NSGlyph*)glyphs
@@ -33,13 +33,31 @@
 #import <AppKit/NSBitmapImageRep.h>
 
 @class NSData;
+@class NSString;
+
+/** Posted on the main thread when a raster which was produced in the
+ * background has been cached.  The object is the image rep, which will
+ * draw sharper the next time it is drawn at that resolution.
+ */
+APPKIT_EXPORT NSString *GSGhostscriptImageRepDidRasterizeNotification;
 
 @interface GSGhostscriptImageRep : NSImageRep
 {
   NSBitmapImageRep *_bitmap;
   NSData *_psData;
+  NSUInteger _digest;
+  BOOL _rasterizing;
 }
 
+/** Sets whether a rep drawn at a resolution it has no raster for draws
+ * the sharpest raster it has at a lower resolution and lets Ghostscript
+ * produce the one it needs in a background thread, rather than waiting
+ * for Ghostscript.  The default is the GSGhostscriptAsynchronousRasterization
+ * user default, or NO.
+ */
++ (void) setRasterizesAsynchronously: (BOOL)flag;
++ (BOOL) rasterizesAsynchronously;
+
 @end
 
 #endif // _GNUstep_H_GSGhostscriptImageRep
@@ -66,6 +66,8 @@
   struct GSHorizontalTypesetter_glyph_cache_s *cache;
   NSUInteger cache_base, cache_size, cache_length;
   BOOL at_end;
+  /* Glyphs found in the cache and glyphs fetched, during one call. */
+  NSUInteger cache_hits, cache_misses;
 
 
   struct GSHorizontalTypesetter_line_frag_s *line_frags;
@@ -29,12 +29,14 @@
 #define _GNUstep_H_GSLayoutManager
 
 #import <Foundation/NSObject.h>
+#import <Foundation/NSDate.h>
 #import <Foundation/NSGeometry.h>
 #import <AppKit/NSFont.h>
 #import <AppKit/NSGlyphGenerator.h>
 
 @class GSTypesetter;
 @class NSTextStorage,NSTextContainer;
+@class NSDictionary;
 
 typedef enum
 {
@@ -97,9 +99,17 @@ how it's supposed to work. It's functional and correct, but it isn't fast. */
   NSTextContainer *extra_textcontainer;
 
 
-  /* For -rectArrayForGlyphRange:... */
+  /* Incremented whenever existing layout is invalidated. */
+  NSUInteger layout_generation;
+
+  /* For -rectArrayForGlyphRange:... The rects of the last call are cached
+  for the given glyph range and container until the layout changes. */
   NSRect *rect_array;
   int rect_array_size;
+  NSTextContainer *rect_cache_container;
+  NSRange rect_cache_range;
+  NSUInteger rect_cache_generation;
+  NSUInteger rect_cache_count;
 
 
   /*
@@ -109,6 +119,31 @@ how it's supposed to work. It's functional and correct, but it isn't fast. */
   */
   struct GSLayoutManager_glyph_run_s *cached_run;
   NSUInteger cached_pos, cached_cpos;
+
+  /*
+  Flat index of the created runs, in text order, with their starting
+  character and glyph positions. It lets -run_for_glyph_index::: and
+  -run_for_character_index::: do a binary search instead of walking the
+  skip list. Only the first run_index_length entries are valid for
+  character lookups and only the first run_index_glyphs of them for glyph
+  lookups. The index is extended lazily and truncated on invalidation.
+  */
+  struct GSLayoutManager_glyph_run_index_s *run_index;
+  NSUInteger run_index_length, run_index_glyphs, run_index_size;
+
+  /*
+  Counters for -layoutStatistics. Each count is also added to the totals
+  of all layout managers.
+  */
+  struct GSLayoutManager_statistics_s
+    {
+      NSUInteger glyphs_generated;
+      NSUInteger runs_created, runs_split;
+      NSUInteger hard_invalidations, soft_invalidations;
+      NSUInteger linefrags_laid_out, linefrags_reused;
+      NSTimeInterval typesetter_time;
+      NSUInteger glyph_cache_hits, glyph_cache_misses;
+    } statistics;
 }
 
 
@@ -168,6 +203,20 @@ If characters have been edited, lengthChange has the text length delta.
 forStartingGlyphAtIndex: (NSUInteger)glyph
        characterIndex: (NSUInteger)index;
 
+/**
+ * GNUstep extension. Returns what the receiver has done so far, to find
+ * out why layout is slow.
+ */
+- (NSDictionary *) layoutStatistics;
+- (void) resetLayoutStatistics;
+
+/**
+ * GNUstep extension. Returns the statistics of all layout managers
+ * together, including those that have been deallocated.
+ */
++ (NSDictionary *) layoutStatistics;
++ (void) resetLayoutStatistics;
+
 
 @end
 
@@ -367,6 +416,8 @@ just the union of all the line frag rects?) */
 
 - (NSUInteger) firstUnlaidCharacterIndex;
 - (NSUInteger) firstUnlaidGlyphIndex;
+/* A number which changes whenever existing layout is invalidated. */
+- (NSUInteger) layoutGeneration;
 - (void) getFirstUnlaidCharacterIndex: (NSUInteger *)charIndex
 	glyphIndex: (NSUInteger *)glyphIndex;
 
@@ -382,9 +433,27 @@ layout information.
 			   firstGlyph: (NSUInteger *)first_glyph
 			    nextGlyph: (NSUInteger *)next_glyph
 		      inTextContainer: (NSTextContainer *)textContainer;
+/*
+Returns how many soft-invalidated line frags, starting with the first one,
+can be reused in one go when moved down by shift without going below maxY.
+The (unshifted) rect of the last of them and the glyph following it are
+returned in last_rect and next_glyph.
+*/
+-(NSInteger) _softInvalidateNumberOfReusableLineFragsWithShift: (CGFloat)shift
+							   maxY: (CGFloat)maxY
+						       lastRect: (NSRect *)last_rect
+						      nextGlyph: (NSUInteger *)next_glyph
+						inTextContainer: (NSTextContainer *)textContainer;
 -(NSUInteger) _softInvalidateFirstGlyphInTextContainer: (NSTextContainer *)textContainer;
 -(NSUInteger) _softInvalidateNumberOfLineFragsInTextContainer: (NSTextContainer *)textContainer;
 
+/*
+Lets the typesetter report, for -layoutStatistics, how many of the glyphs
+it needed it had cached already and how many it had to fetch.
+*/
+-(void) _addGlyphCacheHits: (NSUInteger)hits
+		    misses: (NSUInteger)misses;
+
 @end
 
 
@@ -139,6 +139,31 @@ typedef struct GSLayoutManager_glyph_run_s
 } glyph_run_t;
 
 
+/*
+Entry in the flat run index (see the run_index ivar). char_pos is valid
+for all entries, glyph_pos only for the leading entries whose runs (and all
+runs before them) have had their glyphs generated.
+*/
+typedef struct GSLayoutManager_glyph_run_index_s
+{
+  glyph_run_t *run;
+  NSUInteger glyph_pos, char_pos;
+} glyph_run_index_t;
+
+
+/*
+The statistics of all layout managers (see the statistics ivar).
+GS_LAYOUT_COUNT adds n to a counter of self and to the total.
+*/
+extern struct GSLayoutManager_statistics_s GSLayoutManagerTotalStatistics;
+
+#define GS_LAYOUT_COUNT(field, n) \
+  { \
+    statistics.field += (n); \
+    GSLayoutManagerTotalStatistics.field += (n); \
+  }
+
+
 /* All positions and lengths in glyphs */
 typedef struct
 {
@@ -206,6 +231,65 @@ typedef struct GSLayoutManager_textcontainer_s
 } textcontainer_t;
 
 
+/*
+The significant line frags of a text container are sorted both by glyph
+and by y, so they double as an index for lookups by glyph or by point.
+These return the index of the first line frag in tc matching the
+condition, or tc->num_linefrags if there is none.
+*/
+
+/* First line frag that ends after glyph. */
+static inline NSInteger
+GSLinefragIndexForGlyph(textcontainer_t *tc, NSUInteger glyph)
+{
+  NSInteger lo = 0, hi = tc->num_linefrags, mid;
+
+  while (lo < hi)
+    {
+      mid = (lo + hi) / 2;
+      if (tc->linefrags[mid].pos + tc->linefrags[mid].length > glyph)
+	hi = mid;
+      else
+	lo = mid + 1;
+    }
+  return lo;
+}
+
+/* First line frag whose bottom edge is at or below y. */
+static inline NSInteger
+GSLinefragIndexForMaxY(textcontainer_t *tc, CGFloat y)
+{
+  NSInteger lo = 0, hi = tc->num_linefrags, mid;
+
+  while (lo < hi)
+    {
+      mid = (lo + hi) / 2;
+      if (NSMaxY(tc->linefrags[mid].rect) >= y)
+	hi = mid;
+      else
+	lo = mid + 1;
+    }
+  return lo;
+}
+
+/* First line frag whose top edge is below y. */
+static inline NSInteger
+GSLinefragIndexAfterMinY(textcontainer_t *tc, CGFloat y)
+{
+  NSInteger lo = 0, hi = tc->num_linefrags, mid;
+
+  while (lo < hi)
+    {
+      mid = (lo + hi) / 2;
+      if (NSMinY(tc->linefrags[mid].rect) > y)
+	hi = mid;
+      else
+	lo = mid + 1;
+    }
+  return lo;
+}
+
+
 
 @interface GSLayoutManager (GlyphsHelpers)
 
@@ -244,6 +328,18 @@ typedef struct GSLayoutManager_textcontainer_s
 -(void) _doLayoutToContainer: (NSInteger)cindex;
 
 -(void) _didInvalidateLayout;
+
+-(BOOL) _needsBackgroundLayout;
+-(void) _scheduleBackgroundLayout;
+-(void) _backgroundLayout;
+
+/*
+Called after background layout has laid out the glyphs in glyphRange.
+Does nothing in GSLayoutManager; NSLayoutManager tells its text views.
+*/
+-(void) _didLayoutGlyphRange: (NSRange)glyphRange;
+
+-(NSRect) _estimatedUsedRectForTextContainer: (NSTextContainer *)container;
 @end
 
 
@@ -37,6 +37,8 @@
 #import <AppKit/NSApplication.h>
 #import <AppKit/NSPanel.h>
 
+@class NSArray;
+@class NSDictionary;
 @class NSTableView;
 @class NSMutableArray;
 
@@ -45,11 +47,26 @@
   NSTableView *table;
   NSMutableArray *array;
   /* Are we ordering by class name, or by count or total or peak number 
-     of instances ? */
+     of instances, or by allocation or deallocation rate ? */
   SEL orderingBy;
+  NSTableView *cacheTable;
+  NSArray *caches;
 }
 + (id) sharedMemoryPanel;
 
+/* Returns a dictionary for each class with allocation debugging data,
+   with the keys Class (the class name), Count, Total and Peak (as from
+   GSDebugAllocationCount() and friends), and AllocationsPerSecond and
+   DeallocationsPerSecond, the rates since the previous call (zero on
+   the first call).  Calling this turns allocation debugging on. */
++ (NSArray *) allocationStatistics;
+
+/* Returns the statistics of the caches kept by the GUI library, keyed
+   by Images, StringDrawing, Fonts, TextAttributes, ThemeTiles and
+   Icons.  Each value is the dictionary returned by the statistics
+   method of that cache, such as +[NSImage imageCacheStatistics]. */
++ (NSDictionary *) cacheStatistics;
+
 /* Updates the statistics */
 + (void) update: (id)sender;
 - (void) update: (id)sender;
@@ -30,8 +30,11 @@
 #define _GNUstep_H_GSModelLoaderFactory
 
 #import <Foundation/NSObject.h>
+#import <Foundation/NSDate.h>
 #import <Foundation/NSZone.h>
+#import <AppKit/AppKitDefines.h>
 
+@class NSArray;
 @class NSData;
 @class NSDictionary;
 @class NSString;
@@ -47,8 +50,32 @@
      externalNameTable: (NSDictionary *)context
               withZone: (NSZone *)zone;
 - (NSData *)dataForFile: (NSString *)fileName;
++ (NSArray *) loadProfileReports;
 @end
 
+/*
+ * Profiling of model loads.  When the GSModelLoadProfile user default is
+ * YES, a report of the time spent in each step of every model load is
+ * logged.  When it is an absolute path, the reports of all loads are
+ * written to that file as a property list instead.
+ *
+ * GSModelLoadProfileOpen() starts the report for a model file and returns
+ * the report of any enclosing load, to be passed to GSModelLoadProfileClose().
+ * Within it loaders time the steps read, parse, decode, instantiate,
+ * connect and awake by calling GSModelLoadProfileBegin() and passing its
+ * result to GSModelLoadProfileEndStep().  The work on each object within
+ * a step is timed the same way with GSModelLoadProfileEnd(), which adds
+ * the time, less that of nested timings, to the class of the object.
+ * All of them do nothing when profiling is off.
+ */
+APPKIT_EXPORT id GSModelLoadProfileOpen(NSString *fileName);
+APPKIT_EXPORT void GSModelLoadProfileClose(id previous);
+APPKIT_EXPORT NSTimeInterval GSModelLoadProfileBegin(void);
+APPKIT_EXPORT void GSModelLoadProfileEnd(NSTimeInterval start,
+                                         NSString *step, id object);
+APPKIT_EXPORT void GSModelLoadProfileEndStep(NSTimeInterval start,
+                                             NSString *step);
+
 @interface GSModelLoaderFactory : NSObject
 + (void) registerModelLoaderClass: (Class)aClass;
 + (Class)classForType: (NSString *)type;
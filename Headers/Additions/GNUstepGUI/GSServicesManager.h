@@ -36,6 +36,7 @@
 
 @class	NSApplication;
 @class	NSArray;
+@class	NSData;
 @class	NSDate;
 @class	NSMenu;
 @class	NSMenuItem;
@@ -60,6 +61,8 @@
   NSDate		*_servicesStamp;
   NSMutableSet		*_allDisabled;
   NSMutableDictionary	*_allServices;
+  NSData		*_servicesData;
+  NSMutableDictionary	*_requestors;
   NSTimer		*_timer;
   NSString		*_port;
 }
@@ -209,6 +209,10 @@
   // YES if there is a prisoner in that GSTable position. 
   // (to avoid creating a jail if there is no prisoner to control). 
   BOOL *_havePrisoner;
+  // Nesting of -beginUpdates, and YES if the jails must be moved and 
+  // resized at the matching -endUpdates. 
+  int _updatesDisabled;
+  BOOL _needsWholeUpdate;
 }
 //
 // Initizialing.  
@@ -377,6 +381,19 @@ is not supported.
 
 /** Return the number of columns in the GSTable.  */
 -(int) numberOfColumns;
+//
+// Batching Updates
+//
+/** Stop moving and resizing the jails as views are put in the table
+    or the table is resized, until the matching -endUpdates.  Building 
+    a large table between -beginUpdates and -endUpdates places each 
+    prisoner once, instead of moving all the views to the right or above 
+    of each new view which makes its column or row grow.  Calls nest. */
+-(void) beginUpdates;
+
+/** Balance a -beginUpdates.  The last one places all the jails for the 
+    current sizes of the rows and columns. */
+-(void) endUpdates;
 @end
 
 #endif /* _GNUstep_H_GSTable */
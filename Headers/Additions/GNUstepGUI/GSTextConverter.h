@@ -38,6 +38,9 @@
 @class NSData;
 @class NSDictionary;
 @class NSError;
+@class NSFileWrapper;
+@class NSInputStream;
+@class NSMutableAttributedString;
 @class NSString;
 
 @protocol GSTextConverter
@@ -64,4 +67,34 @@
 			    class: (Class)class;
 @end
 
+/*
+ * Consumers of a package format such as RTFD implement this to read the
+ * document from a file wrapper, so that the files of a package read from
+ * disk are only read when used rather than all serialized first.
+ */
+@protocol GSFileWrapperTextConsumer
++ (NSAttributedString*) parseFile: (NSFileWrapper *)wrapper
+                          options: (NSDictionary *)options
+	       documentAttributes: (NSDictionary **)dict
+                            error: (NSError **)error
+			    class: (Class)class;
+@end
+
+/*
+ * Consumers able to read a document piece by piece implement this too.
+ * The document is read from the stream in chunks and appended to the
+ * end of target as it is parsed, so the whole document never has to be
+ * in memory.  An NSTextStorage target processes its edits after each
+ * chunk.  -cancel may be sent from another thread, or from code run by
+ * the target while parsing, and makes the parsing method return NO with
+ * an NSUserCancelledError; the text read so far stays in target.
+ */
+@protocol GSStreamingTextConsumer
+- (BOOL) parseStream: (NSInputStream *)stream
+intoAttributedString: (NSMutableAttributedString *)target
+  documentAttributes: (NSDictionary **)dict
+	       error: (NSError **)error;
+- (void) cancel;
+@end
+
 #endif // _GNUstep_H_GSTextConverter
@@ -381,6 +381,20 @@ APPKIT_EXPORT	NSString	*GSThemeWillActivateNotification;
  */
 APPKIT_EXPORT	NSString	*GSThemeWillDeactivateNotification;
 
+/** Notification sent as the -prepare method works through the images and
+ * tiles of a theme.<br />
+ * The notification is posted on the main thread, its object is the theme,
+ * and the userInfo dictionary holds the number of files decoded so far
+ * under the key <code>Done</code> and the number to be decoded under
+ * <code>Total</code>, both as NSNumber instances.
+ */
+APPKIT_EXPORT	NSString	*GSThemePrepareProgressNotification;
+
+/** Notification sent on the main thread when the -prepare method has
+ * finished preparing a theme.
+ */
+APPKIT_EXPORT	NSString	*GSThemeDidPrepareNotification;
+
 
 /**
   <p><em>This interface is <strong>HIGHLY</strong> unstable
@@ -449,6 +463,16 @@ APPKIT_EXPORT	NSString	*GSThemeWillDeactivateNotification;
  */
 + (void) setTheme: (GSTheme*)theme;
 
+/**
+ * Prepares theme using the -prepare method and makes it the currently
+ * active theme once it is prepared, so the application keeps running
+ * while the theme's images are decoded and only has to swap the theme
+ * in on the main thread.<br />
+ * If another theme is requested before theme is prepared, theme is
+ * never made active.
+ */
++ (void) setThemeWhenPrepared: (GSTheme*)theme;
+
 /**
  * Returns the currently active theme instance.  This is the value most
  * recently set using +setTheme: or (if none has been set) is a default
@@ -618,6 +642,12 @@ APPKIT_EXPORT	NSString	*GSThemeWillDeactivateNotification;
  */
 - (NSDictionary*) infoDictionary;
 
+/**
+ * Returns YES if the -prepare method has finished with the receiver since
+ * it was last deactivated.
+ */
+- (BOOL) isPrepared;
+
 /**
  * Return the theme's name.
  */
@@ -644,6 +674,21 @@ APPKIT_EXPORT	NSString	*GSThemeWillDeactivateNotification;
  */
 - (IMP) overriddenMethod: (SEL)selector for: (id)receiver;
 
+/**
+ * Starts preparing the receiver for activation and returns at once.<br />
+ * The image files of the theme (in its ThemeImages and ThemeTiles
+ * directories) are located and decoded on a background thread, so that
+ * when the theme is activated the named images and the tiles are built
+ * from the decoded representations rather than by reading and decoding
+ * the files on the main thread.  The tiles themselves are still cut up
+ * on the main thread when they are first used.<br />
+ * A GSThemePrepareProgressNotification is posted as each file is done
+ * and a GSThemeDidPrepareNotification at the end.<br />
+ * The +setTheme: method calls this for the theme it activates, so that
+ * decoding runs alongside the activation.
+ */
+- (void) prepare;
+
 /** Set the name of this theme ... used for testing by Thematic.app
  */
 - (void) setName: (NSString*)aString;
@@ -687,6 +732,12 @@ APPKIT_EXPORT	NSString	*GSThemeWillDeactivateNotification;
 - (void) tilesFlush: (NSString*)aName
 	      state: (GSThemeControlState)elementState;
 
+/** Returns statistics of the tiles cached by the receiver, as NSNumbers
+ * for the keys Entries (sets of tiles cached) and Bytes (an estimate of
+ * the memory used by their images and by the rects drawn from them).
+ */
+- (NSDictionary*) tileCacheStatistics;
+
 /**
  * Returns the tile image information for a particular image name,
  * or nil if there is no such information or the name is nil.<br />
@@ -1044,6 +1095,17 @@ APPKIT_EXPORT	NSString	*GSThemeWillDeactivateNotification;
 - (NSRect) drawProgressIndicatorBezel: (NSRect)bounds withClip: (NSRect) rect;
 - (void) drawProgressIndicatorBarDeterminate: (NSRect)bounds;
 
+/**
+ * Returns the part of bounds which changes from one step of the
+ * animation of progress to the next, that is the area inside the bezel
+ * drawn by -drawProgressIndicatorBezel:withClip:.  A running indicator
+ * only redisplays this area, and the bezel is not drawn again when the
+ * clip lies inside it.  A theme drawing a bezel of another width should
+ * override this method too.
+ */
+- (NSRect) progressIndicatorAnimationRect: (NSProgressIndicator*)progress
+                               withBounds: (NSRect)bounds;
+
 // Table drawing methods
 - (void) drawTableCornerView: (NSView*)cornerView
                     withClip: (NSRect)aRect;
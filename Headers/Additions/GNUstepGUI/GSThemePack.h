@@ -0,0 +1,88 @@
+/* GSThemePack.h                                             -*-objc-*-
+
+   Packed theme resources
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of the GNUstep GUI Library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; see the file COPYING.LIB.
+   If not, see <http://www.gnu.org/licenses/> or write to the 
+   Free Software Foundation, 51 Franklin Street, Fifth Floor, 
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef _GNUstep_H_GSTHEME_PACK_
+#define _GNUstep_H_GSTHEME_PACK_
+
+#import <Foundation/NSObject.h>
+
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+
+@class NSBitmapImageRep;
+@class NSBundle;
+@class NSData;
+@class NSDictionary;
+@class NSString;
+
+/**
+ * A theme pack holds the resources of a theme bundle in a single file,
+ * ThemePack.gstp in the resources of the bundle, so that activating the
+ * theme does not have to open and decode many small files.<br />
+ * The images in the ThemeImages and ThemeTiles directories are stored
+ * as decoded, premultiplied 8 bit RGB(A) bitmaps and the colour lists
+ * (*.clr) as they are in the bundle.  The file is mapped into memory and
+ * the bitmaps handed out use the mapped pixels without copying them.<br />
+ * The loose files stay in the bundle, since resources are still looked
+ * up by name there; the pack has to be generated again (with the
+ * make_theme_pack tool) whenever they change.
+ */
+@interface GSThemePack : NSObject
+{
+  NSData	*_data;
+  NSDictionary	*_index;
+}
+
+/**
+ * Returns the contents of a pack for the resources of bundle, or nil
+ * if the bundle has no resources to pack.
+ */
++ (NSData*) packDataForBundle: (NSBundle*)bundle;
+
+/**
+ * Maps the pack at path, which must describe the bundle at bundlePath.
+ * Returns nil if the file is missing or is not a valid pack.
+ */
+- (id) initWithContentsOfFile: (NSString*)path
+		   bundlePath: (NSString*)bundlePath;
+
+/**
+ * Returns a new bitmap for the image file at path in the bundle, using
+ * the pixels in the pack, or nil if the pack holds no bitmap for path.
+ * The bitmap must not be modified, and may only be used while the
+ * receiver exists.
+ */
+- (NSBitmapImageRep*) bitmapForFile: (NSString*)path;
+
+/**
+ * Returns the contents of the file at path in the bundle as held in the
+ * pack, or nil if the pack doesn't hold the file.  The data is not
+ * copied out of the pack.
+ */
+- (NSData*) dataForFile: (NSString*)path;
+@end
+
+#endif
+
+#endif /* _GNUstep_H_GSTHEME_PACK_ */
@@ -33,6 +33,7 @@
 #import <Foundation/NSKeyedArchiver.h>
 
 @class NSString, NSDictionary, NSArray, NSMutableDictionary, NSMutableArray;
+@class NSMapTable;
 @class NSNibBindingConnector;
 
 // Hack: This allows the class name FirstResponder in NSCustomObject and
@@ -134,6 +135,7 @@
 @interface IBMutableOrderedSet: NSObject
 {
   NSArray *orderedObjects;
+  NSMapTable *objectsByID;
 }
 - (NSArray *)orderedObjects;
 - (id) objectWithObjectID: (NSInteger)objID;
@@ -144,6 +146,7 @@
   NSMutableArray *connectionRecords;
   IBMutableOrderedSet *objectRecords;
   NSMutableDictionary *flattenedProperties;
+  NSMutableDictionary *propertiesByID;
   NSMutableDictionary *unlocalizedProperties;
   id activeLocalization;
   NSMutableDictionary *localizations;
@@ -151,6 +154,7 @@
   int maxID;
 }
 - (id) nibInstantiate;
+- (void) deferWindowsNotVisibleAtLaunch;
 - (NSEnumerator *) connectionRecordEnumerator;
 - (NSEnumerator *) objectRecordEnumerator;
 @end
@@ -170,8 +174,10 @@
 - (void) addElement: (GSXibElement*)element;
 - (void) setElement: (GSXibElement*)element forKey: (NSString*)key;
 - (void) setValue: (NSString*)text;
+- (NSDictionary*) attributes;
 - (NSString*) attributeForKey: (NSString*)key;
 - (GSXibElement*) elementForKey: (NSString*)key;
+- (void) releaseElements;
 @end
 
 @interface GSXibKeyedUnarchiver: NSKeyedUnarchiver
@@ -182,6 +188,12 @@
   NSMutableDictionary *decoded;
 }
 
+- (id) initForReadingWithCompiledData: (NSData*)data
+                           sourcePath: (NSString*)path
+                     sourceAttributes: (NSDictionary*)attrs;
+- (NSData*) compiledDataForSourcePath: (NSString*)path
+                     sourceAttributes: (NSDictionary*)attrs;
+- (NSArray*) imageResourceNames;
 - (id) _decodeArrayOfObjectsForElement: (GSXibElement*)element;
 - (id) _decodeDictionaryOfObjectsForElement: (GSXibElement*)element;
 @end
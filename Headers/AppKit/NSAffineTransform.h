@@ -76,6 +76,15 @@
 
 @end
 #endif
+
+@interface NSAffineTransform (GSTransformArrays)
+/** Transforms count points in place.  */
+- (void) transformPoints: (NSPoint *)points count: (NSUInteger)count;
+
+/** Replaces each of count rects by the bounding rect of the transformed
+    rect, as -boundingRectFor:result: does.  */
+- (void) transformRects: (NSRect *)rects count: (NSUInteger)count;
+@end
 #endif
 
 #endif /* _GNUstep_H_NSAffineTransform */
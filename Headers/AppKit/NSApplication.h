@@ -260,6 +260,12 @@ APPKIT_EXPORT NSString	*NSEventTrackingRunLoopMode;
 			    inMode: (NSString*)mode
 			   dequeue: (BOOL)flag;
 - (void) postEvent: (NSEvent*)event atStart: (BOOL)flag;
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
++ (BOOL) recordsInputLatency;
++ (void) setRecordsInputLatency: (BOOL)flag;
+- (NSDictionary *) inputLatencyStatistics;
+- (void) resetInputLatencyStatistics;
+#endif
 
 /*
  * Sending action messages
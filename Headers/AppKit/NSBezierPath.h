@@ -86,13 +86,8 @@ typedef enum {
   NSRect _bounds;
   NSRect _controlPointBounds;
   NSImage *_cacheImage;
-#ifndef	_IN_NSBEZIERPATH_M
-#define	GSIArray	void*
-#endif
-  GSIArray _pathElements;
-#ifndef	_IN_NSBEZIERPATH_M
-#undef	GSIArray
-#endif
+  void *_flattenedPath;
+  void *_pathElements;
   BOOL _cachesBezierPath;
   BOOL _shouldRecalculateBounds;
   BOOL _flat;
@@ -245,6 +240,29 @@ typedef enum {
                                 yRadius:(CGFloat)yRadius;
 #endif
 
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+/** Starts a new subpath at the first of count points and adds lines to
+    the others.  */
+- (void) appendPolylineWithPoints: (const NSPoint *)points
+			    count: (NSInteger)count;
+
+/** Like -appendPolylineWithPoints:count:, but closes the subpath.  */
+- (void) appendPolygonWithPoints: (const NSPoint *)points
+			   count: (NSInteger)count;
+
+/** Sets *types to the types of the elements of the path, one byte of
+    <ref type="type" id="NSBezierPathElement">NSBezierPathElement</ref>
+    each, and *points to their points, and returns the number of elements.
+    Moveto and lineto elements have one point, curveto elements have the
+    two control points and then the end point, and closepath elements
+    have the start of the subpath they close.  If pointCount isn't NULL,
+    the number of points is put there.  The buffers belong to the path
+    and are only valid until it is changed.  */
+- (NSInteger) getElementTypes: (const unsigned char **)types
+		       points: (const NSPoint **)points
+		   pointCount: (NSInteger *)pointCount;
+#endif
+
 //
 // Hit detection  
 //
@@ -120,6 +120,11 @@ APPKIT_EXPORT NSString *NSImageLoopCount; // NSNumber integer; only for reading
 APPKIT_EXPORT NSString *NSImageGamma; // NSNumber 0.0 to 1.0; only for reading & writing PNG files
 APPKIT_EXPORT NSString *NSImageProgressive; // NSNumber boolean; only for reading & writing JPEG files
 APPKIT_EXPORT NSString *NSImageEXIFData; // No GNUstep support yet; for reading & writing JPEG
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+APPKIT_EXPORT NSString *GSImagePNGCompressionLevel; // NSNumber 0 to 9; only for writing PNG files
+APPKIT_EXPORT NSString *GSImagePNGFilters; // NSNumber of GSPNGFilter flags; only for writing PNG files
+APPKIT_EXPORT NSString *GSImagePNGThreads; // NSNumber integer; only for writing PNG files
+#endif
 
 #endif
 
@@ -140,6 +145,10 @@ APPKIT_EXPORT NSString *NSImageEXIFData; // No GNUstep support yet; for reading
 #else
   unsigned int    _format;
 #endif
+  id _incrementalLoader;
+  NSData *_undecodedData;
+  int _undecodedImage;
+  id _frameDecoder;
 }
 
 //
@@ -253,4 +262,72 @@ APPKIT_EXPORT NSString *NSImageEXIFData; // No GNUstep support yet; for reading
 + (NSArray*) imageRepsWithFile: (NSString *)filename;
 @end
 
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+/** The row filters the PNG writer may choose from, for the
+ * GSImagePNGFilters property. With more than one, each row gets the one
+ * that is expected to compress best.
+ */
+enum {
+  GSPNGFilterNone = 0x08,
+  GSPNGFilterSub = 0x10,
+  GSPNGFilterUp = 0x20,
+  GSPNGFilterAverage = 0x40,
+  GSPNGFilterPaeth = 0x80,
+  GSPNGFilterAll = 0xf8
+};
+typedef NSUInteger GSPNGFilter;
+
+@interface NSBitmapImageRep (GSPixelAccess)
+/** Copies the pixels in rect, where (0,0) is the top-left pixel of the
+ * image, into buffer row after row as non-premultiplied RGBA, with each
+ * component scaled to [0.0 ... 1.0]. The buffer must have room for
+ * 4 * width * height floats. Grey images are expanded to RGB and images
+ * without alpha are returned opaque. Returns NO if rect is not inside
+ * the image or the colour space is neither RGB nor grey.
+ */
+- (BOOL) getRGBAFloatPixels: (float *)buffer inRect: (NSRect)rect;
+/** Copies the pixels of row y like -getRGBAFloatPixels:inRect:. */
+- (BOOL) getRGBAFloatPixels: (float *)buffer row: (NSInteger)y;
+/** Like -getRGBAFloatPixels:inRect:, but with 8 bits per component. */
+- (BOOL) getRGBA8Pixels: (unsigned char *)buffer inRect: (NSRect)rect;
+/** Copies the pixels of row y like -getRGBA8Pixels:inRect:. */
+- (BOOL) getRGBA8Pixels: (unsigned char *)buffer row: (NSInteger)y;
+@end
+
+@interface NSBitmapImageRep (GSScaledLoading)
+/** Returns a new image rep for the first image in imageData, decoded at
+ * a reduced resolution if that is cheaper and the image stays at least
+ * pixelSize wide and high. This is meant for thumbnails and icons of
+ * large photos.
+ */
++ (id) imageRepWithData: (NSData *)imageData forPixelSize: (NSSize)pixelSize;
+/** Initialises like -initWithData:, but JPEG images are scaled down by
+ * 1/2, 1/4 or 1/8 while decoding, as far as the result is at least
+ * pixelSize wide and high. Other formats are decoded at full resolution.
+ */
+- (id) initWithData: (NSData *)imageData forPixelSize: (NSSize)pixelSize;
+@end
+
+/** The kernels bitmaps can be resampled with. Box is the cheapest and
+ * only suits shrinking, Lanczos (with three lobes) keeps the most detail.
+ */
+enum {
+  GSImageResamplingBox,
+  GSImageResamplingBilinear,
+  GSImageResamplingLanczos
+};
+typedef NSUInteger GSImageResamplingFilter;
+
+@interface NSBitmapImageRep (GSResampling)
+/** Returns a new non-premultiplied 8 bit RGBA bitmap of the receiver
+ * scaled to width by height pixels with filter. The new bitmap has the
+ * size of the receiver. Returns nil if the receiver is neither RGB nor
+ * grey.
+ */
+- (NSBitmapImageRep *) bitmapImageRepByResamplingToPixelsWide: (NSInteger)width
+                                                   pixelsHigh: (NSInteger)height
+                                                       filter: (GSImageResamplingFilter)filter;
+@end
+#endif
+
 #endif // _GNUstep_H_NSBitmapImageRep
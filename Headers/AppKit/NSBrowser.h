@@ -62,6 +62,8 @@ typedef NSUInteger NSBrowserColumnResizingType;
   NSScroller *_horizontalScroller;
   NSTimeInterval _lastKeyPressed;
   NSString *_charBuffer;
+  /* Sorted strings of the cells in _alphaNumericalLastColumn */
+  id _typeSelectIndex;
 
   BOOL _isLoaded;
   BOOL _allowsBranchSelection;
@@ -78,6 +80,7 @@ typedef NSUInteger NSBrowserColumnResizingType;
   BOOL _acceptsAlphaNumericalKeys;
   BOOL _sendsActionOnAlphaNumericalKeys;
   BOOL _prefersAllColumnUserResizing;
+  BOOL _loadsColumnsLazily;
 
   BOOL _passiveDelegate;
   id _browserDelegate;
@@ -281,6 +284,8 @@ typedef NSUInteger NSBrowserColumnResizingType;
 - (void) setAcceptsAlphaNumericalKeys: (BOOL)flag;
 - (BOOL) sendsActionOnAlphaNumericalKeys;
 - (void) setSendsActionOnAlphaNumericalKeys: (BOOL)flag;
+- (BOOL) loadsColumnsLazily;
+- (void) setLoadsColumnsLazily: (BOOL)flag;
 @end
 
 //
@@ -140,6 +140,7 @@ typedef NSUInteger NSGradientType;
 #define _shows_border_only_while_mouse_inside _cell.subclass_bool_three
 #define _mouse_inside _cell.subclass_bool_four
   NSImageScaling _imageScaling;
+  void *_layout_cache; // Placement of the contents, private to NSButtonCell
 }
 
 //
@@ -198,7 +198,7 @@ typedef NSUInteger NSImageScaling;
   NSFormatter *_formatter;
   NSMenu *_menu;
   id _represented_object; 
-  void *_reserved1;
+  void *_title_cache; // Prepared title and its size, private to NSCell
 }
 
 //
@@ -526,6 +526,9 @@ typedef NSUInteger NSImageScaling;
                        inView: (NSView*)controlView;
 - (void) _setInEditing: (BOOL)flag;
 - (void) _updateFieldEditor: (NSText*)textObject;
+- (NSAttributedString*) _titleForString: (NSString*)string;
+- (NSSize) _sizeOfTitle: (NSAttributedString*)aString;
+- (void) _invalidateTitleCache;
 
 @end
 
@@ -46,6 +46,7 @@
   BOOL _copiesOnScroll;
   /* Cached */
   BOOL _isOpaque;
+  void *_overdraw;
 }
 
 /* Setting the document view */
@@ -79,6 +80,12 @@
 - (BOOL)drawsBackground;
 #endif
 
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+/* Keeping the document view around the visible rect */
+- (void)setOverdrawMargin:(CGFloat)margin;
+- (CGFloat)overdrawMargin;
+#endif
+
 @end
 
 #endif /* _GNUstep_H_NSClipView */
@@ -101,6 +101,10 @@ namesOfPromisedFilesDroppedAtDestination:(NSURL *)dropURL
   
   NSUInteger _draggingOnRow;
   NSUInteger _draggingOnIndex;
+
+  NSMutableIndexSet *_loadedIndexes;
+  NSMutableArray *_reusableItems;
+  BOOL _reusesItems;
 }
 
 - (BOOL) allowsMultipleSelection;
@@ -163,6 +163,23 @@
 
 @end
 
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+@interface NSColorList (GSBinaryFormat)
+/** Returns the colors of the receiver in the compact binary color list
+ * format, which -initWithName:fromFile: reads much faster than an
+ * archive, or nil if a color has no calibrated RGB equivalent.<br />
+ * The format is the bytes "GSCL", a version byte of 1 and the number of
+ * colors as a big endian 32-bit integer, followed for each color by the
+ * length of its name as a big endian 16-bit integer, the name in UTF-8
+ * and its red, green, blue and alpha components as big endian floats.
+ * <br />
+ * If the GSColorListBinaryFormat user default is YES, -writeToFile:
+ * writes this format rather than an archive where it can.
+ */
+- (NSData *) binaryRepresentation;
+@end
+#endif
+
 /* Notifications */
 APPKIT_EXPORT NSString *NSColorListDidChangeNotification;
 
@@ -54,6 +54,7 @@
   
 @private
    id		        _popup;
+   id			_completionIndex;
 }
 
 - (BOOL)hasVerticalScroller;
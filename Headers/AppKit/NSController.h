@@ -58,6 +58,17 @@
 
 @end
 
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+@interface NSController (GNUstepExtensions)
+/* Between these calls, objects bound to the controller are not updated.
+ * Each binding whose value changed is updated once when the outermost
+ * batch ends.
+ */
+- (void) beginBatchedChanges;
+- (void) endBatchedChanges;
+@end
+#endif
+
 #endif // OS_API_VERSION
 
 #endif // _GNUstep_H_NSController
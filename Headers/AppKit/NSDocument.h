@@ -367,6 +367,58 @@ originalContentsURL:(NSURL *)orig
          contextInfo:(void *)context;
 - (NSError *)willPresentError:(NSError *)error;
 #endif
+
+#if OS_API_VERSION(MAC_OS_X_VERSION_10_7, GS_API_LATEST)
+/**
+ * Returns YES if a save to url may write the document in the background
+ * while the user goes on editing it.  The default returns NO.  When it
+ * returns YES, -saveToURL:ofType:forSaveOperation:delegate:didSaveSelector:contextInfo:
+ * takes the file wrapper of the document on the main thread and writes
+ * it on another thread, so -fileWrapperOfType:error: or -dataOfType:error:
+ * should return a snapshot which later edits do not change.  Documents
+ * which override the methods writing to files are always saved in the
+ * foreground.
+ */
+- (BOOL)canAsynchronouslyWriteToURL:(NSURL *)url
+                             ofType:(NSString *)type
+                   forSaveOperation:(NSSaveOperationType)op;
+#endif
 @end
 
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+/**
+ * <p>Documents which return YES from -autosavesIncrementally are autosaved
+ * by appending the changes made since the last autosave to a journal kept
+ * next to the autosaved contents, rather than by writing the whole
+ * document again.  Once the journal has grown large compared with the
+ * autosaved contents, the next autosave writes the whole document, in
+ * the background if the document allows it, and starts a new journal.
+ * </p>
+ * <p>When an autosaved document is reopened, its autosaved contents are
+ * read as usual and each entry of the journal is then handed to
+ * -replayAutosaveJournalEntry:ofType:error: in the order in which the
+ * entries were written.
+ * </p>
+ */
+@interface NSDocument (GSIncrementalAutosave)
+/** Returns NO.  Override to return YES to autosave with a journal. */
+- (BOOL)autosavesIncrementally;
+/**
+ * Returns a journal entry describing the changes made since the last
+ * autosave, or nil if they can't be described, in which case the whole
+ * document is autosaved.  The default returns nil.
+ */
+- (NSData *)autosaveJournalEntryOfType:(NSString *)type
+                                 error:(NSError **)error;
+/**
+ * Applies an entry written by -autosaveJournalEntryOfType:error: to the
+ * document.  Returns NO if it could not, which stops the replay.  The
+ * default returns NO.
+ */
+- (BOOL)replayAutosaveJournalEntry:(NSData *)entry
+                            ofType:(NSString *)type
+                             error:(NSError **)error;
+@end
+#endif
+
 #endif // _GNUstep_H_NSDocument
@@ -264,6 +264,7 @@ enum
           NSInteger data2;
         } misc;
     } event_data;
+  NSArray *coalesced_events;
 }
 
 + (NSEvent*) enterExitEventWithType: (NSEventType)type        
@@ -329,6 +330,11 @@ enum
                             withPeriod: (NSTimeInterval)periodSeconds;
 + (void) stopPeriodicEvents;
 
+#if OS_API_VERSION(MAC_OS_X_VERSION_10_4, GS_API_LATEST)
++ (BOOL) isMouseCoalescingEnabled;
++ (void) setMouseCoalescingEnabled: (BOOL)flag;
+#endif
+
 
 #if OS_API_VERSION(GS_API_MACOSX, GS_API_LATEST)
 - (NSInteger) buttonNumber;
@@ -357,6 +363,9 @@ enum
 - (void *) userData;
 - (NSWindow *) window;
 - (NSInteger) windowNumber;
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+- (NSArray *) coalescedEvents;
+#endif
 
 #if OS_API_VERSION(MAC_OS_X_VERSION_10_4, GS_API_LATEST)
 - (NSInteger) absoluteX;
@@ -35,6 +35,7 @@
 #import <AppKit/NSImage.h>
 
 @class NSData;
+@class NSDate;
 @class NSDictionary;
 @class NSMutableDictionary;
 @class NSString;
@@ -55,6 +56,9 @@ typedef enum
   GSFileWrapperType	_wrapperType;
   id			_wrapperData;
   NSImage		*_iconImage;
+  NSString		*_contentsPath;	// File the contents are read from
+  NSDate		*_contentsDate;	// Its modification date and size
+  unsigned long long	_contentsSize;	// when the wrapper was made
 }
 
 //
@@ -262,6 +262,10 @@ APPKIT_EXPORT const CGFloat *NSFontIdentityMatrix;
 @interface NSFont (GNUstep)
 - (GSFontInfo*) fontInfo;
 - (void *) fontRef;
+/* Returns the number of font lookups that found a cached font (Hits), that
+   had to set up a new font (Misses) and the number of fonts cached now
+   (Count). */
++ (NSDictionary *) fontCacheStatistics;
 @end
 
 int NSConvertGlyphsToPackedGlyphs(NSGlyph*glBuf, 
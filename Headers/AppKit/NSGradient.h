@@ -53,6 +53,9 @@ enum {
   NSArray *_colors;
   CGFloat *_locations;
   NSInteger _numberOfColorStops;
+  CGFloat *_components;
+  unsigned char *_ramp;
+  id _rampReps[4];
 }
 
 - (NSColorSpace *) colorSpace; 
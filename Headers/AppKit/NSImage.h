@@ -90,6 +90,7 @@ typedef enum {
   NSView                *_lockedView;
   id		        _delegate;
   NSImageCacheMode      _cacheMode;
+  id                    _prefetch;
 }
 
 //
@@ -419,6 +420,43 @@ typedef enum {
 @end
 
 
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+@interface NSImage (GSPurgeableStorage)
+/** Calls -purgeImageData for every image that has not been drawn for at
+ * least seconds. Call this with 0 when memory runs low.<br />
+ * If the GSImagePurgeInterval user default holds a number of seconds, it
+ * is called with that interval from a timer as well.
+ */
++ (void) purgeImageDataUnusedFor: (NSTimeInterval)seconds;
+/** Throws away the cached representations of the receiver, and the
+ * representations loaded from the file it references, if it was created
+ * with -initByReferencingFile: or +imageNamed:. They are created again
+ * when the image is next drawn. Does nothing while the receiver has
+ * focus locked.
+ */
+- (void) purgeImageData;
+@end
+
+@interface NSImage (GSImageCache)
+/** Sets the number of bytes the cached representations of all images may
+ * use together. When a new cache takes more, the least recently drawn
+ * caches of any image are thrown away, to be drawn again when needed.
+ * The default is taken from the GSImageCacheByteBudget user default, or
+ * is 64 MB.
+ */
++ (void) setImageCacheByteBudget: (NSUInteger)bytes;
+/** Returns the byte budget of the cached representations. */
++ (NSUInteger) imageCacheByteBudget;
+/** Returns a dictionary with the number of bytes used by cached
+ * representations (BytesInUse), the budget (ByteBudget), the number of
+ * caches (Entries), the number of caches thrown away to stay within the
+ * budget (Evictions), and the number of caches that had to be made again
+ * after one was thrown away (Recaches).
+ */
++ (NSDictionary *) imageCacheStatistics;
+@end
+#endif
+
 @interface NSBundle (NSImageAdditions)
 
 - (NSString*) pathForImageResource: (NSString*)name;
@@ -37,10 +37,15 @@
   id _target;
   SEL _action;
   struct GSImageViewFlagsType { 
-    // total 32 bits.  30 bits left.
+    // total 32 bits.  29 bits left.
     unsigned allowsCutCopyPaste: 1;
     unsigned initiatesDrag: 1;
+    unsigned animates: 1;
   } _ivflags;
+  id _animator;			// Steps the frames of an animated image
+  NSTimeInterval _lastStep;	// Time of the last step of the animator
+  NSTimeInterval _frameTime;	// Time the current frame has been shown
+  NSUInteger _loops;		// Number of times the animation was played
 }
 
 - (NSImage *)image;
@@ -149,6 +149,12 @@ APPKIT_EXPORT NSString *NSValueTransformerNameBindingOption;
 APPKIT_EXPORT NSString *NSValueTransformerBindingOption;
 #endif
 
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+/* NSNumber boolean; if YES, changes of the observed value are shown in
+   the bound object once per run loop turn, before windows display. */
+APPKIT_EXPORT NSString *GSCoalescesChangesBindingOption;
+#endif
+
 #endif // OS_API_VERSION
 
 #endif // _GNUstep_H_NSKeyValueBinding
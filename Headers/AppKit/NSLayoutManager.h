@@ -68,7 +68,9 @@ typedef enum {
   and will be released when the NSLayoutManager is deallocated. */
   NSMutableDictionary *_typingAttributes;
 
-  NSMutableAttributedString *_temporaryAttributes;
+  id _temporaryAttributes;
+
+  BOOL _allowsNonContiguousLayout;
 }
 
 /* TODO */
@@ -86,6 +86,7 @@ typedef enum _NSMatrixMode {
   id            _reserved1;
   NSInteger     _dottedRow;
   NSInteger     _dottedColumn;
+  id            _lazyCell;
 }
 
 /*
@@ -306,4 +307,11 @@ typedef enum _NSMatrixMode {
 
 @end
 
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+@interface NSMatrix (GNUstepExtensions)
+- (BOOL) createsCellsLazily;
+- (void) setCreatesCellsLazily: (BOOL)flag;
+@end
+#endif
+
 #endif /* _GNUstep_H_NSMatrix */
@@ -357,6 +357,13 @@
   NSMenu    *_oldAttachedMenu;
   NSInteger _oldHiglightedIndex;
   NSString  *_name;
+  /* Items of the menu and its submenus by key equivalent, valid while
+     the key equivalents of all menus are unchanged */
+  NSMutableDictionary *_keyEquivalentIndex;
+  NSUInteger _keyEquivalentGeneration;
+  NSMenu    *_keyEquivalentServicesMenu;
+  /* When the items were last validated */
+  NSTimeInterval _lastValidation;
 }
 
 /** Returns the memory allocation zone used to create instances of this class.
@@ -750,6 +757,14 @@
  */
 - (NSWindow*) window;
 
+/** Returns the number of items validated by the last -update sent
+ *  to a menu by the application, its submenus included.  Submenus
+ *  which are not on screen are validated at most once every
+ *  GSMenuValidationInterval seconds, a user default which is 1 by
+ *  default.
+ */
++ (NSUInteger) lastUpdateValidationCount;
+
 /* Popup behaviour */
 - (BOOL) _ownedByPopUp;
 - (NSPopUpButtonCell *)_owningPopUp;
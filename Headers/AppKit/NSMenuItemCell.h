@@ -59,6 +59,13 @@ typedef void (*DrawingIMP)(id, SEL, NSRect, NSView*);
   NSImage *_imageToDisplay;
   NSString *_titleToDisplay;
   NSSize _imageSize;
+
+  /* Strings last measured by -calcSize, with their font and sizes */
+  NSString *_measuredTitle;
+  NSString *_measuredKeyEquivalent;
+  NSFont *_measuredFont;
+  NSSize _measuredTitleSize;
+  NSSize _measuredKeyEquivalentSize;
 }
 
 - (void)setHighlighted:(BOOL)flag;
@@ -45,6 +45,14 @@
   NSMutableArray *_expandedItems;
   NSMutableArray *_selectedItems; /* No longer in use */
   NSMapTable *_levelOfItems;
+  /* The last known row of each visible item.  The rows of the first
+     _rowOfItemCount rows are right, later ones are rechecked.  */
+  NSMapTable *_rowOfItem;
+  NSUInteger _rowOfItemCount;
+  /* The objects loading children in the background, by item */
+  NSMapTable *_childLoaders;
+  BOOL _loadsChildrenInBackground;
+  NSUInteger _lazyChildrenThreshold;
   BOOL _autoResizesOutlineColumn;
   BOOL _indentationMarkerFollowsCell;
   BOOL _autosaveExpandedItems;
@@ -83,6 +91,12 @@
 - (void) setIndentationPerLevel: (CGFloat)newIndentLevel;
 - (void) setOutlineTableColumn: (NSTableColumn *)outlineTableColumn;
 - (BOOL) shouldCollapseAutoExpandedItemsForDeposited: (BOOL)deposited;
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+- (void) setLoadsChildrenInBackground: (BOOL)flag;
+- (BOOL) loadsChildrenInBackground;
+- (void) setLazyChildrenThreshold: (NSUInteger)count;
+- (NSUInteger) lazyChildrenThreshold;
+#endif
 @end /* interface of NSOutlineView */
 
 /** 
@@ -296,6 +310,15 @@ willDisplayOutlineCell: (id)cell
   didClickTableColumn: (NSTableColumn *)aTableColumn;
 #endif
 
+#if OS_API_VERSION(MAC_OS_X_VERSION_10_4, GS_API_LATEST)
+/**
+ * Returns the height of the row showing item.  If the delegate
+ * implements this method, rows may have different heights.
+ */
+- (CGFloat) outlineView: (NSOutlineView *)outlineView
+      heightOfRowByItem: (id)item;
+#endif
+
 @end
 
 #endif /* _GNUstep_H_NSOutlineView */
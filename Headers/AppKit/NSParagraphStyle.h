@@ -107,6 +107,9 @@ APPKIT_EXPORT NSString *NSTabColumnTerminatorsAttributeName;
   NSLineBreakMode _lineBreakMode;
   NSWritingDirection _baseDirection;
   NSInteger _headerLevel;
+  // Kept for styles in the table of interned styles
+  NSUInteger _hash;
+  BOOL _interned;
 }
 
 + (NSParagraphStyle*) defaultParagraphStyle;
@@ -33,6 +33,7 @@
 #import <GNUstepBase/GSVersionMacros.h>
 
 #import <Foundation/NSObject.h>
+#import <Foundation/NSDate.h>
 #import <AppKit/AppKitDefines.h>
 
 #if defined(__cplusplus)
@@ -43,6 +44,7 @@ extern "C" {
 @class NSArray;
 @class NSData;
 @class NSFileWrapper;
+@class NSInputStream;
 
 /**
  * Pasteboard contains string data as written by
@@ -183,6 +185,9 @@ APPKIT_EXPORT NSString *NSPasteboardCommunicationException;
   id		target;		// Proxy to the object in the server.
   id		owner;		// Local pasteboard owner.
   BOOL		useHistory;	// Want strict OPENSTEP?
+  NSArray	*cachedTypes;	// Types as last fetched from the server.
+  int		cachedCount;	// Change count of the cached types.
+  NSTimeInterval	cachedAt;	// When they were fetched.
 }
 
 //
@@ -285,6 +290,11 @@ APPKIT_EXPORT NSString *NSPasteboardCommunicationException;
 + (NSString*) pasteboardTypeForMimeType: (NSString*)mimeType;
 - (void) setChangeCount: (int)count;
 - (void) setHistory: (unsigned)length;
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+- (NSInputStream*) inputStreamForType: (NSString*)dataType;
+- (BOOL) setDataFromStream: (NSInputStream*)stream
+		   forType: (NSString*)dataType;
+#endif
 @end
 
 #if OS_API_VERSION(GS_API_MACOSX, GS_API_LATEST)
@@ -56,6 +56,15 @@ typedef enum {
       NSUInteger altersStateOfSelectedItem: 1;
       NSUInteger arrowPosition: 2;
   } _pbcFlags;
+  /* Item data source and the part of its items held by the menu */
+  id _itemDataSource;
+  NSInteger _itemDataSelection;
+  NSInteger _itemDataFirst;
+  BOOL _itemDataReloading;
+  BOOL _reopensPopUp;
+  BOOL _trackingPopUp;
+  NSRect _popUpFrame;
+  NSView *_popUpView;
 }
 
 // Initialization
@@ -297,4 +306,35 @@ typedef enum {
 - (void) performClickWithFrame: (NSRect)frame inView: (NSView*)controlView;
 @end    
 
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+@interface NSPopUpButtonCell (GNUstepExtensions)
+/**
+ * Sets an object which supplies the titles of the items of the
+ * receiver, which should implement the methods of the
+ * GSPopUpButtonCellItemDataSource informal protocol.  The menu of the
+ * receiver then only holds items for a part of the list around the
+ * selected item, with items to move to the previous or following part,
+ * so that lists of thousands of items open quickly.  In this mode
+ * -numberOfItems, -indexOfSelectedItem, -selectItemAtIndex: and
+ * -itemTitleAtIndex: refer to the whole list, and -itemAtIndex: returns
+ * nil for items not held by the menu.  The items of the menu should
+ * not be changed directly.  Setting nil returns to a menu of items.
+ * The data source is not retained.
+ */
+- (void) setItemDataSource: (id)dataSource;
+- (id) itemDataSource;
+
+/**
+ * Asks the item data source for its items again.
+ */
+- (void) reloadItemData;
+@end
+
+@interface NSObject (GSPopUpButtonCellItemDataSource)
+- (NSInteger) numberOfItemsInPopUpButtonCell: (NSPopUpButtonCell *)cell;
+- (NSString *) popUpButtonCell: (NSPopUpButtonCell *)cell
+            titleOfItemAtIndex: (NSInteger)index;
+@end
+#endif
+
 #endif // _GNUstep_H_NSPopUpButtonCell
@@ -44,6 +44,7 @@
 @class NSString;
 @class NSData;
 @class NSMutableData;
+@class NSOutputStream;
 
 @class NSView;
 @class NSWindow;
@@ -75,9 +76,12 @@ typedef enum _NSPrintingPageOrder {
       unsigned int show_print_panel:1;
       unsigned int show_progress_panel:1;
       unsigned int can_spawn_separate_thread:1;
-      unsigned int RESERVED:29;
+      unsigned int printing_concurrently:1;
+      unsigned int streamed_output:1;
+      unsigned int RESERVED:27;
   } _flags;
   NSInteger  _currentPage;
+  NSOutputStream *_output_stream;
 }
 
 //
@@ -200,6 +204,16 @@ typedef enum _NSPrintingPageOrder {
 
 @end
 
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+@interface NSPrintOperation (GNUstep)
+/** Sets a stream the output is written to as it is produced, instead
+    of being collected in a file or data object and delivered at the end.
+    The stream is opened if it is not open yet, and is left open. */
+- (void) setOutputStream: (NSOutputStream *)stream;
+- (NSOutputStream *) outputStream;
+@end
+#endif
+
 
 //
 // Private method used by the NSPrintOperation subclasses 
@@ -215,6 +229,16 @@ typedef enum _NSPrintingPageOrder {
              toData:(NSMutableData *)data
           printInfo:(NSPrintInfo *)aPrintInfo;
 
+/* Streaming output.  When -_shouldStreamOutput returns YES the context
+   writes to a pipe, and the other methods are called on a thread which
+   reads from the pipe to pass on what the context wrote.  The default
+   implementations pass it on to the output stream. */
+- (BOOL) _shouldStreamOutput;
+- (BOOL) _beginStreamedOutput;
+- (BOOL) _writeStreamedBytes: (const uint8_t *)bytes
+                      length: (NSUInteger)length;
+- (BOOL) _endStreamedOutput;
+
 @end
 
 
@@ -35,6 +35,7 @@
 
 #import <Foundation/NSObject.h>
 #import <Foundation/NSGeometry.h>
+#import <AppKit/AppKitDefines.h>
 
 @class NSString;
 @class NSArray;
@@ -47,6 +48,12 @@ typedef enum _NSPrinterTableStatus {
   NSPrinterTableError
 } NSPrinterTableStatus;
 
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+/* Posted on the main thread when a printing bundle finds that the
+   printers available have changed. */
+APPKIT_EXPORT NSString *GSPrinterNamesDidChangeNotification;
+#endif
+
 @interface NSPrinter : NSObject <NSCoding>
 {
   NSString *_printerHost;
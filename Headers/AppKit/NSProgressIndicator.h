@@ -71,7 +71,7 @@ typedef enum _NSProgressIndicatorStyle
   BOOL _isVertical;
   BOOL _isRunning;
   int _count;  
-  NSTimer *_timer;
+  id _animator; // GSAnimator stepping a non threaded animation
   id _reserved;
 }
 
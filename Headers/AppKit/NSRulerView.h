@@ -78,6 +78,11 @@ typedef enum {
   float _UNUSED;
   float _unitToRuler;
   NSString *_labelFormat;
+
+  /* Where the document bounds were in the ruler when it was last drawn,
+   * so that what it shows can be moved when the client view scrolls.  */
+  NSRect _drawnDocRect;
+  BOOL _drawnDocRectIsValid;
 }
 
 - (id) initWithScrollView:(NSScrollView *)aScrollView
@@ -96,6 +96,7 @@ enum {
   NSSize _originalSize;
 
   NSArray *_allowedFileTypes;
+  NSSet *_allowedExtensions;	// Case folded extensions of the types
   NSString *_directory;
   NSString *_fullFileName;
 
@@ -117,6 +118,9 @@ enum {
   BOOL _OKButtonPressed;
 
   NSMenu *_showsHiddenFilesMenu;
+
+  // Directories being read or shown into browser columns
+  NSMutableArray *_directoryListers;
 }
 
 /*
@@ -46,6 +46,7 @@
 @class NSThread;
 @class NSConditionLock;
 @class NSLock;
+struct _GSSoundRing;
 
 /** Function used to retrieve all available playback devices.
  *  <p>This function is the only way to retrieve possible playback
@@ -69,6 +70,9 @@ NSArray *PlaybackDeviceIdentifiers (void);
   NSLock            * _playbackLock;
   BOOL _shouldStop;
   BOOL _shouldLoop;
+  BOOL _prefills;
+  struct _GSSoundRing *_ring;
+  NSUInteger _underruns;
 }
 
 //
@@ -208,6 +212,19 @@ NSArray *PlaybackDeviceIdentifiers (void);
 - (void)setChannelMapping: (NSArray *)channelMapping;
 #endif
 
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+/** Sets whether -play waits until the start of the sound has been read
+ *  into its buffer before returning, so playback doesn't have to wait
+ *  for the source once it has started.  The default is NO.
+ */
+- (void)setPrefillsBeforePlaying: (BOOL)flag;
+- (BOOL)prefillsBeforePlaying;
+/** Returns how many times playback had to wait for the source to
+ *  catch up since the receiver was last started.
+ */
+- (NSUInteger)underrunCount;
+#endif
+
 @end
 
 //
@@ -40,6 +40,7 @@
 #import <Foundation/NSGeometry.h>
 #import <Foundation/NSString.h>
 
+@class NSArray;
 @class NSDictionary;
 
 #if OS_API_VERSION(MAC_OS_X_VERSION_10_4, GS_API_LATEST)
@@ -85,6 +86,49 @@ typedef enum
 
 @end
 
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+@interface NSString (GSStringDrawingBatch)
+
+/** Draws each string of strings in the rect at the same index of rects,
+ * all with the same attributes, like -drawInRect:withAttributes:.<br />
+ * This is faster than drawing the strings one by one, since the drawing
+ * state is set up once for all strings and strings already drawn with
+ * this size and these attributes reuse their cached layout.
+ */
++ (void) drawStrings: (NSArray*)strings
+	     inRects: (const NSRect*)rects
+      withAttributes: (NSDictionary*)attrs;
+
+@end
+
+/* The string drawing methods keep the text system objects used for the
+ * most recently drawn strings in a cache, so that drawing or measuring
+ * the same string again does not need a new layout.
+ */
+@interface NSString (GSStringDrawingCache)
+
+/** Returns the number of strings the cache can hold.  This defaults to
+ * 16 and can be set with the GSStringDrawingCacheSize user default.
+ */
++ (NSUInteger) stringDrawingCacheSize;
+
+/** Sets the number of strings the cache can hold, emptying the cache.
+ */
++ (void) setStringDrawingCacheSize: (NSUInteger)size;
+
+/** Returns the cache statistics in a dictionary with the keys @"Hits",
+ * @"Misses", @"Evictions" (misses which replaced a cached string),
+ * @"Entries" (strings currently cached) and @"Size".
+ */
++ (NSDictionary*) stringDrawingCacheStatistics;
+
+/** Resets the hit, miss and eviction counters to zero.
+ */
++ (void) resetStringDrawingCacheStatistics;
+
+@end
+#endif
+
 #else
 @class NSAttributedString;
 #endif
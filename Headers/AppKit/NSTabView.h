@@ -107,11 +107,30 @@ typedef enum {
 
 @end
 
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+@interface NSTabView (GSLazyTabViews)
+/** Unloads the views of the items which are not selected, if the
+ * delegate creates views with -tabView:viewForTabViewItem: so that they
+ * can be created again when selected.  The delegate can keep the view of
+ * an item with -tabView:shouldUnloadViewOfTabViewItem:.  Call this when
+ * memory runs low.
+ */
+- (void) unloadUnselectedTabViews;
+@end
+#endif
+
 @interface NSObject(NSTabViewDelegate)
 - (BOOL)tabView:(NSTabView *)tabView shouldSelectTabViewItem:(NSTabViewItem *)tabViewItem;
 - (void)tabView:(NSTabView *)tabView willSelectTabViewItem:(NSTabViewItem *)tabViewItem;
 - (void)tabView:(NSTabView *)tabView didSelectTabViewItem:(NSTabViewItem *)tabViewItem;
 - (void)tabViewDidChangeNumberOfTabViewItems:(NSTabView *)TabView;
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+/** Returns the view of an item which has none (see -isViewLoaded) when
+ * it is about to be selected.
+ */
+- (NSView *)tabView:(NSTabView *)tabView viewForTabViewItem:(NSTabViewItem *)tabViewItem;
+- (BOOL)tabView:(NSTabView *)tabView shouldUnloadViewOfTabViewItem:(NSTabViewItem *)tabViewItem;
+#endif
 @end
 
 #endif // _GNUstep_H_NSTabView
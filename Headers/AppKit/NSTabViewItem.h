@@ -93,5 +93,21 @@ typedef enum {
 - (NSString*)_truncatedLabel;
 @end
 
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+@interface NSTabViewItem (GSLazyView)
+/** Returns NO if the receiver has no view, because it was given a nil
+ * view or its view was unloaded.  When such an item is selected its tab
+ * view asks its delegate for the view with
+ * -tabView:viewForTabViewItem:, so an item whose view is expensive to
+ * build can be given a nil view until it is first shown.
+ */
+- (BOOL) isViewLoaded;
+/** Releases the view of the receiver, and forgets its initial first
+ * responder, unless the receiver is selected.
+ */
+- (void) unloadView;
+@end
+#endif
+
 #endif // _GNUstep_H_NSTabViewItem
 
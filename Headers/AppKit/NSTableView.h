@@ -36,6 +36,7 @@
 
 @class NSArray;
 @class NSIndexSet;
+@class NSMapTable;
 @class NSMutableIndexSet;
 @class NSTableColumn;
 @class NSTableHeaderView;
@@ -68,6 +69,19 @@ typedef enum _NSTableViewColumnAutoresizingStyle
 } NSTableViewColumnAutoresizingStyle;
 #endif
 
+#if OS_API_VERSION(MAC_OS_X_VERSION_10_7, GS_API_LATEST)
+enum {
+    NSTableViewAnimationEffectNone = 0x0,
+    NSTableViewAnimationEffectFade = 0x1,
+    NSTableViewAnimationEffectGap = 0x2,
+    NSTableViewAnimationSlideUp = 0x10,
+    NSTableViewAnimationSlideDown = 0x20,
+    NSTableViewAnimationSlideLeft = 0x30,
+    NSTableViewAnimationSlideRight = 0x40
+};
+typedef NSUInteger NSTableViewAnimationOptions;
+#endif
+
 
 @interface NSTableView : NSControl <NSUserInterfaceValidations>
 {
@@ -134,6 +148,43 @@ typedef enum _NSTableViewColumnAutoresizingStyle
    * which updates the cache.  */
   CGFloat *_columnOrigins;
 
+  /*
+   * When the delegate gives rows heights of their own, we keep the
+   * height of each row and a Fenwick tree of the sums of the heights,
+   * so that the origin of a row and the row at a given height are
+   * found in logarithmic time, and a changed height is updated in
+   * logarithmic time too.  Both are NULL when all rows have _rowHeight.
+   */
+  CGFloat *_rowHeights;
+  CGFloat *_rowHeightSums;
+
+  /*
+   * Object values of cells got from the data source, by row and column,
+   * when -cachesObjectValues is YES.  Forgotten when the data is
+   * reloaded or edited, and for rows far from the visible ones.
+   */
+  BOOL _cachesObjectValues;
+  NSMapTable *_objectValueCache;
+
+  /* YES if _dataSource responds to
+     tableView:objectValuesForTableColumns:rows: */
+  BOOL _dataSource_batches;
+  /* YES if _dataSource responds to tableView:prefetchRows: */
+  BOOL _dataSource_prefetches;
+  /* The visible rows when the data source was last told to prefetch */
+  NSRange _prefetchedRows;
+
+  /* Nesting of -beginUpdates, and the first row inserted, removed or
+     moved since the outermost one, which is where redisplay starts */
+  NSInteger _beginUpdatesCount;
+  NSInteger _firstChangedRow;
+
+  /* Sorted strings of the first column for type-select, the characters
+     typed so far and when the last one was typed */
+  id _typeSelectIndex;
+  NSString *_typeSelectString;
+  NSTimeInterval _typeSelectTime;
+
   /*
    *  We keep the superview's width in order to know when to
    *  size the last column to fit
@@ -156,6 +207,23 @@ typedef enum _NSTableViewColumnAutoresizingStyle
 
 /* Loading data */
 - (void) reloadData;
+#if OS_API_VERSION(MAC_OS_X_VERSION_10_6, GS_API_LATEST)
+- (void) reloadDataForRowIndexes: (NSIndexSet *)rowIndexes
+                   columnIndexes: (NSIndexSet *)columnIndexes;
+#endif
+#if OS_API_VERSION(MAC_OS_X_VERSION_10_7, GS_API_LATEST)
+- (void) beginUpdates;
+- (void) endUpdates;
+- (void) insertRowsAtIndexes: (NSIndexSet *)indexes
+               withAnimation: (NSTableViewAnimationOptions)animationOptions;
+- (void) removeRowsAtIndexes: (NSIndexSet *)indexes
+               withAnimation: (NSTableViewAnimationOptions)animationOptions;
+- (void) moveRowAtIndex: (NSInteger)oldIndex toIndex: (NSInteger)newIndex;
+#endif
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+- (void) setCachesObjectValues: (BOOL)flag;
+- (BOOL) cachesObjectValues;
+#endif
 
 /* Target-action */
 - (void) setDoubleAction: (SEL)aSelector;
@@ -387,6 +455,28 @@ typedef enum _NSTableViewColumnAutoresizingStyle
       toPasteboard: (NSPasteboard*)pboard;
 - (NSArray *) tableView: (NSTableView *)aTableView namesOfPromisedFilesDroppedAtDestination: (NSURL *)dropDestination forDraggedRowsWithIndexes: (NSIndexSet *)indexSet;
 #endif
+
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+/**
+ * Returns the object values of the cells in the given rows and columns
+ * in one array, row by row, with NSNull for cells without a value.
+ * If the data source implements this, the table gets the values of
+ * all visible rows with one message instead of one per cell, and keeps
+ * them as if -cachesObjectValues was YES.  Useful when each message is
+ * a round trip to a database or another process.
+ */
+- (NSArray *) tableView: (NSTableView *)aTableView
+objectValuesForTableColumns: (NSArray *)tableColumns
+                   rows: (NSRange)rows;
+
+/**
+ * Tells the data source that the rows are just outside the visible
+ * part of the table, so their values are likely to be asked for soon
+ * when the table is scrolled.  A hint only.
+ */
+- (void) tableView: (NSTableView *)aTableView
+      prefetchRows: (NSRange)rows;
+#endif
 @end
 
 APPKIT_EXPORT NSString *NSTableViewColumnDidMoveNotification;
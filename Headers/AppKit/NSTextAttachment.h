@@ -150,6 +150,8 @@ The class uses -cellSize and -cellBaselineOffset to return a rect.
  */
 @interface NSTextAttachmentCell : NSCell <NSTextAttachmentCell> {
     NSTextAttachment *_attachment;
+    BOOL _needs_image;	/* The image of the attachment is made when the
+			   cell is first measured or drawn.  */
 }
 @end
 
@@ -150,6 +150,28 @@ enum
 - (void) invalidateAttributesInRange: (NSRange)range;
 #endif
 
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+/** Allocates a text storage using the named backing store.<br />
+ * @"Array" keeps the attribute runs in an array and the characters in
+ * a contiguous buffer, which is fastest for small texts.
+ * @"Rope" keeps the characters in a piece table and the attribute runs in
+ * a balanced tree, so editing in the middle of a large text is O(log n).
+ * <br />
+ * A nil name gives the backing store set with the
+ * GSTextStorageBackingStore user default (@"Array" if it is not set),
+ * which is also what +allocWithZone: uses.
+ */
++ (id) allocWithBackingStore: (NSString*)name zone: (NSZone*)zone;
+
+/** Returns statistics of the cache shared by all text storage objects to
+ * store one copy of each distinct attributes dictionary.  The keys are
+ * @"Hits" and @"Misses" (lookups which found an existing dictionary or
+ * added a new one), @"HitRate" and @"Entries" (dictionaries currently in
+ * the cache).
+ */
++ (NSDictionary*) attributeCacheStatistics;
+#endif
+
 /** Returns the string data stored by the receiver.<br />
  * For performance reasons (and OSX compatibility) this is actually
  * a proxy to the internal representation of the string.<br />
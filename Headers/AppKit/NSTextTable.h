@@ -133,6 +133,9 @@ typedef enum _NSTextTableLayoutAlgorithm {
   NSUInteger _numberOfColumns;
   BOOL _collapsesBorders;
   BOOL _hidesEmptyCells;
+  // Left edges of the columns, and the right edge of the last one
+  CGFloat *_columnEdges;
+  CGFloat _columnEdgesWidth;
 }
 
 - (NSRect) boundsRectForBlock: (NSTextTableBlock *)block
@@ -247,6 +247,7 @@ therefore be stored in the NSLayoutManager to avoid problems.
   // Text checking (spelling/grammar)
   NSTimer *_textCheckingTimer;
   NSRect _lastCheckedRect;
+  id _incrementalSpellChecker;
 }
 
 
@@ -647,6 +648,12 @@ NSLayoutManager will send this message to a text view when layout information
 for that text view has been invalidated.
 */
 -(void) _layoutManagerDidInvalidateLayout;
+
+/*
+NSLayoutManager will send this message to a text view when background
+layout has laid out more of the text in its text container.
+*/
+-(void) _layoutManagerDidLayoutGlyphRange: (NSRange)glyphRange;
 @end
 
 
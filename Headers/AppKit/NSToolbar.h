@@ -96,6 +96,8 @@ APPKIT_EXPORT NSString *NSToolbarWillAddItemNotification;
   NSArray *_interfaceBuilderAllowedItemIdentifiers;
   NSArray *_interfaceBuilderDefaultItemIdentifiers;
   NSArray *_interfaceBuilderSelectableItemIdentifiers;
+  NSTimeInterval _validationInterval;
+  NSTimeInterval _lastValidation;
 }
 
 // Instance methods
@@ -136,6 +138,18 @@ APPKIT_EXPORT NSString *NSToolbarWillAddItemNotification;
 - (BOOL) showsBaselineSeparator;
 - (void) setShowsBaselineSeparator: (BOOL)flag;
 #endif
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+/** Returns the minimum time between two validations of the visible items
+ *  when the window of the toolbar is updated.  The default is 0, which
+ *  validates them on every update.
+ */
+- (NSTimeInterval) validationInterval;
+/** Sets the minimum time between two validations of the visible items
+ *  when the window of the toolbar is updated.  Items are still validated
+ *  when -validateVisibleItems is called directly.
+ */
+- (void) setValidationInterval: (NSTimeInterval)interval;
+#endif
 
 @end /* interface of NSToolbar */
 
@@ -90,6 +90,12 @@ enum _NSToolbarItemVisibilityPriority {
   // size
   NSSize _maxSize;
   NSSize _minSize;
+
+  // validation, the class of the last validator and how it validates
+  Class _validatorClass;
+  SEL _validatorAction;
+  SEL _validatorSelector;
+  BOOL _validatorResponds;
 }
 
 // Instance methods
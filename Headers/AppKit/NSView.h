@@ -111,6 +111,12 @@ typedef enum _NSFocusRingType {
   NSMutableArray *_tracking_rects;
   NSMutableArray *_cursor_rects;
   NSRect _invalidRect;
+  NSRect *_invalidRects;
+  NSUInteger _invalidRectCount;
+  id _displayCache;
+  NSRect _displayCacheRect;
+  void *_subviewIndex;
+  void *_liveResize;
   NSRect _visibleRect;
   NSInteger _gstate;
   void *_nextKeyView;
@@ -133,6 +139,11 @@ typedef enum _NSFocusRingType {
     unsigned	has_tooltips:1;		/* The view has tooltips set.	*/
     unsigned	ignores_backing:1;      /* The view does not trigger    */
                                         /* backing flush when drawn     */
+    unsigned	caches_display:1;	/* Keep what was drawn.		*/
+    unsigned	cursor_rects_pending:1;	/* Cursor rects need a reset.	*/
+    unsigned	needs_layout:1;		/* Subviews need autoresizing.	*/
+    unsigned	subtree_needs_layout:1;	/* Some view inside needs it.	*/
+    unsigned	keeps_overdraw:1;	/* Clip view keeps bits around.	*/
   } _rFlags;
 
   BOOL _is_rotated_from_base;
@@ -149,6 +160,7 @@ typedef enum _NSFocusRingType {
   NSUInteger _autoresizingMask;
   NSFocusRingType _focusRingType;
   NSRect _autoresizingFrameError;
+  NSSize _autoresizingOldSize;
 }
 
 /*
@@ -240,6 +252,24 @@ typedef enum _NSFocusRingType {
 	      fromView: (NSView*)aView;
 - (NSSize) convertSize: (NSSize)aSize
 		toView: (NSView*)aView;
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+/** Converts count points in place, as -convertPoint:fromView: does,
+    using one transform for all of them.  */
+- (void) convertPoints: (NSPoint *)points
+		 count: (NSUInteger)count
+	      fromView: (NSView*)aView;
+- (void) convertPoints: (NSPoint *)points
+		 count: (NSUInteger)count
+		toView: (NSView*)aView;
+/** Converts count rects in place, as -convertRect:fromView: does,
+    using one transform for all of them.  */
+- (void) convertRects: (NSRect *)rects
+		count: (NSUInteger)count
+	     fromView: (NSView*)aView;
+- (void) convertRects: (NSRect *)rects
+		count: (NSUInteger)count
+	       toView: (NSView*)aView;
+#endif
 #if OS_API_VERSION(MAC_OS_X_VERSION_10_5, GS_API_LATEST)
 - (NSPoint) convertPointFromBase: (NSPoint)aPoint;
 - (NSPoint) convertPointToBase: (NSPoint)aPoint;
@@ -266,6 +296,20 @@ typedef enum _NSFocusRingType {
 - (void) setAutoresizingMask: (NSUInteger)mask;
 - (NSUInteger) autoresizingMask;
 - (void) resizeWithOldSuperviewSize: (NSSize)oldSize;
+#if OS_API_VERSION(MAC_OS_X_VERSION_10_7, GS_API_LATEST)
+- (BOOL) needsLayout;
+- (void) setNeedsLayout: (BOOL)flag;
+- (void) layoutSubtreeIfNeeded;
+#endif
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+/** Sets whether views in a window autoresize their subviews when their
+    frame changes, or only mark themselves as needing layout and leave it
+    to a single pass over the window before it is displayed.  The default
+    is NO, unless the GSDefersAutoresizing user default is set.  */
++ (void) setDefersAutoresizing: (BOOL)flag;
+/** Returns whether autoresizing of subviews is deferred.  */
++ (BOOL) defersAutoresizing;
+#endif
 
 /*
  * Focusing
@@ -334,6 +378,22 @@ typedef enum _NSFocusRingType {
 - (void) viewWillStartLiveResize;
 - (void) viewDidEndLiveResize;
 #endif
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+/** Sets whether the receiver keeps a copy of what it and its subviews
+    drew, and draws that copy instead of drawing again when it is
+    displayed and nothing in it has been marked as needing display.
+    This is only done for opaque views which are not rotated or scaled
+    from the window.  The default is NO.  */
+- (void) setCachesDisplay: (BOOL)flag;
+/** Returns whether the receiver keeps a copy of what it drew.  */
+- (BOOL) cachesDisplay;
+/** Returns whether the receiver shows a copy of what it drew at the
+    start of a live resize, scaled to its visible rect, instead of
+    laying out its subviews and drawing during the resize.  Subclasses
+    which can do without full fidelity while the window is being
+    resized may return YES.  The default is NO.  */
+- (BOOL) stretchesContentDuringLiveResize;
+#endif
 #if OS_API_VERSION(MAC_OS_X_VERSION_10_4, GS_API_LATEST)
 - (BOOL) preservesContentDuringLiveResize;
 - (void) getRectsExposedDuringLiveResize: (NSRect[4])exposedRects count: (NSInteger *)count;
@@ -535,6 +595,10 @@ typedef enum _NSFocusRingType {
 - (NSPoint) locationOfPrintRect: (NSRect)aRect;
 - (NSRect) rectForPage: (NSInteger)page;
 - (CGFloat) widthAdjustLimit;
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+- (BOOL) canPrintPagesConcurrently;
+- (NSUInteger) pageLayoutGeneration;
+#endif
 
 /*
  * Writing Conforming PostScript
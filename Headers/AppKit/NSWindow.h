@@ -193,12 +193,16 @@ APPKIT_EXPORT NSSize NSTokenSize;
   NSString      *_windowTitle;
 PACKAGE_SCOPE
   NSPoint       _lastPoint;
+  void          *_trackingRectIndex;
+  NSMutableArray *_invalidCursorRectViews;
 @protected
   NSBackingStoreType _backingType;
   NSUInteger    _styleMask;
   NSInteger     _windowLevel;
 PACKAGE_SCOPE
   NSRect        _rectNeedingFlush;
+  NSRect        *_rectsNeedingFlush;
+  NSUInteger    _rectsNeedingFlushCount;
   NSMutableArray *_rectsBeingDrawn;
 @protected
   unsigned	_disableFlushWindow;
@@ -213,6 +217,12 @@ PACKAGE_SCOPE
   NSCachedImageRep *_cachedImage;
   NSPoint        _cachedImageOrigin;
   NSWindow       *_attachedSheet;
+  NSUInteger     _autodisplayCount;
+  NSTimeInterval _autodisplayTime;
+  NSTimeInterval _autodisplayDuration;
+PACKAGE_SCOPE
+  void           *_displayTimings;
+  void           *_inputLatencyTags;
 
 PACKAGE_SCOPE
   struct GSWindowFlagsType {
@@ -250,11 +260,14 @@ PACKAGE_SCOPE
     unsigned is_movable_by_window_background: 1;
     unsigned allows_tooltips_when_inactive: 1;
 
-    // 4 used 28 available
+    // 7 used 25 available
     unsigned shows_toolbar_button: 1;
     unsigned autorecalculates_keyview_loop: 1;
     unsigned ignores_mouse_events: 1;
     unsigned preserves_content_during_live_resize: 1;
+    unsigned tracking_rects_valid: 1;
+    unsigned in_live_resize: 1;
+    unsigned views_need_layout: 1;
   } _f;
 @protected 
   NSToolbar     *_toolbar;
@@ -409,6 +422,9 @@ PACKAGE_SCOPE
 - (BOOL) preservesContentDuringLiveResize;
 - (void) setPreservesContentDuringLiveResize: (BOOL)flag;
 #endif
+#if OS_API_VERSION(MAC_OS_X_VERSION_10_6, GS_API_LATEST)
+- (BOOL) inLiveResize;
+#endif
 
 /*
  * Constraining size
@@ -494,6 +510,17 @@ PACKAGE_SCOPE
 - (void) update;
 - (void) useOptimizedDrawing: (BOOL)flag;
 - (BOOL) viewsNeedDisplay;
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
++ (double) autodisplayFrameRate;
++ (void) setAutodisplayFrameRate: (double)rate;
+- (NSUInteger) autodisplayCount;
+- (NSTimeInterval) lastAutodisplayTime;
+- (NSTimeInterval) lastAutodisplayDuration;
++ (BOOL) recordsDisplayTimings;
++ (void) setRecordsDisplayTimings: (BOOL)flag;
+- (NSDictionary *) displayTimings;
+- (void) resetDisplayTimings;
+#endif
 
 - (BOOL) isFlushWindowDisabled;
 - (void) disableFlushWindow;
@@ -805,6 +832,13 @@ PACKAGE_SCOPE
  */
 - (void) _setVisible: (BOOL)flag;
 
+/*
+ * Bracket a resize of the window by the user, so that its views can
+ * draw cheaply until it is over.
+ */
+- (void) _startLiveResize;
+- (void) _endLiveResize;
+
 @end
 #endif
 
@@ -877,6 +911,9 @@ APPKIT_EXPORT NSString *NSWindowDidDeminiaturizeNotification;
 #if OS_API_VERSION(GS_API_MACOSX, GS_API_LATEST)
 APPKIT_EXPORT NSString *NSWindowDidEndSheetNotification;
 #endif
+#if OS_API_VERSION(MAC_OS_X_VERSION_10_6, GS_API_LATEST)
+APPKIT_EXPORT NSString *NSWindowDidEndLiveResizeNotification;
+#endif
 APPKIT_EXPORT NSString *NSWindowDidExposeNotification;
 APPKIT_EXPORT NSString *NSWindowDidMiniaturizeNotification;
 APPKIT_EXPORT NSString *NSWindowDidMoveNotification;
@@ -890,5 +927,8 @@ APPKIT_EXPORT NSString *NSWindowWillBeginSheetNotification;
 APPKIT_EXPORT NSString *NSWindowWillCloseNotification;
 APPKIT_EXPORT NSString *NSWindowWillMiniaturizeNotification;
 APPKIT_EXPORT NSString *NSWindowWillMoveNotification;
+#if OS_API_VERSION(MAC_OS_X_VERSION_10_6, GS_API_LATEST)
+APPKIT_EXPORT NSString *NSWindowWillStartLiveResizeNotification;
+#endif
 
 #endif /* _GNUstep_H_NSWindow */
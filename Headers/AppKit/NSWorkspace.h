@@ -31,6 +31,7 @@
 #define _GNUstep_H_NSWorkspace
 
 #import <Foundation/NSObject.h>
+#import <Foundation/NSDate.h>
 #import <Foundation/NSGeometry.h>
 #import <AppKit/AppKitDefines.h>
 
@@ -74,8 +75,9 @@ typedef NSUInteger NSWorkspaceIconCreationOptions;
 
 @interface NSWorkspace : NSObject
 {
-  NSMutableDictionary	*_iconMap;
+  id			_iconCache;
   NSMutableDictionary	*_launched;
+  NSMutableDictionary	*_pendingLaunches;
   NSNotificationCenter	*_workspaceCenter;
   BOOL			_fileSystemChanged;
   BOOL			_userDefaultsChanged;
@@ -257,6 +259,22 @@ conformsToType: (NSString *)secondTypeName;
 - (void) setBestApp: (NSString*)appName
 	     inRole: (NSString*)role
 	  forScheme: (NSString*)scheme;
+- (NSDictionary*) iconCacheStatistics;
+- (void) requestThumbnailForFile: (NSString*)fullPath
+			  target: (id)target
+			selector: (SEL)aSelector;
+- (void) launchApplication: (NSString*)appName
+		  showIcon: (BOOL)showIcon
+		autolaunch: (BOOL)autolaunch
+		   timeout: (NSTimeInterval)timeout
+		    target: (id)target
+		  selector: (SEL)aSelector;
+- (void) openFile: (NSString*)fullPath
+  withApplication: (NSString*)appName
+    andDeactivate: (BOOL)flag
+	  timeout: (NSTimeInterval)timeout
+	   target: (id)target
+	 selector: (SEL)aSelector;
 @end
 #endif
 
@@ -301,6 +319,30 @@ APPKIT_EXPORT NSString *NSWorkspaceSessionDidResignActiveNotification;
 APPKIT_EXPORT NSString *NSWorkspaceWillSleepNotification;
 #endif
 
+#if OS_API_VERSION(GS_API_NONE, GS_API_NONE)
+/**
+ * Bursts of workspace notifications with the same name are sent between
+ * applications in batches.  Each notification is still posted to the
+ * observers of its name.  Observers of this notification receive every
+ * workspace notification once more, as part of a batch, which lets them
+ * handle a burst in one go.  The userInfo dictionary contains -
+ * <deflist>
+ * <term>GSWorkspaceBatchNameKey</term>
+ * <desc>The name of the notifications in the batch.
+ * A string.
+ * </desc>
+ * <term>GSWorkspaceBatchUserInfoKey</term>
+ * <desc>The userInfo dictionaries of the notifications, in the order
+ * they were posted.  An NSNull stands for a notification without one.
+ * An array.
+ * </desc>
+ * </deflist>
+ */
+APPKIT_EXPORT NSString *GSWorkspaceBatchNotification;
+APPKIT_EXPORT NSString *GSWorkspaceBatchNameKey;
+APPKIT_EXPORT NSString *GSWorkspaceBatchUserInfoKey;
+#endif
+
 //
 // Workspace File Type Globals 
 //
@@ -59,27 +59,9 @@
 +(NSPrinter*) defaultPrinter
 {
   NSString *defaultName;
-  int numDests;
-  cups_dest_t* dests;
-  cups_dest_t* dest = NULL;
  
-  numDests = cupsGetDests( &dests );
-  if (dests) 
-    {
-      // use NULL to request the default printer
-      dest = cupsGetDest( NULL, NULL, numDests, dests );
-    }
- 
-  if (dest)
-     {
-       defaultName = [NSString stringWithCString: dest->name];
-     }
-   else
-     {
-       defaultName = GSCUPSDummyPrinterName;
-     }
+  defaultName = [GSCUPSPrinter defaultPrinterName];
   NSDebugLLog(@"GSCUPS", @"The default printer name is %@", defaultName);
-  cupsFreeDests( numDests, dests );
   
   return [NSPrinter printerWithName: defaultName];  
 }
@@ -130,6 +112,7 @@
 
   cupsSetDests( numDests, dests );
   cupsFreeDests( numDests, dests );
+  [GSCUPSPrinter invalidatePrinterNames];
 }
 
 @end
@@ -38,6 +38,7 @@
 //will likely have to implement much more
 @interface GSCUPSPrintOperation : GSPrintOperation
 {
+  int _job;	// Job the output is streamed to
 }
 
 @end
@@ -32,7 +32,9 @@
 #import <Foundation/NSDebug.h>
 #import <Foundation/NSDictionary.h>
 #import <Foundation/NSPathUtilities.h>
+#import <Foundation/NSProcessInfo.h>
 #import <Foundation/NSString.h>
+#import <Foundation/NSUserDefaults.h>
 #import <AppKit/NSGraphicsContext.h>
 #import <AppKit/NSView.h>
 #import <AppKit/NSPrinter.h>
@@ -93,6 +95,60 @@
   return YES;
 }
 
+/* With the GSCUPSStreamJobs user default set, a job is sent to the
+   printer a page at a time as it is printed, instead of being spooled
+   once the whole of it has been written to a file. */
+- (BOOL) _shouldStreamOutput
+{
+  NSPrintInfo *info;
+
+  if ([super _shouldStreamOutput])
+    return YES;
+  info = [self printInfo];
+  return [[info jobDisposition] isEqual: NSPrintSpoolJob]
+    && [[info dictionary] objectForKey: NSPrintSavePath] == nil
+    && [[NSUserDefaults standardUserDefaults] boolForKey: @"GSCUPSStreamJobs"];
+}
+
+- (BOOL) _beginStreamedOutput
+{
+  const char *name;
+
+  if (_output_stream != nil)
+    return [super _beginStreamedOutput];
+
+  name = [[[[self printInfo] printer] name] UTF8String];
+  _job = cupsCreateJob(CUPS_HTTP_DEFAULT, name,
+                       [[[NSProcessInfo processInfo] processName] UTF8String],
+                       0, NULL);
+  if (_job == 0)
+    {
+      NSDebugMLLog(@"GSPrinting", @"Can't create job: %s",
+                   cupsLastErrorString());
+      return NO;
+    }
+  return cupsStartDocument(CUPS_HTTP_DEFAULT, name, _job, _path,
+                           CUPS_FORMAT_AUTO, 1) == HTTP_CONTINUE;
+}
+
+- (BOOL) _writeStreamedBytes: (const uint8_t *)bytes
+                      length: (NSUInteger)length
+{
+  if (_output_stream != nil)
+    return [super _writeStreamedBytes: bytes length: length];
+  return cupsWriteRequestData(CUPS_HTTP_DEFAULT, (const char *)bytes,
+                              length) == HTTP_CONTINUE;
+}
+
+- (BOOL) _endStreamedOutput
+{
+  if (_output_stream != nil)
+    return [super _endStreamedOutput];
+  return cupsFinishDocument(CUPS_HTTP_DEFAULT,
+                            [[[[self printInfo] printer] name] UTF8String])
+    == IPP_OK;
+}
+
 - (NSGraphicsContext*)createContext
 {
   NSMutableDictionary *info;
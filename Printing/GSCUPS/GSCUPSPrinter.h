@@ -37,10 +37,20 @@
 
 extern NSString *GSCUPSDummyPrinterName;
 
+/* The destinations CUPS knows about are looked up once and remembered
+   for GSCUPSPrinterCacheTimeout seconds (60 if the user default is not
+   set).  Once they are that old they are looked up again in the
+   background, and GSPrinterNamesDidChangeNotification is posted if they
+   changed.  These methods may be called from any thread. */
 @interface GSCUPSPrinter : NSPrinter
 {
 }
 
++ (NSString *) defaultPrinterName;
+
+/* Forgets the destinations, so they are looked up on the next call. */
++ (void) invalidatePrinterNames;
+
 @end
 
 #endif // _GNUstep_H_GSCUPSPrinter
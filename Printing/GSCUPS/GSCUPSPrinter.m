@@ -37,12 +37,18 @@
 #import "config.h"
 #import <Foundation/NSDebug.h>
 #import <Foundation/NSArray.h>
+#import <Foundation/NSAutoreleasePool.h>
 #import <Foundation/NSString.h>
 #import <Foundation/NSBundle.h>
+#import <Foundation/NSDate.h>
 #import <Foundation/NSException.h>
 #import <Foundation/NSFileManager.h>
+#import <Foundation/NSLock.h>
+#import <Foundation/NSNotification.h>
 #import <Foundation/NSPathUtilities.h>
 #import <Foundation/NSSet.h>
+#import <Foundation/NSThread.h>
+#import <Foundation/NSUserDefaults.h>
 #import "AppKit/AppKitExceptions.h"
 #import "AppKit/NSGraphics.h"
 #import "GNUstepGUI/GSPrinting.h"
@@ -53,6 +59,21 @@
 
 NSString *GSCUPSDummyPrinterName = @"GSCUPSDummyPrinter";
 
+#define DEFAULT_CACHE_TIMEOUT 60.0
+
+/* The destinations last read from CUPS, protected by destCondition. */
+static NSCondition *destCondition = nil;
+static NSArray *destNames = nil;
+static NSString *destDefault = nil;
+static NSDate *destDate = nil;
+static BOOL destRefreshing = NO;
+
+@interface GSCUPSPrinter (DestinationCache)
++ (void) _readDestinations;
++ (void) _refreshDestinations: (id)unused;
++ (void) _lookUpDestinationsIfNeeded;
+@end
+
 @implementation GSCUPSPrinter
 
 //
@@ -64,6 +85,13 @@ NSString *GSCUPSDummyPrinterName = @"GSCUPSDummyPrinter";
     {
       // Initial version
       [self setVersion:1];
+      destCondition = [NSCondition new];
+      /* Start looking for printers now, so the list is likely to be
+         ready by the time a print panel asks for it. */
+      destRefreshing = YES;
+      [NSThread detachNewThreadSelector: @selector(_refreshDestinations:)
+                               toTarget: self
+                             withObject: nil];
     }
 }
 
@@ -135,8 +163,47 @@ static BOOL didWarn;
 
 
 + (NSArray *)printerNames
+{
+  NSArray *names;
+
+  [self _lookUpDestinationsIfNeeded];
+  [destCondition lock];
+  names = RETAIN(destNames);
+  [destCondition unlock];
+  return AUTORELEASE(names);
+}
+
++ (NSString *) defaultPrinterName
+{
+  NSString *name;
+
+  [self _lookUpDestinationsIfNeeded];
+  [destCondition lock];
+  name = RETAIN(destDefault);
+  [destCondition unlock];
+  return AUTORELEASE(name);
+}
+
++ (void) invalidatePrinterNames
+{
+  [destCondition lock];
+  DESTROY(destDate);
+  [destCondition unlock];
+}
+
+@end
+
+
+@implementation GSCUPSPrinter (DestinationCache)
+
+/* Reads the destinations from CUPS, which may mean asking a server
+   about each of its queues, so this is done without the lock held. */
++ (void) _readDestinations
 {
   NSMutableSet *set;
+  NSString *def = nil;
+  NSArray *names;
+  BOOL changed;
   int numDests;
   cups_dest_t* dests;
   int n;
@@ -149,6 +216,10 @@ static BOOL didWarn;
   for (n = 0; n < numDests; n++)
     {
       [set addObject: [NSString stringWithCString: dests[n].name]];
+      if (dests[n].is_default && def == nil)
+        {
+          def = [NSString stringWithCString: dests[n].name];
+        }
     }
 
   cupsFreeDests(numDests, dests);
@@ -158,8 +229,81 @@ static BOOL didWarn;
     {
       [set addObject: GSCUPSDummyPrinterName];
     }
+  if (def == nil)
+    {
+      def = GSCUPSDummyPrinterName;
+    }
+  names = [set allObjects];
+
+  [destCondition lock];
+  changed = (destNames != nil
+    && [[NSSet setWithArray: destNames] isEqualToSet: set] == NO);
+  ASSIGN(destNames, names);
+  ASSIGN(destDefault, def);
+  ASSIGN(destDate, [NSDate date]);
+  destRefreshing = NO;
+  [destCondition broadcast];
+  [destCondition unlock];
+
+  if (changed)
+    {
+      NSNotification *n;
+
+      n = [NSNotification
+        notificationWithName: GSPrinterNamesDidChangeNotification
+                      object: self];
+      [[NSNotificationCenter defaultCenter]
+        performSelectorOnMainThread: @selector(postNotification:)
+                         withObject: n
+                      waitUntilDone: NO];
+    }
+}
+
++ (void) _refreshDestinations: (id)unused
+{
+  CREATE_AUTORELEASE_POOL(pool);
+
+  [self _readDestinations];
+  DESTROY(pool);
+}
+
+/* Makes sure there are destinations to answer with.  Waits for the
+   first lookup if one is running, and looks them up again in the
+   background once they are out of date. */
++ (void) _lookUpDestinationsIfNeeded
+{
+  BOOL readNow = NO;
+  NSTimeInterval timeout;
+  id value;
+
+  value = [[NSUserDefaults standardUserDefaults]
+    objectForKey: @"GSCUPSPrinterCacheTimeout"];
+  timeout = (value != nil) ? [value doubleValue] : DEFAULT_CACHE_TIMEOUT;
+
+  [destCondition lock];
+  while (destNames == nil && destRefreshing)
+    {
+      [destCondition wait];
+    }
+  if (destNames == nil)
+    {
+      destRefreshing = YES;
+      readNow = YES;
+    }
+  else if (!destRefreshing
+    && (destDate == nil || -[destDate timeIntervalSinceNow] > timeout))
+    {
+      destRefreshing = YES;
+      [NSThread detachNewThreadSelector: @selector(_refreshDestinations:)
+                               toTarget: self
+                             withObject: nil];
+    }
+  [destCondition unlock];
 
-  return [set allObjects];
+  if (readNow)
+    {
+      [self _readDestinations];
+    }
 }
 
 @end
@@ -81,10 +81,12 @@ NSApplicationMain(int argc, const char **argv)
   mainModelFile = [infoDict objectForKey: @"NSMainNibFile"];
   if (mainModelFile != nil && [mainModelFile isEqual: @""] == NO)
     {
+      GSLaunchTimelineBegin(@"main model");
       if ([NSBundle loadNibNamed: mainModelFile owner: NSApp] == NO)
 	{
 	  NSLog (_(@"Cannot load the main model file '%@'"), mainModelFile);
 	}
+      GSLaunchTimelineEnd(@"main model");
     }
 
   RECREATE_AUTORELEASE_POOL(pool);
@@ -537,22 +539,32 @@ void NSRectClip(NSRect aRect)
 
 void NSRectClipList(const NSRect *rects, NSInteger count)
 {
+  NSGraphicsContext *ctxt;
   NSInteger i;
-  NSRect union_rect;
 
   if (count == 0)
     return;
+  if (count == 1)
+    {
+      NSRectClip(rects[0]);
+      return;
+    }
 
-  /* 
-     The specification is not clear if the union of the rects 
-     should produce the new clip rect or if the outline of all rects 
-     should be used as clip path.
-  */
-  union_rect = rects[0];
-  for (i = 1; i < count; i++)
-    union_rect = NSUnionRect(union_rect, rects[i]);
-
-  NSRectClip(union_rect);
+  /* Clip to the area covered by the rects, not their bounding rect.  All
+     the rects go the same way round, so the nonzero winding rule takes
+     in every point of any of them.  */
+  ctxt = GSCurrentContext();
+  DPSnewpath(ctxt);
+  for (i = 0; i < count; i++)
+    {
+      DPSmoveto(ctxt, NSMinX(rects[i]), NSMinY(rects[i]));
+      DPSrlineto(ctxt, NSWidth(rects[i]), 0);
+      DPSrlineto(ctxt, 0, NSHeight(rects[i]));
+      DPSrlineto(ctxt, -NSWidth(rects[i]), 0);
+      DPSclosepath(ctxt);
+    }
+  DPSclip(ctxt);
+  DPSnewpath(ctxt);
 }
 
 void NSRectFill(NSRect aRect)
@@ -25,14 +25,18 @@
    Boston, MA 02110-1301, USA.
 */ 
 
+#import <Foundation/NSArray.h>
+#import <Foundation/NSDate.h>
 #import <Foundation/NSDebug.h>
 #import <Foundation/NSRunLoop.h>
 #import <Foundation/NSSet.h>
 #import <Foundation/NSString.h>
+#import <Foundation/NSThread.h>
 #import <Foundation/NSTimer.h>
 
 #import "AppKit/NSEvent.h"
 #import "GNUstepGUI/GSAnimator.h"
+#import "GSGuiPrivate.h"
 
 @interface GSAnimator (private)
 - (void) _animationBegin;
@@ -171,75 +175,87 @@
 
 @end
 
-static NSTimer *_GSTimerBasedAnimator_timer = nil;
-static NSMutableSet *_GSTimerBasedAnimator_animators = nil;
-static GSAnimator *_GSTimerBasedAnimator_the_one_animator = nil;
-static int _GSTimerBasedAnimator_animator_count = 0;
+/*
+ * All running animators are stepped from one timer, which fires at the
+ * frame clock of autodisplay.  An animator with a frame rate of its own
+ * is stepped on the first tick after its interval has passed, the others
+ * on every tick.  The windows the animations changed are then displayed
+ * in a single pass, rather than once for each animator.
+ */
+static NSTimer *_GSAnimator_driver = nil;
+static NSMutableArray *_GSAnimator_animators = nil;
+static NSMutableSet *_GSAnimator_modes = nil;   // Modes of the driver
 
 @implementation GSAnimator (private)
 
-+ (void) loopsAnimators
++ (void) _addDriverModes: (NSArray*)modes
 {
-  switch (_GSTimerBasedAnimator_animator_count)
+  NSUInteger i, c;
+
+  for (i = 0, c = [modes count]; i < c; i++)
     {
-    case 0:
-      break;
-    case 1:
-      [_GSTimerBasedAnimator_the_one_animator _animationLoop];
-      break;
-    default:
-      [_GSTimerBasedAnimator_animators 
-        makeObjectsPerform: @selector(_animationLoop)];
+      NSString *mode = [modes objectAtIndex: i];
+
+      if ([_GSAnimator_modes member: mode] == nil)
+        {
+          [_GSAnimator_modes addObject: mode];
+          [[NSRunLoop currentRunLoop] addTimer: _GSAnimator_driver
+                                       forMode: mode];
+        }
     }
+  NSDebugMLLog(@"GSAnimator", @"driver in %lu mode(s)",
+               (unsigned long)[_GSAnimator_modes count]);
 }
 
-- (void) _animationBegin
++ (void) loopsAnimators
 {
-  NSTimer *newTimer = nil;
-
-  if (_timerInterval == 0.0)
+  NSTimeInterval now = [NSDate timeIntervalSinceReferenceDate];
+  NSTimeInterval slack = [_GSAnimator_driver timeInterval] / 2;
+  NSString *mode = [[NSRunLoop currentRunLoop] currentMode];
+  NSArray *animators;
+  NSUInteger i, c;
+  BOOL stepped = NO;
+
+  /* Animators may stop, or start others, while they step. */
+  animators = AUTORELEASE([_GSAnimator_animators copy]);
+  for (i = 0, c = [animators count]; i < c; i++)
     {
-      NSDebugMLLog(@"GSAnimator", @"AFAP start");
-      if (!_GSTimerBasedAnimator_animator_count++)
-        _GSTimerBasedAnimator_the_one_animator = self;
-
-      if (nil == _GSTimerBasedAnimator_animators)
-        _GSTimerBasedAnimator_animators = [[NSMutableSet alloc] initWithCapacity: 5];
-      [_GSTimerBasedAnimator_animators addObject: self];
-    
-      if (nil == _GSTimerBasedAnimator_timer)
+      GSAnimator *animator = [animators objectAtIndex: i];
+
+      if (animator->_running
+        && (mode == nil || [animator->_runLoopModes containsObject: mode])
+        && now - animator->_lastFrame >= animator->_timerInterval - slack)
         {
-          newTimer = [NSTimer timerWithTimeInterval: 0.0
-                              target: [self class]
-                              selector: @selector(loopsAnimators)
-                              userInfo: nil
-                              repeats: YES];
-          ASSIGN(_GSTimerBasedAnimator_timer, newTimer);
+          [animator _animationLoop];
+          stepped = YES;
         }
     }
-  else
+  if (stepped && [NSThread isMainThread])
     {
-      NSDebugMLLog(@"GSAnimator", @"Fixed frame rate start");
-      newTimer = [NSTimer timerWithTimeInterval: _timerInterval
-                          target: self
-                          selector: @selector(_animationLoop)
-                          userInfo: nil
-                          repeats: YES];
-      ASSIGN(_timer, newTimer);
+      GSDisplayFrame();
     }
+}
 
-  if (newTimer != nil)
+- (void) _animationBegin
+{
+  NSDebugMLLog(@"GSAnimator", @"start at %g s per frame", _timerInterval);
+  if (nil == _GSAnimator_animators)
     {
-      NSUInteger i,c;
+      _GSAnimator_animators = [[NSMutableArray alloc] initWithCapacity: 5];
+      _GSAnimator_modes = [[NSMutableSet alloc] initWithCapacity: 3];
+    }
+  [_GSAnimator_animators addObject: self];
 
-      for (i = 0, c = [_runLoopModes count]; i < c; i++)
-        {
-          [[NSRunLoop currentRunLoop]
-              addTimer: newTimer
-              forMode: [_runLoopModes objectAtIndex:i]];
-        }
-      NSDebugMLLog(@"GSAnimator",@"addTimer in %lu mode(s)", (unsigned long)c);
+  if (nil == _GSAnimator_driver)
+    {
+      ASSIGN(_GSAnimator_driver,
+        [NSTimer timerWithTimeInterval: GSFrameInterval()
+                                target: [self class]
+                              selector: @selector(loopsAnimators)
+                              userInfo: nil
+                               repeats: YES]);
     }
+  [[self class] _addDriverModes: _runLoopModes];
 }
 
 - (void) _animationLoop
@@ -250,30 +266,15 @@ static int _GSTimerBasedAnimator_animator_count = 0;
 
 - (void) _animationEnd
 {
-  if (_timerInterval == 0.0)
+  NSDebugMLLog(@"GSAnimator", @"end");
+  /* Our caller still has to tell the animation. */
+  AUTORELEASE(RETAIN(self));
+  [_GSAnimator_animators removeObjectIdenticalTo: self];
+  if ([_GSAnimator_animators count] == 0)
     {
-      NSDebugMLLog(@"GSAnimator", @"AFAP end");
-      [_GSTimerBasedAnimator_animators removeObject: self];
-        
-      if (!--_GSTimerBasedAnimator_animator_count)
-        {
-          [_GSTimerBasedAnimator_timer invalidate];
-          DESTROY(_GSTimerBasedAnimator_timer);
-          _GSTimerBasedAnimator_the_one_animator = nil;
-        }
-      else
-        if (_GSTimerBasedAnimator_the_one_animator == self)
-          _GSTimerBasedAnimator_the_one_animator
-            = [_GSTimerBasedAnimator_animators anyObject];
-    }
-  else
-    {
-      NSDebugMLLog(@"GSAnimator", @"Fixed frame rate end");
-      if (_timer != nil)
-        {
-          [_timer invalidate];
-          DESTROY(_timer);
-        }
+      [_GSAnimator_driver invalidate];
+      DESTROY(_GSAnimator_driver);
+      [_GSAnimator_modes removeAllObjects];
     }
 }
 
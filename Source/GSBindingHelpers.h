@@ -41,16 +41,24 @@
 @public
   NSDictionary *info;
   id src;
+  NSString *pendingBinding;	/* Set while a change waits to be shown */
 }
 
 + (void) exposeBinding: (NSString *)binding forClass: (Class)clazz;
 + (NSArray *) exposedBindingsForClass: (Class)clazz;
+/* The bindings exposed by clazz and its superclasses */
++ (NSArray *) allExposedBindingsForClass: (Class)clazz;
 + (GSKeyValueBinding *) getBinding: (NSString *)binding 
                          forObject: (id)anObject;
 + (NSDictionary *) infoForBinding: (NSString *)binding 
                         forObject: (id)anObject;
 + (void) unbind: (NSString *)binding  forObject: (id)anObject;
 + (void) unbindAllForObject: (id)anObject;
+/* Changes of anObject are held back until the batch ends.  Batches may
+ * be nested.
+ */
++ (void) beginBatchForObject: (id)anObject;
++ (void) endBatchForObject: (id)anObject;
 
 - (id) initWithBinding: (NSString *)binding 
               withName: (NSString *)name
@@ -63,6 +71,7 @@
 - (void) reverseSetValueFor: (NSString *)binding;
 - (id) destinationValue;
 - (id) sourceValueFor: (NSString *)binding;
+- (BOOL) holdsBackChangeFor: (NSString *)binding;
 
 /* Transforms the value with a value transformer, if specified and available,
  * and takes care of any placeholders
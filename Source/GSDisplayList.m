@@ -0,0 +1,1501 @@
+/* GSDisplayList.m                                           -*-objc-*-
+
+   Recording drawing operators for replay
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of the GNUstep GUI Library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; see the file COPYING.LIB.
+   If not, see <http://www.gnu.org/licenses/> or write to the 
+   Free Software Foundation, 51 Franklin Street, Fifth Floor, 
+   Boston, MA 02110-1301, USA.
+*/
+
+#include <math.h>
+#import <Foundation/NSAffineTransform.h>
+#import <Foundation/NSArray.h>
+#import <Foundation/NSCoder.h>
+#import <Foundation/NSData.h>
+#import <Foundation/NSException.h>
+#import <Foundation/NSNull.h>
+#import "AppKit/NSBezierPath.h"
+#import "AppKit/NSBitmapImageRep.h"
+#import "AppKit/NSColorSpace.h"
+#import "AppKit/NSFont.h"
+#import "AppKit/NSGradient.h"
+#import "AppKit/NSView.h"
+#import "AppKit/DPSOperators.h"
+#import "GNUstepGUI/GSFontInfo.h"
+#import "GNUstepGUI/GSDisplayList.h"
+
+/* The operators in a display list.  Each takes its numbers from the
+   argument array in the order of the arguments of its method, and at
+   most one object from the object array.  */
+typedef enum {
+  /* Color */
+  GSDLSetAlpha,
+  GSDLSetCMYKColor,
+  GSDLSetGray,
+  GSDLSetHSBColor,
+  GSDLSetRGBColor,
+  GSDLSetPatternColor,
+  GSDLSetFillColorspace,
+  GSDLSetStrokeColorspace,
+  GSDLSetFillColor,
+  GSDLSetStrokeColor,
+  /* Text */
+  GSDLShow,
+  GSDLAShow,
+  GSDLSetCharacterSpacing,
+  GSDLSetFont,
+  GSDLSetFontSize,
+  GSDLSetTextCTM,
+  GSDLSetTextDrawingMode,
+  GSDLSetTextPosition,
+  GSDLShowText,
+  GSDLShowGlyphs,
+  GSDLShowGlyphsWithAdvances,
+  /* Gstate */
+  GSDLGRestore,
+  GSDLGSave,
+  GSDLInitGraphics,
+  GSDLSetDash,
+  GSDLSetFlat,
+  GSDLSetLineCap,
+  GSDLSetLineJoin,
+  GSDLSetLineWidth,
+  GSDLSetMiterLimit,
+  GSDLSetStrokeAdjust,
+  GSDLSetCompositingOperation,
+  GSDLSetShouldAntialias,
+  GSDLSetImageInterpolation,
+  GSDLSetPatternPhase,
+  /* Matrix */
+  GSDLConcat,
+  GSDLInitMatrix,
+  GSDLRotate,
+  GSDLScale,
+  GSDLTranslate,
+  GSDLSetCTM,
+  GSDLConcatCTM,
+  /* Paths and painting */
+  GSDLArc,
+  GSDLArcn,
+  GSDLArct,
+  GSDLClip,
+  GSDLClosePath,
+  GSDLCurveTo,
+  GSDLEOClip,
+  GSDLEOFill,
+  GSDLFill,
+  GSDLFlattenPath,
+  GSDLInitClip,
+  GSDLLineTo,
+  GSDLMoveTo,
+  GSDLNewPath,
+  GSDLRCurveTo,
+  GSDLRectClip,
+  GSDLRectFill,
+  GSDLRectStroke,
+  GSDLReversePath,
+  GSDLRLineTo,
+  GSDLRMoveTo,
+  GSDLStroke,
+  GSDLShFill,
+  GSDLSendBezierPath,
+  GSDLRectClipList,
+  GSDLRectFillList,
+  /* Images and compositing */
+  GSDLComposite,
+  GSDLCompositeRect,
+  GSDLDissolve,
+  GSDLDrawImage,
+  GSDLDrawLinearGradient,
+  GSDLDrawRadialGradient
+} GSDisplayListOp;
+
+static BOOL
+equal_objects(id a, id b)
+{
+  if (a == b)
+    return YES;
+  if ([a isKindOfClass: [NSBezierPath class]]
+      && [b isKindOfClass: [NSBezierPath class]])
+    {
+      NSInteger count = [a elementCount];
+      NSInteger i;
+
+      if ([b elementCount] != count
+          || [a windingRule] != [b windingRule])
+        return NO;
+      for (i = 0; i < count; i++)
+        {
+          NSPoint pa[3], pb[3];
+          NSBezierPathElement type = [a elementAtIndex: i associatedPoints: pa];
+          int n = (type == NSCurveToBezierPathElement) ? 3 : 1;
+
+          if ([b elementAtIndex: i associatedPoints: pb] != type)
+            return NO;
+          if (type != NSClosePathBezierPathElement
+              && memcmp(pa, pb, n * sizeof(NSPoint)) != 0)
+            return NO;
+        }
+      return YES;
+    }
+  if ([a isKindOfClass: [NSAffineTransform class]]
+      && [b isKindOfClass: [NSAffineTransform class]])
+    {
+      NSAffineTransformStruct ma = [a transformStruct];
+      NSAffineTransformStruct mb = [b transformStruct];
+
+      return memcmp(&ma, &mb, sizeof(ma)) == 0;
+    }
+  return [a isEqual: b];
+}
+
+@implementation GSDisplayList
+
+/* Appends op with count numbers to list.  */
+static void
+record(GSDisplayList *list, GSDisplayListOp op,
+       NSUInteger count, const double *values)
+{
+  NSZone *z = NSDefaultMallocZone();
+
+  if (list->opCount == list->opCapacity)
+    {
+      list->opCapacity = MAX(64, 2 * list->opCapacity);
+      list->ops = NSZoneRealloc(z, list->ops, list->opCapacity);
+    }
+  list->ops[list->opCount++] = op;
+
+  if (list->argCount + count > list->argCapacity)
+    {
+      list->argCapacity = MAX(list->argCount + count,
+                              MAX(128, 2 * list->argCapacity));
+      list->args = NSZoneRealloc(z, list->args,
+                                 list->argCapacity * sizeof(double));
+    }
+  memcpy(list->args + list->argCount, values, count * sizeof(double));
+  list->argCount += count;
+}
+
+/* Appends op with count numbers and an object, which may be nil, to
+   list.  */
+static void
+record_object(GSDisplayList *list, GSDisplayListOp op,
+              NSUInteger count, const double *values, id object)
+{
+  record(list, op, count, values);
+  [list->objects addObject: (object != nil) ? object : [NSNull null]];
+}
+
+/**
+ * Returns a display list of what view draws in rect, with the
+ * coordinates of the view.  Replaying it while the view is focused
+ * draws the same as -drawRect: would.
+ */
++ (GSDisplayList *) displayListForView: (NSView *)view rect: (NSRect)rect
+{
+  GSRecordingContext *ctxt = [GSRecordingContext new];
+  GSDisplayList *list = [ctxt displayList];
+  NSGraphicsContext *old = RETAIN(GSCurrentContext());
+
+  [NSGraphicsContext setCurrentContext: ctxt];
+  [ctxt lockFocusView: view inRect: rect];
+  NS_DURING
+    {
+      [view drawRect: rect];
+    }
+  NS_HANDLER
+    {
+      [ctxt unlockFocusView: view needsFlush: NO];
+      [NSGraphicsContext setCurrentContext: AUTORELEASE(old)];
+      RELEASE(ctxt);
+      [localException raise];
+    }
+  NS_ENDHANDLER
+  [ctxt unlockFocusView: view needsFlush: NO];
+  [NSGraphicsContext setCurrentContext: AUTORELEASE(old)];
+
+  RETAIN(list);
+  RELEASE(ctxt);
+  return AUTORELEASE(list);
+}
+
+- (id) init
+{
+  self = [super init];
+  if (self != nil)
+    {
+      objects = [NSMutableArray new];
+    }
+  return self;
+}
+
+- (void) dealloc
+{
+  if (ops != NULL)
+    NSZoneFree(NSDefaultMallocZone(), ops);
+  if (args != NULL)
+    NSZoneFree(NSDefaultMallocZone(), args);
+  RELEASE(objects);
+  [super dealloc];
+}
+
+- (id) copyWithZone: (NSZone *)zone
+{
+  GSDisplayList *copy = [[GSDisplayList allocWithZone: zone] init];
+
+  copy->opCount = copy->opCapacity = opCount;
+  copy->ops = NSZoneMalloc(NSDefaultMallocZone(), MAX(opCount, 1));
+  memcpy(copy->ops, ops, opCount);
+  copy->argCount = copy->argCapacity = argCount;
+  copy->args = NSZoneMalloc(NSDefaultMallocZone(),
+                            MAX(argCount, 1) * sizeof(double));
+  memcpy(copy->args, args, argCount * sizeof(double));
+  [copy->objects addObjectsFromArray: objects];
+  return copy;
+}
+
+- (void) encodeWithCoder: (NSCoder *)aCoder
+{
+  NSMutableArray *archived;
+  NSUInteger i;
+
+  /* Fonts are archived as NSFont, as the font info seen by the context
+     is private to the backend.  */
+  archived = [NSMutableArray arrayWithCapacity: [objects count]];
+  for (i = 0; i < [objects count]; i++)
+    {
+      id o = [objects objectAtIndex: i];
+
+      if ([o isKindOfClass: [GSFontInfo class]])
+        {
+          o = [NSFont fontWithName: [o fontName] matrix: [o matrix]];
+        }
+      [archived addObject: o];
+    }
+
+  [aCoder encodeValueOfObjCType: @encode(NSUInteger) at: &opCount];
+  [aCoder encodeArrayOfObjCType: @encode(unsigned char)
+                          count: opCount
+                             at: ops];
+  [aCoder encodeValueOfObjCType: @encode(NSUInteger) at: &argCount];
+  [aCoder encodeArrayOfObjCType: @encode(double)
+                          count: argCount
+                             at: args];
+  [aCoder encodeObject: archived];
+}
+
+- (id) initWithCoder: (NSCoder *)aDecoder
+{
+  NSArray *archived;
+  NSUInteger i;
+
+  self = [self init];
+  if (self == nil)
+    return nil;
+
+  [aDecoder decodeValueOfObjCType: @encode(NSUInteger) at: &opCount];
+  opCapacity = opCount;
+  ops = NSZoneMalloc(NSDefaultMallocZone(), MAX(opCapacity, 1));
+  [aDecoder decodeArrayOfObjCType: @encode(unsigned char)
+                            count: opCount
+                               at: ops];
+  [aDecoder decodeValueOfObjCType: @encode(NSUInteger) at: &argCount];
+  argCapacity = argCount;
+  args = NSZoneMalloc(NSDefaultMallocZone(),
+                      MAX(argCapacity, 1) * sizeof(double));
+  [aDecoder decodeArrayOfObjCType: @encode(double)
+                            count: argCount
+                               at: args];
+
+  archived = [aDecoder decodeObject];
+  for (i = 0; i < [archived count]; i++)
+    {
+      id o = [archived objectAtIndex: i];
+
+      if ([o isKindOfClass: [NSFont class]])
+        {
+          o = (id)[o fontRef];
+        }
+      [objects addObject: o];
+    }
+  return self;
+}
+
+- (BOOL) isEqual: (id)other
+{
+  GSDisplayList *list = other;
+  NSUInteger i;
+
+  if (other == self)
+    return YES;
+  if ([other isKindOfClass: [GSDisplayList class]] == NO
+      || list->opCount != opCount || list->argCount != argCount
+      || [list->objects count] != [objects count])
+    return NO;
+  if (memcmp(list->ops, ops, opCount) != 0
+      || memcmp(list->args, args, argCount * sizeof(double)) != 0)
+    return NO;
+  for (i = 0; i < [objects count]; i++)
+    {
+      if (!equal_objects([objects objectAtIndex: i],
+                         [list->objects objectAtIndex: i]))
+        return NO;
+    }
+  return YES;
+}
+
+- (NSUInteger) hash
+{
+  return opCount ^ (argCount << 8);
+}
+
+/**
+ * Returns the number of operators recorded.
+ */
+- (NSUInteger) operatorCount
+{
+  return opCount;
+}
+
+/**
+ * Discards the recorded operators.
+ */
+- (void) removeAllOperators
+{
+  opCount = 0;
+  argCount = 0;
+  [objects removeAllObjects];
+}
+
+/**
+ * Draws the recorded operators in ctxt, which need not be the current
+ * context.
+ */
+- (void) replayInContext: (NSGraphicsContext *)ctxt
+{
+  const double *a = args;
+  NSUInteger o = 0;
+  NSUInteger i;
+  id null = [NSNull null];
+  id obj;
+  CGFloat m[6];
+
+#define NEXT_OBJECT() \
+  ((obj = [objects objectAtIndex: o++]) == null ? nil : obj)
+
+  for (i = 0; i < opCount; i++)
+    {
+      switch ((GSDisplayListOp)ops[i])
+        {
+          case GSDLSetAlpha:
+            DPSsetalpha(ctxt, a[0]);
+            a += 1;
+            break;
+          case GSDLSetCMYKColor:
+            DPSsetcmykcolor(ctxt, a[0], a[1], a[2], a[3]);
+            a += 4;
+            break;
+          case GSDLSetGray:
+            DPSsetgray(ctxt, a[0]);
+            a += 1;
+            break;
+          case GSDLSetHSBColor:
+            DPSsethsbcolor(ctxt, a[0], a[1], a[2]);
+            a += 3;
+            break;
+          case GSDLSetRGBColor:
+            DPSsetrgbcolor(ctxt, a[0], a[1], a[2]);
+            a += 3;
+            break;
+          case GSDLSetPatternColor:
+            [ctxt GSSetPatterColor: NEXT_OBJECT()];
+            break;
+          case GSDLSetFillColorspace:
+            GSSetFillColorspace(ctxt, NEXT_OBJECT());
+            break;
+          case GSDLSetStrokeColorspace:
+            GSSetStrokeColorspace(ctxt, NEXT_OBJECT());
+            break;
+          case GSDLSetFillColor:
+            GSSetFillColor(ctxt, (CGFloat *)[NEXT_OBJECT() bytes]);
+            break;
+          case GSDLSetStrokeColor:
+            GSSetStrokeColor(ctxt, (CGFloat *)[NEXT_OBJECT() bytes]);
+            break;
+
+          case GSDLShow:
+            DPSshow(ctxt, [NEXT_OBJECT() bytes]);
+            break;
+          case GSDLAShow:
+            DPSashow(ctxt, a[0], a[1], [NEXT_OBJECT() bytes]);
+            a += 2;
+            break;
+          case GSDLSetCharacterSpacing:
+            GSSetCharacterSpacing(ctxt, a[0]);
+            a += 1;
+            break;
+          case GSDLSetFont:
+            GSSetFont(ctxt, NEXT_OBJECT());
+            break;
+          case GSDLSetFontSize:
+            GSSetFontSize(ctxt, a[0]);
+            a += 1;
+            break;
+          case GSDLSetTextCTM:
+            GSSetTextCTM(ctxt, NEXT_OBJECT());
+            break;
+          case GSDLSetTextDrawingMode:
+            GSSetTextDrawingMode(ctxt, (GSTextDrawingMode)a[0]);
+            a += 1;
+            break;
+          case GSDLSetTextPosition:
+            GSSetTextPosition(ctxt, NSMakePoint(a[0], a[1]));
+            a += 2;
+            break;
+          case GSDLShowText:
+            obj = NEXT_OBJECT();
+            GSShowText(ctxt, [obj bytes], [obj length]);
+            break;
+          case GSDLShowGlyphs:
+            obj = NEXT_OBJECT();
+            GSShowGlyphs(ctxt, [obj bytes], [obj length] / sizeof(NSGlyph));
+            break;
+          case GSDLShowGlyphsWithAdvances:
+            {
+              /* The advances follow the glyphs in the data.  */
+              size_t length;
+
+              obj = NEXT_OBJECT();
+              length = [obj length] / (sizeof(NSGlyph) + sizeof(NSSize));
+              GSShowGlyphsWithAdvances(ctxt, [obj bytes],
+                (const NSSize *)((const char *)[obj bytes]
+                                 + length * sizeof(NSGlyph)), length);
+            }
+            break;
+
+          case GSDLGRestore:
+            DPSgrestore(ctxt);
+            break;
+          case GSDLGSave:
+            DPSgsave(ctxt);
+            break;
+          case GSDLInitGraphics:
+            DPSinitgraphics(ctxt);
+            break;
+          case GSDLSetDash:
+            obj = NEXT_OBJECT();
+            DPSsetdash(ctxt, [obj bytes], [obj length] / sizeof(CGFloat),
+                       a[0]);
+            a += 1;
+            break;
+          case GSDLSetFlat:
+            DPSsetflat(ctxt, a[0]);
+            a += 1;
+            break;
+          case GSDLSetLineCap:
+            DPSsetlinecap(ctxt, (int)a[0]);
+            a += 1;
+            break;
+          case GSDLSetLineJoin:
+            DPSsetlinejoin(ctxt, (int)a[0]);
+            a += 1;
+            break;
+          case GSDLSetLineWidth:
+            DPSsetlinewidth(ctxt, a[0]);
+            a += 1;
+            break;
+          case GSDLSetMiterLimit:
+            DPSsetmiterlimit(ctxt, a[0]);
+            a += 1;
+            break;
+          case GSDLSetStrokeAdjust:
+            DPSsetstrokeadjust(ctxt, (int)a[0]);
+            a += 1;
+            break;
+          case GSDLSetCompositingOperation:
+            [ctxt setCompositingOperation: (NSCompositingOperation)a[0]];
+            a += 1;
+            break;
+          case GSDLSetShouldAntialias:
+            [ctxt setShouldAntialias: (a[0] != 0)];
+            a += 1;
+            break;
+          case GSDLSetImageInterpolation:
+            [ctxt setImageInterpolation: (NSImageInterpolation)a[0]];
+            a += 1;
+            break;
+          case GSDLSetPatternPhase:
+            [ctxt setPatternPhase: NSMakePoint(a[0], a[1])];
+            a += 2;
+            break;
+
+          case GSDLConcat:
+            m[0] = a[0]; m[1] = a[1]; m[2] = a[2];
+            m[3] = a[3]; m[4] = a[4]; m[5] = a[5];
+            DPSconcat(ctxt, m);
+            a += 6;
+            break;
+          case GSDLInitMatrix:
+            DPSinitmatrix(ctxt);
+            break;
+          case GSDLRotate:
+            DPSrotate(ctxt, a[0]);
+            a += 1;
+            break;
+          case GSDLScale:
+            DPSscale(ctxt, a[0], a[1]);
+            a += 2;
+            break;
+          case GSDLTranslate:
+            DPStranslate(ctxt, a[0], a[1]);
+            a += 2;
+            break;
+          case GSDLSetCTM:
+            GSSetCTM(ctxt, NEXT_OBJECT());
+            break;
+          case GSDLConcatCTM:
+            GSConcatCTM(ctxt, NEXT_OBJECT());
+            break;
+
+          case GSDLArc:
+            DPSarc(ctxt, a[0], a[1], a[2], a[3], a[4]);
+            a += 5;
+            break;
+          case GSDLArcn:
+            DPSarcn(ctxt, a[0], a[1], a[2], a[3], a[4]);
+            a += 5;
+            break;
+          case GSDLArct:
+            DPSarct(ctxt, a[0], a[1], a[2], a[3], a[4]);
+            a += 5;
+            break;
+          case GSDLClip:
+            DPSclip(ctxt);
+            break;
+          case GSDLClosePath:
+            DPSclosepath(ctxt);
+            break;
+          case GSDLCurveTo:
+            DPScurveto(ctxt, a[0], a[1], a[2], a[3], a[4], a[5]);
+            a += 6;
+            break;
+          case GSDLEOClip:
+            DPSeoclip(ctxt);
+            break;
+          case GSDLEOFill:
+            DPSeofill(ctxt);
+            break;
+          case GSDLFill:
+            DPSfill(ctxt);
+            break;
+          case GSDLFlattenPath:
+            DPSflattenpath(ctxt);
+            break;
+          case GSDLInitClip:
+            DPSinitclip(ctxt);
+            break;
+          case GSDLLineTo:
+            DPSlineto(ctxt, a[0], a[1]);
+            a += 2;
+            break;
+          case GSDLMoveTo:
+            DPSmoveto(ctxt, a[0], a[1]);
+            a += 2;
+            break;
+          case GSDLNewPath:
+            DPSnewpath(ctxt);
+            break;
+          case GSDLRCurveTo:
+            DPSrcurveto(ctxt, a[0], a[1], a[2], a[3], a[4], a[5]);
+            a += 6;
+            break;
+          case GSDLRectClip:
+            DPSrectclip(ctxt, a[0], a[1], a[2], a[3]);
+            a += 4;
+            break;
+          case GSDLRectFill:
+            DPSrectfill(ctxt, a[0], a[1], a[2], a[3]);
+            a += 4;
+            break;
+          case GSDLRectStroke:
+            DPSrectstroke(ctxt, a[0], a[1], a[2], a[3]);
+            a += 4;
+            break;
+          case GSDLReversePath:
+            DPSreversepath(ctxt);
+            break;
+          case GSDLRLineTo:
+            DPSrlineto(ctxt, a[0], a[1]);
+            a += 2;
+            break;
+          case GSDLRMoveTo:
+            DPSrmoveto(ctxt, a[0], a[1]);
+            a += 2;
+            break;
+          case GSDLStroke:
+            DPSstroke(ctxt);
+            break;
+          case GSDLShFill:
+            DPSshfill(ctxt, NEXT_OBJECT());
+            break;
+          case GSDLSendBezierPath:
+            GSSendBezierPath(ctxt, NEXT_OBJECT());
+            break;
+          case GSDLRectClipList:
+            obj = NEXT_OBJECT();
+            GSRectClipList(ctxt, [obj bytes], [obj length] / sizeof(NSRect));
+            break;
+          case GSDLRectFillList:
+            obj = NEXT_OBJECT();
+            GSRectFillList(ctxt, [obj bytes], [obj length] / sizeof(NSRect));
+            break;
+
+          case GSDLComposite:
+            DPScomposite(ctxt, a[0], a[1], a[2], a[3], (NSInteger)a[4],
+                         a[5], a[6], (NSCompositingOperation)a[7]);
+            a += 8;
+            break;
+          case GSDLCompositeRect:
+            DPScompositerect(ctxt, a[0], a[1], a[2], a[3],
+                             (NSCompositingOperation)a[4]);
+            a += 5;
+            break;
+          case GSDLDissolve:
+            DPSdissolve(ctxt, a[0], a[1], a[2], a[3], (NSInteger)a[4],
+                        a[5], a[6], a[7]);
+            a += 8;
+            break;
+          case GSDLDrawImage:
+            GSDrawImage(ctxt, NSMakeRect(a[0], a[1], a[2], a[3]),
+                        NEXT_OBJECT());
+            a += 4;
+            break;
+          case GSDLDrawLinearGradient:
+            [ctxt drawGradient: NEXT_OBJECT()
+                     fromPoint: NSMakePoint(a[0], a[1])
+                       toPoint: NSMakePoint(a[2], a[3])
+                       options: (NSUInteger)a[4]];
+            a += 5;
+            break;
+          case GSDLDrawRadialGradient:
+            [ctxt drawGradient: NEXT_OBJECT()
+                    fromCenter: NSMakePoint(a[0], a[1])
+                        radius: a[2]
+                      toCenter: NSMakePoint(a[3], a[4])
+                        radius: a[5]
+                       options: (NSUInteger)a[6]];
+            a += 7;
+            break;
+        }
+    }
+#undef NEXT_OBJECT
+}
+
+@end
+
+/*
+ * The part of the graphics state a recording context keeps to answer
+ * queries.  The current point is kept in device space, as the matrix
+ * may change while it is set.
+ */
+typedef struct {
+  NSAffineTransformStruct ctm;
+  NSPoint point;
+  NSPoint start;
+  CGFloat lineWidth;
+  CGFloat miterLimit;
+  CGFloat flat;
+  int lineCap;
+  int lineJoin;
+  int strokeAdjust;
+  CGFloat red, green, blue, alpha;
+  NSUInteger fillComponents;
+  NSUInteger strokeComponents;
+  NSPoint textPosition;
+} GSRecordedGState;
+
+static const NSAffineTransformStruct identity = { 1, 0, 0, 1, 0, 0 };
+
+/* Returns a followed by b, as PostScript concatenates a onto b.  */
+static NSAffineTransformStruct
+multiply(NSAffineTransformStruct a, NSAffineTransformStruct b)
+{
+  NSAffineTransformStruct r;
+
+  r.m11 = a.m11 * b.m11 + a.m12 * b.m21;
+  r.m12 = a.m11 * b.m12 + a.m12 * b.m22;
+  r.m21 = a.m21 * b.m11 + a.m22 * b.m21;
+  r.m22 = a.m21 * b.m12 + a.m22 * b.m22;
+  r.tX = a.tX * b.m11 + a.tY * b.m21 + b.tX;
+  r.tY = a.tX * b.m12 + a.tY * b.m22 + b.tY;
+  return r;
+}
+
+static inline NSPoint
+to_device(NSAffineTransformStruct m, CGFloat x, CGFloat y)
+{
+  return NSMakePoint(m.m11 * x + m.m21 * y + m.tX,
+                     m.m12 * x + m.m22 * y + m.tY);
+}
+
+static NSPoint
+to_user(NSAffineTransformStruct m, NSPoint p)
+{
+  CGFloat det = m.m11 * m.m22 - m.m12 * m.m21;
+  CGFloat x = p.x - m.tX;
+  CGFloat y = p.y - m.tY;
+
+  if (det == 0)
+    return NSZeroPoint;
+  return NSMakePoint((m.m22 * x - m.m21 * y) / det,
+                     (m.m11 * y - m.m12 * x) / det);
+}
+
+@implementation GSRecordingContext
+
+#define GSTATE ((GSRecordedGState *)gstates + gstateCount - 1)
+
+#define RECORD(op, ...) do { \
+  double values[] = { __VA_ARGS__ }; \
+  record(displayList, op, sizeof(values) / sizeof(double), values); \
+} while (0)
+
+#define RECORD_OP(op) record(displayList, op, 0, NULL)
+
+#define RECORD_OBJECT(op, obj) record_object(displayList, op, 0, NULL, obj)
+
+static void
+init_gstate(GSRecordedGState *g)
+{
+  memset(g, 0, sizeof(GSRecordedGState));
+  g->ctm = identity;
+  g->lineWidth = 1;
+  g->miterLimit = 10;
+  g->flat = 1;
+  g->alpha = 1;
+  g->fillComponents = 2;
+  g->strokeComponents = 2;
+}
+
+- (id) initWithContextInfo: (NSDictionary *)info
+{
+  return [self initWithDisplayList: nil];
+}
+
+/** <init />
+ * Initialises the receiver to record into list, or into a new display
+ * list if list is nil.
+ */
+- (id) initWithDisplayList: (GSDisplayList *)list
+{
+  self = [super initWithContextInfo: nil];
+  if (self != nil)
+    {
+      if (list == nil)
+        displayList = [GSDisplayList new];
+      else
+        ASSIGN(displayList, list);
+      gstateCapacity = 4;
+      gstates = NSZoneMalloc(NSDefaultMallocZone(),
+                             gstateCapacity * sizeof(GSRecordedGState));
+      gstateCount = 1;
+      init_gstate(GSTATE);
+    }
+  return self;
+}
+
+- (void) dealloc
+{
+  RELEASE(displayList);
+  NSZoneFree(NSDefaultMallocZone(), gstates);
+  [super dealloc];
+}
+
+/**
+ * Returns the display list the receiver records into.
+ */
+- (GSDisplayList *) displayList
+{
+  return displayList;
+}
+
+- (void) flushGraphics
+{
+}
+
+- (void) setCompositingOperation: (NSCompositingOperation)operation
+{
+  [super setCompositingOperation: operation];
+  RECORD(GSDLSetCompositingOperation, operation);
+}
+
+- (void) setShouldAntialias: (BOOL)antialias
+{
+  [super setShouldAntialias: antialias];
+  RECORD(GSDLSetShouldAntialias, antialias);
+}
+
+- (void) setImageInterpolation: (NSImageInterpolation)interpolation
+{
+  [super setImageInterpolation: interpolation];
+  RECORD(GSDLSetImageInterpolation, interpolation);
+}
+
+- (void) setPatternPhase: (NSPoint)phase
+{
+  [super setPatternPhase: phase];
+  RECORD(GSDLSetPatternPhase, phase.x, phase.y);
+}
+
+/* ----------------------------------------------------------------------- */
+/* Color operations */
+/* ----------------------------------------------------------------------- */
+- (void) DPScurrentalpha: (CGFloat*)a
+{
+  *a = GSTATE->alpha;
+}
+
+- (void) DPScurrentgray: (CGFloat*)gray
+{
+  GSRecordedGState *g = GSTATE;
+
+  *gray = 0.3 * g->red + 0.59 * g->green + 0.11 * g->blue;
+}
+
+- (void) DPScurrentrgbcolor: (CGFloat*)r : (CGFloat*)g : (CGFloat*)b
+{
+  *r = GSTATE->red;
+  *g = GSTATE->green;
+  *b = GSTATE->blue;
+}
+
+- (void) DPSsetalpha: (CGFloat)a
+{
+  GSTATE->alpha = a;
+  RECORD(GSDLSetAlpha, a);
+}
+
+- (void) DPSsetcmykcolor: (CGFloat)c : (CGFloat)m : (CGFloat)y : (CGFloat)k
+{
+  GSRecordedGState *g = GSTATE;
+
+  g->red = 1 - MIN(1, c + k);
+  g->green = 1 - MIN(1, m + k);
+  g->blue = 1 - MIN(1, y + k);
+  RECORD(GSDLSetCMYKColor, c, m, y, k);
+}
+
+- (void) DPSsetgray: (CGFloat)gray
+{
+  GSRecordedGState *g = GSTATE;
+
+  g->red = g->green = g->blue = gray;
+  RECORD(GSDLSetGray, gray);
+}
+
+- (void) DPSsethsbcolor: (CGFloat)h : (CGFloat)s : (CGFloat)b
+{
+  RECORD(GSDLSetHSBColor, h, s, b);
+}
+
+- (void) DPSsetrgbcolor: (CGFloat)r : (CGFloat)g : (CGFloat)b
+{
+  GSRecordedGState *gs = GSTATE;
+
+  gs->red = r;
+  gs->green = g;
+  gs->blue = b;
+  RECORD(GSDLSetRGBColor, r, g, b);
+}
+
+- (void) GSSetPatterColor: (NSImage*)image
+{
+  RECORD_OBJECT(GSDLSetPatternColor, image);
+}
+
+/* Returns how many values a color in space has: one for each of its
+   colors and one for alpha.  */
+static NSUInteger
+color_components(id space)
+{
+  if ([space respondsToSelector: @selector(numberOfColorComponents)])
+    return [(NSColorSpace *)space numberOfColorComponents] + 1;
+  return 5;
+}
+
+- (void) GSSetFillColorspace: (void *)spaceref
+{
+  GSTATE->fillComponents = color_components(spaceref);
+  RECORD_OBJECT(GSDLSetFillColorspace, (id)spaceref);
+}
+
+- (void) GSSetStrokeColorspace: (void *)spaceref
+{
+  GSTATE->strokeComponents = color_components(spaceref);
+  RECORD_OBJECT(GSDLSetStrokeColorspace, (id)spaceref);
+}
+
+- (void) GSSetFillColor: (const CGFloat *)values
+{
+  RECORD_OBJECT(GSDLSetFillColor, [NSData dataWithBytes: values
+    length: GSTATE->fillComponents * sizeof(CGFloat)]);
+}
+
+- (void) GSSetStrokeColor: (const CGFloat *)values
+{
+  RECORD_OBJECT(GSDLSetStrokeColor, [NSData dataWithBytes: values
+    length: GSTATE->strokeComponents * sizeof(CGFloat)]);
+}
+
+/* ----------------------------------------------------------------------- */
+/* Text operations */
+/* ----------------------------------------------------------------------- */
+- (void) DPSashow: (CGFloat)x : (CGFloat)y : (const char*)s
+{
+  double values[] = { x, y };
+
+  record_object(displayList, GSDLAShow, 2, values,
+                [NSData dataWithBytes: s length: strlen(s) + 1]);
+}
+
+- (void) DPSshow: (const char*)s
+{
+  RECORD_OBJECT(GSDLShow, [NSData dataWithBytes: s length: strlen(s) + 1]);
+}
+
+- (void) GSSetCharacterSpacing: (CGFloat)extra
+{
+  RECORD(GSDLSetCharacterSpacing, extra);
+}
+
+- (void) GSSetFont: (void *)fontref
+{
+  RECORD_OBJECT(GSDLSetFont, (id)fontref);
+}
+
+- (void) GSSetFontSize: (CGFloat)size
+{
+  RECORD(GSDLSetFontSize, size);
+}
+
+- (NSAffineTransform *) GSGetTextCTM
+{
+  return [self GSCurrentCTM];
+}
+
+- (NSPoint) GSGetTextPosition
+{
+  return GSTATE->textPosition;
+}
+
+- (void) GSSetTextCTM: (NSAffineTransform *)ctm
+{
+  RECORD_OBJECT(GSDLSetTextCTM, AUTORELEASE([ctm copy]));
+}
+
+- (void) GSSetTextDrawingMode: (GSTextDrawingMode)mode
+{
+  RECORD(GSDLSetTextDrawingMode, mode);
+}
+
+- (void) GSSetTextPosition: (NSPoint)loc
+{
+  GSTATE->textPosition = loc;
+  RECORD(GSDLSetTextPosition, loc.x, loc.y);
+}
+
+- (void) GSShowText: (const char *)string : (size_t)length
+{
+  RECORD_OBJECT(GSDLShowText, [NSData dataWithBytes: string length: length]);
+}
+
+- (void) GSShowGlyphs: (const NSGlyph *)glyphs : (size_t)length
+{
+  RECORD_OBJECT(GSDLShowGlyphs,
+    [NSData dataWithBytes: glyphs length: length * sizeof(NSGlyph)]);
+}
+
+- (void) GSShowGlyphsWithAdvances: (const NSGlyph *)glyphs
+                                 : (const NSSize *)advances
+                                 : (size_t)length
+{
+  NSMutableData *data;
+
+  data = [NSMutableData dataWithBytes: glyphs
+                               length: length * sizeof(NSGlyph)];
+  [data appendBytes: advances length: length * sizeof(NSSize)];
+  RECORD_OBJECT(GSDLShowGlyphsWithAdvances, data);
+}
+
+/* ----------------------------------------------------------------------- */
+/* Gstate Handling */
+/* ----------------------------------------------------------------------- */
+- (void) DPSgrestore
+{
+  if (gstateCount > 1)
+    gstateCount--;
+  RECORD_OP(GSDLGRestore);
+}
+
+- (void) DPSgsave
+{
+  if (gstateCount == gstateCapacity)
+    {
+      gstateCapacity *= 2;
+      gstates = NSZoneRealloc(NSDefaultMallocZone(), gstates,
+                              gstateCapacity * sizeof(GSRecordedGState));
+    }
+  gstateCount++;
+  *GSTATE = *(GSTATE - 1);
+  RECORD_OP(GSDLGSave);
+}
+
+- (void) DPSinitgraphics
+{
+  init_gstate(GSTATE);
+  RECORD_OP(GSDLInitGraphics);
+}
+
+/* ----------------------------------------------------------------------- */
+/* Gstate operations */
+/* ----------------------------------------------------------------------- */
+- (void) DPScurrentflat: (CGFloat*)flatness
+{
+  *flatness = GSTATE->flat;
+}
+
+- (void) DPScurrentlinecap: (int*)linecap
+{
+  *linecap = GSTATE->lineCap;
+}
+
+- (void) DPScurrentlinejoin: (int*)linejoin
+{
+  *linejoin = GSTATE->lineJoin;
+}
+
+- (void) DPScurrentlinewidth: (CGFloat*)width
+{
+  *width = GSTATE->lineWidth;
+}
+
+- (void) DPScurrentmiterlimit: (CGFloat*)limit
+{
+  *limit = GSTATE->miterLimit;
+}
+
+- (void) DPScurrentpoint: (CGFloat*)x : (CGFloat*)y
+{
+  NSPoint p = to_user(GSTATE->ctm, GSTATE->point);
+
+  *x = p.x;
+  *y = p.y;
+}
+
+- (void) DPScurrentstrokeadjust: (int*)b
+{
+  *b = GSTATE->strokeAdjust;
+}
+
+- (void) DPSsetdash: (const CGFloat*)pat : (NSInteger)size : (CGFloat)offset
+{
+  double values[] = { offset };
+
+  record_object(displayList, GSDLSetDash, 1, values,
+                [NSData dataWithBytes: pat length: size * sizeof(CGFloat)]);
+}
+
+- (void) DPSsetflat: (CGFloat)flatness
+{
+  GSTATE->flat = flatness;
+  RECORD(GSDLSetFlat, flatness);
+}
+
+- (void) DPSsethalftonephase: (CGFloat)x : (CGFloat)y
+{
+}
+
+- (void) DPSsetlinecap: (int)linecap
+{
+  GSTATE->lineCap = linecap;
+  RECORD(GSDLSetLineCap, linecap);
+}
+
+- (void) DPSsetlinejoin: (int)linejoin
+{
+  GSTATE->lineJoin = linejoin;
+  RECORD(GSDLSetLineJoin, linejoin);
+}
+
+- (void) DPSsetlinewidth: (CGFloat)width
+{
+  GSTATE->lineWidth = width;
+  RECORD(GSDLSetLineWidth, width);
+}
+
+- (void) DPSsetmiterlimit: (CGFloat)limit
+{
+  GSTATE->miterLimit = limit;
+  RECORD(GSDLSetMiterLimit, limit);
+}
+
+- (void) DPSsetstrokeadjust: (int)b
+{
+  GSTATE->strokeAdjust = b;
+  RECORD(GSDLSetStrokeAdjust, b);
+}
+
+/* ----------------------------------------------------------------------- */
+/* Matrix operations */
+/* ----------------------------------------------------------------------- */
+- (void) DPSconcat: (const CGFloat*)m
+{
+  NSAffineTransformStruct c = { m[0], m[1], m[2], m[3], m[4], m[5] };
+
+  GSTATE->ctm = multiply(c, GSTATE->ctm);
+  RECORD(GSDLConcat, m[0], m[1], m[2], m[3], m[4], m[5]);
+}
+
+- (void) DPSinitmatrix
+{
+  GSTATE->ctm = identity;
+  RECORD_OP(GSDLInitMatrix);
+}
+
+- (void) DPSrotate: (CGFloat)angle
+{
+  CGFloat r = angle * M_PI / 180;
+  NSAffineTransformStruct c = { cos(r), sin(r), -sin(r), cos(r), 0, 0 };
+
+  GSTATE->ctm = multiply(c, GSTATE->ctm);
+  RECORD(GSDLRotate, angle);
+}
+
+- (void) DPSscale: (CGFloat)x : (CGFloat)y
+{
+  NSAffineTransformStruct c = { x, 0, 0, y, 0, 0 };
+
+  GSTATE->ctm = multiply(c, GSTATE->ctm);
+  RECORD(GSDLScale, x, y);
+}
+
+- (void) DPStranslate: (CGFloat)x : (CGFloat)y
+{
+  NSAffineTransformStruct c = { 1, 0, 0, 1, x, y };
+
+  GSTATE->ctm = multiply(c, GSTATE->ctm);
+  RECORD(GSDLTranslate, x, y);
+}
+
+- (NSAffineTransform *) GSCurrentCTM
+{
+  NSAffineTransform *ctm = [NSAffineTransform transform];
+
+  [ctm setTransformStruct: GSTATE->ctm];
+  return ctm;
+}
+
+- (void) GSSetCTM: (NSAffineTransform *)ctm
+{
+  GSTATE->ctm = [ctm transformStruct];
+  RECORD_OBJECT(GSDLSetCTM, AUTORELEASE([ctm copy]));
+}
+
+- (void) GSConcatCTM: (NSAffineTransform *)ctm
+{
+  GSTATE->ctm = multiply([ctm transformStruct], GSTATE->ctm);
+  RECORD_OBJECT(GSDLConcatCTM, AUTORELEASE([ctm copy]));
+}
+
+/* ----------------------------------------------------------------------- */
+/* Paint operations */
+/* ----------------------------------------------------------------------- */
+/* Sets the current point to x, y in user space.  */
+static inline void
+move_point(GSRecordedGState *g, CGFloat x, CGFloat y)
+{
+  g->point = to_device(g->ctm, x, y);
+}
+
+- (void) DPSarc: (CGFloat)x : (CGFloat)y : (CGFloat)r : (CGFloat)angle1
+               : (CGFloat)angle2
+{
+  CGFloat a = angle2 * M_PI / 180;
+
+  move_point(GSTATE, x + r * cos(a), y + r * sin(a));
+  RECORD(GSDLArc, x, y, r, angle1, angle2);
+}
+
+- (void) DPSarcn: (CGFloat)x : (CGFloat)y : (CGFloat)r : (CGFloat)angle1
+                : (CGFloat)angle2
+{
+  CGFloat a = angle2 * M_PI / 180;
+
+  move_point(GSTATE, x + r * cos(a), y + r * sin(a));
+  RECORD(GSDLArcn, x, y, r, angle1, angle2);
+}
+
+- (void) DPSarct: (CGFloat)x1 : (CGFloat)y1 : (CGFloat)x2 : (CGFloat)y2
+                : (CGFloat)r
+{
+  /* Approximately, the arc ends near the corner.  */
+  move_point(GSTATE, x1, y1);
+  RECORD(GSDLArct, x1, y1, x2, y2, r);
+}
+
+- (void) DPSclip
+{
+  RECORD_OP(GSDLClip);
+}
+
+- (void) DPSclosepath
+{
+  GSTATE->point = GSTATE->start;
+  RECORD_OP(GSDLClosePath);
+}
+
+- (void) DPScurveto: (CGFloat)x1 : (CGFloat)y1 : (CGFloat)x2 : (CGFloat)y2
+                   : (CGFloat)x3 : (CGFloat)y3
+{
+  move_point(GSTATE, x3, y3);
+  RECORD(GSDLCurveTo, x1, y1, x2, y2, x3, y3);
+}
+
+- (void) DPSeoclip
+{
+  RECORD_OP(GSDLEOClip);
+}
+
+- (void) DPSeofill
+{
+  RECORD_OP(GSDLEOFill);
+}
+
+- (void) DPSfill
+{
+  RECORD_OP(GSDLFill);
+}
+
+- (void) DPSflattenpath
+{
+  RECORD_OP(GSDLFlattenPath);
+}
+
+- (void) DPSinitclip
+{
+  RECORD_OP(GSDLInitClip);
+}
+
+- (void) DPSlineto: (CGFloat)x : (CGFloat)y
+{
+  move_point(GSTATE, x, y);
+  RECORD(GSDLLineTo, x, y);
+}
+
+- (void) DPSmoveto: (CGFloat)x : (CGFloat)y
+{
+  move_point(GSTATE, x, y);
+  GSTATE->start = GSTATE->point;
+  RECORD(GSDLMoveTo, x, y);
+}
+
+- (void) DPSnewpath
+{
+  GSTATE->point = GSTATE->start = NSZeroPoint;
+  RECORD_OP(GSDLNewPath);
+}
+
+- (void) DPSpathbbox: (CGFloat*)llx : (CGFloat*)lly : (CGFloat*)urx
+                    : (CGFloat*)ury
+{
+  *llx = *lly = *urx = *ury = 0;
+}
+
+- (void) DPSrcurveto: (CGFloat)x1 : (CGFloat)y1 : (CGFloat)x2 : (CGFloat)y2
+                    : (CGFloat)x3 : (CGFloat)y3
+{
+  NSPoint p = to_user(GSTATE->ctm, GSTATE->point);
+
+  move_point(GSTATE, p.x + x3, p.y + y3);
+  RECORD(GSDLRCurveTo, x1, y1, x2, y2, x3, y3);
+}
+
+- (void) DPSrectclip: (CGFloat)x : (CGFloat)y : (CGFloat)w : (CGFloat)h
+{
+  RECORD(GSDLRectClip, x, y, w, h);
+}
+
+- (void) DPSrectfill: (CGFloat)x : (CGFloat)y : (CGFloat)w : (CGFloat)h
+{
+  RECORD(GSDLRectFill, x, y, w, h);
+}
+
+- (void) DPSrectstroke: (CGFloat)x : (CGFloat)y : (CGFloat)w : (CGFloat)h
+{
+  RECORD(GSDLRectStroke, x, y, w, h);
+}
+
+- (void) DPSreversepath
+{
+  RECORD_OP(GSDLReversePath);
+}
+
+- (void) DPSrlineto: (CGFloat)x : (CGFloat)y
+{
+  NSPoint p = to_user(GSTATE->ctm, GSTATE->point);
+
+  move_point(GSTATE, p.x + x, p.y + y);
+  RECORD(GSDLRLineTo, x, y);
+}
+
+- (void) DPSrmoveto: (CGFloat)x : (CGFloat)y
+{
+  NSPoint p = to_user(GSTATE->ctm, GSTATE->point);
+
+  move_point(GSTATE, p.x + x, p.y + y);
+  GSTATE->start = GSTATE->point;
+  RECORD(GSDLRMoveTo, x, y);
+}
+
+- (void) DPSstroke
+{
+  RECORD_OP(GSDLStroke);
+}
+
+- (void) DPSshfill: (NSDictionary *)shaderDictionary
+{
+  RECORD_OBJECT(GSDLShFill, shaderDictionary);
+}
+
+- (void) GSSendBezierPath: (NSBezierPath *)path
+{
+  if ([path isEmpty] == NO)
+    {
+      NSPoint p = [path currentPoint];
+
+      move_point(GSTATE, p.x, p.y);
+    }
+  RECORD_OBJECT(GSDLSendBezierPath, AUTORELEASE([path copy]));
+}
+
+- (void) GSRectClipList: (const NSRect *)rects : (int)count
+{
+  RECORD_OBJECT(GSDLRectClipList,
+    [NSData dataWithBytes: rects length: count * sizeof(NSRect)]);
+}
+
+- (void) GSRectFillList: (const NSRect *)rects : (int)count
+{
+  RECORD_OBJECT(GSDLRectFillList,
+    [NSData dataWithBytes: rects length: count * sizeof(NSRect)]);
+}
+
+/* ----------------------------------------------------------------------- */
+/* Graphics Extensions Ops */
+/* ----------------------------------------------------------------------- */
+/*
+ * The gstate numbers of compositing operators are recorded as they are,
+ * so lists using them can only be replayed while those gstates exist.
+ */
+- (void) DPScomposite: (CGFloat)x : (CGFloat)y : (CGFloat)w : (CGFloat)h
+                     : (NSInteger)gstateNum : (CGFloat)dx : (CGFloat)dy
+                     : (NSCompositingOperation)op
+{
+  RECORD(GSDLComposite, x, y, w, h, gstateNum, dx, dy, op);
+}
+
+- (void) DPScompositerect: (CGFloat)x : (CGFloat)y : (CGFloat)w : (CGFloat)h
+                         : (NSCompositingOperation)op
+{
+  RECORD(GSDLCompositeRect, x, y, w, h, op);
+}
+
+- (void) DPSdissolve: (CGFloat)x : (CGFloat)y : (CGFloat)w : (CGFloat)h
+                    : (NSInteger)gstateNum : (CGFloat)dx : (CGFloat)dy
+                    : (CGFloat)delta
+{
+  RECORD(GSDLDissolve, x, y, w, h, gstateNum, dx, dy, delta);
+}
+
+- (void) GSDrawImage: (NSRect)rect : (void *)imageref
+{
+  NSBitmapImageRep *rep = imageref;
+  NSBitmapImageRep *copy;
+  unsigned char *src[5];
+  unsigned char *dst[5];
+  NSInteger planes, i;
+  double values[] = { NSMinX(rect), NSMinY(rect),
+                      NSWidth(rect), NSHeight(rect) };
+
+  if (rep == nil)
+    {
+      record_object(displayList, GSDLDrawImage, 4, values, nil);
+      return;
+    }
+
+  /* The data of the rep may belong to the caller, as when drawn by
+     NSDrawBitmap(), so keep a copy.  */
+  copy = [[NSBitmapImageRep alloc]
+           initWithBitmapDataPlanes: NULL
+                         pixelsWide: [rep pixelsWide]
+                         pixelsHigh: [rep pixelsHigh]
+                      bitsPerSample: [rep bitsPerSample]
+                    samplesPerPixel: [rep samplesPerPixel]
+                           hasAlpha: [rep hasAlpha]
+                           isPlanar: [rep isPlanar]
+                     colorSpaceName: [rep colorSpaceName]
+                       bitmapFormat: [rep bitmapFormat]
+                        bytesPerRow: [rep bytesPerRow]
+                       bitsPerPixel: [rep bitsPerPixel]];
+  [rep getBitmapDataPlanes: src];
+  [copy getBitmapDataPlanes: dst];
+  planes = [rep isPlanar] ? [rep numberOfPlanes] : 1;
+  for (i = 0; i < planes; i++)
+    {
+      memcpy(dst[i], src[i], [rep bytesPerPlane]);
+    }
+  record_object(displayList, GSDLDrawImage, 4, values, copy);
+  RELEASE(copy);
+}
+
+- (void) drawGradient: (NSGradient*)gradient
+           fromCenter: (NSPoint)startCenter
+               radius: (CGFloat)startRadius
+             toCenter: (NSPoint)endCenter 
+               radius: (CGFloat)endRadius
+              options: (NSUInteger)options
+{
+  double values[] = { startCenter.x, startCenter.y, startRadius,
+                      endCenter.x, endCenter.y, endRadius, options };
+
+  record_object(displayList, GSDLDrawRadialGradient, 7, values, gradient);
+}
+
+- (void) drawGradient: (NSGradient*)gradient
+            fromPoint: (NSPoint)startPoint
+              toPoint: (NSPoint)endPoint
+              options: (NSUInteger)options
+{
+  double values[] = { startPoint.x, startPoint.y,
+                      endPoint.x, endPoint.y, options };
+
+  record_object(displayList, GSDLDrawLinearGradient, 5, values, gradient);
+}
+
+@end
@@ -26,6 +26,8 @@
    Boston, MA 02110-1301, USA.
 */
 
+#include <string.h>
+
 #import <Foundation/NSArray.h>
 #import <Foundation/NSDictionary.h>
 #import <Foundation/NSEnumerator.h>
@@ -34,6 +36,7 @@
 #import <Foundation/NSRunLoop.h>
 #import <Foundation/NSSet.h>
 #import <Foundation/NSThread.h>
+#import <Foundation/NSUserDefaults.h>
 #import <Foundation/NSGeometry.h>
 
 #import "AppKit/NSApplication.h"
@@ -241,6 +244,7 @@ GSCurrentServer(void)
 */
 - (void) closeServer
 {
+  [self emptyWindowPool];
   if (self == GSCurrentServer())
     [GSDisplayServer setCurrentServer: nil];
 }
@@ -269,6 +273,15 @@ GSCurrentServer(void)
       NSEndMapTableEnumeration(&enumerator);
     }
 
+  if (_transaction != NULL)
+    {
+      [self discardQueuedOperationsForWindow: 0];
+      NSZoneFree(NSDefaultMallocZone(), _transaction);
+    }
+  if (_windowPool != NULL)
+    {
+      NSZoneFree(NSDefaultMallocZone(), _windowPool);
+    }
   DESTROY(server_info);
   DESTROY(event_queue);
   NSFreeMapTable(drag_types);
@@ -432,6 +445,13 @@ GSCurrentServer(void)
   return NSMakeSize(72, 72);
 }
 
+/** Returns the refresh rate, in frames per second, of the indicated
+    screen of the display, or 0 if it is not known. */
+- (double) refreshRateForScreen: (NSInteger)screen
+{
+  return 0;
+}
+
 /** Returns the bounds, in pixels, for the indicated screen of the
     display. */
 - (NSRect) boundsForScreen: (NSInteger)screen
@@ -783,6 +803,23 @@ GSCurrentServer(void)
   [self subclassResponsibility: _cmd];
 }
 
+/** Causes the buffered graphics in the count rects to be flushed to the
+ * screen in one go.  The rects are expressed in OpenStep window
+ * coordinates and do not overlap much.  The default implementation calls
+ * -flushwindowrect:: for each rect; backends that can copy several areas
+ * of a buffer at once should override it.
+ */
+- (void) flushwindowrects: (const NSRect*)rects : (NSUInteger)count
+                         : (NSInteger)win
+{
+  NSUInteger i;
+
+  for (i = 0; i < count; i++)
+    {
+      [self flushwindowrect: rects[i] : win];
+    }
+}
+
 /**
  * Returns the dimensions of window decorations added outside the drawable
  * window frame by a window manager or equivalent. For instance, t
@@ -946,9 +983,496 @@ GSCurrentServer(void)
 
 @end
 
+/* ----------------------------------------------------------------------- */
+/* GNUstep Window transactions */
+/* ----------------------------------------------------------------------- */
+typedef enum {
+  GSQueuedTitle,
+  GSQueuedOrder,
+  GSQueuedPlace,
+  GSQueuedFocus
+} GSQueuedOperationType;
+
+typedef struct {
+  GSQueuedOperationType type;
+  NSInteger win;
+  NSInteger op;
+  NSInteger otherWin;
+  NSRect frame;
+  NSString *title;
+} GSQueuedOperation;
+
+typedef struct {
+  NSUInteger depth;
+  NSUInteger count;
+  NSUInteger capacity;
+  GSQueuedOperation *ops;
+} GSWindowTransaction;
+
+#define TRANSACTION ((GSWindowTransaction*)_transaction)
+
+@implementation GSDisplayServer (WindowTransactions)
+
+/* Returns a new operation at the end of the queue.  */
+- (GSQueuedOperation *) _queueOperation: (GSQueuedOperationType)type
+				       : (NSInteger)win
+{
+  GSWindowTransaction *t = TRANSACTION;
+  GSQueuedOperation *o;
+
+  if (t->count == t->capacity)
+    {
+      t->capacity = 2 * t->capacity + 8;
+      t->ops = NSZoneRealloc(NSDefaultMallocZone(), t->ops,
+	t->capacity * sizeof(GSQueuedOperation));
+    }
+  o = &t->ops[t->count++];
+  memset(o, 0, sizeof(GSQueuedOperation));
+  o->type = type;
+  o->win = win;
+  return o;
+}
+
+- (void) _removeQueuedOperationAtIndex: (NSUInteger)i
+{
+  GSWindowTransaction *t = TRANSACTION;
+
+  DESTROY(t->ops[i].title);
+  t->count--;
+  memmove(&t->ops[i], &t->ops[i + 1],
+    (t->count - i) * sizeof(GSQueuedOperation));
+}
+
+/** <p>Opens a window transaction.  Until the matching
+ * -commitWindowTransaction the -queuetitlewindow::, -queueorderwindow:::,
+ * -queueplacewindow:: and -queuesetinputfocus: methods only record their
+ * operations, and an operation which a later one makes redundant is
+ * dropped, so a burst of window changes, such as the steps of an
+ * animation, reaches the display as a single batch.
+ * </p>
+ * <p>Transactions nest, the operations are sent when the outermost one
+ * is committed.  Other window operations are not queued, so anything
+ * which depends on the queued operations having been sent, such as
+ * asking for the bounds of a window, should come after the commit.
+ * </p>
+ */
+- (void) beginWindowTransaction
+{
+  if (_transaction == NULL)
+    {
+      _transaction = NSZoneCalloc(NSDefaultMallocZone(), 1,
+	sizeof(GSWindowTransaction));
+    }
+  TRANSACTION->depth++;
+}
+
+/** Closes a window transaction opened by -beginWindowTransaction, and
+ * when it is the outermost one sends the queued operations in the order
+ * they were queued.
+ */
+- (void) commitWindowTransaction
+{
+  GSWindowTransaction *t = TRANSACTION;
+  NSUInteger i;
+
+  if (t == NULL || t->depth == 0)
+    {
+      NSLog(@"-commitWindowTransaction without -beginWindowTransaction");
+      return;
+    }
+  if (--t->depth > 0)
+    {
+      return;
+    }
+
+  /* An operation may open a transaction of its own, so the queue is
+     emptied before any of it is sent.  */
+  while (t->count > 0)
+    {
+      GSQueuedOperation *ops = t->ops;
+      NSUInteger count = t->count;
+
+      t->ops = NULL;
+      t->count = 0;
+      t->capacity = 0;
+      for (i = 0; i < count; i++)
+	{
+	  GSQueuedOperation *o = &ops[i];
+
+	  switch (o->type)
+	    {
+	      case GSQueuedTitle:
+		[self titlewindow: o->title : o->win];
+		RELEASE(o->title);
+		break;
+	      case GSQueuedOrder:
+		[self orderwindow: o->op : o->otherWin : o->win];
+		break;
+	      case GSQueuedPlace:
+		[self placewindow: o->frame : o->win];
+		break;
+	      case GSQueuedFocus:
+		[self setinputfocus: o->win];
+		break;
+	    }
+	}
+      NSZoneFree(NSDefaultMallocZone(), ops);
+    }
+}
+
+/** Returns YES between -beginWindowTransaction and the matching
+ * -commitWindowTransaction.
+ */
+- (BOOL) isInWindowTransaction
+{
+  return (_transaction != NULL && TRANSACTION->depth > 0);
+}
+
+/** Sets the title of win like -titlewindow::, or inside a window
+ * transaction replaces any title queued for it.
+ */
+- (void) queuetitlewindow: (NSString *)window_title : (NSInteger)win
+{
+  GSWindowTransaction *t = TRANSACTION;
+  NSUInteger i;
+
+  if ([self isInWindowTransaction] == NO)
+    {
+      [self titlewindow: window_title : win];
+      return;
+    }
+  for (i = 0; i < t->count; i++)
+    {
+      if (t->ops[i].type == GSQueuedTitle && t->ops[i].win == win)
+	{
+	  ASSIGNCOPY(t->ops[i].title, window_title);
+	  return;
+	}
+    }
+  [self _queueOperation: GSQueuedTitle : win]->title = [window_title copy];
+}
+
+/** Orders win like -orderwindow:::, or inside a window transaction
+ * queues the ordering.  When the last ordering queued is of win too it
+ * is replaced, as only the final place of the window shows.
+ */
+- (void) queueorderwindow: (NSInteger)op : (NSInteger)otherWin
+			 : (NSInteger)win
+{
+  GSWindowTransaction *t = TRANSACTION;
+  GSQueuedOperation *o;
+  NSUInteger i;
+
+  if ([self isInWindowTransaction] == NO)
+    {
+      [self orderwindow: op : otherWin : win];
+      return;
+    }
+  for (i = t->count; i > 0; i--)
+    {
+      if (t->ops[i - 1].type == GSQueuedOrder)
+	{
+	  if (t->ops[i - 1].win == win)
+	    {
+	      [self _removeQueuedOperationAtIndex: i - 1];
+	    }
+	  break;
+	}
+    }
+  o = [self _queueOperation: GSQueuedOrder : win];
+  o->op = op;
+  o->otherWin = otherWin;
+}
+
+/** Moves and resizes win like -placewindow::, or inside a window
+ * transaction replaces any frame queued for it.
+ */
+- (void) queueplacewindow: (NSRect)frame : (NSInteger)win
+{
+  GSWindowTransaction *t = TRANSACTION;
+  NSUInteger i;
+
+  if ([self isInWindowTransaction] == NO)
+    {
+      [self placewindow: frame : win];
+      return;
+    }
+  for (i = 0; i < t->count; i++)
+    {
+      if (t->ops[i].type == GSQueuedPlace && t->ops[i].win == win)
+	{
+	  t->ops[i].frame = frame;
+	  return;
+	}
+    }
+  [self _queueOperation: GSQueuedPlace : win]->frame = frame;
+}
+
+/** Gives win the input focus like -setinputfocus:, or inside a window
+ * transaction queues it after everything queued so far, in place of
+ * any input focus queued before.
+ */
+- (void) queuesetinputfocus: (NSInteger)win
+{
+  GSWindowTransaction *t = TRANSACTION;
+  NSUInteger i;
+
+  if ([self isInWindowTransaction] == NO)
+    {
+      [self setinputfocus: win];
+      return;
+    }
+  for (i = 0; i < t->count; i++)
+    {
+      if (t->ops[i].type == GSQueuedFocus)
+	{
+	  [self _removeQueuedOperationAtIndex: i];
+	  break;
+	}
+    }
+  [self _queueOperation: GSQueuedFocus : win];
+}
+
+/** Drops the operations queued for win, which must be done before the
+ * window is destroyed.  With a win of 0 all the queued operations are
+ * dropped.
+ */
+- (void) discardQueuedOperationsForWindow: (NSInteger)win
+{
+  GSWindowTransaction *t = TRANSACTION;
+  NSUInteger i;
+
+  if (t == NULL)
+    {
+      return;
+    }
+  for (i = t->count; i > 0; i--)
+    {
+      if (win == 0 || t->ops[i - 1].win == win)
+	{
+	  [self _removeQueuedOperationAtIndex: i - 1];
+	}
+    }
+  if (win == 0)
+    {
+      NSZoneFree(NSDefaultMallocZone(), t->ops);
+      t->ops = NULL;
+      t->capacity = 0;
+    }
+}
+
+@end
+
+/* ----------------------------------------------------------------------- */
+/* GNUstep Window pool */
+/* ----------------------------------------------------------------------- */
+#define MAX_POOLED_WINDOWS 16
+
+typedef struct {
+  NSInteger win;
+  NSBackingStoreType type;
+  NSUInteger style;
+  NSInteger screen;
+} GSPooledWindow;
+
+typedef struct {
+  NSUInteger size;
+  NSUInteger count;
+  GSPooledWindow windows[MAX_POOLED_WINDOWS];
+} GSWindowPool;
+
+#define POOL ((GSWindowPool*)_windowPool)
+
+/* Only borderless windows, which menus, tool tips, pop ups and drag
+   images use and which carry no title or decorations over from their
+   last owner, are pooled.  */
+static inline BOOL
+poolsStyle(NSUInteger style)
+{
+  return (style == NSBorderlessWindowMask);
+}
+
+@implementation GSDisplayServer (WindowPool)
+
+- (GSWindowPool *) _windowPool
+{
+  if (_windowPool == NULL)
+    {
+      NSUserDefaults *defs = [NSUserDefaults standardUserDefaults];
+      NSInteger size = 4;
+
+      if ([defs objectForKey: @"GSWindowPoolSize"] != nil)
+	{
+	  size = [defs integerForKey: @"GSWindowPoolSize"];
+	}
+      _windowPool = NSZoneCalloc(NSDefaultMallocZone(), 1,
+	sizeof(GSWindowPool));
+      POOL->size = MAX(0, MIN(size, MAX_POOLED_WINDOWS));
+    }
+  return POOL;
+}
+
+/** <p>Returns a window like -window::::, but takes it from the pool of
+ * unmapped windows kept by -returnwindow:::: and -fillWindowPool: when
+ * one of the same backing type, style and screen is there.  A pooled
+ * window is placed at frame, and *reused (when reused is not NULL) is
+ * set to YES, so the caller can set any state it does not want to keep
+ * from the last owner.
+ * </p>
+ * <p>The pool saves the round trip to the display of creating a window
+ * for the short lived windows, such as menus and tool tips, and holds
+ * at most the number given by the GSWindowPoolSize default (4 unless
+ * set, 0 turns the pool off).
+ * </p>
+ */
+- (NSInteger) leasewindow: (NSRect)frame : (NSBackingStoreType)type
+			 : (NSUInteger)style : (NSInteger)screen
+			 : (BOOL*)reused
+{
+  GSWindowPool *pool = [self _windowPool];
+  NSUInteger i;
+
+  if (reused != NULL)
+    {
+      *reused = NO;
+    }
+  for (i = pool->count; i > 0; i--)
+    {
+      GSPooledWindow *w = &pool->windows[i - 1];
+
+      if (w->type == type && w->style == style && w->screen == screen)
+	{
+	  NSInteger win = w->win;
+
+	  pool->count--;
+	  memmove(w, w + 1, (pool->count - (i - 1)) * sizeof(GSPooledWindow));
+	  [self placewindow: frame : win];
+	  if (reused != NULL)
+	    {
+	      *reused = YES;
+	    }
+	  return win;
+	}
+    }
+  return [self window: frame : type : style : screen];
+}
+
+/** Gives back a window got from -leasewindow:::::, with the backing
+ * type, style and screen it was created for.  The window is ordered out
+ * and kept in the pool when it is borderless and the pool has room, and
+ * destroyed with -termwindow: otherwise.
+ */
+- (void) returnwindow: (NSInteger)win : (NSBackingStoreType)type
+		     : (NSUInteger)style : (NSInteger)screen
+{
+  GSWindowPool *pool = [self _windowPool];
+  GSPooledWindow *w;
+
+  if (poolsStyle(style) == NO || pool->count >= pool->size)
+    {
+      [self termwindow: win];
+      return;
+    }
+  [self orderwindow: NSWindowOut : 0 : win];
+  w = &pool->windows[pool->count++];
+  w->win = win;
+  w->type = type;
+  w->style = style;
+  w->screen = screen;
+}
+
+/** Creates unmapped borderless buffered windows on screen until the
+ * pool is full, so that even the first menu or tool tip shown finds
+ * one.  This is meant to be done when the application is idle.
+ */
+- (void) fillWindowPool: (NSInteger)screen
+{
+  GSWindowPool *pool = [self _windowPool];
+
+  while (pool->count < pool->size)
+    {
+      GSPooledWindow *w = &pool->windows[pool->count];
+
+      w->win = [self window: NSMakeRect(0, 0, 1, 1)
+			   : NSBackingStoreBuffered
+			   : NSBorderlessWindowMask
+			   : screen];
+      if (w->win == 0)
+	{
+	  break;
+	}
+      w->type = NSBackingStoreBuffered;
+      w->style = NSBorderlessWindowMask;
+      w->screen = screen;
+      pool->count++;
+    }
+}
+
+/** Destroys the windows in the pool.  */
+- (void) emptyWindowPool
+{
+  GSWindowPool *pool = POOL;
+
+  if (pool == NULL)
+    {
+      return;
+    }
+  while (pool->count > 0)
+    {
+      [self termwindow: pool->windows[--pool->count].win];
+    }
+}
+
+@end
+
 /* ----------------------------------------------------------------------- */
 /* GNUstep Event Operations */
 /* ----------------------------------------------------------------------- */
+@interface NSEvent (Coalescing)
++ (NSEvent*) _eventCoalescingEvents: (NSArray*)events;
+@end
+
+#define GSCoalescedEventMask (NSMouseMovedMask | NSLeftMouseDraggedMask \
+  | NSRightMouseDraggedMask | NSOtherMouseDraggedMask)
+
+/* Removes the motion events of the same kind as event which directly
+ * follow it at pos in the queue, and returns a single event standing for
+ * all of them.  Events for another window or with other modifiers end
+ * the run, so that no change of state is lost.
+ */
+static NSEvent *
+coalesce_events(NSMutableArray *queue, NSUInteger pos, NSEvent *event)
+{
+  NSEventType		type = [event type];
+  NSInteger		window = [event windowNumber];
+  NSUInteger		flags = [event modifierFlags];
+  NSMutableArray	*events = nil;
+  NSUInteger		count = [queue count];
+
+  while (pos < count)
+    {
+      NSEvent	*next = [queue objectAtIndex: pos];
+
+      if ([next type] != type || [next windowNumber] != window
+	|| [next modifierFlags] != flags)
+	{
+	  break;
+	}
+      if (events == nil)
+	{
+	  events = [NSMutableArray arrayWithObject: event];
+	}
+      [events addObject: next];
+      [queue removeObjectAtIndex: pos];
+      count--;
+    }
+  if (events == nil)
+    {
+      return event;
+    }
+  return [NSEvent _eventCoalescingEvents: events];
+}
+
 @implementation GSDisplayServer (EventOps)
 
 /**
@@ -1025,6 +1549,14 @@ GSCurrentServer(void)
 	  if (flag)
 	    {
 	      [event_queue removeObjectAtIndex: pos];
+	      if ((NSEventMaskFromType([event type]) & GSCoalescedEventMask)
+		&& [NSEvent isMouseCoalescingEnabled])
+		{
+		  NSEvent	*coalesced;
+
+		  coalesced = coalesce_events(event_queue, pos, event);
+		  ASSIGN(event, coalesced);
+		}
 	    }
 	  return AUTORELEASE(event);
 	}
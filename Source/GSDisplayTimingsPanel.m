@@ -0,0 +1,451 @@
+/* GSDisplayTimingsPanel.m                                   -*-objc-*-
+
+   A GNUstep panel for finding slow windows and views.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of the GNUstep GUI Library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; see the file COPYING.LIB.
+   If not, see <http://www.gnu.org/licenses/> or write to the 
+   Free Software Foundation, 51 Franklin Street, Fifth Floor, 
+   Boston, MA 02110-1301, USA.
+*/
+
+#import <Foundation/NSArray.h>
+#import <Foundation/NSDictionary.h>
+#import <Foundation/NSEnumerator.h>
+#import <Foundation/NSRunLoop.h>
+#import <Foundation/NSString.h>
+#import <Foundation/NSTimer.h>
+#import <Foundation/NSValue.h>
+#import "AppKit/NSButton.h"
+#import "AppKit/NSColor.h"
+#import "AppKit/NSFont.h"
+#import "AppKit/NSGraphics.h"
+#import "AppKit/NSScreen.h"
+#import "AppKit/NSScrollView.h"
+#import "AppKit/NSTableColumn.h"
+#import "AppKit/NSTableView.h"
+#import "AppKit/NSTextField.h"
+#import "AppKit/NSWindow.h"
+#import "GNUstepGUI/GSDisplayTimingsPanel.h"
+#import "GNUstepGUI/GSHbox.h"
+#import "GNUstepGUI/GSVbox.h"
+
+/* Returns a time in seconds as milliseconds for the tables.  */
+static inline NSString *
+milliseconds(id seconds)
+{
+  return [NSString stringWithFormat: @"%.2f", [seconds doubleValue] * 1000];
+}
+
+static NSButton *
+make_button(NSString *title, id target, SEL action)
+{
+  NSButton *button = [NSButton new];
+
+  [button setBordered: YES];
+  [button setButtonType: NSMomentaryPushButton];
+  [button setTitle: title];
+  [button setImagePosition: NSNoImage];
+  [button setTarget: target];
+  [button setAction: action];
+  [button sizeToFit];
+  return AUTORELEASE(button);
+}
+
+static NSScrollView *
+make_table(NSTableView **table, id owner, NSString **identifiers,
+           NSString **titles, NSUInteger count, CGFloat height)
+{
+  NSScrollView *scrollView;
+  NSUInteger i;
+
+  *table = [[NSTableView alloc] initWithFrame: NSMakeRect (0, 0, 400, height)];
+  for (i = 0; i < count; i++)
+    {
+      NSTableColumn *column;
+
+      column = [[NSTableColumn alloc] initWithIdentifier: identifiers[i]];
+      [column setEditable: NO];
+      [[column headerCell] setStringValue: titles[i]];
+      [column setMinWidth: (i == 0) ? 200 : 50];
+      [*table addTableColumn: column];
+      RELEASE (column);
+    }
+  [*table setDataSource: owner];
+  [*table setDelegate: owner];
+
+  scrollView = [[NSScrollView alloc]
+		 initWithFrame: NSMakeRect (0, 0, 450, height)];
+  [scrollView setDocumentView: *table];
+  [scrollView setHasHorizontalScroller: YES];
+  [scrollView setHasVerticalScroller: YES];
+  [scrollView setBorderType: NSBezelBorder];
+  [scrollView setAutoresizingMask: (NSViewWidthSizable | NSViewHeightSizable)];
+  [*table sizeToFit];
+  RELEASE (*table);
+  return AUTORELEASE(scrollView);
+}
+
+/*
+ * The Display Timings Panel code
+ */
+
+static GSDisplayTimingsPanel *sharedGSDisplayTimingsPanel = nil;
+
+@implementation GSDisplayTimingsPanel
++ (id) sharedDisplayTimingsPanel
+{
+  if (sharedGSDisplayTimingsPanel == nil)
+    {
+      sharedGSDisplayTimingsPanel = [GSDisplayTimingsPanel new];
+    }
+
+  return sharedGSDisplayTimingsPanel;
+}
+
++ (void) update: (id)sender
+{
+  [[self sharedDisplayTimingsPanel] update: sender];
+}
+
+- (id) init
+{
+  static NSString *windowColumns[] = {
+    @"Window", @"Frames", @"AverageDisplayTime", @"SlowestDisplayTime",
+    @"AverageFlushTime", @"AverageViewsDrawn"
+  };
+  static NSString *windowTitles[] = {
+    @"Window", @"Frames", @"Display (ms)", @"Slowest (ms)",
+    @"Flush (ms)", @"Views"
+  };
+  static NSString *viewColumns[] = {
+    @"View", @"Draws", @"AverageTime", @"SlowestTime"
+  };
+  static NSString *viewTitles[] = {
+    @"Slowest Views", @"Draws", @"Average (ms)", @"Slowest (ms)"
+  };
+  NSRect winFrame;
+  GSVbox *vbox;
+  GSHbox *hbox;
+  NSButton *button;
+
+  /* Activate recording of display timings. */
+  [NSWindow setRecordsDisplayTimings: YES];
+
+  hbox = [GSHbox new];
+  [hbox setDefaultMinXMargin: 5];
+  [hbox setBorder: 5];
+  [hbox setAutoresizingMask: NSViewWidthSizable];
+
+  /* Button updating the tables.  */
+  button = make_button(@"Update", self, @selector(update:));
+  [button setAutoresizingMask: NSViewMaxXMargin];
+  [hbox addView: button];
+
+  /* Button discarding the timings.  */
+  button = make_button(@"Reset", self, @selector(reset:));
+  [button setAutoresizingMask: NSViewMinXMargin];
+  [hbox addView: button];
+
+  vbox = [GSVbox new];
+  [vbox setDefaultMinYMargin: 5];
+  [vbox setBorder: 5];
+  [vbox addView: hbox  enablingYResizing: NO];
+  RELEASE (hbox);
+  /* GSVbox packs views from the bottom up.  */
+  [vbox addView: make_table(&viewTable, self, viewColumns, viewTitles,
+                            4, 200)];
+  [vbox addView: make_table(&windowTable, self, windowColumns, windowTitles,
+                            6, 150)];
+
+  winFrame.size = [vbox frame].size;
+  winFrame.origin = NSMakePoint (100, 200);
+  
+  self = [super initWithContentRect: winFrame
+                          styleMask: (NSTitledWindowMask 
+                                      | NSClosableWindowMask 
+                                      | NSMiniaturizableWindowMask 
+                                      | NSResizableWindowMask)
+                            backing: NSBackingStoreBuffered
+                              defer: NO];
+  if (nil == self)
+    return nil;
+
+  windows = [NSMutableArray new];
+  timings = [NSMutableArray new];
+
+  [self setReleasedWhenClosed: NO];
+  [self setContentView: vbox];
+  RELEASE (vbox);
+  [self setTitle: @"Display Timings"];
+  
+  return self;
+}
+
+- (void) dealloc
+{
+  RELEASE(windows);
+  RELEASE(timings);
+  [super dealloc];
+}
+
+- (NSDictionary *) _selectedTimings
+{
+  NSInteger row = [windowTable selectedRow];
+
+  if (row < 0 || row >= (NSInteger)[timings count])
+    return nil;
+  return [timings objectAtIndex: row];
+}
+
+- (NSInteger) numberOfRowsInTableView: (NSTableView *)aTableView
+{
+  if (aTableView == windowTable)
+    {
+      return [timings count];
+    }
+  return [[[self _selectedTimings] objectForKey: @"Views"] count];
+}
+
+- (id)           tableView: (NSTableView *)aTableView 
+ objectValueForTableColumn: (NSTableColumn *)aTableColumn 
+		       row: (NSInteger)rowIndex
+{
+  id identifier = [aTableColumn identifier];
+  NSDictionary *entry;
+  id value;
+
+  if (aTableView == windowTable)
+    {
+      if ([identifier isEqual: @"Window"])
+        {
+          NSWindow *w = [windows objectAtIndex: rowIndex];
+
+          return [NSString stringWithFormat: @"%@ (%ld)", [w title],
+                           (long)[w windowNumber]];
+        }
+      entry = [timings objectAtIndex: rowIndex];
+    }
+  else
+    {
+      entry = [[[self _selectedTimings] objectForKey: @"Views"]
+                objectAtIndex: rowIndex];
+    }
+
+  value = [entry objectForKey: identifier];
+  if ([identifier hasSuffix: @"Time"])
+    {
+      return milliseconds(value);
+    }
+  if ([identifier isEqual: @"AverageViewsDrawn"])
+    {
+      return [NSString stringWithFormat: @"%.1f", [value doubleValue]];
+    }
+  return value;
+}
+
+- (void) tableViewSelectionDidChange: (NSNotification *)aNotification
+{
+  if ([aNotification object] == windowTable)
+    {
+      [viewTable reloadData];
+    }
+}
+
+- (void) update: (id)sender
+{
+  NSEnumerator *e = [GSAllWindows() objectEnumerator];
+  NSWindow *selected = nil;
+  NSWindow *w;
+  NSInteger row = [windowTable selectedRow];
+
+  if (row >= 0 && row < (NSInteger)[windows count])
+    {
+      selected = [windows objectAtIndex: row];
+    }
+
+  [windows removeAllObjects];
+  [timings removeAllObjects];
+  while ((w = [e nextObject]) != nil)
+    {
+      NSDictionary *t = [w displayTimings];
+
+      if (t != nil)
+        {
+          [windows addObject: w];
+          [timings addObject: t];
+        }
+    }
+
+  [windowTable reloadData];
+  row = (selected != nil) ? [windows indexOfObjectIdenticalTo: selected]
+    : NSNotFound;
+  if (row != NSNotFound)
+    {
+      [windowTable selectRow: row byExtendingSelection: NO];
+    }
+  [viewTable reloadData];
+}
+
+- (void) reset: (id)sender
+{
+  NSEnumerator *e = [GSAllWindows() objectEnumerator];
+  NSWindow *w;
+
+  while ((w = [e nextObject]) != nil)
+    {
+      [w resetDisplayTimings];
+    }
+  [self update: sender];
+}
+
+@end
+
+/*
+ * The input latency overlay, a window in a corner of the screen which
+ * does not take events.
+ */
+
+@interface GSInputLatencyOverlay : NSPanel
+{
+  NSTextField *text;
+  NSTimer *timer;
+}
+- (void) update: (id)sender;
+@end
+
+static GSInputLatencyOverlay *sharedInputLatencyOverlay = nil;
+
+@implementation GSInputLatencyOverlay
+
+- (id) init
+{
+  NSRunLoop *loop = [NSRunLoop currentRunLoop];
+
+  self = [super initWithContentRect: NSMakeRect (0, 0, 300, 40)
+                          styleMask: NSBorderlessWindowMask
+                            backing: NSBackingStoreBuffered
+                              defer: NO];
+  if (nil == self)
+    return nil;
+
+  [NSApplication setRecordsInputLatency: YES];
+
+  text = [[NSTextField alloc] initWithFrame: NSMakeRect (0, 0, 300, 40)];
+  [text setEditable: NO];
+  [text setSelectable: NO];
+  [text setBezeled: NO];
+  [text setBordered: NO];
+  [text setDrawsBackground: NO];
+  [text setTextColor: [NSColor whiteColor]];
+  [text setFont: [NSFont userFixedPitchFontOfSize: 10]];
+  [self setContentView: text];
+  RELEASE (text);
+
+  [self setReleasedWhenClosed: NO];
+  [self setIgnoresMouseEvents: YES];
+  [self setLevel: NSStatusWindowLevel];
+  [self setOpaque: NO];
+  [self setBackgroundColor:
+    [NSColor colorWithCalibratedWhite: 0.0 alpha: 0.75]];
+
+  timer = [NSTimer timerWithTimeInterval: 1.0
+                                  target: self
+                                selector: @selector(update:)
+                                userInfo: nil
+                                 repeats: YES];
+  [loop addTimer: timer forMode: NSDefaultRunLoopMode];
+  [loop addTimer: timer forMode: NSModalPanelRunLoopMode];
+  [loop addTimer: timer forMode: NSEventTrackingRunLoopMode];
+  return self;
+}
+
+- (void) dealloc
+{
+  [timer invalidate];
+  [super dealloc];
+}
+
+- (BOOL) canBecomeKeyWindow
+{
+  return NO;
+}
+
+- (BOOL) canBecomeMainWindow
+{
+  return NO;
+}
+
+- (void) update: (id)sender
+{
+  NSDictionary *stats = [NSApp inputLatencyStatistics];
+  NSEnumerator *e;
+  NSString *type;
+  NSMutableString *lines;
+  NSRect screen = [[NSScreen mainScreen] visibleFrame];
+  NSRect frame;
+
+  lines = [NSMutableString stringWithFormat: @"%-18s %6s %7s %7s %7s",
+                           "Input latency (ms)", "Count", "p50", "p99", "Max"];
+  e = [[[stats allKeys] sortedArrayUsingSelector: @selector(compare:)]
+        objectEnumerator];
+  while ((type = [e nextObject]) != nil)
+    {
+      NSDictionary *entry = [stats objectForKey: type];
+
+      [lines appendFormat: @"\n%-18s %6lu %7.1f %7.1f %7.1f",
+             [type UTF8String],
+             (unsigned long)[[entry objectForKey: @"Count"]
+                              unsignedIntegerValue],
+             [[entry objectForKey: @"MedianTime"] doubleValue] * 1000,
+             [[entry objectForKey: @"P99Time"] doubleValue] * 1000,
+             [[entry objectForKey: @"MaxTime"] doubleValue] * 1000];
+    }
+  [text setStringValue: lines];
+  [text sizeToFit];
+
+  /* Keep the window in the top right corner of the screen.  */
+  frame.size = [text frame].size;
+  frame.origin.x = NSMaxX(screen) - frame.size.width - 10;
+  frame.origin.y = NSMaxY(screen) - frame.size.height - 10;
+  [self setFrame: frame display: YES];
+}
+
+@end
+
+@implementation NSApplication (displayTimingsPanel)
+
+- (void) orderFrontSharedDisplayTimingsPanel: (id)sender
+{
+  GSDisplayTimingsPanel *panel;
+
+  panel = [GSDisplayTimingsPanel sharedDisplayTimingsPanel];
+  [panel update: self];
+  [panel orderFront: self];
+}
+
+- (void) orderFrontInputLatencyOverlay: (id)sender
+{
+  if (sharedInputLatencyOverlay == nil)
+    {
+      sharedInputLatencyOverlay = [GSInputLatencyOverlay new];
+    }
+  [sharedInputLatencyOverlay update: self];
+  [sharedInputLatencyOverlay orderFrontRegardless];
+}
+
+@end
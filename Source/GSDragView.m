@@ -55,6 +55,17 @@
 #define SLIDE_TIME_STEP   .02   /* in seconds */
 #define SLIDE_NR_OF_STEPS 20  
 
+/* The drag image follows the mouse at this period.  Dragging updates
+ * are only sent to a target whose view under the mouse is unchanged
+ * when the mouse moved at least DRAG_UPDATE_DISTANCE points since the
+ * last update, or after DRAG_UPDATE_INTERVAL seconds (longer for targets
+ * in other applications, which are sent updates through the backend).
+ */
+#define DRAG_FRAME_PERIOD		(1.0 / 60)
+#define DRAG_UPDATE_DISTANCE		3.0
+#define DRAG_UPDATE_INTERVAL		0.03
+#define DRAG_EXTERNAL_UPDATE_INTERVAL	0.1
+
 @interface GSRawWindow : NSWindow
 @end
 
@@ -80,6 +91,11 @@
        timestamp: (NSTimeInterval)time
 	toWindow: (NSWindow*)dWindow;
 - (void) _handleDrag: (NSEvent*)theEvent slidePoint: (NSPoint)slidePoint;
+- (NSView*) _viewUnder: (NSPoint)screenPoint;
+- (void) _noteUpdateAt: (NSPoint)screenPoint;
+- (void) _sendUpdateAt: (NSPoint)screenPoint
+	     timestamp: (NSTimeInterval)time
+		 force: (BOOL)force;
 - (void) _handleEventDuringDragging: (NSEvent *)theEvent;
 - (void) _updateAndMoveImageToCorrectPosition;
 - (void) _moveDraggedImageToNewPosition;
@@ -670,8 +686,11 @@ static	GSDragView *sharedDragView = nil;
     }
   
   // --- Setup the event loop ------------------------------------------
+  lastUpdateTime = 0;
+  lastUpdateView = nil;
   [self _updateAndMoveImageToCorrectPosition];
-  [NSEvent startPeriodicEventsAfterDelay: 0.02 withPeriod: 0.03];
+  [NSEvent startPeriodicEventsAfterDelay: DRAG_FRAME_PERIOD
+			      withPeriod: DRAG_FRAME_PERIOD];
 
   // --- Loop that handles all events during drag operation -----------
   while ([theEvent type] != NSLeftMouseUp)
@@ -686,6 +705,8 @@ static	GSDragView *sharedDragView = nil;
 
   // --- Event loop for drag operation stopped ------------------------
   [NSEvent stopPeriodicEvents];
+  // Make sure the target has seen the final position before the drop
+  lastUpdateTime = 0;
   [self _updateAndMoveImageToCorrectPosition];
 
   NSDebugLLog(@"NSDragging", @"dnd ending %ld\n", (long)targetWindowRef);
@@ -835,22 +856,9 @@ static	GSDragView *sharedDragView = nil;
         {
           // If flags change, send update to allow
           // destination to take note.
-          if (destWindow)
-            {
-              [self _sendLocalEvent: GSAppKitDraggingUpdate
-                             action: dragMask & operationMask
-                           position: newPosition
-                          timestamp: [theEvent timestamp]
-                           toWindow: destWindow];
-            }
-          else
-            {
-              [self sendExternalEvent: GSAppKitDraggingUpdate
-                               action: dragMask & operationMask
-                             position: newPosition
-                            timestamp: [theEvent timestamp]
-                             toWindow: targetWindowRef];
-            }
+          [self _sendUpdateAt: newPosition
+                    timestamp: [theEvent timestamp]
+                        force: YES];
           [self _setCursor];
         }
       break;
@@ -860,21 +868,11 @@ static	GSDragView *sharedDragView = nil;
         {
           [self _updateAndMoveImageToCorrectPosition];
         }
-      else if (destWindow)
-        {
-	  [self _sendLocalEvent: GSAppKitDraggingUpdate
-                         action: dragMask & operationMask
-                       position: newPosition
-                      timestamp: [theEvent timestamp]
-                       toWindow: destWindow];
-	}
       else
         {
-          [self sendExternalEvent: GSAppKitDraggingUpdate
-                           action: dragMask & operationMask
-                         position: newPosition
-                        timestamp: [theEvent timestamp]
-                         toWindow: targetWindowRef];
+          [self _sendUpdateAt: newPosition
+                    timestamp: [theEvent timestamp]
+                        force: NO];
         }
       break;
     default:
@@ -972,22 +970,9 @@ static	GSDragView *sharedDragView = nil;
       NSDebugLLog(@"NSDragging", @"sending dnd pos\n");
 
       // FIXME: We should only send this when the destination wantsPeriodicDraggingUpdates
-      if (destWindow != nil)
-        {
-          [self _sendLocalEvent: GSAppKitDraggingUpdate
-                         action: dragMask & operationMask
-                       position: dragPosition
-                      timestamp: dragSequence
-                       toWindow: destWindow];
-        }
-      else 
-        {
-          [self sendExternalEvent: GSAppKitDraggingUpdate 
-                           action: dragMask & operationMask
-                         position: dragPosition
-                        timestamp: dragSequence
-                         toWindow: targetWindowRef];
-        }
+      [self _sendUpdateAt: dragPosition
+                timestamp: dragSequence
+                    force: NO];
     }
   else if (mouseWindowRef != 0)
     {
@@ -1011,6 +996,7 @@ static	GSDragView *sharedDragView = nil;
                         timestamp: dragSequence
                          toWindow: mouseWindowRef];
         }
+      [self _noteUpdateAt: dragPosition];
     }
 
   if (targetWindowRef != mouseWindowRef)
@@ -1025,6 +1011,83 @@ static	GSDragView *sharedDragView = nil;
     }
 }
 
+/*
+ * Returns the view under screenPoint in the local destination window,
+ * or nil for a target in another application.
+ */
+- (NSView*) _viewUnder: (NSPoint)screenPoint
+{
+  NSView	*frameView;
+
+  if (destWindow == nil)
+    {
+      return nil;
+    }
+  frameView = [[destWindow contentView] superview];
+  if (frameView == nil)
+    {
+      frameView = [destWindow contentView];
+    }
+  return [frameView hitTest: [destWindow convertScreenToBase: screenPoint]];
+}
+
+/*
+ * Records that the target has been told about screenPoint.
+ */
+- (void) _noteUpdateAt: (NSPoint)screenPoint
+{
+  lastUpdatePosition = screenPoint;
+  lastUpdateTime = [NSDate timeIntervalSinceReferenceDate];
+  lastUpdateView = [self _viewUnder: screenPoint];
+}
+
+/*
+ * Sends a dragging update for screenPoint to the current target.
+ * Unless force is YES, the update is skipped while the mouse stays close
+ * to the last update within the same view, until some time has passed.
+ * This keeps slow targets, and those reached over the backend, from
+ * being flooded with updates that don't tell them anything new.
+ */
+- (void) _sendUpdateAt: (NSPoint)screenPoint
+	     timestamp: (NSTimeInterval)time
+		 force: (BOOL)force
+{
+  if (force == NO)
+    {
+      NSTimeInterval	now = [NSDate timeIntervalSinceReferenceDate];
+      NSTimeInterval	interval;
+      CGFloat		dx = screenPoint.x - lastUpdatePosition.x;
+      CGFloat		dy = screenPoint.y - lastUpdatePosition.y;
+
+      interval = (destWindow != nil)
+	? DRAG_UPDATE_INTERVAL : DRAG_EXTERNAL_UPDATE_INTERVAL;
+      if (now - lastUpdateTime < interval
+	&& dx * dx + dy * dy < DRAG_UPDATE_DISTANCE * DRAG_UPDATE_DISTANCE
+	&& [self _viewUnder: screenPoint] == lastUpdateView)
+	{
+	  return;
+	}
+    }
+
+  if (destWindow != nil)
+    {
+      [self _sendLocalEvent: GSAppKitDraggingUpdate
+		     action: dragMask & operationMask
+		   position: screenPoint
+		  timestamp: time
+		   toWindow: destWindow];
+    }
+  else
+    {
+      [self sendExternalEvent: GSAppKitDraggingUpdate
+		       action: dragMask & operationMask
+		     position: screenPoint
+		    timestamp: time
+		     toWindow: targetWindowRef];
+    }
+  [self _noteUpdateAt: screenPoint];
+}
+
 /*
  * Move the dragged image immediately to the position indicated by
  * the instance variable newPosition.
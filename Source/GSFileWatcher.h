@@ -0,0 +1,83 @@
+/*                                                    -*-objc-*-
+   GSFileWatcher.h
+
+   The private directory change monitor behind NSWorkspace and the
+   open and save panels
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of the GNUstep GUI Library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; see the file COPYING.LIB.
+   If not, see <http://www.gnu.org/licenses/> or write to the
+   Free Software Foundation, 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef _GS_FILE_WATCHER_H
+#define _GS_FILE_WATCHER_H
+
+#import <Foundation/NSObject.h>
+
+@class NSMutableDictionary;
+@class NSString;
+
+/*
+ * Watches directories for changes using inotify where it is available
+ * and kqueue otherwise, from the run loop of the main thread.
+ *
+ * Changes are collected for a short while, so a burst of changes to a
+ * directory is reported once, with
+ *
+ *   [observer performSelector: aSelector withObject: path withObject: names]
+ *
+ * where names is a set of the names of the entries in the directory
+ * which were added, removed or changed.  names is nil if it is not known
+ * what changed, because the directory itself was removed or renamed or
+ * too many events arrived; the observer should then look at the whole
+ * directory again.
+ *
+ * Observers are not retained.  The number of directories watched at
+ * once is limited by the GSFileWatcherMaxDirectories user default (1024
+ * if unset).
+ */
+@interface GSFileWatcher : NSObject
+{
+  int			fd;
+  NSMutableDictionary	*directories;	// Path to watched directory
+  NSMutableDictionary	*descriptors;	// Watch descriptor to directory
+  NSMutableDictionary	*pending;	// Path to changed names or NSNull
+  NSUInteger		maxDirectories;
+}
+
++ (GSFileWatcher *) sharedWatcher;
+
+/* Starts sending changes to path to the observer.  Returns NO if the
+   directory can not be watched. */
+- (BOOL) addObserver: (id)observer
+	    selector: (SEL)aSelector
+	forDirectory: (NSString *)path;
+
+- (void) removeObserver: (id)observer
+	   forDirectory: (NSString *)path;
+
+/* Removes the observer from every directory it watches. */
+- (void) removeObserver: (id)observer;
+
+/* Returns YES if changes to path are being sent to some observer. */
+- (BOOL) isWatchingDirectory: (NSString *)path;
+
+@end
+
+#endif
@@ -0,0 +1,602 @@
+/*
+   GSFileWatcher.m
+
+   The private directory change monitor behind NSWorkspace and the
+   open and save panels
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of the GNUstep GUI Library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; see the file COPYING.LIB.
+   If not, see <http://www.gnu.org/licenses/> or write to the
+   Free Software Foundation, 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#import "config.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#if defined(HAVE_SYS_INOTIFY_H)
+#include <sys/inotify.h>
+#define USE_INOTIFY 1
+#elif defined(HAVE_SYS_EVENT_H)
+#include <sys/types.h>
+#include <sys/event.h>
+#include <sys/time.h>
+#define USE_KQUEUE 1
+#endif
+
+#import <Foundation/NSArray.h>
+#import <Foundation/NSDictionary.h>
+#import <Foundation/NSFileManager.h>
+#import <Foundation/NSNull.h>
+#import <Foundation/NSRunLoop.h>
+#import <Foundation/NSSet.h>
+#import <Foundation/NSString.h>
+#import <Foundation/NSUserDefaults.h>
+#import <Foundation/NSValue.h>
+#import "AppKit/NSApplication.h"
+#import "GSFileWatcher.h"
+
+/* How long changes are collected before they are reported. */
+#define COALESCE_DELAY 0.1
+/* The default limit of the number of directories watched. */
+#define DEFAULT_MAX_DIRECTORIES 1024
+
+/*
+ * One watched directory and the observers of its changes.
+ */
+@interface GSWatchedDirectory : NSObject
+{
+@public
+  NSString *path;
+  int wd;			// inotify watch or kqueue descriptor, or -1
+  NSMutableArray *observers;	// Not retained
+  NSMutableArray *selectors;
+  NSDictionary *snapshot;	// Entry stamps, used with kqueue
+}
+@end
+
+@implementation GSWatchedDirectory
+
+- (void) dealloc
+{
+  RELEASE(path);
+  RELEASE(observers);
+  RELEASE(selectors);
+  RELEASE(snapshot);
+  [super dealloc];
+}
+
+- (NSUInteger) indexOfObserver: (id)observer
+{
+  NSUInteger i = [observers count];
+
+  while (i-- > 0)
+    {
+      if ([[observers objectAtIndex: i] nonretainedObjectValue] == observer)
+	{
+	  return i;
+	}
+    }
+  return NSNotFound;
+}
+
+@end
+
+static GSFileWatcher *sharedWatcher = nil;
+static NSArray *modes = nil;
+
+#if defined(USE_KQUEUE)
+/* Returns the modification time and size of each entry of a directory,
+   so that a change to the directory can be narrowed down to the entries
+   which changed. */
+static NSDictionary *
+snapshotOfDirectory(NSString *path)
+{
+  NSFileManager *mgr = [NSFileManager defaultManager];
+  NSArray *names = [mgr directoryContentsAtPath: path];
+  NSMutableDictionary *d;
+  NSUInteger i, count = [names count];
+
+  d = [NSMutableDictionary dictionaryWithCapacity: count];
+  for (i = 0; i < count; i++)
+    {
+      NSString *name = [names objectAtIndex: i];
+      NSDictionary *attrs;
+
+      attrs = [mgr fileAttributesAtPath:
+	[path stringByAppendingPathComponent: name] traverseLink: NO];
+      [d setObject: [NSString stringWithFormat: @"%f %llu",
+	[[attrs fileModificationDate] timeIntervalSinceReferenceDate],
+	[attrs fileSize]]
+	    forKey: name];
+    }
+  return d;
+}
+#endif
+
+@implementation GSFileWatcher
+
++ (GSFileWatcher *) sharedWatcher
+{
+  if (sharedWatcher == nil)
+    {
+      modes = [[NSArray alloc] initWithObjects: NSDefaultRunLoopMode,
+	NSModalPanelRunLoopMode, NSEventTrackingRunLoopMode, nil];
+      sharedWatcher = [self new];
+    }
+  return sharedWatcher;
+}
+
+- (id) init
+{
+  NSInteger max;
+
+  if ((self = [super init]) == nil)
+    {
+      return nil;
+    }
+  directories = [NSMutableDictionary new];
+  descriptors = [NSMutableDictionary new];
+  pending = [NSMutableDictionary new];
+  max = [[NSUserDefaults standardUserDefaults]
+    integerForKey: @"GSFileWatcherMaxDirectories"];
+  maxDirectories = (max > 0) ? max : DEFAULT_MAX_DIRECTORIES;
+
+  fd = -1;
+#if defined(USE_INOTIFY)
+  fd = inotify_init();
+  if (fd >= 0)
+    {
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+#elif defined(USE_KQUEUE)
+  fd = kqueue();
+#endif
+  if (fd >= 0)
+    {
+      NSRunLoop *loop = [NSRunLoop currentRunLoop];
+      NSUInteger i;
+
+      fcntl(fd, F_SETFD, FD_CLOEXEC);
+      for (i = 0; i < [modes count]; i++)
+	{
+	  [loop addEvent: (void*)(uintptr_t)fd
+		    type: ET_RDESC
+		 watcher: (id<RunLoopEvents>)self
+		 forMode: [modes objectAtIndex: i]];
+	}
+    }
+  return self;
+}
+
+- (void) dealloc
+{
+  if (fd >= 0)
+    {
+      NSRunLoop *loop = [NSRunLoop currentRunLoop];
+      NSUInteger i;
+
+      for (i = 0; i < [modes count]; i++)
+	{
+	  [loop removeEvent: (void*)(uintptr_t)fd
+		       type: ET_RDESC
+		    forMode: [modes objectAtIndex: i]
+			all: YES];
+	}
+      close(fd);
+    }
+  RELEASE(directories);
+  RELEASE(descriptors);
+  RELEASE(pending);
+  [super dealloc];
+}
+
+/* Starts watching the directory of entry, returning NO on failure. */
+- (BOOL) _watch: (GSWatchedDirectory *)entry
+{
+  const char *cPath = [entry->path fileSystemRepresentation];
+  NSNumber *key;
+  NSMutableArray *entries;
+
+  entry->wd = -1;
+#if defined(USE_INOTIFY)
+  entry->wd = inotify_add_watch(fd, cPath,
+    IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY
+    | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+#elif defined(USE_KQUEUE)
+  {
+    struct kevent ev;
+    int flags = O_RDONLY;
+
+#if defined(O_EVTONLY)
+    flags = O_EVTONLY;
+#endif
+    entry->wd = open(cPath, flags);
+    if (entry->wd >= 0)
+      {
+	fcntl(entry->wd, F_SETFD, FD_CLOEXEC);
+	EV_SET(&ev, entry->wd, EVFILT_VNODE, EV_ADD | EV_ENABLE | EV_CLEAR,
+	  NOTE_WRITE | NOTE_EXTEND | NOTE_ATTRIB | NOTE_DELETE | NOTE_RENAME
+	  | NOTE_REVOKE, 0, 0);
+	if (kevent(fd, &ev, 1, NULL, 0, NULL) < 0)
+	  {
+	    close(entry->wd);
+	    entry->wd = -1;
+	  }
+	else
+	  {
+	    ASSIGN(entry->snapshot, snapshotOfDirectory(entry->path));
+	  }
+      }
+  }
+#endif
+  if (entry->wd < 0)
+    {
+      return NO;
+    }
+
+  /* inotify hands out the same watch for two paths of one directory. */
+  key = [NSNumber numberWithInt: entry->wd];
+  entries = [descriptors objectForKey: key];
+  if (entries == nil)
+    {
+      entries = [NSMutableArray new];
+      [descriptors setObject: entries forKey: key];
+      RELEASE(entries);
+    }
+  [entries addObject: entry];
+  return YES;
+}
+
+/* Stops watching the directory of entry. */
+- (void) _unwatch: (GSWatchedDirectory *)entry
+{
+  NSNumber *key;
+  NSMutableArray *entries;
+
+  if (entry->wd < 0)
+    {
+      return;
+    }
+  key = [NSNumber numberWithInt: entry->wd];
+  entries = [descriptors objectForKey: key];
+  [entries removeObjectIdenticalTo: entry];
+  if ([entries count] == 0)
+    {
+      [descriptors removeObjectForKey: key];
+#if defined(USE_INOTIFY)
+      inotify_rm_watch(fd, entry->wd);
+#elif defined(USE_KQUEUE)
+      close(entry->wd);
+#endif
+    }
+  entry->wd = -1;
+}
+
+- (BOOL) addObserver: (id)observer
+	    selector: (SEL)aSelector
+	forDirectory: (NSString *)path
+{
+  GSWatchedDirectory *entry;
+  NSUInteger i;
+
+  if (fd < 0 || path == nil)
+    {
+      return NO;
+    }
+  path = [path stringByStandardizingPath];
+  entry = [directories objectForKey: path];
+  if (entry == nil)
+    {
+      if ([directories count] >= maxDirectories)
+	{
+	  return NO;
+	}
+      entry = AUTORELEASE([GSWatchedDirectory new]);
+      entry->path = [path copy];
+      entry->observers = [NSMutableArray new];
+      entry->selectors = [NSMutableArray new];
+      if ([self _watch: entry] == NO)
+	{
+	  return NO;
+	}
+      [directories setObject: entry forKey: path];
+    }
+
+  i = [entry indexOfObserver: observer];
+  if (i == NSNotFound)
+    {
+      [entry->observers addObject:
+	[NSValue valueWithNonretainedObject: observer]];
+      [entry->selectors addObject: NSStringFromSelector(aSelector)];
+    }
+  else
+    {
+      [entry->selectors replaceObjectAtIndex: i
+				  withObject: NSStringFromSelector(aSelector)];
+    }
+  return YES;
+}
+
+- (void) removeObserver: (id)observer
+	   forDirectory: (NSString *)path
+{
+  GSWatchedDirectory *entry;
+  NSUInteger i;
+
+  path = [path stringByStandardizingPath];
+  entry = [directories objectForKey: path];
+  if (entry == nil)
+    {
+      return;
+    }
+  i = [entry indexOfObserver: observer];
+  if (i != NSNotFound)
+    {
+      [entry->observers removeObjectAtIndex: i];
+      [entry->selectors removeObjectAtIndex: i];
+    }
+  if ([entry->observers count] == 0)
+    {
+      [self _unwatch: entry];
+      [pending removeObjectForKey: path];
+      [directories removeObjectForKey: path];
+    }
+}
+
+- (void) removeObserver: (id)observer
+{
+  NSArray *paths = [directories allKeys];
+  NSUInteger i;
+
+  for (i = 0; i < [paths count]; i++)
+    {
+      [self removeObserver: observer forDirectory: [paths objectAtIndex: i]];
+    }
+}
+
+- (BOOL) isWatchingDirectory: (NSString *)path
+{
+  return [directories objectForKey: [path stringByStandardizingPath]] != nil;
+}
+
+/* Records a change to an entry of a directory, or to the whole directory
+   if name is nil, and makes sure it is reported soon. */
+- (void) _noteChange: (NSString *)name in: (GSWatchedDirectory *)entry
+{
+  id changes;
+
+  if ([pending count] == 0)
+    {
+      [self performSelector: @selector(_flush)
+		 withObject: nil
+		 afterDelay: COALESCE_DELAY
+		    inModes: modes];
+    }
+  changes = [pending objectForKey: entry->path];
+  if (changes == [NSNull null])
+    {
+      return;
+    }
+  if (name == nil)
+    {
+      [pending setObject: [NSNull null] forKey: entry->path];
+    }
+  else
+    {
+      if (changes == nil)
+	{
+	  changes = [NSMutableSet new];
+	  [pending setObject: changes forKey: entry->path];
+	  RELEASE(changes);
+	}
+      [changes addObject: name];
+    }
+}
+
+- (void) _flush
+{
+  NSDictionary *changes = AUTORELEASE(pending);
+  NSEnumerator *enumerator;
+  NSString *path;
+
+  pending = [NSMutableDictionary new];
+  enumerator = [changes keyEnumerator];
+  while ((path = [enumerator nextObject]) != nil)
+    {
+      GSWatchedDirectory *entry = [directories objectForKey: path];
+      NSSet *names = [changes objectForKey: path];
+      NSArray *observers;
+      NSArray *selectors;
+      NSUInteger i;
+
+      if (entry == nil)
+	{
+	  continue;
+	}
+      if ((id)names == [NSNull null])
+	{
+	  names = nil;
+	}
+      if (entry->wd < 0)
+	{
+	  /* The directory went away; it may have been replaced by now. */
+	  [self _watch: entry];
+	}
+
+      RETAIN(entry);
+      observers = AUTORELEASE([entry->observers copy]);
+      selectors = AUTORELEASE([entry->selectors copy]);
+      for (i = 0; i < [observers count]; i++)
+	{
+	  id observer = [[observers objectAtIndex: i] nonretainedObjectValue];
+
+	  /* An earlier observer may have removed this one. */
+	  if ([entry indexOfObserver: observer] != NSNotFound)
+	    {
+	      [observer performSelector:
+		NSSelectorFromString([selectors objectAtIndex: i])
+			     withObject: path
+			     withObject: names];
+	    }
+	}
+      RELEASE(entry);
+    }
+}
+
+- (void) receivedEvent: (void*)data
+		  type: (RunLoopEventType)type
+		 extra: (void*)extra
+	       forMode: (NSString*)mode
+{
+#if defined(USE_INOTIFY)
+  char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+  ssize_t len;
+
+  while ((len = read(fd, buf, sizeof(buf))) > 0)
+    {
+      char *p = buf;
+
+      while (p < buf + len)
+	{
+	  struct inotify_event *ev = (struct inotify_event *)p;
+
+	  p += sizeof(struct inotify_event) + ev->len;
+	  if (ev->mask & IN_Q_OVERFLOW)
+	    {
+	      /* Events were lost, so anything may have changed. */
+	      NSEnumerator *e = [directories objectEnumerator];
+	      GSWatchedDirectory *entry;
+
+	      while ((entry = [e nextObject]) != nil)
+		{
+		  [self _noteChange: nil in: entry];
+		}
+	    }
+	  else
+	    {
+	      NSArray *entries;
+	      NSString *name = nil;
+	      BOOL whole;
+	      NSUInteger i;
+
+	      entries = [descriptors objectForKey:
+		[NSNumber numberWithInt: ev->wd]];
+	      if (entries == nil)
+		{
+		  continue;
+		}
+	      whole = (ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+		? YES : NO;
+	      if (whole == NO)
+		{
+		  if (ev->len == 0)
+		    {
+		      continue;	// A change to the directory's own attributes
+		    }
+		  name = [[NSFileManager defaultManager]
+		    stringWithFileSystemRepresentation: ev->name
+						length: strlen(ev->name)];
+		}
+	      entries = AUTORELEASE([entries copy]);
+	      for (i = 0; i < [entries count]; i++)
+		{
+		  GSWatchedDirectory *entry = [entries objectAtIndex: i];
+
+		  if (ev->mask & IN_IGNORED)
+		    {
+		      /* The kernel dropped the watch along with the
+		       * directory, so there is nothing to remove.
+		       */
+		      [descriptors removeObjectForKey:
+			[NSNumber numberWithInt: entry->wd]];
+		      entry->wd = -1;
+		    }
+		  [self _noteChange: name in: entry];
+		}
+	    }
+	}
+    }
+#elif defined(USE_KQUEUE)
+  struct kevent evs[16];
+  struct timespec zero = { 0, 0 };
+  int n;
+
+  while ((n = kevent(fd, NULL, 0, evs, 16, &zero)) > 0)
+    {
+      int i;
+
+      for (i = 0; i < n; i++)
+	{
+	  NSArray *entries;
+	  NSUInteger j;
+
+	  entries = [descriptors objectForKey:
+	    [NSNumber numberWithInt: (int)evs[i].ident]];
+	  entries = AUTORELEASE([entries copy]);
+	  for (j = 0; j < [entries count]; j++)
+	    {
+	      GSWatchedDirectory *entry = [entries objectAtIndex: j];
+
+	      if (evs[i].fflags & (NOTE_DELETE | NOTE_RENAME | NOTE_REVOKE))
+		{
+		  [self _unwatch: entry];
+		  [self _noteChange: nil in: entry];
+		}
+	      else
+		{
+		  NSDictionary *now = snapshotOfDirectory(entry->path);
+		  NSMutableSet *names = [NSMutableSet set];
+		  NSEnumerator *e;
+		  NSString *name;
+
+		  /* kqueue only says that the directory changed, so the
+		   * entries are compared with how they were before.
+		   */
+		  e = [now keyEnumerator];
+		  while ((name = [e nextObject]) != nil)
+		    {
+		      if (![[now objectForKey: name] isEqual:
+			[entry->snapshot objectForKey: name]])
+			{
+			  [names addObject: name];
+			}
+		    }
+		  e = [entry->snapshot keyEnumerator];
+		  while ((name = [e nextObject]) != nil)
+		    {
+		      if ([now objectForKey: name] == nil)
+			{
+			  [names addObject: name];
+			}
+		    }
+		  ASSIGN(entry->snapshot, now);
+		  e = [names objectEnumerator];
+		  while ((name = [e nextObject]) != nil)
+		    {
+		      [self _noteChange: name in: entry];
+		    }
+		}
+	    }
+	}
+    }
+#endif
+}
+
+@end
@@ -63,8 +63,18 @@ static GSFontEnumerator *sharedEnumerator = nil;
   return self;
 }
 
+- (void) _invalidateFontIndex
+{
+  DESTROY(allFontDescriptors);
+  DESTROY(fontNamesByTraits);
+  DESTROY(fontDescriptorsByName);
+  DESTROY(fontDescriptorsByFamily);
+  DESTROY(fontDescriptorsByTraits);
+}
+
 - (void) dealloc
 {
+  [self _invalidateFontIndex];
   RELEASE(allFontNames);
   RELEASE(allFontFamilies);
   [super dealloc];
@@ -87,6 +97,83 @@ static GSFontEnumerator *sharedEnumerator = nil;
   [self subclassResponsibility: _cmd];
 }
 
+- (void) refreshFontList
+{
+  [self _invalidateFontIndex];
+  DESTROY(allFontNames);
+  DESTROY(allFontFamilies);
+  [self enumerateFontsAndFamilies];
+}
+
+/* Adds object to the array stored under key in index. */
+static void
+addToIndex(NSMutableDictionary *index, id key, id object)
+{
+  NSMutableArray *a = [index objectForKey: key];
+
+  if (a == nil)
+    {
+      a = [[NSMutableArray alloc] init];
+      [index setObject: a forKey: key];
+      RELEASE(a);
+    }
+  [a addObject: object];
+}
+
+- (void) _buildFontIndex
+{
+  NSArray *families;
+  NSEnumerator *familyEnumerator;
+  NSEnumerator *fdEnumerator;
+  NSString *family;
+  NSFontDescriptor *fd;
+
+  if (fontNamesByTraits != nil)
+    return;
+
+  /* Go through the families in the order -availableFontFamilies returns
+     them, so the names are found in the order they always were. */
+  fontNamesByTraits = [[NSMutableDictionary alloc] init];
+  families = [self availableFontFamilies];
+  familyEnumerator = [families objectEnumerator];
+  while ((family = [familyEnumerator nextObject]) != nil)
+    {
+      NSEnumerator *defEnumerator;
+      NSArray *fontDef;
+
+      defEnumerator = [[allFontFamilies objectForKey: family] objectEnumerator];
+      while ((fontDef = [defEnumerator nextObject]) != nil)
+        {
+          NSNumber *traits = [fontDef objectAtIndex: 3];
+
+          addToIndex(fontNamesByTraits,
+            [NSNumber numberWithUnsignedInt: [traits unsignedIntValue]],
+            [fontDef objectAtIndex: 0]);
+        }
+    }
+
+  fontDescriptorsByName = [[NSMutableDictionary alloc] init];
+  fontDescriptorsByFamily = [[NSMutableDictionary alloc] init];
+  fontDescriptorsByTraits = [[NSMutableDictionary alloc] init];
+  fdEnumerator = [[self availableFontDescriptors] objectEnumerator];
+  while ((fd = [fdEnumerator nextObject]) != nil)
+    {
+      NSNumber *traits;
+
+      addToIndex(fontDescriptorsByName,
+                 [fd objectForKey: NSFontNameAttribute], fd);
+      addToIndex(fontDescriptorsByFamily,
+                 [fd objectForKey: NSFontFamilyAttribute], fd);
+      traits = [[fd objectForKey: NSFontTraitsAttribute]
+                 objectForKey: NSFontSymbolicTrait];
+      if (traits != nil)
+        {
+          addToIndex(fontDescriptorsByTraits,
+            [NSNumber numberWithUnsignedInt: [traits unsignedIntValue]], fd);
+        }
+    }
+}
+
 - (NSArray*) availableFonts
 {
   return allFontNames;
@@ -103,6 +190,18 @@ static GSFontEnumerator *sharedEnumerator = nil;
   return [allFontFamilies objectForKey: family];
 }
 
+- (NSArray*) availableFontNamesWithTraits: (NSFontTraitMask)fontTraitMask
+{
+  NSArray *names;
+
+  [self _buildFontIndex];
+  names = [fontNamesByTraits objectForKey:
+    [NSNumber numberWithUnsignedInt: fontTraitMask]];
+  if (names == nil)
+    return [NSArray array];
+  return AUTORELEASE([names copy]);
+}
+
 - (NSArray*) availableFontDescriptors
 {
   if (allFontDescriptors == nil)
@@ -183,67 +282,91 @@ static GSFontEnumerator *sharedEnumerator = nil;
   return found;
 }
 
+static BOOL
+descriptorMatches(NSFontDescriptor *fd, NSDictionary *attributes, NSArray *keys)
+{
+  NSEnumerator *keyEnumerator;
+  NSString *key;
+
+  keyEnumerator = [keys objectEnumerator];
+  while ((key = [keyEnumerator nextObject]) != nil)
+    {
+      id valueA = [attributes objectForKey: key];
+
+      if (valueA != nil)
+        {
+          id valueB = [fd objectForKey: key];
+
+          if (valueB == nil)
+            {
+              return NO;
+            }
+
+          // Special handling for NSFontTraitsAttribute
+          if ([key isEqual: NSFontTraitsAttribute])
+            {
+              NSNumber *traitsA = [valueA objectForKey: NSFontSymbolicTrait];
+              NSNumber *traitsB = [valueB objectForKey: NSFontSymbolicTrait];
+
+              // FIXME: For now we only compare symbolic traits
+              if ((traitsA != nil) && 
+                  ((traitsB == nil) || 
+                   ([traitsA unsignedIntValue] != [traitsB unsignedIntValue])))
+                {
+                  return NO;
+                }
+            }
+          else 
+            {
+              if (![valueA isEqual: valueB])
+                {
+                  return NO;
+                }
+            }
+        }
+    }
+  return YES;
+}
+
 - (NSArray *) matchingFontDescriptorsFor: (NSDictionary *)attributes
 {
   NSMutableArray *found;
   NSEnumerator *fdEnumerator;
   NSFontDescriptor *fd;
   NSArray *keys = [attributes allKeys];
+  NSArray *candidates;
+  id value;
+
+  /* Only look at the fonts in the most selective index that applies;
+     every candidate is still checked against all attributes. */
+  [self _buildFontIndex];
+  if ((value = [attributes objectForKey: NSFontNameAttribute]) != nil)
+    {
+      candidates = [fontDescriptorsByName objectForKey: value];
+    }
+  else if ((value = [attributes objectForKey: NSFontFamilyAttribute]) != nil)
+    {
+      candidates = [fontDescriptorsByFamily objectForKey: value];
+    }
+  else if ((value = [[attributes objectForKey: NSFontTraitsAttribute]
+                      objectForKey: NSFontSymbolicTrait]) != nil)
+    {
+      candidates = [fontDescriptorsByTraits objectForKey:
+        [NSNumber numberWithUnsignedInt: [value unsignedIntValue]]];
+    }
+  else
+    {
+      candidates = [self availableFontDescriptors];
+    }
 
   found = [NSMutableArray arrayWithCapacity: 3];
-  // Get an enumerator for all available font descriptors
-  fdEnumerator = [[self availableFontDescriptors] objectEnumerator];
+  fdEnumerator = [candidates objectEnumerator];
   while ((fd = [fdEnumerator nextObject]) != nil)
     {
-        NSEnumerator *keyEnumerator;
-        NSString *key;
-        BOOL match = YES;
-
-        keyEnumerator = [keys objectEnumerator];
-        while ((key = [keyEnumerator nextObject]) != nil)
-          {
-            id valueA = [attributes objectForKey: key];
-
-            if (valueA != nil)
-              {
-                id valueB = [fd objectForKey: key];
-
-                if (valueB == nil)
-                  {
-                    match = NO;
-                    break;
-                  }
-
-		// Special handling for NSFontTraitsAttribute
-                if ([key isEqual: NSFontTraitsAttribute])
-                  {
-                    NSNumber *traitsA = [valueA objectForKey: NSFontSymbolicTrait];
-                    NSNumber *traitsB = [valueB objectForKey: NSFontSymbolicTrait];
-
-                    // FIXME: For now we only compare symbolic traits
-                    if ((traitsA != nil) && 
-                        ((traitsB == nil) || 
-                         ([traitsA unsignedIntValue] != [traitsB unsignedIntValue])))
-                      {
-                        match = NO;
-                        break;
-                      }
-                  }
-                else 
-                  {
-                    if (![valueA isEqual: valueB])
-                      {
-                        match = NO;
-                        break;
-                      }
-                  }
-              }
-          }
-
-        if (match)
-          {
-            [found addObject: fd];
-          }
+      if (descriptorMatches(fd, attributes, keys))
+        {
+          [found addObject: fd];
+        }
     }
 
   return found;
@@ -272,6 +395,65 @@ static GSFontEnumerator *sharedEnumerator = nil;
        screenFont: (BOOL)screenFont;
 @end
 
+/*
+The metrics of glyphs are kept in pages of GLYPH_PAGE_SIZE glyphs, which
+are allocated the first time one of their glyphs is asked for. Glyphs
+above MAX_CACHED_GLYPH are not cached.
+*/
+#define GLYPH_PAGE_SHIFT 8
+#define GLYPH_PAGE_SIZE (1 << GLYPH_PAGE_SHIFT)
+#define MAX_CACHED_GLYPH 0xffff
+
+#define HAS_ADVANCEMENT 1
+#define HAS_BOUNDS 2
+
+typedef struct
+{
+  NSSize advancements[GLYPH_PAGE_SIZE];
+  NSRect bounds[GLYPH_PAGE_SIZE];
+  unsigned char flags[GLYPH_PAGE_SIZE];
+} glyph_metrics_page_t;
+
+typedef struct
+{
+  glyph_metrics_page_t *pages[(MAX_CACHED_GLYPH + 1) >> GLYPH_PAGE_SHIFT];
+} glyph_metrics_t;
+
+static glyph_metrics_page_t *
+metricsPageForGlyph(void **cache, NSGlyph glyph)
+{
+  glyph_metrics_t *m = *cache;
+  glyph_metrics_page_t **page;
+
+  if (glyph > MAX_CACHED_GLYPH)
+    return NULL;
+  if (m == NULL)
+    {
+      m = calloc(1, sizeof(glyph_metrics_t));
+      if (m == NULL)
+	return NULL;
+      *cache = m;
+    }
+  page = &m->pages[glyph >> GLYPH_PAGE_SHIFT];
+  if (*page == NULL)
+    *page = calloc(1, sizeof(glyph_metrics_page_t));
+  return *page;
+}
+
+static void
+freeGlyphMetrics(void **cache)
+{
+  glyph_metrics_t *m = *cache;
+  unsigned int i;
+
+  if (m == NULL)
+    return;
+  for (i = 0; i < sizeof(m->pages) / sizeof(m->pages[0]); i++)
+    free(m->pages[i]);
+  free(m);
+  *cache = NULL;
+}
+
 @implementation GSFontInfo
 
 + (void) setDefaultClass: (Class)defaultClass
@@ -380,6 +562,7 @@ static GSFontEnumerator *sharedEnumerator = nil;
   RELEASE(familyName);
   RELEASE(encodingScheme);
   TEST_RELEASE(fontDescriptor);
+  freeGlyphMetrics(&glyphMetrics);
   [super dealloc];
 }
 
@@ -396,6 +579,7 @@ static GSFontEnumerator *sharedEnumerator = nil;
       copy->familyName = [familyName copyWithZone: zone];
       copy->encodingScheme = [encodingScheme copyWithZone: zone];
       copy->fontDescriptor = [fontDescriptor copyWithZone: zone];
+      copy->glyphMetrics = NULL;
     }
   return copy;
 }
@@ -411,6 +595,7 @@ static GSFontEnumerator *sharedEnumerator = nil;
   copy->familyName = [familyName copyWithZone: zone];
   copy->encodingScheme = [encodingScheme copyWithZone: zone];
   copy->fontDescriptor = [fontDescriptor copyWithZone: zone];
+  copy->glyphMetrics = NULL;
   return copy;
 }
 
@@ -615,6 +800,78 @@ static GSFontEnumerator *sharedEnumerator = nil;
   return NSZeroRect;
 }
 
+- (void) getAdvancements: (NSSize*)advancements
+	       forGlyphs: (const NSGlyph*)glyphs
+		   count: (NSUInteger)count
+{
+  SEL sel = @selector(advancementForGlyph:);
+  NSSize (*imp)(id, SEL, NSGlyph)
+    = (NSSize (*)(id, SEL, NSGlyph))[self methodForSelector: sel];
+  glyph_metrics_page_t *page = NULL;
+  NSGlyph page_base = 0;
+  NSUInteger i;
+
+  for (i = 0; i < count; i++)
+    {
+      NSGlyph glyph = glyphs[i];
+      unsigned int slot;
+
+      if (page == NULL || (glyph & ~(GLYPH_PAGE_SIZE - 1)) != page_base)
+	{
+	  page = metricsPageForGlyph(&glyphMetrics, glyph);
+	  page_base = glyph & ~(GLYPH_PAGE_SIZE - 1);
+	  if (page == NULL)
+	    {
+	      advancements[i] = imp(self, sel, glyph);
+	      continue;
+	    }
+	}
+      slot = glyph & (GLYPH_PAGE_SIZE - 1);
+      if (!(page->flags[slot] & HAS_ADVANCEMENT))
+	{
+	  page->advancements[slot] = imp(self, sel, glyph);
+	  page->flags[slot] |= HAS_ADVANCEMENT;
+	}
+      advancements[i] = page->advancements[slot];
+    }
+}
+
+- (void) getBoundingRects: (NSRect*)bounds
+		forGlyphs: (const NSGlyph*)glyphs
+		    count: (NSUInteger)count
+{
+  SEL sel = @selector(boundingRectForGlyph:);
+  NSRect (*imp)(id, SEL, NSGlyph)
+    = (NSRect (*)(id, SEL, NSGlyph))[self methodForSelector: sel];
+  glyph_metrics_page_t *page = NULL;
+  NSGlyph page_base = 0;
+  NSUInteger i;
+
+  for (i = 0; i < count; i++)
+    {
+      NSGlyph glyph = glyphs[i];
+      unsigned int slot;
+
+      if (page == NULL || (glyph & ~(GLYPH_PAGE_SIZE - 1)) != page_base)
+	{
+	  page = metricsPageForGlyph(&glyphMetrics, glyph);
+	  page_base = glyph & ~(GLYPH_PAGE_SIZE - 1);
+	  if (page == NULL)
+	    {
+	      bounds[i] = imp(self, sel, glyph);
+	      continue;
+	    }
+	}
+      slot = glyph & (GLYPH_PAGE_SIZE - 1);
+      if (!(page->flags[slot] & HAS_BOUNDS))
+	{
+	  page->bounds[slot] = imp(self, sel, glyph);
+	  page->flags[slot] |= HAS_BOUNDS;
+	}
+      bounds[i] = page->bounds[slot];
+    }
+}
+
 - (BOOL) glyphIsEncoded: (NSGlyph)aGlyph;
 {
   // FIXME: This is a hack for aGlyph == theChar fonts.
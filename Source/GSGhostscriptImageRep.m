@@ -33,17 +33,178 @@
 #import <Foundation/NSData.h>
 #import <Foundation/NSException.h>
 #import <Foundation/NSFileManager.h>
+#import <Foundation/NSLock.h>
+#import <Foundation/NSNotification.h>
 #import <Foundation/NSProcessInfo.h>
 #import <Foundation/NSString.h>
 #import <Foundation/NSTask.h>
+#import <Foundation/NSThread.h>
 #import <Foundation/NSUserDefaults.h>
+#import <Foundation/NSValue.h>
 #import "AppKit/NSImageRep.h"
 #import "AppKit/NSPasteboard.h"
 #import "AppKit/NSGraphicsContext.h"
+#import "AppKit/DPSOperators.h"
 #import "GNUstepGUI/GSGhostscriptImageRep.h"
 
+#include <math.h>
+
+NSString *GSGhostscriptImageRepDidRasterizeNotification
+  = @"GSGhostscriptImageRepDidRasterizeNotification";
+
+/*
+ * Rasters which Ghostscript produced, shared by all reps.  A raster is
+ * found by the digest and length of the document, the resolution it was
+ * produced at and the size of the rep drawing it, and the least recently
+ * used one is dropped to make room for a new one.
+ */
+typedef struct {
+  NSUInteger		digest;
+  NSUInteger		length;
+  CGFloat		resolution;
+  NSSize		size;
+  NSBitmapImageRep	*bitmap;
+  unsigned long		stamp;
+} GSRaster;
+
+static GSRaster		*rasters = 0;
+static NSUInteger	rasterCount = 0;
+static NSUInteger	rasterLimit = 16;
+static unsigned long	rasterClock = 0;
+static NSLock		*rasterLock = nil;
+static CGFloat		maxResolution = 600.0;
+static BOOL		asynchronous = NO;
+
+static NSUInteger
+digestOfData(NSData *data)
+{
+  const unsigned char	*bytes = [data bytes];
+  NSUInteger		length = [data length];
+  NSUInteger		digest = 2166136261U;
+  NSUInteger		i;
+
+  for (i = 0; i < length; i++)
+    {
+      digest = (digest ^ bytes[i]) * 16777619U;
+    }
+  return digest;
+}
+
+/* Returns the cached raster of the document at the resolution, or, if
+ * res is zero, the sharpest one below maxRes.  A zero size matches a
+ * raster of any size.  Must be called with the lock held.
+ */
+static GSRaster *
+findRaster(NSUInteger digest, NSUInteger length, CGFloat res, CGFloat maxRes,
+  NSSize size)
+{
+  GSRaster	*best = 0;
+  NSUInteger	i;
+
+  for (i = 0; i < rasterCount; i++)
+    {
+      GSRaster	*r = &rasters[i];
+
+      if (r->digest != digest || r->length != length)
+	continue;
+      if (size.width != 0 && !NSEqualSizes(r->size, size))
+	continue;
+      if (res != 0)
+	{
+	  if (r->resolution == res)
+	    {
+	      best = r;
+	      break;
+	    }
+	}
+      else if (r->resolution < maxRes
+	&& (best == 0 || r->resolution > best->resolution))
+	{
+	  best = r;
+	}
+    }
+  if (best != 0)
+    {
+      best->stamp = ++rasterClock;
+    }
+  return best;
+}
+
+/* Must be called with the lock held.
+ */
+static void
+addRaster(NSUInteger digest, NSUInteger length, CGFloat res, NSSize size,
+  NSBitmapImageRep *bitmap)
+{
+  GSRaster	*r = findRaster(digest, length, res, 0, size);
+
+  if (r == 0)
+    {
+      if (rasters == 0)
+	{
+	  rasters = NSZoneCalloc(NSDefaultMallocZone(),
+	    rasterLimit, sizeof(GSRaster));
+	}
+      if (rasterCount < rasterLimit)
+	{
+	  r = &rasters[rasterCount++];
+	}
+      else
+	{
+	  NSUInteger	i;
+
+	  r = &rasters[0];
+	  for (i = 1; i < rasterCount; i++)
+	    {
+	      if (rasters[i].stamp < r->stamp)
+		r = &rasters[i];
+	    }
+	}
+      r->digest = digest;
+      r->length = length;
+      r->resolution = res;
+      r->size = size;
+    }
+  ASSIGN(r->bitmap, bitmap);
+  r->stamp = ++rasterClock;
+}
+
 @implementation GSGhostscriptImageRep 
 
++ (void) initialize
+{
+  if (self == [GSGhostscriptImageRep class])
+    {
+      NSUserDefaults	*defs = [NSUserDefaults standardUserDefaults];
+      NSInteger		limit;
+      CGFloat		res;
+
+      rasterLock = [NSLock new];
+      limit = [defs integerForKey: @"GSGhostscriptRasterCacheSize"];
+      if (limit > 0)
+	{
+	  rasterLimit = MIN(limit, 256);
+	}
+      res = [defs floatForKey: @"GSGhostscriptMaxResolution"];
+      if (res >= 72.0)
+	{
+	  maxResolution = res;
+	}
+      asynchronous
+	= [defs boolForKey: @"GSGhostscriptAsynchronousRasterization"];
+    }
+}
+
++ (void) setRasterizesAsynchronously: (BOOL)flag
+{
+  asynchronous = flag;
+}
+
++ (BOOL) rasterizesAsynchronously
+{
+  return asynchronous;
+}
+
 + (BOOL) canInitWithData: (NSData *)data
 {
   char buf[4];
@@ -248,18 +409,39 @@
 - (id) initWithData: (NSData *)psData
 {
   NSData *pngData;
+  GSRaster *r;
   
   ASSIGN(_psData, psData);
+  _digest = digestOfData(_psData);
 
-  pngData = [self _pngWithGhostscriptData: _psData atResolution: 72.0];
-
-  if (pngData == nil)
+  [rasterLock lock];
+  r = findRaster(_digest, [_psData length], 72.0, 0, NSZeroSize);
+  if (r != 0)
     {
-      [self release];
-      return nil;
+      ASSIGN(_bitmap, r->bitmap);
     }
+  [rasterLock unlock];
+
+  if (_bitmap == nil)
+    {
+      pngData = [self _pngWithGhostscriptData: _psData atResolution: 72.0];
 
-  ASSIGN(_bitmap, [NSBitmapImageRep imageRepWithData: pngData]);
+      if (pngData == nil)
+	{
+	  [self release];
+	  return nil;
+	}
+
+      ASSIGN(_bitmap, [NSBitmapImageRep imageRepWithData: pngData]);
+      if (_bitmap == nil)
+	{
+	  [self release];
+	  return nil;
+	}
+      [rasterLock lock];
+      addRaster(_digest, [_psData length], 72.0, [_bitmap size], _bitmap);
+      [rasterLock unlock];
+    }
  
   [self setSize: [_bitmap size]];
   [self setAlpha: [_bitmap hasAlpha]];
@@ -271,16 +453,128 @@
   return self;
 }
 
+- (void) dealloc
+{
+  RELEASE(_bitmap);
+  RELEASE(_psData);
+  [super dealloc];
+}
+
 // Drawing the Image 
+
+/* The resolution the rep has to be rasterized at to be drawn sharp in
+ * the current context, rounded up to a multiple of 36dpi so that slight
+ * changes of scale reuse the same raster.
+ */
+- (CGFloat) _deviceResolution
+{
+  NSAffineTransform *ctm = GSCurrentCTM(GSCurrentContext());
+  NSSize unit = [ctm transformSize: NSMakeSize(1.0, 1.0)];
+  CGFloat scale = MAX(fabs(unit.width), fabs(unit.height));
+  CGFloat res = ceil(scale * 2.0) * 36.0;
+
+  return MAX(72.0, MIN(res, maxResolution));
+}
+
+- (NSBitmapImageRep *) _rasterAtResolution: (CGFloat)res
+{
+  NSData *pngData = [self _pngWithGhostscriptData: _psData atResolution: res];
+  NSBitmapImageRep *bitmap = nil;
+
+  if (pngData != nil)
+    {
+      bitmap = [NSBitmapImageRep imageRepWithData: pngData];
+      [bitmap setSize: _size];
+    }
+  return bitmap;
+}
+
+- (void) _rasterizeInBackground: (NSNumber *)res
+{
+  CREATE_AUTORELEASE_POOL(pool);
+  NSBitmapImageRep *bitmap = [self _rasterAtResolution: [res doubleValue]];
+  NSArray *result = nil;
+
+  if (bitmap != nil)
+    {
+      result = [NSArray arrayWithObjects: res,
+	[NSValue valueWithSize: _size], bitmap, nil];
+    }
+  [self performSelectorOnMainThread: @selector(_didRasterize:)
+			 withObject: result
+		      waitUntilDone: NO];
+  DESTROY(pool);
+}
+
+- (void) _didRasterize: (NSArray *)result
+{
+  _rasterizing = NO;
+  if (result != nil)
+    {
+      [rasterLock lock];
+      addRaster(_digest, [_psData length],
+	[[result objectAtIndex: 0] doubleValue],
+	[[result objectAtIndex: 1] sizeValue],
+	[result objectAtIndex: 2]);
+      [rasterLock unlock];
+      [[NSNotificationCenter defaultCenter]
+	postNotificationName: GSGhostscriptImageRepDidRasterizeNotification
+		      object: self];
+    }
+}
+
 - (BOOL) draw
 {
-  if (_bitmap != nil)
+  NSBitmapImageRep *bitmap = nil;
+  NSUInteger length = [_psData length];
+  CGFloat res;
+  GSRaster *r;
+
+  if (_bitmap == nil)
     {
-      // FIXME: Re-cache at a higher resolution if needed
+      return NO;
+    }
 
-      return [_bitmap draw];
+  res = [self _deviceResolution];
+  [rasterLock lock];
+  r = findRaster(_digest, length, res, 0, _size);
+  if (r == 0 && asynchronous)
+    {
+      r = findRaster(_digest, length, 0, res, _size);
+      if (_rasterizing == NO)
+	{
+	  _rasterizing = YES;
+	  [NSThread detachNewThreadSelector: @selector(_rasterizeInBackground:)
+				   toTarget: self
+				 withObject: [NSNumber numberWithDouble: res]];
+	}
+    }
+  if (r != 0)
+    {
+      bitmap = AUTORELEASE(RETAIN(r->bitmap));
+    }
+  [rasterLock unlock];
+
+  if (bitmap == nil && !asynchronous)
+    {
+      bitmap = [self _rasterAtResolution: res];
+      if (bitmap != nil)
+	{
+	  [rasterLock lock];
+	  addRaster(_digest, length, res, _size, bitmap);
+	  [rasterLock unlock];
+	}
+    }
+  if (bitmap == nil)
+    {
+      bitmap = _bitmap;
+    }
+  if (!NSEqualSizes([bitmap size], _size))
+    {
+      /* The raster from initialisation may be drawn at another size.  */
+      return [bitmap drawInRect: NSMakeRect(0, 0, _size.width, _size.height)];
     }
-  return NO;
+  return [bitmap draw];
 }
 
 // NSCopying protocol
@@ -290,6 +584,7 @@
 
   copy->_psData = [_psData copyWithZone: zone];
   copy->_bitmap = [_bitmap copyWithZone: zone];
+  copy->_rasterizing = NO;
 
   return copy;
 }
@@ -108,10 +108,13 @@
 	  if (unarchiver != nil)
 	    {
 	      id obj;
+	      NSTimeInterval t;
 	      
 	      NSDebugLog(@"Invoking unarchiver");
 	      [unarchiver setObjectZone: zone];
+	      t = GSModelLoadProfileBegin();
 	      obj = [unarchiver decodeObject];
+	      GSModelLoadProfileEndStep(t, @"decode");
 	      if (obj != nil)
 		{
 		  if ([obj isKindOfClass: [GSNibContainer class]])
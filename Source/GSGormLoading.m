@@ -46,6 +46,7 @@
 #import "AppKit/NSView.h"
 #import "AppKit/NSWindow.h"
 #import "GNUstepGUI/GSGormLoading.h"
+#import "GNUstepGUI/GSModelLoaderFactory.h"
 #import "NSDocumentFrameworkPrivate.h"
 
 static const int currentVersion = 1; // GSNibItem version number...
@@ -139,6 +140,7 @@ static NSString *GSInternalNibItemAddedNotification = @"_GSInternalNibItemAddedN
       NSMenu		*menu;
       NSMutableArray    *topObjects; 
       id                 obj;
+      NSTimeInterval     step;
 
       // Add these objects with there old names as the code expects them
       context = AUTORELEASE([context mutableCopyWithZone: [context zone]]);
@@ -158,9 +160,11 @@ static NSString *GSInternalNibItemAddedNotification = @"_GSInternalNibItemAddedN
        *	with the corresponding values from the name table
        *	before telling the connections to establish themselves.
        */
+      step = GSModelLoadProfileBegin();
       enumerator = [connections objectEnumerator];
       while ((connection = [enumerator nextObject]) != nil)
 	{
+	  NSTimeInterval t = GSModelLoadProfileBegin();
 	  id	val;
 
 	  val = [nameTable objectForKey: [connection source]];
@@ -168,7 +172,9 @@ static NSString *GSInternalNibItemAddedNotification = @"_GSInternalNibItemAddedN
 	  val = [nameTable objectForKey: [connection destination]];
 	  [connection setDestination: val];
 	  [connection establishConnection];
+	  GSModelLoadProfileEnd(t, @"connect", connection);
 	}
+      GSModelLoadProfileEndStep(step, @"connect");
 
       /*
        * See if there is a main menu to be set.  Report #4815, mainMenu 
@@ -231,6 +237,7 @@ static NSString *GSInternalNibItemAddedNotification = @"_GSInternalNibItemAddedN
        * Now tell all the objects that they have been loaded from
        * a nib.
        */
+      step = GSModelLoadProfileBegin();
       enumerator = [nameTable keyEnumerator];
       while ((key = [enumerator nextObject]) != nil)
 	{
@@ -247,7 +254,10 @@ static NSString *GSInternalNibItemAddedNotification = @"_GSInternalNibItemAddedN
 		  // send the awake message, if it responds...
 		  if ([o respondsToSelector: @selector(awakeFromNib)])
 		    {
+		      NSTimeInterval t = GSModelLoadProfileBegin();
+
 		      [o awakeFromNib];
+		      GSModelLoadProfileEnd(t, @"awake", o);
 		    }
 
 		  /*
@@ -279,6 +289,7 @@ static NSString *GSInternalNibItemAddedNotification = @"_GSInternalNibItemAddedN
 		}
 	    }
 	}
+      GSModelLoadProfileEndStep(step, @"awake");
       
       /*
        * See if there are objects that should be made visible.
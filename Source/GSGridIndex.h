@@ -0,0 +1,82 @@
+/*                                                    -*-objc-*-
+   GSGridIndex.h
+
+   A uniform grid of rectangles for finding those near a point
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of the GNUstep GUI Library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; see the file COPYING.LIB.
+   If not, see <http://www.gnu.org/licenses/> or write to the
+   Free Software Foundation, 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef _GS_GRID_INDEX_H
+#define _GS_GRID_INDEX_H
+
+#import <Foundation/NSGeometry.h>
+
+/*
+ * A uniform grid over an area, used to find the rectangles which may
+ * contain a point without looking at all of them.  The rectangles are
+ * numbered 0 to count-1 by the caller, and each cell holds the ascending
+ * numbers of the rectangles meeting it.  Rectangles and points beyond
+ * the area are clamped to its edge cells, so a lookup never misses a
+ * rectangle containing the point, edges included.  Rectangles added as
+ * inexact are kept on a list of their own which the caller searches
+ * together with the cell under the point.
+ */
+typedef struct {
+  NSUInteger count;
+  NSUInteger capacity;
+  NSUInteger *items;
+} GSGridCell;
+
+typedef struct {
+  NSUInteger count;
+  NSUInteger *ranges;
+  NSUInteger columns;
+  NSUInteger rows;
+  NSRect area;
+  CGFloat cellWidth;
+  CGFloat cellHeight;
+  GSGridCell *cells;
+  GSGridCell always;
+} GSGridIndex;
+
+/* Makes an empty grid for count rectangles over area, aiming at a
+   couple of rectangles per cell.  */
+extern GSGridIndex *GSGridIndexCreate(NSUInteger count, NSRect area);
+extern void GSGridIndexFree(GSGridIndex *idx);
+
+/* Adds rectangle item with the given frame to the cells it meets, or to
+   the list of inexact rectangles if exact is NO.  */
+extern void GSGridIndexAdd(GSGridIndex *idx, NSUInteger item,
+			   NSRect frame, BOOL exact);
+/* Takes rectangle item out of the cells it was added to.  */
+extern void GSGridIndexRemove(GSGridIndex *idx, NSUInteger item);
+
+extern NSUInteger GSGridIndexColumn(GSGridIndex *idx, CGFloat x);
+extern NSUInteger GSGridIndexRow(GSGridIndex *idx, CGFloat y);
+extern GSGridCell *GSGridIndexCellAtPoint(GSGridIndex *idx, NSPoint p);
+
+/* Returns the highest item not yet visited on either of two cells, where
+   *ia and *ib are the numbers of items of a and b left to visit, or
+   NSNotFound when both are used up.  */
+extern NSUInteger GSGridIndexNext(GSGridCell *a, NSUInteger *ia,
+				  GSGridCell *b, NSUInteger *ib);
+
+#endif /* _GS_GRID_INDEX_H */
@@ -0,0 +1,220 @@
+/*
+   GSGridIndex.m
+
+   A uniform grid of rectangles for finding those near a point
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of the GNUstep GUI Library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; see the file COPYING.LIB.
+   If not, see <http://www.gnu.org/licenses/> or write to the
+   Free Software Foundation, 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#import "config.h"
+#include <math.h>
+#include <string.h>
+#import <Foundation/NSZone.h>
+#import "GSGridIndex.h"
+
+#define MAX_GRID_CELLS 64
+
+static void
+grid_cell_insert(GSGridCell *cell, NSUInteger item)
+{
+  NSUInteger i = cell->count;
+
+  if (cell->count == cell->capacity)
+    {
+      cell->capacity = (cell->capacity == 0) ? 4 : cell->capacity * 2;
+      cell->items = NSZoneRealloc(NSDefaultMallocZone(), cell->items,
+				  cell->capacity * sizeof(NSUInteger));
+    }
+  while (i > 0 && cell->items[i - 1] > item)
+    {
+      cell->items[i] = cell->items[i - 1];
+      i--;
+    }
+  cell->items[i] = item;
+  cell->count++;
+}
+
+static void
+grid_cell_remove(GSGridCell *cell, NSUInteger item)
+{
+  NSUInteger i;
+
+  for (i = 0; i < cell->count; i++)
+    {
+      if (cell->items[i] == item)
+	{
+	  cell->count--;
+	  memmove(cell->items + i, cell->items + i + 1,
+		  (cell->count - i) * sizeof(NSUInteger));
+	  return;
+	}
+    }
+}
+
+NSUInteger
+GSGridIndexColumn(GSGridIndex *idx, CGFloat x)
+{
+  CGFloat c = floor((x - NSMinX(idx->area)) / idx->cellWidth);
+
+  if (!(c > 0))
+    return 0;
+  if (c >= idx->columns)
+    return idx->columns - 1;
+  return (NSUInteger)c;
+}
+
+NSUInteger
+GSGridIndexRow(GSGridIndex *idx, CGFloat y)
+{
+  CGFloat r = floor((y - NSMinY(idx->area)) / idx->cellHeight);
+
+  if (!(r > 0))
+    return 0;
+  if (r >= idx->rows)
+    return idx->rows - 1;
+  return (NSUInteger)r;
+}
+
+GSGridCell *
+GSGridIndexCellAtPoint(GSGridIndex *idx, NSPoint p)
+{
+  return &idx->cells[GSGridIndexRow(idx, p.y) * idx->columns
+    + GSGridIndexColumn(idx, p.x)];
+}
+
+void
+GSGridIndexAdd(GSGridIndex *idx, NSUInteger item, NSRect frame, BOOL exact)
+{
+  NSUInteger *range = idx->ranges + 4 * item;
+  NSUInteger c, r;
+
+  if (exact == NO)
+    {
+      range[0] = NSNotFound;
+      grid_cell_insert(&idx->always, item);
+      return;
+    }
+  range[0] = GSGridIndexColumn(idx, NSMinX(frame));
+  range[1] = GSGridIndexColumn(idx, NSMaxX(frame));
+  range[2] = GSGridIndexRow(idx, NSMinY(frame));
+  range[3] = GSGridIndexRow(idx, NSMaxY(frame));
+  for (r = range[2]; r <= range[3]; r++)
+    {
+      for (c = range[0]; c <= range[1]; c++)
+	{
+	  grid_cell_insert(&idx->cells[r * idx->columns + c], item);
+	}
+    }
+}
+
+void
+GSGridIndexRemove(GSGridIndex *idx, NSUInteger item)
+{
+  NSUInteger *range = idx->ranges + 4 * item;
+  NSUInteger c, r;
+
+  if (range[0] == NSNotFound)
+    {
+      grid_cell_remove(&idx->always, item);
+      return;
+    }
+  for (r = range[2]; r <= range[3]; r++)
+    {
+      for (c = range[0]; c <= range[1]; c++)
+	{
+	  grid_cell_remove(&idx->cells[r * idx->columns + c], item);
+	}
+    }
+}
+
+GSGridIndex *
+GSGridIndexCreate(NSUInteger count, NSRect area)
+{
+  GSGridIndex *idx;
+  CGFloat cells = MAX(count / 2, 1);
+  CGFloat columns = 1, rows = 1;
+
+  if (NSWidth(area) > 0 && NSHeight(area) > 0)
+    {
+      columns = floor(sqrt(cells * NSWidth(area) / NSHeight(area)) + 0.5);
+      columns = MIN(MAX(columns, 1), MAX_GRID_CELLS);
+      rows = floor(cells / columns + 0.5);
+      rows = MIN(MAX(rows, 1), MAX_GRID_CELLS);
+    }
+  else if (NSWidth(area) > 0)
+    {
+      columns = MIN(cells, MAX_GRID_CELLS);
+    }
+  else if (NSHeight(area) > 0)
+    {
+      rows = MIN(cells, MAX_GRID_CELLS);
+    }
+
+  idx = NSZoneCalloc(NSDefaultMallocZone(), 1, sizeof(GSGridIndex));
+  idx->count = count;
+  idx->ranges = NSZoneMalloc(NSDefaultMallocZone(),
+			     4 * count * sizeof(NSUInteger));
+  idx->columns = (NSUInteger)columns;
+  idx->rows = (NSUInteger)rows;
+  idx->area = area;
+  idx->cellWidth = (NSWidth(area) > 0) ? NSWidth(area) / columns : 1;
+  idx->cellHeight = (NSHeight(area) > 0) ? NSHeight(area) / rows : 1;
+  idx->cells = NSZoneCalloc(NSDefaultMallocZone(), idx->columns * idx->rows,
+			    sizeof(GSGridCell));
+  return idx;
+}
+
+void
+GSGridIndexFree(GSGridIndex *idx)
+{
+  NSUInteger i;
+
+  if (idx == NULL)
+    return;
+  for (i = 0; i < idx->columns * idx->rows; i++)
+    {
+      if (idx->cells[i].items != NULL)
+	NSZoneFree(NSDefaultMallocZone(), idx->cells[i].items);
+    }
+  if (idx->always.items != NULL)
+    NSZoneFree(NSDefaultMallocZone(), idx->always.items);
+  NSZoneFree(NSDefaultMallocZone(), idx->cells);
+  NSZoneFree(NSDefaultMallocZone(), idx->ranges);
+  NSZoneFree(NSDefaultMallocZone(), idx);
+}
+
+NSUInteger
+GSGridIndexNext(GSGridCell *a, NSUInteger *ia,
+		     GSGridCell *b, NSUInteger *ib)
+{
+  NSUInteger x = (*ia > 0) ? a->items[*ia - 1] : NSNotFound;
+  NSUInteger y = (*ib > 0) ? b->items[*ib - 1] : NSNotFound;
+
+  if (x == NSNotFound && y == NSNotFound)
+    return NSNotFound;
+  if (y == NSNotFound || (x != NSNotFound && x > y))
+    {
+      (*ia)--;
+      return x;
+    }
+  (*ib)--;
+  return y;
+}
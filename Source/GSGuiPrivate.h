@@ -31,9 +31,13 @@
 #define _GNUstep_H_GSGuiPrivate
 
 #import <Foundation/NSBundle.h>
+#import "AppKit/NSEvent.h"
 #include "GNUstepBase/GSConfig.h"
 #include <math.h>
 
+@class NSView;
+@class NSWindow;
+
 /*
  * Return the gnustep-gui bundle used to load gnustep-gui resources.
  * Should be only used inside the gnustep-gui library.  Implemented
@@ -83,6 +87,45 @@ static inline NSString *GSGuiLocalizedString (NSString *key, NSString *comment)
  * GSRoundTowardsInfinity(0.1) == 0.0
  * GSRoundTowardsInfinity(-2.5) == -2.0
  */
+/*
+ * Launch timeline, recorded when the GSLaunchTimeline user default names
+ * a file.  Begin and end calls must nest.  The timeline is written to the
+ * file as trace event JSON once the application has finished launching,
+ * and later calls do nothing.
+ */
+void GSLaunchTimelineBegin(NSString *name);
+void GSLaunchTimelineEnd(NSString *name);
+void GSLaunchTimelineWrite(void);
+
+/*
+ * Input latency, recorded when the GSRecordInputLatency user default is set
+ * or +[NSApplication setRecordsInputLatency:] turns it on.  -sendEvent:
+ * tags each key, mouse button, drag and scroll event with the time it
+ * arrived in the window it goes to, with GSWindowTagInputEvent() in
+ * Source/NSWindow.m.  The next flush of that window hands the time since
+ * then to GSRecordInputLatency() in Source/NSApplication.m, which keeps
+ * the histograms behind -inputLatencyStatistics.
+ */
+BOOL GSRecordsInputLatency(void);
+void GSRecordInputLatency(NSEventType type, NSTimeInterval seconds);
+void GSWindowTagInputEvent(NSWindow *window, NSEventType type,
+                           NSTimeInterval arrival);
+
+/*
+ * The frame clock of autodisplay, implemented in Source/NSWindow.m.
+ * GSFrameInterval() returns the time between display passes, 0 if every
+ * run loop pass displays.  GSDisplayFrame() displays the windows that
+ * need it at once.
+ */
+NSTimeInterval GSFrameInterval(void);
+void GSDisplayFrame(void);
+
+/*
+ * Drops the pages a print operation remembered for a view, which is
+ * about to go away.
+ */
+void GSPrintForgetPagination(NSView *view);
+
 static inline CGFloat GSRoundTowardsInfinity(CGFloat x)
 {
   return floor(x + 0.5);
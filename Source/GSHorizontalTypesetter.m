@@ -165,6 +165,7 @@ the last time or not, we wouldn't need to clear the cache every time */
       cache_length -= delta;
       memmove(cache, &cache[delta], sizeof(glyph_cache_t) * cache_length);
       cache_base = glyph;
+      cache_hits += cache_length;
       return;
     }
 
@@ -204,6 +205,7 @@ the last time or not, we wouldn't need to clear the cache every time */
 -(void) _cacheGlyphs: (NSUInteger)new_length
 {
   glyph_cache_t *g;
+  NSUInteger old_length = cache_length;
   BOOL valid;
 
   if (cache_size < new_length)
@@ -254,6 +256,7 @@ the last time or not, we wouldn't need to clear the cache every time */
       // FIXME: This assumes the layout manager implements this GNUstep extension
       g->size = [curLayoutManager advancementForGlyphAtIndex: cache_base + cache_length];
     }
+  cache_misses += cache_length - old_length;
 }
 
 
@@ -421,7 +424,7 @@ For bigger values the width gets ignored.
   NSRect r0, r;
   NSSize shift;
   NSInteger i;
-  NSUInteger g, g2, first;
+  NSUInteger g, first;
   CGFloat container_height;
   /*
   Ask the layout manager for soft-invalidated layout for the current
@@ -439,35 +442,21 @@ For bigger values the width gets ignored.
     return NO;
 
   /*
-  We can shift the rects and still have things fit. Find all the line
-  frags in the line and shift them.
+  We can shift the rects and still have things fit. Find all the following
+  line frags that only need to be shifted, in one go, so unchanged text
+  after an edit is moved rather than typeset again. If there's a gap in
+  soft invalidated information, we stop there and fill it in by typesetting.
   */
   shift.width = 0;
   shift.height = curPoint.y - r0.origin.y;
-  i = 1;
-  curPoint.y = NSMaxY(r0) + shift.height;
-  for (; 1; i++)
-    {
-      r = [curLayoutManager _softInvalidateLineFragRect: i
-					     firstGlyph: &first
-					      nextGlyph: &g2
-					inTextContainer: curTextContainer];
-
-      /*
-      If there's a gap in soft invalidated information, we need to
-      fill it in before we can continue.
-      */
-      if (first != g)
-	{
-	  break;
-	}
-
-      if (NSIsEmptyRect(r) || NSMaxY(r) + shift.height > container_height)
-	break;
-
-      g = g2;
-      curPoint.y = NSMaxY(r) + shift.height;
-    }
+  i = [curLayoutManager _softInvalidateNumberOfReusableLineFragsWithShift: shift.height
+								      maxY: container_height
+								  lastRect: &r
+								 nextGlyph: &g
+							   inTextContainer: curTextContainer];
+  if (!i)
+    return NO;
+  curPoint.y = NSMaxY(r) + shift.height;
 
   [curLayoutManager _softInvalidateUseLineFrags: i
 				      withShift: shift
@@ -1238,6 +1227,7 @@ NS_DURING
   curGlyph = glyphIndex;
 
   [self _cacheClear];
+  cache_hits = cache_misses = 0;
 
 
   real_ret = 4;
@@ -1293,6 +1283,8 @@ NS_DURING
    }
 
   *nextGlyphIndex = curGlyph;
+  [curLayoutManager _addGlyphCacheHits: cache_hits
+				misses: cache_misses];
 NS_HANDLER
   NSLog(@"GSHorizontalTypesetter - %@", [localException reason]);
   [lock unlock];
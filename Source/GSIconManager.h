@@ -34,3 +34,9 @@ GSRemoveIcon(NSWindow *window);
 
 NSRect
 GSGetIconFrame(NSWindow *window); 
+
+@class NSCell;
+
+void
+GSDrawIconBase(NSCell *tileCell, NSCell *imageCell, NSRect imageRect,
+  NSSize iconSize);
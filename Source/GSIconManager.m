@@ -22,12 +22,16 @@
    Boston, MA 02110-1301, USA.
 */
 
+#include <string.h>
+
 #import <Foundation/NSConnection.h>
 #import <Foundation/NSUserDefaults.h>
 #import <Foundation/NSProcessInfo.h>
 
 #import <GNUstepGUI/GSDisplayServer.h>
+#import "AppKit/NSCell.h"
 #import "AppKit/NSGraphics.h"
+#import "AppKit/NSImage.h"
 #import "GSIconManager.h"
 
 @protocol GSIconManager
@@ -138,3 +142,82 @@ GSGetIconFrame(NSWindow *window)
 
   return iconRect;
 }
+
+/*
+ * The tile with the image of an application icon or a miniwindow on it
+ * only changes with one of them, so it is composed once into an image
+ * and that image is drawn, with anything which changes more often, like
+ * the title of a miniwindow or the mark of a hidden application, drawn
+ * on top of it.  The last few compositions are kept.
+ */
+#define MAX_ICON_BASES 16
+
+typedef struct {
+  NSImage *tile;
+  NSImage *image;
+  NSRect imageRect;
+  NSSize iconSize;
+  NSImage *composed;
+} GSIconBase;
+
+static GSIconBase iconBases[MAX_ICON_BASES];
+static unsigned numIconBases = 0;
+
+/* Draws the tile of tileCell and the image of imageCell in imageRect at
+   the origin of the focused view, from the composition of the two kept
+   for them and iconSize.  */
+void
+GSDrawIconBase(NSCell *tileCell, NSCell *imageCell, NSRect imageRect,
+  NSSize iconSize)
+{
+  NSImage *tile = [tileCell image];
+  NSImage *image = [imageCell image];
+  GSIconBase base;
+  unsigned i;
+
+  for (i = 0; i < numIconBases; i++)
+    {
+      if (iconBases[i].tile == tile && iconBases[i].image == image
+        && NSEqualRects(iconBases[i].imageRect, imageRect)
+        && NSEqualSizes(iconBases[i].iconSize, iconSize))
+        {
+          break;
+        }
+    }
+
+  if (i < numIconBases)
+    {
+      base = iconBases[i];
+    }
+  else
+    {
+      base.tile = RETAIN(tile);
+      base.image = RETAIN(image);
+      base.imageRect = imageRect;
+      base.iconSize = iconSize;
+      base.composed = [[NSImage alloc] initWithSize: iconSize];
+      [base.composed lockFocus];
+      [tileCell drawWithFrame: NSMakeRect(0, 0, iconSize.width, iconSize.height)
+                       inView: nil];
+      [imageCell drawWithFrame: imageRect inView: nil];
+      [base.composed unlockFocus];
+
+      if (numIconBases == MAX_ICON_BASES)
+        {
+          i = --numIconBases;
+          RELEASE(iconBases[i].tile);
+          RELEASE(iconBases[i].image);
+          RELEASE(iconBases[i].composed);
+        }
+      i = numIconBases++;
+    }
+
+  /* Keep the most recently drawn first.  */
+  memmove(&iconBases[1], &iconBases[0], i * sizeof(GSIconBase));
+  iconBases[0] = base;
+
+  [base.composed drawInRect: NSMakeRect(0, 0, iconSize.width, iconSize.height)
+                   fromRect: NSZeroRect
+                  operation: NSCompositeSourceOver
+                   fraction: 1.0];
+}
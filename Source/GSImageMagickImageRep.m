@@ -34,6 +34,7 @@
 #import <Foundation/NSData.h>
 #import <Foundation/NSTask.h>
 #import <Foundation/NSProcessInfo.h>
+#import <Foundation/NSUserDefaults.h>
 #import <GNUstepBase/NSDebug+GNUstepBase.h>
 #import "AppKit/NSBitmapImageRep.h"
 #import "AppKit/NSGraphics.h"
@@ -43,15 +44,39 @@
 
 #if HAVE_IMAGEMAGICK
 
+#include <math.h>
+#include <stdio.h>
 #include <magick/MagickCore.h>
 
+/* Sets the ImageMagick limit of resource from the user default key, in
+   units of unit, if the default is set to a positive number.  */
+static void
+setResourceLimit(ResourceType resource, NSString *key, MagickSizeType unit)
+{
+  NSInteger value = [[NSUserDefaults standardUserDefaults] integerForKey: key];
+
+  if (value > 0)
+    {
+      SetMagickResourceLimit(resource, (MagickSizeType)value * unit);
+    }
+}
+
 @implementation GSImageMagickImageRep 
 
+/* The GSImageMagickThreads default sets the number of threads ImageMagick
+   decodes with, and GSImageMagickMemoryLimit, GSImageMagickMapLimit and
+   GSImageMagickDiskLimit (in megabytes) the pixel cache it may keep in
+   memory, in mapped files and on disk before failing.  Unset they leave
+   the limits to ImageMagick and its environment variables.  */
 + (void) initialize
 {
   NSArray *argv = [[NSProcessInfo processInfo] arguments];
 
   MagickCoreGenesis([[argv objectAtIndex: 0] UTF8String], 0);
+  setResourceLimit(ThreadResource, @"GSImageMagickThreads", 1);
+  setResourceLimit(MemoryResource, @"GSImageMagickMemoryLimit", 1024 * 1024);
+  setResourceLimit(MapResource, @"GSImageMagickMapLimit", 1024 * 1024);
+  setResourceLimit(DiskResource, @"GSImageMagickDiskLimit", 1024 * 1024);
 }
 
 // Private methods
@@ -111,18 +136,64 @@
   return bmp;
 }
 
+/* Returns image, or a copy of it shrunk to just cover pixelSize when it
+   is more than twice as wide and high.  */
+static Image *
+shrinkImage(Image *image, NSSize pixelSize, ExceptionInfo *exception)
+{
+  double scale;
+  Image *thumbnail;
+
+  if (pixelSize.width <= 0 || pixelSize.height <= 0
+    || image->columns == 0 || image->rows == 0)
+    {
+      return image;
+    }
+  scale = MAX(pixelSize.width / image->columns,
+	      pixelSize.height / image->rows);
+  if (scale > 0.5)
+    {
+      return image;
+    }
+  thumbnail = ThumbnailImage(image, ceil(image->columns * scale),
+			     ceil(image->rows * scale), exception);
+  return (thumbnail != NULL) ? thumbnail : image;
+}
+
 + (NSArray*) imageRepsWithData: (NSData *)data allImages: (BOOL)allImages
+{
+  return [self imageRepsWithData: data
+		       allImages: allImages
+		       pixelSize: NSZeroSize];
+}
+
+/* Like +imageRepsWithData:allImages:, but when pixelSize is not zero the
+   decoders which can (such as the JPEG one) are asked to decode at a size
+   near to it, and images still much larger are shrunk to it.  */
++ (NSArray*) imageRepsWithData: (NSData *)data
+		     allImages: (BOOL)allImages
+		     pixelSize: (NSSize)pixelSize
 {
   NSMutableArray *reps = [NSMutableArray array];
 
   ExceptionInfo *exception = AcquireExceptionInfo();
   ImageInfo *imageinfo = CloneImageInfo(NULL);
   Image *images, *image;
+  BOOL scaled = (pixelSize.width > 0 && pixelSize.height > 0);
   
   // Set the background color to transparent
   // (otherwise SVG's are rendered against a white background by default)
   QueryColorDatabase("none", &imageinfo->background_color, exception);
 
+  if (scaled)
+    {
+      char size[64];
+
+      snprintf(size, sizeof(size), "%ldx%ld",
+	(long)ceil(pixelSize.width), (long)ceil(pixelSize.height));
+      SetImageOption(imageinfo, "jpeg:size", size);
+    }
+
   images = BlobToImage(imageinfo, [data bytes], [data length], exception);
 
   if (exception->severity != UndefinedException)
@@ -132,7 +203,22 @@
   
   for (image = images; image != NULL; image = image->next)
     {
-      NSBitmapImageRep *bmp = [[self class] imageRepWithImageMagickImage: image];
+      NSBitmapImageRep *bmp;
+
+      if (scaled)
+	{
+	  Image *small = shrinkImage(image, pixelSize, exception);
+
+	  bmp = [[self class] imageRepWithImageMagickImage: small];
+	  if (small != image)
+	    {
+	      DestroyImage(small);
+	    }
+	}
+      else
+	{
+	  bmp = [[self class] imageRepWithImageMagickImage: image];
+	}
       if (bmp != nil)
 	{
 	  [reps addObject: bmp];
@@ -256,6 +342,24 @@
   return [self imageRepsWithData: data allImages: YES];
 }
 
+- (id) initWithData: (NSData *)data forPixelSize: (NSSize)pixelSize
+{
+  NSArray *reps = [[self class] imageRepsWithData: data
+					allImages: NO
+					pixelSize: pixelSize];
+
+  [self release];
+
+  if ([reps count] != 0)
+    {
+      return [[reps objectAtIndex: 0] retain];
+    }
+  else
+    {
+      return nil;
+    }
+}
+
 @end
 
 #endif
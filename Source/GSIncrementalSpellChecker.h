@@ -0,0 +1,87 @@
+/*                                                    -*-objc-*-
+   GSIncrementalSpellChecker.h
+
+   The private continuous spell checking helper for NSTextView
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of the GNUstep GUI Library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; see the file COPYING.LIB.
+   If not, see <http://www.gnu.org/licenses/> or write to the
+   Free Software Foundation, 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef _GS_INCREMENTAL_SPELL_CHECKER_H
+#define _GS_INCREMENTAL_SPELL_CHECKER_H
+
+#import <Foundation/NSObject.h>
+#import <Foundation/NSRange.h>
+#import "AppKit/NSSpellChecker.h"
+
+@class NSArray;
+@class NSMutableArray;
+@class NSMutableIndexSet;
+@class NSNotification;
+@class NSTextView;
+
+/*
+ * Keeps track of which characters of a text view's text have a valid
+ * spelling state, and checks the others in batches on a background
+ * thread. The results are applied as NSSpellingStateAttributeName
+ * temporary attributes on the main thread.
+ *
+ * Edits are tracked through NSTextStorageDidProcessEditingNotification,
+ * so only the words touched by an edit lose their state, and answers for
+ * text that was edited while the request was in flight are dropped.
+ */
+@interface GSIncrementalSpellChecker : NSObject
+{
+  NSTextView *textView;		/* Not retained. */
+  NSMutableIndexSet *checked;	/* Characters with a valid spelling state. */
+  NSMutableIndexSet *queued;	/* Characters with a request in flight. */
+  NSMutableIndexSet *unmarked;	/* Characters whose marks must be removed. */
+  NSMutableArray *requests;	/* Requests in flight. */
+}
+
+- (id) initWithTextView: (NSTextView *)aTextView;
+
+/* Stops checking for the text view; it must not be used afterwards. */
+- (void) detach;
+
+/* Forgets all spelling state and drops the requests in flight. */
+- (void) reset;
+
+/* Removes the marks of words changed by edits since the last call. */
+- (void) removeInvalidMarks;
+
+/* Queues requests for the characters in aRange without spelling state. */
+- (void) checkRange: (NSRange)aRange;
+
+@end
+
+@interface NSSpellChecker (GSIncrementalSpellChecker)
+/* Returns the spell server proxy, making it usable from other threads. */
+- (id) _serverProxyForThreads;
+/* Returns the ranges of all misspelled words in string as NSValues.
+   This does not touch the spell checker and may be called from any
+   thread. */
++ (NSArray *) _misspelledWordRangesInString: (NSString *)string
+				   language: (NSString *)language
+			       ignoredWords: (NSArray *)ignoredWords
+				     server: (id)proxy;
+@end
+
+#endif // _GS_INCREMENTAL_SPELL_CHECKER_H
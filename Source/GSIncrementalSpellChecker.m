@@ -0,0 +1,460 @@
+/*
+   GSIncrementalSpellChecker.m
+
+   The private continuous spell checking helper for NSTextView
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of the GNUstep GUI Library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; see the file COPYING.LIB.
+   If not, see <http://www.gnu.org/licenses/> or write to the
+   Free Software Foundation, 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#import "config.h"
+#import <Foundation/NSArray.h>
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSCharacterSet.h>
+#import <Foundation/NSIndexSet.h>
+#import <Foundation/NSLock.h>
+#import <Foundation/NSNotification.h>
+#import <Foundation/NSString.h>
+#import <Foundation/NSThread.h>
+#import <Foundation/NSValue.h>
+#import "AppKit/NSAttributedString.h"
+#import "AppKit/NSLayoutManager.h"
+#import "AppKit/NSTextStorage.h"
+#import "AppKit/NSTextView.h"
+#import "GSIncrementalSpellChecker.h"
+
+/* The largest number of characters sent to the spell server at once. */
+#define BATCH_SIZE 4096
+
+@interface GSIncrementalSpellChecker (Private)
+- (void) _textStorageDidProcessEditing: (NSNotification *)notification;
+- (void) _finishRequest: (id)request;
+@end
+
+/*
+ * A batch of text sent to the spell checking thread. The range is kept
+ * up to date with edits by the checker until the answer arrives.
+ */
+@interface GSSpellCheckRequest : NSObject
+{
+@public
+  GSIncrementalSpellChecker *checker;
+  NSRange range;
+  NSString *string;
+  NSString *language;
+  NSArray *ignoredWords;
+  id server;
+  NSArray *results;
+  BOOL stale;
+}
+@end
+
+@implementation GSSpellCheckRequest
+
+- (void) dealloc
+{
+  RELEASE(checker);
+  RELEASE(string);
+  RELEASE(language);
+  RELEASE(ignoredWords);
+  RELEASE(server);
+  RELEASE(results);
+  [super dealloc];
+}
+
+- (void) deliver
+{
+  [checker _finishRequest: self];
+}
+
+@end
+
+
+static NSMutableArray *queue = nil;
+static NSCondition *queueCondition = nil;
+static NSCharacterSet *boundary = nil;
+
+static NSRange
+wordAlignedRange(NSString *str, NSRange r)
+{
+  NSUInteger length = [str length];
+  NSRange prev, next;
+  NSUInteger start, end;
+
+  prev = [str rangeOfCharacterFromSet: boundary
+			      options: NSBackwardsSearch
+				range: NSMakeRange(0, r.location)];
+  start = (prev.length == 0) ? 0 : NSMaxRange(prev);
+  end = NSMaxRange(r);
+  if (end > length)
+    end = length;
+  next = [str rangeOfCharacterFromSet: boundary
+			      options: 0
+				range: NSMakeRange(end, length - end)];
+  end = (next.length == 0) ? length : next.location;
+
+  return NSMakeRange(start, end - start);
+}
+
+/* Returns the first run of indexes in set at or after index. */
+static NSRange
+nextRangeInSet(NSIndexSet *set, NSUInteger index)
+{
+  NSUInteger start = [set indexGreaterThanOrEqualToIndex: index];
+  NSUInteger low, high;
+
+  if (start == NSNotFound)
+    return NSMakeRange(NSNotFound, 0);
+
+  /* Gallop to find the end of the run, then bisect. */
+  low = 1;
+  high = 2;
+  while ([set containsIndexesInRange: NSMakeRange(start, high)])
+    {
+      low = high;
+      high *= 2;
+    }
+  while (high - low > 1)
+    {
+      NSUInteger mid = low + (high - low) / 2;
+
+      if ([set containsIndexesInRange: NSMakeRange(start, mid)])
+	low = mid;
+      else
+	high = mid;
+    }
+
+  return NSMakeRange(start, low);
+}
+
+@implementation GSIncrementalSpellChecker
+
++ (void) initialize
+{
+  if (self == [GSIncrementalSpellChecker class])
+    {
+      boundary = RETAIN([[NSCharacterSet letterCharacterSet] invertedSet]);
+    }
+}
+
++ (void) _spellCheckingThread: (id)unused
+{
+  while (YES)
+    {
+      CREATE_AUTORELEASE_POOL(pool);
+      GSSpellCheckRequest *request;
+
+      [queueCondition lock];
+      while ([queue count] == 0)
+	{
+	  [queueCondition wait];
+	}
+      request = RETAIN([queue objectAtIndex: 0]);
+      [queue removeObjectAtIndex: 0];
+      [queueCondition unlock];
+
+      /* No need to ask the server about text that has changed already. */
+      if (!request->stale)
+	{
+	  request->results = RETAIN([NSSpellChecker
+	    _misspelledWordRangesInString: request->string
+				 language: request->language
+			     ignoredWords: request->ignoredWords
+				   server: request->server]);
+	}
+      [request performSelectorOnMainThread: @selector(deliver)
+				withObject: nil
+			     waitUntilDone: NO];
+      RELEASE(request);
+      DESTROY(pool);
+    }
+}
+
++ (void) _enqueueRequest: (GSSpellCheckRequest *)request
+{
+  if (queueCondition == nil)
+    {
+      queueCondition = [NSCondition new];
+      queue = [NSMutableArray new];
+      [NSThread detachNewThreadSelector: @selector(_spellCheckingThread:)
+			       toTarget: self
+			     withObject: nil];
+    }
+
+  [queueCondition lock];
+  [queue addObject: request];
+  [queueCondition signal];
+  [queueCondition unlock];
+}
+
+- (id) initWithTextView: (NSTextView *)aTextView
+{
+  if ((self = [super init]) != nil)
+    {
+      textView = aTextView;
+      checked = [NSMutableIndexSet new];
+      queued = [NSMutableIndexSet new];
+      unmarked = [NSMutableIndexSet new];
+      requests = [NSMutableArray new];
+
+      [[NSNotificationCenter defaultCenter]
+	addObserver: self
+	   selector: @selector(_textStorageDidProcessEditing:)
+	       name: NSTextStorageDidProcessEditingNotification
+	     object: nil];
+    }
+  return self;
+}
+
+- (void) dealloc
+{
+  [[NSNotificationCenter defaultCenter] removeObserver: self];
+  RELEASE(checked);
+  RELEASE(queued);
+  RELEASE(unmarked);
+  RELEASE(requests);
+  [super dealloc];
+}
+
+- (void) detach
+{
+  [self reset];
+  [[NSNotificationCenter defaultCenter] removeObserver: self];
+  textView = nil;
+}
+
+- (void) reset
+{
+  NSUInteger i;
+
+  for (i = 0; i < [requests count]; i++)
+    {
+      ((GSSpellCheckRequest *)[requests objectAtIndex: i])->stale = YES;
+    }
+  [requests removeAllObjects];
+  [checked removeAllIndexes];
+  [queued removeAllIndexes];
+  [unmarked removeAllIndexes];
+}
+
+- (void) removeInvalidMarks
+{
+  NSLayoutManager *lm = [textView layoutManager];
+  NSUInteger length = [[textView string] length];
+  NSRange r;
+
+  if (lm == nil)
+    return;
+
+  [unmarked removeIndexesInRange: NSMakeRange(length, NSNotFound - length)];
+  r = nextRangeInSet(unmarked, 0);
+  while (r.location != NSNotFound)
+    {
+      [lm removeTemporaryAttribute: NSSpellingStateAttributeName
+		 forCharacterRange: r];
+      r = nextRangeInSet(unmarked, NSMaxRange(r));
+    }
+  [unmarked removeAllIndexes];
+}
+
+- (void) checkRange: (NSRange)aRange
+{
+  NSString *str = [textView string];
+  NSUInteger length = [str length];
+  NSMutableIndexSet *todo;
+  NSSpellChecker *sp;
+  NSString *language;
+  NSArray *ignored;
+  id server;
+  NSRange r;
+
+  [self removeInvalidMarks];
+
+  if (NSMaxRange(aRange) > length)
+    aRange = NSIntersectionRange(aRange, NSMakeRange(0, length));
+  if (aRange.length == 0)
+    return;
+
+  todo = [NSMutableIndexSet indexSetWithIndexesInRange: aRange];
+  [todo removeIndexes: checked];
+  [todo removeIndexes: queued];
+  if ([todo count] == 0)
+    return;
+
+  sp = [NSSpellChecker sharedSpellChecker];
+  server = [sp _serverProxyForThreads];
+  if (server == nil)
+    return;
+  language = [sp language];
+  ignored = [sp ignoredWordsInSpellDocumentWithTag:
+		  [textView spellCheckerDocumentTag]];
+
+  r = nextRangeInSet(todo, 0);
+  while (r.location != NSNotFound)
+    {
+      NSUInteger next;
+
+      r = wordAlignedRange(str, r);
+      next = NSMaxRange(r);
+      while (r.length > 0)
+	{
+	  GSSpellCheckRequest *request;
+	  NSRange batch = r;
+
+	  /* Split long runs between words. */
+	  if (batch.length > BATCH_SIZE)
+	    {
+	      NSRange b = [str rangeOfCharacterFromSet: boundary
+					       options: NSBackwardsSearch
+						 range: NSMakeRange(r.location,
+								    BATCH_SIZE)];
+
+	      if (b.length > 0 && b.location > r.location)
+		batch.length = NSMaxRange(b) - r.location;
+	      else
+		batch.length = BATCH_SIZE;
+	    }
+
+	  request = [GSSpellCheckRequest new];
+	  request->checker = RETAIN(self);
+	  request->range = batch;
+	  request->string = [[str substringWithRange: batch] copy];
+	  ASSIGN(request->language, language);
+	  ASSIGN(request->ignoredWords, ignored);
+	  ASSIGN(request->server, server);
+	  [requests addObject: request];
+	  [queued addIndexesInRange: batch];
+	  [GSIncrementalSpellChecker _enqueueRequest: request];
+	  RELEASE(request);
+
+	  r.location += batch.length;
+	  r.length -= batch.length;
+	}
+      r = nextRangeInSet(todo, next);
+    }
+}
+
+@end
+
+@implementation GSIncrementalSpellChecker (Private)
+
+- (void) _textStorageDidProcessEditing: (NSNotification *)notification
+{
+  NSTextStorage *ts = [notification object];
+  NSRange r, word;
+  NSInteger delta;
+  NSUInteger oldEnd;
+  NSUInteger i;
+  NSMutableIndexSet *sets[3];
+
+  if (ts != [textView textStorage]
+      || ([ts editedMask] & NSTextStorageEditedCharacters) == 0)
+    return;
+
+  r = [ts editedRange];
+  delta = [ts changeInLength];
+  oldEnd = NSMaxRange(r) - delta;
+
+  /* Move the state of the text after the edit along with it. */
+  sets[0] = checked;
+  sets[1] = queued;
+  sets[2] = unmarked;
+  for (i = 0; i < 3; i++)
+    {
+      [sets[i] removeIndexesInRange:
+	NSMakeRange(r.location, oldEnd - r.location)];
+      [sets[i] shiftIndexesStartingAtIndex: oldEnd by: delta];
+    }
+
+  /*
+  The words touched by the edit must be checked again. The marks for them
+  can't be removed here, since the layout manager hasn't been told about
+  the edit yet, so that is done by -removeInvalidMarks.
+  */
+  word = wordAlignedRange([ts string], r);
+  [checked removeIndexesInRange: word];
+  [queued removeIndexesInRange: word];
+  [unmarked addIndexesInRange: word];
+
+  i = 0;
+  while (i < [requests count])
+    {
+      GSSpellCheckRequest *request = [requests objectAtIndex: i];
+      NSUInteger s = request->range.location;
+      NSUInteger e = NSMaxRange(request->range);
+      BOOL overlaps;
+
+      overlaps = (s <= r.location) ? (e > r.location) : (s < oldEnd);
+      if (s >= oldEnd)
+	s += delta;
+      else if (s > r.location)
+	s = r.location;
+      if (e >= oldEnd)
+	e += delta;
+      else if (e > r.location)
+	e = NSMaxRange(r);
+      request->range = NSMakeRange(s, e - s);
+
+      if (overlaps || NSIntersectionRange(request->range, word).length > 0)
+	{
+	  request->stale = YES;
+	  [queued removeIndexesInRange: request->range];
+	  [requests removeObjectAtIndex: i];
+	}
+      else
+	{
+	  i++;
+	}
+    }
+}
+
+- (void) _finishRequest: (id)req
+{
+  GSSpellCheckRequest *request = req;
+  NSLayoutManager *lm = [textView layoutManager];
+  NSRange range = request->range;
+  NSUInteger i;
+
+  if (request->stale || lm == nil)
+    return;
+
+  [requests removeObjectIdenticalTo: request];
+  [queued removeIndexesInRange: range];
+  if (request->results == nil
+      || NSMaxRange(range) > [[textView string] length])
+    return;
+
+  [lm removeTemporaryAttribute: NSSpellingStateAttributeName
+	     forCharacterRange: range];
+  for (i = 0; i < [request->results count]; i++)
+    {
+      NSRange r = [[request->results objectAtIndex: i] rangeValue];
+
+      r.location += range.location;
+      [lm addTemporaryAttribute: NSSpellingStateAttributeName
+			  value: [NSNumber numberWithInteger:
+					     NSSpellingStateSpellingFlag]
+	      forCharacterRange: r];
+    }
+  [checked addIndexesInRange: range];
+  [unmarked removeIndexesInRange: range];
+}
+
+@end
@@ -80,6 +80,16 @@ struct _GSKeyBinding
   
   /* The length of the array of bindings.  */
   int _bindingsCount;
+
+  /* The number of bindings there is room for in the array.  */
+  int _bindingsCapacity;
+
+  /* An open addressed hash table of indexes into the array of
+   * bindings plus one (0 marks an empty slot), keyed on the character
+   * and modifiers of the binding, so keystrokes are looked up without
+   * walking the array.  The number of slots is a power of two.  */
+  int *_slots;
+  int _slotsCount;
 }
 /* Load all the bindings from this dictionary.  The dictionary binds
    keys to actions, as described below under bindKey:toAction:.  The
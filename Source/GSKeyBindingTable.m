@@ -29,6 +29,30 @@
 #import "GSKeyBindingAction.h"
 #import "GSKeyBindingTable.h"
 
+/* Returns the slot holding the binding for character and modifiers,
+   or the empty slot where it would go.  slotsCount must be a power of
+   two larger than the number of bindings.  */
+static inline int
+findSlot(struct _GSKeyBinding *bindings, int *slots, int slotsCount,
+	 unichar character, NSUInteger modifiers)
+{
+  unsigned mask = slotsCount - 1;
+  unsigned s = ((unsigned)character * 2654435761U
+		^ (unsigned)(modifiers >> 16)) & mask;
+
+  while (slots[s] != 0)
+    {
+      struct _GSKeyBinding *b = &bindings[slots[s] - 1];
+
+      if (b->character == character && b->modifiers == modifiers)
+	{
+	  break;
+	}
+      s = (s + 1) & mask;
+    }
+  return s;
+}
+
 @implementation GSKeyBindingTable : NSObject
 
 - (void) loadBindingsFromDictionary: (NSDictionary *)dict
@@ -50,7 +74,8 @@
   GSKeyBindingAction *a = nil;
   GSKeyBindingTable *t = nil;
   BOOL isTable = NO;
-  NSInteger i;
+  int slot;
+  int i;
 
   /* First, try to determine what exactly is key :-) ... it might
      either be a simple string, "Control-f", or an array,
@@ -165,35 +190,38 @@
      to insert into the table.  */
     
   /* Check if there are already some bindings for this keystroke.  */
-  for (i = 0; i < _bindingsCount; i++)
+  slot = 0;
+  if (_slotsCount > 0)
+    {
+      slot = findSlot(_bindings, _slots, _slotsCount, character, modifiers);
+    }
+  if (_slotsCount > 0 && _slots[slot] != 0)
     {
-      if ((_bindings[i].character == character)  
-	  &&  (_bindings[i].modifiers == modifiers))
+      i = _slots[slot] - 1;
+
+      /* Replace/override the existing action with the new one if
+	 it's an action, or load the bindings into a (new or
+	 existing) table if it's a table.  */
+      if (isTable)
 	{
-	  /* Replace/override the existing action with the new one if
-	     it's an action, or load the bindings into a (new or
-	     existing) table if it's a table.  */
-	  if (isTable)
+	  /* If there was already a table, add keybindings to that
+	     table.  */
+	  if (_bindings[i].table != nil)
 	    {
-	      /* If there was already a table, add keybindings to that
-		 table.  */
-	      if (_bindings[i].table != nil)
-		{
-		  t = _bindings[i].table;
-		}
-	      else
-		{
-		  /* Else, create a new one.  */
-		  t = [[GSKeyBindingTable alloc] init];
-		  AUTORELEASE (t);
-		}
-	      [t loadBindingsFromDictionary: (NSDictionary *)action];
+	      t = _bindings[i].table;
 	    }
-
-	  ASSIGN (_bindings[i].action, a);
-	  ASSIGN (_bindings[i].table, t);
-	  return;
+	  else
+	    {
+	      /* Else, create a new one.  */
+	      t = [[GSKeyBindingTable alloc] init];
+	      AUTORELEASE (t);
+	    }
+	  [t loadBindingsFromDictionary: (NSDictionary *)action];
 	}
+
+      ASSIGN (_bindings[i].action, a);
+      ASSIGN (_bindings[i].table, t);
+      return;
     }
 
   /* Ok - new keystroke.  Create the table if needed.  */
@@ -205,17 +233,31 @@
     }
 
   /* Allocate memory for the new binding.  */
-  if (_bindingsCount == 0)
+  if (_bindingsCount == _bindingsCapacity)
     {
-      _bindingsCount = 1;
-      _bindings = malloc (sizeof (struct _GSKeyBinding));
+      _bindingsCapacity = (_bindingsCapacity == 0) ? 8 : 2 * _bindingsCapacity;
+      _bindings = realloc (_bindings, sizeof (struct _GSKeyBinding) 
+				* _bindingsCapacity);
     }
-  else
+  _bindingsCount++;
+
+  /* Keep the hash table at most half full, rehashing every binding
+     when it grows.  */
+  if (2 * _bindingsCount > _slotsCount)
     {
-      _bindingsCount++;
-      _bindings = realloc (_bindings, sizeof (struct _GSKeyBinding) 
-				* _bindingsCount);
+      _slotsCount = (_slotsCount == 0) ? 16 : 2 * _slotsCount;
+      free (_slots);
+      _slots = calloc (_slotsCount, sizeof (int));
+      for (i = 0; i < _bindingsCount - 1; i++)
+	{
+	  _slots[findSlot(_bindings, _slots, _slotsCount,
+			  _bindings[i].character,
+			  _bindings[i].modifiers)] = i + 1;
+	}
+      slot = findSlot(_bindings, _slots, _slotsCount, character, modifiers);
     }
+  _slots[slot] = _bindingsCount;
+
   _bindings[_bindingsCount - 1].character = character;
   _bindings[_bindingsCount - 1].modifiers = modifiers;
 
@@ -232,29 +274,28 @@
        returningActionIn: (GSKeyBindingAction **)action
 		 tableIn: (GSKeyBindingTable **)table
 {
+  int slot;
   int i;
-  
-  for (i = 0; i < _bindingsCount; i++)
+
+  if (_slotsCount == 0)
     {
-      if (_bindings[i].character == character)
-	{
-	  if (_bindings[i].modifiers == flags)
-	    {
-	      if (_bindings[i].action == nil  &&  _bindings[i].table == nil)
-		{
-		  /* Found the keybinding, but it is disabled!  */
-		  return NO;
-		}
-	      else
-		{
-		  *action = _bindings[i].action;
-		  *table = _bindings[i].table;
-		  return YES;
-		}
-	    }
-	}
+      return NO;
+    }
+  slot = findSlot(_bindings, _slots, _slotsCount, character, flags);
+  if (_slots[slot] == 0)
+    {
+      return NO;
+    }
+
+  i = _slots[slot] - 1;
+  if (_bindings[i].action == nil  &&  _bindings[i].table == nil)
+    {
+      /* Found the keybinding, but it is disabled!  */
+      return NO;
     }
-  return NO;
+  *action = _bindings[i].action;
+  *table = _bindings[i].table;
+  return YES;
 }
 
 - (void) dealloc
@@ -267,6 +308,7 @@
       RELEASE (_bindings[i].table);
     }
   free (_bindings);
+  free (_slots);
   [super dealloc];
 }
 
@@ -25,10 +25,14 @@
    Boston, MA 02110-1301, USA.
 */
 
+#import <Foundation/NSArray.h>
 #import <Foundation/NSCharacterSet.h>
+#import <Foundation/NSDate.h>
 #import <Foundation/NSDebug.h>
+#import <Foundation/NSDictionary.h>
 #import <Foundation/NSEnumerator.h>
 #import <Foundation/NSException.h>
+#import <Foundation/NSRunLoop.h>
 #import <Foundation/NSValue.h>
 
 #import "AppKit/NSAttributedString.h"
@@ -41,6 +45,51 @@
 #import "GNUstepGUI/GSFontInfo.h"
 #import "GNUstepGUI/GSTypesetter.h"
 #import "GNUstepGUI/GSLayoutManager_internal.h"
+#import "GSTraceProbes.h"
+
+/*
+-_doLayoutToGlyph: asks the typesetter for this many line frags at a time,
+so it can stop soon after the requested glyph instead of laying out the
+rest of the text container.
+*/
+#define LAYOUT_STEP_LINE_FRAGS 64
+
+/*
+Maximum time in seconds a single background layout pass may take before
+it gives control back to the run loop.
+*/
+#define BACKGROUND_LAYOUT_INTERVAL 0.02
+
+struct GSLayoutManager_statistics_s GSLayoutManagerTotalStatistics;
+
+static NSDictionary *
+statistics_dictionary(struct GSLayoutManager_statistics_s *s)
+{
+  NSUInteger lookups = s->glyph_cache_hits + s->glyph_cache_misses;
+
+  return [NSDictionary dictionaryWithObjectsAndKeys:
+    [NSNumber numberWithUnsignedInteger: s->glyphs_generated],
+    @"GlyphsGenerated",
+    [NSNumber numberWithUnsignedInteger: s->runs_created], @"RunsCreated",
+    [NSNumber numberWithUnsignedInteger: s->runs_split], @"RunsSplit",
+    [NSNumber numberWithUnsignedInteger: s->hard_invalidations],
+    @"HardInvalidations",
+    [NSNumber numberWithUnsignedInteger: s->soft_invalidations],
+    @"SoftInvalidations",
+    [NSNumber numberWithUnsignedInteger: s->linefrags_laid_out],
+    @"LineFragmentsLaidOut",
+    [NSNumber numberWithUnsignedInteger: s->linefrags_reused],
+    @"LineFragmentsReused",
+    [NSNumber numberWithDouble: s->typesetter_time], @"TypesetterTime",
+    [NSNumber numberWithUnsignedInteger: s->glyph_cache_hits],
+    @"GlyphCacheHits",
+    [NSNumber numberWithUnsignedInteger: s->glyph_cache_misses],
+    @"GlyphCacheMisses",
+    [NSNumber numberWithDouble:
+      lookups ? (double)s->glyph_cache_hits / lookups : 0.0],
+    @"GlyphCacheHitRate",
+    nil];
+}
 
 /* TODO: is using rand() here ok? */
 static inline int random_level(void)
@@ -223,6 +272,10 @@ Private method used internally by GSLayoutManager for sanity checking.
 
   cached_run = NULL;
 
+  free(run_index);
+  run_index = NULL;
+  run_index_length = run_index_glyphs = run_index_size = 0;
+
   h = glyphs;
   h += SKIP_LIST_DEPTH - 1;
 
@@ -329,6 +382,128 @@ Private method used internally by GSLayoutManager for sanity checking.
 }
 
 
+/*
+ * The run index is a flat array of all created runs in text order. It
+ * lets us find the run for a character or glyph with a binary search,
+ * so lookups stay logarithmic no matter how the skip list levels turned
+ * out. The index is extended lazily by the lookups below and truncated
+ * by -_run_index_invalidate_from_character: whenever runs are changed.
+ */
+
+/*
+ * Extends the run index until it covers the character at charIndex.
+ * Returns NO if no run has been created for charIndex yet.
+ */
+- (BOOL) _run_index_cover_character: (NSUInteger)charIndex
+{
+  glyph_run_index_t *e;
+  glyph_run_t *r;
+  NSUInteger cpos;
+
+  if (run_index_length)
+    {
+      e = &run_index[run_index_length - 1];
+      cpos = e->char_pos + e->run->head.char_length;
+      r = (glyph_run_t *)e->run->head.next;
+    }
+  else
+    {
+      cpos = 0;
+      r = (glyph_run_t *)glyphs[SKIP_LIST_DEPTH - 1].next;
+    }
+
+  while (charIndex >= cpos)
+    {
+      if (!r)
+        return NO;
+
+      if (run_index_length == run_index_size)
+        {
+          run_index_size = run_index_size ? run_index_size * 2 : 256;
+          run_index = realloc(run_index,
+                              sizeof(glyph_run_index_t) * run_index_size);
+        }
+      e = &run_index[run_index_length++];
+      e->run = r;
+      e->char_pos = cpos;
+      e->glyph_pos = 0;
+
+      cpos += r->head.char_length;
+      r = (glyph_run_t *)r->head.next;
+    }
+
+  return YES;
+}
+
+/*
+ * Extends the glyph positions in the run index until they cover the
+ * glyph at glyphIndex. Returns NO if this isn't possible because the
+ * glyphs for some run before glyphIndex haven't been generated yet.
+ */
+- (BOOL) _run_index_cover_glyph: (NSUInteger)glyphIndex
+{
+  glyph_run_index_t *e;
+  NSUInteger gpos = 0;
+
+  if (run_index_glyphs)
+    {
+      e = &run_index[run_index_glyphs - 1];
+      gpos = e->glyph_pos + e->run->head.glyph_length;
+    }
+
+  while (glyphIndex >= gpos)
+    {
+      if (run_index_glyphs == run_index_length)
+        {
+          NSUInteger cpos = 0;
+
+          if (run_index_length)
+            {
+              e = &run_index[run_index_length - 1];
+              cpos = e->char_pos + e->run->head.char_length;
+            }
+          if (![self _run_index_cover_character: cpos])
+            return NO;
+        }
+
+      e = &run_index[run_index_glyphs];
+      if (!e->run->head.complete)
+        return NO;
+      e->glyph_pos = gpos;
+      gpos += e->run->head.glyph_length;
+      run_index_glyphs++;
+    }
+
+  return YES;
+}
+
+/*
+ * Drops all entries from the run index for runs that end at or after
+ * charIndex. This must be called before those runs are modified or
+ * freed.
+ */
+- (void) _run_index_invalidate_from_character: (NSUInteger)charIndex
+{
+  NSUInteger lo, hi, mid;
+  glyph_run_index_t *e;
+
+  lo = 0;
+  hi = run_index_length;
+  while (lo < hi)
+    {
+      mid = (lo + hi) / 2;
+      e = &run_index[mid];
+      if (e->char_pos + e->run->head.char_length < charIndex)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  run_index_length = lo;
+  if (run_index_glyphs > lo)
+    run_index_glyphs = lo;
+}
+
 /*
  * Returns the glyph run that contains glyphIndex, if there is any.
  * glyph_pos and char_pos, when supplied, will contain the starting 
@@ -361,6 +536,37 @@ Private method used internally by GSLayoutManager for sanity checking.
         }
     }
 
+  if ([self _run_index_cover_glyph: glyphIndex])
+    {
+      NSUInteger lo, hi, mid;
+      glyph_run_index_t *e;
+
+      /* Find the last run starting at or before glyphIndex. */
+      lo = 0;
+      hi = run_index_glyphs - 1;
+      while (lo < hi)
+        {
+          mid = (lo + hi + 1) / 2;
+          if (run_index[mid].glyph_pos > glyphIndex)
+            hi = mid - 1;
+          else
+            lo = mid;
+        }
+      e = &run_index[lo];
+
+      if (glyph_pos)
+        *glyph_pos = e->glyph_pos;
+      if (char_pos)
+        *char_pos = e->char_pos;
+
+      cached_run = e->run;
+      cached_pos = e->glyph_pos;
+      cached_cpos = e->char_pos;
+
+      return e->run;
+    }
+
+  /* Shouldn't happen, but fall back to walking the skip list. */
   pos = cpos = 0;
   level = SKIP_LIST_DEPTH;
   h = glyphs;
@@ -446,6 +652,56 @@ Private method used internally by GSLayoutManager for sanity checking.
         }
     }
 
+  if ([self _run_index_cover_character: charIndex])
+    {
+      NSUInteger lo, hi, mid;
+      glyph_run_index_t *e;
+
+      /* Find the last run starting at or before charIndex. */
+      lo = 0;
+      hi = run_index_length - 1;
+      while (lo < hi)
+        {
+          mid = (lo + hi + 1) / 2;
+          if (run_index[mid].char_pos > charIndex)
+            hi = mid - 1;
+          else
+            lo = mid;
+        }
+
+      /* Glyph positions are only known if all earlier runs are complete. */
+      while (run_index_glyphs <= lo
+             && run_index[run_index_glyphs].run->head.complete)
+        {
+          e = &run_index[run_index_glyphs];
+          if (run_index_glyphs)
+            e->glyph_pos = (e - 1)->glyph_pos + (e - 1)->run->head.glyph_length;
+          else
+            e->glyph_pos = 0;
+          run_index_glyphs++;
+        }
+
+      if (lo < run_index_glyphs)
+        {
+          e = &run_index[lo];
+
+          if (glyph_pos)
+            *glyph_pos = e->glyph_pos;
+          if (char_pos)
+            *char_pos = e->char_pos;
+
+          cached_run = e->run;
+          cached_pos = e->glyph_pos;
+          cached_cpos = e->char_pos;
+
+          return e->run;
+        }
+    }
+
+  /*
+  The run is in a part of the text where glyphs are missing. Walk the skip
+  list to get the same (approximate) glyph position as the heads give us.
+  */
   pos = cpos = 0;
   h = glyphs;
   for (level = SKIP_LIST_DEPTH - 1; level >= 0; level--)
@@ -520,6 +776,9 @@ Private method used internally by GSLayoutManager for sanity checking.
   h--;
   pos += h->char_length;
 
+  /* The last run may get extended below. */
+  [self _run_index_invalidate_from_character: pos];
+
   /* Create runs and add them to the skip list until we're past our
      target. */
   while (pos <= last)
@@ -604,6 +863,7 @@ Private method used internally by GSLayoutManager for sanity checking.
 
       new = run_insert(context, new_level);
       [self _run_cache_attributes: new : attributes];
+      GS_LAYOUT_COUNT(runs_created, 1);
 
       h = &new->head;
       for (i = 0; i <= new_level; i++, h--)
@@ -682,6 +942,7 @@ Fills in all glyph holes up to last. only looking at levels below level
                                glyphIndex: &gindex
                                characterIndex: &cindex];
               h->complete = 1;
+              GS_LAYOUT_COUNT(glyphs_generated, h->glyph_length);
             }
         }
 
@@ -726,12 +987,14 @@ Fills in all glyph holes up to last. only looking at levels below level
   if (last >= length)
     last = length - 1;
 
+  GS_PROBE2(glyph_generation_entry, self, last);
   if (glyphs->char_length <= last)
     [self _generateRunsToCharacter: last];
 
   // [self _glyphDumpRuns];
   [self _generateGlyphs_char_r: last : 0 : 0 : SKIP_LIST_DEPTH - 1: glyphs : NULL : &dummy];
   // [self _glyphDumpRuns];
+  GS_PROBE2(glyph_generation_return, self, last);
 }
 
 -(void) _generateGlyphsUpToGlyph: (NSUInteger)last
@@ -1301,6 +1564,12 @@ places where we switch.
   // Last affected character (indix before the change).
   max -= lengthChange;
 
+  /*
+  All runs from the one ending at ch onwards may be resized, removed or
+  moved, so they must be dropped from the run index before we touch them.
+  */
+  [self _run_index_invalidate_from_character: ch];
+
   /*
   Find the first run (and context) for the range.
   */
@@ -1349,6 +1618,7 @@ places where we switch.
       new = run_insert(context,  random_level());
       new->head.char_length = cpos + r->head.char_length - max;
       [self _run_copy_attributes: new : r];
+      GS_LAYOUT_COUNT(runs_split, 1);
 
       /* OPT: keep valid glyphs
       this seems to be a fairly rare case
@@ -1537,6 +1807,7 @@ places where we switch.
         
         new = run_insert(context, random_level());
         [self _run_cache_attributes: new : attributes];
+        GS_LAYOUT_COUNT(runs_created, 1);
         
         /*
           We have the longest range the attributes allow us to create a run
@@ -1834,6 +2105,7 @@ places where we switch.
   linefrag_t *lf;
 
   extra_textcontainer = nil;
+  layout_generation++;
 
   for (i = idx, tc = textcontainers + idx; i < num_textcontainers; i++, tc++)
     {
@@ -1878,6 +2150,7 @@ places where we switch.
 
 -(void) _invalidateEverything
 {
+  GS_LAYOUT_COUNT(hard_invalidations, 1);
   [self _freeLayout];
   [self _freeGlyphs];
   [self _initGlyphs];
@@ -1894,8 +2167,10 @@ places where we switch.
   textcontainer_t *tc;
   NSUInteger next;
   NSRect prev;
+  NSTimeInterval start;
   BOOL delegate_responds;
 
+  GS_PROBE2(layout_entry, self, glyphIndex);
   delegate_responds = [_delegate respondsToSelector:
     @selector(layoutManager:didCompleteLayoutForTextContainer:atEnd:)];
 
@@ -1911,18 +2186,22 @@ places where we switch.
             prev = tc->linefrags[tc->num_linefrags - 1].rect;
           else
             prev = NSZeroRect;
+          start = [NSDate timeIntervalSinceReferenceDate];
           j = [typesetter layoutGlyphsInLayoutManager: self
                           inTextContainer: tc->textContainer
                           startingAtGlyphIndex: next
                           previousLineFragmentRect: prev
                           nextGlyphIndex: &next
-                          numberOfLineFragments: 0];
+                          numberOfLineFragments: LAYOUT_STEP_LINE_FRAGS];
+          GS_LAYOUT_COUNT(typesetter_time,
+                          [NSDate timeIntervalSinceReferenceDate] - start);
           if (j)
             break;
 
           if (next > glyphIndex)
             {
               // If all the requested work is done just leave
+              GS_PROBE2(layout_return, self, glyphIndex);
               return;
             }
         }
@@ -1972,6 +2251,7 @@ places where we switch.
                      atEnd: NO];
         }
     }
+  GS_PROBE2(layout_return, self, glyphIndex);
 }
 
 -(void) _doLayoutToContainer: (NSInteger)cindex
@@ -1980,6 +2260,7 @@ places where we switch.
   textcontainer_t *tc;
   NSUInteger next;
   NSRect prev;
+  NSTimeInterval start;
   BOOL delegate_responds;
 
   delegate_responds = [_delegate respondsToSelector:
@@ -1997,12 +2278,15 @@ places where we switch.
             prev = tc->linefrags[tc->num_linefrags - 1].rect;
           else
             prev = NSZeroRect;
+          start = [NSDate timeIntervalSinceReferenceDate];
           j = [typesetter layoutGlyphsInLayoutManager: self
                           inTextContainer: tc->textContainer
                           startingAtGlyphIndex: next
                           previousLineFragmentRect: prev
                           nextGlyphIndex: &next
                           numberOfLineFragments: 0];
+          GS_LAYOUT_COUNT(typesetter_time,
+                          [NSDate timeIntervalSinceReferenceDate] - start);
           if (j)
             break;
         }
@@ -2064,6 +2348,70 @@ places where we switch.
       // FIXME: This value never gets used
       tc->was_invalidated = YES;
     }
+  layout_generation++;
+
+  [self _scheduleBackgroundLayout];
+}
+
+/*
+Background layout. If it is enabled, the text is laid out a few line frags
+at a time whenever the run loop is idle, so most layout is done by the time
+it is needed. Each pass is limited to BACKGROUND_LAYOUT_INTERVAL seconds.
+*/
+-(BOOL) _needsBackgroundLayout
+{
+  if (!backgroundLayoutEnabled || !_textStorage || !num_textcontainers)
+    return NO;
+  if (textcontainers[num_textcontainers - 1].complete)
+    return NO;
+  return layout_char < [_textStorage length];
+}
+
+-(void) _scheduleBackgroundLayout
+{
+  [NSObject cancelPreviousPerformRequestsWithTarget: self
+                                           selector: @selector(_backgroundLayout)
+                                             object: nil];
+  if (![self _needsBackgroundLayout])
+    return;
+
+  [self performSelector: @selector(_backgroundLayout)
+             withObject: nil
+             afterDelay: 0.0
+                inModes: [NSArray arrayWithObject: NSDefaultRunLoopMode]];
+}
+
+-(void) _didLayoutGlyphRange: (NSRange)glyphRange
+{
+}
+
+-(void) _backgroundLayout
+{
+  NSDate *limit;
+
+  if (![self _needsBackgroundLayout])
+    return;
+
+  /*
+  Glyph generation and layout must not be triggered while the text
+  storage is being edited. Just try again later.
+  */
+  if (![_textStorage _editCount])
+    {
+      NSUInteger start = layout_glyph;
+
+      limit = [NSDate dateWithTimeIntervalSinceNow: BACKGROUND_LAYOUT_INTERVAL];
+      do
+        {
+          [self _doLayoutToGlyph: layout_glyph];
+        }
+      while ([self _needsBackgroundLayout] && [limit timeIntervalSinceNow] > 0);
+
+      if (layout_glyph > start)
+        [self _didLayoutGlyphRange: NSMakeRange(start, layout_glyph - start)];
+    }
+
+  [self _scheduleBackgroundLayout];
 }
 
 @end
@@ -2088,6 +2436,7 @@ by calling this incorrectly.
 				    isSoft: (BOOL)flag
 		      actualCharacterRange: (NSRange *)actualRange
 {
+  GS_LAYOUT_COUNT(hard_invalidations, 1);
   [self _invalidateLayoutFromContainer: 0];
 }
 
@@ -2234,6 +2583,7 @@ by calling this incorrectly.
 	}
     }
 
+  GS_LAYOUT_COUNT(linefrags_laid_out, 1);
   if (!(tc->num_linefrags + tc->num_soft))
     {
       if (!tc->size_linefrags)
@@ -2497,9 +2847,8 @@ forStartOfGlyphRange: (NSRange)glyphRange
       return NSZeroRect;
     }
 
-  for (i = 0, lf = tc->linefrags; i < tc->num_linefrags; i++, lf++)
-    if (lf->pos + lf->length > glyphIndex)
-      break;
+  i = GSLinefragIndexForGlyph(tc, glyphIndex);
+  lf = tc->linefrags + i;
   if (i == tc->num_linefrags)
     {
       NSLog(@"%s: can't find line frag rect for glyph (internal error)", __PRETTY_FUNCTION__);
@@ -2541,9 +2890,8 @@ forStartOfGlyphRange: (NSRange)glyphRange
       return NSMakeRect(0, 0, 0, 0);
     }
 
-  for (i = 0, lf = tc->linefrags; i < tc->num_linefrags; i++, lf++)
-    if (lf->pos + lf->length > glyphIndex)
-      break;
+  i = GSLinefragIndexForGlyph(tc, glyphIndex);
+  lf = tc->linefrags + i;
   if (i == tc->num_linefrags)
     {
       NSLog(@"%s: can't find line frag rect for glyph (internal error)", __PRETTY_FUNCTION__);
@@ -2575,9 +2923,8 @@ forStartOfGlyphRange: (NSRange)glyphRange
       return NSMakeRange(NSNotFound, 0);
     }
 
-  for (i = 0, lf = tc->linefrags; i < tc->num_linefrags; i++, lf++)
-    if (lf->pos + lf->length > glyphIndex)
-      break;
+  i = GSLinefragIndexForGlyph(tc, glyphIndex);
+  lf = tc->linefrags + i;
   if (i == tc->num_linefrags)
     {
       NSLog(@"%s: can't find line frag rect for glyph (internal error)", __PRETTY_FUNCTION__);
@@ -2660,6 +3007,68 @@ forStartOfGlyphRange: (NSRange)glyphRange
   return used;
 }
 
+/*
+Like -usedRectForTextContainer:, but only lays out text if nothing has
+been laid out in the container yet. Until the container is complete, the
+height of the rest of its text is estimated from the average height per
+character of the text laid out so far.
+*/
+- (NSRect) _estimatedUsedRectForTextContainer: (NSTextContainer *)container
+{
+  textcontainer_t *tc;
+  linefrag_t *lf;
+  int i, j;
+  NSUInteger first_char, length;
+  double x0, y0, x1, y1, height;
+
+  for (i = 0, tc = textcontainers; i < num_textcontainers; i++, tc++)
+    if (tc->textContainer == container)
+      break;
+  if (i == num_textcontainers)
+    {
+      NSLog(@"%s: doesn't own text container", __PRETTY_FUNCTION__);
+      return NSMakeRect(0, 0, 0, 0);
+    }
+  if (!tc->complete && !tc->num_linefrags)
+    {
+      [self _doLayoutToGlyph: layout_glyph];
+      tc = textcontainers + i;
+    }
+  if (tc->complete || !tc->num_linefrags)
+    return [self usedRectForTextContainer: container];
+
+  lf = tc->linefrags;
+  x0 = NSMinX(lf->used_rect);
+  y0 = NSMinY(lf->used_rect);
+  x1 = NSMaxX(lf->used_rect);
+  y1 = NSMaxY(lf->used_rect);
+  for (j = 1, lf++; j < tc->num_linefrags; j++, lf++)
+    {
+      if (NSMinX(lf->used_rect) < x0)
+	x0 = NSMinX(lf->used_rect);
+      if (NSMinY(lf->used_rect) < y0)
+	y0 = NSMinY(lf->used_rect);
+      if (NSMaxX(lf->used_rect) > x1)
+	x1 = NSMaxX(lf->used_rect);
+      if (NSMaxY(lf->used_rect) > y1)
+	y1 = NSMaxY(lf->used_rect);
+    }
+
+  first_char = [self characterIndexForGlyphAtIndex: tc->pos];
+  length = [_textStorage length];
+  if (layout_char > first_char && length > layout_char)
+    {
+      height = y1 * (double)(length - first_char)
+	/ (double)(layout_char - first_char);
+      if (height > [container containerSize].height)
+	height = [container containerSize].height;
+      if (height > y1)
+	y1 = height;
+    }
+
+  return NSMakeRect(x0, y0, x1 - x0, y1 - y0);
+}
+
 - (NSRange) glyphRangeForTextContainer: (NSTextContainer *)container
 {
   textcontainer_t *tc;
@@ -2704,7 +3113,10 @@ forStartOfGlyphRange: (NSRange)glyphRange
   unsigned int i;
 
   if (index < num_textcontainers)
-    [self _invalidateLayoutFromContainer: index];
+    {
+      GS_LAYOUT_COUNT(hard_invalidations, 1);
+      [self _invalidateLayoutFromContainer: index];
+    }
 
   num_textcontainers++;
   textcontainers = realloc(textcontainers,
@@ -2726,6 +3138,7 @@ forStartOfGlyphRange: (NSRange)glyphRange
   NSInteger i;
   textcontainer_t *tc = &textcontainers[index];
 
+  GS_LAYOUT_COUNT(hard_invalidations, 1);
   [self _invalidateLayoutFromContainer: index];
   [tc->textContainer setLayoutManager: nil];
   [tc->textContainer release];
@@ -2757,6 +3170,7 @@ forStartOfGlyphRange: (NSRange)glyphRange
       NSLog(@"%s: does not own text container", __PRETTY_FUNCTION__);
       return;
     }
+  GS_LAYOUT_COUNT(hard_invalidations, 1);
   [self _invalidateLayoutFromContainer: i];
   [self _didInvalidateLayout];
 }
@@ -2771,6 +3185,11 @@ forStartOfGlyphRange: (NSRange)glyphRange
   return layout_glyph;
 }
 
+- (NSUInteger) layoutGeneration
+{
+  return layout_generation;
+}
+
 -(void) getFirstUnlaidCharacterIndex: (NSUInteger *)cindex
 			  glyphIndex: (NSUInteger *)gindex
 {
@@ -2833,6 +3252,7 @@ forStartOfGlyphRange: (NSRange)glyphRange
     }
   tc->num_soft -= num;
   tc->num_linefrags += num;
+  GS_LAYOUT_COUNT(linefrags_reused, num);
   lf = &tc->linefrags[tc->num_linefrags - 1];
   tc->length = lf->pos + lf->length - tc->pos;
 
@@ -2873,6 +3293,48 @@ forStartOfGlyphRange: (NSRange)glyphRange
   return lf->rect;
 }
 
+-(NSInteger) _softInvalidateNumberOfReusableLineFragsWithShift: (CGFloat)shift
+							   maxY: (CGFloat)maxY
+						       lastRect: (NSRect *)last_rect
+						      nextGlyph: (NSUInteger *)next_glyph
+						inTextContainer: (NSTextContainer *)textContainer
+{
+  NSInteger i;
+  textcontainer_t *tc;
+  linefrag_t *lf;
+  for (i = 0, tc = textcontainers; i < num_textcontainers; i++, tc++)
+    if (tc->textContainer == textContainer)
+      break;
+  if (i == num_textcontainers)
+    {
+      NSLog(@"(%s): does not own text container", __PRETTY_FUNCTION__);
+      return 0;
+    }
+
+  if (!tc->num_soft)
+    return 0;
+
+  /*
+  The first line frag is always reused; the caller has checked that it
+  fits. The following ones are reused as long as there are no gaps between
+  them and they still fit.
+  */
+  lf = &tc->linefrags[tc->num_linefrags];
+  for (i = 1; i < tc->num_soft; i++, lf++)
+    {
+      if (lf[1].pos != lf->pos + lf->length)
+	break;
+      if (NSIsEmptyRect(lf[1].rect) || NSMaxY(lf[1].rect) + shift > maxY)
+	break;
+    }
+
+  if (last_rect)
+    *last_rect = lf->rect;
+  if (next_glyph)
+    *next_glyph = lf->pos + lf->length;
+  return i;
+}
+
 -(NSUInteger) _softInvalidateFirstGlyphInTextContainer: (NSTextContainer *)textContainer
 {
   NSInteger i;
@@ -2906,6 +3368,13 @@ forStartOfGlyphRange: (NSRange)glyphRange
   return tc->num_soft;
 }
 
+-(void) _addGlyphCacheHits: (NSUInteger)hits
+		    misses: (NSUInteger)misses
+{
+  GS_LAYOUT_COUNT(glyph_cache_hits, hits);
+  GS_LAYOUT_COUNT(glyph_cache_misses, misses);
+}
+
 @end
 
 
@@ -3080,7 +3549,7 @@ See [NSTextView -setTextContainer:] for more information about these calls.
   if (flag == backgroundLayoutEnabled)
     return;
   backgroundLayoutEnabled = flag;
-  /* TODO */
+  [self _scheduleBackgroundLayout];
 }
 - (BOOL) backgroundLayoutEnabled
 {
@@ -3143,6 +3612,7 @@ has).
   actualCharacterRange: for information on why we invalidate everything
   here.
   */
+  GS_LAYOUT_COUNT(hard_invalidations, 1);
   [self _invalidateLayoutFromContainer: 0];
   [self _didInvalidateLayout];
 }
@@ -3245,7 +3715,6 @@ forStartingGlyphAtIndex: (NSUInteger)glyph
        characterIndex: (NSUInteger)index
 {
   glyph_run_t *run;
-  NSInteger i;
   NSUInteger gpos, cpos;
   NSSize advances[length];
 
@@ -3257,10 +3726,9 @@ forStartingGlyphAtIndex: (NSUInteger)glyph
       return;
     }
     
-  for (i=0; i<length; i++)
-    {
-      advances[i] = [run->font advancementForGlyph: glyph_list[i]];
-    }
+  [run->font getAdvancements: advances
+		   forGlyphs: glyph_list
+		       count: length];
 
   [self insertGlyphs: glyph_list
     withAdvancements: advances
@@ -3269,6 +3737,55 @@ forStartingGlyphAtIndex: (NSUInteger)glyph
       characterIndex: index];
 }
 
+/**
+ * Returns a dictionary of what the receiver has done since it was
+ * created or -resetLayoutStatistics was last called, with the keys:
+ * <deflist>
+ *   <term>GlyphsGenerated</term>
+ *   <desc>The number of glyphs generated.</desc>
+ *   <term>RunsCreated, RunsSplit</term>
+ *   <desc>The number of glyph runs created, and of runs split in two by
+ *   invalidation.</desc>
+ *   <term>HardInvalidations</term>
+ *   <desc>How often laid out text had to be laid out again from
+ *   scratch.</desc>
+ *   <term>SoftInvalidations</term>
+ *   <desc>How often an edit kept the layout after it for reuse.</desc>
+ *   <term>LineFragmentsLaidOut, LineFragmentsReused</term>
+ *   <desc>The number of line fragments the typesetter laid out, and the
+ *   number of soft invalidated ones it reused instead.</desc>
+ *   <term>TypesetterTime</term>
+ *   <desc>The time spent in the typesetter, in seconds.</desc>
+ *   <term>GlyphCacheHits, GlyphCacheMisses, GlyphCacheHitRate</term>
+ *   <desc>How many of the glyphs the typesetter needed it had cached
+ *   already, how many it had to fetch, and the fraction of hits.</desc>
+ * </deflist>
+ */
+- (NSDictionary *) layoutStatistics
+{
+  return statistics_dictionary(&statistics);
+}
+
+- (void) resetLayoutStatistics
+{
+  memset(&statistics, 0, sizeof(statistics));
+}
+
+/**
+ * Returns the statistics of -layoutStatistics for all layout managers
+ * together.
+ */
++ (NSDictionary *) layoutStatistics
+{
+  return statistics_dictionary(&GSLayoutManagerTotalStatistics);
+}
+
++ (void) resetLayoutStatistics
+{
+  memset(&GSLayoutManagerTotalStatistics, 0,
+         sizeof(GSLayoutManagerTotalStatistics));
+}
+
 - (NSUInteger) layoutOptions
 {
   NSUInteger options = 0;
@@ -27,15 +27,24 @@
 */
 
 #import <Foundation/NSArray.h>
+#import <Foundation/NSDate.h>
 #import <Foundation/NSDebug.h>
+#import <Foundation/NSDictionary.h>
+#import <Foundation/NSMapTable.h>
 #import <Foundation/NSString.h>
 #import <Foundation/NSValue.h>
 #import "AppKit/NSButton.h"
+#import "AppKit/NSFont.h"
+#import "AppKit/NSImage.h"
 #import "AppKit/NSScrollView.h"
+#import "AppKit/NSStringDrawing.h"
 #import "AppKit/NSTableColumn.h"
 #import "AppKit/NSTableView.h"
+#import "AppKit/NSTextStorage.h"
+#import "AppKit/NSWorkspace.h"
 #import "GNUstepGUI/GSMemoryPanel.h"
 #import "GNUstepGUI/GSHbox.h"
+#import "GNUstepGUI/GSTheme.h"
 #import "GNUstepGUI/GSVbox.h"
 
 enum {
@@ -45,6 +54,12 @@ enum {
   OrderByPeak
 };
 
+/* The totals and counts of each class at the previous sample, from
+   which +allocationStatistics works out the rates. */
+static NSMapTable *lastTotals = 0;
+static NSMapTable *lastCounts = 0;
+static NSTimeInterval lastSample = 0.0;
+
 static inline NSComparisonResult 
 invertComparison (NSComparisonResult comparison)
 {
@@ -70,32 +85,34 @@ invertComparison (NSComparisonResult comparison)
   NSNumber *count;
   NSNumber *total;
   NSNumber *peak;
+  NSNumber *allocRate;
+  NSNumber *deallocRate;
 }
-- (id) initWithString: (NSString *)aString  
-		count: (int)aCount
-		total: (int)aTotal   
-		 peak: (int)aPeak;
+- (id) initWithStatistics: (NSDictionary *)info;
 - (NSString *) string;
 - (NSNumber *) count;
 - (NSNumber *) total;
 - (NSNumber *) peak;
+- (NSNumber *) allocRate;
+- (NSNumber *) deallocRate;
 - (NSComparisonResult) compareByTotal: (GSMemoryPanelEntry *)aEntry;
 - (NSComparisonResult) compareByCount: (GSMemoryPanelEntry *)aEntry;
 - (NSComparisonResult) compareByPeak: (GSMemoryPanelEntry *)aEntry;
 - (NSComparisonResult) compareByClassName: (GSMemoryPanelEntry *)aEntry;
+- (NSComparisonResult) compareByAllocRate: (GSMemoryPanelEntry *)aEntry;
+- (NSComparisonResult) compareByDeallocRate: (GSMemoryPanelEntry *)aEntry;
 @end
 
 @implementation GSMemoryPanelEntry
 
-- (id) initWithString: (NSString *)aString  
-		count: (int)aCount
-		total: (int)aTotal   
-		 peak: (int)aPeak
+- (id) initWithStatistics: (NSDictionary *)info
 {
-  ASSIGN (string, aString);
-  ASSIGN (count, [NSNumber numberWithInt: aCount]);
-  ASSIGN (total, [NSNumber numberWithInt: aTotal]);
-  ASSIGN (peak, [NSNumber numberWithInt: aPeak]);
+  ASSIGN (string, [info objectForKey: @"Class"]);
+  ASSIGN (count, [info objectForKey: @"Count"]);
+  ASSIGN (total, [info objectForKey: @"Total"]);
+  ASSIGN (peak, [info objectForKey: @"Peak"]);
+  ASSIGN (allocRate, [info objectForKey: @"AllocationsPerSecond"]);
+  ASSIGN (deallocRate, [info objectForKey: @"DeallocationsPerSecond"]);
   return self;
 }
 
@@ -105,6 +122,8 @@ invertComparison (NSComparisonResult comparison)
   RELEASE (count);
   RELEASE (total);  
   RELEASE (peak);
+  RELEASE (allocRate);
+  RELEASE (deallocRate);
   [super dealloc];
 }
 
@@ -128,6 +147,16 @@ invertComparison (NSComparisonResult comparison)
   return peak;
 }
 
+- (NSNumber *) allocRate
+{
+  return allocRate;
+}
+
+- (NSNumber *) deallocRate
+{
+  return deallocRate;
+}
+
 - (NSComparisonResult) compareByCount: (GSMemoryPanelEntry *)aEntry
 {
   NSComparisonResult comparison = [count compare: aEntry->count];
@@ -154,6 +183,20 @@ invertComparison (NSComparisonResult comparison)
   return [string compare: aEntry->string];
 }
 
+- (NSComparisonResult) compareByAllocRate: (GSMemoryPanelEntry *)aEntry
+{
+  NSComparisonResult comparison = [allocRate compare: aEntry->allocRate];
+
+  return invertComparison (comparison);
+}
+
+- (NSComparisonResult) compareByDeallocRate: (GSMemoryPanelEntry *)aEntry
+{
+  NSComparisonResult comparison = [deallocRate compare: aEntry->deallocRate];
+
+  return invertComparison (comparison);
+}
+
 @end
 
 /*
@@ -173,6 +216,72 @@ static GSMemoryPanel *sharedGSMemoryPanel = nil;
   return sharedGSMemoryPanel;
 }
 
++ (NSArray *) allocationStatistics
+{
+  NSTimeInterval now = [NSDate timeIntervalSinceReferenceDate];
+  NSTimeInterval interval;
+  NSMutableArray *result;
+  Class *classList;
+  int i;
+
+  GSDebugAllocationActive (YES);
+  if (lastTotals == 0)
+    {
+      lastTotals = NSCreateMapTable (NSNonOwnedPointerMapKeyCallBacks,
+                                     NSIntegerMapValueCallBacks, 0);
+      lastCounts = NSCreateMapTable (NSNonOwnedPointerMapKeyCallBacks,
+                                     NSIntegerMapValueCallBacks, 0);
+    }
+  interval = (lastSample > 0.0) ? now - lastSample : 0.0;
+  lastSample = now;
+
+  classList = GSDebugAllocationClassList ();
+  result = [NSMutableArray array];
+  for (i = 0; classList[i] != NULL; i++)
+    {
+      Class c = classList[i];
+      int count = GSDebugAllocationCount (c);
+      int total = GSDebugAllocationTotal (c);
+      int peak = GSDebugAllocationPeak (c);
+      double allocs = 0.0;
+      double deallocs = 0.0;
+
+      if (interval > 0.0)
+        {
+          int allocated = total - (int)(intptr_t)NSMapGet (lastTotals, c);
+          int grown = count - (int)(intptr_t)NSMapGet (lastCounts, c);
+
+          allocs = allocated / interval;
+          deallocs = (allocated - grown) / interval;
+        }
+      NSMapInsert (lastTotals, c, (void*)(intptr_t)total);
+      NSMapInsert (lastCounts, c, (void*)(intptr_t)count);
+
+      [result addObject: [NSDictionary dictionaryWithObjectsAndKeys:
+        NSStringFromClass (c), @"Class",
+        [NSNumber numberWithInt: count], @"Count",
+        [NSNumber numberWithInt: total], @"Total",
+        [NSNumber numberWithInt: peak], @"Peak",
+        [NSNumber numberWithDouble: allocs], @"AllocationsPerSecond",
+        [NSNumber numberWithDouble: deallocs], @"DeallocationsPerSecond",
+        nil]];
+    }
+  NSZoneFree (NSDefaultMallocZone (), classList);
+  return result;
+}
+
++ (NSDictionary *) cacheStatistics
+{
+  return [NSDictionary dictionaryWithObjectsAndKeys:
+    [NSImage imageCacheStatistics], @"Images",
+    [NSString stringDrawingCacheStatistics], @"StringDrawing",
+    [NSFont fontCacheStatistics], @"Fonts",
+    [NSTextStorage attributeCacheStatistics], @"TextAttributes",
+    [[GSTheme theme] tileCacheStatistics], @"ThemeTiles",
+    [[NSWorkspace sharedWorkspace] iconCacheStatistics], @"Icons",
+    nil];
+}
+
 + (void) update: (id)sender
 {
   [[self sharedMemoryPanel] update: sender];
@@ -185,7 +294,11 @@ static GSMemoryPanel *sharedGSMemoryPanel = nil;
   NSTableColumn *countColumn;  
   NSTableColumn *totalColumn;
   NSTableColumn *peakColumn;  
+  NSTableColumn *allocColumn;
+  NSTableColumn *deallocColumn;
+  NSTableColumn *column;
   NSScrollView *scrollView;
+  NSScrollView *cacheScrollView;
   GSVbox *vbox;
   GSHbox *hbox;
   NSButton *button;
@@ -248,6 +361,16 @@ static GSMemoryPanel *sharedGSMemoryPanel = nil;
   [[peakColumn headerCell] setStringValue: @"Peak"];
   [peakColumn setMinWidth: 50];
 
+  allocColumn = [[NSTableColumn alloc] initWithIdentifier: @"AllocRate"];
+  [allocColumn setEditable: NO];
+  [[allocColumn headerCell] setStringValue: @"Allocs/s"];
+  [allocColumn setMinWidth: 60];
+
+  deallocColumn = [[NSTableColumn alloc] initWithIdentifier: @"DeallocRate"];
+  [deallocColumn setEditable: NO];
+  [[deallocColumn headerCell] setStringValue: @"Deallocs/s"];
+  [deallocColumn setMinWidth: 60];
+
   table = [[NSTableView alloc] initWithFrame: NSMakeRect (0, 0, 300, 300)];
   [table addTableColumn: classColumn];
   RELEASE (classColumn);
@@ -257,6 +380,10 @@ static GSMemoryPanel *sharedGSMemoryPanel = nil;
   RELEASE (totalColumn);
   [table addTableColumn: peakColumn];
   RELEASE (peakColumn);
+  [table addTableColumn: allocColumn];
+  RELEASE (allocColumn);
+  [table addTableColumn: deallocColumn];
+  RELEASE (deallocColumn);
   [table setDataSource: self];
   [table setDelegate: self];
   [table setDoubleAction: @selector (reorder:)];
@@ -270,12 +397,57 @@ static GSMemoryPanel *sharedGSMemoryPanel = nil;
   [scrollView setAutoresizingMask: (NSViewWidthSizable | NSViewHeightSizable)];
   [table sizeToFit];
   RELEASE (table);
+
+  /* Table of the caches kept by the library.  */
+  cacheTable = [[NSTableView alloc] initWithFrame: NSMakeRect (0, 0, 300, 100)];
+  column = [[NSTableColumn alloc] initWithIdentifier: @"Cache"];
+  [column setEditable: NO];
+  [[column headerCell] setStringValue: @"Cache"];
+  [column setMinWidth: 150];
+  [cacheTable addTableColumn: column];
+  RELEASE (column);
+  column = [[NSTableColumn alloc] initWithIdentifier: @"Entries"];
+  [column setEditable: NO];
+  [[column headerCell] setStringValue: @"Entries"];
+  [column setMinWidth: 50];
+  [cacheTable addTableColumn: column];
+  RELEASE (column);
+  column = [[NSTableColumn alloc] initWithIdentifier: @"Bytes"];
+  [column setEditable: NO];
+  [[column headerCell] setStringValue: @"Bytes"];
+  [column setMinWidth: 80];
+  [cacheTable addTableColumn: column];
+  RELEASE (column);
+  column = [[NSTableColumn alloc] initWithIdentifier: @"Hits"];
+  [column setEditable: NO];
+  [[column headerCell] setStringValue: @"Hits"];
+  [column setMinWidth: 50];
+  [cacheTable addTableColumn: column];
+  RELEASE (column);
+  column = [[NSTableColumn alloc] initWithIdentifier: @"Misses"];
+  [column setEditable: NO];
+  [[column headerCell] setStringValue: @"Misses"];
+  [column setMinWidth: 50];
+  [cacheTable addTableColumn: column];
+  RELEASE (column);
+  [cacheTable setDataSource: self];
+
+  cacheScrollView = [[NSScrollView alloc] 
+		      initWithFrame: NSMakeRect (0, 0, 350, 130)];
+  [cacheScrollView setDocumentView: cacheTable];
+  [cacheScrollView setHasVerticalScroller: YES];
+  [cacheScrollView setBorderType: NSBezelBorder];
+  [cacheScrollView setAutoresizingMask: NSViewWidthSizable];
+  [cacheTable sizeToFit];
+  RELEASE (cacheTable);
  
   vbox = [GSVbox new];
   [vbox setDefaultMinYMargin: 5];
   [vbox setBorder: 5];
   [vbox addView: hbox  enablingYResizing: NO];
   RELEASE (hbox);
+  [vbox addView: cacheScrollView  enablingYResizing: NO];
+  RELEASE (cacheScrollView);
   [vbox addView: scrollView];
   RELEASE (scrollView);
 
@@ -307,21 +479,54 @@ static GSMemoryPanel *sharedGSMemoryPanel = nil;
 - (void) dealloc
 {
   RELEASE(array);
+  RELEASE(caches);
   [super dealloc];
 }
 
 - (NSInteger) numberOfRowsInTableView: (NSTableView *)aTableView
 {
+  if (aTableView == cacheTable)
+    {
+      return [caches count];
+    }
   return [array count];
 }
 
+- (id) _cacheValueForColumn: (id)identifier
+                        row: (NSInteger)rowIndex
+{
+  NSDictionary *info = [caches objectAtIndex: rowIndex];
+  id value;
+
+  if ([identifier isEqual: @"Cache"])
+    {
+      return [info objectForKey: @"Name"];
+    }
+  value = [info objectForKey: identifier];
+  if (value == nil && [identifier isEqual: @"Entries"])
+    {
+      value = [info objectForKey: @"Count"];
+    }
+  else if (value == nil && [identifier isEqual: @"Bytes"])
+    {
+      value = [info objectForKey: @"BytesInUse"];
+    }
+  return (value == nil) ? (id)@"" : value;
+}
+
 - (id)           tableView: (NSTableView *)aTableView 
  objectValueForTableColumn: (NSTableColumn *)aTableColumn 
 		       row:(NSInteger)rowIndex
 {
-  GSMemoryPanelEntry *entry = [array objectAtIndex: rowIndex];
+  GSMemoryPanelEntry *entry;
   id identifier = [aTableColumn identifier];
 
+  if (aTableView == cacheTable)
+    {
+      return [self _cacheValueForColumn: identifier row: rowIndex];
+    }
+
+  entry = [array objectAtIndex: rowIndex];
   if ([identifier isEqual: @"Class"])
     {
       return [entry string];
@@ -338,6 +543,16 @@ static GSMemoryPanel *sharedGSMemoryPanel = nil;
     {
       return [entry peak];
     }
+  else if ([identifier isEqual: @"AllocRate"])
+    {
+      return [NSString stringWithFormat: @"%.1f",
+                       [[entry allocRate] doubleValue]];
+    }
+  else if ([identifier isEqual: @"DeallocRate"])
+    {
+      return [NSString stringWithFormat: @"%.1f",
+                       [[entry deallocRate] doubleValue]];
+    }
 
   NSLog (@"Hi, I am a bug in your table view");
 
@@ -359,37 +574,43 @@ static GSMemoryPanel *sharedGSMemoryPanel = nil;
 
 - (void) update: (id)sender
 {
-  Class *classList = GSDebugAllocationClassList ();
-  Class *pointer;
+  NSArray *statistics = [GSMemoryPanel allocationStatistics];
+  NSDictionary *cacheStatistics = [GSMemoryPanel cacheStatistics];
+  NSMutableArray *rows;
+  NSArray *names;
   GSMemoryPanelEntry *entry;
-  int i, count, total, peak;
-  NSString *className;
+  NSUInteger i, c;
 
-  pointer = classList;
-  i = 0;
   [array removeAllObjects];
-  while (pointer[i] != NULL)
+  for (i = 0, c = [statistics count]; i < c; i++)
     {
-      className = NSStringFromClass (pointer[i]);
-      count = GSDebugAllocationCount (pointer[i]);
-      total = GSDebugAllocationTotal (pointer[i]);
-      peak = GSDebugAllocationPeak (pointer[i]);
-      
       /* Insert into array */
       entry = [[GSMemoryPanelEntry alloc]
-                initWithString: className
-                         count: count  
-                         total: total  
-                          peak: peak];
+                initWithStatistics: [statistics objectAtIndex: i]];
       [array addObject: entry];
       RELEASE (entry);
-      i++;
     }
-  NSZoneFree(NSDefaultMallocZone(), classList);
 
   [array sortUsingSelector: orderingBy];
 
   [table reloadData];
+
+  names = [[cacheStatistics allKeys] sortedArrayUsingSelector:
+                                       @selector(compare:)];
+  rows = [NSMutableArray arrayWithCapacity: [names count]];
+  for (i = 0, c = [names count]; i < c; i++)
+    {
+      NSString *name = [names objectAtIndex: i];
+      NSMutableDictionary *row;
+
+      row = [[cacheStatistics objectForKey: name] mutableCopy];
+      [row setObject: name forKey: @"Name"];
+      [rows addObject: row];
+      RELEASE (row);
+    }
+  ASSIGN (caches, rows);
+
+  [cacheTable reloadData];
 }
 
 - (void) reorder: (id)sender
@@ -423,6 +644,14 @@ static GSMemoryPanel *sharedGSMemoryPanel = nil;
     {
       newOrderingBy = @selector(compareByPeak:); 
     }
+  else if ([identifier isEqual: @"AllocRate"])
+    {
+      newOrderingBy = @selector(compareByAllocRate:); 
+    }
+  else if ([identifier isEqual: @"DeallocRate"])
+    {
+      newOrderingBy = @selector(compareByDeallocRate:); 
+    }
 
   if (newOrderingBy == orderingBy)
     {
@@ -33,9 +33,206 @@
 #import <Foundation/NSEnumerator.h>
 #import <Foundation/NSException.h>
 #import <Foundation/NSFileManager.h>
+#import <Foundation/NSPathUtilities.h>
 #import <Foundation/NSString.h>
+#import <Foundation/NSUserDefaults.h>
+#import <Foundation/NSValue.h>
 
 #import "GNUstepGUI/GSModelLoaderFactory.h"
+#import "GSGuiPrivate.h"
+#import "GSTraceProbes.h"
+
+/* The timings of one model load. For each step, steps holds a dictionary
+   with the total time of the step, and a dictionary of the time and count
+   of each class of object handled in it. */
+@interface GSModelLoadProfile : NSObject
+{
+@public
+  NSString *fileName;
+  NSTimeInterval start;
+  NSMutableDictionary *steps;
+  /* The time of the nested steps of each open step, innermost last. */
+  NSTimeInterval *nested;
+  NSUInteger depth;
+  NSUInteger capacity;
+}
+- (NSDictionary *) report;
+@end
+
+@implementation GSModelLoadProfile
+- (void) dealloc
+{
+  RELEASE(fileName);
+  RELEASE(steps);
+  if (nested != NULL)
+    NSZoneFree(NSDefaultMallocZone(), nested);
+  [super dealloc];
+}
+
+- (NSMutableDictionary *) step: (NSString *)name
+{
+  NSMutableDictionary *step = [steps objectForKey: name];
+
+  if (step == nil)
+    {
+      step = [NSMutableDictionary dictionaryWithObjectsAndKeys:
+        [NSNumber numberWithDouble: 0.0], @"time",
+        [NSMutableDictionary dictionary], @"classes", nil];
+      [steps setObject: step forKey: name];
+    }
+  return step;
+}
+
+- (NSDictionary *) report
+{
+  return [NSDictionary dictionaryWithObjectsAndKeys:
+    fileName, @"file",
+    [NSNumber numberWithDouble:
+      [NSDate timeIntervalSinceReferenceDate] - start], @"time",
+    steps, @"steps", nil];
+}
+@end
+
+static GSModelLoadProfile *currentProfile = nil;
+static NSMutableArray *profileReports = nil;
+
+id
+GSModelLoadProfileOpen(NSString *fileName)
+{
+  NSString *setting;
+  GSModelLoadProfile *previous = currentProfile;
+
+  setting = [[NSUserDefaults standardUserDefaults]
+              stringForKey: @"GSModelLoadProfile"];
+  if (setting == nil
+    || ([setting boolValue] == NO && [setting isAbsolutePath] == NO))
+    {
+      return previous;
+    }
+
+  currentProfile = [GSModelLoadProfile new];
+  currentProfile->fileName = [fileName copy];
+  currentProfile->start = [NSDate timeIntervalSinceReferenceDate];
+  currentProfile->steps = [NSMutableDictionary new];
+  return previous;
+}
+
+void
+GSModelLoadProfileClose(id previous)
+{
+  NSString *setting;
+  NSDictionary *report;
+
+  if (currentProfile == previous)
+    {
+      return;
+    }
+
+  report = [currentProfile report];
+  if (profileReports == nil)
+    {
+      profileReports = [NSMutableArray new];
+    }
+  [profileReports addObject: report];
+  DESTROY(currentProfile);
+  currentProfile = previous;
+
+  setting = [[NSUserDefaults standardUserDefaults]
+              stringForKey: @"GSModelLoadProfile"];
+  if ([setting isAbsolutePath])
+    {
+      if ([profileReports writeToFile: setting atomically: YES] == NO)
+        {
+          NSLog(@"Could not write model load profile to %@", setting);
+        }
+    }
+  else
+    {
+      NSLog(@"Model load profile: %@", report);
+    }
+}
+
+NSTimeInterval
+GSModelLoadProfileBegin(void)
+{
+  GSModelLoadProfile *p = currentProfile;
+
+  if (p == nil)
+    {
+      return 0.0;
+    }
+  if (p->depth == p->capacity)
+    {
+      p->capacity = p->capacity * 2 + 8;
+      p->nested = NSZoneRealloc(NSDefaultMallocZone(), p->nested,
+                                p->capacity * sizeof(NSTimeInterval));
+    }
+  p->nested[p->depth++] = 0.0;
+  return [NSDate timeIntervalSinceReferenceDate];
+}
+
+/* Closes the innermost timing begun at start. Returns its time less that
+   of the timings nested in it, or a negative value if there was none. */
+static NSTimeInterval
+endTiming(GSModelLoadProfile *p, NSTimeInterval start, NSTimeInterval *elapsed)
+{
+  NSTimeInterval own;
+
+  if (p == nil || start == 0.0 || p->depth == 0)
+    {
+      return -1.0;
+    }
+  *elapsed = [NSDate timeIntervalSinceReferenceDate] - start;
+  own = *elapsed - p->nested[--p->depth];
+  if (p->depth > 0)
+    {
+      p->nested[p->depth - 1] += *elapsed;
+    }
+  return own;
+}
+
+void
+GSModelLoadProfileEnd(NSTimeInterval start, NSString *step, id object)
+{
+  GSModelLoadProfile *p = currentProfile;
+  NSMutableDictionary *classes;
+  NSDictionary *entry;
+  NSString *name;
+  NSTimeInterval elapsed;
+  NSTimeInterval own = endTiming(p, start, &elapsed);
+
+  if (own < 0.0)
+    {
+      return;
+    }
+  classes = [[p step: step] objectForKey: @"classes"];
+  name = (object != nil) ? [object className] : @"nil";
+  entry = [classes objectForKey: name];
+  [classes setObject: [NSDictionary dictionaryWithObjectsAndKeys:
+    [NSNumber numberWithDouble:
+      [[entry objectForKey: @"time"] doubleValue] + own], @"time",
+    [NSNumber numberWithUnsignedInt:
+      [[entry objectForKey: @"count"] unsignedIntValue] + 1], @"count",
+    nil]
+              forKey: name];
+}
+
+void
+GSModelLoadProfileEndStep(NSTimeInterval start, NSString *step)
+{
+  GSModelLoadProfile *p = currentProfile;
+  NSMutableDictionary *dict;
+  NSTimeInterval elapsed;
+
+  if (endTiming(p, start, &elapsed) < 0.0)
+    {
+      return;
+    }
+  dict = [p step: step];
+  [dict setObject: [NSNumber numberWithDouble:
+    [[dict objectForKey: @"time"] doubleValue] + elapsed]
+           forKey: @"time"];
+}
 
 @implementation GSModelLoader
 + (NSString *) type
@@ -61,21 +258,29 @@
      externalNameTable: (NSDictionary *)context
               withZone: (NSZone *)zone
 {
-  NSData *data = [self dataForFile: fileName];
+  id profile = GSModelLoadProfileOpen(fileName);
+  NSTimeInterval t;
+  NSData *data;
+  BOOL loaded = NO;
+
+  GS_PROBE1(model_load_entry, [fileName fileSystemRepresentation]);
+  GSLaunchTimelineBegin([fileName lastPathComponent]);
+  t = GSModelLoadProfileBegin();
+  data = [self dataForFile: fileName];
 
+  GSModelLoadProfileEndStep(t, @"read");
   if (data != nil)
     {
-      BOOL loaded = [self loadModelData: data
-                      externalNameTable: context
-                               withZone: zone];
+      loaded = [self loadModelData: data
+                 externalNameTable: context
+                          withZone: zone];
       if (!loaded)
         NSLog(@"Could not load Nib file: %@", fileName);
-      return loaded;
-    }
-  else
-    {
-      return NO;
     }
+  GSModelLoadProfileClose(profile);
+  GSLaunchTimelineEnd([fileName lastPathComponent]);
+  GS_PROBE1(model_load_return, [fileName fileSystemRepresentation]);
+  return loaded;
 }
 
 - (NSData *) dataForFile: (NSString *)fileName
@@ -83,6 +288,16 @@
   return [NSData dataWithContentsOfFile: fileName];
 }
 
+/**
+ * Returns the reports of the model loads profiled so far, as set up by
+ * the GSModelLoadProfile user default.  Each report is a dictionary with
+ * the file, the total time and the time spent in each step.
+ */
++ (NSArray *) loadProfileReports
+{
+  return AUTORELEASE([profileReports copy]);
+}
+
 + (NSComparisonResult) _comparePriority: (Class)loader
 {
   NSComparisonResult result = NSOrderedSame;
@@ -75,10 +75,13 @@
 	  if (unarchiver != nil)
 	    {
 	      id obj;
+	      NSTimeInterval t;
 	      
 	      NSDebugLog(@"Invoking unarchiver");
 	      [unarchiver setObjectZone: zone];
+	      t = GSModelLoadProfileBegin();
 	      obj = [unarchiver decodeObjectForKey: @"IB.objectdata"];
+	      GSModelLoadProfileEndStep(t, @"decode");
 	      if (obj != nil)
 		{
 		  if ([obj isKindOfClass: [NSIBObjectData class]])
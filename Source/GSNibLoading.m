@@ -48,6 +48,7 @@
 #import <Foundation/NSObjCRuntime.h>
 #import <Foundation/NSSet.h>
 #import <Foundation/NSString.h>
+#import <Foundation/NSUserDefaults.h>
 
 #import "GNUstepGUI/GSNibLoading.h"
 #import "AppKit/NSApplication.h"
@@ -59,6 +60,7 @@
 #import "AppKit/NSSound.h"
 #import "AppKit/NSToolbar.h"
 #import "GNUstepGUI/GSInstantiator.h"
+#import "GNUstepGUI/GSModelLoaderFactory.h"
 #import "GSGuiPrivate.h"
 
 static BOOL _isInInterfaceBuilder = NO;
@@ -1879,24 +1881,44 @@ static BOOL _isInInterfaceBuilder = NO;
   NSArray *objs;
   id obj = nil;
   id menu = nil;
+  NSTimeInterval step;
 
   // set the new root object.
   [_root setRealObject: owner];
 
+  /* Windows that are not visible at launch get their backend window only
+     when they are first ordered front, if the user asked for that.  */
+  if ([[NSUserDefaults standardUserDefaults] boolForKey: @"GSDeferNibWindows"])
+    {
+      objs = NSAllMapTableKeys(_objects);
+      en = [objs objectEnumerator];
+      while ((obj = [en nextObject]) != nil)
+        {
+          if ([obj isKindOfClass: [NSWindowTemplate class]]
+            && [_visibleWindows indexOfObjectIdenticalTo: obj] == NSNotFound)
+            {
+              [obj setDeferred: YES];
+            }
+        }
+    }
+
   // iterate over all objects, instantiate them and fill in top level array.
   /* Note: We instantiate all objects before establishing any connections
      between them, so that any shared instances defined in the nib are
      initialized before being used. This sequence is important when, e.g.,
      the nib defines a shared document controller that is an instance of a
      subclass of NSDocumentController. */
+  step = GSModelLoadProfileBegin();
   objs = NSAllMapTableKeys(_objects);
   en = [objs objectEnumerator];
   while ((obj = [en nextObject]) != nil)
     {
       id v = NSMapGet(_objects, obj);
       NSInteger oid = [(id)NSMapGet(_oids, obj) intValue];
+      NSTimeInterval t = GSModelLoadProfileBegin();
 
       obj = [self instantiateObject: obj];
+      GSModelLoadProfileEnd(t, @"instantiate", obj);
       // Object is top level if it isn't the owner but points to it.
       /* Don't record proxy objects in the top level array. The only
 	 reliable way to identify proxy objects seems to look at their
@@ -1915,19 +1937,26 @@ static BOOL _isInInterfaceBuilder = NO;
 	    }
         }
     }
+  GSModelLoadProfileEndStep(step, @"instantiate");
 
   // iterate over connections, instantiate and then establish them.
+  step = GSModelLoadProfileBegin();
   en = [_connections objectEnumerator];
   while ((obj = [en nextObject]) != nil)
     {
       if ([obj respondsToSelector: @selector(instantiateWithInstantiator:)])
         {
+          NSTimeInterval t = GSModelLoadProfileBegin();
+
           [obj instantiateWithInstantiator: self];          
           [obj establishConnection];
+          GSModelLoadProfileEnd(t, @"connect", obj);
         }
     }
+  GSModelLoadProfileEndStep(step, @"connect");
 
   // awaken all objects except proxy objects.
+  step = GSModelLoadProfileBegin();
   objs = NSAllMapTableKeys(_objects);
   en = [objs objectEnumerator];
   while ((obj = [en nextObject]) != nil)
@@ -1941,7 +1970,10 @@ static BOOL _isInInterfaceBuilder = NO;
             }
           if ([obj respondsToSelector: @selector(awakeFromNib)])
             {
+              NSTimeInterval t = GSModelLoadProfileBegin();
+
               [obj awakeFromNib];
+              GSModelLoadProfileEnd(t, @"awake", obj);
             }
         }
     }
@@ -1949,8 +1981,12 @@ static BOOL _isInInterfaceBuilder = NO;
   // awaken the owner
   if ([owner respondsToSelector: @selector(awakeFromNib)])
     {
+      NSTimeInterval t = GSModelLoadProfileBegin();
+
       [owner awakeFromNib];
+      GSModelLoadProfileEnd(t, @"awake", owner);
     }
+  GSModelLoadProfileEndStep(step, @"awake");
 
   // bring visible windows to front...
   en = [_visibleWindows objectEnumerator];
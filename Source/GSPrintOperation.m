@@ -116,6 +116,10 @@
   BOOL success;
   NSString *job;
   
+  /* Streamed output was delivered while it was produced. */
+  if (_flags.streamed_output)
+    return YES;
+
   success = YES;
   job = [[self printInfo] jobDisposition];
   if ([job isEqual: NSPrintPreviewJob])
@@ -43,6 +43,7 @@
 #import <Foundation/NSMethodSignature.h>
 #import <Foundation/NSPathUtilities.h>
 #import <Foundation/NSUserDefaults.h>
+#import <Foundation/NSValue.h>
 #import <Foundation/NSSerialization.h>
 #import <Foundation/NSPort.h>
 #import <Foundation/NSPortNameServer.h>
@@ -559,7 +560,9 @@ static NSString         *disabledName = @".GNUstepDisabled";
 				       userInfo: nil
 					repeats: YES]);
 
+  GSLaunchTimelineBegin(@"load services");
   [manager loadServices];
+  GSLaunchTimelineEnd(@"load services");
   return manager;
 }
 
@@ -696,6 +699,7 @@ static NSString         *disabledName = @".GNUstepDisabled";
   RELEASE(_servicesStamp);
   RELEASE(_allDisabled);
   RELEASE(_allServices);
+  RELEASE(_servicesData);
   [super dealloc];
 }
 
@@ -888,8 +892,13 @@ static NSString         *disabledName = @".GNUstepDisabled";
 	  id		plist = nil;
 
 	  data = [NSData dataWithContentsOfFile: _servicesPath];
-	  if (data)
+	  /* make_services rewrites the cache whenever the workspace
+	   * changes, usually with the same content, so we only parse
+	   * the file if what it contains is new to us.
+	   */
+	  if (data != nil && [data isEqual: _servicesData] == NO)
 	    {
+	      ASSIGN(_servicesData, data);
 	      plist = [NSDeserializer deserializePropertyListFromData: data
 						    mutableContainers: YES];
 	      if (plist)
@@ -906,10 +915,10 @@ static NSString         *disabledName = @".GNUstepDisabled";
     {
       /* If we have changed the enabled/disabled services,
        * or there have been services added/removed
-       * then we must rebuild the services menu to add/remove
-       * items as appropriate.
+       * then we must work out the usable services again and
+       * add/remove items in the services menu as appropriate.
        */
-      [self rebuildServicesMenu];
+      [self rebuildServices];
     }
 }
 
@@ -1011,6 +1020,116 @@ static NSString         *disabledName = @".GNUstepDisabled";
     }
 }
 
+/*
+ * Brings the items of menu into line with entries, reusing the items
+ * already present for the same titles, so that a change in the available
+ * services only adds or removes the affected items.  Each entry is a
+ * dictionary with a Title and either a KeyEquivalent and Tag for a
+ * service item or an array of Items for a submenu.
+ * Returns YES if any item was added or removed.
+ */
+static BOOL
+syncServicesMenu(NSMenu *menu, NSArray *entries, id target)
+{
+  NSMutableSet  *titles;
+  NSUInteger    count = [entries count];
+  NSUInteger    pos;
+  BOOL          changed = NO;
+
+  titles = [NSMutableSet setWithCapacity: count];
+  for (pos = 0; pos < count; pos++)
+    {
+      [titles addObject: [[entries objectAtIndex: pos] objectForKey: @"Title"]];
+    }
+  for (pos = [menu numberOfItems]; pos > 0; pos--)
+    {
+      if ([titles member: [[menu itemAtIndex: pos - 1] title]] == nil)
+        {
+          [menu removeItemAtIndex: pos - 1];
+          changed = YES;
+        }
+    }
+
+  for (pos = 0; pos < count; pos++)
+    {
+      NSDictionary      *entry = [entries objectAtIndex: pos];
+      NSString          *title = [entry objectForKey: @"Title"];
+      NSArray           *items = [entry objectForKey: @"Items"];
+      NSString          *equiv = [entry objectForKey: @"KeyEquivalent"];
+      id<NSMenuItem>    item = nil;
+      NSInteger         index;
+
+      for (index = pos; index < [menu numberOfItems]; index++)
+        {
+          id<NSMenuItem>        old = [menu itemAtIndex: index];
+
+          if ([[old title] isEqual: title]
+            && ([old hasSubmenu] == (items != nil)))
+            {
+              item = old;
+              break;
+            }
+        }
+      if (item != nil && index != pos)
+        {
+          RETAIN(item);
+          [menu removeItemAtIndex: index];
+          [menu insertItem: item atIndex: pos];
+          RELEASE(item);
+          changed = YES;
+        }
+      else if (item == nil)
+        {
+          if (items != nil)
+            {
+              NSMenu    *submenu;
+
+              item = [menu insertItemWithTitle: title
+                                        action: 0
+                                 keyEquivalent: @""
+                                       atIndex: pos];
+              submenu = [[NSMenu alloc] initWithTitle: title];
+              [menu setSubmenu: submenu forItem: item];
+              RELEASE(submenu);
+            }
+          else
+            {
+              item = [menu insertItemWithTitle: title
+                                        action: @selector(doService:)
+                                 keyEquivalent: equiv
+                                       atIndex: pos];
+              [item setTarget: target];
+            }
+          changed = YES;
+        }
+
+      if (items != nil)
+        {
+          NSMenu        *submenu = (NSMenu*)[item submenu];
+
+          if (syncServicesMenu(submenu, items, target) == YES)
+            {
+              [submenu sizeToFit];
+              [submenu update];
+            }
+        }
+      else
+        {
+          if ([[item keyEquivalent] isEqual: equiv] == NO)
+            {
+              [item setKeyEquivalent: equiv];
+            }
+          [item setTag: [[entry objectForKey: @"Tag"] intValue]];
+        }
+    }
+  while ([menu numberOfItems] > count)
+    {
+      [menu removeItemAtIndex: count];
+      changed = YES;
+    }
+  return changed;
+}
+
 /** Adds or removes items in the services menu in response to a change
  * in the services which are available to the app.
  */
@@ -1018,33 +1137,31 @@ static NSString         *disabledName = @".GNUstepDisabled";
 {
   if (_servicesMenu != nil)
     {
-      NSMutableSet      *keyEquivalents;
-      NSUInteger        pos;
-      NSUInteger        loc0;
-      NSUInteger        loc1 = 0;
-      SEL               sel = @selector(doService:);
-      NSMenu            *submenu = nil;
-
-      [_servicesMenu setAutoenablesItems: NO];
-      for (pos = [_servicesMenu numberOfItems]; pos > 0; pos--)
-        {
-          [_servicesMenu removeItemAtIndex: 0];
-        }
-      [_servicesMenu setAutoenablesItems: YES];
+      NSMutableSet              *keyEquivalents;
+      NSMutableArray            *entries;
+      NSMutableDictionary       *submenus;
+      NSUInteger                pos;
 
       keyEquivalents = [NSMutableSet setWithCapacity: 4];
-      for (loc0 = pos = 0; pos < [_menuTitles count]; pos++)
+      entries = [NSMutableArray arrayWithCapacity: [_menuTitles count]];
+      submenus = [NSMutableDictionary dictionaryWithCapacity: 4];
+      for (pos = 0; pos < [_menuTitles count]; pos++)
         {
           NSString      *title = [_menuTitles objectAtIndex: pos];
-          NSString      *equiv = @"";
+          NSString      *equiv = nil;
           NSDictionary  *info;
           NSDictionary  *titles;
           NSDictionary  *equivs;
+          NSDictionary  *entry;
+          NSMutableArray *items = entries;
           NSRange       r;
           NSUInteger    lang;
-          id<NSMenuItem>        item;
 
-          if (NSShowsServicesMenuItem(title) == NO)
+          /* rebuildServices has left out disabled items already, so we
+           * check the set we have rather than going through
+           * NSShowsServicesMenuItem(), which rereads the files.
+           */
+          if ([_allDisabled member: title] != nil)
             {
               continue; // We don't want to show this one.
             }
@@ -1086,57 +1203,39 @@ static NSString         *disabledName = @".GNUstepDisabled";
                   equiv = @"";
                 }
             }
+          else
+            {
+              equiv = @"";
+            }
 
           r = [title rangeOfString: @"/"];
           if (r.length > 0)
             {
-              NSString  *subtitle = [title substringFromIndex: r.location+1];
-              NSString  *parentTitle = [title substringToIndex: r.location];
-              NSMenu    *menu;
+              NSString          *subtitle;
+              NSString          *parentTitle;
 
-              item = [_servicesMenu itemWithTitle: parentTitle];
-              if (item == nil)
-                {
-                  loc1 = 0;
-                  item = [_servicesMenu insertItemWithTitle: parentTitle
-                                                    action: 0
-                                             keyEquivalent: @""
-                                                   atIndex: loc0++];
-                  menu = [[NSMenu alloc] initWithTitle: parentTitle];
-                  [_servicesMenu setSubmenu: menu
-                                   forItem: item];
-                  RELEASE(menu);
-                }
-              else
-                {
-                  menu = (NSMenu*)[item submenu];
-                }
-              if (menu != submenu)
+              subtitle = [title substringFromIndex: r.location+1];
+              parentTitle = [title substringToIndex: r.location];
+              items = [submenus objectForKey: parentTitle];
+              if (items == nil)
                 {
-                  [submenu sizeToFit];
-                  submenu = menu;
+                  items = [NSMutableArray arrayWithCapacity: 4];
+                  [submenus setObject: items forKey: parentTitle];
+                  [entries addObject: [NSDictionary dictionaryWithObjectsAndKeys:
+                    parentTitle, @"Title", items, @"Items", nil]];
                 }
-              item = [submenu insertItemWithTitle: subtitle
-                                           action: sel
-                                    keyEquivalent: equiv
-                                          atIndex: loc1++];
-              [item setTarget: self];
-              [item setTag: pos];
-            }
-          else
-            {
-              item = [_servicesMenu insertItemWithTitle: title
-                                                action: sel
-                                         keyEquivalent: equiv
-                                               atIndex: loc0++];
-              [item setTarget: self];
-              [item setTag: pos];
+              title = subtitle;
             }
+          entry = [NSDictionary dictionaryWithObjectsAndKeys:
+            title, @"Title", equiv, @"KeyEquivalent",
+            [NSNumber numberWithUnsignedInteger: pos], @"Tag", nil];
+          [items addObject: entry];
+        }
+
+      if (syncServicesMenu(_servicesMenu, entries, self) == YES)
+        {
+          [_servicesMenu update];
         }
-      [submenu update];
-//      [submenu sizeToFit];
-//      [_servicesMenu sizeToFit];
-      [_servicesMenu update];
     }
 }
 
@@ -1343,6 +1442,36 @@ static NSString         *disabledName = @".GNUstepDisabled";
   return NO;
 }
 
+/*
+ * Returns YES if resp has a valid requestor for the types.  While the
+ * services menu is being updated the answers are remembered, since many
+ * services share the same types and each lookup walks the responder chain.
+ */
+- (BOOL) hasRequestor: (NSResponder*)resp
+          forSendType: (NSString*)sendType
+           returnType: (NSString*)returnType
+{
+  NSString      *key;
+  NSNumber      *found;
+
+  if (_requestors == nil)
+    {
+      return [resp validRequestorForSendType: sendType
+                                  returnType: returnType] != nil;
+    }
+  key = [NSString stringWithFormat: @"%@\n%@",
+    sendType ? sendType : @"", returnType ? returnType : @""];
+  found = [_requestors objectForKey: key];
+  if (found == nil)
+    {
+      found = [NSNumber numberWithBool:
+        [resp validRequestorForSendType: sendType
+                             returnType: returnType] != nil];
+      [_requestors setObject: found forKey: key];
+    }
+  return [found boolValue];
+}
+
 - (BOOL) validateMenuItem: (id<NSMenuItem>)item
 {
   NSString      *title = [self item2title: item];
@@ -1390,8 +1519,9 @@ static NSString         *disabledName = @".GNUstepDisabled";
     {
       if (er == 0)
 	{
-	  if ([resp validRequestorForSendType: nil
-				   returnType: nil] != nil)
+	  if ([self hasRequestor: resp
+		     forSendType: nil
+		      returnType: nil])
 	    return YES;
 	}
       else
@@ -1401,8 +1531,9 @@ static NSString         *disabledName = @".GNUstepDisabled";
 	      NSString      *returnType;
 
 	      returnType = [returnTypes objectAtIndex: j];
-	      if ([resp validRequestorForSendType: nil
-				       returnType: returnType] != nil)
+	      if ([self hasRequestor: resp
+			 forSendType: nil
+			  returnType: returnType])
 		return YES;
 	    }
 	}
@@ -1417,8 +1548,9 @@ static NSString         *disabledName = @".GNUstepDisabled";
 
 	  if (er == 0)
 	    {
-	      if ([resp validRequestorForSendType: sendType
-				       returnType: nil] != nil)
+	      if ([self hasRequestor: resp
+			 forSendType: sendType
+			  returnType: nil])
 		return YES;
 	    }
 	  else
@@ -1428,8 +1560,9 @@ static NSString         *disabledName = @".GNUstepDisabled";
 		  NSString      *returnType;
 
 		  returnType = [returnTypes objectAtIndex: j];
-		  if ([resp validRequestorForSendType: sendType
-					   returnType: returnType] != nil)
+		  if ([self hasRequestor: resp
+			     forSendType: sendType
+			      returnType: returnType])
 		    return YES;
 		}
 	    }
@@ -1445,6 +1578,7 @@ static NSString         *disabledName = @".GNUstepDisabled";
       NSArray   	*a;
       unsigned  	i;
 
+      _requestors = [[NSMutableDictionary alloc] initWithCapacity: 8];
       a = [_servicesMenu itemArray];
 
       for (i = 0; i < [a count]; i++)
@@ -1497,6 +1631,7 @@ static NSString         *disabledName = @".GNUstepDisabled";
               [item setEnabled: shouldBeEnabled];
             }
         }
+      DESTROY(_requestors);
     }
 }
 
@@ -335,6 +335,7 @@ calc_new_frame(NSRect frame, NSPoint point, NSPoint firstPoint,
   maxSize = [window maxSize];
 
   [window _captureMouse: nil];
+  [window _startLiveResize];
   [NSEvent startPeriodicEventsAfterDelay: 0.1 withPeriod: 0.1];
   do
     {
@@ -369,6 +370,7 @@ calc_new_frame(NSRect frame, NSPoint point, NSPoint firstPoint,
   [window _releaseMouse: nil];
 
   [window setFrame: newFrame  display: YES];
+  [window _endLiveResize];
 }
 
 - (BOOL) acceptsFirstMouse: (NSEvent*)theEvent
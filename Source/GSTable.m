@@ -385,13 +385,17 @@
       
       // Resize the column
       _columnDimension[column] = theFrame.size.width;
-      [self _updateColumnSize: column];
+      if (_updatesDisabled)
+	_needsWholeUpdate = YES;
+      else
+	[self _updateColumnSize: column];
       
       // Shift the columns on the right 
       for (i = column + 1; i < _numberOfColumns; i++)
 	{
 	  _columnXOrigin[i] += xShift;
-	  [self _updateColumnOrigin: i];
+	  if (!_updatesDisabled)
+	    [self _updateColumnOrigin: i];
 	}
     }
   else // theFrame.size.width <= _columnDimension[column]
@@ -412,13 +416,17 @@
 
       // Resize the row
       _rowDimension[row] = theFrame.size.height;
-      [self _updateRowSize: row];
+      if (_updatesDisabled)
+	_needsWholeUpdate = YES;
+      else
+	[self _updateRowSize: row];
 
       // Shift the rows on the top 
       for (i = row + 1; i < _numberOfRows; i++)
 	{
 	  _rowYOrigin[i] += yShift;
-	  [self _updateRowOrigin: i];
+	  if (!_updatesDisabled)
+	    [self _updateRowOrigin: i];
 	}
     }
   else // theFrame.size.height <= _rowDimension[row]
@@ -543,7 +551,10 @@
       _rowYOrigin[i] = _rowYOrigin[i - 1] + _rowDimension[i - 1];
       _rowDimension[i] = _minRowDimension[i];
     }
-  [self _updateWholeTable];
+  if (_updatesDisabled)
+    _needsWholeUpdate = YES;
+  else
+    [self _updateWholeTable];
   [super setFrameSize: _minimumSize];
 }
 
@@ -740,6 +751,27 @@
   return _numberOfColumns;
 }
 
+//
+// Batching Updates
+//
+-(void) beginUpdates
+{
+  _updatesDisabled++;
+}
+
+-(void) endUpdates
+{
+  if (_updatesDisabled == 0)
+    {
+      NSLog (@"Warning: -endUpdates without -beginUpdates\n");
+      return;
+    }
+  if (--_updatesDisabled == 0 && _needsWholeUpdate)
+    {
+      [self _updateWholeTable];
+    }
+}
+
 //
 // NSCoding protocol
 //
@@ -1090,7 +1122,10 @@
 
   if (tableNeedUpdate)
     {
-      [self _updateWholeTable];
+      if (_updatesDisabled)
+	_needsWholeUpdate = YES;
+      else
+	[self _updateWholeTable];
     }
 }
 
@@ -1167,17 +1202,19 @@
 {
   int i,j;
   
-  for (j = 0; j < _numberOfColumns; j++)
-    for (i = 0; i < _numberOfRows; i++)
+  _needsWholeUpdate = NO;
+  // One pass over the jails, touching only those which move or change size
+  for (i = 0; i < _numberOfRows; i++)
+    for (j = 0; j < _numberOfColumns; j++)
       {
 	if (_havePrisoner[(i * _numberOfColumns) + j])
 	  {
-	    [_jails[(i * _numberOfColumns) + j] 
-		   setFrameOrigin: NSMakePoint (_columnXOrigin[j],
-						_rowYOrigin[i])];
-	    [_jails[(i * _numberOfColumns) + j]
-		   setFrameSize: NSMakeSize (_columnDimension[j],
-					     _rowDimension[i])];
+	    NSView *jail = _jails[(i * _numberOfColumns) + j];
+	    NSRect frame = NSMakeRect (_columnXOrigin[j], _rowYOrigin[i],
+				       _columnDimension[j], _rowDimension[i]);
+
+	    if (!NSEqualRects ([jail frame], frame))
+	      [jail setFrame: frame];
 	  }
       }
 }
@@ -37,6 +37,7 @@
 @class NSMatrix;
 @class NSPanel;
 @class NSTextField;
+@class NSTextView;
 
 @interface GSTextFinder : NSObject
 {
@@ -51,6 +52,11 @@
   NSTextField *messageText;
   NSMatrix *replaceScopeMatrix;
   NSButton *ignoreCaseButton;
+
+  // find all
+  id search;
+  NSTextView *searchView;
+  NSUInteger numFound;
 }
 
 // return shared panel instance
@@ -75,6 +81,9 @@
 - (void) replaceStringInTextView: (NSTextView *)aTextView;
 - (void) replaceAllInTextView: (NSTextView *)aTextView
 	      onlyInSelection: (BOOL)flag;
+- (void) findAllInTextView: (NSTextView *)aTextView
+	   onlyInSelection: (BOOL)flag;
+- (void) cancelFindAll;
 - (NSTextView *) targetView: (NSTextView *)aTextView;
 
 @end
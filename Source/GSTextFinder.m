@@ -25,18 +25,27 @@
 */
 
 #import "config.h"
+#import <Foundation/NSArray.h>
+#import <Foundation/NSAutoreleasePool.h>
 #import <Foundation/NSString.h>
 #import <Foundation/NSNotification.h>
+#import <Foundation/NSThread.h>
+#import <Foundation/NSValue.h>
+#import <GNUstepBase/Unicode.h>
 #import "AppKit/NSApplication.h"
+#import "AppKit/NSAttributedString.h"
 #import "AppKit/NSButton.h"
+#import "AppKit/NSColor.h"
 #import "AppKit/NSEvent.h"
 #import "AppKit/NSGraphics.h"
+#import "AppKit/NSLayoutManager.h"
 #import "AppKit/NSMatrix.h"
 #import "AppKit/NSNib.h"
 #import "AppKit/NSNibLoading.h"
 #import "AppKit/NSPanel.h"
 #import "AppKit/NSPasteboard.h"
 #import "AppKit/NSTextField.h"
+#import "AppKit/NSTextStorage.h"
 #import "AppKit/NSTextView.h"
 #import "AppKit/NSWindow.h"
 #import "GSGuiPrivate.h"
@@ -51,6 +60,213 @@
 - (void) _updateReplaceStringFromPanel;
 - (void) _getFindStringFromPasteboard;
 - (void) _putFindStringToPasteboard;
+- (void) _textStorageDidProcessEditing: (NSNotification *)notification;
+@end
+
+/*
+ * Finds all matches of a string in a snapshot of a text, using the
+ * Boyer-Moore-Horspool algorithm on the UTF-16 characters. Case
+ * insensitive searches compare characters folded with uni_tolower,
+ * like NSLiteralSearch | NSCaseInsensitiveSearch does.
+ *
+ * The search can run synchronously or on a background thread, in which
+ * case the matches are passed to the target in batches on the main
+ * thread by -textSearch:didFindMatches: and -textSearchDidFinish:.
+ */
+@interface GSTextSearch : NSObject
+{
+  unichar *text;
+  NSUInteger length;
+  NSUInteger offset;
+  unichar *pattern;
+  NSUInteger patternLength;
+  BOOL ignoreCase;
+  NSUInteger skip[256];
+  id target;
+  volatile BOOL cancelled;
+}
+- (id) initWithString: (NSString *)string
+		range: (NSRange)range
+	 searchString: (NSString *)searchString
+	      options: (unsigned)options;
+- (NSArray *) allMatches;
+- (void) startWithTarget: (id)aTarget;
+- (void) cancel;
+@end
+
+@interface NSObject (GSTextSearchTarget)
+- (void) textSearch: (GSTextSearch *)search didFindMatches: (NSArray *)matches;
+- (void) textSearchDidFinish: (GSTextSearch *)search;
+@end
+
+/* Number of characters searched between progress reports. */
+#define SEARCH_CHUNK (1024 * 1024)
+
+static inline unichar
+fold(unichar c, BOOL ignoreCase)
+{
+  if (!ignoreCase)
+    return c;
+  if (c < 128)
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+  return uni_tolower(c);
+}
+
+@implementation GSTextSearch
+
+- (id) initWithString: (NSString *)string
+		range: (NSRange)range
+	 searchString: (NSString *)searchString
+	      options: (unsigned)options
+{
+  NSUInteger i;
+
+  if ((self = [super init]) == nil)
+    return nil;
+
+  length = range.length;
+  offset = range.location;
+  text = NSZoneMalloc(NSDefaultMallocZone(), (length + 1) * sizeof(unichar));
+  [string getCharacters: text range: range];
+
+  patternLength = [searchString length];
+  pattern = NSZoneMalloc(NSDefaultMallocZone(),
+			 (patternLength + 1) * sizeof(unichar));
+  [searchString getCharacters: pattern];
+  ignoreCase = (options & NSCaseInsensitiveSearch) != 0;
+  for (i = 0; i < patternLength; i++)
+    pattern[i] = fold(pattern[i], ignoreCase);
+
+  /*
+  The shift table is indexed by the low byte of a character, so distinct
+  characters may share an entry. Taking the smallest shift for each entry
+  keeps the search correct.
+  */
+  for (i = 0; i < 256; i++)
+    skip[i] = patternLength;
+  for (i = 0; i + 1 < patternLength; i++)
+    skip[pattern[i] & 0xff] = patternLength - 1 - i;
+
+  return self;
+}
+
+- (void) dealloc
+{
+  NSZoneFree(NSDefaultMallocZone(), text);
+  NSZoneFree(NSDefaultMallocZone(), pattern);
+  RELEASE(target);
+  [super dealloc];
+}
+
+/*
+Appends the matches starting before end to matches, beginning the search
+at *pos, and leaves *pos at the first position that hasn't been tried.
+*/
+- (void) _findMatchesBefore: (NSUInteger)end
+		   position: (NSUInteger *)pos
+		    inArray: (NSMutableArray *)matches
+{
+  NSUInteger i = *pos;
+  NSUInteger last = patternLength - 1;
+  BOOL atEnd = NO;
+
+  if (patternLength == 0 || patternLength > length)
+    {
+      *pos = length;
+      return;
+    }
+  if (end >= length - patternLength + 1)
+    {
+      end = length - patternLength + 1;
+      atEnd = YES;
+    }
+
+  while (i < end)
+    {
+      unichar c = fold(text[i + last], ignoreCase);
+      NSInteger j;
+
+      if (c == pattern[last])
+	{
+	  for (j = last - 1; j >= 0; j--)
+	    {
+	      if (fold(text[i + j], ignoreCase) != pattern[j])
+		break;
+	    }
+	  if (j < 0)
+	    {
+	      [matches addObject: [NSValue valueWithRange:
+		NSMakeRange(offset + i, patternLength)]];
+	      i += patternLength;
+	      continue;
+	    }
+	}
+      i += skip[c & 0xff];
+    }
+  *pos = atEnd ? length : i;
+}
+
+- (NSArray *) allMatches
+{
+  NSMutableArray *matches = [NSMutableArray array];
+  NSUInteger pos = 0;
+
+  [self _findMatchesBefore: length position: &pos inArray: matches];
+  return matches;
+}
+
+- (void) _deliverMatches: (NSArray *)matches
+{
+  if (!cancelled)
+    [target textSearch: self didFindMatches: matches];
+}
+
+- (void) _finish: (id)unused
+{
+  if (!cancelled)
+    [target textSearchDidFinish: self];
+  DESTROY(target);
+}
+
+- (void) _search: (id)unused
+{
+  NSUInteger pos = 0;
+
+  while (pos < length && !cancelled)
+    {
+      CREATE_AUTORELEASE_POOL(pool);
+      NSMutableArray *matches = [NSMutableArray new];
+
+      [self _findMatchesBefore: pos + SEARCH_CHUNK
+		      position: &pos
+		       inArray: matches];
+      if ([matches count] > 0)
+	{
+	  [self performSelectorOnMainThread: @selector(_deliverMatches:)
+				 withObject: matches
+			      waitUntilDone: NO];
+	}
+      RELEASE(matches);
+      DESTROY(pool);
+    }
+  [self performSelectorOnMainThread: @selector(_finish:)
+			 withObject: nil
+		      waitUntilDone: NO];
+}
+
+- (void) startWithTarget: (id)aTarget
+{
+  ASSIGN(target, aTarget);
+  [NSThread detachNewThreadSelector: @selector(_search:)
+			   toTarget: self
+			 withObject: nil];
+}
+
+- (void) cancel
+{
+  cancelled = YES;
+}
+
 @end
 
 @implementation GSTextFinder
@@ -93,6 +309,7 @@ static GSTextFinder *sharedTextFinder;
 	      name: NSApplicationDidBecomeActiveNotification
 	    object: NSApp];
 
+  [self cancelFindAll];
   DESTROY(findString);
   DESTROY(replaceString);
   [super dealloc];
@@ -191,12 +408,14 @@ static GSTextFinder *sharedTextFinder;
       [self replaceAllInTextView: aTextView onlyInSelection: YES];
       break;
 
+    // NSTextView does not support discontinuous selections at present, so
+    // we highlight all matches instead of selecting them
     case NSFindPanelActionSelectAll:
-      NSLog(@"NSFindPanelActionSelectAll not supported");
+      [self findAllInTextView: aTextView onlyInSelection: NO];
       break;
 
     case NSFindPanelActionSelectAllInSelection:
-      NSLog(@"NSFindPanelActionSelectAllInSelection not supported");
+      [self findAllInTextView: aTextView onlyInSelection: YES];
       break;
 
     default:
@@ -223,15 +442,11 @@ static GSTextFinder *sharedTextFinder;
     case NSFindPanelActionPrevious:
     case NSFindPanelActionReplaceAll:
     case NSFindPanelActionReplaceAndFind:
-#if 0 // NSTextView does not support discontinuous selections at present
     case NSFindPanelActionSelectAll:
-#endif
       return aTextView && [findString length] > 0;
 
     case NSFindPanelActionReplaceAllInSelection:
-#if 0 // NSTextView does not support discontinuous selections at present
     case NSFindPanelActionSelectAllInSelection:
-#endif
       return [findString length] > 0
 	  && aTextView && [aTextView selectedRange].length > 0;
 
@@ -357,10 +572,15 @@ static GSTextFinder *sharedTextFinder;
 - (void) replaceAllInTextView: (NSTextView *)aTextView
 	      onlyInSelection: (BOOL)flag
 {
-  int n;
-  NSRange range, replaceRange;
+  int n, i;
+  NSRange range, replaceRange, first, last;
+  NSUInteger pos;
   NSString *format;
   NSString *string;
+  NSMutableString *replacement;
+  NSTextStorage *textStorage;
+  GSTextSearch *textSearch;
+  NSArray *matches;
   unsigned int options = NSLiteralSearch | NSCaseInsensitiveSearch;
   [messageText setStringValue: @""];
   if (aTextView == nil)
@@ -372,48 +592,169 @@ static GSTextFinder *sharedTextFinder;
   replaceRange =
     flag ? [aTextView selectedRange] : NSMakeRange(0, [string length]);
 
-  // look for a first match in the range
-  range = [string rangeOfString: findString
-			options: options
-			  range: replaceRange];
-  if (range.location == NSNotFound)
+  textSearch = [[GSTextSearch alloc] initWithString: string
+					      range: replaceRange
+				       searchString: findString
+					    options: options];
+  matches = [textSearch allMatches];
+  RELEASE(textSearch);
+
+  n = [matches count];
+  if (n == 0)
     {
       [messageText setStringValue: _(@"Not found")];
       NSBeep();
       return;
     }
 
-  n = 0;
-  do
+  // Ask for and record a single change covering all matches, so that the
+  // delegate is consulted once and the replacement is undone in one step
+  first = [[matches objectAtIndex: 0] rangeValue];
+  last = [[matches lastObject] rangeValue];
+  replaceRange = NSMakeRange(first.location, NSMaxRange(last) - first.location);
+  replacement = [NSMutableString stringWithCapacity: replaceRange.length];
+  pos = first.location;
+  for (i = 0; i < n; i++)
     {
-      if ([aTextView shouldChangeTextInRange: range
-			   replacementString: replaceString])
+      range = [[matches objectAtIndex: i] rangeValue];
+      [replacement appendString: [string substringWithRange:
+	NSMakeRange(pos, range.location - pos)]];
+      [replacement appendString: replaceString];
+      pos = NSMaxRange(range);
+    }
+
+  if (![aTextView shouldChangeTextInRange: replaceRange
+			replacementString: replacement])
+    {
+      n = 0;
+    }
+  else
+    {
+      // Replace the matches back to front, so that the ranges of the
+      // remaining matches stay valid; this keeps the attributes of the
+      // text between the matches
+      textStorage = [aTextView textStorage];
+      [textStorage beginEditing];
+      for (i = n - 1; i >= 0; i--)
 	{
-	  [aTextView replaceCharactersInRange: range
+	  [aTextView replaceCharactersInRange:
+		       [[matches objectAtIndex: i] rangeValue]
 				   withString: replaceString];
-	  [aTextView didChangeText];
-	  n++;
 	}
-
-      replaceRange =
-	NSMakeRange(range.location + [replaceString length],
-		    NSMaxRange(replaceRange) -
-		    (range.location + [findString length]));
-      range = [string rangeOfString: findString
-			    options: options
-			      range: replaceRange];
+      [textStorage endEditing];
+      [aTextView didChangeText];
     }
-  while (range.location != NSNotFound);
 
   format = _(@"%d replaced");
   [messageText setStringValue: [NSString stringWithFormat: format, n]];
 
+  if (n == 0)
+    return;
+
   // set insertion point to the end of the last match
-  range = NSMakeRange(replaceRange.location, 0);
+  range = NSMakeRange(replaceRange.location + [replacement length], 0);
   [aTextView setSelectedRange: range];
   [aTextView scrollRangeToVisible: range];
 }
 
+- (void) findAllInTextView: (NSTextView *)aTextView
+	   onlyInSelection: (BOOL)flag
+{
+  NSRange range;
+  NSString *string;
+  unsigned int options = NSLiteralSearch | NSCaseInsensitiveSearch;
+
+  [self cancelFindAll];
+  [messageText setStringValue: @""];
+  if (aTextView == nil)
+    return;
+
+  [self _updateFindStringFromPanel: &options putToPasteboard: YES];
+  string = [aTextView string];
+  range = flag ? [aTextView selectedRange] : NSMakeRange(0, [string length]);
+
+  ASSIGN(searchView, aTextView);
+  numFound = 0;
+  search = [[GSTextSearch alloc] initWithString: string
+					  range: range
+				   searchString: findString
+					options: options];
+
+  // The search works on a copy of the text, so stop it and remove the
+  // highlights when the text is changed
+  [[NSNotificationCenter defaultCenter]
+    addObserver: self
+       selector: @selector(_textStorageDidProcessEditing:)
+	   name: NSTextStorageDidProcessEditingNotification
+	 object: [aTextView textStorage]];
+
+  [messageText setStringValue: _(@"Searching...")];
+  [search startWithTarget: self];
+}
+
+- (void) cancelFindAll
+{
+  [search cancel];
+  DESTROY(search);
+  if (searchView != nil)
+    {
+      [[NSNotificationCenter defaultCenter]
+	removeObserver: self
+		  name: NSTextStorageDidProcessEditingNotification
+		object: nil];
+      [[searchView layoutManager]
+	removeTemporaryAttribute: NSBackgroundColorAttributeName
+	       forCharacterRange: NSMakeRange(0, [[searchView string] length])];
+      DESTROY(searchView);
+    }
+}
+
+- (void) textSearch: (GSTextSearch *)aSearch didFindMatches: (NSArray *)matches
+{
+  NSLayoutManager *lm = [searchView layoutManager];
+  NSUInteger length = [[searchView string] length];
+  NSUInteger i;
+
+  if (aSearch != search)
+    return;
+
+  for (i = 0; i < [matches count]; i++)
+    {
+      NSRange range = [[matches objectAtIndex: i] rangeValue];
+
+      if (NSMaxRange(range) > length)
+	break;
+      [lm addTemporaryAttribute: NSBackgroundColorAttributeName
+			  value: [NSColor yellowColor]
+	      forCharacterRange: range];
+      if (numFound++ == 0)
+	{
+	  [searchView setSelectedRange: range];
+	  [searchView scrollRangeToVisible: range];
+	}
+    }
+  [messageText setStringValue:
+    [NSString stringWithFormat: _(@"%d found"), (int)numFound]];
+}
+
+- (void) textSearchDidFinish: (GSTextSearch *)aSearch
+{
+  if (aSearch != search)
+    return;
+
+  DESTROY(search);
+  if (numFound == 0)
+    {
+      [messageText setStringValue: _(@"Not found")];
+      NSBeep();
+    }
+  else
+    {
+      [messageText setStringValue:
+	[NSString stringWithFormat: _(@"%d found"), (int)numFound]];
+    }
+}
+
 - (NSTextView *) targetView: (NSTextView *)aTextView
 {
   // If aTextView is equal to the find panel's field editor use the default
@@ -524,4 +865,14 @@ static GSTextFinder *sharedTextFinder;
     [pboard setString: findString forType: NSStringPboardType];
 }
 
+- (void) _textStorageDidProcessEditing: (NSNotification *)notification
+{
+  [search cancel];
+  // The layout manager hasn't been told about the edit yet, so wait with
+  // removing the highlights
+  [self performSelector: @selector(cancelFindAll)
+	     withObject: nil
+	     afterDelay: 0];
+}
+
 @end
@@ -41,3 +41,26 @@
 }
 @end
 
+struct GSRopeNode_s;
+
+/*
+ * Alternative concrete class keeping the characters in a piece table and
+ * the attribute runs in a balanced tree, so that edits in the middle of
+ * large texts do not have to move the rest of the text or its runs.
+ */
+@interface GSRopeTextStorage : NSTextStorage
+{
+  NSMutableString	*_textChars;
+  struct GSRopeNode_s	*_runs;
+  NSString		*_textProxy;
+}
+@end
+
+
+/*
+ * Return the number of lookups in the attribute dictionary cache which
+ * found an existing dictionary, the number which added one, and the
+ * number of dictionaries currently in the cache.
+ */
+extern void GSTextStorageAttributeCacheStatistics(NSUInteger *hits,
+  NSUInteger *misses, NSUInteger *entries);
@@ -57,26 +57,72 @@
 
 #define		SANITY_CHECKS	0
 
+/*
+ * Hash an attributes dictionary by its keys.  The default dictionary hash
+ * is just the number of entries, which puts most attribute dictionaries
+ * in a handful of buckets.  Values are not hashed because some attribute
+ * values do not implement -hash consistently with -isEqual:
+ */
+static NSUInteger
+attrHash(NSDictionary *attrs)
+{
+  NSUInteger	count = [attrs count];
+  NSUInteger	h = count;
+
+  if (count <= 32)
+    {
+      id	keys[32];
+      id	objs[32];
+      NSUInteger	i;
+
+      [attrs getObjects: objs andKeys: keys];
+      for (i = 0; i < count; i++)
+	{
+	  h += [keys[i] hash];
+	}
+    }
+  return h;
+}
+
 #define	GSI_MAP_RETAIN_KEY(M, X)	
 #define	GSI_MAP_RELEASE_KEY(M, X)	
 #define	GSI_MAP_RETAIN_VAL(M, X)	
 #define	GSI_MAP_RELEASE_VAL(M, X)	
+#define	GSI_MAP_HASH(M, X)	attrHash((X).obj)
 #define	GSI_MAP_EQUAL(M, X,Y)	[(X).obj isEqualToDictionary: (Y).obj]
 #define GSI_MAP_KTYPES	GSUNION_OBJ
 #define GSI_MAP_VTYPES	GSUNION_NSINT
 #define	GSI_MAP_NOCLEAN	1
 #include <GNUstepBase/GSIMap.h>
 
+/*
+ * The attribute dictionary cache is split into stripes, each with its
+ * own map, lock and counters, so that threads interning different
+ * dictionaries rarely wait for each other.  The stripe is chosen from
+ * the same hash as the map buckets.  The locks are only created once the
+ * process becomes multi-threaded.
+ */
+#define	ATTR_STRIPE_BITS	4
+#define	ATTR_STRIPES		(1 << ATTR_STRIPE_BITS)
+
+typedef struct {
+  NSLock		*lock;
+  GSIMapTable_t		map;
+  NSUInteger		hits;
+  NSUInteger		misses;
+} attrStripe;
+
 static NSDictionary	*blank;
-static NSLock		*attrLock = nil;
-static __strong GSIMapTable_t	attrMap;
+static __strong attrStripe	attrStripes[ATTR_STRIPES];
 static SEL		lockSel;
 static SEL		unlockSel;
 static IMP		lockImp;
 static IMP		unlockImp;
 
-#define	ALOCK()	if (attrLock != nil) (*lockImp)(attrLock, lockSel)
-#define	AUNLOCK() if (attrLock != nil) (*unlockImp)(attrLock, unlockSel)
+#define	ASTRIPE(A)	(&attrStripes[((uint32_t)attrHash(A) * 2654435761U) \
+  >> (32 - ATTR_STRIPE_BITS)])
+#define	ALOCK(S)	if ((S)->lock != nil) (*lockImp)((S)->lock, lockSel)
+#define	AUNLOCK(S)	if ((S)->lock != nil) (*unlockImp)((S)->lock, unlockSel)
 
 @interface GSTextStorageProxy : NSProxy
 {
@@ -183,10 +229,11 @@ static Class NSStringClass = nil;
 static NSDictionary*
 cacheAttributes(NSDictionary *attrs)
 {
+  attrStripe	*stripe = ASTRIPE(attrs);
   GSIMapNode	node;
 
-  ALOCK();
-  node = GSIMapNodeForKey(&attrMap, (GSIMapKey)((id)attrs));
+  ALOCK(stripe);
+  node = GSIMapNodeForKey(&stripe->map, (GSIMapKey)((id)attrs));
   if (node == 0)
     {
       /*
@@ -194,42 +241,74 @@ cacheAttributes(NSDictionary *attrs)
        * in an immutable dictionary that can safely be cached.
        */
       attrs = [[NSDictionary alloc] initWithDictionary: attrs copyItems: NO];
-      GSIMapAddPair(&attrMap, (GSIMapKey)((id)attrs), (GSIMapVal)(NSUInteger)1);
+      GSIMapAddPair(&stripe->map,
+	(GSIMapKey)((id)attrs), (GSIMapVal)(NSUInteger)1);
+      stripe->misses++;
     }
   else
     {
       node->value.nsu++;
       attrs = RETAIN(node->key.obj);
+      stripe->hits++;
     }
-  AUNLOCK();
+  AUNLOCK(stripe);
   return attrs;
 }
 
 static void
 unCacheAttributes(NSDictionary *attrs)
 {
-  GSIMapBucket       bucket;
+  attrStripe	*stripe = ASTRIPE(attrs);
+  GSIMapBucket	bucket;
 
-  ALOCK();
-  bucket = GSIMapBucketForKey(&attrMap, (GSIMapKey)((id)attrs));
+  ALOCK(stripe);
+  bucket = GSIMapBucketForKey(&stripe->map, (GSIMapKey)((id)attrs));
   if (bucket != 0)
     {
       GSIMapNode     node;
 
-      node = GSIMapNodeForKeyInBucket(&attrMap, bucket, (GSIMapKey)((id)attrs));
+      node = GSIMapNodeForKeyInBucket(&stripe->map, bucket,
+	(GSIMapKey)((id)attrs));
       if (node != 0)
 	{
 	  if (--node->value.nsu == 0)
 	    {
-	      GSIMapRemoveNodeFromMap(&attrMap, bucket, node);
-	      GSIMapFreeNode(&attrMap, node);
+	      GSIMapRemoveNodeFromMap(&stripe->map, bucket, node);
+	      GSIMapFreeNode(&stripe->map, node);
 	    }
 	}
     }
-  AUNLOCK();
+  AUNLOCK(stripe);
 }
 
-
+void
+GSTextStorageAttributeCacheStatistics(NSUInteger *hits,
+  NSUInteger *misses, NSUInteger *entries)
+{
+  NSUInteger	h = 0;
+  NSUInteger	m = 0;
+  NSUInteger	e = 0;
+  NSUInteger	i;
+
+  for (i = 0; i < ATTR_STRIPES; i++)
+    {
+      attrStripe	*stripe = &attrStripes[i];
+
+      ALOCK(stripe);
+      h += stripe->hits;
+      m += stripe->misses;
+      e += stripe->map.nodeCount;
+      AUNLOCK(stripe);
+    }
+  if (hits != 0)
+    *hits = h;
+  if (misses != 0)
+    *misses = m;
+  if (entries != 0)
+    *entries = e;
+}
+
+
 
 @interface	GSTextInfo : NSObject
 {
@@ -344,8 +423,13 @@ static void _setup()
     {
       NSMutableArray	*a;
       NSDictionary	*d;
+      NSUInteger	i;
 
-      GSIMapInitWithZoneAndCapacity(&attrMap, NSDefaultMallocZone(), 32);
+      for (i = 0; i < ATTR_STRIPES; i++)
+	{
+	  GSIMapInitWithZoneAndCapacity(&attrStripes[i].map,
+	    NSDefaultMallocZone(), 8);
+	}
 
       infSel = @selector(newWithZone:value:at:);
       addSel = @selector(addObject:);
@@ -534,11 +618,16 @@ _attributesAtIndexEffectiveRange(NSUInteger index,
  */
 + (void) _becomeThreaded: (id)notification
 {
-  attrLock = [NSLock new];
+  NSUInteger	i;
+
   lockSel = @selector(lock);
   unlockSel = @selector(unlock);
-  lockImp = [attrLock methodForSelector: lockSel];
-  unlockImp = [attrLock methodForSelector: unlockSel];
+  lockImp = [NSLock instanceMethodForSelector: lockSel];
+  unlockImp = [NSLock instanceMethodForSelector: unlockSel];
+  for (i = 0; i < ATTR_STRIPES; i++)
+    {
+      attrStripes[i].lock = [NSLock new];
+    }
 }
 
 + (void) initialize
@@ -930,3 +1019,664 @@ changeInLength: [aString length] - range.length];
   return [_textChars length];
 }
 @end
+
+
+
+/*
+ * Balanced trees used by GSRopeTextStorage.
+ *
+ * Both the pieces of the character buffer and the attribute runs are kept
+ * in treaps ordered by position.  A node only records its own length and
+ * the total length of its subtree, so the position of a node is the sum
+ * of the lengths to its left and an edit never has to touch the nodes
+ * following it.  Piece nodes refer to a range of the character buffer
+ * (attrs is nil), run nodes hold a cached attributes dictionary.
+ */
+typedef struct GSRopeNode_s {
+  struct GSRopeNode_s	*left;
+  struct GSRopeNode_s	*right;
+  uint32_t		priority;
+  NSUInteger		length;	/* Characters covered by this node.	*/
+  NSUInteger		total;	/* Characters covered by the subtree.	*/
+  NSUInteger		offset;	/* Start in the buffer (pieces only).	*/
+  NSDictionary		*attrs;	/* Cached attributes (runs only).	*/
+} GSRopeNode;
+
+static uint32_t	ropeSeed = 2463534242U;
+
+static inline uint32_t
+ropePriority(void)
+{
+  ropeSeed ^= ropeSeed << 13;
+  ropeSeed ^= ropeSeed >> 17;
+  ropeSeed ^= ropeSeed << 5;
+  return ropeSeed;
+}
+
+static inline NSUInteger
+ropeTotal(GSRopeNode *n)
+{
+  return n != 0 ? n->total : 0;
+}
+
+static inline void
+ropeUpdate(GSRopeNode *n)
+{
+  n->total = n->length + ropeTotal(n->left) + ropeTotal(n->right);
+}
+
+static GSRopeNode *
+ropeNewNode(NSZone *z, NSUInteger length, NSUInteger offset,
+  NSDictionary *attrs)
+{
+  GSRopeNode	*n = NSZoneMalloc(z, sizeof(GSRopeNode));
+
+  n->left = n->right = 0;
+  n->priority = ropePriority();
+  n->length = n->total = length;
+  n->offset = offset;
+  n->attrs = attrs;
+  return n;
+}
+
+static void
+ropeFree(NSZone *z, GSRopeNode *n)
+{
+  if (n == 0)
+    return;
+  ropeFree(z, n->left);
+  ropeFree(z, n->right);
+  if (n->attrs != nil)
+    {
+      unCacheAttributes(n->attrs);
+      RELEASE(n->attrs);
+    }
+  NSZoneFree(z, n);
+}
+
+static GSRopeNode *
+ropeMerge(GSRopeNode *a, GSRopeNode *b)
+{
+  if (a == 0)
+    return b;
+  if (b == 0)
+    return a;
+  if (a->priority > b->priority)
+    {
+      a->right = ropeMerge(a->right, b);
+      ropeUpdate(a);
+      return a;
+    }
+  b->left = ropeMerge(a, b->left);
+  ropeUpdate(b);
+  return b;
+}
+
+/*
+ * Split the tree t into the nodes covering the first pos characters (l)
+ * and the rest (r).  A node straddling pos is cut in two.
+ */
+static void
+ropeSplit(NSZone *z, GSRopeNode *t, NSUInteger pos,
+  GSRopeNode **l, GSRopeNode **r)
+{
+  NSUInteger	ll;
+
+  if (t == 0)
+    {
+      *l = *r = 0;
+      return;
+    }
+  ll = ropeTotal(t->left);
+  if (pos <= ll)
+    {
+      ropeSplit(z, t->left, pos, l, &t->left);
+      ropeUpdate(t);
+      *r = t;
+    }
+  else if (pos >= ll + t->length)
+    {
+      ropeSplit(z, t->right, pos - ll - t->length, &t->right, r);
+      ropeUpdate(t);
+      *l = t;
+    }
+  else
+    {
+      NSUInteger	k = pos - ll;
+      GSRopeNode	*m;
+
+      m = ropeNewNode(z, t->length - k, t->offset + k,
+	t->attrs != nil ? cacheAttributes(t->attrs) : nil);
+      t->length = k;
+      *r = ropeMerge(m, t->right);
+      t->right = 0;
+      ropeUpdate(t);
+      *l = t;
+    }
+}
+
+/*
+ * Return the node containing the character at pos and its start.
+ */
+static GSRopeNode *
+ropeFind(GSRopeNode *t, NSUInteger pos, NSUInteger *start)
+{
+  NSUInteger	base = 0;
+
+  while (t != 0)
+    {
+      NSUInteger	ll = ropeTotal(t->left);
+
+      if (pos < ll)
+	{
+	  t = t->left;
+	}
+      else if (pos < ll + t->length)
+	{
+	  if (start != 0)
+	    *start = base + ll;
+	  return t;
+	}
+      else
+	{
+	  pos -= ll + t->length;
+	  base += ll + t->length;
+	  t = t->right;
+	}
+    }
+  return 0;
+}
+
+static inline GSRopeNode *
+ropeFirst(GSRopeNode *t)
+{
+  while (t->left != 0)
+    t = t->left;
+  return t;
+}
+
+static inline GSRopeNode *
+ropeLast(GSRopeNode *t)
+{
+  while (t->right != 0)
+    t = t->right;
+  return t;
+}
+
+/* Lengthen the last node of t by delta characters. */
+static void
+ropeGrowLast(GSRopeNode *t, NSUInteger delta)
+{
+  while (t->right != 0)
+    {
+      t->total += delta;
+      t = t->right;
+    }
+  t->total += delta;
+  t->length += delta;
+}
+
+/*
+ * Concatenate two trees, coalescing the nodes at the join when they
+ * continue each other: runs with the same attributes, or pieces which
+ * are adjacent in the buffer.  An empty run (only present in an empty
+ * text) is dropped when joined to anything else.
+ */
+static GSRopeNode *
+ropeJoin(NSZone *z, GSRopeNode *a, GSRopeNode *b)
+{
+  GSRopeNode	*la;
+  GSRopeNode	*fb;
+
+  if (a == 0 || b == 0)
+    return (a != 0) ? a : b;
+  if (b->total == 0)
+    {
+      ropeFree(z, b);
+      return a;
+    }
+  if (a->total == 0)
+    {
+      ropeFree(z, a);
+      return b;
+    }
+  la = ropeLast(a);
+  fb = ropeFirst(b);
+  if (la->attrs != nil
+    ? la->attrs == fb->attrs
+    : la->offset + la->length == fb->offset)
+    {
+      GSRopeNode	*f;
+
+      ropeSplit(z, b, fb->length, &f, &b);
+      ropeGrowLast(a, f->length);
+      ropeFree(z, f);
+    }
+  return ropeMerge(a, b);
+}
+
+/*
+ * Copy len characters starting at loc in the tree t into dst.
+ */
+static void
+ropeGetCharacters(GSRopeNode *t, const unichar *buf,
+  NSUInteger loc, NSUInteger len, unichar *dst)
+{
+  while (t != 0 && len > 0)
+    {
+      NSUInteger	ll = ropeTotal(t->left);
+      NSUInteger	n;
+
+      if (loc < ll)
+	{
+	  n = MIN(len, ll - loc);
+	  ropeGetCharacters(t->left, buf, loc, n, dst);
+	  dst += n;
+	  len -= n;
+	  loc = ll;
+	  if (len == 0)
+	    return;
+	}
+      if (loc < ll + t->length)
+	{
+	  NSUInteger	o = loc - ll;
+
+	  n = MIN(len, t->length - o);
+	  memcpy(dst, buf + t->offset + o, n * sizeof(unichar));
+	  dst += n;
+	  len -= n;
+	  loc += n;
+	}
+      loc -= ll + t->length;
+      t = t->right;
+    }
+}
+
+
+
+/*
+ * A mutable string stored as a piece table.  Inserted characters are
+ * appended to a single buffer and the text is described by a tree of
+ * pieces of that buffer, so an edit costs O(log n) however large the
+ * text is.  The buffer is compacted once it holds more deleted than live
+ * characters.
+ */
+@interface GSPieceTableString : NSMutableString
+{
+  unichar	*_buf;
+  NSUInteger	_bufLength;
+  NSUInteger	_bufCapacity;
+  GSRopeNode	*_pieces;
+  GSRopeNode	*_cachedPiece;
+  NSUInteger	_cachedStart;
+}
+@end
+
+@implementation	GSPieceTableString
+
+- (void) _compact
+{
+  NSZone	*z = [self zone];
+  NSUInteger	len = ropeTotal(_pieces);
+  unichar	*b;
+
+  b = NSZoneMalloc(z, (len > 0 ? len : 1) * sizeof(unichar));
+  ropeGetCharacters(_pieces, _buf, 0, len, b);
+  ropeFree(z, _pieces);
+  NSZoneFree(z, _buf);
+  _buf = b;
+  _bufLength = len;
+  _bufCapacity = (len > 0 ? len : 1);
+  _pieces = (len > 0 ? ropeNewNode(z, len, 0, nil) : 0);
+  _cachedPiece = 0;
+}
+
+- (id) initWithCharacters: (const unichar*)chars
+		   length: (NSUInteger)length
+{
+  NSZone	*z = [self zone];
+
+  _bufCapacity = (length > 0 ? length : 16);
+  _buf = NSZoneMalloc(z, _bufCapacity * sizeof(unichar));
+  if (length > 0)
+    {
+      memcpy(_buf, chars, length * sizeof(unichar));
+      _bufLength = length;
+      _pieces = ropeNewNode(z, length, 0, nil);
+    }
+  return self;
+}
+
+- (id) initWithCharactersNoCopy: (unichar*)chars
+			 length: (NSUInteger)length
+		   freeWhenDone: (BOOL)flag
+{
+  self = [self initWithCharacters: chars length: length];
+  if (flag == YES && chars != 0)
+    {
+      NSZoneFree(NSZoneFromPointer(chars), chars);
+    }
+  return self;
+}
+
+- (id) initWithCapacity: (NSUInteger)capacity
+{
+  return [self initWithCharacters: 0 length: 0];
+}
+
+- (id) init
+{
+  return [self initWithCharacters: 0 length: 0];
+}
+
+- (id) initWithString: (NSString*)aString
+{
+  NSUInteger	length = [aString length];
+  NSZone	*z = [self zone];
+
+  _bufCapacity = (length > 0 ? length : 16);
+  _buf = NSZoneMalloc(z, _bufCapacity * sizeof(unichar));
+  if (length > 0)
+    {
+      [aString getCharacters: _buf range: NSMakeRange(0, length)];
+      _bufLength = length;
+      _pieces = ropeNewNode(z, length, 0, nil);
+    }
+  return self;
+}
+
+- (void) dealloc
+{
+  NSZone	*z = [self zone];
+
+  ropeFree(z, _pieces);
+  NSZoneFree(z, _buf);
+  [super dealloc];
+}
+
+- (NSUInteger) length
+{
+  return ropeTotal(_pieces);
+}
+
+- (unichar) characterAtIndex: (NSUInteger)index
+{
+  if (_cachedPiece == 0 || index < _cachedStart
+    || index >= _cachedStart + _cachedPiece->length)
+    {
+      if (index >= ropeTotal(_pieces))
+	{
+	  [NSException raise: NSRangeException
+		      format: @"Index %lu out of range in -characterAtIndex:",
+	    (unsigned long)index];
+	}
+      _cachedPiece = ropeFind(_pieces, index, &_cachedStart);
+    }
+  return _buf[_cachedPiece->offset + index - _cachedStart];
+}
+
+- (void) getCharacters: (unichar*)buffer
+		 range: (NSRange)aRange
+{
+  GS_RANGE_CHECK(aRange, ropeTotal(_pieces));
+  ropeGetCharacters(_pieces, _buf, aRange.location, aRange.length, buffer);
+}
+
+- (void) replaceCharactersInRange: (NSRange)aRange
+		       withString: (NSString*)aString
+{
+  NSZone	*z = [self zone];
+  NSUInteger	length = ropeTotal(_pieces);
+  NSUInteger	insLength;
+  GSRopeNode	*l;
+  GSRopeNode	*mid;
+  GSRopeNode	*r;
+
+  GS_RANGE_CHECK(aRange, length);
+  insLength = [aString length];
+  if (insLength > 0)
+    {
+      if (_bufLength + insLength > _bufCapacity)
+	{
+	  _bufCapacity = MAX(_bufCapacity * 2, _bufLength + insLength);
+	  _buf = NSZoneRealloc(z, _buf, _bufCapacity * sizeof(unichar));
+	}
+      /* The new characters go to the unused end of the buffer, so this
+       * is safe even if aString is (a proxy to) the receiver.
+       */
+      [aString getCharacters: _buf + _bufLength
+		       range: NSMakeRange(0, insLength)];
+    }
+
+  ropeSplit(z, _pieces, aRange.location, &l, &mid);
+  ropeSplit(z, mid, aRange.length, &mid, &r);
+  ropeFree(z, mid);
+  if (insLength > 0)
+    {
+      l = ropeJoin(z, l, ropeNewNode(z, insLength, _bufLength, nil));
+      _bufLength += insLength;
+    }
+  _pieces = ropeJoin(z, l, r);
+  _cachedPiece = 0;
+
+  length = ropeTotal(_pieces);
+  if (_bufLength - length > length && _bufLength - length > 65536)
+    {
+      [self _compact];
+    }
+}
+
+@end
+
+
+
+@implementation GSRopeTextStorage
+
+/* We always compile in this method so that it is available from
+ * regression test cases.  */
+- (void) _sanity
+{
+  GSRopeNode	*prev = 0;
+  GSRopeNode	*info;
+  NSUInteger	len = [_textChars length];
+  NSUInteger	loc = 0;
+
+  NSAssert(_runs != 0, NSInternalInconsistencyException);
+  NSAssert(ropeTotal(_runs) == len, NSInternalInconsistencyException);
+  while (loc < len)
+    {
+      NSUInteger	start;
+
+      info = ropeFind(_runs, loc, &start);
+      NSAssert(start == loc, NSInternalInconsistencyException);
+      NSAssert(info->length > 0, NSInternalInconsistencyException);
+      NSAssert(prev == 0 || prev->attrs != info->attrs,
+	NSInternalInconsistencyException);
+      prev = info;
+      loc += info->length;
+    }
+}
+
+- (id) initWithString: (NSString*)aString
+	   attributes: (NSDictionary*)attributes
+{
+  NSZone *z = [self zone];
+
+  self = [super initWithString: aString attributes: attributes];
+  if (aString != nil && [aString isKindOfClass: [NSAttributedString class]])
+    {
+      NSAttributedString	*as = (NSAttributedString*)aString;
+      NSUInteger		length;
+      NSRange			range = NSMakeRange(0, 0);
+
+      aString = [as string];
+      length = [aString length];
+      if (length == 0)
+	{
+	  _runs = ropeNewNode(z, 0, 0, cacheAttributes(blank));
+	}
+      while (NSMaxRange(range) < length)
+	{
+	  NSDictionary	*attr;
+
+	  attr = [as attributesAtIndex: NSMaxRange(range)
+			effectiveRange: &range];
+	  _runs = ropeJoin(z, _runs,
+	    ropeNewNode(z, range.length, 0, cacheAttributes(attr)));
+	}
+    }
+  else
+    {
+      if (attributes == nil)
+        {
+          attributes = blank;
+        }
+      _runs = ropeNewNode(z, [aString length], 0, cacheAttributes(attributes));
+    }
+  _textChars = [[GSPieceTableString allocWithZone: z]
+    initWithString: (aString != nil ? aString : @"")];
+  return self;
+}
+
+- (NSString*) string
+{
+  /* As in GSTextStorage this is a proxy to the mutable string.
+   */
+  if (_textProxy == nil)
+    {
+      _textProxy = [[GSTextStorageProxy alloc] _initWithString: _textChars];
+    }
+  return _textProxy;
+}
+
+- (NSDictionary*) attributesAtIndex: (NSUInteger)index
+		     effectiveRange: (NSRange*)aRange
+{
+  NSUInteger	length = ropeTotal(_runs);
+  NSUInteger	start;
+  GSRopeNode	*info;
+
+  if (index < length)
+    {
+      info = ropeFind(_runs, index, &start);
+    }
+  else if (index == length)
+    {
+      info = ropeLast(_runs);
+      start = length - info->length;
+    }
+  else
+    {
+      [NSException raise: NSRangeException
+		  format: @"index is out of range in "
+			  @"-attributesAtIndex:effectiveRange:"];
+      return nil;
+    }
+  if (aRange != 0)
+    {
+      aRange->location = start;
+      aRange->length = info->length;
+    }
+  return info->attrs;
+}
+
+- (void) setAttributes: (NSDictionary*)attributes
+                 range: (NSRange)range
+{
+  NSZone	*z = [self zone];
+  GSRopeNode	*l;
+  GSRopeNode	*mid;
+  GSRopeNode	*r;
+
+  if (range.length == 0)
+    {
+      NSWarnMLog(@"Attempt to set attribute for zero-length range");
+      return;
+    }
+  if (attributes == nil)
+    {
+      attributes = blank;
+    }
+  GS_RANGE_CHECK(range, ropeTotal(_runs));
+  attributes = cacheAttributes(attributes);
+
+  ropeSplit(z, _runs, range.location, &l, &mid);
+  ropeSplit(z, mid, range.length, &mid, &r);
+  ropeFree(z, mid);
+  l = ropeJoin(z, l, ropeNewNode(z, range.length, 0, attributes));
+  _runs = ropeJoin(z, l, r);
+
+SANITY();
+  [self edited: NSTextStorageEditedAttributes
+	 range: range
+changeInLength: 0];
+}
+
+- (void) replaceCharactersInRange: (NSRange)range
+		       withString: (NSString*)aString
+{
+  NSZone	*z = [self zone];
+  NSUInteger	length = ropeTotal(_runs);
+  NSUInteger	insLength;
+  NSUInteger	start;
+  NSDictionary	*attrs;
+  GSRopeNode	*l;
+  GSRopeNode	*mid;
+  GSRopeNode	*r;
+
+  if (aString == nil)
+    {
+      aString = @"";
+    }
+  GS_RANGE_CHECK(range, length);
+  insLength = [aString length];
+
+  /*
+   * The replacement characters get the attributes of the first character
+   * replaced, or of the previous character when inserting.
+   */
+  if (range.length == 0 && range.location > 0)
+    start = range.location - 1;
+  else
+    start = range.location;
+  if (start < length)
+    attrs = ropeFind(_runs, start, 0)->attrs;
+  else
+    attrs = ropeLast(_runs)->attrs;
+  attrs = cacheAttributes(attrs);
+
+  ropeSplit(z, _runs, range.location, &l, &mid);
+  ropeSplit(z, mid, range.length, &mid, &r);
+  ropeFree(z, mid);
+  if (insLength > 0 || (l == 0 && r == 0))
+    {
+      l = ropeJoin(z, l, ropeNewNode(z, insLength, 0, attrs));
+    }
+  else
+    {
+      unCacheAttributes(attrs);
+      RELEASE(attrs);
+    }
+  _runs = ropeJoin(z, l, r);
+
+  [_textChars replaceCharactersInRange: range withString: aString];
+
+SANITY();
+  [self edited: NSTextStorageEditedCharacters
+         range: range
+changeInLength: insLength - range.length];
+}
+
+- (void) dealloc
+{
+  ropeFree([self zone], _runs);
+  RELEASE(_textChars);
+  RELEASE(_textProxy);
+  [super dealloc];
+}
+
+- (NSUInteger) length
+{
+  return [_textChars length];
+}
+@end
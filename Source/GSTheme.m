@@ -26,6 +26,7 @@
    Boston, MA 02110-1301, USA.
 */
 
+#import <Foundation/NSArchiver.h>
 #import <Foundation/NSBundle.h>
 #import <Foundation/NSDebug.h>
 #import <Foundation/NSDictionary.h>
@@ -38,16 +39,21 @@
 #import <Foundation/NSNull.h>
 #import <Foundation/NSPathUtilities.h>
 #import <Foundation/NSSet.h>
+#import <Foundation/NSThread.h>
 #import <Foundation/NSUserDefaults.h>
+#import <Foundation/NSValue.h>
 #import "GNUstepBase/GSObjCRuntime.h"
 #import "GNUstepGUI/GSTheme.h"
+#import "GNUstepGUI/GSThemePack.h"
 #import "AppKit/NSApplication.h"
+#import "AppKit/NSBitmapImageRep.h"
 #import "AppKit/NSButtonCell.h"
 #import "AppKit/NSButton.h"
 #import "AppKit/NSColor.h"
 #import "AppKit/NSColorList.h"
 #import "AppKit/NSGraphics.h"
 #import "AppKit/NSImage.h"
+#import "AppKit/NSImageRep.h"
 #import "AppKit/NSImageView.h"
 #import "AppKit/NSMatrix.h"
 #import "AppKit/NSMenu.h"
@@ -63,6 +69,7 @@
 #import "AppKit/NSBezierPath.h"
 #import "AppKit/PSOperators.h"
 #import "GSThemePrivate.h"
+#import "GSGuiPrivate.h"
 
 // Scroller part names
 NSString	*GSScrollerDownArrow = @"GSScrollerDownArrow";
@@ -103,6 +110,10 @@ NSString	*GSThemeWillActivateNotification
   = @"GSThemeWillActivateNotification";
 NSString	*GSThemeWillDeactivateNotification
   = @"GSThemeWillDeactivateNotification";
+NSString	*GSThemePrepareProgressNotification
+  = @"GSThemePrepareProgressNotification";
+NSString	*GSThemeDidPrepareNotification
+  = @"GSThemeDidPrepareNotification";
 
 NSString *
 GSThemeStringFromFillStyle(GSThemeFillStyle s)
@@ -209,9 +220,16 @@ GSStringFromBorderType(NSBorderType borderType)
 @interface	NSImage (Private)
 + (void) _setImagePath: (NSString*)path name: (NSString*)name;
 + (void) _reloadCachedImages;
++ (void) _setPreparedReps: (NSArray*)reps forFile: (NSString*)path;
++ (void) _discardPreparedReps;
 @end
 
 @interface	GSTheme (Private)
++ (void) _themeDidPrepare: (NSNotification*)n;
+- (void) _prepareProgress: (NSArray*)counts;
+- (void) _prepareThread: (NSArray*)types;
+- (NSColorList*) _newColorListNamed: (NSString*)name
+			   fromFile: (NSString*)path;
 - (void) _revokeOwnerships;
 @end
 
@@ -237,6 +255,7 @@ GSStringFromBorderType(NSBorderType borderType)
 
 static GSTheme			*defaultTheme = nil;
 static GSTheme			*theTheme = nil;
+static GSTheme			*pendingTheme = nil;
 static NSMutableDictionary	*themes = nil;
 static NSNull			*null = nil;
 static NSMapTable		*names = 0;
@@ -253,6 +272,9 @@ typedef	struct {
   Class			colorClass;
   Class			imageClass;
   NSMutableArray	*overrides;
+  BOOL			preparing;
+  BOOL			prepared;
+  GSThemePack		*pack;
 } internal;
 
 #define	_internal 		((internal*)_reserved)
@@ -267,6 +289,9 @@ typedef	struct {
 #define	_colorClass		_internal->colorClass
 #define	_imageClass		_internal->imageClass
 #define	_overrides		_internal->overrides
+#define	_preparing		_internal->preparing
+#define	_prepared		_internal->prepared
+#define	_pack			_internal->pack
 
 + (void) defaultsDidChange: (NSNotification*)n
 {
@@ -285,7 +310,17 @@ typedef	struct {
     }
   if (NO == [[name lastPathComponent] isEqual: [theTheme name]])
     {
-      [self setTheme: [self loadThemeNamed: name]];
+      if (n == nil)
+	{
+	  /* Called from +initialize ... the theme must be in place
+	   * before anything is drawn.
+	   */
+	  [self setTheme: [self loadThemeNamed: name]];
+	}
+      else
+	{
+	  [self setThemeWhenPrepared: [self loadThemeNamed: name]];
+	}
     }
 }
 
@@ -414,6 +449,7 @@ typedef	struct {
     {
       theme = defaultTheme;
     }
+  DESTROY(pendingTheme);
   if (theme != theTheme)
     {
       /*
@@ -424,7 +460,13 @@ typedef	struct {
 
       [theTheme deactivate];
       ASSIGN (theTheme, theme);
+      GSLaunchTimelineBegin(@"theme");
+      /* Decode the images of the theme in the background while we
+       * activate it.
+       */
+      [theTheme prepare];
       [theTheme activate];
+      GSLaunchTimelineEnd(@"theme");
 
       /*
        * Listen to notifications...
@@ -437,6 +479,28 @@ typedef	struct {
     }
 }
 
++ (void) setThemeWhenPrepared: (GSTheme*)theme
+{
+  if (theme == nil)
+    {
+      theme = defaultTheme;
+    }
+  ASSIGN(pendingTheme, theme);
+  if ([theme isPrepared] == YES)
+    {
+      [self setTheme: theme];
+    }
+  else
+    {
+      [[NSNotificationCenter defaultCenter]
+	addObserver: self
+	   selector: @selector(_themeDidPrepare:)
+	       name: GSThemeDidPrepareNotification
+	     object: theme];
+      [theme prepare];
+    }
+}
+
 + (GSTheme*) theme 
 {
   return theTheme;
@@ -636,8 +700,7 @@ typedef	struct {
 	  if (colorsPath != nil)
 	    {
 	      _extraColors[elementState]
-		= [[_colorClass alloc] initWithName: listName
-					   fromFile: colorsPath];
+		= [self _newColorListNamed: listName fromFile: colorsPath];
 	      /* If the list is actually empty, we get rid of it to avoid
 	       * unnecessary lookups.
 	       */
@@ -673,8 +736,8 @@ typedef	struct {
 	}
       else
 	{
-	  _colors = [[_colorClass alloc] initWithName: @"System"
-					     fromFile: colorsPath];
+	  _colors = [self _newColorListNamed: @"System"
+				    fromFile: colorsPath];
 	}
     }
   if ((id)_colors == (id)null)
@@ -710,6 +773,11 @@ typedef	struct {
 
   [self _revokeOwnerships];
 
+  /* The decoded images have been used or are discarded when the next
+   * theme is prepared, so a later activation has to prepare again.
+   */
+  _prepared = NO;
+
   /* Tell everything that we have become inactive.
    */
   [[NSNotificationCenter defaultCenter]
@@ -733,6 +801,7 @@ typedef	struct {
       RELEASE(_colors);
       RELEASE(_imageNames);
       RELEASE(_icon);
+      RELEASE(_pack);
       [self _revokeOwnerships];
       RELEASE(_overrides);
       RELEASE(_owned);
@@ -813,6 +882,25 @@ typedef	struct {
   _colorClass = [self colorClass];
   _imageClass = [self imageClass];
 
+  /* If the theme has been packed, its images and color lists come from
+   * the pack rather than from the loose files.
+   */
+  if (_bundle != nil)
+    {
+      NSString	*packPath;
+
+      packPath = [_bundle pathForResource: @"ThemePack" ofType: @"gstp"];
+      if (packPath != nil)
+	{
+	  _pack = [[GSThemePack alloc] initWithContentsOfFile: packPath
+						   bundlePath: [_bundle bundlePath]];
+	  if (_pack == nil)
+	    {
+	      NSLog(@"Theme pack %@ is not valid, ignoring it", packPath);
+	    }
+	}
+    }
+
   /* Now we look through our methods to find those which are actually
    * replacements to override methods in other classes.
    * That's determined by method name ... any method of the form
@@ -942,6 +1030,11 @@ typedef	struct {
   return [_bundle infoDictionary];
 }
 
+- (BOOL) isPrepared
+{
+  return _prepared;
+}
+
 - (NSString*) name
 {
   if (self == defaultTheme)
@@ -958,6 +1051,46 @@ typedef	struct {
   return name;
 }
 
+- (NSArray*) _packedRepsForFile: (NSString*)path
+{
+  NSBitmapImageRep	*rep = [_pack bitmapForFile: path];
+
+  if (rep == nil)
+    {
+      return nil;
+    }
+  return [NSArray arrayWithObject: rep];
+}
+
+- (void) prepare
+{
+  if (_prepared == YES || _preparing == YES)
+    {
+      return;
+    }
+  /* Only the images of one theme are kept ready at a time.
+   */
+  [NSImage _discardPreparedReps];
+  _preparing = YES;
+  if (_bundle == nil || _pack != nil)
+    {
+      /* Nothing to decode ... a pack holds its images ready for use.
+       */
+      [self _prepareProgress: [NSArray arrayWithObjects:
+	[NSNumber numberWithUnsignedInteger: 0],
+	[NSNumber numberWithUnsignedInteger: 0], nil]];
+    }
+  else
+    {
+      /* The image class is asked for its types here, as it may not
+       * expect to be used from another thread.
+       */
+      [NSThread detachNewThreadSelector: @selector(_prepareThread:)
+			       toTarget: self
+			     withObject: [_imageClass imageFileTypes]];
+    }
+}
+
 - (IMP) overriddenMethod: (SEL)selector for: (id)receiver
 {
   Class		cls = object_getClass(receiver);
@@ -1056,6 +1189,32 @@ typedef	struct {
     }
 }
 
+- (NSDictionary*) tileCacheStatistics
+{
+  NSUInteger	entries = 0;
+  NSUInteger	bytes = 0;
+  int		state;
+
+  for (state = 0; state <= GSThemeSelectedState; state++)
+    {
+      NSEnumerator	*e = [_tiles[state] objectEnumerator];
+      GSDrawTiles	*tiles;
+
+      while ((tiles = [e nextObject]) != nil)
+	{
+	  if (tiles != (id)null)
+	    {
+	      entries++;
+	      bytes += [tiles cachedBytes];
+	    }
+	}
+    }
+  return [NSDictionary dictionaryWithObjectsAndKeys:
+    [NSNumber numberWithUnsignedInteger: entries], @"Entries",
+    [NSNumber numberWithUnsignedInteger: bytes], @"Bytes",
+    nil];
+}
+
 - (GSDrawTiles*) tilesNamed: (NSString*)aName
 		      state: (GSThemeControlState)elementState
 {
@@ -1073,7 +1232,6 @@ typedef	struct {
   if (tiles == nil)
     {
       NSDictionary	*info;
-      NSImage		*image;
       NSString		*fullName;
 
       switch (elementState)
@@ -1129,23 +1287,21 @@ typedef	struct {
 	    }
 	  else
 	    {
-	      image = [[_imageClass alloc] initWithContentsOfFile: path];
-	      if (image != nil)
+	      BOOL	ninePatch;
+
+	      ninePatch = [[info objectForKey: @"NinePatch"] boolValue];
+	      tiles = [GSDrawTiles tilesWithContentsOfFile: path
+						imageClass: _imageClass
+						 ninePatch: ninePatch
+						horizontal: x
+						  vertical: y];
+	      if (ninePatch)
 		{
-                  if ([[info objectForKey: @"NinePatch"] boolValue])
-                    {
-                      tiles = [[GSDrawTiles alloc]
-			initWithNinePatchImage: image];
-		      [tiles setFillStyle: GSThemeFillStyleScaleAll];
-                    }
-                  else
-                    {
-		      tiles = [[GSDrawTiles alloc] initWithImage: image
-                                                      horizontal: x
-                                                        vertical: y];
-		      [tiles setFillStyle: style];
-                    }
-		  RELEASE(image);
+		  [tiles setFillStyle: GSThemeFillStyleScaleAll];
+		}
+	      else
+		{
+		  [tiles setFillStyle: style];
 		}
 	    }
 	}
@@ -1165,12 +1321,13 @@ typedef	struct {
 				       inDirectory: @"ThemeTiles"];
 	      if (imagePath != nil)
 		{
-		  image
-		    = [[_imageClass alloc] initWithContentsOfFile: imagePath];
-		  if (image != nil)
+		  tiles = [GSDrawTiles tilesWithContentsOfFile: imagePath
+						    imageClass: _imageClass
+						     ninePatch: NO
+						    horizontal: -1.0
+						      vertical: -1.0];
+		  if (tiles != nil)
 		    {
-		      tiles = [[GSDrawTiles alloc] initWithImage: image];
-		      RELEASE(image);
 		      break;
 		    }
 		}
@@ -1184,7 +1341,6 @@ typedef	struct {
       else
         {
 	  [cache setObject: tiles forKey: aName];
-	  RELEASE(tiles);
 	}
     }
   if (tiles == (id)null)
@@ -1202,8 +1358,145 @@ typedef	struct {
 @end
 
 @implementation	GSTheme (Private)
++ (void) _themeDidPrepare: (NSNotification*)n
+{
+  GSTheme	*theme = [n object];
+
+  [[NSNotificationCenter defaultCenter]
+    removeObserver: self
+	      name: GSThemeDidPrepareNotification
+	    object: theme];
+  if (theme == pendingTheme)
+    {
+      [self setTheme: theme];
+    }
+}
+
+/* Called on the main thread with the number of files decoded and the
+ * number to decode.
+ */
+- (void) _prepareProgress: (NSArray*)counts
+{
+  NSNumber	*done = [counts objectAtIndex: 0];
+  NSNumber	*total = [counts objectAtIndex: 1];
+  NSDictionary	*userInfo;
+
+  userInfo = [NSDictionary dictionaryWithObjectsAndKeys:
+    done, @"Done", total, @"Total", nil];
+  [[NSNotificationCenter defaultCenter]
+    postNotificationName: GSThemePrepareProgressNotification
+		  object: self
+		userInfo: userInfo];
+  if ([done isEqual: total])
+    {
+      _preparing = NO;
+      _prepared = YES;
+      [[NSNotificationCenter defaultCenter]
+	postNotificationName: GSThemeDidPrepareNotification
+		      object: self
+		    userInfo: nil];
+    }
+}
+
+- (void) _prepareThread: (NSArray*)types
+{
+  CREATE_AUTORELEASE_POOL(pool);
+  NSMutableArray	*paths = [NSMutableArray arrayWithCapacity: 100];
+  NSNumber		*total;
+  NSUInteger		count;
+  NSUInteger		i;
+
+  for (i = 0; i < [types count]; i++)
+    {
+      NSString	*ext = [types objectAtIndex: i];
+      NSArray	*found;
+
+      found = [_bundle pathsForResourcesOfType: ext
+				   inDirectory: @"ThemeImages"];
+      [paths addObjectsFromArray: found];
+      found = [_bundle pathsForResourcesOfType: ext
+				   inDirectory: @"ThemeTiles"];
+      [paths addObjectsFromArray: found];
+    }
+
+  count = [paths count];
+  total = [NSNumber numberWithUnsignedInteger: count];
+  if (count == 0)
+    {
+      [self performSelectorOnMainThread: @selector(_prepareProgress:)
+			     withObject: [NSArray arrayWithObjects:
+				total, total, nil]
+			  waitUntilDone: NO];
+    }
+  for (i = 0; i < count; i++)
+    {
+      CREATE_AUTORELEASE_POOL(arp);
+      NSString	*path = [paths objectAtIndex: i];
+      NSArray	*reps = nil;
+
+      NS_DURING
+	{
+	  reps = [NSImageRep imageRepsWithContentsOfFile: path];
+	}
+      NS_HANDLER
+	{
+	  NSLog(@"Problem decoding theme image '%@': %@",
+	    path, localException);
+	}
+      NS_ENDHANDLER
+      if ([reps count] > 0)
+	{
+	  [NSImage _setPreparedReps: reps forFile: path];
+	}
+      [self performSelectorOnMainThread: @selector(_prepareProgress:)
+			     withObject: [NSArray arrayWithObjects:
+				[NSNumber numberWithUnsignedInteger: i + 1],
+				total, nil]
+			  waitUntilDone: NO];
+      DESTROY(arp);
+    }
+  DESTROY(pool);
+}
+
 /* Remove all temporarily named objects from our registry, releasing them.
  */
+/* Returns a new color list called name, taken from the theme pack if the
+ * file at path has been packed.
+ */
+- (NSColorList*) _newColorListNamed: (NSString*)name
+			   fromFile: (NSString*)path
+{
+  NSData	*data = [_pack dataForFile: path];
+
+  if (data != nil)
+    {
+      NSColorList	*archived = nil;
+
+      NS_DURING
+	{
+	  archived = [NSUnarchiver unarchiveObjectWithData: data];
+	}
+      NS_HANDLER
+	{
+	  archived = nil;
+	}
+      NS_ENDHANDLER
+      if ([archived isKindOfClass: [NSColorList class]])
+	{
+	  NSColorList	*list = [[_colorClass alloc] initWithName: name];
+	  NSEnumerator	*e = [[archived allKeys] objectEnumerator];
+	  NSString	*key;
+
+	  while ((key = [e nextObject]) != nil)
+	    {
+	      [list setColor: [archived colorWithKey: key] forKey: key];
+	    }
+	  return list;
+	}
+    }
+  return [[_colorClass alloc] initWithName: name fromFile: path];
+}
+
 - (void) _revokeOwnerships
 {
   id	o;
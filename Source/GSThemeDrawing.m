@@ -30,6 +30,7 @@
 
 #import "Foundation/NSUserDefaults.h"
 #import "Foundation/NSIndexSet.h"
+#import "Foundation/NSDictionary.h"
 
 #import "AppKit/NSAttributedString.h"
 #import "AppKit/NSBezierPath.h"
@@ -67,6 +68,9 @@
 
 @interface NSTableView (Private)
 - (CGFloat *)_columnOrigins;
+- (NSInteger) _columnBeforeX: (CGFloat)x;
+- (id) _cachedObjectValueAtColumn: (NSInteger)columnIndex
+                              row: (NSInteger)rowIndex;
 - (void) _willDisplayCell: (NSCell*)cell
            forTableColumn: (NSTableColumn *)tb
                       row: (NSInteger)index;
@@ -1126,6 +1130,74 @@ static int spinningMaxCount = MaxCount;
 static NSColor *indeterminateColors[MaxCount];
 static NSImage *spinningImages[MaxCount];
 
+/* The frames of the indeterminate and spinning animations, rendered at
+ * the size they are drawn at, so that each step of a running indicator
+ * only composites one image.  Indicators of the same style and size,
+ * such as a column of them in a table, share their frames.  The cache
+ * is emptied once it holds MaxFrameSizes sizes.
+ */
+#define MaxFrameSizes 16
+static NSMutableDictionary *progressFrames = nil;
+
+static NSArray *
+progressIndicatorFrames(NSProgressIndicatorStyle style, NSSize size)
+{
+  NSString *key;
+  NSMutableArray *frames;
+  int count, i;
+
+  count = (style == NSProgressIndicatorSpinningStyle)
+    ? spinningMaxCount : indeterminateMaxCount;
+  if (count == 0 || size.width < 1.0 || size.height < 1.0)
+    {
+      return nil;
+    }
+  key = [NSString stringWithFormat: @"%d %gx%g", (int)style,
+                  size.width, size.height];
+  frames = [progressFrames objectForKey: key];
+  if (frames != nil)
+    {
+      return frames;
+    }
+
+  if (progressFrames == nil)
+    {
+      progressFrames = [[NSMutableDictionary alloc]
+                         initWithCapacity: MaxFrameSizes];
+    }
+  else if ([progressFrames count] >= MaxFrameSizes)
+    {
+      [progressFrames removeAllObjects];
+    }
+
+  frames = [NSMutableArray arrayWithCapacity: count];
+  for (i = 0; i < count; i++)
+    {
+      NSImage *frame = [[NSImage alloc] initWithSize: size];
+      NSRect r = {{0, 0}, {0, 0}};
+
+      r.size = size;
+      [frame lockFocus];
+      if (style == NSProgressIndicatorSpinningStyle)
+        {
+          [spinningImages[i] drawInRect: r
+                               fromRect: NSZeroRect
+                              operation: NSCompositeSourceOver
+                               fraction: 1.0];
+        }
+      else
+        {
+          [indeterminateColors[i] set];
+          NSRectFill(r);
+        }
+      [frame unlockFocus];
+      [frames addObject: frame];
+      RELEASE(frame);
+    }
+  [progressFrames setObject: frames forKey: key];
+  return frames;
+}
+
 - (void) initProgressIndicatorDrawing
 {
   int i;
@@ -1176,11 +1248,15 @@ static NSImage *spinningImages[MaxCount];
        [self initProgressIndicatorDrawing];
      }
 
-   // Draw the Bezel
+   // Draw the Bezel, unless only the inside is being redrawn
    if ([progress isBezeled])
      {
-       // Calc the inside rect to be drawn
-       r = [self drawProgressIndicatorBezel: bounds withClip: rect];
+       r = [self progressIndicatorAnimationRect: progress withBounds: bounds];
+       if (!NSContainsRect(r, rect))
+         {
+           // Calc the inside rect to be drawn
+           r = [self drawProgressIndicatorBezel: bounds withClip: rect];
+         }
      }
    else
      {
@@ -1189,27 +1265,34 @@ static NSImage *spinningImages[MaxCount];
 
    if ([progress style] == NSProgressIndicatorSpinningStyle)
      {
-       NSRect imgBox = {{0,0}, {0,0}};
+       NSArray *frames;
 
-       if (spinningMaxCount != 0)
+       frames = progressIndicatorFrames(NSProgressIndicatorSpinningStyle,
+                                        r.size);
+       if (frames != nil)
 	 {
-	   count = count % spinningMaxCount;
-	   imgBox.size = [spinningImages[count] size];
-	   [spinningImages[count] drawInRect: r 
-				    fromRect: imgBox 
-				   operation: NSCompositeSourceOver
-				    fraction: 1.0];
+	   count = count % [frames count];
+	   [[frames objectAtIndex: count] drawInRect: r 
+					    fromRect: NSZeroRect 
+					   operation: NSCompositeSourceOver
+					    fraction: 1.0];
 	 }
      }
    else
      {
        if ([progress isIndeterminate])
          {
-	   if (indeterminateMaxCount != 0)
+	   NSArray *frames;
+
+	   frames = progressIndicatorFrames(NSProgressIndicatorBarStyle,
+					    r.size);
+	   if (frames != nil)
 	     {
-	       count = count % indeterminateMaxCount;
-	       [indeterminateColors[count] set];
-	       NSRectFill(r);
+	       count = count % [frames count];
+	       [[frames objectAtIndex: count] drawInRect: r 
+						fromRect: NSZeroRect 
+					       operation: NSCompositeCopy
+						fraction: 1.0];
 	     }
          }
        else
@@ -1244,6 +1327,17 @@ static NSImage *spinningImages[MaxCount];
   return [self drawGrayBezel: bounds withClip: rect];
 }
 
+- (NSRect) progressIndicatorAnimationRect: (NSProgressIndicator*)progress
+                               withBounds: (NSRect)bounds
+{
+  if ([progress isBezeled])
+    {
+      // The gray bezel is two points wide on every side
+      return NSInsetRect(bounds, 2.0, 2.0);
+    }
+  return bounds;
+}
+
 - (void) drawProgressIndicatorBarDeterminate: (NSRect)bounds
 {
   GSDrawTiles *tiles = [self tilesNamed: GSProgressIndicatorBarDeterminate
@@ -2095,9 +2189,29 @@ static NSDictionary *titleTextAttributes[3] = {nil, nil, nil};
 	withFrame: bounds
 	dirtyRect: rect
 	horizontal: horizontal];
+
+  /* Items of a vertical menu are stacked upwards from the last one, all
+     of the same height, so only those crossing rect need to be looked
+     at.  This matters for long popup menus.  */
+  if (!horizontal && howMany > 1)
+    {
+      NSRect	last = [menuView rectOfItemAtIndex: howMany - 1];
+      CGFloat	h = NSHeight(last);
+
+      if (h > 0)
+	{
+	  NSInteger first;
+	  NSInteger end;
+
+	  first = howMany - 1 - (NSInteger)floor((NSMaxY(rect) - NSMinY(last)) / h);
+	  end = howMany - (NSInteger)floor((NSMinY(rect) - NSMinY(last)) / h);
+	  i = (NSUInteger)MAX(first, 0);
+	  howMany = (NSUInteger)MAX(MIN(end, (NSInteger)howMany), 0);
+	}
+    }
   
   // Draw the menu cells.
-  for (i = 0; i < howMany; i++)
+  for (; i < howMany; i++)
     {
       NSRect aRect;
       NSMenuItemCell *aCell;
@@ -2354,7 +2468,6 @@ static NSDictionary *titleTextAttributes[3] = {nil, nil, nil};
   CGFloat minY = NSMinY (aRect);
   CGFloat maxY = NSMaxY (aRect);
   NSInteger i;
-  CGFloat x_pos;
   NSInteger startingColumn; 
   NSInteger endingColumn;
   NSInteger numberOfColumns = [tableView numberOfColumns];
@@ -2365,26 +2478,12 @@ static NSDictionary *titleTextAttributes[3] = {nil, nil, nil};
   NSInteger startingRow    = [tableView rowAtPoint: NSMakePoint (bounds.origin.x, minY)];
   NSInteger endingRow      = [tableView rowAtPoint: NSMakePoint (bounds.origin.x, maxY)];
   NSColor *gridColor = [tableView gridColor];
-  NSInteger rowHeight = [tableView rowHeight];
   NSInteger numberOfRows = [tableView numberOfRows];
 
   /* Using columnAtPoint:, rowAtPoint: here calls them only twice 
      per drawn rect */
-  x_pos = minX;
-  i = 0;
-  while ((i < numberOfColumns) && (x_pos > columnOrigins[i]))
-    {
-      i++;
-    }
-  startingColumn = (i - 1);
-
-  x_pos = maxX;
-  // Nota Bene: we do *not* reset i
-  while ((i < numberOfColumns) && (x_pos > columnOrigins[i]))
-    {
-      i++;
-    }
-  endingColumn = (i - 1);
+  startingColumn = [tableView _columnBeforeX: minX];
+  endingColumn = [tableView _columnBeforeX: maxX];
 
   if (endingColumn == -1)
     endingColumn = numberOfColumns - 1;
@@ -2407,20 +2506,25 @@ static NSDictionary *titleTextAttributes[3] = {nil, nil, nil};
       if (endingRow == -1)
 	endingRow = numberOfRows - 1;
       
-      position = bounds.origin.y;
-      position += startingRow * rowHeight;
+      /* Rows may have heights of their own, so ask for the position
+	 of each line */
       for (i = startingRow; i <= endingRow + 1; i++)
 	{
+	  if (i < numberOfRows)
+	    position = NSMinY ([tableView rectOfRow: i]);
+	  else
+	    position = NSMaxY ([tableView rectOfRow: numberOfRows - 1]);
 	  DPSmoveto (ctxt, minX, position);
 	  DPSlineto (ctxt, maxX, position);
 	  DPSstroke (ctxt);
-	  position += rowHeight;
 	}
     }
   
   if (numberOfColumns > 0)
     {
-      int lastRowPosition = position - rowHeight;
+      /* The last horizontal line drawn */
+      int lastRowPosition = (numberOfRows > 0)
+	? position : position - [tableView rowHeight];
       /* Draw vertical lines */
       if (startingColumn == -1)
 	startingColumn = 0;
@@ -2594,7 +2698,6 @@ static NSDictionary *titleTextAttributes[3] = {nil, nil, nil};
   // NSIndexSet *selectedRows = [tableView selectedRowIndexes];
   // NSColor *backgroundColor = [tableView backgroundColor];
   id dataSource = [tableView dataSource];
-  CGFloat *columnOrigins = [tableView _columnOrigins];
   NSInteger editedRow = [tableView editedRow];
   NSInteger editedColumn = [tableView editedColumn];
   NSArray *tableColumns = [tableView tableColumns];
@@ -2604,7 +2707,6 @@ static NSDictionary *titleTextAttributes[3] = {nil, nil, nil};
   NSRect drawingRect;
   NSCell *cell;
   NSInteger i;
-  CGFloat x_pos;
 
   if (dataSource == nil)
     {
@@ -2615,25 +2717,13 @@ static NSDictionary *titleTextAttributes[3] = {nil, nil, nil};
      rect - so we avoid it and do it natively */
 
   /* Determine starting column as fast as possible */
-  x_pos = NSMinX (clipRect);
-  i = 0;
-  while ((i < numberOfColumns) && (x_pos > columnOrigins[i]))
-    {
-      i++;
-    }
-  startingColumn = (i - 1);
+  startingColumn = [tableView _columnBeforeX: NSMinX (clipRect)];
 
   if (startingColumn == -1)
     startingColumn = 0;
 
   /* Determine ending column as fast as possible */
-  x_pos = NSMaxX (clipRect);
-  // Nota Bene: we do *not* reset i
-  while ((i < numberOfColumns) && (x_pos > columnOrigins[i]))
-    {
-      i++;
-    }
-  endingColumn = (i - 1);
+  endingColumn = [tableView _columnBeforeX: NSMaxX (clipRect)];
 
   if (endingColumn == -1)
     endingColumn = numberOfColumns - 1;
@@ -2648,9 +2738,8 @@ static NSDictionary *titleTextAttributes[3] = {nil, nil, nil};
       [tableView _willDisplayCell: cell
 		 forTableColumn: tb
 		 row: rowIndex];
-      [cell setObjectValue: [dataSource tableView: tableView
-					objectValueForTableColumn: tb
-					row: rowIndex]]; 
+      [cell setObjectValue: [tableView _cachedObjectValueAtColumn: i
+							      row: rowIndex]];
       drawingRect = [tableView frameOfCellAtColumn: i
 			       row: rowIndex];
       [cell drawWithFrame: drawingRect inView: tableView];
@@ -0,0 +1,435 @@
+/* GSThemePack.m                                             -*-objc-*-
+
+   Packed theme resources
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of the GNUstep GUI Library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; see the file COPYING.LIB.
+   If not, see <http://www.gnu.org/licenses/> or write to the 
+   Free Software Foundation, 51 Franklin Street, Fifth Floor, 
+   Boston, MA 02110-1301, USA.
+*/
+
+#include <string.h>
+#import <Foundation/NSArray.h>
+#import <Foundation/NSBundle.h>
+#import <Foundation/NSByteOrder.h>
+#import <Foundation/NSData.h>
+#import <Foundation/NSDictionary.h>
+#import <Foundation/NSSet.h>
+#import <Foundation/NSString.h>
+#import <Foundation/NSValue.h>
+#import "AppKit/NSBitmapImageRep.h"
+#import "AppKit/NSGraphics.h"
+#import "AppKit/NSImage.h"
+#import "AppKit/NSImageRep.h"
+#import "GNUstepGUI/GSThemePack.h"
+
+@interface NSBitmapImageRep (GSPrivate)
+- (NSBitmapImageRep *) _convertToFormatBitsPerSample: (NSInteger)bps
+                                     samplesPerPixel: (NSInteger)spp
+                                            hasAlpha: (BOOL)alpha
+                                            isPlanar: (BOOL)isPlanar
+                                      colorSpaceName: (NSString*)colorSpaceName
+                                        bitmapFormat: (NSBitmapFormat)bitmapFormat
+                                         bytesPerRow: (NSInteger)rowBytes
+                                        bitsPerPixel: (NSInteger)pixelBits;
+@end
+
+/* A pack starts with a header of big endian 32 bit words:
+
+     magic, version, number of entries, offset and length of the names
+
+   followed by an entry of ENTRY_WORDS words for each file:
+
+     offset and length of its path (relative to the bundle) in the names,
+     kind, pixels wide, pixels high, bytes per row, samples per pixel,
+     width and height in points (as float bits),
+     offset and length of its contents in the pack
+
+   The names and then the contents of the files come after the entries,
+   each file aligned to PACK_ALIGN bytes.  Bitmaps are 8 bit meshed RGB
+   or premultiplied RGBA in the calibrated RGB colour space.  */
+#define PACK_MAGIC	0x47535450	/* 'GSTP' */
+#define PACK_VERSION	1
+#define HEADER_WORDS	5
+#define ENTRY_WORDS	11
+#define PACK_ALIGN	16
+
+enum {
+  PackBitmap = 0,
+  PackData = 1
+};
+
+typedef struct {
+  uint32_t	nameOffset;
+  uint32_t	nameLength;
+  uint32_t	kind;
+  uint32_t	width;
+  uint32_t	height;
+  uint32_t	bytesPerRow;
+  uint32_t	samplesPerPixel;
+  uint32_t	pointsWide;
+  uint32_t	pointsHigh;
+  uint32_t	dataOffset;
+  uint32_t	dataLength;
+} PackEntry;
+
+static inline uint32_t
+readWord(const unsigned char *bytes, NSUInteger index)
+{
+  uint32_t	w;
+
+  memcpy(&w, bytes + index * 4, 4);
+  return NSSwapBigIntToHost(w);
+}
+
+static inline void
+appendWord(NSMutableData *data, uint32_t w)
+{
+  w = NSSwapHostIntToBig(w);
+  [data appendBytes: &w length: 4];
+}
+
+static inline uint32_t
+floatBits(float f)
+{
+  union { float f; uint32_t i; } u;
+
+  u.f = f;
+  return u.i;
+}
+
+static inline float
+bitsFloat(uint32_t i)
+{
+  union { float f; uint32_t i; } u;
+
+  u.i = i;
+  return u.f;
+}
+
+static void
+readEntry(const unsigned char *bytes, NSUInteger index, PackEntry *e)
+{
+  NSUInteger	base = HEADER_WORDS + index * ENTRY_WORDS;
+
+  e->nameOffset = readWord(bytes, base);
+  e->nameLength = readWord(bytes, base + 1);
+  e->kind = readWord(bytes, base + 2);
+  e->width = readWord(bytes, base + 3);
+  e->height = readWord(bytes, base + 4);
+  e->bytesPerRow = readWord(bytes, base + 5);
+  e->samplesPerPixel = readWord(bytes, base + 6);
+  e->pointsWide = readWord(bytes, base + 7);
+  e->pointsHigh = readWord(bytes, base + 8);
+  e->dataOffset = readWord(bytes, base + 9);
+  e->dataLength = readWord(bytes, base + 10);
+}
+
+@implementation GSThemePack
+
++ (NSData*) packDataForBundle: (NSBundle*)bundle
+{
+  NSString		*root = [bundle bundlePath];
+  NSArray		*types = [NSImage imageFileTypes];
+  NSArray		*dirs;
+  NSMutableArray	*files;
+  NSMutableSet		*seen;
+  NSMutableData		*names;
+  NSMutableData		*contents;
+  NSMutableData		*pack;
+  PackEntry		*entries;
+  NSUInteger		count = 0;
+  NSUInteger		start;
+  NSUInteger		i;
+  NSUInteger		j;
+
+  files = [NSMutableArray arrayWithCapacity: 100];
+  dirs = [NSArray arrayWithObjects: @"ThemeImages", @"ThemeTiles", nil];
+  for (i = 0; i < [dirs count]; i++)
+    {
+      for (j = 0; j < [types count]; j++)
+	{
+	  [files addObjectsFromArray:
+	    [bundle pathsForResourcesOfType: [types objectAtIndex: j]
+				inDirectory: [dirs objectAtIndex: i]]];
+	}
+    }
+  [files addObjectsFromArray: [bundle pathsForResourcesOfType: @"clr"
+						  inDirectory: nil]];
+  if ([files count] == 0)
+    {
+      return nil;
+    }
+
+  entries = NSZoneCalloc(NSDefaultMallocZone(), [files count],
+    sizeof(PackEntry));
+  seen = [NSMutableSet setWithCapacity: [files count]];
+  names = [NSMutableData dataWithCapacity: 4096];
+  contents = [NSMutableData dataWithCapacity: 1024 * 1024];
+  for (i = 0; i < [files count]; i++)
+    {
+      NSString		*file = [files objectAtIndex: i];
+      NSString		*name;
+      PackEntry		*e = &entries[count];
+      NSData		*bytes = nil;
+      const char	*utf8;
+
+      if ([file hasPrefix: root] == NO || [file length] <= [root length]
+	|| [seen member: file] != nil)
+	{
+	  continue;
+	}
+      [seen addObject: file];
+      name = [file substringFromIndex: [root length] + 1];
+      memset(e, 0, sizeof(*e));
+
+      if ([[file pathExtension] isEqualToString: @"clr"])
+	{
+	  bytes = [NSData dataWithContentsOfFile: file];
+	  e->kind = PackData;
+	}
+      else
+	{
+	  NSArray		*reps;
+	  NSImageRep		*rep;
+
+	  /* Files with several representations (eg. for different
+	   * resolutions) are left in the bundle.
+	   */
+	  reps = [NSImageRep imageRepsWithContentsOfFile: file];
+	  rep = ([reps count] == 1) ? [reps objectAtIndex: 0] : nil;
+	  if ([rep isKindOfClass: [NSBitmapImageRep class]])
+	    {
+	      NSBitmapImageRep	*bitmap;
+	      BOOL		alpha = [rep hasAlpha];
+	      NSSize		size = [rep size];
+
+	      bitmap = [(NSBitmapImageRep*)rep
+		_convertToFormatBitsPerSample: 8
+			      samplesPerPixel: alpha ? 4 : 3
+				     hasAlpha: alpha
+				     isPlanar: NO
+			       colorSpaceName: NSCalibratedRGBColorSpace
+				 bitmapFormat: 0
+				  bytesPerRow: 0
+				 bitsPerPixel: 0];
+	      if (bitmap != nil)
+		{
+		  e->kind = PackBitmap;
+		  e->width = [bitmap pixelsWide];
+		  e->height = [bitmap pixelsHigh];
+		  e->bytesPerRow = [bitmap bytesPerRow];
+		  e->samplesPerPixel = [bitmap samplesPerPixel];
+		  e->pointsWide = floatBits(size.width);
+		  e->pointsHigh = floatBits(size.height);
+		  bytes = [NSData dataWithBytes: [bitmap bitmapData]
+					 length: e->bytesPerRow * e->height];
+		}
+	    }
+	}
+      if (bytes == nil)
+	{
+	  /* Not something we can decode in advance ... leave it to be
+	   * loaded from the bundle.
+	   */
+	  continue;
+	}
+
+      utf8 = [name UTF8String];
+      e->nameOffset = [names length];
+      e->nameLength = strlen(utf8);
+      [names appendBytes: utf8 length: e->nameLength];
+      [contents setLength: (([contents length] + PACK_ALIGN - 1)
+	/ PACK_ALIGN) * PACK_ALIGN];
+      e->dataOffset = [contents length];
+      e->dataLength = [bytes length];
+      [contents appendData: bytes];
+      count++;
+    }
+
+  if (count == 0)
+    {
+      NSZoneFree(NSDefaultMallocZone(), entries);
+      return nil;
+    }
+
+  /* The contents start at the first aligned offset after the names. */
+  start = (HEADER_WORDS + count * ENTRY_WORDS) * 4 + [names length];
+  start = ((start + PACK_ALIGN - 1) / PACK_ALIGN) * PACK_ALIGN;
+  pack = [NSMutableData dataWithCapacity: start + [contents length]];
+  appendWord(pack, PACK_MAGIC);
+  appendWord(pack, PACK_VERSION);
+  appendWord(pack, count);
+  appendWord(pack, (HEADER_WORDS + count * ENTRY_WORDS) * 4);
+  appendWord(pack, [names length]);
+  for (i = 0; i < count; i++)
+    {
+      PackEntry	*e = &entries[i];
+
+      appendWord(pack, e->nameOffset);
+      appendWord(pack, e->nameLength);
+      appendWord(pack, e->kind);
+      appendWord(pack, e->width);
+      appendWord(pack, e->height);
+      appendWord(pack, e->bytesPerRow);
+      appendWord(pack, e->samplesPerPixel);
+      appendWord(pack, e->pointsWide);
+      appendWord(pack, e->pointsHigh);
+      appendWord(pack, start + e->dataOffset);
+      appendWord(pack, e->dataLength);
+    }
+  [pack appendData: names];
+  [pack setLength: start];
+  [pack appendData: contents];
+  NSZoneFree(NSDefaultMallocZone(), entries);
+  return pack;
+}
+
+- (void) dealloc
+{
+  RELEASE(_data);
+  RELEASE(_index);
+  [super dealloc];
+}
+
+- (id) initWithContentsOfFile: (NSString*)path
+		   bundlePath: (NSString*)bundlePath
+{
+  const unsigned char	*bytes;
+  NSUInteger		length;
+  NSMutableDictionary	*index;
+  uint32_t		count;
+  uint32_t		namesOffset;
+  uint32_t		namesLength;
+  uint32_t		i;
+
+  if ((self = [super init]) == nil)
+    {
+      return nil;
+    }
+  _data = RETAIN([NSData dataWithContentsOfMappedFile: path]);
+  bytes = [_data bytes];
+  length = [_data length];
+  if (length < HEADER_WORDS * 4
+    || readWord(bytes, 0) != PACK_MAGIC
+    || readWord(bytes, 1) != PACK_VERSION)
+    {
+      DESTROY(self);
+      return nil;
+    }
+  count = readWord(bytes, 2);
+  namesOffset = readWord(bytes, 3);
+  namesLength = readWord(bytes, 4);
+  if (count > (length / 4 - HEADER_WORDS) / ENTRY_WORDS
+    || namesOffset < (HEADER_WORDS + count * ENTRY_WORDS) * 4
+    || namesOffset > length || namesLength > length - namesOffset)
+    {
+      DESTROY(self);
+      return nil;
+    }
+
+  index = [NSMutableDictionary dictionaryWithCapacity: count];
+  for (i = 0; i < count; i++)
+    {
+      PackEntry	e;
+      NSString	*name;
+
+      readEntry(bytes, i, &e);
+      if (e.nameOffset > namesLength
+	|| e.nameLength > namesLength - e.nameOffset
+	|| e.dataOffset > length || e.dataLength > length - e.dataOffset)
+	{
+	  DESTROY(self);
+	  return nil;
+	}
+      if (e.kind == PackBitmap
+	&& ((e.samplesPerPixel != 3 && e.samplesPerPixel != 4)
+	  || e.bytesPerRow < e.width * e.samplesPerPixel
+	  || (e.height > 0 && e.bytesPerRow > e.dataLength / e.height)))
+	{
+	  DESTROY(self);
+	  return nil;
+	}
+      name = [[NSString alloc] initWithBytes: bytes + namesOffset
+	+ e.nameOffset length: e.nameLength encoding: NSUTF8StringEncoding];
+      if (name != nil)
+	{
+	  [index setObject: [NSNumber numberWithUnsignedInt: i]
+		    forKey: [bundlePath stringByAppendingPathComponent: name]];
+	  RELEASE(name);
+	}
+    }
+  _index = [index copy];
+  return self;
+}
+
+- (NSBitmapImageRep*) bitmapForFile: (NSString*)path
+{
+  NSNumber		*n = [_index objectForKey: path];
+  const unsigned char	*bytes = [_data bytes];
+  unsigned char		*planes[5] = { 0 };
+  NSBitmapImageRep	*rep;
+  PackEntry		e;
+
+  if (n == nil)
+    {
+      return nil;
+    }
+  readEntry(bytes, [n unsignedIntValue], &e);
+  if (e.kind != PackBitmap)
+    {
+      return nil;
+    }
+  planes[0] = (unsigned char*)bytes + e.dataOffset;
+  rep = [[NSBitmapImageRep alloc]
+    initWithBitmapDataPlanes: planes
+		  pixelsWide: e.width
+		  pixelsHigh: e.height
+	       bitsPerSample: 8
+	     samplesPerPixel: e.samplesPerPixel
+		    hasAlpha: (e.samplesPerPixel == 4)
+		    isPlanar: NO
+	      colorSpaceName: NSCalibratedRGBColorSpace
+		bitmapFormat: 0
+		 bytesPerRow: e.bytesPerRow
+		bitsPerPixel: 8 * e.samplesPerPixel];
+  [rep setSize: NSMakeSize(bitsFloat(e.pointsWide), bitsFloat(e.pointsHigh))];
+  return AUTORELEASE(rep);
+}
+
+- (NSData*) dataForFile: (NSString*)path
+{
+  NSNumber		*n = [_index objectForKey: path];
+  const unsigned char	*bytes = [_data bytes];
+  PackEntry		e;
+
+  if (n == nil)
+    {
+      return nil;
+    }
+  readEntry(bytes, [n unsignedIntValue], &e);
+  if (e.kind != PackData)
+    {
+      return nil;
+    }
+  return [NSData dataWithBytesNoCopy: (void*)(bytes + e.dataOffset)
+			      length: e.dataLength
+			freeWhenDone: NO];
+}
+
+@end
@@ -139,7 +139,7 @@ static GSThemePanel	*sharedPanel = nil;
   NSButtonCell	*cell = [sender selectedCell];
   NSString	*name = [cell title];
 
-  [GSTheme setTheme: [GSTheme loadThemeNamed: name]];
+  [GSTheme setThemeWhenPrepared: [GSTheme loadThemeNamed: name]];
 }
 
 - (void) notified: (NSNotification*)n
@@ -66,7 +66,23 @@ typedef enum {
         	                 *  be customized in the nine-patch format */
   float		scaleFactor;
   GSThemeFillStyle	style;	/** The default style for filling a rect */
+  NSMutableDictionary	*composites;	/** Fully drawn rects by size */
+  NSMutableArray	*compositeOrder;	/** Their keys, oldest first */
+  BOOL		composing;	/** Drawing a rect to be kept */
+  BOOL		composeFlipped;	/** ... as seen in a flipped view */
 }
+/* Returns tiles sliced from the image in the file at path, loaded as
+ * an instance of imageClass, reusing the tiles sliced before while the
+ * file is unchanged. The image is sliced as a nine-patch image if
+ * ninePatch is YES, else divided x and y pixels in from either end,
+ * or into nine equal tiles if x or y is negative.
+ */
++ (GSDrawTiles*) tilesWithContentsOfFile: (NSString*)path
+			      imageClass: (Class)imageClass
+			       ninePatch: (BOOL)ninePatch
+			      horizontal: (float)x
+				vertical: (float)y;
+
 - (id) copyWithZone: (NSZone*)zone;
 
 /* Initialise with a single image, using 'annotations' to determinate
@@ -110,6 +126,12 @@ typedef enum {
  */
 - (NSRect) contentRectForRect: (NSRect)rect;
 
+/**
+ * Returns an estimate of the memory held by the tile images and the
+ * cached composites, at four bytes a pixel.
+ */
+- (NSUInteger) cachedBytes;
+
 /* Style drawing methods
  */
 - (NSRect) noneStyleFillRect: (NSRect)rect;
@@ -203,6 +225,13 @@ typedef enum {
  */
 + (GSTheme*) loadThemeNamed: (NSString*)aName;
 
+/**
+ * Returns the representations for the image file at path held in the
+ * pack of the theme, or nil if the theme has no pack or the file is not
+ * in it.
+ */
+- (NSArray*) _packedRepsForFile: (NSString*)path;
+
 // These two drawing method may be made public later on
 - (void) drawCircularBezel: (NSRect)cellFrame
 		 withColor: (NSColor*)backgroundColor;
@@ -26,8 +26,11 @@
    Boston, MA 02110-1301, USA.
 */
 
+#import <Foundation/NSAffineTransform.h>
 #import <Foundation/NSException.h>
+#import <Foundation/NSFileManager.h>
 #import "AppKit/NSBezierPath.h"
+#import "AppKit/NSBitmapImageRep.h"
 #import "AppKit/NSGraphics.h"
 #import "AppKit/NSImage.h"
 #import "AppKit/PSOperators.h"
@@ -727,7 +730,122 @@ withRepeatedImage: (NSImage*)image
 
 
 
+/* The number of fully drawn rects kept by each GSDrawTiles, and the
+   largest rect kept, in pixels. */
+#define MAX_COMPOSITES		8
+#define MAX_COMPOSITE_PIXELS	(256 * 256)
+
+/* The tiles sliced from image files, so that activating a theme again
+ * doesn't slice them again. Maps a key naming the file and how it is
+ * sliced to an array holding the modification date and size of the
+ * file and the tiles.
+ */
+static NSMutableDictionary	*slicedTiles = nil;
+
+#define MAX_SLICED_TILES	512
+
+/* Returns whether the pixel at (x,y), counted from the top left, is
+ * not transparent.
+ */
+static BOOL
+pixel_is_set(NSBitmapImageRep *rep, NSInteger x, NSInteger y,
+  NSInteger alpha)
+{
+  NSUInteger	pixel[5];
+
+  if (alpha < 0)
+    {
+      return YES;
+    }
+  [rep getPixel: pixel atX: x y: y];
+  return pixel[alpha] > 0;
+}
+
+@interface	GSDrawTiles (Private)
+- (BOOL) _isFlipped;
+- (NSImage*) _compositeForRect: (NSRect)rect
+		     fillStyle: (GSThemeFillStyle)aStyle;
+- (NSRect) _fillRect: (NSRect)rect fillStyle: (GSThemeFillStyle)aStyle;
+- (void) _invalidateComposites;
+@end
+
 @implementation	GSDrawTiles
++ (GSDrawTiles*) tilesWithContentsOfFile: (NSString*)path
+			      imageClass: (Class)imageClass
+			       ninePatch: (BOOL)ninePatch
+			      horizontal: (float)x
+				vertical: (float)y
+{
+  NSDictionary	*attributes;
+  NSArray	*stamp;
+  NSArray	*entry;
+  NSString	*key;
+  NSImage	*image;
+  GSDrawTiles	*tiles;
+  GSDrawTiles	*copy;
+
+  attributes = [[NSFileManager defaultManager] fileAttributesAtPath: path
+						       traverseLink: YES];
+  if (attributes == nil)
+    {
+      return nil;
+    }
+  stamp = [NSArray arrayWithObjects: [attributes fileModificationDate],
+    [NSNumber numberWithUnsignedLongLong: [attributes fileSize]], nil];
+  if (ninePatch == YES)
+    {
+      key = [NSString stringWithFormat: @"%@ %@ nine-patch",
+	NSStringFromClass(imageClass), path];
+    }
+  else
+    {
+      key = [NSString stringWithFormat: @"%@ %@ %g %g",
+	NSStringFromClass(imageClass), path, x, y];
+    }
+
+  entry = [slicedTiles objectForKey: key];
+  if (entry != nil && [[entry objectAtIndex: 0] isEqual: stamp])
+    {
+      return AUTORELEASE([[entry objectAtIndex: 1] copy]);
+    }
+
+  image = [[imageClass alloc] initWithContentsOfFile: path];
+  if (image == nil)
+    {
+      return nil;
+    }
+  if (ninePatch == YES)
+    {
+      tiles = [[self alloc] initWithNinePatchImage: image];
+    }
+  else if (x < 0.0 || y < 0.0)
+    {
+      tiles = [[self alloc] initWithImage: image];
+    }
+  else
+    {
+      tiles = [[self alloc] initWithImage: image horizontal: x vertical: y];
+    }
+  RELEASE(image);
+
+  if (slicedTiles == nil)
+    {
+      slicedTiles = [NSMutableDictionary new];
+    }
+  else if ([slicedTiles count] >= MAX_SLICED_TILES)
+    {
+      [slicedTiles removeAllObjects];
+    }
+  [slicedTiles setObject: [NSArray arrayWithObjects: stamp, tiles, nil]
+		  forKey: key];
+  /* The tiles we keep must not change, so we hand out copies, which
+   * share the bitmaps of the tiles.
+   */
+  copy = [tiles copy];
+  RELEASE(tiles);
+  return AUTORELEASE(copy);
+}
+
 - (id) copyWithZone: (NSZone*)zone
 {
   GSDrawTiles	*c = (GSDrawTiles*)NSCopyObject(self, 0, zone);
@@ -738,6 +856,9 @@ withRepeatedImage: (NSImage*)image
       c->images[i] = [images[i] copyWithZone: zone];
     }
   c->style = style;
+  c->composites = nil;
+  c->compositeOrder = nil;
+  c->composing = NO;
   return c;
 }
 
@@ -749,6 +870,8 @@ withRepeatedImage: (NSImage*)image
     {
       RELEASE(images[i]);
     }
+  RELEASE(composites);
+  RELEASE(compositeOrder);
   [super dealloc];
 }
 
@@ -782,24 +905,39 @@ withRepeatedImage: (NSImage*)image
 - (id) initWithNinePatchImage: (NSImage*)image
 {
   int i;
-  CGFloat r,g,b,a;
   int x1 = -1;
   int x2 = -1;
   int y1 = -1;
   int y2 = -1;
   NSSize s = [image size];
   NSBitmapImageRep* rep = [[image representations] objectAtIndex: 0];
+  NSInteger alpha;
+
+  /* Read the markers straight from the samples of the bitmap rather
+   * than making a colour for each pixel.
+   */
+  if ([rep hasAlpha] == NO)
+    {
+      alpha = -1;
+    }
+  else if ([rep bitmapFormat] & NSAlphaFirstBitmapFormat)
+    {
+      alpha = 0;
+    }
+  else
+    {
+      alpha = [rep samplesPerPixel] - 1;
+    }
 
   for (i = 0; i < s.width; i++)
     {
-      NSColor	*pixelColor = [rep colorAtX: i y: 0];
+      BOOL	set = pixel_is_set(rep, i, 0, alpha);
 
-      [pixelColor getRed: &r green: &g blue: &b alpha: &a];
-      if (a > 0 && x1 == -1)
+      if (set && x1 == -1)
         {
           x1 = i;
         }
-      else if (a == 0 && x1 != -1)
+      else if (!set && x1 != -1)
         {
           x2 = i - 1;
           break;
@@ -808,14 +946,13 @@ withRepeatedImage: (NSImage*)image
 
   for (i = 0; i < s.height; i++)
     {
-      NSColor	*pixelColor = [rep colorAtX: 0 y: i];
+      BOOL	set = pixel_is_set(rep, 0, i, alpha);
 
-      [pixelColor getRed: &r green: &g blue: &b alpha: &a];
-      if (a > 0 && y1 == -1)
+      if (set && y1 == -1)
         {
           y1 = i;
         }
-      else if (a == 0 && y1 != -1)
+      else if (!set && y1 != -1)
         {
           y2 = i - 1;
           break;
@@ -845,14 +982,13 @@ withRepeatedImage: (NSImage*)image
 
   for (i = 0; i < s.width; i++)
     {
-      NSColor	*pixelColor = [rep colorAtX: i y: s.height - 1];
+      BOOL	set = pixel_is_set(rep, i, s.height - 1, alpha);
 
-      [pixelColor getRed: &r green: &g blue: &b alpha: &a];
-      if (a > 0 && x1 == -1)
+      if (set && x1 == -1)
         {
           x1 = i;
         }
-      else if (a == 0 && x1 != -1)
+      else if (!set && x1 != -1)
         {
           x2 = i - 1;
           break;
@@ -861,14 +997,13 @@ withRepeatedImage: (NSImage*)image
 
   for (i = 0; i < s.height; i++)
     {
-      NSColor	*pixelColor = [rep colorAtX: s.width - 1 y: i];
+      BOOL	set = pixel_is_set(rep, s.width - 1, i, alpha);
 
-      [pixelColor getRed: &r green: &g blue: &b alpha: &a];
-      if (a > 0 && y1 == -1)
+      if (set && y1 == -1)
         {
           y1 = i;
         }
-      else if (a == 0 && y1 != -1)
+      else if (!set && y1 != -1)
         {
           y2 = i - 1;
           break;
@@ -907,8 +1042,69 @@ withRepeatedImage: (NSImage*)image
 
 - (NSImage*) extractImageFrom: (NSImage*) image withRect: (NSRect) rect
 {
-  NSImage *img = [[NSImage alloc] initWithSize: rect.size];
+  NSArray		*reps = [image representations];
+  NSBitmapImageRep	*rep = nil;
+  NSImage		*img;
+
+  if ([reps count] == 1)
+    {
+      rep = [reps objectAtIndex: 0];
+    }
+
+  /* When the image is a single bitmap drawn at its pixel size, copy the
+   * rows of the tile straight out of it rather than drawing it.
+   */
+  if ([rep isKindOfClass: [NSBitmapImageRep class]]
+    && [rep isPlanar] == NO && [rep bitsPerPixel] % 8 == 0
+    && [rep pixelsWide] == [image size].width
+    && [rep pixelsHigh] == [image size].height
+    && rect.origin.x == floor(rect.origin.x)
+    && rect.origin.y == floor(rect.origin.y)
+    && rect.size.width == floor(rect.size.width)
+    && rect.size.height == floor(rect.size.height)
+    && NSMaxX(rect) <= [rep pixelsWide] && NSMaxY(rect) <= [rep pixelsHigh])
+    {
+      NSBitmapImageRep	*tile;
+      NSInteger		bytesPerPixel = [rep bitsPerPixel] / 8;
+      NSInteger		width = rect.size.width;
+      NSInteger		height = rect.size.height;
+      NSInteger		srcBytesPerRow = [rep bytesPerRow];
+      NSInteger		dstBytesPerRow;
+      unsigned char	*src;
+      unsigned char	*dst;
+      NSInteger		i;
+
+      tile = [[NSBitmapImageRep alloc]
+	initWithBitmapDataPlanes: NULL
+		      pixelsWide: width
+		      pixelsHigh: height
+		   bitsPerSample: [rep bitsPerSample]
+		 samplesPerPixel: [rep samplesPerPixel]
+			hasAlpha: [rep hasAlpha]
+			isPlanar: NO
+		  colorSpaceName: [rep colorSpaceName]
+		    bitmapFormat: [rep bitmapFormat]
+		     bytesPerRow: 0
+		    bitsPerPixel: [rep bitsPerPixel]];
+      dstBytesPerRow = [tile bytesPerRow];
+      /* Bitmap rows run from the top, image coordinates from the bottom.
+       */
+      src = [rep bitmapData]
+	+ ([rep pixelsHigh] - (NSInteger)NSMaxY(rect)) * srcBytesPerRow
+	+ (NSInteger)rect.origin.x * bytesPerPixel;
+      dst = [tile bitmapData];
+      for (i = 0; i < height; i++)
+	{
+	  memcpy(dst + i * dstBytesPerRow, src + i * srcBytesPerRow,
+	    width * bytesPerPixel);
+	}
+      img = [[NSImage alloc] initWithSize: rect.size];
+      [img addRepresentation: tile];
+      RELEASE(tile);
+      return [img autorelease];
+    }
 
+  img = [[NSImage alloc] initWithSize: rect.size];
   [img lockFocus];
   [image drawAtPoint: NSMakePoint(0, 0)
 	    fromRect: rect
@@ -983,6 +1179,13 @@ withRepeatedImage: (NSImage*)image
       return;
     }
 
+  /* The matrix style scales the tiles while it draws and scales them
+   * back afterwards, so that doesn't change what is kept.
+   */
+  if (composing == NO)
+    {
+      [self _invalidateComposites];
+    }
   [images[0] setScalesWhenResized: YES];
   s = [images[0] size];
   s.width *= scale;
@@ -1032,6 +1235,8 @@ withRepeatedImage: (NSImage*)image
          background: (NSColor*)color
           fillStyle: (GSThemeFillStyle)aStyle
 {
+  NSImage	*composite;
+
   if (color == nil)
     {
       [[NSColor redColor] set];
@@ -1042,6 +1247,30 @@ withRepeatedImage: (NSImage*)image
     }
 //  NSRectFill(rect);
 
+  /* Drawing the tiles takes many composites, so we keep what was drawn
+   * for the last few sizes and draw that in one go.
+   */
+  composite = [self _compositeForRect: rect fillStyle: aStyle];
+  if (composite != nil)
+    {
+      NSPoint	p = rect.origin;
+
+      if ([self _isFlipped])
+	{
+	  p.y += rect.size.height;
+	}
+      [composite compositeToPoint: p operation: NSCompositeSourceOver];
+      if (aStyle == GSThemeFillStyleMatrix)
+	{
+	  return NSZeroRect;
+	}
+      return [self contentRectForRect: rect];
+    }
+  return [self _fillRect: rect fillStyle: aStyle];
+}
+
+- (NSRect) _fillRect: (NSRect)rect fillStyle: (GSThemeFillStyle)aStyle
+{
   switch (aStyle)
     {
       case GSThemeFillStyleNone:
@@ -1099,7 +1328,7 @@ withRepeatedImage: (NSImage*)image
 
 - (NSRect) centerStyleFillRect: (NSRect)rect
 {
-  BOOL flipped = [[GSCurrentContext() focusView] isFlipped];
+  BOOL flipped = [self _isFlipped];
 
   NSRect r = rects[TileCM];
   NSRect inFill = [self contentRectForRect: rect];
@@ -1123,7 +1352,7 @@ withRepeatedImage: (NSImage*)image
 
 - (NSRect) repeatStyleFillRect: (NSRect)rect
 {
-  BOOL flipped = [[GSCurrentContext() focusView] isFlipped];
+  BOOL flipped = [self _isFlipped];
 
   NSSize tsz = [self computeTotalTilesSize];
   NSRect inFill = [self contentRectForRect: rect];
@@ -1143,7 +1372,7 @@ withRepeatedImage: (NSImage*)image
 
 - (NSRect) scaleStyleFillRect: (NSRect)rect
 {
-  BOOL flipped = [[GSCurrentContext() focusView] isFlipped];
+  BOOL flipped = [self _isFlipped];
 
   NSRect inFill = [self contentRectForRect: rect];
 
@@ -1181,7 +1410,7 @@ withRepeatedImage: (NSImage*)image
 
 - (NSRect) scaleAllStyleFillRect: (NSRect)rect
 {
-  BOOL flipped = [[GSCurrentContext() focusView] isFlipped];
+  BOOL flipped = [self _isFlipped];
   NSSize cls = rects[TileCL].size;
   NSSize bms = rects[TileBM].size;
   NSSize crs = rects[TileCR].size;
@@ -1228,7 +1457,7 @@ withRepeatedImage: (NSImage*)image
   float y;
   float space = 3.0;
   float scale;
-  BOOL flipped = [[GSCurrentContext() focusView] isFlipped];
+  BOOL flipped = [self _isFlipped];
 
   if (images[TileTM] == nil)
     {
@@ -1374,7 +1603,7 @@ withRepeatedImage: (NSImage*)image
 
 - (void) repeatFillRect: (NSRect)rect
 {
-  BOOL flipped = [[GSCurrentContext() focusView] isFlipped];
+  BOOL flipped = [self _isFlipped];
 
   NSSize tls = rects[TileTL].size;
   NSSize tms = rects[TileTM].size;
@@ -1453,7 +1682,7 @@ withRepeatedImage: (NSImage*)image
 
 - (void) scaleFillRect: (NSRect)rect
 {
-  BOOL flipped = [[GSCurrentContext() focusView] isFlipped];
+  BOOL flipped = [self _isFlipped];
   NSImage *img;
   NSRect imgRect;
   NSPoint p;
@@ -1549,7 +1778,7 @@ withRepeatedImage: (NSImage*)image
 
 - (void) drawCornersRect: (NSRect)rect
 {
-  BOOL flipped = [[GSCurrentContext() focusView] isFlipped];
+  BOOL flipped = [self _isFlipped];
 
   NSSize tls = rects[TileTL].size;
   NSSize trs = rects[TileTR].size;
@@ -1611,3 +1840,153 @@ withRepeatedImage: (NSImage*)image
 
 @end
 
+@implementation	GSDrawTiles (Private)
+
+/* Whether the tiles are drawn as in a flipped view. While a rect is
+ * drawn to be kept, this is the flipping of the view it is drawn for.
+ */
+- (BOOL) _isFlipped
+{
+  if (composing == YES)
+    {
+      return composeFlipped;
+    }
+  return [[GSCurrentContext() focusView] isFlipped];
+}
+
+/* Returns an image of the tiles drawn in rect, making it if needed, or
+ * nil if the tiles should be drawn directly because rect is too large,
+ * not a whole number of pixels or drawn scaled or rotated.
+ */
+- (NSImage*) _compositeForRect: (NSRect)rect
+		     fillStyle: (GSThemeFillStyle)aStyle
+{
+  NSGraphicsContext		*ctxt = GSCurrentContext();
+  NSAffineTransformStruct	m;
+  NSString			*key;
+  NSImage			*composite;
+  NSImage			*scratch;
+  NSBitmapImageRep		*bitmap;
+  NSRect			r;
+  BOOL				flipped;
+
+  if (composing == YES
+    || rect.size.width != floor(rect.size.width)
+    || rect.size.height != floor(rect.size.height)
+    || rect.size.width * rect.size.height > MAX_COMPOSITE_PIXELS)
+    {
+      return nil;
+    }
+  m = [[ctxt GSCurrentCTM] transformStruct];
+  if (m.m12 != 0.0 || m.m21 != 0.0
+    || fabs(m.m11) != 1.0 || fabs(m.m22) != 1.0)
+    {
+      return nil;
+    }
+
+  flipped = [self _isFlipped];
+  key = [NSString stringWithFormat: @"%d %d %dx%d", (int)aStyle,
+    (int)flipped, (int)rect.size.width, (int)rect.size.height];
+  composite = [composites objectForKey: key];
+  if (composite != nil)
+    {
+      RETAIN(key);
+      [compositeOrder removeObject: key];
+      [compositeOrder addObject: key];
+      RELEASE(key);
+      return composite;
+    }
+
+  r = NSMakeRect(0, 0, rect.size.width, rect.size.height);
+  bitmap = nil;
+  scratch = [[NSImage alloc] initWithSize: r.size];
+  composing = YES;
+  composeFlipped = flipped;
+  NS_DURING
+    {
+      [scratch lockFocus];
+      if (flipped == YES)
+	{
+	  NSAffineTransform	*t = [NSAffineTransform transform];
+
+	  DPSgsave(ctxt);
+	  [t translateXBy: 0 yBy: r.size.height];
+	  [t scaleXBy: 1 yBy: -1];
+	  [t concat];
+	  [self _fillRect: r fillStyle: aStyle];
+	  DPSgrestore(ctxt);
+	}
+      else
+	{
+	  [self _fillRect: r fillStyle: aStyle];
+	}
+      bitmap = [[NSBitmapImageRep alloc] initWithFocusedViewRect: r];
+      [scratch unlockFocus];
+    }
+  NS_HANDLER
+    {
+      composing = NO;
+      [scratch unlockFocus];
+      RELEASE(scratch);
+      [localException raise];
+    }
+  NS_ENDHANDLER
+  composing = NO;
+  RELEASE(scratch);
+  if (bitmap == nil)
+    {
+      return nil;
+    }
+
+  composite = [[NSImage alloc] initWithSize: r.size];
+  [composite addRepresentation: bitmap];
+  RELEASE(bitmap);
+  if (composites == nil)
+    {
+      composites = [NSMutableDictionary new];
+      compositeOrder = [NSMutableArray new];
+    }
+  if ([compositeOrder count] >= MAX_COMPOSITES)
+    {
+      [composites removeObjectForKey: [compositeOrder objectAtIndex: 0]];
+      [compositeOrder removeObjectAtIndex: 0];
+    }
+  [composites setObject: composite forKey: key];
+  [compositeOrder addObject: key];
+  RELEASE(composite);
+  return composite;
+}
+
+- (void) _invalidateComposites
+{
+  [composites removeAllObjects];
+  [compositeOrder removeAllObjects];
+}
+
+- (NSUInteger) cachedBytes
+{
+  NSEnumerator	*e;
+  NSImage	*image;
+  NSUInteger	bytes = 0;
+  NSSize	s;
+  unsigned	i;
+
+  for (i = 0; i < 9; i++)
+    {
+      if (images[i] != nil)
+	{
+	  s = [images[i] size];
+	  bytes += (NSUInteger)(s.width * s.height) * 4;
+	}
+    }
+  e = [composites objectEnumerator];
+  while ((image = [e nextObject]) != nil)
+    {
+      s = [image size];
+      bytes += (NSUInteger)(s.width * s.height) * 4;
+    }
+  return bytes;
+}
+
+@end
+
@@ -0,0 +1,66 @@
+/*                                                    -*-objc-*-
+   GSThumbnailService.h
+
+   The private thumbnail generator behind NSWorkspace
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of the GNUstep GUI Library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; see the file COPYING.LIB.
+   If not, see <http://www.gnu.org/licenses/> or write to the
+   Free Software Foundation, 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef _GS_THUMBNAIL_SERVICE_H
+#define _GS_THUMBNAIL_SERVICE_H
+
+#import <Foundation/NSObject.h>
+
+@class NSString;
+
+/*
+ * Looks up and generates thumbnails on a small pool of background
+ * threads. Thumbnails are kept in the freedesktop.org thumbnail cache
+ * (the normal, 128 pixel size), named after the MD5 digest of the file's
+ * URI and tagged with the file's modification time and size, so other
+ * desktop programs can share them. A thumbnail is used only if both
+ * still match the file.
+ *
+ * Requests for a file that is already being worked on are merged, and
+ * every requester is answered on the main thread with
+ *
+ *   [target performSelector: aSelector withObject: image withObject: path]
+ *
+ * where image is nil if no thumbnail can be made for the file. Targets
+ * are retained until they have been answered.
+ *
+ * The cache is kept below the size in bytes given by the
+ * GSThumbnailCacheSize user default (64 MB if unset) by removing the
+ * thumbnails that were used least recently.
+ */
+@interface GSThumbnailService : NSObject
+
++ (GSThumbnailService *) sharedService;
+
+- (void) requestThumbnailForFile: (NSString *)path
+		   thumbnailPath: (NSString *)thumbnailPath
+			     URI: (NSString *)uri
+			  target: (id)target
+			selector: (SEL)aSelector;
+
+@end
+
+#endif
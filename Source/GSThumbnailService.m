@@ -0,0 +1,414 @@
+/*
+   GSThumbnailService.m
+
+   The private thumbnail generator behind NSWorkspace
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of the GNUstep GUI Library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; see the file COPYING.LIB.
+   If not, see <http://www.gnu.org/licenses/> or write to the
+   Free Software Foundation, 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#import "config.h"
+#import <Foundation/NSArray.h>
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSData.h>
+#import <Foundation/NSDate.h>
+#import <Foundation/NSDictionary.h>
+#import <Foundation/NSFileManager.h>
+#import <Foundation/NSLock.h>
+#import <Foundation/NSPathUtilities.h>
+#import <Foundation/NSString.h>
+#import <Foundation/NSThread.h>
+#import <Foundation/NSUserDefaults.h>
+#import <Foundation/NSValue.h>
+#import "AppKit/NSBitmapImageRep.h"
+#import "AppKit/NSGraphics.h"
+#import "AppKit/NSImage.h"
+#import "GSThumbnailService.h"
+#import "NSBitmapImageRep+PNG.h"
+
+/* The size of freedesktop.org "normal" thumbnails. */
+#define THUMBNAIL_SIZE 128
+/* The number of threads making thumbnails. */
+#define NUM_WORKERS 2
+/* The cache is trimmed after this many thumbnails were written. */
+#define TRIM_INTERVAL 32
+/* The default limit of the cache in bytes. */
+#define DEFAULT_CACHE_SIZE (64 * 1024 * 1024)
+
+/*
+ * The work for one file. It collects the targets of all requests for the
+ * file made while it is queued or being worked on.
+ */
+@interface GSThumbnailRequest : NSObject
+{
+@public
+  NSString *path;
+  NSString *thumbnailPath;
+  NSString *uri;
+  NSMutableArray *targets;
+  NSMutableArray *selectors;
+  NSBitmapImageRep *rep;
+}
+@end
+
+static NSMutableArray *queue = nil;
+static NSMutableDictionary *inFlight = nil;
+static NSCondition *queueCondition = nil;
+static NSUInteger writtenSinceTrim = 0;
+
+@implementation GSThumbnailRequest
+
+- (void) dealloc
+{
+  RELEASE(path);
+  RELEASE(thumbnailPath);
+  RELEASE(uri);
+  RELEASE(targets);
+  RELEASE(selectors);
+  RELEASE(rep);
+  [super dealloc];
+}
+
+- (void) deliver
+{
+  NSImage *image = nil;
+  NSArray *t, *s;
+  NSUInteger i;
+
+  /* Requests arriving from now on start over, so they see a thumbnail
+     that is written already. */
+  [queueCondition lock];
+  [inFlight removeObjectForKey: path];
+  t = AUTORELEASE([targets copy]);
+  s = AUTORELEASE([selectors copy]);
+  [queueCondition unlock];
+
+  if (rep != nil)
+    {
+      image = AUTORELEASE([[NSImage alloc] initWithSize: [rep size]]);
+      [image addRepresentation: rep];
+    }
+  for (i = 0; i < [t count]; i++)
+    {
+      [[t objectAtIndex: i]
+	performSelector: NSSelectorFromString([s objectAtIndex: i])
+	     withObject: image
+	     withObject: path];
+    }
+}
+
+@end
+
+
+/* Returns a copy of source scaled down to fit a THUMBNAIL_SIZE square,
+   as non-premultiplied RGBA. */
+static NSBitmapImageRep *
+scaledImage(NSBitmapImageRep *source)
+{
+  NSInteger w = [source pixelsWide];
+  NSInteger h = [source pixelsHigh];
+  NSInteger tw, th;
+
+  if (w <= 0 || h <= 0)
+    return nil;
+  if (w <= THUMBNAIL_SIZE && h <= THUMBNAIL_SIZE)
+    {
+      tw = w;
+      th = h;
+    }
+  else if (w >= h)
+    {
+      tw = THUMBNAIL_SIZE;
+      th = MAX(1, h * THUMBNAIL_SIZE / w);
+    }
+  else
+    {
+      th = THUMBNAIL_SIZE;
+      tw = MAX(1, w * THUMBNAIL_SIZE / h);
+    }
+
+  return [source bitmapImageRepByResamplingToPixelsWide: tw
+					     pixelsHigh: th
+						 filter: GSImageResamplingBox];
+}
+
+static NSComparisonResult
+compareModificationDates(id a, id b, void *context)
+{
+  return [[a objectAtIndex: 0] compare: [b objectAtIndex: 0]];
+}
+
+/* Removes the least recently used thumbnails in directory until the
+   files there take less than three quarters of the cache size. */
+static void
+trimCache(NSFileManager *mgr, NSString *directory)
+{
+  NSInteger limit;
+  NSArray *names;
+  NSMutableArray *files;
+  unsigned long long total = 0;
+  NSUInteger i;
+
+  limit = [[NSUserDefaults standardUserDefaults]
+	    integerForKey: @"GSThumbnailCacheSize"];
+  if (limit <= 0)
+    limit = DEFAULT_CACHE_SIZE;
+
+  names = [mgr directoryContentsAtPath: directory];
+  files = [NSMutableArray arrayWithCapacity: [names count]];
+  for (i = 0; i < [names count]; i++)
+    {
+      NSString *file;
+      NSDictionary *attrs;
+
+      if (![[[names objectAtIndex: i] pathExtension] isEqualToString: @"png"])
+	continue;
+      file = [directory stringByAppendingPathComponent:
+			  [names objectAtIndex: i]];
+      attrs = [mgr fileAttributesAtPath: file traverseLink: NO];
+      if (attrs == nil)
+	continue;
+      total += [attrs fileSize];
+      [files addObject: [NSArray arrayWithObjects:
+	[attrs fileModificationDate], file,
+	[NSNumber numberWithUnsignedLongLong: [attrs fileSize]], nil]];
+    }
+  if (total <= (unsigned long long)limit)
+    return;
+
+  [files sortUsingFunction: compareModificationDates context: NULL];
+  for (i = 0; i < [files count] && total > (unsigned long long)limit / 4 * 3;
+       i++)
+    {
+      NSArray *entry = [files objectAtIndex: i];
+
+      if ([mgr removeFileAtPath: [entry objectAtIndex: 1] handler: nil])
+	total -= [[entry objectAtIndex: 2] unsignedLongLongValue];
+    }
+}
+
+/* Returns the cached thumbnail of the file of request if it was made for
+   the file's current modification time and size. */
+static NSBitmapImageRep *
+cachedThumbnail(NSFileManager *mgr, GSThumbnailRequest *request,
+		NSString *mtime, NSString *size)
+{
+  NSData *data;
+  NSBitmapImageRep *rep;
+  NSDictionary *text;
+  NSString *s;
+
+  data = [NSData dataWithContentsOfFile: request->thumbnailPath];
+  if (data == nil)
+    return nil;
+  rep = [NSBitmapImageRep imageRepWithData: data];
+  text = [rep valueForProperty: GSImagePNGText];
+  if (![[text objectForKey: @"Thumb::MTime"] isEqualToString: mtime])
+    return nil;
+  s = [text objectForKey: @"Thumb::Size"];
+  if (s != nil && ![s isEqualToString: size])
+    return nil;
+
+  /* The modification date of the thumbnail itself says when it was last
+     used, so the cache can drop the ones unused for the longest time. */
+  [mgr changeFileAttributes:
+	 [NSDictionary dictionaryWithObject: [NSDate date]
+				     forKey: NSFileModificationDate]
+		     atPath: request->thumbnailPath];
+  return rep;
+}
+
+/* Makes a thumbnail for the file of request and writes it to the
+   cache. */
+static NSBitmapImageRep *
+newThumbnail(NSFileManager *mgr, GSThumbnailRequest *request,
+	     NSString *mtime, NSString *size)
+{
+  NSString *ext = [[request->path pathExtension] lowercaseString];
+  NSString *directory;
+  NSDictionary *text;
+  NSData *data;
+  NSBitmapImageRep *rep;
+  BOOL trim = NO;
+
+  if (![[NSBitmapImageRep imageUnfilteredFileTypes] containsObject: ext])
+    return nil;
+  data = [NSData dataWithContentsOfMappedFile: request->path];
+  if (data == nil)
+    return nil;
+  /* JPEG images are decoded at a reduced resolution where possible. */
+  rep = [NSBitmapImageRep imageRepWithData: data
+			      forPixelSize: NSMakeSize(THUMBNAIL_SIZE,
+						       THUMBNAIL_SIZE)];
+  rep = scaledImage(rep);
+  if (rep == nil)
+    return nil;
+
+  text = [NSDictionary dictionaryWithObjectsAndKeys:
+    request->uri, @"Thumb::URI",
+    mtime, @"Thumb::MTime",
+    size, @"Thumb::Size",
+    @"GNUstep", @"Software",
+    nil];
+  data = [rep representationUsingType: NSPNGFileType
+			   properties: [NSDictionary dictionaryWithObject: text
+					  forKey: GSImagePNGText]];
+  directory = [request->thumbnailPath stringByDeletingLastPathComponent];
+  if (data != nil
+      && [mgr createDirectoryAtPath: directory
+	withIntermediateDirectories: YES
+			 attributes: [NSDictionary dictionaryWithObject:
+			   [NSNumber numberWithUnsignedLong: 0700]
+				forKey: NSFilePosixPermissions]
+			      error: NULL]
+      && [data writeToFile: request->thumbnailPath atomically: YES])
+    {
+      [mgr changeFileAttributes:
+	     [NSDictionary dictionaryWithObject:
+			     [NSNumber numberWithUnsignedLong: 0600]
+					 forKey: NSFilePosixPermissions]
+			 atPath: request->thumbnailPath];
+      [queueCondition lock];
+      if (++writtenSinceTrim >= TRIM_INTERVAL)
+	{
+	  writtenSinceTrim = 0;
+	  trim = YES;
+	}
+      [queueCondition unlock];
+      if (trim)
+	trimCache(mgr, directory);
+    }
+  return rep;
+}
+
+static NSBitmapImageRep *
+thumbnailForRequest(GSThumbnailRequest *request)
+{
+  NSFileManager *mgr = AUTORELEASE([NSFileManager new]);
+  NSDictionary *attrs;
+  NSString *mtime, *size;
+  NSBitmapImageRep *rep;
+
+  attrs = [mgr fileAttributesAtPath: request->path traverseLink: YES];
+  if (attrs == nil || ![[attrs fileType] isEqualToString: NSFileTypeRegular])
+    return nil;
+  /* Don't make thumbnails of the thumbnails. */
+  if ([[request->path stringByDeletingLastPathComponent]
+	isEqualToString:
+	  [request->thumbnailPath stringByDeletingLastPathComponent]])
+    return nil;
+
+  mtime = [NSString stringWithFormat: @"%lld",
+    (long long)[[attrs fileModificationDate] timeIntervalSince1970]];
+  size = [NSString stringWithFormat: @"%llu", [attrs fileSize]];
+
+  rep = cachedThumbnail(mgr, request, mtime, size);
+  if (rep == nil)
+    rep = newThumbnail(mgr, request, mtime, size);
+  return rep;
+}
+
+
+@implementation GSThumbnailService
+
+static GSThumbnailService *sharedService = nil;
+
++ (GSThumbnailService *) sharedService
+{
+  if (sharedService == nil)
+    {
+      NSUInteger i;
+
+      sharedService = [self new];
+      queueCondition = [NSCondition new];
+      queue = [NSMutableArray new];
+      inFlight = [NSMutableDictionary new];
+      for (i = 0; i < NUM_WORKERS; i++)
+	{
+	  [NSThread detachNewThreadSelector: @selector(_thumbnailThread:)
+				   toTarget: self
+				 withObject: nil];
+	}
+    }
+  return sharedService;
+}
+
++ (void) _thumbnailThread: (id)unused
+{
+  while (YES)
+    {
+      CREATE_AUTORELEASE_POOL(pool);
+      GSThumbnailRequest *request;
+
+      [queueCondition lock];
+      while ([queue count] == 0)
+	{
+	  [queueCondition wait];
+	}
+      request = RETAIN([queue objectAtIndex: 0]);
+      [queue removeObjectAtIndex: 0];
+      [queueCondition unlock];
+
+      NS_DURING
+	{
+	  request->rep = RETAIN(thumbnailForRequest(request));
+	}
+      NS_HANDLER
+	{
+	  NSLog(@"Problem making thumbnail of '%@': %@",
+		request->path, localException);
+	}
+      NS_ENDHANDLER
+      [request performSelectorOnMainThread: @selector(deliver)
+				withObject: nil
+			     waitUntilDone: NO];
+      RELEASE(request);
+      DESTROY(pool);
+    }
+}
+
+- (void) requestThumbnailForFile: (NSString *)path
+		   thumbnailPath: (NSString *)thumbnailPath
+			     URI: (NSString *)uri
+			  target: (id)target
+			selector: (SEL)aSelector
+{
+  GSThumbnailRequest *request;
+
+  [queueCondition lock];
+  request = [inFlight objectForKey: path];
+  if (request == nil)
+    {
+      request = AUTORELEASE([GSThumbnailRequest new]);
+      request->path = [path copy];
+      request->thumbnailPath = [thumbnailPath copy];
+      request->uri = [uri copy];
+      request->targets = [NSMutableArray new];
+      request->selectors = [NSMutableArray new];
+      [inFlight setObject: request forKey: path];
+      [queue addObject: request];
+      [queueCondition signal];
+    }
+  [request->targets addObject: target];
+  [request->selectors addObject: NSStringFromSelector(aSelector)];
+  [queueCondition unlock];
+}
+
+@end
@@ -28,16 +28,44 @@
 #import <Foundation/NSObject.h>
 #import "GNUstepGUI/GSTrackingRect.h"
 
+@class	NSEvent;
+@class	NSString;
 @class	NSTimer;
 @class	NSView;
 @class	NSWindow;
 
+struct GSToolTipEntry;
+
 @interface	GSToolTips : NSObject
 {
   NSView		*view;
   NSTrackingRectTag	toolTipTag;
+  /* In lazy mode the tips are kept here, sorted by the bottom of their
+   * rectangles, under a single tracking rectangle for the view.
+   */
+  BOOL			lazy;
+  NSTrackingRectTag	viewTag;
+  NSRect		viewRect;
+  NSString		*viewToolTip;
+  struct GSToolTipEntry	*entries;
+  unsigned		entryCount;
+  unsigned		entryCapacity;
+  CGFloat		maxHeight;
+  NSToolTipTag		activeTag;
 }
 
+/** Sets whether tips for views created afterwards use a single
+ * tracking rectangle per view and look up the tip under the mouse as it
+ * moves, instead of a tracking rectangle per tip.  The default is NO,
+ * unless the GSLazyToolTips user default is set.
+ */
++ (void) setLazyTracking: (BOOL)flag;
+
+/** Lets the tips of the view the mouse is in, in lazy mode, follow the
+ * mouse from one tip to the next.
+ */
++ (void) trackMouseMoved: (NSEvent *)theEvent;
+
 /** Destroy object handling tips for aView.
  */
 + (void) removeTipsForView: (NSView*)aView;
@@ -200,9 +200,33 @@
 @end
 
 
+/* A tip in lazy mode.  As for GSTTProvider, the owner is not retained
+ * unless it is a string of our own, made from an object which does not
+ * provide strings.
+ */
+struct GSToolTipEntry
+{
+  NSRect	rect;
+  NSToolTipTag	tag;
+  id		owner;
+  void		*data;
+  BOOL		owned;
+};
+
+static BOOL
+provides_strings(id owner)
+{
+  return [owner respondsToSelector:
+    @selector(view:stringForToolTip:point:userData:)];
+}
+
 @interface	GSToolTips (Private)
 - (void) _endDisplay;
+- (unsigned) _entryAtPoint: (NSPoint)p;
+- (void) _startTimerWithString: (NSString *)toolTipString;
 - (void) _timedOut: (NSTimer *)timer;
+- (void) _trackMouse: (NSEvent *)theEvent;
+- (void) _updateViewTrackingRect;
 @end
 /*
 typedef struct NSView_struct
@@ -223,11 +247,20 @@ static GSTTPanel	*window = nil;
 static BOOL   isOpening = NO;
 static NSSize		offset;
 static BOOL		restoreMouseMoved;
+/* Lazy mode, the tips of the view the mouse is in, and the tag of the
+ * last tip added in lazy mode.
+ */
+static BOOL		lazyTracking = NO;
+static GSToolTips	*trackingTips = nil;
+static BOOL		restoreTrackingMouseMoved;
+static NSToolTipTag	lastLazyTag = 0;
 
 + (void) initialize
 {
   viewsMap = NSCreateMapTable(NSNonOwnedPointerMapKeyCallBacks,
 			     NSObjectMapValueCallBacks, 8);
+  lazyTracking = [[NSUserDefaults standardUserDefaults]
+		   boolForKey: @"GSLazyToolTips"];
            
   window = [[GSTTPanel alloc] initWithContentRect: NSMakeRect(0,0,100,25)
 				       styleMask: NSBorderlessWindowMask
@@ -242,6 +275,19 @@ static BOOL		restoreMouseMoved;
   [window setAutodisplay: NO];
 }
 
++ (void) setLazyTracking: (BOOL)flag
+{
+  lazyTracking = flag;
+}
+
++ (void) trackMouseMoved: (NSEvent *)theEvent
+{
+  if (trackingTips != nil)
+    {
+      [trackingTips _trackMouse: theEvent];
+    }
+}
+
 + (void) removeTipsForView: (NSView*)aView
 {
   GSToolTips	*tt = (GSToolTips*)NSMapGet(viewsMap, (void*)aView);
@@ -268,6 +314,92 @@ static BOOL		restoreMouseMoved;
 
 
 
+/* Returns the index of the first tip whose rectangle starts above y.  */
+static unsigned
+entry_after(struct GSToolTipEntry *entries, unsigned count, CGFloat y)
+{
+  unsigned	lo = 0;
+  unsigned	hi = count;
+
+  while (lo < hi)
+    {
+      unsigned	mid = (lo + hi) / 2;
+
+      if (NSMinY(entries[mid].rect) <= y)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  return lo;
+}
+
+static void
+remove_entry(struct GSToolTipEntry *entries, unsigned *count, unsigned i)
+{
+  if (entries[i].owned)
+    {
+      RELEASE(entries[i].owner);
+    }
+  (*count)--;
+  memmove(&entries[i], &entries[i + 1],
+    (*count - i) * sizeof(struct GSToolTipEntry));
+}
+
+/* Returns the index of the tip under p, the one added last if they
+ * overlap, or entryCount if there is none.  Only the tips starting at
+ * most maxHeight below p can contain it.
+ */
+- (unsigned) _entryAtPoint: (NSPoint)p
+{
+  unsigned	i = entry_after(entries, entryCount, p.y);
+  unsigned	found = entryCount;
+
+  while (i-- > 0 && NSMinY(entries[i].rect) >= p.y - maxHeight)
+    {
+      if (NSPointInRect(p, entries[i].rect)
+	&& (found == entryCount || entries[i].tag > entries[found].tag))
+	{
+	  found = i;
+	}
+    }
+  return found;
+}
+
+- (NSToolTipTag) _addLazyToolTipRect: (NSRect)aRect
+			       owner: (id)anObject
+			    userData: (void *)data
+{
+  struct GSToolTipEntry	*e;
+  unsigned		i;
+
+  if (entryCount == entryCapacity)
+    {
+      entryCapacity = (entryCapacity == 0) ? 8 : entryCapacity * 2;
+      entries = NSZoneRealloc(NSDefaultMallocZone(), entries,
+	entryCapacity * sizeof(struct GSToolTipEntry));
+    }
+  i = entry_after(entries, entryCount, NSMinY(aRect));
+  memmove(&entries[i + 1], &entries[i],
+    (entryCount - i) * sizeof(struct GSToolTipEntry));
+  entryCount++;
+  e = &entries[i];
+  e->rect = aRect;
+  e->tag = ++lastLazyTag;
+  e->data = data;
+  e->owned = (provides_strings(anObject) == NO);
+  if (e->owned)
+    {
+      e->owner = [[anObject description] copy];
+    }
+  else
+    {
+      e->owner = anObject;
+    }
+  maxHeight = MAX(maxHeight, NSHeight(aRect));
+  [self _updateViewTrackingRect];
+  return e->tag;
+}
+
 - (NSToolTipTag) addToolTipRect: (NSRect)aRect
                           owner: (id)anObject
                        userData: (void *)data
@@ -275,7 +407,7 @@ static BOOL		restoreMouseMoved;
   NSTrackingRectTag	tag;
   GSTTProvider		*provider;
 
-  if (timer != nil)
+  if (timer != nil && lazy == NO)
     {
       return -1;	// A tip is already in progress.
     }
@@ -288,6 +420,10 @@ static BOOL		restoreMouseMoved;
     {
       return -1;	// No provider object.
     }
+  if (lazy)
+    {
+      return [self _addLazyToolTipRect: aRect owner: anObject userData: data];
+    }
 
   provider = [[GSTTProvider alloc] initWithObject: anObject
 					 userData: data];
@@ -304,6 +440,10 @@ static BOOL		restoreMouseMoved;
   GSTrackingRect	*rect;
   unsigned		count = 0;
 
+  if (lazy)
+    {
+      return entryCount + (viewToolTip != nil ? 1 : 0);
+    }
   enumerator = [[view _trackingRects] objectEnumerator];
   while ((rect = [enumerator nextObject]) != nil)
     {
@@ -319,6 +459,7 @@ static BOOL		restoreMouseMoved;
 {
   [self _endDisplay];
   [self removeAllToolTips];
+  NSZoneFree(NSDefaultMallocZone(), entries);
   [super dealloc];
 }
 
@@ -326,6 +467,9 @@ static BOOL		restoreMouseMoved;
 {
   view = aView;
   toolTipTag = -1;
+  lazy = lazyTracking;
+  viewTag = -1;
+  activeTag = -1;
   return self;
 }
 
@@ -334,13 +478,17 @@ static BOOL		restoreMouseMoved;
   GSTTProvider	*provider;
   NSString	*toolTipString;
 
-  if (timer != nil)
+  if (lazy)
     {
-      /* Moved from one tooltip view to another, so reset the timer.
-       */
-      [timer invalidate];
-      timer = nil;
-      timedObject = nil;
+      trackingTips = self;
+      if ([[view window] acceptsMouseMovedEvents] == NO)
+	{
+	  restoreTrackingMouseMoved = YES;
+	  [[view window] setAcceptsMouseMovedEvents: YES];
+	}
+      activeTag = -1;
+      [self _trackMouse: theEvent];
+      return;
     }
 
   provider = (GSTTProvider*)[theEvent userData];
@@ -359,29 +507,22 @@ static BOOL		restoreMouseMoved;
     {
       toolTipString = [provider object];
     }
-
-  timer = [NSTimer scheduledTimerWithTimeInterval: 0.5
-                                           target: self
-                                         selector: @selector(_timedOut:)
-                                         userInfo: toolTipString
-                                          repeats: YES];
-  [[NSRunLoop currentRunLoop] addTimer: timer forMode: NSModalPanelRunLoopMode];
-  timedObject = self;
-  if ([[view window] acceptsMouseMovedEvents] == YES)
-    {
-      restoreMouseMoved = NO;
-    }
-  else
-    {
-      restoreMouseMoved = YES;
-      [[view window] setAcceptsMouseMovedEvents: YES];
-    }
-  [NSWindow _setToolTipVisible: self];
+  [self _startTimerWithString: toolTipString];
 }
 
 - (void) mouseExited: (NSEvent *)theEvent
 {
   [self _endDisplay];
+  if (lazy && trackingTips == self)
+    {
+      trackingTips = nil;
+      activeTag = -1;
+      if (restoreTrackingMouseMoved == YES)
+	{
+	  restoreTrackingMouseMoved = NO;
+	  [[view window] setAcceptsMouseMovedEvents: NO];
+	}
+    }
 }
 
 - (void) mouseDown: (NSEvent *)theEvent
@@ -394,6 +535,10 @@ static BOOL		restoreMouseMoved;
   NSPoint mouseLocation;
   NSPoint origin;
 
+  if (lazy)
+    {
+      [self _trackMouse: theEvent];
+    }
   if (window == nil)
     {
       return;
@@ -414,6 +559,18 @@ static BOOL		restoreMouseMoved;
 
   [self _endDisplay];
 
+  if (lazy)
+    {
+      while (entryCount > 0)
+	{
+	  remove_entry(entries, &entryCount, entryCount - 1);
+	}
+      DESTROY(viewToolTip);
+      toolTipTag = -1;
+      maxHeight = 0;
+      [self _updateViewTrackingRect];
+      return;
+    }
   enumerator = [[view _trackingRects] objectEnumerator];
   while ((rect = [enumerator nextObject]) != nil)
     {
@@ -430,8 +587,29 @@ static BOOL		restoreMouseMoved;
 - (void)removeToolTipsInRect: (NSRect)aRect
 {
   NSUInteger idx = 0;
-  NSMutableIndexSet *indexes = [NSMutableIndexSet new];
-  id tracking_rects = [view _trackingRects];
+  NSMutableIndexSet *indexes;
+  id tracking_rects;
+
+  if (lazy)
+    {
+      unsigned	i = entryCount;
+
+      while (i-- > 0)
+	{
+	  if (NSContainsRect(aRect, entries[i].rect))
+	    {
+	      if (entries[i].tag == activeTag)
+		{
+		  [self _endDisplay];
+		}
+	      remove_entry(entries, &entryCount, i);
+	    }
+	}
+      [self _updateViewTrackingRect];
+      return;
+    }
+  indexes = [NSMutableIndexSet new];
+  tracking_rects = [view _trackingRects];
   FOR_IN(GSTrackingRect*, rect, tracking_rects)
     if ((rect->owner == self) && NSContainsRect(aRect, rect->rectangle))
       {
@@ -455,6 +633,31 @@ static BOOL		restoreMouseMoved;
   NSEnumerator   	*enumerator;
   GSTrackingRect	*rect;
 
+  if (lazy)
+    {
+      unsigned	i;
+
+      if (tag == activeTag)
+	{
+	  [self _endDisplay];
+	  activeTag = -1;
+	}
+      if (tag == toolTipTag && toolTipTag != -1)
+	{
+	  DESTROY(viewToolTip);
+	  toolTipTag = -1;
+	}
+      for (i = 0; i < entryCount; i++)
+	{
+	  if (entries[i].tag == tag)
+	    {
+	      remove_entry(entries, &entryCount, i);
+	      break;
+	    }
+	}
+      [self _updateViewTrackingRect];
+      return;
+    }
   enumerator = [[view _trackingRects] objectEnumerator];
   while ((rect = [enumerator nextObject]) != nil)
     {
@@ -470,6 +673,26 @@ static BOOL		restoreMouseMoved;
 
 - (void) setToolTip: (NSString *)string
 {
+  if (lazy)
+    {
+      if ([string length] == 0)
+	{
+	  if (toolTipTag != -1)
+	    {
+	      [self removeToolTip: toolTipTag];
+	    }
+	}
+      else
+	{
+	  ASSIGNCOPY(viewToolTip, string);
+	  if (toolTipTag == -1)
+	    {
+	      toolTipTag = ++lastLazyTag;
+	    }
+	  [self _updateViewTrackingRect];
+	}
+      return;
+    }
   if ([string length] == 0)
     {
       if (toolTipTag != -1)
@@ -517,6 +740,10 @@ static BOOL		restoreMouseMoved;
   NSEnumerator		*enumerator;
   GSTrackingRect	*rect;
 
+  if (lazy)
+    {
+      return viewToolTip;
+    }
   enumerator = [[view _trackingRects] objectEnumerator];
   while ((rect = [enumerator nextObject]) != nil)
     {
@@ -532,6 +759,36 @@ static BOOL		restoreMouseMoved;
 
 @implementation	GSToolTips (Private)
 
+- (void) _startTimerWithString: (NSString *)toolTipString
+{
+  if (timer != nil)
+    {
+      /* Moved from one tooltip view to another, so reset the timer.
+       */
+      [timer invalidate];
+      timer = nil;
+      timedObject = nil;
+    }
+
+  timer = [NSTimer scheduledTimerWithTimeInterval: 0.5
+                                           target: self
+                                         selector: @selector(_timedOut:)
+                                         userInfo: toolTipString
+                                          repeats: YES];
+  [[NSRunLoop currentRunLoop] addTimer: timer forMode: NSModalPanelRunLoopMode];
+  timedObject = self;
+  if ([[view window] acceptsMouseMovedEvents] == YES)
+    {
+      restoreMouseMoved = NO;
+    }
+  else
+    {
+      restoreMouseMoved = YES;
+      [[view window] setAcceptsMouseMovedEvents: YES];
+    }
+  [NSWindow _setToolTipVisible: self];
+}
+
 - (void) _endDisplay
 {
   if (isOpening)
@@ -676,5 +933,89 @@ static BOOL		restoreMouseMoved;
   RELEASE(toolTipText);
 }
 
-@end
+/* Starts the timer for the tip under the mouse, in lazy mode, when the
+ * mouse has moved onto another tip, and stops the one shown for the tip
+ * it has left.
+ */
+- (void) _trackMouse: (NSEvent *)theEvent
+{
+  NSPoint	p;
+  unsigned	i;
+  NSToolTipTag	tag;
+  NSString	*string;
+
+  if ([theEvent window] != [view window])
+    {
+      return;
+    }
+  p = [view convertPoint: [theEvent locationInWindow] fromView: nil];
+  i = [self _entryAtPoint: p];
+  if (i < entryCount)
+    {
+      tag = entries[i].tag;
+    }
+  else if (viewToolTip != nil && NSPointInRect(p, [view bounds]))
+    {
+      tag = toolTipTag;
+    }
+  else
+    {
+      tag = -1;
+    }
+  if (tag == activeTag)
+    {
+      return;
+    }
 
+  [self _endDisplay];
+  activeTag = tag;
+  if (tag == -1)
+    {
+      return;
+    }
+  if (i == entryCount)
+    {
+      string = viewToolTip;
+    }
+  else if (entries[i].owned == NO)
+    {
+      string = [entries[i].owner view: view
+		     stringForToolTip: tag
+				point: p
+			     userData: entries[i].data];
+    }
+  else
+    {
+      string = entries[i].owner;
+    }
+  [self _startTimerWithString: string];
+}
+
+/* Keeps a single tracking rectangle over the view while it has tips in
+ * lazy mode, and makes it cover the bounds again when a tip is added.
+ */
+- (void) _updateViewTrackingRect
+{
+  BOOL		needed = (entryCount > 0 || viewToolTip != nil);
+  NSRect	bounds = [view bounds];
+
+  if (viewTag != -1 && (needed == NO || NSEqualRects(bounds, viewRect) == NO))
+    {
+      [view removeTrackingRect: viewTag];
+      viewTag = -1;
+      if (trackingTips == self)
+	{
+	  [self mouseExited: nil];
+	}
+    }
+  if (needed && viewTag == -1)
+    {
+      viewRect = bounds;
+      viewTag = [view addTrackingRect: viewRect
+				owner: self
+			     userData: NULL
+			 assumeInside: NO];
+    }
+}
+
+@end
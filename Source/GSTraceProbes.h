@@ -0,0 +1,75 @@
+/*                                                    -*-objc-*-
+   GSTraceProbes.h
+
+   Static trace probes on the hot paths of the library
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of the GNUstep GUI Library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; see the file COPYING.LIB.
+   If not, see <http://www.gnu.org/licenses/> or write to the
+   Free Software Foundation, 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef _GS_TRACE_PROBES_H
+#define _GS_TRACE_PROBES_H
+
+#import "config.h"
+
+/*
+ * Where <sys/sdt.h> is available each GS_PROBE marks a static probe of
+ * the gnustep_gui provider.  A probe is a single nop in the code and a
+ * note in the library, so it costs nothing until a tracer such as
+ * SystemTap, bpftrace or perf attaches to it, eg.
+ *
+ *   bpftrace -e 'usdt:libgnustep-gui.so:gnustep_gui:view_display_entry
+ *     { @start[tid] = nsecs; } ...'
+ *
+ * The arguments are evaluated even when nothing is attached, so on the
+ * paths which run often only values already at hand (ivars, locals,
+ * pointers) should be passed.  Each hot path has a pair of probes,
+ * name_entry and name_return:
+ *
+ *   app_send_event     NSApplication -sendEvent: (event, type)
+ *   window_send_event  NSWindow -sendEvent: (window, event)
+ *   view_display       NSView -displayRectIgnoringOpacity:inContext: (view)
+ *   window_flush       NSWindow -flushWindow (window, window number)
+ *   layout             GSLayoutManager layout (layout manager, glyph index)
+ *   glyph_generation   GSLayoutManager glyph generation (layout manager,
+ *                      character index)
+ *   image_decode       NSBitmapImageRep decoding (data, length)
+ *   model_load         GSModelLoader -loadModelFile:... (file system
+ *                      representation of the file name)
+ *
+ * Define GS_DISABLE_TRACE_PROBES to build without them.
+ */
+#if defined(HAVE_SYS_SDT_H) && !defined(GS_DISABLE_TRACE_PROBES)
+
+#include <sys/sdt.h>
+
+#define GS_PROBE1(name, a) \
+  STAP_PROBE1(gnustep_gui, name, a)
+#define GS_PROBE2(name, a, b) \
+  STAP_PROBE2(gnustep_gui, name, a, b)
+
+#else
+
+#define GS_PROBE1(name, a)
+#define GS_PROBE2(name, a, b)
+
+#endif
+
+#endif /* _GS_TRACE_PROBES_H */
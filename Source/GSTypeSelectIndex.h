@@ -0,0 +1,71 @@
+/*                                                    -*-objc-*-
+   GSTypeSelectIndex.h
+
+   A sorted index of item strings for type-select
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of the GNUstep GUI Library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; see the file COPYING.LIB.
+   If not, see <http://www.gnu.org/licenses/> or write to the
+   Free Software Foundation, 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef _GS_TYPE_SELECT_INDEX_H
+#define _GS_TYPE_SELECT_INDEX_H
+
+#import <Foundation/NSObject.h>
+
+@class NSArray;
+@class NSMutableArray;
+@class NSString;
+
+/*
+ * The strings of items 0 to count-1, such as the rows of a table or the
+ * cells of a browser column, kept sorted so that the items whose string
+ * starts with what the user typed are found by binary search.  Items
+ * with the same string are kept in ascending order.  Strings may be
+ * changed one item at a time when an item is reloaded.
+ */
+@interface GSTypeSelectIndex : NSObject
+{
+  NSMutableArray *_strings;	/* By item */
+  NSUInteger *_order;		/* Items sorted by string */
+  NSUInteger _count;
+  BOOL _foldsCase;
+}
+
+/* Makes an index of strings, which may hold NSNull for items with no
+   string.  If flag is YES, strings are matched ignoring case.  */
+- (id) initWithStrings: (NSArray *)strings foldsCase: (BOOL)flag;
+
+- (NSUInteger) count;
+- (void) setString: (NSString *)string forItem: (NSUInteger)item;
+
+/* Returns the first item from start on whose string has prefix, going
+   round to item 0 after the last item, or NSNotFound.  */
+- (NSUInteger) itemWithPrefix: (NSString *)prefix
+                   startingAt: (NSUInteger)start;
+
+/* Returns the first item whose string is string, or NSNotFound.  */
+- (NSUInteger) itemWithString: (NSString *)string;
+
+/* Returns the first item whose string has prefix and is longer than
+   it, or NSNotFound.  */
+- (NSUInteger) itemExtendingPrefix: (NSString *)prefix;
+@end
+
+#endif /* _GS_TYPE_SELECT_INDEX_H */
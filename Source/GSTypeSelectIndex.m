@@ -0,0 +1,248 @@
+/*
+   GSTypeSelectIndex.m
+
+   A sorted index of item strings for type-select
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of the GNUstep GUI Library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; see the file COPYING.LIB.
+   If not, see <http://www.gnu.org/licenses/> or write to the
+   Free Software Foundation, 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#import "config.h"
+#include <string.h>
+#import <Foundation/NSArray.h>
+#import <Foundation/NSNull.h>
+#import <Foundation/NSString.h>
+#import <Foundation/NSValue.h>
+#import "GSTypeSelectIndex.h"
+
+/* Strings are compared by their UTF-16 code units, so the strings with a
+   given prefix follow each other in the index.  */
+static inline NSComparisonResult
+compare_strings(NSString *a, NSString *b)
+{
+  return [a compare: b options: NSLiteralSearch];
+}
+
+static NSInteger
+compare_items(id a, id b, void *context)
+{
+  NSArray *strings = (NSArray *)context;
+  NSUInteger ia = [a unsignedIntegerValue];
+  NSUInteger ib = [b unsignedIntegerValue];
+  NSComparisonResult result;
+
+  result = compare_strings([strings objectAtIndex: ia],
+			   [strings objectAtIndex: ib]);
+  if (result == NSOrderedSame && ia != ib)
+    {
+      result = (ia < ib) ? NSOrderedAscending : NSOrderedDescending;
+    }
+  return result;
+}
+
+@implementation GSTypeSelectIndex
+
+- (NSString *) _keyForString: (id)string
+{
+  if (string == nil || string == [NSNull null])
+    {
+      return @"";
+    }
+  return _foldsCase ? [string lowercaseString] : string;
+}
+
+/* Returns the first place in the order whose string and item sort at
+   or after string and item.  */
+- (NSUInteger) _positionOfString: (NSString *)string
+                            item: (NSUInteger)item
+{
+  NSUInteger lo = 0;
+  NSUInteger hi = _count;
+
+  while (lo < hi)
+    {
+      NSUInteger mid = lo + (hi - lo) / 2;
+      NSUInteger other = _order[mid];
+      NSComparisonResult result;
+
+      result = compare_strings([_strings objectAtIndex: other], string);
+      if (result == NSOrderedAscending
+	  || (result == NSOrderedSame && other < item))
+	{
+	  lo = mid + 1;
+	}
+      else
+	{
+	  hi = mid;
+	}
+    }
+  return lo;
+}
+
+- (id) initWithStrings: (NSArray *)strings foldsCase: (BOOL)flag
+{
+  if ((self = [super init]) != nil)
+    {
+      NSMutableArray *items;
+      NSUInteger i;
+
+      _foldsCase = flag;
+      _count = [strings count];
+      _strings = [[NSMutableArray alloc] initWithCapacity: _count];
+      items = [NSMutableArray arrayWithCapacity: _count];
+      for (i = 0; i < _count; i++)
+	{
+	  [_strings addObject:
+	    [self _keyForString: [strings objectAtIndex: i]]];
+	  [items addObject: [NSNumber numberWithUnsignedInteger: i]];
+	}
+      [items sortUsingFunction: compare_items context: _strings];
+      _order = NSZoneMalloc(NSDefaultMallocZone(),
+			    MAX(_count, 1) * sizeof(NSUInteger));
+      for (i = 0; i < _count; i++)
+	{
+	  _order[i] = [[items objectAtIndex: i] unsignedIntegerValue];
+	}
+    }
+  return self;
+}
+
+- (void) dealloc
+{
+  NSZoneFree(NSDefaultMallocZone(), _order);
+  RELEASE(_strings);
+  [super dealloc];
+}
+
+- (NSUInteger) count
+{
+  return _count;
+}
+
+- (void) setString: (NSString *)string forItem: (NSUInteger)item
+{
+  NSString *key = [self _keyForString: string];
+  NSUInteger pos;
+
+  if (item > _count)
+    {
+      return;
+    }
+  if (item < _count)
+    {
+      pos = [self _positionOfString: [_strings objectAtIndex: item]
+			       item: item];
+      _count--;
+      memmove(_order + pos, _order + pos + 1,
+	      (_count - pos) * sizeof(NSUInteger));
+      [_strings replaceObjectAtIndex: item withObject: key];
+    }
+  else
+    {
+      _order = NSZoneRealloc(NSDefaultMallocZone(), _order,
+			     (_count + 1) * sizeof(NSUInteger));
+      [_strings addObject: key];
+    }
+
+  pos = [self _positionOfString: key item: item];
+  memmove(_order + pos + 1, _order + pos, (_count - pos) * sizeof(NSUInteger));
+  _order[pos] = item;
+  _count++;
+}
+
+- (NSUInteger) itemWithPrefix: (NSString *)prefix
+                   startingAt: (NSUInteger)start
+{
+  NSUInteger first = NSNotFound;
+  NSUInteger next = NSNotFound;
+  NSUInteger pos;
+
+  if ([prefix length] == 0)
+    {
+      return NSNotFound;
+    }
+  prefix = [self _keyForString: prefix];
+
+  /* The matching items follow each other from the first string not
+     sorting before the prefix.  */
+  for (pos = [self _positionOfString: prefix item: 0];
+       pos < _count && [[_strings objectAtIndex: _order[pos]] hasPrefix: prefix];
+       pos++)
+    {
+      NSUInteger item = _order[pos];
+
+      if (item < first)
+	{
+	  first = item;
+	}
+      if (item >= start && item < next)
+	{
+	  next = item;
+	  if (item == start)
+	    {
+	      break;
+	    }
+	}
+    }
+  return (next != NSNotFound) ? next : first;
+}
+
+- (NSUInteger) itemWithString: (NSString *)string
+{
+  NSUInteger pos;
+
+  string = [self _keyForString: string];
+  pos = [self _positionOfString: string item: 0];
+  if (pos < _count
+      && [[_strings objectAtIndex: _order[pos]] isEqualToString: string])
+    {
+      return _order[pos];
+    }
+  return NSNotFound;
+}
+
+- (NSUInteger) itemExtendingPrefix: (NSString *)prefix
+{
+  NSUInteger first = NSNotFound;
+  NSUInteger length;
+  NSUInteger pos;
+
+  prefix = [self _keyForString: prefix];
+  length = [prefix length];
+  for (pos = [self _positionOfString: prefix item: 0];
+       pos < _count && [[_strings objectAtIndex: _order[pos]] hasPrefix: prefix];
+       pos++)
+    {
+      NSUInteger item = _order[pos];
+
+      if (item < first
+	  && [[_strings objectAtIndex: item] length] > length)
+	{
+	  first = item;
+	  if (item == 0)
+	    {
+	      break;
+	    }
+	}
+    }
+  return first;
+}
+
+@end
@@ -409,7 +409,7 @@ static inline NSRect RectWithSizeScaledByFactor(NSRect aRect, CGFloat factor)
 - (void) setTitle: (NSString *)title
 {
   if (windowNumber)
-    [GSServerForWindow(window) titlewindow: title : windowNumber];
+    [GSServerForWindow(window) queuetitlewindow: title : windowNumber];
 }
 
 - (void) setWindowNumber: (NSInteger)theWindowNumber
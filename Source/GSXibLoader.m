@@ -26,13 +26,19 @@
 
 #import <Foundation/NSArray.h>
 #import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSByteOrder.h>
 #import <Foundation/NSData.h>
+#import <Foundation/NSDate.h>
 #import <Foundation/NSDebug.h>
 #import <Foundation/NSDictionary.h>
 #import <Foundation/NSException.h>
 #import <Foundation/NSFileManager.h>
 #import <Foundation/NSKeyedArchiver.h>
+#import <Foundation/NSMapTable.h>
+#import <Foundation/NSPathUtilities.h>
+#import <Foundation/NSSet.h>
 #import <Foundation/NSString.h>
+#import <Foundation/NSUserDefaults.h>
 #import <Foundation/NSValue.h>
 #import <Foundation/NSXMLParser.h>
 #import <Foundation/NSXMLDocument.h>
@@ -40,11 +46,13 @@
 #import	<GNUstepBase/GSMime.h>
 
 #import "AppKit/NSApplication.h"
+#import "AppKit/NSImage.h"
 #import "AppKit/NSNib.h"
 #import "AppKit/NSNibLoading.h"
 #import "GNUstepGUI/GSModelLoaderFactory.h"
 #import "GNUstepGUI/GSNibLoading.h"
 #import "GNUstepGUI/GSXibLoading.h"
+#import "GSGuiPrivate.h"
 
 @interface NSApplication (NibCompatibility)
 - (void) _setMainMenu: (NSMenu*)aMenu;
@@ -54,6 +62,10 @@
 - (BOOL) _isMainMenu;
 @end
 
+@interface NSImage (Private)
++ (void) _prefetchImagesNamed: (NSArray *)names;
+@end
+
 @interface NSCustomObject (NibCompatibility)
 - (id) realObject;
 - (void) setRealObject: (id)obj;
@@ -607,6 +619,10 @@
 
 - (void) dealloc
 {
+  if (objectsByID != NULL)
+    {
+      NSFreeMapTable(objectsByID);
+    }
   DESTROY(orderedObjects);
   [super dealloc];
 }
@@ -618,18 +634,27 @@
 
 - (id) objectWithObjectID: (NSInteger)objID
 {
-  NSEnumerator *en;
   IBObjectRecord *obj;
 
-  en = [orderedObjects objectEnumerator];
-  while ((obj = [en nextObject]) != nil)
+  /* Build the ID index on first use.  The records are not changed after
+     decoding, so it stays valid.  Where IDs repeat the first record wins,
+     as with a search in order.  */
+  if (objectsByID == NULL)
     {
-      if ([obj objectID] == objID)
+      NSEnumerator *en;
+
+      objectsByID = NSCreateMapTable(NSIntegerMapKeyCallBacks,
+                                     NSNonOwnedPointerMapValueCallBacks,
+                                     [orderedObjects count]);
+      en = [orderedObjects objectEnumerator];
+      while ((obj = [en nextObject]) != nil)
         {
-          return [obj object];
+          NSMapInsertIfAbsent(objectsByID, (void*)[obj objectID], obj);
         }
     }
-  return nil;
+
+  obj = NSMapGet(objectsByID, (void*)objID);
+  return [obj object];
 }
 
 @end
@@ -681,6 +706,7 @@
   DESTROY(connectionRecords);
   DESTROY(objectRecords);
   DESTROY(flattenedProperties);
+  DESTROY(propertiesByID);
   DESTROY(unlocalizedProperties);
   DESTROY(activeLocalization);
   DESTROY(localizations);
@@ -700,26 +726,76 @@
 
 - (NSDictionary*) propertiesForObjectID: (NSInteger)objectID
 {
-  NSEnumerator *en;
-  NSString *idString;
-  NSString *key;
-  NSMutableDictionary *properties;
-  NSUInteger idLength;
+  NSDictionary *properties;
 
-  idString = [NSString stringWithFormat: @"%ld.", (long)objectID];
-  idLength = [idString length];
-  properties = [[NSMutableDictionary alloc] init];
-  en = [flattenedProperties keyEnumerator];
-  while ((key = [en nextObject]) != nil)
+  /* Split the flattened properties by object ID once, rather than
+     scanning all of them for every object.  */
+  if (propertiesByID == nil)
     {
-      if ([key hasPrefix: idString])
+      NSEnumerator *en;
+      NSString *key;
+
+      propertiesByID = [[NSMutableDictionary alloc] init];
+      en = [flattenedProperties keyEnumerator];
+      while ((key = [en nextObject]) != nil)
         {
-          id value = [flattenedProperties objectForKey: key];
-          [properties setObject: value forKey: [key substringFromIndex: idLength]];
+          NSRange r = [key rangeOfString: @"."];
+          NSString *idString;
+          NSMutableDictionary *props;
+
+          if (r.location == NSNotFound)
+            {
+              continue;
+            }
+          idString = [key substringToIndex: r.location];
+          props = [propertiesByID objectForKey: idString];
+          if (props == nil)
+            {
+              props = [[NSMutableDictionary alloc] init];
+              [propertiesByID setObject: props forKey: idString];
+              RELEASE(props);
+            }
+          [props setObject: [flattenedProperties objectForKey: key]
+                    forKey: [key substringFromIndex: NSMaxRange(r)]];
         }
     }
 
-  return AUTORELEASE(properties);
+  properties = [propertiesByID objectForKey:
+    [NSString stringWithFormat: @"%ld", (long)objectID]];
+  if (properties == nil)
+    {
+      properties = [NSDictionary dictionary];
+    }
+  return properties;
+}
+
+/*
+  Makes the windows which are not visible at launch create their backend
+  window only when they are first ordered front.  Must be called before
+  the window templates are instantiated.
+ */
+- (void) deferWindowsNotVisibleAtLaunch
+{
+  NSEnumerator *en;
+  IBObjectRecord *obj;
+
+  en = [[objectRecords orderedObjects] objectEnumerator];
+  while ((obj = [en nextObject]) != nil)
+    {
+      id template = [obj object];
+
+      if ([template isKindOfClass: [NSWindowTemplate class]])
+        {
+          NSDictionary *properties;
+
+          properties = [self propertiesForObjectID: [obj objectID]];
+          if ([[properties objectForKey: @"NSWindowTemplate.visibleAtLaunch"]
+                boolValue] == NO)
+            {
+              [template setDeferred: YES];
+            }
+        }
+    }
 }
 
 /*
@@ -755,16 +831,23 @@
 {
   NSEnumerator *en;
   id obj;
+  NSTimeInterval step;
 
   // iterate over connections, instantiate, and then establish them.
+  step = GSModelLoadProfileBegin();
   en = [connectionRecords objectEnumerator];
   while ((obj = [en nextObject]) != nil)
     {
+      NSTimeInterval t = GSModelLoadProfileBegin();
+
       [obj nibInstantiate];
       [obj establishConnection];
+      GSModelLoadProfileEnd(t, @"connect", [obj connection]);
     }
+  GSModelLoadProfileEndStep(step, @"connect");
 
   // awaken all objects.
+  step = GSModelLoadProfileBegin();
   en = [[objectRecords orderedObjects] objectEnumerator];
   while ((obj = [en nextObject]) != nil)
     {
@@ -812,9 +895,13 @@
 
       if ([realObj respondsToSelector: @selector(awakeFromNib)])
         {
+          NSTimeInterval t = GSModelLoadProfileBegin();
+
           [realObj awakeFromNib];
+          GSModelLoadProfileEnd(t, @"awake", realObj);
         }
     }
+  GSModelLoadProfileEndStep(step, @"awake");
 
   return self;
 }
@@ -848,6 +935,7 @@
   id owner = [context objectForKey: NSNibOwner];
   id first = nil;
   id app   = nil;
+  NSTimeInterval step;
   
   // Get the file's owner and NSApplication object references...
   if ([[(NSCustomObject*)[rootObjects objectAtIndex: 1] className] isEqualToString: @"FirstResponder"])
@@ -862,12 +950,21 @@
 
   // Use the owner as first root object
   [(NSCustomObject*)[rootObjects objectAtIndex: 0] setRealObject: owner];
+
+  if ([[NSUserDefaults standardUserDefaults] boolForKey: @"GSDeferNibWindows"])
+    {
+      [objects deferWindowsNotVisibleAtLaunch];
+    }
+  step = GSModelLoadProfileBegin();
   en = [rootObjects objectEnumerator];
   while ((obj = [en nextObject]) != nil)
     {
       if ([obj respondsToSelector: @selector(nibInstantiate)])
         {
+          NSTimeInterval t = GSModelLoadProfileBegin();
+
           obj = [obj nibInstantiate];
+          GSModelLoadProfileEnd(t, @"instantiate", obj);
         }
 
       // IGNORE file's owner, first responder and NSApplication instances...
@@ -887,51 +984,47 @@
           [NSApp _setMainMenu: obj];
         }
     }
+  GSModelLoadProfileEndStep(step, @"instantiate");
 
   // Load connections and awaken objects
   [objects nibInstantiate];
 }
 
-- (BOOL) loadModelData: (NSData *)data
-     externalNameTable: (NSDictionary *)context
-              withZone: (NSZone *)zone;
+- (BOOL) loadModelWithUnarchiver: (GSXibKeyedUnarchiver *)unarchiver
+                externalNameTable: (NSDictionary *)context
+                         withZone: (NSZone *)zone
 {
   BOOL loaded = NO;
-  NSKeyedUnarchiver *unarchiver = nil;
 
   NS_DURING
     {
-      if (data != nil)
-	{
-          unarchiver = [[GSXibKeyedUnarchiver alloc] initForReadingWithData: data];
-	  if (unarchiver != nil)
-	    {
-              NSArray *rootObjects;
-              IBObjectContainer *objects;
-
-	      NSDebugLLog(@"XIB", @"Invoking unarchiver");
-	      [unarchiver setObjectZone: zone];
-              rootObjects = [unarchiver decodeObjectForKey: @"IBDocument.RootObjects"];
-              objects = [unarchiver decodeObjectForKey: @"IBDocument.Objects"];
-              NSDebugLLog(@"XIB", @"rootObjects %@", rootObjects);
-              [self awake: rootObjects inContainer: objects withContext: context];
-              loaded = YES;
-              RELEASE(unarchiver);
-	    }
-	  else
-	    {
-	      NSLog(@"Could not instantiate Xib unarchiver.");
-	    }
-	}
+      if (unarchiver != nil)
+        {
+          NSArray *rootObjects;
+          IBObjectContainer *objects;
+
+          NSTimeInterval t;
+
+          // Decode the images while the objects are instantiated.
+          [NSImage _prefetchImagesNamed: [unarchiver imageResourceNames]];
+          NSDebugLLog(@"XIB", @"Invoking unarchiver");
+          [unarchiver setObjectZone: zone];
+          t = GSModelLoadProfileBegin();
+          rootObjects = [unarchiver decodeObjectForKey: @"IBDocument.RootObjects"];
+          objects = [unarchiver decodeObjectForKey: @"IBDocument.Objects"];
+          GSModelLoadProfileEndStep(t, @"decode");
+          NSDebugLLog(@"XIB", @"rootObjects %@", rootObjects);
+          [self awake: rootObjects inContainer: objects withContext: context];
+          loaded = YES;
+        }
       else
-	{
-	  NSLog(@"Data passed to Xib loading method is nil.");
-	}
+        {
+          NSLog(@"Could not instantiate Xib unarchiver.");
+        }
     }
   NS_HANDLER
     {
       NSLog(@"Exception occured while loading model: %@",[localException reason]);
-      // TEST_RELEASE(unarchiver);
     }
   NS_ENDHANDLER
 
@@ -943,6 +1036,142 @@
   return loaded;
 }
 
+- (BOOL) loadModelData: (NSData *)data
+     externalNameTable: (NSDictionary *)context
+              withZone: (NSZone *)zone;
+{
+  GSXibKeyedUnarchiver *unarchiver;
+  BOOL loaded;
+  NSTimeInterval t;
+
+  if (data == nil)
+    {
+      NSLog(@"Data passed to Xib loading method is nil.");
+      return NO;
+    }
+
+  t = GSModelLoadProfileBegin();
+  unarchiver = [[GSXibKeyedUnarchiver alloc] initForReadingWithData: data];
+  GSModelLoadProfileEndStep(t, @"parse");
+  loaded = [self loadModelWithUnarchiver: unarchiver
+                       externalNameTable: context
+                                withZone: zone];
+  RELEASE(unarchiver);
+  return loaded;
+}
+
+/*
+  Returns the path of the compiled form of the xib at fileName in the
+  user's cache directory, or nil if the cache is turned off.
+ */
+- (NSString *) compiledPathForFile: (NSString *)fileName
+{
+  NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+  NSArray *paths;
+
+  if ([defaults boolForKey: @"GSDisableCompiledModelCache"]
+    || [NSClassSwapper isInInterfaceBuilder])
+    {
+      return nil;
+    }
+
+  paths = NSSearchPathForDirectoriesInDomains(NSCachesDirectory,
+                                              NSUserDomainMask, YES);
+  if ([paths count] == 0)
+    {
+      return nil;
+    }
+
+  return [[[paths objectAtIndex: 0] stringByAppendingPathComponent: @"GSXibCache"]
+           stringByAppendingPathComponent:
+             [NSString stringWithFormat: @"%@-%08lx.xibc",
+                       [[fileName lastPathComponent] stringByDeletingPathExtension],
+                       (unsigned long)[fileName hash]]];
+}
+
+/*
+  Loads the xib through its compiled form when that is newer than the
+  file, and writes the compiled form when it is missing or out of date.
+ */
+- (BOOL) loadModelFile: (NSString *)fileName
+     externalNameTable: (NSDictionary *)context
+              withZone: (NSZone *)zone
+{
+  NSFileManager *mgr = [NSFileManager defaultManager];
+  NSString *compiledPath = [self compiledPathForFile: fileName];
+  NSDictionary *attrs = [mgr fileAttributesAtPath: fileName traverseLink: YES];
+  GSXibKeyedUnarchiver *unarchiver = nil;
+  NSData *data;
+  BOOL loaded;
+  id profile;
+  NSTimeInterval t;
+
+  if (compiledPath == nil || attrs == nil)
+    {
+      return [super loadModelFile: fileName
+                externalNameTable: context
+                         withZone: zone];
+    }
+
+  GSLaunchTimelineBegin([fileName lastPathComponent]);
+  profile = GSModelLoadProfileOpen(fileName);
+  t = GSModelLoadProfileBegin();
+  data = [NSData dataWithContentsOfFile: compiledPath];
+  GSModelLoadProfileEndStep(t, @"read");
+  if (data != nil)
+    {
+      t = GSModelLoadProfileBegin();
+      unarchiver = [[GSXibKeyedUnarchiver alloc]
+                     initForReadingWithCompiledData: data
+                                         sourcePath: fileName
+                                   sourceAttributes: attrs];
+      GSModelLoadProfileEndStep(t, @"parse");
+      NSDebugLLog(@"XIB", @"Compiled Xib `%@' %@", compiledPath,
+                  unarchiver != nil ? @"used" : @"out of date");
+    }
+
+  if (unarchiver == nil)
+    {
+      t = GSModelLoadProfileBegin();
+      data = [self dataForFile: fileName];
+      GSModelLoadProfileEndStep(t, @"read");
+      if (data == nil)
+        {
+          GSModelLoadProfileClose(profile);
+          GSLaunchTimelineEnd([fileName lastPathComponent]);
+          return NO;
+        }
+      t = GSModelLoadProfileBegin();
+      unarchiver = [[GSXibKeyedUnarchiver alloc] initForReadingWithData: data];
+      GSModelLoadProfileEndStep(t, @"parse");
+      if (unarchiver != nil)
+        {
+          // Compile before decoding, which frees the parsed elements.
+          data = [unarchiver compiledDataForSourcePath: fileName
+                                      sourceAttributes: attrs];
+          [mgr createDirectoryAtPath: [compiledPath stringByDeletingLastPathComponent]
+         withIntermediateDirectories: YES
+                          attributes: nil
+                               error: NULL];
+          if ([data writeToFile: compiledPath atomically: YES] == NO)
+            {
+              NSDebugLLog(@"XIB", @"Could not write compiled Xib `%@'",
+                          compiledPath);
+            }
+        }
+    }
+
+  loaded = [self loadModelWithUnarchiver: unarchiver
+                       externalNameTable: context
+                                withZone: zone];
+  RELEASE(unarchiver);
+  if (!loaded)
+    NSLog(@"Could not load Nib file: %@", fileName);
+  GSModelLoadProfileClose(profile);
+  GSLaunchTimelineEnd([fileName lastPathComponent]);
+  return loaded;
+}
+
 - (NSData*) dataForFile: (NSString*)fileName
 {
   NSFileManager	*mgr = [NSFileManager defaultManager];
@@ -1027,6 +1256,11 @@
   ASSIGN(value, text);
 }
 
+- (NSDictionary*) attributes
+{
+  return attributes;
+}
+
 - (NSString*) attributeForKey: (NSString*)key
 {
   return [attributes objectForKey: key];
@@ -1037,6 +1271,17 @@
   return [elements objectForKey: key];
 }
 
+/*
+  Drops the child elements and text once the receiver has been decoded.
+  The attributes are kept, so references to the element still resolve.
+ */
+- (void) releaseElements
+{
+  [elements removeAllObjects];
+  [values removeAllObjects];
+  DESTROY(value);
+}
+
 - (NSString*) description
 {
   return [NSString stringWithFormat: 
@@ -1046,6 +1291,224 @@
 
 @end
 
+/*
+  The compiled form of a xib is its element tree after custom class
+  substitution.  All strings are stored once in a table at the start
+  and elements refer to them by index:
+
+    header:   magic, version, source size, source modification date,
+              source path index
+    strings:  count, then length and UTF-8 bytes of each string
+    element:  type index, attribute count, key and value index of each
+              attribute, value index, keyed child count, key index and
+              element of each keyed child, array child count, elements
+
+  Integers are 32 bit and the date is a double, all in network order.
+ */
+#define COMPILED_XIB_MAGIC 0x47535843  /* 'GSXC' */
+#define COMPILED_XIB_VERSION 1
+#define NO_STRING 0xffffffff
+
+typedef struct {
+  const unsigned char *bytes;
+  NSUInteger length;
+  NSUInteger pos;
+  NSArray *strings;
+  BOOL failed;
+} GSCompiledXibReader;
+
+static void
+appendInt(NSMutableData *data, uint32_t i)
+{
+  i = NSSwapHostIntToBig(i);
+  [data appendBytes: &i length: sizeof(i)];
+}
+
+static uint32_t
+internString(NSString *s, NSMutableDictionary *indexes, NSMutableArray *strings)
+{
+  NSNumber *n;
+
+  if (s == nil)
+    {
+      return NO_STRING;
+    }
+  n = [indexes objectForKey: s];
+  if (n == nil)
+    {
+      n = [NSNumber numberWithUnsignedInt: [strings count]];
+      [indexes setObject: n forKey: s];
+      [strings addObject: s];
+    }
+  return [n unsignedIntValue];
+}
+
+static void
+writeElement(GSXibElement *element, NSMutableData *data,
+             NSMutableDictionary *indexes, NSMutableArray *strings)
+{
+  NSDictionary *dict;
+  NSArray *values;
+  NSEnumerator *en;
+  NSString *key;
+  GSXibElement *child;
+
+  appendInt(data, internString([element type], indexes, strings));
+  dict = [element attributes];
+  appendInt(data, [dict count]);
+  en = [dict keyEnumerator];
+  while ((key = [en nextObject]) != nil)
+    {
+      appendInt(data, internString(key, indexes, strings));
+      appendInt(data, internString([dict objectForKey: key], indexes, strings));
+    }
+  appendInt(data, internString([element value], indexes, strings));
+
+  dict = [element elements];
+  appendInt(data, [dict count]);
+  en = [dict keyEnumerator];
+  while ((key = [en nextObject]) != nil)
+    {
+      appendInt(data, internString(key, indexes, strings));
+      writeElement([dict objectForKey: key], data, indexes, strings);
+    }
+
+  values = [element values];
+  appendInt(data, [values count]);
+  en = [values objectEnumerator];
+  while ((child = [en nextObject]) != nil)
+    {
+      writeElement(child, data, indexes, strings);
+    }
+}
+
+static void
+collectImageNames(GSXibElement *element, NSMutableSet *names)
+{
+  NSEnumerator *en;
+  GSXibElement *child;
+
+  if ([@"NSCustomResource" isEqualToString: [element attributeForKey: @"class"]])
+    {
+      NSString *name = [[element elementForKey: @"NSResourceName"] value];
+
+      if (name != nil
+        && [@"NSImage" isEqualToString:
+              [[element elementForKey: @"NSClassName"] value]])
+        {
+          [names addObject: name];
+        }
+      return;
+    }
+
+  en = [[element elements] objectEnumerator];
+  while ((child = [en nextObject]) != nil)
+    {
+      collectImageNames(child, names);
+    }
+  en = [[element values] objectEnumerator];
+  while ((child = [en nextObject]) != nil)
+    {
+      collectImageNames(child, names);
+    }
+}
+
+static uint32_t
+readInt(GSCompiledXibReader *r)
+{
+  uint32_t i;
+
+  if (r->failed || r->pos + sizeof(i) > r->length)
+    {
+      r->failed = YES;
+      return 0;
+    }
+  memcpy(&i, r->bytes + r->pos, sizeof(i));
+  r->pos += sizeof(i);
+  return NSSwapBigIntToHost(i);
+}
+
+static NSString *
+readString(GSCompiledXibReader *r)
+{
+  uint32_t i = readInt(r);
+
+  if (i == NO_STRING || r->failed)
+    {
+      return nil;
+    }
+  if (i >= [r->strings count])
+    {
+      r->failed = YES;
+      return nil;
+    }
+  return [r->strings objectAtIndex: i];
+}
+
+static GSXibElement *
+readElement(GSCompiledXibReader *r, NSMutableDictionary *objects)
+{
+  NSMutableDictionary *attributes;
+  GSXibElement *element;
+  NSString *type;
+  NSString *ref;
+  uint32_t count;
+  uint32_t i;
+
+  type = readString(r);
+  count = readInt(r);
+  if (r->failed || type == nil || count > r->length - r->pos)
+    {
+      r->failed = YES;
+      return nil;
+    }
+  attributes = [NSMutableDictionary dictionaryWithCapacity: count];
+  for (i = 0; i < count && !r->failed; i++)
+    {
+      NSString *key = readString(r);
+      NSString *value = readString(r);
+
+      if (key != nil && value != nil)
+        {
+          [attributes setObject: value forKey: key];
+        }
+    }
+
+  element = AUTORELEASE([[GSXibElement alloc] initWithType: type
+                                              andAttributes: attributes]);
+  [element setValue: readString(r)];
+  ref = [attributes objectForKey: @"id"];
+  if (ref != nil)
+    {
+      [objects setObject: element forKey: ref];
+    }
+
+  count = readInt(r);
+  for (i = 0; i < count && !r->failed; i++)
+    {
+      NSString *key = readString(r);
+      GSXibElement *child = readElement(r, objects);
+
+      if (key != nil && child != nil)
+        {
+          [element setElement: child forKey: key];
+        }
+    }
+
+  count = readInt(r);
+  for (i = 0; i < count && !r->failed; i++)
+    {
+      GSXibElement *child = readElement(r, objects);
+
+      if (child != nil)
+        {
+          [element addElement: child];
+        }
+    }
+
+  return r->failed ? nil : element;
+}
+
 @implementation GSXibKeyedUnarchiver
 
 - (NSData *) _preProcessXib: (NSData *)data
@@ -1237,6 +1700,168 @@
   [super dealloc];
 }
 
+/*
+  Sets up the receiver from the compiled form of the xib at path, as
+  written by -compiledDataForSourcePath:sourceAttributes:.  Returns nil
+  when the data is damaged or was compiled from a different version of
+  the file.
+ */
+- (id) initForReadingWithCompiledData: (NSData*)data
+                           sourcePath: (NSString*)path
+                     sourceAttributes: (NSDictionary*)attrs
+{
+  GSCompiledXibReader r;
+  NSMutableArray *strings;
+  NSSwappedDouble date;
+  unsigned long long size;
+  uint32_t count;
+  uint32_t i;
+
+  r.bytes = [data bytes];
+  r.length = [data length];
+  r.pos = 0;
+  r.strings = nil;
+  r.failed = NO;
+
+  if (readInt(&r) != COMPILED_XIB_MAGIC
+    || readInt(&r) != COMPILED_XIB_VERSION)
+    {
+      DESTROY(self);
+      return nil;
+    }
+  size = (unsigned long long)readInt(&r) << 32;
+  size |= readInt(&r);
+  if (r.failed || r.pos + sizeof(date) > r.length
+    || size != [attrs fileSize])
+    {
+      DESTROY(self);
+      return nil;
+    }
+  memcpy(&date, r.bytes + r.pos, sizeof(date));
+  r.pos += sizeof(date);
+  if (NSSwapBigDoubleToHost(date)
+    != [[attrs fileModificationDate] timeIntervalSinceReferenceDate])
+    {
+      DESTROY(self);
+      return nil;
+    }
+
+  count = readInt(&r);
+  if (r.failed || count > r.length - r.pos)
+    {
+      DESTROY(self);
+      return nil;
+    }
+  strings = [NSMutableArray arrayWithCapacity: count];
+  for (i = 0; i < count && !r.failed; i++)
+    {
+      uint32_t length = readInt(&r);
+      NSString *s;
+
+      if (r.failed || length > r.length - r.pos)
+        {
+          r.failed = YES;
+          break;
+        }
+      s = [[NSString alloc] initWithBytes: r.bytes + r.pos
+                                   length: length
+                                 encoding: NSUTF8StringEncoding];
+      if (s == nil)
+        {
+          r.failed = YES;
+          break;
+        }
+      [strings addObject: s];
+      RELEASE(s);
+      r.pos += length;
+    }
+  r.strings = strings;
+  if (r.failed || [path isEqualToString: readString(&r)] == NO)
+    {
+      DESTROY(self);
+      return nil;
+    }
+
+  objects = [[NSMutableDictionary alloc] init];
+  stack = [[NSMutableArray alloc] init];
+  decoded = [[NSMutableDictionary alloc] init];
+
+  currentElement = readElement(&r, objects);
+  if (currentElement == nil || r.pos != r.length)
+    {
+      DESTROY(self);
+      return nil;
+    }
+  // No other element retains the root, so keep it on the stack.
+  [stack addObject: currentElement];
+
+  return self;
+}
+
+/*
+  Returns the names of the images the xib refers to as resources.  Like
+  -compiledDataForSourcePath:sourceAttributes:, this must be called
+  before decoding.
+ */
+- (NSArray*) imageResourceNames
+{
+  NSMutableSet *names = [NSMutableSet set];
+
+  if (currentElement != nil)
+    {
+      collectImageNames(currentElement, names);
+    }
+  return [names allObjects];
+}
+
+/*
+  Returns the parsed element tree of the receiver in compiled form.  This
+  must be called before anything is decoded, since decoding frees the
+  elements.
+ */
+- (NSData*) compiledDataForSourcePath: (NSString*)path
+                     sourceAttributes: (NSDictionary*)attrs
+{
+  NSMutableDictionary *indexes = [NSMutableDictionary dictionary];
+  NSMutableArray *strings = [NSMutableArray array];
+  NSMutableData *body = [NSMutableData data];
+  NSMutableData *data = [NSMutableData data];
+  NSEnumerator *en;
+  NSString *s;
+  NSSwappedDouble date;
+  unsigned long long size = [attrs fileSize];
+  uint32_t pathIndex;
+
+  if (currentElement == nil)
+    {
+      return nil;
+    }
+  pathIndex = internString(path, indexes, strings);
+  writeElement(currentElement, body, indexes, strings);
+
+  appendInt(data, COMPILED_XIB_MAGIC);
+  appendInt(data, COMPILED_XIB_VERSION);
+  appendInt(data, (uint32_t)(size >> 32));
+  appendInt(data, (uint32_t)size);
+  date = NSSwapHostDoubleToBig(
+    [[attrs fileModificationDate] timeIntervalSinceReferenceDate]);
+  [data appendBytes: &date length: sizeof(date)];
+
+  appendInt(data, [strings count]);
+  en = [strings objectEnumerator];
+  while ((s = [en nextObject]) != nil)
+    {
+      NSData *d = [s dataUsingEncoding: NSUTF8StringEncoding];
+
+      appendInt(data, [d length]);
+      [data appendData: d];
+    }
+  appendInt(data, pathIndex);
+  [data appendData: body];
+
+  return data;
+}
+
 - (void) parser: (NSXMLParser*)parser
 foundCharacters: (NSString*)string
 {
@@ -1364,6 +1989,7 @@ didStartElement: (NSString*)elementName
   GSXibElement *last;
   id o, r;
   id delegate = [self delegate];
+  NSTimeInterval t = GSModelLoadProfileBegin();
 
   // Create instance.
   o = [self allocObjectForClassName: classname];
@@ -1418,6 +2044,7 @@ didStartElement: (NSString*)elementName
 
   // Balance the retain above
   RELEASE(o);
+  GSModelLoadProfileEnd(t, @"decode", o);
   
   if (objID != nil)
     {
@@ -1438,6 +2065,7 @@ didStartElement: (NSString*)elementName
 {
   id o, r;
   id delegate = [self delegate];
+  NSTimeInterval t = GSModelLoadProfileBegin();
 
   // Create instance.
   o = [self allocObjectForClassName: classname];
@@ -1483,6 +2111,7 @@ didStartElement: (NSString*)elementName
     }
   // Balance the retain above
   RELEASE(o);
+  GSModelLoadProfileEnd(t, @"decode", o);
   
   if (objID != nil)
     {
@@ -1492,6 +2121,22 @@ didStartElement: (NSString*)elementName
   return AUTORELEASE(o);
 }
 
+/*
+  Once an element with an ID has been decoded, any further request for it
+  is answered from the decoded objects, so its subtree and its entry in the
+  ID index are no longer needed.  Elements without an ID may still be
+  decoded again by their parent and are kept.
+ */
+- (void) _releaseDecodedElement: (GSXibElement*)element
+                         withID: (NSString*)objID
+{
+  if (objID != nil && [decoded objectForKey: objID] != nil)
+    {
+      [element releaseElements];
+      [objects removeObjectForKey: objID];
+    }
+}
+
 - (id) objectForXib: (GSXibElement*)element
 {
   NSString *elementName;
@@ -1516,9 +2161,12 @@ didStartElement: (NSString*)elementName
   if ([@"object" isEqualToString: elementName])
     {
       NSString *classname = [element attributeForKey: @"class"];
-      return [self decodeObjectForXib: element
-                         forClassName: classname
-                               withID: objID];
+      id new = [self decodeObjectForXib: element
+                           forClassName: classname
+                                 withID: objID];
+
+      [self _releaseDecodedElement: element withID: objID];
+      return new;
     }
   else if ([@"string" isEqualToString: elementName])
     {
@@ -1654,26 +2302,34 @@ didStartElement: (NSString*)elementName
     {
       NSString *classname = [element attributeForKey: @"class"];
 
+      id new;
+
       if (classname == nil)
         {
           classname = @"NSArray";
         }
-      return [self decodeObjectForXib: element
-                         forClassName: classname
-                               withID: objID];
+      new = [self decodeObjectForXib: element
+                        forClassName: classname
+                              withID: objID];
+      [self _releaseDecodedElement: element withID: objID];
+      return new;
     }
   else if ([@"dictionary" isEqualToString: elementName])
     {
       NSString *classname = [element attributeForKey: @"class"];
 
+      id new;
+
       if (classname == nil)
         {
           classname = @"NSDictionary";
         }
 
-      return [self decodeDictionaryForXib: element
-                             forClassName: classname
-                                   withID: objID];
+      new = [self decodeDictionaryForXib: element
+                            forClassName: classname
+                                  withID: objID];
+      [self _releaseDecodedElement: element withID: objID];
+      return new;
     }
   else
     {
@@ -346,3 +346,64 @@ static const CGFloat pi = 3.1415926535897932384626434;
 
 @end /* NSAffineTransform (GNUstep) */
 
+@implementation NSAffineTransform (GSTransformArrays)
+
+- (void) transformPoints: (NSPoint *)points count: (NSUInteger)count
+{
+  NSAffineTransformStruct matrix = [self transformStruct];
+  NSUInteger i;
+
+  for (i = 0; i < count; i++)
+    {
+      CGFloat x = points[i].x;
+      CGFloat y = points[i].y;
+
+      points[i].x = A * x + C * y + TX;
+      points[i].y = B * x + D * y + TY;
+    }
+}
+
+- (void) transformRects: (NSRect *)rects count: (NSUInteger)count
+{
+  NSAffineTransformStruct matrix = [self transformStruct];
+  NSUInteger i;
+
+  if (B == 0 && C == 0)
+    {
+      /* Without rotation each side maps to a side.  */
+      for (i = 0; i < count; i++)
+	{
+	  CGFloat x = A * rects[i].origin.x + TX;
+	  CGFloat y = D * rects[i].origin.y + TY;
+	  CGFloat w = A * rects[i].size.width;
+	  CGFloat h = D * rects[i].size.height;
+
+	  rects[i].origin.x = (w < 0) ? x + w : x;
+	  rects[i].origin.y = (h < 0) ? y + h : y;
+	  rects[i].size.width = fabs(w);
+	  rects[i].size.height = fabs(h);
+	}
+    }
+  else
+    {
+      for (i = 0; i < count; i++)
+	{
+	  CGFloat x = rects[i].origin.x;
+	  CGFloat y = rects[i].origin.y;
+	  CGFloat width = rects[i].size.width;
+	  CGFloat height = rects[i].size.height;
+	  CGFloat x0 = A * x + C * y + TX;
+	  CGFloat y0 = B * x + D * y + TY;
+	  CGFloat wx = A * width, wy = B * width;
+	  CGFloat hx = C * height, hy = D * height;
+
+	  rects[i].origin.x = x0 + MIN(wx, 0) + MIN(hx, 0);
+	  rects[i].origin.y = y0 + MIN(wy, 0) + MIN(hy, 0);
+	  rects[i].size.width = fabs(wx) + fabs(hx);
+	  rects[i].size.height = fabs(wy) + fabs(hy);
+	}
+    }
+}
+
+@end /* NSAffineTransform (GSTransformArrays) */
+
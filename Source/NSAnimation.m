@@ -42,6 +42,7 @@
 // needed by NSViewAnimation
 #import "AppKit/NSView.h"
 #import "AppKit/NSWindow.h"
+#import "GNUstepGUI/GSDisplayServer.h"
 
 #include <math.h>
 
@@ -151,6 +152,35 @@ _gs_animationValueForCurve(_NSAnimationCurveDesc *c, float t, float t0)
   return _GSRationalBezierEval ( &(c->rb), (t-t0) / (1.0-t0) );
 }
 
+/* The standard curves sampled at GS_ANIMATION_CURVE_STEPS + 1 evenly
+ * spaced progress values, filled in once by +initialize and shared by
+ * all animations.  Values in between are interpolated linearly, which
+ * keeps the error well below what is visible on screen.
+ */
+#define GS_ANIMATION_CURVE_COUNT \
+  (sizeof(_gs_animationCurveDesc) / sizeof(_gs_animationCurveDesc[0]))
+#define GS_ANIMATION_CURVE_STEPS 256
+
+static float
+_gs_animationCurveTable[GS_ANIMATION_CURVE_COUNT][GS_ANIMATION_CURVE_STEPS + 1];
+
+static inline float
+_gs_animationTableValueForCurve(NSAnimationCurve curve, float t)
+{
+  const float	*table = _gs_animationCurveTable[curve];
+  float		x;
+  unsigned	i;
+
+  if (t <= 0.0)
+    return table[0];
+  if (t >= 1.0)
+    return table[GS_ANIMATION_CURVE_STEPS];
+  x = t * GS_ANIMATION_CURVE_STEPS;
+  i = (unsigned)x;
+  x -= i;
+  return table[i] + x * (table[i + 1] - table[i]);
+}
+
 @interface NSAnimation (PrivateNotificationCallbacks)
 - (void) _gs_startAnimationReachesProgressMark: (NSNotification*)notification;
 - (void) _gs_stopAnimationReachesProgressMark: (NSNotification*)notification;
@@ -208,10 +238,16 @@ nsanimation_progressMarkSorter(NSAnimationProgress first, NSAnimationProgress se
 
 + (void) initialize
 {
-  unsigned i;
+  unsigned i, j;
 
-  for (i = 0; i < 5; i++) // compute Bezier curve parameters...
-    _gs_animationValueForCurve(&_gs_animationCurveDesc[i], 0.0, 0.0);
+  for (i = 0; i < GS_ANIMATION_CURVE_COUNT; i++)
+    {
+      /* compute Bezier curve parameters, then sample the curve */
+      for (j = 0; j <= GS_ANIMATION_CURVE_STEPS; j++)
+        _gs_animationCurveTable[i][j]
+          = _gs_animationValueForCurve(&_gs_animationCurveDesc[i],
+            (float)j / GS_ANIMATION_CURVE_STEPS, 0.0);
+    }
   _NSAnimationDefaultRunLoopModes
     = [[NSArray alloc] initWithObjects:
         NSDefaultRunLoopMode,
@@ -350,9 +386,18 @@ nsanimation_progressMarkSorter(NSAnimationProgress first, NSAnimationProgress se
                case NSAnimationEaseIn:
               case NSAnimationEaseOut:
            case NSAnimationSpeedInOut:*/
-      value = _gs_animationValueForCurve ( 
-                &_curveDesc, _currentProgress, _curveProgressShift
-                );
+      {
+        /* The standard curves are looked up in the shared table; a
+         * curve changed while the animation was running has its own
+         * Bezier and is evaluated directly. */
+        if (_curveProgressShift == 0.0
+          && (NSUInteger)_curve < GS_ANIMATION_CURVE_COUNT)
+          value = _gs_animationTableValueForCurve (_curve, _currentProgress);
+        else
+          value = _gs_animationValueForCurve ( 
+                    &_curveDesc, _currentProgress, _curveProgressShift
+                    );
+      }
   /*	break;
         case NSAnimationLinear:
         value = _currentProgress; break;
@@ -1248,6 +1293,7 @@ nsanimation_progressMarkSorter(NSAnimationProgress first, NSAnimationProgress se
 - (id) initWithProperties: (NSDictionary*)properties;
 - (void) setCurrentProgress: (float)progress;
 - (void) setTargetFrame: (NSRect) frame;
+- (NSWindow*) targetWindow;
 
 @end
 
@@ -1355,6 +1401,12 @@ nsanimation_progressMarkSorter(NSAnimationProgress first, NSAnimationProgress se
  [self subclassResponsibility: _cmd];
 }
 
+/* The window drawn into when the target changes. */
+- (NSWindow*) targetWindow
+{
+  return [self subclassResponsibility: _cmd];
+}
+
 @end // implementation _GSViewAnimationDesc
 
 @implementation _GSViewAnimationDesc
@@ -1393,6 +1445,11 @@ nsanimation_progressMarkSorter(NSAnimationProgress first, NSAnimationProgress se
   [_target setFrame: frame];
 }
 
+- (NSWindow*) targetWindow
+{
+  return [_target window];
+}
+
 @end // implementation _GSViewAnimationDesc
 
 @implementation _GSWindowAnimationDesc
@@ -1425,7 +1482,13 @@ nsanimation_progressMarkSorter(NSAnimationProgress first, NSAnimationProgress se
 
 - (void) setTargetFrame: (NSRect) frame
 {
-  [_target setFrame: frame display: YES];
+  /* Displayed by -_gs_updateViewsWithValue: once all targets are set */
+  [_target setFrame: frame display: NO];
+}
+
+- (NSWindow*) targetWindow
+{
+  return _target;
 }
 
 @end // implementation _GSWindowAnimationDesc
@@ -1510,13 +1573,57 @@ nsanimation_progressMarkSorter(NSAnimationProgress first, NSAnimationProgress se
 - (void) _gs_updateViewsWithValue: (NSNumber*) value
 {
   // Runs in main thread : must not call any NSAnimation method to avoid a deadlock
+  NSMutableArray *windows;
+  NSMutableArray *windowTargets;
   NSUInteger i, c;
+  BOOL defers;
   float v;
 
+  if (_viewAnimationDesc == nil)
+    return;
+
+  /* All the frames of one step are set as a batch: autoresizing is
+   * deferred to a single layout pass, the window operations go to the
+   * display server in one window transaction, and each window involved
+   * is displayed and flushed once, after the last target has changed.
+   */
   v = [value floatValue];
-  if (_viewAnimationDesc != nil)
-    for (i = 0, c = [_viewAnimationDesc count]; i < c; i++)
-      [[_viewAnimationDesc objectAtIndex: i] setCurrentProgress: v];
+  c = [_viewAnimationDesc count];
+  windows = [NSMutableArray arrayWithCapacity: c];
+  windowTargets = [NSMutableArray arrayWithCapacity: c];
+  for (i = 0; i < c; i++)
+    {
+      _GSViewAnimationBaseDesc *vabd = [_viewAnimationDesc objectAtIndex: i];
+      NSWindow *w = [vabd targetWindow];
+
+      if (w != nil && [windows indexOfObjectIdenticalTo: w] == NSNotFound)
+        {
+          [windows addObject: w];
+          [w disableFlushWindow];
+        }
+      if ([vabd isKindOfClass: [_GSWindowAnimationDesc class]])
+        [windowTargets addObject: w];
+    }
+
+  defers = [NSView defersAutoresizing];
+  [NSView setDefersAutoresizing: YES];
+  [GSCurrentServer() beginWindowTransaction];
+  for (i = 0; i < c; i++)
+    [[_viewAnimationDesc objectAtIndex: i] setCurrentProgress: v];
+  [GSCurrentServer() commitWindowTransaction];
+  [NSView setDefersAutoresizing: defers];
+
+  for (i = 0, c = [windows count]; i < c; i++)
+    {
+      NSWindow *w = [windows objectAtIndex: i];
+
+      if ([windowTargets indexOfObjectIdenticalTo: w] != NSNotFound)
+        [w display];
+      else
+        [w displayIfNeeded];
+      [w enableFlushWindow];
+      [w flushWindowIfNeeded];
+    }
 }
 
 
@@ -37,6 +37,7 @@
 #import <Foundation/NSArray.h>
 #import <Foundation/NSAutoreleasePool.h>
 #import <Foundation/NSBundle.h>
+#import <Foundation/NSDate.h>
 #import <Foundation/NSDebug.h>
 #import <Foundation/NSDictionary.h>
 #import <Foundation/NSError.h>
@@ -84,6 +85,8 @@
 #import "GNUstepGUI/GSDisplayServer.h"
 #import "GNUstepGUI/GSServicesManager.h"
 #import "GSGuiPrivate.h"
+#import "GSTraceProbes.h"
+#import "GNUstepGUI/GSDisplayTimingsPanel.h"
 #import "GNUstepGUI/GSInfoPanel.h"
 #import "GNUstepGUI/GSVersion.h"
 #import "NSDocumentFrameworkPrivate.h"
@@ -179,6 +182,190 @@ GSGuiBundle(void)
 + (void) initializeBackend;
 @end
 
+/* The launch timeline: a trace event for the start and end of each phase,
+   timed in microseconds from the first one. */
+static enum { TimelineUnknown, TimelineOff, TimelineOn } timelineState;
+static NSMutableString *timelineEvents = nil;
+static NSTimeInterval timelineStart;
+
+static void
+timeline_event(NSString *name, char phase)
+{
+  NSTimeInterval now = [NSDate timeIntervalSinceReferenceDate];
+  NSMutableString *escaped;
+
+  if (timelineState == TimelineUnknown)
+    {
+      timelineState = ([[NSUserDefaults standardUserDefaults]
+                         stringForKey: @"GSLaunchTimeline"] != nil)
+        ? TimelineOn : TimelineOff;
+      if (timelineState == TimelineOn)
+        {
+          timelineEvents = [NSMutableString new];
+          timelineStart = now;
+        }
+    }
+  if (timelineState != TimelineOn)
+    return;
+
+  escaped = [NSMutableString stringWithString: name];
+  [escaped replaceOccurrencesOfString: @"\\" withString: @"\\\\"
+                              options: 0
+                                range: NSMakeRange(0, [escaped length])];
+  [escaped replaceOccurrencesOfString: @"\"" withString: @"\\\""
+                              options: 0
+                                range: NSMakeRange(0, [escaped length])];
+  [timelineEvents appendFormat:
+    @"%@{\"name\": \"%@\", \"cat\": \"launch\", \"ph\": \"%c\", "
+    @"\"ts\": %.0f, \"pid\": %d, \"tid\": 1}",
+    [timelineEvents length] > 0 ? @",\n" : @"", escaped, phase,
+    (now - timelineStart) * 1e6,
+    [[NSProcessInfo processInfo] processIdentifier]];
+}
+
+void
+GSLaunchTimelineBegin(NSString *name)
+{
+  timeline_event(name, 'B');
+}
+
+void
+GSLaunchTimelineEnd(NSString *name)
+{
+  timeline_event(name, 'E');
+}
+
+void
+GSLaunchTimelineWrite(void)
+{
+  NSString *path;
+  NSString *json;
+
+  if (timelineState != TimelineOn)
+    {
+      timelineState = TimelineOff;
+      return;
+    }
+  timelineState = TimelineOff;
+
+  path = [[NSUserDefaults standardUserDefaults]
+           stringForKey: @"GSLaunchTimeline"];
+  json = [NSString stringWithFormat: @"{\"traceEvents\": [\n%@\n]}\n",
+                   timelineEvents];
+  if ([json writeToFile: path atomically: YES] == NO)
+    {
+      NSLog(@"Could not write the launch timeline to %@", path);
+    }
+  DESTROY(timelineEvents);
+}
+
+/* Input latency histograms, one for each event type tagged by -sendEvent:,
+   allocated once an event of the type has been measured.  The buckets
+   are spaced logarithmically, eight to an octave from a microsecond, so
+   a percentile read from them is within 10% of the recorded value.  */
+#define GS_LATENCY_TYPES (NSOtherMouseDragged + 1)
+#define GS_LATENCY_BUCKETS 192
+
+typedef struct {
+  NSUInteger count;
+  NSTimeInterval total;
+  NSTimeInterval max;
+  NSUInteger buckets[GS_LATENCY_BUCKETS];
+} GSLatencyHistogram;
+
+static int recordsInputLatency = -1;
+static GSLatencyHistogram *latencyHistograms[GS_LATENCY_TYPES];
+
+static NSString *latencyTypeNames[GS_LATENCY_TYPES] = {
+  [NSLeftMouseDown] = @"LeftMouseDown",
+  [NSLeftMouseUp] = @"LeftMouseUp",
+  [NSRightMouseDown] = @"RightMouseDown",
+  [NSRightMouseUp] = @"RightMouseUp",
+  [NSLeftMouseDragged] = @"LeftMouseDragged",
+  [NSRightMouseDragged] = @"RightMouseDragged",
+  [NSKeyDown] = @"KeyDown",
+  [NSKeyUp] = @"KeyUp",
+  [NSFlagsChanged] = @"FlagsChanged",
+  [NSScrollWheel] = @"ScrollWheel",
+  [NSOtherMouseDown] = @"OtherMouseDown",
+  [NSOtherMouseUp] = @"OtherMouseUp",
+  [NSOtherMouseDragged] = @"OtherMouseDragged"
+};
+
+BOOL
+GSRecordsInputLatency(void)
+{
+  if (recordsInputLatency < 0)
+    {
+      recordsInputLatency = [[NSUserDefaults standardUserDefaults]
+                              boolForKey: @"GSRecordInputLatency"];
+    }
+  return recordsInputLatency;
+}
+
+void
+GSRecordInputLatency(NSEventType type, NSTimeInterval seconds)
+{
+  GSLatencyHistogram *h;
+  double us = seconds * 1e6;
+  NSInteger bucket;
+
+  if (recordsInputLatency != 1 || type >= GS_LATENCY_TYPES)
+    return;
+  h = latencyHistograms[type];
+  if (h == NULL)
+    {
+      h = NSZoneCalloc(NSDefaultMallocZone(), 1, sizeof(GSLatencyHistogram));
+      latencyHistograms[type] = h;
+    }
+  bucket = (us < 1.0) ? 0 : (NSInteger)(log2(us) * 8);
+  h->buckets[MIN(bucket, GS_LATENCY_BUCKETS - 1)]++;
+  h->count++;
+  h->total += seconds;
+  if (seconds > h->max)
+    h->max = seconds;
+}
+
+/* Returns the latency below which the fraction p of the events fell, as
+   the upper end of its bucket, but no more than the slowest event.  */
+static NSTimeInterval
+latency_percentile(GSLatencyHistogram *h, double p)
+{
+  NSUInteger rank = (NSUInteger)ceil(p * h->count);
+  NSUInteger seen = 0;
+  NSUInteger i;
+
+  for (i = 0; i < GS_LATENCY_BUCKETS; i++)
+    {
+      seen += h->buckets[i];
+      if (seen >= rank && seen > 0)
+        {
+          return MIN(pow(2.0, (i + 1) / 8.0) / 1e6, h->max);
+        }
+    }
+  return h->max;
+}
+
+static void
+reset_input_latency(void)
+{
+  NSUInteger type;
+
+  for (type = 0; type < GS_LATENCY_TYPES; type++)
+    {
+      if (latencyHistograms[type] != NULL)
+        {
+          memset(latencyHistograms[type], 0, sizeof(GSLatencyHistogram));
+        }
+    }
+}
+
+static BOOL
+is_latency_event(NSEventType type)
+{
+  return type < GS_LATENCY_TYPES && latencyTypeNames[type] != nil;
+}
+
 static NSString *
 gnustep_backend_path(NSString *dir, NSString *name)
 {
@@ -381,6 +568,7 @@ struct _NSModalSession {
 - (void) _workspaceNotification: (NSNotification*) notification;
 - (NSArray *) _openFiles;
 - (NSMenu *) _dockMenu;
+- (void) _fillWindowPool;
 @end
 
 @interface NSWindow (TitleWithRepresentedFilename)
@@ -563,10 +751,8 @@ static NSSize scaledIconSizeForSize(NSSize imageSize)
 {
   NSSize iconSize = GSGetIconSize();
   
-  [tileCell drawWithFrame: NSMakeRect(0, 0, iconSize.width, iconSize.height)
-  		   inView: self];
-  [dragCell drawWithFrame: NSMakeRect(0, 0, iconSize.width, iconSize.height)
-		   inView: self];
+  GSDrawIconBase(tileCell, dragCell,
+    NSMakeRect(0, 0, iconSize.width, iconSize.height), iconSize);
   
   if ([NSApp isHidden])
     {
@@ -874,13 +1060,20 @@ static NSSize scaledIconSizeForSize(NSSize imageSize)
    */
   NSApp = self;
 
+  GSLaunchTimelineBegin(@"launch");
+
   /* Initialize the backend here.  */
+  GSLaunchTimelineBegin(@"backend");
   initialize_gnustep_backend();
+  GSLaunchTimelineEnd(@"backend");
 
   /* Load user-defined bundles */
+  GSLaunchTimelineBegin(@"user bundles");
   gsapp_user_bundles();
+  GSLaunchTimelineEnd(@"user bundles");
 
   /* Connect to our window server.  */
+  GSLaunchTimelineBegin(@"display server");
   srv = [GSDisplayServer serverWithAttributes: nil];
   RETAIN(srv);
   [GSDisplayServer setCurrentServer: srv];
@@ -890,9 +1083,12 @@ static NSSize scaledIconSizeForSize(NSSize imageSize)
   _default_context = [NSGraphicsContext graphicsContextWithAttributes: attributes];
   RETAIN(_default_context);
   [NSGraphicsContext setCurrentContext: _default_context];
+  GSLaunchTimelineEnd(@"display server");
 
   /* Initialize font manager.  */
+  GSLaunchTimelineBegin(@"font manager");
   [NSFontManager sharedFontManager];
+  GSLaunchTimelineEnd(@"font manager");
 
   _hidden = [[NSMutableArray alloc] init];
   _inactive = [[NSMutableArray alloc] init];
@@ -909,7 +1105,9 @@ static NSSize scaledIconSizeForSize(NSSize imageSize)
   /* Set a new exception handler for the gui library.  */
   NSSetUncaughtExceptionHandler(_NSAppKitUncaughtExceptionHandler);
 
+  GSLaunchTimelineBegin(@"services manager");
   _listener = [GSServicesManager newWithApplication: self];
+  GSLaunchTimelineEnd(@"services manager");
 
   /* NSEvent doesn't use -init so we use +alloc instead of +new.  */
   _current_event = [NSEvent alloc]; // no current event
@@ -921,7 +1119,9 @@ static NSSize scaledIconSizeForSize(NSSize imageSize)
   /* Create our app icon.
      NB We are doing this here because WindowMaker will not map the app icon
      window unless it is the very first window being mapped. */
+  GSLaunchTimelineBegin(@"app icon");
   [self _appIconInit];
+  GSLaunchTimelineEnd(@"app icon");
 
   [_app_init_pool drain];
 }
@@ -1005,11 +1205,15 @@ static NSSize scaledIconSizeForSize(NSSize imageSize)
   NSArray               *files = nil;
 
   /* post notification that launch will finish */
+  GSLaunchTimelineBegin(@"applicationWillFinishLaunching");
   [nc postNotificationName: NSApplicationWillFinishLaunchingNotification
       object: self];
+  GSLaunchTimelineEnd(@"applicationWillFinishLaunching");
 
   /* Register our listener to incoming services requests etc. */
+  GSLaunchTimelineBegin(@"register services");
   [_listener registerAsServiceProvider];
+  GSLaunchTimelineEnd(@"register services");
 
   /*
    * Establish the current key and main windows.  We need to do this in case
@@ -1100,10 +1304,17 @@ static NSSize scaledIconSizeForSize(NSSize imageSize)
     addObserver: self selector: @selector(_workspaceNotification:)
       name: GSUnhideAllApplicationsNotification object: nil];
 
+  if ([defs boolForKey: @"GSInputLatencyOverlay"])
+    {
+      [self orderFrontInputLatencyOverlay: self];
+    }
+
   // Don't activate the application, when the delegate hid it
   if (![self isHidden])
     {
+      GSLaunchTimelineBegin(@"activate");
       [self activateIgnoringOtherApps: YES];
+      GSLaunchTimelineEnd(@"activate");
     }
 
   /*
@@ -1172,6 +1383,12 @@ static NSSize scaledIconSizeForSize(NSSize imageSize)
 	    }
         }
     }
+
+  /* Create the backend windows for the first menus and tool tips once
+     the launch is over, rather than while the user waits for them.  */
+  [self performSelector: @selector(_fillWindowPool)
+	     withObject: nil
+	     afterDelay: 0.0];
 }
 
 /*
@@ -1183,8 +1400,10 @@ static NSSize scaledIconSizeForSize(NSSize imageSize)
 - (void) _didFinishLaunching
 {
   /* finish the launching post notification that launching has finished */
+  GSLaunchTimelineBegin(@"applicationDidFinishLaunching");
   [nc postNotificationName: NSApplicationDidFinishLaunchingNotification
 		    object: self];
+  GSLaunchTimelineEnd(@"applicationDidFinishLaunching");
 
   NS_DURING
     {
@@ -1535,11 +1754,17 @@ static NSSize scaledIconSizeForSize(NSSize imageSize)
       _app_is_launched = YES;
       IF_NO_GC(_runLoopPool = [arpClass new]);
 
+      GSLaunchTimelineBegin(@"finishLaunching");
       [self finishLaunching];
+      GSLaunchTimelineEnd(@"finishLaunching");
       [self _didFinishLaunching];
 
+      GSLaunchTimelineBegin(@"menus");
       [_listener updateServicesMenu];
       [_main_menu update];
+      GSLaunchTimelineEnd(@"menus");
+      GSLaunchTimelineEnd(@"launch");
+      GSLaunchTimelineWrite();
       DESTROY(_runLoopPool);
     }
  
@@ -2061,6 +2286,13 @@ See -runModalForWindow:
   NSEventType type;
 
   type = [theEvent type];
+  GS_PROBE2(app_send_event_entry, theEvent, type);
+  if (GSRecordsInputLatency() && is_latency_event(type)
+    && [theEvent window] != nil)
+    {
+      GSWindowTagInputEvent([theEvent window], type,
+                            [NSDate timeIntervalSinceReferenceDate]);
+    }
   switch (type)
     {
       case NSPeriodic:	/* NSApplication traps the periodic events	*/
@@ -2107,6 +2339,81 @@ See -runModalForWindow:
 	    [self rightMouseDown: theEvent];
 	}
     }
+  GS_PROBE2(app_send_event_return, theEvent, type);
+}
+
+/**
+ * Returns whether the time from each key, mouse button, drag and scroll
+ * event reaching -sendEvent: to the next flush of its window is recorded,
+ * for -inputLatencyStatistics.  The default comes from the
+ * GSRecordInputLatency user default.
+ */
++ (BOOL) recordsInputLatency
+{
+  return GSRecordsInputLatency();
+}
+
+/**
+ * Sets whether input latency is recorded.  Turning recording off discards
+ * the latencies recorded so far.
+ */
++ (void) setRecordsInputLatency: (BOOL)flag
+{
+  recordsInputLatency = flag;
+  if (flag == NO)
+    {
+      reset_input_latency();
+    }
+}
+
+/**
+ * Returns the input latencies recorded so far, in seconds, as a
+ * dictionary with an entry for each type of event measured, such as
+ * KeyDown or LeftMouseDown.  Each entry is a dictionary with the keys:
+ * <deflist>
+ *   <term>Count</term>
+ *   <desc>The number of events measured.</desc>
+ *   <term>AverageTime</term>
+ *   <desc>The mean latency.</desc>
+ *   <term>MedianTime, P99Time</term>
+ *   <desc>The latencies which half and 99% of the events stayed under.
+ *   These are read from a histogram, so they are within 10% of the
+ *   latency of some event.</desc>
+ *   <term>MaxTime</term>
+ *   <desc>The slowest latency.</desc>
+ * </deflist>
+ */
+- (NSDictionary *) inputLatencyStatistics
+{
+  NSMutableDictionary *stats = [NSMutableDictionary dictionary];
+  NSUInteger type;
+
+  for (type = 0; type < GS_LATENCY_TYPES; type++)
+    {
+      GSLatencyHistogram *h = latencyHistograms[type];
+
+      if (h == NULL || h->count == 0)
+        continue;
+      [stats setObject: [NSDictionary dictionaryWithObjectsAndKeys:
+        [NSNumber numberWithUnsignedInteger: h->count], @"Count",
+        [NSNumber numberWithDouble: h->total / h->count], @"AverageTime",
+        [NSNumber numberWithDouble: latency_percentile(h, 0.5)],
+        @"MedianTime",
+        [NSNumber numberWithDouble: latency_percentile(h, 0.99)],
+        @"P99Time",
+        [NSNumber numberWithDouble: h->max], @"MaxTime",
+        nil]
+                forKey: latencyTypeNames[type]];
+    }
+  return stats;
+}
+
+/**
+ * Discards the input latencies recorded so far.
+ */
+- (void) resetInputLatencyStatistics
+{
+  reset_input_latency();
 }
 
 /**
@@ -4212,6 +4519,11 @@ struct _DelegateWrapper
   return dockMenu;
 }
 
+- (void) _fillWindowPool
+{
+  [GSCurrentServer() fillWindowPool: [[NSScreen mainScreen] screenNumber]];
+}
+
 @end // NSApplication (Private)
 
 
@@ -32,15 +32,300 @@
 #import <Foundation/NSDictionary.h>
 #import <Foundation/NSIndexSet.h>
 #import <Foundation/NSKeyValueObserving.h>
+#import <Foundation/NSLock.h>
 #import <Foundation/NSPredicate.h>
+#import <Foundation/NSProcessInfo.h>
 #import <Foundation/NSSortDescriptor.h>
 #import <Foundation/NSString.h>
+#import <Foundation/NSThread.h>
 
 #import "AppKit/NSArrayController.h"
 #import "AppKit/NSKeyValueBinding.h"
 #import "GSBindingHelpers.h"
 #import "GSFastEnumeration.h"
 
+#include <string.h>
+
+/* Arrays with at least this many objects are sorted on several
+   threads. */
+#define PARALLEL_SORT_MIN 16384
+/* Runs this short are sorted by insertion. */
+#define INSERTION_SORT_MAX 16
+/* Inserting more objects than this arranges all objects again. */
+#define INCREMENTAL_INSERT_MAX 64
+
+/*
+ * Sorting arranged objects.  The key values of every sort descriptor are
+ * got once for each object, then an array of object indexes is merge
+ * sorted comparing the key values.  The values are compared as
+ * NSSortDescriptor compares them.
+ */
+typedef struct {
+  id		*values;	/* count * numKeys key values */
+  SEL		*selectors;
+  BOOL		*ascending;
+  NSUInteger	numKeys;
+} GSSortKeys;
+
+static inline NSComparisonResult
+compare_keys(GSSortKeys *k, NSUInteger a, NSUInteger b)
+{
+  id *va = k->values + a * k->numKeys;
+  id *vb = k->values + b * k->numKeys;
+  NSUInteger i;
+
+  for (i = 0; i < k->numKeys; i++)
+    {
+      NSComparisonResult result;
+
+      result = (NSComparisonResult)(intptr_t)[va[i] performSelector:
+        k->selectors[i] withObject: vb[i]];
+      if (result != NSOrderedSame)
+        {
+          return k->ascending[i] ? result : -result;
+        }
+    }
+  return NSOrderedSame;
+}
+
+/* Merges the sorted runs src[lo..mid) and src[mid..hi) into dst. */
+static void
+merge_runs(GSSortKeys *k, NSUInteger *src, NSUInteger *dst,
+           NSUInteger lo, NSUInteger mid, NSUInteger hi)
+{
+  NSUInteger i = lo, j = mid, o = lo;
+
+  while (i < mid && j < hi)
+    {
+      // Take from the right run only if smaller, to keep the sort stable
+      if (compare_keys(k, src[j], src[i]) == NSOrderedAscending)
+        dst[o++] = src[j++];
+      else
+        dst[o++] = src[i++];
+    }
+  memcpy(dst + o, src + i, (mid - i) * sizeof(NSUInteger));
+  o += mid - i;
+  memcpy(dst + o, src + j, (hi - j) * sizeof(NSUInteger));
+}
+
+/* Sorts idx[lo..hi), using tmp[lo..hi) as scratch space. */
+static void
+merge_sort(GSSortKeys *k, NSUInteger *idx, NSUInteger *tmp,
+           NSUInteger lo, NSUInteger hi)
+{
+  NSUInteger mid;
+
+  if (hi - lo <= INSERTION_SORT_MAX)
+    {
+      NSUInteger i;
+
+      for (i = lo + 1; i < hi; i++)
+        {
+          NSUInteger value = idx[i];
+          NSUInteger j = i;
+
+          while (j > lo
+                 && compare_keys(k, idx[j - 1], value) == NSOrderedDescending)
+            {
+              idx[j] = idx[j - 1];
+              j--;
+            }
+          idx[j] = value;
+        }
+      return;
+    }
+
+  mid = lo + (hi - lo) / 2;
+  merge_sort(k, idx, tmp, lo, mid);
+  merge_sort(k, idx, tmp, mid, hi);
+  if (compare_keys(k, idx[mid - 1], idx[mid]) != NSOrderedDescending)
+    return;
+  memcpy(tmp + lo, idx + lo, (hi - lo) * sizeof(NSUInteger));
+  merge_runs(k, tmp, idx, lo, mid, hi);
+}
+
+/* A run of the indexes sorted on a thread of its own. */
+@interface GSArraySortRun : NSObject
+{
+@public
+  GSSortKeys *keys;
+  NSUInteger *idx;
+  NSUInteger *tmp;
+  NSUInteger lo;
+  NSUInteger hi;
+  NSCondition *done;
+  NSUInteger *pending;
+}
+@end
+
+@implementation GSArraySortRun
+
+- (void) run: (id)unused
+{
+  CREATE_AUTORELEASE_POOL(pool);
+
+  merge_sort(keys, idx, tmp, lo, hi);
+  [done lock];
+  (*pending)--;
+  [done signal];
+  [done unlock];
+  DESTROY(pool);
+}
+
+@end
+
+/* Sorts idx[0..count) in runs on up to threads threads, then merges
+   the runs. */
+static void
+parallel_merge_sort(GSSortKeys *k, NSUInteger *idx, NSUInteger *tmp,
+                    NSUInteger count, NSUInteger threads)
+{
+  NSCondition *done = AUTORELEASE([NSCondition new]);
+  NSUInteger bounds[threads + 1];
+  NSUInteger pending = threads - 1;
+  NSUInteger i, width;
+
+  for (i = 0; i <= threads; i++)
+    {
+      bounds[i] = count * i / threads;
+    }
+  for (i = 1; i < threads; i++)
+    {
+      GSArraySortRun *run = AUTORELEASE([GSArraySortRun new]);
+
+      run->keys = k;
+      run->idx = idx;
+      run->tmp = tmp;
+      run->lo = bounds[i];
+      run->hi = bounds[i + 1];
+      run->done = done;
+      run->pending = &pending;
+      [NSThread detachNewThreadSelector: @selector(run:)
+                               toTarget: run
+                             withObject: nil];
+    }
+  merge_sort(k, idx, tmp, bounds[0], bounds[1]);
+  [done lock];
+  while (pending > 0)
+    [done wait];
+  [done unlock];
+
+  for (width = 1; width < threads; width *= 2)
+    {
+      for (i = 0; i + width < threads; i += 2 * width)
+        {
+          NSUInteger lo = bounds[i];
+          NSUInteger mid = bounds[i + width];
+          NSUInteger hi = bounds[MIN(i + 2 * width, threads)];
+
+          memcpy(tmp + lo, idx + lo, (hi - lo) * sizeof(NSUInteger));
+          merge_runs(k, tmp, idx, lo, mid, hi);
+        }
+    }
+}
+
+/* Returns YES if the descriptors compare objects by key and selector
+   only, so their key values can be got before sorting. */
+static BOOL
+sorts_by_key_values(NSArray *descriptors)
+{
+  IMP plain = [NSSortDescriptor instanceMethodForSelector:
+    @selector(compareObject:toObject:)];
+  NSUInteger i, count = [descriptors count];
+
+  for (i = 0; i < count; i++)
+    {
+      NSSortDescriptor *d = [descriptors objectAtIndex: i];
+
+      if ([d methodForSelector: @selector(compareObject:toObject:)] != plain
+          || [d key] == nil)
+        {
+          return NO;
+        }
+      if ([d respondsToSelector: @selector(comparator)]
+          && [(id)d comparator] != NULL)
+        {
+          return NO;
+        }
+    }
+  return YES;
+}
+
+static NSArray *
+sorted_objects(NSArray *objects, NSArray *descriptors)
+{
+  NSUInteger count = [objects count];
+  NSUInteger numKeys = [descriptors count];
+  NSUInteger threads, i, j;
+  GSSortKeys k;
+  NSUInteger *idx, *tmp;
+  id *objs, *sorted;
+  NSArray *result;
+
+  if (count < 2 || numKeys == 0 || !sorts_by_key_values(descriptors))
+    {
+      return [objects sortedArrayUsingDescriptors: descriptors];
+    }
+
+  objs = NSZoneMalloc(NSDefaultMallocZone(), count * sizeof(id));
+  [objects getObjects: objs];
+  k.numKeys = numKeys;
+  k.values = NSZoneMalloc(NSDefaultMallocZone(), count * numKeys * sizeof(id));
+  k.selectors = NSZoneMalloc(NSDefaultMallocZone(), numKeys * sizeof(SEL));
+  k.ascending = NSZoneMalloc(NSDefaultMallocZone(), numKeys * sizeof(BOOL));
+  for (j = 0; j < numKeys; j++)
+    {
+      NSSortDescriptor *d = [descriptors objectAtIndex: j];
+      NSString *key = [d key];
+
+      k.selectors[j] = [d selector];
+      k.ascending[j] = [d ascending];
+      for (i = 0; i < count; i++)
+        {
+          k.values[i * numKeys + j] = [objs[i] valueForKeyPath: key];
+        }
+    }
+
+  idx = NSZoneMalloc(NSDefaultMallocZone(), count * sizeof(NSUInteger));
+  tmp = NSZoneMalloc(NSDefaultMallocZone(), count * sizeof(NSUInteger));
+  for (i = 0; i < count; i++)
+    {
+      idx[i] = i;
+    }
+  threads = [[NSProcessInfo processInfo] activeProcessorCount];
+  threads = MIN(threads, count / (PARALLEL_SORT_MIN / 2));
+  if (threads > 1)
+    {
+      parallel_merge_sort(&k, idx, tmp, count, MIN(threads, 16));
+    }
+  else
+    {
+      merge_sort(&k, idx, tmp, 0, count);
+    }
+
+  sorted = NSZoneMalloc(NSDefaultMallocZone(), count * sizeof(id));
+  for (i = 0; i < count; i++)
+    {
+      sorted[i] = objs[idx[i]];
+    }
+  result = [NSArray arrayWithObjects: sorted count: count];
+
+  NSZoneFree(NSDefaultMallocZone(), sorted);
+  NSZoneFree(NSDefaultMallocZone(), tmp);
+  NSZoneFree(NSDefaultMallocZone(), idx);
+  NSZoneFree(NSDefaultMallocZone(), k.ascending);
+  NSZoneFree(NSDefaultMallocZone(), k.selectors);
+  NSZoneFree(NSDefaultMallocZone(), k.values);
+  NSZoneFree(NSDefaultMallocZone(), objs);
+  return result;
+}
+
+@interface NSArrayController (Private)
+- (BOOL) _arrangesIncrementally;
+- (void) _arrangeInsertedObjects: (NSArray*)objects;
+- (void) _arrangeRemovedObjects: (NSArray*)objects;
+@end
+
 @implementation NSArrayController
 
 + (void) initialize
@@ -85,7 +370,14 @@
   [_content addObject: obj];
   if ([self automaticallyRearrangesObjects])
     {
-      [self rearrangeObjects];
+      if ([self _arrangesIncrementally])
+        {
+          [self _arrangeInsertedObjects: [NSArray arrayWithObject: obj]];
+        }
+      else
+        {
+          [self rearrangeObjects];
+        }
     }
 }
 
@@ -94,7 +386,15 @@
   [_content addObjectsFromArray: obj];
   if ([self automaticallyRearrangesObjects])
     {
-      [self rearrangeObjects];
+      if ([obj count] <= INCREMENTAL_INSERT_MAX
+          && [self _arrangesIncrementally])
+        {
+          [self _arrangeInsertedObjects: obj];
+        }
+      else
+        {
+          [self rearrangeObjects];
+        }
     }
   if ([self selectsInsertedObjects])
     {
@@ -107,7 +407,14 @@
   [_content removeObject: obj];
   if ([self automaticallyRearrangesObjects])
     {
-      [self rearrangeObjects];
+      if ([self _arrangesIncrementally])
+        {
+          [self _arrangeRemovedObjects: [NSArray arrayWithObject: obj]];
+        }
+      else
+        {
+          [self rearrangeObjects];
+        }
     }
 }
 
@@ -116,7 +423,14 @@
   [_content removeObjectsInArray: obj];
   if ([self automaticallyRearrangesObjects])
     {
-      [self rearrangeObjects];
+      if ([self _arrangesIncrementally])
+        {
+          [self _arrangeRemovedObjects: obj];
+        }
+      else
+        {
+          [self rearrangeObjects];
+        }
     }
 }
 
@@ -331,7 +645,7 @@
 {
   NSArray *temp = [obj filteredArrayUsingPredicate: _filter_predicate];
   
-  return [temp sortedArrayUsingDescriptors: _sort_descriptors];
+  return sorted_objects(temp, _sort_descriptors);
 }
 
 - (id) arrangedObjects
@@ -484,3 +798,70 @@ atArrangedObjectIndexes: (NSIndexSet*)idx
 }
 
 @end
+
+@implementation NSArrayController (Private)
+
+/* Objects added or removed can be placed into the arranged objects
+   directly, unless a subclass arranges them in its own way. */
+- (BOOL) _arrangesIncrementally
+{
+  SEL sel = @selector(arrangeObjects:);
+
+  return _arranged_objects != nil
+    && [self methodForSelector: sel]
+       == [NSArrayController instanceMethodForSelector: sel];
+}
+
+- (void) _arrangeInsertedObjects: (NSArray*)objects
+{
+  NSMutableArray *arranged = AUTORELEASE([_arranged_objects mutableCopy]);
+  NSUInteger numKeys = [_sort_descriptors count];
+  NSUInteger i, count = [objects count];
+
+  for (i = 0; i < count; i++)
+    {
+      id obj = [objects objectAtIndex: i];
+      NSUInteger lo = 0, hi = [arranged count];
+
+      if (_filter_predicate != nil
+          && ![_filter_predicate evaluateWithObject: obj])
+        {
+          continue;
+        }
+      // Find the first arranged object that sorts after obj
+      while (numKeys > 0 && lo < hi)
+        {
+          NSUInteger mid = lo + (hi - lo) / 2;
+          id other = [arranged objectAtIndex: mid];
+          NSComparisonResult result = NSOrderedSame;
+          NSUInteger j;
+
+          for (j = 0; j < numKeys && result == NSOrderedSame; j++)
+            {
+              result = [[_sort_descriptors objectAtIndex: j]
+                compareObject: other toObject: obj];
+            }
+          if (result == NSOrderedDescending)
+            hi = mid;
+          else
+            lo = mid + 1;
+        }
+      [arranged insertObject: obj atIndex: lo];
+    }
+
+  [self willChangeValueForKey: @"arrangedObjects"];
+  ASSIGN(_arranged_objects, arranged);
+  [self didChangeValueForKey: @"arrangedObjects"];
+}
+
+- (void) _arrangeRemovedObjects: (NSArray*)objects
+{
+  NSMutableArray *arranged = AUTORELEASE([_arranged_objects mutableCopy]);
+
+  [arranged removeObjectsInArray: objects];
+  [self willChangeValueForKey: @"arrangedObjects"];
+  ASSIGN(_arranged_objects, arranged);
+  [self didChangeValueForKey: @"arrangedObjects"];
+}
+
+@end
@@ -653,6 +653,25 @@ create_error(int code, NSString* desc)
 - (id) initWithRTFDFileWrapper: (NSFileWrapper *)wrapper
             documentAttributes: (NSDictionary **)dict
 {
+  Class converter = converter_class(NSRTFDTextDocumentType, NO);
+
+  /* Reading the wrapper itself keeps the files of a package on disk
+     from being read before they are used.  */
+  if ([converter respondsToSelector:
+    @selector(parseFile:options:documentAttributes:error:class:)])
+    {
+      NSAttributedString *new;
+
+      new = [converter
+              parseFile: wrapper
+              options: nil
+              documentAttributes: dict
+              error: NULL
+              class: [self class]];
+      // We do not return self but the newly created object
+      RELEASE(self);
+      return RETAIN(new);
+    }
   return [self initWithRTFD: [wrapper serializedRepresentation]
                  documentAttributes: dict];
 }
@@ -918,7 +937,15 @@ documentAttributes: (NSDictionary **)dict
              error: (NSError **)error
 {
   NSURL *baseURL;
-  NSData *data = [url resourceDataUsingCache: YES];
+  NSData *data;
+
+  /* Map local files instead of reading them, so that a large document
+   * is not held in memory twice while it is parsed.
+   */
+  if ([url isFileURL])
+    data = [NSData dataWithContentsOfMappedFile: [url path]];
+  else
+    data = [url resourceDataUsingCache: YES];
 
   if (data == nil)
     {
@@ -1459,6 +1486,15 @@ static NSString *lastFont = nil;
 static NSCharacterSet *lastSet = nil;
 static NSMutableDictionary *cachedCSets = nil;
 
+/*
+ * The substitutes found for a font, by blocks of 128 characters.  A
+ * substitute found for one character of a block is tried first for the
+ * other characters of that block, which usually come from the same
+ * script, before searching the lists of fonts again.
+ */
+static NSMutableDictionary *cachedSubstitutes = nil;
+#define	SUBSTITUTE_BLOCK(C)	((C) >> 7)
+
 - (NSFont*)_substituteFontWithName: (NSString*)fontName 
                               font: (NSFont*)baseFont
 {
@@ -1519,6 +1555,42 @@ static NSMutableDictionary *cachedCSets = nil;
   return nil;
 }
 
+- (NSFont*)_cachedSubstituteFontFor: (unichar)uchar font: (NSFont*)baseFont
+{
+  NSMutableDictionary *blocks;
+  NSNumber *block;
+  NSFont *subFont;
+
+  if (cachedSubstitutes == nil)
+    {
+      cachedSubstitutes = [NSMutableDictionary new];
+    }
+  blocks = [cachedSubstitutes objectForKey: baseFont];
+  block = [NSNumber numberWithUnsignedInt: SUBSTITUTE_BLOCK(uchar)];
+  subFont = [blocks objectForKey: block];
+  if (subFont != nil && [[subFont coveredCharacterSet] characterIsMember: uchar])
+    {
+      return subFont;
+    }
+
+  subFont = [self _substituteFontFor: uchar font: baseFont];
+  if (subFont != nil)
+    {
+      if (blocks == nil)
+        {
+          if ([cachedSubstitutes count] >= 64)
+            {
+              [cachedSubstitutes removeAllObjects];
+            }
+          blocks = [NSMutableDictionary new];
+          [cachedSubstitutes setObject: blocks forKey: baseFont];
+          RELEASE(blocks);
+        }
+      [blocks setObject: subFont forKey: block];
+    }
+  return subFont;
+}
+
 - (NSFont*)_substituteFontFor: (unichar)uchar font: (NSFont*)baseFont
 {
   NSFont *subFont;
@@ -1558,6 +1630,8 @@ static NSMutableDictionary *cachedCSets = nil;
   NSUInteger lastMax;
   NSUInteger start;
   unichar chars[64];
+  NSFont *runFont = nil;
+  NSUInteger runStart = 0;
   CREATE_AUTORELEASE_POOL(pool);
   
   if (NSMaxRange (range) > [self length])
@@ -1605,15 +1679,34 @@ static NSMutableDictionary *cachedCSets = nil;
           // Find a replacement font
           NSFont *subFont;
           
-          subFont = [self _substituteFontFor: uchar font: font];
-          if (subFont != nil)
+          subFont = [self _cachedSubstituteFontFor: uchar font: font];
+          if (subFont != runFont)
             {
-              // Set substitution font permanently
-              [self addAttribute: NSFontAttributeName
-                    value: subFont
-                    range: NSMakeRange(i, 1)];
+              /* Set substitution font permanently, once for each run of
+                 characters needing the same one.  */
+              if (runFont != nil)
+                {
+                  [self addAttribute: NSFontAttributeName
+                        value: runFont
+                        range: NSMakeRange(runStart, i - runStart)];
+                }
+              runFont = subFont;
+              runStart = i;
             }
         }
+      else if (runFont != nil)
+        {
+          [self addAttribute: NSFontAttributeName
+                value: runFont
+                range: NSMakeRange(runStart, i - runStart)];
+          runFont = nil;
+        }
+    }
+  if (runFont != nil)
+    {
+      [self addAttribute: NSFontAttributeName
+            value: runFont
+            range: NSMakeRange(runStart, NSMaxRange(range) - runStart)];
     }
   
   [pool drain];
@@ -1641,6 +1734,24 @@ static NSMutableDictionary *cachedCSets = nil;
       r = [str lineRangeForRange: NSMakeRange (loc, 1)];
       end = NSMaxRange (r);
 
+      /* Most paragraphs already have a single style, often one shared
+         with the following paragraphs.  Skip every paragraph which ends
+         inside the run of the style at this one without searching for
+         the longest effective range.  */
+      style = [self attribute: NSParagraphStyleAttributeName
+		    atIndex: r.location
+		    effectiveRange: &found];
+      if (style != nil && NSMaxRange (found) >= end)
+	{
+	  NSRange	last;
+
+	  last = [str lineRangeForRange:
+	    NSMakeRange (MIN (NSMaxRange (found), NSMaxRange (range)) - 1, 1)];
+	  loc = (NSMaxRange (last) <= NSMaxRange (found))
+	    ? NSMaxRange (last) : last.location;
+	  continue;
+	}
+
       /* Get the style in effect at the paragraph start.  */
       style = [self attribute: NSParagraphStyleAttributeName
 		    atIndex: r.location
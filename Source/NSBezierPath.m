@@ -30,6 +30,8 @@
 
 #import <Foundation/NSData.h>
 #import <Foundation/NSDebug.h>
+#import <Foundation/NSLock.h>
+#import <Foundation/NSUserDefaults.h>
 #import "AppKit/NSAffineTransform.h"
 #import "AppKit/NSFont.h"
 #import "AppKit/NSImage.h"
@@ -43,34 +45,58 @@
 #define M_PI 3.1415926535897932384626434
 #endif
 
-typedef struct _PathElement
-{
-  /*NSBezierPathElement*/int type;
-  NSPoint points[3];
-} PathElement;
-
-//#define GSUNION_TYPES GSUNION_OBJ
-#define GSI_ARRAY_TYPES       0
-#define GSI_ARRAY_TYPE	PathElement
-
-#define GSI_ARRAY_NO_RETAIN
-#define GSI_ARRAY_NO_RELEASE
+#import "AppKit/NSBezierPath.h"
 
-#ifdef GSIArray
-#undef GSIArray
-#endif
-#include <GNUstepBase/GSIArray.h>
+/* The elements of a path: a byte for the type of each element, and the
+   points of all elements one after another.  Closepath elements keep the
+   start of the subpath they close, so every element has its points in
+   the array, found through the offset of its first point.  */
+typedef struct
+{
+  NSUInteger count;
+  NSUInteger capacity;
+  unsigned char *types;
+  NSUInteger *offsets;
+  NSUInteger pointCount;
+  NSUInteger pointCapacity;
+  NSPoint *points;
+  /* The offset of the point of the last moveto, or NSNotFound.  */
+  NSUInteger subpathStart;
+} GSPathElements;
 
-#define	_IN_NSBEZIERPATH_M	1
-#import "AppKit/NSBezierPath.h"
-#undef	_IN_NSBEZIERPATH_M
+#define PATH_ELEMENTS(p) ((GSPathElements *)((p)->_pathElements))
 
 
 // This magic number is 4 *(sqrt(2) -1)/3
 #define KAPPA 0.5522847498
 #define INVALIDATE_CACHE()   [self _invalidateCache]
 
-static void flatten(NSPoint coeff[], CGFloat flatness, NSBezierPath *path);
+/* The flattened form of a path, kept until the path changes: the end
+   points of its moves, lines, the lines approximating its curves and the
+   points closed subpaths go back to, with a type for each. */
+typedef struct
+{
+  NSUInteger count;
+  NSUInteger capacity;
+  NSPoint *points;
+  unsigned char *types;
+  CGFloat flatness;
+  /* NO when a curve needed more than MAX_FLATTEN_DEPTH subdivisions,
+     so its lines may not be within the flatness of the curve. */
+  BOOL withinFlatness;
+} GSFlattenedPath;
+
+enum {
+  FlatMove,
+  FlatLine,
+  FlatCurve,
+  FlatClose
+};
+
+#define MAX_FLATTEN_DEPTH 16
+
+static GSFlattenedPath *flattened_path(NSBezierPath *path, NSZone *zone);
+static void free_flattened_path(GSFlattenedPath *f, NSZone *zone);
 
 static NSWindingRule default_winding_rule = NSNonZeroWindingRule;
 static CGFloat default_line_width = 1.0;
@@ -79,20 +105,316 @@ static NSLineJoinStyle default_line_join_style = NSMiterLineJoinStyle;
 static NSLineCapStyle default_line_cap_style = NSButtLineCapStyle;
 static CGFloat default_miter_limit = 10.0;
 
-@interface NSBezierPath (PrivateMethods)
-- (void)_invalidateCache;
-- (void)_recalculateBounds;
-@end
+static inline NSUInteger points_for_type(NSBezierPathElement type)
+{
+  return (type == NSCurveToBezierPathElement) ? 3 : 1;
+}
+
+/* Makes room for count more elements with pointCount points in all.  */
+static void grow_path_elements(GSPathElements *e, NSUInteger count,
+			       NSUInteger pointCount, NSZone *zone)
+{
+  if (e->count + count > e->capacity)
+    {
+      NSUInteger capacity = e->capacity ? e->capacity : 8;
+
+      while (capacity < e->count + count)
+	capacity *= 2;
+      e->types = NSZoneRealloc(zone, e->types, capacity);
+      e->offsets = NSZoneRealloc(zone, e->offsets,
+				 capacity * sizeof(NSUInteger));
+      e->capacity = capacity;
+    }
+  if (e->pointCount + pointCount > e->pointCapacity)
+    {
+      NSUInteger capacity = e->pointCapacity ? e->pointCapacity : 8;
+
+      while (capacity < e->pointCount + pointCount)
+	capacity *= 2;
+      e->points = NSZoneRealloc(zone, e->points, capacity * sizeof(NSPoint));
+      e->pointCapacity = capacity;
+    }
+}
+
+/* Adds an element, whose points must already have room.  */
+static inline void add_path_element(GSPathElements *e,
+				    NSBezierPathElement type,
+				    const NSPoint *points)
+{
+  NSUInteger n = points_for_type(type);
+
+  e->types[e->count] = type;
+  e->offsets[e->count] = e->pointCount;
+  e->count++;
+  if (type == NSClosePathBezierPathElement)
+    {
+      e->points[e->pointCount] = (e->subpathStart == NSNotFound)
+	? NSZeroPoint : e->points[e->subpathStart];
+    }
+  else
+    {
+      if (type == NSMoveToBezierPathElement)
+	e->subpathStart = e->pointCount;
+      memcpy(e->points + e->pointCount, points, n * sizeof(NSPoint));
+    }
+  e->pointCount += n;
+}
+
+static void add_polyline(GSPathElements *e, const NSPoint *points,
+			 NSUInteger count, BOOL move, BOOL close,
+			 NSZone *zone)
+{
+  NSUInteger i;
+
+  grow_path_elements(e, count + (close ? 1 : 0),
+		     count + (close ? 1 : 0), zone);
+  add_path_element(e, move ? NSMoveToBezierPathElement
+		   : NSLineToBezierPathElement, points);
+  /* Lines have nothing but their point, so go straight to the arrays.  */
+  memset(e->types + e->count, NSLineToBezierPathElement, count - 1);
+  for (i = 1; i < count; i++)
+    e->offsets[e->count + i - 1] = e->pointCount + i - 1;
+  memcpy(e->points + e->pointCount, points + 1,
+	 (count - 1) * sizeof(NSPoint));
+  e->count += count - 1;
+  e->pointCount += count - 1;
+  if (close)
+    add_path_element(e, NSClosePathBezierPathElement, NULL);
+}
+
+static void free_path_elements(GSPathElements *e, NSZone *zone)
+{
+  NSZoneFree(zone, e->types);
+  NSZoneFree(zone, e->offsets);
+  NSZoneFree(zone, e->points);
+  NSZoneFree(zone, e);
+}
+
+/* The outlines of glyphs, kept for all paths once a font backend has
+   been asked for them: the type of each element and the points of all
+   but the closepaths, around the origin of the glyph.  The outlines are
+   found by font info and glyph through a hash table and the least
+   recently used is dropped when there are more than
+   GSGlyphOutlineCacheSize (default 1024).  Each keeps its font info.  */
+typedef struct _GSGlyphOutline
+{
+  struct _GSGlyphOutline *next;
+  struct _GSGlyphOutline *newer;
+  struct _GSGlyphOutline *older;
+  GSFontInfo *fontInfo;
+  NSGlyph glyph;
+  NSSize advancement;
+  NSUInteger count;
+  /* The points of the outline as elements of a path, with closepaths.  */
+  NSUInteger pathPointCount;
+  unsigned char *types;
+  NSPoint *points;
+} GSGlyphOutline;
+
+#define GLYPH_OUTLINE_BUCKETS 1024
+
+static GSGlyphOutline *glyph_outlines[GLYPH_OUTLINE_BUCKETS];
+static GSGlyphOutline *newest_glyph_outline = NULL;
+static GSGlyphOutline *oldest_glyph_outline = NULL;
+static NSUInteger glyph_outline_count = 0;
+static NSUInteger glyph_outline_limit = 1024;
+static NSLock *glyph_outline_lock = nil;
+
+static inline NSUInteger glyph_outline_bucket(GSFontInfo *fontInfo,
+					      NSGlyph glyph)
+{
+  return ((((uintptr_t)fontInfo) >> 4) ^ (glyph * 2654435761U))
+    & (GLYPH_OUTLINE_BUCKETS - 1);
+}
+
+/* Returns the outline of glyph in fontInfo and makes it the most
+   recently used, or NULL.  The lock must be held.  */
+static GSGlyphOutline *find_glyph_outline(GSFontInfo *fontInfo,
+					  NSGlyph glyph)
+{
+  GSGlyphOutline *o = glyph_outlines[glyph_outline_bucket(fontInfo, glyph)];
+
+  while (o != NULL && (o->fontInfo != fontInfo || o->glyph != glyph))
+    o = o->next;
+  if (o != NULL && o != newest_glyph_outline)
+    {
+      o->newer->older = o->older;
+      if (o->older != NULL)
+	o->older->newer = o->newer;
+      else
+	oldest_glyph_outline = o->newer;
+      o->newer = NULL;
+      o->older = newest_glyph_outline;
+      newest_glyph_outline->newer = o;
+      newest_glyph_outline = o;
+    }
+  return o;
+}
+
+static void free_glyph_outline(GSGlyphOutline *o)
+{
+  RELEASE(o->fontInfo);
+  free(o);
+}
+
+/* Asks the font backend for the outline of glyph, with the glyph at the
+   origin of a path of its own.  */
+static GSGlyphOutline *make_glyph_outline(GSFontInfo *fontInfo,
+					   NSGlyph glyph)
+{
+  NSBezierPath *path = [[NSBezierPath alloc] init];
+  GSPathElements *e;
+  GSGlyphOutline *o;
+  NSUInteger count;
+  NSUInteger pointCount;
+  NSUInteger i;
+
+  [path moveToPoint: NSZeroPoint];
+  NS_DURING
+    {
+      [fontInfo appendBezierPathWithGlyphs: &glyph
+				     count: 1
+			      toBezierPath: path];
+    }
+  NS_HANDLER
+    {
+      RELEASE(path);
+      [localException raise];
+    }
+  NS_ENDHANDLER
+
+  /* Leave out the moveto above, and a moveto the backend may have left
+     at the end to advance the current point; the advancement is kept
+     instead.  */
+  e = PATH_ELEMENTS(path);
+  count = e->count - 1;
+  pointCount = e->pointCount - 1;
+  if (count > 0 && e->types[e->count - 1] == NSMoveToBezierPathElement)
+    {
+      count--;
+      pointCount--;
+    }
+
+  o = calloc(1, sizeof(GSGlyphOutline) + pointCount * sizeof(NSPoint)
+	     + count);
+  if (o == NULL)
+    {
+      RELEASE(path);
+      return NULL;
+    }
+  o->points = (NSPoint *)(o + 1);
+  o->types = (unsigned char *)(o->points + pointCount);
+  o->fontInfo = RETAIN(fontInfo);
+  o->glyph = glyph;
+  o->advancement = [fontInfo advancementForGlyph: glyph];
+  o->count = count;
+  o->pathPointCount = pointCount;
+  pointCount = 0;
+  for (i = 0; i < count; i++)
+    {
+      NSBezierPathElement type = e->types[i + 1];
 
+      o->types[i] = type;
+      if (type != NSClosePathBezierPathElement)
+	{
+	  NSUInteger n = points_for_type(type);
+
+	  memcpy(o->points + pointCount, e->points + e->offsets[i + 1],
+		 n * sizeof(NSPoint));
+	  pointCount += n;
+	}
+    }
+  RELEASE(path);
+  return o;
+}
 
-#if 0
-@interface GSBezierPath : NSBezierPath
+/* Adds an outline as the most recently used, or returns the one another
+   thread added meanwhile, dropping the least recently used when there
+   are too many.  The lock must be held.  */
+static GSGlyphOutline *add_glyph_outline(GSGlyphOutline *o)
 {
-  GSIArray pathElements;
-  BOOL flat;
+  GSGlyphOutline *old = find_glyph_outline(o->fontInfo, o->glyph);
+  NSUInteger bucket;
+
+  if (old != NULL)
+    {
+      free_glyph_outline(o);
+      return old;
+    }
+
+  while (glyph_outline_count >= glyph_outline_limit
+	 && oldest_glyph_outline != NULL)
+    {
+      GSGlyphOutline **p;
+
+      old = oldest_glyph_outline;
+      p = &glyph_outlines[glyph_outline_bucket(old->fontInfo, old->glyph)];
+      while (*p != old)
+	p = &(*p)->next;
+      *p = old->next;
+      oldest_glyph_outline = old->newer;
+      if (oldest_glyph_outline != NULL)
+	oldest_glyph_outline->older = NULL;
+      else
+	newest_glyph_outline = NULL;
+      glyph_outline_count--;
+      free_glyph_outline(old);
+    }
+
+  bucket = glyph_outline_bucket(o->fontInfo, o->glyph);
+  o->next = glyph_outlines[bucket];
+  glyph_outlines[bucket] = o;
+  o->older = newest_glyph_outline;
+  o->newer = NULL;
+  if (newest_glyph_outline != NULL)
+    newest_glyph_outline->newer = o;
+  else
+    oldest_glyph_outline = o;
+  newest_glyph_outline = o;
+  glyph_outline_count++;
+  return o;
 }
+
+/* Adds the outline moved to origin.  The lock must be held.  */
+static void add_glyph_outline_elements(GSPathElements *e,
+				       const GSGlyphOutline *o,
+				       NSPoint origin, NSZone *zone)
+{
+  const NSPoint *p = o->points;
+  NSUInteger i;
+
+  grow_path_elements(e, o->count, o->pathPointCount, zone);
+  for (i = 0; i < o->count; i++)
+    {
+      NSBezierPathElement type = o->types[i];
+
+      if (type == NSClosePathBezierPathElement)
+	{
+	  add_path_element(e, type, NULL);
+	}
+      else
+	{
+	  NSPoint points[3];
+	  NSUInteger n = points_for_type(type);
+	  NSUInteger j;
+
+	  for (j = 0; j < n; j++)
+	    {
+	      points[j].x = p[j].x + origin.x;
+	      points[j].y = p[j].y + origin.y;
+	    }
+	  add_path_element(e, type, points);
+	  p += n;
+	}
+    }
+}
+
+@interface NSBezierPath (PrivateMethods)
+- (void)_invalidateCache;
+- (void)_recalculateBounds;
+- (GSFlattenedPath *)_flattenedPath;
 @end
-#endif
+
 
 @implementation NSBezierPath
 
@@ -100,7 +422,14 @@ static CGFloat default_miter_limit = 10.0;
 {
   if (self == [NSBezierPath class])
     {
+      NSInteger limit;
+
       [self setVersion: 2];
+      glyph_outline_lock = [NSLock new];
+      limit = [[NSUserDefaults standardUserDefaults]
+		integerForKey: @"GSGlyphOutlineCacheSize"];
+      if (limit > 0)
+	glyph_outline_limit = limit;
     }
 }
 
@@ -278,8 +607,8 @@ static CGFloat default_miter_limit = 10.0;
   //_dash_pattern = NULL; 
 
   zone = [self zone];
-  _pathElements = NSZoneMalloc(zone, sizeof(GSIArray_t));
-  GSIArrayInitWithZoneAndCapacity(_pathElements, zone, 8);
+  _pathElements = NSZoneCalloc(zone, 1, sizeof(GSPathElements));
+  PATH_ELEMENTS(self)->subpathStart = NSNotFound;
   _flat = YES;
 
   return self;
@@ -287,12 +616,13 @@ static CGFloat default_miter_limit = 10.0;
 
 - (void) dealloc
 {
-  GSIArrayEmpty(_pathElements);
-  NSZoneFree([self zone], _pathElements);
+  free_path_elements(_pathElements, [self zone]);
 
   if (_cacheImage != nil)
     RELEASE(_cacheImage);
 
+  free_flattened_path(_flattenedPath, [self zone]);
+
   if (_dash_pattern != NULL)
     NSZoneFree([self zone], _dash_pattern);
 
@@ -304,25 +634,19 @@ static CGFloat default_miter_limit = 10.0;
 //
 - (void)moveToPoint:(NSPoint)aPoint
 {
-  PathElement elem;
-  
-  elem.type = NSMoveToBezierPathElement;
-  elem.points[0] = aPoint;
-  elem.points[1] = NSZeroPoint;
-  elem.points[2] = NSZeroPoint;
-  GSIArrayAddItem(_pathElements, (GSIArrayItem)elem);
+  GSPathElements *e = PATH_ELEMENTS(self);
+
+  grow_path_elements(e, 1, 1, [self zone]);
+  add_path_element(e, NSMoveToBezierPathElement, &aPoint);
   INVALIDATE_CACHE();
 }
 
 - (void)lineToPoint:(NSPoint)aPoint
 {
-  PathElement elem;
-  
-  elem.type = NSLineToBezierPathElement;
-  elem.points[0] = aPoint;
-  elem.points[1] = NSZeroPoint;
-  elem.points[2] = NSZeroPoint;
-  GSIArrayAddItem(_pathElements, (GSIArrayItem)elem);
+  GSPathElements *e = PATH_ELEMENTS(self);
+
+  grow_path_elements(e, 1, 1, [self zone]);
+  add_path_element(e, NSLineToBezierPathElement, &aPoint);
   INVALIDATE_CACHE();
 }
 
@@ -330,13 +654,14 @@ static CGFloat default_miter_limit = 10.0;
        controlPoint1:(NSPoint)controlPoint1
        controlPoint2:(NSPoint)controlPoint2
 {
-  PathElement elem;
-  
-  elem.type = NSCurveToBezierPathElement;
-  elem.points[0] = controlPoint1;
-  elem.points[1] = controlPoint2;
-  elem.points[2] = aPoint;
-  GSIArrayAddItem(_pathElements, (GSIArrayItem)elem);
+  GSPathElements *e = PATH_ELEMENTS(self);
+  NSPoint points[3];
+
+  points[0] = controlPoint1;
+  points[1] = controlPoint2;
+  points[2] = aPoint;
+  grow_path_elements(e, 1, 3, [self zone]);
+  add_path_element(e, NSCurveToBezierPathElement, points);
   _flat = NO;
 
   INVALIDATE_CACHE();
@@ -344,19 +669,20 @@ static CGFloat default_miter_limit = 10.0;
 
 - (void)closePath
 {
-  PathElement elem;
+  GSPathElements *e = PATH_ELEMENTS(self);
 
-  elem.type = NSClosePathBezierPathElement;
-  elem.points[0] = NSZeroPoint;
-  elem.points[1] = NSZeroPoint;
-  elem.points[2] = NSZeroPoint;
-  GSIArrayAddItem(_pathElements, (GSIArrayItem)elem);
+  grow_path_elements(e, 1, 1, [self zone]);
+  add_path_element(e, NSClosePathBezierPathElement, NULL);
   INVALIDATE_CACHE();
 }
 
 - (void)removeAllPoints
 {
-  GSIArrayRemoveAllItems(_pathElements);
+  GSPathElements *e = PATH_ELEMENTS(self);
+
+  e->count = 0;
+  e->pointCount = 0;
+  e->subpathStart = NSNotFound;
   _flat = YES;
   INVALIDATE_CACHE();
 }
@@ -602,59 +928,27 @@ static CGFloat default_miter_limit = 10.0;
 - (NSBezierPath *)bezierPathByFlatteningPath
 {
   NSBezierPath *path;
-  NSBezierPathElement type;
-  NSPoint pts[3];
-  NSPoint coeff[4];
-  NSPoint p, last_p;
-  NSInteger i, count;
-  BOOL first = YES;
+  GSFlattenedPath *f;
+  NSUInteger i;
 
   if (_flat)
     return self;
 
-  /* Silence compiler warnings.  */
-  p = NSZeroPoint;
-  last_p = NSZeroPoint;
-
+  f = [self _flattenedPath];
   path = [[self class] bezierPath];
-  count = [self elementCount];
-  for (i = 0; i < count; i++) 
+  for (i = 0; i < f->count; i++) 
     {
-      type = [self elementAtIndex: i associatedPoints: pts];
-      switch(type) 
+      switch (f->types[i]) 
         {
-	  case NSMoveToBezierPathElement:
-	      [path moveToPoint: pts[0]];
-	      last_p = p = pts[0];
-	      first = NO;
+	  case FlatMove:
+	      [path moveToPoint: f->points[i]];
 	      break;
-	  case NSLineToBezierPathElement:
-	      [path lineToPoint: pts[0]];
-	      p = pts[0];
-	      if (first)
-	        {
-		  last_p = pts[0];
-		  first = NO;
-		}
-	      break;
-	  case NSCurveToBezierPathElement:
-	      coeff[0] = p;
-	      coeff[1] = pts[0];
-	      coeff[2] = pts[1];
-	      coeff[3] = pts[2];
-	      flatten(coeff, [self flatness], path);
-	      p = pts[2];
-	      if (first)
-		{
-		  last_p = pts[2];
-		  first = NO;
-		}
+	  case FlatLine:
+	  case FlatCurve:
+	      [path lineToPoint: f->points[i]];
 	      break;
-	  case NSClosePathBezierPathElement:
+	  case FlatClose:
 	      [path closePath];
-	      p = last_p;
-	      break;
-	  default:
 	      break;
 	}
     }
@@ -736,41 +1030,19 @@ static CGFloat default_miter_limit = 10.0;
 //
 - (void) transformUsingAffineTransform: (NSAffineTransform *)transform
 {
-  NSBezierPathElement type;
-  NSPoint pts[3];
-  NSInteger i, count;
-  SEL transformPointSel = @selector(transformPoint:); 
-  NSPoint (*transformPointImp)(NSAffineTransform*, SEL, NSPoint);
-
-  transformPointImp = (NSPoint (*)(NSAffineTransform*, SEL, NSPoint))
-    [transform methodForSelector: transformPointSel];
+  GSPathElements *e = PATH_ELEMENTS(self);
+  NSAffineTransformStruct m = [transform transformStruct];
+  NSPoint *p = e->points;
+  NSPoint *end = p + e->pointCount;
 
-  count = [self elementCount];
-  for (i = 0; i < count; i++) 
+  /* Every point, including those closepath elements keep of the start of
+     their subpath, goes through the same transform.  */
+  for (; p < end; p++)
     {
-      type = [self elementAtIndex: i associatedPoints: pts];
-      switch(type) 
-        {
-	  case NSMoveToBezierPathElement:
-	  case NSLineToBezierPathElement:
-	      pts[0] = (*transformPointImp)(transform,
-                                            transformPointSel, pts[0]);
-	      [self setAssociatedPoints: pts atIndex: i];
-	      break;
-	  case NSCurveToBezierPathElement:
-	      pts[0] = (*transformPointImp)(transform,
-                                            transformPointSel, pts[0]);
-	      pts[1] = (*transformPointImp)(transform,
-                                            transformPointSel, pts[1]);
-	      pts[2] = (*transformPointImp)(transform,
-                                            transformPointSel, pts[2]);
-	      [self setAssociatedPoints: pts atIndex: i];
-	      break;
-	  case NSClosePathBezierPathElement:
-	      break;
-	  default:
-	      break;
-	}
+      CGFloat x = p->x;
+
+      p->x = m.m11 * x + m.m21 * p->y + m.tX;
+      p->y = m.m12 * x + m.m22 * p->y + m.tY;
     }
   INVALIDATE_CACHE();
 }
@@ -833,45 +1105,34 @@ static CGFloat default_miter_limit = 10.0;
 //
 - (NSInteger) elementCount
 {
-  return GSIArrayCount(_pathElements);
+  return PATH_ELEMENTS(self)->count;
 }
 
 - (NSBezierPathElement) elementAtIndex: (NSInteger)index
 		      associatedPoints: (NSPoint *)points
 {
-  PathElement elm = GSIArrayItemAtIndex(_pathElements, index).ext;
-  NSBezierPathElement type = elm.type;
-  NSInteger i;
-	
+  GSPathElements *e = PATH_ELEMENTS(self);
+  NSBezierPathElement type;
+
+  if (index < 0 || (NSUInteger)index >= e->count)
+    [NSException raise: NSRangeException
+		format: @"Index out of range in -elementAtIndex:associatedPoints:"];
+
+  type = e->types[index];
   if (points != NULL) 
     {
-      switch(type) 
-        {
-        case NSMoveToBezierPathElement:
-        case NSLineToBezierPathElement:
-	  points[0] = elm.points[0];
-          break;
-        case NSCurveToBezierPathElement:
-	  points[0] = elm.points[0];
-	  points[1] = elm.points[1];
-	  points[2] = elm.points[2];
-          break;
-        case NSClosePathBezierPathElement:
-  	  // We have to find the last move element and take its point
-	  for (i = index - 1; i >= 0; i--)
-	    {
-	      elm = GSIArrayItemAtIndex(_pathElements, i).ext;
-	      if (elm.type == NSMoveToBezierPathElement)
-                {
-                  points[0] = elm.points[0];
-                  break;
-                }
-	    }
-          // FIXME: What to do if we don't find a move element?
-          break;
-        default:
-	  break;
-        }
+      NSPoint *p = e->points + e->offsets[index];
+
+      if (type == NSCurveToBezierPathElement)
+	{
+	  points[0] = p[0];
+	  points[1] = p[1];
+	  points[2] = p[2];
+	}
+      else
+	{
+	  points[0] = p[0];
+	}
     }
   
   return type;
@@ -884,19 +1145,36 @@ static CGFloat default_miter_limit = 10.0;
 
 - (void)setAssociatedPoints:(NSPoint *)points atIndex:(NSInteger)index
 {
-  PathElement elm = GSIArrayItemAtIndex(_pathElements, index).ext;
-  NSBezierPathElement type = elm.type;
-  
+  GSPathElements *e = PATH_ELEMENTS(self);
+  NSBezierPathElement type;
+  NSPoint *p;
+  NSUInteger i;
+
+  if (index < 0 || (NSUInteger)index >= e->count)
+    [NSException raise: NSRangeException
+		format: @"Index out of range in -setAssociatedPoints:atIndex:"];
+
+  type = e->types[index];
+  p = e->points + e->offsets[index];
   switch(type) 
     {
       case NSMoveToBezierPathElement:
+	  p[0] = points[0];
+	  /* The closepath elements of the subpath keep its start.  */
+	  for (i = index + 1; i < e->count
+		 && e->types[i] != NSMoveToBezierPathElement; i++)
+	    {
+	      if (e->types[i] == NSClosePathBezierPathElement)
+		e->points[e->offsets[i]] = points[0];
+	    }
+	  break;
       case NSLineToBezierPathElement:
-	  elm.points[0] = points[0];
+	  p[0] = points[0];
 	  break;
       case NSCurveToBezierPathElement:
-	  elm.points[0] = points[0];
-	  elm.points[1] = points[1];
-	  elm.points[2] = points[2];
+	  p[0] = points[0];
+	  p[1] = points[1];
+	  p[2] = points[2];
 	  break;
       case NSClosePathBezierPathElement:
 	  break;
@@ -904,7 +1182,6 @@ static CGFloat default_miter_limit = 10.0;
 	  break;
     }
 
-  GSIArraySetItemAtIndex(_pathElements, (GSIArrayItem)elm, index);
   INVALIDATE_CACHE();
 }
 
@@ -917,6 +1194,44 @@ static CGFloat default_miter_limit = 10.0;
   NSPoint points[3];
   NSInteger i, count;
 
+  if ([aPath isKindOfClass: [NSBezierPath class]]
+      && [aPath methodForSelector: @selector(elementAtIndex:associatedPoints:)]
+      == [NSBezierPath instanceMethodForSelector:
+        @selector(elementAtIndex:associatedPoints:)])
+    {
+      GSPathElements *e = PATH_ELEMENTS(self);
+      GSPathElements *a = PATH_ELEMENTS(aPath);
+      NSUInteger n = a->count;
+      NSUInteger base = e->pointCount;
+      NSUInteger j;
+
+      if (n == 0)
+	return;
+
+      /* Copy the arrays, moving the offsets past the points already
+	 there.  Closepath elements before the first moveto of aPath
+	 close the current subpath of the receiver.  */
+      grow_path_elements(e, n, a->pointCount, [self zone]);
+      memcpy(e->types + e->count, a->types, n);
+      memcpy(e->points + base, a->points, a->pointCount * sizeof(NSPoint));
+      for (j = 0; j < n; j++)
+	{
+	  NSUInteger offset = a->offsets[j] + base;
+
+	  e->offsets[e->count + j] = offset;
+	  if (a->types[j] == NSMoveToBezierPathElement)
+	    e->subpathStart = offset;
+	  else if (a->types[j] == NSClosePathBezierPathElement)
+	    e->points[offset] = (e->subpathStart == NSNotFound)
+	      ? NSZeroPoint : e->points[e->subpathStart];
+	}
+      e->count += n;
+      e->pointCount += a->pointCount;
+      _flat = _flat && aPath->_flat;
+      INVALIDATE_CACHE();
+      return;
+    }
+
   count = [aPath elementCount];
   for (i = 0; i < count; i++)
     {
@@ -962,24 +1277,47 @@ static CGFloat default_miter_limit = 10.0;
 
 - (void)appendBezierPathWithPoints:(NSPoint *)points count:(NSInteger)count
 {
-  NSInteger i;
+  if (count <= 0)
+    return;
 
-  if (!count)
+  add_polyline(PATH_ELEMENTS(self), points, count, [self isEmpty], NO,
+	       [self zone]);
+  INVALIDATE_CACHE();
+}
+
+- (void) appendPolylineWithPoints: (const NSPoint *)points
+			    count: (NSInteger)count
+{
+  if (count <= 0)
     return;
 
-  if ([self isEmpty])
-    {
-      [self moveToPoint: points[0]];
-    }
-  else
-    {
-      [self lineToPoint: points[0]];
-    }
-  
-  for (i = 1; i < count; i++)
-    {
-      [self lineToPoint: points[i]];
-    }
+  add_polyline(PATH_ELEMENTS(self), points, count, YES, NO, [self zone]);
+  INVALIDATE_CACHE();
+}
+
+- (void) appendPolygonWithPoints: (const NSPoint *)points
+			   count: (NSInteger)count
+{
+  if (count <= 0)
+    return;
+
+  add_polyline(PATH_ELEMENTS(self), points, count, YES, YES, [self zone]);
+  INVALIDATE_CACHE();
+}
+
+- (NSInteger) getElementTypes: (const unsigned char **)types
+		       points: (const NSPoint **)points
+		   pointCount: (NSInteger *)pointCount
+{
+  GSPathElements *e = PATH_ELEMENTS(self);
+
+  if (types != NULL)
+    *types = e->types;
+  if (points != NULL)
+    *points = e->points;
+  if (pointCount != NULL)
+    *pointCount = e->pointCount;
+  return e->count;
 }
 
 - (void) appendBezierPathWithOvalInRect: (NSRect)aRect
@@ -1248,18 +1586,49 @@ static CGFloat default_miter_limit = 10.0;
 
 - (void)appendBezierPathWithGlyph:(NSGlyph)glyph inFont:(NSFont *)font
 {
-  [[font fontInfo] appendBezierPathWithGlyphs: &glyph
-    count: 1
-    toBezierPath: self];
+  [self appendBezierPathWithGlyphs: &glyph count: 1 inFont: font];
 }
 
+/* The outlines come from the glyph outline cache, so the backend is
+   asked for each glyph of a font once.  Each glyph is put at the current
+   point, which is then advanced by the advancement of the glyph.  */
 - (void)appendBezierPathWithGlyphs:(NSGlyph *)glyphs 
 			     count:(NSInteger)count
 			    inFont:(NSFont *)font
 {
-  [[font fontInfo] appendBezierPathWithGlyphs: glyphs
-    count: count
-    toBezierPath: self];
+  GSFontInfo *fontInfo = [font fontInfo];
+  GSPathElements *e = PATH_ELEMENTS(self);
+  NSZone *zone = [self zone];
+  NSPoint origin;
+  NSInteger i;
+
+  if (fontInfo == nil || count <= 0)
+    return;
+
+  origin = e->count > 0 ? e->points[e->pointCount - 1] : NSZeroPoint;
+  [glyph_outline_lock lock];
+  for (i = 0; i < count; i++)
+    {
+      GSGlyphOutline *o = find_glyph_outline(fontInfo, glyphs[i]);
+
+      if (o == NULL)
+	{
+	  [glyph_outline_lock unlock];
+	  o = make_glyph_outline(fontInfo, glyphs[i]);
+	  [glyph_outline_lock lock];
+	  if (o == NULL)
+	    continue;
+	  o = add_glyph_outline(o);
+	}
+      add_glyph_outline_elements(e, o, origin, zone);
+      origin.x += o->advancement.width;
+      origin.y += o->advancement.height;
+    }
+  [glyph_outline_lock unlock];
+
+  grow_path_elements(e, 1, 1, zone);
+  add_path_element(e, NSMoveToBezierPathElement, &origin);
+  INVALIDATE_CACHE();
 }
 
 - (void)appendBezierPathWithPackedGlyphs:(const char *)packedGlyphs
@@ -1522,6 +1891,95 @@ static int winding_curve(double_point from, double_point to, double_point c1,
   }
 }
 
+/* Returns whether p lies in the rectangle around the line from a to b
+   that holds a curve flattened to that line with the given flatness,
+   so the curve and the line might pass p on different sides. */
+static BOOL near_flattened_curve(double_point a, double_point b,
+				 double_point p, double flatness)
+{
+  double dx = b.x - a.x;
+  double dy = b.y - a.y;
+  double len = sqrt(dx * dx + dy * dy);
+  double tol;
+  double u, v;
+
+  /* Allow for rounding in the subdivision.  */
+  tol = flatness * 1.001
+    + 1e-6 * (fabs(a.x) + fabs(a.y) + fabs(b.x) + fabs(b.y) + 1.0);
+  if (len < 0.04)
+    {
+      /* A curve with ends this close is flat when its control points are
+	 within the flatness of its start.  */
+      u = p.x - a.x;
+      v = p.y - a.y;
+      return sqrt(u * u + v * v) <= tol + len;
+    }
+
+  u = ((p.x - a.x) * dx + (p.y - a.y) * dy) / len;
+  v = ((p.x - a.x) * dy - (p.y - a.y) * dx) / len;
+  return u >= -tol && u <= len + tol && fabs(v) <= tol;
+}
+
+/* Works out the winding count of point from the flattened form of the
+   path f.  Returns NO if point is too close to a curve for the flattened
+   form to give the winding count of the curves, or the path isn't well
+   formed.  */
+static BOOL flattened_winding_count(GSFlattenedPath *f, NSPoint point,
+				    int *result)
+{
+  double_point p = {point.x, point.y};
+  double_point first_p, last_p;
+  double flatness = f->flatness;
+  BOOL first;
+  int total = 0;
+  NSUInteger i;
+
+  if (!f->withinFlatness || f->count == 0 || f->types[0] != FlatMove)
+    return NO;
+
+  first_p.x = last_p.x = f->points[0].x;
+  first_p.y = last_p.y = f->points[0].y;
+  first = NO;
+  for (i = 1; i < f->count; i++)
+    {
+      double_point q = {f->points[i].x, f->points[i].y};
+
+      switch (f->types[i])
+	{
+	  case FlatMove:
+	    if (!first)
+	      total += winding_line(last_p, first_p, p);
+	    last_p = first_p = q;
+	    first = NO;
+	    break;
+	  case FlatCurve:
+	    if (first || near_flattened_curve(last_p, q, p, flatness))
+	      return NO;
+	    total += winding_line(last_p, q, p);
+	    last_p = q;
+	    break;
+	  case FlatLine:
+	    if (first)
+	      return NO;
+	    total += winding_line(last_p, q, p);
+	    last_p = q;
+	    break;
+	  case FlatClose:
+	    if (first)
+	      return NO;
+	    first = YES;
+	    total += winding_line(last_p, first_p, p);
+	    break;
+	}
+    }
+
+  if (!first)
+    total += winding_line(last_p, first_p, p);
+
+  *result = total / 2;
+  return YES;
+}
+
 - (int) windingCountAtPoint: (NSPoint)point
 {
   int total;
@@ -1565,6 +2023,13 @@ static int winding_curve(double_point from, double_point to, double_point c1,
   if (count == 0)
     return 0;
 
+  /* Points away from the curves get the same count from the lines the
+     curves are flattened to, which are kept, so only points close to a
+     curve need the curves subdivided around them.  */
+  if (flattened_winding_count([self _flattenedPath], point, &total))
+    return total;
+  total = 0;
+
   /* 'Unroll' the first element to avoid compiler warnings.  It has to be
      a MoveTo, anyway.  */
   type = [self elementAtIndex: 0 associatedPoints: pts];
@@ -2073,15 +2538,29 @@ static int winding_curve(double_point from, double_point to, double_point c1,
   if (_cachesBezierPath && _cacheImage)
       path->_cacheImage = [_cacheImage copy];
 
+  path->_flattenedPath = NULL;
+
   if (_dash_pattern != NULL)
     {
       CGFloat *pattern = NSZoneMalloc(zone, _dash_count * sizeof(CGFloat));
 
       memcpy(pattern, _dash_pattern, _dash_count * sizeof(CGFloat));
-      _dash_pattern = pattern;
+      path->_dash_pattern = pattern;
     }
 
-  path->_pathElements = GSIArrayCopyWithZone(_pathElements, zone);
+  {
+    GSPathElements *e = PATH_ELEMENTS(self);
+    GSPathElements *c = NSZoneCalloc(zone, 1, sizeof(GSPathElements));
+
+    c->subpathStart = e->subpathStart;
+    grow_path_elements(c, e->count, e->pointCount, zone);
+    memcpy(c->types, e->types, e->count);
+    memcpy(c->offsets, e->offsets, e->count * sizeof(NSUInteger));
+    memcpy(c->points, e->points, e->pointCount * sizeof(NSPoint));
+    c->count = e->count;
+    c->pointCount = e->pointCount;
+    path->_pathElements = c;
+  }
 
   return path;
 }
@@ -2095,6 +2574,22 @@ static int winding_curve(double_point from, double_point to, double_point c1,
 {
   _shouldRecalculateBounds = YES;
   DESTROY(_cacheImage);
+  free_flattened_path(_flattenedPath, [self zone]);
+  _flattenedPath = NULL;
+}
+
+/* Returns the flattened form of the receiver, making it if the path has
+   changed or its flatness has been set since it was last made.  */
+- (GSFlattenedPath *) _flattenedPath
+{
+  GSFlattenedPath *f = _flattenedPath;
+
+  if (f == NULL || f->flatness != _flatness)
+    {
+      free_flattened_path(f, [self zone]);
+      _flattenedPath = f = flattened_path(self, [self zone]);
+    }
+  return f;
 }
 
 
@@ -2235,41 +2730,34 @@ static NSPoint point_on_curve(double t, NSPoint a, NSPoint b, NSPoint c,
 
 @end
 
-#if 0
-@implementation GSBezierPath
-
-- (void) appendBezierPath: (NSBezierPath *)aPath
+static void append_flattened_point(GSFlattenedPath *f, NSPoint p,
+				   unsigned char type, NSZone *zone)
 {
-  PathElement elem;
-  int i, count;
-
-  if (![aPath isKindOfClass: object_getClass(self)])
+  if (f->count == f->capacity)
     {
-      [super appendBezierPath: aPath];
-      return;
+      f->capacity = f->capacity ? 2 * f->capacity : 16;
+      f->points = NSZoneRealloc(zone, f->points,
+				f->capacity * sizeof(NSPoint));
+      f->types = NSZoneRealloc(zone, f->types, f->capacity);
     }
+  f->points[f->count] = p;
+  f->types[f->count] = type;
+  f->count++;
+}
 
-  flat = flat && ((GSBezierPath*)aPath)->flat;
-  count = [aPath elementCount];
-
-  for (i = 0; i < count; i++)
+static void free_flattened_path(GSFlattenedPath *f, NSZone *zone)
+{
+  if (f != NULL)
     {
-      elem = GSIArrayItemAtIndex(((GSBezierPath*)aPath)->pathElements, i).ext;
-      GSIArrayAddItem(pathElements, (GSIArrayItem)elem);
+      NSZoneFree(zone, f->points);
+      NSZoneFree(zone, f->types);
+      NSZoneFree(zone, f);
     }
-  INVALIDATE_CACHE();
 }
 
-@end // GSBezierPath
-#endif
-
-static void flatten(NSPoint coeff[], CGFloat flatness, NSBezierPath *path)
+static BOOL curve_is_flat(NSPoint coeff[], CGFloat flatness)
 {
   // Check if the Bezier path defined by the four points has the given flatness.
-  // If not split it up in the middle and recurse. 
-  // Otherwise add the end point to the path.
-  BOOL flat = YES;
-
   // This criteria for flatness is based on code from Libart which has the 
   // following copyright:
 /* Libart_LGPL - library of basic graphic primitives
@@ -2292,6 +2780,7 @@ static void flatten(NSPoint coeff[], CGFloat flatness, NSBezierPath *path)
  */
 
   double x1_0, y1_0;
+  double x2_0, y2_0;
   double x3_2, y3_2;
   double x3_0, y3_0;
   double z3_0_dot;
@@ -2306,69 +2795,159 @@ static void flatten(NSPoint coeff[], CGFloat flatness, NSBezierPath *path)
   x1_0 = coeff[1].x - coeff[0].x;
   y1_0 = coeff[1].y - coeff[0].y;
   z3_0_dot = x3_0 * x3_0 + y3_0 * y3_0;
+  max_perp_sq = flatness * flatness;
 
   if (z3_0_dot < 0.001)
-    flat = YES;
-  else
     {
-      max_perp_sq = flatness * flatness * z3_0_dot;
+      /* The ends (nearly) meet, so the curve is flat only if the control
+	 points are close to them too.  Loops are subdivided.  */
+      x2_0 = coeff[2].x - coeff[0].x;
+      y2_0 = coeff[2].y - coeff[0].y;
+      return (x1_0 * x1_0 + y1_0 * y1_0 <= max_perp_sq
+	      && x2_0 * x2_0 + y2_0 * y2_0 <= max_perp_sq);
+    }
+
+  max_perp_sq *= z3_0_dot;
+
+  z1_perp = y1_0 * x3_0 - x1_0 * y3_0;
+  if (z1_perp * z1_perp > max_perp_sq)
+    return NO;
+
+  z2_perp = y3_2 * x3_0 - x3_2 * y3_0;
+  if (z2_perp * z2_perp > max_perp_sq)
+    return NO;
+
+  z1_dot = x1_0 * x3_0 + y1_0 * y3_0;
+  if (z1_dot < 0 && z1_dot * z1_dot > max_perp_sq)
+    return NO;
 
-      z1_perp = y1_0 * x3_0 - x1_0 * y3_0;
-      if (z1_perp * z1_perp > max_perp_sq)
-	flat = NO;
+  z2_dot = x3_2 * x3_0 + y3_2 * y3_0;
+  if (z2_dot < 0 && z2_dot * z2_dot > max_perp_sq)
+    return NO;
+
+  if ((z1_dot + z1_dot > z3_0_dot) ||
+      (z2_dot + z2_dot > z3_0_dot))
+    return NO;
+
+  return YES;
+}
+
+/* Appends the lines approximating the Bezier curve defined by the four
+   points to f.  The curve is split in the middle until its parts are
+   flat, using a stack of the parts still to be done rather than
+   recursion.  */
+static void flatten_curve(GSFlattenedPath *f, NSPoint coeff[],
+			  CGFloat flatness, NSZone *zone)
+{
+  NSPoint stack[MAX_FLATTEN_DEPTH + 1][4];
+  int depth[MAX_FLATTEN_DEPTH + 1];
+  int top = 0;
+
+  memcpy(stack[0], coeff, 4 * sizeof(NSPoint));
+  depth[0] = 0;
+  while (top >= 0)
+    {
+      NSPoint *b = stack[top];
+
+      if (depth[top] == MAX_FLATTEN_DEPTH || curve_is_flat(b, flatness))
+	{
+	  if (depth[top] == MAX_FLATTEN_DEPTH)
+	    f->withinFlatness = NO;
+	  append_flattened_point(f, b[3], FlatCurve, zone);
+	  top--;
+	}
       else
+	{
+	  NSPoint *bleft = stack[top + 1];
+	  NSPoint bright[4];
+
+	  /* The right half replaces the curve and the left half goes on
+	     top of it, to be done first.  */
+	  bleft[0] = b[0];
+	  bleft[1].x = (b[0].x + b[1].x) / 2;
+	  bleft[1].y = (b[0].y + b[1].y) / 2;
+	  bleft[2].x = (b[0].x + 2*b[1].x + b[2].x) / 4;
+	  bleft[2].y = (b[0].y + 2*b[1].y + b[2].y) / 4;
+	  bleft[3].x = (b[0].x + 3*(b[1].x + b[2].x) + b[3].x) / 8;
+	  bleft[3].y = (b[0].y + 3*(b[1].y + b[2].y) + b[3].y) / 8;
+	  bright[0] = bleft[3];
+	  bright[1].x = (b[3].x + 2*b[2].x + b[1].x) / 4;
+	  bright[1].y = (b[3].y + 2*b[2].y + b[1].y) / 4;
+	  bright[2].x = (b[3].x + b[2].x) / 2;
+	  bright[2].y = (b[3].y + b[2].y) / 2;
+	  bright[3] = b[3];
+	  memcpy(b, bright, sizeof(bright));
+	  depth[top + 1] = ++depth[top];
+	  top++;
+	}
+    }
+}
+
+static GSFlattenedPath *flattened_path(NSBezierPath *path, NSZone *zone)
+{
+  GSFlattenedPath *f;
+  NSBezierPathElement type;
+  NSPoint pts[3];
+  NSPoint coeff[4];
+  NSPoint p, last_p;
+  NSInteger i, count;
+  BOOL first = YES;
+
+  f = NSZoneMalloc(zone, sizeof(GSFlattenedPath));
+  f->count = 0;
+  f->capacity = 0;
+  f->points = NULL;
+  f->types = NULL;
+  f->flatness = [path flatness];
+  f->withinFlatness = YES;
+
+  /* Silence compiler warnings.  */
+  p = NSZeroPoint;
+  last_p = NSZeroPoint;
+
+  count = [path elementCount];
+  for (i = 0; i < count; i++) 
+    {
+      type = [path elementAtIndex: i associatedPoints: pts];
+      switch(type) 
         {
-	  z2_perp = y3_2 * x3_0 - x3_2 * y3_0;
-	  if (z2_perp * z2_perp > max_perp_sq)
-	      flat = NO;
-	  else
-	    {
-	      z1_dot = x1_0 * x3_0 + y1_0 * y3_0;
-	      if (z1_dot < 0 && z1_dot * z1_dot > max_perp_sq)
-		flat = NO;
-	      else
+	  case NSMoveToBezierPathElement:
+	      append_flattened_point(f, pts[0], FlatMove, zone);
+	      last_p = p = pts[0];
+	      first = NO;
+	      break;
+	  case NSLineToBezierPathElement:
+	      append_flattened_point(f, pts[0], FlatLine, zone);
+	      p = pts[0];
+	      if (first)
 	        {
-		  z2_dot = x3_2 * x3_0 + y3_2 * y3_0;
-		  if (z2_dot < 0 && z2_dot * z2_dot > max_perp_sq)
-		      flat = NO;
-		  else
-		    {
-		      if ((z1_dot + z1_dot > z3_0_dot) ||
-			  (z2_dot + z2_dot > z3_0_dot))
-			flat = NO;
-		    }
+		  last_p = pts[0];
+		  first = NO;
 		}
-	    }
+	      break;
+	  case NSCurveToBezierPathElement:
+	      coeff[0] = p;
+	      coeff[1] = pts[0];
+	      coeff[2] = pts[1];
+	      coeff[3] = pts[2];
+	      flatten_curve(f, coeff, f->flatness, zone);
+	      p = pts[2];
+	      if (first)
+		{
+		  last_p = pts[2];
+		  first = NO;
+		}
+	      break;
+	  case NSClosePathBezierPathElement:
+	      append_flattened_point(f, last_p, FlatClose, zone);
+	      p = last_p;
+	      break;
+	  default:
+	      break;
 	}
     }
 
-  if (!flat)
-    {
-      NSPoint bleft[4], bright[4];
-	
-      bleft[0] = coeff[0];
-      bleft[1].x = (coeff[0].x + coeff[1].x) / 2;
-      bleft[1].y = (coeff[0].y + coeff[1].y) / 2;
-      bleft[2].x = (coeff[0].x + 2*coeff[1].x + coeff[2].x) / 4;
-      bleft[2].y = (coeff[0].y + 2*coeff[1].y + coeff[2].y) / 4;
-      bleft[3].x = (coeff[0].x + 3*(coeff[1].x + coeff[2].x) + coeff[3].x) / 8;
-      bleft[3].y = (coeff[0].y + 3*(coeff[1].y + coeff[2].y) + coeff[3].y) / 8;
-      bright[0].x =  bleft[3].x;
-      bright[0].y =  bleft[3].y;
-      bright[1].x = (coeff[3].x + 2*coeff[2].x + coeff[1].x) / 4;
-      bright[1].y = (coeff[3].y + 2*coeff[2].y + coeff[1].y) / 4;
-      bright[2].x = (coeff[3].x + coeff[2].x) / 2;
-      bright[2].y = (coeff[3].y + coeff[2].y) / 2;
-      bright[3] = coeff[3];
-
-      flatten(bleft, flatness, path);
-      flatten(bright, flatness, path);
-    }
-  else
-    {
-      //[path lineToPoint: coeff[1]];
-      //[path lineToPoint: coeff[2]];
-      [path lineToPoint: coeff[3]];
-    }
+  return f;
 }
 
+
@@ -36,6 +36,9 @@
 + (BOOL) _bitmapIsGIF: (NSData *)imageData;
 - (id) _initBitmapFromGIF: (NSData *)imageData
              errorMessage: (NSString **)errorMsg;
+/* Shows frame n of an animated gif, decoding it if needed. Returns NO
+   if there is no such frame. */
+- (BOOL) _setGIFFrame: (int)n;
 - (NSData *) _GIFRepresentationWithProperties: (NSDictionary *) properties
                                  errorMessage: (NSString **)errorMsg;
 
@@ -125,6 +125,375 @@ static int gs_gif_output(GifFileType *file, const GifByteType *buffer, int len)
 }
 #endif
 
+/* -----------------------------------------------------------
+   Decoding the frames of animated gifs
+   ----------------------------------------------------------- */
+
+/* The number of decoded frames kept for animations too large to keep
+   all of them. */
+#define GIF_FRAME_RING 4
+/* Animations whose decoded frames take at most this many bytes together
+   keep all of them, so that later loops need no decoding. */
+#define GIF_FRAME_BUDGET (4 * 1024 * 1024)
+
+static GifFileType *gs_gif_open(gs_gif_input_src *src)
+{
+  src->pos = 0;
+#if GIFLIB_MAJOR >= 5
+  return DGifOpen(src, gs_gif_input, NULL);
+#else
+  return DGifOpen(src, gs_gif_input);
+#endif
+}
+
+/*
+ * Decodes the frames of an animated gif one at a time as they are asked
+ * for. Apart from the compressed data it only keeps the canvas the
+ * frames are composited onto and a few decoded frames. Going back to an
+ * earlier frame that is no longer kept starts decoding from the first
+ * frame again.
+ */
+@interface GSGIFFrameDecoder : NSObject
+{
+@public
+  NSData *data;
+  gs_gif_input_src src;
+  GifFileType *file;
+  int width, height;
+  int frameCount;
+  int loopCount;
+  int next;			/* The frame the file is positioned at. */
+  BOOL hasAlpha;
+  int sPP;
+  NSMutableData *delays;	/* unsigned short per frame, in 1/100 s */
+  unsigned char *canvas;	/* width * height RGBA pixels */
+  unsigned char *saved;		/* The canvas before the last frame. */
+  int disposal;			/* Disposal method of the last frame. */
+  int left, top, right, bottom;	/* The area of the last frame. */
+  unsigned char background[4];
+  NSMutableDictionary *frames;	/* Decoded frames by number. */
+  NSMutableArray *order;	/* Numbers of the kept frames, oldest first. */
+  NSUInteger capacity;
+}
+- (id) initWithData: (NSData *)imageData;
+- (NSData *) frame: (int)n;
+- (float) durationOfFrame: (int)n;
+@end
+
+@implementation GSGIFFrameDecoder
+
+/* Skips the remaining sub-blocks of an extension. */
+static BOOL skipExtension(GifFileType *file, GifByteType *extension)
+{
+  while (extension != NULL)
+    {
+      if (DGifGetExtensionNext(file, &extension) != GIF_OK)
+	return NO;
+    }
+  return YES;
+}
+
+/* Counts the frames and finds their delays without decoding them. */
+- (BOOL) _scan
+{
+  GifRecordType recordType;
+  GifByteType *extension, *code;
+  int extCode, codeSize;
+  unsigned short delay = 0;
+
+  do
+    {
+      if (DGifGetRecordType(file, &recordType) != GIF_OK)
+	return NO;
+      switch (recordType)
+	{
+	  case IMAGE_DESC_RECORD_TYPE:
+	    if (DGifGetImageDesc(file) != GIF_OK
+	      || DGifGetCode(file, &codeSize, &code) != GIF_OK)
+	      return NO;
+	    while (code != NULL)
+	      {
+		if (DGifGetCodeNext(file, &code) != GIF_OK)
+		  return NO;
+	      }
+	    [delays appendBytes: &delay length: sizeof(delay)];
+	    delay = 0;
+	    frameCount++;
+	    break;
+
+	  case EXTENSION_RECORD_TYPE:
+	    if (DGifGetExtension(file, &extCode, &extension) != GIF_OK)
+	      return NO;
+	    if (extCode == GRAPHICS_EXT_FUNC_CODE && extension != NULL
+	      && extension[0] >= 4)
+	      {
+		if (extension[1] & 0x01)
+		  hasAlpha = YES;
+		delay = (extension[3] << 8) + extension[2];
+	      }
+	    else if (extCode == APPLICATION_EXT_FUNC_CODE && extension != NULL
+	      && extension[0] >= 11
+	      && memcmp(extension + 1, "NETSCAPE2.0", 11) == 0)
+	      {
+		if (DGifGetExtensionNext(file, &extension) != GIF_OK)
+		  return NO;
+		if (extension != NULL && extension[0] >= 3 && extension[1] == 1)
+		  loopCount = extension[2] + (extension[3] << 8);
+	      }
+	    if (!skipExtension(file, extension))
+	      return NO;
+	    break;
+
+	  default:
+	    break;
+	}
+    } while (recordType != TERMINATE_RECORD_TYPE);
+  return YES;
+}
+
+- (BOOL) _rewind
+{
+  int i;
+
+  if (file != NULL)
+    DGifCloseFile(file);
+  file = gs_gif_open(&src);
+  if (file == NULL)
+    return NO;
+  for (i = 0; i < width * height; i++)
+    memcpy(canvas + 4 * i, background, 4);
+  disposal = 0;
+  next = 0;
+  return YES;
+}
+
+- (id) initWithData: (NSData *)imageData
+{
+  NSUInteger frameBytes;
+  ColorMapObject *colorMap;
+
+  if ((self = [super init]) == nil)
+    return nil;
+
+  data = RETAIN(imageData);
+  gs_gif_init_input_source(&src, data);
+  file = gs_gif_open(&src);
+  delays = [NSMutableData new];
+  if (file == NULL || ![self _scan] || frameCount < 2
+    || file->SWidth <= 0 || file->SHeight <= 0)
+    {
+      RELEASE(self);
+      return nil;
+    }
+
+  width = file->SWidth;
+  height = file->SHeight;
+  sPP = hasAlpha ? 4 : 3;
+  colorMap = file->SColorMap;
+  if (hasAlpha)
+    memset(background, 0, 4);
+  else if (colorMap != NULL && file->SBackGroundColor < colorMap->ColorCount)
+    {
+      background[0] = colorMap->Colors[file->SBackGroundColor].Red;
+      background[1] = colorMap->Colors[file->SBackGroundColor].Green;
+      background[2] = colorMap->Colors[file->SBackGroundColor].Blue;
+      background[3] = 255;
+    }
+  else
+    {
+      memset(background, 0, 3);
+      background[3] = 255;
+    }
+
+  canvas = malloc(4 * width * height);
+  if (canvas == NULL || ![self _rewind])
+    {
+      RELEASE(self);
+      return nil;
+    }
+
+  frameBytes = width * height * sPP;
+  capacity = (frameCount * frameBytes <= GIF_FRAME_BUDGET)
+    ? frameCount : GIF_FRAME_RING;
+  frames = [[NSMutableDictionary alloc] initWithCapacity: capacity];
+  order = [[NSMutableArray alloc] initWithCapacity: capacity];
+  return self;
+}
+
+- (void) dealloc
+{
+  if (file != NULL)
+    DGifCloseFile(file);
+  free(canvas);
+  free(saved);
+  RELEASE(data);
+  RELEASE(delays);
+  RELEASE(frames);
+  RELEASE(order);
+  [super dealloc];
+}
+
+/* Composites the next frame of the file onto the canvas and returns a
+   copy of the canvas with sPP samples per pixel. */
+- (NSData *) _decodeNextFrame
+{
+  GifRecordType recordType;
+  GifByteType *extension;
+  GifPixelType *line;
+  ColorMapObject *colorMap;
+  NSMutableData *frame;
+  unsigned char *dst;
+  int extCode, frameDisposal = 0, transparent = -1;
+  int x, y, i, pass;
+
+  /* Undo the last frame as its disposal method asks. */
+  if (disposal == 2)
+    {
+      for (y = top; y < bottom; y++)
+	for (x = left; x < right; x++)
+	  memcpy(canvas + 4 * (y * width + x), background, 4);
+    }
+  else if (disposal == 3 && saved != NULL)
+    {
+      memcpy(canvas, saved, 4 * width * height);
+    }
+
+  do
+    {
+      if (DGifGetRecordType(file, &recordType) != GIF_OK)
+	return nil;
+      if (recordType == EXTENSION_RECORD_TYPE)
+	{
+	  if (DGifGetExtension(file, &extCode, &extension) != GIF_OK)
+	    return nil;
+	  if (extCode == GRAPHICS_EXT_FUNC_CODE && extension != NULL
+	    && extension[0] >= 4)
+	    {
+	      frameDisposal = (extension[1] >> 2) & 0x07;
+	      transparent = (extension[1] & 0x01) ? extension[4] : -1;
+	    }
+	  if (!skipExtension(file, extension))
+	    return nil;
+	}
+      else if (recordType == TERMINATE_RECORD_TYPE)
+	{
+	  return nil;
+	}
+    } while (recordType != IMAGE_DESC_RECORD_TYPE);
+
+  if (DGifGetImageDesc(file) != GIF_OK
+    || file->Image.Left + file->Image.Width > width
+    || file->Image.Top + file->Image.Height > height)
+    return nil;
+
+  colorMap = (file->Image.ColorMap ? file->Image.ColorMap : file->SColorMap);
+  if (colorMap == NULL)
+    return nil;
+  if (frameDisposal == 3)
+    {
+      if (saved == NULL)
+	saved = malloc(4 * width * height);
+      if (saved != NULL)
+	memcpy(saved, canvas, 4 * width * height);
+    }
+  left = file->Image.Left;
+  top = file->Image.Top;
+  right = left + file->Image.Width;
+  bottom = top + file->Image.Height;
+  disposal = frameDisposal;
+
+  line = malloc(file->Image.Width * sizeof(GifPixelType));
+  if (line == NULL)
+    return nil;
+  /* Interlaced images have their rows in four passes. */
+  for (pass = (file->Image.Interlace ? 0 : 3); pass < 4; pass++)
+    {
+      int start = file->Image.Interlace ? InterlaceOffset[pass] : 0;
+      int step = file->Image.Interlace ? InterlaceJumps[pass] : 1;
+
+      for (y = start; y < file->Image.Height; y += step)
+	{
+	  if (DGifGetLine(file, line, file->Image.Width) != GIF_OK)
+	    {
+	      free(line);
+	      return nil;
+	    }
+	  dst = canvas + 4 * ((top + y) * width + left);
+	  for (x = 0; x < file->Image.Width; x++, dst += 4)
+	    {
+	      if (line[x] == transparent || line[x] >= colorMap->ColorCount)
+		continue;
+	      dst[0] = colorMap->Colors[line[x]].Red;
+	      dst[1] = colorMap->Colors[line[x]].Green;
+	      dst[2] = colorMap->Colors[line[x]].Blue;
+	      dst[3] = 255;
+	    }
+	}
+    }
+  free(line);
+  next++;
+
+  frame = [NSMutableData dataWithLength: width * height * sPP];
+  dst = [frame mutableBytes];
+  if (sPP == 4)
+    {
+      memcpy(dst, canvas, 4 * width * height);
+    }
+  else
+    {
+      for (i = 0; i < width * height; i++, dst += 3)
+	memcpy(dst, canvas + 4 * i, 3);
+    }
+  return frame;
+}
+
+- (void) _keepFrame: (NSData *)frame number: (int)n
+{
+  NSNumber *key = [NSNumber numberWithInt: n];
+
+  [frames setObject: frame forKey: key];
+  [order removeObject: key];
+  [order addObject: key];
+  while ([order count] > capacity)
+    {
+      [frames removeObjectForKey: [order objectAtIndex: 0]];
+      [order removeObjectAtIndex: 0];
+    }
+}
+
+- (NSData *) frame: (int)n
+{
+  NSNumber *key = [NSNumber numberWithInt: n];
+  NSData *frame = [frames objectForKey: key];
+
+  if (frame != nil)
+    {
+      RETAIN(frame);
+      [order removeObject: key];
+      [order addObject: key];
+      return AUTORELEASE(frame);
+    }
+  if (n < next && ![self _rewind])
+    return nil;
+  while (next <= n)
+    {
+      int number = next;
+
+      frame = [self _decodeNextFrame];
+      if (frame == nil)
+	return nil;
+      [self _keepFrame: frame number: number];
+    }
+  return frame;
+}
+
+- (float) durationOfFrame: (int)n
+{
+  return ((unsigned short *)[delays bytes])[n] / 100.0;
+}
+
+@end
+
 /* -----------------------------------------------------------
    The gif loading part of NSBitmapImageRep
    ----------------------------------------------------------- */
@@ -193,6 +562,70 @@ static int gs_gif_output(GifFileType *file, const GifByteType *buffer, int len)
        GIF_CREATE_ERROR(msg);\
      }
 
+/* Initializes the receiver with the first frame of an animation. */
+- (id) _initBitmapFromGIFAnimation: (GSGIFFrameDecoder *)decoder
+{
+  NSData *frame = [decoder frame: 0];
+  unsigned char *buf;
+
+  if (frame == nil)
+    {
+      return nil;
+    }
+  buf = (unsigned char *)[frame bytes];
+  [self initWithBitmapDataPlanes: &buf
+	pixelsWide: decoder->width
+	pixelsHigh: decoder->height
+	bitsPerSample: 8
+	samplesPerPixel: decoder->sPP
+	hasAlpha: decoder->hasAlpha
+	isPlanar: NO
+	colorSpaceName: NSCalibratedRGBColorSpace
+	bytesPerRow: decoder->width * decoder->sPP
+	bitsPerPixel: 8 * decoder->sPP];
+  _imageData = RETAIN(frame);
+
+  if (decoder->file->SColorMap != NULL)
+    {
+      [self setProperty: NSImageRGBColorTable
+	      withValue: [NSData dataWithBytes: decoder->file->SColorMap->Colors
+		length: sizeof(GifColorType)
+			* decoder->file->SColorMap->ColorCount]];
+    }
+  [self setProperty: NSImageFrameCount
+	  withValue: [NSNumber numberWithInt: decoder->frameCount]];
+  [self setProperty: NSImageLoopCount
+	  withValue: [NSNumber numberWithInt: decoder->loopCount]];
+  [self setProperty: NSImageCurrentFrameDuration
+	  withValue: [NSNumber numberWithFloat:
+			[decoder durationOfFrame: 0]]];
+  [self setProperty: NSImageCurrentFrame
+	  withValue: [NSNumber numberWithInt: 0]];
+  _frameDecoder = RETAIN(decoder);
+  return self;
+}
+
+- (BOOL) _setGIFFrame: (int)n
+{
+  GSGIFFrameDecoder *decoder = _frameDecoder;
+  NSData *frame;
+
+  if (n < 0 || n >= decoder->frameCount)
+    {
+      return NO;
+    }
+  frame = [decoder frame: n];
+  if (frame == nil)
+    {
+      return NO;
+    }
+  ASSIGN(_imageData, frame);
+  _imagePlanes[0] = (unsigned char *)[frame bytes];
+  [self setProperty: NSImageCurrentFrameDuration
+	  withValue: [NSNumber numberWithFloat: [decoder durationOfFrame: n]]];
+  return YES;
+}
+
 /* Read a gif image. Assume it is from a gif file. */
 - (id) _initBitmapFromGIF: (NSData *)imageData
 	     errorMessage: (NSString **)errorMsg
@@ -218,6 +651,21 @@ static int gs_gif_output(GifFileType *file, const GifByteType *buffer, int len)
   unsigned char           transparentColor = 0;
   int                     sPP = 3;	/* samples per pixel */
   unsigned short          duration = 0;
+  GSGIFFrameDecoder      *decoder;
+
+  /* Animations are decoded a frame at a time, as the current frame is
+     set. */
+  decoder = [[GSGIFFrameDecoder alloc] initWithData: imageData];
+  if (decoder != nil)
+    {
+      id result = [self _initBitmapFromGIFAnimation: decoder];
+
+      RELEASE(decoder);
+      if (result != nil)
+	{
+	  return result;
+	}
+    }
 
   /* open the image */
   gs_gif_init_input_source(&src, imageData);
@@ -377,7 +825,7 @@ static int gs_gif_output(GifFileType *file, const GifByteType *buffer, int len)
   if (duration > 0)
     {
       [self setProperty: NSImageCurrentFrameDuration
-              withValue: [NSNumber numberWithFloat: (100.0 * duration)]];
+              withValue: [NSNumber numberWithFloat: (duration / 100.0)]];
     }
   [self setProperty: NSImageCurrentFrame
           withValue: [NSNumber numberWithInt: 0]];
@@ -568,6 +1016,11 @@ static int gs_gif_output(GifFileType *file, const GifByteType *buffer, int len)
   return nil;
 }
 
+- (BOOL) _setGIFFrame: (int)n
+{
+  return NO;
+}
+
 - (NSData *) _GIFRepresentationWithProperties: (NSDictionary *) properties
                                  errorMessage: (NSString **)errorMsg
 {
@@ -36,6 +36,7 @@
 + (BOOL) _bitmapIsICNS: (NSData *)imageData;
 + (NSArray*) _imageRepsWithICNSData: (NSData *)imageData;
 - (id) _initBitmapFromICNS: (NSData *)imageData;
+- (void) _decodeICNSElement;
 // - (NSData *) _ICNSRepresentationWithProperties: (NSDictionary *) properties;
 @end
 
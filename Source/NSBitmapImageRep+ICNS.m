@@ -455,6 +455,52 @@ typedef struct pixel_t
   uint8_t a;
 } pixel_t;
 
+/* Copies the pixels of iconImage to rgbBuffer as 8-bit RGBA. */
+static void
+icns_copy_pixels(icns_image_t *iconImage, unsigned char *rgbBuffer)
+{
+  unsigned int iconWidth = iconImage->imageWidth;
+  unsigned int iconHeight = iconImage->imageHeight;
+  int imageChannels = iconImage->imageChannels;
+  unsigned int rgbBufferPos = 0;
+  int i, j;
+
+  for (i = 0; i < iconHeight; i++)
+    {
+      for (j = 0; j < iconWidth; j++)
+        {
+          pixel_t *src_rgb_pixel;
+	  
+          src_rgb_pixel = (pixel_t *)&(iconImage->imageData[i*iconWidth*imageChannels+j*imageChannels]);
+          
+          rgbBuffer[rgbBufferPos++] = src_rgb_pixel->r;
+          rgbBuffer[rgbBufferPos++] = src_rgb_pixel->g;
+          rgbBuffer[rgbBufferPos++] = src_rgb_pixel->b;
+          rgbBuffer[rgbBufferPos++] = src_rgb_pixel->a;
+        }
+    }
+}
+
+/* Returns YES if elements of type hold a colour image of a known size,
+   which is returned in width and height. */
+static BOOL
+icns_is_image_type(icns_type_t type, unsigned int *width,
+                   unsigned int *height)
+{
+  icns_icon_info_t info = icns_get_image_info_for_type(type);
+
+#if HAVE_LIBICNS
+  if (!info.isImage)
+    return NO;
+#else
+  if (info.iconChannels == 0)
+    return NO;
+#endif
+  *width = info.iconWidth;
+  *height = info.iconHeight;
+  return (*width > 0 && *height > 0);
+}
+
 @implementation NSBitmapImageRep (ICNS)
 
 + (BOOL) _bitmapIsICNS: (NSData *)imageData
@@ -485,11 +531,8 @@ typedef struct pixel_t
 - (id) _initBitmapFromICNSImage: (icns_image_t*)iconImage
 {
   unsigned int iconWidth = 0, iconHeight = 0;
-  unsigned int rgbBufferPos = 0;
   unsigned int rgbBufferSize = 0;
   unsigned char *rgbBuffer = NULL; /* image converted to rgb */
-  int i = 0, j = 0;
-  int imageChannels = 0;
   int sPP = 4;
 
   iconWidth = iconImage->imageWidth;
@@ -505,22 +548,7 @@ typedef struct pixel_t
       return nil;
     }
 
-  imageChannels = iconImage->imageChannels;
-  rgbBufferPos = 0;
-  for (i = 0; i < iconHeight; i++)
-    {
-      for (j = 0; j < iconWidth; j++)
-        {
-          pixel_t *src_rgb_pixel;
-	  
-          src_rgb_pixel = (pixel_t *)&(iconImage->imageData[i*iconWidth*imageChannels+j*imageChannels]);
-          
-          rgbBuffer[rgbBufferPos++] = src_rgb_pixel->r;
-          rgbBuffer[rgbBufferPos++] = src_rgb_pixel->g;
-          rgbBuffer[rgbBufferPos++] = src_rgb_pixel->b;
-          rgbBuffer[rgbBufferPos++] = src_rgb_pixel->a;
-        }
-    }
+  icns_copy_pixels(iconImage, rgbBuffer);
   
   /* initialize self */
   [self initWithBitmapDataPlanes: &rgbBuffer
@@ -628,34 +656,39 @@ typedef struct pixel_t
   dataOffset = sizeof(icns_type_t) + sizeof(icns_size_t);
   data = (icns_byte_t *)iconFamily;
 
-  // read each icon...
+  /* Make an image rep for each icon, but read its pixels only when they
+     are used. Usually only the icon drawn is ever read. */
   while (((dataOffset + 8) < iconFamily->resourceSize))
     {
       icns_element_t element;
       icns_type_t typeStr = ICNS_NULL_TYPE;
-      icns_image_t iconImage;
+      unsigned int width, height;
       
       memcpy(&element, (data + dataOffset), 8);
       memcpy(&typeStr, &(element.elementType), 4);
 
-      // extract the image...
-      memset(&iconImage, 0, sizeof(icns_image_t));
-      error = icns_get_image32_with_mask_from_family(iconFamily,
-                                                     typeStr,
-                                                     &iconImage);
-      //NSLog(@"Read image %c %c %c %c result %d size %d", typeStr.c[0], typeStr.c[1], typeStr.c[2], typeStr.c[3], error, element.elementSize);
-      if (!error)
+      if (icns_is_image_type(typeStr, &width, &height))
         {
           NSBitmapImageRep* imageRep;
 
-          imageRep = [[self alloc] _initBitmapFromICNSImage: &iconImage];
+          imageRep = [[self alloc] initWithBitmapDataPlanes: NULL
+                                                 pixelsWide: width
+                                                 pixelsHigh: height
+                                              bitsPerSample: 8
+                                            samplesPerPixel: 4
+                                                   hasAlpha: YES
+                                                   isPlanar: NO
+                                             colorSpaceName: NSCalibratedRGBColorSpace
+                                               bitmapFormat: NSAlphaNonpremultipliedBitmapFormat
+                                                bytesPerRow: width * 4
+                                               bitsPerPixel: 32];
           if (imageRep)
             {
+              imageRep->_undecodedData = RETAIN(imageData);
+              memcpy(&imageRep->_undecodedImage, &typeStr, 4);
               [array addObject: imageRep];
               RELEASE(imageRep);
             }
-          
-          icns_free_image(&iconImage);
         }
 
       // next...
@@ -667,4 +700,44 @@ typedef struct pixel_t
   return array;
 }
 
+/* Reads the pixels of the icon whose decoding was put off by
+   +_imageRepsWithICNSData:. */
+- (void) _decodeICNSElement
+{
+  NSData *imageData = _undecodedData;
+  icns_family_t *iconFamily = NULL;
+  icns_type_t typeStr;
+  icns_image_t iconImage;
+  NSInteger error;
+
+  _undecodedData = nil;
+  memcpy(&typeStr, &_undecodedImage, 4);
+  memset(&iconImage, 0, sizeof(icns_image_t));
+  error = icns_import_family_data([imageData length],
+                                  (icns_byte_t *)[imageData bytes],
+                                  &iconFamily);
+  if (error == ICNS_STATUS_OK)
+    {
+      error = icns_get_image32_with_mask_from_family(iconFamily,
+                                                     typeStr,
+                                                     &iconImage);
+    }
+  if (error == ICNS_STATUS_OK
+      && iconImage.imageWidth == _pixelsWide
+      && iconImage.imageHeight == _pixelsHigh)
+    {
+      icns_copy_pixels(&iconImage, _imagePlanes[0]);
+    }
+  else
+    {
+      NSLog(@"Error while extracting image from ICNS data.");
+    }
+  if (error == ICNS_STATUS_OK)
+    {
+      icns_free_image(&iconImage);
+    }
+  free(iconFamily);
+  RELEASE(imageData);
+}
+
 @end
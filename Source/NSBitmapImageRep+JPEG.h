@@ -37,10 +37,19 @@
 + (BOOL) _bitmapIsJPEG: (NSData *)imageData;
 - (id) _initBitmapFromJPEG: (NSData *)imageData
 	      errorMessage: (NSString **)errorMsg;
+- (id) _initBitmapFromJPEG: (NSData *)imageData
+	      forPixelSize: (NSSize)pixelSize
+	      errorMessage: (NSString **)errorMsg;
 - (NSData *) _JPEGRepresentationWithProperties: (NSDictionary *) properties
                                   errorMessage: (NSString **)errorMsg;
 @end
 
+@interface NSBitmapImageRep (JPEGIncremental)
+/* Returns an object decoding a JPEG image into the receiver as data
+   arrives, or nil if JPEG images can't be read. */
+- (id) _incrementalJPEGLoader;
+@end
+
 #endif // _NSBitmapImageRep_JPEG_H_include
 
 
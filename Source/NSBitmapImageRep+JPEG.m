@@ -210,6 +210,129 @@ static void gs_jpeg_memory_src_destroy(j_decompress_ptr cinfo)
   cinfo->src = NULL;
 }
 
+/* ------------------------------------------------------------------*/
+
+/* A data source manager for incremental loading. It reads from data that
+ * grows between calls and suspends the library when it runs out of bytes,
+ * as described in libjpeg.txt. Before each call into the library the
+ * buffer is pointed at the bytes not yet consumed; afterwards the number
+ * of consumed bytes is taken back from it.  */
+typedef struct
+{
+  struct jpeg_source_mgr parent;
+
+  const unsigned char *data;
+  NSUInteger length;
+  NSUInteger consumed;	/* may be beyond length after a long skip */
+  NSUInteger skip;	/* bytes to skip that have not arrived yet */
+  BOOL complete;	/* no more data will arrive */
+  BOOL truncated;	/* the data ended before the image */
+} gs_jpeg_incremental_source_mgr;
+
+typedef gs_jpeg_incremental_source_mgr *gs_jpeg_incremental_source_ptr;
+
+
+static boolean gs_fill_incremental_buffer(j_decompress_ptr cinfo)
+{
+  static const JOCTET eoi[2] = { 0xFF, JPEG_EOI };
+  gs_jpeg_incremental_source_ptr src
+    = (gs_jpeg_incremental_source_ptr)cinfo->src;
+
+  if (!src->complete)
+    {
+      /* suspend until more data arrives */
+      return FALSE;
+    }
+
+  /* The data is truncated. Insert a fake end marker, so what arrived can
+     still be decoded. */
+  WARNMS(cinfo, JWRN_JPEG_EOF);
+  src->truncated = YES;
+  src->parent.next_input_byte = eoi;
+  src->parent.bytes_in_buffer = 2;
+  return TRUE;
+}
+
+
+static void gs_skip_incremental_data(j_decompress_ptr cinfo, long numBytes)
+{
+  gs_jpeg_incremental_source_ptr src
+    = (gs_jpeg_incremental_source_ptr)cinfo->src;
+
+  if (numBytes <= 0)
+    return;
+  if ((size_t)numBytes > src->parent.bytes_in_buffer)
+    {
+      src->skip += numBytes - src->parent.bytes_in_buffer;
+      src->parent.next_input_byte += src->parent.bytes_in_buffer;
+      src->parent.bytes_in_buffer = 0;
+    }
+  else
+    {
+      src->parent.next_input_byte += numBytes;
+      src->parent.bytes_in_buffer -= numBytes;
+    }
+}
+
+
+static void gs_jpeg_incremental_src_create(j_decompress_ptr cinfo)
+{
+  gs_jpeg_incremental_source_ptr src;
+
+  cinfo->src = (struct jpeg_source_mgr *)
+    calloc(1, sizeof(gs_jpeg_incremental_source_mgr));
+
+  src = (gs_jpeg_incremental_source_ptr) cinfo->src;
+  src->parent.init_source = gs_init_source;
+  src->parent.fill_input_buffer = gs_fill_incremental_buffer;
+  src->parent.skip_input_data = gs_skip_incremental_data;
+  src->parent.resync_to_restart = jpeg_resync_to_restart; /* use default */
+  src->parent.term_source = gs_term_source;
+}
+
+
+/* Points the source at the unconsumed part of data before the library
+ * is called.  */
+static void gs_jpeg_incremental_src_update(j_decompress_ptr cinfo,
+                                           NSData *data, BOOL complete)
+{
+  gs_jpeg_incremental_source_ptr src
+    = (gs_jpeg_incremental_source_ptr)cinfo->src;
+
+  src->data = (const unsigned char *)[data bytes];
+  src->length = [data length];
+  src->complete = complete;
+  if (src->consumed > src->length)
+    {
+      src->skip = src->consumed - src->length;
+      src->consumed = src->length;
+    }
+  src->parent.next_input_byte = src->data + src->consumed;
+  src->parent.bytes_in_buffer = src->length - src->consumed;
+}
+
+
+/* Remembers how much of the data the library consumed after a call.  */
+static void gs_jpeg_incremental_src_suspend(j_decompress_ptr cinfo)
+{
+  gs_jpeg_incremental_source_ptr src
+    = (gs_jpeg_incremental_source_ptr)cinfo->src;
+
+  if (src->parent.next_input_byte >= src->data
+    && src->parent.next_input_byte <= src->data + src->length)
+    {
+      src->consumed = src->parent.next_input_byte - src->data;
+    }
+  else
+    {
+      /* reading the fake end marker */
+      src->consumed = src->length;
+    }
+  src->consumed += src->skip;
+  src->skip = 0;
+}
+
+
 /* ------------------------------------------------------------------*/
 
 /*
@@ -391,6 +514,21 @@ static void gs_jpeg_memory_dest_destroy (j_compress_ptr cinfo)
  */
 - (id) _initBitmapFromJPEG: (NSData *)imageData
 	      errorMessage: (NSString **)errorMsg
+{
+  return [self _initBitmapFromJPEG: imageData
+		      forPixelSize: NSZeroSize
+		      errorMessage: errorMsg];
+}
+
+
+/* Read the jpeg image like -_initBitmapFromJPEG:errorMessage:. If
+ * pixelSize is not zero, the image is scaled down by a power of two while
+ * decoding, as far as it stays at least pixelSize wide and high. libjpeg
+ * then skips most of the inverse DCT work for the pixels dropped.
+ */
+- (id) _initBitmapFromJPEG: (NSData *)imageData
+	      forPixelSize: (NSSize)pixelSize
+	      errorMessage: (NSString **)errorMsg
 {
   struct jpeg_decompress_struct  cinfo;
   struct gs_jpeg_error_mgr  jerrMgr;
@@ -438,6 +576,20 @@ static void gs_jpeg_memory_dest_destroy (j_compress_ptr cinfo)
   /* we use RGB as target color space; others are not yet supported */
   cinfo.out_color_space = JCS_RGB;
 
+  if (pixelSize.width > 0 && pixelSize.height > 0)
+    {
+      unsigned int denom = 8;
+
+      while (denom > 1
+        && ((cinfo.image_width + denom - 1) / denom < pixelSize.width
+          || (cinfo.image_height + denom - 1) / denom < pixelSize.height))
+        {
+          denom /= 2;
+        }
+      cinfo.scale_num = 1;
+      cinfo.scale_denom = denom;
+    }
+
   /* decompress */
   jpeg_start_decompress(&cinfo);
 
@@ -674,6 +826,198 @@ static void gs_jpeg_memory_dest_destroy (j_compress_ptr cinfo)
 
 @end
 
+/* -----------------------------------------------------------
+   Incremental jpeg loading
+   ----------------------------------------------------------- */
+
+@implementation NSBitmapImageRep (JPEGIncrementalSetUp)
+
+/* Makes the receiver a bitmap for the output of cinfo, which must have
+ * started decompressing, and returns its image buffer.  */
+- (unsigned char *) _setUpBitmapForJPEG: (j_decompress_ptr)cinfo
+{
+  JDIMENSION rowSize = cinfo->output_width * cinfo->output_components;
+  unsigned char *imgbuffer;
+  BOOL isProgressive;
+
+  imgbuffer = NSZoneMalloc([self zone], cinfo->output_height * rowSize);
+  if (!imgbuffer)
+    {
+      NSLog(@"NSBitmapImageRep+JPEG: failed to allocated image buffer");
+      return NULL;
+    }
+  /* Rows that haven't arrived yet are drawn white. */
+  memset(imgbuffer, 0xff, cinfo->output_height * rowSize);
+
+  [self initWithBitmapDataPlanes: &imgbuffer
+		      pixelsWide: cinfo->output_width
+		      pixelsHigh: cinfo->output_height
+		   bitsPerSample: BITS_IN_JSAMPLE
+		 samplesPerPixel: cinfo->output_components
+			hasAlpha: (cinfo->output_components == 3 ? NO : YES)
+			isPlanar: NO
+		  colorSpaceName: NSCalibratedRGBColorSpace
+		     bytesPerRow: rowSize
+		    bitsPerPixel: BITS_IN_JSAMPLE * cinfo->output_components];
+
+#ifdef GSTEP_PROGRESSIVE_CODEC
+  isProgressive = (cinfo->process == JPROC_PROGRESSIVE);
+#else
+  isProgressive = cinfo->progressive_mode;
+#endif
+  [self setProperty: NSImageProgressive
+          withValue: [NSNumber numberWithBool: isProgressive]];
+
+  _imageData = [[NSData alloc]
+    initWithBytesNoCopy: imgbuffer
+		 length: (rowSize * cinfo->output_height)];
+
+  return imgbuffer;
+}
+
+@end
+
+/* Decodes a JPEG image into an image rep as the bytes of the file
+ * arrive, using a suspending data source. Progressive images are
+ * decoded once all their scans have arrived.  */
+@interface GSJPEGIncrementalLoader : NSObject
+{
+  NSBitmapImageRep *rep;	/* Not retained; it owns the loader. */
+  struct jpeg_decompress_struct cinfo;
+  struct gs_jpeg_error_mgr jerrMgr;
+  unsigned char *imgbuffer;
+  JDIMENSION rowSize;
+  int state;
+}
+- (id) initWithImageRep: (NSBitmapImageRep *)aRep;
+- (NSInteger) loadFromData: (NSData *)data complete: (BOOL)complete;
+@end
+
+enum {
+  GSJPEGReadingHeader,
+  GSJPEGStarting,
+  GSJPEGReadingScanlines,
+  GSJPEGFinishing,
+  GSJPEGDone,
+  GSJPEGFailed
+};
+
+@implementation GSJPEGIncrementalLoader
+
+- (id) initWithImageRep: (NSBitmapImageRep *)aRep
+{
+  if (!(self = [super init]))
+    return nil;
+
+  rep = aRep;
+  gs_jpeg_error_mgr_init(&jerrMgr);
+  cinfo.err = jpeg_std_error(&jerrMgr.parent);
+  jerrMgr.parent.error_exit = gs_jpeg_error_exit;
+  jerrMgr.parent.output_message = gs_jpeg_output_message;
+  jpeg_create_decompress(&cinfo);
+  gs_jpeg_incremental_src_create(&cinfo);
+  state = GSJPEGReadingHeader;
+  return self;
+}
+
+- (void) dealloc
+{
+  free(cinfo.src);
+  cinfo.src = NULL;
+  jpeg_destroy_decompress(&cinfo);
+  [super dealloc];
+}
+
+- (NSInteger) loadFromData: (NSData *)data complete: (BOOL)complete
+{
+  if (state == GSJPEGFailed)
+    return NSImageRepLoadStatusInvalidData;
+
+  if (setjmp(jerrMgr.setjmpBuffer))
+    {
+      state = GSJPEGFailed;
+      return NSImageRepLoadStatusInvalidData;
+    }
+
+  gs_jpeg_incremental_src_update(&cinfo, data, complete);
+
+  if (state == GSJPEGReadingHeader)
+    {
+      if (jpeg_read_header(&cinfo, TRUE) == JPEG_SUSPENDED)
+        {
+          gs_jpeg_incremental_src_suspend(&cinfo);
+          return (complete ? NSImageRepLoadStatusUnexpectedEOF
+            : NSImageRepLoadStatusReadingHeader);
+        }
+      /* we use RGB as target color space; others are not yet supported */
+      cinfo.out_color_space = JCS_RGB;
+      state = GSJPEGStarting;
+    }
+
+  if (state == GSJPEGStarting)
+    {
+      if (!jpeg_start_decompress(&cinfo))
+        {
+          gs_jpeg_incremental_src_suspend(&cinfo);
+          return (complete ? NSImageRepLoadStatusUnexpectedEOF
+            : NSImageRepLoadStatusReadingHeader);
+        }
+
+      imgbuffer = [rep _setUpBitmapForJPEG: &cinfo];
+      if (!imgbuffer)
+        {
+          state = GSJPEGFailed;
+          return NSImageRepLoadStatusInvalidData;
+        }
+      rowSize = cinfo.output_width * cinfo.output_components;
+      state = GSJPEGReadingScanlines;
+    }
+
+  if (state == GSJPEGReadingScanlines)
+    {
+      while (cinfo.output_scanline < cinfo.output_height)
+        {
+          JSAMPROW row = imgbuffer + cinfo.output_scanline * rowSize;
+
+          if (jpeg_read_scanlines(&cinfo, &row, 1) == 0)
+            {
+              gs_jpeg_incremental_src_suspend(&cinfo);
+              return cinfo.output_scanline;
+            }
+        }
+      state = GSJPEGFinishing;
+    }
+
+  if (state == GSJPEGFinishing)
+    {
+      if (!jpeg_finish_decompress(&cinfo))
+        {
+          gs_jpeg_incremental_src_suspend(&cinfo);
+          return (complete ? NSImageRepLoadStatusUnexpectedEOF
+            : (NSInteger)cinfo.output_height);
+        }
+      gs_jpeg_incremental_src_suspend(&cinfo);
+      state = GSJPEGDone;
+    }
+
+  if (((gs_jpeg_incremental_source_ptr)cinfo.src)->truncated)
+    {
+      return NSImageRepLoadStatusUnexpectedEOF;
+    }
+  return NSImageRepLoadStatusCompleted;
+}
+
+@end
+
+@implementation NSBitmapImageRep (JPEGIncremental)
+
+- (id) _incrementalJPEGLoader
+{
+  return AUTORELEASE([[GSJPEGIncrementalLoader alloc] initWithImageRep: self]);
+}
+
+@end
+
 #else /* !HAVE_LIBJPEG */
 
 @implementation NSBitmapImageRep (JPEGReading)
@@ -688,6 +1032,13 @@ static void gs_jpeg_memory_dest_destroy (j_compress_ptr cinfo)
   RELEASE(self);
   return nil;
 }
+- (id) _initBitmapFromJPEG: (NSData *)imageData
+	      forPixelSize: (NSSize)pixelSize
+	      errorMessage: (NSString **)errorMsg
+{
+  RELEASE(self);
+  return nil;
+}
 - (NSData *) _JPEGRepresentationWithProperties: (NSDictionary *) properties
                                   errorMessage: (NSString **)errorMsg
 {
@@ -695,5 +1046,12 @@ static void gs_jpeg_memory_dest_destroy (j_compress_ptr cinfo)
 }
 @end
 
+@implementation NSBitmapImageRep (JPEGIncremental)
+- (id) _incrementalJPEGLoader
+{
+  return nil;
+}
+@end
+
 #endif /* !HAVE_LIBJPEG */
 
@@ -32,10 +32,21 @@
 
 #import "AppKit/NSBitmapImageRep.h"
 
+/* Property holding the tEXt chunks of a PNG image as a dictionary of
+   keyword and text strings. It is set when an image is read and written
+   by -_PNGRepresentationWithProperties:. */
+#define GSImagePNGText @"GSImagePNGText"
+
 @interface NSBitmapImageRep (PNG)
 + (BOOL) _bitmapIsPNG: (NSData *)imageData;
 - (id) _initBitmapFromPNG: (NSData *)imageData;
 - (NSData *) _PNGRepresentationWithProperties: (NSDictionary *) properties;
 @end
 
+@interface NSBitmapImageRep (PNGIncremental)
+/* Returns an object decoding a PNG image into the receiver as data
+   arrives, or nil if PNG images can't be read. */
+- (id) _incrementalPNGLoader;
+@end
+
 #endif
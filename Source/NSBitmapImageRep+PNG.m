@@ -46,13 +46,19 @@
 #  define PNG_gAMA 0
 #endif
 
+#if HAVE_LIBZ
+#include <zlib.h>
+#endif
+
 #endif /* HAVE_LIBPNG */
 
 /* we import all the standard headers to allow compilation without PNG */
 #import <Foundation/NSData.h>
 #import <Foundation/NSDictionary.h>
 #import <Foundation/NSException.h>
+#import <Foundation/NSLock.h>
 #import <Foundation/NSString.h>
+#import <Foundation/NSThread.h>
 #import <Foundation/NSValue.h>
 #import "AppKit/NSGraphics.h"
 #import "NSBitmapImageRep+PNG.h"
@@ -92,11 +98,15 @@ static void reader_func(png_structp png_struct, png_bytep data,
   r->offset += length;
 }
 
-- (id) _initBitmapFromPNG: (NSData *)imageData
+/* Sets up the transformations for the colour type of the image described
+   by png_info and makes the receiver a bitmap of that format, with a
+   buffer of its own for the image rows. Returns NO if the colour type is
+   not supported. */
+- (BOOL) _setUpBitmapForPNG: (png_structp)png_struct
+                       info: (png_infop)png_info
+                     buffer: (unsigned char **)buffer
+                bytesPerRow: (png_size_t *)rowBytes
 {
-  png_structp png_struct;
-  png_infop png_info, png_end_info;
-
   png_uint_32 width,height;
   unsigned char *buf;
   png_size_t bytes_per_row;
@@ -106,48 +116,6 @@ static void reader_func(png_structp png_struct, png_bytep data,
   int bpp;
   NSString *colorspace;
 
-  reader_struct_t reader;
-
-
-  if (!(self = [super init]))
-    return nil;
-
-  png_struct = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-  if (!png_struct)
-    {
-      RELEASE(self);
-      return nil;
-    }
-
-  png_info = png_create_info_struct(png_struct);
-  if (!png_info)
-    {
-      png_destroy_read_struct(&png_struct, NULL, NULL);
-      RELEASE(self);
-      return nil;
-    }
-
-  png_end_info = png_create_info_struct(png_struct);
-  if (!png_end_info)
-    {
-      png_destroy_read_struct(&png_struct, &png_info, NULL);
-      RELEASE(self);
-      return nil;
-    }
-
-  if (setjmp(png_jmpbuf(png_struct)))
-    {
-      png_destroy_read_struct(&png_struct, &png_info, &png_end_info);
-      RELEASE(self);
-      return nil;
-    }
-
-  reader.data = imageData;
-  reader.offset = 0;
-  png_set_read_fn(png_struct, &reader, reader_func);
-
-  png_read_info(png_struct, png_info);
-
   width = png_get_image_width(png_struct, png_info);
   height = png_get_image_height(png_struct, png_info);
   bytes_per_row = png_get_rowbytes(png_struct, png_info);
@@ -205,20 +173,11 @@ static void reader_func(png_structp png_struct, png_bytep data,
 
       default:
 	NSLog(@"NSBitmapImageRep+PNG: unknown color type %i", type);
-	RELEASE(self);
-	return nil;
+	return NO;
     }
 
   buf = NSZoneMalloc([self zone], bytes_per_row * height);
 
-  {
-    unsigned char *row_pointers[height];
-    int i;
-    for (i=0;i<height;i++)
-      row_pointers[i]=buf+i*bytes_per_row;
-    png_read_image(png_struct, row_pointers);
-  }
-
   [self initWithBitmapDataPlanes: &buf
         pixelsWide: width
         pixelsHigh: height
@@ -256,6 +215,30 @@ static void reader_func(png_structp png_struct, png_bytep data,
     //NSLog(@"PNG file gamma: %f", file_gamma);
    } 
 
+  {
+    png_textp text;
+    int num_text = 0;
+
+    if (png_get_text(png_struct, png_info, &text, &num_text) > 0)
+      {
+        NSMutableDictionary *chunks = [NSMutableDictionary dictionary];
+        int i;
+
+        for (i = 0; i < num_text; i++)
+          {
+            NSString *key, *value;
+
+            key = [NSString stringWithCString: text[i].key
+                                     encoding: NSISOLatin1StringEncoding];
+            value = [NSString stringWithCString: text[i].text
+                                       encoding: NSISOLatin1StringEncoding];
+            if (key != nil && value != nil)
+              [chunks setObject: value forKey: key];
+          }
+        [self setProperty: GSImagePNGText withValue: chunks];
+      }
+  }
+
   if (png_get_valid(png_struct, png_info, PNG_INFO_pHYs))
   {
     png_uint_32 xppm = png_get_x_pixels_per_meter(png_struct, png_info);
@@ -283,11 +266,233 @@ static void reader_func(png_structp png_struct, png_bytep data,
       }
   }
 
+  *buffer = buf;
+  *rowBytes = bytes_per_row;
+  return YES;
+}
+
+- (id) _initBitmapFromPNG: (NSData *)imageData
+{
+  png_structp png_struct;
+  png_infop png_info, png_end_info;
+  png_uint_32 height;
+  unsigned char *buf;
+  png_size_t bytes_per_row;
+
+  reader_struct_t reader;
+
+
+  if (!(self = [super init]))
+    return nil;
+
+  png_struct = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+  if (!png_struct)
+    {
+      RELEASE(self);
+      return nil;
+    }
+
+  png_info = png_create_info_struct(png_struct);
+  if (!png_info)
+    {
+      png_destroy_read_struct(&png_struct, NULL, NULL);
+      RELEASE(self);
+      return nil;
+    }
+
+  png_end_info = png_create_info_struct(png_struct);
+  if (!png_end_info)
+    {
+      png_destroy_read_struct(&png_struct, &png_info, NULL);
+      RELEASE(self);
+      return nil;
+    }
+
+  if (setjmp(png_jmpbuf(png_struct)))
+    {
+      png_destroy_read_struct(&png_struct, &png_info, &png_end_info);
+      RELEASE(self);
+      return nil;
+    }
+
+  reader.data = imageData;
+  reader.offset = 0;
+  png_set_read_fn(png_struct, &reader, reader_func);
+
+  png_read_info(png_struct, png_info);
+
+  if (![self _setUpBitmapForPNG: png_struct
+                           info: png_info
+                         buffer: &buf
+                    bytesPerRow: &bytes_per_row])
+    {
+      png_destroy_read_struct(&png_struct, &png_info, &png_end_info);
+      RELEASE(self);
+      return nil;
+    }
+
+  height = png_get_image_height(png_struct, png_info);
+  {
+    unsigned char *row_pointers[height];
+    int i;
+    for (i=0;i<height;i++)
+      row_pointers[i]=buf+i*bytes_per_row;
+    png_read_image(png_struct, row_pointers);
+  }
+
   png_destroy_read_struct(&png_struct, &png_info, &png_end_info);
 
   return self;
 }
 
+/***** Incremental PNG reading ******/
+
+/* Decodes a PNG image with the progressive reader of libpng, as the
+   bytes of the file arrive. */
+@interface GSPNGIncrementalLoader : NSObject
+{
+  NSBitmapImageRep *rep;	/* Not retained; it owns the loader. */
+  png_structp png_struct;
+  png_infop png_info;
+  NSUInteger offset;		/* Number of bytes given to libpng. */
+  unsigned char *buf;
+  png_size_t bytes_per_row;
+  NSInteger rows;		/* Number of rows decoded. */
+  BOOL haveHeader;
+  BOOL done;
+  BOOL failed;
+}
+- (id) initWithImageRep: (NSBitmapImageRep *)aRep;
+- (NSInteger) loadFromData: (NSData *)data complete: (BOOL)complete;
+- (void) _didReadInfo;
+- (void) _didReadRow: (png_bytep)new_row number: (png_uint_32)row_num;
+- (void) _didReadEnd;
+@end
+
+static void
+png_info_callback(png_structp png_struct, png_infop png_info)
+{
+  GSPNGIncrementalLoader *loader = png_get_progressive_ptr(png_struct);
+
+  [loader _didReadInfo];
+}
+
+static void
+png_row_callback(png_structp png_struct, png_bytep new_row,
+		 png_uint_32 row_num, int pass)
+{
+  GSPNGIncrementalLoader *loader = png_get_progressive_ptr(png_struct);
+
+  [loader _didReadRow: new_row number: row_num];
+}
+
+static void
+png_end_callback(png_structp png_struct, png_infop png_info)
+{
+  GSPNGIncrementalLoader *loader = png_get_progressive_ptr(png_struct);
+
+  [loader _didReadEnd];
+}
+
+@implementation GSPNGIncrementalLoader
+
+- (id) initWithImageRep: (NSBitmapImageRep *)aRep
+{
+  if (!(self = [super init]))
+    return nil;
+
+  rep = aRep;
+  png_struct = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+  if (png_struct)
+    png_info = png_create_info_struct(png_struct);
+  if (!png_struct || !png_info)
+    {
+      png_destroy_read_struct(&png_struct, NULL, NULL);
+      RELEASE(self);
+      return nil;
+    }
+  png_set_progressive_read_fn(png_struct, self, png_info_callback,
+                              png_row_callback, png_end_callback);
+  return self;
+}
+
+- (void) dealloc
+{
+  png_destroy_read_struct(&png_struct, &png_info, NULL);
+  [super dealloc];
+}
+
+- (void) _didReadInfo
+{
+  png_set_interlace_handling(png_struct);
+  if (![rep _setUpBitmapForPNG: png_struct
+                          info: png_info
+                        buffer: &buf
+                   bytesPerRow: &bytes_per_row])
+    {
+      png_error(png_struct, "unsupported color type");
+      return;
+    }
+  png_read_update_info(png_struct, png_info);
+  /* Rows that haven't arrived yet are drawn transparent. */
+  memset(buf, 0, bytes_per_row * png_get_image_height(png_struct, png_info));
+  haveHeader = YES;
+}
+
+- (void) _didReadRow: (png_bytep)new_row number: (png_uint_32)row_num
+{
+  if (new_row == NULL)
+    return;
+  png_progressive_combine_row(png_struct, buf + row_num * bytes_per_row,
+                              new_row);
+  if ((NSInteger)row_num >= rows)
+    rows = row_num + 1;
+}
+
+- (void) _didReadEnd
+{
+  done = YES;
+}
+
+- (NSInteger) loadFromData: (NSData *)data complete: (BOOL)complete
+{
+  NSUInteger length = [data length];
+
+  if (failed)
+    return NSImageRepLoadStatusInvalidData;
+
+  if (setjmp(png_jmpbuf(png_struct)))
+    {
+      failed = YES;
+      return NSImageRepLoadStatusInvalidData;
+    }
+  if (length > offset)
+    {
+      png_process_data(png_struct, png_info,
+                       (png_bytep)[data bytes] + offset, length - offset);
+      offset = length;
+    }
+
+  if (done)
+    return NSImageRepLoadStatusCompleted;
+  if (complete)
+    return NSImageRepLoadStatusUnexpectedEOF;
+  if (!haveHeader)
+    return NSImageRepLoadStatusReadingHeader;
+  return rows;
+}
+
+@end
+
+@implementation NSBitmapImageRep (PNGIncremental)
+
+- (id) _incrementalPNGLoader
+{
+  return AUTORELEASE([[GSPNGIncrementalLoader alloc] initWithImageRep: self]);
+}
+
+@end
+
 /***** PNG writing support ******/
 static void writer_func(png_structp png_struct, png_bytep data,
 			png_size_t length)
@@ -296,6 +501,242 @@ static void writer_func(png_structp png_struct, png_bytep data,
   [PNGRep appendBytes: data length: length];
 }
 
+#if HAVE_LIBZ
+
+/* Bands compressed on their own hold at least this many bytes. */
+#define PNG_MIN_BAND (128 * 1024)
+/* Each band is primed with this much of the data before it, so it
+   compresses about as well as a single stream. */
+#define PNG_WINDOW 32768
+
+static unsigned
+filter_cost(const unsigned char *row, NSUInteger length)
+{
+  unsigned cost = 0;
+  NSUInteger i;
+
+  for (i = 0; i < length; i++)
+    cost += (row[i] < 128) ? row[i] : 256 - row[i];
+  return cost;
+}
+
+static unsigned char
+paeth(unsigned char a, unsigned char b, unsigned char c)
+{
+  int p = a + b - c;
+  int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+
+  if (pa <= pb && pa <= pc)
+    return a;
+  return (pb <= pc) ? b : c;
+}
+
+/* Writes the filter type and the filtered bytes of row to out. */
+static void
+filter_row(int type, const unsigned char *row, const unsigned char *prev,
+           NSUInteger length, NSUInteger bpp, unsigned char *out)
+{
+  NSUInteger i;
+
+  *out++ = type;
+  for (i = 0; i < length; i++)
+    {
+      unsigned char a = (i >= bpp) ? row[i - bpp] : 0;
+      unsigned char b = (prev != NULL) ? prev[i] : 0;
+      unsigned char c = (prev != NULL && i >= bpp) ? prev[i - bpp] : 0;
+
+      switch (type)
+        {
+          case 1: out[i] = row[i] - a; break;
+          case 2: out[i] = row[i] - b; break;
+          case 3: out[i] = row[i] - ((a + b) >> 1); break;
+          case 4: out[i] = row[i] - paeth(a, b, c); break;
+          default: out[i] = row[i]; break;
+        }
+    }
+}
+
+/* Filters all rows into out, which has room for height * (length + 1)
+   bytes. With several allowed filters each row gets the one giving the
+   smallest sum of absolute differences, as libpng does. */
+static void
+filter_rows(const unsigned char *data, NSInteger height, NSInteger rowStride,
+            NSUInteger length, NSUInteger bpp, int filters,
+            unsigned char *out)
+{
+  static const int flags[5] = { PNG_FILTER_NONE, PNG_FILTER_SUB,
+    PNG_FILTER_UP, PNG_FILTER_AVG, PNG_FILTER_PAETH };
+  unsigned char *trial = malloc(length + 1);
+  NSInteger y;
+
+  for (y = 0; y < height; y++, out += length + 1)
+    {
+      const unsigned char *row = data + y * rowStride;
+      const unsigned char *prev = (y > 0) ? row - rowStride : NULL;
+      unsigned best = UINT_MAX;
+      int type;
+
+      for (type = 0; type < 5; type++)
+        {
+          unsigned cost;
+
+          if (!(filters & flags[type]))
+            continue;
+          if (trial == NULL || best == UINT_MAX)
+            {
+              filter_row(type, row, prev, length, bpp, out);
+              best = filter_cost(out + 1, length);
+              continue;
+            }
+          filter_row(type, row, prev, length, bpp, trial);
+          cost = filter_cost(trial + 1, length);
+          if (cost < best)
+            {
+              best = cost;
+              memcpy(out, trial, length + 1);
+            }
+        }
+    }
+  free(trial);
+}
+
+/*
+ * A part of the filtered image compressed on a thread of its own, as a
+ * raw deflate stream ending on a byte boundary, so the parts can simply
+ * be put one after the other.
+ */
+@interface GSPNGBand : NSObject
+{
+@public
+  const unsigned char *bytes;
+  NSUInteger length;
+  NSUInteger primed;		/* Bytes before bytes used as dictionary. */
+  int level;
+  BOOL last;
+  NSMutableData *output;
+  uLong adler;
+  BOOL ok;
+  NSCondition *done;
+  NSUInteger *pending;
+}
+- (void) compress;
+@end
+
+@implementation GSPNGBand
+
+- (void) dealloc
+{
+  RELEASE(output);
+  [super dealloc];
+}
+
+- (void) compress
+{
+  z_stream z;
+  NSUInteger size;
+
+  memset(&z, 0, sizeof(z));
+  adler = adler32(adler32(0L, Z_NULL, 0), bytes, length);
+  if (deflateInit2(&z, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    return;
+  if (primed > 0)
+    deflateSetDictionary(&z, bytes - primed, primed);
+
+  size = deflateBound(&z, length) + 16;
+  output = [[NSMutableData alloc] initWithLength: size];
+  z.next_in = (Bytef *)bytes;
+  z.avail_in = length;
+  z.next_out = [output mutableBytes];
+  z.avail_out = size;
+  ok = (deflate(&z, last ? Z_FINISH : Z_SYNC_FLUSH)
+        == (last ? Z_STREAM_END : Z_OK)) && z.avail_in == 0;
+  [output setLength: size - z.avail_out];
+  deflateEnd(&z);
+}
+
+- (void) run: (id)unused
+{
+  CREATE_AUTORELEASE_POOL(pool);
+
+  [self compress];
+  [done lock];
+  (*pending)--;
+  [done signal];
+  [done unlock];
+  DESTROY(pool);
+}
+
+@end
+
+/* Returns the zlib stream of the filtered image, with the bands
+   compressed on up to threads threads. */
+static NSData *
+parallel_deflate(const unsigned char *filtered, NSUInteger length,
+                 int level, NSUInteger threads)
+{
+  NSMutableArray *bands = [NSMutableArray array];
+  NSCondition *done = AUTORELEASE([NSCondition new]);
+  NSMutableData *stream;
+  NSUInteger count, bandSize, pending, i;
+  unsigned char header[2], trailer[4];
+  uLong adler;
+
+  if (level < 0 || level > 9)
+    level = (level < 0) ? 6 : 9;
+  count = MIN(threads, MAX(1, length / PNG_MIN_BAND));
+  bandSize = (length + count - 1) / count;
+  pending = count - 1;
+  for (i = 0; i < count; i++)
+    {
+      GSPNGBand *band = AUTORELEASE([GSPNGBand new]);
+      NSUInteger start = i * bandSize;
+
+      band->bytes = filtered + start;
+      band->length = MIN(bandSize, length - start);
+      band->primed = MIN(start, PNG_WINDOW);
+      band->level = level;
+      band->last = (i == count - 1);
+      band->done = done;
+      band->pending = &pending;
+      [bands addObject: band];
+      if (i > 0)
+        {
+          [NSThread detachNewThreadSelector: @selector(run:)
+                                   toTarget: band
+                                 withObject: nil];
+        }
+    }
+  [[bands objectAtIndex: 0] compress];
+  [done lock];
+  while (pending > 0)
+    [done wait];
+  [done unlock];
+
+  /* zlib header: deflate with a 32K window and the level hint. */
+  header[0] = 0x78;
+  header[1] = (level < 2) ? 0x01 : (level < 6) ? 0x5e
+    : (level == 6) ? 0x9c : 0xda;
+  stream = [NSMutableData dataWithBytes: header length: 2];
+  adler = adler32(0L, Z_NULL, 0);
+  for (i = 0; i < count; i++)
+    {
+      GSPNGBand *band = [bands objectAtIndex: i];
+
+      if (!band->ok)
+        return nil;
+      [stream appendData: band->output];
+      adler = adler32_combine(adler, band->adler, band->length);
+    }
+  trailer[0] = (adler >> 24) & 0xff;
+  trailer[1] = (adler >> 16) & 0xff;
+  trailer[2] = (adler >> 8) & 0xff;
+  trailer[3] = adler & 0xff;
+  [stream appendBytes: trailer length: 4];
+  return stream;
+}
+
+#endif /* HAVE_LIBZ */
+
 - (NSData *) _PNGRepresentationWithProperties: (NSDictionary *) properties
 {
   png_structp png_struct;
@@ -311,6 +752,10 @@ static void writer_func(png_structp png_struct, png_bytep data,
   int transforms = PNG_TRANSFORM_IDENTITY;	// no transformations
   NSNumber * gammaNumber = nil;
   double gamma = 0.0;
+  NSDictionary * textChunks;
+  NSNumber * levelNumber;
+  NSNumber * filterNumber;
+  NSData * idat = nil;	// already compressed image data, if any
   
   // FIXME: Need to convert to non-pre-multiplied format
   if ([self isPlanar])	// don't handle planar yet
@@ -335,6 +780,34 @@ static void writer_func(png_structp png_struct, png_bytep data,
       [colorspace isEqualToString: NSDeviceRGBColorSpace])
     type = PNG_COLOR_TYPE_RGB;
   if ([self hasAlpha]) type = type | PNG_COLOR_MASK_ALPHA;
+  levelNumber = [properties objectForKey: GSImagePNGCompressionLevel];
+  filterNumber = [properties objectForKey: GSImagePNGFilters];
+
+#if HAVE_LIBZ
+  if ([[properties objectForKey: GSImagePNGThreads] intValue] > 1
+      && interlace == PNG_INTERLACE_NONE && type >= 0)
+    {
+      NSUInteger channels = ((type & PNG_COLOR_MASK_COLOR) ? 3 : 1)
+        + ((type & PNG_COLOR_MASK_ALPHA) ? 1 : 0);
+      NSUInteger row_length = (width * channels * depth + 7) / 8;
+      NSUInteger length = height * (row_length + 1);
+      int filters = filterNumber ? [filterNumber intValue] : PNG_ALL_FILTERS;
+      unsigned char *filtered;
+
+      if (length >= 2 * PNG_MIN_BAND
+          && (filtered = malloc(length)) != NULL)
+        {
+          filter_rows([self bitmapData], height, bytes_per_row, row_length,
+                      MAX(1, channels * depth / 8),
+                      (filters & PNG_ALL_FILTERS) ? filters : PNG_ALL_FILTERS,
+                      filtered);
+          idat = parallel_deflate(filtered, length,
+            levelNumber ? [levelNumber intValue] : Z_DEFAULT_COMPRESSION,
+            [[properties objectForKey: GSImagePNGThreads] intValue]);
+          free(filtered);
+        }
+    }
+#endif
 
   // make the PNG structures
   // ignore errors until I write the handlers
@@ -367,6 +840,11 @@ static void writer_func(png_structp png_struct, png_bytep data,
   png_set_write_fn(png_struct, PNGRep, writer_func, NULL);
   png_set_IHDR(png_struct, png_info, (png_uint_32)width, (png_uint_32)height,
                (int)depth, type, interlace, PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
+  if (levelNumber)
+    png_set_compression_level(png_struct, [levelNumber intValue]);
+  if (filterNumber && ([filterNumber intValue] & PNG_ALL_FILTERS))
+    png_set_filter(png_struct, PNG_FILTER_TYPE_BASE,
+                   [filterNumber intValue] & PNG_ALL_FILTERS);
 
   if (gammaNumber)
   {
@@ -384,6 +862,52 @@ static void writer_func(png_structp png_struct, png_bytep data,
     }
    } 
 
+  textChunks = [properties objectForKey: GSImagePNGText];
+  if ([textChunks count] > 0)
+    {
+      NSEnumerator *e = [textChunks keyEnumerator];
+      png_textp text;
+      NSString *key;
+      int n = 0;
+
+      text = NSZoneCalloc(NSDefaultMallocZone(), [textChunks count],
+                          sizeof(png_text));
+      while ((key = [e nextObject]) != nil)
+        {
+          const char *k, *t;
+
+          k = [key cStringUsingEncoding: NSISOLatin1StringEncoding];
+          t = [[textChunks objectForKey: key]
+                cStringUsingEncoding: NSISOLatin1StringEncoding];
+          if (k == NULL || t == NULL || strlen(k) == 0 || strlen(k) > 79)
+            continue;
+          text[n].compression = PNG_TEXT_COMPRESSION_NONE;
+          text[n].key = (png_charp)k;
+          text[n].text = (png_charp)t;
+          n++;
+        }
+      /* libpng copies the strings. */
+      png_set_text(png_struct, png_info, text, n);
+      NSZoneFree(NSDefaultMallocZone(), text);
+    }
+
+  if (idat != nil)
+    {
+      const unsigned char *bytes = [idat bytes];
+      NSUInteger length = [idat length];
+      NSUInteger pos;
+
+      /* libpng writes the other chunks, the image data is ready. */
+      png_write_info(png_struct, png_info);
+      for (pos = 0; pos < length; pos += 1024 * 1024)
+        png_write_chunk(png_struct, (png_bytep)"IDAT",
+                        (png_bytep)bytes + pos,
+                        MIN(1024 * 1024, length - pos));
+      png_write_chunk(png_struct, (png_bytep)"IEND", NULL, 0);
+      png_destroy_write_struct(&png_struct, &png_info);
+      return PNGRep;
+    }
+
   // get rgb data and row pointers and
   // write PNG out to NSMutableData
   bitmapData = [self bitmapData];
@@ -421,5 +945,12 @@ static void writer_func(png_structp png_struct, png_bytep data,
 }
 @end
 
+@implementation NSBitmapImageRep (PNGIncremental)
+- (id) _incrementalPNGLoader
+{
+  return nil;
+}
+@end
+
 #endif /* !HAVE_LIBPNG */
 
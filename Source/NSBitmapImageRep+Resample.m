@@ -0,0 +1,339 @@
+/*
+   NSBitmapImageRep+Resample.m
+
+   Methods for resampling bitmaps to other sizes.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of the GNUstep GUI Library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; see the file COPYING.LIB.
+   If not, see <http://www.gnu.org/licenses/> or write to the 
+   Free Software Foundation, 51 Franklin Street, Fifth Floor, 
+   Boston, MA 02110-1301, USA.
+*/
+
+#import "config.h"
+#include <math.h>
+#import <Foundation/NSString.h>
+#import "AppKit/NSBitmapImageRep.h"
+#import "AppKit/NSGraphics.h"
+
+/* Weights are fixed point numbers with this many fraction bits. */
+#define WEIGHT_BITS 14
+
+/*
+ * The weights of the source pixels making up each pixel along one axis.
+ * Output pixel i is made of count[i] source pixels from start[i] on,
+ * with the weights at weights + i * size.
+ */
+typedef struct {
+  int *start;
+  int *count;
+  int *weights;
+  int size;
+} gs_resample_weights;
+
+static double
+box_filter(double x)
+{
+  return (x > -0.5 && x <= 0.5) ? 1.0 : 0.0;
+}
+
+static double
+triangle_filter(double x)
+{
+  x = fabs(x);
+  return (x < 1.0) ? 1.0 - x : 0.0;
+}
+
+static double
+sinc(double x)
+{
+  if (x == 0.0)
+    return 1.0;
+  x *= M_PI;
+  return sin(x) / x;
+}
+
+static double
+lanczos_filter(double x)
+{
+  return (x > -3.0 && x < 3.0) ? sinc(x) * sinc(x / 3.0) : 0.0;
+}
+
+static void
+free_weights(gs_resample_weights *w)
+{
+  free(w->start);
+  free(w->count);
+  free(w->weights);
+}
+
+/* Computes the weights for scaling inSize pixels to outSize pixels.
+   When shrinking, the filter is stretched to cover all source pixels.
+   Returns NO if out of memory. */
+static BOOL
+compute_weights(int inSize, int outSize, double (*filter)(double),
+		double support, gs_resample_weights *w)
+{
+  double scale = (double)inSize / outSize;
+  double fscale = MAX(scale, 1.0);
+  double radius = support * fscale;
+  double *k;
+  int x, i;
+
+  w->size = (int)ceil(radius) * 2 + 1;
+  w->start = malloc(outSize * sizeof(int));
+  w->count = malloc(outSize * sizeof(int));
+  w->weights = calloc(outSize * w->size, sizeof(int));
+  k = malloc(w->size * sizeof(double));
+  if (w->start == NULL || w->count == NULL || w->weights == NULL
+    || k == NULL)
+    {
+      free(k);
+      free_weights(w);
+      return NO;
+    }
+
+  for (x = 0; x < outSize; x++)
+    {
+      double center = (x + 0.5) * scale;
+      double total = 0.0;
+      int xmin = MAX(0, (int)(center - radius + 0.5));
+      int xmax = MIN(inSize, (int)(center + radius + 0.5));
+      int n;
+
+      if (xmax - xmin > w->size)
+	xmax = xmin + w->size;
+      if (xmax <= xmin)
+	{
+	  xmax = MIN(inSize, xmin + 1);
+	  xmin = xmax - 1;
+	}
+      n = xmax - xmin;
+      for (i = 0; i < n; i++)
+	{
+	  k[i] = filter((xmin + i + 0.5 - center) / fscale);
+	  total += k[i];
+	}
+      if (total == 0.0)
+	{
+	  /* The filter fell between the pixels; take the nearest. */
+	  for (i = 0; i < n; i++)
+	    k[i] = 0.0;
+	  k[MIN(n - 1, MAX(0, (int)center - xmin))] = 1.0;
+	  total = 1.0;
+	}
+      for (i = 0; i < n; i++)
+	w->weights[x * w->size + i]
+	  = (int)floor(k[i] / total * (1 << WEIGHT_BITS) + 0.5);
+      w->start[x] = xmin;
+      w->count[x] = n;
+    }
+  free(k);
+  return YES;
+}
+
+static inline unsigned char
+clamp8(int v)
+{
+  v >>= WEIGHT_BITS;
+  return (v < 0) ? 0 : (v > 255) ? 255 : v;
+}
+
+/* Scales each of the rows of in, which are inWidth RGBA pixels wide,
+   to the width of the weights. */
+static void
+resample_rows(const unsigned char *in, int inWidth, int rows,
+	      gs_resample_weights *w, int outWidth, unsigned char *out)
+{
+  int y, x, i;
+
+  for (y = 0; y < rows; y++)
+    {
+      const unsigned char *row = in + 4 * y * inWidth;
+
+      for (x = 0; x < outWidth; x++, out += 4)
+	{
+	  const unsigned char *p = row + 4 * w->start[x];
+	  const int *k = w->weights + x * w->size;
+	  int n = w->count[x];
+	  int r, g, b, a;
+
+	  r = g = b = a = 1 << (WEIGHT_BITS - 1);
+	  for (i = 0; i < n; i++, p += 4)
+	    {
+	      r += p[0] * k[i];
+	      g += p[1] * k[i];
+	      b += p[2] * k[i];
+	      a += p[3] * k[i];
+	    }
+	  out[0] = clamp8(r);
+	  out[1] = clamp8(g);
+	  out[2] = clamp8(b);
+	  out[3] = clamp8(a);
+	}
+    }
+}
+
+/* Scales the columns of in, which has rows of length bytes, to the
+   height of the weights. The inner loop runs along whole rows, so the
+   compiler can vectorise it. */
+static void
+resample_columns(const unsigned char *in, int length, gs_resample_weights *w,
+		 int outHeight, int *acc, unsigned char *out)
+{
+  int y, i, j;
+
+  for (y = 0; y < outHeight; y++, out += length)
+    {
+      const int *k = w->weights + y * w->size;
+      const unsigned char *row = in + w->start[y] * length;
+
+      for (j = 0; j < length; j++)
+	acc[j] = 1 << (WEIGHT_BITS - 1);
+      for (i = 0; i < w->count[y]; i++, row += length)
+	{
+	  int weight = k[i];
+
+	  for (j = 0; j < length; j++)
+	    acc[j] += row[j] * weight;
+	}
+      for (j = 0; j < length; j++)
+	out[j] = clamp8(acc[j]);
+    }
+}
+
+@implementation NSBitmapImageRep (GSResampling)
+
+- (NSBitmapImageRep *) bitmapImageRepByResamplingToPixelsWide: (NSInteger)width
+						   pixelsHigh: (NSInteger)height
+						       filter: (GSImageResamplingFilter)filter
+{
+  NSInteger w = [self pixelsWide];
+  NSInteger h = [self pixelsHigh];
+  BOOL alpha = [self hasAlpha];
+  double (*function)(double);
+  double support;
+  gs_resample_weights xw, yw;
+  NSBitmapImageRep *rep;
+  unsigned char *src, *tmp, *dst;
+  int *acc;
+  NSInteger i;
+
+  if (w <= 0 || h <= 0 || width <= 0 || height <= 0)
+    return nil;
+
+  switch (filter)
+    {
+      case GSImageResamplingBox:
+	function = box_filter;
+	support = 0.5;
+	break;
+      case GSImageResamplingBilinear:
+	function = triangle_filter;
+	support = 1.0;
+	break;
+      default:
+	function = lanczos_filter;
+	support = 3.0;
+	break;
+    }
+
+  rep = AUTORELEASE([[NSBitmapImageRep alloc]
+    initWithBitmapDataPlanes: NULL
+		  pixelsWide: width
+		  pixelsHigh: height
+	       bitsPerSample: 8
+	     samplesPerPixel: 4
+		    hasAlpha: YES
+		    isPlanar: NO
+	      colorSpaceName: NSCalibratedRGBColorSpace
+		bitmapFormat: NSAlphaNonpremultipliedBitmapFormat
+		 bytesPerRow: width * 4
+		bitsPerPixel: 32]);
+  if (rep == nil)
+    return nil;
+  [rep setSize: [self size]];
+  [rep setOpaque: [self isOpaque]];
+
+  if (!compute_weights(w, width, function, support, &xw))
+    return nil;
+  if (!compute_weights(h, height, function, support, &yw))
+    {
+      free_weights(&xw);
+      return nil;
+    }
+  src = malloc(4 * w * h);
+  tmp = malloc(4 * width * h);
+  acc = malloc(4 * width * sizeof(int));
+  if (src == NULL || tmp == NULL || acc == NULL
+    || ![self getRGBA8Pixels: src inRect: NSMakeRect(0, 0, w, h)])
+    {
+      free(src);
+      free(tmp);
+      free(acc);
+      free_weights(&xw);
+      free_weights(&yw);
+      return nil;
+    }
+
+  /* Filter with premultiplied alpha, so transparent pixels don't bleed
+     their colour into the ones next to them. */
+  if (alpha)
+    {
+      for (i = 0; i < w * h; i++)
+	{
+	  unsigned char *p = src + 4 * i;
+
+	  p[0] = (p[0] * p[3] + 127) / 255;
+	  p[1] = (p[1] * p[3] + 127) / 255;
+	  p[2] = (p[2] * p[3] + 127) / 255;
+	}
+    }
+
+  resample_rows(src, w, h, &xw, width, tmp);
+  dst = [rep bitmapData];
+  resample_columns(tmp, 4 * width, &yw, height, acc, dst);
+
+  if (alpha)
+    {
+      for (i = 0; i < width * height; i++)
+	{
+	  unsigned char *p = dst + 4 * i;
+	  int a = p[3];
+
+	  if (a == 0)
+	    {
+	      p[0] = p[1] = p[2] = 0;
+	    }
+	  else if (a < 255)
+	    {
+	      p[0] = MIN(255, (p[0] * 255 + a / 2) / a);
+	      p[1] = MIN(255, (p[1] * 255 + a / 2) / a);
+	      p[2] = MIN(255, (p[2] * 255 + a / 2) / a);
+	    }
+	}
+    }
+
+  free(src);
+  free(tmp);
+  free(acc);
+  free_weights(&xw);
+  free_weights(&yw);
+  return rep;
+}
+
+@end
@@ -30,6 +30,9 @@
 
 #include <stdlib.h>
 #include <math.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include <tiff.h>
 
 #import <Foundation/NSArray.h>
@@ -52,16 +55,29 @@
 #import "NSBitmapImageRep+PNM.h"
 #import "NSBitmapImageRep+ICNS.h"
 #import "GSGuiPrivate.h"
+#import "GSTraceProbes.h"
 
 #include "nsimage-tiff.h"
 
 /* Maximum number of planes */
 #define MAX_PLANES 5
 
+/* The objects decoding an image for incremental loading. */
+@protocol GSIncrementalImageLoader
+/* Decodes the new bytes of data and returns the number of rows decoded
+   so far or an NSImageRepLoadStatus. */
+- (NSInteger) loadFromData: (NSData *)data complete: (BOOL)complete;
+@end
+
 /* Backend methods (optional) */
 @interface NSBitmapImageRep (GSPrivate)
 // GNUstep extension
 - _initFromTIFFImage: (TIFF *)image number: (int)imageNumber;
+- _initFromTIFFImage: (TIFF *)image
+              number: (int)imageNumber
+            lazyData: (NSData *)data;
+- (void) _decodeTIFFPage;
+- (void) _decodeImage;
 
 // Internal
 + (int) _localFromCompressionType: (NSTIFFCompression)type;
@@ -183,11 +199,7 @@
   return AUTORELEASE([[self alloc] initWithData: imageData]);
 }
 
-/**<p>Returns an array containing newly allocated NSBitmapImageRep
-    objects representing the images stored in imageData.</p>
-    <p>See Also: +imageRepWithData:</p>
-*/
-+ (NSArray*) imageRepsWithData: (NSData *)imageData
++ (NSArray*) _imageRepsFromData: (NSData *)imageData
 {
   int		 i, images;
   TIFF		 *image;
@@ -272,7 +284,12 @@
   for (i = 0; i < images; i++)
     {
       NSBitmapImageRep* imageRep;
-      imageRep = [[self alloc] _initFromTIFFImage: image number: i];
+
+      /* Only the first page is decoded now, the others when their
+         pixels are first used. */
+      imageRep = [[self alloc] _initFromTIFFImage: image
+                                           number: i
+                                         lazyData: (i > 0 ? imageData : nil)];
       if (imageRep)
 	{
 	  [array addObject: imageRep];
@@ -284,9 +301,21 @@
   return array;
 }
 
-/** Loads only the default (first) image from the image contained in
-   data. */
-- (id) initWithData: (NSData *)imageData
+/**<p>Returns an array containing newly allocated NSBitmapImageRep
+    objects representing the images stored in imageData.</p>
+    <p>See Also: +imageRepWithData:</p>
+*/
++ (NSArray*) imageRepsWithData: (NSData *)imageData
+{
+  NSArray *array;
+
+  GS_PROBE2(image_decode_entry, imageData, [imageData length]);
+  array = [self _imageRepsFromData: imageData];
+  GS_PROBE2(image_decode_return, imageData, [imageData length]);
+  return array;
+}
+
+- (id) _initFromData: (NSData *)imageData
 {
   TIFF *image;
 
@@ -328,6 +357,16 @@
   return self;
 }
 
+/** Loads only the default (first) image from the image contained in
+   data. */
+- (id) initWithData: (NSData *)imageData
+{
+  GS_PROBE2(image_decode_entry, imageData, [imageData length]);
+  self = [self _initFromData: imageData];
+  GS_PROBE2(image_decode_return, imageData, [imageData length]);
+  return self;
+}
+
 /** Initialize with bitmap data from a rect within the focused view */
 - (id) initWithFocusedViewRect: (NSRect)rect
 {
@@ -601,23 +640,64 @@
 
 - (id) initForIncrementalLoad
 {
-  // FIXME
-  return self;
+  return [super init];
 }
 
+/* Loads the image as the data arrives, for the formats whose libraries
+   can decode partial data (PNG and JPEG). The other formats are decoded
+   once complete is YES. The data passed in holds all bytes received so
+   far. Rows not decoded yet are blank, so the image may be drawn while
+   it loads. */
 - (NSInteger) incrementalLoadFromData: (NSData *)data complete: (BOOL)complete
 {
-  if (!complete)
+  NSInteger status;
+
+  if (_incrementalLoader == nil)
     {
-      // we don't implement it really
-      return NSImageRepLoadStatusWillNeedAllData;
+      const unsigned char *bytes = [data bytes];
+      NSUInteger length = [data length];
+
+      if (length < 8 && !complete)
+        {
+          return NSImageRepLoadStatusReadingHeader;
+        }
+      if ([object_getClass(self) _bitmapIsPNG: data])
+        {
+          _incrementalLoader = RETAIN([self _incrementalPNGLoader]);
+        }
+      else if (length >= 3
+        && bytes[0] == 0xff && bytes[1] == 0xd8 && bytes[2] == 0xff)
+        {
+          _incrementalLoader = RETAIN([self _incrementalJPEGLoader]);
+        }
+
+      if (_incrementalLoader == nil)
+        {
+          if (!complete)
+            {
+              return NSImageRepLoadStatusWillNeedAllData;
+            }
+          return [self initWithData: data] ? NSImageRepLoadStatusCompleted
+            : NSImageRepLoadStatusUnexpectedEOF;
+        }
     }
-  return [self initWithData: data] ? NSImageRepLoadStatusCompleted : NSImageRepLoadStatusUnexpectedEOF;
+
+  status = [_incrementalLoader loadFromData: data complete: complete];
+  if (status == NSImageRepLoadStatusCompleted
+    || status == NSImageRepLoadStatusInvalidData
+    || status == NSImageRepLoadStatusUnexpectedEOF)
+    {
+      DESTROY(_incrementalLoader);
+    }
+  return status;
 }
 
 - (void) dealloc
 {
   NSZoneFree([self zone],_imagePlanes);
+  RELEASE(_incrementalLoader);
+  RELEASE(_undecodedData);
+  RELEASE(_frameDecoder);
   RELEASE(_imageData);
   RELEASE(_properties);
   [super dealloc];
@@ -692,6 +772,9 @@
 {
   unsigned int i;
 
+  if (_undecodedData != nil)
+    [self _decodeImage];
+
   if (data)
     {
       for (i = 0; i < _numColors; i++)
@@ -755,6 +838,9 @@ _get_bit_value(unsigned char *base, long msb_off, NSInteger bit_width)
   NSInteger offset;
   NSInteger line_offset;
 
+  if (_undecodedData != nil)
+    [self _decodeImage];
+
   if (x < 0 || y < 0 || x >= _pixelsWide || y >= _pixelsHigh)
     {
       // outside
@@ -848,6 +934,9 @@ _set_bit_value(unsigned char *base, long msb_off, NSInteger bit_width,
   NSInteger offset;
   NSInteger line_offset;
 
+  if (_undecodedData != nil)
+    [self _decodeImage];
+
   if (x < 0 || y < 0 || x >= _pixelsWide || y >= _pixelsHigh)
     {
       // outside
@@ -1722,13 +1811,22 @@ _set_bit_value(unsigned char *base, long msb_off, NSInteger bit_width,
     <desc> NSNumber boolean; only for writing PNG data </desc>
     <term> NSImageGamma </term>
     <desc> NSNumber 0.0 to 1.0; only for reading or writing PNG data </desc>
+    <term> GSImagePNGCompressionLevel </term>
+    <desc> NSNumber 0 to 9; only for writing PNG data (GNUstep extension) </desc>
+    <term> GSImagePNGFilters </term>
+    <desc> NSNumber of GSPNGFilter flags the rows are filtered with; only
+    for writing PNG data (GNUstep extension) </desc>
+    <term> GSImagePNGThreads </term>
+    <desc> NSNumber integer; the number of threads large PNG images may
+    be compressed on; only for writing non-interlaced PNG data (GNUstep
+    extension) </desc>
     <term> NSImageRGBColorTable </term>
     <desc> NSData; automatically set when reading GIF data; writing GIF data </desc>
     <term> NSImageFrameCount </term>
-    <desc> NSNumber integer; automatically set when reading animated GIF data.
-    Not currently implemented. </desc>
+    <desc> NSNumber integer; automatically set when reading animated GIF data. </desc>
     <term> NSImageCurrentFrame </term>
-    <desc> NSNumber integer; only for animated GIF files. Not currently implemented. </desc>
+    <desc> NSNumber integer; only for animated GIF files. Setting it shows
+    that frame, which is decoded when it is first needed. </desc>
     <term> NSImageCurrentFrameDuration </term>
     <desc> NSNumber float; automatically set when reading animated GIF data </desc>
     <term> NSImageLoopCount </term>
@@ -1739,6 +1837,13 @@ _set_bit_value(unsigned char *base, long msb_off, NSInteger bit_width,
 */
 - (void)setProperty:(NSString *)property withValue:(id)value
 {
+  /* Frames of animated gifs are decoded as they are shown. */
+  if (_frameDecoder != nil && value != nil
+    && [property isEqualToString: NSImageCurrentFrame]
+    && ![self _setGIFFrame: [value intValue]])
+    {
+      return;
+    }
   if (value)
   {
     [_properties setObject: value forKey: property];
@@ -1760,9 +1865,16 @@ _set_bit_value(unsigned char *base, long msb_off, NSInteger bit_width,
 {
   NSBitmapImageRep	*copy;
 
+  if (_undecodedData != nil)
+    [self _decodeImage];
+
   copy = (NSBitmapImageRep*)[super copyWithZone: zone];
 
   copy->_imageData = [_imageData copyWithZone: zone];
+  /* The copy holds the rows decoded so far, but doesn't load further. */
+  copy->_incrementalLoader = nil;
+  /* Both show the frames of an animation from the same decoder. */
+  RETAIN(copy->_frameDecoder);
   copy->_imagePlanes = NSZoneMalloc(zone, sizeof(unsigned char*) * MAX_PLANES);
   if (_imageData == nil)
     {
@@ -1870,6 +1982,16 @@ _set_bit_value(unsigned char *base, long msb_off, NSInteger bit_width,
 /* Given a TIFF image (from the libtiff library), load the image information
    into our data structure.  Reads the specified image. */
 - _initFromTIFFImage: (TIFF *)image number: (int)imageNumber
+{
+  return [self _initFromTIFFImage: image number: imageNumber lazyData: nil];
+}
+
+/* Initialises the receiver from directory imageNumber of image. If data
+   is not nil, it holds the TIFF file of image, and the pixels are only
+   read from it when they are first used. */
+- _initFromTIFFImage: (TIFF *)image
+              number: (int)imageNumber
+            lazyData: (NSData *)data
 {
   NSString* space;
   NSTiffInfo* info;
@@ -1928,7 +2050,12 @@ _set_bit_value(unsigned char *base, long msb_off, NSInteger bit_width,
       [self setSize: pointSize];
     }
 
-  if (NSTiffRead(image, info, [self bitmapData]))
+  if (data != nil)
+    {
+      _undecodedData = RETAIN(data);
+      _undecodedImage = imageNumber;
+    }
+  else if (NSTiffRead(image, info, [self bitmapData]))
     {
       free(info);
       RELEASE(self);
@@ -1940,6 +2067,132 @@ _set_bit_value(unsigned char *base, long msb_off, NSInteger bit_width,
   return self;
 }
 
+/* Reads the pixels of an image whose decoding was put off. _undecodedData
+   holds the file and _undecodedImage tells which image of it to read. */
+- (void) _decodeImage
+{
+  if ([object_getClass(self) _bitmapIsICNS: _undecodedData])
+    [self _decodeICNSElement];
+  else
+    [self _decodeTIFFPage];
+}
+
+/* Reads the pixels of a TIFF page whose decoding was put off. */
+- (void) _decodeTIFFPage
+{
+  NSData *data = _undecodedData;
+  NSTiffInfo *info = NULL;
+  TIFF *image;
+
+  _undecodedData = nil;
+  image = NSTiffOpenDataRead((char *)[data bytes], [data length]);
+  if (image != NULL)
+    {
+      info = NSTiffGetInfo(_undecodedImage, image);
+    }
+  if (info == NULL || NSTiffRead(image, info, _imagePlanes[0]))
+    {
+      NSLog(@"Tiff read invalid TIFF image data in directory %d",
+            _undecodedImage);
+    }
+  free(info);
+  if (image != NULL)
+    {
+      NSTiffClose(image);
+    }
+  RELEASE(data);
+}
+
+/* Multiplies the colour samples of width 8-bit pixels by their alpha.
+   samples holds a pointer to the first sample of each component, and
+   step is the distance in bytes between the samples of two pixels. */
+static void
+_premultiply_row_8(unsigned char **samples, NSInteger step, NSInteger width,
+                   NSInteger ai, NSInteger start, NSInteger end)
+{
+  NSInteger x = 0;
+  NSInteger off, i;
+
+#if defined(__SSE2__)
+  /* Four meshed pixels with four samples at a time. The alpha sample is
+     multiplied by 255, which leaves it unchanged. */
+  if (step == 4 && end - start == 3 && samples[1] == samples[0] + 1)
+    {
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i round = _mm_set1_epi16(0x80);
+      const __m128i alphaMask = (ai == 0)
+        ? _mm_set_epi16(0, 0, 0, -1, 0, 0, 0, -1)
+        : _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+      const __m128i alphaOne = _mm_and_si128(alphaMask, _mm_set1_epi16(255));
+      unsigned char *p = samples[0];
+
+      for (; x + 4 <= width; x += 4, p += 16)
+        {
+          __m128i v = _mm_loadu_si128((const __m128i *)p);
+          __m128i lo = _mm_unpacklo_epi8(v, zero);
+          __m128i hi = _mm_unpackhi_epi8(v, zero);
+          __m128i alo, ahi;
+
+          if (ai == 0)
+            {
+              alo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, 0x00), 0x00);
+              ahi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, 0x00), 0x00);
+            }
+          else
+            {
+              alo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, 0xff), 0xff);
+              ahi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, 0xff), 0xff);
+            }
+          alo = _mm_or_si128(_mm_andnot_si128(alphaMask, alo), alphaOne);
+          ahi = _mm_or_si128(_mm_andnot_si128(alphaMask, ahi), alphaOne);
+          lo = _mm_add_epi16(_mm_mullo_epi16(lo, alo), round);
+          hi = _mm_add_epi16(_mm_mullo_epi16(hi, ahi), round);
+          lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+          hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+          _mm_storeu_si128((__m128i *)p, _mm_packus_epi16(lo, hi));
+        }
+    }
+#endif
+
+  for (off = x * step; x < width; x++, off += step)
+    {
+      NSUInteger a = samples[ai][off];
+
+      if (a != 255)
+        {
+          for (i = start; i < end; i++)
+            {
+              NSUInteger t = a * samples[i][off] + 0x80;
+
+              samples[i][off] = ((t >> 8) + t) >> 8;
+            }
+        }
+    }
+}
+
+/* Divides the colour samples of width 8-bit pixels by their alpha. */
+static void
+_unpremultiply_row_8(unsigned char **samples, NSInteger step, NSInteger width,
+                     NSInteger ai, NSInteger start, NSInteger end)
+{
+  NSInteger x, off, i;
+
+  for (x = 0, off = 0; x < width; x++, off += step)
+    {
+      NSUInteger a = samples[ai][off];
+
+      if ((a != 0) && (a != 255))
+        {
+          for (i = start; i < end; i++)
+            {
+              NSUInteger c = (samples[i][off] * 255) / a;
+
+              samples[i][off] = (c >= 255) ? 255 : c;
+            }
+        }
+    }
+}
+
 - (void) _premultiply
 {
   NSInteger x, y;
@@ -1950,6 +2203,9 @@ _set_bit_value(unsigned char *base, long msb_off, NSInteger bit_width,
   IMP getP = [self methodForSelector: getPSel];
   IMP setP = [self methodForSelector: setPSel];
 
+  if (_undecodedData != nil)
+    [self _decodeImage];
+
   if (!_hasAlpha || !(_format & NSAlphaNonpremultipliedBitmapFormat))
     return;
 
@@ -1968,27 +2224,19 @@ _set_bit_value(unsigned char *base, long msb_off, NSInteger bit_width,
 
   if (_bitsPerSample == 8)
     {
-      NSUInteger a;
+      unsigned char *samples[MAX_PLANES];
+      NSInteger step = _isPlanar ? 1 : _bitsPerPixel / 8;
 
       for (y = 0; y < _pixelsHigh; y++)
         {
-          for (x = 0; x < _pixelsWide; x++)
+          for (i = 0; i < _numColors; i++)
             {
-              //[self getPixel: pixelData atX: x y: y];
-              getP(self, getPSel, pixelData, x, y);
-              a = pixelData[ai];
-              if (a != 255)
-                {
-                  for (i = start; i < end; i++)
-                    {
-                      NSUInteger t = a * pixelData[i] + 0x80;
-
-                      pixelData[i] = ((t >> 8) + t) >> 8;
-                    }
-                  //[self setPixel: pixelData atX: x y: y];
-                  setP(self, setPSel, pixelData, x, y);
-                }
+              if (_isPlanar)
+                samples[i] = _imagePlanes[i] + y * _bytesPerRow;
+              else
+                samples[i] = _imagePlanes[0] + y * _bytesPerRow + i;
             }
+          _premultiply_row_8(samples, step, _pixelsWide, ai, start, end);
         }
     }
   else
@@ -2027,6 +2275,9 @@ _set_bit_value(unsigned char *base, long msb_off, NSInteger bit_width,
   IMP getP = [self methodForSelector: getPSel];
   IMP setP = [self methodForSelector: setPSel];
 
+  if (_undecodedData != nil)
+    [self _decodeImage];
+
   if (!_hasAlpha || (_format & NSAlphaNonpremultipliedBitmapFormat))
     return;
 
@@ -2045,35 +2296,19 @@ _set_bit_value(unsigned char *base, long msb_off, NSInteger bit_width,
 
   if (_bitsPerSample == 8)
     {
-      NSUInteger a;
+      unsigned char *samples[MAX_PLANES];
+      NSInteger step = _isPlanar ? 1 : _bitsPerPixel / 8;
 
       for (y = 0; y < _pixelsHigh; y++)
         {
-          for (x = 0; x < _pixelsWide; x++)
+          for (i = 0; i < _numColors; i++)
             {
-              //[self getPixel: pixelData atX: x y: y];
-              getP(self, getPSel, pixelData, x, y);
-              a = pixelData[ai];
-              if ((a != 0) && (a != 255))
-                {
-                  for (i = start; i < end; i++)
-                    {
-                      NSUInteger c;
-                      
-                      c = (pixelData[i] * 255) / a;
-                      if (c >= 255)
-                        {
-                          pixelData[i] = 255;
-                        }
-                      else
-                        {
-                          pixelData[i] = c;
-                        }
-                    }
-                  //[self setPixel: pixelData atX: x y: y];
-                  setP(self, setPSel, pixelData, x, y);
-                }
+              if (_isPlanar)
+                samples[i] = _imagePlanes[i] + y * _bytesPerRow;
+              else
+                samples[i] = _imagePlanes[0] + y * _bytesPerRow + i;
             }
+          _unpremultiply_row_8(samples, step, _pixelsWide, ai, start, end);
         }
     }
   else
@@ -2117,6 +2352,182 @@ _set_bit_value(unsigned char *base, long msb_off, NSInteger bit_width,
   _format |= NSAlphaNonpremultipliedBitmapFormat;
 }
 
+/*
+Row converters for the common conversions between meshed 8-bit and 16-bit
+formats that don't need any arithmetic on the colour values. Each one
+converts a row of width pixels with spp destination samples.
+*/
+typedef void (*_row_converter_f)(const unsigned char *src, unsigned char *dst,
+                                 NSInteger width, NSInteger spp);
+
+static void
+_row_rgb8_to_rgba8(const unsigned char *s, unsigned char *d,
+                   NSInteger width, NSInteger spp)
+{
+  for (; width > 0; width--, s += 3, d += 4)
+    {
+      d[0] = s[0];
+      d[1] = s[1];
+      d[2] = s[2];
+      d[3] = 255;
+    }
+}
+
+static void
+_row_rgb8_to_argb8(const unsigned char *s, unsigned char *d,
+                   NSInteger width, NSInteger spp)
+{
+  for (; width > 0; width--, s += 3, d += 4)
+    {
+      d[0] = 255;
+      d[1] = s[0];
+      d[2] = s[1];
+      d[3] = s[2];
+    }
+}
+
+static void
+_row_rgba8_to_argb8(const unsigned char *s, unsigned char *d,
+                    NSInteger width, NSInteger spp)
+{
+  for (; width > 0; width--, s += 4, d += 4)
+    {
+      d[0] = s[3];
+      d[1] = s[0];
+      d[2] = s[1];
+      d[3] = s[2];
+    }
+}
+
+static void
+_row_argb8_to_rgba8(const unsigned char *s, unsigned char *d,
+                    NSInteger width, NSInteger spp)
+{
+  for (; width > 0; width--, s += 4, d += 4)
+    {
+      d[0] = s[1];
+      d[1] = s[2];
+      d[2] = s[3];
+      d[3] = s[0];
+    }
+}
+
+static void
+_row_rgba8_to_rgb8(const unsigned char *s, unsigned char *d,
+                   NSInteger width, NSInteger spp)
+{
+  for (; width > 0; width--, s += 4, d += 3)
+    {
+      d[0] = s[0];
+      d[1] = s[1];
+      d[2] = s[2];
+    }
+}
+
+static void
+_row_argb8_to_rgb8(const unsigned char *s, unsigned char *d,
+                   NSInteger width, NSInteger spp)
+{
+  for (; width > 0; width--, s += 4, d += 3)
+    {
+      d[0] = s[1];
+      d[1] = s[2];
+      d[2] = s[3];
+    }
+}
+
+static void
+_row_gray8_to_rgb8(const unsigned char *s, unsigned char *d,
+                   NSInteger width, NSInteger spp)
+{
+  for (; width > 0; width--, s++, d += 3)
+    {
+      d[0] = d[1] = d[2] = s[0];
+    }
+}
+
+static void
+_row_gray8_to_rgba8(const unsigned char *s, unsigned char *d,
+                    NSInteger width, NSInteger spp)
+{
+  for (; width > 0; width--, s++, d += 4)
+    {
+      d[0] = d[1] = d[2] = s[0];
+      d[3] = 255;
+    }
+}
+
+static void
+_row_graya8_to_rgba8(const unsigned char *s, unsigned char *d,
+                     NSInteger width, NSInteger spp)
+{
+  for (; width > 0; width--, s += 2, d += 4)
+    {
+      d[0] = d[1] = d[2] = s[0];
+      d[3] = s[1];
+    }
+}
+
+static void
+_row_graya8_to_argb8(const unsigned char *s, unsigned char *d,
+                     NSInteger width, NSInteger spp)
+{
+  for (; width > 0; width--, s += 2, d += 4)
+    {
+      d[0] = s[1];
+      d[1] = d[2] = d[3] = s[0];
+    }
+}
+
+/* 16-bit samples are stored with the most significant byte first. */
+static void
+_row_16_to_8(const unsigned char *s, unsigned char *d,
+             NSInteger width, NSInteger spp)
+{
+  NSInteger n;
+
+  for (n = width * spp; n > 0; n--, s += 2, d++)
+    {
+      NSUInteger v = (s[0] << 8) | s[1];
+
+      *d = (v * 255) / 65535;
+    }
+}
+
+enum
+{
+  _ALPHA_NONE,
+  _ALPHA_LAST,
+  _ALPHA_FIRST
+};
+
+typedef struct
+{
+  /* Source bits per sample, samples per pixel (0 matches any number if
+     the destination has the same layout) and alpha position. */
+  int srcBps, srcSpp, srcAlpha;
+  /* Whether the source is grey and the destination RGB. */
+  BOOL grayToRGB;
+  /* Destination samples per pixel and alpha position. The destination
+     always has 8 bits per sample. */
+  int dstSpp, dstAlpha;
+  _row_converter_f convert;
+} _row_converter_t;
+
+static const _row_converter_t _row_converters[] = {
+  { 8, 3, _ALPHA_NONE, NO, 4, _ALPHA_LAST, _row_rgb8_to_rgba8 },
+  { 8, 3, _ALPHA_NONE, NO, 4, _ALPHA_FIRST, _row_rgb8_to_argb8 },
+  { 8, 4, _ALPHA_LAST, NO, 4, _ALPHA_FIRST, _row_rgba8_to_argb8 },
+  { 8, 4, _ALPHA_FIRST, NO, 4, _ALPHA_LAST, _row_argb8_to_rgba8 },
+  { 8, 4, _ALPHA_LAST, NO, 3, _ALPHA_NONE, _row_rgba8_to_rgb8 },
+  { 8, 4, _ALPHA_FIRST, NO, 3, _ALPHA_NONE, _row_argb8_to_rgb8 },
+  { 8, 1, _ALPHA_NONE, YES, 3, _ALPHA_NONE, _row_gray8_to_rgb8 },
+  { 8, 1, _ALPHA_NONE, YES, 4, _ALPHA_LAST, _row_gray8_to_rgba8 },
+  { 8, 2, _ALPHA_LAST, YES, 4, _ALPHA_LAST, _row_graya8_to_rgba8 },
+  { 8, 2, _ALPHA_LAST, YES, 4, _ALPHA_FIRST, _row_graya8_to_argb8 },
+  { 16, 0, -1, NO, 0, -1, _row_16_to_8 }
+};
+
 - (NSBitmapImageRep *) _convertToFormatBitsPerSample: (NSInteger)bps
                                      samplesPerPixel: (NSInteger)spp
                                             hasAlpha: (BOOL)alpha
@@ -2131,6 +2542,9 @@ _set_bit_value(unsigned char *base, long msb_off, NSInteger bit_width,
   if (!rowBytes) 
     rowBytes = ceil((float)_pixelsWide * pixelBits / 8);
 
+  if (_undecodedData != nil)
+    [self _decodeImage];
+
   // Do we already have the correct format?
   if ((bps == _bitsPerSample) && (spp == _numColors)
       && (alpha == _hasAlpha) && (isPlanar == _isPlanar)
@@ -2157,11 +2571,77 @@ _set_bit_value(unsigned char *base, long msb_off, NSInteger bit_width,
                 bytesPerRow: rowBytes
                 bitsPerPixel: pixelBits];
 
-      if ([_colorSpace isEqualToString: colorSpaceName] ||
+      BOOL sameSpace = [_colorSpace isEqualToString: colorSpaceName] ||
           ([_colorSpace isEqualToString: NSDeviceRGBColorSpace] &&
            [colorSpaceName isEqualToString: NSCalibratedRGBColorSpace]) ||
           ([colorSpaceName isEqualToString: NSDeviceRGBColorSpace] &&
-           [_colorSpace isEqualToString: NSCalibratedRGBColorSpace]))
+           [_colorSpace isEqualToString: NSCalibratedRGBColorSpace]);
+      _row_converter_f convert = NULL;
+
+      /* Look for a row converter if both images are meshed without padding
+         between the pixels and no alpha has to be multiplied or divided. */
+      if (!_isPlanar && !isPlanar && bps == 8
+          && _bitsPerPixel == _bitsPerSample * _numColors
+          && pixelBits == bps * spp
+          && (!_hasAlpha
+              || (_format & NSAlphaNonpremultipliedBitmapFormat)
+                 == (bitmapFormat & NSAlphaNonpremultipliedBitmapFormat)))
+        {
+          BOOL grayToRGB = NO;
+          int srcAlpha, dstAlpha;
+          unsigned int i;
+
+          if (!sameSpace)
+            {
+              grayToRGB = ([colorSpaceName isEqualToString: NSDeviceRGBColorSpace]
+                 || [colorSpaceName isEqualToString: NSCalibratedRGBColorSpace])
+                && ([_colorSpace isEqualToString: NSCalibratedWhiteColorSpace]
+                    || [_colorSpace isEqualToString: NSDeviceWhiteColorSpace]);
+            }
+          srcAlpha = !_hasAlpha ? _ALPHA_NONE
+            : ((_format & NSAlphaFirstBitmapFormat) ? _ALPHA_FIRST : _ALPHA_LAST);
+          dstAlpha = !alpha ? _ALPHA_NONE
+            : ((bitmapFormat & NSAlphaFirstBitmapFormat) ? _ALPHA_FIRST : _ALPHA_LAST);
+          for (i = 0; (sameSpace || grayToRGB)
+                 && i < sizeof(_row_converters) / sizeof(_row_converters[0]); i++)
+            {
+              const _row_converter_t *c = &_row_converters[i];
+
+              if (c->srcBps != _bitsPerSample || c->grayToRGB != grayToRGB)
+                continue;
+              if (c->srcSpp == 0)
+                {
+                  /* The layout must stay the same. */
+                  if (_numColors == spp && srcAlpha == dstAlpha)
+                    {
+                      convert = c->convert;
+                      break;
+                    }
+                }
+              else if (c->srcSpp == _numColors && c->srcAlpha == srcAlpha
+                       && c->dstSpp == spp && c->dstAlpha == dstAlpha)
+                {
+                  convert = c->convert;
+                  break;
+                }
+            }
+        }
+
+      if (convert != NULL)
+        {
+          unsigned char *src = _imagePlanes[0];
+          unsigned char *dst = [new bitmapData];
+          NSInteger y;
+
+          NSDebugLLog(@"NSImage", @"Converting %@ bitmap data by rows",
+                      _colorSpace);
+          for (y = 0; y < _pixelsHigh; y++)
+            {
+              convert(src + y * _bytesPerRow, dst + y * rowBytes,
+                      _pixelsWide, spp);
+            }
+        }
+      else if (sameSpace)
         {
           SEL getPSel = @selector(getPixel:atX:y:);
           SEL setPSel = @selector(setPixel:atX:y:);
@@ -2453,3 +2933,223 @@ _set_bit_value(unsigned char *base, long msb_off, NSInteger bit_width,
 }
 
 @end
+
+@implementation NSBitmapImageRep (GSPixelAccess)
+
+/* Stores the non-premultiplied RGBA components of count pixels of row y,
+   starting at x, in rgba, scaled to [0.0 ... 1.0]. */
+- (BOOL) _getRGBA: (float *)rgba
+            atX: (NSInteger)x
+              y: (NSInteger)y
+          count: (NSInteger)count
+{
+  unsigned char *line[MAX_PLANES];
+  NSInteger ai, ci, i, n;
+  BOOL isGray, isBlack;
+  float scale;
+
+  if (_undecodedData != nil)
+    [self _decodeImage];
+
+  if ([_colorSpace isEqualToString: NSCalibratedRGBColorSpace]
+      || [_colorSpace isEqualToString: NSDeviceRGBColorSpace])
+    {
+      isGray = isBlack = NO;
+    }
+  else if ([_colorSpace isEqualToString: NSCalibratedWhiteColorSpace]
+           || [_colorSpace isEqualToString: NSDeviceWhiteColorSpace])
+    {
+      isGray = YES;
+      isBlack = NO;
+    }
+  else if ([_colorSpace isEqualToString: NSCalibratedBlackColorSpace]
+           || [_colorSpace isEqualToString: NSDeviceBlackColorSpace])
+    {
+      isGray = isBlack = YES;
+    }
+  else
+    {
+      return NO;
+    }
+
+  if (_hasAlpha && (_format & NSAlphaFirstBitmapFormat))
+    {
+      ai = 0;
+      ci = 1;
+    }
+  else
+    {
+      ai = _hasAlpha ? _numColors - 1 : -1;
+      ci = 0;
+    }
+  scale = (float)((1 << _bitsPerSample) - 1);
+  for (i = 0; i < _numColors; i++)
+    {
+      line[i] = _imagePlanes[_isPlanar ? i : 0] + y * _bytesPerRow;
+    }
+
+  for (n = 0; n < count; n++, x++, rgba += 4)
+    {
+      NSUInteger v[5];
+      float a;
+
+      for (i = 0; i < _numColors; i++)
+        {
+          if (_bitsPerSample == 8)
+            {
+              if (_isPlanar)
+                v[i] = line[i][x];
+              else
+                v[i] = line[0][(_bitsPerPixel * x) / 8 + i];
+            }
+          else if (_isPlanar)
+            {
+              v[i] = _get_bit_value(line[i], _bitsPerPixel * x,
+                                    _bitsPerSample);
+            }
+          else
+            {
+              v[i] = _get_bit_value(line[0],
+                                    _bitsPerPixel * x + _bitsPerSample * i,
+                                    _bitsPerSample);
+            }
+        }
+
+      a = (ai >= 0) ? v[ai] / scale : 1.0;
+      if (isGray)
+        {
+          float g = v[ci] / scale;
+
+          if (isBlack)
+            g = 1.0 - g;
+          rgba[0] = rgba[1] = rgba[2] = g;
+        }
+      else
+        {
+          rgba[0] = v[ci] / scale;
+          rgba[1] = v[ci + 1] / scale;
+          rgba[2] = v[ci + 2] / scale;
+        }
+      if (ai >= 0 && !(_format & NSAlphaNonpremultipliedBitmapFormat))
+        {
+          for (i = 0; i < 3; i++)
+            {
+              if (a == 0.0)
+                rgba[i] = 0.0;
+              else if (rgba[i] >= a)
+                rgba[i] = 1.0;
+              else
+                rgba[i] /= a;
+            }
+        }
+      rgba[3] = a;
+    }
+  return YES;
+}
+
+- (BOOL) _checkPixelRect: (NSRect)rect
+{
+  return NSMinX(rect) >= 0 && NSMinY(rect) >= 0
+    && NSMaxX(rect) <= _pixelsWide && NSMaxY(rect) <= _pixelsHigh
+    && NSWidth(rect) >= 0 && NSHeight(rect) >= 0;
+}
+
+- (BOOL) getRGBAFloatPixels: (float *)buffer inRect: (NSRect)rect
+{
+  NSInteger x = NSMinX(rect);
+  NSInteger width = NSWidth(rect);
+  NSInteger y, maxY = NSMaxY(rect);
+
+  if (![self _checkPixelRect: rect])
+    return NO;
+  for (y = NSMinY(rect); y < maxY; y++, buffer += 4 * width)
+    {
+      if (![self _getRGBA: buffer atX: x y: y count: width])
+        return NO;
+    }
+  return YES;
+}
+
+- (BOOL) getRGBAFloatPixels: (float *)buffer row: (NSInteger)y
+{
+  return [self getRGBAFloatPixels: buffer
+                           inRect: NSMakeRect(0, y, _pixelsWide, 1)];
+}
+
+- (BOOL) getRGBA8Pixels: (unsigned char *)buffer inRect: (NSRect)rect
+{
+  NSInteger x = NSMinX(rect);
+  NSInteger width = NSWidth(rect);
+  NSInteger y, maxY = NSMaxY(rect);
+  float *rgba;
+  NSInteger i;
+
+  if (_undecodedData != nil)
+    [self _decodeImage];
+
+  if (![self _checkPixelRect: rect])
+    return NO;
+
+  /* Non-premultiplied meshed RGBA with 8 bits is copied as it is. */
+  if (_bitsPerSample == 8 && _numColors == 4 && _hasAlpha && !_isPlanar
+      && _bitsPerPixel == 32
+      && (_format & NSAlphaNonpremultipliedBitmapFormat)
+      && !(_format & NSAlphaFirstBitmapFormat)
+      && ([_colorSpace isEqualToString: NSCalibratedRGBColorSpace]
+          || [_colorSpace isEqualToString: NSDeviceRGBColorSpace]))
+    {
+      for (y = NSMinY(rect); y < maxY; y++, buffer += 4 * width)
+        {
+          memcpy(buffer, _imagePlanes[0] + y * _bytesPerRow + 4 * x,
+                 4 * width);
+        }
+      return YES;
+    }
+
+  rgba = malloc(4 * width * sizeof(float));
+  if (rgba == NULL)
+    return NO;
+  for (y = NSMinY(rect); y < maxY; y++, buffer += 4 * width)
+    {
+      if (![self _getRGBA: rgba atX: x y: y count: width])
+        {
+          free(rgba);
+          return NO;
+        }
+      for (i = 0; i < 4 * width; i++)
+        {
+          buffer[i] = (unsigned char)(rgba[i] * 255.0 + 0.5);
+        }
+    }
+  free(rgba);
+  return YES;
+}
+
+- (BOOL) getRGBA8Pixels: (unsigned char *)buffer row: (NSInteger)y
+{
+  return [self getRGBA8Pixels: buffer
+                       inRect: NSMakeRect(0, y, _pixelsWide, 1)];
+}
+
+@end
+
+@implementation NSBitmapImageRep (GSScaledLoading)
+
++ (id) imageRepWithData: (NSData *)imageData forPixelSize: (NSSize)pixelSize
+{
+  return AUTORELEASE([[self alloc] initWithData: imageData
+                                   forPixelSize: pixelSize]);
+}
+
+- (id) initWithData: (NSData *)imageData forPixelSize: (NSSize)pixelSize
+{
+  if (imageData != nil
+    && [object_getClass(self) _bitmapIsJPEG: imageData])
+    return [self _initBitmapFromJPEG: imageData
+                        forPixelSize: pixelSize
+                        errorMessage: NULL];
+
+  return [self initWithData: imageData];
+}
+
+@end
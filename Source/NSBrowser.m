@@ -39,6 +39,7 @@
 #import <Foundation/NSArray.h>
 #import <Foundation/NSDebug.h>
 #import <Foundation/NSException.h>
+#import <Foundation/NSIndexSet.h>
 #import <Foundation/NSUserDefaults.h>
 #import "AppKit/NSBrowser.h"
 #import "AppKit/NSBrowserCell.h"
@@ -57,6 +58,7 @@
 #import "GNUstepGUI/GSTheme.h"
 
 #import "GSGuiPrivate.h"
+#import "GSTypeSelectIndex.h"
 
 /* Cache */
 static CGFloat scrollerWidth; // == [NSScroller scrollerWidth]
@@ -234,6 +236,253 @@ static NSTextFieldCell *titleCell;
 - (void) _performLoadOfColumn: (NSInteger)column;
 - (void) _remapColumnSubviews: (BOOL)flag;
 - (void) _setColumnTitlesNeedDisplay;
+- (void) _loadCell: (NSCell *)cell
+             atRow: (NSInteger)row
+          ofMatrix: (NSMatrix *)matrix;
+@end
+
+/*
+ * Matrix used for columns which are loaded lazily.  Rows which haven't
+ * been shown hold a shared placeholder cell.  A row gets a real cell,
+ * recycled if possible, which is loaded by the browser delegate when the
+ * row is drawn or its cell is asked for.  When rows scroll out of view
+ * their cells are recycled, unless the rows are selected.
+ */
+@interface GSBrowserMatrix : NSMatrix
+{
+  NSBrowser *_browser;
+  NSCell *_placeholder;
+  NSMutableArray *_reusableCells;
+  NSMutableIndexSet *_loadedRows;
+}
+- (id) initWithBrowser: (NSBrowser *)browser
+             prototype: (NSCell *)prototype
+          numberOfRows: (NSInteger)rows;
+- (id) _loadCellAtRow: (NSInteger)row;
+- (void) _recycleCellAtRow: (NSInteger)row;
+- (void) _recycleCellsOutsideRect: (NSRect)rect;
+- (void) _recycleUnselectedCells;
+@end
+
+@implementation GSBrowserMatrix
+
+- (id) initWithBrowser: (NSBrowser *)browser
+             prototype: (NSCell *)prototype
+          numberOfRows: (NSInteger)rows
+{
+  self = [super initWithFrame: NSMakeRect(0, 0, 100, 100)
+                         mode: NSListModeMatrix
+                    prototype: prototype
+                 numberOfRows: 0
+              numberOfColumns: 0];
+  if (nil == self)
+    return nil;
+
+  _browser = browser;
+  _placeholder = [prototype copy];
+  _reusableCells = [[NSMutableArray alloc] init];
+  _loadedRows = [[NSMutableIndexSet alloc] init];
+  [self renewRows: rows columns: 1];
+
+  return self;
+}
+
+- (void) dealloc
+{
+  RELEASE(_placeholder);
+  RELEASE(_reusableCells);
+  RELEASE(_loadedRows);
+  [super dealloc];
+}
+
+- (NSCell *) makeCellAtRow: (NSInteger)row
+                    column: (NSInteger)column
+{
+  if (_placeholder == nil)
+    {
+      return [super makeCellAtRow: row column: column];
+    }
+  _cells[row][column] = RETAIN(_placeholder);
+  return _placeholder;
+}
+
+- (id) cellAtRow: (NSInteger)row
+          column: (NSInteger)column
+{
+  if (row < 0 || row >= _numRows || column < 0 || column >= _numCols)
+    return nil;
+  return [self _loadCellAtRow: row];
+}
+
+- (id) selectedCell
+{
+  if (_selectedCell == _placeholder && _selectedRow != -1)
+    {
+      [self _loadCellAtRow: _selectedRow];
+    }
+  return [super selectedCell];
+}
+
+- (NSArray *) selectedCells
+{
+  NSInteger i;
+
+  for (i = 0; i < _numRows && _numCols > 0; i++)
+    {
+      if (_selectedCells[i][0])
+        {
+          [self _loadCellAtRow: i];
+        }
+    }
+  return [super selectedCells];
+}
+
+- (NSArray *) cells
+{
+  NSInteger i;
+
+  for (i = 0; i < _numRows && _numCols > 0; i++)
+    {
+      [self _loadCellAtRow: i];
+    }
+  return [super cells];
+}
+
+- (void) drawRect: (NSRect)rect
+{
+  [self _recycleCellsOutsideRect: [self visibleRect]];
+  [super drawRect: rect];
+}
+
+- (void) mouseDown: (NSEvent *)theEvent
+{
+  NSPoint p = [self convertPoint: [theEvent locationInWindow] fromView: nil];
+  NSInteger row, column;
+
+  if ([self getRow: &row column: &column forPoint: p])
+    {
+      [self _loadCellAtRow: row];
+    }
+  [super mouseDown: theEvent];
+}
+
+/* Returns the real cell of row, getting it and having the browser
+   load it if needed. */
+- (id) _loadCellAtRow: (NSInteger)row
+{
+  NSCell *cell = _cells[row][0];
+
+  if (cell == _placeholder)
+    {
+      BOOL selected = _selectedCells[row][0];
+
+      if ([_reusableCells count] > 0)
+        {
+          cell = RETAIN([_reusableCells lastObject]);
+          [_reusableCells removeLastObject];
+        }
+      else
+        {
+          cell = [_cellPrototype copyWithZone: _myZone];
+        }
+      [cell setState: selected ? NSOnState : NSOffState];
+      [cell setHighlighted: selected && _mode == NSListModeMatrix];
+      _cells[row][0] = cell;
+      RELEASE(_placeholder);
+      if (_selectedCell == _placeholder && _selectedRow == row)
+        {
+          _selectedCell = cell;
+        }
+      [_loadedRows addIndex: row];
+    }
+  else if (![cell respondsToSelector: @selector(isLoaded)]
+    || [(NSBrowserCell *)cell isLoaded])
+    {
+      return cell;
+    }
+  [_browser _loadCell: cell atRow: row ofMatrix: self];
+  return cell;
+}
+
+- (void) _recycleCellAtRow: (NSInteger)row
+{
+  NSCell *cell = _cells[row][0];
+
+  if (cell == _placeholder)
+    return;
+
+  if ([cell respondsToSelector: @selector(setLoaded:)])
+    {
+      [(NSBrowserCell *)cell setLoaded: NO];
+    }
+  [_reusableCells addObject: cell];
+  _cells[row][0] = RETAIN(_placeholder);
+  RELEASE(cell);
+  [_loadedRows removeIndex: row];
+}
+
+/* Recycles the cells of unselected rows which are not in rect, and of
+   rows left over after the matrix shrank. */
+- (void) _recycleCellsOutsideRect: (NSRect)rect
+{
+  CGFloat height = _cellSize.height + _intercell.height;
+  NSMutableIndexSet *rows;
+  NSUInteger row;
+
+  if ([_loadedRows count] == 0)
+    return;
+
+  rows = [_loadedRows mutableCopy];
+  if (height > 0 && _numRows > 0 && NSMaxY(rect) > 0)
+    {
+      NSUInteger first = MAX(NSMinY(rect), 0) / height;
+      NSUInteger last = MIN(NSMaxY(rect) / height, _numRows - 1);
+
+      if (first <= last)
+        {
+          [rows removeIndexesInRange: NSMakeRange(first, last - first + 1)];
+        }
+    }
+  for (row = [rows firstIndex]; row != NSNotFound;
+       row = [rows indexGreaterThanIndex: row])
+    {
+      if ((NSInteger)row < _numRows
+          && (_selectedCells[row][0] || (NSInteger)row == _selectedRow
+              || (NSInteger)row == _dottedRow))
+        {
+          continue;
+        }
+      [self _recycleCellAtRow: row];
+    }
+  RELEASE(rows);
+}
+
+/* Prepares the matrix for reloading: the cells of selected rows are
+   kept, so the browser can select them again, but are loaded again when
+   next shown.  All other cells are recycled. */
+- (void) _recycleUnselectedCells
+{
+  NSMutableIndexSet *rows = [_loadedRows mutableCopy];
+  NSUInteger row;
+
+  for (row = [rows firstIndex]; row != NSNotFound;
+       row = [rows indexGreaterThanIndex: row])
+    {
+      if ((NSInteger)row < _numRows && _selectedCells[row][0])
+        {
+          NSCell *cell = _cells[row][0];
+
+          if ([cell respondsToSelector: @selector(setLoaded:)])
+            {
+              [(NSBrowserCell *)cell setLoaded: NO];
+              continue;
+            }
+        }
+      [self _recycleCellAtRow: row];
+    }
+  RELEASE(rows);
+}
+
 @end
 
 //
@@ -2289,6 +2538,7 @@ static NSTextFieldCell *titleCell;
   RELEASE(_horizontalScroller);
   RELEASE(_browserColumns);
   TEST_RELEASE(_charBuffer);
+  TEST_RELEASE(_typeSelectIndex);
 
   [super dealloc];
 }
@@ -2401,7 +2651,7 @@ static NSTextFieldCell *titleCell;
         {
           matrix = [self matrixInColumn: 0];
 
-          if ([[matrix cells] count])
+          if ([matrix numberOfRows] > 0)
             {
               [matrix selectCellAtRow: 0 column: 0];
             }
@@ -2415,7 +2665,7 @@ static NSTextFieldCell *titleCell;
             {
               selectedColumn++;
               matrix = [self matrixInColumn: selectedColumn];
-              if ([[matrix cells] count] && [matrix selectedCell] == nil)
+              if ([matrix numberOfRows] > 0 && [matrix selectedCell] == nil)
                 {
                   [matrix selectCellAtRow: 0 column: 0];
                 }
@@ -2482,9 +2732,8 @@ static NSTextFieldCell *titleCell;
        && ([characters length] > 0))
     {
       NSMatrix *matrix;
-      NSString *sv;
       NSInteger i, n, s;
-      NSInteger match;
+      NSUInteger match;
       NSInteger selectedColumn;
       SEL lcarcSel = @selector(loadedCellAtRow:column:);
       IMP lcarc = [self methodForSelector: lcarcSel];
@@ -2522,43 +2771,37 @@ static NSTextFieldCell *titleCell;
                 }
             }
 
+          if (_alphaNumericalLastColumn != selectedColumn
+              || [_typeSelectIndex count] != (NSUInteger)n)
+            {
+              NSMutableArray *strings;
+
+              /* Get the strings of the column once, and look up the
+                 cells starting with the typed characters in them on
+                 later key presses.  */
+              strings = [NSMutableArray arrayWithCapacity: n];
+              for (i = 0; i < n; i++)
+                {
+                  NSString *sv = [((*lcarc)(self, lcarcSel, i,
+                                            selectedColumn)) stringValue];
+
+                  [strings addObject: (sv != nil) ? sv : @""];
+                }
+              DESTROY(_typeSelectIndex);
+              _typeSelectIndex = [[GSTypeSelectIndex alloc]
+                                   initWithStrings: strings
+                                         foldsCase: NO];
+            }
           _alphaNumericalLastColumn = selectedColumn;
           _lastKeyPressed = [theEvent timestamp];
-          
-          sv = [((*lcarc)(self, lcarcSel, s, selectedColumn))
-                 stringValue];
 
-          if (([sv length] > 0)
-              && ([sv hasPrefix: _charBuffer]))
+          // A selected cell that still matches stays selected
+          match = [_typeSelectIndex itemWithPrefix: _charBuffer
+                                        startingAt: (s < 0) ? 0 : s];
+          if (s >= 0 && match == (NSUInteger)s)
             return;
 
-          match = -1;
-          for (i = s + 1; i < n; i++)
-            {
-              sv = [((*lcarc)(self, lcarcSel, i, selectedColumn))
-                     stringValue];
-              if (([sv length] > 0)
-                  && ([sv hasPrefix: _charBuffer]))
-                {
-                  match = i;
-                  break;
-                }
-            }
-          if (i == n)
-            {
-              for (i = 0; i < s; i++)
-                {
-                  sv = [((*lcarc)(self, lcarcSel, i, selectedColumn))
-                         stringValue];
-                  if (([sv length] > 0)
-                      && ([sv hasPrefix: _charBuffer]))
-                    {
-                      match = i;
-                      break;
-                    }
-                }
-            }
-          if (match != -1)
+          if (match != NSNotFound)
             {
               [matrix deselectAllCells];
               [self selectRow: match
@@ -2887,6 +3130,27 @@ static NSTextFieldCell *titleCell;
   _sendsActionOnAlphaNumericalKeys = flag;
 }
 
+/** Returns YES if columns are loaded lazily.  By default NO.
+    <p>See Also: -setLoadsColumnsLazily:</p> */
+- (BOOL) loadsColumnsLazily
+{
+  return _loadsColumnsLazily;
+}
+
+/** <p>If flag is YES, columns loaded from now on make cells only for the
+    rows which are shown, and the delegate is sent
+    -browser:willDisplayCell:atRow:column: when a row is first drawn or
+    its cell asked for.  Cells of rows which scroll out of view are
+    reused for other rows, so the delegate has to set every attribute of
+    the cell it cares about.  This makes browsing columns with many rows
+    fast.</p>
+    <p>Only browsers with a passive delegate using the NSMatrix class
+    load columns lazily.</p> */
+- (void) setLoadsColumnsLazily: (BOOL)flag
+{
+  _loadsColumnsLazily = flag;
+}
+
 @end
 
 
@@ -2981,7 +3245,15 @@ static NSTextFieldCell *titleCell;
   NSScrollView *sc;
   NSMatrix *matrix;
   NSInteger i, rows, cols;
+  BOOL lazy;
 
+  lazy = (_loadsColumnsLazily && _passiveDelegate
+          && _browserMatrixClass == [NSMatrix class]);
+  if (column == _alphaNumericalLastColumn)
+    {
+      // The cell strings are about to change
+      DESTROY(_typeSelectIndex);
+    }
   if (_passiveDelegate)
     {
       // Ask the delegate for the number of rows
@@ -3001,7 +3273,19 @@ static NSTextFieldCell *titleCell;
 
   matrix = [bc columnMatrix];
 
-  if (_reusesColumns && matrix)
+  // A matrix can't be reused if the column was loaded in the other mode
+  if (matrix != nil
+      && lazy != [matrix isKindOfClass: [GSBrowserMatrix class]])
+    {
+      matrix = nil;
+    }
+
+  if (_reusesColumns && matrix && lazy)
+    {
+      [(GSBrowserMatrix *)matrix _recycleUnselectedCells];
+      [matrix renewRows: rows columns: cols];
+    }
+  else if (_reusesColumns && matrix)
     {
       [matrix renewRows: rows columns: cols];
 
@@ -3017,12 +3301,22 @@ static NSTextFieldCell *titleCell;
       NSSize matrixIntercellSpace = {0, 0};
 
       // create a new col matrix
-      matrix = [[_browserMatrixClass alloc]
-                   initWithFrame: matrixRect
-                   mode: NSListModeMatrix
-                   prototype: _browserCellPrototype
-                   numberOfRows: rows
-                   numberOfColumns: cols];
+      if (lazy)
+        {
+          matrix = [[GSBrowserMatrix alloc]
+                     initWithBrowser: self
+                           prototype: _browserCellPrototype
+                        numberOfRows: rows];
+        }
+      else
+        {
+          matrix = [[_browserMatrixClass alloc]
+                       initWithFrame: matrixRect
+                       mode: NSListModeMatrix
+                       prototype: _browserCellPrototype
+                       numberOfRows: rows
+                       numberOfColumns: cols];
+        }
       [matrix setIntercellSpacing: matrixIntercellSpace];
       [matrix setAllowsEmptySelection: _allowsEmptySelection];
       [matrix setAutoscroll: YES];
@@ -3046,7 +3340,11 @@ static NSTextFieldCell *titleCell;
   [sc setDocumentView: matrix];
 
   // Loading is different based upon passive/active delegate
-  if (_passiveDelegate)
+  if (lazy)
+    {
+      // Cells are loaded when they are shown
+    }
+  else if (_passiveDelegate)
     {
       // Now loop through the cells and load each one
       id aCell;
@@ -3106,6 +3404,32 @@ static NSTextFieldCell *titleCell;
   [self displayColumn: column];
 }
 
+/* Has the delegate load a cell of a lazily loaded column. */
+- (void) _loadCell: (NSCell *)cell
+             atRow: (NSInteger)row
+          ofMatrix: (NSMatrix *)matrix
+{
+  NSInteger column, count;
+
+  count = [_browserColumns count];
+  for (column = 0; column < count; column++)
+    {
+      if ([[_browserColumns objectAtIndex: column] columnMatrix] == matrix)
+        break;
+    }
+  if (column == count)
+    return;
+
+  [_browserDelegate browser: self
+            willDisplayCell: cell
+                      atRow: row
+                     column: column];
+  if ([cell respondsToSelector: @selector(setLoaded:)])
+    {
+      [(NSBrowserCell *)cell setLoaded: YES];
+    }
+}
+
 /* Get the title of a column. */
 - (NSString *) _getTitleOfColumn: (NSInteger)column
 {
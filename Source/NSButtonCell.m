@@ -106,6 +106,34 @@ typedef struct _GSButtonCellFlags
 #endif
 } GSButtonCellFlags;
 
+/*
+ * Where the image and the title of the normal or the alternate contents
+ * went the last time they were drawn.  The rectangles are relative to the
+ * origin of the frame, so that moving a button does not lose them.
+ */
+typedef struct {
+  NSImage *image;
+  NSAttributedString *title;
+  NSSize imageSize;
+  NSSize frameSize;
+  NSUInteger key;
+  BOOL draws_image;
+  BOOL draws_title;
+  NSRect imageRect;
+  NSRect titleRect;
+} GSButtonCellLayout;
+
+typedef struct {
+  GSButtonCellLayout contents[2];
+} GSButtonCellLayoutCache;
+
+#define LAYOUT_CACHE ((GSButtonCellLayoutCache*)_layout_cache)
+
+@interface NSButtonCell (LayoutCache)
+- (GSButtonCellLayout*) _layoutForAlternateContents: (BOOL)flag;
+- (void) _invalidateLayoutCache;
+@end
+
 @interface NSCell (Private)
 - (NSSize) _scaleImageWithSize: (NSSize)imageSize
                    toFitInSize: (NSSize)canvasSize
@@ -181,6 +209,7 @@ typedef struct _GSButtonCellFlags
   RELEASE(_keyEquivalentFont);
   RELEASE(_sound);
   RELEASE(_backgroundColor);
+  [self _invalidateLayoutCache];
 
   [super dealloc];
 }
@@ -356,6 +385,7 @@ typedef struct _GSButtonCellFlags
 {
   ASSIGNCOPY(_contents, aString);
   _cell.contents_is_attributed_string = NO;
+  [self _invalidateTitleCache];
 
   if (_control_view)
     {
@@ -373,6 +403,7 @@ typedef struct _GSButtonCellFlags
 - (void) setAlternateTitle: (NSString*)aString
 {
   ASSIGNCOPY(_altContents, aString);
+  [self _invalidateLayoutCache];
 
   if (_control_view)
     {
@@ -412,14 +443,7 @@ typedef struct _GSButtonCellFlags
     }
   else
     {
-      NSDictionary *dict;
-      NSAttributedString *attrStr;
-
-      dict = [self _nonAutoreleasedTypingAttributes];
-      attrStr = [[NSAttributedString alloc] initWithString: [self title]
-                                            attributes: dict];
-      RELEASE(dict);
-      return AUTORELEASE(attrStr);
+      return [self _titleForString: [self title]];
     }
 }
 
@@ -427,6 +451,7 @@ typedef struct _GSButtonCellFlags
 {
   ASSIGNCOPY(_contents, aString);
   _cell.contents_is_attributed_string = YES;
+  [self _invalidateTitleCache];
 
   if (_control_view)
     {
@@ -505,6 +530,7 @@ typedef struct _GSButtonCellFlags
     }
   
   [super setImage: anImage];
+  [self _invalidateLayoutCache];
 }
 
 /**<p>Sets the NSButtonCell's alternate image to <var>anImage</var>.</p>
@@ -513,6 +539,7 @@ typedef struct _GSButtonCellFlags
 - (void) setAlternateImage: (NSImage*)anImage
 {
   ASSIGN(_altImage, anImage);
+  [self _invalidateLayoutCache];
 
   if (_control_view)
     {
@@ -533,6 +560,7 @@ typedef struct _GSButtonCellFlags
 - (void) setImagePosition: (NSCellImagePosition)aPosition
 {
   _cell.image_position = aPosition;
+  [self _invalidateLayoutCache];
    
   // In the GNUstep NSButtonCell implementation, the cell type depends only on
   // the image position. 
@@ -697,6 +725,7 @@ typedef struct _GSButtonCellFlags
 - (void) setBezelStyle: (NSBezelStyle)bezelStyle
 {
   _bezel_style = bezelStyle;
+  [self _invalidateLayoutCache];
 }
 
 - (BOOL) showsBorderOnlyWhileMouseInside
@@ -1103,6 +1132,8 @@ typedef struct _GSButtonCellFlags
   NSSize titleSize = {0, 0};
   BOOL flippedView = [controlView isFlipped];
   NSCellImagePosition ipos = _cell.image_position;
+  NSUInteger key;
+  GSButtonCellLayout *layout;
 
   // transparent buttons never draw
   if (_buttoncell_is_transparent)
@@ -1150,181 +1181,220 @@ typedef struct _GSButtonCellFlags
       titleToDisplay = [self attributedTitle];
     }
 
-  if (imageToDisplay && ipos != NSNoImage)
-    {
-      imageSize = [imageToDisplay size];
-    }
-  else
-    {
-      // When there is no image to display, ignore it in the calculations
-      imageToDisplay = nil;
-      ipos = NSNoImage;
-    }
-
-  if (titleToDisplay && ipos != NSImageOnly)
+  /*
+   * The placement depends only on what is displayed, where the image goes
+   * and the size of the frame, so it is kept for the normal and the
+   * alternate contents and reused while these stay the same.
+   */
+  key = ipos | (_cell.is_bordered << 3) | (_cell.is_bezeled << 4)
+    | (flippedView << 5);
+  layout = [self _layoutForAlternateContents: (mask & NSContentsCellMask)];
+  if (layout->image == imageToDisplay && layout->title == titleToDisplay
+    && layout->key == key && NSEqualSizes(layout->frameSize, cellFrame.size)
+    && (imageToDisplay == nil
+      || NSEqualSizes(layout->imageSize, [imageToDisplay size])))
     {
-      titleSize = [titleToDisplay size];
+      if (!layout->draws_image)
+        imageToDisplay = nil;
+      if (!layout->draws_title)
+        titleToDisplay = nil;
+      imageRect = NSOffsetRect(layout->imageRect,
+                               NSMinX(cellFrame), NSMinY(cellFrame));
+      titleRect = NSOffsetRect(layout->titleRect,
+                               NSMinX(cellFrame), NSMinY(cellFrame));
     }
   else
     {
-      // When there is no text to display, ignore it in the calculations
-      titleToDisplay = nil;
-      ipos = NSImageOnly;
-    }
-
-  if (flippedView == YES)
-    {
-      if (ipos == NSImageAbove)
+      ASSIGN(layout->image, imageToDisplay);
+      ASSIGN(layout->title, titleToDisplay);
+      layout->imageSize = (imageToDisplay != nil)
+        ? [imageToDisplay size] : NSZeroSize;
+      layout->key = key;
+      layout->frameSize = cellFrame.size;
+
+      if (imageToDisplay && ipos != NSNoImage)
         {
-          ipos = NSImageBelow;
+          imageSize = [imageToDisplay size];
         }
-      else if (ipos == NSImageBelow)
+      else
         {
-          ipos = NSImageAbove;
+          // When there is no image to display, ignore it in the calculations
+          imageToDisplay = nil;
+          ipos = NSNoImage;
         }
-    }
-  
-  /*
-  The size calculations here should be changed very carefully, and _must_ be
-  kept in sync with -cellSize. Changing the calculations to require more
-  space isn't OK; this breaks interfaces designed using the old sizes by
-  clipping away parts of the title.
-
-  The current size calculations ensure that for bordered or bezeled cells,
-  there's always at least a three point margin between the size returned by
-  -cellSize and the minimum size required not to clip text. (In other words,
-  the text can become three points wider (due to eg. font mismatches) before
-  you lose the last character.)
-  */
-  switch (ipos)
-    {
-      default:
-      case NSNoImage: 
-        imageToDisplay = nil;
-        titleRect = cellFrame;
-         imageRect = NSZeroRect;
-        if (titleSize.width + 6 <= titleRect.size.width)
-          {
-            titleRect.origin.x += 3;
-            titleRect.size.width -= 6;
-          }
-        break;
-
-      case NSImageOnly: 
-        titleToDisplay = nil;
-        imageRect = cellFrame;
-        titleRect = NSZeroRect;
-        break;
 
-      case NSImageLeft: 
-        imageRect.origin = cellFrame.origin;
-        imageRect.size.width = imageSize.width;
-        imageRect.size.height = cellFrame.size.height;
-        if (_cell.is_bordered || _cell.is_bezeled) 
-          {
-            imageRect.origin.x += 3;
-          }
-        titleRect = imageRect;
-        titleRect.origin.x += imageSize.width + GSCellTextImageXDist;
-        titleRect.size.width = NSMaxX(cellFrame) - titleRect.origin.x;
-        if (titleSize.width + 3 <= titleRect.size.width)
-          {
-            titleRect.size.width -= 3;
-          }
-        break;
-
-      case NSImageRight: 
-        imageRect.origin.x = NSMaxX(cellFrame) - imageSize.width;
-        imageRect.origin.y = cellFrame.origin.y;
-        imageRect.size.width = imageSize.width;
-        imageRect.size.height = cellFrame.size.height;
-        if (_cell.is_bordered || _cell.is_bezeled) 
-          {
-            imageRect.origin.x -= 3;
-          }
-        titleRect.origin = cellFrame.origin;
-        titleRect.size.width = imageRect.origin.x - titleRect.origin.x
-                               - GSCellTextImageXDist;
-        titleRect.size.height = cellFrame.size.height;
-        if (titleSize.width + 3 <= titleRect.size.width)
-          {
-            titleRect.origin.x += 3;
-            titleRect.size.width -= 3;
-          }
-        break;
+      if (titleToDisplay && ipos != NSImageOnly)
+        {
+          titleSize = [self _sizeOfTitle: titleToDisplay];
+        }
+      else
+        {
+          // When there is no text to display, ignore it in the calculations
+          titleToDisplay = nil;
+          ipos = NSImageOnly;
+        }
 
-      case NSImageAbove: 
-        /*
-         * In this case, imageRect is all the space we can allocate
-         * above the text. 
-         * The drawing code below will then center the image in imageRect.
-         */
-        titleRect.origin = cellFrame.origin;
-        titleRect.size.width = cellFrame.size.width;
-        titleRect.size.height = titleSize.height;
-        if (_cell.is_bordered || _cell.is_bezeled) 
-          {
-            titleRect.origin.y += 3;
-          }
-
-        imageRect.origin.x = cellFrame.origin.x;
-        imageRect.origin.y = NSMaxY(titleRect) + GSCellTextImageYDist;
-        imageRect.size.width = cellFrame.size.width;
-        imageRect.size.height = NSMaxY(cellFrame) - imageRect.origin.y;
-
-        if (_cell.is_bordered || _cell.is_bezeled) 
-          {
-            imageRect.size.height -= 3;
-          }
-        if (titleSize.width + 6 <= titleRect.size.width)
-          {
-            titleRect.origin.x += 3;
-            titleRect.size.width -= 6;
-          }
-        break;
+      if (flippedView == YES)
+        {
+          if (ipos == NSImageAbove)
+            {
+              ipos = NSImageBelow;
+            }
+          else if (ipos == NSImageBelow)
+            {
+              ipos = NSImageAbove;
+            }
+        }
 
-      case NSImageBelow: 
-        /*
-         * In this case, imageRect is all the space we can allocate
-         * below the text. 
-         * The drawing code below will then center the image in imageRect.
-         */
-        titleRect.origin.x = cellFrame.origin.x;
-        titleRect.origin.y = NSMaxY(cellFrame) - titleSize.height;
-        titleRect.size.width = cellFrame.size.width;
-        titleRect.size.height = titleSize.height;
-        if (_cell.is_bordered || _cell.is_bezeled)
-          {
-            titleRect.origin.y -= 3;
-          }
-
-        imageRect.origin.x = cellFrame.origin.x;
-        imageRect.origin.y = cellFrame.origin.y;
-        imageRect.size.width = cellFrame.size.width;
-        imageRect.size.height
-          = titleRect.origin.y - GSCellTextImageYDist - imageRect.origin.y;
-
-        if (_cell.is_bordered || _cell.is_bezeled) 
-          {
-            imageRect.origin.y += 3;
-            imageRect.size.height -= 3;
-          }
-        if (titleSize.width + 6 <= titleRect.size.width)
-          {
-            titleRect.origin.x += 3;
-            titleRect.size.width -= 6;
-          }
-        break;
+      /*
+      The size calculations here should be changed very carefully, and _must_ be
+      kept in sync with -cellSize. Changing the calculations to require more
+      space isn't OK; this breaks interfaces designed using the old sizes by
+      clipping away parts of the title.
+
+      The current size calculations ensure that for bordered or bezeled cells,
+      there's always at least a three point margin between the size returned by
+      -cellSize and the minimum size required not to clip text. (In other words,
+      the text can become three points wider (due to eg. font mismatches) before
+      you lose the last character.)
+      */
+      switch (ipos)
+        {
+          default:
+          case NSNoImage: 
+            imageToDisplay = nil;
+            titleRect = cellFrame;
+             imageRect = NSZeroRect;
+            if (titleSize.width + 6 <= titleRect.size.width)
+              {
+                titleRect.origin.x += 3;
+                titleRect.size.width -= 6;
+              }
+            break;
+
+          case NSImageOnly: 
+            titleToDisplay = nil;
+            imageRect = cellFrame;
+            titleRect = NSZeroRect;
+            break;
+
+          case NSImageLeft: 
+            imageRect.origin = cellFrame.origin;
+            imageRect.size.width = imageSize.width;
+            imageRect.size.height = cellFrame.size.height;
+            if (_cell.is_bordered || _cell.is_bezeled) 
+              {
+                imageRect.origin.x += 3;
+              }
+            titleRect = imageRect;
+            titleRect.origin.x += imageSize.width + GSCellTextImageXDist;
+            titleRect.size.width = NSMaxX(cellFrame) - titleRect.origin.x;
+            if (titleSize.width + 3 <= titleRect.size.width)
+              {
+                titleRect.size.width -= 3;
+              }
+            break;
+
+          case NSImageRight: 
+            imageRect.origin.x = NSMaxX(cellFrame) - imageSize.width;
+            imageRect.origin.y = cellFrame.origin.y;
+            imageRect.size.width = imageSize.width;
+            imageRect.size.height = cellFrame.size.height;
+            if (_cell.is_bordered || _cell.is_bezeled) 
+              {
+                imageRect.origin.x -= 3;
+              }
+            titleRect.origin = cellFrame.origin;
+            titleRect.size.width = imageRect.origin.x - titleRect.origin.x
+                                   - GSCellTextImageXDist;
+            titleRect.size.height = cellFrame.size.height;
+            if (titleSize.width + 3 <= titleRect.size.width)
+              {
+                titleRect.origin.x += 3;
+                titleRect.size.width -= 3;
+              }
+            break;
+
+          case NSImageAbove: 
+            /*
+             * In this case, imageRect is all the space we can allocate
+             * above the text. 
+             * The drawing code below will then center the image in imageRect.
+             */
+            titleRect.origin = cellFrame.origin;
+            titleRect.size.width = cellFrame.size.width;
+            titleRect.size.height = titleSize.height;
+            if (_cell.is_bordered || _cell.is_bezeled) 
+              {
+                titleRect.origin.y += 3;
+              }
+
+            imageRect.origin.x = cellFrame.origin.x;
+            imageRect.origin.y = NSMaxY(titleRect) + GSCellTextImageYDist;
+            imageRect.size.width = cellFrame.size.width;
+            imageRect.size.height = NSMaxY(cellFrame) - imageRect.origin.y;
+
+            if (_cell.is_bordered || _cell.is_bezeled) 
+              {
+                imageRect.size.height -= 3;
+              }
+            if (titleSize.width + 6 <= titleRect.size.width)
+              {
+                titleRect.origin.x += 3;
+                titleRect.size.width -= 6;
+              }
+            break;
+
+          case NSImageBelow: 
+            /*
+             * In this case, imageRect is all the space we can allocate
+             * below the text. 
+             * The drawing code below will then center the image in imageRect.
+             */
+            titleRect.origin.x = cellFrame.origin.x;
+            titleRect.origin.y = NSMaxY(cellFrame) - titleSize.height;
+            titleRect.size.width = cellFrame.size.width;
+            titleRect.size.height = titleSize.height;
+            if (_cell.is_bordered || _cell.is_bezeled)
+              {
+                titleRect.origin.y -= 3;
+              }
+
+            imageRect.origin.x = cellFrame.origin.x;
+            imageRect.origin.y = cellFrame.origin.y;
+            imageRect.size.width = cellFrame.size.width;
+            imageRect.size.height
+              = titleRect.origin.y - GSCellTextImageYDist - imageRect.origin.y;
+
+            if (_cell.is_bordered || _cell.is_bezeled) 
+              {
+                imageRect.origin.y += 3;
+                imageRect.size.height -= 3;
+              }
+            if (titleSize.width + 6 <= titleRect.size.width)
+              {
+                titleRect.origin.x += 3;
+                titleRect.size.width -= 6;
+              }
+            break;
+
+          case NSImageOverlaps: 
+            imageRect = cellFrame;
+            titleRect = cellFrame;
+            if (titleSize.width + 6 <= titleRect.size.width)
+              {
+                titleRect.origin.x += 3;
+                titleRect.size.width -= 6;
+              }
+            break;
+        }
 
-      case NSImageOverlaps: 
-        imageRect = cellFrame;
-        titleRect = cellFrame;
-        if (titleSize.width + 6 <= titleRect.size.width)
-          {
-            titleRect.origin.x += 3;
-            titleRect.size.width -= 6;
-          }
-        break;
+      layout->draws_image = (imageToDisplay != nil);
+      layout->draws_title = (titleToDisplay != nil);
+      layout->imageRect = NSOffsetRect(imageRect,
+                                       -NSMinX(cellFrame), -NSMinY(cellFrame));
+      layout->titleRect = NSOffsetRect(titleRect,
+                                       -NSMinX(cellFrame), -NSMinY(cellFrame));
     }
 
   // Draw image
@@ -1393,7 +1463,7 @@ typedef struct _GSButtonCellFlags
 
   if (titleToDisplay != nil)
     {
-      titleSize = [titleToDisplay size];
+      titleSize = [self _sizeOfTitle: titleToDisplay];
     }
   
   switch (_cell.image_position)
@@ -1596,6 +1666,7 @@ typedef struct _GSButtonCellFlags
 {
   NSButtonCell *c = [super copyWithZone: zone];
   
+  c->_layout_cache = NULL;
   c->_altContents = [_altContents copyWithZone: zone];
   _altImage = TEST_RETAIN(_altImage);
   _keyEquivalent = TEST_RETAIN(_keyEquivalent);
@@ -1966,3 +2037,42 @@ typedef struct _GSButtonCellFlags
 }
 
 @end
+
+@implementation NSButtonCell (LayoutCache)
+
+- (GSButtonCellLayout*) _layoutForAlternateContents: (BOOL)flag
+{
+  if (_layout_cache == NULL)
+    {
+      _layout_cache = NSZoneCalloc([self zone], 1,
+                                   sizeof(GSButtonCellLayoutCache));
+    }
+  return &LAYOUT_CACHE->contents[flag ? 1 : 0];
+}
+
+- (void) _invalidateLayoutCache
+{
+  GSButtonCellLayoutCache *cache = LAYOUT_CACHE;
+
+  if (cache != NULL)
+    {
+      int i;
+
+      _layout_cache = NULL;
+      for (i = 0; i < 2; i++)
+        {
+          RELEASE(cache->contents[i].image);
+          RELEASE(cache->contents[i].title);
+        }
+      NSZoneFree([self zone], cache);
+    }
+}
+
+/* The placement depends on the title, so it goes when the title does.  */
+- (void) _invalidateTitleCache
+{
+  [super _invalidateTitleCache];
+  [self _invalidateLayoutCache];
+}
+
+@end
@@ -76,6 +76,26 @@ static Class imageClass;
 static NSColor *txtCol;
 static NSColor *dtxtCol;
 
+/*
+ * The attributed string built from a plain title, and its size, are kept
+ * until the title or anything which goes into its attributes changes, so
+ * that a cell drawn or sized over and over does not build and measure the
+ * same string each time.  The setters drop the cache, and since subclasses
+ * may change the ivars or override the accessors the inputs are also
+ * compared before the cached string is used.
+ */
+typedef struct {
+  NSString *string;
+  NSFont *font;
+  NSColor *color;
+  NSUInteger style;
+  NSAttributedString *title;
+  NSSize size;
+  BOOL size_valid;
+} GSCellTitleCache;
+
+#define TITLE_CACHE ((GSCellTitleCache*)_title_cache)
+
 @interface NSCell (PrivateColor)
 + (void) _systemColorsChanged: (NSNotification*)n;
 @end
@@ -230,6 +250,7 @@ static NSColor *dtxtCol;
   TEST_RELEASE (_object_value);
   TEST_RELEASE (_formatter);
   TEST_RELEASE (_menu);
+  [self _invalidateTitleCache];
 
   [super dealloc];
 }
@@ -395,6 +416,7 @@ static NSColor *dtxtCol;
     }
 
   ASSIGNCOPY(_contents, newContents);
+  [self _invalidateTitleCache];
 }
 
 
@@ -494,6 +516,7 @@ static NSColor *dtxtCol;
           ASSIGNCOPY(_contents, aString);
           _cell.contents_is_attributed_string = NO;
           _cell.has_valid_object_value = NO;
+          [self _invalidateTitleCache];
         }
     }
 }
@@ -913,6 +936,7 @@ static NSColor *dtxtCol;
 {
   // This does not have any influence on attributed strings
   _cell.text_align = mode;
+  [self _invalidateTitleCache];
 }
 
 /**<p>Sets whether the NSCell's text is editable.</p>
@@ -940,6 +964,7 @@ static NSColor *dtxtCol;
 
   // This does not have any influence on attributed strings
   ASSIGN (_font, fontObject);
+  [self _invalidateTitleCache];
 }
 
 /**<p>Sets whether the cell selectable. Making a cell unselectable also
@@ -1011,6 +1036,7 @@ static NSColor *dtxtCol;
 
   ASSIGN (_contents, attribStr);
   _cell.contents_is_attributed_string = YES;
+  [self _invalidateTitleCache];
 }
 
 - (NSAttributedString*) attributedStringValue
@@ -1038,14 +1064,7 @@ static NSColor *dtxtCol;
     }
   else
     {
-      NSDictionary *dict;
-      NSAttributedString *attrStr;
-
-      dict = [self _nonAutoreleasedTypingAttributes];
-      attrStr = [[NSAttributedString alloc] initWithString: [self stringValue]
-                                            attributes: dict];
-      RELEASE(dict);
-      return AUTORELEASE(attrStr);
+      return [self _titleForString: [self stringValue]];
     }
 }
 
@@ -1095,6 +1114,7 @@ static NSColor *dtxtCol;
       _cell.is_scrollable = NO;
     }
   _cell.line_break_mode = mode;
+  [self _invalidateTitleCache];
 }
 
 - (NSWritingDirection) baseWritingDirection
@@ -1105,6 +1125,7 @@ static NSColor *dtxtCol;
 - (void) setBaseWritingDirection: (NSWritingDirection)direction
 {
   _cell.base_writing_direction = direction;
+  [self _invalidateTitleCache];
 }
 
 /**<p>Implemented by subclasses to return the action method.
@@ -1866,7 +1887,7 @@ static NSColor *dtxtCol;
           attrStr = [self attributedStringValue];
           if ([attrStr length] != 0)
             {
-              s = [attrStr size];
+              s = [self _sizeOfTitle: attrStr];
             }
           else
             {
@@ -1966,6 +1987,7 @@ static NSColor *dtxtCol;
 - (void) setControlSize: (NSControlSize)controlSize
 {
   _cell.control_size = controlSize;
+  [self _invalidateTitleCache];
 }
 
 - (NSControlSize) controlSize
@@ -2335,6 +2357,7 @@ static NSColor *dtxtCol;
 
   /* Hmmm. */
   c->_contents = [_contents copyWithZone: zone];
+  c->_title_cache = NULL;
   /* Because of performance issues (and because so the doc says) only
      pointers to the objects are copied.  We need to RETAIN them all
      though. */
@@ -2841,6 +2864,82 @@ static NSColor *dtxtCol;
   return size;
 }
 
+/**
+ * Private internal method, returns string with the typing attributes of
+ * the cell.  The result is kept in the title cache and returned again
+ * until string or the attributes change.
+ */
+- (NSAttributedString*) _titleForString: (NSString*)string
+{
+  NSColor *color = [self textColor];
+  NSUInteger style;
+  GSCellTitleCache *cache;
+  NSDictionary *dict;
+
+  style = [self alignment] | ([self lineBreakMode] << 4)
+    | ([self baseWritingDirection] << 8) | (_cell.control_size << 12);
+  cache = TITLE_CACHE;
+  if (cache != NULL && cache->string == string
+    && cache->font == _font && cache->color == color
+    && cache->style == style)
+    {
+      return AUTORELEASE(RETAIN(cache->title));
+    }
+
+  [self _invalidateTitleCache];
+  cache = NSZoneCalloc([self zone], 1, sizeof(GSCellTitleCache));
+  cache->string = RETAIN(string);
+  cache->font = RETAIN(_font);
+  cache->color = RETAIN(color);
+  cache->style = style;
+  dict = [self _nonAutoreleasedTypingAttributes];
+  cache->title = [[NSAttributedString alloc] initWithString: string
+                                                 attributes: dict];
+  RELEASE(dict);
+  _title_cache = cache;
+  return AUTORELEASE(RETAIN(cache->title));
+}
+
+/**
+ * Private internal method, returns the size of aString, which is kept
+ * with the title cache when aString is the cached title.
+ */
+- (NSSize) _sizeOfTitle: (NSAttributedString*)aString
+{
+  GSCellTitleCache *cache = TITLE_CACHE;
+
+  if (cache == NULL || cache->title != aString)
+    {
+      return [aString size];
+    }
+  if (!cache->size_valid)
+    {
+      cache->size = [aString size];
+      cache->size_valid = YES;
+    }
+  return cache->size;
+}
+
+/**
+ * Private internal method, drops the prepared title and its size.
+ * Subclasses which change what goes into the title behind the back of
+ * the setters should call it.
+ */
+- (void) _invalidateTitleCache
+{
+  GSCellTitleCache *cache = TITLE_CACHE;
+
+  if (cache != NULL)
+    {
+      _title_cache = NULL;
+      RELEASE(cache->string);
+      RELEASE(cache->font);
+      RELEASE(cache->color);
+      RELEASE(cache->title);
+      NSZoneFree([self zone], cache);
+    }
+}
+
 /**
  * Private internal method, returns an attributed string to display.
  */
@@ -2879,7 +2978,7 @@ static NSColor *dtxtCol;
   if (aString == nil)
     return;
 
-  titleSize = [aString size];
+  titleSize = [self _sizeOfTitle: aString];
 
   /** Important: text should always be vertically centered without
    * considering descender [as if descender did not exist].
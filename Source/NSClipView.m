@@ -30,6 +30,7 @@
 #import <Foundation/NSNotification.h>
 #import <Foundation/NSException.h>
 
+#import "AppKit/NSCachedImageRep.h"
 #import "AppKit/NSClipView.h"
 #import "AppKit/NSCursor.h"
 #import "AppKit/NSColor.h"
@@ -41,13 +42,36 @@
 
 #import <GNUstepGUI/GSNibLoading.h>
 #import "GSGuiPrivate.h"
+#import "NSViewPrivate.h"
 
 #include <math.h>
 
 @interface NSClipView (Private)
 - (void) _scrollToPoint: (NSPoint)aPoint;
+- (void) _exposeRect: (NSRect)aRect;
+- (void) _scheduleOverdrawUpdate;
+- (void) _updateOverdraw;
 @end
 
+/*
+ * What a clip view with an overdraw margin keeps of its document view.
+ * bits holds the pixels the window showed for the valid rect, which is
+ * in the coordinates of the document view, with the first pixel of bits
+ * at the bottom left corner of the rect in the window.
+ */
+typedef struct {
+  CGFloat margin;
+  NSCachedImageRep *bits;
+  NSRect valid;
+  BOOL scrolling;	/* Marks made while scrolling keep the bits.	*/
+  BOOL scheduled;	/* An update of the bits is waiting.		*/
+} GSClipViewOverdraw;
+
+#define OVERDRAW ((GSClipViewOverdraw*)_overdraw)
+
+/* How long after a scroll to wait before keeping what it showed.  */
+#define OVERDRAW_DELAY 0.1
+
 /*
  * Return the biggest integral (in device space) rect contained in rect. 
  * Conversion to/from device space is done using view.
@@ -110,6 +134,7 @@ static inline NSRect integralRect (NSRect rect, NSView *view)
 
 - (void) dealloc
 {
+  [self setOverdrawMargin: 0.0];
   [self setDocumentView: nil];
   RELEASE(_cursor);
   RELEASE(_backgroundColor);
@@ -132,6 +157,7 @@ static inline NSRect integralRect (NSRect rect, NSView *view)
       return;
     }
   
+  [self _discardOverdraw];
   nc = [NSNotificationCenter defaultCenter];
   if (_documentView)
     {
@@ -240,6 +266,7 @@ static inline NSRect integralRect (NSRect rect, NSView *view)
 - (void) setBounds: (NSRect)b
 {
   // FIXME: Shouldn't the document view be marked as needing a redraw?
+  [self _discardOverdraw];
   [super setBounds: b];
   [_super_view reflectScrolledClipView: self];
 }
@@ -247,6 +274,7 @@ static inline NSRect integralRect (NSRect rect, NSView *view)
 - (void) setBoundsSize: (NSSize)aSize
 {
   // FIXME: Shouldn't the document view be marked as needing a redraw?
+  [self _discardOverdraw];
   [super setBoundsSize: aSize];
   [_super_view reflectScrolledClipView: self];
 }
@@ -287,6 +315,13 @@ static inline NSRect integralRect (NSRect rect, NSView *view)
          integral rects in device space - adjust our copy rect */
       intersection = integralRect (intersection, self);
 
+      /* The parts which have to be shown again may be in the bits
+         kept around the visible rect, which stay valid meanwhile.  */
+      if (_overdraw != NULL)
+        {
+          OVERDRAW->scrolling = YES;
+        }
+
       /* At this point, intersection is the rectangle containing the
          image we can recycle from the old to the new situation.  We
          must not make any assumption on its position/size, because it
@@ -297,8 +332,7 @@ static inline NSRect integralRect (NSRect rect, NSView *view)
           // no recyclable part -- docview should redraw everything
           // from scratch
           [super setBoundsOrigin: newBounds.origin];
-          [_documentView setNeedsDisplayInRect: 
-                             [self documentVisibleRect]];
+          [self _exposeRect: _bounds];
         }
       else
         {
@@ -335,9 +369,7 @@ static inline NSRect integralRect (NSRect rect, NSView *view)
                                   _bounds.size.height);
           if (NSIsEmptyRect(redrawRect) == NO)
             {
-              [_documentView setNeedsDisplayInRect: 
-                                 [self convertRect: redrawRect 
-                                       toView: _documentView]];
+              [self _exposeRect: redrawRect];
             }
           
           /* Right */
@@ -346,9 +378,7 @@ static inline NSRect integralRect (NSRect rect, NSView *view)
                                   _bounds.size.height);
           if (NSIsEmptyRect(redrawRect) == NO)
             {
-              [_documentView setNeedsDisplayInRect: 
-                                 [self convertRect: redrawRect 
-                                       toView: _documentView]];
+              [self _exposeRect: redrawRect];
             }
           
           /* Up (or Down according to whether it's flipped or not) */
@@ -357,9 +387,7 @@ static inline NSRect integralRect (NSRect rect, NSView *view)
                                   NSMinY(intersection) - NSMinY(_bounds));
           if (NSIsEmptyRect(redrawRect) == NO)
             {
-              [_documentView setNeedsDisplayInRect: 
-                                 [self convertRect: redrawRect 
-                                       toView: _documentView]];
+              [self _exposeRect: redrawRect];
             }
           
           /* Down (or Up) */
@@ -368,11 +396,14 @@ static inline NSRect integralRect (NSRect rect, NSView *view)
                                   NSMaxY(_bounds) - NSMaxY(intersection));
           if (NSIsEmptyRect(redrawRect) == NO)
             {
-              [_documentView setNeedsDisplayInRect: 
-                                 [self convertRect: redrawRect 
-                                       toView: _documentView]];
+              [self _exposeRect: redrawRect];
             }
         }
+      if (_overdraw != NULL)
+        {
+          OVERDRAW->scrolling = NO;
+        }
+      [self _scheduleOverdrawUpdate];
     }
   else
     {
@@ -531,6 +562,7 @@ static inline NSRect integralRect (NSRect rect, NSView *view)
 
 - (void) viewBoundsChanged: (NSNotification*)aNotification
 {
+  [self _discardOverdraw];
   [_super_view reflectScrolledClipView: self];
 }
 
@@ -539,6 +571,7 @@ static inline NSRect integralRect (NSRect rect, NSView *view)
  */
 - (void) viewFrameChanged: (NSNotification*)aNotification
 {
+  [self _discardOverdraw];
   [self _scrollToPoint: _bounds.origin];
 
   /* If document frame does not completely cover _bounds */
@@ -555,6 +588,7 @@ static inline NSRect integralRect (NSRect rect, NSView *view)
 
 - (void) scaleUnitSquareToSize: (NSSize)newUnitSize
 {
+  [self _discardOverdraw];
   [super scaleUnitSquareToSize: newUnitSize];
   [_super_view reflectScrolledClipView: self];
 }
@@ -609,6 +643,51 @@ static inline NSRect integralRect (NSRect rect, NSView *view)
   return _copiesOnScroll;
 }
 
+/**
+ * Sets the height and width of the document view around its visible
+ * rect which the receiver keeps, to show it without drawing it again
+ * when it is scrolled back into sight.  A margin of 0, the default,
+ * keeps nothing.  What the receiver keeps is copied from the window
+ * shortly after each scroll, and is thrown away as soon as anything
+ * in the document view is marked as needing display.  Only used when
+ * the receiver copies on scroll.
+ */
+- (void) setOverdrawMargin: (CGFloat)margin
+{
+  if (margin <= 0.0)
+    {
+      if (_overdraw != NULL)
+        {
+          [NSObject cancelPreviousPerformRequestsWithTarget: self
+                                                   selector: @selector(_updateOverdraw)
+                                                     object: nil];
+          RELEASE(OVERDRAW->bits);
+          NSZoneFree(NSDefaultMallocZone(), _overdraw);
+          _overdraw = NULL;
+          _rFlags.keeps_overdraw = NO;
+        }
+      return;
+    }
+
+  if (_overdraw == NULL)
+    {
+      _overdraw = NSZoneCalloc(NSDefaultMallocZone(), 1,
+                               sizeof(GSClipViewOverdraw));
+      _rFlags.keeps_overdraw = YES;
+    }
+  OVERDRAW->margin = margin;
+  [self _discardOverdraw];
+  [self _scheduleOverdrawUpdate];
+}
+
+/**
+ * Returns the margin of the document view kept around its visible rect.
+ */
+- (CGFloat) overdrawMargin
+{
+  return (_overdraw == NULL) ? 0.0 : OVERDRAW->margin;
+}
+
 /**<p>Sets the cursor for the document view to <var>aCursor</var></p>
  <p>See Also: -documentCursor</p>
  */
@@ -836,6 +915,22 @@ static inline NSRect integralRect (NSRect rect, NSView *view)
 }
 @end
 
+/* Sets *u to the union of a and b and returns YES if the union is a rect
+   covered by the two, as when b is a scrolled copy of a.  */
+static BOOL
+union_is_rect(NSRect a, NSRect b, NSRect *u)
+{
+  if ((NSMinX(a) == NSMinX(b) && NSMaxX(a) == NSMaxX(b)
+       && NSMinY(a) <= NSMaxY(b) && NSMinY(b) <= NSMaxY(a))
+    || (NSMinY(a) == NSMinY(b) && NSMaxY(a) == NSMaxY(b)
+       && NSMinX(a) <= NSMaxX(b) && NSMinX(b) <= NSMaxX(a)))
+    {
+      *u = NSUnionRect(a, b);
+      return YES;
+    }
+  return NO;
+}
+
 @implementation NSClipView (Private)
 
 - (void) _scrollToPoint: (NSPoint)aPoint
@@ -856,5 +951,143 @@ static inline NSRect integralRect (NSRect rect, NSView *view)
   [self scrollToPoint: newBounds.origin]; 
 }
 
+/* Shows aRect, which a scroll has exposed, from the bits kept around
+   the visible rect if they cover it, else marks the document view as
+   needing display there.  */
+- (void) _exposeRect: (NSRect)aRect
+{
+  GSClipViewOverdraw *o = OVERDRAW;
+  NSRect r = [self convertRect: aRect toView: _documentView];
+
+  if (o != NULL && o->bits != nil && NSContainsRect(o->valid, r))
+    {
+      NSRect inBase = [_documentView convertRect: r toView: nil];
+      NSRect validInBase = [_documentView convertRect: o->valid toView: nil];
+
+      if (NSEqualSizes(inBase.size, r.size)
+        && NSEqualRects(inBase, NSIntegralRect(inBase)))
+        {
+          NSPoint destPoint = aRect.origin;
+
+          if ([self isFlipped])
+            {
+              destPoint.y += aRect.size.height;
+            }
+          [self lockFocus];
+          NSCopyBits([[o->bits window] gState],
+                     NSOffsetRect(inBase, -NSMinX(validInBase),
+                                  -NSMinY(validInBase)),
+                     destPoint);
+          [self unlockFocus];
+          return;
+        }
+    }
+  [_documentView setNeedsDisplayInRect: r];
+}
+
+- (void) _scheduleOverdrawUpdate
+{
+  GSClipViewOverdraw *o = OVERDRAW;
+
+  if (o != NULL && o->scheduled == NO)
+    {
+      o->scheduled = YES;
+      [self performSelector: @selector(_updateOverdraw)
+                 withObject: nil
+                 afterDelay: OVERDRAW_DELAY];
+    }
+}
+
+/* Adds what the window now shows of the document view to the bits kept,
+   keeping no more than the margin around the visible rect.  */
+- (void) _updateOverdraw
+{
+  GSClipViewOverdraw *o = OVERDRAW;
+  NSRect visible;
+  NSRect valid;
+  NSRect visibleInBase;
+  NSRect validInBase;
+  NSCachedImageRep *bits;
+  NSView *bitsView;
+
+  o->scheduled = NO;
+  /* Until the window is drawn it does not show what the document view
+     would draw; the next scroll will try again.  */
+  if (_documentView == nil || _window == nil || [_window gState] == 0
+    || _copiesOnScroll == NO || _rFlags.needs_display)
+    {
+      return;
+    }
+
+  visible = [self convertRect: [self visibleRect] toView: _documentView];
+  visible = NSIntersectionRect(visible, [_documentView bounds]);
+  visibleInBase = [_documentView convertRect: visible toView: nil];
+  if (NSIsEmptyRect(visibleInBase)
+    || NSEqualSizes(visibleInBase.size, visible.size) == NO
+    || NSEqualRects(visibleInBase, NSIntegralRect(visibleInBase)) == NO)
+    {
+      /* Only bits which line up with the window may be kept.  */
+      [self _discardOverdraw];
+      return;
+    }
+
+  if (o->bits == nil || union_is_rect(o->valid, visible, &valid) == NO)
+    {
+      valid = visible;
+    }
+  valid = NSIntersectionRect(valid,
+    NSInsetRect(visible, -o->margin, -o->margin));
+  if (o->bits != nil && NSEqualRects(valid, o->valid))
+    {
+      return;
+    }
+
+  validInBase = [_documentView convertRect: valid toView: nil];
+  bits = [[NSCachedImageRep alloc]
+           initWithWindow: nil
+                     rect: NSMakeRect(0, 0, NSWidth(validInBase),
+                                      NSHeight(validInBase))];
+  bitsView = [[bits window] contentView];
+  [bitsView lockFocus];
+  if (o->bits != nil)
+    {
+      NSRect kept = NSIntersectionRect(o->valid, valid);
+
+      if (NSIsEmptyRect(kept) == NO)
+        {
+          NSRect keptInBase = [_documentView convertRect: kept toView: nil];
+          NSRect oldInBase = [_documentView convertRect: o->valid toView: nil];
+
+          NSCopyBits([[o->bits window] gState],
+                     NSOffsetRect(keptInBase, -NSMinX(oldInBase),
+                                  -NSMinY(oldInBase)),
+                     NSMakePoint(NSMinX(keptInBase) - NSMinX(validInBase),
+                                 NSMinY(keptInBase) - NSMinY(validInBase)));
+        }
+    }
+  NSCopyBits([_window gState], visibleInBase,
+             NSMakePoint(NSMinX(visibleInBase) - NSMinX(validInBase),
+                         NSMinY(visibleInBase) - NSMinY(validInBase)));
+  [bitsView unlockFocus];
+  ASSIGN(o->bits, bits);
+  RELEASE(bits);
+  o->valid = valid;
+}
+
+@end
+
+@implementation NSClipView (Overdraw)
+
+- (void) _discardOverdraw
+{
+  GSClipViewOverdraw *o = OVERDRAW;
+
+  if (o != NULL && o->scrolling == NO)
+    {
+      DESTROY(o->bits);
+      o->valid = NSZeroRect;
+    }
+}
+
 @end
 
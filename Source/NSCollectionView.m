@@ -62,6 +62,8 @@ static NSString *placeholderItem = nil;
 - (void) _resetItemSize;
 - (void) _removeItemsViews;
 - (NSInteger) _indexAtPoint: (NSPoint)point;
+- (void) _loadItemsInRect: (NSRect)rect;
+- (void) _unloadItemAtIndex: (NSUInteger)index;
 
 - (NSRect) _frameForRowOfItemAtIndex: (NSUInteger)theIndex;
 - (NSRect) _frameForRowsAroundItemAtIndex: (NSUInteger)theIndex;
@@ -116,6 +118,13 @@ static NSString *placeholderItem = nil;
   _items = [[NSMutableArray alloc] init];
   _selectionIndexes = [[NSIndexSet alloc] init];
   _draggingOnIndex = NSNotFound;
+  _loadedIndexes = [[NSMutableIndexSet alloc] init];
+  _reusableItems = [[NSMutableArray alloc] init];
+  /* Items can only be reused if they are all made the same way.  */
+  _reusesItems = ([self methodForSelector:
+			  @selector(newItemForRepresentedObject:)]
+		  == [NSCollectionView instanceMethodForSelector:
+				 @selector(newItemForRepresentedObject:)]);
 }
 
 - (void) _resetItemSize
@@ -146,22 +155,10 @@ static NSString *placeholderItem = nil;
       NSRectFill(dirtyRect);
     }
 
-  NSPoint origin = dirtyRect.origin;
-  NSSize size = dirtyRect.size;
-  NSPoint oppositeOrigin = NSMakePoint (origin.x + size.width, origin.y + size.height);
-  
-  NSInteger firstIndexInRect = MAX(0, [self _indexAtPoint: origin]);
-  NSInteger lastIndexInRect = MIN([_items count] - 1, [self _indexAtPoint: oppositeOrigin]);
-  NSInteger index;
-
-  for (index = firstIndexInRect; index <= lastIndexInRect; index++)
-    {
-      // Calling itemAtIndex: will eventually instantiate the collection view item,
-      // if it hasn't been done already.
-      NSCollectionViewItem *collectionItem = [self itemAtIndex: index];
-      NSView *view = [collectionItem view];
-      [view setFrame: [self frameForItemAtIndex: index]];
-    }
+  // Keep items for a row above and below the visible ones.
+  [self _loadItemsInRect:
+	  NSInsetRect([self visibleRect], 0,
+		      -(_itemSize.height + _verticalMargin))];
 }
 
 - (void) dealloc
@@ -176,6 +173,8 @@ static NSString *placeholderItem = nil;
   DESTROY (_backgroundColors);
   DESTROY (_selectionIndexes);
   DESTROY (_items);
+  DESTROY (_loadedIndexes);
+  DESTROY (_reusableItems);
   //DESTROY (_mouseDownEvent);
   [super dealloc];
 }
@@ -220,6 +219,7 @@ static NSString *placeholderItem = nil;
   
   RELEASE (_items);
   _items = [[NSMutableArray alloc] initWithCapacity: [_content count]];
+  [_loadedIndexes removeAllIndexes];
  
   for (i = 0; i < [_content count]; i++)
     {
@@ -257,6 +257,7 @@ static NSString *placeholderItem = nil;
 - (void) setItemPrototype: (NSCollectionViewItem *)prototype
 {
   ASSIGN(itemPrototype, prototype);
+  [_reusableItems removeAllObjects];
   [self _resetItemSize];
 }
 
@@ -361,15 +362,16 @@ static NSString *placeholderItem = nil;
       ASSIGN(_selectionIndexes, indexes);
     }
   
-  NSUInteger index = 0;
-  while (index < [_items count])
+  // Only loaded items have a selected state
+  NSUInteger index = [_loadedIndexes firstIndex];
+  while (index != NSNotFound)
     {
       id item = [_items objectAtIndex: index];
       if ([item respondsToSelector: @selector(setSelected:)])
         {
           [item setSelected:NO];
         }
-      index++;
+      index = [_loadedIndexes indexGreaterThanIndex: index];
     }
   
   index = -1;
@@ -387,51 +389,39 @@ static NSString *placeholderItem = nil;
 - (NSRect) frameForItemAtIndex: (NSUInteger)theIndex
 {
   NSRect itemFrame = NSMakeRect (0,0,0,0);
-  NSInteger index;
   NSUInteger count = [_items count];
-  CGFloat x = _horizontalMargin;
-  CGFloat y = -_itemSize.height;
+  NSUInteger row, column;
+  NSInteger draggingOffset = 0;
+  CGFloat x, y;
   
   if (_maxNumberOfColumns > 0 && _maxNumberOfRows > 0)
     {
       count = MIN(count, _maxNumberOfColumns * _maxNumberOfRows);
     }
 
-  for (index = 0; index < count; ++index)
+  if (theIndex >= count || _numberOfColumns == 0)
+    {
+      return itemFrame;
+    }
+
+  row = theIndex / _numberOfColumns;
+  column = theIndex % _numberOfColumns;
+  x = _horizontalMargin + column * (_itemSize.width + _horizontalMargin);
+  y = _verticalMargin + row * (_itemSize.height + _verticalMargin);
+
+  if (_draggingOnIndex != NSNotFound
+      && (_draggingOnIndex / _numberOfColumns) == row)
     {
-      if (index % _numberOfColumns == 0)
+      if (theIndex < _draggingOnIndex)
         {
-          x = _horizontalMargin;
-          y += _verticalMargin + _itemSize.height;
+          draggingOffset = -20;
         }
-      
-      if (index == theIndex)
+      else
         {
-          NSInteger draggingOffset = 0;
-
-          if (_draggingOnIndex != NSNotFound)
-            {
-              NSInteger draggingOnRow = (_draggingOnIndex / _numberOfColumns);
-              NSInteger currentIndexRow = (theIndex / _numberOfColumns);
-
-              if (draggingOnRow == currentIndexRow)
-                {
-                  if (index < _draggingOnIndex)
-                    {
-                      draggingOffset = -20;
-                    }
-                  else
-                    {
-                      draggingOffset = 20;
-                    }
-                }
-            }
-          itemFrame = NSMakeRect ((x + draggingOffset), y, _itemSize.width, _itemSize.height);
-          break;
+          draggingOffset = 20;
         }
-      
-      x += _itemSize.width + _horizontalMargin;
     }
+  itemFrame = NSMakeRect ((x + draggingOffset), y, _itemSize.width, _itemSize.height);
   return itemFrame;
 }
 
@@ -458,12 +448,25 @@ static NSString *placeholderItem = nil;
 
   if (item == placeholderItem)
     {
-      item = [self newItemForRepresentedObject: [_content objectAtIndex: index]];
+      id object = [_content objectAtIndex: index];
+
+      if ([_reusableItems count] > 0)
+        {
+          item = AUTORELEASE(RETAIN([_reusableItems lastObject]));
+          [_reusableItems removeLastObject];
+          [item setRepresentedObject: object];
+        }
+      else
+        {
+          item = [self newItemForRepresentedObject: object];
+        }
       [_items replaceObjectAtIndex: index withObject: item];
+      [_loadedIndexes addIndex: index];
       if ([[self selectionIndexes] containsIndex: index])
         {
           [item setSelected: YES];
         }
+      [[item view] setFrame: [self frameForItemAtIndex: index]];
       [self addSubview: [item view]];
     }
   return item;
@@ -485,20 +488,99 @@ static NSString *placeholderItem = nil;
   if (!_items)
     return;
   
-  NSUInteger count = [_items count];
+  NSUInteger index = [_loadedIndexes lastIndex];
   
-  while (count--)
+  while (index != NSNotFound)
     {
-      id item = [_items objectAtIndex: count];
+      id item = [_items objectAtIndex: index];
 
       if ([item respondsToSelector: @selector(view)])
         {
           [[item view] removeFromSuperview];
           [item setSelected: NO];
         }
+      index = [_loadedIndexes indexLessThanIndex: index];
     }
 }
 
+/* Makes sure the items of the rows in rect are loaded and placed, and
+   unloads all other items, keeping them for reuse. */
+- (void) _loadItemsInRect: (NSRect)rect
+{
+  NSUInteger count = [_items count];
+  CGFloat rowHeight = _itemSize.height + _verticalMargin;
+  NSUInteger first = 0, last = 0, index;
+  NSMutableIndexSet *unload;
+
+  if (_maxNumberOfColumns > 0 && _maxNumberOfRows > 0)
+    {
+      count = MIN(count, _maxNumberOfColumns * _maxNumberOfRows);
+    }
+  if (_numberOfColumns == 0 || rowHeight <= 0 || NSMaxY(rect) <= 0)
+    {
+      count = 0;
+    }
+  if (count > 0)
+    {
+      first = floor(MAX(NSMinY(rect), 0) / rowHeight) * _numberOfColumns;
+      last = MIN(count, (floor(NSMaxY(rect) / rowHeight) + 1)
+                 * _numberOfColumns);
+    }
+
+  unload = [_loadedIndexes mutableCopy];
+  if (first < last)
+    {
+      [unload removeIndexesInRange: NSMakeRange(first, last - first)];
+    }
+  index = [unload firstIndex];
+  while (index != NSNotFound)
+    {
+      [self _unloadItemAtIndex: index];
+      index = [unload indexGreaterThanIndex: index];
+    }
+  RELEASE(unload);
+
+  for (index = first; index < last; index++)
+    {
+      NSCollectionViewItem *collectionItem = [self itemAtIndex: index];
+
+      [[collectionItem view] setFrame: [self frameForItemAtIndex: index]];
+    }
+
+  // Don't keep more items than there are items shown.
+  if ([_reusableItems count] > last - first)
+    {
+      [_reusableItems removeObjectsInRange:
+        NSMakeRange(last - first, [_reusableItems count] - (last - first))];
+    }
+}
+
+- (void) _unloadItemAtIndex: (NSUInteger)index
+{
+  id item = [_items objectAtIndex: index];
+  NSView *view;
+  id firstResponder;
+
+  if (item == placeholderItem)
+    return;
+
+  // Keep the item the user is interacting with.
+  view = [item view];
+  firstResponder = [_window firstResponder];
+  if ([firstResponder isKindOfClass: [NSView class]]
+      && [firstResponder isDescendantOf: view])
+    return;
+
+  [view removeFromSuperview];
+  [item setSelected: NO];
+  if (_reusesItems)
+    {
+      [_reusableItems addObject: item];
+    }
+  [_items replaceObjectAtIndex: index withObject: placeholderItem];
+  [_loadedIndexes removeIndex: index];
+}
+
 - (void) tile
 {
   // TODO: - Animate items, Add Fade-in/Fade-out (as in Cocoa)
@@ -539,7 +621,6 @@ static NSString *placeholderItem = nil;
       _itemSize = itemSize;
     }
   
-  NSInteger index;
   NSUInteger count = [_items count];
   
   if (_maxNumberOfColumns > 0 && _maxNumberOfRows > 0)
@@ -551,12 +632,10 @@ static NSString *placeholderItem = nil;
                             (_numberOfColumns + 1));
   CGFloat y = -itemSize.height;
   
-  for (index = 0; index < count; ++index)
+  if (count > 0)
     {
-      if (index % _numberOfColumns == 0)
-        {
-          y += _verticalMargin + itemSize.height;
-        }
+      y = _verticalMargin
+        + ((count - 1) / _numberOfColumns) * (_verticalMargin + itemSize.height);
     }
   
   id superview = [self superview];
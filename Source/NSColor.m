@@ -68,6 +68,7 @@ static Class	NSColorClass;
   NSString *_color_name;
   NSString *_cached_name_space;
   NSColor *_cached_color;
+  NSColor *_real_color;
 }
 
 - (NSColor*) initWithCatalogName: (NSString *)listName
@@ -76,7 +77,22 @@ static Class	NSColorClass;
 
 @end
 
-@interface GSWhiteColor : NSColor
+/* The superclass of the colours holding their components. As colours
+ * are immutable, these keep the colour they were last converted to, for
+ * drawing code asking for the same conversion over and over.
+ */
+@interface GSConcreteColor : NSColor
+{
+  NSString *_converted_space;
+  NSColor *_converted_color;
+}
+
+- (NSColor*) _colorUsingColorSpaceName: (NSString *)colorSpace
+				device: (NSDictionary *)deviceDescription;
+
+@end
+
+@interface GSWhiteColor : GSConcreteColor
 {
   CGFloat _white_component;
   CGFloat _alpha_component;
@@ -98,7 +114,7 @@ static Class	NSColorClass;
 
 @end
 
-@interface GSDeviceCMYKColor : NSColor
+@interface GSDeviceCMYKColor : GSConcreteColor
 {
   CGFloat _cyan_component;
   CGFloat _magenta_component;
@@ -115,7 +131,7 @@ static Class	NSColorClass;
 
 @end
 
-@interface GSRGBColor : NSColor
+@interface GSRGBColor : GSConcreteColor
 {
   CGFloat _red_component;
   CGFloat _green_component;
@@ -1903,6 +1919,7 @@ static	NSRecursiveLock		*namedColorLock = nil;
   RELEASE(_color_name);
   RELEASE(_cached_name_space);
   RELEASE(_cached_color);
+  RELEASE(_real_color);
   [super dealloc];
 }
 
@@ -1995,12 +2012,20 @@ static	NSRecursiveLock		*namedColorLock = nil;
   // Is there a cache hit?
   // FIXME How would we detect that the cache has become invalid by a
   // change to the colour list?
+  // System colours are recached when the defaults or the theme change.
   [namedColorLock lock];
   if (NO == [colorSpace isEqualToString: _cached_name_space])
     {
-      list = [NSColorList colorListNamed: _catalog_name];
-      real = [list colorWithKey: _color_name];
-      ASSIGN(_cached_color, [real colorUsingColorSpaceName: colorSpace
+      /* Look up the colour in the list once. It keeps the colour it
+       * was last converted to as well, so using a named colour in two
+       * colour spaces in turn doesn't make new colours either.
+       */
+      if (_real_color == nil)
+	{
+	  list = [NSColorList colorListNamed: _catalog_name];
+	  ASSIGN(_real_color, [list colorWithKey: _color_name]);
+	}
+      ASSIGN(_cached_color, [_real_color colorUsingColorSpaceName: colorSpace
 	device: deviceDescription]);
       ASSIGN(_cached_name_space, colorSpace);
     }
@@ -2015,6 +2040,7 @@ static	NSRecursiveLock		*namedColorLock = nil;
   [namedColorLock lock];
   DESTROY(_cached_name_space);
   DESTROY(_cached_color);
+  DESTROY(_real_color);
   [namedColorLock unlock];
 }
 
@@ -2050,6 +2076,86 @@ static	NSRecursiveLock		*namedColorLock = nil;
 
 @end
 
+@implementation GSConcreteColor
+
+static NSLock	*convertedColorLock = nil;
+
++ (void) initialize
+{
+  if (convertedColorLock == nil)
+    {
+      convertedColorLock = [NSLock new];
+    }
+}
+
+- (void) dealloc
+{
+  RELEASE(_converted_space);
+  RELEASE(_converted_color);
+  [super dealloc];
+}
+
+- (id) copyWithZone: (NSZone*)aZone
+{
+  GSConcreteColor	*aCopy = [super copyWithZone: aZone];
+
+  if (aCopy != self)
+    {
+      aCopy->_converted_space = nil;
+      aCopy->_converted_color = nil;
+    }
+  return aCopy;
+}
+
+- (NSColor*) colorUsingColorSpaceName: (NSString *)colorSpace
+			       device: (NSDictionary *)deviceDescription
+{
+  NSColor	*c = nil;
+
+  if (colorSpace == nil)
+    {
+      if (deviceDescription != nil)
+	colorSpace = [deviceDescription objectForKey: NSDeviceColorSpaceName];
+      if (colorSpace == nil)
+        colorSpace = NSCalibratedRGBColorSpace;
+    }
+  if ([colorSpace isEqualToString: [self colorSpaceName]])
+    {
+      return self;
+    }
+
+  [convertedColorLock lock];
+  if (_converted_color != nil
+    && [colorSpace isEqualToString: _converted_space])
+    {
+      c = [[_converted_color retain] autorelease];
+    }
+  [convertedColorLock unlock];
+
+  if (c == nil)
+    {
+      c = [self _colorUsingColorSpaceName: colorSpace
+				   device: deviceDescription];
+      if (c != nil)
+	{
+	  [convertedColorLock lock];
+	  ASSIGN(_converted_color, c);
+	  ASSIGNCOPY(_converted_space, colorSpace);
+	  [convertedColorLock unlock];
+	}
+    }
+  return c;
+}
+
+- (NSColor*) _colorUsingColorSpaceName: (NSString *)colorSpace
+				device: (NSDictionary *)deviceDescription
+{
+  [self subclassResponsibility: _cmd];
+  return nil;
+}
+
+@end
+
 // Grayscale colours
 @implementation GSWhiteColor
 
@@ -2128,26 +2234,16 @@ static	NSRecursiveLock		*namedColorLock = nil;
   if (aCopy)
     {
       aCopy->_alpha_component = alpha;
+      aCopy->_converted_space = nil;
+      aCopy->_converted_color = nil;
     }
 
   return AUTORELEASE(aCopy);
 }
 
-- (NSColor*) colorUsingColorSpaceName: (NSString *)colorSpace
-			       device: (NSDictionary *)deviceDescription
+- (NSColor*) _colorUsingColorSpaceName: (NSString *)colorSpace
+				device: (NSDictionary *)deviceDescription
 {
-  if (colorSpace == nil)
-    {
-      if (deviceDescription != nil)
-	colorSpace = [deviceDescription objectForKey: NSDeviceColorSpaceName];
-      if (colorSpace == nil)
-        colorSpace = NSCalibratedRGBColorSpace;
-    }
-  if ([colorSpace isEqualToString: [self colorSpaceName]])
-    {
-      return self;
-    }
-
   if ([colorSpace isEqualToString: NSNamedColorSpace])
     {
       // FIXME: We cannot convert to named color space.
@@ -2448,26 +2544,16 @@ static	NSRecursiveLock		*namedColorLock = nil;
   if (aCopy)
     {
       aCopy->_alpha_component = alpha;
+      aCopy->_converted_space = nil;
+      aCopy->_converted_color = nil;
     }
 
   return AUTORELEASE(aCopy);
 }
 
-- (NSColor*) colorUsingColorSpaceName: (NSString *)colorSpace
-			       device: (NSDictionary *)deviceDescription
+- (NSColor*) _colorUsingColorSpaceName: (NSString *)colorSpace
+				device: (NSDictionary *)deviceDescription
 {
-  if (colorSpace == nil)
-    {
-      if (deviceDescription != nil)
-	colorSpace = [deviceDescription objectForKey: NSDeviceColorSpaceName];
-      if (colorSpace == nil)
-        colorSpace = NSCalibratedRGBColorSpace;
-    }
-  if ([colorSpace isEqualToString: [self colorSpaceName]])
-    {
-      return self;
-    }
-
   if ([colorSpace isEqualToString: NSNamedColorSpace])
     {
       // FIXME: We cannot convert to named color space.
@@ -2708,26 +2794,16 @@ static	NSRecursiveLock		*namedColorLock = nil;
   if (aCopy)
     {
       aCopy->_alpha_component = alpha;
+      aCopy->_converted_space = nil;
+      aCopy->_converted_color = nil;
     }
 
   return AUTORELEASE(aCopy);
 }
 
-- (NSColor*) colorUsingColorSpaceName: (NSString *)colorSpace
-			       device: (NSDictionary *)deviceDescription
+- (NSColor*) _colorUsingColorSpaceName: (NSString *)colorSpace
+				device: (NSDictionary *)deviceDescription
 {
-  if (colorSpace == nil)
-    {
-      if (deviceDescription != nil)
-	colorSpace = [deviceDescription objectForKey: NSDeviceColorSpaceName];
-      if (colorSpace == nil)
-        colorSpace = NSCalibratedRGBColorSpace;
-    }
-  if ([colorSpace isEqualToString: [self colorSpaceName]])
-    {
-      return self;
-    }
-
   if ([colorSpace isEqualToString: NSNamedColorSpace])
     {
       // FIXME: We cannot convert to named color space.
@@ -34,12 +34,15 @@
 #import <Foundation/NSLock.h>
 #import <Foundation/NSDictionary.h>
 #import <Foundation/NSArchiver.h>
+#import <Foundation/NSByteOrder.h>
 #import <Foundation/NSCharacterSet.h>
+#import <Foundation/NSData.h>
 #import <Foundation/NSException.h>
 #import <Foundation/NSFileManager.h>
 #import <Foundation/NSPathUtilities.h>
 #import <Foundation/NSScanner.h>
 #import <Foundation/NSString.h>
+#import <Foundation/NSUserDefaults.h>
 
 #import "AppKit/NSColorList.h"
 #import "AppKit/NSColor.h"
@@ -50,6 +53,15 @@
 static NSMutableArray *_availableColorLists = nil;
 static NSLock *_colorListLock = nil;
 
+/* The available lists by name, the first list of each name only, so that
+ * +colorListNamed: can be answered without taking the lock.  The index is
+ * replaced rather than changed when the lists change, and a replaced one
+ * is kept in _retiredIndexes since a reader may still be using it; the
+ * lists change rarely.
+ */
+static NSDictionary *_colorListsByName = nil;
+static NSMutableArray *_retiredIndexes = nil;
+
 static NSColorList *defaultSystemColorList = nil;
 static NSColorList *themeColorList = nil;
 
@@ -74,6 +86,21 @@ static NSColorList *themeColorList = nil;
  */
 + (void) _setThemeSystemColorList: (NSColorList*)aList;
 
+/* Rebuilds the index of the available lists by name.  Must be called
+ * with the lock held after changing _availableColorLists.
+ */
++ (void) _indexAvailableColorLists;
+
+/* Initializes a list of the given name whose colors are read from the
+ * file at path only when they are first used.
+ */
+- (id) _initWithName: (NSString *)name
+     referencingFile: (NSString *)path;
+
+/* Reads the colors of the list from its file, if it has not done so yet.
+ */
+- (void) _loadColorsIfNeeded;
+
 @end
 
 @implementation NSColorList
@@ -112,27 +139,14 @@ static NSColorList *themeColorList = nil;
  */
 + (NSColorList *) colorListNamed: (NSString *)name
 {
-  NSColorList  *r;
-  NSEnumerator *e;
-
-  // Serialize access to color list
-  [_colorListLock lock];
+  NSDictionary *index = _colorListsByName;
 
-  [NSColorList _loadAvailableColorLists: nil];
-  e = [_availableColorLists objectEnumerator];
-  
-  while ((r = (NSColorList *)[e nextObject]) != nil) 
+  if (index == nil)
     {
-      if ([[r name] isEqualToString: name])
-	{
-	  RETAIN(r);
-	  break;
-	}
+      [NSColorList _loadAvailableColorLists: nil];
+      index = _colorListsByName;
     }
-  
-  [_colorListLock unlock];
-
-  return AUTORELEASE(r);
+  return [index objectForKey: name];
 }
 
 
@@ -148,6 +162,8 @@ static NSColorList *themeColorList = nil;
  * provide its arguments (e.g., r, g, b, alpha), and string is name.
  */
 - (BOOL) _readTextColorFile: (NSString *) filepath
+		     colors: (NSMutableDictionary *)colors
+		       keys: (NSMutableArray *)keys
 {
   int nColors;
   int method;
@@ -163,7 +179,7 @@ static NSColorList *themeColorList = nil;
     [NSCharacterSet characterSetWithCharactersInString: @"\n"];
   NSScanner *scanner =
     [NSScanner scannerWithString:
-                 [NSString stringWithContentsOfFile: _fullFileName]];
+                 [NSString stringWithContentsOfFile: filepath]];
 
   if ([scanner scanInt: &nColors] == NO)
     {
@@ -201,12 +217,122 @@ static NSColorList *themeColorList = nil;
           break;
         }
       color = [NSColor colorWithCalibratedRed: r green: g blue: b alpha: alpha];
-      [self insertColor: color key: cname atIndex: i];
+      if ([colors objectForKey: cname] == nil)
+	{
+	  [keys addObject: cname];
+	}
+      [colors setObject: color forKey: cname];
     }
 
   return i == nColors;
 }
 
+/*
+ * Private method for reading the binary format described with
+ * -binaryRepresentation.
+ */
+- (BOOL) _readBinaryColorData: (NSData *)data
+		       colors: (NSMutableDictionary *)colors
+			 keys: (NSMutableArray *)keys
+{
+  const unsigned char *bytes = [data bytes];
+  NSUInteger length = [data length];
+  NSUInteger pos = 9;
+  uint32_t nColors;
+  uint32_t i;
+
+  if (length < 9 || memcmp(bytes, "GSCL", 4) != 0 || bytes[4] != 1)
+    {
+      return NO;
+    }
+  memcpy(&nColors, bytes + 5, 4);
+  nColors = NSSwapBigIntToHost(nColors);
+
+  for (i = 0; i < nColors; i++)
+    {
+      NSSwappedFloat c[4];
+      uint16_t nameLength;
+      NSString *cname;
+      NSColor *color;
+
+      if (pos + 2 > length)
+	break;
+      memcpy(&nameLength, bytes + pos, 2);
+      nameLength = NSSwapBigShortToHost(nameLength);
+      pos += 2;
+      if (pos + nameLength + sizeof(c) > length)
+	break;
+      cname = [[NSString alloc] initWithBytes: bytes + pos
+				       length: nameLength
+				     encoding: NSUTF8StringEncoding];
+      pos += nameLength;
+      memcpy(c, bytes + pos, sizeof(c));
+      pos += sizeof(c);
+      if (cname == nil)
+	break;
+      color = [NSColor colorWithCalibratedRed: NSSwapBigFloatToHost(c[0])
+					green: NSSwapBigFloatToHost(c[1])
+					 blue: NSSwapBigFloatToHost(c[2])
+					alpha: NSSwapBigFloatToHost(c[3])];
+      if ([colors objectForKey: cname] == nil)
+	{
+	  [keys addObject: cname];
+	}
+      [colors setObject: color forKey: cname];
+      RELEASE(cname);
+    }
+
+  if (i != nColors)
+    {
+      NSLog(@"Unable to read color file at \"%@\" -- truncated binary list.",
+            _fullFileName);
+      return NO;
+    }
+  return YES;
+}
+
+/*
+ * Reads the colors from the file, which may hold the binary format, an
+ * archive of a color list or the text format.
+ */
+- (BOOL) _readColorFile: (NSString *)path
+		 colors: (NSMutableDictionary *)colors
+		   keys: (NSMutableArray *)keys
+{
+  NSData *data = [NSData dataWithContentsOfFile: path];
+  NSColorList *cl;
+
+  if (data == nil)
+    {
+      return NO;
+    }
+  if ([self _readBinaryColorData: data colors: colors keys: keys])
+    {
+      return YES;
+    }
+
+  NS_DURING
+    {
+      cl = (NSColorList*)[NSUnarchiver unarchiveObjectWithData: data];
+    }
+  NS_HANDLER
+    {
+      cl = nil;
+    }
+  NS_ENDHANDLER ;
+
+  if (cl && [cl isKindOfClass: [NSColorList class]])
+    {
+      [colors addEntriesFromDictionary: cl->_colorDictionary];
+      [keys addObjectsFromArray: cl->_orderedColorKeys];
+      return YES;
+    }
+
+  [colors removeAllObjects];
+  [keys removeAllObjects];
+  return [self _readTextColorFile: path colors: colors keys: keys];
+}
+
 - (id) initWithName: (NSString *)name
 {
   return [self initWithName: name
@@ -216,9 +342,6 @@ static NSColorList *themeColorList = nil;
 - (id) initWithName: (NSString *)name
 	   fromFile: (NSString *)path
 {
-  NSColorList *cl;
-  BOOL        could_load = NO; 
-
   ASSIGN (_name, name);
 
   if (path != nil)
@@ -239,62 +362,8 @@ static NSColorList *themeColorList = nil;
         {
           ASSIGN (_fullFileName, path);
         }
-  
-      // Unarchive the color list
-      
-      // TODO [Optm]: Rewrite to initialize directly without unarchiving 
-      // in another object
-      NS_DURING
-        {
-          cl =
-            (NSColorList*)[NSUnarchiver unarchiveObjectWithFile: _fullFileName];
-        }
-      NS_HANDLER
-        {
-          cl = nil;
-        }
-      NS_ENDHANDLER ;
-
-      if (cl && [cl isKindOfClass: [NSColorList class]])
-	{
-	  could_load = YES;
-
-	  _is_editable = [[NSFileManager defaultManager] 
-	    isWritableFileAtPath: _fullFileName];
-	  
-	  ASSIGN(_colorDictionary, [NSMutableDictionary 
-	    dictionaryWithDictionary: cl->_colorDictionary]);
-
-	  ASSIGN(_orderedColorKeys, [NSMutableArray 
-	    arrayWithArray: cl->_orderedColorKeys]);
-	}
-      else if ([[NSFileManager defaultManager] fileExistsAtPath: path])
-        {
-          _colorDictionary = [[NSMutableDictionary alloc] init];
-          _orderedColorKeys = [[NSMutableArray alloc] init];
-	  _is_editable = YES;
-
-          if ([self _readTextColorFile: _fullFileName])
-            {
-              could_load = YES;
-              _is_editable = [[NSFileManager defaultManager] 
-                                   isWritableFileAtPath: _fullFileName];
-            }
-          else
-            {
-              RELEASE (_colorDictionary);
-              RELEASE (_orderedColorKeys);
-            }
-        }
-    }
-  
-  if (could_load == NO)
-    {
-      _fullFileName = nil;
-      _colorDictionary = [[NSMutableDictionary alloc] init];
-      _orderedColorKeys = [[NSMutableArray alloc] init];
-      _is_editable = YES;  
     }
+  [self _loadColorsIfNeeded];
   
   return self;
 }
@@ -321,11 +390,15 @@ static NSColorList *themeColorList = nil;
  */
 - (NSArray *) allKeys
 {
+  if (_colorDictionary == nil)
+    [self _loadColorsIfNeeded];
   return [NSArray arrayWithArray: _orderedColorKeys];
 }
 
 - (NSColor *) colorWithKey: (NSString *)key
 {
+  if (_colorDictionary == nil)
+    [self _loadColorsIfNeeded];
   return [_colorDictionary objectForKey: key];
 }
 
@@ -335,6 +408,8 @@ static NSColorList *themeColorList = nil;
 {
   NSNotification	*n;
 
+  if (_colorDictionary == nil)
+    [self _loadColorsIfNeeded];
   if (_is_editable == NO)
     [NSException raise: NSColorListNotEditableException
 		format: @"Color list cannot be edited\n"];
@@ -357,6 +432,8 @@ static NSColorList *themeColorList = nil;
 {
   NSNotification	*n;
 
+  if (_colorDictionary == nil)
+    [self _loadColorsIfNeeded];
   if (_is_editable == NO)
     [NSException raise: NSColorListNotEditableException
 		format: @"Color list cannot be edited\n"];
@@ -379,6 +456,8 @@ static NSColorList *themeColorList = nil;
 {
   NSNotification	*n;
 
+  if (_colorDictionary == nil)
+    [self _loadColorsIfNeeded];
   if (_is_editable == NO)
     [NSException raise: NSColorListNotEditableException
 		format: @"Color list cannot be edited\n"];
@@ -403,6 +482,8 @@ static NSColorList *themeColorList = nil;
  */
 - (BOOL) isEditable
 {
+  if (_colorDictionary == nil)
+    [self _loadColorsIfNeeded];
   return _is_editable;
 }
 
@@ -415,8 +496,13 @@ static NSColorList *themeColorList = nil;
   NSString      *tmpPath;
   BOOL          isDir;
   BOOL          success;
+  NSData        *data;
   BOOL          path_is_standard = YES;
 
+  /* Read the colors from the file they are in before changing it. */
+  if (_colorDictionary == nil)
+    [self _loadColorsIfNeeded];
+
   /*
    * We need to initialize before saving, to avoid the new file being 
    * counted as a different list thus making us appear twice
@@ -498,14 +584,26 @@ static NSColorList *themeColorList = nil;
 	}
     }
 
-  success = [NSArchiver archiveRootObject: self 
-				   toFile: _fullFileName];
+  if ([[NSUserDefaults standardUserDefaults]
+    boolForKey: @"GSColorListBinaryFormat"]
+    && (data = [self binaryRepresentation]) != nil)
+    {
+      success = [data writeToFile: _fullFileName atomically: YES];
+    }
+  else
+    {
+      success = [NSArchiver archiveRootObject: self 
+				       toFile: _fullFileName];
+    }
 
   if (success && path_is_standard)
     {
       [_colorListLock lock];
       if ([_availableColorLists containsObject: self] == NO)
-	[_availableColorLists addObject: self];
+	{
+	  [_availableColorLists addObject: self];
+	  [NSColorList _indexAvailableColorLists];
+	}
       [_colorListLock unlock];      
       return YES;
     }
@@ -515,7 +613,7 @@ static NSColorList *themeColorList = nil;
 
 - (void) removeFile
 {
-  if (_fullFileName && _is_editable)
+  if (_fullFileName && [self isEditable])
     {
       // Remove the file
       [[NSFileManager defaultManager] removeFileAtPath: _fullFileName
@@ -524,6 +622,7 @@ static NSColorList *themeColorList = nil;
       // Remove the color list from the global list of colors
       [_colorListLock lock];
       [_availableColorLists removeObject: self];
+      [NSColorList _indexAvailableColorLists];
       [_colorListLock unlock];
 
       // Reset file name
@@ -539,6 +638,8 @@ static NSColorList *themeColorList = nil;
     }
   else
     {
+      if (_colorDictionary == nil)
+	[self _loadColorsIfNeeded];
       [aCoder encodeObject: _name];
       [aCoder encodeObject: _colorDictionary];
       [aCoder encodeObject: _orderedColorKeys];
@@ -626,8 +727,8 @@ static NSColorList *themeColorList = nil;
 		  NSString	*name;
 
 		  name = [file stringByDeletingPathExtension];
-		  newList = [[NSColorList alloc] initWithName: name
-		    fromFile: [dir stringByAppendingPathComponent: file]];
+		  newList = [[NSColorList alloc] _initWithName: name
+		    referencingFile: [dir stringByAppendingPathComponent: file]];
 		  [_availableColorLists addObject: newList];
 		  RELEASE(newList);
 		}
@@ -638,10 +739,76 @@ static NSColorList *themeColorList = nil;
         {
 	  [_availableColorLists addObject: defaultSystemColorList];
 	}
+      [NSColorList _indexAvailableColorLists];
       [_colorListLock unlock];
     }
 }
 
++ (void) _indexAvailableColorLists
+{
+  NSMutableDictionary	*index;
+  NSUInteger		i;
+
+  index = [[NSMutableDictionary alloc] init];
+  for (i = 0; i < [_availableColorLists count]; i++)
+    {
+      NSColorList	*list = [_availableColorLists objectAtIndex: i];
+
+      if ([index objectForKey: [list name]] == nil)
+	{
+	  [index setObject: list forKey: [list name]];
+	}
+    }
+  if (_colorListsByName != nil)
+    {
+      if (_retiredIndexes == nil)
+	{
+	  _retiredIndexes = [[NSMutableArray alloc] init];
+	}
+      [_retiredIndexes addObject: _colorListsByName];
+      RELEASE(_colorListsByName);
+    }
+  _colorListsByName = [index copy];
+  RELEASE(index);
+}
+
+- (id) _initWithName: (NSString *)name
+     referencingFile: (NSString *)path
+{
+  ASSIGN (_name, name);
+  ASSIGN (_fullFileName, path);
+  return self;
+}
+
+- (void) _loadColorsIfNeeded
+{
+  [_colorListLock lock];
+  if (_colorDictionary == nil)
+    {
+      NSMutableDictionary	*colors = [[NSMutableDictionary alloc] init];
+      NSMutableArray		*keys = [[NSMutableArray alloc] init];
+
+      if (_fullFileName != nil
+	&& [self _readColorFile: _fullFileName colors: colors keys: keys])
+	{
+	  _is_editable = [[NSFileManager defaultManager] 
+	    isWritableFileAtPath: _fullFileName];
+	}
+      else
+	{
+	  [colors removeAllObjects];
+	  [keys removeAllObjects];
+	  DESTROY (_fullFileName);
+	  _is_editable = YES;
+	}
+      /* Once the dictionary is set the list is read without the lock,
+       * so it is set last. */
+      _orderedColorKeys = keys;
+      _colorDictionary = colors;
+    }
+  [_colorListLock unlock];
+}
+
 + (void) _setDefaultSystemColorList: (NSColorList*)aList
 {
   [_colorListLock lock];
@@ -654,6 +821,10 @@ static NSColorList *themeColorList = nil;
 	}
       ASSIGN(defaultSystemColorList, aList);
       [_availableColorLists addObject: aList];
+      if (_availableColorLists != nil)
+	{
+	  [NSColorList _indexAvailableColorLists];
+	}
     }
   [_colorListLock unlock];
 }
@@ -670,9 +841,50 @@ static NSColorList *themeColorList = nil;
 	}
       ASSIGN(themeColorList, aList);
       [_availableColorLists insertObject: aList atIndex: 0];
+      if (_availableColorLists != nil)
+	{
+	  [NSColorList _indexAvailableColorLists];
+	}
     }
   [_colorListLock unlock];
 }
 
 @end
 
+@implementation NSColorList (GSBinaryFormat)
+
+- (NSData *) binaryRepresentation
+{
+  NSMutableData	*data = [NSMutableData dataWithCapacity: 1024];
+  NSArray	*keys = [self allKeys];
+  uint32_t	nColors = NSSwapHostIntToBig((uint32_t)[keys count]);
+  NSUInteger	i;
+
+  [data appendBytes: "GSCL\1" length: 5];
+  [data appendBytes: &nColors length: 4];
+  for (i = 0; i < [keys count]; i++)
+    {
+      NSString		*key = [keys objectAtIndex: i];
+      NSData		*name = [key dataUsingEncoding: NSUTF8StringEncoding];
+      NSColor		*color = [_colorDictionary objectForKey: key];
+      NSSwappedFloat	c[4];
+      uint16_t		nameLength;
+
+      color = [color colorUsingColorSpaceName: NSCalibratedRGBColorSpace];
+      if (color == nil || [name length] > 0xffff)
+	{
+	  return nil;
+	}
+      nameLength = NSSwapHostShortToBig((uint16_t)[name length]);
+      c[0] = NSSwapHostFloatToBig([color redComponent]);
+      c[1] = NSSwapHostFloatToBig([color greenComponent]);
+      c[2] = NSSwapHostFloatToBig([color blueComponent]);
+      c[3] = NSSwapHostFloatToBig([color alphaComponent]);
+      [data appendBytes: &nameLength length: 2];
+      [data appendData: name];
+      [data appendBytes: c length: sizeof(c)];
+    }
+  return data;
+}
+
+@end
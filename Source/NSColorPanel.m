@@ -28,12 +28,14 @@
 
 #import "config.h"
 #import <Foundation/NSBundle.h>
+#import <Foundation/NSDictionary.h>
 #import <Foundation/NSEnumerator.h>
 #import <Foundation/NSException.h>
 #import <Foundation/NSFileManager.h>
 #import <Foundation/NSLock.h>
 #import <Foundation/NSNotification.h>
 #import <Foundation/NSPathUtilities.h>
+#import <Foundation/NSValue.h>
 #import "AppKit/NSBox.h"
 #import "AppKit/NSButton.h"
 #import "AppKit/NSButtonCell.h"
@@ -82,9 +84,113 @@ static int _gs_gui_color_picker_mode = NSRGBModeColorPanel;
 
 @end
 
+/* Stands in for a color picker whose bundle describes its button image
+ * and modes in its Info.plist (GSColorPickerButtonImage and
+ * GSColorPickerModes), so that the bundle's code is only loaded and the
+ * picker only created once the user selects it.  Color lists attached
+ * before then are remembered and passed on to the real picker.
+ */
+@interface GSColorPickerPlaceholder : NSObject
+{
+  NSString	*path;
+  NSString	*imageName;
+  NSArray	*modes;
+  NSMutableArray	*colorLists;
+}
+- (id) initWithPath: (NSString *)aPath info: (NSDictionary *)info;
+- (NSString *) path;
+- (NSArray *) colorLists;
+- (int) pickerMask;
+@end
+
+@implementation GSColorPickerPlaceholder
+
+- (id) initWithPath: (NSString *)aPath info: (NSDictionary *)info
+{
+  if ((self = [super init]) != nil)
+    {
+      ASSIGN(path, aPath);
+      ASSIGN(imageName, [info objectForKey: @"GSColorPickerButtonImage"]);
+      ASSIGN(modes, [info objectForKey: @"GSColorPickerModes"]);
+      colorLists = [NSMutableArray new];
+    }
+  return self;
+}
+
+- (void) dealloc
+{
+  RELEASE(path);
+  RELEASE(imageName);
+  RELEASE(modes);
+  RELEASE(colorLists);
+  [super dealloc];
+}
+
+- (NSString *) path
+{
+  return path;
+}
+
+- (NSArray *) colorLists
+{
+  return colorLists;
+}
+
+- (int) pickerMask
+{
+  NSEnumerator	*e = [modes objectEnumerator];
+  id		mode;
+  int		mask = 0;
+
+  while ((mode = [e nextObject]) != nil)
+    {
+      mask |= 1 << [mode intValue];
+    }
+  return mask;
+}
+
+- (BOOL) supportsMode: (int)mode
+{
+  return [modes containsObject: [NSNumber numberWithInt: mode]];
+}
+
+- (NSImage *) provideNewButtonImage
+{
+  NSBundle	*bundle = [NSBundle bundleWithPath: path];
+  NSString	*file = [bundle pathForImageResource: imageName];
+
+  if (file == nil)
+    return nil;
+  return AUTORELEASE([[NSImage alloc] initWithContentsOfFile: file]);
+}
+
+- (void) insertNewButtonImage: (NSImage *)newImage
+			   in: (NSButtonCell *)newButtonCell
+{
+  [newButtonCell setImage: newImage];
+}
+
+- (void) alphaControlAddedOrRemoved: (id)sender
+{
+}
+
+- (void) attachColorList: (NSColorList *)aColorList
+{
+  [colorLists addObject: aColorList];
+}
+
+- (void) detachColorList: (NSColorList *)aColorList
+{
+  [colorLists removeObjectIdenticalTo: aColorList];
+}
+
+@end
+
 @interface NSColorPanel (PrivateMethods)
 - (void) _loadPickers;
 - (void) _loadPickerAtPath: (NSString *)path;
+- (id) _newPickerFromBundle: (NSBundle *)bundle;
+- (id) _pickerAtIndex: (NSInteger)index;
 - (void) _fixupMatrix;
 - (void) _setupPickers;
 - (void) _showNewPicker: (id)sender;
@@ -135,24 +241,91 @@ static int _gs_gui_color_picker_mode = NSRGBModeColorPanel;
 - (void) _loadPickerAtPath: (NSString *)path
 {
   NSBundle	*bundle;
+  NSDictionary	*info;
+  id		picker;
+
+  bundle = [NSBundle bundleWithPath: path];
+  if (bundle == nil)
+    return;
+
+  /* A bundle that describes its picker is not loaded until the picker
+   * is selected.  Others must be loaded now to get their button image.
+   */
+  info = [bundle infoDictionary];
+  if ([info objectForKey: @"GSColorPickerModes"] != nil
+    && [info objectForKey: @"GSColorPickerButtonImage"] != nil)
+    {
+      picker = [[GSColorPickerPlaceholder alloc] initWithPath: path
+							  info: info];
+      if ([picker pickerMask] & _gs_gui_color_picker_mask)
+	{
+	  [_pickers addObject: picker];
+	}
+      RELEASE(picker);
+      return;
+    }
+
+  picker = [self _newPickerFromBundle: bundle];
+  if (picker != nil)
+    {
+      [_pickers addObject: picker];
+      RELEASE(picker);
+    }
+}
+
+/* Loads the bundle's code and returns a new picker with its view
+ * created, or nil if the bundle has no valid picker.
+ */
+- (id) _newPickerFromBundle: (NSBundle *)bundle
+{
   Class		pickerClass;
   NSColorPicker	*picker;
 
-  bundle = [NSBundle bundleWithPath: path];
-  if (bundle && (pickerClass = [bundle principalClass]))
+  if ((pickerClass = [bundle principalClass]) == Nil)
+    return nil;
+
+  picker = [[pickerClass alloc] initWithPickerMask:_gs_gui_color_picker_mask
+					colorPanel: self];
+  if (picker && [picker conformsToProtocol:@protocol(NSColorPickingCustom)])
     {
-      picker = [[pickerClass alloc] initWithPickerMask:_gs_gui_color_picker_mask
-                                            colorPanel: self];
-      if (picker && [picker conformsToProtocol:@protocol(NSColorPickingCustom)])
-        {
-          [(id<NSColorPickingCustom>)picker provideNewView: YES];
-          [_pickers addObject: picker];
-        }
-      else
+      [(id<NSColorPickingCustom>)picker provideNewView: YES];
+      return picker;
+    }
+  NSLog(@"%@ does not contain a valid color picker.", [bundle bundlePath]);
+  RELEASE(picker);
+  return nil;
+}
+
+/* Returns the picker at index, replacing a placeholder with the real
+ * picker first.  Returns nil if the picker can't be loaded.
+ */
+- (id) _pickerAtIndex: (NSInteger)index
+{
+  id	picker = [_pickers objectAtIndex: index];
+
+  if ([picker isKindOfClass: [GSColorPickerPlaceholder class]])
+    {
+      GSColorPickerPlaceholder	*placeholder = picker;
+      NSEnumerator		*e;
+      NSColorList		*list;
+
+      picker = [self _newPickerFromBundle:
+	[NSBundle bundleWithPath: [placeholder path]]];
+      if (picker == nil)
+	return nil;
+
+      e = [[placeholder colorLists] objectEnumerator];
+      while ((list = [e nextObject]) != nil)
 	{
-	  NSLog(@"%@ does not contain a valid color picker.", path);
+	  [picker attachColorList: list];
 	}
+      [picker alphaControlAddedOrRemoved: self];
+      [picker insertNewButtonImage: [picker provideNewButtonImage]
+				in: [_pickerMatrix cellWithTag: index]];
+      [_pickers replaceObjectAtIndex: index withObject: picker];
+      RELEASE(picker);
     }
+  return picker;
 }
 
 // FIXME - this is a HACK to get around problems in the gmodel code
@@ -206,7 +379,14 @@ static int _gs_gui_color_picker_mode = NSRGBModeColorPanel;
 
 - (void) _showNewPicker: (id)sender
 {
-  _currentPicker = [_pickers objectAtIndex: [sender selectedColumn]];
+  id	picker = [self _pickerAtIndex: [sender selectedColumn]];
+
+  if (picker == nil)
+    {
+      NSBeep();
+      return;
+    }
+  _currentPicker = picker;
   [_currentPicker setColor: [_colorWell color]];
   [_pickerBox setContentView: [_currentPicker provideNewView: NO]];
 }
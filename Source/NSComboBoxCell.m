@@ -27,6 +27,7 @@
 */
 
 #import <Foundation/NSNotification.h>
+#import <Foundation/NSNull.h>
 #import <Foundation/NSString.h>
 #import <Foundation/NSArray.h>
 #import <Foundation/NSRunLoop.h>
@@ -52,6 +53,7 @@
 #import "AppKit/NSTextView.h"
 #import "GNUstepGUI/GSTheme.h"
 #import "GSGuiPrivate.h"
+#import "GSTypeSelectIndex.h"
 
 static NSNotificationCenter *nc;
 
@@ -107,6 +109,8 @@ static NSNotificationCenter *nc;
 - (void) _setSelectedItem: (NSInteger)index;
 - (void) _loadButtonCell;
 - (void) _selectCompleted;
+- (GSTypeSelectIndex *) _completionIndex;
+- (NSUInteger) _indexOfCompletedString: (NSString *)substring;
 @end
 
 // ---
@@ -667,6 +671,7 @@ static GSComboWindow *gsWindow = nil;
 {
   RELEASE(_buttonCell);
   RELEASE(_popUpList);
+  RELEASE(_completionIndex);
   
   [super dealloc];
 }
@@ -678,6 +683,7 @@ static GSComboWindow *gsWindow = nil;
   c->_buttonCell = [_buttonCell copyWithZone: zone];
   [c->_buttonCell setTarget: c];
   c->_popUpList = [_popUpList copyWithZone: zone];
+  c->_completionIndex = nil;
 
   return c;
 }
@@ -771,6 +777,7 @@ static GSComboWindow *gsWindow = nil;
  */
 - (void) reloadData
 {
+  DESTROY(_completionIndex);
   [_popup reloadData];
 }
 
@@ -787,6 +794,23 @@ static GSComboWindow *gsWindow = nil;
  */
 - (void) noteNumberOfItemsChanged
 {
+  if (_completionIndex != nil)
+    {
+      NSUInteger count = [self numberOfItems];
+      NSUInteger i = [_completionIndex count];
+
+      /* Items are only expected to have been added, which can be
+	 indexed as they are.  */
+      if (count < i)
+	{
+	  DESTROY(_completionIndex);
+	}
+      for (; i < count; i++)
+	{
+	  [_completionIndex setString: [self _stringValueAtIndex: i]
+			      forItem: i];
+	}
+    }
   [_popup noteNumberOfItemsChanged];
 }
 
@@ -807,6 +831,7 @@ static GSComboWindow *gsWindow = nil;
 - (void) setUsesDataSource: (BOOL)flag
 {
   _usesDataSource = flag;
+  DESTROY(_completionIndex);
 }
 
 /**
@@ -954,6 +979,7 @@ static GSComboWindow *gsWindow = nil;
   else
     {
       _dataSource = aSource;
+      DESTROY(_completionIndex);
     }
 }
 
@@ -1268,28 +1294,18 @@ static GSComboWindow *gsWindow = nil;
 	}
       else
         {
-          NSInteger i;
+          NSUInteger i = [self _indexOfCompletedString: substring];
 
-          for (i = 0; i < [self numberOfItems]; i++)
-            {
-	      NSString *str = [self _stringValueAtIndex: i];
-
-	      if ([str length] > [substring length] && [str hasPrefix: substring])
-	        return str;
-            }	
+          if (i != NSNotFound)
+            return [self _stringValueAtIndex: i];
 	}
     }
   else
     {
-      NSUInteger i;
+      NSUInteger i = [self _indexOfCompletedString: substring];
 
-      for (i = 0; i < [_popUpList count]; i++)
-        {
-	  NSString *str = [[_popUpList objectAtIndex: i] description];
-
-	  if ([str length] > [substring length] && [str hasPrefix: substring])
-	    return str;
-        }
+      if (i != NSNotFound)
+        return [[_popUpList objectAtIndex: i] description];
     }
   
   return substring;
@@ -1908,6 +1924,16 @@ static inline NSRect buttonCellFrameFromRect(NSRect cellRect)
 	    }
 	}
     }
+  else if ([more isKindOfClass: [NSString class]])
+    {
+      index = [[self _completionIndex] itemWithString: more];
+      if (index != NSNotFound
+	  && ![[_popUpList objectAtIndex: index] isEqual: more])
+	{
+	  /* Only the description of the item is the string.  */
+	  index = [[self objectValues] indexOfObject: more];
+	}
+    }
   else
     {
       index = [[self objectValues] indexOfObject: more];
@@ -1920,4 +1946,33 @@ static inline NSRect buttonCellFrameFromRect(NSRect cellRect)
   // Otherwise keep old selection
 }
 
+/* The strings of the items sorted for completion, made when first
+   needed after the items change.  */
+- (GSTypeSelectIndex *) _completionIndex
+{
+  if (_completionIndex == nil)
+    {
+      NSUInteger count = [self numberOfItems];
+      NSMutableArray *strings = [NSMutableArray arrayWithCapacity: count];
+      NSUInteger i;
+
+      for (i = 0; i < count; i++)
+	{
+	  NSString *str = [self _stringValueAtIndex: i];
+
+	  [strings addObject: (str != nil) ? (id)str : (id)[NSNull null]];
+	}
+      _completionIndex = [[GSTypeSelectIndex alloc] initWithStrings: strings
+							  foldsCase: NO];
+    }
+  return _completionIndex;
+}
+
+/* Returns the index of the first item whose string extends substring,
+   or NSNotFound.  */
+- (NSUInteger) _indexOfCompletedString: (NSString *)substring
+{
+  return [[self _completionIndex] itemExtendingPrefix: substring];
+}
+
 @end
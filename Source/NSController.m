@@ -30,6 +30,7 @@
 #import <Foundation/NSArchiver.h>
 #import <Foundation/NSKeyedArchiver.h>
 #import "AppKit/NSController.h"
+#import "GSBindingHelpers.h"
 
 @implementation NSController
 
@@ -137,3 +138,17 @@
 }
 
 @end
+
+@implementation NSController (GNUstepExtensions)
+
+- (void) beginBatchedChanges
+{
+  [GSKeyValueBinding beginBatchForObject: self];
+}
+
+- (void) endBatchedChanges
+{
+  [GSKeyValueBinding endBatchForObject: self];
+}
+
+@end
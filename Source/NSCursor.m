@@ -28,6 +28,8 @@
    Boston, MA 02110-1301, USA.
 */ 
 
+#include <string.h>
+
 #import <Foundation/NSArray.h>
 #import <Foundation/NSDebug.h>
 #import <Foundation/NSDictionary.h>
@@ -49,6 +51,102 @@ static Class NSCursor_class;
 
 static NSMutableDictionary *cursorDict = nil;
 
+/*
+ * The backend cursors made from images are shared by all the cursors
+ * with the same image and hot spot, so that cursors which are made again
+ * and again, eg. in -resetCursorRects, cost one conversion of the image
+ * for as long as any of them is alive.
+ */
+typedef struct {
+  NSImage *image;
+  NSPoint hotSpot;
+  void *cid;
+  NSUInteger users;
+} GSSharedCursor;
+
+static GSSharedCursor *sharedCursors = NULL;
+static NSUInteger numSharedCursors = 0;
+static NSUInteger maxSharedCursors = 0;
+
+static GSSharedCursor *
+sharedCursorForCid(void *cid)
+{
+  NSUInteger i;
+
+  for (i = 0; i < numSharedCursors; i++)
+    {
+      if (sharedCursors[i].cid == cid)
+        {
+          return &sharedCursors[i];
+        }
+    }
+  return NULL;
+}
+
+static void
+removeSharedCursor(GSSharedCursor *s)
+{
+  RELEASE(s->image);
+  numSharedCursors--;
+  memmove(s, s + 1, (numSharedCursors - (s - sharedCursors))
+    * sizeof(GSSharedCursor));
+}
+
+static void *
+leaseCursor(NSImage *image, NSPoint hotSpot)
+{
+  GSSharedCursor *s;
+  NSUInteger i;
+  void *c = NULL;
+
+  for (i = 0; i < numSharedCursors; i++)
+    {
+      s = &sharedCursors[i];
+      if (s->image == image && NSEqualPoints(s->hotSpot, hotSpot))
+        {
+          s->users++;
+          return s->cid;
+        }
+    }
+
+  [GSCurrentServer() imagecursor: hotSpot : image : &c];
+  if (c == NULL)
+    {
+      return NULL;
+    }
+  if (numSharedCursors == maxSharedCursors)
+    {
+      maxSharedCursors = 2 * maxSharedCursors + 8;
+      sharedCursors = NSZoneRealloc(NSDefaultMallocZone(), sharedCursors,
+        maxSharedCursors * sizeof(GSSharedCursor));
+    }
+  s = &sharedCursors[numSharedCursors++];
+  s->image = RETAIN(image);
+  s->hotSpot = hotSpot;
+  s->cid = c;
+  s->users = 1;
+  return c;
+}
+
+/* Gives up one use of a backend cursor got from leaseCursor(), and frees
+   it after the last one.  Returns NO when cid is not a shared cursor.  */
+static BOOL
+releaseCursor(void *cid)
+{
+  GSSharedCursor *s = sharedCursorForCid(cid);
+
+  if (s == NULL)
+    {
+      return NO;
+    }
+  if (--s->users == 0)
+    {
+      [GSCurrentServer() freecursor: cid];
+      removeSharedCursor(s);
+    }
+  return YES;
+}
+
 @implementation NSCursor
 
 /*
@@ -82,16 +180,41 @@ static NSMutableDictionary *cursorDict = nil;
 
 - (void) _computeCid
 {
-  void *c;
-  
+  if (_cid != NULL)
+    {
+      releaseCursor(_cid);
+    }
   if (_cursor_image == nil)
     {
       _cid = NULL;
       return;
     }
 
-  [GSCurrentServer() imagecursor: _hot_spot : _cursor_image : &c];
-  _cid = c;
+  _cid = leaseCursor(_cursor_image, _hot_spot);
+}
+
+/* Makes sure no other cursor uses the backend cursor of the receiver,
+   before it is changed.  */
+- (void) _unshareCid
+{
+  GSSharedCursor *s = sharedCursorForCid(_cid);
+
+  if (s == NULL)
+    {
+      return;
+    }
+  if (s->users == 1)
+    {
+      removeSharedCursor(s);
+    }
+  else
+    {
+      void *c = NULL;
+
+      s->users--;
+      [GSCurrentServer() imagecursor: _hot_spot : _cursor_image : &c];
+      _cid = c;
+    }
 }
 
 /**<p>Hides the current cursor.</p>
@@ -361,6 +484,7 @@ backgroundColorHint:(NSColor *)bg
 	fg = [NSColor blackColor];
       bg = [bg colorUsingColorSpaceName: NSDeviceRGBColorSpace];
       fg = [fg colorUsingColorSpaceName: NSDeviceRGBColorSpace];
+      [self _unshareCid];
       [GSCurrentServer() recolorcursor: fg : bg : _cid];
     }
   return self;
@@ -369,7 +493,7 @@ backgroundColorHint:(NSColor *)bg
 - (void) dealloc
 {
   RELEASE(_cursor_image);
-  if (_cid)
+  if (_cid && releaseCursor(_cid) == NO)
     {
       [GSCurrentServer() freecursor: _cid];
     }
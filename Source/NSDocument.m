@@ -28,13 +28,21 @@
    Boston, MA 02110-1301, USA.
 */
 
+#import <Foundation/FoundationErrors.h>
+#import <Foundation/NSByteOrder.h>
 #import <Foundation/NSData.h>
+#import <Foundation/NSDictionary.h>
+#import <Foundation/NSError.h>
 #import <Foundation/NSException.h>
+#import <Foundation/NSFileHandle.h>
 #import <Foundation/NSFileManager.h>
 #import <Foundation/NSNotification.h>
+#import <Foundation/NSOperation.h>
 #import <Foundation/NSProcessInfo.h>
+#import <Foundation/NSThread.h>
 #import <Foundation/NSUndoManager.h>
 #import <Foundation/NSURL.h>
+#import "AppKit/NSApplication.h"
 #import "AppKit/NSBox.h"
 #import "AppKit/NSDocument.h"
 #import "AppKit/NSFileWrapper.h"
@@ -44,10 +52,150 @@
 #import "AppKit/NSPrintInfo.h"
 #import "AppKit/NSPrintOperation.h"
 #import "AppKit/NSView.h"
+#import "AppKit/NSWindow.h"
+#import "AppKit/NSWindowController.h"
 #import "NSDocumentFrameworkPrivate.h"
 
 #import "GSGuiPrivate.h"
 
+/* The time a background save may take before the windows show it. */
+#define SAVE_PROGRESS_DELAY 0.5
+/* An autosave journal smaller than this is never compacted. */
+#define JOURNAL_MIN_COMPACT (256 * 1024)
+/* Otherwise it is compacted once it is larger than the autosaved
+ * contents divided by this. */
+#define JOURNAL_COMPACT_RATIO 4
+
+/*
+ * A save of a document running in the background.  The snapshot of the
+ * document is taken on the main thread; it is written on the save queue
+ * and the document is updated on the main thread afterwards.
+ */
+@interface GSDocumentSave : NSObject
+{
+@public
+  NSDocument		*document;
+  NSURL			*url;
+  NSString		*type;
+  NSSaveOperationType	op;
+  NSFileWrapper		*wrapper;
+  NSDictionary		*attributes;
+  BOOL			backup;
+  long			changeCount;	// Changes included in the snapshot
+  long			autosaveChangeCount;
+  id			delegate;
+  SEL			didSaveSelector;
+  void			*contextInfo;
+  BOOL			saved;
+  NSError		*error;
+}
+- (void) write;
+@end
+
+static NSOperationQueue	*saveQueue = nil;
+static NSMutableArray	*runningSaves = nil;
+
+@interface NSDocument (BackgroundSaving)
+- (BOOL) _saveInBackgroundToURL: (NSURL *)url
+			 ofType: (NSString *)type
+	       forSaveOperation: (NSSaveOperationType)op
+		       delegate: (id)delegate
+		didSaveSelector: (SEL)didSaveSelector
+		    contextInfo: (void *)contextInfo;
+- (BOOL) _isSavingInBackground;
+- (void) _didSaveInBackground: (GSDocumentSave *)save;
+- (void) _showSaveProgress;
+@end
+
+@interface NSDocument (AutosaveJournal)
+- (BOOL) _appendToAutosaveJournalOfType: (NSString *)type;
+- (void) _removeAutosaveJournalForURL: (NSURL *)url;
+- (void) _replayAutosaveJournalForURL: (NSURL *)url ofType: (NSString *)type;
+@end
+
+static NSString *
+journalPathForURL(NSURL *url)
+{
+  return [[url path] stringByAppendingString: @".journal"];
+}
+
+@implementation GSDocumentSave
+
+- (void) dealloc
+{
+  RELEASE(document);
+  RELEASE(url);
+  RELEASE(type);
+  RELEASE(wrapper);
+  RELEASE(attributes);
+  RELEASE(delegate);
+  RELEASE(error);
+  [super dealloc];
+}
+
+- (void) write
+{
+  CREATE_AUTORELEASE_POOL(pool);
+  NSFileManager	*fileManager = [NSFileManager defaultManager];
+  NSString	*path = [url path];
+
+  NS_DURING
+    {
+      if (backup && [fileManager fileExistsAtPath: path])
+	{
+	  NSString	*extension = [path pathExtension];
+	  NSString	*backupFilename;
+
+	  /* The file is written atomically, so the backup can share the old
+	   * contents with a link rather than copying them.
+	   */
+	  backupFilename = [[path stringByDeletingPathExtension]
+	    stringByAppendingString: @"~"];
+	  backupFilename
+	    = [backupFilename stringByAppendingPathExtension: extension];
+	  [fileManager removeFileAtPath: backupFilename handler: nil];
+	  if (![fileManager linkPath: path toPath: backupFilename handler: nil])
+	    {
+	      [fileManager copyPath: path toPath: backupFilename handler: nil];
+	    }
+	}
+      saved = [wrapper writeToFile: path atomically: YES updateFilenames: NO];
+      if (saved)
+	{
+	  [fileManager changeFileAttributes: attributes atPath: path];
+	}
+      else
+	{
+	  error = [[NSError alloc] initWithDomain: NSCocoaErrorDomain
+	    code: NSFileWriteUnknownError
+	    userInfo: [NSDictionary dictionaryWithObject: path
+						  forKey: NSFilePathErrorKey]];
+	}
+    }
+  NS_HANDLER
+    {
+      saved = NO;
+      DESTROY(error);
+      error = [[NSError alloc] initWithDomain: NSCocoaErrorDomain
+	code: NSFileWriteUnknownError
+	userInfo: [NSDictionary dictionaryWithObjectsAndKeys:
+	  path, NSFilePathErrorKey,
+	  [localException reason], NSLocalizedFailureReasonErrorKey, nil]];
+    }
+  NS_ENDHANDLER
+  /* Let go of the snapshot here rather than on the main thread. */
+  DESTROY(wrapper);
+  [document performSelectorOnMainThread: @selector(_didSaveInBackground:)
+			     withObject: self
+			  waitUntilDone: NO
+				  modes: [NSArray arrayWithObjects:
+    NSDefaultRunLoopMode, NSModalPanelRunLoopMode,
+    NSEventTrackingRunLoopMode, nil]];
+  RELEASE(pool);
+}
+
+@end
+
 @implementation NSDocument
 
 + (NSArray *) readableTypes
@@ -164,6 +312,7 @@ withContentsOfURL: (NSURL *)url
         {
           if (![url isEqual: forUrl])
             {
+              [self _replayAutosaveJournalForURL: url ofType: type];
               [self setAutosavedContentsFileURL: url];
               [self updateChangeCount: NSChangeReadOtherContents];
             }
@@ -899,6 +1048,7 @@ withContentsOfURL: (NSURL *)url
 
       if (isAutosave)
 	{
+	  [self _removeAutosaveJournalForURL: url];
 	  [self setAutosavedContentsFileURL: url];
 	  [self updateChangeCount: NSChangeAutosaved];
 	}
@@ -959,6 +1109,7 @@ withContentsOfURL: (NSURL *)url
 
   if (op == NSAutosaveOperation)
     {
+      [self _removeAutosaveJournalForURL: url];
       [self setAutosavedContentsFileURL: url];
       [self updateChangeCount: NSChangeAutosaved];
     }
@@ -1484,7 +1635,7 @@ originalContentsURL: (NSURL *)orig
   if (sel_isEqual([anItem action], @selector(revertDocumentToSaved:)))
     return ([self fileName] != nil && [self isDocumentEdited]);
   if (sel_isEqual([anItem action], @selector(saveDocument:)))
-    return [self isDocumentEdited];
+    return [self isDocumentEdited] && ![self _isSavingInBackground];
 
   // FIXME should validate spa popup items; return YES if it's a native type.
 
@@ -1625,6 +1776,16 @@ originalContentsURL: (NSURL *)orig
   NSError *error;
   BOOL saved;
 
+  if ([self _saveInBackgroundToURL: url
+			    ofType: type
+		  forSaveOperation: op
+			  delegate: delegate
+		   didSaveSelector: didSaveSelector
+		       contextInfo: contextInfo])
+    {
+      return;
+    }
+
   saved = [self saveToURL: url
                 ofType: type
                 forSaveOperation: op
@@ -1836,6 +1997,25 @@ originalContentsURL: (NSURL *)orig
       path = [path stringByAppendingPathExtension: ext];
       url = [NSURL fileURLWithPath: path];
     }
+  else if ([self _isSavingInBackground]
+    || ([self autosavesIncrementally]
+      && [self _appendToAutosaveJournalOfType: type]))
+    {
+      /* Either the changes went to the journal, or a background save is
+       * still writing and the next autosave will pick them up.
+       */
+      BOOL	saved = ![self _isSavingInBackground];
+
+      if (delegate != nil && didAutosaveSelector != NULL)
+	{
+	  void (*meth)(id, SEL, id, BOOL, void*);
+	  meth = (void (*)(id, SEL, id, BOOL, void*))[delegate
+	    methodForSelector: didAutosaveSelector];
+	  if (meth)
+	    meth(delegate, didAutosaveSelector, self, saved, context);
+	}
+      return;
+    }
 
   [self saveToURL: url
         ofType: type
@@ -1855,6 +2035,370 @@ originalContentsURL: (NSURL *)orig
   return _autosave_change_count != 0 || _doc_flags.autosave_permanently_modified;
 }
 
+- (BOOL) canAsynchronouslyWriteToURL: (NSURL *)url
+			      ofType: (NSString *)type
+		    forSaveOperation: (NSSaveOperationType)op
+{
+  return NO;
+}
+
+@end
+
+@implementation NSDocument (GSIncrementalAutosave)
+
+- (BOOL) autosavesIncrementally
+{
+  return NO;
+}
+
+- (NSData *) autosaveJournalEntryOfType: (NSString *)type
+				  error: (NSError **)error
+{
+  if (error)
+    *error = nil;
+  return nil;
+}
+
+- (BOOL) replayAutosaveJournalEntry: (NSData *)entry
+			     ofType: (NSString *)type
+			      error: (NSError **)error
+{
+  if (error)
+    *error = nil;
+  return NO;
+}
+
+@end
+
+@implementation NSDocument (AutosaveJournal)
+
+/*
+ * Appends the changes since the last autosave to the journal of the
+ * autosaved contents.  Returns NO if the whole document should be
+ * autosaved instead, because there are no autosaved contents to add to,
+ * the journal is due to be compacted or the document could not describe
+ * its changes.
+ */
+- (BOOL) _appendToAutosaveJournalOfType: (NSString *)type
+{
+  NSFileManager		*fileManager = [NSFileManager defaultManager];
+  NSURL			*url = [self autosavedContentsFileURL];
+  NSString		*path = journalPathForURL(url);
+  unsigned long long	baseSize;
+  unsigned long long	journalSize;
+  NSFileHandle		*handle;
+  NSData		*entry;
+  uint32_t		length;
+
+  if (url == nil || ![url isFileURL]
+    || ![type isEqual: [self autosavingFileType]])
+    {
+      return NO;
+    }
+  baseSize = [[fileManager fileAttributesAtPath: [url path]
+				   traverseLink: YES] fileSize];
+  journalSize = [[fileManager fileAttributesAtPath: path
+				      traverseLink: YES] fileSize];
+  if (baseSize == 0 || (journalSize > JOURNAL_MIN_COMPACT
+    && journalSize > baseSize / JOURNAL_COMPACT_RATIO))
+    {
+      return NO;
+    }
+
+  entry = [self autosaveJournalEntryOfType: type error: NULL];
+  if (entry == nil)
+    {
+      return NO;
+    }
+
+  if (![fileManager fileExistsAtPath: path])
+    {
+      [fileManager createFileAtPath: path contents: nil attributes: nil];
+    }
+  handle = [NSFileHandle fileHandleForUpdatingAtPath: path];
+  if (handle == nil)
+    {
+      return NO;
+    }
+  /* Each entry is preceded by its length, so that an entry cut short by
+   * a crash can be recognised and left out when the journal is replayed.
+   */
+  length = NSSwapHostIntToBig([entry length]);
+  NS_DURING
+    {
+      [handle seekToEndOfFile];
+      [handle writeData: [NSData dataWithBytes: &length
+					length: sizeof(length)]];
+      [handle writeData: entry];
+      [handle synchronizeFile];
+      [handle closeFile];
+    }
+  NS_HANDLER
+    {
+      NSLog(@"Could not append to the autosave journal %@: %@",
+	path, [localException reason]);
+      [handle closeFile];
+      [self _removeAutosaveJournalForURL: url];
+      NS_VALRETURN(NO);
+    }
+  NS_ENDHANDLER
+
+  [self updateChangeCount: NSChangeAutosaved];
+  return YES;
+}
+
+- (void) _removeAutosaveJournalForURL: (NSURL *)url
+{
+  if (url != nil && [url isFileURL])
+    {
+      [[NSFileManager defaultManager] removeFileAtPath: journalPathForURL(url)
+					       handler: nil];
+    }
+}
+
+- (void) _replayAutosaveJournalForURL: (NSURL *)url ofType: (NSString *)type
+{
+  NSData	*journal;
+  const uint8_t	*bytes;
+  NSUInteger	length;
+  NSUInteger	offset = 0;
+
+  if (![url isFileURL] || ![self autosavesIncrementally])
+    {
+      return;
+    }
+  journal = [NSData dataWithContentsOfMappedFile: journalPathForURL(url)];
+  bytes = [journal bytes];
+  length = [journal length];
+  while (offset + sizeof(uint32_t) <= length)
+    {
+      uint32_t	size;
+      NSData	*entry;
+      NSError	*error = nil;
+
+      memcpy(&size, bytes + offset, sizeof(size));
+      size = NSSwapBigIntToHost(size);
+      offset += sizeof(uint32_t);
+      if (size > length - offset)
+	{
+	  NSLog(@"Ignoring the incomplete end of the autosave journal of %@",
+	    [url path]);
+	  break;
+	}
+      entry = [journal subdataWithRange: NSMakeRange(offset, size)];
+      offset += size;
+      if (![self replayAutosaveJournalEntry: entry ofType: type error: &error])
+	{
+	  NSLog(@"Could not replay the autosave journal of %@: %@",
+	    [url path], error);
+	  break;
+	}
+    }
+}
+
+@end
+
+@implementation NSDocument (BackgroundSaving)
+
+/*
+ * Starts writing the document in the background and returns YES, or
+ * returns NO if it has to be saved in the foreground.
+ */
+- (BOOL) _saveInBackgroundToURL: (NSURL *)url
+			 ofType: (NSString *)type
+	       forSaveOperation: (NSSaveOperationType)op
+		       delegate: (id)delegate
+		didSaveSelector: (SEL)didSaveSelector
+		    contextInfo: (void *)contextInfo
+{
+  GSDocumentSave	*save;
+  NSInvocationOperation	*operation;
+  NSFileWrapper		*wrapper;
+  NSError		*error = nil;
+
+  /* Only the default writing methods are known to work from a snapshot.
+   */
+  if (![url isFileURL] || ![[self class] isNativeType: type]
+    || OVERRIDDEN(writeSafelyToURL:ofType:forSaveOperation:error:)
+    || OVERRIDDEN(writeWithBackupToFile:ofType:saveOperation:)
+    || OVERRIDDEN(writeToURL:ofType:forSaveOperation:originalContentsURL:error:)
+    || OVERRIDDEN(writeToFile:ofType:originalFile:saveOperation:)
+    || OVERRIDDEN(writeToURL:ofType:error:)
+    || OVERRIDDEN(writeToFile:ofType:)
+    || ![self canAsynchronouslyWriteToURL: url
+				   ofType: type
+			 forSaveOperation: op])
+    {
+      return NO;
+    }
+
+  wrapper = [self fileWrapperOfType: type error: &error];
+  if (wrapper == nil)
+    {
+      /* Let the foreground save report the failure. */
+      return NO;
+    }
+
+  save = AUTORELEASE([GSDocumentSave new]);
+  save->document = RETAIN(self);
+  save->url = RETAIN(url);
+  save->type = [type copy];
+  save->op = op;
+  save->wrapper = RETAIN(wrapper);
+  save->attributes = RETAIN([self fileAttributesToWriteToURL: url
+						       ofType: type
+					     forSaveOperation: op
+					  originalContentsURL: [self fileURL]
+							error: NULL]);
+  save->backup = (op == NSSaveOperation && [self keepBackupFile]);
+  save->changeCount = _change_count;
+  save->autosaveChangeCount = _autosave_change_count;
+  save->delegate = RETAIN(delegate);
+  save->didSaveSelector = didSaveSelector;
+  save->contextInfo = contextInfo;
+
+  if (saveQueue == nil)
+    {
+      saveQueue = [NSOperationQueue new];
+      [saveQueue setMaxConcurrentOperationCount: 1];
+      runningSaves = [NSMutableArray new];
+    }
+  if ([self _isSavingInBackground] == NO)
+    {
+      [self performSelector: @selector(_showSaveProgress)
+		 withObject: nil
+		 afterDelay: SAVE_PROGRESS_DELAY];
+    }
+  [runningSaves addObject: save];
+  operation = [[NSInvocationOperation alloc] initWithTarget: save
+						   selector: @selector(write)
+						     object: nil];
+  [saveQueue addOperation: operation];
+  RELEASE(operation);
+  return YES;
+}
+
+- (BOOL) _isSavingInBackground
+{
+  NSUInteger	i = [runningSaves count];
+
+  while (i-- > 0)
+    {
+      if (((GSDocumentSave *)[runningSaves objectAtIndex: i])->document
+	== self)
+	{
+	  return YES;
+	}
+    }
+  return NO;
+}
+
+- (void) _showSaveProgress
+{
+  NSEnumerator		*enumerator = [_window_controllers objectEnumerator];
+  NSWindowController	*controller;
+
+  while ((controller = [enumerator nextObject]) != nil)
+    {
+      NSWindow	*window = [controller window];
+
+      [window setTitle: [NSString stringWithFormat: _(@"%@ (saving)"),
+	[window title]]];
+    }
+}
+
+- (void) _didSaveInBackground: (GSDocumentSave *)save
+{
+  NSSaveOperationType	op = save->op;
+  NSUInteger		i;
+  BOOL			saving = NO;
+
+  RETAIN(save);
+  [runningSaves removeObjectIdenticalTo: save];
+  for (i = 0; i < [runningSaves count]; i++)
+    {
+      GSDocumentSave	*other = [runningSaves objectAtIndex: i];
+
+      if (other->document == self)
+	{
+	  /* The changes saved now are no longer pending for later saves. */
+	  if (save->saved && op != NSSaveToOperation)
+	    {
+	      if (op != NSAutosaveOperation)
+		{
+		  other->changeCount -= save->changeCount;
+		}
+	      other->autosaveChangeCount -= save->autosaveChangeCount;
+	    }
+	  saving = YES;
+	}
+    }
+  if (saving == NO)
+    {
+      [NSObject cancelPreviousPerformRequestsWithTarget: self
+	selector: @selector(_showSaveProgress)
+	object: nil];
+      [_window_controllers makeObjectsPerformSelector:
+	@selector(synchronizeWindowTitleWithDocumentName)];
+    }
+
+  if (save->saved)
+    {
+      /* Edits made while the document was being written are kept.
+       */
+      long	changes = _change_count - save->changeCount;
+      long	autosaveChanges
+	= _autosave_change_count - save->autosaveChangeCount;
+
+      if (op == NSAutosaveOperation)
+	{
+	  [self _removeAutosaveJournalForURL: save->url];
+	  [self setAutosavedContentsFileURL: save->url];
+	  [self updateChangeCount: NSChangeAutosaved];
+	  _autosave_change_count = autosaveChanges;
+	}
+      else if (op != NSSaveToOperation)
+	{
+	  [self _removeAutosavedContentsFile];
+	  [self setFileURL: save->url];
+	  [self setFileType: save->type];
+	  [self updateChangeCount: NSChangeCleared];
+	  _change_count = changes;
+	  _autosave_change_count = autosaveChanges;
+	}
+      if (_change_count != 0 || _autosave_change_count != 0)
+	{
+	  BOOL	isEdited = [self isDocumentEdited];
+
+	  for (i = 0; i < [_window_controllers count]; i++)
+	    {
+	      [[_window_controllers objectAtIndex: i]
+		setDocumentEdited: isEdited];
+	    }
+	}
+      if (op == NSSaveOperation || op == NSSaveAsOperation)
+	{
+	  [[NSDocumentController sharedDocumentController]
+	    noteNewRecentDocument: self];
+	}
+    }
+  else
+    {
+      [self presentError: save->error];
+    }
+
+  if (save->delegate != nil && save->didSaveSelector != NULL)
+    {
+      void (*meth)(id, SEL, id, BOOL, void*);
+      meth = (void (*)(id, SEL, id, BOOL, void*))[save->delegate
+	methodForSelector: save->didSaveSelector];
+      if (meth)
+        meth(save->delegate, save->didSaveSelector, self, save->saved,
+	  save->contextInfo);
+    }
+  RELEASE(save);
+}
+
 @end
 
 @implementation NSDocument(Private)
@@ -1898,6 +2442,7 @@ originalContentsURL: (NSURL *)orig
 
       [self setAutosavedContentsFileURL: nil];
       [[NSFileManager defaultManager] removeFileAtPath: path handler: nil];
+      [self _removeAutosaveJournalForURL: url];
       [path release];
     }
 }
@@ -32,11 +32,14 @@
 */
 
 #include "config.h"
+#include <string.h>
+#import <Foundation/NSArray.h>
 #import <Foundation/NSDictionary.h>
 #import <Foundation/NSLock.h>
 #import <Foundation/NSTimer.h>
 #import <Foundation/NSRunLoop.h>
 #import <Foundation/NSThread.h>
+#import <Foundation/NSUserDefaults.h>
 #import <Foundation/NSValue.h>
 #import <Foundation/NSException.h>
 #import <Foundation/NSDebug.h>
@@ -66,6 +69,58 @@
 static NSString *timerKey = @"NSEventTimersKey";
 static Class dateClass;
 static Class eventClass;
+static BOOL mouseCoalescing = NO;
+static BOOL recycling = YES;
+
+/*
+ * Mouse and other events of the main thread are recycled.  Each one made
+ * is kept in a small ring as well as being autoreleased, and when the
+ * ring holds the only reference left to an event, ie. it has been sent,
+ * its autorelease pool has gone and nobody kept it, the object is used
+ * again for the next event instead of allocating a new one.  An event
+ * which is retained beyond its dispatch is simply never reused, and the
+ * GSEventRecyclingDisabled default turns recycling off.
+ */
+#define RECYCLED_EVENTS 16
+static NSEvent *recycled[RECYCLED_EVENTS];
+static NSUInteger recycleNext = 0;
+
+static inline NSEvent *
+allocEvent(Class c, BOOL recycle)
+{
+  NSEvent *e;
+
+  if (c != eventClass)
+    {
+      e = [(NSEvent*)NSAllocateObject(c, 0, NSDefaultMallocZone()) init];
+      return AUTORELEASE(e);
+    }
+  if (recycle && recycling && [NSThread isMainThread])
+    {
+      NSUInteger i;
+
+      for (i = 0; i < RECYCLED_EVENTS; i++)
+        {
+          NSUInteger slot = (recycleNext + i) % RECYCLED_EVENTS;
+
+          e = recycled[slot];
+          if (e != nil && [e retainCount] == 1)
+            {
+              DESTROY(e->coalesced_events);
+              memset(&e->event_data, 0, sizeof(e->event_data));
+              recycleNext = (slot + 1) % RECYCLED_EVENTS;
+              return AUTORELEASE(RETAIN(e));
+            }
+        }
+      e = (NSEvent*)NSAllocateObject(c, 0, NSDefaultMallocZone());
+      RELEASE(recycled[recycleNext]);
+      recycled[recycleNext] = RETAIN(e);
+      recycleNext = (recycleNext + 1) % RECYCLED_EVENTS;
+      return AUTORELEASE(e);
+    }
+  e = (NSEvent*)NSAllocateObject(c, 0, NSDefaultMallocZone());
+  return AUTORELEASE(e);
+}
 
 /*
  * Class methods
@@ -77,6 +132,10 @@ static Class eventClass;
       [self setVersion: 3];
       dateClass = [NSDate class];
       eventClass = [NSEvent class];
+      mouseCoalescing = [[NSUserDefaults standardUserDefaults]
+                          boolForKey: @"GSMouseCoalescingEnabled"];
+      recycling = ![[NSUserDefaults standardUserDefaults]
+                     boolForKey: @"GSEventRecyclingDisabled"];
     }
 }
 
@@ -101,10 +160,7 @@ static Class eventClass;
     [NSException raise: NSInvalidArgumentException
                 format: @"enterExitEvent with wrong type"];
 
-  e = (NSEvent*)NSAllocateObject(self, 0, NSDefaultMallocZone());
-  if (self != eventClass)
-    e = [e init];
-  AUTORELEASE(e);
+  e = allocEvent(self, NO);
 
   e->event_type = type;
   e->location_point = location;
@@ -136,10 +192,7 @@ static Class eventClass;
     [NSException raise: NSInvalidArgumentException
                 format: @"keyEvent with wrong type"];
 
-  e = (NSEvent*)NSAllocateObject(self, 0, NSDefaultMallocZone());
-  if (self != eventClass)
-    e = [e init];
-  AUTORELEASE(e);
+  e = allocEvent(self, NO);
 
   e->event_type = type;
   e->location_point = location;
@@ -173,10 +226,7 @@ static Class eventClass;
     [NSException raise: NSInvalidArgumentException
                 format: @"mouseEvent with wrong type"];
 
-  e = (NSEvent*)NSAllocateObject(self, 0, NSDefaultMallocZone());
-  if (self != eventClass)
-    e = [e init];
-  AUTORELEASE(e);
+  e = allocEvent(self, YES);
 
   e->event_type = type;
   e->location_point = location;
@@ -211,10 +261,7 @@ static Class eventClass;
     [NSException raise: NSInvalidArgumentException
                 format: @"mouseEvent with wrong type"];
 
-  e = (NSEvent*)NSAllocateObject(self, 0, NSDefaultMallocZone());
-  if (self != eventClass)
-    e = [e init];
-  AUTORELEASE(e);
+  e = allocEvent(self, YES);
 
   e->event_type = type;
   e->location_point = location;
@@ -257,10 +304,7 @@ static Class eventClass;
     [NSException raise: NSInvalidArgumentException
                 format: @"otherEvent with wrong type"];
 
-  e = (NSEvent*)NSAllocateObject(self, 0, NSDefaultMallocZone());
-  if (self != eventClass)
-    e = [e init];
-  AUTORELEASE(e);
+  e = allocEvent(self, YES);
 
   e->event_type = type;
   e->location_point = location;
@@ -364,6 +408,68 @@ static Class eventClass;
                                forMode: NSEventTrackingRunLoopMode];
 }
 
+/**
+ * Returns YES if consecutive mouse moved and mouse dragged events for
+ * the same window are collapsed into one when they are taken from the
+ * event queue.  Coalescing is off unless it has been turned on with
+ * +setMouseCoalescingEnabled: or the GSMouseCoalescingEnabled user
+ * default.
+ */
++ (BOOL) isMouseCoalescingEnabled
+{
+  return mouseCoalescing;
+}
+
+/**
+ * Turns coalescing of mouse moved and mouse dragged events on or off.
+ * When it is on, an event taken from the queue stands for all the
+ * motion events of the same type, window and modifiers which directly
+ * followed it in the queue.  The event has the location and time of the
+ * last of them and the sum of their deltas, and -coalescedEvents returns
+ * the individual events.
+ */
++ (void) setMouseCoalescingEnabled: (BOOL)flag
+{
+  mouseCoalescing = flag;
+}
+
+/* Returns a new motion event standing for events, which all have the
+   same type, window and modifiers, in the order they were queued.  */
++ (NSEvent*) _eventCoalescingEvents: (NSArray*)events
+{
+  NSUInteger count = [events count];
+  NSEvent *list[count];
+  NSEvent *last;
+  NSEvent *e;
+  CGFloat dx = 0.0, dy = 0.0, dz = 0.0;
+  NSUInteger i;
+
+  [events getObjects: list];
+  last = list[count - 1];
+  for (i = 0; i < count; i++)
+    {
+      dx += list[i]->event_data.mouse.deltaX;
+      dy += list[i]->event_data.mouse.deltaY;
+      dz += list[i]->event_data.mouse.deltaZ;
+    }
+
+  e = [self mouseEventWithType: last->event_type
+                      location: last->location_point
+                 modifierFlags: last->modifier_flags
+                     timestamp: last->event_time
+                  windowNumber: last->window_num
+                       context: last->event_context
+                   eventNumber: last->event_data.mouse.event_num
+                    clickCount: last->event_data.mouse.click
+                      pressure: last->event_data.mouse.pressure
+                  buttonNumber: last->event_data.mouse.button
+                        deltaX: dx
+                        deltaY: dy
+                        deltaZ: dz];
+  e->coalesced_events = [events copy];
+  return e;
+}
+
 + (void) stopPeriodicEvents
 {
   NSTimer             *timer;
@@ -441,6 +547,21 @@ static Class eventClass;
   return event_data.mouse.click;
 }
 
+/**
+ * Returns the mouse moved or mouse dragged events this event was made
+ * from when mouse coalescing is enabled, in the order they arrived.
+ * The last of them has the location and time of the receiver.  For any
+ * other event this returns an array holding only the receiver.
+ */
+- (NSArray *) coalescedEvents
+{
+  if (coalesced_events == nil)
+    {
+      return [NSArray arrayWithObject: self];
+    }
+  return coalesced_events;
+}
+
 /**
  * Returns the graphics context for which this event was generated.
  */
@@ -464,6 +585,7 @@ static Class eventClass;
       event_data.tracking.user_data
         = (void *)[(id)event_data.tracking.user_data copyWithZone: zone];
     }
+  RETAIN(e->coalesced_events);
   return e;
 }
 
@@ -510,6 +632,7 @@ static Class eventClass;
     {
       RELEASE((id)event_data.tracking.user_data);
     }
+  RELEASE(coalesced_events);
   [super dealloc];
 }
 
@@ -30,10 +30,15 @@
 
 #include "config.h"
 
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+
 #import <Foundation/NSArchiver.h>
 #import <Foundation/NSArray.h>
 #import <Foundation/NSAutoreleasePool.h>
 #import <Foundation/NSData.h>
+#import <Foundation/NSDate.h>
 #import <Foundation/NSDebug.h>
 #import <Foundation/NSException.h>
 #import <Foundation/NSFileManager.h>
@@ -42,6 +47,11 @@
 #import "AppKit/NSFont.h"
 #import "AppKit/NSWorkspace.h"
 
+@interface NSFileWrapper (Private)
+- (BOOL) _contentsAreUnchanged;
+- (BOOL) _linkContentsToPath: (NSString*)path;
+@end
+
 @implementation NSFileWrapper
 
 //
@@ -140,8 +150,13 @@
     }
   else if ([fileType isEqualToString: @"NSFileTypeRegular"])
     {
-      self = [self initRegularFileWithContents: 
-		AUTORELEASE([[NSData alloc] initWithContentsOfFile: path])];
+      /* The contents are only read when they are asked for, so that
+       * opening a large directory wrapper doesn't read all its files.
+       */
+      self = [self initRegularFileWithContents: nil];
+      ASSIGN(_contentsPath, path);
+      ASSIGN(_contentsDate, [[self fileAttributes] fileModificationDate]);
+      _contentsSize = [[self fileAttributes] fileSize];
     }
   else if ([fileType isEqualToString: @"NSFileTypeSymbolicLink"])
     {
@@ -174,6 +189,8 @@
   TEST_RELEASE(_preferredFilename);
   TEST_RELEASE(_wrapperData);
   TEST_RELEASE(_iconImage);
+  TEST_RELEASE(_contentsPath);
+  TEST_RELEASE(_contentsDate);
   [super dealloc];
 }
 
@@ -220,7 +237,32 @@
         }
       case GSFileWrapperRegularFileType: 
         {
-	  if ([_wrapperData writeToFile: path atomically: atomicFlag])
+	  NSData	*contents;
+
+	  /* Contents which are still those of the file they were read
+	   * from need not be written again: they are already there if
+	   * the wrapper is written where it was read from, and can be
+	   * linked to otherwise.
+	   */
+	  if ([self _contentsAreUnchanged])
+	    {
+	      if ([path isEqualToString: _contentsPath]
+		|| [self _linkContentsToPath: path])
+		{
+		  success = YES;
+		  break;
+		}
+	    }
+	  contents = [self regularFileContents];
+	  if (!atomicFlag
+	    && [[fm fileAttributesAtPath: path traverseLink: NO]
+	      fileReferenceCount] > 1)
+	    {
+	      /* Don't overwrite the contents of files linked to this one.
+	       */
+	      [fm removeFileAtPath: path handler: nil];
+	    }
+	  if ([contents writeToFile: path atomically: atomicFlag])
 	    success = [fm changeFileAttributes: _fileAttributes
 			  atPath: path];
 	  break;
@@ -546,6 +588,16 @@
 {
   if (_wrapperType == GSFileWrapperRegularFileType)
     {
+      if (_wrapperData == nil && _contentsPath != nil)
+	{
+	  if (![self _contentsAreUnchanged])
+	    {
+	      NSLog(@"File wrapper contents %@ changed since the wrapper"
+		@" was made", _contentsPath);
+	    }
+	  _wrapperData = RETAIN([NSData dataWithContentsOfMappedFile:
+	    _contentsPath]);
+	}
       return _wrapperData;
     }
   else
@@ -592,7 +644,10 @@
       // Dont store the file name
       [aCoder encodeObject: _preferredFilename];
       [aCoder encodeObject: _fileAttributes];
-      [aCoder encodeObject: _wrapperData];
+      if (_wrapperType == GSFileWrapperRegularFileType)
+	[aCoder encodeObject: [self regularFileContents]];
+      else
+	[aCoder encodeObject: _wrapperData];
       [aCoder encodeObject: _iconImage];
     }
 }
@@ -656,3 +711,60 @@
 
 @end
 
+@implementation NSFileWrapper (Private)
+
+/* Returns YES if the wrapper was read from a file which still has the
+ * contents and attributes it had then.
+ */
+- (BOOL) _contentsAreUnchanged
+{
+  NSDictionary	*attributes;
+
+  if (_contentsPath == nil)
+    {
+      return NO;
+    }
+  attributes = [[NSFileManager defaultManager]
+    fileAttributesAtPath: _contentsPath traverseLink: NO];
+  return ([[attributes fileType] isEqualToString: NSFileTypeRegular]
+    && [attributes fileSize] == _contentsSize
+    && [[attributes fileModificationDate] isEqual: _contentsDate]
+    && [[_fileAttributes fileModificationDate] isEqual: _contentsDate]
+    && [_fileAttributes filePosixPermissions]
+      == [attributes filePosixPermissions]);
+}
+
+/* Makes path a hard link to the file the contents were read from.
+ * The link is made under a temporary name and renamed into place so
+ * that a file already at path is replaced in one step.  Returns NO if
+ * the file system can't link the two paths.
+ */
+- (BOOL) _linkContentsToPath: (NSString*)path
+{
+  NSFileManager	*fm = [NSFileManager defaultManager];
+  NSString	*tmp;
+  const char	*from;
+  const char	*to;
+  const char	*temp;
+
+  tmp = [path stringByAppendingFormat: @".%d.link", (int)getpid()];
+  from = [fm fileSystemRepresentationWithPath: _contentsPath];
+  to = [fm fileSystemRepresentationWithPath: path];
+  temp = [fm fileSystemRepresentationWithPath: tmp];
+  unlink(temp);
+  if (link(from, temp) != 0)
+    {
+      NSDebugLLog(@"NSFileWrapper", @"Can't link %@ to %@: %d",
+	_contentsPath, path, errno);
+      return NO;
+    }
+  if (rename(temp, to) != 0)
+    {
+      unlink(temp);
+      return NO;
+    }
+  return YES;
+}
+
+@end
+
@@ -34,6 +34,7 @@
 #import <Foundation/NSString.h>
 #import <Foundation/NSUserDefaults.h>
 #import <Foundation/NSSet.h>
+#import <Foundation/NSLock.h>
 #import <Foundation/NSMapTable.h>
 #import <Foundation/NSException.h>
 #import <Foundation/NSDebug.h>
@@ -196,6 +197,16 @@ static Class NSFontClass = 0;
 
 /* Cache all created fonts for reuse. */
 static NSMapTable* globalFontMap = 0;
+static NSRecursiveLock *fontMapLock = nil;
+static unsigned long fontMapHits = 0;
+static unsigned long fontMapMisses = 0;
+
+/* The fonts in globalFontMap are not retained, so a font that is asked
+   for over and over again, but released in between, would have to be set
+   up again every time. We keep the fonts created last alive here. */
+#define NUM_RECENT_FONTS 64
+static NSFont *recentFonts[NUM_RECENT_FONTS];
+static unsigned int nextRecentFont = 0;
 
 static NSUserDefaults *defaults = nil;
 
@@ -445,6 +456,7 @@ static void setNSFont(NSString *key, NSFont *font)
       placeHolder = [self alloc];
       globalFontMap = NSCreateMapTable(NSObjectMapKeyCallBacks,
                                        NSNonRetainedObjectMapValueCallBacks, 64);
+      fontMapLock = [NSRecursiveLock new];
 
       if (defaults == nil)
         {
@@ -821,6 +833,7 @@ static void setNSFont(NSString *key, NSFont *font)
 {
   GSFontMapKey *key;
   NSFont *font;
+  NSFont *old;
 
   /* Should never be called on an initialised font! */
   NSAssert(fontName == nil, NSInternalInconsistencyException);
@@ -828,9 +841,11 @@ static void setNSFont(NSString *key, NSFont *font)
   /* Check whether the font is cached */
   key = keyForFont(name, fontMatrix,
                    screen, aRole);
+  [fontMapLock lock];
   font = (id)NSMapGet(globalFontMap, (void *)key);
   if (font == nil)
     {
+      fontMapMisses++;
       if (self == placeHolder)
         {
           /*
@@ -860,6 +875,7 @@ static void setNSFont(NSString *key, NSFont *font)
         }
       if (fontInfo == nil)
         {
+          [fontMapLock unlock];
           DESTROY(fontName);
           DESTROY(key);
           RELEASE(self);
@@ -868,15 +884,21 @@ static void setNSFont(NSString *key, NSFont *font)
       
       /* Cache the font for later use */
       NSMapInsert(globalFontMap, (void *)key, (void *)self);
+      old = recentFonts[nextRecentFont];
+      recentFonts[nextRecentFont] = RETAIN(self);
+      nextRecentFont = (nextRecentFont + 1) % NUM_RECENT_FONTS;
+      RELEASE(old);
     }
   else
     {
+      fontMapHits++;
       if (self != placeHolder)
         {
           RELEASE(self);
         }
       self = RETAIN(font);
     }
+  [fontMapLock unlock];
   RELEASE(key);
 
   return self;
@@ -890,7 +912,9 @@ static void setNSFont(NSString *key, NSFont *font)
 
       key = keyForFont(fontName, matrix,
                        screenFont, role);
+      [fontMapLock lock];
       NSMapRemove(globalFontMap, (void *)key);
+      [fontMapLock unlock];
       RELEASE(key);
       RELEASE(fontName);
     }
@@ -1152,12 +1176,18 @@ static BOOL flip_hack;
 //
 - (NSSize) advancementForGlyph: (NSGlyph)aGlyph
 {
-  return [fontInfo advancementForGlyph: aGlyph];
+  NSSize advancement;
+
+  [fontInfo getAdvancements: &advancement forGlyphs: &aGlyph count: 1];
+  return advancement;
 }
 
 - (NSRect) boundingRectForGlyph: (NSGlyph)aGlyph
 {
-  return [fontInfo boundingRectForGlyph: aGlyph];
+  NSRect bounds;
+
+  [fontInfo getBoundingRects: &bounds forGlyphs: &aGlyph count: 1];
+  return bounds;
 }
 
 - (BOOL) glyphIsEncoded: (NSGlyph)aGlyph
@@ -1251,13 +1281,7 @@ static BOOL flip_hack;
                forGlyphs: (const NSGlyph*)glyphs
                    count: (NSUInteger)count
 {
-  // FIXME
-  int i;
-
-  for (i = 0; i < count; i++)
-    {
-      advancements[i] = [self advancementForGlyph: glyphs[i]];
-    }
+  [fontInfo getAdvancements: advancements forGlyphs: glyphs count: count];
 }
 
 - (void) getAdvancements: (NSSizeArray)advancements
@@ -1271,13 +1295,7 @@ static BOOL flip_hack;
                 forGlyphs: (const NSGlyph*)glyphs
                     count: (NSUInteger)count
 {
-  // FIXME
-  int i;
-
-  for (i = 0; i < count; i++)
-    {
-      bounds[i] = [self boundingRectForGlyph: glyphs[i]];
-    }
+  [fontInfo getBoundingRects: bounds forGlyphs: glyphs count: count];
 }
 
 - (NSStringEncoding) mostCompatibleStringEncoding
@@ -1522,6 +1540,21 @@ static BOOL flip_hack;
   return [fontInfo glyphForCharacter: theChar];
 }
 
++ (NSDictionary *) fontCacheStatistics
+{
+  NSDictionary *d;
+
+  [fontMapLock lock];
+  d = [NSDictionary dictionaryWithObjectsAndKeys:
+    [NSNumber numberWithUnsignedLong: fontMapHits], @"Hits",
+    [NSNumber numberWithUnsignedLong: fontMapMisses], @"Misses",
+    [NSNumber numberWithUnsignedInt: NSCountMapTable(globalFontMap)],
+    @"Count",
+    nil];
+  [fontMapLock unlock];
+  return d;
+}
+
 @end
 
 
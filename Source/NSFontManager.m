@@ -148,33 +148,13 @@ static Class         fontPanelClass = Nil;
 
 - (NSArray*) availableFontNamesWithTraits: (NSFontTraitMask)fontTraitMask
 {
-  unsigned int i, j;
-  NSArray *fontFamilies = [self availableFontFamilies];
-  NSMutableArray *fontNames = [NSMutableArray array];
-  NSFontTraitMask traits;
-
   if (fontTraitMask == (NSUnitalicFontMask | NSUnboldFontMask))
     {
       fontTraitMask = 0;
     }
 
-  for (i = 0; i < [fontFamilies count]; i++)
-    {
-      NSArray *fontDefs = [self availableMembersOfFontFamily: 
-                                 [fontFamilies objectAtIndex: i]];
-      
-      for (j = 0; j < [fontDefs count]; j++)
-        {
-          NSArray *fontDef = [fontDefs objectAtIndex: j];
-
-          traits = [[fontDef objectAtIndex: 3] unsignedIntValue];
-          // Check if the font has exactly the given mask
-          if (traits == fontTraitMask)
-            [fontNames addObject: [fontDef objectAtIndex: 0]];
-        }
-    }
-
-  return fontNames;
+  // The font must have exactly the given mask
+  return [_fontEnumerator availableFontNamesWithTraits: fontTraitMask];
 }
 
 - (NSArray*) availableMembersOfFontFamily: (NSString*)family
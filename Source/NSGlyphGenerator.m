@@ -25,6 +25,9 @@
    Boston, MA 02110-1301, USA.
 */
 
+#include <stdint.h>
+#include <string.h>
+
 #import <Foundation/NSCharacterSet.h>
 #import <Foundation/NSDictionary.h>
 #import <Foundation/NSException.h>
@@ -40,6 +43,58 @@
 
 static NSGlyphGenerator* instance;
 
+/*
+Most text is set in fonts that map Latin-1 characters directly to glyphs,
+so we keep a table of the glyphs for the first 256 characters of the
+fonts used last. Characters whose table entry is NSNullGlyph take the
+generic path below.
+*/
+#define NUM_LATIN1_TABLES 4
+
+typedef struct
+{
+  GSFontInfo *fontInfo;
+  NSGlyph glyphs[256];
+} latin1_table_t;
+
+static latin1_table_t latin1Tables[NUM_LATIN1_TABLES];
+static int nextLatin1Table;
+
+static const NSGlyph *
+latin1GlyphsForFont(GSFontInfo *fi, NSCharacterSet *cs)
+{
+  latin1_table_t *t;
+  unichar ch;
+
+  for (t = latin1Tables; t < latin1Tables + NUM_LATIN1_TABLES; t++)
+    {
+      if (t->fontInfo == fi)
+        return t->glyphs;
+    }
+
+  t = &latin1Tables[nextLatin1Table];
+  nextLatin1Table = (nextLatin1Table + 1) % NUM_LATIN1_TABLES;
+  ASSIGN(t->fontInfo, fi);
+  for (ch = 0; ch < 256; ch++)
+    {
+      if ([cs characterIsMember: ch])
+        t->glyphs[ch] = NSControlGlyph;
+      else
+        t->glyphs[ch] = [fi glyphForCharacter: ch];
+    }
+  return t->glyphs;
+}
+
+/* Returns YES if all of the four characters at p are Latin-1. */
+static inline BOOL
+isLatin1Block(const unichar *p)
+{
+  uint64_t w;
+
+  memcpy(&w, p, sizeof(w));
+  return (w & 0xff00ff00ff00ff00ULL) == 0;
+}
+
 @interface NSGlyphGenerator (Private)
 - (NSFont *) fontForCharactersWithAttributes: (NSDictionary *)attributes;
 @end
@@ -114,6 +169,7 @@ fb04 'ffl'
   SEL gfc_sel = @selector(glyphForCharacter:);
   NSGlyph (*glyphForCharacter)(id, SEL, unichar);
   NSGlyph fallback = NSNullGlyph;
+  const NSGlyph *latin1;
 
   [[attrstr string] getCharacters: buf range: maxRange];
   attributes = [attrstr attributesAtIndex: *index
@@ -127,6 +183,7 @@ fb04 'ffl'
       return;
     }
   glyphForCharacter = (NSGlyph(*)(id, SEL, unichar)) [fi methodForSelector: gfc_sel];
+  latin1 = latin1GlyphsForFont(fi, cs);
 
   n = [attributes objectForKey: NSLigatureAttributeName];
   if (n)
@@ -139,7 +196,39 @@ fb04 'ffl'
     {
       unsigned int ch, ch2;
 
+      /* Convert blocks of Latin-1 characters that map directly to glyphs
+         and can't start a ligature. */
+      while (i + 4 <= num && isLatin1Block(buf + i))
+        {
+          NSGlyph g0 = latin1[buf[i]];
+          NSGlyph g1 = latin1[buf[i + 1]];
+          NSGlyph g2 = latin1[buf[i + 2]];
+          NSGlyph g3 = latin1[buf[i + 3]];
+
+          if (g0 == NSNullGlyph || g1 == NSNullGlyph
+              || g2 == NSNullGlyph || g3 == NSNullGlyph)
+            break;
+          if (ligature >= 1 && (buf[i] == 'f' || buf[i + 1] == 'f'
+                                || buf[i + 2] == 'f' || buf[i + 3] == 'f'))
+            break;
+          g[0] = g0;
+          g[1] = g1;
+          g[2] = g2;
+          g[3] = g3;
+          g += 4;
+          i += 4;
+        }
+      if (i == num)
+        break;
+
       ch = buf[i];
+      if (ch < 256 && latin1[ch] != NSNullGlyph
+          && (ch != 'f' || ligature < 1))
+        {
+          *g = latin1[ch];
+          g++;
+          continue;
+        }
       if (characterIsMember(cs, cim_sel, ch))
         {
           *g = NSControlGlyph;
@@ -31,6 +31,7 @@
 
 #import <Foundation/NSException.h>
 #import "AppKit/NSBezierPath.h"
+#import "AppKit/NSBitmapImageRep.h"
 #import "AppKit/NSColor.h"
 #import "AppKit/NSColorSpace.h"
 #import "AppKit/NSGradient.h"
@@ -42,6 +43,15 @@
 #define PI 3.1415926535897932384626434
 #endif
 
+/* The number of colours in the ramp of a gradient. */
+#define RAMP_SIZE 256
+
+@interface NSGradient (Private)
+- (CGFloat *) _components;
+- (const unsigned char *) _ramp;
+- (void) _drawRampInRect: (NSRect)rect direction: (int)direction;
+@end
+
 @implementation NSGradient
 
 - (NSColorSpace *) colorSpace; 
@@ -112,6 +122,14 @@
       angle -= 360.0;
     }
 
+  /* A gradient along a side of the rect is a bitmap one pixel across,
+     stretched over the rect. */
+  if (fmod(angle, 90.0) == 0.0)
+    {
+      [self _drawRampInRect: rect direction: ((int)angle / 90) % 4];
+      return;
+    }
+
   if (angle < 90.0)
     {
       startPoint = NSMakePoint(NSMinX(rect), NSMinY(rect));
@@ -283,15 +301,24 @@ relativeCenterPosition: (NSPoint)relativeCenterPoint
 
 - (void) dealloc
 {
+  unsigned int i;
+
   RELEASE(_colorSpace);
   RELEASE(_colors);
   free(_locations);
+  free(_components);
+  free(_ramp);
+  for (i = 0; i < 4; i++)
+    {
+      RELEASE(_rampReps[i]);
+    }
   [super dealloc];
 }
 
 - (NSColor *) interpolatedColorAtLocation: (CGFloat)location
 {
   unsigned int i;
+  CGFloat *components;
 
   if (location <= _locations[0])
     {
@@ -307,13 +334,18 @@ relativeCenterPosition: (NSPoint)relativeCenterPoint
     {
       if (location <= _locations[i])
         {
-          NSColor *c1 = [_colors objectAtIndex: i - 1];
-          NSColor *c2 = [_colors objectAtIndex: i];
-          float fraction = (_locations[i] - location) / (_locations[i] - _locations[i - 1]);
-          
+          CGFloat fraction = (location - _locations[i - 1]) / (_locations[i] - _locations[i - 1]);
+          CGFloat *c1;
+          CGFloat *c2;
+
           // FIXME: Works only for RGB colours and does not respect the colour space
-          return [c1 blendedColorWithFraction: fraction
-                     ofColor: c2];
+          components = [self _components];
+          c1 = components + 4 * (i - 1);
+          c2 = components + 4 * i;
+          return [NSColor colorWithCalibratedRed: c1[0] + fraction * (c2[0] - c1[0])
+                                           green: c1[1] + fraction * (c2[1] - c1[1])
+                                            blue: c1[2] + fraction * (c2[2] - c1[2])
+                                           alpha: c1[3] + fraction * (c2[3] - c1[3])];
         }
     }
 
@@ -336,6 +368,9 @@ relativeCenterPosition: (NSPoint)relativeCenterPoint
   RETAIN(g->_colors);
   g->_locations = malloc(sizeof(CGFloat) * _numberOfColorStops);
   memcpy(g->_locations, _locations, sizeof(CGFloat) * _numberOfColorStops);
+  g->_components = NULL;
+  g->_ramp = NULL;
+  memset(g->_rampReps, 0, sizeof(g->_rampReps));
 
   return g;
 }
@@ -365,3 +400,128 @@ relativeCenterPosition: (NSPoint)relativeCenterPoint
 }
 
 @end
+
+@implementation NSGradient (Private)
+
+/* Returns the calibrated RGBA components of the colour stops, working
+   them out the first time. A gradient doesn't change its stops, so they
+   and the ramp made from them are kept until it is deallocated. */
+- (CGFloat *) _components
+{
+  if (_components == NULL)
+    {
+      NSInteger i;
+
+      _components = malloc(sizeof(CGFloat) * 4 * _numberOfColorStops);
+      for (i = 0; i < _numberOfColorStops; i++)
+        {
+          NSColor *c = [[_colors objectAtIndex: i]
+                         colorUsingColorSpaceName: NSCalibratedRGBColorSpace];
+          CGFloat *p = _components + 4 * i;
+
+          if (c == nil)
+            {
+              p[0] = p[1] = p[2] = p[3] = 0.0;
+            }
+          else
+            {
+              [c getRed: &p[0] green: &p[1] blue: &p[2] alpha: &p[3]];
+            }
+        }
+    }
+  return _components;
+}
+
+/* Returns RAMP_SIZE colours evenly spaced from location 0 to 1, as
+   8 bit premultiplied RGBA. */
+- (const unsigned char *) _ramp
+{
+  if (_ramp == NULL)
+    {
+      CGFloat *components = [self _components];
+      unsigned char *p;
+      NSInteger stop = 1;
+      int i;
+
+      _ramp = malloc(4 * RAMP_SIZE);
+      p = _ramp;
+      for (i = 0; i < RAMP_SIZE; i++, p += 4)
+        {
+          CGFloat location = (CGFloat)i / (RAMP_SIZE - 1);
+          CGFloat c[4];
+          int j;
+
+          while (stop < _numberOfColorStops - 1 && location > _locations[stop])
+            {
+              stop++;
+            }
+          if (location <= _locations[0])
+            {
+              memcpy(c, components, sizeof(c));
+            }
+          else if (location >= _locations[_numberOfColorStops - 1])
+            {
+              memcpy(c, components + 4 * (_numberOfColorStops - 1), sizeof(c));
+            }
+          else
+            {
+              CGFloat *c1 = components + 4 * (stop - 1);
+              CGFloat *c2 = components + 4 * stop;
+              CGFloat fraction = (location - _locations[stop - 1])
+                / (_locations[stop] - _locations[stop - 1]);
+
+              for (j = 0; j < 4; j++)
+                {
+                  c[j] = c1[j] + fraction * (c2[j] - c1[j]);
+                }
+            }
+          for (j = 0; j < 3; j++)
+            {
+              p[j] = (unsigned char)(c[j] * c[3] * 255.0 + 0.5);
+            }
+          p[3] = (unsigned char)(c[3] * 255.0 + 0.5);
+        }
+    }
+  return _ramp;
+}
+
+/* Draws the ramp stretched over rect, running from the left (direction
+   0), bottom (1), right (2) or top (3) side of rect to the other. The
+   bitmap holding the ramp in each direction is kept. */
+- (void) _drawRampInRect: (NSRect)rect direction: (int)direction
+{
+  NSBitmapImageRep *rep = _rampReps[direction];
+
+  if (rep == nil)
+    {
+      const unsigned char *ramp = [self _ramp];
+      BOOL across = (direction == 0 || direction == 2);
+      unsigned char *p;
+      int i;
+
+      rep = [[NSBitmapImageRep alloc]
+              initWithBitmapDataPlanes: NULL
+                            pixelsWide: (across ? RAMP_SIZE : 1)
+                            pixelsHigh: (across ? 1 : RAMP_SIZE)
+                         bitsPerSample: 8
+                       samplesPerPixel: 4
+                              hasAlpha: YES
+                              isPlanar: NO
+                        colorSpaceName: NSCalibratedRGBColorSpace
+                           bytesPerRow: 0
+                          bitsPerPixel: 0];
+      p = [rep bitmapData];
+      for (i = 0; i < RAMP_SIZE; i++, p += 4)
+        {
+          /* Bitmap rows run from the top of the rect, so a ramp from the
+             bottom is stored backwards, as is one from the right. */
+          int index = (direction == 0 || direction == 3) ? i : RAMP_SIZE - 1 - i;
+
+          memcpy(p, ramp + 4 * index, 4);
+        }
+      _rampReps[direction] = rep;
+    }
+  [rep drawInRect: rect];
+}
+
+@end
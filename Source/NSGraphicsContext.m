@@ -39,6 +39,8 @@
 #import <Foundation/NSException.h>
 #import <Foundation/NSData.h>
 #import <Foundation/NSLock.h>
+#import <Foundation/NSNotification.h>
+#import <Foundation/NSNull.h>
 #import <Foundation/NSRunLoop.h>
 #import <Foundation/NSSet.h>
 #import <Foundation/NSThread.h>
@@ -54,6 +56,7 @@
 #import "AppKit/DPSOperators.h"
 #import "GNUstepGUI/GSVersion.h"
 #import "GNUstepGUI/GSDisplayServer.h"
+#import "NSViewPrivate.h"
 
 /* The memory zone where all global objects are allocated from (Contexts
    are also allocated from this zone) */
@@ -73,6 +76,82 @@ static NSString	*NSGraphicsContextThreadKey = @"NSGraphicsContextThreadKey";
 #endif
 static NSString	*NSGraphicsContextStackKey = @"NSGraphicsContextStackKey";
 
+/* The context stack of the current thread is owned by the thread
+   dictionary, but where the compiler supports thread local variables
+   it is also kept in one so that saving and restoring the graphics
+   state doesn't have to look it up each time.  The variable is cleared
+   when the thread exits, before the dictionary is released.  */
+#ifdef GS_HAVE_THREAD_LOCAL
+static GS_THREAD_LOCAL NSMutableArray *threadContextStack = nil;
+#endif
+
+static NSMutableArray *
+context_stack(BOOL create)
+{
+  NSMutableDictionary *dict;
+  NSMutableArray *stack;
+
+#ifdef GS_HAVE_THREAD_LOCAL
+  if (threadContextStack != nil)
+    return threadContextStack;
+#endif
+  dict = [[NSThread currentThread] threadDictionary];
+  stack = [dict objectForKey: NSGraphicsContextStackKey];
+  if (stack == nil && create)
+    {
+      stack = [[NSMutableArray allocWithZone: _globalGSZone] init];
+      [dict setObject: stack forKey: NSGraphicsContextStackKey];
+      RELEASE(stack);
+    }
+#ifdef GS_HAVE_THREAD_LOCAL
+  threadContextStack = stack;
+#endif
+  return stack;
+}
+
+/* Makes ctxt the current context, remembering the previous one on the
+   context stack, but unlike +saveGraphicsState doesn't save the graphics
+   state of the previous context.  Used by view focus locking, which
+   saves the gstate of ctxt itself and doesn't draw into any other
+   context.  */
+void
+GSPushCurrentContext(NSGraphicsContext *ctxt)
+{
+  NSGraphicsContext *prev = GSCurrentContext();
+  NSMutableArray *stack = context_stack(YES);
+
+  [stack addObject: (prev != nil) ? (id)prev : (id)[NSNull null]];
+  if (prev != ctxt)
+    {
+      [NSGraphicsContext setCurrentContext: ctxt];
+    }
+}
+
+/* Balances GSPushCurrentContext(), making the remembered context current
+   again.  */
+void
+GSPopCurrentContext(void)
+{
+  NSMutableArray *stack = context_stack(NO);
+  NSGraphicsContext *prev;
+
+  if (stack == nil || [stack count] == 0)
+    {
+      [NSException raise: NSGenericException
+		   format: @"GSPopCurrentContext without previous push"];
+    }
+  prev = [stack lastObject];
+  if ((id)prev == (id)[NSNull null])
+    {
+      prev = nil;
+    }
+  if (prev != GSCurrentContext())
+    {
+      [NSGraphicsContext setCurrentContext: prev];
+    }
+  [stack removeLastObject];
+}
+
 /* Colorspace constants */
 NSString *GSColorSpaceName = @"GSColorSpaceName";
 NSString *GSColorSpaceWhitePoint = @"GSColorSpaceWhitePoint";
@@ -139,11 +218,26 @@ NSGraphicsContext	*GSCurrentContext(void)
 	  _globalGSZone = NSDefaultMallocZone();
 	  classMethodTable =
 	    [[NSMutableDictionary allocWithZone: _globalGSZone] init];
+#ifdef GS_HAVE_THREAD_LOCAL
+	  [[NSNotificationCenter defaultCenter]
+	    addObserver: self
+	       selector: @selector(_threadWillExit:)
+		   name: NSThreadWillExitNotification
+		 object: nil];
+#endif
 	}
       [gnustep_global_lock unlock];
     }
 }
 
+#ifdef GS_HAVE_THREAD_LOCAL
+/* Posted in the exiting thread, so this clears its own variable.  */
++ (void) _threadWillExit: (NSNotification *)aNotification
+{
+  threadContextStack = nil;
+}
+#endif
+
 + (void) initializeBackend
 {
   [self subclassResponsibility: _cmd];
@@ -235,8 +329,7 @@ NSGraphicsContext	*GSCurrentContext(void)
 + (void) restoreGraphicsState
 {
   NSGraphicsContext *ctxt;
-  NSMutableDictionary *dict = [[NSThread currentThread] threadDictionary];
-  NSMutableArray *stack = [dict objectForKey: NSGraphicsContextStackKey];
+  NSMutableArray *stack = context_stack(NO);
 
   if (stack == nil)
     {
@@ -256,14 +349,8 @@ NSGraphicsContext	*GSCurrentContext(void)
 + (void) saveGraphicsState
 {
   NSGraphicsContext *ctxt;
-  NSMutableDictionary *dict = [[NSThread currentThread] threadDictionary];
-  NSMutableArray *stack = [dict objectForKey: NSGraphicsContextStackKey];
-  if (stack == nil)
-    {
-      stack = [[NSMutableArray allocWithZone: _globalGSZone] init];
-      [dict setObject: stack forKey: NSGraphicsContextStackKey];
-      RELEASE(stack);
-    }
+  NSMutableArray *stack = context_stack(YES);
+
   // might be nil, i.e. no current context
   ctxt = GSCurrentContext();
   if (ctxt)
@@ -1761,6 +1848,8 @@ destination point but not the content. */
       [self showPage];
     }
   DPSPrintf(self, "%%%%PageTrailer\n\n");
+  /* Push each page out, for output which is passed on as it is written. */
+  [self flushGraphics];
 }
 
 - (void) endTrailer
@@ -35,9 +35,15 @@
 #import <Foundation/NSException.h>
 #import <Foundation/NSFileManager.h>
 #import <Foundation/NSKeyedArchiver.h>
+#import <Foundation/NSDate.h>
 #import <Foundation/NSLock.h>
+#import <Foundation/NSMapTable.h>
 #import <Foundation/NSNotification.h>
+#import <Foundation/NSPathUtilities.h>
 #import <Foundation/NSString.h>
+#import <Foundation/NSThread.h>
+#import <Foundation/NSTimer.h>
+#import <Foundation/NSUserDefaults.h>
 #import <Foundation/NSValue.h>
 
 #import "AppKit/NSImage.h"
@@ -93,9 +99,20 @@ BOOL NSImageForceCaching = NO; /* use on missmatch */
   NSImageRep *rep;
   NSImageRep *original;
   NSColor *bg;
+  BOOL fromFile;	/* Loaded from a referenced file; may be purged. */
+  BOOL cacheEvicted;	/* A cache of this rep was evicted. */
+  BOOL scaled;		/* A resampled copy of original. */
+  /* For caches: the image holding the cache, and the neighbours in the
+     list of all caches, most recently used first. Not retained. */
+  NSImage *owner;
+  GSRepData *lruPrev;
+  GSRepData *lruNext;
+  NSUInteger cacheBytes;
 }
 @end
 
+static void cache_unlink(GSRepData *repd);
+
 @implementation GSRepData
 - (id) copyWithZone: (NSZone*)z
 {
@@ -105,17 +122,52 @@ BOOL NSImageForceCaching = NO; /* use on missmatch */
     c->rep = [c->rep copyWithZone: z];
   if (c->bg)
     c->bg = [c->bg copyWithZone: z];
+  c->owner = nil;
+  c->lruPrev = c->lruNext = nil;
+  c->cacheBytes = 0;
   return c;
 }
 
 - (void) dealloc
 {
+  if (owner != nil)
+    cache_unlink(self);
   TEST_RELEASE(rep);
   TEST_RELEASE(bg);
   [super dealloc];
 }
 @end
 
+/* A referenced file being decoded ahead of use by +_prefetchImagesNamed:.
+   The fields are protected by prefetchCondition. */
+@interface GSImagePrefetch : NSObject
+{
+@public
+  NSString *path;
+  NSArray *reps;
+  BOOL done;
+}
+@end
+
+@implementation GSImagePrefetch
+- (void) dealloc
+{
+  RELEASE(path);
+  TEST_RELEASE(reps);
+  [super dealloc];
+}
+@end
+
+#define NUM_PREFETCH_WORKERS 2
+
+static NSCondition *prefetchCondition = nil;
+static NSMutableArray *prefetchQueue = nil;
+
+/* Representations decoded ahead of time by a theme being prepared, keyed
+   by the path of their file. Each is used by the first image to load the
+   file. Protected by imageLock. */
+static NSMutableDictionary *preparedReps = nil;
+
 /* Class variables and functions for class methods */
 static NSRecursiveLock		*imageLock = nil;
 static NSMutableDictionary	*nameDict = nil;
@@ -131,6 +183,188 @@ static NSArray *imagePasteboardTypes = nil;
 
 static NSArray *iterate_reps_for_types(NSArray *imageReps, SEL method);
 
+/* Indexes of the images in the main bundle, the theme and the system
+   Images directories, built on first use. Each maps the file name of an
+   image, and its name without extension, to its path. The paths without
+   extension are those of the first type in imageFileTypes that exists,
+   as the search in +_pathForImageNamed: used to find. Protected by
+   imageLock. */
+static NSDictionary *mainImageIndex = nil;
+static NSDictionary *themeImageIndex = nil;
+static NSDictionary *systemImageIndex = nil;
+
+/* Adds the image at path, of the type at position rank of the image file
+   types, to index unless an earlier path or type is already there. */
+static void
+add_to_index(NSMutableDictionary *index, NSMutableDictionary *ranks,
+             NSString *path, NSUInteger rank)
+{
+  NSString *file = [path lastPathComponent];
+  NSString *name = [file stringByDeletingPathExtension];
+  NSNumber *old;
+
+  if ([index objectForKey: file] == nil)
+    {
+      [index setObject: path forKey: file];
+    }
+  old = [ranks objectForKey: name];
+  if (old == nil || [old unsignedIntegerValue] > rank)
+    {
+      [index setObject: path forKey: name];
+      [ranks setObject: [NSNumber numberWithUnsignedInteger: rank]
+                forKey: name];
+    }
+}
+
+static NSDictionary *
+index_bundle(NSBundle *bundle, NSString *dir, NSArray *types)
+{
+  NSMutableDictionary *index = [NSMutableDictionary dictionary];
+  NSMutableDictionary *ranks = [NSMutableDictionary dictionary];
+  NSUInteger i, count = [types count];
+
+  for (i = 0; bundle != nil && i < count; i++)
+    {
+      NSEnumerator *e = [[bundle pathsForResourcesOfType: [types objectAtIndex: i]
+                                             inDirectory: dir]
+                          objectEnumerator];
+      NSString *path;
+
+      while ((path = [e nextObject]) != nil)
+        {
+          add_to_index(index, ranks, path, i);
+        }
+    }
+  return index;
+}
+
+static NSDictionary *
+index_library_images(NSArray *types)
+{
+  NSMutableDictionary *index = [NSMutableDictionary dictionary];
+  NSMutableDictionary *ranks = [NSMutableDictionary dictionary];
+  NSFileManager *manager = [NSFileManager defaultManager];
+  NSEnumerator *libs = [NSStandardLibraryPaths() objectEnumerator];
+  NSString *lib;
+
+  while ((lib = [libs nextObject]) != nil)
+    {
+      NSString *dir = [lib stringByAppendingPathComponent: @"Images"];
+      NSEnumerator *e = [[manager directoryContentsAtPath: dir]
+                          objectEnumerator];
+      NSString *file;
+
+      while ((file = [e nextObject]) != nil)
+        {
+          NSUInteger rank = [types indexOfObject: [file pathExtension]];
+
+          if (rank != NSNotFound)
+            {
+              add_to_index(index, ranks,
+                           [dir stringByAppendingPathComponent: file], rank);
+            }
+        }
+    }
+  return index;
+}
+
+/* All cached reps of all images, most recently used first, with the
+   bytes they use. Caches are evicted from the tail when the budget is
+   exceeded. The list is protected by imageLock. */
+static GSRepData *lruHead = nil;
+static GSRepData *lruTail = nil;
+static NSUInteger cacheBytesInUse = 0;
+static NSUInteger cacheEntries = 0;
+static NSUInteger cacheByteBudget = 0;
+static NSUInteger cacheEvictions = 0;
+static NSUInteger cacheRecaches = 0;
+
+static void
+cache_unlink(GSRepData *repd)
+{
+  [imageLock lock];
+  if (repd->lruPrev != nil)
+    repd->lruPrev->lruNext = repd->lruNext;
+  else
+    lruHead = repd->lruNext;
+  if (repd->lruNext != nil)
+    repd->lruNext->lruPrev = repd->lruPrev;
+  else
+    lruTail = repd->lruPrev;
+  repd->lruPrev = repd->lruNext = nil;
+  cacheBytesInUse -= repd->cacheBytes;
+  cacheEntries--;
+  repd->owner = nil;
+  [imageLock unlock];
+}
+
+static void
+cache_push(GSRepData *repd)
+{
+  repd->lruPrev = nil;
+  repd->lruNext = lruHead;
+  if (lruHead != nil)
+    lruHead->lruPrev = repd;
+  else
+    lruTail = repd;
+  lruHead = repd;
+}
+
+/* Moves a cache that is used to the head of the list. */
+static void
+cache_touch(GSRepData *repd)
+{
+  [imageLock lock];
+  if (repd->owner != nil && repd != lruHead)
+    {
+      repd->lruPrev->lruNext = repd->lruNext;
+      if (repd->lruNext != nil)
+        repd->lruNext->lruPrev = repd->lruPrev;
+      else
+        lruTail = repd->lruPrev;
+      cache_push(repd);
+    }
+  [imageLock unlock];
+}
+
+/* The images with decoded data or caches that may be purged, mapped to
+   the time they were last drawn, in whole seconds. */
+static NSMapTable *drawnImages = NULL;
+static NSTimeInterval purgeInterval = -1;
+static NSTimer *purgeTimer = nil;
+
+/* Records that image was drawn, and starts the timer purging unused
+   images if the GSImagePurgeInterval default is set. */
+static void
+mark_drawn(NSImage *image)
+{
+  NSUInteger now = (NSUInteger)[NSDate timeIntervalSinceReferenceDate];
+
+  [imageLock lock];
+  if (drawnImages == NULL)
+    {
+      drawnImages = NSCreateMapTable(NSNonOwnedPointerMapKeyCallBacks,
+                                     NSIntegerMapValueCallBacks, 64);
+    }
+  NSMapInsert(drawnImages, image, (void*)now);
+  if (purgeInterval < 0)
+    {
+      purgeInterval = [[NSUserDefaults standardUserDefaults]
+                        doubleForKey: @"GSImagePurgeInterval"];
+      if (purgeInterval > 0)
+        {
+          purgeTimer = [NSTimer scheduledTimerWithTimeInterval:
+                                  MAX(purgeInterval / 2, 1.0)
+                          target: [NSImage class]
+                        selector: @selector(_purgeTimerFired:)
+                        userInfo: nil
+                         repeats: YES];
+          RETAIN(purgeTimer);
+        }
+    }
+  [imageLock unlock];
+}
+
 /* Find the GSRepData object holding a representation */
 static GSRepData*
 repd_for_rep(NSArray *_reps, NSImageRep *rep)
@@ -156,12 +390,26 @@ repd_for_rep(NSArray *_reps, NSImageRep *rep)
 + (void) _clearFileTypeCaches: (NSNotification*)notif;
 + (NSString *) _pathForImageNamed: (NSString *)aName;
 + (void) _reloadCachedImages;
++ (void) _clearImageIndexes;
++ (void) _buildImageIndexes;
 - (BOOL) _useFromFile: (NSString *)fileName;
 - (BOOL) _loadFromData: (NSData *)data;
 - (BOOL) _loadFromFile: (NSString *)fileName;
 - (BOOL) _resetAndUseFromFile: (NSString *)fileName;
++ (void) _prefetchImagesNamed: (NSArray *)names;
++ (void) _prefetchThread: (id)unused;
+- (NSArray *) _prefetchedRepsForFile: (NSString *)fileName;
++ (void) _setPreparedReps: (NSArray *)reps forFile: (NSString *)path;
++ (void) _discardPreparedReps;
 - (GSRepData*) _cacheForRep: (NSImageRep*)rep;
 - (NSCachedImageRep*) _doImageCache: (NSImageRep *)rep;
++ (void) _purgeTimerFired: (NSTimer *)timer;
++ (void) _addCache: (GSRepData *)repd ofImage: (NSImage *)image;
+- (BOOL) _evictCache: (GSRepData *)repd;
+- (NSImageRep *) _scaledRep: (NSImageRep *)rep
+		    forRect: (NSRect)dstRect
+		   fromRect: (NSRect)srcRect
+		    context: (NSGraphicsContext *)ctxt;
 @end
 
 @implementation NSImage
@@ -406,9 +654,16 @@ repd_for_rep(NSArray *_reps, NSImageRep *rep)
 {
   if (_name == nil)
     {
+      if (drawnImages != NULL)
+        {
+          [imageLock lock];
+          NSMapRemove(drawnImages, self);
+          [imageLock unlock];
+        }
       RELEASE(_reps);
       TEST_RELEASE(_fileName);
       RELEASE(_color);
+      TEST_RELEASE(_prefetch);
       [super dealloc];
     }
   else
@@ -428,6 +683,7 @@ repd_for_rep(NSArray *_reps, NSImageRep *rep)
   copy = (NSImage*)NSCopyObject (self, 0, zone);
 
   copy->_name = nil;
+  copy->_prefetch = nil;
   RETAIN(_fileName);
   RETAIN(_color);
   copy->_lockedView = nil;
@@ -849,6 +1105,7 @@ repd_for_rep(NSArray *_reps, NSImageRep *rep)
 	      hints: (NSDictionary*)hints
 {
   NSImageRep *rep;
+  NSImageRep *scaled = nil;
   NSGraphicsContext *ctxt;
   NSSize imgSize, repSize;
   NSRect repSrcRect;
@@ -877,6 +1134,20 @@ repd_for_rep(NSArray *_reps, NSImageRep *rep)
 				  hints: hints];
   if (rep == nil)
     return;
+  mark_drawn(self);
+
+  /* Bitmaps drawn at another size are resampled once for that size, so
+   * drawing them again is a plain copy.
+   */
+  if (_cacheMode != NSImageCacheNever
+      && [rep isKindOfClass: bitmapClass]
+      && [ctxt isDrawingToScreen])
+    {
+      scaled = [self _scaledRep: rep
+			forRect: dstRect
+		       fromRect: srcRect
+			context: ctxt];
+    }
 
   // Try to cache / get a cached version of the best rep
   
@@ -884,7 +1155,11 @@ repd_for_rep(NSArray *_reps, NSImageRep *rep)
    * We only use caching on backends that can efficiently draw a rect from the cache
    * onto the current graphics context respecting the CTM, which is currently cairo.
    */
-  if (_cacheMode != NSImageCacheNever &&
+  if (scaled != nil)
+    {
+      rep = scaled;
+    }
+  else if (_cacheMode != NSImageCacheNever &&
       [ctxt supportsDrawGState])
     {
       NSCachedImageRep *cache = [self _doImageCache: rep];
@@ -1885,6 +2160,45 @@ iterate_reps_for_types(NSArray* imageReps, SEL method)
   DESTROY(imageFileTypes);
   DESTROY(imageUnfilteredPasteboardTypes);
   DESTROY(imagePasteboardTypes);
+  [self _clearImageIndexes];
+}
+
+/* Forgets the image indexes, so they are built again on next use. */
++ (void) _clearImageIndexes
+{
+  [imageLock lock];
+  DESTROY(mainImageIndex);
+  DESTROY(themeImageIndex);
+  DESTROY(systemImageIndex);
+  [imageLock unlock];
+}
+
+/* Builds the indexes of the main bundle, the theme and the system image
+   directories unless they exist. */
++ (void) _buildImageIndexes
+{
+  NSArray *types;
+  NSDate *start;
+
+  [imageLock lock];
+  if (mainImageIndex != nil)
+    {
+      [imageLock unlock];
+      return;
+    }
+  start = [NSDate date];
+  types = [self imageFileTypes];
+  mainImageIndex = RETAIN(index_bundle([NSBundle mainBundle], nil, types));
+  themeImageIndex = RETAIN(index_bundle([[GSTheme theme] bundle],
+                                        @"ThemeImages", types));
+  systemImageIndex = RETAIN(index_library_images(types));
+  NSDebugLLog(@"NSImage", @"Indexed %lu main bundle, %lu theme and %lu "
+              @"system image names in %f seconds",
+              (unsigned long)[mainImageIndex count],
+              (unsigned long)[themeImageIndex count],
+              (unsigned long)[systemImageIndex count],
+              -[start timeIntervalSinceNow]);
+  [imageLock unlock];
 }
 
 /**
@@ -1898,6 +2212,8 @@ iterate_reps_for_types(NSArray* imageReps, SEL method)
   NSEnumerator *e;
 
   [imageLock lock];
+  /* The theme has changed, so its images have to be indexed again. */
+  [self _clearImageIndexes];
   e = [nameDict keyEnumerator];
   while ((name = [e nextObject]) != nil)
     {
@@ -1951,6 +2267,29 @@ iterate_reps_for_types(NSArray* imageReps, SEL method)
 	 So leave it alone */
       ext = nil;
     }
+
+  /* Names without a directory are looked up in the indexes, which find
+     the same path as the search below, without probing the file system
+     for each type. */
+  if ([realName rangeOfString: @"/"].location == NSNotFound)
+    {
+      NSString *key = realName;
+
+      if (ext != nil)
+        {
+          key = [realName stringByAppendingPathExtension: ext];
+        }
+      [imageLock lock];
+      [self _buildImageIndexes];
+      path = [mainImageIndex objectForKey: key];
+      if (path == nil)
+        path = [themeImageIndex objectForKey: key];
+      if (path == nil)
+        path = [systemImageIndex objectForKey: key];
+      AUTORELEASE(RETAIN(path));
+      [imageLock unlock];
+      return path;
+    }
   
   /* First search locally */
   if (ext)
@@ -2054,10 +2393,21 @@ iterate_reps_for_types(NSArray* imageReps, SEL method)
 - (BOOL) _loadFromFile: (NSString *)fileName
 {
   NSArray *array;
+  NSUInteger i = [_reps count];
 
-  array = [NSImageRep imageRepsWithContentsOfFile: fileName];
+  array = [self _prefetchedRepsForFile: fileName];
+  if (array == nil)
+    array = [NSImageRep imageRepsWithContentsOfFile: fileName];
   if (array)
     [self addRepresentations: array];
+  if (!_flags.dataRetained)
+    {
+      /* The file can be read again, so these may be purged. */
+      for (; i < [_reps count]; i++)
+        {
+          ((GSRepData*)[_reps objectAtIndex: i])->fromFile = YES;
+        }
+    }
 
   return (array && ([array count] > 0)) ? YES : NO;
 }
@@ -2085,6 +2435,147 @@ iterate_reps_for_types(NSArray* imageReps, SEL method)
   return YES;
 }
 
+/* Starts decoding the files of the named images on worker threads, so
+   that the representations are ready when the images are first used.
+   Images which are already loaded are skipped. */
++ (void) _prefetchImagesNamed: (NSArray *)names
+{
+  NSEnumerator *e = [names objectEnumerator];
+  NSString *name;
+
+  if (prefetchCondition == nil)
+    {
+      NSUInteger i;
+
+      prefetchCondition = [NSCondition new];
+      prefetchQueue = [NSMutableArray new];
+      for (i = 0; i < NUM_PREFETCH_WORKERS; i++)
+        {
+          [NSThread detachNewThreadSelector: @selector(_prefetchThread:)
+                                   toTarget: self
+                                 withObject: nil];
+        }
+    }
+
+  while ((name = [e nextObject]) != nil)
+    {
+      NSImage *image = [self imageNamed: name];
+      GSImagePrefetch *prefetch;
+
+      if (image == nil || !image->_flags.syncLoad || image->_prefetch != nil)
+        continue;
+
+      prefetch = [GSImagePrefetch new];
+      prefetch->path = [image->_fileName copy];
+      image->_prefetch = prefetch;
+      [prefetchCondition lock];
+      [prefetchQueue addObject: prefetch];
+      [prefetchCondition signal];
+      [prefetchCondition unlock];
+    }
+}
+
++ (void) _prefetchThread: (id)unused
+{
+  while (YES)
+    {
+      CREATE_AUTORELEASE_POOL(pool);
+      GSImagePrefetch *prefetch;
+      NSArray *reps = nil;
+
+      [prefetchCondition lock];
+      while ([prefetchQueue count] == 0)
+        {
+          [prefetchCondition wait];
+        }
+      prefetch = RETAIN([prefetchQueue objectAtIndex: 0]);
+      [prefetchQueue removeObjectAtIndex: 0];
+      [prefetchCondition unlock];
+
+      NS_DURING
+        {
+          reps = [NSImageRep imageRepsWithContentsOfFile: prefetch->path];
+        }
+      NS_HANDLER
+        {
+          NSLog(@"Problem decoding image '%@': %@",
+                prefetch->path, localException);
+        }
+      NS_ENDHANDLER
+
+      [prefetchCondition lock];
+      prefetch->reps = RETAIN(reps);
+      prefetch->done = YES;
+      [prefetchCondition broadcast];
+      [prefetchCondition unlock];
+      RELEASE(prefetch);
+      DESTROY(pool);
+    }
+}
+
+/* Returns the representations decoded for fileName by a prefetch, waiting
+   for a worker which is decoding them, or nil if there was no prefetch or
+   no worker has started on it yet. Without a prefetch, returns those
+   in the pack of the current theme or decoded for the file by a theme
+   being prepared, if any. */
+- (NSArray *) _prefetchedRepsForFile: (NSString *)fileName
+{
+  GSImagePrefetch *prefetch = _prefetch;
+  NSArray *reps = nil;
+
+  if (prefetch == nil)
+    {
+      reps = [[GSTheme theme] _packedRepsForFile: fileName];
+      if (reps != nil || preparedReps == nil)
+        return reps;
+      [imageLock lock];
+      reps = AUTORELEASE(RETAIN([preparedReps objectForKey: fileName]));
+      if (reps != nil)
+        [preparedReps removeObjectForKey: fileName];
+      [imageLock unlock];
+      return reps;
+    }
+
+  _prefetch = nil;
+  [prefetchCondition lock];
+  if ([prefetchQueue indexOfObjectIdenticalTo: prefetch] != NSNotFound)
+    {
+      [prefetchQueue removeObjectIdenticalTo: prefetch];
+    }
+  else
+    {
+      while (!prefetch->done)
+        {
+          [prefetchCondition wait];
+        }
+      reps = AUTORELEASE(RETAIN(prefetch->reps));
+    }
+  [prefetchCondition unlock];
+
+  if (![fileName isEqualToString: prefetch->path])
+    reps = nil;
+  RELEASE(prefetch);
+  return reps;
+}
+
+/* Called from the thread preparing a theme with the representations it
+   decoded from the file at path. */
++ (void) _setPreparedReps: (NSArray *)reps forFile: (NSString *)path
+{
+  [imageLock lock];
+  if (preparedReps == nil)
+    preparedReps = [NSMutableDictionary new];
+  [preparedReps setObject: reps forKey: path];
+  [imageLock unlock];
+}
+
++ (void) _discardPreparedReps
+{
+  [imageLock lock];
+  [preparedReps removeAllObjects];
+  [imageLock unlock];
+}
+
 - (BOOL) _resetAndUseFromFile: (NSString *)fileName
 {
   [_reps removeAllObjects];
@@ -2096,6 +2587,137 @@ iterate_reps_for_types(NSArray* imageReps, SEL method)
   return [self _useFromFile: fileName];
 }
 
+/* Adds a new cache to the list of all caches and evicts the least
+   recently used caches of all images while over the byte budget. */
++ (void) _addCache: (GSRepData *)repd ofImage: (NSImage *)image
+{
+  [imageLock lock];
+  if (cacheByteBudget == 0)
+    {
+      NSInteger budget = [[NSUserDefaults standardUserDefaults]
+                           integerForKey: @"GSImageCacheByteBudget"];
+
+      cacheByteBudget = (budget > 0 ? budget : 64 * 1024 * 1024);
+    }
+  repd->owner = image;
+  cache_push(repd);
+  cacheBytesInUse += repd->cacheBytes;
+  cacheEntries++;
+
+  while (cacheBytesInUse > cacheByteBudget && lruTail != lruHead)
+    {
+      if (![lruTail->owner _evictCache: lruTail])
+        break;
+      cacheEvictions++;
+    }
+  [imageLock unlock];
+}
+
+/* Removes the cache repd of the receiver, unless the receiver has focus
+   locked. */
+- (BOOL) _evictCache: (GSRepData *)repd
+{
+  if (_lockedView != nil)
+    return NO;
+
+  if (repd->original != nil)
+    {
+      repd_for_rep(_reps, repd->original)->cacheEvicted = YES;
+    }
+  /* Releasing repd unlinks it. */
+  [_reps removeObjectIdenticalTo: repd];
+  return YES;
+}
+
+/* The number of resampled copies kept of each bitmap. */
+#define MAX_SCALED_REPS 4
+
+/* Returns a copy of the bitmap rep resampled to the size it takes on
+   the device when srcRect of the receiver is drawn into dstRect, making
+   it if needed. Returns nil if the backend should scale rep itself,
+   because it is drawn at about its own size, rotated or much enlarged. */
+- (NSImageRep *) _scaledRep: (NSImageRep *)rep
+		    forRect: (NSRect)dstRect
+		   fromRect: (NSRect)srcRect
+		    context: (NSGraphicsContext *)ctxt
+{
+  NSImageInterpolation interpolation = [ctxt imageInterpolation];
+  NSAffineTransformStruct m = [[ctxt GSCurrentCTM] transformStruct];
+  NSSize imgSize = [self size];
+  NSInteger pixelsWide = [rep pixelsWide];
+  NSInteger pixelsHigh = [rep pixelsHigh];
+  NSInteger width, height;
+  GSImageResamplingFilter filter;
+  NSBitmapImageRep *scaled;
+  GSRepData *repd, *oldest = nil;
+  NSUInteger i, count = 0;
+
+  if (interpolation == NSImageInterpolationNone
+      || m.m12 != 0.0 || m.m21 != 0.0
+      || NSWidth(srcRect) <= 0 || NSHeight(srcRect) <= 0
+      || pixelsWide <= 0 || pixelsHigh <= 0)
+    return nil;
+
+  /* The size of the whole rep in device pixels. */
+  width = (NSInteger)floor(fabs(m.m11) * NSWidth(dstRect)
+			   * imgSize.width / NSWidth(srcRect) + 0.5);
+  height = (NSInteger)floor(fabs(m.m22) * NSHeight(dstRect)
+			    * imgSize.height / NSHeight(srcRect) + 0.5);
+  if (width <= 0 || height <= 0
+      || (labs(width - pixelsWide) <= 1 && labs(height - pixelsHigh) <= 1)
+      || width > 2 * pixelsWide || height > 2 * pixelsHigh
+      || width * height > 4096 * 4096)
+    return nil;
+
+  for (i = 0; i < [_reps count]; i++)
+    {
+      repd = (GSRepData*)[_reps objectAtIndex: i];
+      if (repd->scaled && repd->original == rep)
+	{
+	  if ([repd->rep pixelsWide] == width
+	      && [repd->rep pixelsHigh] == height)
+	    {
+	      cache_touch(repd);
+	      return repd->rep;
+	    }
+	  /* Copies are added at the end, so the first is the oldest. */
+	  if (oldest == nil)
+	    oldest = repd;
+	  count++;
+	}
+    }
+  if (count >= MAX_SCALED_REPS)
+    {
+      [_reps removeObjectIdenticalTo: oldest];
+    }
+
+  if (interpolation == NSImageInterpolationLow)
+    filter = GSImageResamplingBilinear;
+  else if (interpolation == NSImageInterpolationHigh)
+    filter = GSImageResamplingLanczos;
+  else if (width * 2 <= pixelsWide && height * 2 <= pixelsHigh)
+    filter = GSImageResamplingBox;
+  else
+    filter = GSImageResamplingBilinear;
+
+  scaled = [(NSBitmapImageRep*)rep
+	     bitmapImageRepByResamplingToPixelsWide: width
+					 pixelsHigh: height
+					     filter: filter];
+  if (scaled == nil)
+    return nil;
+
+  repd = [GSRepData new];
+  repd->rep = RETAIN(scaled);
+  repd->original = rep;
+  repd->scaled = YES;
+  repd->cacheBytes = width * height * 4;
+  [_reps addObject: repd];
+  RELEASE(repd); /* Retained in _reps array. */
+  [NSImage _addCache: repd ofImage: self];
+  return scaled;
+}
+
 // Cache the bestRepresentation.  If the bestRepresentation is not itself
 // a cache and no cache exists, create one and draw the representation in it
 // If a cache exists, but is not valid, redraw the cache from the original
@@ -2112,6 +2734,7 @@ iterate_reps_for_types(NSArray* imageReps, SEL method)
   cache = (NSCachedImageRep*)(repd->rep);
   if ([cache isKindOfClass: cachedClass] == NO)
     return nil;
+  cache_touch(repd);
   
   NSDebugLLog(@"NSImage", @"Cached image rep is %p", cache);
   /*
@@ -2169,7 +2792,8 @@ iterate_reps_for_types(NSArray* imageReps, SEL method)
             {
               GSRepData *repd = reps[i];
 
-              if (repd->original == rep && repd->rep != nil)
+              if (repd->original == rep && repd->rep != nil
+                  && !repd->scaled)
                 {
                   if (repd->bg == nil)
                     {
@@ -2268,12 +2892,162 @@ iterate_reps_for_types(NSArray* imageReps, SEL method)
           repd = [GSRepData new];
           repd->rep = cacheRep;
           repd->original = rep; // may be nil!
+          repd->cacheBytes = pixelsWide * pixelsHigh * 4;
           [_reps addObject: repd]; 
           RELEASE(repd); /* Retained in _reps array. */
 
+          if (rep != nil)
+            {
+              GSRepData *orig = repd_for_rep(_reps, rep);
+
+              if (orig->cacheEvicted)
+                {
+                  orig->cacheEvicted = NO;
+                  [imageLock lock];
+                  cacheRecaches++;
+                  [imageLock unlock];
+                }
+            }
+          [NSImage _addCache: repd ofImage: self];
+
           return repd;
         }
     }
 }
 
 @end
+
+@implementation NSImage (GSPurgeableStorage)
+
++ (void) purgeImageDataUnusedFor: (NSTimeInterval)seconds
+{
+  NSUInteger now = (NSUInteger)[NSDate timeIntervalSinceReferenceDate];
+  NSMutableArray *unused;
+  NSMapEnumerator e;
+  NSImage *image;
+  void *drawn;
+
+  [imageLock lock];
+  if (drawnImages == NULL)
+    {
+      [imageLock unlock];
+      return;
+    }
+  unused = [NSMutableArray array];
+  e = NSEnumerateMapTable(drawnImages);
+  while (NSNextMapEnumeratorPair(&e, (void**)&image, &drawn))
+    {
+      if (now - (NSUInteger)drawn >= seconds)
+        {
+          [unused addObject: image];
+        }
+    }
+  NSEndMapTableEnumeration(&e);
+  [unused makeObjectsPerformSelector: @selector(purgeImageData)];
+  [imageLock unlock];
+}
+
++ (void) _purgeTimerFired: (NSTimer *)timer
+{
+  [self purgeImageDataUnusedFor: purgeInterval];
+}
+
+- (void) purgeImageData
+{
+  NSMutableArray *fromFile;
+  NSUInteger i;
+
+  if (_lockedView != nil)
+    {
+      return;
+    }
+
+  /* Throw away the caches, and the representations that can be loaded
+     from the referenced file again. */
+  fromFile = [NSMutableArray array];
+  i = [_reps count];
+  while (i--)
+    {
+      GSRepData *repd = (GSRepData*)[_reps objectAtIndex: i];
+
+      if (repd->fromFile)
+        {
+          [fromFile addObject: repd->rep];
+        }
+      else if (repd->original != nil)
+        {
+          [_reps removeObjectAtIndex: i];
+        }
+    }
+  if ([fromFile count] > 0)
+    {
+      NSEnumerator *e = [fromFile objectEnumerator];
+      NSImageRep *rep;
+
+      while ((rep = [e nextObject]) != nil)
+        {
+          [self removeRepresentation: rep];
+        }
+      _flags.syncLoad = YES;
+    }
+
+  [imageLock lock];
+  if (drawnImages != NULL)
+    {
+      NSMapRemove(drawnImages, self);
+    }
+  [imageLock unlock];
+}
+
+@end
+
+@implementation NSImage (GSImageCache)
+
++ (void) setImageCacheByteBudget: (NSUInteger)bytes
+{
+  [imageLock lock];
+  cacheByteBudget = MAX(bytes, 1);
+  while (cacheBytesInUse > cacheByteBudget && lruTail != nil)
+    {
+      if (![lruTail->owner _evictCache: lruTail])
+        break;
+      cacheEvictions++;
+    }
+  [imageLock unlock];
+}
+
++ (NSUInteger) imageCacheByteBudget
+{
+  NSUInteger budget;
+
+  [imageLock lock];
+  budget = cacheByteBudget;
+  [imageLock unlock];
+  if (budget == 0)
+    {
+      NSInteger b = [[NSUserDefaults standardUserDefaults]
+                      integerForKey: @"GSImageCacheByteBudget"];
+
+      budget = (b > 0 ? b : 64 * 1024 * 1024);
+    }
+  return budget;
+}
+
++ (NSDictionary *) imageCacheStatistics
+{
+  NSDictionary *d;
+
+  [imageLock lock];
+  d = [NSDictionary dictionaryWithObjectsAndKeys:
+    [NSNumber numberWithUnsignedInteger: cacheBytesInUse], @"BytesInUse",
+    [NSNumber numberWithUnsignedInteger: [self imageCacheByteBudget]],
+    @"ByteBudget",
+    [NSNumber numberWithUnsignedInteger: cacheEntries], @"Entries",
+    [NSNumber numberWithUnsignedInteger: cacheEvictions], @"Evictions",
+    [NSNumber numberWithUnsignedInteger: cacheRecaches], @"Recaches",
+    nil];
+  [imageLock unlock];
+  return d;
+}
+
+@end
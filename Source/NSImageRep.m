@@ -247,6 +247,12 @@ implement, so we can't do that. */
       data = [p dataForType: type];
       NSDebugLLog(@"NSImage", @"Filtering data for %@ from %@ of type %@ to %@", filename, p, type, data);
     }
+  else if ([rep isSubclassOfClass: [NSBitmapImageRep class]])
+    {
+      /* Bitmaps are decoded straight from the pages of the file, and
+         later TIFF pages only when they are used. */
+      data = [NSData dataWithContentsOfMappedFile: filename];
+    }
   else
     {
       data = [NSData dataWithContentsOfFile: filename];
@@ -26,6 +26,9 @@
    Boston, MA 02110-1301, USA.
 */
 
+#import <Foundation/NSArray.h>
+#import <Foundation/NSValue.h>
+#import "AppKit/NSBitmapImageRep.h"
 #import "AppKit/NSDragging.h"
 #import "AppKit/NSEvent.h"
 #import "AppKit/NSImage.h"
@@ -34,6 +37,7 @@
 #import "AppKit/NSMenuItem.h"
 #import "AppKit/NSPasteboard.h"
 #import "AppKit/NSWindow.h"
+#import "GNUstepGUI/GSAnimator.h"
 
 /*
  * Class variables
@@ -41,6 +45,36 @@
 static Class usedCellClass;
 static Class imageCellClass;
 
+/* An animated image is stepped by the shared animation clock of
+   GSAnimator while the view is in a window.  Frames are only advanced,
+   decoded and displayed while the view can be seen, so the animation
+   pauses when the view or an ancestor is hidden, its window is ordered
+   out or miniaturised, or it is scrolled out of its clip view.  */
+@interface NSImageView (GSAnimation) <GSAnimation>
+- (void) _updateAnimation;
+@end
+
+/* Returns the bitmap rep of image holding several frames, if any.  */
+static NSBitmapImageRep *
+animatedRep(NSImage *image)
+{
+  NSArray *reps = [image representations];
+  NSUInteger i;
+
+  for (i = 0; i < [reps count]; i++)
+    {
+      NSImageRep *rep = [reps objectAtIndex: i];
+
+      if ([rep isKindOfClass: [NSBitmapImageRep class]]
+	&& [[(NSBitmapImageRep *)rep valueForProperty: NSImageFrameCount]
+	  intValue] > 1)
+	{
+	  return (NSBitmapImageRep *)rep;
+	}
+    }
+  return nil;
+}
+
 @implementation NSImageView
 
 //
@@ -85,10 +119,20 @@ static Class imageCellClass;
   return self;
 }
 
+- (void) dealloc
+{
+  [_animator stopAnimation];
+  DESTROY(_animator);
+  [super dealloc];
+}
+
 - (void) setImage: (NSImage *)image
 {
   [_cell setImage: image];
   [self updateCell: _cell];
+  _frameTime = 0.0;
+  _loops = 0;
+  [self _updateAnimation];
 }
 
 - (void) setImageAlignment: (NSImageAlignment)align
@@ -149,13 +193,19 @@ static Class imageCellClass;
 
 - (BOOL) animates
 {
-  // FIXME: Should be passed on to cell.
-  return NO;
+  return _ivflags.animates;
 }
 
 - (void) setAnimates: (BOOL) flag
 {
-  // FIXME: Should be passed on to cell.
+  _ivflags.animates = flag;
+  [self _updateAnimation];
+}
+
+- (void) viewDidMoveToWindow
+{
+  [super viewDidMoveToWindow];
+  [self _updateAnimation];
 }
 
 - (BOOL) allowsCutCopyPaste
@@ -418,6 +468,103 @@ static Class imageCellClass;
 
 @end
 
+@implementation NSImageView (GSAnimation)
+
+- (void) _updateAnimation
+{
+  BOOL run = _ivflags.animates && _window != nil
+    && animatedRep([self image]) != nil;
+
+  if (run && _animator == nil)
+    {
+      _animator = [[GSAnimator alloc] initWithAnimation: self];
+      [_animator setRunLoopModesForAnimating:
+	[NSArray arrayWithObjects: NSDefaultRunLoopMode,
+		 NSModalPanelRunLoopMode, NSEventTrackingRunLoopMode, nil]];
+      [_animator startAnimation];
+    }
+  else if (run && ![_animator isAnimationRunning])
+    {
+      [_animator startAnimation];
+    }
+  else if (!run && _animator != nil)
+    {
+      [_animator stopAnimation];
+      DESTROY(_animator);
+    }
+}
+
+- (void) animatorDidStart
+{
+  _lastStep = 0.0;
+}
+
+- (void) animatorDidStop
+{
+}
+
+- (void) animatorStep: (NSTimeInterval)elapsedTime
+{
+  NSImage *image = [self image];
+  NSBitmapImageRep *rep;
+  NSTimeInterval delta = elapsedTime - _lastStep;
+  NSTimeInterval duration;
+  int frame, count, loopCount;
+  BOOL changed = NO;
+
+  _lastStep = elapsedTime;
+  if (_window == nil || ![_window isVisible] || [_window isMiniaturized]
+    || [self isHiddenOrHasHiddenAncestor] || NSIsEmptyRect([self visibleRect]))
+    {
+      return;
+    }
+  rep = animatedRep(image);
+  if (rep == nil)
+    {
+      return;
+    }
+
+  count = [[rep valueForProperty: NSImageFrameCount] intValue];
+  loopCount = [[rep valueForProperty: NSImageLoopCount] intValue];
+  frame = [[rep valueForProperty: NSImageCurrentFrame] intValue];
+  _frameTime += delta;
+  for (;;)
+    {
+      duration = [[rep valueForProperty: NSImageCurrentFrameDuration]
+		   doubleValue];
+      /* Like browsers, show frames without a usable delay for 0.1s.  */
+      if (duration <= 0.01)
+	duration = 0.1;
+      if (_frameTime < duration)
+	break;
+      if (frame + 1 >= count)
+	{
+	  _loops++;
+	  if (loopCount > 0 && _loops >= (NSUInteger)loopCount)
+	    {
+	      /* Stay on the last frame until a new image is set.  */
+	      _frameTime = 0.0;
+	      [_animator stopAnimation];
+	      break;
+	    }
+	}
+      _frameTime -= duration;
+      frame = (frame + 1) % count;
+      [rep setProperty: NSImageCurrentFrame
+	     withValue: [NSNumber numberWithInt: frame]];
+      changed = YES;
+    }
+
+  if (changed)
+    {
+      /* Drop the copies of the previous frame the image cached.  */
+      [image recache];
+      [self setNeedsDisplay: YES];
+    }
+}
+
+@end
+
 @implementation NSImageView (GNUstep)
 
 - (BOOL)initiatesDrag
@@ -37,10 +37,13 @@
 #import <Foundation/NSKeyValueCoding.h>
 #import <Foundation/NSLock.h>
 #import <Foundation/NSMapTable.h>
+#import <Foundation/NSRunLoop.h>
+#import <Foundation/NSThread.h>
 #import <Foundation/NSValue.h>
 #import <Foundation/NSValueTransformer.h>
 #import <GNUstepBase/GSLock.h>
 
+#import "AppKit/NSApplication.h"
 #import "AppKit/NSKeyValueBinding.h"
 #import "GSBindingHelpers.h"
 
@@ -53,22 +56,7 @@
 
 - (NSArray *) exposedBindings
 {
-  NSMutableArray *exposedBindings = [NSMutableArray array];
-  NSArray *tmp;
-  Class class = [self class];
-
-  while (class && class != [NSObject class])
-    {
-      tmp = [GSKeyValueBinding exposedBindingsForClass: class];
-      if (tmp != nil)
-        {
-          [exposedBindings addObjectsFromArray: tmp];
-        }
-  
-      class = [class superclass];
-    }
-
-  return exposedBindings;
+  return [GSKeyValueBinding allExposedBindingsForClass: [self class]];
 }
 
 - (Class) valueClassForBinding: (NSString *)binding
@@ -122,7 +110,14 @@
 
 static NSRecursiveLock *bindingLock = nil;
 static NSMapTable *classTable = NULL;      //available bindings
+static NSMapTable *flatTable = NULL;       //bindings of class and supers
 static NSMapTable *objectTable = NULL;     //bound bindings
+static id lastObject = nil;                //object of the last lookup
+static NSMutableDictionary *lastBindings = nil; //its bound bindings
+static NSMapTable *batchTable = NULL;      //objects in a batch -> depth
+static NSMutableArray *pendingBindings = nil; //bindings with held changes
+static NSArray *flushModes = nil;
+static BOOL flushScheduled = NO;
 
 typedef enum {
   GSBindingOperationAnd = 0,
@@ -146,8 +141,115 @@ void GSBindingInvokeAction(NSString *targetKey, NSString *argumentKey,
       bindingLock = [GSLazyRecursiveLock new];
       classTable = NSCreateMapTable(NSNonOwnedPointerMapKeyCallBacks,
           NSObjectMapValueCallBacks, 128);
+      flatTable = NSCreateMapTable(NSNonOwnedPointerMapKeyCallBacks,
+          NSObjectMapValueCallBacks, 128);
       objectTable = NSCreateMapTable(NSNonRetainedObjectMapKeyCallBacks,
           NSObjectMapValueCallBacks, 128);
+      batchTable = NSCreateMapTable(NSNonRetainedObjectMapKeyCallBacks,
+          NSIntegerMapValueCallBacks, 16);
+      pendingBindings = [NSMutableArray new];
+      flushModes = [[NSArray alloc] initWithObjects: NSDefaultRunLoopMode,
+                                    NSModalPanelRunLoopMode,
+                                    NSEventTrackingRunLoopMode, nil];
+    }
+}
+
+/* Returns the bound bindings of anObject.  Views look up their bindings
+   many times in a row, so the last lookup is remembered.  Must be called
+   with bindingLock held. */
+static inline NSMutableDictionary *
+bindingsForObject(id anObject)
+{
+  if (anObject != lastObject)
+    {
+      lastBindings = (NSMutableDictionary *)NSMapGet(objectTable,
+                                                     (void *)anObject);
+      lastObject = anObject;
+    }
+  return lastBindings;
+}
+
+/* Forgets the last lookup when the object table changes.  Must be
+   called with bindingLock held. */
+static inline void
+forgetLastLookup(void)
+{
+  lastObject = nil;
+  lastBindings = nil;
+}
+
+/* Shows the held back changes of the bindings observing object, or of
+   every binding whose observed object is not in a batch if object is
+   nil. */
+static void
+flushPendingBindings(id object)
+{
+  NSMutableArray *ready = [NSMutableArray array];
+  NSMutableArray *names = [NSMutableArray array];
+  NSUInteger i = 0, count;
+
+  [bindingLock lock];
+  while (i < [pendingBindings count])
+    {
+      GSKeyValueBinding *b = [pendingBindings objectAtIndex: i];
+      id dest = [b->info objectForKey: NSObservedObjectKey];
+
+      if (object != nil ? dest == object : NSMapGet(batchTable, dest) == 0)
+        {
+          [ready addObject: b];
+          [names addObject: b->pendingBinding];
+          DESTROY(b->pendingBinding);
+          [pendingBindings removeObjectAtIndex: i];
+        }
+      else
+        {
+          i++;
+        }
+    }
+  [bindingLock unlock];
+
+  count = [ready count];
+  for (i = 0; i < count; i++)
+    {
+      [[ready objectAtIndex: i] setValueFor: [names objectAtIndex: i]];
+    }
+}
+
++ (void) _flushPendingBindings: (id)sender
+{
+  [bindingLock lock];
+  flushScheduled = NO;
+  [bindingLock unlock];
+  flushPendingBindings(nil);
+}
+
++ (void) beginBatchForObject: (id)anObject
+{
+  [bindingLock lock];
+  NSMapInsert(batchTable, (void *)anObject,
+              (void *)((NSInteger)NSMapGet(batchTable, anObject) + 1));
+  [bindingLock unlock];
+}
+
++ (void) endBatchForObject: (id)anObject
+{
+  NSInteger depth;
+
+  [bindingLock lock];
+  depth = (NSInteger)NSMapGet(batchTable, anObject);
+  if (depth > 1)
+    {
+      NSMapInsert(batchTable, (void *)anObject, (void *)(depth - 1));
+    }
+  else
+    {
+      NSMapRemove(batchTable, (void *)anObject);
+    }
+  [bindingLock unlock];
+
+  if (depth == 1)
+    {
+      flushPendingBindings(anObject);
     }
 }
 
@@ -164,6 +266,7 @@ void GSBindingInvokeAction(NSString *targetKey, NSString *argumentKey,
       RELEASE(bindings);
     }
   [bindings addObject: binding];
+  NSResetMapTable(flatTable);
   [bindingLock unlock];
 }
 
@@ -181,6 +284,38 @@ void GSBindingInvokeAction(NSString *targetKey, NSString *argumentKey,
   return tmp;
 }
 
++ (NSArray *) allExposedBindingsForClass: (Class)clazz
+{
+  NSArray *all;
+
+  [bindingLock lock];
+  all = (NSArray *)NSMapGet(flatTable, (void*)clazz);
+  if (all == nil)
+    {
+      NSMutableArray *exposedBindings = [NSMutableArray array];
+      Class class = clazz;
+
+      while (class && class != [NSObject class])
+        {
+          NSArray *tmp = NSMapGet(classTable, (void*)class);
+
+          if (tmp != nil)
+            {
+              [exposedBindings addObjectsFromArray: tmp];
+            }
+          class = [class superclass];
+        }
+      all = [exposedBindings copy];
+      NSMapInsert(flatTable, (void*)clazz, (void*)all);
+      RELEASE(all);
+    }
+  // Keep the list alive should a binding be exposed meanwhile
+  all = AUTORELEASE(RETAIN(all));
+  [bindingLock unlock];
+
+  return all;
+}
+
 + (GSKeyValueBinding *) getBinding: (NSString *)binding 
                          forObject: (id)anObject
 {
@@ -191,7 +326,7 @@ void GSBindingInvokeAction(NSString *targetKey, NSString *argumentKey,
     return nil;
 
   [bindingLock lock];
-  bindings = (NSMutableDictionary *)NSMapGet(objectTable, (void *)anObject);
+  bindings = bindingsForObject(anObject);
   if (bindings != nil)
     {
       theBinding = (GSKeyValueBinding*)[bindings objectForKey: binding];
@@ -225,7 +360,7 @@ void GSBindingInvokeAction(NSString *targetKey, NSString *argumentKey,
     return;
 
   [bindingLock lock];
-  bindings = (NSMutableDictionary *)NSMapGet(objectTable, (void *)anObject);
+  bindings = bindingsForObject(anObject);
   if (bindings != nil)
     {
       theBinding = (GSKeyValueBinding*)[bindings objectForKey: binding];
@@ -234,6 +369,11 @@ void GSBindingInvokeAction(NSString *targetKey, NSString *argumentKey,
           observedObject = [theBinding->info objectForKey: NSObservedObjectKey];
           keyPath = [theBinding->info objectForKey: NSObservedKeyPathKey];
           [observedObject removeObserver: theBinding forKeyPath: keyPath];
+          if (theBinding->pendingBinding != nil)
+            {
+              DESTROY(theBinding->pendingBinding);
+              [pendingBindings removeObjectIdenticalTo: theBinding];
+            }
           [bindings setValue: nil forKey: binding];
         }
     }
@@ -250,7 +390,7 @@ void GSBindingInvokeAction(NSString *targetKey, NSString *argumentKey,
     return;
 
   [bindingLock lock];
-  list = (NSDictionary *)NSMapGet(objectTable, (void *)anObject);
+  list = bindingsForObject(anObject);
   if (list != nil)
     {
       NSArray *keys = [list allKeys];
@@ -261,6 +401,7 @@ void GSBindingInvokeAction(NSString *targetKey, NSString *argumentKey,
           [anObject unbind: binding];
         }
       NSMapRemove(objectTable, (void *)anObject);
+      forgetLastLookup();
     }
   [bindingLock unlock];
 }
@@ -303,6 +444,7 @@ void GSBindingInvokeAction(NSString *targetKey, NSString *argumentKey,
       bindings = [NSMutableDictionary new];
       NSMapInsert(objectTable, (void*)source, (void*)bindings);
       RELEASE(bindings);
+      forgetLastLookup();
     }
   [bindings setObject: self forKey: name];
   [bindingLock unlock];
@@ -314,6 +456,7 @@ void GSBindingInvokeAction(NSString *targetKey, NSString *argumentKey,
 
 - (void)dealloc
 {
+  DESTROY(pendingBinding);
   DESTROY(info);
   src = nil; 
   [super dealloc];
@@ -348,6 +491,51 @@ void GSBindingInvokeAction(NSString *targetKey, NSString *argumentKey,
   [src setValue: [self destinationValue] forKey: binding];
 }
 
+/* Returns YES if the change of the observed value is held back, either
+   because the binding coalesces changes or because the observed object
+   is in a batch.  The binding is then updated once later on. */
+- (BOOL) holdsBackChangeFor: (NSString *)binding
+{
+  id dest = [info objectForKey: NSObservedObjectKey];
+  BOOL batched, coalesces;
+
+  coalesces = [[[info objectForKey: NSOptionsKey]
+    objectForKey: GSCoalescesChangesBindingOption] boolValue];
+  [bindingLock lock];
+  batched = (NSMapGet(batchTable, dest) != 0);
+  if (batched || coalesces)
+    {
+      if (pendingBinding == nil)
+        {
+          ASSIGN(pendingBinding, binding);
+          [pendingBindings addObject: self];
+        }
+      if (!batched && !flushScheduled)
+        {
+          flushScheduled = YES;
+          /* Flush just before windows are displayed. */
+          if ([NSThread isMainThread])
+            {
+              [[NSRunLoop currentRunLoop]
+                performSelector: @selector(_flushPendingBindings:)
+                         target: [GSKeyValueBinding class]
+                       argument: nil
+                          order: 599999
+                          modes: flushModes];
+            }
+          else
+            {
+              [[GSKeyValueBinding class]
+                performSelectorOnMainThread: @selector(_flushPendingBindings:)
+                                 withObject: nil
+                              waitUntilDone: NO];
+            }
+        }
+    }
+  [bindingLock unlock];
+  return (batched || coalesces);
+}
+
 - (void) reverseSetValue: (id)value
 {
   NSString *keyPath;
@@ -372,7 +560,7 @@ void GSBindingInvokeAction(NSString *targetKey, NSString *argumentKey,
   NSDictionary *options;
   id newValue;
 
-  if (change != nil)
+  if (change != nil && ![self holdsBackChangeFor: binding])
     {
       options = [info objectForKey: NSOptionsKey];
       newValue = [change objectForKey: NSKeyValueChangeNewKey];
@@ -490,9 +678,12 @@ void GSBindingInvokeAction(NSString *targetKey, NSString *argumentKey,
     return;
 
  [bindingLock lock];
-  bindings = (NSDictionary *)NSMapGet(objectTable, (void *)src);
+  bindings = bindingsForObject(src);
   if (!bindings)
-    return;
+    {
+      [bindingLock unlock];
+      return;
+    }
 
   res = GSBindingResolveMultipleValueBool(binding, bindings,
                                           GSBindingOperationOr);
@@ -505,7 +696,10 @@ void GSBindingInvokeAction(NSString *targetKey, NSString *argumentKey,
                          change: (NSDictionary *)change
                         context: (void *)context
 {
-  [self setValueFor: (NSString*)context];
+  if (![self holdsBackChangeFor: (NSString*)context])
+    {
+      [self setValueFor: (NSString*)context];
+    }
 }
 
 @end
@@ -521,9 +715,12 @@ void GSBindingInvokeAction(NSString *targetKey, NSString *argumentKey,
     return;
 
   [bindingLock lock];
-  bindings = (NSDictionary *)NSMapGet(objectTable, (void *)src);
+  bindings = bindingsForObject(src);
   if (!bindings)
-    return;
+    {
+      [bindingLock unlock];
+      return;
+    }
 
   res = GSBindingResolveMultipleValueBool(binding, bindings,
                                           GSBindingOperationAnd);
@@ -536,7 +733,10 @@ void GSBindingInvokeAction(NSString *targetKey, NSString *argumentKey,
                          change: (NSDictionary *)change
                         context: (void *)context
 {
-  [self setValueFor: (NSString*)context];
+  if (![self holdsBackChangeFor: (NSString*)context])
+    {
+      [self setValueFor: (NSString*)context];
+    }
 }
 
 @end
@@ -111,6 +111,7 @@ first. Remaining cases, highest priority first:
 #import "AppKit/NSAttributedString.h"
 #import "AppKit/NSBezierPath.h"
 #import "AppKit/NSColor.h"
+#import "AppKit/NSGraphics.h"
 #import "AppKit/NSImage.h"
 #import "AppKit/NSKeyValueBinding.h"
 #import "AppKit/NSLayoutManager.h"
@@ -123,6 +124,7 @@ first. Remaining cases, highest priority first:
 
 #import "GNUstepGUI/GSLayoutManager_internal.h"
 #import "GSBindingHelpers.h"
+#import "NSViewPrivate.h"
 
 
 @interface NSLayoutManager (spelling)
@@ -140,50 +142,91 @@ first. Remaining cases, highest priority first:
 @end
 
 @implementation NSLayoutManager (LayoutHelpers)
+/*
+Lays out all text containers before cindex and enough of the text
+container at cindex to cover (in the vertical direction) the point p,
+ie. until there is a line frag below p. Layout is always done from the
+start of the text, but whatever comes after p is left for later (or for
+background layout).
+*/
 -(void) _doLayoutToContainer: (NSInteger)cindex  point: (NSPoint)p
 {
-  [self _doLayout];
+  textcontainer_t *tc;
+  NSUInteger last;
+
+  if (cindex < 0 || cindex >= num_textcontainers)
+    return;
+
+  if (cindex > 0)
+    [self _doLayoutToContainer: cindex - 1];
+
+  tc = textcontainers + cindex;
+  while (!tc->complete)
+    {
+      if (tc->num_linefrags &&
+	  NSMinY(tc->linefrags[tc->num_linefrags - 1].rect) > p.y)
+	break;
+
+      last = layout_glyph;
+      [self _doLayoutToGlyph: layout_glyph];
+
+      /* The text containers may have moved. */
+      tc = textcontainers + cindex;
+      if (layout_glyph == last && !tc->complete)
+	break;
+    }
 }
 @end
 
 /**
- * Temporary attributes are implemented using an NSMutableAttributedString
- * stored in the _temporaryAttributes ivar. We only care about this attributed
- * string's attributes, not its characters, so to save space,
- * _temporaryAttributes is initialized with an instance of the following
- * NSMutableString subclass, which doesn't store any character data.
- *
- * WARNING ... it's an unofficial implementation detail that the
- * GSMutableAttributedString class creates it's internal storage by taking
- * a mutable copy of its initialisation argument, and we have a comment in
- * the source to warn about it.  If we change the behavior here, we should
- * remove the warning comment from the source in base.
+ * Temporary attributes are stored in the _temporaryAttributes ivar as a
+ * sorted array of runs covering only the characters that actually have
+ * temporary attributes. Characters between runs have none. Thus memory
+ * use and the cost of edits are proportional to the number of highlighted
+ * ranges rather than to the length of the text. Adjacent runs never have
+ * equal attributes, so the range of a run is its longest effective range.
  */
-@interface GSDummyMutableString : NSMutableString
+typedef struct {
+  NSUInteger location;
+  NSUInteger length;
+  NSDictionary *attrs;
+} GSTemporaryAttributeRun;
+
+@interface GSTemporaryAttributes : NSObject
 {
-  NSUInteger _length;
-}
-- (id)initWithLength: (NSUInteger)aLength;
+  GSTemporaryAttributeRun *runs;
+  NSUInteger count;
+  NSUInteger capacity;
+  NSUInteger length;
+}
+- (id) initWithLength: (NSUInteger)aLength;
+- (NSUInteger) runCount;
+- (NSDictionary *) attributesAtIndex: (NSUInteger)index
+		      effectiveRange: (NSRange *)range;
+- (id) attribute: (NSString *)attr
+	 atIndex: (NSUInteger)index
+  effectiveRange: (NSRange *)range;
+- (id) attribute: (NSString *)attr
+	 atIndex: (NSUInteger)index
+longestEffectiveRange: (NSRange *)longestRange
+	 inRange: (NSRange)range;
+- (void) setAttributes: (NSDictionary *)attrs range: (NSRange)range;
+- (void) addAttributes: (NSDictionary *)attrs range: (NSRange)range;
+- (void) addAttribute: (NSString *)attr value: (id)value range: (NSRange)range;
+- (void) removeAttribute: (NSString *)attr range: (NSRange)range;
+/* Replaces the characters in range with aLength characters that have no
+   temporary attributes. */
+- (void) replaceCharactersInRange: (NSRange)range withLength: (NSUInteger)aLength;
 @end
 
-/* Helper for searching for the line frag of a glyph. */
+/* Helper for searching for the line frag of a glyph. Glyphs after the
+   last line frag map to the last line frag. */
 #define LINEFRAG_FOR_GLYPH(glyph) \
   do { \
-    NSInteger lo, hi, mid; \
-\
-    lf = tc->linefrags; \
-    for (lo = 0, hi = tc->num_linefrags - 1; lo < hi;) \
-      { \
-	mid = (lo + hi) / 2; \
-	if (lf[mid].pos > glyph) \
-	  hi = mid - 1; \
-	else if (lf[mid].pos + lf[mid].length <= glyph) \
-	  lo = mid + 1; \
-	else \
-	  lo = hi = mid; \
-      } \
-    lf = &lf[lo]; \
-    i = lo; \
+    i = GSLinefragIndexForGlyph(tc, glyph); \
+    if (i == tc->num_linefrags && i > 0) \
+      i--; \
+    lf = &tc->linefrags[i]; \
   } while (0)
 
 
@@ -296,7 +339,49 @@ container? necessary? */
 
   num_rects = 0;
 
-  LINEFRAG_FOR_GLYPH(glyphRange.location);
+  /*
+  The rects of the last call are kept in rect_array. Dragging a selection
+  asks for the same range, or for a range with the same start and a
+  different end, over and over, so we reuse the cached rects when the layout
+  hasn't changed since, and only recompute the rects from the line where
+  the old and new ranges start to differ.
+  */
+  if (rect_cache_count > 0
+      && rect_cache_container == container
+      && rect_cache_generation == layout_generation
+      && rect_cache_range.location == glyphRange.location)
+    {
+      if (rect_cache_range.length == glyphRange.length)
+	{
+	  *rectCount = rect_cache_count;
+	  return rect_array;
+	}
+
+      LINEFRAG_FOR_GLYPH(MIN(last, NSMaxRange(rect_cache_range)) - 1);
+      while (lf > tc->linefrags && lf[-1].rect.origin.y == lf->rect.origin.y)
+	lf--;
+
+      if (lf->pos > glyphRange.location)
+	{
+	  /* Keep the rects of the lines above this one. */
+	  CGFloat y = lf->rect.origin.y;
+
+	  num_rects = rect_cache_count;
+	  while (num_rects > 0 && rect_array[num_rects - 1].origin.y >= y)
+	    num_rects--;
+	  if (num_rects > 0 && NSMaxY(rect_array[num_rects - 1]) > y)
+	    {
+	      rect_array[num_rects - 1].size.height =
+		y - rect_array[num_rects - 1].origin.y;
+	    }
+	}
+    }
+  rect_cache_count = 0;
+
+  if (num_rects == 0)
+    {
+      LINEFRAG_FOR_GLYPH(glyphRange.location);
+    }
 
   /* Main loop. Work through all line frag rects and build the array of
   rects. */
@@ -446,6 +531,11 @@ container? necessary? */
       lf++;
     }
 
+  rect_cache_container = container;
+  rect_cache_range = glyphRange;
+  rect_cache_generation = layout_generation;
+  rect_cache_count = num_rects;
+
   *rectCount = num_rects;
   return rect_array;
 }
@@ -497,10 +587,13 @@ line frag rect. */
 }
 
 
--(NSRange) glyphRangeForBoundingRect: (NSRect)bounds
-		     inTextContainer: (NSTextContainer *)container
+/*
+Return the range of the glyphs in bounds among those already laid out in
+the text container at index i.
+*/
+-(NSRange) _glyphRangeForBoundingRect: (NSRect)bounds
+		   textContainerIndex: (NSInteger)i
 {
-  NSInteger i;
   NSUInteger j;
   NSInteger low, high, mid;
   textcontainer_t *tc;
@@ -508,19 +601,6 @@ line frag rect. */
 
   NSRange range;
 
-
-  for (tc = textcontainers, i = 0; i < num_textcontainers; i++, tc++)
-    if (tc->textContainer == container)
-      break;
-  if (i == num_textcontainers)
-    {
-      NSLog(@"%s: invalid text container", __PRETTY_FUNCTION__);
-      return NSMakeRange(0, 0);
-    }
-
-  [self _doLayoutToContainer: i
-    point: NSMakePoint(NSMaxX(bounds), NSMaxY(bounds))];
-
   tc = textcontainers + i;
 
   if (!tc->num_linefrags)
@@ -607,19 +687,43 @@ line frag rect. */
   return range;
 }
 
+-(NSRange) glyphRangeForBoundingRect: (NSRect)bounds
+		     inTextContainer: (NSTextContainer *)container
+{
+  NSInteger i;
+  textcontainer_t *tc;
+
+  for (tc = textcontainers, i = 0; i < num_textcontainers; i++, tc++)
+    if (tc->textContainer == container)
+      break;
+  if (i == num_textcontainers)
+    {
+      NSLog(@"%s: invalid text container", __PRETTY_FUNCTION__);
+      return NSMakeRange(0, 0);
+    }
+
+  [self _doLayoutToContainer: i
+    point: NSMakePoint(NSMaxX(bounds), NSMaxY(bounds))];
+
+  return [self _glyphRangeForBoundingRect: bounds textContainerIndex: i];
+}
+
 -(NSRange) glyphRangeForBoundingRectWithoutAdditionalLayout: (NSRect)bounds
 					    inTextContainer: (NSTextContainer *)container
 {
-  /* TODO: this should be the same as
-  -glyphRangeForBoundingRect:inTextContainer: but without the _doLayout...
-  call.
+  NSInteger i;
+  textcontainer_t *tc;
 
-  In other words, it returns the range of glyphs in the rect that have
-  already been laid out.
-  */
+  for (tc = textcontainers, i = 0; i < num_textcontainers; i++, tc++)
+    if (tc->textContainer == container)
+      break;
+  if (i == num_textcontainers)
+    {
+      NSLog(@"%s: invalid text container", __PRETTY_FUNCTION__);
+      return NSMakeRange(0, 0);
+    }
 
-  return [self glyphRangeForBoundingRect: bounds
-	       inTextContainer: container];
+  return [self _glyphRangeForBoundingRect: bounds textContainerIndex: i];
 }
 
 
@@ -662,8 +766,10 @@ anything visible
   tc = textcontainers + i;
 
   /* Find the line frag rect that contains the point, and handle the case
-  where the point isn't inside a line frag rect. */
-  for (i = 0, lf = tc->linefrags; i < tc->num_linefrags; i++, lf++)
+  where the point isn't inside a line frag rect. Line frags that end
+  above the point can't match, so skip them. */
+  i = GSLinefragIndexForMaxY(tc, point.y);
+  for (lf = tc->linefrags + i; i < tc->num_linefrags; i++, lf++)
     {
       /* The point is inside a rect; we're done. */
       if (NSPointInRect(point, lf->rect))
@@ -1137,11 +1243,16 @@ has the same y origin and height as the line frag rect it is in.
 
       tc = &textcontainers[from_tc];
       /* Find first line frag rect on the from line. */
-      for (i = 0, lf = tc->linefrags; i < tc->num_linefrags; i++, lf++)
+      i = GSLinefragIndexAfterMinY(tc, from_rect.origin.y);
+      if (i > 0 && tc->linefrags[i - 1].rect.origin.y == from_rect.origin.y)
 	{
-	  if (lf->rect.origin.y == from_rect.origin.y)
-	    break;
+	  while (i > 0
+		 && tc->linefrags[i - 1].rect.origin.y == from_rect.origin.y)
+	    i--;
 	}
+      else
+	i = tc->num_linefrags;
+      lf = tc->linefrags + i;
 
       /* If we don't have a line frag rect that matches the from position,
       the from position is probably on the last line, in the extra rect,
@@ -1157,7 +1268,10 @@ has the same y origin and height as the line frag rect it is in.
 	  tc = textcontainers + from_tc;
 	  /* Find the target line. Move at least (should be up to?)
 	  distance, and at least one line. */
-	  for (; i < tc->num_linefrags; i++, lf++)
+	  if (i < tc->num_linefrags)
+	    i = MAX(i, GSLinefragIndexForMaxY(tc,
+	      distance + NSMaxY(from_rect)));
+	  for (lf = tc->linefrags + i; i < tc->num_linefrags; i++, lf++)
 	    if (NSMaxY(lf->rect) >= distance + NSMaxY(from_rect) &&
 	        NSMinY(lf->rect) != NSMinY(from_rect))
 	      break;
@@ -1179,11 +1293,11 @@ has the same y origin and height as the line frag rect it is in.
 	}
       else
 	{
-	  if (i == tc->num_linefrags)
-	    i--, lf--;
 	  /* Find the target line. Move at least (should be up to?)
 	  distance, and at least one line. */
-	  for (; i >= 0; i--, lf--)
+	  i = MIN(i, GSLinefragIndexAfterMinY(tc,
+	    NSMinY(from_rect) - distance)) - 1;
+	  for (lf = tc->linefrags + i; i >= 0; i--, lf--)
 	    if (NSMinY(lf->rect) <= NSMinY(from_rect) - distance &&
 	        NSMinY(lf->rect) != NSMinY(from_rect))
 	      break;
@@ -1332,11 +1446,18 @@ has the same y origin and height as the line frag rect it is in.
 
 - (BOOL) allowsNonContiguousLayout
 {
-  return NO;
+  return _allowsNonContiguousLayout;
 }
 
+/*
+Layout is done lazily; methods that work on a rectangle or a point only lay
+out the text up to that point, and the rest can be filled in by background
+layout (see -setBackgroundLayoutEnabled:). The laid out text is always a
+contiguous range starting at the beginning of the text, though.
+*/
 - (void) setAllowsNonContiguousLayout: (BOOL)flag;
 {
+  _allowsNonContiguousLayout = flag;
 }
 
 - (BOOL) hasNonContiguousLayout;
@@ -1450,6 +1571,48 @@ container
 	break;
     }
 
+  /* Temporary background colors, used e.g. to highlight search results. */
+  if (_temporaryAttributes != nil && [_temporaryAttributes runCount] > 0)
+    {
+      NSRange charRange = NSMakeRange(first_char_pos, char_pos - first_char_pos);
+      NSUInteger c = charRange.location;
+
+      while (c < NSMaxRange(charRange))
+	{
+	  NSRange cr;
+
+	  color = [self temporaryAttribute: NSBackgroundColorAttributeName
+			  atCharacterIndex: c
+		     longestEffectiveRange: &cr
+				   inRange: charRange];
+	  if (cr.length == 0)
+	    break;
+	  if (color)
+	    {
+	      NSRange r = [self glyphRangeForCharacterRange: cr
+				       actualCharacterRange: NULL];
+
+	      r = NSIntersectionRange(r, range);
+	      rects = [self rectArrayForGlyphRange: r
+			  withinSelectedGlyphRange: NSMakeRange(NSNotFound, 0)
+				   inTextContainer: textContainer
+					 rectCount: &count];
+	      if (count)
+		{
+		  [color set];
+		  for (j = 0; j < count; j++, rects++)
+		    {
+		      DPSrectfill(ctxt,
+				  rects->origin.x + containerOrigin.x,
+				  rects->origin.y + containerOrigin.y,
+				  rects->size.width, rects->size.height);
+		    }
+		}
+	    }
+	  c = NSMaxRange(cr);
+	}
+    }
+
   if (!_selected_range.length || _selected_range.location == NSNotFound)
     return;
 
@@ -1534,6 +1697,172 @@ attachmentSize(linefrag_t *lf, NSUInteger glyphIndex)
   return la->size;
 }
 
+/*
+ * The underlines of a draw pass are collected as the rects covered by
+ * their dashes, one list for each color, and each list is filled with
+ * one call at the end of the pass instead of stroking a path for every
+ * attribute run and line fragment.
+ */
+#define MAX_DECORATION_COLORS 8
+
+typedef struct {
+  BOOL collecting;
+  NSUInteger numColors;
+  NSColor *colors[MAX_DECORATION_COLORS];
+  NSRect *rects[MAX_DECORATION_COLORS];
+  NSUInteger counts[MAX_DECORATION_COLORS];
+  NSUInteger capacities[MAX_DECORATION_COLORS];
+} GSDecorations;
+
+static GS_THREAD_LOCAL GSDecorations decorations;
+
+static void GSFlushDecorations(void)
+{
+  NSUInteger i;
+
+  for (i = 0; i < decorations.numColors; i++)
+    {
+      [decorations.colors[i] set];
+      NSRectFillList(decorations.rects[i], decorations.counts[i]);
+      decorations.counts[i] = 0;
+      DESTROY(decorations.colors[i]);
+    }
+  decorations.numColors = 0;
+}
+
+static void GSAddDecorationRect(NSColor *color, NSRect rect)
+{
+  NSUInteger i;
+
+  for (i = 0; i < decorations.numColors; i++)
+    {
+      if (decorations.colors[i] == color
+	|| [decorations.colors[i] isEqual: color])
+	break;
+    }
+  if (i == decorations.numColors)
+    {
+      if (i == MAX_DECORATION_COLORS)
+	{
+	  GSFlushDecorations();
+	  i = 0;
+	}
+      decorations.colors[i] = RETAIN(color);
+      decorations.numColors++;
+    }
+  if (decorations.counts[i] == decorations.capacities[i])
+    {
+      decorations.capacities[i] = 2 * decorations.capacities[i] + 16;
+      decorations.rects[i] = NSZoneRealloc(NSDefaultMallocZone(),
+	decorations.rects[i], decorations.capacities[i] * sizeof(NSRect));
+    }
+  decorations.rects[i][decorations.counts[i]++] = rect;
+}
+
+/* Draws a line from start to end in color, as a path with the given
+   thickness and dash pattern of count lengths starting phase into it
+   would be stroked.  A horizontal line, which all underlines are unless
+   the baseline moves within them, becomes the rects of its dashes.  */
+static void GSDrawLine(NSColor *color, NSPoint start, NSPoint end,
+		       CGFloat thickness, const CGFloat *pattern,
+		       NSInteger count, CGFloat phase)
+{
+  CGFloat period = 0.0;
+  CGFloat pos;
+  CGFloat x;
+  NSInteger i;
+
+  for (i = 0; i < count; i++)
+    {
+      period += pattern[i];
+    }
+
+  if (start.y != end.y || end.x < start.x
+    || (count > 0 && period < 1.0))
+    {
+      NSBezierPath *path = [NSBezierPath bezierPath];
+
+      if (count > 0)
+	{
+	  [path setLineDash: pattern count: count phase: phase];
+	}
+      [path setLineWidth: thickness];
+      [path moveToPoint: start];
+      [path lineToPoint: end];
+      [color set];
+      [path stroke];
+      return;
+    }
+
+  if (count == 0)
+    {
+      GSAddDecorationRect(color, NSMakeRect(start.x, start.y - thickness / 2,
+	end.x - start.x, thickness));
+    }
+  else
+    {
+      /* Find the dash or gap at the start, then add a rect for each dash
+	 up to the end.  */
+      pos = fmod(phase, period);
+      if (pos < 0)
+	{
+	  pos += period;
+	}
+      i = 0;
+      while (pos >= pattern[i])
+	{
+	  pos -= pattern[i];
+	  i = (i + 1) % count;
+	}
+      for (x = start.x; x < end.x; )
+	{
+	  CGFloat next = MIN(x + pattern[i] - pos, end.x);
+
+	  if (i % 2 == 0)
+	    {
+	      GSAddDecorationRect(color, NSMakeRect(x, start.y - thickness / 2,
+		next - x, thickness));
+	    }
+	  x = next;
+	  pos = 0;
+	  i = (i + 1) % count;
+	}
+    }
+
+  if (decorations.collecting == NO)
+    {
+      GSFlushDecorations();
+    }
+}
+
+static void GSDrawPatternLine(NSColor *color, NSPoint start, NSPoint end, NSInteger pattern, CGFloat thickness, CGFloat phase)
+{
+  if ((pattern & NSUnderlinePatternDot) == NSUnderlinePatternDot)
+    {
+      const CGFloat dot[2] = {2.5 * thickness, 2.5 * thickness};
+      GSDrawLine(color, start, end, thickness, dot, 2, phase);
+    }
+  else if ((pattern & NSUnderlinePatternDash) == NSUnderlinePatternDash)
+    {
+      const CGFloat dash[2] = {10 * thickness, 5 * thickness};   
+      GSDrawLine(color, start, end, thickness, dash, 2, phase);
+    }
+  else if ((pattern & NSUnderlinePatternDashDot) == NSUnderlinePatternDashDot)
+    {
+      const CGFloat dashdot[4] = {10 * thickness, 3 * thickness, 3 * thickness, 3 * thickness};
+      GSDrawLine(color, start, end, thickness, dashdot, 4, phase);
+    }
+  else if ((pattern & NSUnderlinePatternDashDotDot) == NSUnderlinePatternDashDotDot)
+    {
+      const CGFloat dashdotdot[6] = {10 * thickness, 3 * thickness, 3 * thickness, 3 * thickness, 3 * thickness, 3 * thickness};
+      GSDrawLine(color, start, end, thickness, dashdotdot, 6, phase);
+    }
+  else
+    {
+      GSDrawLine(color, start, end, thickness, NULL, 0, phase);
+    }
+}
+
 - (NSSize) attachmentSizeForGlyphAtIndex: (NSUInteger)glyphIndex
 {
   textcontainer_t *tc;
@@ -1598,11 +1927,14 @@ attachmentSize(linefrag_t *lf, NSUInteger glyphIndex)
   NSColor *link_color = nil;
   id linkValue;
  
-#define GBUF_SIZE 16 /* TODO: tweak */
+  /* Room for a long line, so that a line of glyphs in one font and color
+     usually goes to the backend in one call.  */
+#define GBUF_SIZE 256
   NSGlyph gbuf[GBUF_SIZE];
   NSSize advancementbuf[GBUF_SIZE];
   NSInteger gbuf_len, gbuf_size;
   NSPoint gbuf_point = NSZeroPoint;
+  NSSize advancement;
 
   if (!range.length)
     return;
@@ -1731,13 +2063,8 @@ attachmentSize(linefrag_t *lf, NSUInteger glyphIndex)
 
       if (g == lp->pos + lp->length)
 	{
-	  if (gbuf_len)
-	    {
-	      DPSmoveto(ctxt, gbuf_point.x, gbuf_point.y);
-	      GSShowGlyphsWithAdvances(ctxt, gbuf, advancementbuf, gbuf_len);
-	      DPSnewpath(ctxt);
-	      gbuf_len = 0;
-	    }
+	  NSPoint next;
+
 	  j++;
 	  lp++;
 	  if (j == lf->num_points)
@@ -1747,9 +2074,20 @@ attachmentSize(linefrag_t *lf, NSUInteger glyphIndex)
 	      j = 0;
 	      lp = lf->points;
 	    }
-	  p = lp->p;
-	  p.x += lf->rect.origin.x + containerOrigin.x;
-	  p.y += lf->rect.origin.y + containerOrigin.y;
+	  next = lp->p;
+	  next.x += lf->rect.origin.x + containerOrigin.x;
+	  next.y += lf->rect.origin.y + containerOrigin.y;
+
+	  /* The glyphs buffered so far can only be continued by glyphs
+	     which start where they end.  */
+	  if (gbuf_len && NSEqualPoints(next, p) == NO)
+	    {
+	      DPSmoveto(ctxt, gbuf_point.x, gbuf_point.y);
+	      GSShowGlyphsWithAdvances(ctxt, gbuf, advancementbuf, gbuf_len);
+	      DPSnewpath(ctxt);
+	      gbuf_len = 0;
+	    }
+	  p = next;
 	}
       if (g == glyph_pos + glyph_run->head.glyph_length)
 	{
@@ -1782,6 +2120,10 @@ attachmentSize(linefrag_t *lf, NSUInteger glyphIndex)
 	   * not drawing using the selected text color) then we must flush
 	   * any buffered glyphs and set the new font and color.
 	   */
+	  if (run_color != color && [run_color isEqual: color])
+	    {
+	      run_color = color;
+	    }
 	  if (glyph_run->font != f
 	    || (currentGlyphIsSelected == NO && run_color != color))
 	    {
@@ -1846,6 +2188,7 @@ attachmentSize(linefrag_t *lf, NSUInteger glyphIndex)
 		}
 	      continue;
 	    }
+	  advancement = [f advancementForGlyph: glyph->g];
 	  if (g >= range.location)
 	    {
 	      if (!gbuf_len)
@@ -1865,11 +2208,11 @@ attachmentSize(linefrag_t *lf, NSUInteger glyphIndex)
 		      gbuf_point = p;
 		    }
 		  gbuf[gbuf_len] = glyph->g;
-		  advancementbuf[gbuf_len] = [f advancementForGlyph: glyph->g];
+		  advancementbuf[gbuf_len] = advancement;
 		  gbuf_len++;
 		}
 	    }
-	  p.x += [f advancementForGlyph: glyph->g].width;
+	  p.x += advancement.width;
 	}
     }
   if (gbuf_len)
@@ -1886,6 +2229,7 @@ for (i = 0; i < gbuf_len; i++) printf("   %3i : %04x\n", i, gbuf[i]); */
 
   // Draw underline where necessary
   // FIXME: Also draw strikeout
+  decorations.collecting = YES;
   {
     const NSRange characterRange = [self characterRangeForGlyphRange: range
 						    actualGlyphRange: NULL];
@@ -1984,6 +2328,8 @@ for (i = 0; i < gbuf_len; i++) printf("   %3i : %04x\n", i, gbuf[i]); */
 	  }
       }
   }
+  GSFlushDecorations();
+  decorations.collecting = NO;
 }
 
 -(void) underlineGylphRange: (NSRange)range
@@ -2026,37 +2372,6 @@ for (i = 0; i < gbuf_len; i++) printf("   %3i : %04x\n", i, gbuf[i]); */
 }
 
 
-static void GSDrawPatternLine(NSPoint start, NSPoint end, NSInteger pattern, CGFloat thickness, CGFloat phase)
-{
-  NSBezierPath *path = [NSBezierPath bezierPath];
-  // FIXME: setLineDash should take CGFloat
-  if ((pattern & NSUnderlinePatternDot) == NSUnderlinePatternDot)
-    {
-      const CGFloat dot[2] = {2.5 * thickness, 2.5 * thickness};
-      [path setLineDash: dot count: 2 phase: phase];
-    }
-  else if ((pattern & NSUnderlinePatternDash) == NSUnderlinePatternDash)
-    {
-      const CGFloat dash[2] = {10 * thickness, 5 * thickness};   
-      [path setLineDash: dash count: 2 phase: phase];
-    }
-  else if ((pattern & NSUnderlinePatternDashDot) == NSUnderlinePatternDashDot)
-    {
-      const CGFloat dashdot[4] = {10 * thickness, 3 * thickness, 3 * thickness, 3 * thickness};
-      [path setLineDash: dashdot count: 4 phase: phase];
-    }
-  else if ((pattern & NSUnderlinePatternDashDotDot) == NSUnderlinePatternDashDotDot)
-    {
-      const CGFloat dashdotdot[6] = {10 * thickness, 3 * thickness, 3 * thickness, 3 * thickness, 3 * thickness, 3 * thickness};
-      [path setLineDash: dashdotdot count: 6 phase: phase];
-    }
-
-  [path setLineWidth: thickness];
-  [path moveToPoint: start];
-  [path lineToPoint: end];
-  [path stroke];
-}
-
 -(void) drawUnderlineForGlyphRange: (NSRange)underlineRange
                      underlineType: (NSInteger)type
                     baselineOffset: (CGFloat)offset
@@ -2124,7 +2439,6 @@ static void GSDrawPatternLine(NSPoint start, NSPoint end, NSInteger pattern, CGF
 
       if (underlineColor != nil)
 	{
-	  [underlineColor set];
 	  rangeToDraw = underlineColorCharacterRange;
 	}
       else
@@ -2137,11 +2451,11 @@ static void GSDrawPatternLine(NSPoint start, NSPoint end, NSInteger pattern, CGF
 
 	  if (foregroundColor != nil)
 	    {
-	      [foregroundColor set];
+	      underlineColor = foregroundColor;
 	    }
 	  else 
 	    {
-	      [[NSColor textColor] set];
+	      underlineColor = [NSColor textColor];
 	    }
 
 	  // Draw the smaller range
@@ -2177,16 +2491,18 @@ static void GSDrawPatternLine(NSPoint start, NSPoint end, NSInteger pattern, CGF
 	  
 	  if ((type & NSUnderlineStyleDouble) == NSUnderlineStyleDouble)
 	    {
-	      GSDrawPatternLine(NSMakePoint(start.x, start.y - (underlineWidth / 2)), 
+	      GSDrawPatternLine(underlineColor,
+				NSMakePoint(start.x, start.y - (underlineWidth / 2)), 
 				NSMakePoint(end.x, end.y - (underlineWidth / 2)),
 				type, underlineWidth / 2, start.x);
-	      GSDrawPatternLine(NSMakePoint(start.x, start.y + (underlineWidth / 2)), 
+	      GSDrawPatternLine(underlineColor,
+				NSMakePoint(start.x, start.y + (underlineWidth / 2)), 
 				NSMakePoint(end.x, end.y + (underlineWidth / 2)),
 				type, underlineWidth / 2, start.x);
 	    }
 	  else
 	    {
-	      GSDrawPatternLine(start, end, type, underlineWidth, start.x);
+	      GSDrawPatternLine(underlineColor, start, end, type, underlineWidth, start.x);
 	    }
 	}
 
@@ -2204,7 +2520,6 @@ static void GSDrawPatternLine(NSPoint start, NSPoint end, NSInteger pattern, CGF
     lineFragmentGlyphRange: (NSRange)fragmentGlyphRange
 	   containerOrigin: (NSPoint)containerOrigin
 {
-  NSBezierPath *path;
   const CGFloat pattern[2] = {2.5, 1.0};
   NSFont *largestFont = [self effectiveFontForGlyphAtIndex: range.location // NOTE: GS private method
 						     range: NULL];
@@ -2225,22 +2540,9 @@ static void GSDrawPatternLine(NSPoint start, NSPoint end, NSInteger pattern, CGF
   start = NSMakePoint(start.x + containerOrigin.x + fragmentRect.origin.x, start.y + containerOrigin.y + fragmentRect.origin.y);
   end = NSMakePoint(end.x + containerOrigin.x + fragmentRect.origin.x, end.y + containerOrigin.y + fragmentRect.origin.y);
 
-  path = [NSBezierPath bezierPath];
-  [path setLineDash: pattern count: 2 phase: 0];
-  [path setLineWidth: 1.5];
-  [path moveToPoint: start];
-  [path lineToPoint: end];
-
-  if ((spellingState & NSSpellingStateGrammarFlag) != 0)
-    {
-      [[NSColor greenColor] set];
-    }
-  else
-    {
-      [[NSColor redColor] set];
-    }
-
-  [path stroke];	  
+  GSDrawLine(((spellingState & NSSpellingStateGrammarFlag) != 0)
+	     ? [NSColor greenColor] : [NSColor redColor],
+	     start, end, 1.5, pattern, 2, 0);
 }
 
 @end
@@ -2484,6 +2786,23 @@ TODO: not really clear what these should do
 }
 
 
+-(void) _didLayoutGlyphRange: (NSRange)glyphRange
+{
+  NSInteger i;
+
+  for (i = 0; i < num_textcontainers; i++)
+    {
+      textcontainer_t *tc = textcontainers + i;
+      NSRange r = NSIntersectionRange(glyphRange,
+				      NSMakeRange(tc->pos, tc->length));
+
+      if (r.length == 0)
+	continue;
+      [[tc->textContainer textView] _layoutManagerDidLayoutGlyphRange: r];
+    }
+}
+
+
 -(void) _dumpLayout
 {
     NSInteger i, j, k;
@@ -2556,28 +2875,11 @@ this file describes this.
 
   if (_temporaryAttributes != nil && (mask & NSTextStorageEditedCharacters) != 0)
     {
-      NSInteger i;
-      NSArray *attrs;
       NSRange oldRange = NSMakeRange(range.location, range.length - lengthChange);
 
-      NSString *replacementString = [[GSDummyMutableString alloc] initWithLength: range.length];
+      // The replaced characters don't get any temporary attributes
       [_temporaryAttributes replaceCharactersInRange: oldRange
-					  withString: replacementString];
-      [replacementString release];
-      
-      // In addition, clear any temporary attributes that may have been extended
-      // over the affected range
-
-      if (range.length > 0)
-	{
-	  attrs = [[self temporaryAttributesAtCharacterIndex: range.location
-					      effectiveRange: NULL] allKeys];
-	  for (i=0; i<[attrs count]; i++)
-	    {
-	      [self removeTemporaryAttribute: [attrs objectAtIndex: i]
-			   forCharacterRange: range];
-	    }
-	}
+					  withLength: range.length];
     }
 
   [self invalidateGlyphsForCharacterRange: invalidatedRange
@@ -2769,7 +3071,10 @@ this file describes this.
 	}
 
       if (j == num_textcontainers)
-	goto no_soft_invalidation;
+	{
+	  GS_LAYOUT_COUNT(hard_invalidations, 1);
+	  goto no_soft_invalidation;
+	}
 
       if (new_num != i)
 	{
@@ -2784,6 +3089,7 @@ this file describes this.
 	}
       tc->num_soft += tc->num_linefrags - new_num;
       tc->num_linefrags = new_num;
+      GS_LAYOUT_COUNT(soft_invalidations, 1);
       tc->was_invalidated = YES;
       tc->complete = NO;
       if (new_num)
@@ -2840,18 +3146,96 @@ no_soft_invalidation:
     }
   else
     {
-      int i, j;
+      NSInteger i, j, k, end;
       linefrag_t *lf;
-      textcontainer_t *tc;
-      /*
-      TODO: could handle this better, but it should be a rare case,
-      handling it efficiently is tricky.
+      textcontainer_t *tc, *prev_tc;
+      NSUInteger glyph_index = 0;
+      BOOL keep = NO;
 
-      For now, we simply clear out all soft invalidation information.
+      /*
+      The change is beyond the hard layout. This happens when the text is
+      changed several times without layout in between, eg. when replacing
+      all occurrences of a string.
+
+      Soft invalidated line frags for glyphs before the change are still
+      valid, except for the line containing the change and the line before
+      it, so we keep them and let the typesetter reuse them. Everything
+      from there on is cleared out.
       */
       for (i = 0, tc = textcontainers; i < num_textcontainers; i++, tc++)
 	{
-	  for (j = 0, lf = tc->linefrags + tc->num_linefrags; j < tc->num_soft; j++, lf++)
+	  if (tc->num_soft)
+	    {
+	      keep = r.location > 0;
+	      break;
+	    }
+	}
+      if (keep)
+	{
+	  if (r.location >= [_textStorage length])
+	    glyph_index = [self numberOfGlyphs];
+	  else
+	    glyph_index = [self glyphRangeForCharacterRange: NSMakeRange(r.location, 1)
+				       actualCharacterRange: NULL].location;
+	}
+
+      prev_tc = NULL;
+      for (i = 0, tc = textcontainers; i < num_textcontainers; i++, tc++)
+	{
+	  /* j is the first soft line frag we don't keep. */
+	  j = tc->num_linefrags;
+	  end = tc->num_linefrags + tc->num_soft;
+	  if (keep && tc->num_soft)
+	    {
+	      for (lf = tc->linefrags + j; j < end; j++, lf++)
+		if (lf->pos + lf->length > glyph_index)
+		  break;
+
+	      if (j < end)
+		{
+		  /* Back up to the first line frag on this line. */
+		  while (j > tc->num_linefrags && lf[-1].rect.origin.y == lf->rect.origin.y)
+		    j--, lf--;
+		  if (j > tc->num_linefrags)
+		    {
+		      /* And to the first line frag on the previous line. */
+		      j--, lf--;
+		      while (j > tc->num_linefrags && lf[-1].rect.origin.y == lf->rect.origin.y)
+			j--, lf--;
+		    }
+		  else if (prev_tc)
+		    {
+		      /* The previous line is in an earlier text container. */
+		      NSInteger first;
+
+		      first = prev_tc->num_linefrags + prev_tc->num_soft - 1;
+		      lf = prev_tc->linefrags + first;
+		      while (first > prev_tc->num_linefrags && lf[-1].rect.origin.y == lf->rect.origin.y)
+			first--, lf--;
+		      for (k = first; k < prev_tc->num_linefrags + prev_tc->num_soft; k++, lf++)
+			{
+			  if (lf->points)
+			    {
+			      free(lf->points);
+			      lf->points = NULL;
+			    }
+			  if (lf->attachments)
+			    {
+			      free(lf->attachments);
+			      lf->attachments = NULL;
+			    }
+			}
+		      prev_tc->num_soft = first - prev_tc->num_linefrags;
+		    }
+		  keep = NO;
+		}
+	      else
+		{
+		  prev_tc = tc;
+		}
+	    }
+
+	  for (k = j, lf = tc->linefrags + j; k < end; k++, lf++)
 	    {
 	      if (lf->points)
 		{
@@ -2864,7 +3248,7 @@ no_soft_invalidation:
 		  lf->attachments = NULL;
 		}
 	    }
-	  tc->num_soft = 0;
+	  tc->num_soft = j - tc->num_linefrags;
 	  if (tc->pos + tc->length == r.location)
 	    {
 	      tc->complete = NO;
@@ -3011,47 +3395,346 @@ no_soft_invalidation:
 @end
 
 
-@implementation GSDummyMutableString
-- (id)initWithLength: (NSUInteger)aLength
+@implementation GSTemporaryAttributes
+
+static NSDictionary *emptyAttributes = nil;
+
++ (void) initialize
+{
+  if (emptyAttributes == nil)
+    emptyAttributes = [NSDictionary new];
+}
+
+- (id) initWithLength: (NSUInteger)aLength
 {
-  self = [super init];
-  if (self != nil)
+  if ((self = [super init]) != nil)
     {
-      self->_length = aLength;
+      length = aLength;
     }
   return self;
 }
-- (NSUInteger)length
+
+- (void) dealloc
 {
-  return _length;
+  NSUInteger i;
+
+  for (i = 0; i < count; i++)
+    RELEASE(runs[i].attrs);
+  if (runs != NULL)
+    NSZoneFree(NSDefaultMallocZone(), runs);
+  [super dealloc];
 }
-- (unichar)characterAtIndex: (NSUInteger)index
+
+- (NSUInteger) runCount
 {
-  return 0;
+  return count;
 }
-- (void)replaceCharactersInRange:(NSRange)range withString:(NSString *)aString
+
+/* Returns the index of the first run that ends after index. */
+- (NSUInteger) _runAfterIndex: (NSUInteger)index
 {
-  _length = (_length - range.length) + [aString length];
+  NSUInteger lo = 0, hi = count;
+
+  while (lo < hi)
+    {
+      NSUInteger mid = (lo + hi) / 2;
+
+      if (runs[mid].location + runs[mid].length <= index)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  return lo;
 }
-- (id) copyWithZone: (NSZone*)zone
+
+- (void) _insertRuns: (NSUInteger)n atIndex: (NSUInteger)i
 {
-  return [self mutableCopyWithZone: zone];
+  if (count + n > capacity)
+    {
+      capacity = (count + n) * 2;
+      if (capacity < 8)
+	capacity = 8;
+      runs = NSZoneRealloc(NSDefaultMallocZone(), runs,
+			   capacity * sizeof(GSTemporaryAttributeRun));
+    }
+  memmove(runs + i + n, runs + i, (count - i) * sizeof(GSTemporaryAttributeRun));
+  count += n;
+}
+
+- (void) _removeRuns: (NSUInteger)n atIndex: (NSUInteger)i
+{
+  NSUInteger j;
+
+  for (j = i; j < i + n; j++)
+    RELEASE(runs[j].attrs);
+  memmove(runs + i, runs + i + n,
+	  (count - i - n) * sizeof(GSTemporaryAttributeRun));
+  count -= n;
 }
-- (id) mutableCopyWithZone: (NSZone*)zone
+
+/* Merges the run at i with its successor if they touch and are equal. */
+- (void) _coalesceAtIndex: (NSUInteger)i
 {
-  return [[GSDummyMutableString allocWithZone: zone] initWithLength: _length];
+  if (i + 1 < count
+      && runs[i].location + runs[i].length == runs[i + 1].location
+      && [runs[i].attrs isEqualToDictionary: runs[i + 1].attrs])
+    {
+      runs[i].length += runs[i + 1].length;
+      [self _removeRuns: 1 atIndex: i + 1];
+    }
 }
+
+/*
+Removes all attributes from range, splitting runs that extend beyond it.
+Returns the index at which runs for range would have to be inserted.
+*/
+- (NSUInteger) _clearRange: (NSRange)range
+{
+  NSUInteger end = NSMaxRange(range);
+  NSUInteger i = [self _runAfterIndex: range.location];
+  NSUInteger j;
+
+  if (i < count && runs[i].location < range.location
+      && runs[i].location + runs[i].length > end)
+    {
+      /* The range is inside a single run; split it in two. */
+      [self _insertRuns: 1 atIndex: i + 1];
+      runs[i + 1].location = end;
+      runs[i + 1].length = runs[i].location + runs[i].length - end;
+      runs[i + 1].attrs = RETAIN(runs[i].attrs);
+      runs[i].length = range.location - runs[i].location;
+      return i + 1;
+    }
+
+  if (i < count && runs[i].location < range.location)
+    {
+      runs[i].length = range.location - runs[i].location;
+      i++;
+    }
+  for (j = i; j < count && runs[j].location + runs[j].length <= end; j++)
+    ;
+  [self _removeRuns: j - i atIndex: i];
+  if (i < count && runs[i].location < end)
+    {
+      runs[i].length -= end - runs[i].location;
+      runs[i].location = end;
+    }
+  return i;
+}
+
+- (NSDictionary *) attributesAtIndex: (NSUInteger)index
+		      effectiveRange: (NSRange *)range
+{
+  NSUInteger i = [self _runAfterIndex: index];
+
+  if (index >= length)
+    {
+      [NSException raise: NSRangeException
+		  format: @"index %lu beyond length %lu",
+		   (unsigned long)index, (unsigned long)length];
+    }
+
+  if (i < count && runs[i].location <= index)
+    {
+      if (range)
+	*range = NSMakeRange(runs[i].location, runs[i].length);
+      return runs[i].attrs;
+    }
+
+  /* A gap between runs. */
+  if (range)
+    {
+      NSUInteger start = (i > 0) ? runs[i - 1].location + runs[i - 1].length : 0;
+      NSUInteger end = (i < count) ? runs[i].location : length;
+
+      *range = NSMakeRange(start, end - start);
+    }
+  return emptyAttributes;
+}
+
+- (id) attribute: (NSString *)attr
+	 atIndex: (NSUInteger)index
+  effectiveRange: (NSRange *)range
+{
+  return [[self attributesAtIndex: index effectiveRange: range]
+	   objectForKey: attr];
+}
+
+- (id) attribute: (NSString *)attr
+	 atIndex: (NSUInteger)index
+longestEffectiveRange: (NSRange *)longestRange
+	 inRange: (NSRange)range
+{
+  NSRange r;
+  id value = [self attribute: attr atIndex: index effectiveRange: &r];
+
+  if (longestRange)
+    {
+      NSUInteger start = r.location;
+      NSUInteger end = NSMaxRange(r);
+      NSRange next;
+      id v;
+
+      while (start > range.location)
+	{
+	  v = [self attribute: attr atIndex: start - 1 effectiveRange: &next];
+	  if (v != value && ![v isEqual: value])
+	    break;
+	  start = next.location;
+	}
+      while (end < NSMaxRange(range))
+	{
+	  v = [self attribute: attr atIndex: end effectiveRange: &next];
+	  if (v != value && ![v isEqual: value])
+	    break;
+	  end = NSMaxRange(next);
+	}
+      *longestRange = NSIntersectionRange(NSMakeRange(start, end - start),
+					  range);
+    }
+  return value;
+}
+
+- (void) setAttributes: (NSDictionary *)attrs range: (NSRange)range
+{
+  NSUInteger i;
+
+  if (range.length == 0)
+    return;
+  if (NSMaxRange(range) > length)
+    {
+      [NSException raise: NSRangeException
+		  format: @"range %@ beyond length %lu",
+		   NSStringFromRange(range), (unsigned long)length];
+    }
+
+  i = [self _clearRange: range];
+  if ([attrs count] == 0)
+    return;
+
+  [self _insertRuns: 1 atIndex: i];
+  runs[i].location = range.location;
+  runs[i].length = range.length;
+  runs[i].attrs = [attrs copy];
+  [self _coalesceAtIndex: i];
+  if (i > 0)
+    [self _coalesceAtIndex: i - 1];
+}
+
+/*
+Collects the runs and gaps covering range, so that they can be modified
+one at a time without disturbing the iteration.
+*/
+- (NSArray *) _segmentsInRange: (NSRange)range
+{
+  NSMutableArray *segments = [NSMutableArray array];
+  NSUInteger index = range.location;
+
+  while (index < NSMaxRange(range))
+    {
+      NSRange r;
+      NSDictionary *d = [self attributesAtIndex: index effectiveRange: &r];
+
+      r = NSIntersectionRange(r, range);
+      [segments addObject: [NSValue valueWithRange: r]];
+      [segments addObject: d];
+      index = NSMaxRange(r);
+    }
+  return segments;
+}
+
+- (void) addAttributes: (NSDictionary *)attrs range: (NSRange)range
+{
+  NSArray *segments = [self _segmentsInRange: range];
+  NSUInteger i;
+
+  for (i = 0; i < [segments count]; i += 2)
+    {
+      NSMutableDictionary *d = [[segments objectAtIndex: i + 1] mutableCopy];
+
+      [d addEntriesFromDictionary: attrs];
+      [self setAttributes: d range: [[segments objectAtIndex: i] rangeValue]];
+      RELEASE(d);
+    }
+}
+
+- (void) addAttribute: (NSString *)attr value: (id)value range: (NSRange)range
+{
+  [self addAttributes: [NSDictionary dictionaryWithObject: value forKey: attr]
+		range: range];
+}
+
+- (void) removeAttribute: (NSString *)attr range: (NSRange)range
+{
+  NSArray *segments;
+  NSUInteger i;
+
+  if (count == 0)
+    return;
+
+  segments = [self _segmentsInRange: range];
+  for (i = 0; i < [segments count]; i += 2)
+    {
+      NSDictionary *old = [segments objectAtIndex: i + 1];
+      NSMutableDictionary *d;
+
+      if ([old objectForKey: attr] == nil)
+	continue;
+      d = [old mutableCopy];
+      [d removeObjectForKey: attr];
+      [self setAttributes: d range: [[segments objectAtIndex: i] rangeValue]];
+      RELEASE(d);
+    }
+}
+
+- (void) replaceCharactersInRange: (NSRange)range withLength: (NSUInteger)aLength
+{
+  NSInteger delta = (NSInteger)aLength - (NSInteger)range.length;
+  NSUInteger i;
+
+  if (count > 0)
+    {
+      if (range.length > 0)
+	{
+	  i = [self _clearRange: range];
+	}
+      else
+	{
+	  i = [self _runAfterIndex: range.location];
+	  if (i < count && runs[i].location < range.location)
+	    {
+	      /* Inserting inside a run; the new characters split it. */
+	      [self _insertRuns: 1 atIndex: i + 1];
+	      runs[i + 1].location = range.location;
+	      runs[i + 1].length = runs[i].location + runs[i].length
+		- range.location;
+	      runs[i + 1].attrs = RETAIN(runs[i].attrs);
+	      runs[i].length = range.location - runs[i].location;
+	      i++;
+	    }
+	}
+      for (; i < count; i++)
+	runs[i].location += delta;
+      if (aLength == 0)
+	{
+	  i = [self _runAfterIndex: range.location];
+	  if (i > 0)
+	    [self _coalesceAtIndex: i - 1];
+	}
+    }
+  length += delta;
+}
+
 @end
 
 @implementation NSLayoutManager (temporaryattributes)
 
-- (NSMutableAttributedString*) _temporaryAttributes
+- (GSTemporaryAttributes*) _temporaryAttributes
 {
   if (_temporaryAttributes == nil)
     {
-      NSString *dummyString = [[GSDummyMutableString alloc] initWithLength: [[self textStorage] length]];
-      _temporaryAttributes = [[NSMutableAttributedString alloc] initWithString: dummyString];
-      [dummyString release];
+      _temporaryAttributes = [[GSTemporaryAttributes alloc]
+			       initWithLength: [[self textStorage] length]];
     }
   return _temporaryAttributes;
 }
@@ -3110,7 +3793,14 @@ no_soft_invalidation:
                                  longestEffectiveRange: (NSRange*)longestRange 
                                                inRange: (NSRange)range
 {
-  return [[self _temporaryAttributes] attributesAtIndex: index longestEffectiveRange: longestRange inRange: range];
+  // Adjacent runs never have equal attributes, so the effective range
+  // is the longest one
+  NSDictionary *attrs = [[self _temporaryAttributes] attributesAtIndex: index
+							 effectiveRange: longestRange];
+
+  if (longestRange)
+    *longestRange = NSIntersectionRange(*longestRange, range);
+  return attrs;
 }
 
 /**
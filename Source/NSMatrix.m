@@ -184,6 +184,9 @@ static inline MPoint MakePoint (int x, int y)
 					 column: (NSInteger)column;
 - (void) _setKeyRow: (NSInteger) row
              column: (NSInteger) column;
+- (id) _realCellAtRow: (NSInteger)row
+               column: (NSInteger)column;
+- (void) _makeLazyCellsReal;
 @end
 
 enum {
@@ -409,6 +412,7 @@ static SEL getSel;
   NSZoneFree(_myZone, _cells);
   NSZoneFree(_myZone, _selectedCells);
 
+  [_lazyCell release];
   [_cellPrototype release];
   [_backgroundColor release];
   [_cellBackgroundColor release];
@@ -652,6 +656,13 @@ static SEL getSel;
 {
   NSCell	*aCell;
 
+  if (_lazyCell != nil)
+    {
+      /* The new cell is the prototype; it gets a cell of its own when
+	 it has to differ from it.  */
+      _cells[row][column] = [_lazyCell retain];
+      return _lazyCell;
+    }
   if (_cellPrototype != nil)
     {
       aCell = (*_cellNew)(_cellPrototype, copySel, _myZone);
@@ -1176,7 +1187,7 @@ static SEL getSel;
 	  if ([_cells[i][j] isEnabled] == YES
 	    && [_cells[i][j] isEditable] == NO)
 	    {
-	      _selectedCell = _cells[i][j];
+	      _selectedCell = [self _realCellAtRow: i column: j];
 	      [_selectedCell setState: NSOnState];
 	      _selectedCells[i][j] = YES;
 
@@ -1302,6 +1313,7 @@ static SEL getSel;
 	  aCell = _cells[i][j];
 	  if ([aCell tag] == anInt)
 	    {
+	      aCell = [self _realCellAtRow: i column: j];
 	      [self _selectCell: aCell atRow: i column: j];
 	      [self selectTextAtRow: i column: j];
 	      return YES;
@@ -1492,7 +1504,7 @@ static SEL getSel;
 {
   if (row < 0 || row >= _numRows || column < 0 || column >= _numCols)
     return nil;
-  return _cells[row][column];
+  return [self _realCellAtRow: row column: column];
 }
 
 /**<p>Returns the cell with tag <var>anInt</var>
@@ -1512,7 +1524,7 @@ static SEL getSel;
 
 	  if ([aCell tag] == anInt)
 	    {
-	      return aCell;
+	      return [self _realCellAtRow: i column: j];
 	    }
 	}
     }
@@ -1535,7 +1547,7 @@ static SEL getSel;
 
       for (j = 0; j < _numCols; j++)
 	{
-	  (*add)(c, @selector(addObject:), _cells[i][j]);
+	  (*add)(c, @selector(addObject:), [self _realCellAtRow: i column: j]);
 	}
     }
   return c;
@@ -1625,7 +1637,9 @@ static SEL getSel;
       if ([text resignFirstResponder] == NO)
 	return nil;
 
-    [self _selectCell: _cells[row][column] atRow: row column: column];
+    [self _selectCell: [self _realCellAtRow: row column: column]
+		atRow: row
+	       column: column];
 
     /* See comment in NSTextField */
     length = [[_selectedCell stringValue] length];
@@ -1648,7 +1662,7 @@ static SEL getSel;
     }
   else if (_cells != 0)
     {
-      return _cells[_dottedRow][_dottedColumn];
+      return [self _realCellAtRow: _dottedRow column: _dottedColumn];
     }
 
   return nil;
@@ -2084,7 +2098,14 @@ static SEL getSel;
  */
 - (void) drawCellAtRow: (NSInteger)row column: (NSInteger)column
 {
-  NSCell *aCell = [self cellAtRow: row column: column];
+  NSCell *aCell;
+
+  /* A cell which is still the prototype is drawn as it is.  */
+  if (_lazyCell != nil && row >= 0 && row < _numRows
+    && column >= 0 && column < _numCols && _cells[row][column] == _lazyCell)
+    aCell = _lazyCell;
+  else
+    aCell = [self cellAtRow: row column: column];
 
   if (aCell)
     {
@@ -2185,7 +2206,8 @@ static SEL getSel;
 	  for (j = 0; j < _numCols; j++)
 	    {
 	      if (![anObject performSelector: aSelector
-				  withObject: _cells[i][j]])
+				  withObject: [self _realCellAtRow: i
+							    column: j]])
 		{
 		  return;
 		}
@@ -2537,7 +2559,9 @@ static SEL getSel;
 		    }
 		}
 	      // During editing, the selected cell is the cell being edited
-              [self _selectCell: _cells[row][column] atRow: row column: column];
+              [self _selectCell: [self _realCellAtRow: row column: column]
+			  atRow: row
+			 column: column];
 	      _textObject = [_selectedCell setUpFieldEditorAttributes: t];
 	      [_selectedCell editWithFrame: [self cellFrameAtRow: row
 						  column: column]
@@ -2578,6 +2602,12 @@ static SEL getSel;
   NSInteger		row, col;
   NSRect	rect;
 
+  if (aCell != nil && aCell == _lazyCell)
+    {
+      // The cell stands in for many cells.
+      [self setNeedsDisplay: YES];
+      return;
+    }
   if ([self getRow: &row column: &col ofCell: aCell] == NO)
     return;	// Not a cell in this matrix - we can't update it.
 
@@ -2624,6 +2654,7 @@ static SEL getSel;
 	      NSInteger oldSelectedRow = _selectedRow; 
 	      NSInteger oldSelectedColumn = _selectedColumn;
 
+	      aCell = [self _realCellAtRow: i column: j];
 	      _selectedCell = aCell;
 	      [self lockFocus];
 	      [self highlightCell: YES atRow: i column: j];
@@ -2966,6 +2997,13 @@ static SEL getSel;
  */
 - (void) setCellClass: (Class)classId
 {
+  if (_lazyCell != nil)
+    {
+      [self _makeLazyCellsReal];
+      DESTROY(_lazyCell);
+      _lazyCell = [[(classId ? classId : defaultCellClass)
+		     allocWithZone: _myZone] init];
+    }
   _cellClass = classId;
   if (_cellClass == nil)
     {
@@ -2991,6 +3029,12 @@ static SEL getSel;
  */
 - (void) setPrototype: (NSCell*)aCell
 {
+  if (_lazyCell != nil && aCell != nil)
+    {
+      [self _makeLazyCellsReal];
+      DESTROY(_lazyCell);
+      _lazyCell = [aCell copyWithZone: _myZone];
+    }
   ASSIGN(_cellPrototype, aCell);
   if (_cellPrototype == nil)
     {
@@ -3631,8 +3675,8 @@ static SEL getSel;
     }
 
   [self lockFocus];
-  [self drawCell: _cells[lastDottedRow][lastDottedColumn]];
-  [self drawCell: _cells[_dottedRow][_dottedColumn]];
+  [self drawCellAtRow: lastDottedRow column: lastDottedColumn];
+  [self drawCellAtRow: _dottedRow column: _dottedColumn];
   [self unlockFocus];
   [_window flushWindow];
 
@@ -3916,8 +3960,89 @@ static SEL getSel;
 @end
 
 
+@implementation NSMatrix (GNUstepExtensions)
+
+/** <p>Returns YES if new cells are only made when they have to differ
+    from the prototype.  By default NO.</p>
+    <p>See Also: -setCreatesCellsLazily:</p>
+ */
+- (BOOL) createsCellsLazily
+{
+  return (_lazyCell != nil);
+}
+
+/** <p>If flag is YES, cells the matrix makes from now on share a single
+    copy of the prototype (or of an instance of the cell class).  A cell
+    gets an object of its own when it is asked for, for example by
+    -cellAtRow:column:, or is selected, edited or clicked.  Until then it
+    is drawn from the shared copy, and changes made to all cells at once,
+    such as -setEnabled:, apply to the shared copy.  This saves memory
+    and time in large matrices whose cells are mostly alike.</p>
+    <p>If flag is NO, every cell gets an object of its own.</p>
+ */
+- (void) setCreatesCellsLazily: (BOOL)flag
+{
+  if (flag && _lazyCell == nil)
+    {
+      if (_cellPrototype != nil)
+	{
+	  _lazyCell = [_cellPrototype copyWithZone: _myZone];
+	}
+      else
+	{
+	  _lazyCell = [[_cellClass allocWithZone: _myZone] init];
+	}
+    }
+  else if (!flag && _lazyCell != nil)
+    {
+      [self _makeLazyCellsReal];
+      DESTROY(_lazyCell);
+    }
+}
+
+@end
+
+
 @implementation NSMatrix (PrivateMethods)
 
+/* Returns the cell at row and column, which must be in the matrix,
+ * giving it an object of its own if it is still the shared prototype.
+ */
+- (id) _realCellAtRow: (NSInteger)row
+               column: (NSInteger)column
+{
+  id aCell = _cells[row][column];
+
+  if (aCell != nil && aCell == _lazyCell)
+    {
+      aCell = [_lazyCell copyWithZone: _myZone];
+      _cells[row][column] = aCell;
+      [_lazyCell release];
+      if (_selectedCell == _lazyCell && _selectedRow == row
+	&& _selectedColumn == column)
+	{
+	  _selectedCell = aCell;
+	}
+    }
+  return aCell;
+}
+
+/* Gives every cell still sharing the prototype an object of its own,
+ * including the cells kept beyond the current size of the matrix.
+ */
+- (void) _makeLazyCellsReal
+{
+  NSInteger i, j;
+
+  for (i = 0; i < _maxRows; i++)
+    {
+      for (j = 0; j < _maxCols; j++)
+	{
+	  [self _realCellAtRow: i column: j];
+	}
+    }
+}
+
 /*
  * Renew rows and columns, but when expanding the matrix, refrain from
  * creating rowSpace  items in the last row and colSpace items in the
@@ -4093,6 +4218,7 @@ static SEL getSel;
 	      || (state == NSOffState && _selectedCells[i][j] != NO)
 	      || (state != NSOffState && _selectedCells[i][j] == NO)))
             {
+	      aCell = [self _realCellAtRow: i column: j];
 	      [aCell setState: state];
 
 	      if (state == NSOffState)
@@ -37,6 +37,7 @@
 #import <Foundation/NSCoder.h>
 #import <Foundation/NSArray.h>
 #import <Foundation/NSCharacterSet.h>
+#import <Foundation/NSDate.h>
 #import <Foundation/NSDebug.h>
 #import <Foundation/NSException.h>
 #import <Foundation/NSProcessInfo.h>
@@ -132,6 +133,12 @@ static NSString	*NSMenuLocationsKey = @"NSMenuLocations";
 static NSString *NSEnqueuedMenuMoveName = @"EnqueuedMoveNotificationName";
 static NSNotificationCenter *nc;
 static BOOL menuBarVisible = YES;
+/* Changed whenever a key equivalent, or the items of a menu, change */
+static NSUInteger keyEquivalentGeneration = 1;
+/* Nesting of -update, and the items validated by the outermost one */
+static NSUInteger updateDepth = 0;
+static NSUInteger validationCount = 0;
+static NSUInteger lastUpdateValidationCount = 0;
 
 @interface	NSMenu (GNUstepPrivate)
 
@@ -143,6 +150,10 @@ static BOOL menuBarVisible = YES;
 - (void) _setGeometry;
 - (void) _updateUserDefaults: (id) notification;
 - (void) _organizeMenu;
++ (void) _keyEquivalentsChanged;
+- (NSMutableDictionary *) _keyEquivalentIndex;
+- (void) _validateItem: (NSMenuItem *)item;
+- (BOOL) _needsValidation;
 
 @end
 
@@ -178,6 +189,160 @@ static BOOL menuBarVisible = YES;
 
 @implementation	NSMenu (GNUstepPrivate)
 
++ (void) _keyEquivalentsChanged
+{
+  keyEquivalentGeneration++;
+}
+
+/* Enables or disables item as its validator tells.  */
+- (void) _validateItem: (NSMenuItem *)item
+{
+  SEL	      action = [item action];
+  id	      validator = nil;
+  BOOL	      wasEnabled = [item isEnabled];
+  BOOL	      shouldBeEnabled;
+
+  validationCount++;
+
+  // If there is no action - there can be no validator for the item.
+  if (action)
+    {
+      validator = [NSApp targetForAction: action 
+			 to: [item target]
+			 from: item];
+    }
+  else if (_popUpButtonCell != nil)
+    {
+      if (NULL != (action = [_popUpButtonCell action]))
+	{
+	  validator = [NSApp targetForAction: action
+			     to: [_popUpButtonCell target]
+			     from: [_popUpButtonCell controlView]];
+	}
+    }
+
+  if (validator == nil)
+    {
+      if ((action == NULL) && (_popUpButtonCell != nil))
+	{
+	  shouldBeEnabled = YES;
+	}
+      else 
+	{
+	  shouldBeEnabled = NO;
+	}
+    }
+  else if ([validator
+	     respondsToSelector: @selector(validateMenuItem:)])
+    {
+      shouldBeEnabled = [validator validateMenuItem: item];
+    }
+  else if ([validator
+	     respondsToSelector: @selector(validateUserInterfaceItem:)])
+    {
+      shouldBeEnabled = [validator validateUserInterfaceItem: item];
+    }
+  else
+    {
+      shouldBeEnabled = YES;
+    }
+
+  if (shouldBeEnabled != wasEnabled)
+    {
+      [item setEnabled: shouldBeEnabled];
+    }
+}
+
+/* Returns YES if the items of the receiver, a submenu being updated
+   with its supermenu, should be validated now.  Menus on screen are
+   validated on every update, others only every so often, since their
+   items are validated again when they are displayed or their key
+   equivalents are used.  */
+- (BOOL) _needsValidation
+{
+  static NSTimeInterval interval = -1;
+  NSTimeInterval now;
+
+  if ([_aWindow isVisible] || [_bWindow isVisible])
+    {
+      return YES;
+    }
+  if (interval < 0)
+    {
+      NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+
+      if ([defaults objectForKey: @"GSMenuValidationInterval"] != nil)
+        {
+          interval = MAX(0, [defaults doubleForKey:
+                                        @"GSMenuValidationInterval"]);
+        }
+      else
+        {
+          interval = 1.0;
+        }
+    }
+  now = [NSDate timeIntervalSinceReferenceDate];
+  return (now - _lastValidation >= interval);
+}
+
+static void
+addKeyEquivalents(NSMenu *menu, NSMutableDictionary *index, NSMenu *services)
+{
+  NSArray *items = [menu itemArray];
+  NSUInteger i, count = [items count];
+
+  for (i = 0; i < count; i++)
+    {
+      NSMenuItem *item = [items objectAtIndex: i];
+
+      if ([item hasSubmenu])
+        {
+          /* The Services menu is left out, see -performKeyEquivalent: */
+          if ([item submenu] != services)
+            {
+              addKeyEquivalents([item submenu], index, services);
+            }
+        }
+      else
+        {
+          NSString *key = [item keyEquivalent];
+
+          if ([key length] > 0)
+            {
+              NSMutableArray *list = [index objectForKey: key];
+
+              if (list == nil)
+                {
+                  list = [NSMutableArray arrayWithCapacity: 1];
+                  [index setObject: list forKey: key];
+                }
+              [list addObject: item];
+            }
+        }
+    }
+}
+
+/* Returns the items of the receiver and its submenus with a key
+   equivalent, in the order they are searched, keyed by their key
+   equivalent.  Made again once the key equivalent of any item, or the
+   items of any menu, changed.  */
+- (NSMutableDictionary *) _keyEquivalentIndex
+{
+  NSMenu *services = [NSApp servicesMenu];
+
+  if (_keyEquivalentIndex == nil
+      || _keyEquivalentGeneration != keyEquivalentGeneration
+      || _keyEquivalentServicesMenu != services)
+    {
+      DESTROY(_keyEquivalentIndex);
+      _keyEquivalentIndex = [NSMutableDictionary new];
+      addKeyEquivalents(self, _keyEquivalentIndex, services);
+      _keyEquivalentGeneration = keyEquivalentGeneration;
+      _keyEquivalentServicesMenu = services;
+    }
+  return _keyEquivalentIndex;
+}
+
 - (NSString *) _name;
 {
   return _name;
@@ -628,6 +793,7 @@ static BOOL menuBarVisible = YES;
   RELEASE(_aWindow);
   RELEASE(_bWindow);
   RELEASE(_name);
+  RELEASE(_keyEquivalentIndex);
 
   [super dealloc];
 }
@@ -737,6 +903,7 @@ static BOOL menuBarVisible = YES;
     }
   
   [_items insertObject: newItem atIndex: index];
+  keyEquivalentGeneration++;
   _menu.needsSizing = YES;
   [(NSMenuView*)_view setNeedsSizing: YES];
   
@@ -811,6 +978,7 @@ static BOOL menuBarVisible = YES;
 
   [anItem setMenu: nil];
   [_items removeObjectAtIndex: index];
+  keyEquivalentGeneration++;
   _menu.needsSizing = YES;
   [(NSMenuView*)_view setNeedsSizing: YES];
   
@@ -1127,11 +1295,18 @@ static BOOL menuBarVisible = YES;
   if (!_menu.changedMessagesEnabled)
     return;
 
+  if (updateDepth == 0)
+    {
+      validationCount = 0;
+    }
+  updateDepth++;
+
   if ([self autoenablesItems])
     {
       NSUInteger i, count;
 
       count = [_items count];  
+      _lastValidation = [NSDate timeIntervalSinceReferenceDate];
       
       // Temporary disable automatic displaying of menu.
       [self setMenuChangedMessagesEnabled: NO];
@@ -1141,62 +1316,12 @@ static BOOL menuBarVisible = YES;
 	  for (i = 0; i < count; i++)
 	    {
 	      NSMenuItem *item = [_items objectAtIndex: i];
-	      SEL	      action = [item action];
-	      id	      validator = nil;
-	      BOOL	      wasEnabled = [item isEnabled];
-	      BOOL	      shouldBeEnabled;
 
 	      // Update the submenu items if any.
-	      if ([item hasSubmenu])
+	      if ([item hasSubmenu] && [[item submenu] _needsValidation])
 	        [[item submenu] update];
 
-	      // If there is no action - there can be no validator for the item.
-	      if (action)
-	        {
-	          validator = [NSApp targetForAction: action 
-				     to: [item target]
-				     from: item];
-	        }
-	      else if (_popUpButtonCell != nil)
-	        {
-	          if (NULL != (action = [_popUpButtonCell action]))
-	            {
-		      validator = [NSApp targetForAction: action
-				         to: [_popUpButtonCell target]
-				         from: [_popUpButtonCell controlView]];
-		    }
-	        }
-
-	      if (validator == nil)
-	        {
-	          if ((action == NULL) && (_popUpButtonCell != nil))
-		    {
-		      shouldBeEnabled = YES;
-		    }
-	          else 
-		    {
-		      shouldBeEnabled = NO;
-		    }
-	        }
-	      else if ([validator
-		         respondsToSelector: @selector(validateMenuItem:)])
-	        {
-	          shouldBeEnabled = [validator validateMenuItem: item];
-	        }
-	      else if ([validator
-		         respondsToSelector: @selector(validateUserInterfaceItem:)])
-	        {
-	          shouldBeEnabled = [validator validateUserInterfaceItem: item];
-	        }
-	      else
-	        {
-	          shouldBeEnabled = YES;
-	        }
-
-	      if (shouldBeEnabled != wasEnabled)
-	        {
-	          [item setEnabled: shouldBeEnabled];
-	        }
+	      [self _validateItem: item];
 	    }
           }
 	NS_HANDLER
@@ -1208,6 +1333,11 @@ static BOOL menuBarVisible = YES;
       [self setMenuChangedMessagesEnabled: YES]; // this will send pending _notifications
     }
 
+  if (--updateDepth == 0)
+    {
+      lastUpdateValidationCount = validationCount;
+    }
+
   if (_menu.mainMenuChanged)
     {
       if (NSInterfaceStyleForKey(@"NSMenuInterfaceStyle", nil) == NSWindows95InterfaceStyle)
@@ -1232,7 +1362,8 @@ static BOOL menuBarVisible = YES;
 - (BOOL) performKeyEquivalent: (NSEvent*)theEvent
 {
   NSUInteger      i;
-  NSUInteger      count = [_items count];
+  NSUInteger      count;
+  NSArray	*candidates;
   NSEventType   type = [theEvent type];
   NSUInteger modifiers = [theEvent modifierFlags];
   NSString	*keyEquivalent = [theEvent charactersIgnoringModifiers];
@@ -1244,47 +1375,44 @@ static BOOL menuBarVisible = YES;
 
   if ((type != NSKeyDown && type != NSKeyUp) || [keyEquivalent length] == 0)
     return NO;
-             
+
+  /* Submenus are searched whether active or not, except for the
+     Services submenu, so that its key equivalents do not accidentally
+     shadow standard key equivalents in the application's own menus.
+     NSApp calls -performKeyEquivalent: explicitly for the Services menu
+     when no matching key equivalent was found here (see NSApplication
+     -sendEvent:).
+     Note: Shadowing is no problem for a standard OpenStep menu, where
+     the Services menu appears close to the end of the main menu, but
+     is very likely for Macintosh or Windows 95 interface styles, where
+     the Services menu appears in the first submenu of the main menu.
+     Only the items with the key equivalent of the event are looked at,
+     found in an index of the menu tree.  */
+  // FIXME Should really remove conflicting key equivalents from the
+  // menus so that users don't get confused.
+  candidates = [[self _keyEquivalentIndex] objectForKey: keyEquivalent];
+  count = [candidates count];
   for (i = 0; i < count; i++)
     {
-      NSMenuItem *item = [_items objectAtIndex: i];
-                                    
-      if ([item hasSubmenu])
+      NSMenuItem *item = [candidates objectAtIndex: i];
+      NSUInteger mask = [item keyEquivalentModifierMask];
+
+      if ((modifiers & relevantModifiersMask) == (mask & relevantModifiersMask))
         {
-	  /* Ignore the Services submenu during menu traversal so that its key
-	     equivalents do not accidentally shadow standard key equivalents
-	     in the application's own menus. NSApp calls -performKeyEquivalent:
-	     explicitly for the Services menu when no matching key equivalent
-	     was found here (see NSApplication -sendEvent:).
-	     Note: Shadowing is no problem for a standard OpenStep menu, where
-	     the Services menu appears close to the end of the main menu, but
-	     is very likely for Macintosh or Windows 95 interface styles, where
-	     the Services menu appears in the first submenu of the main menu. */
-	  // FIXME Should really remove conflicting key equivalents from the
-	  // menus so that users don't get confused.
-	  if ([item submenu] == [NSApp servicesMenu])
-	    continue;
-	  // Recurse through submenus whether active or not.
-          // Recurse through submenus whether active or not.
-          if ([[item submenu] performKeyEquivalent: theEvent])
+          NSMenu *menu = [item menu];
+
+          // Its menu may not have been validated lately
+          if ([menu autoenablesItems])
             {
-              // The event has been handled by an item in the submenu.
-              return YES;
+              [menu _validateItem: item];
             }
-        }
-      else
-        {
-          NSUInteger mask = [item keyEquivalentModifierMask];
-
-          if ([[item keyEquivalent] isEqualToString: keyEquivalent] 
-            && (modifiers & relevantModifiersMask) == (mask & relevantModifiersMask))
+          if ([item isEnabled])
             {
-              if ([item isEnabled])
-                {
-                  [_view performActionWithHighlightingForItemAtIndex: i];
-                }
-              return YES;
+              [[menu menuRepresentation]
+                performActionWithHighlightingForItemAtIndex:
+                  [menu indexOfItem: item]];
             }
+          return YES;
         }
     }
   return NO; 
@@ -1720,6 +1848,11 @@ static BOOL menuBarVisible = YES;
 
 @implementation NSMenu (GNUstepExtra)
 
++ (NSUInteger) lastUpdateValidationCount
+{
+  return lastUpdateValidationCount;
+}
+
 - (void) setTornOff: (BOOL)flag
 {
   NSMenu	*supermenu;
@@ -1825,6 +1958,12 @@ static BOOL menuBarVisible = YES;
                    @"trying to display while already displayed transient");
     }
 
+  // Submenus off screen may have been left out of updates
+  if (_superMenu != nil)
+    {
+      [self update];
+    }
+
   if (_menu.needsSizing)
     {
       [self sizeToFit];
@@ -1860,6 +1999,11 @@ static BOOL menuBarVisible = YES;
       return;
     }
 
+  if (_superMenu != nil)
+    {
+      [self update];
+    }
+
   if (_menu.needsSizing)
     {
       [self sizeToFit];
@@ -46,6 +46,10 @@
 static BOOL usesUserKeyEquivalents = NO;
 static Class imageClass;
 
+@interface NSMenu (KeyEquivalentIndex)
++ (void) _keyEquivalentsChanged;
+@end
+
 @interface GSMenuSeparator : NSMenuItem
 
 @end
@@ -95,6 +99,7 @@ static Class imageClass;
 + (void) setUsesUserKeyEquivalents: (BOOL)flag
 {
   usesUserKeyEquivalents = flag;
+  [NSMenu _keyEquivalentsChanged];
 }
 
 + (BOOL) usesUserKeyEquivalents
@@ -234,6 +239,7 @@ static Class imageClass;
 		   [submenu title], [[submenu supermenu] title]];
     }
   ASSIGN(_submenu, submenu);
+  [NSMenu _keyEquivalentsChanged];
   if (submenu != nil)
     {
       [submenu setSupermenu: _menu];
@@ -259,6 +265,7 @@ static Class imageClass;
 	
   ASSIGNCOPY(_title,  aString);
   [self _updateKeyEquivalent];
+  [NSMenu _keyEquivalentsChanged];
   [_menu itemChanged: self];
 }
 
@@ -286,6 +293,7 @@ static Class imageClass;
     return; // no change
 	
   ASSIGNCOPY(_keyEquivalent,  aKeyEquivalent);
+  [NSMenu _keyEquivalentsChanged];
   [_menu itemChanged: self];
 }
 
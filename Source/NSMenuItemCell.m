@@ -109,6 +109,9 @@ static NSString *commandKeyString = @"#";
 - (void) dealloc
 {
   RELEASE(_menuItem);
+  RELEASE(_measuredTitle);
+  RELEASE(_measuredKeyEquivalent);
+  RELEASE(_measuredFont);
   [super dealloc];
 }
 
@@ -268,6 +271,8 @@ static NSString *commandKeyString = @"#";
 {
   NSSize   componentSize;
   NSImage *anImage = nil;
+  NSString *title;
+  NSString *keyEquivalent;
   CGFloat  neededMenuItemHeight = 20;
  
   // Check if _mcell_belongs_to_popupbutton = NO while cell owned by 
@@ -331,11 +336,34 @@ static NSString *commandKeyString = @"#";
     }
 
   // Title and Key Equivalent
-  componentSize = [self _sizeText: [_menuItem title]];
+  /* Measuring text is costly and the cell is resized whenever its item
+     changes at all, so only measure strings which have changed.  */
+  title = [_menuItem title];
+  keyEquivalent = [self _keyEquivalentString];
+  if (_measuredFont != [self font])
+    {
+      ASSIGN(_measuredFont, [self font]);
+      DESTROY(_measuredTitle);
+      DESTROY(_measuredKeyEquivalent);
+    }
+  if (_measuredTitle == nil || title == nil
+      || ![_measuredTitle isEqualToString: title])
+    {
+      _measuredTitleSize = [self _sizeText: title];
+      ASSIGNCOPY(_measuredTitle, title);
+    }
+  if (_measuredKeyEquivalent == nil || keyEquivalent == nil
+      || ![_measuredKeyEquivalent isEqualToString: keyEquivalent])
+    {
+      _measuredKeyEquivalentSize = [self _sizeText: keyEquivalent];
+      ASSIGNCOPY(_measuredKeyEquivalent, keyEquivalent);
+    }
+
+  componentSize = _measuredTitleSize;
   _titleWidth = componentSize.width;
   if (componentSize.height > neededMenuItemHeight)
     neededMenuItemHeight = componentSize.height;
-  componentSize = [self _sizeText: [self _keyEquivalentString]];
+  componentSize = _measuredKeyEquivalentSize;
   _keyEquivalentWidth = componentSize.width;
   if (componentSize.height > neededMenuItemHeight)
     neededMenuItemHeight = componentSize.height;
@@ -915,6 +943,9 @@ static NSString *commandKeyString = @"#";
 
   if (_menuItem)
     c->_menuItem = [_menuItem copyWithZone: zone];
+  TEST_RETAIN(_measuredTitle);
+  TEST_RETAIN(_measuredKeyEquivalent);
+  TEST_RETAIN(_measuredFont);
 
   /* We do not copy _menuView, because _menuView owns the old cell,
      but not the new one!  _menuView knows nothing about c.  If we copy
@@ -82,6 +82,7 @@ static NSOpenPanel *_gs_gui_open_panel = nil;
 - (void) _selectTextInColumn: (int)column;
 - (void) _setupForDirectory: (NSString *)path file: (NSString *)filename;
 - (BOOL) _shouldShowExtension: (NSString *)extension;
+- (BOOL) _isAllowedExtension: (NSString *)extension;
 - (NSComparisonResult) _compareFilename: (NSString *)n1 with: (NSString *)n2;
 @end
 
@@ -99,7 +100,7 @@ static NSOpenPanel *_gs_gui_open_panel = nil;
 - (BOOL) _shouldShowExtension: (NSString *)extension
 {
   if (_canChooseFiles == NO ||
-      (_allowedFileTypes != nil && [_allowedFileTypes containsObject: extension] == NO))
+      (_allowedExtensions != nil && [self _isAllowedExtension: extension] == NO))
     return NO;
 
   return YES;
@@ -40,6 +40,7 @@
 #import <Foundation/NSNotification.h>
 #import <Foundation/NSNull.h>
 #import <Foundation/NSSet.h>
+#import <Foundation/NSThread.h>
 #import <Foundation/NSUserDefaults.h>
 #import <Foundation/NSValue.h>
 
@@ -85,6 +86,47 @@ static NSImage *collapsed = nil;
 static NSImage *expanded  = nil;
 static NSImage *unexpandable  = nil;
 
+/* The number of children a background loader hands over at a time */
+#define CHILD_BATCH 256
+
+/* Loads the children of an item on a background thread and hands them
+   to the outline view in batches.  Until it is done, the loader itself
+   stands in a placeholder row after the children loaded so far.  */
+@interface GSOutlineChildLoader : NSObject
+{
+@public
+  NSOutlineView *view;
+  id dataSource;
+  id item;
+  NSUInteger threshold;
+  BOOL cancelled;
+}
+- (id) initWithOutlineView: (NSOutlineView *)ov
+		      item: (id)anItem
+	    lazyThreshold: (NSUInteger)count;
+- (void) start;
+- (void) cancel;
+@end
+
+/* Stands for a child of an item with more children than the lazy
+   children threshold, until the child is shown and got from the data
+   source.  */
+@interface GSOutlineLazyChild : NSObject
+{
+@public
+  id parent;
+  NSInteger index;
+}
+@end
+
+static Class childLoaderClass = Nil;
+static Class lazyChildClass = Nil;
+
+#define IS_PLACEHOLDER(item) \
+  ((item) != nil && object_getClass(item) == childLoaderClass)
+#define IS_LAZY_CHILD(item) \
+  ((item) != nil && object_getClass(item) == lazyChildClass)
+
 @interface NSOutlineView (NotificationRequestMethods)
 - (void) _postSelectionIsChangingNotification;
 - (void) _postSelectionDidChangeNotification;
@@ -109,6 +151,15 @@ static NSImage *unexpandable  = nil;
           forTableColumn: (NSTableColumn *)tb
                      row: (NSInteger) index;
 - (NSInteger) _numRows;
+- (id) _cachedObjectValueAtColumn: (NSInteger)columnIndex
+                              row: (NSInteger)rowIndex;
+- (void) _invalidateObjectValueCache;
+- (NSInteger) _columnBeforeX: (CGFloat)x;
+- (BOOL) _delegateGivesRowHeights;
+- (CGFloat) _delegateHeightOfRow: (NSInteger)rowIndex;
+- (void) _updateRowHeights;
+- (CGFloat) _originOfRow: (NSInteger)rowIndex;
+- (CGFloat) _rowPositionAtOffset: (CGFloat)offset;
 @end
 
 // These methods are private...
@@ -123,7 +174,123 @@ static NSImage *unexpandable  = nil;
 - (void) _openItem: (id)item;
 - (void) _closeItem: (id)item;
 - (void) _removeChildren: (id)startitem;
+- (void) _unloadChildren: (id)startitem;
+- (void) _rowsOfItemsChangedFromRow: (NSUInteger)row;
 - (void) _noteNumberOfRowsChangedBelowItem: (id)item by: (NSInteger)n;
+- (void) _noteNumberOfRowsChangedAtRow: (NSUInteger)rowIndex
+				    by: (NSInteger)numItems;
+- (void) _loadChildrenInBackground: (id)item;
+- (void) _childLoader: (GSOutlineChildLoader *)loader
+      didLoadChildren: (NSArray *)children;
+- (void) _childLoaderDidFinish: (GSOutlineChildLoader *)loader;
+- (void) _cancelChildLoaderForItem: (id)item;
+- (void) _cancelChildLoaders;
+- (id) _resolveLazyChild: (GSOutlineLazyChild *)child row: (NSInteger)row;
+@end
+
+@implementation GSOutlineLazyChild
+
+- (void) dealloc
+{
+  RELEASE(parent);
+  [super dealloc];
+}
+
+@end
+
+@implementation GSOutlineChildLoader
+
+- (id) initWithOutlineView: (NSOutlineView *)ov
+		      item: (id)anItem
+	    lazyThreshold: (NSUInteger)count
+{
+  if ((self = [super init]) != nil)
+    {
+      ASSIGN(view, ov);
+      ASSIGN(item, anItem);
+      dataSource = [ov dataSource];
+      threshold = count;
+    }
+  return self;
+}
+
+- (void) dealloc
+{
+  RELEASE(view);
+  RELEASE(item);
+  [super dealloc];
+}
+
+- (void) _deliverChildren: (NSArray *)children
+{
+  if (!cancelled)
+    [view _childLoader: self didLoadChildren: children];
+}
+
+- (void) _finish: (id)unused
+{
+  if (!cancelled)
+    [view _childLoaderDidFinish: self];
+  DESTROY(view);
+}
+
+- (void) _load: (id)unused
+{
+  CREATE_AUTORELEASE_POOL(arp);
+  NSInteger num;
+  NSInteger i = 0;
+  BOOL lazy;
+
+  num = [dataSource outlineView: view numberOfChildrenOfItem: item];
+  lazy = (threshold > 0 && num > threshold);
+  while (i < num && !cancelled)
+    {
+      CREATE_AUTORELEASE_POOL(pool);
+      NSMutableArray *children = [NSMutableArray new];
+      NSInteger end = MIN(i + CHILD_BATCH, num);
+
+      for (; i < end; i++)
+	{
+	  if (lazy)
+	    {
+	      GSOutlineLazyChild *child = [GSOutlineLazyChild new];
+
+	      child->parent = RETAIN(item);
+	      child->index = i;
+	      [children addObject: child];
+	      RELEASE(child);
+	    }
+	  else
+	    {
+	      [children addObject: [dataSource outlineView: view
+						     child: i
+						    ofItem: item]];
+	    }
+	}
+      [self performSelectorOnMainThread: @selector(_deliverChildren:)
+			     withObject: children
+			  waitUntilDone: NO];
+      RELEASE(children);
+      DESTROY(pool);
+    }
+  [self performSelectorOnMainThread: @selector(_finish:)
+			 withObject: nil
+		      waitUntilDone: NO];
+  DESTROY(arp);
+}
+
+- (void) start
+{
+  [NSThread detachNewThreadSelector: @selector(_load:)
+			   toTarget: self
+			 withObject: nil];
+}
+
+- (void) cancel
+{
+  cancelled = YES;
+}
+
 @end
 
 @interface	NSOutlineView (Private)
@@ -152,6 +319,8 @@ static NSImage *unexpandable  = nil;
       unexpandable = [[NSImage alloc] initWithSize: [expanded size]];
 #endif
       autoExpanded = [NSMutableSet new];
+      childLoaderClass = [GSOutlineChildLoader class];
+      lazyChildClass = [GSOutlineLazyChild class];
     }
 }
 
@@ -182,6 +351,9 @@ static NSImage *unexpandable  = nil;
 
   NSFreeMapTable(_itemDict);
   NSFreeMapTable(_levelOfItems);
+  NSFreeMapTable(_rowOfItem);
+  [self _cancelChildLoaders];
+  NSFreeMapTable(_childLoaders);
 
   if (_autosaveExpandedItems)
     {
@@ -411,7 +583,7 @@ static NSImage *unexpandable  = nil;
  */
 - (BOOL) isExpandable: (id)item
 {
-  if (item == nil)
+  if (item == nil || IS_PLACEHOLDER(item) || IS_LAZY_CHILD(item))
     {
       return NO;
     }
@@ -439,11 +611,18 @@ static NSImage *unexpandable  = nil;
  */
 - (id) itemAtRow: (NSInteger)row
 {
+  id item;
+
   if ((row >= [_items count]) || (row < 0))
     {
       return nil;
     }
-  return [_items objectAtIndex: row];
+  item = [_items objectAtIndex: row];
+  if (IS_LAZY_CHILD(item))
+    {
+      item = [self _resolveLazyChild: item row: row];
+    }
+  return item;
 }
 
 /**
@@ -539,9 +718,33 @@ static NSImage *unexpandable  = nil;
 
           if (dsobj != item)
             {
+              NSInteger row = [self rowForItem: item];
+              id children = AUTORELEASE(RETAIN(NSMapGet(_itemDict, item)));
+              id level = AUTORELEASE(RETAIN(NSMapGet(_levelOfItems, item)));
+
+              // Put the new object in the place of the old one
               [childArray replaceObjectAtIndex: index withObject: dsobj];
-              // FIXME We need to correct _items, _itemDict, _levelOfItems,
-              // _expandedItems and _selectedItems
+              NSMapRemove(_rowOfItem, item);
+              NSMapRemove(_levelOfItems, item);
+              NSMapRemove(_itemDict, item);
+              if (row != -1)
+                {
+                  [_items replaceObjectAtIndex: row withObject: dsobj];
+                  NSMapInsert(_rowOfItem, dsobj, (void *)row);
+                }
+              if (level != nil)
+                {
+                  NSMapInsert(_levelOfItems, dsobj, level);
+                }
+              if (children != nil)
+                {
+                  NSMapInsert(_itemDict, dsobj, children);
+                }
+              if (expanded)
+                {
+                  [_expandedItems removeObject: item];
+                  [_expandedItems addObject: dsobj];
+                }
             }
           break;
         }
@@ -558,6 +761,8 @@ static NSImage *unexpandable  = nil;
           [self _openItem: dsobj];
         }
     }
+  /* The rows may show other items or values now */
+  [self _invalidateObjectValueCache];
   [self setNeedsDisplay: YES];
 }
 
@@ -567,12 +772,38 @@ static NSImage *unexpandable  = nil;
  */
 - (NSInteger) rowForItem: (id)item
 {
-  NSInteger row;
+  NSUInteger count = [_items count];
+  void *row;
+
   if (item == nil)
     return -1;
 
-  row = [_items indexOfObject: item];
-  return (row == NSNotFound) ? -1 : row;
+  if (NSMapMember(_rowOfItem, item, NULL, &row)
+      && (NSUInteger)row < count
+      && [[_items objectAtIndex: (NSUInteger)row] isEqual: item])
+    {
+      return (NSInteger)row;
+    }
+
+  /* Learn the rows of the items after the last known one until we get
+     to item.  An item which is there twice keeps its first row.  */
+  while (_rowOfItemCount < count)
+    {
+      NSUInteger r = _rowOfItemCount++;
+      id anitem = [_items objectAtIndex: r];
+
+      if (!NSMapMember(_rowOfItem, anitem, NULL, &row)
+          || (NSUInteger)row >= r
+          || ![[_items objectAtIndex: (NSUInteger)row] isEqual: anitem])
+        {
+          NSMapInsert(_rowOfItem, anitem, (void *)r);
+        }
+      if ([anitem isEqual: item])
+        {
+          return r;
+        }
+    }
+  return -1;
 }
 
 /**
@@ -662,6 +893,42 @@ static NSImage *unexpandable  = nil;
   return YES;
 }
 
+/**
+ * Sets whether the children of an item are got from the data source on
+ * a background thread when the item is expanded for the first time.
+ * The item shows a placeholder row at once, and the children appear in
+ * batches as they arrive.  The data source must then answer
+ * -outlineView:numberOfChildrenOfItem: and -outlineView:child:ofItem:
+ * on any thread.  The top level items are always got at once.  The
+ * default is NO.
+ */
+- (void) setLoadsChildrenInBackground: (BOOL)flag
+{
+  _loadsChildrenInBackground = flag;
+}
+
+- (BOOL) loadsChildrenInBackground
+{
+  return _loadsChildrenInBackground;
+}
+
+/**
+ * Sets the number of children above which an item's children are got
+ * from the data source only when their rows are shown, so that
+ * expanding a node with a huge number of children asks only for the
+ * rows on screen.  Until then -rowForItem: doesn't find such a child.
+ * Zero, the default, gets all children at once.
+ */
+- (void) setLazyChildrenThreshold: (NSUInteger)count
+{
+  _lazyChildrenThreshold = count;
+}
+
+- (NSUInteger) lazyChildrenThreshold
+{
+  return _lazyChildrenThreshold;
+}
+
 /**
  * Sets the data source for this outline view.
  */
@@ -708,6 +975,10 @@ static NSImage *unexpandable  = nil;
       NSFreeMapTable(_levelOfItems);
     }
 
+  NSResetMapTable(_rowOfItem);
+  _rowOfItemCount = 0;
+  [self _cancelChildLoaders];
+
   // create a new empty one
   _items = [[NSMutableArray alloc] init];
   _itemDict = NSCreateMapTable(NSObjectMapKeyCallBacks,
@@ -749,6 +1020,12 @@ static NSImage *unexpandable  = nil;
   SET_DELEGATE_NOTIFICATION(ItemWillCollapse);
 
   _del_responds = [_delegate respondsToSelector: sel];
+
+  [self _updateRowHeights];
+  if (_numberOfRows > 0)
+    {
+      [self tile];
+    }
 }
 
 - (void) encodeWithCoder: (NSCoder*)aCoder
@@ -915,7 +1192,6 @@ static NSImage *unexpandable  = nil;
   NSCell *imageCell = nil;
   NSRect imageRect;
   NSInteger i;
-  CGFloat x_pos;
 
   if (_dataSource == nil)
     {
@@ -931,25 +1207,13 @@ static NSImage *unexpandable  = nil;
     }
 
   /* Determine starting column as fast as possible */
-  x_pos = NSMinX (aRect);
-  i = 0;
-  while ((i < _numberOfColumns) && (x_pos > _columnOrigins[i]))
-    {
-      i++;
-    }
-  startingColumn = (i - 1);
+  startingColumn = [self _columnBeforeX: NSMinX (aRect)];
 
   if (startingColumn == -1)
     startingColumn = 0;
 
   /* Determine ending column as fast as possible */
-  x_pos = NSMaxX (aRect);
-  // Nota Bene: we do *not* reset i
-  while ((i < _numberOfColumns) && (x_pos > _columnOrigins[i]))
-    {
-      i++;
-    }
-  endingColumn = (i - 1);
+  endingColumn = [self _columnBeforeX: NSMaxX (aRect)];
 
   if (endingColumn == -1)
     endingColumn = _numberOfColumns - 1;
@@ -969,9 +1233,8 @@ static NSImage *unexpandable  = nil;
       [self _willDisplayCell: cell
             forTableColumn: tb
             row: rowIndex];
-      [cell setObjectValue: [_dataSource outlineView: self
-                                         objectValueForTableColumn: tb
-                                         byItem: item]];
+      [cell setObjectValue: [self _cachedObjectValueAtColumn: i
+                                                         row: rowIndex]];
       drawingRect = [self frameOfCellAtColumn: i
                           row: rowIndex];
 
@@ -1065,7 +1328,7 @@ static NSImage *unexpandable  = nil;
       dropChildIndex: (NSInteger)childIndex
 {
 
-  if (item != nil && [_items indexOfObject: item] == NSNotFound)
+  if (item != nil && [self rowForItem: item] == -1)
     {
       /* FIXME raise an exception, or perhaps we should support
        * setting an item which is not visible (inside a collapsed
@@ -1122,14 +1385,14 @@ static NSImage *unexpandable  = nil;
   else if (row == _numberOfRows)
     {
       newRect = NSMakeRect([self visibleRect].origin.x,
-                           row * _rowHeight - 2,
+                           [self _originOfRow: row] - 2,
                            [self visibleRect].size.width,
                            2);
     }
   else
     {
       newRect = NSMakeRect([self visibleRect].origin.x,
-                           row * _rowHeight - 1,
+                           [self _originOfRow: row] - 1,
                            [self visibleRect].size.width,
                            2);
     }
@@ -1187,7 +1450,7 @@ static NSImage *unexpandable  = nil;
 // TODO: Move a method common to -drapOnRootIndicator and the one below to GSTheme
 - (void) drawDropOnIndicatorWithDropItem: (id)currentDropItem
 {
-  NSInteger row = [_items indexOfObject: currentDropItem];
+  NSInteger row = [self rowForItem: currentDropItem];
   NSInteger level = [self levelForItem: currentDropItem];
   NSRect newRect = [self frameOfCellAtColumn: 0
                                          row: row];
@@ -1293,7 +1556,8 @@ Also returns the child index relative to this parent. */
   /* _bounds.origin is (0, 0) when the outline view is not clipped.
    * When the view is scrolled, _bounds.origin.y returns the scrolled height. */
   verticalQuarterPosition =
-    GSRoundTowardsInfinity(((p.y + _bounds.origin.y) / _rowHeight) * 4.);
+    GSRoundTowardsInfinity([self _rowPositionAtOffset: p.y + _bounds.origin.y]
+                           * 4.);
   horizontalHalfPosition =
     GSRoundTowardsInfinity(((p.x + _bounds.origin.y) / _indentationPerLevel) * 2.);
 
@@ -1767,6 +2031,11 @@ Also returns the child index relative to this parent. */
 {
   id item = [self itemAtRow: rowIndex];
 
+  if (IS_PLACEHOLDER(item))
+    {
+      return NO;
+    }
+
   if ([_delegate respondsToSelector:
     @selector (outlineView:shouldSelectItem:)] == YES)
     {
@@ -1814,6 +2083,10 @@ Also returns the child index relative to this parent. */
 - (BOOL) _shouldEditTableColumn: (NSTableColumn *)tableColumn
                             row: (NSInteger) rowIndex
 {
+  if (IS_PLACEHOLDER([_items objectAtIndex: rowIndex]))
+    {
+      return NO;
+    }
   if ([_delegate respondsToSelector:
     @selector(outlineView:shouldEditTableColumn:item:)])
     {
@@ -1833,7 +2106,7 @@ Also returns the child index relative to this parent. */
            forTableColumn: (NSTableColumn *)tb
                       row: (NSInteger)index
 {
-  if (_del_responds)
+  if (_del_responds && !IS_PLACEHOLDER([_items objectAtIndex: index]))
     {
       id item = [self itemAtRow: index];
 
@@ -1853,7 +2126,12 @@ Also returns the child index relative to this parent. */
 
   while (index != NSNotFound)
     {
-      [itemArray addObject: [self itemAtRow: index]];
+      id item = [self itemAtRow: index];
+
+      if (!IS_PLACEHOLDER(item))
+        {
+          [itemArray addObject: item];
+        }
       index = [rows indexGreaterThanIndex: index];
     }
 
@@ -1878,6 +2156,10 @@ Also returns the child index relative to this parent. */
 {
   id result = nil;
 
+  if (IS_PLACEHOLDER([_items objectAtIndex: index]))
+    {
+      return (tb == _outlineTableColumn) ? _(@"Loading...") : nil;
+    }
   if ([_dataSource respondsToSelector:
     @selector(outlineView:objectValueForTableColumn:byItem:)])
     {
@@ -1896,7 +2178,8 @@ Also returns the child index relative to this parent. */
                      row: (NSInteger) index
 {
   if ([_dataSource respondsToSelector:
-    @selector(outlineView:setObjectValue:forTableColumn:byItem:)])
+    @selector(outlineView:setObjectValue:forTableColumn:byItem:)]
+    && !IS_PLACEHOLDER([_items objectAtIndex: index]))
     {
       id item = [self itemAtRow: index];
 
@@ -1912,6 +2195,24 @@ Also returns the child index relative to this parent. */
   return [_items count];
 }
 
+- (BOOL) _delegateGivesRowHeights
+{
+  return [_delegate respondsToSelector:
+    @selector(outlineView:heightOfRowByItem:)];
+}
+
+- (CGFloat) _delegateHeightOfRow: (NSInteger)rowIndex
+{
+  id item = [_items objectAtIndex: rowIndex];
+
+  /* Don't get lazy children just for their heights */
+  if (IS_PLACEHOLDER(item) || IS_LAZY_CHILD(item))
+    {
+      return _rowHeight;
+    }
+  return [_delegate outlineView: self heightOfRowByItem: item];
+}
+
 @end
 
 @implementation NSOutlineView (TableViewInternalPrivate)
@@ -1926,6 +2227,13 @@ Also returns the child index relative to this parent. */
   _levelOfItems = NSCreateMapTable(NSObjectMapKeyCallBacks,
                                    NSObjectMapValueCallBacks,
                                    64);
+  _rowOfItem = NSCreateMapTable(NSObjectMapKeyCallBacks,
+                                NSIntMapValueCallBacks,
+                                64);
+  _rowOfItemCount = 0;
+  _childLoaders = NSCreateMapTable(NSObjectMapKeyCallBacks,
+                                   NSObjectMapValueCallBacks,
+                                   0);
 
   _indentationMarkerFollowsCell = YES;
   _autoResizesOutlineColumn = NO;
@@ -1973,7 +2281,8 @@ Also returns the child index relative to this parent. */
     }
 }
 
-// Collect all of the items under a given element.
+// Collect the items shown under a given element, in the order of their
+// rows.
 - (void)_collectItemsStartingWith: (id)startitem
                              into: (NSMutableArray *)allChildren
 {
@@ -1982,21 +2291,33 @@ Also returns the child index relative to this parent. */
   id sitem = (startitem == nil) ? (id)[NSNull null] : (id)startitem;
   NSMutableArray *anarray;
 
+  // Only collect the children if the item is expanded
+  if (![self isItemExpanded: startitem])
+    {
+      return;
+    }
+
   anarray = NSMapGet(_itemDict, sitem);
   num = [anarray count];
   for (i = 0; i < num; i++)
     {
       id anitem = [anarray objectAtIndex: i];
 
-      // Only collect the children if the item is expanded
-      if ([self isItemExpanded: startitem])
-        {
-          [allChildren addObject: anitem];
-        }
-
+      [allChildren addObject: anitem];
       [self _collectItemsStartingWith: anitem
             into: allChildren];
     }
+
+  // The placeholder of children still being loaded comes last
+  if (startitem != nil)
+    {
+      id loader = NSMapGet(_childLoaders, startitem);
+
+      if (loader != nil)
+        {
+          [allChildren addObject: loader];
+        }
+    }
 }
 
 - (BOOL) _isItemLoaded: (id)item
@@ -2044,6 +2365,24 @@ Also returns the child index relative to this parent. */
 
   NSMapInsert(_levelOfItems, sitem, [NSNumber numberWithInteger: level]);
 
+  // Only get the children of a huge node when they are shown
+  if (_lazyChildrenThreshold > 0 && num > _lazyChildrenThreshold)
+    {
+      NSNumber *childLevel = [NSNumber numberWithInteger: level + 1];
+
+      for (i = 0; i < num; i++)
+        {
+          GSOutlineLazyChild *child = [GSOutlineLazyChild new];
+
+          child->parent = RETAIN(startitem);
+          child->index = i;
+          [anarray addObject: child];
+          NSMapInsert(_levelOfItems, child, childLevel);
+          RELEASE(child);
+        }
+      return;
+    }
+
   for (i = 0; i < num; i++)
     {
       id anitem = [_dataSource outlineView: self
@@ -2060,8 +2399,14 @@ Also returns the child index relative to this parent. */
 {
   NSUInteger i, numChildren;
   NSMutableArray *removeAll = [NSMutableArray array];
+  NSInteger row = (item == nil) ? -1 : [self rowForItem: item];
 
-  [self _collectItemsStartingWith: item into: removeAll];
+  // The rows shown under an item directly follow its own row, unless
+  // the item isn't shown itself
+  if (item == nil || row != -1)
+    {
+      [self _collectItemsStartingWith: item into: removeAll];
+    }
   numChildren = [removeAll count];
 
   // close the item...
@@ -2070,22 +2415,25 @@ Also returns the child index relative to this parent. */
       [_expandedItems removeObject: item];
     }
 
-  // For the close method it doesn't matter what order they are
-  // removed in.
-  for (i = 0; i < numChildren; i++)
+  if (numChildren > 0)
     {
-      id child = [removeAll objectAtIndex: i];
-      [_items removeObject: child];
+      [_items removeObjectsInRange: NSMakeRange(row + 1, numChildren)];
+      [self _rowsOfItemsChangedFromRow: row + 1];
+      for (i = 0; i < numChildren; i++)
+        {
+          NSMapRemove(_rowOfItem, [removeAll objectAtIndex: i]);
+        }
     }
+  // Children still being loaded are loaded again on the next expansion
+  [self _cancelChildLoaderForItem: item];
   [self _noteNumberOfRowsChangedBelowItem: item by: -numChildren];
 }
 
 - (void)_openItem: (id)item
 {
-  NSUInteger insertionPoint, numChildren, numDescendants;
-  NSInteger i;
-  id object;
-  id sitem = (item == nil) ? (id)[NSNull null] : (id)item;
+  NSUInteger insertionPoint, numDescendants;
+  NSInteger row;
+  NSMutableArray *insertAll;
 
   // open the item...
   if (item != nil)
@@ -2094,89 +2442,114 @@ Also returns the child index relative to this parent. */
     }
 
   // Load the children of the item if needed
-  if ([self _isItemLoaded: item] == NO)
+  if ([self _isItemLoaded: item] == NO && item != nil
+      && _loadsChildrenInBackground && NSMapGet(_childLoaders, item) == nil)
+    {
+      [self _loadChildrenInBackground: item];
+    }
+  else if ([self _isItemLoaded: item] == NO)
     {
       [self _loadDictionaryStartingWith: item atLevel: [self levelForItem: item]];
     }
 
-  object = NSMapGet(_itemDict, sitem);
-  numChildren = numDescendants = [object count];
-
-  insertionPoint = [_items indexOfObject: item];
-  if (insertionPoint == NSNotFound)
+  // An item which isn't shown itself shows no children either
+  row = (item == nil) ? -1 : [self rowForItem: item];
+  if (item != nil && row == -1)
     {
-      insertionPoint = 0;
+      return;
     }
-  else
+  insertionPoint = row + 1;
+
+  // Add all of the children and the items shown under them, and
+  // splice them into the rows at once
+  insertAll = [NSMutableArray array];
+  [self _collectItemsStartingWith: item into: insertAll];
+  numDescendants = [insertAll count];
+  if (numDescendants > 0)
     {
-      insertionPoint++;
+      [_items replaceObjectsInRange: NSMakeRange(insertionPoint, 0)
+               withObjectsFromArray: insertAll];
+      [self _rowsOfItemsChangedFromRow: insertionPoint];
     }
 
-  for (i = numChildren-1; i >= 0; i--)
-    {
-      id obj = NSMapGet(_itemDict, sitem);
-      id child = [obj objectAtIndex: i];
+  [self _noteNumberOfRowsChangedBelowItem: item by: numDescendants];
+}
 
-      // Add all of the children...
-      if ([self isItemExpanded: child])
+- (void) _removeChildren: (id)startitem
+{
+  NSUInteger i, numChildren;
+  NSMutableArray *removeAll = [NSMutableArray array];
+  NSInteger row = (startitem == nil) ? -1 : [self rowForItem: startitem];
+
+  if (startitem == nil || row != -1)
+    {
+      [self _collectItemsStartingWith: startitem into: removeAll];
+    }
+  numChildren = [removeAll count];
+  if (numChildren > 0)
+    {
+      [_items removeObjectsInRange: NSMakeRange(row + 1, numChildren)];
+      [self _rowsOfItemsChangedFromRow: row + 1];
+      for (i = 0; i < numChildren; i++)
         {
-          NSUInteger numItems;
-          NSInteger j;
-          NSMutableArray *insertAll = [NSMutableArray array];
-
-          [self _collectItemsStartingWith: child into: insertAll];
-          numItems = [insertAll count];
-          numDescendants += numItems;
-          for (j = numItems-1; j >= 0; j--)
-            {
-              [_items insertObject: [insertAll objectAtIndex: j]
-                      atIndex: insertionPoint];
-            }
+          NSMapRemove(_rowOfItem, [removeAll objectAtIndex: i]);
         }
-
-      // Add the parent
-      [_items insertObject: child atIndex: insertionPoint];
     }
-
-  [self _noteNumberOfRowsChangedBelowItem: item by: numDescendants];
+  [self _unloadChildren: startitem];
+  [self _noteNumberOfRowsChangedBelowItem: startitem by: -numChildren];
 }
 
-- (void) _removeChildren: (id)startitem
+// Forget the loaded children of an item and their descendants.
+- (void) _unloadChildren: (id)startitem
 {
   NSUInteger i, numChildren;
   id sitem = (startitem == nil) ? (id)[NSNull null] : (id)startitem;
   NSMutableArray *anarray;
 
+  [self _cancelChildLoaderForItem: startitem];
+
   anarray = NSMapGet(_itemDict, sitem);
   numChildren = [anarray count];
   for (i = 0; i < numChildren; i++)
     {
       id child = [anarray objectAtIndex: i];
 
-      [self _removeChildren: child];
+      [self _unloadChildren: child];
       NSMapRemove(_itemDict, child);
-      [_items removeObject: child];
       [_expandedItems removeObject: child];
     }
   [anarray removeAllObjects];
-  [self _noteNumberOfRowsChangedBelowItem: startitem by: -numChildren];
+}
+
+- (void) _rowsOfItemsChangedFromRow: (NSUInteger)row
+{
+  if (row < _rowOfItemCount)
+    {
+      _rowOfItemCount = row;
+    }
 }
 
 - (void) _noteNumberOfRowsChangedBelowItem: (id)item by: (NSInteger)numItems
+{
+  NSUInteger rowIndex = (item == nil) ? 0 : [self rowForItem: item] + 1;
+
+  [self _noteNumberOfRowsChangedAtRow: rowIndex by: numItems];
+}
+
+- (void) _noteNumberOfRowsChangedAtRow: (NSUInteger)rowIndex
+				    by: (NSInteger)numItems
 {
   BOOL selectionDidChange = NO;
-  NSUInteger rowIndex, nextIndex;
+  NSUInteger nextIndex;
 
   // check for trivial case
   if (numItems == 0)
     return;
 
-  // if a row below item is selected, update the selected row indexes
+  // if a row from rowIndex on is selected, update the selected row indexes
   /* Note: We update the selected row indexes directly instead of calling
    * -selectRowIndexes:extendingSelection: to avoid posting bogus selection
    * did change notifications. */
-  rowIndex = [_items indexOfObject: item];
-  rowIndex = (rowIndex == NSNotFound) ? 0 : rowIndex + 1;
   nextIndex = [_selectedRows indexGreaterThanOrEqualToIndex: rowIndex];
   if (nextIndex != NSNotFound)
     {
@@ -2246,13 +2619,147 @@ Also returns the child index relative to this parent. */
     }
 }
 
+- (void) _loadChildrenInBackground: (id)item
+{
+  GSOutlineChildLoader *loader;
+
+  loader = [[GSOutlineChildLoader alloc] initWithOutlineView: self
+							item: item
+					       lazyThreshold: _lazyChildrenThreshold];
+  NSMapInsert(_itemDict, item, [NSMutableArray array]);
+  NSMapInsert(_childLoaders, item, loader);
+  NSMapInsert(_levelOfItems, loader,
+	      [NSNumber numberWithInteger: [self levelForItem: item] + 1]);
+  [loader start];
+  RELEASE(loader);
+}
+
+- (void) _childLoader: (GSOutlineChildLoader *)loader
+      didLoadChildren: (NSArray *)children
+{
+  NSMutableArray *anarray = NSMapGet(_itemDict, loader->item);
+  id level = NSMapGet(_levelOfItems, loader);
+  NSUInteger i, count = [children count];
+  NSInteger row;
+
+  for (i = 0; i < count; i++)
+    {
+      NSMapInsert(_levelOfItems, [children objectAtIndex: i], level);
+    }
+  [anarray addObjectsFromArray: children];
+
+  // The new rows go before the placeholder, if the item is shown
+  row = [self rowForItem: loader];
+  if (row != -1 && count > 0)
+    {
+      [_items replaceObjectsInRange: NSMakeRange(row, 0)
+               withObjectsFromArray: children];
+      [self _rowsOfItemsChangedFromRow: row];
+      [self _noteNumberOfRowsChangedAtRow: row by: count];
+      [self setNeedsDisplay: YES];
+    }
+}
+
+- (void) _childLoaderDidFinish: (GSOutlineChildLoader *)loader
+{
+  NSInteger row = [self rowForItem: loader];
+
+  RETAIN(loader);
+  NSMapRemove(_childLoaders, loader->item);
+  NSMapRemove(_levelOfItems, loader);
+  NSMapRemove(_rowOfItem, loader);
+  if (row != -1)
+    {
+      [_items removeObjectAtIndex: row];
+      [self _rowsOfItemsChangedFromRow: row];
+      [self _noteNumberOfRowsChangedAtRow: row by: -1];
+      [self setNeedsDisplay: YES];
+    }
+  RELEASE(loader);
+}
+
+/* Stops loading the children of item in the background, if that is
+   going on, and forgets the children loaded so far.  The rows of the
+   item must have been removed already.  */
+- (void) _cancelChildLoaderForItem: (id)item
+{
+  GSOutlineChildLoader *loader;
+
+  if (item == nil || (loader = NSMapGet(_childLoaders, item)) == nil)
+    {
+      return;
+    }
+  [loader cancel];
+  NSMapRemove(_levelOfItems, loader);
+  NSMapRemove(_rowOfItem, loader);
+  [(NSMutableArray *)NSMapGet(_itemDict, item) removeAllObjects];
+  NSMapRemove(_childLoaders, item);
+}
+
+- (void) _cancelChildLoaders
+{
+  NSMapEnumerator e = NSEnumerateMapTable(_childLoaders);
+  void *key;
+  void *loader;
+
+  while (NSNextMapEnumeratorPair(&e, &key, &loader))
+    {
+      [(GSOutlineChildLoader *)loader cancel];
+    }
+  NSEndMapTableEnumeration(&e);
+  NSResetMapTable(_childLoaders);
+}
+
+/* Gets a child which was only shown by a stand in from the data source,
+   and puts it in the place of the stand in.  */
+- (id) _resolveLazyChild: (GSOutlineLazyChild *)lazy row: (NSInteger)row
+{
+  id parent = lazy->parent;
+  id sparent = (parent == nil) ? (id)[NSNull null] : (id)parent;
+  NSMutableArray *anarray = NSMapGet(_itemDict, sparent);
+  id level;
+  id child;
+
+  child = [_dataSource outlineView: self child: lazy->index ofItem: parent];
+  if (child == nil)
+    {
+      return nil;
+    }
+
+  RETAIN(lazy);
+  if (row < 0)
+    {
+      row = [self rowForItem: lazy];
+    }
+  level = NSMapGet(_levelOfItems, lazy);
+  if (level != nil)
+    {
+      NSMapInsert(_levelOfItems, child, level);
+    }
+  NSMapRemove(_levelOfItems, lazy);
+  if (lazy->index < [anarray count]
+      && [anarray objectAtIndex: lazy->index] == lazy)
+    {
+      [anarray replaceObjectAtIndex: lazy->index withObject: child];
+    }
+  if (row != -1)
+    {
+      [_items replaceObjectAtIndex: row withObject: child];
+      NSMapRemove(_rowOfItem, lazy);
+      NSMapInsert(_rowOfItem, child, (void *)row);
+    }
+  RELEASE(lazy);
+  return child;
+}
+
 - (NSCell *) preparedCellAtColumn: (NSInteger)columnIndex row: (NSInteger)rowIndex
 {
   NSCell *cell = nil;
   NSTableColumn *tb = [_tableColumns objectAtIndex: columnIndex];
 
   if ([_delegate respondsToSelector:
-        @selector(outlineView:dataCellForTableColumn:item:)])
+        @selector(outlineView:dataCellForTableColumn:item:)]
+      && !IS_PLACEHOLDER([_items objectAtIndex: rowIndex]))
     {
       id item = [self itemAtRow: rowIndex];
       cell = [_delegate outlineView: self dataCellForTableColumn: tb
@@ -29,6 +29,8 @@
 
 #import <Foundation/NSDictionary.h>
 #import <Foundation/NSException.h>
+#import <Foundation/NSHashTable.h>
+#import <Foundation/NSLock.h>
 #import "AppKit/NSParagraphStyle.h"
 
 @implementation NSTextTab
@@ -209,6 +211,75 @@
 
 static NSParagraphStyle	*defaultStyle = nil;
 
+/*
+ * Immutable copies of mutable styles are interned, so that equal styles
+ * are the same object.  Documents then keep one copy of each distinct
+ * style and comparing the attributes of two runs is mostly a pointer
+ * check.  The table does not retain the styles, instead an interned style
+ * leaves it when it is released for the last time, under the same lock
+ * as the lookups, so that a lookup never returns a style being freed.
+ */
+static NSHashTable	*internedStyles = nil;
+static NSLock		*internLock = nil;
+
+static NSUInteger
+styleHash(NSParagraphStyle *s)
+{
+  NSUInteger	h;
+
+  h = s->_alignment + (s->_lineBreakMode << 3) + (s->_baseDirection << 6)
+    + ([s->_tabStops count] << 8) + ((NSUInteger)s->_headerLevel << 13);
+  h ^= (NSUInteger)(NSInteger)(s->_headIndent * 4)
+    ^ ((NSUInteger)(NSInteger)(s->_firstLineHeadIndent * 4) << 7)
+    ^ ((NSUInteger)(NSInteger)(s->_tailIndent * 4) << 14)
+    ^ ((NSUInteger)(NSInteger)(s->_lineSpacing * 4) << 21)
+    ^ ((NSUInteger)(NSInteger)(s->_paragraphSpacing * 4) << 25);
+  if ([s->_tabStops count] > 0)
+    {
+      h ^= [[s->_tabStops lastObject] hash] << 16;
+    }
+  return h;
+}
+
+static NSUInteger
+internedHash(NSHashTable *t, const void *s)
+{
+  return ((NSParagraphStyle*)s)->_hash;
+}
+
+static BOOL
+internedEqual(NSHashTable *t, const void *a, const void *b)
+{
+  return [(NSParagraphStyle*)a isEqual: (NSParagraphStyle*)b];
+}
+
+/* Return the interned style equal to style, which is consumed.  */
+static NSParagraphStyle *
+internStyle(NSParagraphStyle *style)
+{
+  NSParagraphStyle	*found;
+
+  style->_hash = styleHash(style);
+  [internLock lock];
+  found = NSHashGet(internedStyles, style);
+  if (found != nil)
+    {
+      NSIncrementExtraRefCount(found);
+    }
+  else
+    {
+      style->_interned = YES;
+      NSHashInsertKnownAbsent(internedStyles, style);
+    }
+  [internLock unlock];
+  if (found != nil)
+    {
+      RELEASE(style);
+      return found;
+    }
+  return style;
+}
+
 + (NSParagraphStyle*) defaultParagraphStyle
 {
   if (defaultStyle == nil)
@@ -234,9 +305,15 @@ static NSParagraphStyle	*defaultStyle = nil;
 {
   if (self == [NSParagraphStyle class])
     {
+      NSHashTableCallBacks	callBacks = {
+	internedHash, internedEqual, NULL, NULL, NULL
+      };
+
       /* Set the class version to 2, as the writing direction is now 
 	 stored in the encoding */
       [self setVersion: 2];
+      internedStyles = NSCreateHashTable(callBacks, 64);
+      internLock = [NSLock new];
     }
 }
 
@@ -273,6 +350,24 @@ static NSParagraphStyle	*defaultStyle = nil;
   return writingDirection;  
 }
 
+- (oneway void) release
+{
+  if (_interned)
+    {
+      [internLock lock];
+      if (NSDecrementExtraRefCountWasZero(self))
+	{
+	  NSHashRemove(internedStyles, self);
+	  [internLock unlock];
+	  [self dealloc];
+	  return;
+	}
+      [internLock unlock];
+      return;
+    }
+  [super release];
+}
+
 - (void) dealloc
 {
   if (self == defaultStyle)
@@ -445,6 +540,7 @@ static NSParagraphStyle	*defaultStyle = nil;
       NSParagraphStyle	*c;
 
       c = (NSParagraphStyle*)NSCopyObject (self, 0, aZone);
+      c->_interned = NO;
       c->_textBlocks = [_textBlocks mutableCopyWithZone: aZone];
       c->_textLists = [_textLists mutableCopyWithZone: aZone];
       return c;
@@ -574,6 +670,9 @@ static NSParagraphStyle	*defaultStyle = nil;
     return YES;
   if ([other isKindOfClass: [NSParagraphStyle class]] == NO)
     return NO;
+  /* Equal styles are interned as a single object.  */
+  if (_interned && other->_interned)
+    return NO;
 
 #define C(x) if (x != other->x) return NO
   C(_lineSpacing);
@@ -591,14 +690,23 @@ static NSParagraphStyle	*defaultStyle = nil;
   C(_lineHeightMultiple);
   C(_tighteningFactorForTruncation);
   C(_headerLevel);
+  C(_baseDirection);
 #undef C
 
+  if ((_textBlocks != other->_textBlocks
+    && [_textBlocks isEqualToArray: other->_textBlocks] == NO)
+    || (_textLists != other->_textLists
+    && [_textLists isEqualToArray: other->_textLists] == NO))
+    return NO;
+
   return [_tabStops isEqualToArray: other->_tabStops];
 }
 
 - (NSUInteger) hash
 {
-  return _alignment + _lineBreakMode;
+  if (_interned)
+    return _hash;
+  return styleHash(self);
 }
 
 
@@ -808,6 +916,11 @@ static NSParagraphStyle	*defaultStyle = nil;
   c->_tabStops = [_tabStops mutableCopyWithZone: aZone];
   c->_textBlocks = [_textBlocks mutableCopyWithZone: aZone];
   c->_textLists = [_textLists mutableCopyWithZone: aZone];
+  c->_interned = NO;
+  if (aZone == NSDefaultMallocZone() || aZone == 0)
+    {
+      return (NSMutableParagraphStyle*)internStyle(c);
+    }
   return c;
 }
 
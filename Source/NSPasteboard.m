@@ -520,7 +520,9 @@
 
 #include "config.h"
 #import <Foundation/NSArray.h>
+#import <Foundation/NSByteOrder.h>
 #import <Foundation/NSData.h>
+#import <Foundation/NSDate.h>
 #import <Foundation/NSDebug.h>
 #import <Foundation/NSHost.h>
 #import <Foundation/NSDictionary.h>
@@ -528,6 +530,7 @@
 #import <Foundation/NSConnection.h>
 #import <Foundation/NSDistantObject.h>
 #import <Foundation/NSDistributedNotificationCenter.h>
+#import <Foundation/NSFileHandle.h>
 #import <Foundation/NSFileManager.h>
 #import <Foundation/NSMapTable.h>
 #import <Foundation/NSNotification.h>
@@ -543,8 +546,11 @@
 #import <Foundation/NSMethodSignature.h>
 #import <Foundation/NSRunLoop.h>
 #import <Foundation/NSSet.h>
+#import <Foundation/NSStream.h>
 #import <Foundation/NSTask.h>
 #import <Foundation/NSTimer.h>
+#import <Foundation/NSValue.h>
+#import <GNUstepBase/NSData+GNUstepBase.h>
 #import <GNUstepBase/NSTask+GNUstepBase.h>
 #import "AppKit/NSPasteboard.h"
 #import "AppKit/NSApplication.h"
@@ -627,6 +633,156 @@ static NSString	*namePrefix = @"NSTypedFilenamesPboardType:";
 }
 @end
 
+/*
+ * The filters registered with the services manager, indexed by the types
+ * they convert from and to.  Each index keeps the filters in the order
+ * of the services manager, so lookups pick the same filter as a scan of
+ * its list would.  The index is rebuilt when the services are reloaded.
+ */
+static NSLock			*filterLock = nil;
+static NSArray			*indexedFilters = nil;
+static NSMutableDictionary	*filtersFrom = nil;
+static NSMutableDictionary	*filtersTo = nil;
+
+/*
+ * Results of filter services, kept for a while so that converting the
+ * same data again doesn't run the filter again.  They are keyed by a
+ * digest of the data converted and the types and filter used.
+ */
+#define	FILTER_CACHE_AGE	60.0
+#define	FILTER_CACHE_SIZE	(16 * 1024 * 1024)
+
+static NSMutableDictionary	*filterResults = nil;
+static NSUInteger		filterResultsSize = 0;
+
+static void
+addFilterToIndex(NSMutableDictionary *index, NSArray *types,
+  NSDictionary *info)
+{
+  NSEnumerator	*e = [types objectEnumerator];
+  NSString	*type;
+
+  while ((type = [e nextObject]) != nil)
+    {
+      NSMutableArray	*a = [index objectForKey: type];
+
+      if (a == nil)
+	{
+	  a = [NSMutableArray arrayWithCapacity: 2];
+	  [index setObject: a forKey: type];
+	}
+      if ([a indexOfObjectIdenticalTo: info] == NSNotFound)
+	{
+	  [a addObject: info];
+	}
+    }
+}
+
+/* Returns the filters converting from (or to) type.
+ */
+static NSArray *
+filtersForType(NSString *type, BOOL to)
+{
+  NSArray	*filters = [[GSServicesManager manager] filters];
+  NSArray	*result;
+
+  [filterLock lock];
+  if (filters != indexedFilters)
+    {
+      NSEnumerator	*e = [filters objectEnumerator];
+      NSDictionary	*info;
+
+      ASSIGN(indexedFilters, filters);
+      DESTROY(filtersFrom);
+      DESTROY(filtersTo);
+      filtersFrom = [NSMutableDictionary new];
+      filtersTo = [NSMutableDictionary new];
+      while ((info = [e nextObject]) != nil)
+	{
+	  addFilterToIndex(filtersFrom,
+	    [info objectForKey: @"NSSendTypes"], info);
+	  addFilterToIndex(filtersTo,
+	    [info objectForKey: @"NSReturnTypes"], info);
+	}
+    }
+  result = RETAIN([(to ? filtersTo : filtersFrom) objectForKey: type]);
+  [filterLock unlock];
+  return AUTORELEASE(result);
+}
+
+static NSData *
+cachedFilterResult(NSString *key)
+{
+  NSArray	*entry;
+  NSData	*result = nil;
+
+  [filterLock lock];
+  entry = [filterResults objectForKey: key];
+  if (entry != nil)
+    {
+      if ([[entry objectAtIndex: 1] timeIntervalSinceNow] > -FILTER_CACHE_AGE)
+	{
+	  result = AUTORELEASE(RETAIN([entry objectAtIndex: 0]));
+	}
+      else
+	{
+	  filterResultsSize -= [[entry objectAtIndex: 0] length];
+	  [filterResults removeObjectForKey: key];
+	}
+    }
+  [filterLock unlock];
+  return result;
+}
+
+static void
+storeFilterResult(NSString *key, NSData *result)
+{
+  NSUInteger	length = [result length];
+
+  if (key == nil || result == nil || length > FILTER_CACHE_SIZE / 4)
+    {
+      return;
+    }
+  result = AUTORELEASE([result copy]);
+  [filterLock lock];
+  if (filterResults == nil)
+    {
+      filterResults = [NSMutableDictionary new];
+    }
+  /* Make room by dropping expired results, then the oldest ones. */
+  while ([filterResults count] > 0
+    && filterResultsSize + length > FILTER_CACHE_SIZE)
+    {
+      NSEnumerator	*e = [filterResults keyEnumerator];
+      NSString		*k;
+      NSString		*oldest = nil;
+      NSDate		*oldestDate = nil;
+
+      while ((k = [e nextObject]) != nil)
+	{
+	  NSDate	*d = [[filterResults objectForKey: k] objectAtIndex: 1];
+
+	  if (oldestDate == nil || [d compare: oldestDate] == NSOrderedAscending)
+	    {
+	      oldest = k;
+	      oldestDate = d;
+	    }
+	}
+      filterResultsSize
+	-= [[[filterResults objectForKey: oldest] objectAtIndex: 0] length];
+      [filterResults removeObjectForKey: oldest];
+    }
+  if ([filterResults objectForKey: key] != nil)
+    {
+      filterResultsSize
+	-= [[[filterResults objectForKey: key] objectAtIndex: 0] length];
+    }
+  [filterResults setObject: [NSArray arrayWithObjects: result, [NSDate date],
+    nil] forKey: key];
+  filterResultsSize += length;
+  [filterLock unlock];
+}
+
 @implementation	GSFiltered
 
 /**
@@ -636,31 +792,69 @@ static NSString	*namePrefix = @"NSTypedFilenamesPboardType:";
 + (NSArray*) _typesFilterableFrom: (NSArray*)from
 {
   NSMutableSet	*types = [NSMutableSet setWithCapacity: 8];
-  NSArray	*filters = [[GSServicesManager manager] filters];
-  NSUInteger	c = [filters count];
   NSUInteger 	i;
 
   for (i = 0; i < [from count]; i++)
     {
-      NSString *type = [from objectAtIndex: i];
-      NSUInteger j;
+      NSString		*type = [from objectAtIndex: i];
+      NSEnumerator	*e;
+      NSDictionary	*info;
 
       [types addObject: type];	// Always include original type
 
-      for (j = 0; j < c; j++)
+      e = [filtersForType(type, NO) objectEnumerator];
+      while ((info = [e nextObject]) != nil)
 	{
-	  NSDictionary	*info = [filters objectAtIndex: j];
-	  NSArray	*sendTypes = [info objectForKey: @"NSSendTypes"];
+	  [types addObjectsFromArray: [info objectForKey: @"NSReturnTypes"]];
+	}
+    }
+  return [types allObjects];
+}
 
-	  if ([sendTypes containsObject: type] == YES)
-	    {
-	      NSArray	*returnTypes = [info objectForKey: @"NSReturnTypes"];
+/*
+ * Returns the key for the result of converting our data from fromType to
+ * type with the filter described by info, or nil if the result can't
+ * be cached because the data is the name of a file the filter reads.
+ */
+- (NSString*) _keyForFilter: (NSDictionary*)info
+		   fromType: (NSString*)fromType
+		     toType: (NSString*)type
+{
+  NSString	*mechanism = [info objectForKey: @"NSInputMechanism"];
+  NSString	*source;
 
-	      [types addObjectsFromArray: returnTypes];
-	    }
+  if (file != nil)
+    {
+      NSDictionary	*attrs;
+
+      attrs = [[NSFileManager defaultManager] fileAttributesAtPath: file
+						      traverseLink: YES];
+      if (attrs == nil)
+	{
+	  return nil;
 	}
+      source = [NSString stringWithFormat: @"%@ %llu %f", file,
+	[attrs fileSize],
+	[[attrs fileModificationDate] timeIntervalSinceReferenceDate]];
     }
-  return [types allObjects];
+  else if ([mechanism isEqualToString: @"NSUnixStdio"] == YES
+    || [mechanism isEqualToString: @"NSMapFile"] == YES)
+    {
+      return nil;
+    }
+  else
+    {
+      NSData	*d = (data != nil) ? data : [pboard dataForType: fromType];
+
+      if (d == nil)
+	{
+	  return nil;
+	}
+      source = [[d md5Digest] hexadecimalRepresentation];
+    }
+  return [NSString stringWithFormat: @"%@ %@ %@ %@ %@ %@", source,
+    fromType, type, [info objectForKey: @"NSPortName"],
+    [info objectForKey: @"NSExecutable"], [info objectForKey: @"NSFilter"]];
 }
 
 - (void) dealloc
@@ -681,6 +875,7 @@ static NSString	*namePrefix = @"NSTypedFilenamesPboardType:";
   NSDictionary	*info;
   NSString	*fromType = nil;
   NSString	*mechanism;
+  NSString	*key = nil;
 
   NSAssert(sender == self, NSInvalidArgumentException);
 
@@ -705,7 +900,7 @@ static NSString	*namePrefix = @"NSTypedFilenamesPboardType:";
        * converting from and the name of the filter to use.
        */
       info = nil;
-      filters = [[GSServicesManager manager] filters];
+      filters = filtersForType(type, YES);
       count = [filters count];
       while (fromType == nil && filterNumber < count)
 	{
@@ -735,6 +930,18 @@ static NSString	*namePrefix = @"NSTypedFilenamesPboardType:";
 	  NSWarnMLog(@"Unable to provide data of type '%@'.", type);
 	  return;
 	}
+
+      key = [self _keyForFilter: info fromType: fromType toType: type];
+      if (key != nil)
+	{
+	  NSData	*d = cachedFilterResult(key);
+
+	  if (d != nil)
+	    {
+	      [sender setData: d forType: type];
+	      return;
+	    }
+	}
     }
 
   mechanism = [info objectForKey: @"NSInputMechanism"];
@@ -824,6 +1031,7 @@ static NSString	*namePrefix = @"NSTypedFilenamesPboardType:";
       /*
        * And send it on.
        */
+      storeFilterResult(key, m);
       [sender setData: [GSByrefObject byrefWithObject: m] forType: type];
     }
   else if ([mechanism isEqualToString: @"NSMapFile"] == YES)
@@ -901,6 +1109,7 @@ static NSString	*namePrefix = @"NSTypedFilenamesPboardType:";
       NSString		*selName;
       NSString		*userData;
       NSString		*error = nil;
+      NSData		*d;
 
       /*
        * Put data onto a pasteboard that can be used by the service provider.
@@ -1025,8 +1234,9 @@ static NSString	*namePrefix = @"NSTypedFilenamesPboardType:";
       /*
        * Finally, make it available.
        */
-      [sender setData: [GSByrefObject byrefWithObject: [tmp dataForType: type]]
-	      forType: type];
+      d = [tmp dataForType: type];
+      storeFilterResult(key, d);
+      [sender setData: [GSByrefObject byrefWithObject: d] forType: type];
     }
 }
 
@@ -1041,6 +1251,9 @@ static NSString	*namePrefix = @"NSTypedFilenamesPboardType:";
 + (NSPasteboard*) _pasteboardWithTarget: (id<GSPasteboardObj>)aTarget
 				   name: (NSString*)aName;
 - (id) _target;
+- (NSData*) _dataOrReferenceForType: (NSString*)dataType;
+- (void) _dropCachedTypes;
+- (NSArray*) _cachedTypes;
 @end
 
 /**
@@ -1073,6 +1286,172 @@ static NSString	*namePrefix = @"NSTypedFilenamesPboardType:";
  * NSPasteboardOwner informal protocol in order to do this.
  * </p>
  */
+/*
+ * Data of at least this size is not sent to the pasteboard server.  It
+ * is written to a file which readers map into memory, and the server
+ * only holds a small reference to the file.  Files are kept in a
+ * directory per pasteboard and are removed when new types are declared
+ * on the pasteboard.
+ */
+#define	LARGE_DATA_SIZE	(4 * 1024 * 1024)
+
+/*
+ * The types and change count of a pasteboard are fetched from the server
+ * once and answered locally until the current run loop pass ends, the
+ * process changes the pasteboard itself, or this many seconds passed.
+ * Validating a menu for one event thus costs one round trip, while
+ * changes made by other processes are seen in the next pass.
+ */
+#define	TYPES_CACHE_AGE	0.5
+
+static const char	largeDataMagic[] = "GSPasteboardLargeData";
+
+static NSString *
+largeDataDirectory(NSString *pbName)
+{
+  NSString	*dir;
+
+  dir = [NSTemporaryDirectory() stringByAppendingPathComponent:
+    [NSString stringWithFormat: @"GSPasteboard-%@", NSUserName()]];
+  pbName = [[pbName componentsSeparatedByString: @"/"]
+    componentsJoinedByString: @"_"];
+  return [dir stringByAppendingPathComponent: pbName];
+}
+
+/* Creates a new file for large data of the pasteboard, holding data if
+ * that is not nil.  Returns its path, or nil if it can't be created.
+ */
+static NSString *
+newLargeDataFile(NSString *pbName, NSData *data)
+{
+  NSFileManager		*mgr = [NSFileManager defaultManager];
+  NSString		*dir = largeDataDirectory(pbName);
+  NSString		*path;
+  NSDictionary		*attrs;
+
+  attrs = [NSDictionary dictionaryWithObject: [NSNumber numberWithInt: 0700]
+				      forKey: NSFilePosixPermissions];
+  if ([mgr createDirectoryAtPath: dir
+     withIntermediateDirectories: YES
+		      attributes: attrs
+			   error: NULL] == NO)
+    {
+      return nil;
+    }
+  path = [dir stringByAppendingPathComponent:
+    [[NSProcessInfo processInfo] globallyUniqueString]];
+  attrs = [NSDictionary dictionaryWithObject: [NSNumber numberWithInt: 0600]
+				      forKey: NSFilePosixPermissions];
+  if ([mgr createFileAtPath: path contents: data attributes: attrs] == NO)
+    {
+      return nil;
+    }
+  return path;
+}
+
+/* Returns the reference to send to the server in place of the data of
+ * length bytes held in the file at path.
+ */
+static NSData *
+largeDataReferenceForFile(NSString *path, unsigned long long length)
+{
+  NSMutableData		*ref;
+  const char		*file;
+
+  file = [path fileSystemRepresentation];
+  length = NSSwapHostLongLongToBig(length);
+  ref = [NSMutableData dataWithBytes: largeDataMagic
+			      length: sizeof(largeDataMagic)];
+  [ref appendBytes: &length length: sizeof(length)];
+  [ref appendBytes: file length: strlen(file)];
+  return ref;
+}
+
+/* Writes data to a new file for the pasteboard and returns the reference
+ * to send to the server in its place, or nil if the file can't be
+ * written.
+ */
+static NSData *
+largeDataReference(NSData *data, NSString *pbName)
+{
+  NSString	*path = newLargeDataFile(pbName, data);
+
+  if (path == nil)
+    {
+      return nil;
+    }
+  return largeDataReferenceForFile(path, [data length]);
+}
+
+/* If d is a reference to large data, returns the path of the file it
+ * refers to and sets *length to the length of the data.  Returns nil
+ * for any other data.
+ */
+static NSString *
+largeDataPath(NSData *d, unsigned long long *length)
+{
+  NSUInteger		headerLength;
+
+  headerLength = sizeof(largeDataMagic) + sizeof(*length);
+  if ([d length] <= headerLength || [d length] > headerLength + 4096
+    || memcmp([d bytes], largeDataMagic, sizeof(largeDataMagic)) != 0)
+    {
+      return nil;
+    }
+
+  memcpy(length, (const char*)[d bytes] + sizeof(largeDataMagic),
+    sizeof(*length));
+  *length = NSSwapBigLongLongToHost(*length);
+  return [[NSFileManager defaultManager]
+    stringWithFileSystemRepresentation:
+      (const char*)[d bytes] + headerLength
+				length: [d length] - headerLength];
+}
+
+/* If d is a reference to large data, returns the data of the file it
+ * refers to, mapped into memory.  Returns nil if the file has gone or
+ * changed.  Other data is returned as it is.
+ */
+static NSData *
+resolveLargeData(NSData *d)
+{
+  unsigned long long	length;
+  NSString		*path;
+  NSData		*mapped;
+
+  if ((path = largeDataPath(d, &length)) == nil)
+    {
+      return d;
+    }
+  mapped = [NSData dataWithContentsOfMappedFile: path];
+  if ([mapped length] != length)
+    {
+      NSDebugLLog(@"NSPasteboard", @"Large pasteboard data %@ is gone",
+	path);
+      return nil;
+    }
+  return mapped;
+}
+
+/* Removes the files holding large data of a pasteboard.  Readers which
+ * mapped one of them keep their data.
+ */
+static void
+removeLargeData(NSString *pbName)
+{
+  NSFileManager	*mgr = [NSFileManager defaultManager];
+  NSString	*dir = largeDataDirectory(pbName);
+  NSEnumerator	*e;
+  NSString	*file;
+
+  e = [[mgr directoryContentsAtPath: dir] objectEnumerator];
+  while ((file = [e nextObject]) != nil)
+    {
+      [mgr removeFileAtPath: [dir stringByAppendingPathComponent: file]
+		    handler: nil];
+    }
+}
+
 @implementation NSPasteboard
 
 static	NSRecursiveLock		*dictionary_lock = nil;
@@ -1105,6 +1484,7 @@ static  NSMapTable              *mimeMap = NULL;
       // Initial version
       [self setVersion: 1];
       dictionary_lock = [[NSRecursiveLock alloc] init];
+      filterLock = [NSLock new];
       pasteboards = NSCreateMapTable (NSObjectMapKeyCallBacks,
 	NSNonRetainedObjectMapValueCallBacks, 0);
     }
@@ -1292,25 +1672,17 @@ static  NSMapTable              *mimeMap = NULL;
 + (NSArray*) typesFilterableTo: (NSString*)type
 {
   NSMutableSet	*types = [NSMutableSet setWithCapacity: 8];
-  NSArray	*filters = [[GSServicesManager manager] filters];
-  NSEnumerator	*enumerator = [filters objectEnumerator];
+  NSEnumerator	*enumerator = [filtersForType(type, YES) objectEnumerator];
   NSDictionary	*info;
 
   [types addObject: type];	// Always include original type
 
   /*
-   * Step through the filters looking for those which handle the type
+   * Step through the filters which produce the type
    */
   while ((info = [enumerator nextObject]) != nil)
     {
-      NSArray	*returnTypes = [info objectForKey: @"NSReturnTypes"];
-
-      if ([returnTypes containsObject: type] == YES)
-	{
-	  NSArray	*sendTypes = [info objectForKey: @"NSSendTypes"];
-
-	  [types addObjectsFromArray: sendTypes];
-	}
+      [types addObjectsFromArray: [info objectForKey: @"NSSendTypes"]];
     }
 
   return [types allObjects];
@@ -1333,6 +1705,7 @@ static  NSMapTable              *mimeMap = NULL;
 
   NS_DURING
     {
+      [self _dropCachedTypes];
       count = [target addTypes: newTypes
 			 owner: newOwner
 		    pasteboard: self
@@ -1418,6 +1791,8 @@ static  NSMapTable              *mimeMap = NULL;
 - (int) declareTypes: (NSArray*)newTypes
 	       owner: (id)newOwner
 {
+  removeLargeData(name);
+  [self _dropCachedTypes];
   NS_DURING
     {
       changeCount = [target declareTypes: newTypes
@@ -1436,6 +1811,7 @@ static  NSMapTable              *mimeMap = NULL;
 - (void) dealloc
 {
   DESTROY(target);
+  DESTROY(cachedTypes);
   [dictionary_lock lock];
   if (NSMapGet(pasteboards, (void*)name) == (void*)self)
     {
@@ -1497,6 +1873,7 @@ static  NSMapTable              *mimeMap = NULL;
       [NSException raise: NSGenericException
 		  format: @"Illegal attempt to globally release %@", name];
     }
+  [self _dropCachedTypes];
   [target releaseGlobally];
   [dictionary_lock lock];
   if (NSMapGet(pasteboards, (void*)name) == (void*)self)
@@ -1543,6 +1920,15 @@ static  NSMapTable              *mimeMap = NULL;
 {
   BOOL	ok = NO;
 
+  if ([data length] >= LARGE_DATA_SIZE)
+    {
+      NSData	*ref = largeDataReference(data, name);
+
+      if (ref != nil)
+	{
+	  data = ref;
+	}
+    }
   NS_DURING
     {
       ok = [target setData: data
@@ -1729,24 +2115,18 @@ static  NSMapTable              *mimeMap = NULL;
  */
 - (NSString*) availableTypeFromArray: (NSArray*)types
 {
-  NSString *type = nil;
+  NSArray	*available = [self _cachedTypes];
+  NSEnumerator	*e = [types objectEnumerator];
+  NSString	*type;
 
-  NS_DURING
+  while ((type = [e nextObject]) != nil)
     {
-      int	count = 0;
-
-      type = [target availableTypeFromArray: types
-				changeCount: &count];
-      changeCount = count;
-    }
-  NS_HANDLER
-    {
-      type = nil;
-      [NSException raise: NSPasteboardCommunicationException
-		  format: @"%@", [localException reason]];
+      if ([available containsObject: type])
+	{
+	  return type;
+	}
     }
-  NS_ENDHANDLER
-  return type;
+  return nil;
 }
 
 /**
@@ -1755,23 +2135,7 @@ static  NSMapTable              *mimeMap = NULL;
  */
 - (NSArray*) types
 {
-  NSArray *result = nil;
-
-  NS_DURING
-    {
-      int	count = 0;
-
-      result = [target typesAndChangeCount: &count];
-      changeCount = count;
-    }
-  NS_HANDLER
-    {
-      result = nil;
-      [NSException raise: NSPasteboardCommunicationException
-		  format: @"%@", [localException reason]];
-    }
-  NS_ENDHANDLER
-  return result;
+  return [self _cachedTypes];
 }
 
 /**
@@ -1780,19 +2144,7 @@ static  NSMapTable              *mimeMap = NULL;
  */
 - (int) changeCount
 {
-  NS_DURING
-    {
-      int	count;
-
-      count = [target changeCount];
-      changeCount = count;
-    }
-  NS_HANDLER
-    {
-      [NSException raise: NSPasteboardCommunicationException
-		  format: @"%@", [localException reason]];
-    }
-  NS_ENDHANDLER
+  [self _cachedTypes];
   return changeCount;
 }
 
@@ -1803,22 +2155,7 @@ static  NSMapTable              *mimeMap = NULL;
  */
 - (NSData*) dataForType: (NSString*)dataType
 {
-  NSData	*d = nil;
-
-  NS_DURING
-    {
-      d = [target dataForType: dataType
-		     oldCount: changeCount
-		mustBeCurrent: (useHistory == NO) ? YES : NO];
-    }
-  NS_HANDLER
-    {
-      d = nil;
-      [NSException raise: NSPasteboardCommunicationException
-		  format: @"%@", [localException reason]];
-    }
-  NS_ENDHANDLER
-  return d;
+  return resolveLargeData([self _dataOrReferenceForType: dataType]);
 }
 
 /**
@@ -1914,6 +2251,30 @@ static  NSMapTable              *mimeMap = NULL;
 
 @implementation NSPasteboard (Private)
 
+/*
+ *	Returns the data held by the server, which for large data is a
+ *	reference to the file holding it.
+ */
+- (NSData*) _dataOrReferenceForType: (NSString*)dataType
+{
+  NSData	*d = nil;
+
+  NS_DURING
+    {
+      d = [target dataForType: dataType
+		     oldCount: changeCount
+		mustBeCurrent: (useHistory == NO) ? YES : NO];
+    }
+  NS_HANDLER
+    {
+      d = nil;
+      [NSException raise: NSPasteboardCommunicationException
+		  format: @"%@", [localException reason]];
+    }
+  NS_ENDHANDLER
+  return d;
+}
+
 /*
  *	Special method to use a local server rather than connecting over DO
  */
@@ -2132,6 +2493,7 @@ description, [cmd stringByDeletingLastPathComponent]);
 	  [p autorelease];
 	}
     }
+  [p _dropCachedTypes];
   p->changeCount = [p->target changeCount];
   [dictionary_lock unlock];
   return p;
@@ -2142,6 +2504,58 @@ description, [cmd stringByDeletingLastPathComponent]);
   return target;
 }
 
+- (void) _dropCachedTypes
+{
+  DESTROY(cachedTypes);
+}
+
+/*
+ *	Returns the types on the pasteboard, fetching them and the change
+ *	count from the server unless they were fetched during the current
+ *	run loop pass.
+ */
+- (NSArray*) _cachedTypes
+{
+  NSTimeInterval	now = [NSDate timeIntervalSinceReferenceDate];
+
+  if (cachedTypes != nil && now - cachedAt < TYPES_CACHE_AGE)
+    {
+      changeCount = cachedCount;
+      return cachedTypes;
+    }
+
+  DESTROY(cachedTypes);
+  NS_DURING
+    {
+      int	count = 0;
+      NSArray	*result;
+
+      result = [target typesAndChangeCount: &count];
+      changeCount = count;
+      if (result != nil)
+	{
+	  ASSIGN(cachedTypes, result);
+	  cachedCount = count;
+	  cachedAt = now;
+	  [[NSRunLoop currentRunLoop]
+	    performSelector: @selector(_dropCachedTypes)
+		     target: self
+		   argument: nil
+		      order: 0
+		      modes: [NSArray arrayWithObjects: NSDefaultRunLoopMode,
+			NSModalPanelRunLoopMode, NSEventTrackingRunLoopMode,
+			nil]];
+	}
+    }
+  NS_HANDLER
+    {
+      [NSException raise: NSPasteboardCommunicationException
+		  format: @"%@", [localException reason]];
+    }
+  NS_ENDHANDLER
+  return AUTORELEASE(RETAIN(cachedTypes));
+}
+
 @end
 
 
@@ -2197,6 +2611,120 @@ description, [cmd stringByDeletingLastPathComponent]);
   NS_ENDHANDLER
 }
 
+/**
+ * Returns a stream reading the data of dataType from the pasteboard, or
+ * nil if no such data is available.  Large data is read from the file
+ * the writer put it in, a chunk at a time, rather than being loaded
+ * into memory as a whole.<br />
+ * May raise an exception if communication with the pasteboard server fails.
+ */
+- (NSInputStream*) inputStreamForType: (NSString*)dataType
+{
+  NSData		*d = [self _dataOrReferenceForType: dataType];
+  NSString		*path;
+  unsigned long long	length;
+
+  if (d == nil)
+    {
+      return nil;
+    }
+  if ((path = largeDataPath(d, &length)) != nil)
+    {
+      NSDictionary	*attrs;
+
+      attrs = [[NSFileManager defaultManager] fileAttributesAtPath: path
+						      traverseLink: NO];
+      if (attrs == nil || [attrs fileSize] != length)
+	{
+	  return nil;
+	}
+      return [NSInputStream inputStreamWithFileAtPath: path];
+    }
+  return [NSInputStream inputStreamWithData: d];
+}
+
+/**
+ * Writes the data of dataType read from stream to the pasteboard.  The
+ * data is taken from the stream a chunk at a time and written to a file
+ * which readers map or stream from, so it never needs to be held in
+ * memory as a whole.  The stream is opened if it is not open already and
+ * is read until its end, so an owner can hand over data as it produces
+ * it, for instance from its -pasteboard:provideDataForType: method.<br />
+ * Returns YES on success, NO if the stream reports an error or the data
+ * could not be written.
+ */
+- (BOOL) setDataFromStream: (NSInputStream*)stream
+		   forType: (NSString*)dataType
+{
+  NSString		*path;
+  NSFileHandle		*handle;
+  NSData		*data;
+  unsigned long long	length = 0;
+  uint8_t		buffer[65536];
+  NSInteger		n;
+  BOOL			ok;
+
+  if ((path = newLargeDataFile(name, nil)) == nil
+    || (handle = [NSFileHandle fileHandleForWritingAtPath: path]) == nil)
+    {
+      return NO;
+    }
+  if ([stream streamStatus] == NSStreamStatusNotOpen)
+    {
+      [stream open];
+    }
+  NS_DURING
+    {
+      while ((n = [stream read: buffer maxLength: sizeof(buffer)]) > 0)
+	{
+	  [handle writeData: [NSData dataWithBytesNoCopy: buffer
+						   length: n
+					     freeWhenDone: NO]];
+	  length += n;
+	}
+    }
+  NS_HANDLER
+    {
+      n = -1;
+    }
+  NS_ENDHANDLER
+  [handle closeFile];
+  [stream close];
+
+  if (n < 0)
+    {
+      [[NSFileManager defaultManager] removeFileAtPath: path handler: nil];
+      return NO;
+    }
+
+  /* Small data goes to the server as it is. */
+  if (length < LARGE_DATA_SIZE)
+    {
+      data = [NSData dataWithContentsOfFile: path];
+      [[NSFileManager defaultManager] removeFileAtPath: path handler: nil];
+    }
+  else
+    {
+      data = largeDataReferenceForFile(path, length);
+    }
+
+  NS_DURING
+    {
+      ok = [target setData: data
+		   forType: dataType
+		    isFile: NO
+		  oldCount: changeCount];
+    }
+  NS_HANDLER
+    {
+      ok = NO;
+      [NSException raise: NSPasteboardCommunicationException
+		  format: @"%@", [localException reason]];
+    }
+  NS_ENDHANDLER
+  return ok;
+}
+
 + (void) _initMimeMappings
 {
   mimeMap = NSCreateMapTable(NSObjectMapKeyCallBacks,
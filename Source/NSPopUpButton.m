@@ -523,7 +523,7 @@ this to return nil to indicate that we have no context menu.
 
 	    menuView = [[_cell menu] menuRepresentation];
 	    selectedIndex = [menuView highlightedItemIndex];
-	    numberOfItems = [self numberOfItems];
+	    numberOfItems = [[_cell menu] numberOfItems];
 
 	    switch (selectedIndex)
 	      {
@@ -547,7 +547,7 @@ this to return nil to indicate that we have no context menu.
 
 	    menuView = [[_cell menu] menuRepresentation];
 	    selectedIndex = [menuView highlightedItemIndex];
-	    numberOfItems = [self numberOfItems];
+	    numberOfItems = [[_cell menu] numberOfItems];
 
 	    if (selectedIndex < numberOfItems-1)
 	      [menuView setHighlightedItemIndex: selectedIndex + 1];
@@ -41,6 +41,10 @@
 #import "AppKit/NSWindow.h"
 #import "GNUstepGUI/GSTheme.h"
 #import "GSBindingHelpers.h"
+#import "GSGuiPrivate.h"
+
+/* The number of items of an item data source held by the menu */
+#define ITEM_DATA_WINDOW 50
 
 /* The image to use in a specific popupbutton depends on type and
  * preferred edge; that is, _pbc_image[0] if it is a
@@ -52,6 +56,12 @@ static NSImage *_pbc_image[5];
 - (void) _popUpItemAction: (id)sender;
 @end
 
+@interface NSPopUpButtonCell (ItemData)
+- (NSInteger) _menuIndexOfItemData: (NSInteger)index;
+- (void) _loadItemDataFrom: (NSInteger)first;
+- (void) _showMoreItems: (id)sender;
+@end
+
 @implementation NSPopUpButtonCell
 + (void) initialize
 {
@@ -450,7 +460,7 @@ static NSImage *_pbc_image[5];
  */
 - (void) removeItemAtIndex: (NSInteger)index
 {
-  if (index == [self indexOfSelectedItem])
+  if (index == [_menu indexOfItem: _selectedItem])
     {
       [self selectItem: nil];
     }
@@ -485,6 +495,10 @@ static NSImage *_pbc_image[5];
  */
 - (NSInteger) numberOfItems
 {
+  if (_itemDataSource != nil)
+    {
+      return [_itemDataSource numberOfItemsInPopUpButtonCell: self];
+    }
   return [_menu numberOfItems];
 }
 
@@ -534,6 +548,10 @@ static NSImage *_pbc_image[5];
  */ 
 - (id <NSMenuItem>) itemAtIndex: (NSInteger)index
 {
+  if (_itemDataSource != nil)
+    {
+      index = [self _menuIndexOfItemData: index];
+    }
   if ((index >= 0) && (index < [_menu numberOfItems]))
     {
       return [_menu itemAtIndex: index];
@@ -656,6 +674,11 @@ static NSImage *_pbc_image[5];
 {
   id<NSMenuItem> oldSelectedItem = _selectedItem;
 
+  if (_itemDataSource != nil && !_itemDataReloading)
+    {
+      _itemDataSelection = (item == nil) ? -1 : [item tag];
+    }
+
   if (_selectedItem == item)
     {
       // pull-down should set highlighted item even when selection is unchanged
@@ -701,6 +724,15 @@ static NSImage *_pbc_image[5];
 {
   id <NSMenuItem> anItem;
 
+  if (_itemDataSource != nil && index >= 0 && index < [self numberOfItems]
+      && [self _menuIndexOfItemData: index] < 0)
+    {
+      /* Hold the items around the new selection in the menu.  */
+      _itemDataSelection = index;
+      [self _loadItemDataFrom: index - ITEM_DATA_WINDOW / 2];
+      return;
+    }
+
   if (index < 0) 
     anItem = nil;
   else
@@ -798,6 +830,10 @@ static NSImage *_pbc_image[5];
 
 - (NSInteger) indexOfSelectedItem
 {
+  if (_itemDataSource != nil)
+    {
+      return _itemDataSelection;
+    }
   return [_menu indexOfItem: [self selectedItem]];
 }
 
@@ -808,6 +844,28 @@ static NSImage *_pbc_image[5];
   if (!_pbcFlags.usesItemFromMenu)
     return;
 
+  if (_itemDataReloading)
+    return;
+
+  if (_itemDataSource != nil && !_pbcFlags.pullsDown)
+    {
+      /* The selected item may not be in the menu, in which case the
+         item showing its title is kept.  */
+      index = [[_menu menuRepresentation] highlightedItemIndex];
+      if (index >= 0 && index < [_menu numberOfItems]
+          && [[_menu itemAtIndex: index] tag] >= 0)
+        {
+          [self selectItem: [_menu itemAtIndex: index]];
+        }
+      if (_selectedItem != nil || _itemDataSelection < 0)
+        {
+          [self setMenuItem: (NSMenuItem *)_selectedItem];
+        }
+      if ([_control_view isKindOfClass: [NSControl class]])
+        [(NSControl *)_control_view updateCell: self];
+      return;
+    }
+
   if ([_menu numberOfItems] == 0)
     {
       index = -1;
@@ -823,12 +881,12 @@ static NSImage *_pbc_image[5];
       if (index < 0) 
         {
           // If no item is highighted, display the selected one, if there is one.
-          index = [self indexOfSelectedItem];
+          index = [_menu indexOfItem: _selectedItem];
         }
       else 
         {
           // Selected the highlighted item
-          [self selectItemAtIndex: index];
+          [self selectItem: [_menu itemAtIndex: index]];
         }
     }
 
@@ -857,6 +915,12 @@ static NSImage *_pbc_image[5];
  */
 - (NSString *) itemTitleAtIndex: (NSInteger)index
 {
+  if (_itemDataSource != nil)
+    {
+      if (index < 0 || index >= [self numberOfItems])
+        return nil;
+      return [_itemDataSource popUpButtonCell: self titleOfItemAtIndex: index];
+    }
   return [[self itemAtIndex: index] title];
 }
 
@@ -887,6 +951,8 @@ static NSImage *_pbc_image[5];
 
   if (item != nil)
     return [item title];
+  else if (_itemDataSource != nil && _itemDataSelection >= 0)
+    return [self itemTitleAtIndex: _itemDataSelection];
   else
     return @"";
 }
@@ -909,6 +975,10 @@ static NSImage *_pbc_image[5];
   [nc postNotificationName: NSPopUpButtonWillPopUpNotification
                     object: controlView];
 
+  // Remember where we pop up, to pop up again with other items
+  _popUpFrame = cellFrame;
+  _popUpView = controlView;
+
   // Convert to Screen Coordinates
   cellFrame = [controlView convertRect: cellFrame toView: nil];
   cellFrame.origin = [cvWin convertBaseToScreen: cellFrame.origin];
@@ -917,7 +987,7 @@ static NSImage *_pbc_image[5];
     selectedItem = -1;
   else
     {
-      selectedItem = [self indexOfSelectedItem];
+      selectedItem = [_menu indexOfItem: _selectedItem];
       if (selectedItem == -1)
 	{
 	  selectedItem = 0;
@@ -986,6 +1056,12 @@ static NSImage *_pbc_image[5];
     {
       [self dismissPopUp];
       [self synchronizeTitleAndSelectedItem];
+      if (_reopensPopUp && _popUpView != nil && !_trackingPopUp)
+        {
+          /* Another part of the items of the data source was chosen.  */
+          _reopensPopUp = NO;
+          [self attachPopUpWithFrame: _popUpFrame inView: _popUpView];
+        }
     }
 }
 
@@ -1031,8 +1107,18 @@ static NSImage *_pbc_image[5];
 
   // Send the event directly to the popup window, as it may not be located
   // at the event position.
+  _trackingPopUp = YES;
   [mr mouseDown: e];
+  _trackingPopUp = NO;
   
+  // Another part of the items of the data source was chosen, pop up again
+  if (_reopensPopUp)
+    {
+      _reopensPopUp = NO;
+      [self attachPopUpWithFrame: cellFrame inView: controlView];
+      return YES;
+    }
+
   // End of mouse tracking here -- dismiss popup
   // No synchronization needed here
   if ([[_menu window] isVisible])
@@ -1183,7 +1269,7 @@ static NSImage *_pbc_image[5];
 	      forKey: @"NSArrowPosition"];
       [aCoder encodeInteger:  [self preferredEdge] 
 	      forKey: @"NSPreferredEdge"];
-      [aCoder encodeInteger:  [self indexOfSelectedItem] 
+      [aCoder encodeInteger:  [_menu indexOfItem: _selectedItem] 
 	      forKey: @"NSSelectedIndex"];
       [aCoder encodeBool: [self pullsDown]
 	      forKey: @"NSPullDown"];
@@ -1341,9 +1427,9 @@ static NSImage *_pbc_image[5];
 - (void) _popUpItemAction: (id)sender
 {
   // first, if sender is one of our items, set it as our selected item
-  NSUInteger index = [_menu indexOfItem: sender];
-  if (index != NSNotFound)
-    [self selectItemAtIndex: index];
+  NSInteger index = [_menu indexOfItem: sender];
+  if (index != -1)
+    [self selectItem: sender];
 
   if (_control_view)
     {
@@ -1369,3 +1455,162 @@ static NSImage *_pbc_image[5];
 }
 
 @end
+
+@implementation NSPopUpButtonCell (GNUstepExtensions)
+
+- (void) setItemDataSource: (id)dataSource
+{
+  if (_itemDataSource == dataSource)
+    {
+      return;
+    }
+  [self removeAllItems];
+  _itemDataSource = dataSource;
+  _itemDataSelection = -1;
+  _itemDataFirst = 0;
+  if (_itemDataSource != nil)
+    {
+      if ([self numberOfItems] > 0)
+        {
+          _itemDataSelection = 0;
+        }
+      [self _loadItemDataFrom: 0];
+    }
+  else
+    {
+      [self setMenuItem: nil];
+    }
+}
+
+- (id) itemDataSource
+{
+  return _itemDataSource;
+}
+
+- (void) reloadItemData
+{
+  NSInteger count;
+
+  if (_itemDataSource == nil)
+    {
+      return;
+    }
+  count = [self numberOfItems];
+  if (_itemDataSelection >= count)
+    {
+      _itemDataSelection = count - 1;
+    }
+  [self setMenuItem: nil];
+  [self _loadItemDataFrom: _itemDataFirst];
+}
+
+@end
+
+@implementation NSPopUpButtonCell (ItemData)
+
+/* Returns the index in the menu of the item for index in the data
+   source, or -1 if the menu doesn't hold it.  */
+- (NSInteger) _menuIndexOfItemData: (NSInteger)index
+{
+  NSInteger i = index - _itemDataFirst + ((_itemDataFirst > 0) ? 1 : 0);
+
+  if (index < _itemDataFirst || i >= [_menu numberOfItems]
+      || [[_menu itemAtIndex: i] tag] != index)
+    {
+      return -1;
+    }
+  return i;
+}
+
+/* Replaces the items of the menu by at most ITEM_DATA_WINDOW items of
+   the data source, starting at first, with items before and after them
+   to show the previous or following ones.  */
+- (void) _loadItemDataFrom: (NSInteger)first
+{
+  NSInteger count = [self numberOfItems];
+  NSInteger last;
+  NSInteger i;
+  NSMenuItem *item;
+
+  first = MAX(MIN(first, count - ITEM_DATA_WINDOW), 0);
+  last = MIN(first + ITEM_DATA_WINDOW, count);
+
+  _itemDataReloading = YES;
+  if (_pbcFlags.altersStateOfSelectedItem)
+    {
+      [_selectedItem setState: NSOffState];
+    }
+  _selectedItem = nil;
+  [[_menu menuRepresentation] setHighlightedItemIndex: -1];
+  while ([_menu numberOfItems] > 0)
+    {
+      [_menu removeItemAtIndex: [_menu numberOfItems] - 1];
+    }
+
+  if (first > 0)
+    {
+      item = (NSMenuItem *)[_menu addItemWithTitle: _(@"Previous Items")
+                                            action: @selector(_showMoreItems:)
+                                     keyEquivalent: @""];
+      [item setTarget: self];
+      [item setTag: -1];
+    }
+  for (i = first; i < last; i++)
+    {
+      NSString *title;
+
+      title = [_itemDataSource popUpButtonCell: self titleOfItemAtIndex: i];
+      item = (NSMenuItem *)[_menu addItemWithTitle: (title ? title : @"")
+                                            action: @selector(_popUpItemAction:)
+                                     keyEquivalent: @""];
+      [item setOnStateImage: nil];
+      [item setMixedStateImage: nil];
+      [item setTarget: self];
+      [item setTag: i];
+    }
+  if (last < count)
+    {
+      item = (NSMenuItem *)[_menu addItemWithTitle: _(@"More Items")
+                                            action: @selector(_showMoreItems:)
+                                     keyEquivalent: @""];
+      [item setTarget: self];
+      [item setTag: -2];
+    }
+  _itemDataFirst = first;
+  _itemDataReloading = NO;
+
+  i = [self _menuIndexOfItemData: _itemDataSelection];
+  if (i >= 0)
+    {
+      [self selectItem: [_menu itemAtIndex: i]];
+      [self setMenuItem: [_menu itemAtIndex: i]];
+    }
+  else if (_itemDataSelection >= 0 && _menuItem == nil)
+    {
+      /* Show the title of a selected item which the menu doesn't hold.  */
+      item = [[NSMenuItem alloc]
+               initWithTitle: [self itemTitleAtIndex: _itemDataSelection]
+                      action: NULL
+               keyEquivalent: @""];
+      [self setMenuItem: item];
+      RELEASE(item);
+    }
+
+  if ([_control_view isKindOfClass: [NSControl class]])
+    [(NSControl *)_control_view updateCell: self];
+}
+
+- (void) _showMoreItems: (id)sender
+{
+  if ([sender tag] == -1)
+    {
+      [self _loadItemDataFrom: _itemDataFirst - ITEM_DATA_WINDOW + 1];
+    }
+  else
+    {
+      [self _loadItemDataFrom: _itemDataFirst + ITEM_DATA_WINDOW - 1];
+    }
+  _reopensPopUp = YES;
+}
+
+@end
@@ -36,12 +36,26 @@
 #include <limits.h>
 #include <math.h>
 #include "config.h"
+#if	!defined(__MINGW32__)
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
 #import <Foundation/NSString.h>
+#import <Foundation/NSArray.h>
 #import <Foundation/NSDebug.h>
+#import <Foundation/NSDictionary.h>
 #import <Foundation/NSData.h>
 #import <Foundation/NSFileManager.h>
 #import <Foundation/NSException.h>
+#import <Foundation/NSLock.h>
 #import <Foundation/NSPathUtilities.h>
+#import <Foundation/NSProcessInfo.h>
+#import <Foundation/NSSet.h>
+#import <Foundation/NSStream.h>
 #import <Foundation/NSTask.h>
 #import <Foundation/NSThread.h>
 #import <Foundation/NSUserDefaults.h>
@@ -96,8 +110,71 @@ typedef struct _page_info_t {
   double lastWidth, lastHeight; /* max. values of last printed page (scaled) */
   NSPrintingOrientation orient;
   int    pageDirection;      /* NSPrintPageDirection */
+  id     pagination;         /* Page rects worked out so far */
 } page_info_t;
 
+/* What the pages of a view depend on, besides the view itself */
+typedef struct _pagination_key_t {
+  NSRect rect;
+  NSRect bounds;
+  NSRect scaledBounds;
+  NSRect paperBounds;
+  double pageScale;
+  double printScale;
+  NSInteger xpages, ypages;
+  NSInteger nup;
+  NSPrintingPaginationMode horizontal, vertical;
+  int pageDirection;
+  BOOL knowsRange;
+  NSUInteger generation;
+} pagination_key_t;
+
+/* A page rect along with the state it left pagination in */
+typedef struct _page_entry_t {
+  NSRect rect;
+  double lastWidth, lastHeight;
+  NSInteger xpages, ypages;  /* The page counts it was worked out with */
+} page_entry_t;
+
+/* The pages worked out for a view.  The last of these is kept after
+   printing, so printing the same view again with the same geometry,
+   for a preview and then for the printer say, doesn't have to ask the
+   view to adjust each page again. */
+@interface GSPrintPagination : NSObject
+{
+@public
+  NSView *view;              /* Not retained */
+  NSData *key;
+  NSMutableData *pages;      /* page_entry_t for pages from the first */
+  NSMutableDictionary *known; /* Rects of a view which knows its range */
+}
+@end
+
+@implementation GSPrintPagination
+- (void) dealloc
+{
+  RELEASE(key);
+  RELEASE(pages);
+  RELEASE(known);
+  [super dealloc];
+}
+@end
+
+static GSPrintPagination *lastPagination = nil;
+static NSLock *paginationLock = nil;
+
+void
+GSPrintForgetPagination(NSView *view)
+{
+  if (lastPagination != nil)
+    {
+      [paginationLock lock];
+      if (lastPagination != nil && lastPagination->view == view)
+        DESTROY(lastPagination);
+      [paginationLock unlock];
+    }
+}
+
 
 @interface NSPrintOperation (TrulyPrivate)
 - (BOOL) _runOperation;
@@ -113,6 +190,17 @@ typedef struct _page_info_t {
 - (NSRect) _adjustPagesFirst: (NSInteger)first 
                         last: (NSInteger)last
                         info: (page_info_t *)info;
+- (void) _extendPagination: (page_info_t *)info forRect: (NSRect)pageRect;
+- (GSPrintPagination *) _paginationForInfo: (page_info_t *)info
+                                knowsRange: (BOOL)knowsRange;
+- (void) _rememberPagination: (GSPrintPagination *)pagination;
+- (NSRect) _pageRectForPage: (NSInteger)page
+                       info: (page_info_t *)info
+                 knowsRange: (BOOL)knowsRange;
+- (BOOL) _canPrintPagesConcurrently: (page_info_t *)info;
+- (void) _printPages: (NSArray *)rects
+	    withInfo: (page_info_t)info
+	  knowsRange: (BOOL)knowsPageRange;
 - (void) _print;
 @end
 
@@ -135,6 +223,110 @@ typedef struct _page_info_t {
 
 
 static NSString *NSPrintOperationThreadKey = @"NSPrintOperationThreadKey";
+static NSString *GSPrintContextThreadKey = @"GSPrintContextThreadKey";
+static NSString *GSPrintCurrentPageThreadKey = @"GSPrintCurrentPageThreadKey";
+
+/* The fewest pages worth handing to a thread of their own. */
+#define PAGES_PER_THREAD 8
+
+/* A run of consecutive pages drawn on a thread of its own into a
+   PostScript stream of their own, which the print operation then copies
+   into its output after the pages before them. */
+@interface GSPrintPageRun : NSObject
+{
+@public
+  NSPrintOperation *operation;
+  NSDictionary *attributes;	// For the context of the run
+  NSArray *rects;
+  NSUInteger lo;
+  NSUInteger hi;
+  page_info_t info;
+  BOOL knowsPageRange;
+  NSSet *fonts;			// Fonts used by the pages
+  NSException *exception;
+  NSCondition *done;
+  NSUInteger *pending;
+}
+@end
+
+#if	!defined(__MINGW32__)
+/* How long to wait for the pipe to be closed once the context is gone. */
+#define STREAM_CLOSE_TIMEOUT 30.0
+
+/* Passes what a print context writes to a pipe on to the operation as
+   it arrives, from a thread of its own. */
+@interface GSPrintOutputStreamer : NSObject
+{
+@public
+  NSPrintOperation *operation;
+  NSString *path;
+  int readFd;
+  int holdFd;		// Keeps the pipe open until the context is done
+  NSCondition *done;
+  BOOL finished;
+  BOOL abandoned;
+  BOOL ok;
+}
+- (id) initWithOperation: (NSPrintOperation *)op path: (NSString *)aPath;
+- (BOOL) finish;
+@end
+#endif
+
+@implementation GSPrintPageRun
+
+- (void) dealloc
+{
+  RELEASE(attributes);
+  RELEASE(rects);
+  RELEASE(fonts);
+  RELEASE(exception);
+  [super dealloc];
+}
+
+- (void) run: (id)unused
+{
+  CREATE_AUTORELEASE_POOL(pool);
+  NSMutableDictionary *dict = [[NSThread currentThread] threadDictionary];
+  NSView *view = [operation view];
+
+  NS_DURING
+    {
+      NSGraphicsContext *ctxt;
+      NSUInteger i;
+
+      ctxt = [NSGraphicsContext graphicsContextWithAttributes: attributes];
+      [dict setObject: operation forKey: NSPrintOperationThreadKey];
+      [dict setObject: ctxt forKey: GSPrintContextThreadKey];
+      [NSGraphicsContext setCurrentContext: ctxt];
+      for (i = lo; i < hi; i++)
+	{
+	  [dict setObject: NSNUMBER(info.first + i)
+		   forKey: GSPrintCurrentPageThreadKey];
+	  [view _displayPageInRect: [[rects objectAtIndex: i] rectValue]
+			  withInfo: info
+		    knowsPageRange: knowsPageRange];
+	}
+      fonts = [[ctxt usedFonts] copy];
+    }
+  NS_HANDLER
+    {
+      ASSIGN(exception, localException);
+    }
+  NS_ENDHANDLER
+  [NSGraphicsContext setCurrentContext: nil];
+  [dict removeObjectForKey: GSPrintCurrentPageThreadKey];
+  [dict removeObjectForKey: GSPrintContextThreadKey];
+  [dict removeObjectForKey: NSPrintOperationThreadKey];
+  /* Releasing the context closes its output file. */
+  DESTROY(pool);
+
+  [done lock];
+  (*pending)--;
+  [done signal];
+  [done unlock];
+}
+
+@end
 
 /**
   <unit>
@@ -162,6 +354,7 @@ static NSString *NSPrintOperationThreadKey = @"NSPrintOperationThreadKey";
     {
       // Initial version
       [self setVersion:1];
+      paginationLock = [NSLock new];
     }
 }
 
@@ -310,6 +503,7 @@ static NSString *NSPrintOperationThreadKey = @"NSPrintOperationThreadKey";
   RELEASE(_print_info);
   RELEASE(_view);  
   RELEASE(_data);
+  TEST_RELEASE(_output_stream);
   TEST_RELEASE(_context);
   TEST_RELEASE(_print_panel);  
   TEST_RELEASE(_accessory_view);  
@@ -427,6 +621,14 @@ static NSString *NSPrintOperationThreadKey = @"NSPrintOperationThreadKey";
 */
 - (NSGraphicsContext *)context
 {
+  if (_flags.printing_concurrently)
+    {
+      NSGraphicsContext *ctxt = [[[NSThread currentThread] threadDictionary]
+	objectForKey: GSPrintContextThreadKey];
+
+      if (ctxt != nil)
+	return ctxt;
+    }
   return _context;
 }
 
@@ -446,6 +648,14 @@ static NSString *NSPrintOperationThreadKey = @"NSPrintOperationThreadKey";
 */
 - (NSInteger)currentPage
 {
+  if (_flags.printing_concurrently)
+    {
+      NSNumber *page = [[[NSThread currentThread] threadDictionary]
+	objectForKey: GSPrintCurrentPageThreadKey];
+
+      if (page != nil)
+	return [page integerValue];
+    }
   return _currentPage;
 }
 
@@ -556,6 +766,10 @@ static NSString *NSPrintOperationThreadKey = @"NSPrintOperationThreadKey";
   [panel setAccessoryView: nil];
 }
 
+/** Returns YES if the operation may use other threads.  When it may,
+    the pages of a PostScript document are drawn on several threads at
+    once, unless the view returns NO from -canPrintPagesConcurrently.
+*/
 - (BOOL)canSpawnSeparateThread
 {
   return _flags.can_spawn_separate_thread;
@@ -609,6 +823,21 @@ static NSString *NSPrintOperationThreadKey = @"NSPrintOperationThreadKey";
 @end
 
 
+@implementation NSPrintOperation (GNUstep)
+
+- (void) setOutputStream: (NSOutputStream *)stream
+{
+  ASSIGN(_output_stream, stream);
+}
+
+- (NSOutputStream *) outputStream
+{
+  return _output_stream;
+}
+
+@end
+
+
 @implementation NSPrintOperation (Private)
 
 - (id) initWithView:(NSView *)aView
@@ -635,7 +864,155 @@ static NSString *NSPrintOperationThreadKey = @"NSPrintOperationThreadKey";
   [NSPrintOperation setCurrentOperation: self];
   return self;
 }
+
+- (BOOL) _shouldStreamOutput
+{
+  return _output_stream != nil;
+}
+
+- (BOOL) _beginStreamedOutput
+{
+  if ([_output_stream streamStatus] == NSStreamStatusNotOpen)
+    [_output_stream open];
+  return [_output_stream streamStatus] != NSStreamStatusError;
+}
+
+- (BOOL) _writeStreamedBytes: (const uint8_t *)bytes
+                      length: (NSUInteger)length
+{
+  while (length > 0)
+    {
+      NSInteger written = [_output_stream write: bytes maxLength: length];
+
+      if (written <= 0)
+        return NO;
+      bytes += written;
+      length -= written;
+    }
+  return YES;
+}
+
+- (BOOL) _endStreamedOutput
+{
+  return YES;
+}
+@end
+
+#if	!defined(__MINGW32__)
+@implementation GSPrintOutputStreamer
+
+- (id) initWithOperation: (NSPrintOperation *)op path: (NSString *)aPath
+{
+  const char *file = [aPath fileSystemRepresentation];
+
+  if ((self = [super init]) == nil)
+    return nil;
+  operation = op;
+  ASSIGN(path, aPath);
+  readFd = holdFd = -1;
+  if (mkfifo(file, 0600) < 0)
+    {
+      NSDebugLLog(@"NSPrinting", @"Can't make pipe %@: %d", path, errno);
+      DESTROY(self);
+      return nil;
+    }
+  /* Opening the reading end doesn't wait for a writer when it's non
+     blocking, and holding a writing end open means reads wait for the
+     context rather than finding the pipe closed before it opens it. */
+  readFd = open(file, O_RDONLY | O_NONBLOCK);
+  if (readFd >= 0)
+    holdFd = open(file, O_WRONLY);
+  if (holdFd < 0)
+    {
+      DESTROY(self);
+      return nil;
+    }
+  done = [NSCondition new];
+  [NSThread detachNewThreadSelector: @selector(_forward:)
+                           toTarget: self
+                         withObject: nil];
+  return self;
+}
+
+- (void) dealloc
+{
+  if (readFd >= 0 && done == nil)
+    close(readFd);
+  if (holdFd >= 0)
+    close(holdFd);
+  if (path != nil)
+    unlink([path fileSystemRepresentation]);
+  RELEASE(path);
+  RELEASE(done);
+  [super dealloc];
+}
+
+- (void) _forward: (id)unused
+{
+  CREATE_AUTORELEASE_POOL(pool);
+  uint8_t buf[65536];
+  BOOL began;
+
+  RETAIN(self);
+  ok = began = [operation _beginStreamedOutput];
+  while (!abandoned)
+    {
+      struct pollfd pfd;
+      ssize_t n;
+
+      pfd.fd = readFd;
+      pfd.events = POLLIN;
+      if (poll(&pfd, 1, 1000) <= 0)
+        continue;
+      n = read(readFd, buf, sizeof(buf));
+      if (n > 0)
+        {
+          /* Keep reading after a failure so the context isn't blocked. */
+          if (ok)
+            ok = [operation _writeStreamedBytes: buf length: n];
+        }
+      else if (n == 0 || (errno != EINTR && errno != EAGAIN))
+        {
+          break;
+        }
+    }
+  if (began)
+    ok = [operation _endStreamedOutput] && ok;
+  close(readFd);
+
+  [done lock];
+  finished = YES;
+  [done signal];
+  [done unlock];
+  RELEASE(self);
+  DESTROY(pool);
+}
+
+/* Called once the context has closed its end of the pipe.  Waits for
+   what is left in the pipe to be passed on, and returns NO if any of it
+   could not be. */
+- (BOOL) finish
+{
+  NSDate *limit = [NSDate dateWithTimeIntervalSinceNow: STREAM_CLOSE_TIMEOUT];
+
+  close(holdFd);
+  holdFd = -1;
+  [done lock];
+  while (!finished)
+    {
+      if ([done waitUntilDate: limit] == NO)
+        {
+          NSLog(@"Print output pipe %@ was not closed", path);
+          abandoned = YES;
+          break;
+        }
+    }
+  [done unlock];
+  return finished && ok;
+}
+
 @end
+#endif
 
 @implementation NSPrintOperation (TrulyPrivate)
 
@@ -648,10 +1025,58 @@ static NSString *NSPrintOperationThreadKey = @"NSPrintOperationThreadKey";
   BOOL result;
   CREATE_AUTORELEASE_POOL(pool);
   NSGraphicsContext *oldContext = [NSGraphicsContext currentContext];
+#if	!defined(__MINGW32__)
+  GSPrintOutputStreamer *streamer = nil;
+  NSString *savedPath = nil;
+
+  /* Rather than have the context write to a file which is read back in
+     once it is complete, point it at a pipe and pass its output on as it
+     is written. */
+  if ([self _shouldStreamOutput])
+    {
+      NSString *fifo;
+
+      fifo = [NSTemporaryDirectory() stringByAppendingPathComponent:
+	[@"GSPrintStream-" stringByAppendingString:
+	  [[NSProcessInfo processInfo] globallyUniqueString]]];
+      if ([_path pathExtension] != nil)
+	fifo = [fifo stringByAppendingPathExtension: [_path pathExtension]];
+      streamer = [[GSPrintOutputStreamer alloc] initWithOperation: self
+							     path: fifo];
+      if (streamer != nil)
+	{
+	  savedPath = RETAIN(_path);
+	  ASSIGN(_path, fifo);
+	}
+    }
+#endif
 
   [self createContext];
+#if	!defined(__MINGW32__)
+  if (streamer != nil)
+    {
+      ASSIGN(_path, savedPath);
+      DESTROY(savedPath);
+      /* A subclass may have chosen a path of its own (NSPrintSavePath). */
+      if (![[[_print_info dictionary] objectForKey: @"NSOutputFile"]
+	     isEqual: streamer->path])
+	{
+	  [streamer finish];
+	  DESTROY(streamer);
+	}
+    }
+#endif
   if (_context == nil)
-    return NO;
+    {
+#if	!defined(__MINGW32__)
+      if (streamer != nil)
+	{
+	  [streamer finish];
+	  DESTROY(streamer);
+	}
+#endif
+      return NO;
+    }
 
   result = NO;
   if (_page_order == NSUnknownPageOrder)
@@ -680,6 +1105,17 @@ static NSString *NSPrintOperationThreadKey = @"NSPrintOperationThreadKey";
   NS_ENDHANDLER
   [self destroyContext];
   RELEASE(pool);
+#if	!defined(__MINGW32__)
+  if (streamer != nil)
+    {
+      /* The output has gone already, so there is nothing to read back
+	 in when delivering the result. */
+      result = [streamer finish] && result;
+      DESTROY(streamer);
+      _flags.streamed_output = 1;
+      DESTROY(_data);
+    }
+#endif
   return result;
 }
 
@@ -936,6 +1372,281 @@ scaleRect(NSRect rect, double scale)
   return pageRect;
 }
 
+/* Checks if adjusting the last page forced part of the bounds onto 
+   another page, and adds a row or column of pages for it if so. */
+- (void) _extendPagination: (page_info_t *)info forRect: (NSRect)pageRect
+{
+  if (NSMaxX(pageRect) < NSMaxX(_rect) 
+      && [_print_info horizontalPagination] != NSClipPagination)
+    {
+      info->xpages++;
+    }
+  if (NSMaxY(pageRect) < NSMaxY(_rect)
+      && [_print_info verticalPagination] != NSClipPagination)
+    {
+      info->ypages++;
+    }
+  info->last = info->xpages * info->ypages;
+}
+
+/* Returns the pages remembered for the view if they were worked out
+   with the same geometry and the view's layout hasn't changed since,
+   or a new pagination to fill in otherwise. */
+- (GSPrintPagination *) _paginationForInfo: (page_info_t *)info
+                                knowsRange: (BOOL)knowsRange
+{
+  GSPrintPagination *pagination = nil;
+  pagination_key_t k;
+  NSData *key;
+
+  memset(&k, 0, sizeof(k));
+  k.rect = _rect;
+  k.bounds = [_view bounds];
+  k.scaledBounds = info->scaledBounds;
+  k.paperBounds = info->paperBounds;
+  k.pageScale = info->pageScale;
+  k.printScale = info->printScale;
+  k.xpages = info->xpages;
+  k.ypages = info->ypages;
+  k.nup = info->nup;
+  k.horizontal = [_print_info horizontalPagination];
+  k.vertical = [_print_info verticalPagination];
+  k.pageDirection = info->pageDirection;
+  k.knowsRange = knowsRange;
+  k.generation = [_view pageLayoutGeneration];
+  key = [NSData dataWithBytes: &k length: sizeof(k)];
+
+  if (k.generation != NSNotFound)
+    {
+      [paginationLock lock];
+      if (lastPagination != nil && lastPagination->view == _view
+        && [lastPagination->key isEqual: key])
+        {
+          pagination = AUTORELEASE(RETAIN(lastPagination));
+        }
+      [paginationLock unlock];
+      if (pagination != nil)
+        {
+          NSDebugLLog(@"NSPrinting", @"Reusing %lu page rects",
+            (unsigned long)([pagination->pages length] / sizeof(page_entry_t)
+                            + [pagination->known count]));
+          return pagination;
+        }
+    }
+
+  pagination = AUTORELEASE([GSPrintPagination new]);
+  pagination->view = _view;
+  pagination->key = RETAIN(key);
+  pagination->pages = [NSMutableData new];
+  pagination->known = [NSMutableDictionary new];
+  return pagination;
+}
+
+- (void) _rememberPagination: (GSPrintPagination *)pagination
+{
+  pagination_key_t k;
+
+  [pagination->key getBytes: &k length: sizeof(k)];
+  if (k.generation != NSNotFound)
+    {
+      [paginationLock lock];
+      ASSIGN(lastPagination, pagination);
+      [paginationLock unlock];
+    }
+}
+
+/* Returns the rect of the page, working it out and remembering it if it
+   hasn't been before.  Unless the view knows its pages, each is adjusted
+   to where the one before it ended, so the pages missing before it are
+   worked out first, in order. */
+- (NSRect) _pageRectForPage: (NSInteger)page
+                       info: (page_info_t *)info
+                 knowsRange: (BOOL)knowsRange
+{
+  GSPrintPagination *pagination = info->pagination;
+  page_entry_t *entries;
+  page_entry_t entry;
+  NSUInteger count;
+  NSInteger i;
+  NSRect pageRect = NSZeroRect;
+
+  if (knowsRange == YES)
+    {
+      NSNumber *number = NSNUMBER(page);
+      NSValue *value = [pagination->known objectForKey: number];
+
+      if (value == nil)
+        {
+          value = [NSValue valueWithRect: [_view rectForPage: page]];
+          [pagination->known setObject: value forKey: number];
+        }
+      return [value rectValue];
+    }
+
+  count = [pagination->pages length] / sizeof(page_entry_t);
+  entries = (page_entry_t *)[pagination->pages mutableBytes];
+  if (page <= (NSInteger)count)
+    {
+      entry = entries[page - 1];
+      if (entry.xpages == info->xpages && entry.ypages == info->ypages)
+        {
+          info->lastWidth = entry.lastWidth;
+          info->lastHeight = entry.lastHeight;
+          return entry.rect;
+        }
+      /* The pagination was extended since, so this and the pages after
+         it have to be worked out again. */
+      count = page - 1;
+      [pagination->pages setLength: count * sizeof(page_entry_t)];
+    }
+
+  if (count > 0)
+    {
+      info->lastWidth = entries[count - 1].lastWidth;
+      info->lastHeight = entries[count - 1].lastHeight;
+    }
+  else
+    {
+      info->lastWidth = info->lastHeight = 0;
+    }
+  for (i = count + 1; i <= page; i++)
+    {
+      pageRect = [self _adjustPagesFirst: i last: i info: info];
+      entry.rect = pageRect;
+      entry.lastWidth = info->lastWidth;
+      entry.lastHeight = info->lastHeight;
+      entry.xpages = info->xpages;
+      entry.ypages = info->ypages;
+      [pagination->pages appendBytes: &entry length: sizeof(entry)];
+    }
+  return pageRect;
+}
+
+/* Pages can be drawn on several threads when the operation may spawn
+   threads, the view can draw concurrently and the output is a
+   PostScript document with a page per sheet, whose pages can simply be
+   put one after the other. */
+- (BOOL) _canPrintPagesConcurrently: (page_info_t *)info
+{
+  NSDictionary *dict = [_print_info dictionary];
+
+  if ([self canSpawnSeparateThread] == NO
+      || [_view canPrintPagesConcurrently] == NO
+      || [self isEPSOperation] == YES
+      || info->nup != 1
+      || [dict objectForKey: @"NSOutputFile"] == nil
+      || [[dict objectForKey: NSGraphicsContextRepresentationFormatAttributeName]
+           isEqual: NSGraphicsContextPSFormat] == NO)
+    {
+      return NO;
+    }
+  return [[NSProcessInfo processInfo] activeProcessorCount] > 1;
+}
+
+/* Draws the pages with the rects given, the first of them on this thread
+   straight into the context of the operation and the others on threads
+   of their own, then copies the output of those into the context in
+   order. */
+- (void) _printPages: (NSArray *)rects
+	    withInfo: (page_info_t)info
+	  knowsRange: (BOOL)knowsPageRange
+{
+  NSUInteger count = [rects count];
+  NSUInteger threads = [[NSProcessInfo processInfo] activeProcessorCount];
+  NSCondition *done = AUTORELEASE([NSCondition new]);
+  NSMutableArray *runs = [NSMutableArray array];
+  NSUInteger pending;
+  NSUInteger i, j;
+  NSString *base;
+
+  threads = MIN(MIN(threads, 16), count / PAGES_PER_THREAD);
+  threads = MAX(threads, 1);
+  pending = threads - 1;
+  base = [NSTemporaryDirectory() stringByAppendingPathComponent:
+    [@"GSPrint-" stringByAppendingString:
+      [[NSProcessInfo processInfo] globallyUniqueString]]];
+
+  _flags.printing_concurrently = 1;
+  for (i = 1; i < threads; i++)
+    {
+      GSPrintPageRun *run = AUTORELEASE([GSPrintPageRun new]);
+      NSMutableDictionary *attributes;
+
+      attributes = [[_print_info dictionary] mutableCopy];
+      [attributes setObject: [base stringByAppendingFormat: @"-%lu.ps",
+                                   (unsigned long)i]
+                     forKey: @"NSOutputFile"];
+      run->operation = self;
+      run->attributes = attributes;
+      run->rects = RETAIN(rects);
+      run->lo = count * i / threads;
+      run->hi = count * (i + 1) / threads;
+      run->info = info;
+      run->knowsPageRange = knowsPageRange;
+      run->done = done;
+      run->pending = &pending;
+      [runs addObject: run];
+      [NSThread detachNewThreadSelector: @selector(run:)
+                               toTarget: run
+                             withObject: nil];
+    }
+
+  NS_DURING
+    {
+      for (j = 0; j < count / threads; j++)
+        {
+          _currentPage = info.first + j;
+          [_view _displayPageInRect: [[rects objectAtIndex: j] rectValue]
+                           withInfo: info
+                     knowsPageRange: knowsPageRange];
+        }
+    }
+  NS_HANDLER
+    {
+      [done lock];
+      while (pending > 0)
+        [done wait];
+      [done unlock];
+      _flags.printing_concurrently = 0;
+      [localException raise];
+    }
+  NS_ENDHANDLER
+
+  [done lock];
+  while (pending > 0)
+    [done wait];
+  [done unlock];
+  _flags.printing_concurrently = 0;
+
+  for (i = 0; i < [runs count]; i++)
+    {
+      GSPrintPageRun *run = [runs objectAtIndex: i];
+      NSString *path = [run->attributes objectForKey: @"NSOutputFile"];
+      NSData *data;
+      NSEnumerator *e;
+      NSString *font;
+
+      if (run->exception == nil)
+        {
+          data = [NSData dataWithContentsOfFile: path];
+          DPSWriteData(_context, [data bytes], [data length]);
+          e = [run->fonts objectEnumerator];
+          while ((font = [e nextObject]) != nil)
+            {
+              [_context useFont: font];
+            }
+        }
+      [[NSFileManager defaultManager] removeFileAtPath: path handler: nil];
+    }
+  for (i = 0; i < [runs count]; i++)
+    {
+      GSPrintPageRun *run = [runs objectAtIndex: i];
+
+      if (run->exception != nil)
+        [run->exception raise];
+    }
+}
+
 - (void) _print
 {
   int i, dir;
@@ -1016,19 +1727,46 @@ scaleRect(NSRect rect, double scale)
       dir = 1;
     }
 
-  /*
-   * FIXME: Independent of the page order we could pre-calculate the
-   * pageRects for all pages up to last (including clipping adjustment) 
-   * and use them when printing. 
-   */
+  /* Page rects are worked out once, in order, and remembered, so the
+     order pages are printed in doesn't matter and a view printed again
+     unchanged doesn't have to be paginated again. */
   info.lastWidth = info.lastHeight = 0;
-  if (!knowsPageRange && dir > 0 && _currentPage != 1)
+  info.pagination = [self _paginationForInfo: &info
+                                  knowsRange: knowsPageRange];
+
+  if (dir > 0 && [self _canPrintPagesConcurrently: &info])
     {
-      /* Calculate page rects we aren't processing to catch up to the
-         first page we are */
-      [self _adjustPagesFirst: 1
-                         last: _currentPage - 1 
-                         info: &info];
+      NSMutableArray *rects = [NSMutableArray array];
+
+      /* Work out the rect of every page first, as the view may adjust
+         each one to where the previous one ended, then draw them. */
+      i = 0;
+      while (i < (info.last - info.first + 1))
+        {
+          NSRect pageRect;
+
+          pageRect = [self _pageRectForPage: _currentPage
+                                       info: &info
+                                 knowsRange: knowsPageRange];
+          if (NSIsEmptyRect(pageRect))
+            break;
+          [rects addObject: [NSValue valueWithRect: pageRect]];
+          if (!knowsPageRange && _currentPage == info.last && allPages == YES)
+            {
+              [self _extendPagination: &info forRect: pageRect];
+            }
+          i++;
+          _currentPage++;
+        }
+
+      [_view beginDocument];
+      [self _printPages: rects withInfo: info knowsRange: knowsPageRange];
+      info.last = info.first + [rects count] - 1;
+      _currentPage = info.last + 1;
+      [_view endDocument];
+      [dict setObject: NSNUMBER(info.last) forKey: NSPrintLastPage];
+      [self _rememberPagination: info.pagination];
+      return;
     }
 
   /* Print the header information */
@@ -1040,21 +1778,9 @@ scaleRect(NSRect rect, double scale)
     {
       NSRect pageRect;
 
-      if (knowsPageRange == YES)
-        {
-          pageRect = [_view rectForPage: _currentPage];
-        }
-      else
-        {
-          if (dir < 0)
-            pageRect = [self _adjustPagesFirst: 1 
-                                          last: _currentPage 
-                                          info: &info];
-          else
-            pageRect = [self _adjustPagesFirst: _currentPage 
-                                          last: _currentPage 
-                                          info: &info];
-        }
+      pageRect = [self _pageRectForPage: _currentPage
+                                   info: &info
+                             knowsRange: knowsPageRange];
 
       NSDebugLLog(@"NSPrinting", @" current page %ld, rect %@", 
                   (long)_currentPage, NSStringFromRect(pageRect));
@@ -1069,20 +1795,7 @@ scaleRect(NSRect rect, double scale)
       // We could end up in this case for each row/column not just the lase page.
       if (!knowsPageRange && dir > 0 && _currentPage == info.last && allPages == YES)
         {
-          /* Check if adjust pages forced part of the bounds onto 
-             another page */
-          if (NSMaxX(pageRect) < NSMaxX(_rect) 
-              && [_print_info horizontalPagination] != NSClipPagination)
-            {
-              info.xpages++;
-            }
-          if (NSMaxY(pageRect) < NSMaxY(_rect)
-              && [_print_info verticalPagination] != NSClipPagination)
-            {
-              info.ypages++;
-            }
-          viewPageRange = NSMakeRange(1, (info.xpages * info.ypages));
-          info.last = NSMaxRange(viewPageRange) - 1;
+          [self _extendPagination: &info forRect: pageRect];
         }
       i++;
       _currentPage += dir;
@@ -1099,6 +1812,7 @@ scaleRect(NSRect rect, double scale)
 
   /* Setup/reset for next time */
   [dict setObject: NSNUMBER(info.last) forKey: NSPrintLastPage];
+  [self _rememberPagination: info.pagination];
   if (((int)(info.nup / 2) & 0x1) == 1)
     {
       info.orient = (info.orient == NSPortraitOrientation) ? 
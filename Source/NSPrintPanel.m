@@ -34,6 +34,8 @@
 #import <Foundation/NSBundle.h>
 #import <Foundation/NSDebug.h>
 #import <Foundation/NSDictionary.h>
+#import <Foundation/NSNotification.h>
+#import <Foundation/NSThread.h>
 #import <Foundation/NSValue.h>
 #import "AppKit/NSApplication.h"
 #import "AppKit/NSBox.h"
@@ -59,6 +61,8 @@ static NSPrintPanel *shared_instance = nil;
 @interface NSPrintPanel (GSPrivate)
 - (void)_updateFromPrintInfo: (NSPrintInfo*)info;
 - (void)_finalWritePrintInfo: (NSPrintInfo*)info;
+- (void)_loadPrinterNames;
+- (void)_setPrinterNames: (NSArray*)names;
 @end
 
 /**
@@ -185,11 +189,18 @@ static NSPrintPanel *shared_instance = nil;
     }
   [control selectItemAtIndex: 0];
 
+  [[NSNotificationCenter defaultCenter]
+    addObserver: self
+       selector: @selector(_loadPrinterNames)
+	   name: GSPrinterNamesDidChangeNotification
+	 object: nil];
+
   return self;
 }
 
 - (void) dealloc
 {
+  [[NSNotificationCenter defaultCenter] removeObserver: self];
   RELEASE(_accessoryView);
   RELEASE(_savePath);
   RELEASE(_optionPanel);
@@ -536,22 +547,16 @@ static NSPrintPanel *shared_instance = nil;
   printer = [info printer];
   dict = [info dictionary];
 
-  /* Setup printer information */
+  /* Setup printer information.  Finding the other printers may take a
+     while, so the panel starts with the current one and the list is
+     filled in when they are known. */
   {
-    NSArray *printerNames = [NSPrinter printerNames];
-    NSInteger i;
     NSPopUpButton *button = CONTROL(self, NSPPNameField);
+
     [button removeAllItems];
-    
-    for (i=0; i<[printerNames count]; i++)
-      {
-      NSString *printerName = [printerNames objectAtIndex: i];
-      [button addItemWithTitle: printerName];
-      if ([[printer name] isEqual: printerName])
-	{
-	  [button selectItemAtIndex: i];
-	}
-    }
+    if ([printer name] != nil)
+      [button addItemWithTitle: [printer name]];
+    [self _loadPrinterNames];
   }
 
   [CONTROL(self, NSPPNoteField) setStringValue: [printer note] ];
@@ -678,6 +683,48 @@ static NSPrintPanel *shared_instance = nil;
 
 #define NSNUMBER(a) [NSNumber numberWithInteger: (a)]
 
+- (void) _readPrinterNames: (id)unused
+{
+  CREATE_AUTORELEASE_POOL(pool);
+
+  [self performSelectorOnMainThread: @selector(_setPrinterNames:)
+			 withObject: [NSPrinter printerNames]
+		      waitUntilDone: NO];
+  DESTROY(pool);
+}
+
+- (void)_loadPrinterNames
+{
+  [NSThread detachNewThreadSelector: @selector(_readPrinterNames:)
+			   toTarget: self
+			 withObject: nil];
+}
+
+- (void)_setPrinterNames: (NSArray*)names
+{
+  NSPopUpButton *button = CONTROL(self, NSPPNameField);
+  NSString *selected = AUTORELEASE(RETAIN([button titleOfSelectedItem]));
+  NSInteger i;
+
+  [button removeAllItems];
+  for (i = 0; i < [names count]; i++)
+    {
+      NSString *printerName = [names objectAtIndex: i];
+
+      [button addItemWithTitle: printerName];
+      if ([selected isEqual: printerName])
+	{
+	  [button selectItemAtIndex: i];
+	}
+    }
+  /* Keep the current printer even if it has gone away meanwhile. */
+  if (selected != nil && [button indexOfItemWithTitle: selected] < 0)
+    {
+      [button insertItemWithTitle: selected atIndex: 0];
+      [button selectItemAtIndex: 0];
+    }
+}
+
 - (void)_finalWritePrintInfo: (NSPrintInfo*)info
 {
   id control;
@@ -147,27 +147,16 @@ static NSMutableDictionary* printerCache;
   NSEnumerator *keyEnum;
   NSString *key;
   NSPrinter *printer;
+  NSSet *validNames;
   
   //First, the cache has to be managed.
   //Take into account any deleted printers.
+  //The names are looked up once, as the bundle may have to ask a server.
+  validNames = [NSSet setWithArray: [self printerNames]];
   keyEnum = [[printerCache allKeys] objectEnumerator];
   while ((key = [keyEnum nextObject]))
     {
-      NSEnumerator *namesEnum;
-      NSString *validName;
-      BOOL stillValid = NO;
-
-      namesEnum = [[self printerNames] objectEnumerator];
-      while ((validName = [namesEnum nextObject]))
-        {
-          if ([validName isEqualToString: key])
-            {
-              stillValid = YES;
-              break;
-            }
-        }
-      
-      if (stillValid == NO)
+      if ([validNames member: key] == nil)
         {
           [printerCache removeObjectForKey: key];
         }
@@ -26,18 +26,25 @@
    Boston, MA 02110-1301, USA.
 */
 
+#import <Foundation/NSArray.h>
 #import <Foundation/NSAutoreleasePool.h>
 #import <Foundation/NSRunLoop.h>
 #import <Foundation/NSThread.h>
-#import <Foundation/NSTimer.h>
 #import "AppKit/NSApplication.h"
 #import "AppKit/NSProgressIndicator.h"
 #import "AppKit/NSGraphics.h"
 #import "AppKit/NSImage.h"
 #import "AppKit/NSWindow.h"
+#import "GNUstepGUI/GSAnimator.h"
 #import "GNUstepGUI/GSTheme.h"
 #import "GNUstepGUI/GSNibLoading.h"
 
+/* Running indicators which do not use a thread of their own are all
+   stepped by the shared animation clock of GSAnimator, rather than by
+   a timer each. */
+@interface NSProgressIndicator (GSAnimation) <GSAnimation>
+@end
+
 @implementation NSProgressIndicator
 
 + (void) initialize
@@ -89,7 +96,10 @@
   // Let this value overflow when it reachs the limit
   _count++;
 
-  [self setNeedsDisplay: YES];
+  // Only the inside of the bezel changes from one step to the next
+  [self setNeedsDisplayInRect:
+    [[GSTheme theme] progressIndicatorAnimationRect: self
+                                         withBounds: _bounds]];
 }
 
 - (NSTimeInterval) animationDelay
@@ -129,12 +139,14 @@
   _isRunning = YES;
   if (!_usesThreadedAnimation)
     {
-      ASSIGN(_timer, [NSTimer scheduledTimerWithTimeInterval: _animationDelay 
-                              target: self 
-                              selector: @selector(animate:)
-                              userInfo: nil
-                              repeats: YES]);
-      [[NSRunLoop currentRunLoop] addTimer: _timer forMode: NSModalPanelRunLoopMode];
+      float fps = (_animationDelay > 0.0) ? 1.0 / _animationDelay : 0.0;
+
+      _animator = [[GSAnimator alloc] initWithAnimation: self
+                                              frameRate: fps];
+      [_animator setRunLoopModesForAnimating:
+        [NSArray arrayWithObjects: NSDefaultRunLoopMode,
+                 NSModalPanelRunLoopMode, nil]];
+      [_animator startAnimation];
     }
   else
     {
@@ -152,8 +164,8 @@
 
   if (!_usesThreadedAnimation)
     {
-      [_timer invalidate];
-      DESTROY(_timer);
+      [_animator stopAnimation];
+      DESTROY(_animator);
     }
   else
     {
@@ -548,3 +560,19 @@
 
 @end
 
+@implementation NSProgressIndicator (GSAnimation)
+
+- (void) animatorDidStart
+{
+}
+
+- (void) animatorDidStop
+{
+}
+
+- (void) animatorStep: (NSTimeInterval)elapsedTime
+{
+  [self animate: self];
+}
+
+@end
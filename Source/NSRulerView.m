@@ -67,6 +67,11 @@
 		    }					\
 		} while (0)
 
+@interface NSRulerView (Private)
+- (NSRect) _docRect;
+- (void) _documentViewDidScroll;
+@end
+
 @interface GSRulerUnit : NSObject
 {
   NSString *_unitName;
@@ -518,6 +523,8 @@ static NSMutableDictionary *units = nil;
   NSRectFill(aRect);
   [self drawHashMarksAndLabelsInRect: aRect];
   [self drawMarkersInRect: aRect];
+  _drawnDocRect = [self _docRect];
+  _drawnDocRectIsValid = YES;
 }
 
 - (float) _stepForIndex: (int)index
@@ -780,6 +787,7 @@ static NSMutableDictionary *units = nil;
 - (void) invalidateHashMarks
 {
   _cacheIsValid = NO;
+  _drawnDocRectIsValid = NO;
   [self setNeedsDisplay:YES];
 }
 
@@ -887,3 +895,98 @@ static NSMutableDictionary *units = nil;
 
 @end
 
+@implementation NSRulerView (Private)
+
+/* The bounds of the document view in the coordinates of the receiver.  */
+- (NSRect) _docRect
+{
+  NSView *docView = [_scrollView documentView];
+
+  return [self convertRect: [docView bounds] fromView: docView];
+}
+
+/*
+ * Everything the ruler shows, hash marks, labels and markers, is placed
+ * relative to the document view.  So when the document view scrolls
+ * along the ruler without changing size, the pixels the ruler shows are
+ * moved with it and only the strip which comes into sight is drawn, and
+ * a scroll across the ruler draws nothing.
+ */
+- (void) _documentViewDidScroll
+{
+  NSRect docRect;
+  NSRect visible;
+  NSRect source;
+  NSRect exposed;
+  NSSize delta;
+  NSSize deltaInBase;
+
+  if (_drawnDocRectIsValid == NO || _window == nil || [self needsDisplay])
+    {
+      [self setNeedsDisplay: YES];
+      return;
+    }
+
+  docRect = [self _docRect];
+  if (_orientation == NSHorizontalRuler)
+    {
+      delta = NSMakeSize(NSMinX(docRect) - NSMinX(_drawnDocRect), 0);
+      if (NSWidth(docRect) != NSWidth(_drawnDocRect))
+        {
+          delta.width = NSWidth(_bounds);
+        }
+    }
+  else
+    {
+      delta = NSMakeSize(0, NSMinY(docRect) - NSMinY(_drawnDocRect));
+      if (NSHeight(docRect) != NSHeight(_drawnDocRect))
+        {
+          delta.height = NSHeight(_bounds);
+        }
+    }
+  if (delta.width == 0 && delta.height == 0)
+    {
+      return;
+    }
+
+  /* Only whole pixels can be copied, anything else is drawn again.  */
+  visible = [self visibleRect];
+  deltaInBase = [self convertSize: delta toView: nil];
+  if (deltaInBase.width != floor(deltaInBase.width)
+    || deltaInBase.height != floor(deltaInBase.height)
+    || fabs(delta.width) >= NSWidth(visible)
+    || fabs(delta.height) >= NSHeight(visible))
+    {
+      [self setNeedsDisplay: YES];
+      return;
+    }
+
+  source = NSIntersectionRect(visible,
+    NSOffsetRect(visible, -delta.width, -delta.height));
+  [self scrollRect: source by: delta];
+  _drawnDocRect = docRect;
+
+  exposed = visible;
+  if (delta.width > 0)
+    {
+      exposed.size.width = delta.width;
+    }
+  else if (delta.width < 0)
+    {
+      exposed.origin.x = NSMaxX(visible) + delta.width;
+      exposed.size.width = -delta.width;
+    }
+  else if (delta.height > 0)
+    {
+      exposed.size.height = delta.height;
+    }
+  else
+    {
+      exposed.origin.y = NSMaxY(visible) + delta.height;
+      exposed.size.height = -delta.height;
+    }
+  [self setNeedsDisplayInRect: exposed];
+}
+
+@end
+
@@ -33,10 +33,15 @@
 */
 
 #import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSDate.h>
 #import <Foundation/NSException.h>
 #import <Foundation/NSFileManager.h>
+#import <Foundation/NSLock.h>
 #import <Foundation/NSNotification.h>
 #import <Foundation/NSPathUtilities.h>
+#import <Foundation/NSRunLoop.h>
+#import <Foundation/NSSet.h>
+#import <Foundation/NSThread.h>
 #import <Foundation/NSUserDefaults.h>
 #import <Foundation/NSURL.h>
 #import "AppKit/NSApplication.h"
@@ -58,6 +63,7 @@
 #import "AppKit/NSWorkspace.h"
 
 #import "GSGuiPrivate.h"
+#import "GSFileWatcher.h"
 #import "GNUstepGUI/GSTheme.h"
 
 #define _SAVE_PANEL_X_PAD	5
@@ -68,6 +74,17 @@ static NSFileManager *_fm = nil;
 
 static BOOL _gs_display_reading_progress = NO;
 
+/* How long the browser waits for a directory to be read before showing
+ * the column empty and filling it in later. */
+#define LISTING_WAIT 0.1
+/* The number of entries added to a column at a time. */
+#define LISTING_BATCH 200
+/* The number of directory listings kept for reuse. */
+#define MAX_CACHED_LISTINGS 32
+
+/* Directory listings by standardized path. */
+static NSMutableDictionary *listings = nil;
+
 static NSString	*
 pathToColumn(NSBrowser *browser, NSInteger column)
 {
@@ -101,6 +118,11 @@ setPath(NSBrowser *browser, NSString *path)
 - (NSComparisonResult)_gsSavePanelCompare:(NSString *)other;
 @end
 
+static NSComparisonResult compareFilenames (id elem1, id elem2, void *context);
+
+@class GSDirectoryListing;
+@class GSDirectoryLister;
+
 //
 // NSSavePanel private methods
 //
@@ -122,10 +144,178 @@ setPath(NSBrowser *browser, NSString *path)
 - (void) _setFileName: (NSString *)name;
 - (void) _setupForDirectory: (NSString *)path file: (NSString *)name;
 - (BOOL) _shouldShowExtension: (NSString *)extension;
+- (BOOL) _isAllowedExtension: (NSString *)extension;
+- (void) _updateAllowedExtensions;
 - (void) _windowResized: (NSNotification*)n;
 - (NSComparisonResult) _compareFilename: (NSString *)n1 with: (NSString *)n2;
+- (BOOL) _shouldShowFile: (NSString *)pathAndFile isDirectory: (BOOL *)isDir;
+- (void) _setupCell: (NSBrowserCell *)cell
+	    forFile: (NSString *)pathAndFile
+	isDirectory: (BOOL)isDir;
+- (void) _reloadColumn: (NSInteger)column;
+- (BOOL) _updateEntry: (NSString *)name inColumn: (NSInteger)column;
+- (void) _directoryChanged: (NSString *)path entries: (NSSet *)names;
+- (BOOL) _shouldShowExistingFile: (NSString *)pathAndFile
+		     isDirectory: (BOOL *)isDir;
+- (NSArray *) _visibleFiles: (NSArray *)files inDirectory: (NSString *)path;
+- (GSDirectoryListing *) _cachedListingForPath: (NSString *)path;
+- (void) _lister: (GSDirectoryLister *)lister
+	 didList: (GSDirectoryListing *)listing;
+- (void) _fillColumn: (GSDirectoryLister *)lister;
+- (void) _cancelListersFromColumn: (NSInteger)column;
+- (GSDirectoryLister *) _listerForColumn: (NSInteger)column;
 @end /* NSSavePanel (PrivateMethods) */
 
+/* The entries of a directory as it was read, sorted, with the names of
+ * those which are directories.
+ */
+@interface GSDirectoryListing : NSObject
+{
+@public
+  NSDate	*date;
+  NSArray	*names;
+  NSSet		*directories;
+}
+@end
+
+@implementation GSDirectoryListing
+- (void) dealloc
+{
+  RELEASE(date);
+  RELEASE(names);
+  RELEASE(directories);
+  [super dealloc];
+}
+@end
+
+/* Reads a directory for a column of the browser in a thread of its own,
+ * then has the panel fill the column from the listing a batch at a time.
+ */
+@interface GSDirectoryLister : NSObject
+{
+@public
+  NSSavePanel		*panel;		// Not retained
+  NSString		*path;
+  NSInteger		column;
+  NSMatrix		*matrix;	// Not retained
+  NSConditionLock	*lock;
+  GSDirectoryListing	*listing;
+  NSArray		*files;		// Entries to show, in order
+  NSUInteger		next;		// The first entry not yet shown
+  BOOL			cancelled;
+  BOOL			filling;
+  BOOL			deferred;	// Filled after the browser asked
+}
+- (id) initWithPanel: (NSSavePanel *)aPanel
+		path: (NSString *)aPath
+	      column: (NSInteger)aColumn;
+- (void) start;
+- (BOOL) waitUntilListed: (NSTimeInterval)seconds;
+- (void) cancel;
+@end
+
+@implementation GSDirectoryLister
+
+- (id) initWithPanel: (NSSavePanel *)aPanel
+		path: (NSString *)aPath
+	      column: (NSInteger)aColumn
+{
+  if ((self = [super init]) != nil)
+    {
+      panel = aPanel;
+      ASSIGN(path, aPath);
+      column = aColumn;
+      lock = [[NSConditionLock alloc] initWithCondition: 0];
+    }
+  return self;
+}
+
+- (void) dealloc
+{
+  RELEASE(path);
+  RELEASE(lock);
+  RELEASE(listing);
+  RELEASE(files);
+  [super dealloc];
+}
+
+- (void) _listed: (id)unused
+{
+  if (!cancelled && !filling)
+    {
+      [panel _lister: self didList: listing];
+    }
+}
+
+- (void) _list: (id)unused
+{
+  CREATE_AUTORELEASE_POOL(arp);
+  NSFileManager		*fm = [NSFileManager new];
+  GSDirectoryListing	*result = [GSDirectoryListing new];
+  NSMutableSet		*directories = [NSMutableSet new];
+  NSEnumerator		*enumerator;
+  NSString		*name;
+  NSArray		*names;
+
+  /* The date is taken first, so that a change made while the directory
+   * is read makes the listing out of date. */
+  result->date = RETAIN([[fm fileAttributesAtPath: path traverseLink: YES]
+    fileModificationDate]);
+  names = [fm directoryContentsAtPath: path];
+  if (names == nil)
+    {
+      names = [NSArray array];
+    }
+  enumerator = [names objectEnumerator];
+  while ((name = [enumerator nextObject]) != nil && !cancelled)
+    {
+      BOOL	isDir = NO;
+
+      if ([fm fileExistsAtPath: [path stringByAppendingPathComponent: name]
+		   isDirectory: &isDir] && isDir)
+	{
+	  [directories addObject: name];
+	}
+    }
+  result->names = RETAIN([names sortedArrayUsingSelector:
+    @selector(_gsSavePanelCompare:)]);
+  result->directories = directories;
+  RELEASE(fm);
+
+  [lock lock];
+  listing = result;
+  [lock unlockWithCondition: 1];
+  [self performSelectorOnMainThread: @selector(_listed:)
+			 withObject: nil
+		      waitUntilDone: NO];
+  DESTROY(arp);
+}
+
+- (void) start
+{
+  [NSThread detachNewThreadSelector: @selector(_list:)
+			   toTarget: self
+			 withObject: nil];
+}
+
+- (BOOL) waitUntilListed: (NSTimeInterval)seconds
+{
+  if ([lock lockWhenCondition: 1
+		   beforeDate: [NSDate dateWithTimeIntervalSinceNow: seconds]])
+    {
+      [lock unlock];
+      return YES;
+    }
+  return NO;
+}
+
+- (void) cancel
+{
+  cancelled = YES;
+}
+
+@end
+
 @implementation NSSavePanel (PrivateMethods)
 
 - (NSDragOperation) draggingEntered: (id <NSDraggingInfo>)sender
@@ -446,6 +636,146 @@ setPath(NSBrowser *browser, NSString *path)
   setPath(_browser, path);
 }
 
+- (void) _reloadColumn: (NSInteger)column
+{
+  NSString *path = [_browser path];
+  [_browser reloadColumn: column];
+  setPath(_browser, path);
+}
+
+/* Adds, removes or updates the cell for a single entry of the directory
+ * shown in a column, keeping the order of the column.  Returns NO if the
+ * whole column had to be loaded again instead.
+ */
+- (BOOL) _updateEntry: (NSString *)name inColumn: (NSInteger)column
+{
+  NSMatrix      *matrix = [_browser matrixInColumn: column];
+  NSString      *path = pathToColumn(_browser, column);
+  NSString      *pathAndFile = [path stringByAppendingPathComponent: name];
+  NSArray       *cells = [matrix cells];
+  NSInteger     count = [cells count];
+  NSInteger     row;
+  NSBrowserCell *cell = nil;
+  BOOL          isDir = NO;
+  BOOL          shown;
+
+  for (row = 0; row < count; row++)
+    {
+      if ([[[cells objectAtIndex: row] stringValue] isEqualToString: name])
+	{
+	  cell = [cells objectAtIndex: row];
+	  break;
+	}
+    }
+
+  shown = (_showsHiddenFiles || ![name hasPrefix: @"."])
+    && [self _shouldShowFile: pathAndFile isDirectory: &isDir];
+  if (shown && !_showsHiddenFiles)
+    {
+      NSString *h = [path stringByAppendingPathComponent: @".hidden"];
+
+      h = [NSString stringWithContentsOfFile: h];
+      if ([[h componentsSeparatedByString: @"\n"] containsObject: name])
+	{
+	  shown = NO;
+	}
+    }
+
+  if (cell != nil && [[matrix selectedCells] indexOfObjectIdenticalTo: cell]
+    != NSNotFound && (!shown || [cell isLeaf] != !isDir))
+    {
+      /* The browser shows the contents of the selected directory in the
+       * next column, so this needs more than the cell to change.
+       */
+      [self _reloadColumn: column];
+      return NO;
+    }
+
+  if (cell != nil && !shown)
+    {
+      [matrix removeRow: row];
+    }
+  else if (shown)
+    {
+      if (cell == nil)
+	{
+	  for (row = 0; row < count; row++)
+	    {
+	      NSString *other = [[cells objectAtIndex: row] stringValue];
+
+	      if ([self _compareFilename: name with: other]
+		== NSOrderedAscending)
+		{
+		  break;
+		}
+	    }
+	  if ([matrix numberOfColumns] == 0)
+	    {
+	      [matrix addColumn];
+	    }
+	  else
+	    {
+	      [matrix insertRow: row withCells: nil];
+	    }
+	  cell = [matrix cellAtRow: row column: 0];
+	  [cell setStringValue: name];
+	}
+      [self _setupCell: cell forFile: pathAndFile isDirectory: isDir];
+    }
+  [matrix sizeToCells];
+  [matrix setNeedsDisplay: YES];
+  return YES;
+}
+
+/* Called by the file watcher when directories shown in the browser
+ * change.
+ */
+- (void) _directoryChanged: (NSString *)path entries: (NSSet *)names
+{
+  NSInteger    column;
+  NSInteger    last = [_browser lastColumn];
+  NSEnumerator *enumerator;
+  NSString     *name;
+
+  if ([self isVisible] == NO)
+    {
+      [[GSFileWatcher sharedWatcher] removeObserver: self];
+      return;
+    }
+  for (column = 0; column <= last; column++)
+    {
+      if ([[pathToColumn(_browser, column) stringByStandardizingPath]
+	isEqualToString: path])
+	{
+	  break;
+	}
+    }
+  if (column > last)
+    {
+      [[GSFileWatcher sharedWatcher] removeObserver: self forDirectory: path];
+      return;
+    }
+
+  [listings removeObjectForKey: path];
+  if (names == nil || [names containsObject: @".hidden"]
+    || [self _listerForColumn: column] != nil)
+    {
+      /* Entries still to be added to the column may be among those which
+       * changed, so it is simpler to read the directory again. */
+      [self _reloadColumn: column];
+      return;
+    }
+  enumerator = [names objectEnumerator];
+  while ((name = [enumerator nextObject]) != nil)
+    {
+      if ([self _updateEntry: name inColumn: column] == NO)
+	{
+	  /* The column was loaded again, which took in all the changes. */
+	  break;
+	}
+    }
+}
+
 //
 // Methods invoked by button press
 //
@@ -615,19 +945,129 @@ selectCellWithString: (NSString*)title
 
 - (BOOL) _shouldShowExtension: (NSString *)extension
 {
-  if (_allowedFileTypes != nil
-      && [_allowedFileTypes indexOfObject: extension] == NSNotFound
-      && [_allowedFileTypes indexOfObject: @""] == NSNotFound)
+  if (_allowedExtensions != nil
+      && [self _isAllowedExtension: extension] == NO
+      && [_allowedExtensions containsObject: @""] == NO)
     return NO;
 
   return YES;
 }
 
+/* Returns YES if extension is one of the allowed file types, ignoring
+ * case.  This is asked for every entry of a directory, so it looks the
+ * extension up in a set made when the types are set.
+ */
+- (BOOL) _isAllowedExtension: (NSString *)extension
+{
+  if (_allowedExtensions == nil)
+    {
+      return NO;
+    }
+  return [_allowedExtensions containsObject: [extension lowercaseString]];
+}
+
+- (void) _updateAllowedExtensions
+{
+  NSWorkspace  *ws = [NSWorkspace sharedWorkspace];
+  NSMutableSet *extensions;
+  NSEnumerator *enumerator;
+  NSString     *type;
+
+  if (_allowedFileTypes == nil)
+    {
+      DESTROY(_allowedExtensions);
+      return;
+    }
+  extensions = [NSMutableSet setWithCapacity: [_allowedFileTypes count]];
+  enumerator = [_allowedFileTypes objectEnumerator];
+  while ((type = [enumerator nextObject]) != nil)
+    {
+      NSString *extension;
+
+      [extensions addObject: [type lowercaseString]];
+      /* The type may be a type name rather than an extension. */
+      extension = [ws preferredFilenameExtensionForType: type];
+      if (extension != nil)
+	{
+	  [extensions addObject: [extension lowercaseString]];
+	}
+    }
+  RELEASE(_allowedExtensions);
+  _allowedExtensions = [extensions copy];
+}
+
 - (void) _windowResized: (NSNotification*)n
 {
   [_browser setMaxVisibleColumns: [_browser frame].size.width / 140];
 }
 
+/* Returns YES if the file exists and passes the filters of the panel,
+ * setting *isDir to whether the browser should show it as a directory.
+ */
+- (BOOL) _shouldShowFile: (NSString *)pathAndFile isDirectory: (BOOL *)isDir
+{
+  if ([_fm fileExistsAtPath: pathAndFile isDirectory: isDir] == NO)
+    {
+      return NO;
+    }
+  return [self _shouldShowExistingFile: pathAndFile isDirectory: isDir];
+}
+
+/* Like -_shouldShowFile:isDirectory: for a file known to exist, with
+ * *isDir already set to whether it is a directory.
+ */
+- (BOOL) _shouldShowExistingFile: (NSString *)pathAndFile
+		     isDirectory: (BOOL *)isDir
+{
+  NSString *extension = [pathAndFile pathExtension];
+  BOOL     exists = YES;
+
+  /* Note: The initial directory and its parents are always shown, even if
+   * it they are file packages or would be rejected by the validator. */
+#define HAS_PATH_PREFIX(aPath, otherPath) \
+  ([aPath isEqualToString: otherPath] || \
+   [aPath hasPrefix: [otherPath stringByAppendingString: @"/"]])
+
+  if (!*isDir || !HAS_PATH_PREFIX(_directory, pathAndFile))
+    {
+      if (*isDir && !_treatsFilePackagesAsDirectories
+	  && ([self _isAllowedExtension: extension]
+	      || [[NSWorkspace sharedWorkspace] isFilePackageAtPath: pathAndFile]))
+	{
+	  *isDir = NO;
+	}
+
+      if (_delegateHasShowFilenameFilter)
+	{
+	  exists = [_delegate panel: self shouldShowFilename: pathAndFile];
+	}
+
+      if (exists && !*isDir)
+	{
+	  exists = [self _shouldShowExtension: extension];
+	}
+    }
+  return exists;
+}
+
+- (void) _setupCell: (NSBrowserCell *)cell
+	    forFile: (NSString *)pathAndFile
+	isDirectory: (BOOL)isDir
+{
+  NSImage *icon = [[[NSWorkspace sharedWorkspace] iconForFile: pathAndFile]
+    copy];
+  CGFloat iconSize = [cell cellSize].height - 1;
+
+  [icon setSize: NSMakeSize(iconSize, iconSize)];
+  [cell setImage: icon];
+  [icon release];
+
+  if (isDir)
+    [cell setLeaf: NO];
+  else
+    [cell setLeaf: YES];
+}
+
 - (NSComparisonResult) _compareFilename: (NSString *)n1 with: (NSString *)n2
 {
   if (_delegateHasCompareFilter)
@@ -643,6 +1083,248 @@ selectCellWithString: (NSString*)title
     }
 }
 
+/* Returns the files of a directory which the browser may show, leaving
+ * out hidden files unless they are to be shown.
+ */
+- (NSArray *) _visibleFiles: (NSArray *)files inDirectory: (NSString *)path
+{
+  NSString *h;
+  NSArray *hiddenFiles = nil;
+
+  // FIXME: Use NSFileManager to tell us what files are hidden/non-hidden
+  // rather than having it hardcoded here
+
+  if ([files containsObject: @".hidden"] == YES)
+    {
+      /* We need to remove files listed in the xxx/.hidden file.  */
+      h = [path stringByAppendingPathComponent: @".hidden"];
+      h = [NSString stringWithContentsOfFile: h];
+      hiddenFiles = [h componentsSeparatedByString: @"\n"];
+    }
+
+  /* Alse remove files starting with `.' (dot) */
+
+  /* Now copy the files array into a mutable array - but only if
+     strictly needed.  */
+  if (!_showsHiddenFiles)
+    {
+      NSInteger j;
+      /* We must make a mutable copy of the array because we shouldn't
+	 change the listing, which may be used again.  */
+      NSMutableArray *mutableFiles = AUTORELEASE ([files mutableCopy]);
+
+      /* Ok - now modify the mutable array removing unwanted files.  */
+      if (hiddenFiles != nil)
+	{
+	  [mutableFiles removeObjectsInArray: hiddenFiles];
+	}
+
+      /* Don't use i which is unsigned.  */
+      j = [mutableFiles count] - 1;
+
+      while (j >= 0)
+	{
+	  NSString *file = (NSString *)[mutableFiles objectAtIndex: j];
+
+	  if ([file hasPrefix: @"."])
+	    {
+	      /* NSLog (@"Removing dot file %@", file); */
+	      [mutableFiles removeObjectAtIndex: j];
+	    }
+	  j--;
+	}
+
+      files = mutableFiles;
+    }
+  return files;
+}
+
+/* Returns the listing of the directory at path read before, if the
+ * directory hasn't been modified since.
+ */
+- (GSDirectoryListing *) _cachedListingForPath: (NSString *)path
+{
+  NSString           *key = [path stringByStandardizingPath];
+  GSDirectoryListing *listing = [listings objectForKey: key];
+  NSDate             *date;
+
+  if (listing == nil)
+    {
+      return nil;
+    }
+  date = [[_fm fileAttributesAtPath: path traverseLink: YES]
+    fileModificationDate];
+  if (date == nil || [date isEqual: listing->date] == NO)
+    {
+      [listings removeObjectForKey: key];
+      return nil;
+    }
+  return listing;
+}
+
+/* Starts filling the column of the lister with the listing of its
+ * directory.
+ */
+- (void) _lister: (GSDirectoryLister *)lister
+	 didList: (GSDirectoryListing *)listing
+{
+  NSArray *files;
+
+  if (lister->deferred)
+    {
+      if (_gs_display_reading_progress)
+	{
+	  [super setTitle: @""];
+	}
+      if (lister->matrix != [_browser matrixInColumn: lister->column])
+	{
+	  [lister cancel];
+	  [_directoryListers removeObjectIdenticalTo: lister];
+	  return;
+	}
+    }
+  if (listing->date != nil)
+    {
+      if (listings == nil)
+	{
+	  listings = [NSMutableDictionary new];
+	}
+      else if ([listings count] >= MAX_CACHED_LISTINGS)
+	{
+	  [listings removeAllObjects];
+	}
+      [listings setObject: listing
+		   forKey: [lister->path stringByStandardizingPath]];
+    }
+
+  files = [self _visibleFiles: listing->names inDirectory: lister->path];
+  if (_delegateHasCompareFilter == YES)
+    {
+      files = [files sortedArrayUsingFunction: compareFilenames
+				      context: self];
+    }
+  ASSIGN(lister->listing, listing);
+  ASSIGN(lister->files, files);
+  lister->filling = YES;
+  [self _fillColumn: lister];
+}
+
+/* Adds the next batch of entries to the column of the lister, and
+ * arranges for the batch after that to be added once the events
+ * waiting have been handled.
+ */
+- (void) _fillColumn: (GSDirectoryLister *)lister
+{
+  NSMatrix      *matrix = lister->matrix;
+  NSString      *path = lister->path;
+  NSUInteger    count = [lister->files count];
+  NSUInteger    end = MIN(lister->next + LISTING_BATCH, count);
+  NSUInteger    i;
+  NSAutoreleasePool *pool;
+
+  if (lister->cancelled)
+    {
+      return;
+    }
+  if (lister->deferred
+    && matrix != [_browser matrixInColumn: lister->column])
+    {
+      [lister cancel];
+      [_directoryListers removeObjectIdenticalTo: lister];
+      return;
+    }
+
+  pool = [NSAutoreleasePool new];
+  for (i = lister->next; i < end; i++)
+    {
+      NSString *file = [lister->files objectAtIndex: i];
+      NSString *pathAndFile = [path stringByAppendingPathComponent: file];
+      BOOL     isDir = [lister->listing->directories containsObject: file];
+
+      if ([self _shouldShowExistingFile: pathAndFile isDirectory: &isDir])
+	{
+	  NSInteger     row = [matrix numberOfRows];
+	  NSBrowserCell *cell;
+
+	  if ([matrix numberOfColumns] == 0)
+	    {
+	      [matrix addColumn];
+	      row = 0;
+	    }
+	  else
+	    {
+	      /* Same as [matrix addRow] */
+	      [matrix insertRow: row withCells: nil];
+	    }
+	  cell = [matrix cellAtRow: row column: 0];
+	  [cell setStringValue: file];
+	  [self _setupCell: cell forFile: pathAndFile isDirectory: isDir];
+	}
+    }
+  lister->next = end;
+  RELEASE(pool);
+
+  if (lister->deferred)
+    {
+      [matrix sizeToCells];
+      [matrix setNeedsDisplay: YES];
+    }
+  if (end < count)
+    {
+      lister->deferred = YES;
+      [self performSelector: @selector(_fillColumn:)
+		 withObject: lister
+		 afterDelay: 0.0
+		    inModes: [NSArray arrayWithObjects: NSDefaultRunLoopMode,
+				NSModalPanelRunLoopMode,
+				NSEventTrackingRunLoopMode, nil]];
+      return;
+    }
+
+  RETAIN(lister);
+  [_directoryListers removeObjectIdenticalTo: lister];
+  if (lister->deferred && [_browser lastColumn] == lister->column
+    && HAS_PATH_PREFIX(_directory, path)
+    && [_directory isEqualToString: path] == NO)
+    {
+      /* The browser could not go further into the directory of the panel
+       * while this column was empty. */
+      setPath(_browser, _directory);
+    }
+  RELEASE(lister);
+}
+
+- (void) _cancelListersFromColumn: (NSInteger)column
+{
+  NSInteger i = [_directoryListers count];
+
+  while (i-- > 0)
+    {
+      GSDirectoryLister *lister = [_directoryListers objectAtIndex: i];
+
+      if (lister->column >= column)
+	{
+	  [lister cancel];
+	  [_directoryListers removeObjectAtIndex: i];
+	}
+    }
+}
+
+- (GSDirectoryLister *) _listerForColumn: (NSInteger)column
+{
+  NSEnumerator      *enumerator = [_directoryListers objectEnumerator];
+  GSDirectoryLister *lister;
+
+  while ((lister = [enumerator nextObject]) != nil)
+    {
+      if (lister->column == column)
+	{
+	  return lister;
+	}
+    }
+  return nil;
+}
+
 @end /* NSSavePanel (PrivateMethods) */
 
 //
@@ -703,9 +1385,13 @@ selectCellWithString: (NSString*)title
 - (void) dealloc
 {
   [[NSNotificationCenter defaultCenter] removeObserver: self];
+  [[GSFileWatcher sharedWatcher] removeObserver: self];
+  [self _cancelListersFromColumn: 0];
+  TEST_RELEASE (_directoryListers);
   TEST_RELEASE (_fullFileName);
   TEST_RELEASE (_directory);  
   TEST_RELEASE (_allowedFileTypes);
+  TEST_RELEASE (_allowedExtensions);
 
   [super dealloc];
 }
@@ -1020,6 +1706,7 @@ selectCellWithString: (NSString*)title
    	DESTROY(_allowedFileTypes);
       else
 	ASSIGN(_allowedFileTypes, types);
+      [self _updateAllowedExtensions];
       [self _reloadBrowser];
 
       if (hasAllowedExtension && [types count] &&
@@ -1643,31 +2330,37 @@ static NSComparisonResult compareFilenames (id elem1, id elem2, void *context)
 createRowsForColumn: (NSInteger)column
 	inMatrix: (NSMatrix*)matrix
 {
-  NSString              *path, *file, *pathAndFile, *extension; 
-  NSArray               *files;
-  NSUInteger            i, count, addedRows; 
-  BOOL                  exists, isDir;
-  NSBrowserCell         *cell;
-  // _gs_display_reading_progress variables
-  NSUInteger            reached_frac = 0;
-  NSUInteger            base_frac = 1;
-  BOOL                  display_progress = NO;
-  NSString              *progressString = nil;
-  NSWorkspace           *ws;
-  /* We create lot of objects in this method, so we use a pool */
-  NSAutoreleasePool     *pool;
+  NSString              *path;
+  GSDirectoryLister     *lister;
+  GSDirectoryListing    *listing;
 
-  pool = [NSAutoreleasePool new];
-  ws = [NSWorkspace sharedWorkspace];
   path = pathToColumn(_browser, column);
+  [[GSFileWatcher sharedWatcher] addObserver: self
+				    selector: @selector(_directoryChanged:entries:)
+				forDirectory: path];
+
+  /* Anything still being shown in this column or the ones after it is
+   * being replaced. */
+  [self _cancelListersFromColumn: column];
+  if (_directoryListers == nil)
+    {
+      _directoryListers = [NSMutableArray new];
+    }
+  lister = [[GSDirectoryLister alloc] initWithPanel: self
+					       path: path
+					     column: column];
+  lister->matrix = matrix;
+  [_directoryListers addObject: lister];
+  RELEASE(lister);
+
 #if	defined(__MINGW32__)
   if (column == 0)
     {
       NSMutableArray	*m;
       unsigned		i;
 
-      files = [ws mountedLocalVolumePaths];
-      m = [files mutableCopy];
+      m = [[[NSWorkspace sharedWorkspace] mountedLocalVolumePaths]
+	mutableCopy];
       i = [m count];
       while (i-- > 0)
 	{
@@ -1679,189 +2372,38 @@ createRowsForColumn: (NSInteger)column
 	  file = [file substringToIndex: [file length] - 1];
 	  [m replaceObjectAtIndex: i withObject: file];
 	}
-      files = [m autorelease];
-    }
-  else
-    {
-      files = [[NSFileManager defaultManager] directoryContentsAtPath: path];
-    }
-#else
-  files = [[NSFileManager defaultManager] directoryContentsAtPath: path];
-#endif
-
-  /* Remove hidden files.  */
-  {
-    NSString *h;
-    NSArray *hiddenFiles = nil;
-    
-    // FIXME: Use NSFileManager to tell us what files are hidden/non-hidden
-    // rather than having it hardcoded here
-
-    if ([files containsObject: @".hidden"] == YES)
-      {
-	/* We need to remove files listed in the xxx/.hidden file.  */
-	h = [path stringByAppendingPathComponent: @".hidden"];
-	h = [NSString stringWithContentsOfFile: h];
-	hiddenFiles = [h componentsSeparatedByString: @"\n"];
-      }
-
-    /* Alse remove files starting with `.' (dot) */
-
-    /* Now copy the files array into a mutable array - but only if
-       strictly needed.  */
-    if (!_showsHiddenFiles)
-      {
-	NSInteger j;
-	/* We must make a mutable copy of the array because the API
-	   says that NSFileManager -directoryContentsAtPath: return a
-	   NSArray, not a NSMutableArray, so we shouldn't expect it to
-	   be mutable.  */
-	NSMutableArray *mutableFiles = AUTORELEASE ([files mutableCopy]);
-	
-	/* Ok - now modify the mutable array removing unwanted files.  */
-	if (hiddenFiles != nil)
-	  {
-	    [mutableFiles removeObjectsInArray: hiddenFiles];
-	  }
-	
-	
-	/* Don't use i which is unsigned.  */
-	j = [mutableFiles count] - 1;
-	
-	while (j >= 0)
-	  {
-	    NSString *file = (NSString *)[mutableFiles objectAtIndex: j];
-	    
-	    if ([file hasPrefix: @"."])
-	      {
-		/* NSLog (@"Removing dot file %@", file); */
-		[mutableFiles removeObjectAtIndex: j];
-	      }
-	    j--;
-	  }
-	
-	files = mutableFiles;
-      }
-  }
-
-  count = [files count];
-
-  /* If array is empty, just return (nothing to display).  */
-  if (count == 0)
-    {
-      RELEASE (pool);
+      listing = AUTORELEASE([GSDirectoryListing new]);
+      listing->names = [[m sortedArrayUsingSelector:
+	@selector(_gsSavePanelCompare:)] retain];
+      listing->directories = [[NSSet alloc] initWithArray: m];
+      RELEASE(m);
+      [self _lister: lister didList: listing];
       return;
     }
+#endif
 
-  // Prepare Messages on title bar if directory is big and user wants them
-  if (_gs_display_reading_progress && (count > 100))
-    {
-      display_progress = YES;
-      base_frac = count / 4;
-      progressString = [_(@"Reading Directory ") stringByAppendingString: path];
-      [super setTitle: progressString];
-      // Is the following really safe? 
-      [self flushWindow];
-    }
-
-  //TODO: Sort after creation of matrix so we do not sort 
-  // files we are not going to show.  Use NSMatrix sorting cells method
-  // Sort list of files to display
-  if (_delegateHasCompareFilter == YES)
-    {
-      files = [files sortedArrayUsingFunction: compareFilenames 
-		     context: self];
-    }
-  else
-    files = [files sortedArrayUsingSelector: @selector(_gsSavePanelCompare:)];
-
-  addedRows = 0;
-  for (i = 0; i < count; i++)
+  listing = [self _cachedListingForPath: path];
+  if (listing == nil)
     {
-      // Update displayed message if needed
-      if (display_progress && (i > (base_frac * (reached_frac + 1))))
-        {
-          reached_frac++;
-          progressString = [progressString stringByAppendingString: @"."];
-          [super setTitle: progressString];
-          [self flushWindow];
-        }
-      // Now the real code
-      file = [files objectAtIndex: i];
-      extension = [file pathExtension];
-      
-      pathAndFile = [path stringByAppendingPathComponent: file];
-      exists = [_fm fileExistsAtPath: pathAndFile 
-		    isDirectory: &isDir];
-
-      /* Note: The initial directory and its parents are always shown, even if
-       * it they are file packages or would be rejected by the validator. */
-#define HAS_PATH_PREFIX(aPath, otherPath) \
-  ([aPath isEqualToString: otherPath] || \
-   [aPath hasPrefix: [otherPath stringByAppendingString: @"/"]])
-
-      if (exists && (!isDir || !HAS_PATH_PREFIX(_directory, pathAndFile)))
-	{
-	  if (isDir && !_treatsFilePackagesAsDirectories
-	      && ([ws isFilePackageAtPath: pathAndFile]
-		  || [_allowedFileTypes containsObject: extension]))
-	    {
-	      isDir = NO;
-	    }
-
-	  if (_delegateHasShowFilenameFilter)
-	    {
-	      exists = [_delegate panel: self shouldShowFilename: pathAndFile];
-	    }
-
-	  if (exists && !isDir)
-	    {
-	      exists = [self _shouldShowExtension: extension];
-	    }
-	} 
-
-      if (exists)
+      /* Reading a large or remote directory can take a long time, so it
+       * is read in another thread.  Most directories are read at once,
+       * and are shown straight away so that the column doesn't flicker;
+       * the others are shown when they have been read.
+       */
+      [lister start];
+      if ([lister waitUntilListed: LISTING_WAIT] == NO)
 	{
-	  if (addedRows == 0)
+	  lister->deferred = YES;
+	  if (_gs_display_reading_progress)
 	    {
-	      [matrix addColumn];
+	      [super setTitle: [_(@"Reading Directory ")
+		stringByAppendingString: path]];
 	    }
-	  else // addedRows > 0
-	    {
-	      /* Same as [matrix addRow] */
-	      [matrix insertRow: addedRows  withCells: nil];
-	      /* Possible TODO: Faster would be to create all the
-		 cells at once with a single call instead of resizing 
-		 the matrix each time a cell is inserted. */
-	    }
-
-	  cell = [matrix cellAtRow: addedRows column: 0];
-	  [cell setStringValue: file];
-
-	  {
-	    NSImage *icon = [[ws iconForFile: pathAndFile] copy];
-	    CGFloat iconSize = [cell cellSize].height - 1;
-	    [icon setSize: NSMakeSize(iconSize, iconSize)];
-	    [cell setImage: icon];
-	    [icon release];
-	  }
-
-	  if (isDir)
-	    [cell setLeaf: NO];
-	  else
-	    [cell setLeaf: YES];
-
-	  addedRows++;
+	  return;
 	}
+      listing = lister->listing;
     }
-
-  if (display_progress)
-    {
-      [super setTitle: @""];
-      [self flushWindow];
-    }
-
-  RELEASE (pool);
+  [self _lister: lister didList: listing];
 }
 
 - (BOOL) browser: (NSBrowser*)sender
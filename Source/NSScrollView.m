@@ -35,6 +35,7 @@
 #import <Foundation/NSNotification.h>
 #import <Foundation/NSUserDefaults.h>
 
+#import "AppKit/NSApplication.h"
 #import "AppKit/NSColor.h"
 #import "AppKit/NSColorList.h"
 #import "AppKit/NSCell.h"
@@ -55,6 +56,10 @@
 - (void) _scrollToPoint: (NSPoint)aPoint;
 @end
 
+@interface NSRulerView (Private)
+- (void) _documentViewDidScroll;
+@end
+
 //
 // For nib compatibility, this is used to properly
 // initialize the object from a OS X nib file in initWithCoder:.
@@ -398,6 +403,11 @@ static CGFloat scrollerWidth;
   _autohidesScrollers = flag;
 }
 
+/*
+ * A fast turn of the wheel queues up many events.  Those already
+ * waiting for the same place with the same modifiers are taken along,
+ * so that the receiver scrolls and redraws once for all of them.
+ */
 - (void) scrollWheel: (NSEvent *)theEvent
 {
   NSRect clipViewBounds;
@@ -405,6 +415,23 @@ static CGFloat scrollerWidth;
   CGFloat deltaX = [theEvent deltaX];
   CGFloat amount;
   NSPoint point;
+  NSEvent *next;
+
+  while ((next = [NSApp nextEventMatchingMask: NSScrollWheelMask
+                                    untilDate: nil
+                                       inMode: NSDefaultRunLoopMode
+                                      dequeue: NO]) != nil
+    && [next window] == [theEvent window]
+    && [next modifierFlags] == [theEvent modifierFlags]
+    && NSEqualPoints([next locationInWindow], [theEvent locationInWindow]))
+    {
+      next = [NSApp nextEventMatchingMask: NSScrollWheelMask
+                                untilDate: nil
+                                   inMode: NSDefaultRunLoopMode
+                                  dequeue: YES];
+      deltaX += [next deltaX];
+      deltaY += [next deltaY];
+    }
 
   if (_contentView == nil)
     {
@@ -918,12 +945,12 @@ static CGFloat scrollerWidth;
     {
       if (_hasHorizRuler)
         {
-          [_horizRuler setNeedsDisplay: YES];
+          [_horizRuler _documentViewDidScroll];
         }
       if (_hasVertRuler)
         {
-          [_vertRuler setNeedsDisplay: YES];
-       }
+          [_vertRuler _documentViewDidScroll];
+        }
     }
 }
 
@@ -1423,9 +1450,14 @@ static CGFloat scrollerWidth;
   return _vPageScroll;
 }
 
+/**
+ * Sets whether the document view scrolls while the knob of a scroller
+ * is dragged.  When flag is NO the knob only shows where the document
+ * will be scrolled to once it is let go, which suits documents that are
+ * too slow to draw for each move of the knob.
+ */
 - (void) setScrollsDynamically: (BOOL)flag
 {
-  // FIXME: This should change the behaviour of the scrollers
   _scrollsDynamically = flag;
 }
 
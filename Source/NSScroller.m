@@ -72,6 +72,10 @@ static CGFloat	scrollerWidth = 0.0;
  */
 static float	buttonsOffset = 1.0; // buttonsWidth = sw - 2*buttonsOffset
 
+/* The shortest time between two actions sent while the knob is dragged,
+   so that the target scrolls and redraws at most once per frame.  */
+static const NSTimeInterval	knobActionInterval = 1.0 / 60.0;
+
 + (void) _themeWillDeactivate: (NSNotification*)n
 {
   /* Clear cached information from the old theme ... will get info from
@@ -542,11 +546,23 @@ static float	buttonsOffset = 1.0; // buttonsWidth = sw - 2*buttonsOffset
 
 - (void) setDoubleValue: (double)aDouble
 {
+  NSRect oldKnobRect;
+
   if (_doubleValue == aDouble)
     {
       /* Most likely our trackKnob method initiated this via NSScrollView */
       return;
     }
+  /* Only the old and new places of the knob need drawing again, unless
+     the old value was made up to force a redisplay.  */
+  if (_doubleValue >= 0.0 && _doubleValue <= 1.0)
+    {
+      oldKnobRect = [self rectForPart: NSScrollerKnob];
+    }
+  else
+    {
+      oldKnobRect = [self rectForPart: NSScrollerKnobSlot];
+    }
   if (aDouble < 0.0)
     {
       _doubleValue = 0.0;
@@ -560,16 +576,20 @@ static float	buttonsOffset = 1.0; // buttonsWidth = sw - 2*buttonsOffset
       _doubleValue = aDouble;
     }
 
-  [self setNeedsDisplayInRect: [self rectForPart: NSScrollerKnobSlot]];
+  [self setNeedsDisplayInRect:
+    NSUnionRect(oldKnobRect, [self rectForPart: NSScrollerKnob])];
 }
 
 - (void) setKnobProportion: (CGFloat)proportion
 {
+  NSRect oldKnobRect;
+
   if (_knobProportion == proportion)
     {
       /* Most likely our trackKnob method initiated this via NSScrollView */
       return;
     }
+  oldKnobRect = [self rectForPart: NSScrollerKnob];
 
   if (proportion < 0.0)
     {
@@ -583,7 +603,8 @@ static float	buttonsOffset = 1.0; // buttonsWidth = sw - 2*buttonsOffset
     {
       _knobProportion = proportion;
     }
-  [self setNeedsDisplayInRect: [self rectForPart: NSScrollerKnobSlot]];
+  [self setNeedsDisplayInRect:
+    NSUnionRect(oldKnobRect, [self rectForPart: NSScrollerKnob])];
 
   // Handle the case when parts should disappear
   if (_knobProportion == 1.0)
@@ -861,6 +882,17 @@ static float	buttonsOffset = 1.0; // buttonsWidth = sw - 2*buttonsOffset
   NSEventType	eventType = [theEvent type];
   NSRect	knobRect;
   NSUInteger	flags = [theEvent modifierFlags];
+  BOOL		dynamic = YES;
+  BOOL		actionPending = NO;
+  NSTimeInterval lastAction = 0.0;
+
+  /* A target which doesn't scroll dynamically, for documents which are
+     too slow to draw while dragging, is only sent the action once the
+     knob is let go; until then the knob just shows where it will be.  */
+  if ([_target respondsToSelector: @selector(scrollsDynamically)])
+    {
+      dynamic = [_target scrollsDynamically];
+    }
 
   knobRect = [self rectForPart: NSScrollerKnob];
 
@@ -933,12 +965,25 @@ static float	buttonsOffset = 1.0; // buttonsWidth = sw - 2*buttonsOffset
 	   if (doubleValue != _doubleValue)
 	     {
 	       [self setDoubleValue: doubleValue];
-	       [self sendAction: _action to: _target];
+	       actionPending = YES;
 	     }
 	      
 	     lastPosition = newPosition;
          }
 
+       /* At most one action per frame; the knob keeps up meanwhile.  */
+       if (actionPending && dynamic)
+         {
+           NSTimeInterval now = [NSDate timeIntervalSinceReferenceDate];
+
+           if (now - lastAction >= knobActionInterval)
+             {
+               [self sendAction: _action to: _target];
+               lastAction = now;
+               actionPending = NO;
+             }
+         }
+
        /* 
 	* If our current event is actually the mouse up (perhaps the inner 
 	* loop got to this point) we want to update with the last info and 
@@ -947,13 +992,32 @@ static float	buttonsOffset = 1.0; // buttonsWidth = sw - 2*buttonsOffset
        if (eventType == NSLeftMouseUp)
          break;
 
-       /* Get the next event, blocking if necessary. */
+       /* Get the next event, blocking if necessary.  An action held back
+          is sent when it is due if the mouse stops meanwhile.  */
        theEvent = [NSApp nextEventMatchingMask: eventMask
-                     untilDate: [NSDate distantFuture] /* No limit, block until we get an event. */
+                     untilDate: (actionPending && dynamic)
+                       ? [NSDate dateWithTimeIntervalSinceReferenceDate:
+                           lastAction + knobActionInterval]
+                       : [NSDate distantFuture]
                      inMode: NSEventTrackingRunLoopMode
                      dequeue: YES];
+       if (theEvent == nil)
+         {
+           [self sendAction: _action to: _target];
+           lastAction = [NSDate timeIntervalSinceReferenceDate];
+           actionPending = NO;
+           theEvent = [NSApp nextEventMatchingMask: eventMask
+                         untilDate: [NSDate distantFuture]
+                         inMode: NSEventTrackingRunLoopMode
+                         dequeue: YES];
+         }
        eventType = [theEvent type];
   } while (eventType != NSLeftMouseUp);
+
+  if (actionPending)
+    {
+      [self sendAction: _action to: _target];
+    }
 }
 
 - (void) trackScrollButtons: (NSEvent*)theEvent
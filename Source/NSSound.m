@@ -42,9 +42,38 @@ enum
 };
 
 #define BUFFER_SIZE 4096
+#define RING_SIZE (16 * BUFFER_SIZE)	// Must be a power of two
+#define RING_WAIT 0.002			// Seconds to wait for the other side
+#define PREFILL_TIMEOUT 1.0
+
+/* The buffer between the thread reading a sound from its source and the
+   thread playing it.  The head is only moved by the reader and the tail
+   only by the player, each storing its index once the bytes up to it
+   have been written or played, so neither has to take a lock. */
+typedef struct _GSSoundRing {
+  uint8_t	*bytes;
+  NSUInteger	head;
+  NSUInteger	tail;
+  int		eof;		// The reader has read the last byte
+  int		flush;		// Drop what was read before a seek
+  int		abort;		// The player has stopped
+  int		readerDone;
+} GSSoundRing;
+
+#define RING_LOAD(x) __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define RING_STORE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+
+/* Sounds which decode to at most this many bytes (or the value of the
+   GSSoundCacheLimit user default) are kept decoded in memory. */
+#define DEFAULT_PCM_CACHE_LIMIT (512 * 1024)
+#define PCM_CACHE_TOTAL (8 * 1024 * 1024)
 
 /* Class variables and functions for class methods */
 static NSMutableDictionary *nameDict = nil;
+static NSMutableDictionary *pcmCache = nil;	// Sound data to decoded source
+static NSMutableArray *pcmCacheOrder = nil;	// Oldest first
+static NSUInteger pcmCacheSize = 0;
+static NSLock *pcmCacheLock = nil;
 static NSDictionary *nsmapping = nil;
 static NSArray *sourcePlugIns = nil;
 static NSArray *sinkPlugIns = nil;
@@ -131,8 +160,237 @@ static inline void _loadNSSoundPlugIns (void)
 
 @end 
 
+/* Plays decoded samples from memory.  The samples are shared between
+   all the sources made for the same sound data, each with a position
+   of its own, so several copies of a sound can play at once. */
+@interface GSPCMSoundSource : NSObject <GSSoundSource>
+{
+  NSData	*_pcm;
+  NSUInteger	_position;
+  int		_encoding;
+  NSUInteger	_channels;
+  NSUInteger	_rate;
+  NSByteOrder	_order;
+  NSUInteger	_frameSize;
+}
+- (id) initWithPCM: (NSData *)pcm likeSource: (id<GSSoundSource>)source;
+@end
+
+static NSUInteger
+bytesPerSample(int encoding)
+{
+  switch (encoding)
+    {
+      case GSSoundFormatPCMS8:
+      case GSSoundFormatPCMU8:
+      case GSSoundFormatULaw:
+      case GSSoundFormatALaw:
+        return 1;
+      case GSSoundFormatPCM16:
+        return 2;
+      case GSSoundFormatPCM24:
+        return 3;
+      case GSSoundFormatPCM32:
+      case GSSoundFormatFloat32:
+        return 4;
+      case GSSoundFormatFloat64:
+        return 8;
+      default:
+        return 0;
+    }
+}
+
+@implementation GSPCMSoundSource
+
++ (NSArray *) soundUnfilteredFileTypes
+{
+  return [NSArray array];
+}
+
++ (NSArray *) soundUnfilteredTypes
+{
+  return [NSArray array];
+}
+
++ (BOOL) canInitWithData: (NSData *)data
+{
+  return NO;
+}
+
+- (id) initWithData: (NSData *)data
+{
+  DESTROY(self);
+  return nil;
+}
+
+- (id) initWithPCM: (NSData *)pcm likeSource: (id<GSSoundSource>)source
+{
+  if ((self = [super init]) != nil)
+    {
+      ASSIGN(_pcm, pcm);
+      _encoding = [source encoding];
+      _channels = [source channelCount];
+      _rate = [source sampleRate];
+      _order = [source byteOrder];
+      _frameSize = MAX(bytesPerSample(_encoding) * _channels, 1);
+    }
+  return self;
+}
+
+- (void) dealloc
+{
+  RELEASE(_pcm);
+  [super dealloc];
+}
+
+- (NSData *) pcm
+{
+  return _pcm;
+}
+
+- (NSUInteger) readBytes: (void *)bytes length: (NSUInteger)length
+{
+  length = MIN(length, [_pcm length] - _position);
+  memcpy(bytes, (const uint8_t *)[_pcm bytes] + _position, length);
+  _position += length;
+  return length;
+}
+
+- (NSTimeInterval) duration
+{
+  return (_rate == 0) ? 0.0
+    : (NSTimeInterval)([_pcm length] / _frameSize) / _rate;
+}
+
+- (void) setCurrentTime: (NSTimeInterval)currentTime
+{
+  NSUInteger frame = (NSUInteger)(MAX(currentTime, 0.0) * _rate);
+
+  _position = MIN(frame * _frameSize, [_pcm length]);
+}
+
+- (NSTimeInterval) currentTime
+{
+  return (_rate == 0) ? 0.0 : (NSTimeInterval)(_position / _frameSize) / _rate;
+}
+
+- (int) encoding
+{
+  return _encoding;
+}
+
+- (NSUInteger) channelCount
+{
+  return _channels;
+}
+
+- (NSUInteger) sampleRate
+{
+  return _rate;
+}
+
+- (NSByteOrder) byteOrder
+{
+  return _order;
+}
+
+@end
+
+/* Returns a new source playing the decoded samples of data if they are
+   cached. */
+static GSPCMSoundSource *
+cachedSourceForData(NSData *data)
+{
+  GSPCMSoundSource *entry;
+
+  [pcmCacheLock lock];
+  entry = RETAIN([pcmCache objectForKey: data]);
+  [pcmCacheLock unlock];
+  if (entry == nil)
+    {
+      return nil;
+    }
+  AUTORELEASE(entry);
+  return AUTORELEASE([[GSPCMSoundSource alloc] initWithPCM: [entry pcm]
+                                                likeSource: entry]);
+}
+
+/* Decodes all of source if it is short enough, caches the samples for
+   data and returns a new source playing them.  Otherwise returns nil,
+   with source back at its start. */
+static GSPCMSoundSource *
+decodeSourceForData(NSData *data, id<GSSoundSource> source)
+{
+  NSUInteger bps = bytesPerSample([source encoding]);
+  NSUInteger limit = DEFAULT_PCM_CACHE_LIMIT;
+  GSPCMSoundSource *entry;
+  NSMutableData *pcm;
+  NSUInteger length;
+  NSUInteger bytesRead;
+  id value;
+
+  value = [[NSUserDefaults standardUserDefaults]
+    objectForKey: @"GSSoundCacheLimit"];
+  if (value != nil)
+    {
+      limit = [value unsignedIntegerValue];
+    }
+  if (bps == 0 || limit == 0
+    || [source duration] * [source sampleRate] * [source channelCount] * bps
+      > limit)
+    {
+      return nil;
+    }
+
+  pcm = [NSMutableData dataWithCapacity: limit];
+  do
+    {
+      length = [pcm length];
+      if (length > limit)
+        {
+          // Longer than its duration said.
+          [source setCurrentTime: 0.0];
+          return nil;
+        }
+      [pcm setLength: length + BUFFER_SIZE];
+      bytesRead = [source readBytes: (uint8_t *)[pcm mutableBytes] + length
+                             length: BUFFER_SIZE];
+      length += bytesRead;
+      [pcm setLength: length];
+    }
+  while (bytesRead > 0);
+  [source setCurrentTime: 0.0];
+  if (length == 0)
+    {
+      return nil;
+    }
+
+  entry = AUTORELEASE([[GSPCMSoundSource alloc]
+    initWithPCM: AUTORELEASE([pcm copy]) likeSource: source]);
+  [pcmCacheLock lock];
+  if ([pcmCache objectForKey: data] == nil)
+    {
+      [pcmCache setObject: entry forKey: data];
+      [pcmCacheOrder addObject: data];
+      pcmCacheSize += length;
+      while (pcmCacheSize > PCM_CACHE_TOTAL && [pcmCacheOrder count] > 1)
+        {
+          NSData *oldest = [pcmCacheOrder objectAtIndex: 0];
+
+          pcmCacheSize -= [[[pcmCache objectForKey: oldest] pcm] length];
+          [pcmCache removeObjectForKey: oldest];
+          [pcmCacheOrder removeObjectAtIndex: 0];
+        }
+    }
+  [pcmCacheLock unlock];
+  return AUTORELEASE([[GSPCMSoundSource alloc] initWithPCM: [entry pcm]
+                                                likeSource: entry]);
+}
+
 @interface NSSound (PrivateMethods)
 
+- (BOOL)_makeSourceAndSink;
+- (void)_fill;
 - (void)_stream;
 - (void)_finished: (NSNumber *)finishedPlaying;
 
@@ -140,41 +398,203 @@ static inline void _loadNSSoundPlugIns (void)
 
 @implementation NSSound (PrivateMethods)
 
+/* Finds plug-ins to read and play _data, reusing its decoded samples
+   when they were cached for an earlier sound. */
+- (BOOL)_makeSourceAndSink
+{
+  NSEnumerator *enumerator;
+  Class sourceClass = Nil,
+        sinkClass;
+
+  _source = RETAIN(cachedSourceForData(_data));
+  if (_source == nil)
+    {
+      // Search for an GSSoundSource bundle that can play this data.
+      enumerator = [sourcePlugIns objectEnumerator];
+      while ((sourceClass = [enumerator nextObject]) != nil)
+        {
+          if ([sourceClass canInitWithData: _data])
+            {
+              GSPCMSoundSource *decoded;
+
+              _source = [[sourceClass alloc] initWithData: _data];
+              if (_source == nil)
+                {
+                  NSLog (@"Could not read sound data!");
+                  return NO;
+                }
+              decoded = decodeSourceForData(_data, _source);
+              if (decoded != nil)
+                {
+                  ASSIGN(_source, (id)decoded);
+                }
+              break;
+            }
+        }
+      /* FIXME: There has to be a better way to do this check??? */
+      if (sourceClass == nil)
+        {
+          NSLog (@"Could not find suitable sound plug-in");
+          return NO;
+        }
+    }
+  
+  enumerator = [sinkPlugIns objectEnumerator];
+  /* FIXME: Grab the first available sink/device for now.  In the future
+       look for what is set in the GSSoundDeviceBundle default first. */
+  while ((sinkClass = [enumerator nextObject]) != nil)
+    {
+      if ([sinkClass canInitWithPlaybackDevice: nil])
+        {
+          _sink = [[sinkClass alloc] initWithEncoding: [_source encoding]
+                                             channels: [_source channelCount]
+                                           sampleRate: [_source sampleRate]
+                                            byteOrder: [_source byteOrder]];
+          if (_sink == nil)
+            {
+              NSLog (@"Could not open sound sink!");
+              return NO;
+            }
+          break;
+        }
+    }
+  
+  if (sinkClass == nil)
+    {
+      NSLog (@"Could not find suitable sound plug-in");
+      return NO;
+    }
+  return YES;
+}
+
+// Reads the sound into the ring, on a thread of its own.
+- (void)_fill
+{
+  CREATE_AUTORELEASE_POOL(pool);
+  GSSoundRing *ring = _ring;
+  BOOL rewound = NO;
+
+  while (!_shouldStop && !RING_LOAD(ring->abort))
+    {
+      NSUInteger head = ring->head;
+      NSUInteger offset = head & (RING_SIZE - 1);
+      NSUInteger length;
+      NSUInteger bytesRead;
+
+      length = RING_SIZE - (head - RING_LOAD(ring->tail));
+      length = MIN(MIN(length, BUFFER_SIZE), RING_SIZE - offset);
+      if (length == 0 || RING_LOAD(ring->flush))
+        {
+          [NSThread sleepForTimeInterval: RING_WAIT];
+          continue;
+        }
+
+      // Seeking takes the lock, so the read must be at one position.
+      [_readLock lock];
+      if (RING_LOAD(ring->flush))
+        {
+          [_readLock unlock];
+          continue;
+        }
+      bytesRead = [_source readBytes: ring->bytes + offset length: length];
+      if (bytesRead > 0)
+        {
+          RING_STORE(ring->head, head + bytesRead);
+          rewound = NO;
+        }
+      else if (_shouldLoop && !rewound)
+        {
+          [_source setCurrentTime: 0.0];
+          rewound = YES;
+          bytesRead = 1;
+        }
+      [_readLock unlock];
+      if (bytesRead == 0)
+        {
+          RING_STORE(ring->eof, 1);
+          break;
+        }
+    }
+  // Start from the beginning the next time the sound is played.
+  [_readLock lock];
+  [_source setCurrentTime: 0.0];
+  [_readLock unlock];
+  RING_STORE(ring->readerDone, 1);
+  DESTROY(pool);
+}
+
+// Plays what has been read into the ring, on a thread of its own.
 - (void)_stream
 {
-  NSUInteger bytesRead;
+  GSSoundRing *ring = _ring;
   BOOL success = NO;
-  void *buffer;
+  BOOL started = NO;
+  BOOL waiting = NO;
   
   // Exit with success = NO if device could not be open.
   if ([_sink open])
     {
-      // Allocate space for buffer and start writing.
-      buffer = NSZoneMalloc(NSDefaultMallocZone(), BUFFER_SIZE);
-      do
+      success = YES;
+      while (!_shouldStop)
         {
-          do
+          NSUInteger tail = ring->tail;
+          NSUInteger head;
+          NSUInteger length;
+
+          // If not SOUND_SHOULD_PLAY block thread
+          if ([_readLock condition] != SOUND_SHOULD_PLAY)
             {
-              // If not SOUND_SHOULD_PLAY block thread
               [_readLock lockWhenCondition: SOUND_SHOULD_PLAY];
-              if (_shouldStop)
+              [_readLock unlock];
+              continue;
+            }
+          if (RING_LOAD(ring->flush))
+            {
+              RING_STORE(ring->tail, RING_LOAD(ring->head));
+              RING_STORE(ring->flush, 0);
+              continue;
+            }
+
+          head = RING_LOAD(ring->head);
+          if (head == tail)
+            {
+              /* The reader stores its last head before the end. */
+              if (RING_LOAD(ring->eof) && RING_LOAD(ring->head) == tail)
                 {
-                  [_readLock unlock];
                   break;
                 }
-              bytesRead = [_source readBytes: buffer
-                                     length: BUFFER_SIZE];
-              [_readLock unlock];
-              [_playbackLock lock];
-              success = [_sink playBytes: buffer length: bytesRead];
-              [_playbackLock unlock];
-            } while ((!_shouldStop) && (bytesRead > 0) && success);
-          
-          [_source setCurrentTime: 0.0];
-        } while (_shouldLoop == YES && _shouldStop == NO);
+              if (started && !waiting)
+                {
+                  _underruns++;
+                  waiting = YES;
+                }
+              [NSThread sleepForTimeInterval: RING_WAIT];
+              continue;
+            }
+          waiting = NO;
+
+          length = MIN(MIN(head - tail, BUFFER_SIZE),
+                       RING_SIZE - (tail & (RING_SIZE - 1)));
+          [_playbackLock lock];
+          success = [_sink playBytes: ring->bytes + (tail & (RING_SIZE - 1))
+                              length: length];
+          [_playbackLock unlock];
+          if (!success)
+            {
+              break;
+            }
+          started = YES;
+          RING_STORE(ring->tail, tail + length);
+        }
       
       [_sink close];
-      NSZoneFree (NSDefaultMallocZone(), buffer);
+    }
+
+  // The ring goes away with the locks, once the reader is done with it.
+  RING_STORE(ring->abort, 1);
+  while (!RING_LOAD(ring->readerDone))
+    {
+      [NSThread sleepForTimeInterval: RING_WAIT];
     }
   
   RETAIN(self);
@@ -188,6 +608,12 @@ static inline void _loadNSSoundPlugIns (void)
 {
   DESTROY(_readLock);
   DESTROY(_playbackLock);
+  if (_ring != NULL)
+    {
+      NSZoneFree(NSDefaultMallocZone(), _ring->bytes);
+      NSZoneFree(NSDefaultMallocZone(), _ring);
+      _ring = NULL;
+    }
   
   /* FIXME: should I call -sound:didFinishPlaying: when -stop was sent? */
   if ([_delegate respondsToSelector: @selector(sound:didFinishPlaying:)])
@@ -210,6 +636,9 @@ static inline void _loadNSSoundPlugIns (void)
       [self setVersion: 2];
 
       nameDict = [[NSMutableDictionary alloc] initWithCapacity: 10];
+      pcmCache = [[NSMutableDictionary alloc] init];
+      pcmCacheOrder = [[NSMutableArray alloc] init];
+      pcmCacheLock = [[NSLock alloc] init];
       
       if (path)
         {
@@ -274,55 +703,11 @@ static inline void _loadNSSoundPlugIns (void)
 
 - (id) initWithData: (NSData *)data
 {
-  NSEnumerator *enumerator;
-  Class sourceClass,
-        sinkClass;
-    
   _data = data;
   RETAIN(_data);
   
-  // Search for an GSSoundSource bundle that can play this data.
-  enumerator = [sourcePlugIns objectEnumerator];
-  while ((sourceClass = [enumerator nextObject]) != nil)
+  if ([self _makeSourceAndSink] == NO)
     {
-      if ([sourceClass canInitWithData: _data])
-        {
-          _source = [[sourceClass alloc] initWithData: _data];
-          if (_source == nil)
-            {
-              NSLog (@"Could not read sound data!");
-              DESTROY(self);
-              return nil;
-            }
-          break;
-        }
-    }
-  
-  enumerator = [sinkPlugIns objectEnumerator];
-  /* FIXME: Grab the first available sink/device for now.  In the future
-       look for what is set in the GSSoundDeviceBundle default first. */
-  while ((sinkClass = [enumerator nextObject]) != nil)
-    {
-      if ([sinkClass canInitWithPlaybackDevice: nil])
-        {
-          _sink = [[sinkClass alloc] initWithEncoding: [_source encoding]
-                                             channels: [_source channelCount]
-                                           sampleRate: [_source sampleRate]
-                                            byteOrder: [_source byteOrder]];
-          if (_sink == nil)
-            {
-              NSLog (@"Could not open sound sink!");
-              DESTROY(self);
-              return nil;
-            }
-          break;
-        }
-    }
-  
-  /* FIXME: There has to be a better way to do this check??? */
-  if (sourceClass == nil || sinkClass == nil)
-    {
-      NSLog (@"Could not find suitable sound plug-in");
       DESTROY(self);
       return nil;
     }
@@ -377,10 +762,27 @@ static inline void _loadNSSoundPlugIns (void)
       return NO;
     }
   _shouldStop = NO;
+  _underruns = 0;
+  _ring = NSZoneCalloc(NSDefaultMallocZone(), 1, sizeof(GSSoundRing));
+  _ring->bytes = NSZoneMalloc(NSDefaultMallocZone(), RING_SIZE);
+  [_readLock unlockWithCondition: SOUND_SHOULD_PLAY];
+  [NSThread detachNewThreadSelector: @selector(_fill)
+                           toTarget: self
+                         withObject: nil];
+  if (_prefills)
+    {
+      NSDate *limit = [NSDate dateWithTimeIntervalSinceNow: PREFILL_TIMEOUT];
+
+      while (RING_LOAD(_ring->head) < RING_SIZE
+        && !RING_LOAD(_ring->readerDone)
+        && [limit timeIntervalSinceNow] > 0)
+        {
+          [NSThread sleepForTimeInterval: RING_WAIT];
+        }
+    }
   [NSThread detachNewThreadSelector: @selector(_stream)
                            toTarget: self
                          withObject: nil];
-  [_readLock unlockWithCondition: SOUND_SHOULD_PLAY];
   
   return YES;
 }
@@ -453,6 +855,11 @@ static inline void _loadNSSoundPlugIns (void)
 {
   [_readLock lock];
   [_source setCurrentTime: currentTime];
+  // What was read ahead from the old position must not be played.
+  if (_ring != NULL)
+    {
+      RING_STORE(_ring->flush, 1);
+    }
   [_readLock unlock];
 }
 
@@ -466,6 +873,21 @@ static inline void _loadNSSoundPlugIns (void)
   _shouldLoop = loops;
 }
 
+- (void) setPrefillsBeforePlaying: (BOOL)flag
+{
+  _prefills = flag;
+}
+
+- (BOOL) prefillsBeforePlaying
+{
+  return _prefills;
+}
+
+- (NSUInteger) underrunCount
+{
+  return _underruns;
+}
+
 - (NSTimeInterval) duration
 {
   return [_source duration];
@@ -780,8 +1202,19 @@ static inline void _loadNSSoundPlugIns (void)
   newSound->_playbackDeviceIdentifier = [_playbackDeviceIdentifier
                                           copyWithZone: zone];
   newSound->_channelMapping = [_channelMapping copyWithZone: zone];
-	
-  /* FIXME: Need to prepare the object for playback before going further. */
+
+  /* The copy plays on its own, from the same decoded samples if the
+     sound is short enough to have them cached. */
+  newSound->_source = nil;
+  newSound->_sink = nil;
+  newSound->_readLock = nil;
+  newSound->_playbackLock = nil;
+  newSound->_ring = NULL;
+  newSound->_underruns = 0;
+  if ([newSound _makeSourceAndSink] == NO)
+    {
+      DESTROY(newSound);
+    }
   return newSound;
 }
 
@@ -35,6 +35,7 @@
 #import <Foundation/NSBundle.h>
 #import <Foundation/NSConnection.h>
 #import <Foundation/NSDictionary.h>
+#import <Foundation/NSDebug.h>
 #import <Foundation/NSDistantObject.h>
 #import <Foundation/NSEnumerator.h>
 #import <Foundation/NSException.h>
@@ -80,6 +81,11 @@ extern NSString *GSSpellServerName(NSString *checkerDictionary, NSString *langua
 
 - (NSArray *) _suggestGuessesForWord: (NSString *)word
 			  inLanguage: (NSString *)language;
+
+// Not known to spell servers older than the GSspell of this library.
+- (bycopy NSArray *) _findMisspelledWordRangesInString: (bycopy NSString *)string
+					      language: (NSString *)language
+					  ignoredWords: (NSArray *)ignoredWords;
 @end
 
 // Methods needed to get the GSServicesManager
@@ -738,3 +744,75 @@ static NSInteger __documentTag = 0;
   return NO;
 }
 @end
+
+@implementation NSSpellChecker (GSIncrementalSpellChecker)
+
+- (id) _serverProxyForThreads
+{
+  id proxy = [self _serverProxy];
+
+  if (proxy != nil)
+    {
+      [[(NSDistantObject *)proxy connectionForProxy] enableMultipleThreads];
+    }
+  return proxy;
+}
+
++ (NSArray *) _misspelledWordRangesInString: (NSString *)string
+				   language: (NSString *)language
+			       ignoredWords: (NSArray *)ignoredWords
+				     server: (id)proxy
+{
+  NSMutableArray *ranges = [NSMutableArray array];
+  NSUInteger length = [string length];
+  NSUInteger start = 0;
+
+  /* Ask for all the misspellings of the string in one message, and only
+     when the server does not know that, one misspelling at a time.  */
+  NS_DURING
+    {
+      NSArray *r;
+
+      r = [(id<NSSpellServerPrivateProtocol>)proxy
+	    _findMisspelledWordRangesInString: string
+				     language: language
+				 ignoredWords: ignoredWords];
+      NS_VALUERETURN(r, NSArray*);
+    }
+  NS_HANDLER
+    {
+      NSDebugLLog(@"NSSpellChecker", @"%@", [localException reason]);
+    }
+  NS_ENDHANDLER
+
+  // As above, a failing spell server must not bring down the application.
+  NS_DURING
+    {
+      while (start < length)
+	{
+	  NSInteger count = 0;
+	  NSRange r;
+
+	  r = [(id<NSSpellServerPrivateProtocol>)proxy
+		_findMisspelledWordInString: [string substringFromIndex: start]
+				   language: language
+			       ignoredWords: ignoredWords
+				  wordCount: &count
+				  countOnly: NO];
+	  if (r.length == 0)
+	    break;
+	  r.location += start;
+	  [ranges addObject: [NSValue valueWithRange: r]];
+	  start = NSMaxRange(r);
+	}
+    }
+  NS_HANDLER
+    {
+      NSLog(@"%@", [localException reason]);
+    }
+  NS_ENDHANDLER
+
+  return ranges;
+}
+
+@end
@@ -398,6 +398,11 @@ static NSNotificationCenter *nc = nil;
  * a "ghost" display of the splitview (without doing the 
  * resize) by doing:
  * defaults write NSGlobalDomain GSUseGhostResize YES
+ * A live resize happens at most once every 1/60 of a second, so that
+ * panes which are slow to lay out or draw don't fall behind the pointer;
+ * the last position is always applied.  The interval, in seconds, can be
+ * changed, or set to 0 to resize for every mouse motion, by doing:
+ * defaults write NSGlobalDomain GSSplitViewResizeInterval 0.05
  */
 - (void) mouseDown: (NSEvent*)theEvent
 {
@@ -424,6 +429,12 @@ static NSNotificationCenter *nc = nil;
   NSRect oldRect; //only one can be dragged at a time
   BOOL lit = NO;
   NSCursor *cursor;
+  /* Throttling of the live resize: the interval between resizes, the
+     time of the last one and whether a position is waiting for it.  */
+  NSTimeInterval resizeInterval = 1.0 / 60.0;
+  NSTimeInterval lastResize = 0.0;
+  BOOL resizePending = NO;
+  NSPoint resized;
 
   /*  if there are less the two subviews, there is nothing to do */
   if (count < 2)
@@ -604,6 +615,18 @@ static NSNotificationCenter *nc = nil;
                           inMode: NSEventTrackingRunLoopMode
                          dequeue: YES];
 
+  if (liveResize)
+    {
+      id interval = [[NSUserDefaults standardUserDefaults]
+                      objectForKey: @"GSSplitViewResizeInterval"];
+
+      if (interval != nil)
+        {
+          resizeInterval = [interval doubleValue];
+        }
+      resized = p;
+    }
+
   if (delegateConstrains)
     {
       constrainImp = (floatIMP)[_delegate methodForSelector: constrainSel];
@@ -618,11 +641,6 @@ static NSNotificationCenter *nc = nil;
   // user is moving the knob loop until left mouse up
   while ([e type] != NSLeftMouseUp)
     {
-      if (liveResize)
-        {
-          // Save the old position
-          op = p;
-        }
       p = [self convertPoint: [e locationInWindow] fromView: nil];
       if (delegateConstrains)
         {
@@ -677,9 +695,29 @@ static NSNotificationCenter *nc = nil;
         NSEvent *ee;
 
         e = [app nextEventMatchingMask: eventMask
-                  untilDate: farAway
+                  untilDate: resizePending
+                    ? [NSDate dateWithTimeIntervalSinceReferenceDate:
+                        lastResize + resizeInterval]
+                    : farAway
                   inMode: NSEventTrackingRunLoopMode
                   dequeue: YES];
+        if (e == nil)
+          {
+            /* The pointer stopped before the next resize was due: show
+               where the divider is now, then wait for more motion.  */
+            [self _resize: v withOldSplitView: prev withFrame: r fromPoint: p 
+              withBigRect: bigRect divHorizontal: divHorizontal
+              divVertical: divVertical];
+            [_window invalidateCursorRectsForView: self];
+            [self setNeedsDisplay: YES];
+            lastResize = [NSDate timeIntervalSinceReferenceDate];
+            resized = p;
+            resizePending = NO;
+            e = [app nextEventMatchingMask: eventMask
+                      untilDate: farAway
+                      inMode: NSEventTrackingRunLoopMode
+                      dequeue: YES];
+          }
 
         if ((ee = [app nextEventMatchingMask: NSLeftMouseUpMask
                        untilDate: longTimeAgo
@@ -708,14 +746,27 @@ static NSNotificationCenter *nc = nil;
       if (liveResize)
         {
           // If the splitview was moved, we resize the subviews
-          if ((_isVertical == YES && p.x != op.x)
-               || (_isVertical == NO && p.y != op.y))
+          if ((_isVertical == YES && p.x != resized.x)
+               || (_isVertical == NO && p.y != resized.y))
             {
-              [self _resize: v withOldSplitView: prev withFrame: r fromPoint: p 
-                withBigRect: bigRect divHorizontal: divHorizontal
-                divVertical: divVertical];
-              [_window invalidateCursorRectsForView: self];
-              [self setNeedsDisplay: YES];
+              NSTimeInterval now = [NSDate timeIntervalSinceReferenceDate];
+
+              if (now - lastResize >= resizeInterval
+                || [e type] == NSLeftMouseUp)
+                {
+                  [self _resize: v withOldSplitView: prev withFrame: r
+                      fromPoint: p withBigRect: bigRect
+                  divHorizontal: divHorizontal divVertical: divVertical];
+                  [_window invalidateCursorRectsForView: self];
+                  [self setNeedsDisplay: YES];
+                  lastResize = now;
+                  resized = p;
+                  resizePending = NO;
+                }
+              else
+                {
+                  resizePending = YES;
+                }
             }
         }
       
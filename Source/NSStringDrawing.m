@@ -34,6 +34,8 @@
 
 #import <Foundation/NSException.h>
 #import <Foundation/NSLock.h>
+#import <Foundation/NSUserDefaults.h>
+#import <Foundation/NSValue.h>
 
 #import "AppKit/NSAffineTransform.h"
 #import "AppKit/NSLayoutManager.h"
@@ -50,21 +52,28 @@ For bigger values the width gets ignored.
 
 
 /*
-A size of 16 and these constants give a hit rate of 80%-90% for normal app
-use (based on real world statistics gathered with the help of some users
-from #GNUstep).
+A size of 16 gives a hit rate of 80%-90% for normal app use (based on real
+world statistics gathered with the help of some users from #GNUstep).
+Applications drawing many different strings, like forms and tables with
+lots of labels, may set a bigger size with the GSStringDrawingCacheSize
+user default or +setStringDrawingCacheSize:.
 */
-#define NUM_CACHE_ENTRIES 16
-#define HIT_BOOST         2
-#define MISS_COST         1
+#define DEFAULT_CACHE_SIZE 16
+#define MAX_CACHE_SIZE     4096
 
 
 typedef struct
 {
   NSInteger used;
   NSUInteger string_hash;
+  NSUInteger key_hash;
   NSInteger hasSize, useScreenFonts;
 
+  /* Next entry in the same hash bucket, or -1. */
+  NSInteger hash_next;
+  /* Neighbours in the list of entries by last use, or -1. */
+  NSInteger lru_prev, lru_next;
+
   NSTextStorage *textStorage;
   NSLayoutManager *layoutManager;
   NSTextContainer *textContainer;
@@ -75,7 +84,17 @@ typedef struct
 
 
 static BOOL did_init = NO;
-static cache_t cache[NUM_CACHE_ENTRIES];
+static cache_t *cache = NULL;
+static NSInteger cache_size = 0;
+
+/* Hash buckets with the index of their first entry; a power of two. */
+static NSInteger *buckets = NULL;
+static NSUInteger num_buckets = 0;
+
+/* Most and least recently used entries. */
+static NSInteger lru_head = -1, lru_tail = -1;
+
+static NSUInteger hits, misses, evictions;
 
 static NSTextStorage   *scratchTextStorage;
 static NSLayoutManager *scratchLayoutManager;
@@ -83,31 +102,128 @@ static NSTextContainer *scratchTextContainer;
 
 static NSRecursiveLock *cacheLock = nil;
 
-/* For collecting statistics. */
+/* Print statistics at exit. */
 //#define STATS
 
 #ifdef STATS
-static int total, hits, misses, hash_hits;
-
 static void NSStringDrawing_dump_stats(void)
 {
-#define P(x) printf("%15i %s\n", x, #x);
-  P(total)
+#define P(x) printf("%15lu %s\n", (unsigned long)x, #x);
   P(hits)
   P(misses)
-  P(hash_hits)
+  P(evictions)
 #undef P
-  printf("%15.8f hit ratio\n", hits / (double)total);
+  printf("%15.8f hit ratio\n", hits / (double)(hits + misses));
 }
 #endif
 
-static void init_string_drawing(void)
+static void new_text_system(NSTextStorage **ts, NSLayoutManager **lm,
+			    NSTextContainer **tc)
 {
-  NSInteger i;
   NSTextStorage *textStorage;
   NSLayoutManager *layoutManager;
   NSTextContainer *textContainer;
 
+  textStorage = [[NSTextStorage alloc] init];
+  layoutManager = [[NSLayoutManager alloc] init];
+  [textStorage addLayoutManager: layoutManager];
+  [layoutManager release];
+  textContainer = [[NSTextContainer alloc]
+		    initWithContainerSize: NSMakeSize(10, 10)];
+  [textContainer setLineFragmentPadding: 0];
+  [layoutManager addTextContainer: textContainer];
+  [textContainer release];
+
+  *ts = textStorage;
+  *lm = layoutManager;
+  *tc = textContainer;
+}
+
+static void lru_unlink(NSInteger i)
+{
+  cache_t *c = cache + i;
+
+  if (c->lru_prev != -1)
+    cache[c->lru_prev].lru_next = c->lru_next;
+  else
+    lru_head = c->lru_next;
+  if (c->lru_next != -1)
+    cache[c->lru_next].lru_prev = c->lru_prev;
+  else
+    lru_tail = c->lru_prev;
+  c->lru_prev = c->lru_next = -1;
+}
+
+static void lru_push_front(NSInteger i)
+{
+  cache_t *c = cache + i;
+
+  c->lru_prev = -1;
+  c->lru_next = lru_head;
+  if (lru_head != -1)
+    cache[lru_head].lru_prev = i;
+  else
+    lru_tail = i;
+  lru_head = i;
+}
+
+static void hash_unlink(NSInteger i)
+{
+  NSInteger *p = &buckets[cache[i].key_hash & (num_buckets - 1)];
+
+  while (*p != -1)
+    {
+      if (*p == i)
+	{
+	  *p = cache[i].hash_next;
+	  break;
+	}
+      p = &cache[*p].hash_next;
+    }
+  cache[i].hash_next = -1;
+}
+
+/*
+Drop all cached entries and set up an empty cache with the given number
+of entries. The text system objects of the entries are created on first
+use.
+*/
+static void setup_cache(NSInteger size)
+{
+  NSInteger i;
+
+  if (size < 1)
+    size = 1;
+  if (size > MAX_CACHE_SIZE)
+    size = MAX_CACHE_SIZE;
+
+  for (i = 0; i < cache_size; i++)
+    {
+      [cache[i].textStorage release];
+    }
+  free(cache);
+  free(buckets);
+
+  cache_size = size;
+  cache = calloc(cache_size, sizeof(cache_t));
+  for (num_buckets = 1; num_buckets < 2 * (NSUInteger)cache_size; )
+    num_buckets *= 2;
+  buckets = malloc(num_buckets * sizeof(NSInteger));
+  for (i = 0; i < (NSInteger)num_buckets; i++)
+    buckets[i] = -1;
+
+  lru_head = lru_tail = -1;
+  for (i = 0; i < cache_size; i++)
+    {
+      cache[i].hash_next = -1;
+      lru_push_front(i);
+    }
+}
+
+static void init_string_drawing(void)
+{
+  NSInteger size;
+
   if (did_init)
     return;
   did_init = YES;
@@ -115,32 +231,12 @@ static void init_string_drawing(void)
 #ifdef STATS
   atexit(NSStringDrawing_dump_stats);
 #endif
-  
-  for (i = 0; i < NUM_CACHE_ENTRIES + 1; i++)
-    {
-      textStorage = [[NSTextStorage alloc] init];
-      layoutManager = [[NSLayoutManager alloc] init];
-      [textStorage addLayoutManager: layoutManager];
-      [layoutManager release];
-      textContainer = [[NSTextContainer alloc]
-			initWithContainerSize: NSMakeSize(10, 10)];
-      [textContainer setLineFragmentPadding: 0];
-      [layoutManager addTextContainer: textContainer];
-      [textContainer release];
-      
-      if (i < NUM_CACHE_ENTRIES)
-	{
-	  cache[i].textStorage = textStorage;
-	  cache[i].layoutManager = layoutManager;
-	  cache[i].textContainer = textContainer;
-	}
-      else
-	{
-	  scratchTextStorage = textStorage;
-	  scratchLayoutManager = layoutManager;
-	  scratchTextContainer = textContainer;
-	}
-    }
+
+  size = [[NSUserDefaults standardUserDefaults]
+	   integerForKey: @"GSStringDrawingCacheSize"];
+  setup_cache(size > 0 ? size : DEFAULT_CACHE_SIZE);
+  new_text_system(&scratchTextStorage, &scratchLayoutManager,
+		  &scratchTextContainer);
 }
 
 static inline void cache_lock()
@@ -179,85 +275,81 @@ static inline BOOL is_size_match(cache_t *c, NSInteger hasSize, NSSize size)
     }
 }
 
+static inline NSUInteger key_hash_for(NSUInteger string_hash,
+				      NSInteger hasSize, NSSize size,
+				      NSInteger useScreenFonts)
+{
+  NSUInteger h = string_hash * 2 + (useScreenFonts ? 1 : 0);
+
+  if (hasSize)
+    {
+      h = h * 31 + (NSUInteger)(NSInteger)size.width;
+      h = h * 31 + (NSUInteger)(NSInteger)size.height;
+    }
+  /* Mix the high bits in, since the bucket is taken from the low bits. */
+  return h ^ (h >> 16);
+}
+
 static NSInteger cache_match(NSInteger hasSize, NSSize size, NSInteger useScreenFonts, NSInteger *matched)
 {
-  NSInteger i, j;
+  NSInteger i;
   cache_t *c;
-  NSInteger least_used;
-  NSInteger replace;
-  NSInteger orig_used;
   NSUInteger string_hash = [[scratchTextStorage string] hash];
-
-#ifdef STATS
-  total++;
-#endif
+  NSUInteger key_hash = key_hash_for(string_hash, hasSize, size,
+				     useScreenFonts);
+  NSInteger *bucket = &buckets[key_hash & (num_buckets - 1)];
 
   *matched = 1;
-  replace = least_used = -1;
-
-  /*
-  A deterministic pattern for replacing cache entries can hit ugly worst
-  cases on certain matching use patterns (where the cache is full of old
-  unused entries, but the new entries keep replacing each other).
-
-  By starting at a random index, we avoid this kind of problem.
-  */
-  j = rand() % NUM_CACHE_ENTRIES;
-  for (i = 0; i < NUM_CACHE_ENTRIES; i++, j++)
-    {
-      if (j == NUM_CACHE_ENTRIES)
-	j = 0;
-      c = cache + j;
-      if (least_used == -1 || c->used < least_used)
-	{
-	  least_used = c->used;
-	  replace = j;
-	}
 
-      if (!c->used)
-	continue;
-
-      orig_used = c->used;
-      if (c->used > MISS_COST)
-	c->used -= MISS_COST;
-      else
-	c->used = 1;
-
-      if (c->string_hash != string_hash
-	  || c->useScreenFonts != useScreenFonts)
+  for (i = *bucket; i != -1; i = cache[i].hash_next)
+    {
+      c = cache + i;
+      if (c->key_hash != key_hash
+	  || c->string_hash != string_hash
+	  || c->useScreenFonts != useScreenFonts
+	  || !is_size_match(c, hasSize, size))
 	continue;
 
-#ifdef STATS
-      hash_hits++;
-#endif
-
       if (![scratchTextStorage isEqualToAttributedString: c->textStorage])
 	continue;
 
-      /* String and attributes match, check size. */
-      if (is_size_match(c, hasSize, size))
+      hits++;
+      if (i != lru_head)
 	{
-	  c->used = orig_used + HIT_BOOST;
-#ifdef STATS
-	  hits++;
-#endif
-	  return j;
+	  lru_unlink(i);
+	  lru_push_front(i);
 	}
+      return i;
     }
 
-  NSCAssert(replace != -1, @"Couldn't find a cache entry to replace.");
-
-#ifdef STATS
+  /* Replace the least recently used entry. */
   misses++;
-#endif
   *matched = 0;
 
-  c = cache + replace;
+  i = lru_tail;
+  NSCAssert(i != -1, @"Couldn't find a cache entry to replace.");
+  c = cache + i;
+  if (c->used)
+    {
+      evictions++;
+      hash_unlink(i);
+    }
+  else if (c->textStorage == nil)
+    {
+      new_text_system(&c->textStorage, &c->layoutManager,
+		      &c->textContainer);
+    }
+
   c->used = 1;
   c->string_hash = string_hash;
+  c->key_hash = key_hash;
   c->hasSize = hasSize;
   c->useScreenFonts = useScreenFonts;
   c->givenSize = size;
+  c->hash_next = *bucket;
+  *bucket = i;
+  lru_unlink(i);
+  lru_push_front(i);
 
   {
     id temp;
@@ -269,7 +361,7 @@ static NSInteger cache_match(NSInteger hasSize, NSSize size, NSInteger useScreen
 #undef SWAP
   }
 
-  return replace;
+  return i;
 }
 
 static inline void prepare_string(NSString *string, NSDictionary *attributes)
@@ -704,6 +796,153 @@ glyphs to be drawn upside-down, so we need to tell NSFont to flip the fonts.
 @end
 
 
+@implementation NSString (GSStringDrawingBatch)
+
++ (void) drawStrings: (NSArray*)strings
+	     inRects: (const NSRect*)rects
+      withAttributes: (NSDictionary*)attrs
+{
+  NSUInteger count = [strings count];
+  NSUInteger i;
+  NSGraphicsContext *ctxt;
+  BOOL flipped;
+  int screenFonts;
+
+  if (count == 0)
+    return;
+
+  ctxt = GSCurrentContext();
+  flipped = [[NSView focusView] isFlipped];
+  screenFonts = use_screen_fonts();
+
+  cache_lock();
+  if (!flipped)
+    {
+      DPSscale(ctxt, 1, -1);
+      [NSFont _setFontFlipHack: YES];
+    }
+  NS_DURING
+    {
+      for (i = 0; i < count; i++)
+	{
+	  NSString *string = [strings objectAtIndex: i];
+	  NSRect rect = rects[i];
+	  NSInteger ci;
+	  cache_t *c;
+	  NSRange r;
+	  BOOL need_clip;
+
+	  if (rect.size.width <= 0 || rect.size.height <= 0
+	      || [string length] == 0)
+	    continue;
+
+	  prepare_string(string, attrs);
+	  ci = cache_lookup(1, rect.size, screenFonts);
+	  c = &cache[ci];
+
+	  if (!flipped)
+	    rect.origin.y = -NSMaxY(rect);
+
+	  /* See -drawWithRect:options:attributes: */
+	  need_clip = !(c->usedRect.origin.x >= 0 && c->usedRect.origin.y <= 0
+			&& NSMaxX(c->usedRect) <= rect.size.width
+			&& NSMaxY(c->usedRect) <= rect.size.height);
+	  if (need_clip)
+	    {
+	      DPSgsave(ctxt);
+	      DPSrectclip(ctxt, rect.origin.x, rect.origin.y,
+			  rect.size.width, rect.size.height);
+	    }
+
+	  r = [c->layoutManager
+		glyphRangeForBoundingRect: NSMakeRect(0, 0, rect.size.width,
+						      rect.size.height)
+		inTextContainer: c->textContainer];
+	  [c->layoutManager drawBackgroundForGlyphRange: r
+	    atPoint: rect.origin];
+	  [c->layoutManager drawGlyphsForGlyphRange: r
+	    atPoint: rect.origin];
+
+	  if (need_clip)
+	    DPSgrestore(ctxt);
+	}
+    }
+  NS_HANDLER
+    {
+      if (!flipped)
+	{
+	  DPSscale(ctxt, 1, -1);
+	  [NSFont _setFontFlipHack: NO];
+	}
+      cache_unlock();
+      [localException raise];
+    }
+  NS_ENDHANDLER;
+  if (!flipped)
+    {
+      DPSscale(ctxt, 1, -1);
+      [NSFont _setFontFlipHack: NO];
+    }
+  cache_unlock();
+}
+
+@end
+
+
+@implementation NSString (GSStringDrawingCache)
+
++ (NSUInteger) stringDrawingCacheSize
+{
+  NSUInteger size;
+
+  cache_lock();
+  size = cache_size;
+  cache_unlock();
+  return size;
+}
+
++ (void) setStringDrawingCacheSize: (NSUInteger)size
+{
+  cache_lock();
+  if ((NSInteger)size != cache_size)
+    {
+      setup_cache(size);
+    }
+  cache_unlock();
+}
+
++ (NSDictionary*) stringDrawingCacheStatistics
+{
+  NSDictionary *d;
+  NSInteger i, entries = 0;
+
+  cache_lock();
+  for (i = 0; i < cache_size; i++)
+    {
+      if (cache[i].used)
+	entries++;
+    }
+  d = [NSDictionary dictionaryWithObjectsAndKeys:
+    [NSNumber numberWithUnsignedInteger: hits], @"Hits",
+    [NSNumber numberWithUnsignedInteger: misses], @"Misses",
+    [NSNumber numberWithUnsignedInteger: evictions], @"Evictions",
+    [NSNumber numberWithInteger: entries], @"Entries",
+    [NSNumber numberWithInteger: cache_size], @"Size",
+    nil];
+  cache_unlock();
+  return d;
+}
+
++ (void) resetStringDrawingCacheStatistics
+{
+  cache_lock();
+  hits = misses = evictions = 0;
+  cache_unlock();
+}
+
+@end
+
+
 /*
 Dummy function; see comment in NSApplication.m, +initialize.
 */
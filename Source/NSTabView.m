@@ -262,6 +262,13 @@
 
       _selected = tabViewItem;
       [_selected _setTabState: NSSelectedTab];
+      if (_selected != nil && [_selected isViewLoaded] == NO
+        && [_delegate respondsToSelector:
+          @selector(tabView:viewForTabViewItem:)])
+        {
+          [_selected setView: [_delegate tabView: self
+                                 viewForTabViewItem: _selected]];
+        }
       selectedView = [_selected view];
       if (selectedView != nil)
         {
@@ -713,6 +720,34 @@
 }
 @end
 
+@implementation NSTabView (GSLazyTabViews)
+
+- (void) unloadUnselectedTabViews
+{
+  BOOL ask;
+  NSUInteger i;
+
+  if (![_delegate respondsToSelector: @selector(tabView:viewForTabViewItem:)])
+    {
+      return;
+    }
+  ask = [_delegate respondsToSelector:
+    @selector(tabView:shouldUnloadViewOfTabViewItem:)];
+  for (i = 0; i < [_items count]; i++)
+    {
+      NSTabViewItem *item = [_items objectAtIndex: i];
+
+      if (item != _selected && [item isViewLoaded]
+        && (!ask || [_delegate tabView: self
+                     shouldUnloadViewOfTabViewItem: item]))
+        {
+          [item unloadView];
+        }
+    }
+}
+
+@end
+
 @implementation NSTabViewItem (KeyViewLoop)
 
 - (void) _setUpKeyViewLoopWithNextKeyView: (NSView *)nextKeyView
@@ -287,3 +287,22 @@
 }
 
 @end
+
+@implementation NSTabViewItem (GSLazyView)
+
+- (BOOL) isViewLoaded
+{
+  return _view != nil;
+}
+
+- (void) unloadView
+{
+  if (_state == NSSelectedTab)
+    {
+      return;
+    }
+  _first_responder = nil;
+  DESTROY(_view);
+}
+
+@end
@@ -44,18 +44,24 @@
 #import <Foundation/NSUserDefaults.h>
 #import <Foundation/NSValue.h>
 #import <Foundation/NSKeyedArchiver.h>
+#import <Foundation/NSMapTable.h>
+#import <Foundation/NSNull.h>
 
 #import "AppKit/NSTableView.h"
 #import "AppKit/NSApplication.h"
+#import "AppKit/NSBezierPath.h"
+#import "AppKit/NSBitmapImageRep.h"
 #import "AppKit/NSCell.h"
 #import "AppKit/NSClipView.h"
 #import "AppKit/NSColor.h"
 #import "AppKit/NSEvent.h"
+#import "AppKit/NSFont.h"
 #import "AppKit/NSImage.h"
 #import "AppKit/NSGraphics.h"
 #import "AppKit/NSKeyValueBinding.h"
 #import "AppKit/NSScroller.h"
 #import "AppKit/NSScrollView.h"
+#import "AppKit/NSStringDrawing.h"
 #import "AppKit/NSTableColumn.h"
 #import "AppKit/NSTableHeaderView.h"
 #import "AppKit/NSText.h"
@@ -68,8 +74,10 @@
 #import "AppKit/NSCustomImageRep.h"
 #import "GNUstepGUI/GSTheme.h"
 #import "GSBindingHelpers.h"
+#import "GSTypeSelectIndex.h"
 
 #include <math.h>
+#include <string.h>
 static NSNotificationCenter *nc = nil;
 
 static const NSInteger currentVersion = 5;
@@ -114,6 +122,13 @@ typedef struct _tableViewFlags
 #define CONTROL_DOWN (1 << 3)
 #define ADDING_ROW (1 << 4)
 
+/* At most this many rows are drawn into a drag image */
+#define DRAG_IMAGE_MAX_ROWS 8
+
+/* Characters typed within this many seconds of each other are matched
+   together against the row strings */
+#define TYPE_SELECT_INTERVAL 1.0
+
 @interface NSTableView (NotificationRequestMethods)
 - (void) _postSelectionIsChangingNotification;
 - (void) _postSelectionDidChangeNotification;
@@ -148,6 +163,22 @@ typedef struct _tableViewFlags
 - (BOOL) _isCellEditableColumn: (NSInteger)columnIndex
                            row: (NSInteger)rowIndex;
 - (NSInteger) _numRows;
+- (id) _cachedObjectValueAtColumn: (NSInteger)columnIndex
+                              row: (NSInteger)rowIndex;
+- (BOOL) _fetchObjectValuesInRows: (NSRange)rows;
+- (void) _prefetchRowsAroundVisibleRows;
+- (void) _invalidateObjectValueCache;
+- (void) _invalidateObjectValuesInRow: (NSInteger)rowIndex;
+- (void) _invalidateObjectValuesFromRow: (NSInteger)rowIndex;
+- (void) _shiftRowsAtIndex: (NSInteger)rowIndex by: (NSInteger)delta;
+- (void) _rowsChangedFromRow: (NSInteger)rowIndex;
+- (void) _updateRowHeightSums;
+- (NSInteger) _columnBeforeX: (CGFloat)x;
+- (void) _tileFromColumn: (NSInteger)columnIndex;
+- (BOOL) _delegateGivesRowHeights;
+- (CGFloat) _delegateHeightOfRow: (NSInteger)rowIndex;
+- (NSString *) _typeSelectStringForRow: (NSInteger)rowIndex;
+- (NSInteger) _typeSelectRowForEvent: (NSEvent *)theEvent;
 @end
 
 @interface NSTableView (SelectionHelper)
@@ -165,6 +196,9 @@ typedef struct _tableViewFlags
 @interface NSTableView (EventLoopHelper)
 - (void) _trackCellAtColumn:(NSInteger)column row:(NSInteger)row withEvent:(NSEvent *)ev;
 - (BOOL) _startDragOperationWithEvent:(NSEvent *)theEvent;
+- (NSImage *) _dragImageForRows: (NSIndexSet*)rows
+                          event: (NSEvent*)event
+                         offset: (NSPoint*)offset;
 @end
 
 /*
@@ -1986,8 +2020,110 @@ static void computeNewSelection(NSTableView *tv,
 - (void) _editNextCellAfterRow:(NSInteger)row inColumn:(NSInteger)column;
 - (void) _autosaveTableColumns;
 - (void) _autoloadTableColumns;
+- (void) _updateRowHeights;
+- (CGFloat) _originOfRow: (NSInteger)rowIndex;
+- (CGFloat) _heightOfRow: (NSInteger)rowIndex;
+- (CGFloat) _heightOfRows;
+- (NSInteger) _rowAtOffset: (CGFloat)offset;
+- (CGFloat) _rowPositionAtOffset: (CGFloat)offset;
 @end
 
+/*
+ * Fenwick tree of row heights.  sums[i] (counting from 1) holds the
+ * sum of the heights of the rows from i - (i & -i) up to i - 1.
+ */
+static void
+row_sums_build(CGFloat *sums, const CGFloat *heights, NSInteger count)
+{
+  NSInteger i;
+
+  sums[0] = 0.0;
+  for (i = 1; i <= count; i++)
+    {
+      sums[i] = heights[i - 1];
+    }
+  for (i = 1; i <= count; i++)
+    {
+      NSInteger parent = i + (i & -i);
+
+      if (parent <= count)
+        {
+          sums[parent] += sums[i];
+        }
+    }
+}
+
+/* Returns the sum of the heights of the rows before row.  */
+static CGFloat
+row_sums_prefix(const CGFloat *sums, NSInteger row)
+{
+  CGFloat sum = 0.0;
+
+  while (row > 0)
+    {
+      sum += sums[row];
+      row -= row & -row;
+    }
+  return sum;
+}
+
+static void
+row_sums_add(CGFloat *sums, NSInteger count, NSInteger row, CGFloat delta)
+{
+  for (row++; row <= count; row += row & -row)
+    {
+      sums[row] += delta;
+    }
+}
+
+/* Returns the row offset falls in, or count if it is below the last
+   row.  */
+static NSInteger
+row_sums_find(const CGFloat *sums, NSInteger count, CGFloat offset)
+{
+  NSInteger row = 0;
+  NSInteger step = 1;
+
+  while (step * 2 <= count)
+    {
+      step *= 2;
+    }
+  for (; step > 0; step /= 2)
+    {
+      if (row + step <= count && sums[row + step] <= offset)
+        {
+          row += step;
+          offset -= sums[row];
+        }
+    }
+  return row;
+}
+
+/* Returns the last column whose origin is at most x, or less than x if
+   strict is YES, or -1 if there is none.  Column origins never decrease,
+   so a binary search finds it.  */
+static NSInteger
+column_at_x(const CGFloat *origins, NSInteger count, CGFloat x, BOOL strict)
+{
+  NSInteger low = 0;
+  NSInteger high = count;
+
+  while (low < high)
+    {
+      NSInteger mid = low + (high - low) / 2;
+
+      if (origins[mid] < x || (!strict && origins[mid] == x))
+        {
+          low = mid + 1;
+        }
+      else
+        {
+          high = mid;
+        }
+    }
+  return low - 1;
+}
+
 
 @implementation NSTableView 
 
@@ -2065,6 +2201,8 @@ static void computeNewSelection(NSTableView *tv,
   RELEASE (_selectedColumns);
   RELEASE (_selectedRows);
   RELEASE (_sortDescriptors);
+  TEST_RELEASE (_typeSelectIndex);
+  TEST_RELEASE (_typeSelectString);
   TEST_RELEASE (_headerView);
   TEST_RELEASE (_cornerView);
   if (_autosaveTableColumns == YES)
@@ -2078,6 +2216,15 @@ static void computeNewSelection(NSTableView *tv,
     {
       NSZoneFree (NSDefaultMallocZone (), _columnOrigins);
     }
+  if (_rowHeights != NULL)
+    {
+      NSZoneFree (NSDefaultMallocZone (), _rowHeights);
+      NSZoneFree (NSDefaultMallocZone (), _rowHeightSums);
+    }
+  if (_objectValueCache != NULL)
+    {
+      NSFreeMapTable (_objectValueCache);
+    }
   if (_delegate != nil)
     {
       [nc removeObserver: _delegate  name: nil  object: self];
@@ -2111,17 +2258,18 @@ static void computeNewSelection(NSTableView *tv,
 
 - (void) addTableColumn: (NSTableColumn *)aColumn
 {
+  [self _invalidateObjectValueCache];
   [aColumn setTableView: self];
   [_tableColumns addObject: aColumn];
   _numberOfColumns++;
   if (_numberOfColumns > 1)
     {
       _columnOrigins = NSZoneRealloc (NSDefaultMallocZone (), _columnOrigins,
-				      (sizeof (float)) * _numberOfColumns);
+				      (sizeof (CGFloat)) * _numberOfColumns);
     }
   else 
     {
-      _columnOrigins = NSZoneMalloc (NSDefaultMallocZone (), sizeof (float));
+      _columnOrigins = NSZoneMalloc (NSDefaultMallocZone (), sizeof (CGFloat));
     }      
   [self tile];
 }
@@ -2130,6 +2278,8 @@ static void computeNewSelection(NSTableView *tv,
 {
   NSInteger columnIndex = [self columnWithIdentifier: [aColumn identifier]];
 
+  [self _invalidateObjectValueCache];
+
   if (columnIndex == -1)
     {
       NSLog (@"Warning: Tried to remove not-existent column from table");
@@ -2156,7 +2306,7 @@ static void computeNewSelection(NSTableView *tv,
   if (_numberOfColumns > 0)
     {
       _columnOrigins = NSZoneRealloc (NSDefaultMallocZone (), _columnOrigins,
-				      (sizeof (float)) * _numberOfColumns);
+				      (sizeof (CGFloat)) * _numberOfColumns);
     }
   else 
     {
@@ -2188,6 +2338,8 @@ static void computeNewSelection(NSTableView *tv,
   if (columnIndex == newIndex)
     return;
 
+  [self _invalidateObjectValueCache];
+
   if (columnIndex > newIndex)
     {
       minRange = newIndex;
@@ -2245,8 +2397,8 @@ static void computeNewSelection(NSTableView *tv,
 		     atIndex: newIndex];
       [_tableColumns removeObjectAtIndex: columnIndex + 1];
     }
-  /* Tile */
-  [self tile];
+  /* Tile, the columns before the moved ones keep their origins */
+  [self _tileFromColumn: MIN(columnIndex, newIndex)];
 
   /* Post notification */
 
@@ -2331,6 +2483,10 @@ static void computeNewSelection(NSTableView *tv,
     }
 
   _dataSource_editable = [anObject respondsToSelector: sel_c];
+  _dataSource_batches = [anObject respondsToSelector:
+    @selector(tableView:objectValuesForTableColumns:rows:)];
+  _dataSource_prefetches = [anObject respondsToSelector:
+    @selector(tableView:prefetchRows:)];
 
   /* We do *not* retain the dataSource, it's like a delegate */
   _dataSource = anObject;
@@ -2345,10 +2501,247 @@ static void computeNewSelection(NSTableView *tv,
 
 - (void) reloadData
 {
+  [self _invalidateObjectValueCache];
+  _prefetchedRows = NSMakeRange(0, 0);
   [self noteNumberOfRowsChanged];
   [self setNeedsDisplay: YES];
 }
 
+/**
+ * Gets the values of the cells in the given rows and columns from the
+ * data source again, and redisplays them.
+ */
+- (void) reloadDataForRowIndexes: (NSIndexSet *)rowIndexes
+                   columnIndexes: (NSIndexSet *)columnIndexes
+{
+  NSUInteger row;
+
+  for (row = [rowIndexes firstIndex];
+       row != NSNotFound && row < (NSUInteger)_numberOfRows;
+       row = [rowIndexes indexGreaterThanIndex: row])
+    {
+      NSUInteger column;
+
+      for (column = [columnIndexes firstIndex];
+           column != NSNotFound && column < (NSUInteger)_numberOfColumns;
+           column = [columnIndexes indexGreaterThanIndex: column])
+        {
+          if (column == 0 && _typeSelectIndex != nil)
+            {
+              [_typeSelectIndex
+                setString: [self _typeSelectStringForRow: row]
+                  forItem: row];
+            }
+          if (_objectValueCache != NULL)
+            {
+              NSMapRemove (_objectValueCache,
+                           (void *)(row * _numberOfColumns + column));
+            }
+          [self setNeedsDisplayInRect: [self frameOfCellAtColumn: column
+                                                             row: row]];
+        }
+    }
+}
+
+/**
+ * Starts a group of row insertions, removals and moves.  The table is
+ * resized and redisplayed once, at the matching -endUpdates.  Calls
+ * may be nested.
+ */
+- (void) beginUpdates
+{
+  if (_beginUpdatesCount++ == 0)
+    {
+      _firstChangedRow = NSIntegerMax;
+    }
+}
+
+/**
+ * Ends a group of changes started with -beginUpdates.
+ */
+- (void) endUpdates
+{
+  if (_beginUpdatesCount == 0)
+    {
+      NSDebugLLog(@"NSTableView", @"endUpdates without beginUpdates");
+      return;
+    }
+  if (--_beginUpdatesCount == 0 && _firstChangedRow != NSIntegerMax)
+    {
+      [self _rowsChangedFromRow: _firstChangedRow];
+    }
+}
+
+/**
+ * Tells the table that rows were inserted in the data source at the
+ * given indexes, which are the indexes of the new rows after the
+ * insertion.  Unlike -noteNumberOfRowsChanged, the data source is not
+ * asked for the number of rows, the selection moves with the rows it
+ * belongs to, and only the rows from the first new one on are redrawn,
+ * so appending rows to a long table redraws just the new rows.  The
+ * rows are not animated.
+ */
+- (void) insertRowsAtIndexes: (NSIndexSet *)indexes
+               withAnimation: (NSTableViewAnimationOptions)animationOptions
+{
+  NSUInteger row;
+
+  if ([indexes count] == 0)
+    {
+      return;
+    }
+  if ([indexes lastIndex] >= _numberOfRows + [indexes count])
+    {
+      [NSException raise: NSRangeException
+                  format: @"Row index out of table in insertRowsAtIndexes"];
+    }
+
+  for (row = [indexes firstIndex];
+       row != NSNotFound;
+       row = [indexes indexGreaterThanIndex: row])
+    {
+      [self _shiftRowsAtIndex: row by: 1];
+    }
+  [self _rowsChangedFromRow: [indexes firstIndex]];
+}
+
+/**
+ * Tells the table that the rows at the given indexes were removed from
+ * the data source.  Selected rows that were removed are deselected, and
+ * only the rows from the first removed one on are redrawn.  The rows are
+ * not animated.
+ */
+- (void) removeRowsAtIndexes: (NSIndexSet *)indexes
+               withAnimation: (NSTableViewAnimationOptions)animationOptions
+{
+  BOOL selectionChanged = NO;
+  NSUInteger row;
+
+  if ([indexes count] == 0)
+    {
+      return;
+    }
+  if ([indexes lastIndex] >= _numberOfRows)
+    {
+      [NSException raise: NSRangeException
+                  format: @"Row index out of table in removeRowsAtIndexes"];
+    }
+
+  /* Remove the last rows first so that the indexes of the others don't
+     change */
+  for (row = [indexes lastIndex];
+       row != NSNotFound;
+       row = [indexes indexLessThanIndex: row])
+    {
+      if ([_selectedRows containsIndex: row])
+        {
+          if (selectionChanged == NO)
+            {
+              [self _postSelectionIsChangingNotification];
+              selectionChanged = YES;
+            }
+          [_selectedRows removeIndex: row];
+        }
+      [self _shiftRowsAtIndex: row by: -1];
+    }
+
+  if (selectionChanged)
+    {
+      if (_selectedRow == -1)
+        {
+          row = [_selectedRows lastIndex];
+          if (row != NSNotFound)
+            {
+              _selectedRow = row;
+            }
+          else if (!_allowsEmptySelection && _numberOfRows > 0)
+            {
+              _selectedRow = MIN([indexes firstIndex], _numberOfRows - 1);
+              [_selectedRows addIndex: _selectedRow];
+            }
+        }
+      [self _postSelectionDidChangeNotification];
+    }
+  [self _rowsChangedFromRow: [indexes firstIndex]];
+}
+
+/**
+ * Tells the table that the row at oldIndex was moved to newIndex in the
+ * data source.  The row stays selected if it was, and only the rows
+ * between the two indexes are redrawn.
+ */
+- (void) moveRowAtIndex: (NSInteger)oldIndex toIndex: (NSInteger)newIndex
+{
+  BOOL selected;
+  BOOL wasSelectedRow;
+  NSInteger row;
+  CGFloat top;
+  CGFloat bottom;
+
+  if (oldIndex < 0 || oldIndex >= _numberOfRows
+      || newIndex < 0 || newIndex >= _numberOfRows)
+    {
+      [NSException raise: NSRangeException
+                  format: @"Row index out of table in moveRowAtIndex"];
+    }
+  if (oldIndex == newIndex)
+    {
+      return;
+    }
+
+  selected = [_selectedRows containsIndex: oldIndex];
+  wasSelectedRow = (_selectedRow == oldIndex);
+  [_selectedRows removeIndex: oldIndex];
+  [self _shiftRowsAtIndex: oldIndex by: -1];
+  [self _shiftRowsAtIndex: newIndex by: 1];
+  if (selected)
+    {
+      [_selectedRows addIndex: newIndex];
+    }
+  if (wasSelectedRow)
+    {
+      _selectedRow = newIndex;
+    }
+
+  [self _updateRowHeightSums];
+  for (row = MIN(oldIndex, newIndex); row <= MAX(oldIndex, newIndex); row++)
+    {
+      [self _invalidateObjectValuesInRow: row];
+    }
+  if (_beginUpdatesCount > 0)
+    {
+      _firstChangedRow = MIN(_firstChangedRow, MIN(oldIndex, newIndex));
+      return;
+    }
+  top = [self _originOfRow: MIN(oldIndex, newIndex)];
+  bottom = [self _originOfRow: MAX(oldIndex, newIndex) + 1];
+  [self setNeedsDisplayInRect: NSMakeRect(_bounds.origin.x, top,
+                                          _bounds.size.width, bottom - top)];
+}
+
+/**
+ * Sets whether the table keeps the object values it gets from the data
+ * source for the cells it draws, so that drawing the same cells again,
+ * for example after scrolling or a change of selection, doesn't ask the
+ * data source again.  Useful with slow data sources.  The values are
+ * got again after -reloadData, -reloadDataForRowIndexes:columnIndexes:,
+ * -noteNumberOfRowsChanged and editing.  The default is NO.
+ */
+- (void) setCachesObjectValues: (BOOL)flag
+{
+  _cachesObjectValues = flag;
+  if (flag == NO && _objectValueCache != NULL)
+    {
+      NSFreeMapTable (_objectValueCache);
+      _objectValueCache = NULL;
+    }
+}
+
+- (BOOL) cachesObjectValues
+{
+  return _cachesObjectValues;
+}
+
 /* 
  * Target-action 
  */
@@ -3263,6 +3656,7 @@ byExtendingSelection: (BOOL)flag
                   [self _setObjectValue: newObjectValue
                         forTableColumn: tb
                         row: _editedRow];
+                  [self _invalidateObjectValuesInRow: _editedRow];
                 }
               return;
             }
@@ -3297,6 +3691,7 @@ byExtendingSelection: (BOOL)flag
               [self _setObjectValue: string // newObjectValue
                     forTableColumn: tb
                     row: _editedRow];
+              [self _invalidateObjectValuesInRow: _editedRow];
             }
         }
 
@@ -3485,6 +3880,7 @@ static inline CGFloat computePeriod(NSPoint mouseLocationWin,
 	  [self _setObjectValue: newValue 
 			forTableColumn: tb
 			row: rowIndex];
+	  [self _invalidateObjectValuesInRow: rowIndex];
 	}
     }
   RELEASE(originalValue);    
@@ -4164,11 +4560,23 @@ static BOOL selectContiguousRegion(NSTableView *self,
    */
   if (gotMovementKey == NO)
     {
-      /* no handled keys. */
-      [super keyDown: theEvent];
-      return;
+      /* maybe the start of the string of a row */
+      currentRow = [self _typeSelectRowForEvent: theEvent];
+      if (currentRow == -1)
+        {
+          /* no handled keys. */
+          [super keyDown: theEvent];
+          return;
+        }
+      originalRow = -1;
+      modifiers &= ~NSShiftKeyMask;
     }
-  else if (currentRow < 0)
+  else
+    {
+      _typeSelectTime = 0;
+    }
+
+  if (currentRow < 0)
     {
       currentRow = 0;
     }
@@ -4301,7 +4709,7 @@ static BOOL selectContiguousRegion(NSTableView *self,
   rect.origin.x = _columnOrigins[columnIndex];
   rect.origin.y = _bounds.origin.y;
   rect.size.width = [[_tableColumns objectAtIndex: columnIndex] width];
-  rect.size.height = _numberOfRows * _rowHeight;
+  rect.size.height = [self _heightOfRows];
   return rect;
 }
 
@@ -4316,9 +4724,9 @@ static BOOL selectContiguousRegion(NSTableView *self,
     }
 
   rect.origin.x = _bounds.origin.x;
-  rect.origin.y = _bounds.origin.y + (_rowHeight * rowIndex);
+  rect.origin.y = _bounds.origin.y + [self _originOfRow: rowIndex];
   rect.size.width = _bounds.size.width;
-  rect.size.height = _rowHeight;
+  rect.size.height = [self _heightOfRow: rowIndex];
   return rect;
 }
 
@@ -4331,9 +4739,9 @@ Hidden table columns are never tested. */
 {
   NSRange range = [self columnsInRect: aRect];
   NSMutableIndexSet *indexes = [NSMutableIndexSet indexSetWithIndexesInRange: range];
-  NSInteger i;
+  NSUInteger i;
 
-  for (i = range.location; i < range.length; i++)
+  for (i = range.location; i < NSMaxRange(range); i++)
     {
       NSTableColumn *tableColumn = [_tableColumns objectAtIndex: i];
 
@@ -4391,13 +4799,7 @@ This method is deprecated, use -columnIndexesInRect:. */
     }
   else
     {
-      int i = 0;
-      
-      while ((i < _numberOfColumns) && (aPoint.x >= _columnOrigins[i]))
-	{
-	  i++;
-	}
-      return i - 1;
+      return column_at_x(_columnOrigins, _numberOfColumns, aPoint.x, NO);
     }
 }
 
@@ -4410,10 +4812,10 @@ This method is deprecated, use -columnIndexesInRect:. */
     }
   else
     {
-      int return_value;
+      NSInteger return_value;
 
       aPoint.y -= _bounds.origin.y;
-      return_value = (int) (aPoint.y / _rowHeight);
+      return_value = [self _rowAtOffset: aPoint.y];
       /* This could happen if point lies on the grid line or below the last row */
       if (return_value >= _numberOfRows)
 	{
@@ -4434,9 +4836,10 @@ This method is deprecated, use -columnIndexesInRect:. */
       || (rowIndex > (_numberOfRows - 1)))
     return NSZeroRect;
       
-  frameRect.origin.y  = _bounds.origin.y + (rowIndex * _rowHeight);
+  frameRect.origin.y  = _bounds.origin.y + [self _originOfRow: rowIndex];
   frameRect.origin.y += _intercellSpacing.height / 2;
-  frameRect.size.height = _rowHeight - _intercellSpacing.height;
+  frameRect.size.height = [self _heightOfRow: rowIndex]
+    - _intercellSpacing.height;
 
   frameRect.origin.x = _columnOrigins[columnIndex];
   frameRect.origin.x  += _intercellSpacing.width / 2;
@@ -4503,7 +4906,7 @@ This method is deprecated, use -columnIndexesInRect:. */
 
   if ([_super_view respondsToSelector: @selector(documentVisibleRect)])
     {
-      float rowsHeight = ((_numberOfRows * _rowHeight) + 1);
+      float rowsHeight = ([self _heightOfRows] + 1);
       NSRect docRect = [(NSClipView *)_super_view documentVisibleRect];
       
       if (rowsHeight < docRect.size.height)
@@ -4525,7 +4928,7 @@ This method is deprecated, use -columnIndexesInRect:. */
   
   if ([_super_view respondsToSelector: @selector(documentVisibleRect)])
     {
-      float rowsHeight = ((_numberOfRows * _rowHeight) + 1);
+      float rowsHeight = ([self _heightOfRows] + 1);
       NSRect docRect = [(NSClipView *)_super_view documentVisibleRect];
       
       if (rowsHeight < docRect.size.height)
@@ -4570,11 +4973,11 @@ This method is deprecated, use -columnIndexesInRect:. */
 			    sizeof(columnSorting) * 2 
 			    * _numberOfColumns);
   currentWidth = NSZoneMalloc(NSDefaultMallocZone(),
-			      sizeof(float) * _numberOfColumns);
+			      sizeof(CGFloat) * _numberOfColumns);
   maxWidth = NSZoneMalloc(NSDefaultMallocZone(),
-			  sizeof(float) * _numberOfColumns);
+			  sizeof(CGFloat) * _numberOfColumns);
   minWidth = NSZoneMalloc(NSDefaultMallocZone(),
-			  sizeof(float) * _numberOfColumns);
+			  sizeof(CGFloat) * _numberOfColumns);
   isResizable = NSZoneMalloc(NSDefaultMallocZone(),
 			     sizeof(BOOL) * _numberOfColumns);
 
@@ -4841,6 +5244,8 @@ This method is deprecated, use -columnIndexesInRect:. */
   NSRect newFrame;
 
   _numberOfRows = [self _numRows];
+  [self _invalidateObjectValueCache];
+  [self _updateRowHeights];
  
   /* If we are selecting rows, we have to check that we have no
      selected rows below the new end of the table */
@@ -4915,7 +5320,7 @@ This method is deprecated, use -columnIndexesInRect:. */
     }
   
   newFrame = _frame;
-  newFrame.size.height = (_numberOfRows * _rowHeight) + 1;
+  newFrame.size.height = [self _heightOfRows] + 1;
   if (NO == NSEqualRects(newFrame, NSUnionRect(newFrame, _frame)))
     {
       [_super_view setNeedsDisplayInRect: _frame];
@@ -4937,6 +5342,14 @@ This method is deprecated, use -columnIndexesInRect:. */
 }
 
 - (void) tile
+{
+  [self _tileFromColumn: 0];
+}
+
+/* Like -tile, but the origins of the columns before columnIndex are
+   known not to have changed, so only the later ones are computed again
+   and redisplayed.  */
+- (void) _tileFromColumn: (NSInteger)columnIndex
 {
   float table_width = 0;
   float table_height;
@@ -4946,23 +5359,46 @@ This method is deprecated, use -columnIndexesInRect:. */
 
   if (_numberOfColumns > 0)
     {
-      int i;
+      NSInteger i;
       float width;
-  
-      _columnOrigins[0] = _bounds.origin.x;
-      width = [[_tableColumns objectAtIndex: 0] width];
-      table_width += width;
-      for (i = 1; i < _numberOfColumns; i++)
+
+      if (columnIndex <= 0)
+        {
+          columnIndex = 0;
+          _columnOrigins[0] = _bounds.origin.x;
+        }
+      else if (columnIndex >= _numberOfColumns)
+        {
+          columnIndex = _numberOfColumns - 1;
+        }
+      for (i = columnIndex + 1; i < _numberOfColumns; i++)
 	{
-	  _columnOrigins[i] = _columnOrigins[i - 1] + width;
-	  width = [[_tableColumns objectAtIndex: i] width];
-	  table_width += width;
+	  _columnOrigins[i] = _columnOrigins[i - 1]
+	    + [[_tableColumns objectAtIndex: i - 1] width];
 	}
+      width = [[_tableColumns lastObject] width];
+      table_width = _columnOrigins[_numberOfColumns - 1] + width
+	- _bounds.origin.x;
+    }
+  else
+    {
+      columnIndex = 0;
     }
   /* + 1 for the last grid line */
-  table_height = (_numberOfRows * _rowHeight) + 1;
+  table_height = [self _heightOfRows] + 1;
   [self setFrameSize: NSMakeSize (table_width, table_height)];
-  [self setNeedsDisplay: YES];
+  if (columnIndex == 0)
+    {
+      [self setNeedsDisplay: YES];
+    }
+  else
+    {
+      CGFloat x = _columnOrigins[columnIndex];
+
+      [self setNeedsDisplayInRect:
+	NSMakeRect (x, _bounds.origin.y, NSMaxX (_bounds) - x,
+		    _bounds.size.height)];
+    }
 
   if (_headerView != nil)
     {
@@ -4988,9 +5424,40 @@ This method is deprecated, use -columnIndexesInRect:. */
 		   inView: self];
 }
 
+/**
+ * Asks the delegate again for the heights of the rows in indexes,
+ * and moves the rows below them to fit.  Only the heights of those
+ * rows are looked up.
+ */
 - (void) noteHeightOfRowsWithIndexesChanged: (NSIndexSet*)indexes
 {
-  // FIXME
+  NSUInteger row;
+
+  if (_rowHeights == NULL)
+    {
+      if ([self _delegateGivesRowHeights] == NO)
+        {
+          return;
+        }
+      [self _updateRowHeights];
+    }
+  else
+    {
+      for (row = [indexes firstIndex];
+           row != NSNotFound && row < (NSUInteger)_numberOfRows;
+           row = [indexes indexGreaterThanIndex: row])
+        {
+          CGFloat height = [self _delegateHeightOfRow: row];
+
+          if (height != _rowHeights[row])
+            {
+              row_sums_add(_rowHeightSums, _numberOfRows, row,
+                           height - _rowHeights[row]);
+              _rowHeights[row] = height;
+            }
+        }
+    }
+  [self tile];
 }
 
 - (void) drawGridInClipRect: (NSRect)aRect
@@ -5015,6 +5482,10 @@ This method is deprecated, use -columnIndexesInRect:. */
 
 - (void) drawRect: (NSRect)aRect
 {
+  if (_dataSource_prefetches)
+    {
+      [self _prefetchRowsAroundVisibleRows];
+    }
   [[GSTheme theme] drawTableViewRect: aRect
 		   inView: self];
 }
@@ -5277,6 +5748,12 @@ This method is deprecated, use -columnIndexesInRect:. */
   
   /* Cache */
   _del_responds = [_delegate respondsToSelector: sel];
+
+  [self _updateRowHeights];
+  if (_numberOfRows > 0)
+    {
+      [self tile];
+    }
 }
 
 - (id) delegate
@@ -5333,25 +5810,142 @@ This method is deprecated, use -columnIndexesInRect:. */
                         event: (NSEvent*)dragEvent
               dragImageOffset: (NSPoint*)dragImageOffset
 {
-  // FIXME
-  NSImage *dragImage = [[NSImage alloc]
-			 initWithSize: NSMakeSize(8, 8)];
+  NSMutableIndexSet *rows = [NSMutableIndexSet indexSet];
+  NSEnumerator *e = [dragRows objectEnumerator];
+  NSNumber *row;
 
-  return AUTORELEASE(dragImage);
+  while ((row = [e nextObject]) != nil)
+    {
+      [rows addIndex: [row unsignedIntegerValue]];
+    }
+  return [self _dragImageForRows: rows
+                           event: dragEvent
+                          offset: dragImageOffset];
 }
 
+/**
+ * Returns the image dragged for rows.  It shows at most a few of the
+ * rows that are visible, stacked on top of each other, and a badge
+ * with the number of rows when more than one row is dragged.  So the
+ * image is cheap to make however many rows are dragged.  On return,
+ * offset holds the position of the centre of the image relative to
+ * the location of event.
+ */
 - (NSImage *) dragImageForRowsWithIndexes: (NSIndexSet*)rows
                              tableColumns: (NSArray*)cols
                                     event: (NSEvent*)event
                                    offset: (NSPoint*)offset
 {
-  // FIXME
-  NSArray *rowArray;
+  SEL sel = @selector(dragImageForRows:event:dragImageOffset:);
+
+  if ([self methodForSelector: sel]
+      != [NSTableView instanceMethodForSelector: sel])
+    {
+      // A subclass still draws the image the old way
+      return [self dragImageForRows: [self _indexSetToArray: rows]
+                              event: event
+                    dragImageOffset: offset];
+    }
+  return [self _dragImageForRows: rows event: event offset: offset];
+}
+
+- (NSImage *) _dragImageForRows: (NSIndexSet*)rows
+                          event: (NSEvent*)event
+                         offset: (NSPoint*)offset
+{
+  NSRect visible = [self visibleRect];
+  NSRange range = [self rowsInRect: visible];
+  NSMutableArray *bitmaps = [NSMutableArray array];
+  NSImage *dragImage;
+  NSString *label = nil;
+  NSDictionary *attributes = nil;
+  NSSize labelSize = NSZeroSize;
+  CGFloat width = NSWidth(visible);
+  CGFloat height = 0;
+  CGFloat top = 0;
+  CGFloat y;
+  NSUInteger row, i;
+
+  /* Only rows on screen are read back from the window, and only a
+     few of them. */
+  for (row = [rows indexGreaterThanOrEqualToIndex: range.location];
+       row != NSNotFound && row < NSMaxRange(range)
+         && [bitmaps count] < DRAG_IMAGE_MAX_ROWS;
+       row = [rows indexGreaterThanIndex: row])
+    {
+      NSRect rect = NSIntersectionRect([self rectOfRow: row], visible);
+      NSBitmapImageRep *bitmap;
+
+      if (NSIsEmptyRect(rect))
+        continue;
+      bitmap = [self bitmapImageRepForCachingDisplayInRect: rect];
+      [self cacheDisplayInRect: rect toBitmapImageRep: bitmap];
+      if ([bitmaps count] == 0)
+        top = NSMinY(rect);
+      [bitmaps addObject: bitmap];
+      height += NSHeight(rect);
+    }
+  if (height == 0)
+    {
+      height = _rowHeight;
+    }
+
+  if ([rows count] > 1)
+    {
+      label = [NSString stringWithFormat: @"%lu",
+                        (unsigned long)[rows count]];
+      attributes = [NSDictionary dictionaryWithObjectsAndKeys:
+        [NSFont boldSystemFontOfSize: 0], NSFontAttributeName,
+        [NSColor whiteColor], NSForegroundColorAttributeName,
+        nil];
+      labelSize = [label sizeWithAttributes: attributes];
+      height = MAX(height, labelSize.height + 8);
+    }
+
+  dragImage = AUTORELEASE([[NSImage alloc]
+                            initWithSize: NSMakeSize(width, height)]);
+  [dragImage lockFocus];
+  y = height;
+  for (i = 0; i < [bitmaps count]; i++)
+    {
+      NSBitmapImageRep *bitmap = [bitmaps objectAtIndex: i];
+      NSSize size = [bitmap size];
+
+      y -= size.height;
+      [bitmap drawInRect: NSMakeRect(0, y, width, size.height)];
+    }
+  if (label != nil)
+    {
+      NSRect badge;
+
+      badge.size.width = MAX(labelSize.width + 12, labelSize.height + 4);
+      badge.size.height = labelSize.height + 4;
+      badge.origin.x = width - NSWidth(badge) - 2;
+      badge.origin.y = height - NSHeight(badge) - 2;
+      [[NSColor redColor] set];
+      [[NSBezierPath bezierPathWithRoundedRect: badge
+                                       xRadius: NSHeight(badge) / 2
+                                       yRadius: NSHeight(badge) / 2] fill];
+      [label drawAtPoint: NSMakePoint(NSMidX(badge) - labelSize.width / 2,
+                                      NSMinY(badge) + 2)
+          withAttributes: attributes];
+    }
+  [dragImage unlockFocus];
+
+  if (offset != NULL)
+    {
+      *offset = NSZeroPoint;
+      if (event != nil && [bitmaps count] > 0)
+        {
+          NSPoint p = [self convertPoint: [event locationInWindow]
+                                fromView: nil];
 
-  rowArray = [self _indexSetToArray: rows];
-  return [self dragImageForRows: rowArray 
-               event: event
-               dragImageOffset: offset];
+          // Lay the image over the rows it shows
+          offset->x = NSMinX(visible) + width / 2 - p.x;
+          offset->y = top + height / 2 - p.y;
+        }
+    }
+  return dragImage;
 }
 
 - (void) setDropRow: (NSInteger)row
@@ -5703,7 +6297,7 @@ This method is deprecated, use -columnIndexesInRect:. */
       if (_numberOfColumns > 0)
         {
           _columnOrigins = NSZoneMalloc (NSDefaultMallocZone (), 
-                                         sizeof(float) * _numberOfColumns);
+                                         sizeof(CGFloat) * _numberOfColumns);
         }
       [self tile]; /* Initialize _columnOrigins */
     }
@@ -5761,7 +6355,19 @@ This method is deprecated, use -columnIndexesInRect:. */
 - (void) _userResizedTableColumn: (NSInteger)index
 			   width: (CGFloat)width
 {
+  BOOL tilingDisabled = _tilingDisabled;
+
+  /* Only the columns after the resized one move, so don't let the
+     column tile the whole table */
+  _tilingDisabled = YES;
   [[_tableColumns objectAtIndex: index] setWidth: width];
+  _tilingDisabled = tilingDisabled;
+  [self _tileFromColumn: index];
+}
+
+- (NSInteger) _columnBeforeX: (CGFloat)x
+{
+  return column_at_x(_columnOrigins, _numberOfColumns, x, YES);
 }
 
 - (CGFloat *) _columnOrigins
@@ -6205,21 +6811,21 @@ This method is deprecated, use -columnIndexesInRect:. */
 	  if (currentDropRow == 0)
 		{
 		  newRect = NSMakeRect([self visibleRect].origin.x,
-					currentDropRow * _rowHeight,
+					[self _originOfRow: currentDropRow],
 					[self visibleRect].size.width,
 					3);
 		}
 	  else if (currentDropRow == _numberOfRows)
 		{
 		  newRect = NSMakeRect([self visibleRect].origin.x,
-					currentDropRow * _rowHeight - 2,
+					[self _originOfRow: currentDropRow] - 2,
 					[self visibleRect].size.width,
 					3);
 		}
 	  else
 	    {
           newRect = NSMakeRect([self visibleRect].origin.x,
-				    currentDropRow * _rowHeight - 1,
+				    [self _originOfRow: currentDropRow] - 1,
 				    [self visibleRect].size.width,
 				    3);
 	    }
@@ -6281,7 +6887,7 @@ view to drag. */
 
 - (NSInteger) _computedRowAtPoint: (NSPoint)p
 {
-  return (NSInteger)(p.y - _bounds.origin.y) / (NSInteger)_rowHeight;
+  return [self _rowAtOffset: p.y - _bounds.origin.y];
 }
 
 - (void) _setDropOperationAndRow: (NSInteger)row
@@ -6289,8 +6895,9 @@ view to drag. */
                          atPoint: (NSPoint)p
 {
   NSParameterAssert(row > -1);
+  CGFloat height = [self _heightOfRow: [self _computedRowAtPoint: p]];
   BOOL isPositionInsideMiddleQuartersOfRow = 
-    (positionInRow > _rowHeight / 4 && positionInRow <= (3 * _rowHeight) / 4);
+    (positionInRow > height / 4 && positionInRow <= (3 * height) / 4);
   BOOL isDropOn = (row > _numberOfRows || isPositionInsideMiddleQuartersOfRow); 
 
   [self setDropRow: (isDropOn ? [self _computedRowAtPoint: p] : row)
@@ -6313,7 +6920,8 @@ view to drag. */
 - (NSDragOperation) draggingUpdated: (id <NSDraggingInfo>) sender
 {
   NSPoint p = [self convertPoint: [sender draggingLocation] fromView: nil];
-  NSInteger positionInRow = (NSInteger)(p.y - _bounds.origin.y) % (int)_rowHeight;
+  NSInteger positionInRow = (NSInteger)(p.y - _bounds.origin.y
+    - [self _originOfRow: [self _computedRowAtPoint: p]]);
   NSInteger quarterPosition = (NSInteger)([self _computedRowAtPoint: p] * 4.);
   NSInteger row = [self _dropRowFromQuarterPosition: quarterPosition];
   NSDragOperation dragOperation = [sender draggingSourceOperationMask];
@@ -6647,6 +7255,413 @@ For a more detailed explanation, -setSortDescriptors:. */
   return result;
 }
 
+/* Returns the object value of the cell, from the cache when the table
+   caches object values.  The cache is keyed by the index of the cell,
+   row * _numberOfColumns + column, so it is forgotten whenever the
+   columns change.  When it gets large, the values of rows that are not
+   visible are dropped.  */
+- (id) _cachedObjectValueAtColumn: (NSInteger)columnIndex
+                              row: (NSInteger)rowIndex
+{
+  NSTableColumn *tb = [_tableColumns objectAtIndex: columnIndex];
+  void *key;
+  id value;
+
+  if (_cachesObjectValues == NO && _dataSource_batches == NO)
+    {
+      return [self _objectValueForTableColumn: tb row: rowIndex];
+    }
+
+  if (_objectValueCache == NULL)
+    {
+      _objectValueCache = NSCreateMapTable (NSIntMapKeyCallBacks,
+                                            NSObjectMapValueCallBacks, 256);
+    }
+  key = (void *)(rowIndex * _numberOfColumns + columnIndex);
+  value = NSMapGet (_objectValueCache, key);
+  if (value == nil)
+    {
+      NSRange visible = [self rowsInRect: [self visibleRect]];
+      NSUInteger limit = MAX(4 * visible.length * _numberOfColumns, 256);
+
+      if (NSCountMapTable (_objectValueCache) >= limit)
+        {
+          NSMapEnumerator e = NSEnumerateMapTable (_objectValueCache);
+          NSMutableArray *far = [NSMutableArray array];
+          NSUInteger i;
+          void *k;
+          void *v;
+
+          while (NSNextMapEnumeratorPair (&e, &k, &v))
+            {
+              NSUInteger row = (NSUInteger)k / _numberOfColumns;
+
+              if (NSLocationInRange (row, visible) == NO)
+                {
+                  [far addObject: [NSNumber numberWithUnsignedInteger:
+                                              (NSUInteger)k]];
+                }
+            }
+          NSEndMapTableEnumeration (&e);
+          for (i = 0; i < [far count]; i++)
+            {
+              NSMapRemove (_objectValueCache,
+                (void *)[[far objectAtIndex: i] unsignedIntegerValue]);
+            }
+        }
+
+      /* Get the values of all the visible rows at once if the data
+         source can give them */
+      if (_dataSource_batches
+          && [GSKeyValueBinding getBinding: NSValueBinding
+                                 forObject: tb] == nil)
+        {
+          NSRange rows = NSIntersectionRange(visible,
+            NSMakeRange(0, _numberOfRows));
+
+          if (NSLocationInRange(rowIndex, rows) == NO)
+            {
+              rows = NSMakeRange(rowIndex, 1);
+            }
+          if ([self _fetchObjectValuesInRows: rows])
+            {
+              value = NSMapGet (_objectValueCache, key);
+              return (value == (id)[NSNull null]) ? nil : value;
+            }
+        }
+
+      value = [self _objectValueForTableColumn: tb row: rowIndex];
+      NSMapInsert (_objectValueCache, key,
+                   (value != nil) ? value : (id)[NSNull null]);
+      return value;
+    }
+  return (value == (id)[NSNull null]) ? nil : value;
+}
+
+/* Asks the data source for the values of all columns in rows with one
+   message and puts them in the cache.  Returns NO if the data source
+   didn't give as many values as there are cells.  */
+- (BOOL) _fetchObjectValuesInRows: (NSRange)rows
+{
+  NSArray *values;
+  NSUInteger count = rows.length * _numberOfColumns;
+  NSUInteger i;
+
+  values = [_dataSource tableView: self
+      objectValuesForTableColumns: _tableColumns
+                             rows: rows];
+  if ([values count] != count)
+    {
+      NSDebugLLog(@"NSTableView", @"Data source gave %lu values for %lu"
+                  @" cells", (unsigned long)[values count],
+                  (unsigned long)count);
+      return NO;
+    }
+  for (i = 0; i < count; i++)
+    {
+      NSMapInsert (_objectValueCache,
+                   (void *)(rows.location * _numberOfColumns + i),
+                   [values objectAtIndex: i]);
+    }
+  return YES;
+}
+
+/* Tells the data source about the rows a page above and below the
+   visible ones, whenever the visible rows change.  */
+- (void) _prefetchRowsAroundVisibleRows
+{
+  NSRange visible = NSIntersectionRange([self rowsInRect: [self visibleRect]],
+                                        NSMakeRange(0, _numberOfRows));
+  NSUInteger start, end;
+
+  if (visible.length == 0 || NSEqualRanges(visible, _prefetchedRows))
+    {
+      return;
+    }
+  _prefetchedRows = visible;
+
+  start = (visible.location > visible.length)
+    ? visible.location - visible.length : 0;
+  if (start < visible.location)
+    {
+      [_dataSource tableView: self
+                prefetchRows: NSMakeRange(start, visible.location - start)];
+    }
+  end = MIN(NSMaxRange(visible) + visible.length, (NSUInteger)_numberOfRows);
+  if (end > NSMaxRange(visible))
+    {
+      [_dataSource tableView: self
+                prefetchRows: NSMakeRange(NSMaxRange(visible),
+                                          end - NSMaxRange(visible))];
+    }
+}
+
+- (void) _invalidateObjectValueCache
+{
+  DESTROY (_typeSelectIndex);
+  if (_objectValueCache != NULL)
+    {
+      NSResetMapTable (_objectValueCache);
+    }
+}
+
+- (void) _invalidateObjectValuesInRow: (NSInteger)rowIndex
+{
+  NSInteger column;
+
+  if (_typeSelectIndex != nil)
+    {
+      [_typeSelectIndex setString: [self _typeSelectStringForRow: rowIndex]
+                          forItem: rowIndex];
+    }
+  if (_objectValueCache == NULL)
+    {
+      return;
+    }
+  for (column = 0; column < _numberOfColumns; column++)
+    {
+      NSMapRemove (_objectValueCache,
+                   (void *)(rowIndex * _numberOfColumns + column));
+    }
+}
+
+/* Forgets the cached values of the rows from rowIndex on, whose rows
+   changed because rows were inserted, removed or moved before them.  */
+- (void) _invalidateObjectValuesFromRow: (NSInteger)rowIndex
+{
+  NSMapEnumerator e;
+  NSMutableArray *moved;
+  NSUInteger first;
+  NSUInteger i;
+  void *k;
+  void *v;
+
+  DESTROY (_typeSelectIndex);
+  if (_objectValueCache == NULL)
+    {
+      return;
+    }
+  if (rowIndex == 0)
+    {
+      NSResetMapTable (_objectValueCache);
+      return;
+    }
+
+  first = rowIndex * _numberOfColumns;
+  moved = [NSMutableArray array];
+  e = NSEnumerateMapTable (_objectValueCache);
+  while (NSNextMapEnumeratorPair (&e, &k, &v))
+    {
+      if ((NSUInteger)k >= first)
+        {
+          [moved addObject: [NSNumber numberWithUnsignedInteger:
+                                        (NSUInteger)k]];
+        }
+    }
+  NSEndMapTableEnumeration (&e);
+  for (i = 0; i < [moved count]; i++)
+    {
+      NSMapRemove (_objectValueCache,
+        (void *)[[moved objectAtIndex: i] unsignedIntegerValue]);
+    }
+}
+
+/* Moves the rows from rowIndex on by delta, which is 1 when a row was
+   inserted at rowIndex and -1 when the row at rowIndex was removed.  The
+   selected, clicked and edited rows and the row heights move with their
+   rows.  The sums of the row heights are not updated, that is left to
+   -_updateRowHeightSums.  */
+- (void) _shiftRowsAtIndex: (NSInteger)rowIndex by: (NSInteger)delta
+{
+  if (_editedRow >= rowIndex)
+    {
+      [self abortEditing];
+    }
+  if (delta < 0)
+    {
+      [_selectedRows removeIndex: rowIndex];
+      [_selectedRows shiftIndexesStartingAtIndex: rowIndex + 1 by: -1];
+      if (_selectedRow == rowIndex)
+        {
+          _selectedRow = -1;
+        }
+      if (_clickedRow == rowIndex)
+        {
+          _clickedRow = -1;
+        }
+    }
+  else
+    {
+      [_selectedRows shiftIndexesStartingAtIndex: rowIndex by: 1];
+    }
+  if (_selectedRow >= rowIndex)
+    {
+      _selectedRow += delta;
+    }
+  if (_clickedRow >= rowIndex)
+    {
+      _clickedRow += delta;
+    }
+
+  if (_rowHeights != NULL)
+    {
+      if (delta > 0)
+        {
+          _rowHeights = NSZoneRealloc (NSDefaultMallocZone (), _rowHeights,
+                                       (_numberOfRows + 1) * sizeof (CGFloat));
+          memmove (_rowHeights + rowIndex + 1, _rowHeights + rowIndex,
+                   (_numberOfRows - rowIndex) * sizeof (CGFloat));
+        }
+      else
+        {
+          memmove (_rowHeights + rowIndex, _rowHeights + rowIndex + 1,
+                   (_numberOfRows - rowIndex - 1) * sizeof (CGFloat));
+        }
+    }
+  _numberOfRows += delta;
+  if (_rowHeights != NULL && delta > 0)
+    {
+      _rowHeights[rowIndex] = [self _delegateHeightOfRow: rowIndex];
+    }
+}
+
+/* The string type-select matches for a row, which is the string of its
+   value in the first column.  */
+- (NSString *) _typeSelectStringForRow: (NSInteger)rowIndex
+{
+  id value;
+
+  if (_numberOfColumns == 0)
+    {
+      return nil;
+    }
+  value = [self _objectValueForTableColumn: [_tableColumns objectAtIndex: 0]
+                                       row: rowIndex];
+  if (value == nil || [value isKindOfClass: [NSString class]])
+    {
+      return value;
+    }
+  return [value description];
+}
+
+/* Adds the characters of theEvent to those typed just before, and
+   returns the first row from the selected one on whose string starts
+   with them, or -1 if theEvent holds no characters to match or no row
+   matches.  The strings of the rows are got once and kept sorted until
+   the data is reloaded, then each key press is looked up in them.  */
+- (NSInteger) _typeSelectRowForEvent: (NSEvent *)theEvent
+{
+  NSString *characters = [theEvent characters];
+  NSUInteger i, row;
+
+  if ([characters length] == 0 || _numberOfRows == 0 || _numberOfColumns == 0
+      || ([theEvent modifierFlags] & (NSCommandKeyMask | NSControlKeyMask)))
+    {
+      return -1;
+    }
+  for (i = 0; i < [characters length]; i++)
+    {
+      unichar c = [characters characterAtIndex: i];
+
+      if (c <= ' ' || c == 0x7f || (c >= 0xF700 && c <= 0xF8FF))
+        {
+          return -1;
+        }
+    }
+
+  if (_typeSelectString != nil
+      && [theEvent timestamp] - _typeSelectTime < TYPE_SELECT_INTERVAL)
+    {
+      ASSIGN (_typeSelectString,
+              [_typeSelectString stringByAppendingString: characters]);
+    }
+  else
+    {
+      ASSIGN (_typeSelectString, characters);
+    }
+  _typeSelectTime = [theEvent timestamp];
+
+  if (_typeSelectIndex == nil
+      || [_typeSelectIndex count] != (NSUInteger)_numberOfRows)
+    {
+      NSMutableArray *strings;
+      NSInteger r;
+
+      strings = [NSMutableArray arrayWithCapacity: _numberOfRows];
+      for (r = 0; r < _numberOfRows; r++)
+        {
+          NSString *string = [self _typeSelectStringForRow: r];
+
+          [strings addObject: (string != nil) ? string : @""];
+        }
+      ASSIGN (_typeSelectIndex, AUTORELEASE ([[GSTypeSelectIndex alloc]
+                                                initWithStrings: strings
+                                                      foldsCase: YES]));
+    }
+
+  row = [_typeSelectIndex itemWithPrefix: _typeSelectString
+                              startingAt: (_selectedRow < 0) ? 0 : _selectedRow];
+  return (row == NSNotFound) ? -1 : (NSInteger)row;
+}
+
+/* Rebuilds the sums of the row heights after -_shiftRowsAtIndex:by:.  */
+- (void) _updateRowHeightSums
+{
+  if (_rowHeights != NULL && _numberOfRows > 0)
+    {
+      _rowHeightSums = NSZoneRealloc (NSDefaultMallocZone (), _rowHeightSums,
+                                      (_numberOfRows + 1) * sizeof (CGFloat));
+      row_sums_build(_rowHeightSums, _rowHeights, _numberOfRows);
+    }
+  else
+    {
+      [self _updateRowHeights];
+    }
+}
+
+/* Called after rows were inserted or removed.  Updates the sums of the
+   row heights and the cache, then resizes the table and redraws the
+   rows from rowIndex on, unless this is done by -endUpdates later.  */
+- (void) _rowsChangedFromRow: (NSInteger)rowIndex
+{
+  NSRect newFrame;
+  CGFloat top;
+
+  [self _updateRowHeightSums];
+  [self _invalidateObjectValuesFromRow: rowIndex];
+  _prefetchedRows = NSMakeRange(0, 0);
+
+  if (_beginUpdatesCount > 0)
+    {
+      _firstChangedRow = MIN(_firstChangedRow, rowIndex);
+      return;
+    }
+
+  newFrame = _frame;
+  newFrame.size.height = [self _heightOfRows] + 1;
+  if (NSHeight(newFrame) < NSHeight(_frame) && _super_view != nil)
+    {
+      NSRect gone = NSMakeRect(_bounds.origin.x, NSHeight(newFrame),
+                               _bounds.size.width,
+                               NSHeight(_frame) - NSHeight(newFrame));
+
+      [_super_view setNeedsDisplayInRect:
+        [self convertRect: gone toView: _super_view]];
+    }
+  if (NSHeight(newFrame) != NSHeight(_frame))
+    {
+      [self setFrame: newFrame];
+    }
+
+  top = [self _originOfRow: rowIndex];
+  if (top < NSMaxY(_bounds))
+    {
+      [self setNeedsDisplayInRect:
+        NSMakeRect(_bounds.origin.x, top, _bounds.size.width,
+                   NSMaxY(_bounds) - top)];
+    }
+}
+
 - (void) _setObjectValue: (id)value
 	  forTableColumn: (NSTableColumn *)tb
 		     row: (NSInteger) index
@@ -6689,6 +7704,105 @@ For a more detailed explanation, -setSortDescriptors:. */
     }
 }
 
+/* Quasi private methods called on self to find the heights of rows,
+ * overridden in subclasses with delegates of their own.
+ */
+- (BOOL) _delegateGivesRowHeights
+{
+  return [_delegate respondsToSelector: @selector(tableView:heightOfRow:)];
+}
+
+- (CGFloat) _delegateHeightOfRow: (NSInteger)rowIndex
+{
+  return [_delegate tableView: self heightOfRow: rowIndex];
+}
+
+/* Looks up the heights of all rows again if the delegate gives them,
+   or forgets them if it doesn't.  */
+- (void) _updateRowHeights
+{
+  NSInteger row;
+
+  if (_rowHeights != NULL)
+    {
+      NSZoneFree (NSDefaultMallocZone (), _rowHeights);
+      NSZoneFree (NSDefaultMallocZone (), _rowHeightSums);
+      _rowHeights = NULL;
+      _rowHeightSums = NULL;
+    }
+  if (_numberOfRows <= 0 || [self _delegateGivesRowHeights] == NO)
+    {
+      return;
+    }
+
+  _rowHeights = NSZoneMalloc (NSDefaultMallocZone (),
+                              _numberOfRows * sizeof (CGFloat));
+  _rowHeightSums = NSZoneMalloc (NSDefaultMallocZone (),
+                                 (_numberOfRows + 1) * sizeof (CGFloat));
+  for (row = 0; row < _numberOfRows; row++)
+    {
+      _rowHeights[row] = [self _delegateHeightOfRow: row];
+    }
+  row_sums_build(_rowHeightSums, _rowHeights, _numberOfRows);
+}
+
+/* The distance from the top of the table to the top of the row.  Rows
+   past the end of the table are taken to have _rowHeight.  */
+- (CGFloat) _originOfRow: (NSInteger)rowIndex
+{
+  if (_rowHeights == NULL)
+    {
+      return rowIndex * _rowHeight;
+    }
+  if (rowIndex <= _numberOfRows)
+    {
+      return row_sums_prefix(_rowHeightSums, rowIndex);
+    }
+  return row_sums_prefix(_rowHeightSums, _numberOfRows)
+    + (rowIndex - _numberOfRows) * _rowHeight;
+}
+
+- (CGFloat) _heightOfRow: (NSInteger)rowIndex
+{
+  if (_rowHeights == NULL || rowIndex < 0 || rowIndex >= _numberOfRows)
+    {
+      return _rowHeight;
+    }
+  return _rowHeights[rowIndex];
+}
+
+- (CGFloat) _heightOfRows
+{
+  return [self _originOfRow: _numberOfRows];
+}
+
+/* The row at the given distance from the top of the table, counting
+   rows past the end as having _rowHeight.  */
+- (NSInteger) _rowAtOffset: (CGFloat)offset
+{
+  CGFloat height;
+
+  if (_rowHeights == NULL)
+    {
+      return (NSInteger)(offset / _rowHeight);
+    }
+  height = row_sums_prefix(_rowHeightSums, _numberOfRows);
+  if (offset >= height)
+    {
+      return _numberOfRows + (NSInteger)((offset - height) / _rowHeight);
+    }
+  return row_sums_find(_rowHeightSums, _numberOfRows, offset);
+}
+
+/* Like -_rowAtOffset:, but the fraction says how far into the row
+   offset is.  */
+- (CGFloat) _rowPositionAtOffset: (CGFloat)offset
+{
+  NSInteger row = [self _rowAtOffset: offset];
+
+  return row + (offset - [self _originOfRow: row]) / [self _heightOfRow: row];
+}
+
 - (BOOL) _isDraggingSource
 {
   return [_dataSource respondsToSelector:
@@ -45,6 +45,10 @@
 #import "AppKit/NSTextView.h"
 
 
+@interface NSTextAttachmentCell (Private)
+- (void) _makeImageIfNeeded;
+@end
+
 @implementation NSTextAttachmentCell
 
 - (void)drawWithFrame: (NSRect)cellFrame 
@@ -77,6 +81,7 @@
 {
   NSRect aRect;
   
+  [self _makeImageIfNeeded];
   aRect.origin = [self cellBaselineOffset];
   aRect.size = [self cellSize];
   return aRect;
@@ -235,26 +240,14 @@
 
 - (void)setAttachment: (NSTextAttachment *)anObject
 {
-  NSFileWrapper *fileWrap = [anObject fileWrapper];
-
   // Do not retain the attachment
   _attachment = anObject;
 
-  if (fileWrap != nil)
+  /* Opening a document with many images should not decode them all,
+     so the image is only made when it is needed.  */
+  if ([anObject fileWrapper] != nil)
     {
-      NSImage *icon = nil;
-      NSString *fileName = [fileWrap filename];
-
-      if (fileName != nil)
-        {
-	  // Try to set the image to the file wrapper content
-	  icon = [[NSImage alloc] initByReferencingFile: fileName];
-        }
-      if (icon == nil)
-	icon = RETAIN([fileWrap icon]);
-
-      [self setImage: icon];
-      RELEASE(icon);
+      _needs_image = YES;
     }
 }
 
@@ -268,9 +261,22 @@
 
 - (NSSize)cellSize
 {
+  [self _makeImageIfNeeded];
   return [super cellSize];
 }
 
+- (NSImage *)image
+{
+  [self _makeImageIfNeeded];
+  return [super image];
+}
+
+- (void)setImage: (NSImage *)anImage
+{
+  _needs_image = NO;
+  [super setImage: anImage];
+}
+
 - (void)highlight: (BOOL)flag 
 	withFrame: (NSRect)cellFrame 
 	   inView: (NSView *)controlView
@@ -282,11 +288,46 @@
 
 - (void)drawWithFrame: (NSRect)cellFrame inView: (NSView *)controlView
 {
+  [self _makeImageIfNeeded];
   [super drawWithFrame: cellFrame inView: controlView];
 }
 
 @end
 
+@implementation NSTextAttachmentCell (Private)
+
+/* Sets the image to the contents of the file wrapper of the attachment.
+   An image referencing the file reads it only when drawn, and throws the
+   decoded image away again when purged (see
+   +[NSImage purgeImageDataUnusedFor:]).  */
+- (void) _makeImageIfNeeded
+{
+  NSFileWrapper *fileWrap;
+  NSImage *icon = nil;
+  NSString *fileName;
+
+  if (_needs_image == NO)
+    return;
+  _needs_image = NO;
+
+  fileWrap = [_attachment fileWrapper];
+  fileName = [fileWrap filename];
+  if (fileName != nil)
+    {
+      // Try to set the image to the file wrapper content
+      icon = [[NSImage alloc] initByReferencingFile: fileName];
+    }
+  if (icon == nil)
+    icon = RETAIN([fileWrap icon]);
+  if (icon == nil && [fileWrap isRegularFile])
+    icon = [[NSImage alloc] initWithData: [fileWrap regularFileContents]];
+
+  [self setImage: icon];
+  RELEASE(icon);
+}
+
+@end
+
 
 @implementation NSTextAttachment
 
@@ -242,6 +242,14 @@
                              inRect: (NSRect)rect
                       textContainer: (NSTextContainer *)container
                      characterRange: (NSRange)range
+{
+  return [self _boundsRectForContentRect: cont inRect: rect];
+}
+
+/* The rectangle around cont which takes the padding, border and margin
+ * of the receiver.  NSTextTable uses it for the cells of a table too.
+ */
+- (NSRect) _boundsRectForContentRect: (NSRect)cont inRect: (NSRect)rect
 {
   CGFloat minx = [self _scaledWidthValue: NSTextBlockPadding : NSMinXEdge: rect.size] 
     + [self _scaledWidthValue: NSTextBlockBorder : NSMinXEdge : rect.size]
@@ -265,6 +273,24 @@
   return cont;
 }
 
+/* The inverse of -_boundsRectForContentRect:inRect:, the rectangle left
+ * for the text inside bounds.
+ */
+- (NSRect) _contentRectForBoundsRect: (NSRect)bounds inRect: (NSRect)rect
+{
+  NSRect outer = [self _boundsRectForContentRect: NSZeroRect inRect: rect];
+
+  bounds.origin.x -= NSMinX(outer);
+  bounds.size.width -= NSWidth(outer);
+  bounds.origin.y -= NSMinY(outer);
+  bounds.size.height -= NSHeight(outer);
+  if (bounds.size.width < 0.0)
+    bounds.size.width = 0.0;
+  if (bounds.size.height < 0.0)
+    bounds.size.height = 0.0;
+  return bounds;
+}
+
 /**
  * POINT is the point in NSTextContainer where the TextBlock should be laid out.
  * RECT is the bounding rect (e.g. the rect of the container or the rect of the 
@@ -28,6 +28,8 @@
 #import <Foundation/NSException.h>
 #import <Foundation/NSDebug.h>
 #import <Foundation/NSPortCoder.h>
+#import <Foundation/NSUserDefaults.h>
+#import <Foundation/NSValue.h>
 #import "AppKit/NSAttributedString.h"
 #import "AppKit/NSTextStorage.h"
 #import "GNUstepGUI/GSLayoutManager.h"
@@ -40,12 +42,24 @@ static Class concrete;
 
 static NSNotificationCenter *nc = nil;
 
+static Class
+concreteClassForBackingStore(NSString *name)
+{
+  if ([name isEqualToString: @"Rope"])
+    return [GSRopeTextStorage class];
+  return [GSTextStorage class];
+}
+
 + (void) initialize
 {
   if (self == [NSTextStorage class])
     {
+      NSString	*store;
+
       abstract = self;
-      concrete = [GSTextStorage class];
+      store = [[NSUserDefaults standardUserDefaults]
+		stringForKey: @"GSTextStorageBackingStore"];
+      concrete = concreteClassForBackingStore(store);
       nc = [NSNotificationCenter defaultCenter];
     }
 }
@@ -58,6 +72,30 @@ static NSNotificationCenter *nc = nil;
     return NSAllocateObject(self, 0, zone);
 }
 
++ (id) allocWithBackingStore: (NSString*)name zone: (NSZone*)zone
+{
+  if (self == abstract && name != nil)
+    return NSAllocateObject(concreteClassForBackingStore(name), 0, zone);
+  else
+    return [self allocWithZone: zone];
+}
+
++ (NSDictionary*) attributeCacheStatistics
+{
+  NSUInteger	hits;
+  NSUInteger	misses;
+  NSUInteger	entries;
+
+  GSTextStorageAttributeCacheStatistics(&hits, &misses, &entries);
+  return [NSDictionary dictionaryWithObjectsAndKeys:
+    [NSNumber numberWithUnsignedInteger: hits], @"Hits",
+    [NSNumber numberWithUnsignedInteger: misses], @"Misses",
+    [NSNumber numberWithUnsignedInteger: entries], @"Entries",
+    [NSNumber numberWithDouble: (hits + misses > 0)
+      ? (double)hits / (hits + misses) : 0.0], @"HitRate",
+    nil];
+}
+
 - (void) dealloc
 {
   [self setDelegate: nil];
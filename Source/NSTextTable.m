@@ -31,8 +31,36 @@
 
 #import "AppKit/NSTextTable.h"
 
+@interface NSTextBlock (Private)
+- (CGFloat) _scaledValue: (NSTextBlockDimension)dimension : (NSSize)size;
+- (NSRect) _boundsRectForContentRect: (NSRect)cont inRect: (NSRect)rect;
+- (NSRect) _contentRectForBoundsRect: (NSRect)bounds inRect: (NSRect)rect;
+@end
+
+@interface NSTextTable (Private)
+- (NSRect) _rectForColumnsOfBlock: (NSTextTableBlock *)block
+                           inRect: (NSRect)rect;
+@end
+
 @implementation NSTextTable
 
+- (void) dealloc
+{
+  if (_columnEdges != NULL)
+    {
+      NSZoneFree([self zone], _columnEdges);
+    }
+  [super dealloc];
+}
+
+- (id) copyWithZone: (NSZone*)zone
+{
+  NSTextTable *t = [super copyWithZone: zone];
+
+  t->_columnEdges = NULL;
+  return t;
+}
+
 - (BOOL) collapsesBorders
 {
   return _collapsesBorders;	// if true: ???
@@ -70,6 +98,11 @@
 
 - (void) setNumberOfColumns: (NSUInteger)numCols
 {
+  if (numCols != _numberOfColumns && _columnEdges != NULL)
+    {
+      NSZoneFree([self zone], _columnEdges);
+      _columnEdges = NULL;
+    }
   _numberOfColumns = numCols;
 }
 
@@ -79,8 +112,13 @@
                 textContainer: (NSTextContainer *)container
                characterRange: (NSRange)range
 {
-  // FIXME
-  return NSZeroRect;
+  NSRect bounds = [block _boundsRectForContentRect: content inRect: rect];
+  NSRect columns = [self _rectForColumnsOfBlock: block inRect: rect];
+
+  // The cell fills its columns whatever the width of its text
+  bounds.origin.x = NSMinX(columns);
+  bounds.size.width = NSWidth(columns);
+  return bounds;
 }
 
 - (NSRect) rectForBlock: (NSTextTableBlock *)block
@@ -89,8 +127,11 @@
           textContainer: (NSTextContainer *)container
          characterRange: (NSRange)range
 {
-  // FIXME
-  return NSZeroRect;
+  NSRect cell = [self _rectForColumnsOfBlock: block inRect: rect];
+
+  cell.origin.y = start.y;
+  cell.size.height = MAX(NSMaxY(rect) - start.y, 0.0);
+  return [block _contentRectForBoundsRect: cell inRect: rect];
 }
 
 - (void) drawBackgroundForBlock: (NSTextTableBlock *)block
@@ -139,3 +180,52 @@
 }
 
 @end
+
+@implementation NSTextTable (Private)
+
+/* The horizontal extent of the columns spanned by block when the table is
+ * laid out in rect.  All cells of a table share the column edges, so they
+ * are worked out once for a width of the table and kept until the width
+ * or the number of columns changes.  Both layout algorithms share the
+ * width of the table equally between the columns, as the widths of the
+ * contents are not known here.
+ */
+- (NSRect) _rectForColumnsOfBlock: (NSTextTableBlock *)block
+                           inRect: (NSRect)rect
+{
+  NSUInteger columns = MAX(_numberOfColumns, 1);
+  NSUInteger first;
+  NSUInteger last;
+  NSRect table;
+
+  table = rect;
+  if ([self _scaledValue: NSTextBlockWidth : rect.size] > 0.0)
+    {
+      table.size.width = [self _scaledValue: NSTextBlockWidth : rect.size];
+    }
+  table = [self _contentRectForBoundsRect: table inRect: rect];
+
+  if (_columnEdges == NULL || _columnEdgesWidth != NSWidth(table))
+    {
+      NSUInteger i;
+
+      if (_columnEdges == NULL)
+        {
+          _columnEdges = NSZoneMalloc([self zone],
+                                      (columns + 1) * sizeof(CGFloat));
+        }
+      for (i = 0; i <= columns; i++)
+        {
+          _columnEdges[i] = NSWidth(table) * i / columns;
+        }
+      _columnEdgesWidth = NSWidth(table);
+    }
+
+  first = MIN((NSUInteger)MAX([block startingColumn], 0), columns - 1);
+  last = MIN(first + (NSUInteger)MAX([block columnSpan], 1), columns);
+  table.origin.x += _columnEdges[first];
+  table.size.width = _columnEdges[last] - _columnEdges[first];
+  return table;
+}
+
+@end
@@ -51,6 +51,7 @@
 #import <Foundation/NSCharacterSet.h>
 #import <Foundation/NSCoder.h>
 #import <Foundation/NSData.h>
+#import <Foundation/NSDate.h>
 #import <Foundation/NSDebug.h>
 #import <Foundation/NSEnumerator.h>
 #import <Foundation/NSException.h>
@@ -60,6 +61,7 @@
 #import <Foundation/NSString.h>
 #import <Foundation/NSTimer.h>
 #import <Foundation/NSUndoManager.h>
+#import <Foundation/NSUserDefaults.h>
 #import <Foundation/NSValue.h>
 #import "AppKit/NSApplication.h"
 #import "AppKit/NSAttributedString.h"
@@ -89,6 +91,7 @@
 #import "AppKit/NSTextView.h"
 #import "AppKit/NSWindow.h"
 #import "GSGuiPrivate.h"
+#import "GSIncrementalSpellChecker.h"
 #import "GSTextFinder.h"
 #import "GSToolTips.h"
 #import "GSFastEnumeration.h"
@@ -164,6 +167,13 @@ Interface for a bunch of internal methods that need to be cleaned up.
  */
 - (void) _becomeRulerClient;
 - (void) _resignRulerClient;
+
+/*
+ * Coalescing queued typing
+ */
+- (BOOL) _canCoalesceTyping: (NSEvent *)theEvent;
+- (void) _interpretQueuedTyping: (NSEvent *)theEvent;
+- (void) _insertTypedText;
 @end
 
 
@@ -315,6 +325,10 @@ Interface for a bunch of internal methods that need to be cleaned up.
 - (void) _undoTextChange: (NSTextViewUndoObject *)anObject;
 @end
 
+@interface NSLayoutManager (GSEstimatedLayout)
+- (NSRect) _estimatedUsedRectForTextContainer: (NSTextContainer *)container;
+@end
+
 /**** Misc. helpers and stuff ****/
 
 static const int currentVersion = 4;
@@ -520,6 +534,22 @@ this happens when layout has been invalidated, and when we are resized.
   [[self window] invalidateCursorRectsForView: self];
 }
 
+- (void) _layoutManagerDidLayoutGlyphRange: (NSRange)glyphRange
+{
+  NSRect r;
+
+  /* Our size estimate may have changed now that more text is laid out. */
+  [self sizeToFit];
+
+  r = [_layoutManager boundingRectForGlyphRange: glyphRange
+				inTextContainer: _textContainer];
+  r.origin.x += _textContainerOrigin.x;
+  r.origin.y += _textContainerOrigin.y;
+  r = NSIntersectionRect(r, [self visibleRect]);
+  if (!NSIsEmptyRect(r))
+    [self setNeedsDisplayInRect: r];
+}
+
 - (void) _layoutManagerDidInvalidateLayout
 {
   /*
@@ -567,6 +597,52 @@ this happens when layout has been invalidated, and when we are resized.
 @end
 
 
+/* Key events which are already queued when a key down reaches a text
+   view are typed in one go: the characters the input manager inserts
+   for them are collected in typedText and inserted with a single change
+   once all of them were interpreted, instead of one change, layout and
+   display each.  Up to MAX_TYPED_EVENTS events are gathered at a time.
+   Key events only arrive on the main thread, so static state will do.
+   The GSTypingCoalescingDisabled default turns this off.  */
+#define MAX_TYPED_EVENTS 64
+
+static NSTextView *typingView = nil;
+static NSMutableString *typedText = nil;
+static BOOL insertingTypedText = NO;
+
+/* Whether the event just types characters, ie. the input manager will
+   turn it into an -insertText: rather than a command.  */
+static BOOL
+isTypingEvent(NSEvent *event, NSWindow *window)
+{
+  NSString *chars;
+  NSUInteger i, length;
+
+  if ([event type] != NSKeyDown || [event window] != window
+    || ([event modifierFlags]
+      & (NSCommandKeyMask | NSControlKeyMask | NSFunctionKeyMask)))
+    {
+      return NO;
+    }
+  chars = [event characters];
+  length = [chars length];
+  if (length == 0)
+    {
+      return NO;
+    }
+  for (i = 0; i < length; i++)
+    {
+      unichar c = [chars characterAtIndex: i];
+
+      if (c < 0x20 || c == 0x7f || (c >= 0xf700 && c <= 0xf8ff))
+	{
+	  return NO;
+	}
+    }
+  return YES;
+}
+
+
 @implementation NSTextView
 
 
@@ -1116,6 +1192,8 @@ that makes decoding and encoding compatible with the old code.
     name: NSTextDidChangeNotification
     object: self];
   [_textCheckingTimer invalidate];
+  [_incrementalSpellChecker detach];
+  DESTROY(_incrementalSpellChecker);
 
   [[NSRunLoop currentRunLoop] cancelPerformSelector: @selector(_updateState:)
     target: self
@@ -1578,8 +1656,7 @@ to make sure syncing is handled properly in all cases.
 
       _tf.continuous_spell_checking = 0;
       
-      [_layoutManager removeTemporaryAttribute: @"NSTextChecked"
-			     forCharacterRange: allRange];
+      [_incrementalSpellChecker reset];
       [_layoutManager removeTemporaryAttribute: NSSpellingStateAttributeName
 			     forCharacterRange: allRange];
       _lastCheckedRect = NSZeroRect;
@@ -1608,6 +1685,20 @@ to make sure syncing is handled properly in all cases.
   return YES;
 }
 
+/* The layout manager may lay text out while drawing, which it can only
+   do on one thread at a time. */
+- (BOOL) canPrintPagesConcurrently
+{
+  return NO;
+}
+
+/* Pages are adjusted to line fragments, which only move when the
+   layout is invalidated. */
+- (NSUInteger) pageLayoutGeneration
+{
+  return [_layoutManager layoutGeneration];
+}
+
 - (BOOL) isOpaque
 {
   if (_tf.draws_background == NO
@@ -1922,8 +2013,18 @@ incorrectly. */
 
   if (_tf.is_horizontally_resizable || _tf.is_vertically_resizable)
     {
-      NSRect r = [_layoutManager usedRectForTextContainer: _textContainer];
+      NSRect r;
       NSSize s2;
+
+      /*
+      With non-contiguous layout we don't want to lay out a huge text just
+      to get our size, so we use an estimate that grows more accurate as
+      background layout proceeds.
+      */
+      if ([_layoutManager allowsNonContiguousLayout])
+	r = [_layoutManager _estimatedUsedRectForTextContainer: _textContainer];
+      else
+	r = [_layoutManager usedRectForTextContainer: _textContainer];
       if (_textContainer == [_layoutManager extraLineFragmentTextContainer])
 	{
 	  r = NSUnionRect(r, [_layoutManager extraLineFragmentUsedRect]);
@@ -2088,6 +2189,10 @@ here. */
 {
   NSAttributedString *as;
 
+  if (typingView == self)
+    {
+      [self _insertTypedText];
+    }
   _markedRange = selRange;
 
   as = [[NSAttributedString alloc] initWithString: aString
@@ -2147,6 +2252,10 @@ here. */
 chain if we can't handle it. */
 - (void) doCommandBySelector: (SEL)aSelector
 {
+  if (typingView == self)
+    {
+      [self _insertTypedText];
+    }
   if (!_layoutManager)
     {
       NSBeep();
@@ -2190,6 +2299,17 @@ This method is for user changes; see NSTextView_actions.m.
 
   isAttributed = [insertString isKindOfClass: [NSAttributedString class]];
 
+  if (typingView == self && !insertingTypedText)
+    {
+      if (!isAttributed)
+	{
+	  [typedText appendString: insertString];
+	  return;
+	}
+      [self _insertTypedText];
+      insertRange = [self rangeForUserTextChange];
+    }
+
   if (isAttributed)
     string = [(NSAttributedString *)insertString string];
   else
@@ -2722,8 +2842,9 @@ TextDidEndEditing notification _without_ asking the delegate
 	 immediately. We never coalesce actions when the current selection is
 	 not empty. */
       event = [NSApp currentEvent];
-      isTyping = [event type] == NSKeyDown
-	      && [[event characters] isEqualToString: replacementString];
+      isTyping = ([event type] == NSKeyDown
+	      && [[event characters] isEqualToString: replacementString])
+	|| insertingTypedText;
       if (undoManagerCanCoalesce && _undoObject)
 	{
 	  undoRange = [_undoObject range];
@@ -3932,8 +4053,17 @@ Figure out how the additional layout stuff is supposed to work.
   containerRect.origin.y -= _textContainerOrigin.y;
   if (_layoutManager)
     {
-      drawnRange = [_layoutManager glyphRangeForBoundingRect: containerRect 
-                                   inTextContainer: _textContainer];
+      /*
+      With non-contiguous layout only draw what has been laid out already;
+      background layout will ask us to redisplay the rest as it gets there.
+      */
+      if ([_layoutManager allowsNonContiguousLayout])
+        drawnRange = [_layoutManager
+          glyphRangeForBoundingRectWithoutAdditionalLayout: containerRect
+                                           inTextContainer: _textContainer];
+      else
+        drawnRange = [_layoutManager glyphRangeForBoundingRect: containerRect 
+                                               inTextContainer: _textContainer];
     }
   else
     {
@@ -5866,12 +5996,121 @@ static const NSInteger GSSpellingSuggestionMenuItemTag = 1;
     {
       [super keyDown: theEvent];
     }
+  else if (typingView == nil && [self _canCoalesceTyping: theEvent])
+    {
+      [self _interpretQueuedTyping: theEvent];
+    }
   else
     {
       [self interpretKeyEvents: [NSArray arrayWithObject: theEvent]];
     }
 }
 
+- (BOOL) _canCoalesceTyping: (NSEvent *)theEvent
+{
+  static int disabled = -1;
+
+  if (disabled < 0)
+    {
+      disabled = [[NSUserDefaults standardUserDefaults]
+	boolForKey: @"GSTypingCoalescingDisabled"];
+    }
+  /* A delegate vetting each change must see each keystroke.  */
+  return !disabled && ![self hasMarkedText]
+    && isTypingEvent(theEvent, _window)
+    && ![_delegate respondsToSelector:
+      @selector(textView:shouldChangeTextInRange:replacementString:)]
+    && ![_delegate respondsToSelector:
+      @selector(textView:shouldChangeTextInRanges:replacementStrings:)];
+}
+
+/* Takes the typing events which follow theEvent in the queue (and the
+   key ups between them) and has the input manager interpret them along
+   with theEvent, inserting all the characters they type at once.  The
+   key ups are sent afterwards.  */
+- (void) _interpretQueuedTyping: (NSEvent *)theEvent
+{
+  NSMutableArray *events = [NSMutableArray arrayWithObject: theEvent];
+  NSMutableArray *keyUps = [NSMutableArray array];
+  NSDate *past = [NSDate distantPast];
+  NSEvent *e;
+  NSUInteger i;
+
+  while ([events count] < MAX_TYPED_EVENTS)
+    {
+      e = [NSApp nextEventMatchingMask: NSAnyEventMask
+			     untilDate: past
+				inMode: NSEventTrackingRunLoopMode
+			       dequeue: NO];
+      if (e == nil)
+	break;
+      if ([e type] == NSKeyUp && [e window] == _window)
+	[keyUps addObject: e];
+      else if (isTypingEvent(e, _window))
+	[events addObject: e];
+      else
+	break;
+      [NSApp nextEventMatchingMask: NSAnyEventMask
+			 untilDate: past
+			    inMode: NSEventTrackingRunLoopMode
+			   dequeue: YES];
+    }
+
+  if ([events count] == 1)
+    {
+      [self interpretKeyEvents: events];
+    }
+  else
+    {
+      typingView = self;
+      typedText = [NSMutableString new];
+      NS_DURING
+	{
+	  [self interpretKeyEvents: events];
+	  [self _insertTypedText];
+	}
+      NS_HANDLER
+	{
+	  typingView = nil;
+	  DESTROY(typedText);
+	  [localException raise];
+	}
+      NS_ENDHANDLER
+      typingView = nil;
+      DESTROY(typedText);
+    }
+
+  for (i = 0; i < [keyUps count]; i++)
+    {
+      [NSApp sendEvent: [keyUps objectAtIndex: i]];
+    }
+}
+
+/* Inserts the characters collected while interpreting queued typing
+   events, as if they were typed with a single key.  */
+- (void) _insertTypedText
+{
+  NSString *text;
+
+  if ([typedText length] == 0)
+    return;
+
+  text = AUTORELEASE([typedText copy]);
+  [typedText setString: @""];
+  insertingTypedText = YES;
+  NS_DURING
+    {
+      [self insertText: text];
+    }
+  NS_HANDLER
+    {
+      insertingTypedText = NO;
+      [localException raise];
+    }
+  NS_ENDHANDLER
+  insertingTypedText = NO;
+}
+
 /* Bind other mouse up to pasteSelection. This should be done via
 configuation! */
 - (void) otherMouseUp: (NSEvent *)theEvent
@@ -6159,69 +6398,12 @@ or add guards
 
 - (void) _checkTextInRange: (NSRange)aRange
 {
-  NSRange longestRange;
-  id value = [_layoutManager temporaryAttribute: @"NSTextChecked" 
-			       atCharacterIndex: aRange.location
-			  longestEffectiveRange: &longestRange
-					inRange: aRange];
-  longestRange = NSIntersectionRange(longestRange, aRange);
-  
-  if ([value boolValue] && NSEqualRanges(longestRange, aRange))
+  if (_incrementalSpellChecker == nil)
     {
-      //NSLog(@"No need to check in range %@", NSStringFromRange(aRange));
-      return;
+      _incrementalSpellChecker =
+	[[GSIncrementalSpellChecker alloc] initWithTextView: self];
     }
-  
-  // Check all of aRange
-
-  [_layoutManager removeTemporaryAttribute: NSSpellingStateAttributeName
-			 forCharacterRange: aRange];
-  
-  {
-    NSSpellChecker *sp = [NSSpellChecker sharedSpellChecker];
-    NSInteger start = 0;
-    NSInteger count;
-    // FIXME: doing the spellcheck on this substring could create false-positives
-    // if a word is split in half.. so the range should be expanded to the 
-    // nearest word boundary
-    NSString *substring = [[self string] substringWithRange: aRange];
-    
-    do {
-      NSRange errorRange = [sp checkSpellingOfString: substring
-					  startingAt: start
-					    language: [sp language]
-						wrap: YES
-			      inSpellDocumentWithTag: [self spellCheckerDocumentTag]
-					   wordCount: &count];
-      
-      if (errorRange.location < start)
-	{
-	  break;
-	}
-      
-      if (errorRange.length > 0)
-	{
-	  start = NSMaxRange(errorRange);
-	}
-      else
-	{
-	  break;
-	}
-      
-      errorRange = NSMakeRange(aRange.location + errorRange.location, errorRange.length);
-      
-      //NSLog(@"highlighting mistake: %@", [[self string] substringWithRange: errorRange]);
-      
-      [_layoutManager addTemporaryAttribute: NSSpellingStateAttributeName
-				      value: [NSNumber numberWithInteger: NSSpellingStateSpellingFlag]
-			  forCharacterRange: errorRange];
-      
-    } while (1);
-    
-    [_layoutManager addTemporaryAttribute: @"NSTextChecked"
-				    value: [NSNumber numberWithBool: YES]
-			forCharacterRange: aRange];
-  }
+  [_incrementalSpellChecker checkRange: aRange];
 }
 
 - (void) _textCheckingTimerFired: (NSTimer *)t
@@ -6274,73 +6456,15 @@ or add guards
     }
 }
 
-/**
- * If selected has a nonzero length, return it unmodified.
- * If selected is touching a word, expand it to cover the entire word
- * Otherwise return selected unmodified
- */
-- (NSRange) _rangeToInvalidateSpellingForSelectionRange: (NSRange)selected
-{
-  if (selected.length > 0)
-    {
-      return selected;
-    }
-  else
-    {
-      NSRange prevNonCharacter;
-      NSRange nextNonCharacter;
-      NSRange range;
-      NSCharacterSet *boundary = [[NSCharacterSet letterCharacterSet] invertedSet];
-  
-      if (selected.location == [[self string] length] && selected.location > 0)
-	{
-	  selected.location--;
-	}
-
-      prevNonCharacter = [[self string] rangeOfCharacterFromSet: boundary options: NSBackwardsSearch range: NSMakeRange(0, selected.location)];
-      nextNonCharacter = [[self string] rangeOfCharacterFromSet: boundary options: 0 range: NSMakeRange(NSMaxRange(selected), [[self string] length] - NSMaxRange(selected))];
-  
-      if (prevNonCharacter.length == 0)
-	{
-	  range.location = 0;
-	}
-      else
-	{
-	  range.location = prevNonCharacter.location + 1;
-	}
-
-      if (nextNonCharacter.length == 0)
-	{
-	  range.length = [[self string] length] - range.location;
-	}
-      else
-	{
-	  range.length = nextNonCharacter.location - range.location;
-	}
-
-      return range;
-    }
-}
-
 - (void) _textDidChange: (NSNotification*)notif
 {
   if (_tf.continuous_spell_checking)
     {
-      // FIXME: This uses the caret position to guess what change caused
-      // the NSTextDidChangeNotification and mark that range of the text as requiring re-checking.
-      //
-      // It would be better to use accurate information to decide what range
-      // need its spelling state invalidated.
-
-      NSRange range = [self _rangeToInvalidateSpellingForSelectionRange: [self selectedRange]];
-      if (range.length > 0)
-	{
-	  [_layoutManager removeTemporaryAttribute: @"NSTextChecked"
-				 forCharacterRange: range];
-	  [_layoutManager removeTemporaryAttribute: NSSpellingStateAttributeName
-				 forCharacterRange: range];
-	}
-
+      /*
+      The spell checker has already seen the edits through the text
+      storage, so we only need to clear the marks it invalidated.
+      */
+      [_incrementalSpellChecker removeInvalidMarks];
       [self _scheduleTextCheckingTimer];
     }
 }
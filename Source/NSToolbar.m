@@ -31,6 +31,7 @@
 
 #import <Foundation/NSObject.h>
 #import <Foundation/NSArray.h>
+#import <Foundation/NSDate.h>
 #import <Foundation/NSDictionary.h>
 #import <Foundation/NSEnumerator.h>
 #import <Foundation/NSException.h>
@@ -974,6 +975,16 @@ static GSValidationCenter *vc = nil;
     [_toolbarView setBorderMask: 0];
 }
 
+- (NSTimeInterval) validationInterval
+{
+  return _validationInterval;
+}
+
+- (void) setValidationInterval: (NSTimeInterval)interval
+{
+  _validationInterval = MAX(interval, 0.0);
+}
+
 // Private methods
 
 - (NSArray *) _defaultItemIdentifiers
@@ -1551,8 +1562,21 @@ static GSValidationCenter *vc = nil;
 
 - (void) _validate: (NSWindow *)observedWindow
 {
+  NSWindow *window = [_toolbarView window];
+  NSTimeInterval now;
+
   // We observe only one window, then we ignore observedWindow.
-  
+
+  /* Items of a window in the background are validated again when it
+     becomes key or main, since that updates the window.  */
+  if (![window isKeyWindow] && ![window isMainWindow])
+    return;
+
+  now = [NSDate timeIntervalSinceReferenceDate];
+  if (now - _lastValidation < _validationInterval)
+    return;
+  _lastValidation = now;
+
   [self validateVisibleItems];
 }
 
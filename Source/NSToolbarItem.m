@@ -1429,22 +1429,41 @@ NSString *GSMovableToolbarItemPboardType = @"GSMovableToolbarItemPboardType";
 - (void) validate
 {
   BOOL enabled = YES;
+  SEL action;
   id target;
 
   /* No validation for custom views */
   if (_view)
     return;
 
-  target = [NSApp targetForAction: [self action] to: [self target] from: self];
-  if (target == nil || ![target respondsToSelector: [self action]])
+  action = [self action];
+  target = [NSApp targetForAction: action to: [self target] from: self];
+  if (target != nil
+      && ([target class] != _validatorClass
+          || !sel_isEqual(action, _validatorAction)))
+    {
+      /* The validator is usually the same object, or one of the same
+         class, each time, so remember how it validates us.  */
+      _validatorClass = [target class];
+      _validatorAction = action;
+      _validatorResponds = [target respondsToSelector: action];
+      if ([target respondsToSelector: @selector(validateToolbarItem:)])
+        _validatorSelector = @selector(validateToolbarItem:);
+      else if ([target respondsToSelector: @selector(validateUserInterfaceItem:)])
+        _validatorSelector = @selector(validateUserInterfaceItem:);
+      else
+        _validatorSelector = NULL;
+    }
+
+  if (target == nil || !_validatorResponds)
     {
       enabled = NO;
     }
-  else if ([target respondsToSelector: @selector(validateToolbarItem:)])
+  else if (sel_isEqual(_validatorSelector, @selector(validateToolbarItem:)))
     {
       enabled = [target validateToolbarItem: self];
     }
-  else if ([target respondsToSelector: @selector(validateUserInterfaceItem:)])
+  else if (_validatorSelector != NULL)
     {
       enabled = [target validateUserInterfaceItem: self];
     }
@@ -50,11 +50,13 @@
 #import <Foundation/NSDebug.h>
 #import <Foundation/NSPathUtilities.h>
 #import <Foundation/NSSet.h>
+#import <Foundation/NSUserDefaults.h>
 
 #import "AppKit/NSAffineTransform.h"
 #import "AppKit/NSApplication.h"
 #import "AppKit/NSBezierPath.h"
 #import "AppKit/NSBitmapImageRep.h"
+#import "AppKit/NSCachedImageRep.h"
 #import "AppKit/NSCursor.h"
 #import "AppKit/NSDocumentController.h"
 #import "AppKit/NSDocument.h"
@@ -77,6 +79,8 @@
 #import "GSToolTips.h"
 #import "GSBindingHelpers.h"
 #import "GSGuiPrivate.h"
+#import "GSTraceProbes.h"
+#import "GSGridIndex.h"
 #import "NSViewPrivate.h"
 
 /*
@@ -97,7 +101,13 @@
 /* Variable tells this view and subviews that we're printing. Not really
    a class variable because we want it visible to subviews also
 */
-NSView *viewIsPrinting = nil;
+GS_THREAD_LOCAL NSView *viewIsPrinting = nil;
+
+/* The root of the detached view hierarchy being drawn into a bitmap by
+   -cacheDisplayInRect:toBitmapImageRep: in this thread, if any.  Views
+   in it draw and convert coordinates as if the root was at the origin
+   of a window.  */
+static GS_THREAD_LOCAL NSView *viewIsRendering = nil;
 
 /**
   <unit>
@@ -130,11 +140,33 @@ static NSAffineTransform	*flip = nil;
 
 static NSNotificationCenter *nc = nil;
 
+static BOOL	defersAutoresizing = NO;
+static NSUInteger	savedAutoresizeCount = 0;
+
 static SEL	preSel;
 static SEL	invalidateSel;
 
 static void	(*preImp)(NSAffineTransform*, SEL, NSAffineTransform*);
 static void	(*invalidateImp)(NSView*, SEL);
+static SEL	hitTestSel;
+static IMP	hitTestImp;
+static SEL	mouseInRectSel;
+static IMP	mouseInRectImp;
+
+extern NSThread *GSAppKitThread; /* TODO */
+
+/*
+ *	Gstates given up by views in -releaseGState are kept here instead
+ *	of being undefined, so that the next view to allocate a gstate in
+ *	the same context can replace one rather than define a new one.
+ *	Only used in the AppKit thread.
+ */
+#define GSTATE_POOL_SIZE 16
+static struct {
+  NSGraphicsContext *ctxt;
+  NSInteger gstate;
+} gstatePool[GSTATE_POOL_SIZE];
+static NSUInteger	gstatePoolCount = 0;
 
 /*
  *	Stuff to maintain a map table so we know what views are
@@ -206,6 +238,17 @@ GSSetDragTypes(NSView* obj, NSArray *types)
  */
 
 
+/* Makes the window of view find its tracking rectangles again on the
+   next mouse move, after they were added, removed or may have moved.  */
+static inline void
+invalidate_tracking_rects(NSView *view)
+{
+  if (view->_window != nil)
+    {
+      view->_window->_f.tracking_rects_valid = NO;
+    }
+}
+
 /*
  *	The [-_invalidateCoordinates] method marks the coordinate mapping
  *	matrices (matrixFromWindow and _matrixToWindow) and the cached visible
@@ -221,6 +264,8 @@ GSSetDragTypes(NSView* obj, NSArray *types)
       NSUInteger count;
 
       _coordinates_valid = NO;
+      DESTROY(_displayCache);
+      invalidate_tracking_rects(self);
       if (_rFlags.valid_rects != 0)
         {
           [_window invalidateCursorRectsForView: self];
@@ -300,7 +345,7 @@ GSSetDragTypes(NSView* obj, NSArray *types)
       _coordinates_valid = YES;
       _rFlags.flipped_view = isFlipped;
 
-      if (!_window)
+      if (!_window && viewIsRendering == nil)
         {
           _visibleRect = NSZeroRect;
           [_matrixToWindow makeIdentityMatrix];
@@ -397,6 +442,11 @@ GSSetDragTypes(NSView* obj, NSArray *types)
 {
   BOOL old_allocate_gstate;
 
+  /* The layout pass of the window would not find the view any more.  */
+  if (_rFlags.needs_layout || _rFlags.subtree_needs_layout)
+    {
+      [self layoutSubtreeIfNeeded];
+    }
   [self viewWillMoveToWindow: newWindow];
   if (_coordinates_valid)
     {
@@ -419,6 +469,12 @@ GSSetDragTypes(NSView* obj, NSArray *types)
   [self releaseGState];
   _allocate_gstate = old_allocate_gstate;
 
+  if (_rFlags.cursor_rects_pending)
+    {
+      [_window->_invalidCursorRectViews removeObjectIdenticalTo: self];
+      _rFlags.cursor_rects_pending = 0;
+    }
+
   if (_rFlags.has_draginfo)
     {
       NSArray *t = GSGetDragTypes(self);
@@ -442,6 +498,8 @@ GSSetDragTypes(NSView* obj, NSArray *types)
     }
   
   _window = newWindow;
+  /* Have the new window ask for our cursor rectangles.  */
+  [newWindow invalidateCursorRectsForView: self];
 
   if (_rFlags.has_subviews)
     {
@@ -564,10 +622,17 @@ GSSetDragTypes(NSView* obj, NSArray *types)
       invalidateImp = (void (*)(NSView*, SEL))
           [self instanceMethodForSelector: invalidateSel];
 
+      hitTestSel = @selector(hitTest:);
+      hitTestImp = [self instanceMethodForSelector: hitTestSel];
+      mouseInRectSel = @selector(mouse:inRect:);
+      mouseInRectImp = [self instanceMethodForSelector: mouseInRectSel];
+
       flip = [matrixClass new];
       [flip setTransformStruct: ats];
 
       nc = [NSNotificationCenter defaultCenter];
+      defersAutoresizing = [[NSUserDefaults standardUserDefaults]
+                             boolForKey: @"GSDefersAutoresizing"];
 
       viewClass = [NSView class];
       rectClass = [GSTrackingRect class];
@@ -643,6 +708,175 @@ GSSetDragTypes(NSView* obj, NSArray *types)
   return self;
 }
 
+/*
+ * Spatial index of subviews used by -hitTest: once a view has at least
+ * SUBVIEW_INDEX_THRESHOLD subviews.  The grid holds the positions in
+ * _sub_views of the subviews.  Subviews whose frames don't bound their
+ * hit area (those with a frame matrix or rotated bounds, or which
+ * override -hitTest:) are inexact and so always searched.  The index is
+ * rebuilt on demand after subviews are added, removed or reordered, and
+ * updated in place when a subview's frame changes.
+ */
+#define SUBVIEW_INDEX_THRESHOLD 64
+
+typedef struct {
+  NSUInteger viewCount;
+  NSView **views;
+  GSGridIndex *grid;
+} GSSubviewIndex;
+
+static void
+free_subview_index(GSSubviewIndex *idx)
+{
+  if (idx == NULL)
+    return;
+  GSGridIndexFree(idx->grid);
+  NSZoneFree(NSDefaultMallocZone(), idx->views);
+  NSZoneFree(NSDefaultMallocZone(), idx);
+}
+
+/*
+ * What a view keeps while its window is resized live: its frame size and
+ * bounds when the resize started and, if it opted in, a copy of what it
+ * showed then, taken from the window.
+ */
+typedef struct {
+  NSSize frameSize;
+  NSRect bounds;
+  NSRect snapshotRect;
+  NSBitmapImageRep *snapshot;
+  BOOL stretches;
+} GSLiveResize;
+
+static void
+free_live_resize(GSLiveResize *lr)
+{
+  if (lr == NULL)
+    return;
+  RELEASE(lr->snapshot);
+  NSZoneFree(NSDefaultMallocZone(), lr);
+}
+
+/* Puts the parts of a not covered by b in rects, and returns how many
+   there are, at most four.  */
+static NSUInteger
+subtract_rect(NSRect a, NSRect b, NSRect *rects)
+{
+  NSRect c = NSIntersectionRect(a, b);
+  NSUInteger n = 0;
+
+  if (NSIsEmptyRect(c))
+    {
+      if (NSIsEmptyRect(a) == NO)
+	rects[n++] = a;
+      return n;
+    }
+  if (NSMinY(c) > NSMinY(a))
+    rects[n++] = NSMakeRect(NSMinX(a), NSMinY(a),
+			    NSWidth(a), NSMinY(c) - NSMinY(a));
+  if (NSMaxY(c) < NSMaxY(a))
+    rects[n++] = NSMakeRect(NSMinX(a), NSMaxY(c),
+			    NSWidth(a), NSMaxY(a) - NSMaxY(c));
+  if (NSMinX(c) > NSMinX(a))
+    rects[n++] = NSMakeRect(NSMinX(a), NSMinY(c),
+			    NSMinX(c) - NSMinX(a), NSHeight(c));
+  if (NSMaxX(c) < NSMaxX(a))
+    rects[n++] = NSMakeRect(NSMaxX(c), NSMinY(c),
+			    NSMaxX(a) - NSMaxX(c), NSHeight(c));
+  return n;
+}
+
+static BOOL
+subview_is_indexable(NSView *sub)
+{
+  return sub->_frameMatrix == nil && sub->_is_rotated_from_base == NO
+    && [sub methodForSelector: hitTestSel] == hitTestImp;
+}
+
+static GSSubviewIndex *
+build_subview_index(NSView *view)
+{
+  NSUInteger count = [view->_sub_views count];
+  NSView *array[count];
+  BOOL exact[count];
+  CGFloat x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+  BOOL found = NO;
+  GSSubviewIndex *idx;
+  NSUInteger i;
+
+  [view->_sub_views getObjects: array];
+  for (i = 0; i < count; i++)
+    {
+      NSRect f = array[i]->_frame;
+
+      exact[i] = subview_is_indexable(array[i]);
+      if (exact[i] == NO)
+	continue;
+      if (found == NO)
+	{
+	  x0 = NSMinX(f);
+	  y0 = NSMinY(f);
+	  x1 = NSMaxX(f);
+	  y1 = NSMaxY(f);
+	  found = YES;
+	}
+      else
+	{
+	  x0 = MIN(x0, NSMinX(f));
+	  y0 = MIN(y0, NSMinY(f));
+	  x1 = MAX(x1, NSMaxX(f));
+	  y1 = MAX(y1, NSMaxY(f));
+	}
+    }
+
+  idx = NSZoneMalloc(NSDefaultMallocZone(), sizeof(GSSubviewIndex));
+  idx->viewCount = count;
+  idx->views = NSZoneMalloc(NSDefaultMallocZone(), count * sizeof(NSView*));
+  memcpy(idx->views, array, count * sizeof(NSView*));
+  idx->grid = GSGridIndexCreate(count, NSMakeRect(x0, y0, x1 - x0, y1 - y0));
+  for (i = 0; i < count; i++)
+    {
+      GSGridIndexAdd(idx->grid, i, array[i]->_frame, exact[i]);
+    }
+  return idx;
+}
+
+/* Drops the subview index of view after its subviews were added,
+   removed or reordered.  */
+static inline void
+invalidate_subview_index(NSView *view)
+{
+  if (view->_subviewIndex != NULL)
+    {
+      free_subview_index(view->_subviewIndex);
+      view->_subviewIndex = NULL;
+    }
+}
+
+/* Moves sub within the subview index of its superview after its frame
+   changed.  */
+static void
+update_subview_index(NSView *sub)
+{
+  NSView *view = sub->_super_view;
+  GSSubviewIndex *idx;
+  NSUInteger i;
+
+  if (view == nil || view->_subviewIndex == NULL)
+    return;
+  idx = view->_subviewIndex;
+  for (i = 0; i < idx->viewCount; i++)
+    {
+      if (idx->views[i] == sub)
+	{
+	  GSGridIndexRemove(idx->grid, i);
+	  GSGridIndexAdd(idx->grid, i, sub->_frame, subview_is_indexable(sub));
+	  return;
+	}
+    }
+  invalidate_subview_index(view);
+}
+
 - (void) dealloc
 {
   NSView *tmp;
@@ -650,6 +884,7 @@ GSSetDragTypes(NSView* obj, NSArray *types)
 
   // Remove all key value bindings for this view.
   [GSKeyValueBinding unbindAllForObject: self];
+  GSPrintForgetPagination(self);
 
   /*
    * Remove self from view chain.  Try to mimic MacOS-X behavior ...
@@ -754,6 +989,13 @@ GSSetDragTypes(NSView* obj, NSArray *types)
       [[_sub_views lastObject] removeFromSuperviewWithoutNeedingDisplay];
     }
 
+  if (_invalidRects != NULL)
+    {
+      NSZoneFree(NSDefaultMallocZone(), _invalidRects);
+    }
+  free_subview_index(_subviewIndex);
+  free_live_resize(_liveResize);
+  TEST_RELEASE(_displayCache);
   RELEASE(_matrixToWindow);
   RELEASE(_matrixFromWindow);
   TEST_RELEASE(_frameMatrix);
@@ -834,6 +1076,8 @@ GSSetDragTypes(NSView* obj, NSArray *types)
   [aView _viewWillMoveToSuperview: self];
   [aView setNextResponder: self];
   [_sub_views insertObject: aView atIndex: index];
+  invalidate_subview_index(self);
+  invalidate_tracking_rects(self);
   _rFlags.has_subviews = 1;
   [aView resetCursorRects];
   [aView setNeedsDisplay: YES];
@@ -968,6 +1212,8 @@ GSSetDragTypes(NSView* obj, NSArray *types)
   [aView setNextResponder: nil];
   RETAIN(aView);
   [_sub_views removeObjectIdenticalTo: aView];
+  invalidate_subview_index(self);
+  invalidate_tracking_rects(self);
   [aView setNeedsDisplay: NO];
   [aView _viewDidMoveToWindow];
   [aView viewDidMoveToSuperview];
@@ -1007,6 +1253,8 @@ GSSetDragTypes(NSView* obj, NSArray *types)
       [newView _viewWillMoveToSuperview: self];
       [newView setNextResponder: self];
       [_sub_views addObject: newView];
+      invalidate_subview_index(self);
+      invalidate_tracking_rects(self);
       _rFlags.has_subviews = 1;
       [newView resetCursorRects];
       [newView setNeedsDisplay: YES];
@@ -1045,6 +1293,8 @@ GSSetDragTypes(NSView* obj, NSArray *types)
 	  [newView setNextResponder: self];
           [_sub_views insertObject: newView
                            atIndex: index];
+	  invalidate_subview_index(self);
+	  invalidate_tracking_rects(self);
 	  _rFlags.has_subviews = 1;
 	  [newView resetCursorRects];
 	  [newView setNeedsDisplay: YES];
@@ -1104,6 +1354,8 @@ GSSetDragTypes(NSView* obj, NSArray *types)
     }
   
   ASSIGN(_sub_views, uniqNew);
+  invalidate_subview_index(self);
+  invalidate_tracking_rects(self);
 
   // The order of the subviews may have changed
   [self setNeedsDisplay: YES];
@@ -1113,6 +1365,8 @@ GSSetDragTypes(NSView* obj, NSArray *types)
 			   context: (void*)context
 {
   [_sub_views sortUsingFunction: compare context: context];
+  invalidate_subview_index(self);
+  invalidate_tracking_rects(self);
 }
 
 /**
@@ -1174,10 +1428,72 @@ static NSSize _computeScale(NSSize fs, NSSize bs)
   return scale;
 }
 
+/*
+ * With deferred autoresizing, a view in a window whose frame changes
+ * remembers its size before the first change and marks itself and its
+ * ancestors, and the window, as needing layout.  The subviews are then
+ * autoresized once, from that size, by -layoutSubtreeIfNeeded, which
+ * the window sends before displaying and which views send themselves
+ * before they are drawn.  Views without subviews, or outside a window,
+ * are never deferred.
+ */
++ (void) setDefersAutoresizing: (BOOL)flag
+{
+  defersAutoresizing = flag;
+}
+
++ (BOOL) defersAutoresizing
+{
+  return defersAutoresizing;
+}
+
++ (NSUInteger) _savedAutoresizeCount
+{
+  return savedAutoresizeCount;
+}
+
+static void
+mark_needs_layout(NSView *view)
+{
+  NSView *ancestor;
+
+  view->_rFlags.needs_layout = YES;
+  for (ancestor = view->_super_view;
+       ancestor != nil && ancestor->_rFlags.subtree_needs_layout == NO;
+       ancestor = ancestor->_super_view)
+    {
+      ancestor->_rFlags.subtree_needs_layout = YES;
+    }
+  if (view->_window != nil)
+    {
+      view->_window->_f.views_need_layout = YES;
+    }
+}
+
+static void
+resize_subviews(NSView *view, NSSize oldSize)
+{
+  if (defersAutoresizing == NO || view->_window == nil
+    || view->_rFlags.has_subviews == NO)
+    {
+      [view resizeSubviewsWithOldSize: oldSize];
+    }
+  else if (view->_rFlags.needs_layout)
+    {
+      savedAutoresizeCount++;
+    }
+  else
+    {
+      view->_autoresizingOldSize = oldSize;
+      mark_needs_layout(view);
+    }
+}
+
 - (void) _setFrameAndClearAutoresizingError: (NSRect)frameRect
 {
   _frame = frameRect;
   _autoresizingFrameError = NSZeroRect;
+  update_subview_index(self);
 }
 
 - (void) setFrame: (NSRect)frameRect
@@ -1234,7 +1550,7 @@ static NSSize _computeScale(NSSize fs, NSSize bs)
           (*invalidateImp)(self, invalidateSel);
         }
       [self resetCursorRects];
-      [self resizeSubviewsWithOldSize: old_size];
+      resize_subviews(self, old_size);
       if (_post_frame_changes)
         {
           [nc postNotificationName: NSViewFrameDidChangeNotification
@@ -1320,7 +1636,7 @@ static NSSize _computeScale(NSSize fs, NSSize bs)
           (*invalidateImp)(self, invalidateSel);
         }
       [self resetCursorRects];
-      [self resizeSubviewsWithOldSize: old_size];
+      resize_subviews(self, old_size);
       if (_post_frame_changes)
         {
           [nc postNotificationName: NSViewFrameDidChangeNotification
@@ -1344,6 +1660,7 @@ static NSSize _computeScale(NSSize fs, NSSize bs)
 
       [_frameMatrix rotateByDegrees: angle - oldAngle];
       _is_rotated_from_base = _is_rotated_or_scaled_from_base = YES;
+      update_subview_index(self);
 
       if (_coordinates_valid)
         {
@@ -1635,6 +1952,7 @@ static NSSize _computeScale(NSSize fs, NSSize bs)
       RELEASE(matrix);
 
       _is_rotated_from_base = _is_rotated_or_scaled_from_base = YES;
+      update_subview_index(self);
 
       if (_coordinates_valid)
         {
@@ -1773,7 +2091,8 @@ convert_rect_using_matrices(NSRect aRect, NSAffineTransform *matrix1,
 {
   NSAffineTransform *matrix1, *matrix2;
 
-  if (aView == self || _window == nil || (aView != nil && [aView window] == nil))
+  if (aView == self || (_window == nil && viewIsRendering == nil)
+      || (aView != nil && [aView window] == nil && viewIsRendering == nil))
     {
       return aRect;
     }
@@ -1805,7 +2124,8 @@ convert_rect_using_matrices(NSRect aRect, NSAffineTransform *matrix1,
 {
   NSAffineTransform *matrix1, *matrix2;
 
-  if (aView == self || _window == nil || (aView != nil && [aView window] == nil))
+  if (aView == self || (_window == nil && viewIsRendering == nil)
+      || (aView != nil && [aView window] == nil && viewIsRendering == nil))
     {
       return aRect;
     }
@@ -1825,6 +2145,83 @@ convert_rect_using_matrices(NSRect aRect, NSAffineTransform *matrix1,
   return convert_rect_using_matrices(aRect, matrix1, matrix2);
 }
 
+/* Helper for the methods converting arrays of points and rects.  Returns
+   the transform from the coordinates of from to those of to, either of
+   which may be nil for the window's coordinates.  */
+static NSAffineTransform *
+conversion_matrix(NSView *from, NSView *to)
+{
+  NSAffineTransform *matrix;
+
+  if (from != nil)
+    {
+      matrix = AUTORELEASE([[from _matrixToWindow] copy]);
+      if (to != nil)
+	[matrix appendTransform: [to _matrixFromWindow]];
+    }
+  else if (to != nil)
+    {
+      matrix = [to _matrixFromWindow];
+    }
+  else
+    {
+      matrix = nil;
+    }
+  return matrix;
+}
+
+- (void) convertPoints: (NSPoint *)points
+		 count: (NSUInteger)count
+	      fromView: (NSView*)aView
+{
+  if (aView == self || count == 0)
+    return;
+
+  if (aView != nil)
+    NSAssert(_window == [aView window], NSInvalidArgumentException);
+  [conversion_matrix(aView, self) transformPoints: points count: count];
+}
+
+- (void) convertPoints: (NSPoint *)points
+		 count: (NSUInteger)count
+		toView: (NSView*)aView
+{
+  if (aView == self || count == 0)
+    return;
+
+  if (aView != nil)
+    NSAssert(_window == [aView window], NSInvalidArgumentException);
+  [conversion_matrix(self, aView) transformPoints: points count: count];
+}
+
+- (void) convertRects: (NSRect *)rects
+		count: (NSUInteger)count
+	     fromView: (NSView*)aView
+{
+  if (aView == self || (_window == nil && viewIsRendering == nil)
+      || (aView != nil && [aView window] == nil && viewIsRendering == nil)
+      || count == 0)
+    return;
+
+  if (aView != nil)
+    NSAssert(_window == [aView window], NSInvalidArgumentException);
+  [conversion_matrix(aView, self) transformRects: rects count: count];
+}
+
+- (void) convertRects: (NSRect *)rects
+		count: (NSUInteger)count
+	       toView: (NSView*)aView
+{
+  if (aView == self || (_window == nil && viewIsRendering == nil)
+      || (aView != nil && [aView window] == nil && viewIsRendering == nil)
+      || count == 0)
+    return;
+
+  if (aView != nil)
+    NSAssert(_window == [aView window], NSInvalidArgumentException);
+  [conversion_matrix(self, aView) transformRects: rects count: count];
+}
+
 - (NSSize) convertSize: (NSSize)aSize fromView: (NSView*)aView
 {
   NSSize inBase;
@@ -1936,6 +2333,9 @@ convert_rect_using_matrices(NSRect aRect, NSAffineTransform *matrix1,
 
       if (_autoresizes_subviews == NO || _is_rotated_from_base == YES)
           return;
+      /* Laid out once the live resize is over.  */
+      if (_liveResize != NULL && ((GSLiveResize*)_liveResize)->stretches)
+          return;
 
       e = [_sub_views objectEnumerator];
       o = [e nextObject];
@@ -2015,6 +2415,59 @@ static void autoresize(CGFloat oldContainerSize,
     }
 }
 
+- (BOOL) needsLayout
+{
+  return _rFlags.needs_layout;
+}
+
+/**
+ * Marks the receiver as needing its subviews autoresized by the next
+ * layout pass, or clears the mark.
+ */
+- (void) setNeedsLayout: (BOOL)flag
+{
+  if (flag == NO)
+    {
+      _rFlags.needs_layout = NO;
+    }
+  else if (_rFlags.needs_layout == NO)
+    {
+      _autoresizingOldSize = _frame.size;
+      mark_needs_layout(self);
+    }
+}
+
+/**
+ * Autoresizes the subviews of the receiver if it needs layout, and then
+ * does the same for every view inside it which needs layout, from the
+ * top down.
+ */
+- (void) layoutSubtreeIfNeeded
+{
+  if (_rFlags.needs_layout)
+    {
+      _rFlags.needs_layout = NO;
+      [self resizeSubviewsWithOldSize: _autoresizingOldSize];
+    }
+  if (_rFlags.subtree_needs_layout)
+    {
+      NSUInteger count = [_sub_views count];
+      NSView *array[count];
+      NSUInteger i;
+
+      _rFlags.subtree_needs_layout = NO;
+      [_sub_views getObjects: array];
+      for (i = 0; i < count; i++)
+        {
+          if (array[i]->_rFlags.needs_layout
+            || array[i]->_rFlags.subtree_needs_layout)
+            {
+              [array[i] layoutSubtreeIfNeeded];
+            }
+        }
+    }
+}
+
 - (void) resizeWithOldSuperviewSize: (NSSize)oldSize
 {
   NSSize superViewFrameSize;
@@ -2074,12 +2527,49 @@ static void autoresize(CGFloat oldContainerSize,
   _autoresizingFrameError.size.height = (newFrameRounded.size.height - newFrame.size.height);
 }
 
+/* Takes a pooled gstate of ctxt, or returns 0 if there is none.  */
+static NSInteger
+pooled_gstate(NSGraphicsContext *ctxt)
+{
+  NSUInteger i;
+
+  if (GSCurrentThread() != GSAppKitThread)
+    return 0;
+  for (i = gstatePoolCount; i-- > 0; )
+    {
+      if (gstatePool[i].ctxt == ctxt)
+        {
+          NSInteger gstate = gstatePool[i].gstate;
+
+          RELEASE(gstatePool[i].ctxt);
+          gstatePool[i] = gstatePool[--gstatePoolCount];
+          return gstate;
+        }
+    }
+  return 0;
+}
+
+/* Gives gstate back to the pool, undefining it if the pool is full.  */
+static void
+pool_gstate(NSGraphicsContext *ctxt, NSInteger gstate)
+{
+  if (GSCurrentThread() != GSAppKitThread
+    || gstatePoolCount == GSTATE_POOL_SIZE)
+    {
+      GSUndefineGState(ctxt, gstate);
+      return;
+    }
+  gstatePool[gstatePoolCount].ctxt = RETAIN(ctxt);
+  gstatePool[gstatePoolCount].gstate = gstate;
+  gstatePoolCount++;
+}
+
 - (void) _lockFocusInContext: (NSGraphicsContext *)ctxt inRect: (NSRect)rect
 {
   NSRect wrect;
   NSInteger window_gstate = 0;
 
-  if (viewIsPrinting == nil)
+  if (viewIsPrinting == nil && viewIsRendering == nil)
     {
       NSAssert(_window != nil, NSInternalInconsistencyException);
       /* Check for deferred window */
@@ -2091,7 +2581,11 @@ static void autoresize(CGFloat oldContainerSize,
 
   if (ctxt == nil)
     {
-      if (viewIsPrinting != nil)
+      if (viewIsRendering != nil)
+        {
+          ctxt = GSCurrentContext();
+        }
+      else if (viewIsPrinting != nil)
         {
           NSPrintOperation *printOp = [NSPrintOperation currentOperation];
 
@@ -2103,9 +2597,10 @@ static void autoresize(CGFloat oldContainerSize,
         }
     }
 
-  // Set current context
-  [NSGraphicsContext saveGraphicsState];
-  [NSGraphicsContext setCurrentContext: ctxt];
+  /* Set current context.  There is no need to save the gstate of the
+     previous one: the gsave below protects the gstate of ctxt and
+     nothing draws into another context until we unlock.  */
+  GSPushCurrentContext(ctxt);
 
   [ctxt lockFocusView: self inRect: rect];
   wrect = [self convertRect: rect toView: nil];
@@ -2115,7 +2610,7 @@ static void autoresize(CGFloat oldContainerSize,
 	      NSStringFromRect(wrect),
 	      self, _window, NSStringFromRect([_window frame]),
 	      NSStringFromRect(_frame), [self isFlipped]);
-  if (viewIsPrinting == nil)
+  if (viewIsPrinting == nil && viewIsRendering == nil)
     {
       [_window->_rectsBeingDrawn addObject: [NSValue valueWithRect: wrect]];
     }
@@ -2123,7 +2618,14 @@ static void autoresize(CGFloat oldContainerSize,
   /* Make sure we don't modify superview's gstate */
   DPSgsave(ctxt);
 
-  if (viewIsPrinting != nil)
+  if (viewIsRendering != nil)
+    {
+      [[self _matrixToWindow] concat];
+
+      /* Allow subclases to make other modifications */
+      [self setUpGState];
+    }
+  else if (viewIsPrinting != nil)
     {
       if (viewIsPrinting == self)
         {
@@ -2159,6 +2661,10 @@ static void autoresize(CGFloat oldContainerSize,
           _renew_gstate = NO;
           if (_allocate_gstate)
             {
+              if (_gstate == 0)
+                {
+                  _gstate = pooled_gstate(ctxt);
+                }
               if (_gstate)
                 {
                   GSReplaceGState(ctxt, _gstate);
@@ -2230,7 +2736,7 @@ static void autoresize(CGFloat oldContainerSize,
   NSDebugLLog(@"NSView_details", @"-unlockFocusNeedsFlush: %i for view %@\n",
 	      flush, self);
 
-  if (viewIsPrinting == nil)
+  if (viewIsPrinting == nil && viewIsRendering == nil)
     {
       NSAssert(_window != nil, NSInternalInconsistencyException);
       /* Check for deferred window */
@@ -2246,12 +2752,14 @@ static void autoresize(CGFloat oldContainerSize,
   if (!_allocate_gstate)
     _gstate = 0;
 
-  if (viewIsPrinting == nil)
+  if (viewIsPrinting == nil && viewIsRendering == nil)
     {
       NSRect        rect;
       if (flush && !_rFlags.ignores_backing)
         {
           rect = [[_window->_rectsBeingDrawn lastObject] rectValue];
+          GSAddRegionRect(_window->_rectsNeedingFlush,
+                          &_window->_rectsNeedingFlushCount, rect);
           _window->_rectNeedingFlush =
               NSUnionRect(_window->_rectNeedingFlush, rect);
           _window->_f.needs_flush = YES;
@@ -2259,7 +2767,7 @@ static void autoresize(CGFloat oldContainerSize,
       [_window->_rectsBeingDrawn removeLastObject];
     }
   [ctxt unlockFocusView: self needsFlush: YES ];
-  [NSGraphicsContext restoreGraphicsState];
+  GSPopCurrentContext();
 }
 
 /**
@@ -2289,7 +2797,7 @@ static void autoresize(CGFloat oldContainerSize,
   if (_allocate_gstate && _gstate &&
       _window && ([_window graphicsContext] != nil))
     {
-      GSUndefineGState([_window graphicsContext], _gstate);
+      pool_gstate([_window graphicsContext], _gstate);
     }
   _gstate = 0;
   _allocate_gstate = NO;
@@ -2368,6 +2876,8 @@ static void autoresize(CGFloat oldContainerSize,
 - (BOOL) canDraw
 {
   if (((viewIsPrinting != nil) && [self isDescendantOf: viewIsPrinting]) || 
+      ((viewIsRendering != nil) && [self isDescendantOf: viewIsRendering]
+       && ![self isHiddenOrHasHiddenAncestor]) ||
       ((_window != nil) && ([_window windowNumber] != 0) && 
        ![self isHiddenOrHasHiddenAncestor]))
     {
@@ -2408,58 +2918,436 @@ static void autoresize(CGFloat oldContainerSize,
  *
  */
 
-- (void) display
+/*
+ * The invalid area of a view is kept as up to MAX_INVALID_RECTS rects, and
+ * _invalidRect is their union.  A new rect is merged with one already
+ * there when their union is mostly covered by the two of them, so that
+ * neighbouring changes make one rect while two changes far apart stay
+ * separate.  When there is no room for another rect, the pair whose
+ * union adds least is merged.
+ */
+#define MAX_INVALID_RECTS GS_MAX_REGION_RECTS
+
+static inline CGFloat
+rect_area(NSRect r)
 {
-  [self displayRect: [self visibleRect]];
+  return NSIsEmptyRect(r) ? 0.0 : NSWidth(r) * NSHeight(r);
 }
 
-- (void) displayIfNeeded
+/* Returns how much of the union of a and b neither of them covers.  */
+static CGFloat
+merge_waste(NSRect a, NSRect b)
 {
-  if (_rFlags.needs_display == YES)
-    {
-      [self displayIfNeededInRect: [self visibleRect]];
-    }
+  return rect_area(NSUnionRect(a, b)) - rect_area(a) - rect_area(b)
+    + rect_area(NSIntersectionRect(a, b));
 }
 
-- (void) displayIfNeededIgnoringOpacity
+/* Adds r to the count rects, merging as above.  Returns NO if the rects
+   already covered r.  */
+static BOOL
+add_invalid_rect(NSRect *rects, NSUInteger *count, NSRect r)
 {
-  if (_rFlags.needs_display == YES)
+  NSUInteger n = *count;
+  NSUInteger i;
+
+  if (NSIsEmptyRect(r))
+    return NO;
+  for (i = 0; i < n; i++)
     {
-      [self displayIfNeededInRectIgnoringOpacity: [self visibleRect]];
+      if (NSContainsRect(rects[i], r))
+	return NO;
     }
-}
 
-- (void) displayIfNeededInRect: (NSRect)aRect
-{
-  if (_rFlags.needs_display == YES)
+  for (;;)
     {
-      if ([self isOpaque] == YES)
-        {
-          [self displayIfNeededInRectIgnoringOpacity: aRect];
-        }
-      else
-        {
-          NSView *firstOpaque = [self opaqueAncestor];
+      BOOL merged = NO;
 
-          aRect = [firstOpaque convertRect: aRect fromView: self];
-          [firstOpaque displayIfNeededInRectIgnoringOpacity: aRect];
-        }
+      for (i = 0; i < n; i++)
+	{
+	  if (NSContainsRect(r, rects[i])
+	      || merge_waste(r, rects[i])
+	      <= rect_area(NSUnionRect(r, rects[i])) / 4)
+	    {
+	      r = NSUnionRect(r, rects[i]);
+	      rects[i] = rects[--n];
+	      merged = YES;
+	      break;
+	    }
+	}
+      if (merged)
+	continue;
+      if (n < MAX_INVALID_RECTS)
+	break;
+
+      /* Full, so merge r into the rect it adds least to.  */
+      {
+	NSUInteger best = 0;
+	CGFloat least = merge_waste(r, rects[0]);
+
+	for (i = 1; i < n; i++)
+	  {
+	    CGFloat waste = merge_waste(r, rects[i]);
+
+	    if (waste < least)
+	      {
+		least = waste;
+		best = i;
+	      }
+	  }
+	r = NSUnionRect(r, rects[best]);
+	rects[best] = rects[--n];
+      }
     }
+
+  rects[n++] = r;
+  *count = n;
+  return YES;
 }
 
-- (void) displayIfNeededInRectIgnoringOpacity: (NSRect)aRect
+BOOL
+GSAddRegionRect(NSRect *rects, NSUInteger *count, NSRect r)
 {
-  if (_rFlags.needs_display == YES)
-    {
-      NSRect rect;
-        
-      /*
-       * Restrict the drawing of self onto the invalid rectangle.
-       */
-      rect = NSIntersectionRect(aRect, _invalidRect);
-      [self displayRectIgnoringOpacity: rect];
+  return add_invalid_rect(rects, count, r);
+}
 
-      /*
+static NSRect
+union_of_rects(const NSRect *rects, NSUInteger count)
+{
+  NSRect r = NSZeroRect;
+  NSUInteger i;
+
+  for (i = 0; i < count; i++)
+    r = NSUnionRect(r, rects[i]);
+  return r;
+}
+
+/*
+ * The rects -displayRectIgnoringOpacity:inContext: should draw when
+ * asked to draw their union.  They are handed over this way rather than
+ * as an argument so that subclasses overriding that method still see
+ * every display.
+ */
+static NSView *pendingView = nil;
+static NSRect pendingRects[MAX_INVALID_RECTS];
+static NSUInteger pendingCount = 0;
+
+/* The rects given to -drawRect: of the view being drawn, for
+   -getRectsBeingDrawn:count:, with the depth of the focus stack while
+   they apply.  */
+static NSView *drawingView = nil;
+static const NSRect *drawingRects = NULL;
+static NSUInteger drawingCount = 0;
+static NSUInteger drawingDepth = 0;
+
+/*
+ * A view which caches its display keeps what it and its subviews drew in
+ * an offscreen window, copied from the window it is in once all of its
+ * visible rect has been drawn.  Marking the view or any view inside it
+ * as needing display, or changing its coordinates, throws the copy away.
+ * Only opaque views which are at most translated from the window can use
+ * the copy, since everything they show was then drawn by them and the
+ * copy lines up with the window pixels.
+ */
+- (BOOL) _canUseDisplayCache
+{
+  return _rFlags.caches_display && !_is_rotated_or_scaled_from_base
+    && [self isOpaque];
+}
+
+- (void) _keepDisplayCache: (NSRect)visibleRect
+{
+  NSRect inBase = [self convertRect: visibleRect toView: nil];
+  NSCachedImageRep *cache;
+  NSView *cacheView;
+
+  if (NSIsEmptyRect(inBase) || NSEqualRects(inBase, NSIntegralRect(inBase)) == NO)
+    {
+      return;
+    }
+
+  cache = [[NSCachedImageRep alloc]
+            initWithWindow: nil
+                      rect: NSMakeRect(0, 0, NSWidth(inBase), NSHeight(inBase))];
+  cacheView = [[cache window] contentView];
+  [cacheView lockFocus];
+  NSCopyBits([_window gState], inBase, NSZeroPoint);
+  [cacheView unlockFocus];
+  ASSIGN(_displayCache, cache);
+  RELEASE(cache);
+  _displayCacheRect = visibleRect;
+}
+
+- (void) _drawDisplayCache: (NSRect)aRect inContext: (NSGraphicsContext *)context
+{
+  NSRect inBase = [self convertRect: aRect toView: nil];
+  NSRect cacheInBase = [self convertRect: _displayCacheRect toView: nil];
+  NSPoint destPoint = aRect.origin;
+
+  inBase.origin.x -= cacheInBase.origin.x;
+  inBase.origin.y -= cacheInBase.origin.y;
+  if ([self isFlipped])
+    {
+      destPoint.y += aRect.size.height;
+    }
+
+  [self _lockFocusInContext: context inRect: aRect];
+  NSCopyBits([[_displayCache window] gState], inBase, destPoint);
+  [self unlockFocusNeedsFlush: YES];
+}
+
+/*
+ * A view which has a copy of itself for a live resize draws the copy
+ * instead of itself.  A view which stretches its content draws only the
+ * copy, scaled to its visible rect.  Otherwise the copy stays where it
+ * was in the bounds and only the parts of aRect outside it are left to
+ * draw; those are returned in rects, and their union is returned.
+ */
+- (NSRect) _drawLiveResizeSnapshot: (NSRect)aRect
+                             rects: (NSRect *)rects
+                             count: (NSUInteger *)count
+                         inContext: (NSGraphicsContext *)context
+{
+  GSLiveResize *lr = _liveResize;
+  NSRect imageRect;
+  NSRect kept;
+  NSUInteger n;
+
+  if (lr->stretches)
+    {
+      imageRect = [self visibleRect];
+      kept = aRect;
+    }
+  else
+    {
+      imageRect = lr->snapshotRect;
+      kept = NSIntersectionRect(NSIntersectionRect(imageRect, _bounds), aRect);
+    }
+
+  if (NSIsEmptyRect(kept) == NO)
+    {
+      [self _lockFocusInContext: context inRect: kept];
+      if ([self isFlipped])
+        {
+          NSAffineTransform *flip = [NSAffineTransform transform];
+
+          [flip translateXBy: 0 yBy: NSMinY(imageRect) + NSMaxY(imageRect)];
+          [flip scaleXBy: 1 yBy: -1];
+          [flip concat];
+        }
+      [lr->snapshot drawInRect: imageRect];
+      [self unlockFocusNeedsFlush: YES];
+    }
+
+  if (lr->stretches)
+    {
+      *count = 0;
+      return NSZeroRect;
+    }
+  n = subtract_rect(aRect, kept, rects);
+  *count = n;
+  return union_of_rects(rects, n);
+}
+
+- (void) setCachesDisplay: (BOOL)flag
+{
+  _rFlags.caches_display = flag;
+  if (flag == NO)
+    {
+      DESTROY(_displayCache);
+    }
+}
+
+- (BOOL) cachesDisplay
+{
+  return _rFlags.caches_display;
+}
+
+/*
+ * A subview need not draw where opaque siblings in front of it, which
+ * are drawn after it, cover it.  Only siblings which are neither hidden
+ * nor rotated or scaled are taken to cover their frames, and only the
+ * first MAX_OCCLUDERS of them meeting the area are looked at.
+ */
+#define MAX_OCCLUDERS 8
+
+static NSUInteger occludedDisplayCount = 0;
+
++ (NSUInteger) _occludedDisplayCount
+{
+  return occludedDisplayCount;
+}
+
+/* Fills covers with the frames of the opaque subviews after index in
+   array which meet r, and returns how many there are.  */
+static NSUInteger
+occluding_frames(NSView **array, NSUInteger index, NSUInteger count,
+		 NSRect r, NSRect *covers)
+{
+  NSUInteger i, n = 0;
+
+  for (i = index + 1; i < count && n < MAX_OCCLUDERS; i++)
+    {
+      NSView *sibling = array[i];
+
+      if (sibling->_frameMatrix == nil && sibling->_is_hidden == NO
+	  && NSIntersectsRect(r, sibling->_frame) && [sibling isOpaque])
+	{
+	  covers[n++] = sibling->_frame;
+	}
+    }
+  return n;
+}
+
+/* Returns whether the count covers together contain all of r.  */
+static BOOL
+rect_is_covered(NSRect r, const NSRect *covers, NSUInteger count)
+{
+  NSUInteger i;
+
+  for (i = 0; i < count; i++)
+    {
+      NSRect c = covers[i];
+
+      if (NSContainsRect(c, r))
+	{
+	  return YES;
+	}
+      if (NSIntersectsRect(r, c))
+	{
+	  /* Check the parts of r outside c against the other covers.  */
+	  NSRect parts[4];
+	  CGFloat y0 = MAX(NSMinY(r), NSMinY(c));
+	  CGFloat y1 = MIN(NSMaxY(r), NSMaxY(c));
+	  NSUInteger j, n = 0;
+
+	  if (NSMinY(r) < NSMinY(c))
+	    parts[n++] = NSMakeRect(NSMinX(r), NSMinY(r),
+				    NSWidth(r), NSMinY(c) - NSMinY(r));
+	  if (NSMaxY(c) < NSMaxY(r))
+	    parts[n++] = NSMakeRect(NSMinX(r), NSMaxY(c),
+				    NSWidth(r), NSMaxY(r) - NSMaxY(c));
+	  if (NSMinX(r) < NSMinX(c))
+	    parts[n++] = NSMakeRect(NSMinX(r), y0,
+				    NSMinX(c) - NSMinX(r), y1 - y0);
+	  if (NSMaxX(c) < NSMaxX(r))
+	    parts[n++] = NSMakeRect(NSMaxX(c), y0,
+				    NSMaxX(r) - NSMaxX(c), y1 - y0);
+	  for (j = 0; j < n; j++)
+	    {
+	      if (!rect_is_covered(parts[j], covers + i + 1, count - i - 1))
+		{
+		  return NO;
+		}
+	    }
+	  return YES;
+	}
+    }
+  return NO;
+}
+
+/* Returns whether r, in the coordinates of the superview of array[index],
+   is hidden behind opaque siblings of array[index].  */
+static BOOL
+is_occluded(NSView **array, NSUInteger index, NSUInteger count, NSRect r)
+{
+  NSRect covers[MAX_OCCLUDERS];
+  NSUInteger n = occluding_frames(array, index, count, r, covers);
+
+  return n > 0 && rect_is_covered(r, covers, n);
+}
+
+/* Like is_occluded(), but counts the display skipped if r is hidden.  */
+static BOOL
+skip_occluded(NSView **array, NSUInteger index, NSUInteger count, NSRect r)
+{
+  if (is_occluded(array, index, count, r))
+    {
+      occludedDisplayCount++;
+      NSDebugLLog(@"NSViewOcclusion", @"Not drawing %@ in %@, covered",
+		  array[index], NSStringFromRect(r));
+      return YES;
+    }
+  return NO;
+}
+
+- (void) display
+{
+  [self displayRect: [self visibleRect]];
+}
+
+- (void) displayIfNeeded
+{
+  if (_rFlags.needs_display == YES)
+    {
+      [self displayIfNeededInRect: [self visibleRect]];
+    }
+}
+
+- (void) displayIfNeededIgnoringOpacity
+{
+  if (_rFlags.needs_display == YES)
+    {
+      [self displayIfNeededInRectIgnoringOpacity: [self visibleRect]];
+    }
+}
+
+- (void) displayIfNeededInRect: (NSRect)aRect
+{
+  if (_rFlags.needs_display == YES)
+    {
+      if ([self isOpaque] == YES)
+        {
+          [self displayIfNeededInRectIgnoringOpacity: aRect];
+        }
+      else
+        {
+          NSView *firstOpaque = [self opaqueAncestor];
+
+          aRect = [firstOpaque convertRect: aRect fromView: self];
+          [firstOpaque displayIfNeededInRectIgnoringOpacity: aRect];
+        }
+    }
+}
+
+- (void) displayIfNeededInRectIgnoringOpacity: (NSRect)aRect
+{
+  if (_rFlags.needs_display == YES)
+    {
+      NSRect rect;
+        
+      /*
+       * Restrict the drawing of self onto the invalid rectangles.
+       */
+      if (_invalidRectCount > 1)
+        {
+          NSRect rects[MAX_INVALID_RECTS];
+          NSUInteger i, n = 0;
+
+          for (i = 0; i < _invalidRectCount; i++)
+            {
+              NSRect isect = NSIntersectionRect(aRect, _invalidRects[i]);
+
+              if (NSIsEmptyRect(isect) == NO)
+                {
+                  rects[n++] = isect;
+                }
+            }
+          rect = union_of_rects(rects, n);
+          if (n > 1)
+            {
+              memcpy(pendingRects, rects, n * sizeof(NSRect));
+              pendingCount = n;
+              pendingView = self;
+            }
+        }
+      else
+        {
+          rect = NSIntersectionRect(aRect, _invalidRect);
+        }
+      [self displayRectIgnoringOpacity: rect];
+      pendingView = nil;
+
+      /*
        * If we still need display after displaying the invalid rectangle,
        * this means that some subviews still need to display. For opaque subviews
        * their invalid rectangle may even overlap the original aRect.
@@ -2467,19 +3355,37 @@ static void autoresize(CGFloat oldContainerSize,
        */ 
       if (_rFlags.needs_display == YES)
         {
-          NSEnumerator *enumerator = [_sub_views objectEnumerator];
-          NSView *subview;
+          NSUInteger count = [_sub_views count];
+          NSView *array[count];
+          NSUInteger i;
           BOOL subviewNeedsDisplay = NO;
          
-          while ((subview = [enumerator nextObject]) != nil)
+          [_sub_views getObjects: array];
+          for (i = 0; i < count; i++)
             {
+              NSView *subview = array[i];
+
               if (subview->_rFlags.needs_display)
                 {
                   NSRect subviewFrame = [subview _frameExtend];
                   NSRect isect;
               
                   isect = NSIntersectionRect(aRect, subviewFrame);
-                  if (NSIsEmptyRect(isect) == NO)
+                  if (NSIsEmptyRect(isect) == NO
+                      && skip_occluded(array, i, count, isect))
+                    {
+                      /*
+                       * A subview hidden behind its siblings altogether
+                       * has nothing to draw until they move, which marks
+                       * the area it is in as needing display.
+                       */
+                      if (is_occluded(array, i, count,
+                                      NSIntersectionRect(subviewFrame, _bounds)))
+                        {
+                          [subview setNeedsDisplay: NO];
+                        }
+                    }
+                  else if (NSIsEmptyRect(isect) == NO)
                     {
                       isect = [subview convertRect: isect fromView: self];
                       [subview displayIfNeededInRectIgnoringOpacity: isect];
@@ -2534,9 +3440,26 @@ static void autoresize(CGFloat oldContainerSize,
   NSGraphicsContext *wContext;
   BOOL flush = NO;
   BOOL subviewNeedsDisplay = NO;
+  NSRect drawRects[MAX_INVALID_RECTS];
+  NSUInteger drawCount = 0;
+
+  if (pendingView == self)
+    {
+      memcpy(drawRects, pendingRects, pendingCount * sizeof(NSRect));
+      drawCount = pendingCount;
+      pendingView = nil;
+    }
+
+  GS_PROBE1(view_display_entry, self);
+
+  if (_rFlags.needs_layout || _rFlags.subtree_needs_layout)
+    {
+      [self layoutSubtreeIfNeeded];
+    }
 
   if (![self canDraw])
     {
+      GS_PROBE1(view_display_return, self);
       return;
     }
 
@@ -2548,35 +3471,136 @@ static void autoresize(CGFloat oldContainerSize,
 
   if (context == wContext)
     {
-      NSRect neededRect;
       NSRect visibleRect = [self visibleRect];
+      NSUInteger i, j, n;
 
       flush = YES;
       [_window disableFlushWindow];
       aRect = NSIntersectionRect(aRect, visibleRect);
-      neededRect = NSIntersectionRect(_invalidRect, visibleRect);
+      if (drawCount > 0)
+        {
+          for (i = n = 0; i < drawCount; i++)
+            {
+              NSRect isect = NSIntersectionRect(drawRects[i], aRect);
+
+              if (NSIsEmptyRect(isect) == NO)
+                {
+                  drawRects[n++] = isect;
+                }
+            }
+          drawCount = n;
+          aRect = union_of_rects(drawRects, drawCount);
+        }
   
       /*
-       * If the rect we are going to display contains the _invalidRect
-       * then we can empty _invalidRect. Do this before the drawing, as drawRect: 
-       * may change this value.
-       * FIXME: If the drawn rectangle cuts of a complete part of the _invalidRect,
-       * we should try to reduce this.
+       * Drop the invalid rectangles whose visible part is about to be
+       * drawn. Do this before the drawing, as drawRect: may invalidate
+       * parts of the view again.
        */
-      if (NSEqualRects(aRect, NSUnionRect(neededRect, aRect)) == YES)
+      for (i = n = 0; i < _invalidRectCount; i++)
+        {
+          NSRect needed = NSIntersectionRect(_invalidRects[i], visibleRect);
+          BOOL drawn = NSIsEmptyRect(needed);
+
+          if (drawCount == 0)
+            {
+              drawn = drawn || NSContainsRect(aRect, needed);
+            }
+          for (j = 0; j < drawCount && !drawn; j++)
+            {
+              drawn = NSContainsRect(drawRects[j], needed);
+            }
+          if (!drawn)
+            {
+              _invalidRects[n++] = _invalidRects[i];
+            }
+        }
+      _invalidRectCount = n;
+      _invalidRect = union_of_rects(_invalidRects, n);
+      if (n == 0)
         {
-          _invalidRect = NSZeroRect;
           _rFlags.needs_display = NO;
         }
+
+      /*
+       * Nothing in the view has changed since the copy was kept, so the
+       * copy is what drawing would give.
+       */
+      if (_displayCache != nil && NSIsEmptyRect(aRect) == NO
+          && NSEqualRects(_displayCacheRect, visibleRect)
+          && [self _canUseDisplayCache])
+        {
+          [self _drawDisplayCache: aRect inContext: context];
+          [_window enableFlushWindow];
+          [_window flushWindowIfNeeded];
+          GS_PROBE1(view_display_return, self);
+          return;
+        }
+
+      if (_liveResize != NULL && ((GSLiveResize*)_liveResize)->snapshot != nil
+          && NSIsEmptyRect(aRect) == NO)
+        {
+          aRect = [self _drawLiveResizeSnapshot: aRect
+                                          rects: drawRects
+                                          count: &drawCount
+                                      inContext: context];
+          if (NSIsEmptyRect(aRect))
+            {
+              [_window enableFlushWindow];
+              [_window flushWindowIfNeeded];
+              GS_PROBE1(view_display_return, self);
+              return;
+            }
+        }
     }
   
   if (NSIsEmptyRect(aRect) == NO)
     {
+      NSView *oldView = drawingView;
+      const NSRect *oldRects = drawingRects;
+      NSUInteger oldCount = drawingCount;
+      NSUInteger oldDepth = drawingDepth;
+
       /*
        * Now we draw this view.
        */
       [self _lockFocusInContext: context inRect: aRect];
-      [self drawRect: aRect];
+      if (drawCount > 1)
+        {
+          NSRectClipList(drawRects, drawCount);
+          drawingView = self;
+          drawingRects = drawRects;
+          drawingCount = drawCount;
+          drawingDepth = [_window->_rectsBeingDrawn count];
+        }
+      NS_DURING
+        {
+          if (_window != nil && _window->_displayTimings != NULL)
+            {
+              NSTimeInterval start = [NSDate timeIntervalSinceReferenceDate];
+
+              [self drawRect: aRect];
+              GSWindowRecordViewDrawing(_window, self,
+                [NSDate timeIntervalSinceReferenceDate] - start);
+            }
+          else
+            {
+              [self drawRect: aRect];
+            }
+        }
+      NS_HANDLER
+        {
+          drawingView = oldView;
+          drawingRects = oldRects;
+          drawingCount = oldCount;
+          drawingDepth = oldDepth;
+          [localException raise];
+        }
+      NS_ENDHANDLER
+      drawingView = oldView;
+      drawingRects = oldRects;
+      drawingCount = oldCount;
+      drawingDepth = oldDepth;
       [self unlockFocusNeedsFlush: flush];
     }
 
@@ -2605,11 +3629,45 @@ static void autoresize(CGFloat oldContainerSize,
                * Having drawn ourself into the rect, we must make sure that
                * subviews overlapping the area are redrawn.
                */
-              isect = NSIntersectionRect(aRect, subviewFrame);
-              if (NSIsEmptyRect(isect) == NO)
+              if (drawCount > 1)
+                {
+                  NSRect rects[MAX_INVALID_RECTS];
+                  NSUInteger j, n = 0;
+
+                  for (j = 0; j < drawCount; j++)
+                    {
+                      isect = NSIntersectionRect(drawRects[j], subviewFrame);
+                      if (NSIsEmptyRect(isect) == NO
+                          && !skip_occluded(array, i, count, isect))
+                        {
+                          rects[n++] = isect;
+                        }
+                    }
+                  if (n > 0)
+                    {
+                      [subview convertRects: rects count: n fromView: self];
+                      if (n > 1)
+                        {
+                          memcpy(pendingRects, rects, n * sizeof(NSRect));
+                          pendingCount = n;
+                          pendingView = subview;
+                        }
+                      [subview displayRectIgnoringOpacity:
+                                 union_of_rects(rects, n)
+                                                inContext: context];
+                      pendingView = nil;
+                    }
+                }
+              else
                 {
-                  isect = [subview convertRect: isect fromView: self];
-                  [subview displayRectIgnoringOpacity: isect inContext: context];
+                  isect = NSIntersectionRect(aRect, subviewFrame);
+                  if (NSIsEmptyRect(isect) == NO
+                      && !skip_occluded(array, i, count, isect))
+                    {
+                      isect = [subview convertRect: isect fromView: self];
+                      [subview displayRectIgnoringOpacity: isect
+                                                inContext: context];
+                    }
                 }
               /*
                * Is there still something to draw in the subview?
@@ -2636,9 +3694,17 @@ static void autoresize(CGFloat oldContainerSize,
            */
           _rFlags.needs_display = YES;
         }
+      else if (_rFlags.caches_display && _displayCache == nil
+               && _rFlags.needs_display == NO && drawCount <= 1
+               && NSEqualRects(aRect, [self visibleRect])
+               && [self _canUseDisplayCache])
+        {
+          [self _keepDisplayCache: aRect];
+        }
       [_window enableFlushWindow];
       [_window flushWindowIfNeeded];
     }
+  GS_PROBE1(view_display_return, self);
 }
 
 /**
@@ -2696,9 +3762,22 @@ static void autoresize(CGFloat oldContainerSize,
 
 - (void) getRectsBeingDrawn: (const NSRect **)rects count: (NSInteger *)count
 {
-  // FIXME
   static NSRect rect;
 
+  if (drawingView == self
+      && drawingDepth == [_window->_rectsBeingDrawn count])
+    {
+      if (rects != NULL)
+        {
+          *rects = drawingRects;
+        }
+      if (count != NULL)
+        {
+          *count = drawingCount;
+        }
+      return;
+    }
+
   rect = [[_window->_rectsBeingDrawn lastObject] rectValue];
   rect = [self convertRect: rect fromView: nil];
 
@@ -2713,10 +3792,33 @@ static void autoresize(CGFloat oldContainerSize,
     }
 }
 
+/**
+ * Returns a bitmap suitable for -cacheDisplayInRect:toBitmapImageRep:.
+ * For a view in a window, the bitmap holds what the window shows in
+ * rect.  For a view without a window, it is a new transparent bitmap
+ * of the size of rect.
+ */
 - (NSBitmapImageRep *) bitmapImageRepForCachingDisplayInRect: (NSRect)rect
 {
   NSBitmapImageRep *bitmap;
 
+  if (_window == nil)
+    {
+      bitmap = [[NSBitmapImageRep alloc]
+        initWithBitmapDataPlanes: NULL
+                      pixelsWide: ceil(NSWidth(rect))
+                      pixelsHigh: ceil(NSHeight(rect))
+                   bitsPerSample: 8
+                 samplesPerPixel: 4
+                        hasAlpha: YES
+                        isPlanar: NO
+                  colorSpaceName: NSCalibratedRGBColorSpace
+                     bytesPerRow: 0
+                    bitsPerPixel: 0];
+      memset([bitmap bitmapData], 0, [bitmap bytesPerRow] * [bitmap pixelsHigh]);
+      return AUTORELEASE(bitmap);
+    }
+
   [self lockFocus];
   bitmap = [[NSBitmapImageRep alloc] initWithFocusedViewRect: rect];
   [self unlockFocus];
@@ -2724,12 +3826,70 @@ static void autoresize(CGFloat oldContainerSize,
   return AUTORELEASE(bitmap);
 }
 
+/* Draws rect of the receiver, which is in a detached view hierarchy,
+   into bitmap, using a graphics context of its own in the current
+   thread.  */
+- (void) _renderRect: (NSRect)rect toBitmapImageRep: (NSBitmapImageRep *)bitmap
+{
+  NSGraphicsContext *ctxt;
+  NSView *oldRoot = viewIsRendering;
+  NSView *top = self;
+  NSRect base;
+
+  while (top->_super_view != nil)
+    {
+      top = top->_super_view;
+    }
+  ctxt = [NSGraphicsContext graphicsContextWithBitmapImageRep: bitmap];
+
+  viewIsRendering = self;
+  [top _invalidateCoordinates];
+  GSPushCurrentContext(ctxt);
+  NS_DURING
+    {
+      base = convert_rect_using_matrices(rect, [self _matrixToWindow],
+                                         [NSAffineTransform transform]);
+      DPSgsave(ctxt);
+      DPStranslate(ctxt, -NSMinX(base), -NSMinY(base));
+      [self displayRectIgnoringOpacity: rect inContext: ctxt];
+      DPSgrestore(ctxt);
+      [ctxt flushGraphics];
+    }
+  NS_HANDLER
+    {
+      GSPopCurrentContext();
+      [top _invalidateCoordinates];
+      viewIsRendering = oldRoot;
+      [localException raise];
+    }
+  NS_ENDHANDLER
+  GSPopCurrentContext();
+  /* The coordinates are only valid while drawing */
+  [top _invalidateCoordinates];
+  viewIsRendering = oldRoot;
+}
+
+/**
+ * Draws rect of the receiver and its subviews into bitmap.
+ * <br />
+ * A view that is not in a window, and is not a subview of another
+ * view, is drawn with a graphics context for bitmap that belongs to
+ * the current thread.  So independent view hierarchies may be drawn
+ * in worker threads while the AppKit thread goes on with other work,
+ * as long as each hierarchy is only used by one thread at a time.
+ */
 - (void) cacheDisplayInRect: (NSRect)rect 
            toBitmapImageRep: (NSBitmapImageRep *)bitmap
 {
   NSDictionary *dict;
   NSData *imageData;
 
+  if (_window == nil)
+    {
+      [self _renderRect: rect toBitmapImageRep: bitmap];
+      return;
+    }
+
   [self lockFocus];
   dict = [GSCurrentContext() GSReadRect: rect];
   [self unlockFocus];
@@ -2743,8 +3903,6 @@ static void autoresize(CGFloat oldContainerSize,
 }
 
 
-extern NSThread *GSAppKitThread; /* TODO */
-
 /*
 For -setNeedsDisplay*, the real work is done in the ..._real methods, and
 the actual public method simply calls it, but makes sure that the call is
@@ -2763,6 +3921,7 @@ in the main thread.
     {
       _rFlags.needs_display = NO;
       _invalidRect = NSZeroRect;
+      _invalidRectCount = 0;
     }
 }
 
@@ -2797,34 +3956,50 @@ in the main thread.
   NSRect invalidRect = [v rectValue];
   NSView *currentView = _super_view;
 
+  DESTROY(_displayCache);
+  if (_rFlags.keeps_overdraw)
+    {
+      [(NSClipView*)self _discardOverdraw];
+    }
+
   /*
-   *	Limit to bounds, combine with old _invalidRect, and then check to see
-   *	if the result is the same as the old _invalidRect - if it isn't then
-   *	set the new _invalidRect.
+   *	Limit to bounds and add to the invalid rectangles, unless they
+   *	already cover it.
    */
   invalidRect = NSIntersectionRect(invalidRect, _bounds);
-  invalidRect = NSUnionRect(_invalidRect, invalidRect);
-  if (NSEqualRects(invalidRect, _invalidRect) == NO)
+  if (NSIsEmptyRect(invalidRect) == NO)
     {
       NSView	*firstOpaque = [self opaqueAncestor];
 
-      _rFlags.needs_display = YES;
-      _invalidRect = invalidRect;
       if (firstOpaque == self)
         {
 	  /**
-	   * Enlarge (if necessary) _invalidRect so it lies on integral device pixels 
+	   * Enlarge (if necessary) the rect so it lies on integral device pixels 
 	   */
-	  const NSRect inBase =  [self convertRectToBase: _invalidRect];
+	  const NSRect inBase =  [self convertRectToBase: invalidRect];
 	  const NSRect inBaseRounded = NSIntegralRect(inBase);
-	  _invalidRect = [self convertRectFromBase: inBaseRounded];
+	  invalidRect = [self convertRectFromBase: inBaseRounded];
+        }
 
-          [_window setViewsNeedDisplay: YES];
+      if (_invalidRects == NULL)
+        {
+          _invalidRects = NSZoneMalloc(NSDefaultMallocZone(),
+                                       MAX_INVALID_RECTS * sizeof(NSRect));
         }
-      else
+      if (add_invalid_rect(_invalidRects, &_invalidRectCount, invalidRect))
         {
-          invalidRect = [firstOpaque convertRect: _invalidRect fromView: self];
-          [firstOpaque setNeedsDisplayInRect: invalidRect];
+          _rFlags.needs_display = YES;
+          _invalidRect = union_of_rects(_invalidRects, _invalidRectCount);
+          if (firstOpaque == self)
+            {
+              [_window setViewsNeedDisplay: YES];
+            }
+          else
+            {
+              invalidRect = [firstOpaque convertRect: invalidRect
+                                            fromView: self];
+              [firstOpaque setNeedsDisplayInRect: invalidRect];
+            }
         }
     }
 
@@ -2836,6 +4011,11 @@ in the main thread.
   while (currentView)
     {
       currentView->_rFlags.needs_display = YES;
+      DESTROY(currentView->_displayCache);
+      if (currentView->_rFlags.keeps_overdraw)
+        {
+          [(NSClipView*)currentView _discardOverdraw];
+        }
       currentView = currentView->_super_view;
     }
   // Also mark the window, as this may not happen above
@@ -2911,6 +4091,7 @@ in the main thread.
       return;
 
   _is_hidden = flag;
+  invalidate_tracking_rects(self);
 
   if (_is_hidden)
     {
@@ -2975,21 +4156,100 @@ in the main thread.
 /*
  * Live resize support
  */
+
+/* Keeps a copy of what view shows, if it wants to be drawn from one
+   during the live resize.  Views inside a view which stretches its copy
+   are not drawn at all, so they need none.  */
+static void
+take_live_resize_snapshot(NSView *view, GSLiveResize *lr)
+{
+  BOOL stretches = [view stretchesContentDuringLiveResize];
+  NSView *ancestor;
+  NSRect visibleRect;
+
+  if (stretches == NO && ([view preservesContentDuringLiveResize] == NO
+    || [view->_window preservesContentDuringLiveResize] == NO))
+    {
+      return;
+    }
+  if ([view canDraw] == NO || view->_is_rotated_or_scaled_from_base)
+    {
+      return;
+    }
+  for (ancestor = view->_super_view; ancestor != nil;
+       ancestor = ancestor->_super_view)
+    {
+      if (ancestor->_liveResize != NULL
+        && ((GSLiveResize*)ancestor->_liveResize)->stretches)
+        {
+          return;
+        }
+    }
+
+  visibleRect = [view visibleRect];
+  if (NSIsEmptyRect(visibleRect))
+    {
+      return;
+    }
+  [view lockFocus];
+  lr->snapshot = [[NSBitmapImageRep alloc]
+                   initWithFocusedViewRect: visibleRect];
+  [view unlockFocus];
+  lr->snapshotRect = visibleRect;
+  lr->stretches = (lr->snapshot != nil && stretches);
+}
+
 - (BOOL) inLiveResize
 {
   return _in_live_resize;
 }
 
+/**
+ * Sent by the window to all its views before the user starts resizing
+ * it.  Subclasses which override this must call the super class
+ * implementation.
+ */
 - (void) viewWillStartLiveResize
 {
-  // FIXME
-  _in_live_resize = YES; 
+  GSLiveResize *lr;
+
+  _in_live_resize = YES;
+  if (_liveResize != NULL)
+    {
+      return;
+    }
+  lr = NSZoneCalloc(NSDefaultMallocZone(), 1, sizeof(GSLiveResize));
+  lr->frameSize = _frame.size;
+  lr->bounds = _bounds;
+  _liveResize = lr;
+  take_live_resize_snapshot(self, lr);
 }
 
+/**
+ * Sent by the window to all its views once the user has finished
+ * resizing it.  A view which was drawn from a copy during the resize is
+ * laid out and marked as needing display.  Subclasses which override
+ * this must call the super class implementation.
+ */
 - (void) viewDidEndLiveResize
 {
-  // FIXME
-  _in_live_resize = NO; 
+  GSLiveResize *lr = _liveResize;
+
+  _in_live_resize = NO;
+  if (lr == NULL)
+    {
+      return;
+    }
+  _liveResize = NULL;
+  if (lr->stretches)
+    {
+      [self resizeSubviewsWithOldSize: lr->frameSize];
+    }
+  if (lr->snapshot != nil)
+    {
+      [self setNeedsDisplay: YES];
+    }
+  free_live_resize(lr);
 }
 
 - (BOOL) preservesContentDuringLiveResize
@@ -2997,19 +4257,48 @@ in the main thread.
   return NO;
 }
 
+- (BOOL) stretchesContentDuringLiveResize
+{
+  return NO;
+}
+
+/**
+ * Returns the parts of the bounds which were not in the bounds at the
+ * start of the live resize, if the receiver preserves its content during
+ * live resize.  Otherwise returns the bounds.
+ */
 - (void) getRectsExposedDuringLiveResize: (NSRect[4])exposedRects count: (NSInteger *)count
 {
-  // FIXME
+  NSUInteger n;
+
+  if (_liveResize == NULL || [self preservesContentDuringLiveResize] == NO)
+    {
+      exposedRects[0] = _bounds;
+      n = 1;
+    }
+  else
+    {
+      n = subtract_rect(_bounds, ((GSLiveResize*)_liveResize)->bounds,
+                        exposedRects);
+    }
   if (count != NULL)
     {
-      *count = 1;
+      *count = n;
     }
-  exposedRects[0] = _bounds;
 }
 
+/**
+ * Returns the part of the bounds which was in the bounds at the start of
+ * the live resize, if the receiver preserves its content during live
+ * resize.  Otherwise returns an empty rect.
+ */
 - (NSRect) rectPreservedDuringLiveResize
 {
-  return NSZeroRect;
+  if (_liveResize == NULL || [self preservesContentDuringLiveResize] == NO)
+    {
+      return NSZeroRect;
+    }
+  return NSIntersectionRect(_bounds, ((GSLiveResize*)_liveResize)->bounds);
 }
 
 /*
@@ -3198,6 +4487,7 @@ Returns YES iff any scrolling was done.
       RELEASE(m);
       _rFlags.has_currects = 1;
       _rFlags.valid_rects = 1;
+      invalidate_tracking_rects(self);
     }
 }
 
@@ -3235,6 +4525,7 @@ Returns YES iff any scrolling was done.
 	  [_cursor_rects removeAllObjects];
 	}
       _rFlags.has_currects = 0;
+      invalidate_tracking_rects(self);
     }
 }
 
@@ -3258,6 +4549,7 @@ Returns YES iff any scrolling was done.
 	    }
 	  [o invalidate];
 	  [_cursor_rects removeObject: o];
+	  invalidate_tracking_rects(self);
 	  if ([_cursor_rects count] == 0)
 	    {
 	      _rFlags.has_currects = 0;
@@ -3428,7 +4720,31 @@ static NSView* findByTag(NSView *view, NSInteger aTag, NSUInteger *level)
       NSUInteger count;
 
       count = [_sub_views count];
-      if (count > 0)
+      if (count >= SUBVIEW_INDEX_THRESHOLD
+        && [self methodForSelector: mouseInRectSel] == mouseInRectImp)
+        {
+          GSSubviewIndex *idx = _subviewIndex;
+          GSGridCell *cell;
+          NSUInteger ia, ib, i;
+
+          if (idx == NULL || idx->viewCount != count)
+            {
+              invalidate_subview_index(self);
+              _subviewIndex = idx = build_subview_index(self);
+            }
+          cell = GSGridIndexCellAtPoint(idx->grid, p);
+          ia = cell->count;
+          ib = idx->grid->always.count;
+          while ((i = GSGridIndexNext(cell, &ia, &idx->grid->always, &ib))
+            != NSNotFound)
+            {
+              v = [idx->views[i] hitTest: p];
+              /* Stop if the subviews were changed under us.  */
+              if (v || _subviewIndex != idx)
+                break;
+            }
+        }
+      else if (count > 0)
         {
           NSView *array[count];
 
@@ -3498,6 +4814,7 @@ static NSView* findByTag(NSView *view, NSInteger aTag, NSUInteger *level)
 	{
 	  [m invalidate];
 	  [_tracking_rects removeObjectAtIndex: i];
+	  invalidate_tracking_rects(self);
 	  if ([_tracking_rects count] == 0)
 	    {
 	      _rFlags.has_trkrects = 0;
@@ -3539,6 +4856,7 @@ static NSView* findByTag(NSView *view, NSInteger aTag, NSUInteger *level)
   [_tracking_rects addObject: m];
   RELEASE(m);
   _rFlags.has_trkrects = 1;
+  invalidate_tracking_rects(self);
   return t;
 }
 
@@ -4165,6 +5483,30 @@ static NSView* findByTag(NSView *view, NSInteger aTag, NSUInteger *level)
   return NO;
 }
 
+/**
+ * Returns YES if the pages of the receiver may be drawn on several
+ * threads at once, when the print operation is allowed to spawn
+ * threads.  Views which can't draw safely outside the main thread, or
+ * which keep state between pages, should override this to return NO.
+ */
+- (BOOL) canPrintPagesConcurrently
+{
+  return YES;
+}
+
+/**
+ * Returns a number which changes whenever the way the receiver is split
+ * into pages may have changed, other than through a change of its size.
+ * Print operations reuse the pages they worked out for the receiver
+ * while the number stays the same.  The default is NSNotFound, meaning
+ * the receiver can't tell, so its pages are worked out afresh each time
+ * it is printed.
+ */
+- (NSUInteger) pageLayoutGeneration
+{
+  return NSNotFound;
+}
+
 - (NSPoint) locationOfPrintRect: (NSRect)aRect
 {
   int pages;
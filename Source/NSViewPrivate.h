@@ -28,10 +28,60 @@
 #define _GNUstep_H_NSViewPrivate
 
 #import "AppKit/NSView.h"
+#import "AppKit/NSClipView.h"
 
 @interface NSView (KeyViewLoop)
 - (void) _setUpKeyViewLoopWithNextKeyView: (NSView *)nextKeyView;
 - (void) _recursiveSetUpKeyViewLoopWithNextKeyView: (NSView *)nextKeyView;
 @end
 
+@interface NSView (Occlusion)
+/* Returns the number of times a subview was not drawn because opaque
+   siblings in front of it covered the area to draw.  For debugging.  */
++ (NSUInteger) _occludedDisplayCount;
+@end
+
+/* Storage class for variables with a separate value in each thread,
+   where the compiler supports them.  */
+#if defined(__GNUC__) && !defined(GS_NO_THREAD_LOCAL)
+#define GS_HAVE_THREAD_LOCAL 1
+#define GS_THREAD_LOCAL __thread
+#else
+#define GS_THREAD_LOCAL
+#endif
+
+/* The most rects kept for the invalid area of a view or the area of a
+   window that needs flushing.  */
+#define GS_MAX_REGION_RECTS 8
+
+/* Adds r to the count rects of such an area, merging it with the rects
+   already there when they are close or there is no room.  Returns NO if
+   the rects already covered r.  */
+extern BOOL GSAddRegionRect(NSRect *rects, NSUInteger *count, NSRect r);
+
+/* Records that view took seconds in -drawRect: for the display timings
+   of window.  Only called when window->_displayTimings is set.  */
+extern void GSWindowRecordViewDrawing(NSWindow *window, NSView *view,
+                                      NSTimeInterval seconds);
+
+/* Make ctxt the current context and make the previous one current
+   again, without saving and restoring the graphics state of either.
+   For focus locking, which saves the gstate of ctxt itself.  */
+extern void GSPushCurrentContext(NSGraphicsContext *ctxt);
+extern void GSPopCurrentContext(void);
+
+@interface NSClipView (Overdraw)
+/* Throws away what the clip view kept of its document view, unless the
+   clip view is scrolling.  Called when the clip view or a view inside it
+   is marked as needing display.  */
+- (void) _discardOverdraw;
+@end
+
+@interface NSView (DeferredLayout)
+/* Returns the number of times a frame change did not autoresize the
+   subviews of a view because they were going to be autoresized anyway
+   by the next layout pass.  For debugging.  */
++ (NSUInteger) _savedAutoresizeCount;
+@end
+
 #endif // _GNUstep_H_NSViewPrivate
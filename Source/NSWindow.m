@@ -42,6 +42,7 @@
 #import <Foundation/NSAutoreleasePool.h>
 #import <Foundation/NSString.h>
 #import <Foundation/NSCoder.h>
+#import <Foundation/NSDate.h>
 #import <Foundation/NSArray.h>
 #import <Foundation/NSEnumerator.h>
 #import <Foundation/NSGeometry.h>
@@ -49,6 +50,7 @@
 #import <Foundation/NSValue.h>
 #import <Foundation/NSException.h>
 #import <Foundation/NSSet.h>
+#import <Foundation/NSTimer.h>
 #import <Foundation/NSLock.h>
 #import <Foundation/NSUserDefaults.h>
 #import <Foundation/NSUndoManager.h>
@@ -86,6 +88,8 @@
 #import "GNUstepGUI/GSWindowDecorationView.h"
 #import "GSBindingHelpers.h"
 #import "GSGuiPrivate.h"
+#import "GSTraceProbes.h"
+#import "GSGridIndex.h"
 #import "GSToolTips.h"
 #import "GSIconManager.h"
 #import "NSToolbarFrameworkPrivate.h"
@@ -164,6 +168,10 @@ static GSWindowAnimationDelegate *animationDelegate;
 + (GSToolTips*) _toolTipVisible;
 
 - (void) _lossOfKeyOrMainWindow;
+- (BOOL) _needsAutodisplay;
+- (void) _handleAutodisplay;
+- (void) _checkTrackingRectanglesForEvent: (NSEvent*)theEvent;
+- (void) _checkCursorRectanglesForEvent: (NSEvent*)theEvent;
 - (NSView *) _windowView; 
 - (NSScreen *) _screenForFrame: (NSRect)frame;
 @end
@@ -181,23 +189,242 @@ static GSWindowAnimationDelegate *animationDelegate;
 }
 
 /* Window autodisplay machinery. */
+- (BOOL) _needsAutodisplay
+{
+  return _f.is_autodisplay
+    && (_f.views_need_display || _f.views_need_layout);
+}
+
 - (void) _handleAutodisplay
 {
+  if (_f.views_need_layout)
+    {
+      _f.views_need_layout = NO;
+      [_wv layoutSubtreeIfNeeded];
+    }
   if (_f.is_autodisplay && _f.views_need_display)
     {
+      NSTimeInterval start = [NSDate timeIntervalSinceReferenceDate];
+
       [self disableFlushWindow];
       [self displayIfNeeded];
       [self enableFlushWindow];
       [self flushWindowIfNeeded];
+      _autodisplayCount++;
+      _autodisplayTime = start;
+      _autodisplayDuration = [NSDate timeIntervalSinceReferenceDate] - start;
     }
 }
 
 static NSArray *modes = nil;
 
+/*
+Display timings.  When recording is on, each window keeps how long its
+-displayIfNeeded and -flushWindow calls took, how many views it drew per
+frame, and the GS_SLOW_VIEW_COUNT views whose -drawRect: took longest.
+Views are matched by address only, so a view allocated where a freed
+one was counts as the same view.  Recording starts with the
+GSRecordDisplayTimings default or +setRecordsDisplayTimings:.
+*/
+#define GS_SLOW_VIEW_COUNT 10
+
+typedef struct {
+  NSView *view;                 /* Not retained.  */
+  NSString *name;
+  NSUInteger draws;
+  NSTimeInterval total;
+  NSTimeInterval slowest;
+} GSViewTiming;
+
+typedef struct {
+  NSUInteger frames;
+  NSTimeInterval lastDisplay;
+  NSTimeInterval totalDisplay;
+  NSTimeInterval slowestDisplay;
+  NSUInteger flushes;
+  NSTimeInterval lastFlush;
+  NSTimeInterval totalFlush;
+  NSTimeInterval slowestFlush;
+  NSUInteger viewsDrawn;        /* By the current or last frame.  */
+  NSUInteger totalViewsDrawn;
+  NSUInteger viewCount;
+  GSViewTiming views[GS_SLOW_VIEW_COUNT];
+} GSDisplayTimings;
+
+/* The input events waiting for the next flush of a window, for the input
+   latency histograms of NSApplication.  Events arriving once the list is
+   full are not measured.  */
+#define GS_INPUT_TAG_COUNT 16
+
+typedef struct {
+  NSUInteger count;
+  NSEventType types[GS_INPUT_TAG_COUNT];
+  NSTimeInterval arrivals[GS_INPUT_TAG_COUNT];
+} GSInputLatencyTags;
+
+void
+GSWindowTagInputEvent(NSWindow *window, NSEventType type,
+                      NSTimeInterval arrival)
+{
+  GSInputLatencyTags *tags = window->_inputLatencyTags;
+
+  if (tags == NULL)
+    {
+      tags = NSZoneCalloc(NSDefaultMallocZone(), 1,
+                          sizeof(GSInputLatencyTags));
+      window->_inputLatencyTags = tags;
+    }
+  if (tags->count < GS_INPUT_TAG_COUNT)
+    {
+      tags->types[tags->count] = type;
+      tags->arrivals[tags->count] = arrival;
+      tags->count++;
+    }
+}
+
+/* Called when the window has been flushed to the screen.  */
+static void
+flush_input_latency_tags(GSInputLatencyTags *tags)
+{
+  NSTimeInterval now = [NSDate timeIntervalSinceReferenceDate];
+  NSUInteger i;
+
+  for (i = 0; i < tags->count; i++)
+    {
+      GSRecordInputLatency(tags->types[i], now - tags->arrivals[i]);
+    }
+  tags->count = 0;
+}
+
+static int recordsDisplayTimings = -1;
+
+static BOOL
+records_display_timings(void)
+{
+  if (recordsDisplayTimings < 0)
+    {
+      recordsDisplayTimings = [[NSUserDefaults standardUserDefaults]
+                                boolForKey: @"GSRecordDisplayTimings"];
+    }
+  return recordsDisplayTimings;
+}
+
+static void
+free_display_timings(GSDisplayTimings *t)
+{
+  NSUInteger i;
+
+  for (i = 0; i < t->viewCount; i++)
+    {
+      RELEASE(t->views[i].name);
+    }
+  t->viewCount = 0;
+}
+
+void
+GSWindowRecordViewDrawing(NSWindow *window, NSView *view,
+                          NSTimeInterval seconds)
+{
+  GSDisplayTimings *t = window->_displayTimings;
+  GSViewTiming *v = NULL;
+  NSUInteger i;
+
+  t->viewsDrawn++;
+  for (i = 0; i < t->viewCount; i++)
+    {
+      if (t->views[i].view == view)
+        {
+          v = &t->views[i];
+          break;
+        }
+    }
+  if (v == NULL)
+    {
+      if (t->viewCount < GS_SLOW_VIEW_COUNT)
+        {
+          v = &t->views[t->viewCount++];
+        }
+      else
+        {
+          /* Replace the view whose slowest draw is the quickest, if this
+             draw was slower.  */
+          v = &t->views[0];
+          for (i = 1; i < t->viewCount; i++)
+            {
+              if (t->views[i].slowest < v->slowest)
+                v = &t->views[i];
+            }
+          if (v->slowest >= seconds)
+            return;
+          RELEASE(v->name);
+        }
+      v->view = view;
+      v->name = [[NSString alloc] initWithFormat: @"%@ %p",
+                                  NSStringFromClass([view class]), view];
+      v->draws = 0;
+      v->total = 0;
+      v->slowest = 0;
+    }
+  v->draws++;
+  v->total += seconds;
+  if (seconds > v->slowest)
+    v->slowest = seconds;
+}
+
 /* Array of windows we might need to handle autodisplay for (in practice
 a list of windows that are, wrt. -gui, on-screen). */
 static GSIArray_t autodisplayedWindows;
 
+/*
+The frame clock.  Autodisplay passes are at least frameInterval apart,
+and the windows needing display in between wait for frameTimer.  When a
+pass takes longer than the interval, the next one waits for as long as
+the pass took, so that the display never takes up all of the main thread
+and events still get handled.  The interval comes from the
+GSAutodisplayFrameRate default, or from the refresh rate of the main
+screen, or else is 1/60 s.  A rate of 0 turns the clock off, so every
+run loop pass displays.
+*/
+static NSTimeInterval frameInterval = -1;
+static NSTimeInterval nextFrameTime = 0;
+static NSTimer *frameTimer = nil;
+
+static NSTimeInterval
+frame_interval(void)
+{
+  if (frameInterval < 0)
+    {
+      id rate = [[NSUserDefaults standardUserDefaults]
+                  objectForKey: @"GSAutodisplayFrameRate"];
+      double fps;
+
+      if (rate != nil)
+        {
+          fps = [rate doubleValue];
+        }
+      else
+        {
+          fps = [GSCurrentServer() refreshRateForScreen:
+            [[NSScreen mainScreen] screenNumber]];
+          if (fps <= 0)
+            fps = 60;
+        }
+      frameInterval = (fps > 0) ? 1 / fps : 0;
+    }
+  return frameInterval;
+}
+
+static BOOL
+autodisplay_pending(void)
+{
+  int i;
+
+  for (i = 0; i < GSIArrayCount(&autodisplayedWindows); i++)
+    if ([GSIArrayItemAtIndex(&autodisplayedWindows, i).ext _needsAutodisplay])
+      return YES;
+  return NO;
+}
+
 /*
 This method handles all normal displaying. It is set to be run on each
 runloop iteration when the first window is created
@@ -211,11 +438,60 @@ events. If the performer were added in a call to another performer, it
 wouldn't be called until the next runloop iteration, ie. after the runloop
 has blocked and waited for events.
 */
-+(void) _handleAutodisplay: (id)bogus
++(void) _displayFrame
 {
+  NSTimeInterval start, end;
   int i;
+
+  if (autodisplay_pending() == NO)
+    return;
+
+  start = [NSDate timeIntervalSinceReferenceDate];
   for (i = 0; i < GSIArrayCount(&autodisplayedWindows); i++)
     [GSIArrayItemAtIndex(&autodisplayedWindows, i).ext _handleAutodisplay];
+  end = [NSDate timeIntervalSinceReferenceDate];
+  nextFrameTime = MAX(start + frame_interval(), end + (end - start));
+}
+
+NSTimeInterval
+GSFrameInterval(void)
+{
+  return frame_interval();
+}
+
+void
+GSDisplayFrame(void)
+{
+  [NSWindow _displayFrame];
+}
+
++(void) _frameTimerFired: (NSTimer*)timer
+{
+  frameTimer = nil;
+  [self _displayFrame];
+}
+
++(void) _handleAutodisplay: (id)bogus
+{
+  NSTimeInterval now = [NSDate timeIntervalSinceReferenceDate];
+
+  if (frame_interval() == 0 || now >= nextFrameTime)
+    {
+      [self _displayFrame];
+    }
+  else if (frameTimer == nil && autodisplay_pending())
+    {
+      NSRunLoop *loop = [NSRunLoop currentRunLoop];
+      NSUInteger i;
+
+      frameTimer = [NSTimer timerWithTimeInterval: nextFrameTime - now
+                                           target: self
+                                         selector: @selector(_frameTimerFired:)
+                                         userInfo: nil
+                                          repeats: NO];
+      for (i = 0; i < [modes count]; i++)
+        [loop addTimer: frameTimer forMode: [modes objectAtIndex: i]];
+    }
 
   [[NSRunLoop currentRunLoop]
          performSelector: @selector(_handleAutodisplay:)
@@ -503,14 +779,12 @@ static NSSize scaledIconSizeForSize(NSSize imageSize)
 {   
   NSSize iconSize = GSGetIconSize();
 
-  [tileCell drawWithFrame: NSMakeRect(0, 0, iconSize.width, iconSize.height)
-                     inView: self];
-  [imageCell
-       drawWithFrame: NSMakeRect(iconSize.width / 8,
-                                 (iconSize.height / 16),
-                                 iconSize.width - ((iconSize.width / 8) * 2),
-                                 iconSize.height - ((iconSize.height / 8) * 2))
-              inView: self];
+  GSDrawIconBase(tileCell, imageCell,
+    NSMakeRect(iconSize.width / 8,
+               (iconSize.height / 16),
+               iconSize.width - ((iconSize.width / 8) * 2),
+               iconSize.height - ((iconSize.height / 8) * 2)),
+    iconSize);
   [titleCell drawWithFrame: NSMakeRect(1, iconSize.height - 12,
                                        iconSize.width - 2, 11)
                     inView: self];
@@ -664,10 +938,6 @@ static NSSize scaledIconSizeForSize(NSSize imageSize)
 /*
  * Class variables
  */
-static SEL        ccSel;
-static SEL        ctSel;
-static IMP        ccImp;
-static IMP        ctImp;
 static Class      responderClass;
 static Class      viewClass;
 static NSMutableSet *autosaveNames;
@@ -675,6 +945,46 @@ static NSMapTable *windowmaps = NULL;
 static NSMapTable *windowUndoManagers = NULL;
 static NSNotificationCenter *nc = nil;
 
+/*
+ * The tracking and cursor rectangles of all the views in the window,
+ * found by walking the view tree in order and kept in a grid by their
+ * bounding boxes in window coordinates.  On a mouse move only the
+ * rectangles in the cells under the current and the last mouse position
+ * can be entered or exited, so only those are tested.  The index is
+ * rebuilt on the next mouse move after the views mark it invalid by
+ * clearing _f.tracking_rects_valid.  Cursor rectangles have no view, as
+ * they are kept in window coordinates already.
+ */
+typedef struct {
+  NSUInteger count;
+  NSUInteger capacity;
+  GSTrackingRect **rects;
+  NSView **views;
+  NSRect *frames;
+  GSGridIndex *grid;
+} GSTrackingRectIndex;
+
+static void
+free_tracking_rect_index(GSTrackingRectIndex *idx)
+{
+  NSUInteger i;
+
+  if (idx == NULL)
+    return;
+  for (i = 0; i < idx->count; i++)
+    {
+      RELEASE(idx->rects[i]);
+    }
+  GSGridIndexFree(idx->grid);
+  if (idx->rects != NULL)
+    {
+      NSZoneFree(NSDefaultMallocZone(), idx->rects);
+      NSZoneFree(NSDefaultMallocZone(), idx->views);
+      NSZoneFree(NSDefaultMallocZone(), idx->frames);
+    }
+  NSZoneFree(NSDefaultMallocZone(), idx);
+}
+
 /*
  * Class methods
  */
@@ -683,10 +993,6 @@ static NSNotificationCenter *nc = nil;
   if (self == [NSWindow class])
     {
       [self setVersion: 2];
-      ccSel = @selector(_checkCursorRectangles:forEvent:);
-      ctSel = @selector(_checkTrackingRectangles:forEvent:);
-      ccImp = [self instanceMethodForSelector: ccSel];
-      ctImp = [self instanceMethodForSelector: ctSel];
       responderClass = [NSResponder class];
       viewClass = [NSView class];
       autosaveNames = [NSMutableSet new];
@@ -777,6 +1083,8 @@ many times.
 {
   if (_windowNum)
     {
+      GSDisplayServer *srv;
+
       [_wv setWindowNumber: 0];
 
       /* Check for context also as it might have disappeared before us */
@@ -798,7 +1106,23 @@ many times.
           DESTROY(_context);
         }
 
-      [GSServerForWindow(self) termwindow: _windowNum];
+      srv = GSServerForWindow(self);
+      [srv discardQueuedOperationsForWindow: _windowNum];
+      /* A borderless backend window which keeps no state of ours that a
+         new backend window would not have goes back to the pool.  */
+      if (_parent == nil && _counterpart == 0 && _alphaValue == 1.0
+        && NSEqualSizes(_increments, NSZeroSize)
+        && [srv dragTypesForWindow: self] == nil)
+        {
+          [srv returnwindow: _windowNum
+                           : _backingType
+                           : _styleMask
+                           : [_screen screenNumber]];
+        }
+      else
+        {
+          [srv termwindow: _windowNum];
+        }
       NSMapRemove(windowmaps, (void*)(intptr_t)_windowNum);
       _windowNum = 0;
     }
@@ -854,6 +1178,9 @@ many times.
      retained for some other reason by the programmer or by other
      parts of the code */
   DESTROY(_wv);
+  free_tracking_rect_index(_trackingRectIndex);
+  clearInvalidCursorRectViews(_invalidCursorRectViews);
+  DESTROY(_invalidCursorRectViews);
   DESTROY(_fieldEditor);
   DESTROY(_backgroundColor);
   DESTROY(_representedFilename);
@@ -861,6 +1188,22 @@ many times.
   DESTROY(_miniaturizedImage);
   DESTROY(_windowTitle);
   DESTROY(_rectsBeingDrawn);
+  if (_displayTimings != NULL)
+    {
+      free_display_timings(_displayTimings);
+      NSZoneFree(NSDefaultMallocZone(), _displayTimings);
+      _displayTimings = NULL;
+    }
+  if (_inputLatencyTags != NULL)
+    {
+      NSZoneFree(NSDefaultMallocZone(), _inputLatencyTags);
+      _inputLatencyTags = NULL;
+    }
+  if (_rectsNeedingFlush != NULL)
+    {
+      NSZoneFree(NSDefaultMallocZone(), _rectsNeedingFlush);
+      _rectsNeedingFlush = NULL;
+    }
   DESTROY(_initialFirstResponder);
   DESTROY(_defaultButtonCell);
   DESTROY(_cachedImage);
@@ -944,10 +1287,11 @@ many times.
       [srv removeDragTypes: nil fromWindow: self];
     }
 
-  _windowNum = [srv window: _frame
-                    : _backingType
-                    : _styleMask
-                    : [_screen screenNumber]];
+  _windowNum = [srv leasewindow: _frame
+                         : _backingType
+                         : _styleMask
+                         : [_screen screenNumber]
+                         : NULL];
   if (_windowNum == 0)
     [NSException raise:@"No Window" format:@"Failed to obtain window from the back end"];
   [srv setwindowlevel: [self level] : _windowNum];
@@ -1085,6 +1429,13 @@ many times.
      part a view is drawing in, so NSWindow only has to flush that portion */
   _rectsBeingDrawn = RETAIN([NSMutableArray arrayWithCapacity: 10]);
 
+  /* The area needing a flush is kept as a few rects, like the invalid
+     area of a view, so that drawing in two corners of the window does
+     not flush everything in between.  _rectNeedingFlush is their union. */
+  _rectsNeedingFlush = NSZoneMalloc(NSDefaultMallocZone(),
+                                    GS_MAX_REGION_RECTS * sizeof(NSRect));
+  _rectsNeedingFlushCount = 0;
+
   /* Create window (if not deferred) */
   _windowNum = 0;
   _gstate = 0;
@@ -1570,7 +1921,7 @@ titleWithRepresentedFilename(NSString *representedFilename)
         }
 
       [_wv setInputState: GSTitleBarKey];
-      [GSServerForWindow(self) setinputfocus: _windowNum];
+      [GSServerForWindow(self) queuesetinputfocus: _windowNum];
       [self resetCursorRects];
       [nc postNotificationName: NSWindowDidBecomeKeyNotification object: self];
       NSDebugLLog(@"NSWindow", @"%@ is now key window", [self title]);
@@ -1833,7 +2184,7 @@ titleWithRepresentedFilename(NSString *representedFilename)
       && [NSApp isActive])
     otherWin = -1;
     
-  [srv orderwindow: place : otherWin : _windowNum];
+  [srv queueorderwindow: place : otherWin : _windowNum];
   if (display)
     [self display];
 
@@ -1862,7 +2213,7 @@ titleWithRepresentedFilename(NSString *representedFilename)
       if ([self isKeyWindow] == YES)
         {
           [_wv setInputState: GSTitleBarKey];
-          [srv setinputfocus: _windowNum];
+          [srv queuesetinputfocus: _windowNum];
         }
       _f.visible = YES;
     }
@@ -2015,6 +2366,11 @@ titleWithRepresentedFilename(NSString *representedFilename)
   _f.preserves_content_during_live_resize = flag;
 }
 
+- (BOOL) inLiveResize
+{
+  return _f.in_live_resize;
+}
+
 - (void) setFrame: (NSRect)frameRect
           display: (BOOL)displayFlag
           animate: (BOOL)animationFlag
@@ -2202,9 +2558,10 @@ titleWithRepresentedFilename(NSString *representedFilename)
   /*
    * Now we can tell the graphics context to do the actual resizing.
    * We will recieve an event to tell us when the resize is done.
+   * Inside a window transaction only the last frame is sent.
    */
   if (_windowNum)
-    [GSServerForWindow(self) placewindow: frameRect : _windowNum];
+    [GSServerForWindow(self) queueplacewindow: frameRect : _windowNum];
   else
     {
       _frame = frameRect;
@@ -2414,6 +2771,11 @@ titleWithRepresentedFilename(NSString *representedFilename)
   if (_gstate == 0 || _f.visible == NO)
     return;
 
+  if (_f.views_need_layout)
+    {
+      _f.views_need_layout = NO;
+      [_wv layoutSubtreeIfNeeded];
+    }
   [_wv display];
   [self discardCachedImage];
   _f.views_need_display = NO;
@@ -2421,15 +2783,45 @@ titleWithRepresentedFilename(NSString *representedFilename)
 
 - (void) displayIfNeeded
 {
+  GSDisplayTimings *t;
+  NSTimeInterval start = 0;
+
   if (_gstate == 0 || _f.visible == NO)
     return;
 
+  if (records_display_timings() && _displayTimings == NULL)
+    {
+      _displayTimings = NSZoneCalloc(NSDefaultMallocZone(), 1,
+                                     sizeof(GSDisplayTimings));
+    }
+  t = _displayTimings;
+  if (t != NULL)
+    {
+      start = [NSDate timeIntervalSinceReferenceDate];
+      t->viewsDrawn = 0;
+    }
+
+  if (_f.views_need_layout)
+    {
+      _f.views_need_layout = NO;
+      [_wv layoutSubtreeIfNeeded];
+    }
   if (_f.views_need_display)
     {
       [_wv displayIfNeeded];
       [self discardCachedImage];
       _f.views_need_display = NO;
     }
+
+  if (t != NULL)
+    {
+      t->lastDisplay = [NSDate timeIntervalSinceReferenceDate] - start;
+      t->totalDisplay += t->lastDisplay;
+      if (t->lastDisplay > t->slowestDisplay)
+        t->slowestDisplay = t->lastDisplay;
+      t->totalViewsDrawn += t->viewsDrawn;
+      t->frames++;
+    }
 }
 
 - (void) update
@@ -2463,6 +2855,8 @@ titleWithRepresentedFilename(NSString *representedFilename)
       return;
     }
 
+  GS_PROBE2(window_flush_entry, self, _windowNum);
+
   /*
    * Just flush graphics if backing is not buffered.
    * The documentation actually says that this is wrong ... the method
@@ -2471,6 +2865,9 @@ titleWithRepresentedFilename(NSString *representedFilename)
   if (_backingType == NSBackingStoreNonretained)
     {
       [_context flushGraphics];
+      if (_inputLatencyTags != NULL)
+        flush_input_latency_tags(_inputLatencyTags);
+      GS_PROBE2(window_flush_return, self, _windowNum);
       return;
     }
 
@@ -2481,6 +2878,7 @@ titleWithRepresentedFilename(NSString *representedFilename)
       if ([_rectsBeingDrawn count] == 0)
         {
           _f.needs_flush = NO;
+          GS_PROBE2(window_flush_return, self, _windowNum);
           return;
         }
     }
@@ -2491,17 +2889,45 @@ titleWithRepresentedFilename(NSString *representedFilename)
   i = [_rectsBeingDrawn count];
   while (i-- > 0)
     {
-      _rectNeedingFlush = NSUnionRect(_rectNeedingFlush,
-        [[_rectsBeingDrawn objectAtIndex: i] rectValue]);
+      NSRect rect = [[_rectsBeingDrawn objectAtIndex: i] rectValue];
+
+      GSAddRegionRect(_rectsNeedingFlush, &_rectsNeedingFlushCount, rect);
+      _rectNeedingFlush = NSUnionRect(_rectNeedingFlush, rect);
     }
 
-  if (_windowNum > 0)
+  if (_windowNum > 0 && _rectsNeedingFlushCount > 0)
     {
-      [GSServerForWindow(self) flushwindowrect: _rectNeedingFlush
-                                              : _windowNum];
+      GSDisplayServer *srv = GSServerForWindow(self);
+      GSDisplayTimings *t = _displayTimings;
+      NSTimeInterval start = 0;
+
+      if (t != NULL)
+        start = [NSDate timeIntervalSinceReferenceDate];
+      if (_rectsNeedingFlushCount == 1)
+        {
+          [srv flushwindowrect: _rectsNeedingFlush[0] : _windowNum];
+        }
+      else
+        {
+          [srv flushwindowrects: _rectsNeedingFlush
+                               : _rectsNeedingFlushCount
+                               : _windowNum];
+        }
+      if (_inputLatencyTags != NULL)
+        flush_input_latency_tags(_inputLatencyTags);
+      if (t != NULL)
+        {
+          t->lastFlush = [NSDate timeIntervalSinceReferenceDate] - start;
+          t->totalFlush += t->lastFlush;
+          if (t->lastFlush > t->slowestFlush)
+            t->slowestFlush = t->lastFlush;
+          t->flushes++;
+        }
     }
   _f.needs_flush = NO;
   _rectNeedingFlush = NSZeroRect;
+  _rectsNeedingFlushCount = 0;
+  GS_PROBE2(window_flush_return, self, _windowNum);
 }
 
 - (void) enableFlushWindow
@@ -2545,6 +2971,173 @@ titleWithRepresentedFilename(NSString *representedFilename)
   return _f.views_need_display;
 }
 
+/**
+ * Returns the most frames per second at which windows are autodisplayed,
+ * or 0 if they are displayed on every pass of the run loop.
+ */
++ (double) autodisplayFrameRate
+{
+  return (frame_interval() > 0) ? 1 / frame_interval() : 0;
+}
+
+/**
+ * Sets the most frames per second at which windows are autodisplayed.
+ * Views changed more often than that are drawn once for all the changes
+ * in each frame.  A rate of 0 displays windows on every pass of the run
+ * loop.  The default comes from the GSAutodisplayFrameRate user default
+ * or the refresh rate of the screen.
+ */
++ (void) setAutodisplayFrameRate: (double)rate
+{
+  frameInterval = (rate > 0) ? 1 / rate : 0;
+  nextFrameTime = 0;
+}
+
+/**
+ * Returns how often the receiver has been autodisplayed.
+ */
+- (NSUInteger) autodisplayCount
+{
+  return _autodisplayCount;
+}
+
+/**
+ * Returns the time, relative to the reference date, at which the
+ * receiver was last autodisplayed.
+ */
+- (NSTimeInterval) lastAutodisplayTime
+{
+  return _autodisplayTime;
+}
+
+/**
+ * Returns how long the last autodisplay of the receiver took.
+ */
+- (NSTimeInterval) lastAutodisplayDuration
+{
+  return _autodisplayDuration;
+}
+
+/**
+ * Returns whether windows record display timings.  The default comes
+ * from the GSRecordDisplayTimings user default.
+ */
++ (BOOL) recordsDisplayTimings
+{
+  return records_display_timings();
+}
+
+/**
+ * Sets whether windows record how long their displays and flushes take
+ * and which of their views draw slowest, for -displayTimings.  Windows
+ * start recording when they are next displayed.  Turning recording off
+ * discards the timings recorded so far.
+ */
++ (void) setRecordsDisplayTimings: (BOOL)flag
+{
+  recordsDisplayTimings = flag;
+  if (flag == NO)
+    {
+      NSEnumerator *e = [GSAllWindows() objectEnumerator];
+      NSWindow *w;
+
+      while ((w = [e nextObject]) != nil)
+        {
+          if (w->_displayTimings != NULL)
+            {
+              free_display_timings(w->_displayTimings);
+              NSZoneFree(NSDefaultMallocZone(), w->_displayTimings);
+              w->_displayTimings = NULL;
+            }
+        }
+    }
+}
+
+/**
+ * Returns the display timings recorded for the receiver, or nil if it
+ * has not recorded any.  Times are in seconds.  The keys are:
+ * <deflist>
+ *   <term>Frames</term>
+ *   <desc>The number of -displayIfNeeded calls.</desc>
+ *   <term>LastDisplayTime, AverageDisplayTime, SlowestDisplayTime</term>
+ *   <desc>How long -displayIfNeeded took.</desc>
+ *   <term>Flushes</term>
+ *   <desc>The number of flushes to the screen.</desc>
+ *   <term>LastFlushTime, AverageFlushTime, SlowestFlushTime</term>
+ *   <desc>How long the flushes took.</desc>
+ *   <term>LastViewsDrawn, AverageViewsDrawn</term>
+ *   <desc>How many views were drawn per frame.</desc>
+ *   <term>Views</term>
+ *   <desc>The views whose -drawRect: took longest, slowest first, as
+ *   dictionaries with the keys View (a description of the view), Draws,
+ *   AverageTime and SlowestTime.</desc>
+ * </deflist>
+ */
+- (NSDictionary *) displayTimings
+{
+  GSDisplayTimings *t = _displayTimings;
+  NSMutableArray *views;
+  NSUInteger order[GS_SLOW_VIEW_COUNT];
+  NSUInteger frames;
+  NSUInteger i, j;
+
+  if (t == NULL)
+    return nil;
+
+  /* Sort the views by their slowest draw.  */
+  for (i = 0; i < t->viewCount; i++)
+    {
+      for (j = i; j > 0
+             && t->views[order[j - 1]].slowest < t->views[i].slowest; j--)
+        {
+          order[j] = order[j - 1];
+        }
+      order[j] = i;
+    }
+  views = [NSMutableArray arrayWithCapacity: t->viewCount];
+  for (i = 0; i < t->viewCount; i++)
+    {
+      GSViewTiming *v = &t->views[order[i]];
+
+      [views addObject: [NSDictionary dictionaryWithObjectsAndKeys:
+        v->name, @"View",
+        [NSNumber numberWithUnsignedInteger: v->draws], @"Draws",
+        [NSNumber numberWithDouble: v->total / v->draws], @"AverageTime",
+        [NSNumber numberWithDouble: v->slowest], @"SlowestTime",
+        nil]];
+    }
+
+  frames = MAX(t->frames, 1);
+  return [NSDictionary dictionaryWithObjectsAndKeys:
+    [NSNumber numberWithUnsignedInteger: t->frames], @"Frames",
+    [NSNumber numberWithDouble: t->lastDisplay], @"LastDisplayTime",
+    [NSNumber numberWithDouble: t->totalDisplay / frames],
+    @"AverageDisplayTime",
+    [NSNumber numberWithDouble: t->slowestDisplay], @"SlowestDisplayTime",
+    [NSNumber numberWithUnsignedInteger: t->flushes], @"Flushes",
+    [NSNumber numberWithDouble: t->lastFlush], @"LastFlushTime",
+    [NSNumber numberWithDouble: t->totalFlush / MAX(t->flushes, 1)],
+    @"AverageFlushTime",
+    [NSNumber numberWithDouble: t->slowestFlush], @"SlowestFlushTime",
+    [NSNumber numberWithUnsignedInteger: t->viewsDrawn], @"LastViewsDrawn",
+    [NSNumber numberWithDouble: (double)t->totalViewsDrawn / frames],
+    @"AverageViewsDrawn",
+    views, @"Views",
+    nil];
+}
+
+/**
+ * Discards the display timings recorded for the receiver so far.
+ */
+- (void) resetDisplayTimings
+{
+  if (_displayTimings != NULL)
+    {
+      free_display_timings(_displayTimings);
+      memset(_displayTimings, 0, sizeof(GSDisplayTimings));
+    }
+}
+
 - (void) cacheImageInRect: (NSRect)aRect
 {
   NSView *cacheView;
@@ -2708,29 +3301,63 @@ discardCursorRectsForView(NSView *theView)
   _f.cursor_rects_enabled = YES;
 }
 
+/* Forgets the views waiting for their cursor rectangles to be reset.  */
+static void
+clearInvalidCursorRectViews(NSMutableArray *views)
+{
+  NSUInteger count = [views count];
+
+  if (count > 0)
+    {
+      NSView *array[count];
+      NSUInteger i;
+
+      [views getObjects: array];
+      for (i = 0; i < count; i++)
+        {
+          array[i]->_rFlags.cursor_rects_pending = 0;
+        }
+      [views removeAllObjects];
+    }
+}
+
+/**
+ * Discards the cursor rectangles of aView and marks it as needing its
+ * cursor rectangles set again.  Only the views marked in this way get
+ * -resetCursorRects sent before the next event is handled.
+ */
 - (void) invalidateCursorRectsForView: (NSView*)aView
 {
   if (aView->_rFlags.valid_rects)
     {
       [aView discardCursorRects];
+    }
+  if (aView->_rFlags.cursor_rects_pending == 0 && [aView window] == self)
+    {
+      if (_invalidCursorRectViews == nil)
+        {
+          _invalidCursorRectViews = [NSMutableArray new];
+        }
+      [_invalidCursorRectViews addObject: aView];
+      aView->_rFlags.cursor_rects_pending = 1;
+    }
 
-      if (_f.cursor_rects_valid)
+  if (_f.cursor_rects_valid)
+    {
+      if (_f.is_key && _f.cursor_rects_enabled)
         {
-          if (_f.is_key && _f.cursor_rects_enabled)
-            {
-              NSEvent *e = [NSEvent otherEventWithType: NSAppKitDefined
-                                              location: NSMakePoint(-1, -1)
-                                         modifierFlags: 0
-                                             timestamp: 0
-                                          windowNumber: _windowNum
-                                               context: GSCurrentContext()
-                                               subtype: -1
-                                                 data1: 0
-                                                 data2: 0];
-              [self postEvent: e atStart: YES];
-            }
-          _f.cursor_rects_valid = NO;
+          NSEvent *e = [NSEvent otherEventWithType: NSAppKitDefined
+                                          location: NSMakePoint(-1, -1)
+                                     modifierFlags: 0
+                                         timestamp: 0
+                                      windowNumber: _windowNum
+                                           context: GSCurrentContext()
+                                           subtype: -1
+                                             data1: 0
+                                             data2: 0];
+          [self postEvent: e atStart: YES];
         }
+      _f.cursor_rects_valid = NO;
     }
 }
 
@@ -2761,12 +3388,10 @@ resetCursorRectsForView(NSView *theView)
     }
 }
 
-- (void) resetCursorRects
+/* Sends the cursor updates for the mouse position after the cursor
+   rectangles were set again.  */
+- (void) _updateCursorAtMouseLocation
 {
-  [self discardCursorRects];
-  resetCursorRectsForView(_wv);
-  _f.cursor_rects_valid = YES;
-
   if (_f.is_key && _f.cursor_rects_enabled)
     {
       NSPoint loc = [self mouseLocationOutsideOfEventStream];
@@ -2782,12 +3407,53 @@ resetCursorRectsForView(NSView *theView)
                                         clickCount: 0
                                           pressure: 0];
           _lastPoint = NSMakePoint(-1,-1);
-          (*ccImp)(self, ccSel, _wv, e);
+          [self _checkCursorRectanglesForEvent: e];
           _lastPoint = loc;
         }
     }
 }
 
+- (void) resetCursorRects
+{
+  clearInvalidCursorRectViews(_invalidCursorRectViews);
+  [self discardCursorRects];
+  resetCursorRectsForView(_wv);
+  _f.cursor_rects_valid = YES;
+  [self _updateCursorAtMouseLocation];
+}
+
+/* Sets the cursor rectangles again for only the views which were passed
+   to -invalidateCursorRectsForView: since they were last set.  */
+- (void) _resetInvalidCursorRects
+{
+  NSUInteger count = [_invalidCursorRectViews count];
+
+  if (count > 0)
+    {
+      NSView *array[count];
+      NSUInteger i;
+
+      [_invalidCursorRectViews getObjects: array];
+      for (i = 0; i < count; i++)
+        {
+          RETAIN(array[i]);
+          array[i]->_rFlags.cursor_rects_pending = 0;
+        }
+      [_invalidCursorRectViews removeAllObjects];
+      for (i = 0; i < count; i++)
+        {
+          if ([array[i] window] == self)
+            {
+              [array[i] discardCursorRects];
+              [array[i] resetCursorRects];
+            }
+          RELEASE(array[i]);
+        }
+    }
+  _f.cursor_rects_valid = YES;
+  [self _updateCursorAtMouseLocation];
+}
+
 /*
  * Handling user actions and events
  */
@@ -3473,108 +4139,64 @@ resetCursorRectsForView(NSView *theView)
   [NSApp postEvent: event atStart: flag];
 }
 
-- (void) _checkTrackingRectangles: (NSView*)theView
-                         forEvent: (NSEvent*)theEvent
+static void
+grow_tracking_rect_index(GSTrackingRectIndex *idx, NSUInteger count)
+{
+  if (idx->count + count > idx->capacity)
+    {
+      idx->capacity = MAX(idx->capacity * 2, idx->count + count);
+      idx->rects = NSZoneRealloc(NSDefaultMallocZone(), idx->rects,
+        idx->capacity * sizeof(GSTrackingRect*));
+      idx->views = NSZoneRealloc(NSDefaultMallocZone(), idx->views,
+        idx->capacity * sizeof(NSView*));
+      idx->frames = NSZoneRealloc(NSDefaultMallocZone(), idx->frames,
+        idx->capacity * sizeof(NSRect));
+    }
+}
+
+/* Adds the tracking and cursor rectangles of theView and its visible
+   subviews.  */
+static void
+collect_tracking_rects(GSTrackingRectIndex *idx, NSView *theView)
 {
-  if (theView == nil)
-    return;
   if (theView->_rFlags.has_trkrects)
     {
-      BOOL isFlipped = [theView isFlipped];
       NSArray *tr = [theView _trackingRects];
       NSUInteger count = [tr count];
+      NSUInteger i;
 
-      /*
-       * Loop through the tracking rectangles
-       */
-      if (count > 0)
+      grow_tracking_rect_index(idx, count);
+      for (i = 0; i < count; i++)
         {
-          GSTrackingRect *rects[count];
-          NSPoint loc = [theEvent locationInWindow];
-	  NSPoint lastPoint = _lastPoint;
-          NSUInteger i;
-
-	  lastPoint = [theView convertPoint: lastPoint fromView: nil];
-	  loc = [theView convertPoint: loc fromView: nil];
-          [tr getObjects: rects];
+          GSTrackingRect *r = [tr objectAtIndex: i];
+          NSRect frame = [theView convertRect: r->rectangle toView: nil];
+
+          /* Allow for rounding in the conversion.  */
+          idx->frames[idx->count] = NSInsetRect(frame, -1, -1);
+          idx->rects[idx->count] = RETAIN(r);
+          idx->views[idx->count] = theView;
+          idx->count++;
+        }
+    }
 
-          for (i = 0; i < count; ++i)
-            {
-              BOOL last;
-              BOOL now;
-              GSTrackingRect *r = rects[i];
-
-              if ([r isValid] == NO)
-                continue;
-              /* Check mouse at last point */
-              last = NSMouseInRect(lastPoint, r->rectangle, isFlipped);
-              /* Check mouse at current point */
-              now = NSMouseInRect(loc, r->rectangle, isFlipped);
-
-              if ((!last) && (now))                // Mouse entered event
-                {
-                  if (r->flags.checked == NO)
-                    {
-                      if ([r->owner respondsToSelector:
-                        @selector(mouseEntered:)])
-                        r->flags.ownerRespondsToMouseEntered = YES;
-                      if ([r->owner respondsToSelector:
-                        @selector(mouseExited:)])
-                        r->flags.ownerRespondsToMouseExited = YES;
-                      r->flags.checked = YES;
-                    }
-                  if (r->flags.ownerRespondsToMouseEntered)
-                    {
-                      NSEvent        *e;
+  if (theView->_rFlags.valid_rects)
+    {
+      NSArray *cr = [theView _cursorRects];
+      NSUInteger count = [cr count];
+      NSUInteger i;
 
-                      e = [NSEvent enterExitEventWithType: NSMouseEntered
-                        location: loc
-                        modifierFlags: [theEvent modifierFlags]
-                        timestamp: 0
-                        windowNumber: [theEvent windowNumber]
-                        context: NULL
-                        eventNumber: 0
-                        trackingNumber: r->tag
-                        userData: r->user_data];
-                      [r->owner mouseEntered: e];
-                    }
-                }
-                
-              if ((last) && (!now))                // Mouse exited event
-                {
-                  if (r->flags.checked == NO)
-                    {    
-                      if ([r->owner respondsToSelector:
-                        @selector(mouseEntered:)])
-                        r->flags.ownerRespondsToMouseEntered = YES;
-                      if ([r->owner respondsToSelector:
-                        @selector(mouseExited:)])
-                        r->flags.ownerRespondsToMouseExited = YES;
-                      r->flags.checked = YES;
-                    }
-                  if (r->flags.ownerRespondsToMouseExited)
-                    {
-                      NSEvent        *e;
+      grow_tracking_rect_index(idx, count);
+      for (i = 0; i < count; i++)
+        {
+          GSTrackingRect *r = [cr objectAtIndex: i];
 
-                      e = [NSEvent enterExitEventWithType: NSMouseExited
-                        location: loc
-                        modifierFlags: [theEvent modifierFlags]
-                        timestamp: 0
-                        windowNumber: [theEvent windowNumber]
-                        context: NULL
-                        eventNumber: 0
-                        trackingNumber: r->tag
-                        userData: r->user_data];
-                      [r->owner mouseExited: e];
-                    }
-                }
-            }
+          idx->frames[idx->count] = r->rectangle;
+          idx->rects[idx->count] = RETAIN(r);
+          idx->views[idx->count] = nil;
+          idx->count++;
         }
     }
 
-  /*
-   * Check tracking rectangles for the subviews
-   */
   if (theView->_rFlags.has_subviews)
     {
       NSArray *sb = [theView subviews];
@@ -3589,100 +4211,240 @@ resetCursorRectsForView(NSView *theView)
           for (i = 0; i < count; ++i)
             {
               if (![subs[i] isHidden])
-                (*ctImp)(self, ctSel, subs[i], theEvent);
+                collect_tracking_rects(idx, subs[i]);
             }
         }
     }
 }
 
-- (void) _checkCursorRectangles: (NSView*)theView forEvent: (NSEvent*)theEvent
+static GSTrackingRectIndex *
+build_tracking_rect_index(NSView *theView)
 {
-  if (theView->_rFlags.valid_rects)
+  GSTrackingRectIndex *idx;
+  NSRect area = NSZeroRect;
+  NSUInteger i;
+
+  idx = NSZoneCalloc(NSDefaultMallocZone(), 1, sizeof(GSTrackingRectIndex));
+  if (theView != nil)
+    collect_tracking_rects(idx, theView);
+  for (i = 0; i < idx->count; i++)
     {
-      NSArray *tr = [theView _cursorRects];
-      NSUInteger count = [tr count];
+      area = (i == 0) ? idx->frames[0] : NSUnionRect(area, idx->frames[i]);
+    }
+  idx->grid = GSGridIndexCreate(idx->count, area);
+  for (i = 0; i < idx->count; i++)
+    {
+      GSGridIndexAdd(idx->grid, i, idx->frames[i], YES);
+    }
+  return idx;
+}
 
-      // Loop through cursor rectangles
-      if (count > 0)
-        {
-          GSTrackingRect *rects[count];
-          NSPoint loc = [theEvent locationInWindow];
-          NSUInteger i;
+/* Sends mouseEntered: or mouseExited: to the owner of r.  */
+static void
+send_tracking_event(GSTrackingRect *r, BOOL entered, NSPoint loc,
+                    NSEvent *theEvent)
+{
+  NSEvent *e;
 
-          [tr getObjects: rects];
+  if (r->flags.checked == NO)
+    {
+      if ([r->owner respondsToSelector: @selector(mouseEntered:)])
+        r->flags.ownerRespondsToMouseEntered = YES;
+      if ([r->owner respondsToSelector: @selector(mouseExited:)])
+        r->flags.ownerRespondsToMouseExited = YES;
+      r->flags.checked = YES;
+    }
+  if (entered ? !r->flags.ownerRespondsToMouseEntered
+    : !r->flags.ownerRespondsToMouseExited)
+    return;
 
-          for (i = 0; i < count; ++i)
-            {
-              GSTrackingRect *r = rects[i];
-              BOOL last;
-              BOOL now;
+  e = [NSEvent enterExitEventWithType: entered ? NSMouseEntered : NSMouseExited
+                             location: loc
+                        modifierFlags: [theEvent modifierFlags]
+                            timestamp: 0
+                         windowNumber: [theEvent windowNumber]
+                              context: NULL
+                          eventNumber: 0
+                       trackingNumber: r->tag
+                             userData: r->user_data];
+  if (entered)
+    [r->owner mouseEntered: e];
+  else
+    [r->owner mouseExited: e];
+}
 
-              if ([r isValid] == NO)
-                continue;
+/* Returns how much room near_tracking_rects() needs for its items.  */
+static NSUInteger
+near_tracking_rect_count(GSTrackingRectIndex *idx, NSPoint loc,
+                         NSPoint lastPoint)
+{
+  GSGridCell *a = GSGridIndexCellAtPoint(idx->grid, loc);
+  GSGridCell *b = GSGridIndexCellAtPoint(idx->grid, lastPoint);
 
-              /*
-               * Check for presence of point in rectangle.
-               */
-              last = NSMouseInRect(_lastPoint, r->rectangle, NO);
-              now = NSMouseInRect(loc, r->rectangle, NO);
+  return (a == b) ? a->count : a->count + b->count;
+}
 
-              // Mouse entered
-              if ((!last) && (now))
-                {
-                  NSEvent *e;
-
-                  e = [NSEvent enterExitEventWithType: NSCursorUpdate
-                    location: loc
-                    modifierFlags: [theEvent modifierFlags]
-                    timestamp: 0
-                    windowNumber: [theEvent windowNumber]
-                    context: [theEvent context]
-                    eventNumber: 0
-                    trackingNumber: (int)YES
-                    userData: (void*)r];
-                  [self postEvent: e atStart: YES];
-                }
-              // Mouse exited
-              if ((last) && (!now))
-                {
-                  NSEvent *e;
-
-                  e = [NSEvent enterExitEventWithType: NSCursorUpdate
-                    location: loc
-                    modifierFlags: [theEvent modifierFlags]
-                    timestamp: 0
-                    windowNumber: [theEvent windowNumber]
-                    context: [theEvent context]
-                    eventNumber: 0
-                    trackingNumber: (int)NO
-                    userData: (void*)r];
-                  [self postEvent: e atStart: YES];
-                }
-            }
+/* Fills items with the rectangles in the cells under loc or lastPoint, in
+   view tree order, and returns how many there are.  */
+static NSUInteger
+near_tracking_rects(GSTrackingRectIndex *idx, NSPoint loc,
+                    NSPoint lastPoint, NSUInteger *items)
+{
+  GSGridCell *a = GSGridIndexCellAtPoint(idx->grid, loc);
+  GSGridCell *b = GSGridIndexCellAtPoint(idx->grid, lastPoint);
+  NSUInteger ia = 0, ib = 0, n = 0;
+
+  if (a == b)
+    {
+      memcpy(items, a->items, a->count * sizeof(NSUInteger));
+      return a->count;
+    }
+  while (ia < a->count || ib < b->count)
+    {
+      if (ib == b->count
+        || (ia < a->count && a->items[ia] <= b->items[ib]))
+        {
+          if (ib < b->count && b->items[ib] == a->items[ia])
+            ib++;
+          items[n++] = a->items[ia++];
+        }
+      else
+        {
+          items[n++] = b->items[ib++];
         }
     }
+  return n;
+}
 
-  /*
-   * Check cursor rectangles for the subviews
-   */
-  if (theView->_rFlags.has_subviews)
+/* Returns the index of window, building it again if it is invalid.  */
+static GSTrackingRectIndex *
+tracking_rect_index(NSWindow *window)
+{
+  GSTrackingRectIndex *idx = window->_trackingRectIndex;
+
+  if (idx == NULL || window->_f.tracking_rects_valid == NO)
     {
-      NSArray *sb = [theView subviews];
-      NSUInteger count = [sb count];
+      free_tracking_rect_index(idx);
+      window->_trackingRectIndex = idx
+        = build_tracking_rect_index(window->_wv);
+      window->_f.tracking_rects_valid = YES;
+    }
+  return idx;
+}
 
-      if (count > 0)
-        {
-          NSView *subs[count];
-          NSUInteger i;
+- (void) _checkTrackingRectanglesForEvent: (NSEvent*)theEvent
+{
+  GSTrackingRectIndex *idx = tracking_rect_index(self);
+  NSPoint loc = [theEvent locationInWindow];
+  NSPoint lastPoint = _lastPoint;
+  NSUInteger count, n = 0;
 
-          [sb getObjects: subs];
-          for (i = 0; i < count; ++i)
-            {
-              if (![subs[i] isHidden])
-                (*ccImp)(self, ccSel, subs[i], theEvent);
-            }
-        }
-    }
+  if (idx->count == 0)
+    return;
+
+  count = near_tracking_rect_count(idx, loc, lastPoint);
+  {
+    NSUInteger items[count];
+    GSTrackingRect *rects[count];
+    BOOL entered[count];
+    NSPoint points[count];
+    NSView *view = nil;
+    NSPoint viewLoc = NSZeroPoint, viewLast = NSZeroPoint;
+    BOOL isFlipped = NO;
+    NSUInteger i, j;
+
+    /* Note the rectangles the mouse entered or exited.  */
+    count = near_tracking_rects(idx, loc, lastPoint, items);
+    for (j = 0; j < count; j++)
+      {
+        GSTrackingRect *r;
+        BOOL last, now;
+
+        i = items[j];
+        r = idx->rects[i];
+        if (idx->views[i] == nil || [r isValid] == NO)
+          continue;
+        if (idx->views[i] != view)
+          {
+            view = idx->views[i];
+            isFlipped = [view isFlipped];
+            viewLoc = [view convertPoint: loc fromView: nil];
+            viewLast = [view convertPoint: lastPoint fromView: nil];
+          }
+        last = NSMouseInRect(viewLast, r->rectangle, isFlipped);
+        now = NSMouseInRect(viewLoc, r->rectangle, isFlipped);
+        if (last != now)
+          {
+            rects[n] = RETAIN(r);
+            entered[n] = now;
+            points[n] = viewLoc;
+            n++;
+          }
+      }
+
+    /* Send the events once all rectangles are checked, as the owners
+       may change the views and their tracking rectangles.  */
+    for (i = 0; i < n; i++)
+      {
+        if ([rects[i] isValid])
+          {
+            send_tracking_event(rects[i], entered[i], points[i], theEvent);
+          }
+        RELEASE(rects[i]);
+      }
+  }
+}
+
+- (void) _checkCursorRectanglesForEvent: (NSEvent*)theEvent
+{
+  GSTrackingRectIndex *idx = tracking_rect_index(self);
+  NSPoint loc = [theEvent locationInWindow];
+  NSPoint lastPoint = _lastPoint;
+  NSUInteger count;
+
+  if (idx->count == 0)
+    return;
+
+  count = near_tracking_rect_count(idx, loc, lastPoint);
+  {
+    NSUInteger items[count];
+    NSUInteger j;
+
+    count = near_tracking_rects(idx, loc, lastPoint, items);
+    for (j = 0; j < count; j++)
+      {
+        NSUInteger i = items[j];
+        GSTrackingRect *r = idx->rects[i];
+        BOOL last;
+        BOOL now;
+
+        if (idx->views[i] != nil || [r isValid] == NO)
+          continue;
+
+        /*
+         * Check for presence of point in rectangle.
+         */
+        last = NSMouseInRect(lastPoint, r->rectangle, NO);
+        now = NSMouseInRect(loc, r->rectangle, NO);
+
+        // Mouse entered or exited
+        if (last != now)
+          {
+            NSEvent *e;
+
+            e = [NSEvent enterExitEventWithType: NSCursorUpdate
+              location: loc
+              modifierFlags: [theEvent modifierFlags]
+              timestamp: 0
+              windowNumber: [theEvent windowNumber]
+              context: [theEvent context]
+              eventNumber: 0
+              trackingNumber: (int)now
+              userData: (void*)r];
+            [self postEvent: e atStart: YES];
+          }
+      }
+  }
 }
 
 - (void) _processResizeEvent
@@ -3731,9 +4493,11 @@ resetCursorRectsForView(NSView *theView)
       return;
     }
 
+  GS_PROBE2(window_send_event_entry, self, theEvent);
+
   if (!_f.cursor_rects_valid)
     {
-      [self resetCursorRects];
+      [self _resetInvalidCursorRects];
     }
 
   type = [theEvent type];
@@ -3741,6 +4505,7 @@ resetCursorRectsForView(NSView *theView)
     && GSMouseEventMask == NSEventMaskFromType(type))
     {
       NSDebugLLog(@"NSEvent", @"Discard (window ignoring mouse) %@", theEvent);
+      GS_PROBE2(window_send_event_return, self, theEvent);
       return;
     }
 
@@ -3795,6 +4560,7 @@ resetCursorRectsForView(NSView *theView)
                   // Only try to set first responder, when the view wants it.
                   if ([v acceptsFirstResponder] && ![self makeFirstResponder: v])
                     {
+                      GS_PROBE2(window_send_event_return, self, theEvent);
                       return;
                     }
                 }
@@ -3905,6 +4671,7 @@ resetCursorRectsForView(NSView *theView)
                     }
                   else
                     {
+                      [GSToolTips trackMouseMoved: theEvent];
                       [v mouseMoved: theEvent];
                     }
                 }
@@ -3916,7 +4683,7 @@ resetCursorRectsForView(NSView *theView)
          * a tracking rectangle then we need to determine if we should send
          * a NSMouseEntered or NSMouseExited event.
          */
-        (*ctImp)(self, ctSel, _wv, theEvent);
+        [self _checkTrackingRectanglesForEvent: theEvent];
         
         if (_f.is_key)
           {
@@ -3926,7 +4693,7 @@ resetCursorRectsForView(NSView *theView)
              * cursor update event.
              */
             if (_f.cursor_rects_enabled)
-                (*ccImp)(self, ccSel, _wv, theEvent);
+                [self _checkCursorRectanglesForEvent: theEvent];
           }
         
         _lastPoint = [theEvent locationInWindow];
@@ -4052,6 +4819,8 @@ resetCursorRectsForView(NSView *theView)
                        * so we add it to the rectangle to be flushed
                        * and set the flag to say that a flush is required.
                        */
+                      GSAddRegionRect(_rectsNeedingFlush,
+                                      &_rectsNeedingFlushCount, region);
                       _rectNeedingFlush
                         = NSUnionRect(_rectNeedingFlush, region);
                       _f.needs_flush = YES;
@@ -4136,7 +4905,7 @@ resetCursorRectsForView(NSView *theView)
                * We need to go through all of the views, and if there
                * is any with a tracking rectangle then we need to
                * determine if we should send a NSMouseExited event.  */
-              (*ctImp)(self, ctSel, _wv, theEvent);
+              [self _checkTrackingRectanglesForEvent: theEvent];
 
               if (_f.is_key)
                 {
@@ -4146,7 +4915,7 @@ resetCursorRectsForView(NSView *theView)
                    * to determine if we should send a cursor update
                    * event.  */
                   if (_f.cursor_rects_enabled)
-                    (*ccImp)(self, ccSel, _wv, theEvent);
+                    [self _checkCursorRectanglesForEvent: theEvent];
                 }
               
               _lastPoint = NSMakePoint(-1, -1);
@@ -4353,6 +5122,7 @@ resetCursorRectsForView(NSView *theView)
         // FIXME: Tablet events
         break;
     }
+  GS_PROBE2(window_send_event_return, self, theEvent);
 }
 
 - (BOOL) shouldBeTreatedAsInkEvent: (NSEvent *)theEvent
@@ -5617,6 +6387,68 @@ current key view.<br />
   _f.visible = flag;
 }
 
+/* Views are told about the live resize before their subviews, so a view
+   which is drawn from a copy during the resize knows whether a view
+   around it is.  */
+static void
+start_live_resize(NSView *view)
+{
+  NSArray *subviews;
+  NSUInteger count, i;
+
+  [view viewWillStartLiveResize];
+  subviews = [view subviews];
+  count = [subviews count];
+  for (i = 0; i < count; i++)
+    {
+      start_live_resize([subviews objectAtIndex: i]);
+    }
+}
+
+static void
+end_live_resize(NSView *view)
+{
+  NSArray *subviews;
+  NSUInteger count, i;
+
+  [view viewDidEndLiveResize];
+  subviews = [view subviews];
+  count = [subviews count];
+  for (i = 0; i < count; i++)
+    {
+      end_live_resize([subviews objectAtIndex: i]);
+    }
+}
+
+- (void) _startLiveResize
+{
+  if (_f.in_live_resize)
+    {
+      return;
+    }
+  /* Copies are taken from the window, so it must show what it should. */
+  [self displayIfNeeded];
+  _f.in_live_resize = YES;
+  [[NSNotificationCenter defaultCenter]
+    postNotificationName: NSWindowWillStartLiveResizeNotification
+                  object: self];
+  start_live_resize(_wv);
+}
+
+- (void) _endLiveResize
+{
+  if (_f.in_live_resize == NO)
+    {
+      return;
+    }
+  _f.in_live_resize = NO;
+  end_live_resize(_wv);
+  [[NSNotificationCenter defaultCenter]
+    postNotificationName: NSWindowDidEndLiveResizeNotification
+                  object: self];
+  [self displayIfNeeded];
+}
+
 - (void) performDeminiaturize: sender
 {
   [self deminiaturize: sender];
@@ -5669,6 +6501,7 @@ current key view.<br />
 //  _f.has_shadow = NO;
   _f.is_opaque = YES;
   _f.views_need_display = YES;
+  _f.preserves_content_during_live_resize = YES;
   _f.selectionDirection = NSDirectSelection;
 }
 
@@ -49,6 +49,7 @@
 
 #import <Foundation/NSBundle.h>
 #import <Foundation/NSData.h>
+#import <Foundation/NSDate.h>
 #import <Foundation/NSDictionary.h>
 #import <Foundation/NSHost.h>
 #import <Foundation/NSLock.h>
@@ -60,11 +61,15 @@
 #import <Foundation/NSException.h>
 #import <Foundation/NSFileManager.h>
 #import <Foundation/NSNotificationQueue.h>
+#import <Foundation/NSNull.h>
+#import <Foundation/NSRunLoop.h>
+#import <Foundation/NSSet.h>
 #import <Foundation/NSDistributedNotificationCenter.h>
 #import <Foundation/NSConnection.h>
 #import <Foundation/NSDebug.h>
 #import <Foundation/NSProcessInfo.h>
 #import <Foundation/NSThread.h>
+#import <Foundation/NSTimer.h>
 #import <Foundation/NSURL.h>
 #import <Foundation/NSValue.h>
 #import "AppKit/NSWorkspace.h"
@@ -78,6 +83,8 @@
 #import "GNUstepGUI/GSServicesManager.h"
 #import "GNUstepGUI/GSDisplayServer.h"
 #import "GSGuiPrivate.h"
+#import "GSThumbnailService.h"
+#import "GSFileWatcher.h"
 
 /* Informal protocol for method to ask an app to open a URL.
  */
@@ -94,7 +101,6 @@
 #define PosixExecutePermission	(0111)
 
 static NSMutableDictionary *folderPathIconDict = nil;
-static NSMutableDictionary *folderIconCache = nil;
 
 static NSImage	*folderImage = nil;
 static NSImage	*multipleFiles = nil;
@@ -102,6 +108,182 @@ static NSImage	*unknownApplication = nil;
 static NSImage	*unknownTool = nil;
 
 
+/* The default number of icons kept by the icon cache. */
+#define ICON_CACHE_SIZE 256
+
+/*
+ * An entry of the icon cache, linked into a list ordered by use.
+ * The links are not retained; the cache's dictionary owns the entries.
+ */
+@interface GSIconCacheEntry : NSObject
+{
+@public
+  NSString		*key;
+  NSImage		*image;
+  GSIconCacheEntry	*prev;
+  GSIconCacheEntry	*next;
+}
+@end
+
+@implementation GSIconCacheEntry
+- (void) dealloc
+{
+  RELEASE(key);
+  RELEASE(image);
+  [super dealloc];
+}
+@end
+
+/*
+ * Keeps the most recently used icons of file types and folders, up to a
+ * fixed number of them. Type icons are keyed by "e" and the lowercase
+ * extension, folder icons by "d" and the standardized path.
+ */
+@interface GSIconCache : NSObject
+{
+  NSMutableDictionary	*entries;
+  GSIconCacheEntry	*head;	/* Most recently used. */
+  GSIconCacheEntry	*tail;	/* Least recently used. */
+  NSUInteger		capacity;
+  NSUInteger		hits;
+  NSUInteger		misses;
+  NSUInteger		evictions;
+}
+- (id) initWithCapacity: (NSUInteger)aNumber;
+- (NSImage*) imageForKey: (NSString*)aKey;
+- (void) setImage: (NSImage*)anImage forKey: (NSString*)aKey;
+- (void) removeImageForKey: (NSString*)aKey;
+- (void) removeImagesWithKeyPrefix: (NSString*)aPrefix;
+- (void) removeAllImages;
+- (NSDictionary*) statistics;
+@end
+
+@implementation GSIconCache
+
+- (id) initWithCapacity: (NSUInteger)aNumber
+{
+  if ((self = [super init]) != nil)
+    {
+      capacity = (aNumber > 0) ? aNumber : ICON_CACHE_SIZE;
+      entries = [[NSMutableDictionary alloc] initWithCapacity: capacity];
+    }
+  return self;
+}
+
+- (void) dealloc
+{
+  RELEASE(entries);
+  [super dealloc];
+}
+
+- (void) _unlink: (GSIconCacheEntry*)entry
+{
+  if (entry->prev != nil)
+    entry->prev->next = entry->next;
+  else
+    head = entry->next;
+  if (entry->next != nil)
+    entry->next->prev = entry->prev;
+  else
+    tail = entry->prev;
+  entry->prev = entry->next = nil;
+}
+
+- (void) _push: (GSIconCacheEntry*)entry
+{
+  entry->next = head;
+  if (head != nil)
+    head->prev = entry;
+  head = entry;
+  if (tail == nil)
+    tail = entry;
+}
+
+- (NSImage*) imageForKey: (NSString*)aKey
+{
+  GSIconCacheEntry	*entry = [entries objectForKey: aKey];
+
+  if (entry == nil)
+    {
+      misses++;
+      return nil;
+    }
+  hits++;
+  if (entry != head)
+    {
+      [self _unlink: entry];
+      [self _push: entry];
+    }
+  return entry->image;
+}
+
+- (void) setImage: (NSImage*)anImage forKey: (NSString*)aKey
+{
+  GSIconCacheEntry	*entry;
+
+  [self removeImageForKey: aKey];
+  if (anImage == nil)
+    {
+      return;
+    }
+  while ([entries count] >= capacity && tail != nil)
+    {
+      evictions++;
+      [self removeImageForKey: tail->key];
+    }
+  entry = [GSIconCacheEntry new];
+  entry->key = [aKey copy];
+  entry->image = RETAIN(anImage);
+  [self _push: entry];
+  [entries setObject: entry forKey: entry->key];
+  RELEASE(entry);
+}
+
+- (void) removeImageForKey: (NSString*)aKey
+{
+  GSIconCacheEntry	*entry = [entries objectForKey: aKey];
+
+  if (entry != nil)
+    {
+      [self _unlink: entry];
+      [entries removeObjectForKey: aKey];
+    }
+}
+
+- (void) removeImagesWithKeyPrefix: (NSString*)aPrefix
+{
+  NSEnumerator	*enumerator = [[entries allKeys] objectEnumerator];
+  NSString	*key;
+
+  while ((key = [enumerator nextObject]) != nil)
+    {
+      if ([key hasPrefix: aPrefix])
+	{
+	  [self removeImageForKey: key];
+	}
+    }
+}
+
+- (void) removeAllImages
+{
+  [entries removeAllObjects];
+  head = tail = nil;
+}
+
+- (NSDictionary*) statistics
+{
+  return [NSDictionary dictionaryWithObjectsAndKeys:
+    [NSNumber numberWithUnsignedInteger: hits], @"Hits",
+    [NSNumber numberWithUnsignedInteger: misses], @"Misses",
+    [NSNumber numberWithUnsignedInteger: evictions], @"Evictions",
+    [NSNumber numberWithUnsignedInteger: [entries count]], @"Entries",
+    [NSNumber numberWithUnsignedInteger: capacity], @"Capacity",
+    nil];
+}
+
+@end
+
+
 static NSString	*GSWorkspaceNotification = @"GSWorkspaceNotification";
 static NSString *GSWorkspacePreferencesChanged =
     @"GSWorkspacePreferencesChanged";
@@ -264,20 +446,41 @@ static id GSLaunched(NSNotification *notification, BOOL active)
     }
 }
 
+/*
+ * A notification posted within this many seconds of one with the same
+ * name is held back and sent to other applications in a batch with the
+ * ones following it.  A batch is sent when the burst is over, when it is
+ * full, or when a notification with another name is posted, so that
+ * notifications always arrive in the order they were posted.
+ */
+#define	BATCH_DELAY	0.05
+#define	BATCH_MAX	100
+
+/* The key of the userInfo array of a batch sent between applications. */
+static NSString	*GSBatchedUserInfo = @"GSBatchedUserInfo";
+
 @interface	_GSWorkspaceCenter: NSNotificationCenter
 {
   NSNotificationCenter	*remote;
+  NSString		*lastName;	// Name of the last notification posted
+  NSTimeInterval	lastPost;	// and when it was posted.
+  NSMutableArray	*batch;		// The userInfo held back for lastName.
 }
 - (void) _handleRemoteNotification: (NSNotification*)aNotification;
 - (void) _postLocal: (NSString*)name userInfo: (NSDictionary*)info;
+- (void) _postRemote: (NSString*)name userInfo: (NSDictionary*)info;
+- (void) _sendBatch;
 @end
 
 @implementation	_GSWorkspaceCenter
 
 - (void) dealloc
 {
+  [self _sendBatch];
+  [[NSNotificationCenter defaultCenter] removeObserver: self];
   [remote removeObserver: self name: nil object: GSWorkspaceNotification];
   RELEASE(remote);
+  RELEASE(lastName);
   [super dealloc];
 }
 
@@ -309,6 +512,11 @@ static id GSLaunched(NSNotification *notification, BOOL active)
 	    }
 	}
       NS_ENDHANDLER
+      [[NSNotificationCenter defaultCenter]
+	addObserver: self
+	   selector: @selector(_sendBatch)
+	       name: NSApplicationWillTerminateNotification
+	     object: nil];
     }
   return self;
 }
@@ -317,12 +525,14 @@ static id GSLaunched(NSNotification *notification, BOOL active)
  * Post notification remotely - since we are listening for distributed
  * notifications, we will observe the notification arriving from the
  * distributed notification center, and it will get sent out locally too.
+ * A notification following one with the same name closely is held back
+ * and sent in a batch.
  */
 - (void) postNotification: (NSNotification*)aNotification
 {
-  NSNotification	*rem;
   NSString		*name = [aNotification name];
   NSDictionary		*info = [aNotification userInfo];
+  NSTimeInterval	now = [NSDate timeIntervalSinceReferenceDate];
 
   if ([name isEqual: NSWorkspaceDidTerminateApplicationNotification] == YES
     || [name isEqual: NSWorkspaceDidLaunchApplicationNotification] == YES
@@ -332,6 +542,76 @@ static id GSLaunched(NSNotification *notification, BOOL active)
       GSLaunched(aNotification, YES);
     }
 
+  if (batch != nil && [name isEqualToString: lastName] == NO)
+    {
+      [self _sendBatch];
+    }
+  if (batch == nil)
+    {
+      if (now - lastPost < BATCH_DELAY && [name isEqualToString: lastName])
+	{
+	  batch = [NSMutableArray new];
+	  [[NSRunLoop currentRunLoop]
+	    performSelector: @selector(_sendBatch)
+		     target: self
+		   argument: nil
+		      order: 0
+		      modes: [NSArray arrayWithObjects: NSDefaultRunLoopMode,
+			NSModalPanelRunLoopMode, NSEventTrackingRunLoopMode,
+			nil]];
+	}
+      else
+	{
+	  ASSIGN(lastName, name);
+	  lastPost = now;
+	  [self _postRemote: name userInfo: info];
+	  return;
+	}
+    }
+  [batch addObject: (info == nil) ? (id)[NSNull null] : (id)info];
+  lastPost = now;
+  if ([batch count] >= BATCH_MAX)
+    {
+      [self _sendBatch];
+    }
+}
+
+/*
+ * Sends the notifications held back, if any.  While more keep coming,
+ * the batch is not sent before the burst is over or the batch is full.
+ */
+- (void) _sendBatch
+{
+  NSMutableArray	*infos = batch;
+
+  if (infos == nil)
+    {
+      return;
+    }
+  [[NSRunLoop currentRunLoop] cancelPerformSelector: @selector(_sendBatch)
+					     target: self
+					   argument: nil];
+  batch = nil;
+  if ([infos count] == 1)
+    {
+      id	info = [infos objectAtIndex: 0];
+
+      [self _postRemote: lastName
+	       userInfo: (info == [NSNull null]) ? nil : info];
+    }
+  else if ([infos count] > 1)
+    {
+      [self _postRemote: lastName
+	       userInfo: [NSDictionary dictionaryWithObject: infos
+						     forKey: GSBatchedUserInfo]];
+    }
+  RELEASE(infos);
+}
+
+- (void) _postRemote: (NSString*)name userInfo: (NSDictionary*)info
+{
+  NSNotification	*rem;
+
   rem = [NSNotification notificationWithName: name
 				      object: GSWorkspaceNotification
 				    userInfo: info];
@@ -378,8 +658,26 @@ static id GSLaunched(NSNotification *notification, BOOL active)
  */
 - (void) _handleRemoteNotification: (NSNotification*)aNotification
 {
-  [self _postLocal: [aNotification name]
-	  userInfo: [aNotification userInfo]];
+  NSString	*name = [aNotification name];
+  NSDictionary	*info = [aNotification userInfo];
+  NSArray	*infos = [info objectForKey: GSBatchedUserInfo];
+  NSEnumerator	*e;
+  id		o;
+
+  if (infos == nil)
+    {
+      infos = [NSArray arrayWithObject:
+	(info == nil) ? (id)[NSNull null] : (id)info];
+    }
+  e = [infos objectEnumerator];
+  while ((o = [e nextObject]) != nil)
+    {
+      [self _postLocal: name userInfo: (o == [NSNull null]) ? nil : o];
+    }
+  [self _postLocal: GSWorkspaceBatchNotification
+	  userInfo: [NSDictionary dictionaryWithObjectsAndKeys:
+	    name, GSWorkspaceBatchNameKey,
+	    infos, GSWorkspaceBatchUserInfoKey, nil]];
 }
 
 /*
@@ -397,6 +695,112 @@ static id GSLaunched(NSNotification *notification, BOOL active)
 @end
 
 
+/*
+ * A request to launch an application or to open a file with it, made
+ * without waiting for the application to start.  The request is answered
+ * once, when the application registers, when it dies or when the timeout
+ * for the request runs out, with
+ *
+ *   [target performSelector: selector withObject: subject withObject: result]
+ *
+ * where subject is the application name or the file path and result is
+ * an NSNumber holding YES or NO.
+ */
+@interface	GSLaunchRequest : NSObject
+{
+@public
+  NSString	*appName;
+  NSString	*file;		// File to open, nil for a launch.
+  BOOL		deactivate;
+  BOOL		sent;		// File was passed on the command line.
+  id		target;
+  SEL		selector;
+  NSTimer	*timer;
+  NSMutableArray	*queue;	// Requests waiting for the same app.
+}
+- (void) answer: (BOOL)result;
+- (void) completeWithApplication: (id)app;
+- (void) startTimer: (NSTimeInterval)timeout;
+@end
+
+@implementation	GSLaunchRequest
+
+- (void) dealloc
+{
+  RELEASE(appName);
+  RELEASE(file);
+  RELEASE(target);
+  [super dealloc];
+}
+
+- (void) answer: (BOOL)result
+{
+  [timer invalidate];
+  timer = nil;
+  [queue removeObjectIdenticalTo: self];
+  queue = nil;
+  [target performSelector: selector
+	       withObject: (file == nil) ? appName : file
+	       withObject: [NSNumber numberWithBool: result]];
+  DESTROY(target);
+}
+
+- (void) completeWithApplication: (id)app
+{
+  BOOL	result = (app != nil);
+
+  if (app != nil && file != nil && sent == NO)
+    {
+      NS_DURING
+	{
+	  if (deactivate == NO)
+	    {
+	      [app application: NSApp openFileWithoutUI: file];
+	    }
+	  else
+	    {
+	      [app application: NSApp openFile: file];
+	      [NSApp deactivate];
+	    }
+	}
+      NS_HANDLER
+	{
+	  NSWarnLog(@"Failed to contact '%@' to open file", appName);
+	  result = NO;
+	}
+      NS_ENDHANDLER
+    }
+  RETAIN(self);
+  [self answer: result];
+  RELEASE(self);
+}
+
+- (void) startTimer: (NSTimeInterval)timeout
+{
+  NSRunLoop	*loop = [NSRunLoop currentRunLoop];
+
+  /* The timer retains the request, which keeps it alive until answered.
+   */
+  timer = [NSTimer timerWithTimeInterval: timeout
+				  target: self
+				selector: @selector(timedOut:)
+				userInfo: nil
+				 repeats: NO];
+  [loop addTimer: timer forMode: NSDefaultRunLoopMode];
+  [loop addTimer: timer forMode: NSModalPanelRunLoopMode];
+  [loop addTimer: timer forMode: NSEventTrackingRunLoopMode];
+}
+
+- (void) timedOut: (NSTimer*)t
+{
+  timer = nil;
+  NSWarnLog(@"Timed out waiting for '%@' to start", appName);
+  [self answer: NO];
+}
+
+@end
+
+
 @interface NSWorkspace (Private)
 
 // Icon handling
@@ -404,6 +808,7 @@ static id GSLaunched(NSNotification *notification, BOOL active)
 - (NSImage*) unknownFiletypeImage;
 - (NSImage*) _saveImageFor: (NSString*)iconPath;
 - (NSString*) thumbnailForFile: (NSString *)file;
+- (NSString*) _thumbnailURIForFile: (NSString *)file;
 - (NSImage*) _iconForExtension: (NSString*)ext;
 - (BOOL) _extension: (NSString*)ext
                role: (NSString*)role
@@ -411,13 +816,27 @@ static id GSLaunched(NSNotification *notification, BOOL active)
 - (BOOL) _scheme: (NSString*)scheme
 	    role: (NSString*)role
 	     app: (NSString**)app;
+- (BOOL) _lookupExtension: (NSString*)ext
+		     role: (NSString*)role
+		      app: (NSString**)app;
+- (BOOL) _lookupScheme: (NSString*)scheme
+		  role: (NSString*)role
+		   app: (NSString**)app;
 - (void) _workspacePreferencesChanged: (NSNotification *)aNotification;
+- (void) _directoryChanged: (NSString*)path entries: (NSSet*)names;
 
 // application communication
 - (BOOL) _launchApplication: (NSString*)appName
 		  arguments: (NSArray*)args;
 - (id) _connectApplication: (NSString*)appName;
+- (id) _runningApplication: (NSString*)appName;
+- (NSString*) _workspaceApplicationName;
 - (id) _workspaceApplication;
+- (void) _addLaunchRequest: (GSLaunchRequest*)request
+		 arguments: (NSArray*)args
+		   timeout: (NSTimeInterval)timeout;
+- (void) _applicationDidLaunch: (NSNotification*)aNotification;
+- (void) _applicationDidTerminate: (NSNotification*)aNotification;
 
 @end
 
@@ -527,9 +946,78 @@ static NSDictionary		*extPreferences = nil;
 
 static NSString			*urlPrefPath = nil;
 static NSDictionary		*urlPreferences = nil;
+
+/*
+ * The modification date and size of each file when it was last read, so
+ * that a file is only read again when it has changed.
+ */
+static NSString			*appListStamp = nil;
+static NSString			*extPrefStamp = nil;
+static NSString			*urlPrefStamp = nil;
+
+/*
+ * Answers found for extensions and URL schemes (keyed by role and
+ * extension or scheme), and the executables found for application
+ * names.  NSNull stands for no answer.  They are dropped when the
+ * preferences or the application list they were found from change.
+ */
+static NSMutableDictionary	*extensionApps = nil;
+static NSMutableDictionary	*schemeApps = nil;
+static NSMutableDictionary	*appBinaries = nil;
+
 // FIXME: Won't work for MINGW32
 static NSString			*_rootPath = @"/";
 
+static NSString *
+fileStamp(NSString *path)
+{
+  NSDictionary	*attrs;
+
+  attrs = [[NSFileManager defaultManager] fileAttributesAtPath: path
+						  traverseLink: YES];
+  if (attrs == nil)
+    {
+      return nil;
+    }
+  return [NSString stringWithFormat: @"%f %llu",
+    [[attrs fileModificationDate] timeIntervalSinceReferenceDate],
+    [attrs fileSize]];
+}
+
+/*
+ * Reads the property list at path into *dict unless the file is unchanged
+ * since *stamp was taken.  Returns YES if it was read.
+ */
+static BOOL
+reloadIfChanged(NSString *path, NSDictionary **dict, NSString **stamp)
+{
+  NSString	*s = fileStamp(path);
+  NSData	*data;
+  NSDictionary	*d;
+
+  if (s == nil || [s isEqualToString: *stamp] == YES)
+    {
+      return NO;
+    }
+  data = [NSData dataWithContentsOfFile: path];
+  if (data == nil)
+    {
+      return NO;
+    }
+  d = [NSDeserializer deserializePropertyListFromData: data
+				    mutableContainers: NO];
+  ASSIGN(*dict, d);
+  ASSIGN(*stamp, s);
+  return YES;
+}
+
+static NSString *
+roleKey(NSString *role, NSString *name)
+{
+  return [NSString stringWithFormat: @"%@ %@",
+    (role == nil) ? (id)@"" : (id)role, name];
+}
+
 /*
  * Class methods
  */
@@ -538,10 +1026,7 @@ static NSString			*_rootPath = @"/";
   if (self == [NSWorkspace class])
     {
       static BOOL	beenHere = NO;
-      NSFileManager	*mgr = [NSFileManager defaultManager];
       NSString		*service;
-      NSData		*data;
-      NSDictionary	*dict;
 
       [self setVersion: 1];
 
@@ -566,16 +1051,7 @@ static NSString			*_rootPath = @"/";
 	  extPrefPath = [service
 	    stringByAppendingPathComponent: @".GNUstepExtPrefs"];
 	  RETAIN(extPrefPath);
-	  if ([mgr isReadableFileAtPath: extPrefPath] == YES)
-	    {
-	      data = [NSData dataWithContentsOfFile: extPrefPath];
-	      if (data)
-		{
-		  dict = [NSDeserializer deserializePropertyListFromData: data
-					 mutableContainers: NO];
-		  extPreferences = RETAIN(dict);
-		}
-	    }
+	  reloadIfChanged(extPrefPath, &extPreferences, &extPrefStamp);
 	  
 	  /*
 	   *	Load URL scheme preferences.
@@ -583,16 +1059,7 @@ static NSString			*_rootPath = @"/";
 	  urlPrefPath = [service
 	    stringByAppendingPathComponent: @".GNUstepURLPrefs"];
 	  RETAIN(urlPrefPath);
-	  if ([mgr isReadableFileAtPath: urlPrefPath] == YES)
-	    {
-	      data = [NSData dataWithContentsOfFile: urlPrefPath];
-	      if (data)
-		{
-		  dict = [NSDeserializer deserializePropertyListFromData: data
-					 mutableContainers: NO];
-		  urlPreferences = RETAIN(dict);
-		}
-	    }
+	  reloadIfChanged(urlPrefPath, &urlPreferences, &urlPrefStamp);
 	  
 	  /*
 	   *	Load cached application information.
@@ -600,16 +1067,11 @@ static NSString			*_rootPath = @"/";
 	  appListPath = [service
 	    stringByAppendingPathComponent: @".GNUstepAppList"];
 	  RETAIN(appListPath);
-	  if ([mgr isReadableFileAtPath: appListPath] == YES)
-	    {
-	      data = [NSData dataWithContentsOfFile: appListPath];
-	      if (data)
-		{
-		  dict = [NSDeserializer deserializePropertyListFromData: data
-					 mutableContainers: NO];
-		  applications = RETAIN(dict);
-		}
-	    }
+	  reloadIfChanged(appListPath, &applications, &appListStamp);
+
+	  extensionApps = [NSMutableDictionary new];
+	  schemeApps = [NSMutableDictionary new];
+	  appBinaries = [NSMutableDictionary new];
 	}
       NS_HANDLER
 	{
@@ -690,8 +1152,20 @@ static NSString			*_rootPath = @"/";
     object: nil];
 
   _workspaceCenter = [_GSWorkspaceCenter new];
-  _iconMap = [NSMutableDictionary new];
+  _iconCache = [[GSIconCache alloc] initWithCapacity:
+    [[NSUserDefaults standardUserDefaults] integerForKey: @"GSIconCacheSize"]];
   _launched = [NSMutableDictionary new];
+  _pendingLaunches = [NSMutableDictionary new];
+  [_workspaceCenter
+    addObserver: self
+    selector: @selector(_applicationDidLaunch:)
+    name: NSWorkspaceDidLaunchApplicationNotification
+    object: nil];
+  [[NSNotificationCenter defaultCenter]
+    addObserver: self
+    selector: @selector(_applicationDidTerminate:)
+    name: NSTaskDidTerminateNotification
+    object: nil];
   if (applications == nil)
     {
       [self findApplications];
@@ -757,7 +1231,6 @@ static NSString			*_rootPath = @"/";
       [folderPathIconDict setObject: @"Desktop"
 	forKey: [desktopDir objectAtIndex: i]];
     }
-  folderIconCache = [[NSMutableDictionary alloc] init];
 
   return self;
 }
@@ -1308,7 +1781,23 @@ inFileViewerRootedAtPath: (NSString*)rootFullpath
   if ([fileType isEqual: NSFileTypeDirectory] == YES)
     {
       NSString *iconPath = nil;
-      
+      NSString *key;
+
+      /* Looking for the icon of a folder means probing it and maybe
+       * loading a bundle, so the result is kept until the folder is
+       * reported as changed.
+       */
+      key = [@"d" stringByAppendingString:
+		    [fullPath stringByStandardizingPath]];
+      if ((image = [_iconCache imageForKey: key]) != nil)
+	{
+	  return image;
+	}
+      [[GSFileWatcher sharedWatcher]
+	addObserver: self
+	   selector: @selector(_directoryChanged:entries:)
+       forDirectory: fullPath];
+
       if ([pathExtension isEqualToString: @"app"]
 	|| [pathExtension isEqualToString: @"debug"]
 	|| [pathExtension isEqualToString: @"profile"])
@@ -1320,7 +1809,9 @@ inFileViewerRootedAtPath: (NSString*)rootFullpath
 	      /*
                * Just use the appropriate icon for the path extension
                */
-              return [self _iconForExtension: pathExtension];
+              image = [self _iconForExtension: pathExtension];
+	      [_iconCache setImage: image forKey: key];
+              return image;
 	    }
 	}
 
@@ -1357,16 +1848,7 @@ inFileViewerRootedAtPath: (NSString*)rootFullpath
 	      iconName = [folderPathIconDict objectForKey: fullPath];
 	      if (iconName != nil)
 		{
-		  NSImage *iconImage;
-
-		  iconImage = [folderIconCache objectForKey: iconName];
-		  if (iconImage == nil)
-		    {
-		      iconImage = [NSImage _standardImageWithName: iconName];
-		      /* the dictionary retains the image */
-		      [folderIconCache setObject: iconImage forKey: iconName];
-		    }
-		  image = iconImage;
+		  image = [NSImage _standardImageWithName: iconName];
 		}
 	      else
 		{
@@ -1380,6 +1862,7 @@ inFileViewerRootedAtPath: (NSString*)rootFullpath
 	    }
 
 	}
+      [_iconCache setImage: image forKey: key];
     }
   else
     {
@@ -1505,11 +1988,24 @@ inFileViewerRootedAtPath: (NSString*)rootFullpath
 - (void) noteFileSystemChanged
 {
   _fileSystemChanged = YES;
+  [_iconCache removeAllImages];
 }
 
 - (void) noteFileSystemChanged: (NSString*)path
 {
+  NSString	*key;
+
   _fileSystemChanged = YES;
+  /* Forget the icons of the path, the folders inside it and the folder
+   * holding it, which may have had its .dir.png changed.
+   */
+  path = [path stringByStandardizingPath];
+  key = [@"d" stringByAppendingString: path];
+  [_iconCache removeImageForKey: key];
+  [_iconCache removeImagesWithKeyPrefix:
+    [key stringByAppendingString: @"/"]];
+  [_iconCache removeImageForKey:
+    [@"d" stringByAppendingString: [path stringByDeletingLastPathComponent]]];
 }
 
 /**
@@ -2272,10 +2768,27 @@ launchIdentifiers: (NSArray **)identifiers
 {
   NSString	*path;
   NSString	*file;
-  NSBundle	*bundle = [self bundleForApp: appName];
+  NSBundle	*bundle;
+  BOOL		plain = ([appName rangeOfString: @"/"].length == 0);
 
+  /* A plain application name is looked up in the application list, so
+   * the answer holds until the list changes.
+   */
+  if (plain == YES && appName != nil)
+    {
+      path = [appBinaries objectForKey: appName];
+      if (path != nil)
+	{
+	  return (path == (id)[NSNull null]) ? nil : path;
+	}
+    }
+  bundle = [self bundleForApp: appName];
   if (bundle == nil)
     {
+      if (plain == YES && appName != nil)
+	{
+	  [appBinaries setObject: [NSNull null] forKey: appName];
+	}
       return nil;
     }
   path = [bundle bundlePath];
@@ -2309,6 +2822,10 @@ launchIdentifiers: (NSArray **)identifiers
 	}
     }
 
+  if (plain == YES)
+    {
+      [appBinaries setObject: path forKey: appName];
+    }
   return path;
 }
 
@@ -2362,6 +2879,7 @@ launchIdentifiers: (NSArray **)identifiers
   RELEASE(inf);
   RELEASE(extPreferences);
   extPreferences = map;
+  [extensionApps removeAllObjects];
   data = [NSSerializer serializePropertyList: extPreferences];
   if ([data writeToFile: extPrefPath atomically: YES])
     {
@@ -2497,6 +3015,7 @@ launchIdentifiers: (NSArray **)identifiers
   RELEASE(inf);
   RELEASE(urlPreferences);
   urlPreferences = map;
+  [schemeApps removeAllObjects];
   data = [NSSerializer serializePropertyList: urlPreferences];
   if ([data writeToFile: urlPrefPath atomically: YES])
     {
@@ -2509,6 +3028,187 @@ launchIdentifiers: (NSArray **)identifiers
     }
 }
 
+/**
+ * Looks up or makes a 128 pixel thumbnail of fullPath in the background,
+ * sharing the freedesktop.org thumbnail cache with other programs.<br />
+ * When done, the following is sent to target on the main thread, where
+ * image is nil if no thumbnail could be made:
+ * <example>
+ * [target performSelector: aSelector withObject: image withObject: fullPath]
+ * </example>
+ * Requests for a file that is already being worked on are answered
+ * together. The size of the cache in bytes is limited by the
+ * GSThumbnailCacheSize user default.
+ */
+/**
+ * Returns counters of the icon cache used by -iconForFile: and
+ * -iconForFileType:, as NSNumbers for the keys Hits, Misses, Evictions,
+ * Entries and Capacity. The capacity is set by the GSIconCacheSize user
+ * default.
+ */
+- (NSDictionary*) iconCacheStatistics
+{
+  return [_iconCache statistics];
+}
+
+- (void) requestThumbnailForFile: (NSString*)fullPath
+			  target: (id)target
+			selector: (SEL)aSelector
+{
+  fullPath = [fullPath stringByStandardizingPath];
+  [[GSThumbnailService sharedService]
+    requestThumbnailForFile: fullPath
+	      thumbnailPath: [self thumbnailForFile: fullPath]
+			URI: [self _thumbnailURIForFile: fullPath]
+		     target: target
+		   selector: aSelector];
+}
+
+/**
+ * Launches the application like -launchApplication:showIcon:autolaunch:
+ * but returns at once.  When the application is running, or could not
+ * be started within timeout seconds, the target is sent<br />
+ * [target performSelector: aSelector withObject: appName withObject: result]
+ * <br />where result is an NSNumber holding YES on success or NO on failure.
+ * The target is retained until it has been answered.
+ * A timeout of zero or less means thirty seconds.
+ */
+- (void) launchApplication: (NSString*)appName
+		  showIcon: (BOOL)showIcon
+		autolaunch: (BOOL)autolaunch
+		   timeout: (NSTimeInterval)timeout
+		    target: (id)target
+		  selector: (SEL)aSelector
+{
+  GSLaunchRequest	*request;
+  NSArray		*args = nil;
+  id			app = nil;
+
+  request = AUTORELEASE([GSLaunchRequest new]);
+  ASSIGNCOPY(request->appName, appName);
+  ASSIGN(request->target, target);
+  request->selector = aSelector;
+
+  if ([self _workspaceApplicationName] != nil)
+    {
+      app = [self _runningApplication: [self _workspaceApplicationName]];
+    }
+  if (app != nil)
+    {
+      BOOL	result = NO;
+
+      NS_DURING
+	{
+	  result = [app launchApplication: appName
+				 showIcon: showIcon
+			       autolaunch: autolaunch];
+	}
+      NS_HANDLER
+	{
+	  NSWarnLog(@"Failed to contact workspace application");
+	}
+      NS_ENDHANDLER
+      [request answer: result];
+      return;
+    }
+
+  app = [self _runningApplication: appName];
+  if (app != nil)
+    {
+      [app activateIgnoringOtherApps: YES];
+      [request answer: YES];
+      return;
+    }
+  if (autolaunch == YES)
+    {
+      args = [NSArray arrayWithObjects: @"-autolaunch", @"YES", nil];
+    }
+  [self _addLaunchRequest: request arguments: args timeout: timeout];
+}
+
+/**
+ * Opens the file like -openFile:withApplication:andDeactivate: but returns
+ * at once, without waiting for the application to start.  When the file
+ * has been handed to the application, or that failed or timed out, the
+ * target is sent<br />
+ * [target performSelector: aSelector withObject: fullPath withObject: result]
+ * <br />where result is an NSNumber holding YES on success or NO on failure.
+ * The target is retained until it has been answered.
+ * Files opened with an application which is still starting up are handed
+ * to it as soon as it is running, so many files can be opened at once.
+ * A timeout of zero or less means thirty seconds.
+ */
+- (void) openFile: (NSString*)fullPath
+  withApplication: (NSString*)appName
+    andDeactivate: (BOOL)flag
+	  timeout: (NSTimeInterval)timeout
+	   target: (id)target
+	 selector: (SEL)aSelector
+{
+  GSLaunchRequest	*request;
+  id			app = nil;
+
+  request = AUTORELEASE([GSLaunchRequest new]);
+  ASSIGNCOPY(request->file, fullPath);
+  ASSIGN(request->target, target);
+  request->selector = aSelector;
+  request->deactivate = flag;
+
+  if ([self _workspaceApplicationName] != nil)
+    {
+      app = [self _runningApplication: [self _workspaceApplicationName]];
+    }
+  if (app != nil)
+    {
+      BOOL	result = NO;
+
+      NS_DURING
+	{
+	  result = [app openFile: fullPath
+		 withApplication: appName
+		   andDeactivate: flag];
+	}
+      NS_HANDLER
+	{
+	  NSWarnLog(@"Failed to contact workspace application");
+	}
+      NS_ENDHANDLER
+      [request answer: result];
+      return;
+    }
+
+  if (appName == nil)
+    {
+      NSString	*ext = [fullPath pathExtension];
+
+      if ([self _extension: ext role: nil app: &appName] == NO)
+	{
+	  if ([self _openUnknown: fullPath] == NO)
+	    {
+	      NSWarnLog(@"No known applications for file extension '%@'", ext);
+	      [request answer: NO];
+	    }
+	  else
+	    {
+	      [request answer: YES];
+	    }
+	  return;
+	}
+    }
+  ASSIGNCOPY(request->appName, appName);
+
+  app = [self _runningApplication: appName];
+  if (app != nil)
+    {
+      [request completeWithApplication: app];
+      return;
+    }
+  [self _addLaunchRequest: request
+		arguments: [NSArray arrayWithObjects:
+		  @"-GSFilePath", fullPath, nil]
+		  timeout: timeout];
+}
+
 @end
 
 @implementation NSWorkspace (Private)
@@ -2605,12 +3305,11 @@ launchIdentifiers: (NSArray **)identifiers
   return tmp;
 }
 
-/** Returns the freedesktop thumbnail file name for a given file name */
-- (NSString*) thumbnailForFile: (NSString *)file
+/** Returns the URI of a file as used by the freedesktop thumbnail
+    specification */
+- (NSString*) _thumbnailURIForFile: (NSString *)file
 {
   NSString *absolute;
-  NSString *digest;
-  NSString *thumbnail;
 
   absolute = [[NSURL fileURLWithPath: [file stringByStandardizingPath]] 
 		 absoluteString];
@@ -2623,7 +3322,17 @@ launchIdentifiers: (NSArray **)identifiers
 		       [absolute substringWithRange: 
 				     NSMakeRange(17, [absolute length] - 17)]];
     }
+  return absolute;
+}
 
+/** Returns the freedesktop thumbnail file name for a given file name */
+- (NSString*) thumbnailForFile: (NSString *)file
+{
+  NSString *absolute;
+  NSString *digest;
+  NSString *thumbnail;
+
+  absolute = [self _thumbnailURIForFile: file];
   // FIXME: Not sure which encoding to use here. 
   digest = [[[[absolute dataUsingEncoding: NSASCIIStringEncoding]
 		 md5Digest] hexadecimalRepresentation] lowercaseString];
@@ -2645,7 +3354,8 @@ launchIdentifiers: (NSArray **)identifiers
    * extensions are case-insensitive - convert to lowercase.
    */
   ext = [ext lowercaseString];
-  if ((icon = [_iconMap objectForKey: ext]) == nil)
+  if ((icon = [_iconCache imageForKey: [@"e" stringByAppendingString: ext]])
+    == nil)
     {
       NSDictionary	*prefs;
       NSDictionary	*extInfo;
@@ -2726,7 +3436,8 @@ launchIdentifiers: (NSArray **)identifiers
        */
       if (icon != nil)
 	{
-	  [_iconMap setObject: icon forKey: ext];
+	  [_iconCache setImage: icon
+			forKey: [@"e" stringByAppendingString: ext]];
 	}
     }
   return icon;
@@ -2735,6 +3446,34 @@ launchIdentifiers: (NSArray **)identifiers
 - (BOOL) _extension: (NSString*)ext
                role: (NSString*)role
 	        app: (NSString**)app
+{
+  NSString	*key = roleKey(role, [ext lowercaseString]);
+  NSString	*appName = [extensionApps objectForKey: key];
+
+  if (appName == nil)
+    {
+      if ([self _lookupExtension: ext role: role app: &appName] == NO)
+	{
+	  appName = nil;
+	}
+      [extensionApps setObject: (appName == nil) ? (id)[NSNull null]
+					       : (id)appName
+			forKey: key];
+    }
+  else if (appName == (id)[NSNull null])
+    {
+      appName = nil;
+    }
+  if (appName != nil && app != 0)
+    {
+      *app = appName;
+    }
+  return (appName != nil);
+}
+
+- (BOOL) _lookupExtension: (NSString*)ext
+		     role: (NSString*)role
+		      app: (NSString**)app
 {
   NSEnumerator	*enumerator;
   NSString      *appName = nil;
@@ -2880,6 +3619,34 @@ launchIdentifiers: (NSArray **)identifiers
 - (BOOL) _scheme: (NSString*)scheme
 	    role: (NSString*)role
 	     app: (NSString**)app
+{
+  NSString	*key = roleKey(role, [scheme lowercaseString]);
+  NSString	*appName = [schemeApps objectForKey: key];
+
+  if (appName == nil)
+    {
+      if ([self _lookupScheme: scheme role: role app: &appName] == NO)
+	{
+	  appName = nil;
+	}
+      [schemeApps setObject: (appName == nil) ? (id)[NSNull null]
+					    : (id)appName
+		     forKey: key];
+    }
+  else if (appName == (id)[NSNull null])
+    {
+      appName = nil;
+    }
+  if (appName != nil && app != 0)
+    {
+      *app = appName;
+    }
+  return (appName != nil);
+}
+
+- (BOOL) _lookupScheme: (NSString*)scheme
+		  role: (NSString*)role
+		   app: (NSString**)app
 {
   NSEnumerator	*enumerator;
   NSString      *appName = nil;
@@ -3022,52 +3789,55 @@ launchIdentifiers: (NSArray **)identifiers
     }
 }
 
-- (void) _workspacePreferencesChanged: (NSNotification *)aNotification
+/* Called by the file watcher when a folder whose icon is cached changes.
+ */
+- (void) _directoryChanged: (NSString*)path entries: (NSSet*)names
 {
-  /* FIXME reload only those preferences that really were changed
-   * TODO  add a user info to aNotification, which includes a bitmask
-   *       denoting the updated preference files.
-   */
-  NSFileManager		*mgr = [NSFileManager defaultManager];
-  NSData		*data;
-  NSDictionary		*dict;
+  NSEnumerator	*enumerator;
+  NSString	*name;
 
-  if ([mgr isReadableFileAtPath: extPrefPath] == YES)
+  if (names == nil)
     {
-      data = [NSData dataWithContentsOfFile: extPrefPath];
-      if (data)
-	{
-	  dict = [NSDeserializer deserializePropertyListFromData: data
-					       mutableContainers: NO];
-	  ASSIGN(extPreferences, dict);
-	}
+      [self noteFileSystemChanged: path];
+      return;
     }
-
-  if ([mgr isReadableFileAtPath: urlPrefPath] == YES)
+  _fileSystemChanged = YES;
+  if ([names containsObject: @".dir.png"]
+    || [names containsObject: @".dir.tiff"])
     {
-      data = [NSData dataWithContentsOfFile: urlPrefPath];
-      if (data)
-	{
-	  dict = [NSDeserializer deserializePropertyListFromData: data
-					       mutableContainers: NO];
-	  ASSIGN(urlPreferences, dict);
-	}
+      [_iconCache removeImageForKey: [@"d" stringByAppendingString: path]];
+    }
+  enumerator = [names objectEnumerator];
+  while ((name = [enumerator nextObject]) != nil)
+    {
+      [_iconCache removeImageForKey: [@"d" stringByAppendingString:
+	[path stringByAppendingPathComponent: name]]];
     }
+}
 
-  if ([mgr isReadableFileAtPath: appListPath] == YES)
+- (void) _workspacePreferencesChanged: (NSNotification *)aNotification
+{
+  /* Only the files which changed are read again, and only the answers
+   * found from them are forgotten.
+   */
+  if (reloadIfChanged(extPrefPath, &extPreferences, &extPrefStamp))
     {
-      data = [NSData dataWithContentsOfFile: appListPath];
-      if (data)
-	{
-	  dict = [NSDeserializer deserializePropertyListFromData: data
-					       mutableContainers: NO];
-	  ASSIGN(applications, dict);
-	}
+      [extensionApps removeAllObjects];
+    }
+  if (reloadIfChanged(urlPrefPath, &urlPreferences, &urlPrefStamp))
+    {
+      [schemeApps removeAllObjects];
+    }
+  if (reloadIfChanged(appListPath, &applications, &appListStamp))
+    {
+      [extensionApps removeAllObjects];
+      [schemeApps removeAllObjects];
+      [appBinaries removeAllObjects];
     }
   /*
-   *	Invalidate the cache of icons for file extensions.
+   *	Invalidate the cache of icons for file extensions and folders.
    */
-  [_iconMap removeAllObjects];
+  [_iconCache removeAllImages];
 }
 
 
@@ -3149,54 +3919,69 @@ launchIdentifiers: (NSArray **)identifiers
   return YES;
 }
 
-- (id) _connectApplication: (NSString*)appName
+/*
+ * Tries once to contact a running application, without waiting for it
+ * to start up.
+ */
+- (id) _runningApplication: (NSString*)appName
 {
   NSTimeInterval        replyTimeout = 0.0;
   NSTimeInterval        requestTimeout = 0.0;
   NSString	*host;
   NSString	*port;
-  NSDate	*when = nil;
   NSConnection  *conn = nil;
   id		app = nil;
 
-  while (app == nil)
+  host = [[NSUserDefaults standardUserDefaults] stringForKey: @"NSHost"];
+  if (host == nil)
     {
-      host = [[NSUserDefaults standardUserDefaults] stringForKey: @"NSHost"];
-      if (host == nil)
+      host = @"";
+    }
+  else
+    {
+      NSHost	*h;
+
+      h = [NSHost hostWithName: host];
+      if ([h isEqual: [NSHost currentHost]] == YES)
 	{
 	  host = @"";
 	}
-      else
-	{
-	  NSHost	*h;
-
-	  h = [NSHost hostWithName: host];
-	  if ([h isEqual: [NSHost currentHost]] == YES)
-	    {
-	      host = @"";
-	    }
-	}
-      port = [[appName lastPathComponent] stringByDeletingPathExtension];
-      /*
-       *	Try to contact a running application.
+    }
+  port = [[appName lastPathComponent] stringByDeletingPathExtension];
+  NS_DURING
+    {
+      conn = [NSConnection connectionWithRegisteredName: port host: host];
+      requestTimeout = [conn requestTimeout];
+      [conn setRequestTimeout: 5.0];
+      replyTimeout = [conn replyTimeout];
+      [conn setReplyTimeout: 5.0];
+      app = [conn rootProxy];
+    }
+  NS_HANDLER
+    {
+      /* Fatal error in DO	*/
+      conn = nil;
+      app = nil;
+    }
+  NS_ENDHANDLER
+  if (conn != nil)
+    {
+      /* Use original timeouts
        */
-      NS_DURING
-	{
-          conn = [NSConnection connectionWithRegisteredName: port host: host];
-          requestTimeout = [conn requestTimeout];
-          [conn setRequestTimeout: 5.0];
-          replyTimeout = [conn replyTimeout];
-          [conn setReplyTimeout: 5.0];
-	  app = [conn rootProxy];
-	}
-      NS_HANDLER
-	{
-	  /* Fatal error in DO	*/
-          conn = nil;
-	  app = nil;
-	}
-      NS_ENDHANDLER
+      [conn setRequestTimeout: requestTimeout];
+      [conn setReplyTimeout: replyTimeout];
+    }
+  return app;
+}
+
+- (id) _connectApplication: (NSString*)appName
+{
+  NSDate	*when = nil;
+  id		app = nil;
 
+  while (app == nil)
+    {
+      app = [self _runningApplication: appName];
       if (app == nil)
 	{
 	  NSTask	*task = [_launched objectForKey: appName];
@@ -3246,24 +4031,16 @@ launchIdentifiers: (NSArray **)identifiers
 	  RELEASE(limit);
 	}
     }
-  if (conn != nil)
-    {
-      /* Use original timeouts
-       */
-      [conn setRequestTimeout: requestTimeout];
-      [conn setReplyTimeout: replyTimeout];
-    }
   TEST_RELEASE(when);
   return app;
 }
 
-- (id) _workspaceApplication
+- (NSString*) _workspaceApplicationName
 {
   static NSUserDefaults		*defs = nil;
   static GSServicesManager	*smgr = nil;
   NSString			*appName;
   NSString			*myName;
-  id				app;
 
   if (defs == nil)
     {
@@ -3288,7 +4065,18 @@ launchIdentifiers: (NSArray **)identifiers
     {
       return nil;
     }
+  return appName;
+}
+
+- (id) _workspaceApplication
+{
+  NSString	*appName = [self _workspaceApplicationName];
+  id		app;
 
+  if (appName == nil)
+    {
+      return nil;
+    }
   app = [self _connectApplication: appName];
   if (app == nil)
     {
@@ -3327,4 +4115,88 @@ launchIdentifiers: (NSArray **)identifiers
   return app;
 }
 
+/*
+ * Queues a request until the application it is for has started,
+ * launching the application unless it is already starting up.
+ */
+- (void) _addLaunchRequest: (GSLaunchRequest*)request
+		 arguments: (NSArray*)args
+		   timeout: (NSTimeInterval)timeout
+{
+  NSString		*appName = request->appName;
+  NSString		*port;
+  NSMutableArray	*queue;
+
+  port = [[appName lastPathComponent] stringByDeletingPathExtension];
+  queue = [_pendingLaunches objectForKey: port];
+  if ([queue count] == 0)
+    {
+      NSTask	*task = [_launched objectForKey: appName];
+
+      if (task == nil || [task isRunning] == NO)
+	{
+	  if ([self _launchApplication: appName arguments: args] == NO)
+	    {
+	      [request answer: NO];
+	      return;
+	    }
+	  request->sent = (request->file != nil);
+	}
+      if (queue == nil)
+	{
+	  queue = [NSMutableArray new];
+	  [_pendingLaunches setObject: queue forKey: port];
+	  RELEASE(queue);
+	}
+    }
+  if (timeout <= 0.0)
+    {
+      timeout = 30.0;
+    }
+  [queue addObject: request];
+  request->queue = queue;
+  [request startTimer: timeout];
+}
+
+- (void) _applicationDidLaunch: (NSNotification*)aNotification
+{
+  NSString	*port;
+  NSArray	*queue;
+
+  port = [[aNotification userInfo] objectForKey: @"NSApplicationName"];
+  queue = [_pendingLaunches objectForKey: port];
+  if ([queue count] > 0)
+    {
+      id	app = [self _runningApplication: port];
+
+      queue = AUTORELEASE([queue copy]);
+      [queue makeObjectsPerformSelector: @selector(completeWithApplication:)
+			     withObject: app];
+    }
+}
+
+- (void) _applicationDidTerminate: (NSNotification*)aNotification
+{
+  NSEnumerator	*enumerator;
+  NSString	*appName;
+
+  enumerator = [[_launched allKeysForObject: [aNotification object]]
+    objectEnumerator];
+  while ((appName = [enumerator nextObject]) != nil)
+    {
+      NSString	*port;
+      NSArray	*queue;
+
+      port = [[appName lastPathComponent] stringByDeletingPathExtension];
+      queue = [_pendingLaunches objectForKey: port];
+      if ([queue count] > 0)
+	{
+	  NSWarnLog(@"'%@' exited while starting up", appName);
+	  queue = AUTORELEASE([queue copy]);
+	  [queue makeObjectsPerformSelector:
+	    @selector(completeWithApplication:) withObject: nil];
+	}
+    }
+}
+
 @end
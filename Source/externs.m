@@ -124,6 +124,9 @@ NSString *NSImageLoopCount = @"NSImageLoopCount";
 NSString *NSImageGamma = @"NSImageGamma";
 NSString *NSImageProgressive = @"NSImageProgressive";
 NSString *NSImageEXIFData = @"NSImageEXIFData";  // No support yet in GNUstep
+NSString *GSImagePNGCompressionLevel = @"GSImagePNGCompressionLevel";
+NSString *GSImagePNGFilters = @"GSImagePNGFilters";
+NSString *GSImagePNGThreads = @"GSImagePNGThreads";
 
 // NSBrowser notification
 NSString *NSBrowserColumnConfigurationDidChangeNotification = @"NSBrowserColumnConfigurationDidChange";
@@ -273,6 +276,10 @@ NSString *NSDeviceIsScreen = @"NSDeviceIsScreen";
 NSString *NSDeviceIsPrinter = @"NSDeviceIsPrinter";
 NSString *NSDeviceSize = @"NSDeviceSize";
 
+// NSPrinter notifications
+NSString *GSPrinterNamesDidChangeNotification =
+@"GSPrinterNamesDidChangeNotification";
+
 // NSImageRep notifications
 NSString *NSImageRepRegistryChangedNotification =
 @"NSImageRepRegistryChangedNotification";
@@ -468,6 +475,7 @@ NSString *NSWindowDidChangeScreenNotification = @"WindowDidChangeScreen";
 NSString *NSWindowDidChangeScreenProfileNotification = @"NSWindowDidChangeScreenProfile";
 NSString *NSWindowDidDeminiaturizeNotification = @"WindowDidDeminiaturize";
 NSString *NSWindowDidEndSheetNotification = @"NSWindowDidEndSheet";
+NSString *NSWindowDidEndLiveResizeNotification = @"NSWindowDidEndLiveResize";
 NSString *NSWindowDidExposeNotification = @"WindowDidExpose";
 NSString *NSWindowDidMiniaturizeNotification = @"WindowDidMiniaturize";
 NSString *NSWindowDidMoveNotification = @"WindowDidMove";
@@ -479,6 +487,8 @@ NSString *NSWindowWillBeginSheetNotification = @"NSWindowWillBeginSheet";
 NSString *NSWindowWillCloseNotification = @"WindowWillClose";
 NSString *NSWindowWillMiniaturizeNotification = @"WindowWillMiniaturize";
 NSString *NSWindowWillMoveNotification = @"WindowWillMove";
+NSString *NSWindowWillStartLiveResizeNotification
+  = @"NSWindowWillStartLiveResize";
 
 // Workspace File Type Globals
 NSString *NSPlainFileType = @"NSPlainFileType";
@@ -523,6 +533,9 @@ NSString *NSWorkspaceSessionDidResignActiveNotification =
 @"NSWorkspaceSessionDidResignActiveNotification";
 NSString *NSWorkspaceWillSleepNotification =
 @"NSWorkspaceWillSleepNotification";
+NSString *GSWorkspaceBatchNotification = @"GSWorkspaceBatchNotification";
+NSString *GSWorkspaceBatchNameKey = @"GSWorkspaceBatchName";
+NSString *GSWorkspaceBatchUserInfoKey = @"GSWorkspaceBatchUserInfo";
 
 /*
  *	NSStringDrawing NSAttributedString additions
@@ -688,6 +701,7 @@ NSString *NSSelectsAllWhenSettingContentBindingOption = @"NSSelectsAllWhenSettin
 NSString *NSValidatesImmediatelyBindingOption = @"NSValidatesImmediately";
 NSString *NSValueTransformerNameBindingOption = @"NSValueTransformerName";
 NSString *NSValueTransformerBindingOption = @"NSValueTransformer";
+NSString *GSCoalescesChangesBindingOption = @"GSCoalescesChanges";
  
 NSString *NSAlignmentBinding = @"alignment";
 NSString *NSContentArrayBinding = @"contentArray";
@@ -0,0 +1,122 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Shared timing and reporting code of the benchmarks in this directory.
+
+Each scenario is run GSTEST_BENCHMARK_RUNS times (5 if unset), after
+one untimed warm up run, and reports one line of JSON to stdout:
+
+  {"benchmark": "<scenario>", "operations": <n>, "runs": <r>,
+   "median": <seconds>, "min": <seconds>, "max": <seconds>}
+
+all on a single line, with the keys always in this order, so results
+can be compared across runs and builds with line based tools.  The
+median is the figure to track; min and max show how noisy a run was.
+A benchmark may add members of its own after these, always in the
+same order too.
+If GSTEST_BENCHMARK_FILE is set, the lines are appended to that file
+as well.
+
+The benchmarks draw into windows that are never ordered in, so they
+run headless when the GSBackend user default names a backend which
+needs no display server, such as the headless backend of gnustep-back.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#import <Foundation/NSDate.h>
+#import <Foundation/NSDictionary.h>
+#import <Foundation/NSProcessInfo.h>
+#import <Foundation/NSString.h>
+
+#define BENCHMARK_MAX_RUNS 100
+
+static FILE *benchmarkFile = NULL;
+static int benchmarkRuns = 0;
+
+static int
+compareTimes(const void *a, const void *b)
+{
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+
+  return (x < y) ? -1 : ((x > y) ? 1 : 0);
+}
+
+static void
+benchmarkSetUp(void)
+{
+  NSDictionary *env = [[NSProcessInfo processInfo] environment];
+  NSString *path = [env objectForKey: @"GSTEST_BENCHMARK_FILE"];
+  NSString *runs = [env objectForKey: @"GSTEST_BENCHMARK_RUNS"];
+
+  if (path != nil && benchmarkFile == NULL)
+    benchmarkFile = fopen([path fileSystemRepresentation], "a");
+  benchmarkRuns = (runs != nil) ? [runs intValue] : 5;
+  if (benchmarkRuns < 1)
+    benchmarkRuns = 1;
+  if (benchmarkRuns > BENCHMARK_MAX_RUNS)
+    benchmarkRuns = BENCHMARK_MAX_RUNS;
+}
+
+static void
+benchmarkTearDown(void)
+{
+  if (benchmarkFile != NULL)
+    fclose(benchmarkFile);
+  benchmarkFile = NULL;
+}
+
+/* Sorts the times of the runs and returns their median. */
+static double
+benchmarkMedian(double *times, int runs)
+{
+  qsort(times, runs, sizeof(double), compareTimes);
+  return (runs % 2) ? times[runs / 2]
+    : (times[runs / 2 - 1] + times[runs / 2]) / 2;
+}
+
+/* Reports a scenario.  extra, if not NULL, holds further members for
+   the JSON object, such as "\"bytes\": 100", without a leading comma. */
+static void
+benchmarkReport(const char *scenario, unsigned long operations,
+  double *times, int runs, const char *extra)
+{
+  char line[1024];
+  double median = benchmarkMedian(times, runs);
+
+  snprintf(line, sizeof(line),
+    "{\"benchmark\": \"%s\", \"operations\": %lu, \"runs\": %d, "
+    "\"median\": %.6f, \"min\": %.6f, \"max\": %.6f%s%s}\n",
+    scenario, operations, runs, median, times[0], times[runs - 1],
+    (extra != NULL) ? ", " : "", (extra != NULL) ? extra : "");
+  fputs(line, stdout);
+  if (benchmarkFile != NULL)
+    fputs(line, benchmarkFile);
+}
+
+/* Times the statements after the array for the times, running them
+   once to warm up and then benchmarkRuns times, each run in an
+   autorelease pool of its own. */
+#define BENCHMARK_TIMES(times, ...) \
+  do { \
+    int _run; \
+    for (_run = -1; _run < benchmarkRuns; _run++) \
+      { \
+        CREATE_AUTORELEASE_POOL(_pool); \
+        NSTimeInterval _start = [NSDate timeIntervalSinceReferenceDate]; \
+        __VA_ARGS__; \
+        if (_run >= 0) \
+          times[_run] = [NSDate timeIntervalSinceReferenceDate] - _start; \
+        DESTROY(_pool); \
+      } \
+  } while (0)
+
+/* Times the statements after the scenario name and operation count,
+   and reports them. */
+#define BENCHMARK(scenario, operations, ...) \
+  do { \
+    double _times[BENCHMARK_MAX_RUNS]; \
+    BENCHMARK_TIMES(_times, __VA_ARGS__); \
+    benchmarkReport(scenario, operations, _times, benchmarkRuns, NULL); \
+  } while (0)
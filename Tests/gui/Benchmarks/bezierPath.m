@@ -0,0 +1,62 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Benchmark flattening a long curved path and hit testing points against
+it.  See Benchmark.h for the output.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSBezierPath.h>
+#include <math.h>
+#import "Benchmark.h"
+
+#define CURVES 2000
+#define FLATTENS 20
+#define HITS 10000
+
+int
+main(int argc, char **argv)
+{
+  NSBezierPath *path = [NSBezierPath bezierPath];
+  NSBezierPath *flat = nil;
+  NSUInteger i, inside = 0;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+  benchmarkSetUp();
+
+  /* A star shaped closed path of curves around (500, 500) */
+  [path moveToPoint: NSMakePoint(900, 500)];
+  for (i = 1; i <= CURVES; i++)
+    {
+      double a = 2 * M_PI * i / CURVES;
+      double r = (i % 2) ? 300 : 400;
+
+      [path curveToPoint: NSMakePoint(500 + r * cos(a), 500 + r * sin(a))
+           controlPoint1: NSMakePoint(500 + 450 * cos(a - 0.001),
+                                      500 + 450 * sin(a - 0.001))
+           controlPoint2: NSMakePoint(500 + 250 * cos(a),
+                                      500 + 250 * sin(a))];
+    }
+  [path closePath];
+
+  BENCHMARK("bezier-flatten", FLATTENS,
+    for (i = 0; i < FLATTENS; i++)
+      ASSIGN(flat, [path bezierPathByFlatteningPath]));
+  pass([flat elementCount] >= CURVES, "flattening gives line segments");
+
+  BENCHMARK("bezier-contains-point", HITS,
+    srand(4711);
+    inside = 0;
+    for (i = 0; i < HITS; i++)
+      if ([path containsPoint: NSMakePoint(rand() % 1000, rand() % 1000)])
+        inside++);
+  pass(inside > 0 && inside < HITS, "some points are inside the path");
+
+  RELEASE(flat);
+  benchmarkTearDown();
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,494 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Benchmark and cross check the image codecs on a fixed corpus of
+generated images: an opaque colour image, one with alpha, a grey image
+and a small icon.  Each is encoded with -representationUsingType:
+properties: (PNG, JPEG, GIF) and -TIFFRepresentationUsingCompression:
+factor: (none, LZW, PackBits), and every encoding is decoded again with
++imageRepsWithData:.  PNM and ICNS data, which there is no encoder for,
+is put together by hand.  The PNG data is also decoded with
+GSImageMagickImageRep, and a small EPS file with NSEPSImageRep, when
+the library was built with them.  The files in the directory named by
+GSTEST_IMAGE_CORPUS, if set, are decoded as well.
+
+Besides the members described in Benchmark.h, each line has
+
+  "bytes"        the size of the encoded data,
+  "mb_per_s"     megabytes of decoded pixels handled per second,
+  "live_bytes"   the memory still allocated for one decoded or encoded
+                 result (-1 where malloc cannot tell),
+  "peak_rss_kb"  the peak resident size of the process so far,
+  "checksum"     a checksum of the decoded pixels as 8 bit RGBA, or 0
+                 for encoding.
+
+A lossless codec must give the checksum of the image it was given;
+lossy codecs are only expected to give the same checksum from one
+build to the next.  As the peak resident size never goes down, setting
+GSTEST_CODECS to a comma separated list of scenario prefixes, such as
+"decode-png,encode-png", measures the codecs in separate processes.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSArray.h>
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSData.h>
+#import <Foundation/NSDictionary.h>
+#import <Foundation/NSFileManager.h>
+#import <Foundation/NSProcessInfo.h>
+#import <Foundation/NSString.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSBitmapImageRep.h>
+#import <AppKit/NSGraphics.h>
+#import <AppKit/NSImage.h>
+#import <AppKit/NSImageRep.h>
+#import "Benchmark.h"
+#include <sys/resource.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#define OPERATIONS 5
+
+static NSArray *selected = nil;
+
+static BOOL
+wanted(const char *scenario)
+{
+  NSUInteger i;
+
+  if (selected == nil)
+    return YES;
+  for (i = 0; i < [selected count]; i++)
+    if (strncmp(scenario, [[selected objectAtIndex: i] UTF8String],
+                strlen([[selected objectAtIndex: i] UTF8String])) == 0)
+      return YES;
+  return NO;
+}
+
+static long
+liveBytes(void)
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 \
+  || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  return (long)mallinfo2().uordblks;
+#else
+  return -1;
+#endif
+}
+
+static long
+peakRSS(void)
+{
+  struct rusage usage;
+
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return -1;
+  return usage.ru_maxrss;
+}
+
+/* FNV-1a over the pixels as 8 bit RGBA, so reps decoded with different
+   bit depths, planes or colour spaces can be compared. */
+static unsigned long
+checksum(NSImageRep *imageRep)
+{
+  NSBitmapImageRep *rep;
+  NSInteger w, h, x, y, bps, spp, colors;
+  BOOL alpha, black;
+  unsigned long hash = 2166136261UL;
+
+  if (![imageRep isKindOfClass: [NSBitmapImageRep class]])
+    return 0;
+  rep = (NSBitmapImageRep *)imageRep;
+  w = [rep pixelsWide];
+  h = [rep pixelsHigh];
+  bps = [rep bitsPerSample];
+  spp = [rep samplesPerPixel];
+  alpha = [rep hasAlpha];
+  colors = spp - (alpha ? 1 : 0);
+  black = [[rep colorSpaceName] isEqual: NSDeviceBlackColorSpace]
+    || [[rep colorSpaceName] isEqual: NSCalibratedBlackColorSpace];
+  for (y = 0; y < h; y++)
+    for (x = 0; x < w; x++)
+      {
+        NSUInteger p[5];
+        unsigned char rgba[4];
+        NSInteger i;
+
+        [rep getPixel: p atX: x y: y];
+        for (i = 0; i < spp && i < 5; i++)
+          p[i] = (bps == 8) ? p[i] : (p[i] * 255) / ((1 << bps) - 1);
+        if (colors == 1)
+          rgba[0] = rgba[1] = rgba[2] = black ? 255 - p[0] : p[0];
+        else
+          {
+            rgba[0] = p[0];
+            rgba[1] = p[1];
+            rgba[2] = p[2];
+          }
+        rgba[3] = alpha ? p[colors] : 255;
+        for (i = 0; i < 4; i++)
+          hash = (hash ^ rgba[i]) * 16777619UL;
+        hash &= 0xffffffffUL;
+      }
+  return hash;
+}
+
+static NSBitmapImageRep *
+makeImage(NSInteger side, NSInteger spp, BOOL alpha)
+{
+  NSBitmapImageRep *rep;
+  unsigned char *p;
+  NSInteger x, y;
+
+  rep = [[NSBitmapImageRep alloc]
+    initWithBitmapDataPlanes: NULL
+                  pixelsWide: side
+                  pixelsHigh: side
+               bitsPerSample: 8
+             samplesPerPixel: spp
+                    hasAlpha: alpha
+                    isPlanar: NO
+              colorSpaceName: (spp - alpha > 1) ? NSDeviceRGBColorSpace
+                                                : NSDeviceWhiteColorSpace
+                 bytesPerRow: 0
+                bitsPerPixel: 0];
+  p = [rep bitmapData];
+  for (y = 0; y < side; y++)
+    for (x = 0; x < side; x++)
+      {
+        unsigned char a = alpha ? (x + y) * 255 / (2 * side) : 255;
+
+        if (spp - alpha > 1)
+          {
+            /* Premultiplied, as the rep is */
+            *p++ = (x * 255 / side) * a / 255;
+            *p++ = (y * 255 / side) * a / 255;
+            *p++ = ((x ^ y) & 0xff) * a / 255;
+          }
+        else
+          {
+            *p++ = ((x + y) * 255 / (2 * side)) * a / 255;
+          }
+        if (alpha)
+          *p++ = a;
+      }
+  return AUTORELEASE(rep);
+}
+
+static NSData *
+makePNM(NSBitmapImageRep *rep)
+{
+  NSInteger w = [rep pixelsWide], h = [rep pixelsHigh], x, y;
+  NSMutableData *data;
+  NSUInteger p[5];
+
+  data = [NSMutableData dataWithData:
+    [[NSString stringWithFormat: @"P6\n%ld %ld\n255\n", (long)w, (long)h]
+      dataUsingEncoding: NSASCIIStringEncoding]];
+  for (y = 0; y < h; y++)
+    for (x = 0; x < w; x++)
+      {
+        unsigned char rgb[3];
+
+        [rep getPixel: p atX: x y: y];
+        rgb[0] = p[0];
+        rgb[1] = p[1];
+        rgb[2] = p[2];
+        [data appendBytes: rgb length: 3];
+      }
+  return data;
+}
+
+static void
+appendElement(NSMutableData *data, const char *type, NSData *bytes)
+{
+  unsigned int size = 8 + [bytes length];
+  unsigned char header[8];
+
+  memcpy(header, type, 4);
+  header[4] = size >> 24;
+  header[5] = size >> 16;
+  header[6] = size >> 8;
+  header[7] = size;
+  [data appendBytes: header length: 8];
+  [data appendData: bytes];
+}
+
+/* A 32x32 icon family with uncompressed colour data and a mask. */
+static NSData *
+makeICNS(NSBitmapImageRep *rep)
+{
+  NSMutableData *family = [NSMutableData data];
+  NSMutableData *colour = [NSMutableData data];
+  NSMutableData *mask = [NSMutableData data];
+  NSMutableData *data;
+  NSInteger x, y;
+
+  for (y = 0; y < 32; y++)
+    for (x = 0; x < 32; x++)
+      {
+        NSUInteger p[5];
+        unsigned char rgb[3], a;
+
+        [rep getPixel: p atX: x y: y];
+        rgb[0] = p[0];
+        rgb[1] = p[1];
+        rgb[2] = p[2];
+        a = p[3];
+        [colour appendBytes: rgb length: 3];
+        [mask appendBytes: &a length: 1];
+      }
+  appendElement(family, "il32", colour);
+  appendElement(family, "l8mk", mask);
+  data = [NSMutableData data];
+  appendElement(data, "icns", family);
+  return data;
+}
+
+static double
+megabytesOf(NSBitmapImageRep *rep)
+{
+  return (double)[rep pixelsWide] * [rep pixelsHigh] * 4 / (1024 * 1024);
+}
+
+static void
+reportCodec(const char *scenario, double *times, NSUInteger bytes,
+  double megabytes, long live, unsigned long sum)
+{
+  char extra[256];
+  double median = benchmarkMedian(times, benchmarkRuns);
+
+  snprintf(extra, sizeof(extra),
+    "\"bytes\": %lu, \"mb_per_s\": %.3f, \"live_bytes\": %ld, "
+    "\"peak_rss_kb\": %ld, \"checksum\": \"%08lx\"",
+    (unsigned long)bytes,
+    (median > 0.0) ? megabytes * OPERATIONS / median : 0.0,
+    live, peakRSS(), sum);
+  benchmarkReport(scenario, OPERATIONS, times, benchmarkRuns, extra);
+}
+
+/* Decodes data with the class given, or with whatever NSImageRep picks
+   if it is Nil, and returns the first rep. */
+static NSImageRep *
+decodeWith(Class c, NSData *data)
+{
+  NSArray *reps;
+
+  if (c == Nil)
+    reps = [NSImageRep imageRepsWithData: data];
+  else if ([c respondsToSelector: @selector(imageRepsWithData:)])
+    reps = [c imageRepsWithData: data];
+  else
+    reps = [NSArray arrayWithObjects: [c imageRepWithData: data], nil];
+  return ([reps count] > 0) ? [reps objectAtIndex: 0] : nil;
+}
+
+/* Benchmarks decoding data, and returns the checksum of the result. */
+static unsigned long
+decode(const char *scenario, Class c, NSData *data, double megabytes)
+{
+  double times[BENCHMARK_MAX_RUNS];
+  NSImageRep *rep;
+  unsigned long sum;
+  long before, live;
+  NSUInteger i;
+
+  if (data == nil || !wanted(scenario))
+    return 0;
+  before = liveBytes();
+  rep = RETAIN(decodeWith(c, data));
+  live = (before < 0) ? -1 : liveBytes() - before;
+  if (rep == nil)
+    return 0;
+  sum = checksum(rep);
+  if (megabytes == 0.0)
+    megabytes = (double)[rep pixelsWide] * [rep pixelsHigh] * 4
+      / (1024 * 1024);
+  RELEASE(rep);
+
+  BENCHMARK_TIMES(times,
+    for (i = 0; i < OPERATIONS; i++)
+      {
+        NSImageRep *r = decodeWith(c, data);
+
+        if ([r isKindOfClass: [NSBitmapImageRep class]])
+          [(NSBitmapImageRep *)r bitmapData];
+      });
+  reportCodec(scenario, times, [data length], megabytes, live, sum);
+  return sum;
+}
+
+/* Benchmarks an encoding of image, either with
+   -TIFFRepresentationUsingCompression:factor: when tiff is YES, or with
+   -representationUsingType:properties:, and returns the data. */
+static NSData *
+encode(const char *scenario, NSBitmapImageRep *image, BOOL tiff,
+  NSBitmapImageFileType type, NSTIFFCompression compression)
+{
+  double times[BENCHMARK_MAX_RUNS];
+  NSData *data;
+  long before, live;
+  NSUInteger i;
+
+#define ENCODE() (tiff \
+  ? [image TIFFRepresentationUsingCompression: compression factor: 0.0] \
+  : [image representationUsingType: type properties: nil])
+
+  before = liveBytes();
+  data = RETAIN(ENCODE());
+  live = (before < 0) ? -1 : liveBytes() - before;
+  if (data == nil || !wanted(scenario))
+    return AUTORELEASE(data);
+
+  BENCHMARK_TIMES(times,
+    for (i = 0; i < OPERATIONS; i++)
+      ENCODE());
+  reportCodec(scenario, times, [data length], megabytesOf(image), live, 0);
+  return AUTORELEASE(data);
+#undef ENCODE
+}
+
+int
+main(int argc, char **argv)
+{
+  struct {
+    const char *name;
+    BOOL tiff;
+    NSBitmapImageFileType type;
+    NSTIFFCompression compression;
+    BOOL lossless;
+  } codecs[] = {
+    { "png", NO, NSPNGFileType, 0, YES },
+    { "jpeg", NO, NSJPEGFileType, 0, NO },
+    { "gif", NO, NSGIFFileType, 0, NO },
+    { "tiff-none", YES, NSTIFFFileType, NSTIFFCompressionNone, YES },
+    { "tiff-lzw", YES, NSTIFFFileType, NSTIFFCompressionLZW, YES },
+    { "tiff-packbits", YES, NSTIFFFileType, NSTIFFCompressionPackBits, YES }
+  };
+  struct {
+    const char *name;
+    NSBitmapImageRep *rep;
+  } images[4];
+  NSDictionary *env = [[NSProcessInfo processInfo] environment];
+  NSString *corpus = [env objectForKey: @"GSTEST_IMAGE_CORPUS"];
+  NSString *eps;
+  Class magick = NSClassFromString(@"GSImageMagickImageRep");
+  Class epsClass = NSClassFromString(@"NSEPSImageRep");
+  unsigned i, j;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+  benchmarkSetUp();
+  if ([env objectForKey: @"GSTEST_CODECS"] != nil)
+    selected = RETAIN([[env objectForKey: @"GSTEST_CODECS"]
+                        componentsSeparatedByString: @","]);
+
+  images[0].name = "rgb";
+  images[0].rep = makeImage(512, 3, NO);
+  images[1].name = "rgba";
+  images[1].rep = makeImage(512, 4, YES);
+  images[2].name = "gray";
+  images[2].rep = makeImage(512, 1, NO);
+  images[3].name = "icon";
+  images[3].rep = makeImage(32, 4, YES);
+
+  for (i = 0; i < sizeof(images) / sizeof(images[0]); i++)
+    {
+      NSBitmapImageRep *image = images[i].rep;
+      unsigned long original = checksum(image);
+
+      for (j = 0; j < sizeof(codecs) / sizeof(codecs[0]); j++)
+        {
+          char scenario[64];
+          unsigned long sum;
+          NSData *data;
+
+          snprintf(scenario, sizeof(scenario), "encode-%s-%s",
+                   codecs[j].name, images[i].name);
+          data = encode(scenario, image, codecs[j].tiff, codecs[j].type,
+                        codecs[j].compression);
+          snprintf(scenario, sizeof(scenario), "decode-%s-%s",
+                   codecs[j].name, images[i].name);
+          sum = decode(scenario, Nil, data, megabytesOf(image));
+          /* Premultiplied alpha does not survive all round trips */
+          if (codecs[j].lossless && ![image hasAlpha] && sum != 0)
+            pass(sum == original, "%s gives back the pixels encoded",
+                 scenario);
+
+          if (!codecs[j].tiff && codecs[j].type == NSPNGFileType
+            && magick != Nil)
+            {
+              snprintf(scenario, sizeof(scenario),
+                       "decode-imagemagick-png-%s", images[i].name);
+              sum = decode(scenario, magick, data, megabytesOf(image));
+              if (![image hasAlpha] && sum != 0)
+                {
+                  testHopeful = YES;
+                  pass(sum == original, "%s gives back the pixels encoded",
+                       scenario);
+                  testHopeful = NO;
+                }
+            }
+        }
+    }
+
+  if (wanted("decode-pnm-rgb"))
+    pass(decode("decode-pnm-rgb", Nil, makePNM(images[0].rep),
+                megabytesOf(images[0].rep)) == checksum(images[0].rep),
+         "PNM data decodes to its pixels");
+  if (wanted("decode-icns-icon"))
+    {
+      testHopeful = YES;
+      pass(decode("decode-icns-icon", Nil, makeICNS(images[3].rep),
+                  megabytesOf(images[3].rep)) != 0,
+           "ICNS data decodes");
+      testHopeful = NO;
+    }
+
+  if (epsClass != Nil && wanted("decode-eps"))
+    {
+      double times[BENCHMARK_MAX_RUNS];
+      NSData *data;
+      NSImage *canvas;
+      NSUInteger n;
+
+      eps = @"%!PS-Adobe-3.0 EPSF-3.0\n%%BoundingBox: 0 0 256 256\n"
+        @"0 0 1 setrgbcolor 0 0 256 256 rectfill\n"
+        @"1 0 0 setrgbcolor 128 128 100 0 360 arc fill\n%%EOF\n";
+      data = [eps dataUsingEncoding: NSASCIIStringEncoding];
+      canvas = AUTORELEASE([[NSImage alloc]
+        initWithSize: NSMakeSize(256, 256)]);
+      [canvas lockFocus];
+      BENCHMARK_TIMES(times,
+        for (n = 0; n < OPERATIONS; n++)
+          [decodeWith(epsClass, data) drawInRect:
+            NSMakeRect(0, 0, 256, 256)]);
+      [canvas unlockFocus];
+      reportCodec("decode-eps", times, [data length],
+                  256.0 * 256 * 4 / (1024 * 1024), -1, 0);
+    }
+
+  if (corpus != nil)
+    {
+      NSFileManager *fm = [NSFileManager defaultManager];
+      NSArray *files = [[fm directoryContentsAtPath: corpus]
+                         sortedArrayUsingSelector: @selector(compare:)];
+
+      for (i = 0; i < [files count]; i++)
+        {
+          NSString *file = [files objectAtIndex: i];
+          char scenario[256];
+
+          snprintf(scenario, sizeof(scenario), "decode-file-%s",
+                   [file UTF8String]);
+          decode(scenario, Nil, [NSData dataWithContentsOfFile:
+            [corpus stringByAppendingPathComponent: file]], 0.0);
+        }
+    }
+
+  RELEASE(selected);
+  benchmarkTearDown();
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,111 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Benchmark decoding PNG, JPEG and TIFF images, and compositing images
+with and without scaling.  See Benchmark.h for the output.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSData.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSBitmapImageRep.h>
+#import <AppKit/NSGraphics.h>
+#import <AppKit/NSImage.h>
+#import "Benchmark.h"
+
+#define SIDE 512
+#define DECODES 10
+#define COMPOSITES 200
+
+static NSBitmapImageRep *
+makeBitmap(void)
+{
+  NSBitmapImageRep *rep;
+  unsigned char *p;
+  int x, y;
+
+  rep = [[NSBitmapImageRep alloc]
+    initWithBitmapDataPlanes: NULL
+                  pixelsWide: SIDE
+                  pixelsHigh: SIDE
+               bitsPerSample: 8
+             samplesPerPixel: 4
+                    hasAlpha: YES
+                    isPlanar: NO
+              colorSpaceName: NSDeviceRGBColorSpace
+                 bytesPerRow: 0
+                bitsPerPixel: 0];
+  p = [rep bitmapData];
+  for (y = 0; y < SIDE; y++)
+    for (x = 0; x < SIDE; x++)
+      {
+        *p++ = x;
+        *p++ = y;
+        *p++ = x ^ y;
+        *p++ = 255;
+      }
+  return AUTORELEASE(rep);
+}
+
+static void
+decode(const char *scenario, NSData *data)
+{
+  NSBitmapImageRep *rep = nil;
+  NSUInteger i;
+
+  if (data == nil)
+    return;
+  BENCHMARK(scenario, DECODES,
+    for (i = 0; i < DECODES; i++)
+      {
+        ASSIGN(rep, [NSBitmapImageRep imageRepWithData: data]);
+        [rep bitmapData];
+      });
+  pass([rep pixelsWide] == SIDE && [rep pixelsHigh] == SIDE,
+       "%s gives an image of the right size", scenario);
+  RELEASE(rep);
+}
+
+int
+main(int argc, char **argv)
+{
+  NSBitmapImageRep *bitmap;
+  NSImage *image, *canvas;
+  NSRect dst = NSMakeRect(0, 0, SIDE, SIDE);
+  NSUInteger i;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+  benchmarkSetUp();
+
+  bitmap = makeBitmap();
+  decode("image-decode-png",
+    [bitmap representationUsingType: NSPNGFileType properties: nil]);
+  decode("image-decode-jpeg",
+    [bitmap representationUsingType: NSJPEGFileType properties: nil]);
+  decode("image-decode-tiff", [bitmap TIFFRepresentation]);
+
+  image = AUTORELEASE([[NSImage alloc] initWithSize: dst.size]);
+  [image addRepresentation: bitmap];
+  canvas = AUTORELEASE([[NSImage alloc]
+    initWithSize: NSMakeSize(SIDE * 2, SIDE * 2)]);
+  [canvas lockFocus];
+  BENCHMARK("image-composite", COMPOSITES,
+    for (i = 0; i < COMPOSITES; i++)
+      [image drawInRect: dst
+               fromRect: NSZeroRect
+              operation: NSCompositeSourceOver
+               fraction: 1.0]);
+  BENCHMARK("image-composite-scaled", COMPOSITES,
+    for (i = 0; i < COMPOSITES; i++)
+      [image drawInRect: NSMakeRect(0, 0, SIDE * 1.5, SIDE * 1.5)
+               fromRect: NSZeroRect
+              operation: NSCompositeSourceOver
+               fraction: 0.5]);
+  [canvas unlockFocus];
+
+  benchmarkTearDown();
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,130 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Benchmark loading a xib holding a view with many buttons and labels,
+both reading the file and instantiating it again from the loaded data.
+See Benchmark.h for the output.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSArray.h>
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSFileManager.h>
+#import <Foundation/NSPathUtilities.h>
+#import <Foundation/NSProcessInfo.h>
+#import <Foundation/NSString.h>
+#import <Foundation/NSURL.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSNib.h>
+#import <AppKit/NSView.h>
+#import "Benchmark.h"
+
+#define CONTROLS 250
+#define LOADS 10
+
+static NSString *
+makeXib(void)
+{
+  NSMutableString *xib = [NSMutableString string];
+  NSUInteger i;
+
+  [xib appendString:
+    @"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    @"<document type=\"com.apple.InterfaceBuilder3.Cocoa.XIB\" version=\"3.0\""
+    @" toolsVersion=\"14113\" targetRuntime=\"MacOSX.Cocoa\""
+    @" propertyAccessControl=\"none\">\n"
+    @" <objects>\n"
+    @"  <customObject id=\"-2\" userLabel=\"File's Owner\""
+    @" customClass=\"NSObject\"/>\n"
+    @"  <customObject id=\"-1\" userLabel=\"First Responder\""
+    @" customClass=\"FirstResponder\"/>\n"
+    @"  <customObject id=\"-3\" userLabel=\"Application\""
+    @" customClass=\"NSObject\"/>\n"
+    @"  <customView id=\"view\">\n"
+    @"   <rect key=\"frame\" x=\"0.0\" y=\"0.0\" width=\"400\""
+    @" height=\"6000\"/>\n"
+    @"   <subviews>\n"];
+  for (i = 0; i < CONTROLS; i++)
+    {
+      [xib appendFormat:
+        @"    <button id=\"b%lu\">\n"
+        @"     <rect key=\"frame\" x=\"10\" y=\"%lu\" width=\"150\""
+        @" height=\"20\"/>\n"
+        @"     <buttonCell key=\"cell\" type=\"push\" title=\"Button %lu\""
+        @" bezelStyle=\"rounded\" alignment=\"center\" id=\"bc%lu\">\n"
+        @"      <font key=\"font\" metaFont=\"system\"/>\n"
+        @"     </buttonCell>\n"
+        @"    </button>\n"
+        @"    <textField id=\"t%lu\">\n"
+        @"     <rect key=\"frame\" x=\"200\" y=\"%lu\" width=\"150\""
+        @" height=\"20\"/>\n"
+        @"     <textFieldCell key=\"cell\" title=\"Label %lu\" id=\"tc%lu\">\n"
+        @"      <font key=\"font\" metaFont=\"system\"/>\n"
+        @"     </textFieldCell>\n"
+        @"    </textField>\n",
+        (unsigned long)i, (unsigned long)(i * 24), (unsigned long)i,
+        (unsigned long)i, (unsigned long)i, (unsigned long)(i * 24),
+        (unsigned long)i, (unsigned long)i];
+    }
+  [xib appendString:
+    @"   </subviews>\n"
+    @"  </customView>\n"
+    @" </objects>\n"
+    @"</document>\n"];
+  return xib;
+}
+
+static NSView *
+viewIn(NSArray *objects)
+{
+  NSUInteger i;
+
+  for (i = 0; i < [objects count]; i++)
+    if ([[objects objectAtIndex: i] isKindOfClass: [NSView class]])
+      return [objects objectAtIndex: i];
+  return nil;
+}
+
+int
+main(int argc, char **argv)
+{
+  NSString *path;
+  NSURL *url;
+  NSNib *nib;
+  NSArray *objects = nil;
+  NSUInteger i;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+  benchmarkSetUp();
+
+  path = [NSTemporaryDirectory() stringByAppendingPathComponent:
+    [[[NSProcessInfo processInfo] globallyUniqueString]
+      stringByAppendingPathExtension: @"xib"]];
+  [makeXib() writeToFile: path atomically: NO];
+  url = [NSURL fileURLWithPath: path];
+
+  BENCHMARK("nib-read-and-instantiate", LOADS,
+    for (i = 0; i < LOADS; i++)
+      {
+        NSNib *n = AUTORELEASE([[NSNib alloc] initWithContentsOfURL: url]);
+
+        [n instantiateNibWithOwner: nil topLevelObjects: NULL];
+      });
+
+  nib = AUTORELEASE([[NSNib alloc] initWithContentsOfURL: url]);
+  BENCHMARK("nib-instantiate", LOADS,
+    for (i = 0; i < LOADS; i++)
+      [nib instantiateNibWithOwner: nil topLevelObjects: NULL]);
+
+  testHopeful = YES;
+  pass([nib instantiateNibWithOwner: nil topLevelObjects: &objects]
+       && [[viewIn(objects) subviews] count] == 2 * CONTROLS,
+       "the xib loads with all its controls");
+  testHopeful = NO;
+
+  [[NSFileManager defaultManager] removeFileAtPath: path handler: nil];
+  benchmarkTearDown();
+  DESTROY(arp);
+  return 0;
+}
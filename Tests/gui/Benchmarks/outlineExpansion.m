@@ -0,0 +1,150 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Benchmark expanding and collapsing an outline of 1000 items with 100
+children each, every item in turn and one item in the middle.  See Benchmark.h
+for the output.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSArray.h>
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSString.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSOutlineView.h>
+#import <AppKit/NSTableColumn.h>
+#import "Benchmark.h"
+
+#define ITEMS 1000
+#define CHILDREN 100
+
+@interface Node : NSObject
+{
+@public
+  NSString *name;
+  NSMutableArray *children;
+}
+@end
+
+@implementation Node
+- (void) dealloc
+{
+  RELEASE(name);
+  RELEASE(children);
+  [super dealloc];
+}
+@end
+
+@interface Tree : NSObject
+{
+@public
+  Node *root;
+}
+@end
+
+@implementation Tree
+- (void) dealloc
+{
+  RELEASE(root);
+  [super dealloc];
+}
+
+- (NSInteger) outlineView: (NSOutlineView *)ov
+   numberOfChildrenOfItem: (id)item
+{
+  Node *node = (item == nil) ? root : item;
+
+  return [node->children count];
+}
+
+- (id) outlineView: (NSOutlineView *)ov child: (NSInteger)index ofItem: (id)item
+{
+  Node *node = (item == nil) ? root : item;
+
+  return [node->children objectAtIndex: index];
+}
+
+- (BOOL) outlineView: (NSOutlineView *)ov isItemExpandable: (id)item
+{
+  return [((Node *)item)->children count] > 0;
+}
+
+- (id) outlineView: (NSOutlineView *)ov
+objectValueForTableColumn: (NSTableColumn *)column
+            byItem: (id)item
+{
+  return ((Node *)item)->name;
+}
+@end
+
+static Node *
+makeNode(NSString *name, NSUInteger count)
+{
+  Node *node = AUTORELEASE([Node new]);
+  NSUInteger i;
+
+  node->name = RETAIN(name);
+  node->children = [[NSMutableArray alloc] initWithCapacity: count];
+  for (i = 0; i < count; i++)
+    {
+      [node->children addObject: makeNode([NSString stringWithFormat:
+        @"%@.%lu", name, (unsigned long)i], 0)];
+    }
+  return node;
+}
+
+int
+main(int argc, char **argv)
+{
+  NSOutlineView *ov;
+  NSTableColumn *column;
+  Tree *tree = AUTORELEASE([Tree new]);
+  NSInteger expanded = 0;
+  NSUInteger i;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+  benchmarkSetUp();
+
+  tree->root = RETAIN(makeNode(@"root", 0));
+  for (i = 0; i < ITEMS; i++)
+    {
+      [tree->root->children addObject: makeNode([NSString stringWithFormat:
+        @"%lu", (unsigned long)i], CHILDREN)];
+    }
+
+  ov = AUTORELEASE([[NSOutlineView alloc]
+    initWithFrame: NSMakeRect(0, 0, 300, 400)]);
+  column = AUTORELEASE([[NSTableColumn alloc] initWithIdentifier: @"name"]);
+  [ov addTableColumn: column];
+  [ov setOutlineTableColumn: column];
+  [ov setDataSource: tree];
+  [ov reloadData];
+  pass([ov numberOfRows] == ITEMS, "the outline shows its top items");
+
+  /* Each run has to collapse again what it expanded, or the runs after
+     the first would find nothing left to do. */
+  BENCHMARK("outline-expand-collapse-each", 2 * ITEMS,
+    for (i = 0; i < ITEMS; i++)
+      [ov expandItem: [tree->root->children objectAtIndex: i]];
+    expanded = [ov numberOfRows];
+    for (i = ITEMS; i-- > 0;)
+      [ov collapseItem: [tree->root->children objectAtIndex: i]]);
+  pass(expanded == ITEMS * (CHILDREN + 1),
+       "expanding every item shows all the children");
+  pass([ov numberOfRows] == ITEMS, "collapsing every item hides the children");
+
+  BENCHMARK("outline-expand-middle", ITEMS,
+    for (i = 0; i < ITEMS; i++)
+      {
+        id item = [tree->root->children objectAtIndex: ITEMS / 2];
+
+        [ov expandItem: item];
+        [ov rowForItem: [tree->root->children lastObject]];
+        [ov collapseItem: item];
+      });
+
+  benchmarkTearDown();
+  DESTROY(arp);
+  return 0;
+}
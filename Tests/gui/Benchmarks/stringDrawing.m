@@ -0,0 +1,80 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Benchmark drawing and measuring many short labels, as a window full of
+controls does, both with the same few strings again and again and with
+strings which are all different.  See Benchmark.h for the output.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSArray.h>
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSDictionary.h>
+#import <Foundation/NSString.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSFont.h>
+#import <AppKit/NSImage.h>
+#import <AppKit/NSStringDrawing.h>
+#import "Benchmark.h"
+
+#define LABELS 10000
+#define DISTINCT 50
+
+int
+main(int argc, char **argv)
+{
+  NSMutableArray *repeated = [NSMutableArray arrayWithCapacity: LABELS];
+  NSMutableArray *unique = [NSMutableArray arrayWithCapacity: LABELS];
+  NSDictionary *attrs;
+  NSImage *canvas;
+  NSSize size = NSZeroSize;
+  NSUInteger i;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+  benchmarkSetUp();
+
+  attrs = [NSDictionary dictionaryWithObject: [NSFont systemFontOfSize: 0]
+                                      forKey: NSFontAttributeName];
+  for (i = 0; i < LABELS; i++)
+    {
+      [repeated addObject: [NSString stringWithFormat: @"Label %lu",
+        (unsigned long)(i % DISTINCT)]];
+      [unique addObject: [NSString stringWithFormat: @"Item number %lu",
+        (unsigned long)i]];
+    }
+  canvas = AUTORELEASE([[NSImage alloc] initWithSize: NSMakeSize(800, 600)]);
+
+  BENCHMARK("string-size-repeated", LABELS,
+    for (i = 0; i < LABELS; i++)
+      size = [[repeated objectAtIndex: i] sizeWithAttributes: attrs]);
+  pass(size.width > 0 && size.height > 0, "labels are measured");
+
+  BENCHMARK("string-size-unique", LABELS,
+    for (i = 0; i < LABELS; i++)
+      size = [[unique objectAtIndex: i] sizeWithAttributes: attrs]);
+
+  [canvas lockFocus];
+  BENCHMARK("string-draw-repeated", LABELS,
+    for (i = 0; i < LABELS; i++)
+      [[repeated objectAtIndex: i]
+        drawAtPoint: NSMakePoint((i % 10) * 80, ((i / 10) % 40) * 15)
+        withAttributes: attrs]);
+
+  BENCHMARK("string-draw-unique", LABELS,
+    for (i = 0; i < LABELS; i++)
+      [[unique objectAtIndex: i]
+        drawAtPoint: NSMakePoint((i % 10) * 80, ((i / 10) % 40) * 15)
+        withAttributes: attrs]);
+
+  BENCHMARK("string-draw-in-rect", LABELS,
+    for (i = 0; i < LABELS; i++)
+      [[unique objectAtIndex: i]
+        drawInRect: NSMakeRect((i % 10) * 80, ((i / 10) % 40) * 15, 60, 15)
+        withAttributes: attrs]);
+  [canvas unlockFocus];
+
+  benchmarkTearDown();
+  DESTROY(arp);
+  return 0;
+}
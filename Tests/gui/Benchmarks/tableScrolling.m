@@ -0,0 +1,104 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Benchmark scrolling through a table of 100000 rows a page at a time,
+and jumping to random rows.  See Benchmark.h for the output.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSString.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSClipView.h>
+#import <AppKit/NSScrollView.h>
+#import <AppKit/NSTableColumn.h>
+#import <AppKit/NSTableView.h>
+#import <AppKit/NSWindow.h>
+#import "Benchmark.h"
+
+#define ROWS 100000
+#define PAGES 200
+#define JUMPS 200
+
+@interface Rows : NSObject
+@end
+
+@implementation Rows
+- (NSInteger) numberOfRowsInTableView: (NSTableView *)tv
+{
+  return ROWS;
+}
+
+- (id) tableView: (NSTableView *)tv
+objectValueForTableColumn: (NSTableColumn *)column
+             row: (NSInteger)row
+{
+  return [NSString stringWithFormat: @"%@ %ld", [column identifier],
+                   (long)row];
+}
+@end
+
+int
+main(int argc, char **argv)
+{
+  NSWindow *window;
+  NSScrollView *sv;
+  NSTableView *tv;
+  NSTableColumn *column;
+  Rows *rows = AUTORELEASE([Rows new]);
+  NSInteger visible;
+  NSUInteger i;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+  benchmarkSetUp();
+
+  window = AUTORELEASE([[NSWindow alloc]
+    initWithContentRect: NSMakeRect(0, 0, 600, 400)
+              styleMask: NSBorderlessWindowMask
+                backing: NSBackingStoreBuffered
+                  defer: NO]);
+  sv = AUTORELEASE([[NSScrollView alloc]
+    initWithFrame: [[window contentView] bounds]]);
+  [sv setHasVerticalScroller: YES];
+  tv = AUTORELEASE([[NSTableView alloc]
+    initWithFrame: NSMakeRect(0, 0, 600, 400)]);
+  for (i = 0; i < 3; i++)
+    {
+      column = AUTORELEASE([[NSTableColumn alloc] initWithIdentifier:
+        [NSString stringWithFormat: @"c%lu", (unsigned long)i]]);
+      [column setWidth: 180];
+      [tv addTableColumn: column];
+    }
+  [tv setDataSource: rows];
+  [sv setDocumentView: tv];
+  [[window contentView] addSubview: sv];
+  [window display];
+
+  visible = NSHeight([sv documentVisibleRect]) / [tv rowHeight];
+  pass([tv numberOfRows] == ROWS, "the table has all its rows");
+
+  BENCHMARK("table-scroll-pages", PAGES,
+    [tv scrollRowToVisible: 0];
+    for (i = 0; i < PAGES; i++)
+      {
+        [tv scrollRowToVisible: (i + 1) * visible];
+        [window displayIfNeeded];
+      });
+
+  BENCHMARK("table-scroll-jumps", JUMPS,
+    srand(4711);
+    for (i = 0; i < JUMPS; i++)
+      {
+        [tv scrollRowToVisible: rand() % ROWS];
+        [window displayIfNeeded];
+      });
+
+  [tv scrollRowToVisible: ROWS - 1];
+  pass(NSMaxY([sv documentVisibleRect]) >= NSMaxY([tv rectOfRow: ROWS - 1]),
+       "the table scrolls to its last row");
+
+  benchmarkTearDown();
+  DESTROY(arp);
+  return 0;
+}
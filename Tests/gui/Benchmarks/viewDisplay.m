@@ -0,0 +1,101 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Benchmark the display of deep and of wide view hierarchies, and hit
+testing in them.  See Benchmark.h for the output.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSColor.h>
+#import <AppKit/NSGraphics.h>
+#import <AppKit/NSView.h>
+#import <AppKit/NSWindow.h>
+#import "Benchmark.h"
+
+#define DEPTH 200
+#define WIDTH 5000
+#define HITS 10000
+
+@interface FilledView : NSView
+@end
+
+@implementation FilledView
+- (void) drawRect: (NSRect)rect
+{
+  [[NSColor whiteColor] set];
+  NSRectFill(rect);
+}
+@end
+
+static NSWindow *
+makeWindow(void)
+{
+  return AUTORELEASE([[NSWindow alloc]
+    initWithContentRect: NSMakeRect(0, 0, 800, 600)
+              styleMask: NSBorderlessWindowMask
+                backing: NSBackingStoreBuffered
+                  defer: NO]);
+}
+
+int
+main(int argc, char **argv)
+{
+  NSWindow *deep, *wide;
+  NSView *view;
+  NSView *innermost = nil;
+  NSView *hit = nil;
+  NSUInteger i;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+  benchmarkSetUp();
+
+  deep = makeWindow();
+  view = [deep contentView];
+  for (i = 0; i < DEPTH; i++)
+    {
+      NSView *child;
+
+      child = [[FilledView alloc] initWithFrame:
+        NSInsetRect([view bounds], 1, 1)];
+      [view addSubview: child];
+      RELEASE(child);
+      view = child;
+    }
+  innermost = view;
+
+  wide = makeWindow();
+  for (i = 0; i < WIDTH; i++)
+    {
+      NSView *child;
+
+      child = [[FilledView alloc] initWithFrame:
+        NSMakeRect((i % 100) * 8, (i / 100) * 12, 7, 11)];
+      [[wide contentView] addSubview: child];
+      RELEASE(child);
+    }
+
+  BENCHMARK("view-display-deep", DEPTH, [deep display]);
+  BENCHMARK("view-display-wide", WIDTH, [wide display]);
+  BENCHMARK("view-invalidate-display-wide", WIDTH,
+    [[wide contentView] setNeedsDisplay: YES];
+    [wide displayIfNeeded]);
+
+  BENCHMARK("view-hit-test-deep", HITS,
+    for (i = 0; i < HITS; i++)
+      hit = [[deep contentView] hitTest: NSMakePoint(400, 300)]);
+  pass(hit == innermost, "hit testing finds the innermost view");
+
+  BENCHMARK("view-hit-test-wide", HITS,
+    for (i = 0; i < HITS; i++)
+      hit = [[wide contentView] hitTest:
+        NSMakePoint((i % 100) * 8 + 3, ((i / 100) % 50) * 12 + 5)]);
+  pass([hit superview] == [wide contentView],
+       "hit testing finds a subview among many");
+
+  benchmarkTearDown();
+  DESTROY(arp);
+  return 0;
+}
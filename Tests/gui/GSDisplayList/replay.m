@@ -0,0 +1,69 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that a recording context records drawing into a display list,
+answers queries about its graphics state, and that a display list
+replays and archives to the same operators.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSArchiver.h>
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSBezierPath.h>
+#import <AppKit/NSColor.h>
+#import <AppKit/NSGraphics.h>
+#import <AppKit/DPSOperators.h>
+#import <GNUstepGUI/GSDisplayList.h>
+
+int
+main(int argc, char **argv)
+{
+  GSRecordingContext *ctxt, *other;
+  GSDisplayList *list, *copy;
+  NSGraphicsContext *old;
+  NSBezierPath *path;
+  CGFloat x, y;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+  old = GSCurrentContext();
+
+  ctxt = AUTORELEASE([GSRecordingContext new]);
+  [NSGraphicsContext setCurrentContext: ctxt];
+  DPSgsave(ctxt);
+  DPStranslate(ctxt, 10, 20);
+  DPSmoveto(ctxt, 1, 2);
+  DPScurrentpoint(ctxt, &x, &y);
+  pass(x == 1 && y == 2, "the current point is in user space");
+  DPSgrestore(ctxt);
+  DPScurrentpoint(ctxt, &x, &y);
+  pass(x == 11 && y == 22, "the matrix is restored with the gstate");
+
+  [[NSColor redColor] set];
+  NSRectFill(NSMakeRect(0, 0, 50, 50));
+  path = [NSBezierPath bezierPathWithOvalInRect: NSMakeRect(5, 5, 20, 10)];
+  [path setLineWidth: 3];
+  [path stroke];
+  [NSGraphicsContext setCurrentContext: old];
+
+  list = [ctxt displayList];
+  pass([list operatorCount] > 6, "drawing is recorded");
+
+  other = AUTORELEASE([GSRecordingContext new]);
+  [list replayInContext: other];
+  pass([[other displayList] isEqual: list],
+       "replaying a list sends the recorded operators");
+
+  copy = [NSUnarchiver unarchiveObjectWithData:
+    [NSArchiver archivedDataWithRootObject: list]];
+  pass([copy isEqual: list], "archiving keeps the operators");
+
+  copy = AUTORELEASE([list copy]);
+  [copy removeAllOperators];
+  pass([copy operatorCount] == 0 && [list operatorCount] > 0,
+       "removing the operators of a copy leaves the original");
+
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,80 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that borderless windows given back to the display server are kept
+unmapped and leased again instead of creating new ones, and that other
+windows are destroyed.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSWindow.h>
+#import <GNUstepGUI/GSDisplayServer.h>
+
+@interface CountingServer : GSDisplayServer
+{
+@public
+  NSInteger created;
+  NSInteger terminated;
+  NSInteger placed;
+}
+@end
+
+@implementation CountingServer
+- (NSInteger) window: (NSRect)frame : (NSBackingStoreType)type
+		    : (NSUInteger)style : (NSInteger)screen
+{
+  return ++created;
+}
+- (void) termwindow: (NSInteger)win
+{
+  terminated++;
+}
+- (void) orderwindow: (NSInteger)op : (NSInteger)otherWin : (NSInteger)win
+{
+}
+- (void) placewindow: (NSRect)frame : (NSInteger)win
+{
+  placed++;
+}
+@end
+
+int
+main(int argc, char **argv)
+{
+  CountingServer *srv;
+  NSInteger win;
+  NSInteger other;
+  BOOL reused;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  srv = [[CountingServer alloc] initWithAttributes: nil];
+
+  win = [srv leasewindow: NSMakeRect(0, 0, 10, 10) : NSBackingStoreBuffered
+			: NSBorderlessWindowMask : 0 : &reused];
+  pass(srv->created == 1 && reused == NO,
+       "a window is created when the pool is empty");
+  [srv returnwindow: win : NSBackingStoreBuffered
+		   : NSBorderlessWindowMask : 0];
+  pass(srv->terminated == 0, "a borderless window goes back to the pool");
+  other = [srv leasewindow: NSMakeRect(5, 5, 20, 20) : NSBackingStoreBuffered
+			  : NSBorderlessWindowMask : 0 : &reused];
+  pass(other == win && reused && srv->created == 1 && srv->placed == 1,
+       "a pooled window is leased again and placed");
+
+  other = [srv leasewindow: NSMakeRect(0, 0, 10, 10) : NSBackingStoreBuffered
+			  : NSTitledWindowMask : 0 : &reused];
+  [srv returnwindow: other : NSBackingStoreBuffered
+		   : NSTitledWindowMask : 0];
+  pass(srv->created == 2 && srv->terminated == 1,
+       "a titled window is not pooled");
+
+  [srv fillWindowPool: 0];
+  pass(srv->created == 6, "the pool can be filled in advance");
+  [srv emptyWindowPool];
+  pass(srv->terminated == 5, "emptying the pool destroys its windows");
+
+  RELEASE(srv);
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,86 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that the window operations queued inside a window transaction are
+sent when it is committed, in order, with the redundant ones dropped.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSArray.h>
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSString.h>
+#import <GNUstepGUI/GSDisplayServer.h>
+
+@interface RecordingServer : GSDisplayServer
+{
+@public
+  NSMutableArray *calls;
+}
+@end
+
+@implementation RecordingServer
+- (void) titlewindow: (NSString *)window_title : (NSInteger)win
+{
+  [calls addObject: [NSString stringWithFormat: @"title %ld %@",
+    (long)win, window_title]];
+}
+- (void) orderwindow: (NSInteger)op : (NSInteger)otherWin : (NSInteger)win
+{
+  [calls addObject: [NSString stringWithFormat: @"order %ld %ld",
+    (long)win, (long)op]];
+}
+- (void) placewindow: (NSRect)frame : (NSInteger)win
+{
+  [calls addObject: [NSString stringWithFormat: @"place %ld %g",
+    (long)win, frame.origin.x]];
+}
+- (void) setinputfocus: (NSInteger)win
+{
+  [calls addObject: [NSString stringWithFormat: @"focus %ld", (long)win]];
+}
+@end
+
+int
+main(int argc, char **argv)
+{
+  RecordingServer *srv;
+  NSArray *expected;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  srv = [[RecordingServer alloc] initWithAttributes: nil];
+  srv->calls = [NSMutableArray new];
+
+  [srv queueplacewindow: NSMakeRect(1, 0, 10, 10) : 1];
+  pass([srv->calls count] == 1,
+       "outside a transaction an operation is sent at once");
+  [srv->calls removeAllObjects];
+
+  [srv beginWindowTransaction];
+  pass([srv isInWindowTransaction], "a transaction can be opened");
+  [srv queueplacewindow: NSMakeRect(2, 0, 10, 10) : 1];
+  [srv queueorderwindow: 1 : 0 : 1];
+  [srv queuetitlewindow: @"a" : 1];
+  [srv beginWindowTransaction];
+  [srv queueplacewindow: NSMakeRect(3, 0, 10, 10) : 1];
+  [srv queueplacewindow: NSMakeRect(4, 0, 10, 10) : 2];
+  [srv queuesetinputfocus: 2];
+  [srv queueorderwindow: 1 : 0 : 2];
+  [srv queuetitlewindow: @"b" : 1];
+  [srv queuesetinputfocus: 1];
+  [srv queueplacewindow: NSMakeRect(5, 0, 10, 10) : 3];
+  [srv discardQueuedOperationsForWindow: 3];
+  [srv commitWindowTransaction];
+  pass([srv->calls count] == 0, "nothing is sent before the outermost commit");
+  [srv commitWindowTransaction];
+  pass([srv isInWindowTransaction] == NO, "the transaction is closed");
+
+  expected = [NSArray arrayWithObjects: @"place 1 3", @"order 1 1",
+    @"title 1 b", @"place 2 4", @"order 2 1", @"focus 1", nil];
+  pass([srv->calls isEqual: expected],
+       "the queued operations are sent in order without the redundant ones");
+
+  RELEASE(srv->calls);
+  RELEASE(srv);
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,78 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check the allocation rates and cache statistics reported for the memory
+panel.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSArray.h>
+#import <Foundation/NSDictionary.h>
+#import <Foundation/NSThread.h>
+#import <Foundation/NSValue.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSImage.h>
+#import <GNUstepGUI/GSMemoryPanel.h>
+
+static NSDictionary *
+entryForClass(NSArray *statistics, NSString *name)
+{
+  NSUInteger i;
+
+  for (i = 0; i < [statistics count]; i++)
+    {
+      NSDictionary *d = [statistics objectAtIndex: i];
+
+      if ([[d objectForKey: @"Class"] isEqual: name])
+        return d;
+    }
+  return nil;
+}
+
+int
+main(int argc, char **argv)
+{
+  NSMutableArray *images = [NSMutableArray array];
+  NSDictionary *caches;
+  NSDictionary *entry;
+  NSArray *statistics;
+  int i;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  [GSMemoryPanel allocationStatistics];
+  for (i = 0; i < 100; i++)
+    {
+      NSImage *image = [[NSImage alloc] initWithSize: NSMakeSize(1, 1)];
+
+      [images addObject: image];
+      RELEASE(image);
+    }
+  [NSThread sleepForTimeInterval: 0.1];
+  statistics = [GSMemoryPanel allocationStatistics];
+  entry = entryForClass(statistics, @"NSImage");
+  pass(entry != nil && [[entry objectForKey: @"Count"] intValue] >= 100,
+       "allocation statistics count live instances");
+  pass([[entry objectForKey: @"AllocationsPerSecond"] doubleValue] > 0.0
+       && [[entry objectForKey: @"DeallocationsPerSecond"] doubleValue] < 1.0,
+       "allocation statistics report the allocation rate");
+
+  [images removeAllObjects];
+  [NSThread sleepForTimeInterval: 0.1];
+  entry = entryForClass([GSMemoryPanel allocationStatistics], @"NSImage");
+  pass([[entry objectForKey: @"DeallocationsPerSecond"] doubleValue] > 0.0,
+       "allocation statistics report the deallocation rate");
+
+  caches = [GSMemoryPanel cacheStatistics];
+  pass([caches objectForKey: @"Images"] != nil
+       && [caches objectForKey: @"StringDrawing"] != nil
+       && [caches objectForKey: @"Fonts"] != nil
+       && [caches objectForKey: @"ThemeTiles"] != nil
+       && [caches objectForKey: @"Icons"] != nil,
+       "cache statistics cover the library caches");
+
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,79 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that a table built between -beginUpdates and -endUpdates places
+its views as one built view by view does.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSArray.h>
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSView.h>
+#import <GNUstepGUI/GSTable.h>
+
+static GSTable *
+makeTable(BOOL batched)
+{
+  GSTable *table = AUTORELEASE([[GSTable alloc] initWithNumberOfRows: 6
+                                                     numberOfColumns: 5]);
+  int i;
+
+  if (batched)
+    [table beginUpdates];
+  for (i = 0; i < 30; i++)
+    {
+      NSView *v = AUTORELEASE([[NSView alloc] initWithFrame:
+        NSMakeRect(0, 0, 10 + (i * 7) % 23, 5 + (i * 3) % 11)]);
+
+      [table putView: v atRow: i / 5 column: i % 5 withMargins: 2];
+    }
+  if (batched)
+    [table endUpdates];
+  return table;
+}
+
+static BOOL
+samePlaces(GSTable *a, GSTable *b)
+{
+  NSArray *ja = [a subviews];
+  NSArray *jb = [b subviews];
+  NSUInteger i;
+
+  if ([ja count] != [jb count])
+    return NO;
+  for (i = 0; i < [ja count]; i++)
+    {
+      if (!NSEqualRects([[ja objectAtIndex: i] frame],
+                        [[jb objectAtIndex: i] frame]))
+        return NO;
+    }
+  return YES;
+}
+
+int
+main(int argc, char **argv)
+{
+  GSTable *plain;
+  GSTable *batched;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+  plain = makeTable(NO);
+  batched = makeTable(YES);
+
+  pass(NSEqualSizes([plain frame].size, [batched frame].size)
+       && NSEqualSizes([plain minimumSize], [batched minimumSize]),
+       "a batched table has the same size");
+  pass(samePlaces(plain, batched), "a batched table places its views alike");
+
+  [plain setFrameSize: NSMakeSize(400, 300)];
+  [batched beginUpdates];
+  [batched setFrameSize: NSMakeSize(400, 300)];
+  [batched endUpdates];
+  pass(samePlaces(plain, batched),
+       "a batched table is laid out alike when resized");
+
+  DESTROY(arp);
+  return 0;
+}
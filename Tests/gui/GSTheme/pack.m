@@ -0,0 +1,95 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that a theme pack keeps the pixels of the images of a bundle and
+refuses a damaged file.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSBundle.h>
+#import <Foundation/NSData.h>
+#import <Foundation/NSFileManager.h>
+#import <Foundation/NSString.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSBitmapImageRep.h>
+#import <AppKit/NSGraphics.h>
+#import <GNUstepGUI/GSThemePack.h>
+
+int
+main(int argc, char **argv)
+{
+  NSFileManager *mgr = [NSFileManager defaultManager];
+  NSString *root = @"/tmp/GSThemePackTest.theme";
+  NSString *images;
+  NSString *file;
+  NSString *packPath;
+  NSBitmapImageRep *image;
+  NSBitmapImageRep *rep;
+  NSBundle *bundle;
+  NSData *data;
+  GSThemePack *pack;
+  unsigned char *p;
+  int x, y;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  image = [[NSBitmapImageRep alloc]
+    initWithBitmapDataPlanes: NULL
+                  pixelsWide: 8
+                  pixelsHigh: 4
+               bitsPerSample: 8
+             samplesPerPixel: 3
+                    hasAlpha: NO
+                    isPlanar: NO
+              colorSpaceName: NSCalibratedRGBColorSpace
+                 bytesPerRow: 0
+                bitsPerPixel: 0];
+  p = [image bitmapData];
+  for (y = 0; y < 4; y++)
+    for (x = 0; x < 8; x++)
+      {
+        *p++ = x * 32;
+        *p++ = y * 64;
+        *p++ = 7;
+      }
+
+  [mgr removeFileAtPath: root handler: nil];
+  images = [root stringByAppendingPathComponent: @"Resources/ThemeImages"];
+  [mgr createDirectoryAtPath: images
+ withIntermediateDirectories: YES
+                  attributes: nil
+                       error: NULL];
+  file = [images stringByAppendingPathComponent: @"Test.tiff"];
+  [[image TIFFRepresentation] writeToFile: file atomically: NO];
+
+  bundle = [NSBundle bundleWithPath: root];
+  data = [GSThemePack packDataForBundle: bundle];
+  pass(data != nil, "a theme bundle with an image can be packed");
+  packPath = [root stringByAppendingPathComponent: @"Resources/ThemePack.gstp"];
+  [data writeToFile: packPath atomically: NO];
+
+  pack = [[GSThemePack alloc] initWithContentsOfFile: packPath
+                                          bundlePath: [bundle bundlePath]];
+  pass(pack != nil, "a theme pack can be loaded");
+  rep = [pack bitmapForFile: [[bundle bundlePath]
+    stringByAppendingPathComponent: @"Resources/ThemeImages/Test.tiff"]];
+  pass(rep != nil && [rep pixelsWide] == 8 && [rep pixelsHigh] == 4
+       && memcmp([rep bitmapData], [image bitmapData], 8 * 4 * 3) == 0,
+       "packed bitmap has the pixels of the image");
+  pass([pack bitmapForFile: @"/nowhere/Test.tiff"] == nil,
+       "a pack holds no bitmaps for other files");
+  RELEASE(pack);
+
+  [[data subdataWithRange: NSMakeRange(0, [data length] / 2)]
+    writeToFile: packPath atomically: NO];
+  pack = [[GSThemePack alloc] initWithContentsOfFile: packPath
+                                          bundlePath: [bundle bundlePath]];
+  pass(pack == nil, "a truncated theme pack is refused");
+
+  [mgr removeFileAtPath: root handler: nil];
+  RELEASE(image);
+  DESTROY(arp);
+  return 0;
+}
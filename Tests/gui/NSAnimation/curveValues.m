@@ -0,0 +1,61 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that the standard animation curves start at 0, end at 1, are
+symmetric where they should be and never go backwards.
+*/
+
+#import "Testing.h"
+#include <math.h>
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSAnimation.h>
+#import <AppKit/NSApplication.h>
+
+static BOOL
+increasing(NSAnimation *a)
+{
+  float last = -1.0;
+  int i;
+
+  for (i = 0; i <= 1000; i++)
+    {
+      [a setCurrentProgress: i / 1000.0];
+      if ([a currentValue] < last)
+        return NO;
+      last = [a currentValue];
+    }
+  return YES;
+}
+
+int
+main(int argc, char **argv)
+{
+  NSAnimation *a;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  a = AUTORELEASE([[NSAnimation alloc] initWithDuration: 1.0
+    animationCurve: NSAnimationEaseInOut]);
+  [a setCurrentProgress: 0.0];
+  pass(fabs([a currentValue]) < 1e-4, "ease in out starts at 0");
+  [a setCurrentProgress: 0.5];
+  pass(fabs([a currentValue] - 0.5) < 1e-3, "ease in out is half way at 0.5");
+  [a setCurrentProgress: 1.0];
+  pass(fabs([a currentValue] - 1.0) < 1e-4, "ease in out ends at 1");
+  pass(increasing(a), "ease in out never goes backwards");
+
+  a = AUTORELEASE([[NSAnimation alloc] initWithDuration: 1.0
+    animationCurve: NSAnimationLinear]);
+  [a setCurrentProgress: 0.3];
+  pass(fabs([a currentValue] - 0.3) < 1e-4, "linear follows the progress");
+
+  a = AUTORELEASE([[NSAnimation alloc] initWithDuration: 1.0
+    animationCurve: NSAnimationEaseIn]);
+  [a setCurrentProgress: 0.25];
+  pass([a currentValue] < 0.25, "ease in starts slowly");
+  pass(increasing(a), "ease in never goes backwards");
+
+  DESTROY(arp);
+  return 0;
+}
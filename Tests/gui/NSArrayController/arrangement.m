@@ -0,0 +1,81 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that a large array is arranged in the order sortedArrayUsingDescriptors:
+gives, and that objects added and removed one by one end up where
+arranging all objects again would put them.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSArray.h>
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSDictionary.h>
+#import <Foundation/NSPredicate.h>
+#import <Foundation/NSSortDescriptor.h>
+#import <Foundation/NSValue.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSArrayController.h>
+
+#define COUNT 20000
+
+static NSDictionary *
+item(NSUInteger i)
+{
+  return [NSDictionary dictionaryWithObjectsAndKeys:
+    [NSNumber numberWithUnsignedInteger: i % 7], @"group",
+    [NSNumber numberWithUnsignedInteger: i], @"n",
+    nil];
+}
+
+int
+main(int argc, char **argv)
+{
+  NSMutableArray *objects = [NSMutableArray array];
+  NSArrayController *ac;
+  NSArray *descriptors;
+  NSUInteger i;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  for (i = 0; i < COUNT; i++)
+    {
+      [objects addObject: item((i * 7919) % COUNT)];
+    }
+  descriptors = [NSArray arrayWithObjects:
+    AUTORELEASE([[NSSortDescriptor alloc] initWithKey: @"group"
+                                            ascending: YES]),
+    AUTORELEASE([[NSSortDescriptor alloc] initWithKey: @"n"
+                                            ascending: NO]),
+    nil];
+
+  ac = AUTORELEASE([NSArrayController new]);
+  [ac setSortDescriptors: descriptors];
+  pass([[ac arrangeObjects: objects] isEqual:
+    [objects sortedArrayUsingDescriptors: descriptors]],
+       "large arrays are sorted as sortedArrayUsingDescriptors: sorts them");
+
+  ac = AUTORELEASE([[NSArrayController alloc] initWithContent:
+    [NSMutableArray array]]);
+  [ac setSortDescriptors: descriptors];
+  [ac setFilterPredicate: [NSPredicate predicateWithFormat: @"n < 150"]];
+  [ac setAutomaticallyRearrangesObjects: YES];
+  [ac rearrangeObjects];
+  for (i = 0; i < 200; i++)
+    {
+      [ac addObject: item((i * 37) % 200)];
+    }
+  pass([[ac arrangedObjects] isEqual:
+    [ac arrangeObjects: [ac content]]],
+       "added objects are placed in the arranged order");
+
+  [ac removeObject: item(14)];
+  [ac removeObjects: [NSArray arrayWithObjects: item(3), item(160), nil]];
+  pass([[ac arrangedObjects] count] == 147
+       && [[ac arrangedObjects] isEqual:
+         [ac arrangeObjects: [ac content]]],
+       "removed objects leave the arranged order");
+
+  DESTROY(arp);
+  return 0;
+}
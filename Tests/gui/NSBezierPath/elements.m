@@ -0,0 +1,82 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check the points kept for each kind of element, the bulk construction
+methods and the raw element buffers.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSAffineTransform.h>
+#import <AppKit/NSBezierPath.h>
+
+int
+main(int argc, char **argv)
+{
+  NSBezierPath *p, *q;
+  NSAffineTransform *t;
+  NSPoint line[4] = {{0, 0}, {10, 0}, {10, 10}, {0, 10}};
+  NSPoint pts[3];
+  const unsigned char *types;
+  const NSPoint *points;
+  NSInteger count, pointCount;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  p = [NSBezierPath bezierPath];
+  [p appendPolygonWithPoints: line count: 4];
+  pass([p elementCount] == 5
+       && [p elementAtIndex: 0] == NSMoveToBezierPathElement
+       && [p elementAtIndex: 3] == NSLineToBezierPathElement
+       && [p elementAtIndex: 4] == NSClosePathBezierPathElement,
+       "a polygon is a moveto, lines and a closepath");
+  [p elementAtIndex: 4 associatedPoints: pts];
+  pass(NSEqualPoints(pts[0], line[0]),
+       "a closepath has the start of its subpath");
+
+  [p appendPolylineWithPoints: line + 1 count: 3];
+  [p curveToPoint: NSMakePoint(5, 5)
+    controlPoint1: NSMakePoint(1, 2)
+    controlPoint2: NSMakePoint(3, 4)];
+  count = [p getElementTypes: &types points: &points pointCount: &pointCount];
+  pass(count == 9 && pointCount == 11
+       && types[5] == NSMoveToBezierPathElement
+       && types[8] == NSCurveToBezierPathElement
+       && NSEqualPoints(points[8], NSMakePoint(1, 2))
+       && NSEqualPoints(points[10], NSMakePoint(5, 5)),
+       "the raw buffers hold the types and points of the elements");
+
+  pts[0] = NSMakePoint(-1, -1);
+  [p setAssociatedPoints: pts atIndex: 0];
+  [p elementAtIndex: 4 associatedPoints: pts];
+  pass(NSEqualPoints(pts[0], NSMakePoint(-1, -1)),
+       "moving the start of a subpath moves its closepath point");
+
+  t = [NSAffineTransform transform];
+  [t translateXBy: 100 yBy: 50];
+  [p transformUsingAffineTransform: t];
+  [p elementAtIndex: 4 associatedPoints: pts];
+  pass(NSEqualPoints(pts[0], NSMakePoint(99, 49)),
+       "transforming a path transforms its closepath points");
+  [p elementAtIndex: 8 associatedPoints: pts];
+  pass(NSEqualPoints(pts[1], NSMakePoint(103, 54))
+       && NSEqualPoints(pts[2], NSMakePoint(105, 55)),
+       "transforming a path transforms its curves");
+
+  q = [NSBezierPath bezierPathWithRect: NSMakeRect(0, 0, 1, 1)];
+  [q appendBezierPath: p];
+  pass([q elementCount] == 5 + count,
+       "appending a path adds its elements");
+  [q elementAtIndex: 5 + 4 associatedPoints: pts];
+  pass(NSEqualPoints(pts[0], NSMakePoint(99, 49)),
+       "appended closepath elements keep their subpath start");
+
+  [q removeAllPoints];
+  [q closePath];
+  [q appendBezierPathWithPoints: line count: 4];
+  pass([q elementCount] == 5
+       && [q elementAtIndex: 1] == NSLineToBezierPathElement,
+       "points appended to a non-empty path start with a line");
+
+  DESTROY(arp);
+  return 0;
+}
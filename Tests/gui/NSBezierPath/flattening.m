@@ -0,0 +1,64 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that flattened paths follow their curves, including curves whose
+ends meet, and that hit testing and flattening see changes to the path.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSBezierPath.h>
+
+#include <math.h>
+
+int
+main(int argc, char **argv)
+{
+  NSBezierPath *p, *f;
+  NSPoint pts[3];
+  NSInteger i, coarse;
+  BOOL within = YES;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  p = [NSBezierPath bezierPath];
+  [p moveToPoint: NSMakePoint(0, 0)];
+  [p curveToPoint: NSMakePoint(0, 0)
+    controlPoint1: NSMakePoint(100, 100)
+    controlPoint2: NSMakePoint(-100, 100)];
+  [p closePath];
+  f = [p bezierPathByFlatteningPath];
+  pass([f elementCount] > 4, "a curve whose ends meet is flattened to lines");
+  pass([p containsPoint: NSMakePoint(0, 50)]
+       && ![p containsPoint: NSMakePoint(0, 90)],
+       "hit testing follows a curve whose ends meet");
+
+  p = [NSBezierPath bezierPathWithOvalInRect: NSMakeRect(0, 0, 100, 100)];
+  [p setFlatness: 0.1];
+  f = [p bezierPathByFlatteningPath];
+  for (i = 0; i < [f elementCount]; i++)
+    {
+      if ([f elementAtIndex: i associatedPoints: pts]
+	  == NSClosePathBezierPathElement)
+	continue;
+      if (fabs(hypot(pts[0].x - 50, pts[0].y - 50) - 50) > 0.1)
+	within = NO;
+    }
+  pass(within, "flattened points lie on the curve");
+  [p setFlatness: 2.0];
+  coarse = [[p bezierPathByFlatteningPath] elementCount];
+  pass(coarse < [f elementCount], "a larger flatness gives fewer lines");
+
+  pass([p containsPoint: NSMakePoint(50, 50)]
+       && [p containsPoint: NSMakePoint(50, 99.9)]
+       && ![p containsPoint: NSMakePoint(50, 100.1)]
+       && ![p containsPoint: NSMakePoint(99.9, 99.9)],
+       "hit testing near a curve uses the curve");
+  [p appendBezierPathWithRect: NSMakeRect(200, 0, 10, 10)];
+  pass([p containsPoint: NSMakePoint(205, 5)],
+       "hit testing sees points added to the path");
+  pass([[p bezierPathByFlatteningPath] elementCount] == coarse + 5,
+       "flattening sees elements added to the path");
+
+  DESTROY(arp);
+  return 0;
+}
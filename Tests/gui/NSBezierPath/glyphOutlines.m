@@ -0,0 +1,81 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that glyphs appended to paths from the glyph outline cache are put
+at the current point, which is advanced past them, and that appending
+several glyphs at once gives the same path as one at a time.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSBezierPath.h>
+#import <AppKit/NSFont.h>
+#include <math.h>
+
+static BOOL
+moved(NSBezierPath *p1, NSBezierPath *p2, NSInteger from, NSPoint by)
+{
+  NSInteger i;
+
+  if ([p2 elementCount] - from != [p1 elementCount])
+    return NO;
+  for (i = 0; i < [p1 elementCount]; i++)
+    {
+      NSPoint a[3], b[3];
+      NSBezierPathElement type = [p1 elementAtIndex: i associatedPoints: a];
+      NSInteger j, n = (type == NSCurveToBezierPathElement) ? 3 : 1;
+
+      if ([p2 elementAtIndex: i + from associatedPoints: b] != type)
+	return NO;
+      for (j = 0; j < n; j++)
+	{
+	  if (fabs(a[j].x + by.x - b[j].x) > 0.001
+	      || fabs(a[j].y + by.y - b[j].y) > 0.001)
+	    return NO;
+	}
+    }
+  return YES;
+}
+
+int
+main(int argc, char **argv)
+{
+  NSFont *font;
+  NSGlyph glyphs[2];
+  NSBezierPath *p1, *p2, *p3;
+  NSSize advance;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  font = [NSFont userFontOfSize: 24];
+  glyphs[0] = [font glyphWithName: @"A"];
+  glyphs[1] = [font glyphWithName: @"B"];
+  advance = [font advancementForGlyph: glyphs[0]];
+
+  testHopeful = YES;
+  p1 = [NSBezierPath bezierPath];
+  [p1 appendBezierPathWithGlyph: glyphs[0] inFont: font];
+  pass([p1 elementCount] > 1, "a glyph has an outline");
+  pass(fabs([p1 currentPoint].x - advance.width) < 0.001,
+       "the current point is advanced past the glyph");
+
+  p2 = [NSBezierPath bezierPath];
+  [p2 moveToPoint: NSMakePoint(10, 20)];
+  [p2 appendBezierPathWithGlyph: glyphs[0] inFont: font];
+  pass(moved(p1, p2, 1, NSMakePoint(10, 20)),
+       "a cached outline is put at the current point");
+
+  p2 = [NSBezierPath bezierPath];
+  [p2 appendBezierPathWithGlyph: glyphs[0] inFont: font];
+  [p2 appendBezierPathWithGlyph: glyphs[1] inFont: font];
+  p3 = [NSBezierPath bezierPath];
+  [p3 appendBezierPathWithGlyphs: glyphs count: 2 inFont: font];
+  pass(moved(p2, p3, 0, NSZeroPoint),
+       "glyphs appended at once are put one after the other");
+  testHopeful = NO;
+
+  DESTROY(arp);
+  return 0;
+}
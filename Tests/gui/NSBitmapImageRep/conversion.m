@@ -0,0 +1,102 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check the conversions between common 8-bit and 16-bit bitmap formats.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSBitmapImageRep.h>
+#import <AppKit/NSGraphics.h>
+
+@interface NSBitmapImageRep (Conversion)
+- (NSBitmapImageRep *) _convertToFormatBitsPerSample: (NSInteger)bps
+                                     samplesPerPixel: (NSInteger)spp
+                                            hasAlpha: (BOOL)alpha
+                                            isPlanar: (BOOL)isPlanar
+                                      colorSpaceName: (NSString*)colorSpaceName
+                                        bitmapFormat: (NSBitmapFormat)bitmapFormat 
+                                         bytesPerRow: (NSInteger)rowBytes
+                                        bitsPerPixel: (NSInteger)pixelBits;
+@end
+
+static NSBitmapImageRep *
+makeImage(NSInteger bps, NSInteger spp, BOOL alpha, NSString *space,
+          NSBitmapFormat format, const unsigned char *bytes)
+{
+  NSBitmapImageRep *rep;
+
+  rep = [[NSBitmapImageRep alloc]
+    initWithBitmapDataPlanes: NULL
+                  pixelsWide: 2
+                  pixelsHigh: 1
+               bitsPerSample: bps
+             samplesPerPixel: spp
+                    hasAlpha: alpha
+                    isPlanar: NO
+              colorSpaceName: space
+                bitmapFormat: format
+                 bytesPerRow: 0
+                bitsPerPixel: 0];
+  memcpy([rep bitmapData], bytes, 2 * spp * bps / 8);
+  return AUTORELEASE(rep);
+}
+
+static NSBitmapImageRep *
+convert(NSBitmapImageRep *rep, NSInteger spp, BOOL alpha,
+        NSBitmapFormat format)
+{
+  return [rep _convertToFormatBitsPerSample: 8
+                            samplesPerPixel: spp
+                                   hasAlpha: alpha
+                                   isPlanar: NO
+                             colorSpaceName: NSDeviceRGBColorSpace
+                               bitmapFormat: format
+                                bytesPerRow: 0
+                               bitsPerPixel: 0];
+}
+
+int
+main(int argc, char **argv)
+{
+  static const unsigned char rgb[] = { 10, 20, 30, 40, 50, 60 };
+  static const unsigned char rgba[] = { 10, 20, 30, 40, 50, 60, 70, 80 };
+  static const unsigned char graya[] = { 10, 20, 30, 40 };
+  static const unsigned char rgb16[] = { 10, 1, 20, 2, 30, 3,
+                                         255, 255, 0, 0, 128, 0 };
+  static const unsigned char rgbaFromRGB[] = { 10, 20, 30, 255,
+                                               40, 50, 60, 255 };
+  static const unsigned char argbFromRGBA[] = { 40, 10, 20, 30,
+                                                80, 50, 60, 70 };
+  static const unsigned char rgbaFromGrayA[] = { 10, 10, 10, 20,
+                                                 30, 30, 30, 40 };
+  static const unsigned char rgbFromRGB16[] = { 10, 20, 30, 255, 0, 127 };
+  NSBitmapImageRep *rep;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  rep = makeImage(8, 3, NO, NSDeviceRGBColorSpace, 0, rgb);
+  rep = convert(rep, 4, YES, 0);
+  pass(memcmp([rep bitmapData], rgbaFromRGB, 8) == 0,
+       "RGB is converted to opaque RGBA");
+
+  rep = makeImage(8, 4, YES, NSDeviceRGBColorSpace, 0, rgba);
+  rep = convert(rep, 4, YES, NSAlphaFirstBitmapFormat);
+  pass(memcmp([rep bitmapData], argbFromRGBA, 8) == 0,
+       "RGBA is converted to ARGB");
+
+  rep = makeImage(8, 2, YES, NSDeviceWhiteColorSpace, 0, graya);
+  rep = convert(rep, 4, YES, 0);
+  pass(memcmp([rep bitmapData], rgbaFromGrayA, 8) == 0,
+       "grey with alpha is converted to RGBA");
+
+  rep = makeImage(16, 3, NO, NSDeviceRGBColorSpace, 0, rgb16);
+  rep = convert(rep, 3, NO, 0);
+  pass(memcmp([rep bitmapData], rgbFromRGB16, 6) == 0,
+       "16-bit RGB is converted to 8-bit RGB");
+
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,73 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that the frames of an animated GIF are shown as the current frame
+is set, going forward as well as back to the start of the loop.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSData.h>
+#import <Foundation/NSValue.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSBitmapImageRep.h>
+
+/* A 1x1 animation with a red and a blue frame, shown for 0.1 and 0.2
+   seconds and looping forever. */
+static const unsigned char animation[] = {
+  'G', 'I', 'F', '8', '9', 'a', 1, 0, 1, 0, 0x80, 0, 0,
+  0xff, 0x00, 0x00, 0x00, 0x00, 0xff,
+  0x21, 0xff, 11, 'N', 'E', 'T', 'S', 'C', 'A', 'P', 'E', '2', '.', '0',
+  3, 1, 0, 0, 0,
+  0x21, 0xf9, 4, 0, 10, 0, 0, 0,
+  0x2c, 0, 0, 0, 0, 1, 0, 1, 0, 0, 2, 2, 0x44, 0x01, 0,
+  0x21, 0xf9, 4, 0, 20, 0, 0, 0,
+  0x2c, 0, 0, 0, 0, 1, 0, 1, 0, 0, 2, 2, 0x4c, 0x01, 0,
+  0x3b
+};
+
+static BOOL
+isColor(NSBitmapImageRep *rep, int r, int g, int b)
+{
+  unsigned char *p = [rep bitmapData];
+
+  return p[0] == r && p[1] == g && p[2] == b;
+}
+
+int
+main(int argc, char **argv)
+{
+  NSBitmapImageRep *rep;
+  NSData *data;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  data = [NSData dataWithBytes: animation length: sizeof(animation)];
+  rep = [NSBitmapImageRep imageRepWithData: data];
+  if (rep != nil)
+    {
+      pass([[rep valueForProperty: NSImageFrameCount] intValue] == 2,
+           "the frames of an animated GIF are counted");
+      pass(isColor(rep, 255, 0, 0), "the first frame is shown at first");
+
+      [rep setProperty: NSImageCurrentFrame
+             withValue: [NSNumber numberWithInt: 1]];
+      pass(isColor(rep, 0, 0, 255)
+           && [[rep valueForProperty: NSImageCurrentFrameDuration]
+                floatValue] > 0.19,
+           "setting the current frame shows that frame");
+
+      [rep setProperty: NSImageCurrentFrame
+             withValue: [NSNumber numberWithInt: 0]];
+      pass(isColor(rep, 255, 0, 0), "going back to the first frame works");
+
+      [rep setProperty: NSImageCurrentFrame
+             withValue: [NSNumber numberWithInt: 5]];
+      pass([[rep valueForProperty: NSImageCurrentFrame] intValue] == 0,
+           "frames past the end are ignored");
+    }
+
+  DESTROY(arp);
+  return 0;
+}
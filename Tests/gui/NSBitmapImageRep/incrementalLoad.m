@@ -0,0 +1,123 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that PNG and JPEG images load incrementally when their data is
+handed over a few bytes at a time.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSData.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSBitmapImageRep.h>
+#import <AppKit/NSGraphics.h>
+
+#define CHUNK 61
+
+static NSBitmapImageRep *
+makeImage(void)
+{
+  NSBitmapImageRep *rep;
+  unsigned char *p;
+  int x, y;
+
+  rep = [[NSBitmapImageRep alloc]
+    initWithBitmapDataPlanes: NULL
+                  pixelsWide: 32
+                  pixelsHigh: 32
+               bitsPerSample: 8
+             samplesPerPixel: 3
+                    hasAlpha: NO
+                    isPlanar: NO
+              colorSpaceName: NSDeviceRGBColorSpace
+                 bytesPerRow: 0
+                bitsPerPixel: 0];
+  p = [rep bitmapData];
+  for (y = 0; y < 32; y++)
+    for (x = 0; x < 32; x++)
+      {
+        *p++ = x * 8;
+        *p++ = y * 8;
+        *p++ = 128;
+      }
+  return AUTORELEASE(rep);
+}
+
+/* Feeds data to a new image rep in chunks. Returns the final status and
+   sets *ok to NO if any status before the last one was an error or the
+   number of rows went down. */
+static NSInteger
+load(NSData *data, NSBitmapImageRep **result, BOOL *ok)
+{
+  NSBitmapImageRep *rep = [[NSBitmapImageRep alloc] initForIncrementalLoad];
+  NSUInteger length = [data length];
+  NSUInteger n = 0;
+  NSInteger status, rows = 0;
+
+  *ok = YES;
+  do
+    {
+      n = MIN(n + CHUNK, length);
+      status = [rep incrementalLoadFromData:
+        [data subdataWithRange: NSMakeRange(0, n)]
+                                   complete: (n == length)];
+      if (status >= 0)
+        {
+          if (status < rows)
+            *ok = NO;
+          rows = status;
+        }
+      else if (n < length && status != NSImageRepLoadStatusReadingHeader)
+        {
+          *ok = NO;
+        }
+    }
+  while (n < length && *ok);
+
+  *result = AUTORELEASE(rep);
+  return status;
+}
+
+int
+main(int argc, char **argv)
+{
+  NSBitmapImageRep *image, *rep;
+  NSData *data;
+  NSInteger status;
+  BOOL ok;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  image = makeImage();
+
+  data = [image representationUsingType: NSPNGFileType properties: nil];
+  if (data != nil)
+    {
+      status = load(data, &rep, &ok);
+      pass(ok, "PNG loading reports progress as the data arrives");
+      pass(status == NSImageRepLoadStatusCompleted,
+           "PNG loading completes");
+      pass([rep pixelsWide] == 32 && [rep pixelsHigh] == 32
+           && memcmp([rep bitmapData], [image bitmapData], 32 * 32 * 3) == 0,
+           "incrementally loaded PNG has the pixels of the image");
+
+      status = load([data subdataWithRange:
+        NSMakeRange(0, [data length] / 2)], &rep, &ok);
+      pass(status == NSImageRepLoadStatusUnexpectedEOF,
+           "truncated PNG reports an unexpected end of file");
+    }
+
+  data = [image representationUsingType: NSJPEGFileType properties: nil];
+  if (data != nil)
+    {
+      status = load(data, &rep, &ok);
+      pass(ok, "JPEG loading reports progress as the data arrives");
+      pass(status == NSImageRepLoadStatusCompleted
+           && [rep pixelsWide] == 32 && [rep pixelsHigh] == 32,
+           "JPEG loading completes");
+    }
+
+  DESTROY(arp);
+  return 0;
+}
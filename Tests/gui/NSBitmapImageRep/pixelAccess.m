@@ -0,0 +1,54 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that the bulk pixel accessors return the same pixels as
+-getPixel:atX:y: in RGBA.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSBitmapImageRep.h>
+#import <AppKit/NSGraphics.h>
+
+int
+main(int argc, char **argv)
+{
+  static const unsigned char graya[] = { 10, 255, 200, 128, 0, 0 };
+  NSBitmapImageRep *rep;
+  unsigned char bytes[4 * 3];
+  float floats[4 * 3];
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  rep = [[NSBitmapImageRep alloc]
+    initWithBitmapDataPlanes: NULL
+                  pixelsWide: 3
+                  pixelsHigh: 2
+               bitsPerSample: 8
+             samplesPerPixel: 2
+                    hasAlpha: YES
+                    isPlanar: NO
+              colorSpaceName: NSDeviceWhiteColorSpace
+                bitmapFormat: NSAlphaNonpremultipliedBitmapFormat
+                 bytesPerRow: 0
+                bitsPerPixel: 0];
+  memcpy([rep bitmapData] + [rep bytesPerRow], graya, sizeof(graya));
+
+  pass([rep getRGBA8Pixels: bytes row: 1]
+       && bytes[0] == 10 && bytes[1] == 10 && bytes[2] == 10
+       && bytes[3] == 255 && bytes[4] == 200 && bytes[7] == 128
+       && bytes[11] == 0,
+       "grey pixels are returned as 8-bit RGBA");
+  pass([rep getRGBAFloatPixels: floats inRect: NSMakeRect(1, 1, 2, 1)]
+       && floats[0] == 200 / 255.0f && floats[3] == 128 / 255.0f
+       && floats[7] == 0.0f,
+       "grey pixels in a rect are returned as float RGBA");
+  pass(![rep getRGBA8Pixels: bytes inRect: NSMakeRect(2, 0, 2, 1)],
+       "rects outside the image are refused");
+
+  [rep release];
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,94 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that PNG images written with a compression level, a choice of row
+filters or on several threads read back with the same pixels.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSData.h>
+#import <Foundation/NSDictionary.h>
+#import <Foundation/NSValue.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSBitmapImageRep.h>
+#import <AppKit/NSGraphics.h>
+
+#define SIZE 512
+
+static BOOL
+roundTrips(NSBitmapImageRep *image, NSDictionary *properties)
+{
+  NSData *data;
+  NSBitmapImageRep *rep;
+
+  data = [image representationUsingType: NSPNGFileType
+                             properties: properties];
+  rep = [NSBitmapImageRep imageRepWithData: data];
+  return [rep pixelsWide] == SIZE && [rep pixelsHigh] == SIZE
+    && memcmp([rep bitmapData], [image bitmapData], SIZE * SIZE * 3) == 0;
+}
+
+int
+main(int argc, char **argv)
+{
+  NSBitmapImageRep *image;
+  NSData *fast, *small;
+  unsigned char *p;
+  int x, y;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  image = AUTORELEASE([[NSBitmapImageRep alloc]
+    initWithBitmapDataPlanes: NULL
+                  pixelsWide: SIZE
+                  pixelsHigh: SIZE
+               bitsPerSample: 8
+             samplesPerPixel: 3
+                    hasAlpha: NO
+                    isPlanar: NO
+              colorSpaceName: NSDeviceRGBColorSpace
+                 bytesPerRow: 0
+                bitsPerPixel: 0]);
+  p = [image bitmapData];
+  for (y = 0; y < SIZE; y++)
+    for (x = 0; x < SIZE; x++)
+      {
+        *p++ = x;
+        *p++ = y;
+        *p++ = (x * y) >> 4;
+      }
+
+  if ([image representationUsingType: NSPNGFileType properties: nil] != nil)
+    {
+      fast = [image representationUsingType: NSPNGFileType
+        properties: [NSDictionary dictionaryWithObjectsAndKeys:
+          [NSNumber numberWithInt: 0], GSImagePNGCompressionLevel,
+          [NSNumber numberWithInt: GSPNGFilterNone], GSImagePNGFilters,
+          nil]];
+      small = [image representationUsingType: NSPNGFileType
+        properties: [NSDictionary dictionaryWithObject:
+          [NSNumber numberWithInt: 9] forKey: GSImagePNGCompressionLevel]];
+      pass([small length] < [fast length],
+           "the compression level is used");
+
+      pass(roundTrips(image, [NSDictionary dictionaryWithObject:
+             [NSNumber numberWithInt: GSPNGFilterPaeth]
+             forKey: GSImagePNGFilters]),
+           "images written with a chosen filter read back");
+      pass(roundTrips(image, [NSDictionary dictionaryWithObject:
+             [NSNumber numberWithInt: 4] forKey: GSImagePNGThreads]),
+           "images compressed on several threads read back");
+      pass(roundTrips(image, [NSDictionary dictionaryWithObjectsAndKeys:
+             [NSNumber numberWithInt: 4], GSImagePNGThreads,
+             [NSNumber numberWithInt: GSPNGFilterSub | GSPNGFilterUp],
+             GSImagePNGFilters,
+             [NSNumber numberWithInt: 1], GSImagePNGCompressionLevel,
+             nil]),
+           "images filtered and compressed on several threads read back");
+    }
+
+  DESTROY(arp);
+  return 0;
+}
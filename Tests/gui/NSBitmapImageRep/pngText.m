@@ -0,0 +1,58 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that the text chunks of PNG images are written and read back, as
+they are for the keys of freedesktop.org thumbnails.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSData.h>
+#import <Foundation/NSDictionary.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSBitmapImageRep.h>
+#import <AppKit/NSGraphics.h>
+
+int
+main(int argc, char **argv)
+{
+  NSBitmapImageRep *image, *rep;
+  NSDictionary *text, *read;
+  NSData *data;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  image = AUTORELEASE([[NSBitmapImageRep alloc]
+    initWithBitmapDataPlanes: NULL
+                  pixelsWide: 4
+                  pixelsHigh: 4
+               bitsPerSample: 8
+             samplesPerPixel: 4
+                    hasAlpha: YES
+                    isPlanar: NO
+              colorSpaceName: NSDeviceRGBColorSpace
+                 bytesPerRow: 0
+                bitsPerPixel: 0]);
+  text = [NSDictionary dictionaryWithObjectsAndKeys:
+    @"file:///tmp/a.png", @"Thumb::URI",
+    @"1234567890", @"Thumb::MTime",
+    nil];
+  data = [image representationUsingType: NSPNGFileType
+                             properties: [NSDictionary dictionaryWithObject:
+                                            text forKey: @"GSImagePNGText"]];
+  if (data != nil)
+    {
+      rep = [NSBitmapImageRep imageRepWithData: data];
+      read = [rep valueForProperty: @"GSImagePNGText"];
+      pass([read isEqual: text], "PNG text chunks are read back");
+
+      data = [image representationUsingType: NSPNGFileType properties: nil];
+      rep = [NSBitmapImageRep imageRepWithData: data];
+      pass([rep valueForProperty: @"GSImagePNGText"] == nil,
+           "PNG images without text chunks have no text property");
+    }
+
+  DESTROY(arp);
+  return 0;
+}
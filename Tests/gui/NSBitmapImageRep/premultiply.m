@@ -0,0 +1,156 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that premultiplying and unpremultiplying 8-bit images gives the
+same samples for meshed and planar images with the alpha first or last,
+and log the time taken for a large meshed RGBA image.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSDate.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSBitmapImageRep.h>
+#import <AppKit/NSGraphics.h>
+
+#define BENCH_SIZE 2048
+
+@interface NSBitmapImageRep (Premultiply)
+- (void) _premultiply;
+- (void) _unpremultiply;
+@end
+
+static NSBitmapImageRep *
+makeImage(NSInteger width, NSInteger height, NSInteger spp,
+          BOOL planar, BOOL alphaFirst)
+{
+  NSBitmapImageRep *rep;
+  unsigned char *planes[5];
+  NSInteger length, i, p;
+
+  rep = [[NSBitmapImageRep alloc]
+    initWithBitmapDataPlanes: NULL
+                  pixelsWide: width
+                  pixelsHigh: height
+               bitsPerSample: 8
+             samplesPerPixel: spp
+                    hasAlpha: YES
+                    isPlanar: planar
+              colorSpaceName: (spp == 2 ? NSCalibratedWhiteColorSpace
+                                        : NSCalibratedRGBColorSpace)
+                bitmapFormat: NSAlphaNonpremultipliedBitmapFormat
+                  | (alphaFirst ? NSAlphaFirstBitmapFormat : 0)
+                 bytesPerRow: 0
+                bitsPerPixel: 0];
+  [rep getBitmapDataPlanes: planes];
+  length = [rep bytesPerRow] * height;
+  for (p = 0; p < (planar ? spp : 1); p++)
+    {
+      for (i = 0; i < length; i++)
+        planes[p][i] = rand();
+    }
+  return AUTORELEASE(rep);
+}
+
+/* Premultiplies the samples of pixel (x, y) of rep with the formula used
+   for 8-bit images and compares them with those of premultiplied. */
+static BOOL
+samePremultiplied(NSBitmapImageRep *rep, NSBitmapImageRep *premultiplied,
+                  BOOL alphaFirst)
+{
+  NSInteger spp = [rep samplesPerPixel];
+  NSInteger ai = alphaFirst ? 0 : spp - 1;
+  NSUInteger a[5], b[5];
+  NSInteger x, y, i;
+
+  for (y = 0; y < [rep pixelsHigh]; y++)
+    {
+      for (x = 0; x < [rep pixelsWide]; x++)
+        {
+          [rep getPixel: a atX: x y: y];
+          [premultiplied getPixel: b atX: x y: y];
+          for (i = 0; i < spp; i++)
+            {
+              NSUInteger t = a[ai] * a[i] + 0x80;
+              NSUInteger expected = (i == ai) ? a[i] : ((t >> 8) + t) >> 8;
+
+              if (b[i] != expected)
+                return NO;
+            }
+        }
+    }
+  return YES;
+}
+
+/* Does the same for unpremultiplying. */
+static BOOL
+sameUnpremultiplied(NSBitmapImageRep *rep, NSBitmapImageRep *unpremultiplied,
+                    BOOL alphaFirst)
+{
+  NSInteger spp = [rep samplesPerPixel];
+  NSInteger ai = alphaFirst ? 0 : spp - 1;
+  NSUInteger a[5], b[5];
+  NSInteger x, y, i;
+
+  for (y = 0; y < [rep pixelsHigh]; y++)
+    {
+      for (x = 0; x < [rep pixelsWide]; x++)
+        {
+          [rep getPixel: a atX: x y: y];
+          [unpremultiplied getPixel: b atX: x y: y];
+          for (i = 0; i < spp; i++)
+            {
+              NSUInteger expected = a[i];
+
+              if (i != ai && a[ai] != 0 && a[ai] != 255)
+                expected = MIN(255, a[i] * 255 / a[ai]);
+              if (b[i] != expected)
+                return NO;
+            }
+        }
+    }
+  return YES;
+}
+
+int
+main(int argc, char **argv)
+{
+  NSInteger spps[] = { 2, 4 };
+  NSInteger s, planar, first;
+  NSBitmapImageRep *rep, *copy, *copy2;
+  NSDate *start;
+  BOOL ok = YES, unOk = YES;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+  srand(4711);
+
+  for (s = 0; s < 2; s++)
+    for (planar = 0; planar < 2; planar++)
+      for (first = 0; first < 2; first++)
+        {
+          /* An odd width checks the pixels after the last full block. */
+          rep = makeImage(37, 5, spps[s], planar, first);
+          copy = AUTORELEASE([rep copy]);
+          [copy _premultiply];
+          ok = ok && samePremultiplied(rep, copy, first);
+          copy2 = AUTORELEASE([copy copy]);
+          [copy2 _unpremultiply];
+          unOk = unOk && sameUnpremultiplied(copy, copy2, first);
+        }
+  pass(ok, "8-bit images are premultiplied correctly");
+  pass(unOk, "8-bit images are unpremultiplied correctly");
+
+  rep = makeImage(BENCH_SIZE, BENCH_SIZE, 4, NO, NO);
+  start = [NSDate date];
+  [rep _premultiply];
+  NSLog(@"Premultiplying a %dx%d RGBA image took %g seconds",
+        BENCH_SIZE, BENCH_SIZE, -[start timeIntervalSinceNow]);
+  start = [NSDate date];
+  [rep _unpremultiply];
+  NSLog(@"Unpremultiplying a %dx%d RGBA image took %g seconds",
+        BENCH_SIZE, BENCH_SIZE, -[start timeIntervalSinceNow]);
+
+  DESTROY(arp);
+  return 0;
+}
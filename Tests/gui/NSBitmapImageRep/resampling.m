@@ -0,0 +1,94 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that bitmaps resampled with each filter get the asked for size,
+keep smooth gradients and don't let transparent pixels darken the
+pixels next to them.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSBitmapImageRep.h>
+#import <AppKit/NSGraphics.h>
+
+static NSBitmapImageRep *
+makeImage(BOOL transparentHalf)
+{
+  NSBitmapImageRep *rep;
+  unsigned char *p;
+  int x, y;
+
+  rep = [[NSBitmapImageRep alloc]
+    initWithBitmapDataPlanes: NULL
+                  pixelsWide: 100
+                  pixelsHigh: 60
+               bitsPerSample: 8
+             samplesPerPixel: 4
+                    hasAlpha: YES
+                    isPlanar: NO
+              colorSpaceName: NSDeviceRGBColorSpace
+                bitmapFormat: NSAlphaNonpremultipliedBitmapFormat
+                 bytesPerRow: 0
+                bitsPerPixel: 0];
+  p = [rep bitmapData];
+  for (y = 0; y < 60; y++)
+    for (x = 0; x < 100; x++)
+      {
+        BOOL clear = transparentHalf && x >= 50;
+
+        *p++ = clear ? 0 : 200;
+        *p++ = clear ? 0 : x * 2;
+        *p++ = clear ? 0 : 50;
+        *p++ = clear ? 0 : 255;
+      }
+  return AUTORELEASE(rep);
+}
+
+int
+main(int argc, char **argv)
+{
+  NSBitmapImageRep *image, *rep;
+  GSImageResamplingFilter filter;
+  unsigned char *p;
+  BOOL sizes = YES, gradients = YES;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  image = makeImage(NO);
+  for (filter = GSImageResamplingBox; filter <= GSImageResamplingLanczos;
+       filter++)
+    {
+      rep = [image bitmapImageRepByResamplingToPixelsWide: 25
+                                               pixelsHigh: 15
+                                                   filter: filter];
+      if ([rep pixelsWide] != 25 || [rep pixelsHigh] != 15
+          || !NSEqualSizes([rep size], [image size]))
+        sizes = NO;
+      p = [rep bitmapData];
+      /* Pixel 12 covers source columns 48 to 51. */
+      if (p[0] != 200 || abs(p[4 * 12 + 1] - 99) > 2 || p[4 * 12 + 3] != 255)
+        gradients = NO;
+    }
+  pass(sizes, "resampled bitmaps have the asked for pixel size");
+  pass(gradients, "resampling keeps colours and gradients");
+
+  rep = [image bitmapImageRepByResamplingToPixelsWide: 300
+                                           pixelsHigh: 180
+                                               filter: GSImageResamplingLanczos];
+  p = [rep bitmapData];
+  pass([rep pixelsWide] == 300 && abs(p[4 * 150 + 1] - 99) <= 2,
+       "bitmaps can be enlarged");
+
+  image = makeImage(YES);
+  rep = [image bitmapImageRepByResamplingToPixelsWide: 10
+                                           pixelsHigh: 6
+                                               filter: GSImageResamplingBilinear];
+  p = [rep bitmapData];
+  pass(p[4 * 4 + 0] == 200 && p[4 * 4 + 2] == 50,
+       "transparent pixels don't bleed into their neighbours");
+
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,59 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that JPEG images are decoded at a reduced resolution when a small
+pixel size is asked for.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSData.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSBitmapImageRep.h>
+#import <AppKit/NSGraphics.h>
+
+int
+main(int argc, char **argv)
+{
+  NSBitmapImageRep *image, *rep;
+  NSData *data;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  image = [[NSBitmapImageRep alloc]
+    initWithBitmapDataPlanes: NULL
+                  pixelsWide: 256
+                  pixelsHigh: 200
+               bitsPerSample: 8
+             samplesPerPixel: 3
+                    hasAlpha: NO
+                    isPlanar: NO
+              colorSpaceName: NSDeviceRGBColorSpace
+                 bytesPerRow: 0
+                bitsPerPixel: 0];
+  memset([image bitmapData], 100, 256 * 200 * 3);
+
+  data = [image representationUsingType: NSJPEGFileType properties: nil];
+  if (data != nil)
+    {
+      rep = [NSBitmapImageRep imageRepWithData: data
+                                  forPixelSize: NSMakeSize(32, 25)];
+      pass([rep pixelsWide] == 32 && [rep pixelsHigh] == 25,
+           "JPEG is decoded at 1/8 for a small pixel size");
+
+      rep = [NSBitmapImageRep imageRepWithData: data
+                                  forPixelSize: NSMakeSize(64, 60)];
+      pass([rep pixelsWide] == 128 && [rep pixelsHigh] == 100,
+           "decoded JPEG is not smaller than the pixel size");
+
+      rep = [NSBitmapImageRep imageRepWithData: data
+                                  forPixelSize: NSMakeSize(1000, 1000)];
+      pass([rep pixelsWide] == 256 && [rep pixelsHigh] == 200,
+           "JPEG is decoded at full size for a large pixel size");
+    }
+
+  RELEASE(image);
+  DESTROY(arp);
+  return 0;
+}
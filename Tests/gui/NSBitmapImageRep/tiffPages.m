@@ -0,0 +1,77 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that the pages of a multi-page TIFF read back with their own pixels,
+also when they are decoded only once they are used.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSArray.h>
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSData.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSBitmapImageRep.h>
+#import <AppKit/NSGraphics.h>
+
+static NSBitmapImageRep *
+makeImage(NSInteger width, unsigned char value)
+{
+  NSBitmapImageRep *rep;
+
+  rep = [[NSBitmapImageRep alloc]
+    initWithBitmapDataPlanes: NULL
+                  pixelsWide: width
+                  pixelsHigh: 8
+               bitsPerSample: 8
+             samplesPerPixel: 3
+                    hasAlpha: NO
+                    isPlanar: NO
+              colorSpaceName: NSDeviceRGBColorSpace
+                 bytesPerRow: 0
+                bitsPerPixel: 0];
+  memset([rep bitmapData], value, width * 8 * 3);
+  return AUTORELEASE(rep);
+}
+
+int
+main(int argc, char **argv)
+{
+  NSArray *pages, *reps;
+  NSBitmapImageRep *copy;
+  NSData *data;
+  NSUInteger pixel[3];
+  NSInteger i;
+  BOOL ok = YES;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  pages = [NSArray arrayWithObjects: makeImage(8, 10), makeImage(16, 20),
+                   makeImage(24, 30), nil];
+  data = [NSBitmapImageRep TIFFRepresentationOfImageRepsInArray: pages];
+  reps = [NSBitmapImageRep imageRepsWithData: data];
+  pass([reps count] == 3, "all pages of the TIFF are read");
+
+  for (i = 0; i < 3 && i < [reps count]; i++)
+    {
+      NSBitmapImageRep *rep = [reps objectAtIndex: i];
+
+      if ([rep pixelsWide] != 8 * (i + 1)
+        || memcmp([rep bitmapData], [[pages objectAtIndex: i] bitmapData],
+                  8 * (i + 1) * 8 * 3) != 0)
+        ok = NO;
+    }
+  pass(ok, "each page has its own size and pixels");
+
+  reps = [NSBitmapImageRep imageRepsWithData: data];
+  copy = AUTORELEASE([[reps lastObject] copy]);
+  [[reps objectAtIndex: 1] getPixel: pixel atX: 3 y: 3];
+  pass(pixel[0] == 20 && pixel[1] == 20 && pixel[2] == 20,
+       "a page not decoded yet reads its pixels when asked for one");
+  pass(copy != nil && memcmp([copy bitmapData],
+                             [[pages lastObject] bitmapData], 24 * 8 * 3) == 0,
+       "a copy of a page not decoded yet has its pixels");
+
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,89 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that a browser loading columns lazily only loads the cells which
+are asked for, and reuses cells when a column is reloaded.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSString.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSBrowser.h>
+#import <AppKit/NSBrowserCell.h>
+#import <AppKit/NSMatrix.h>
+
+@interface Delegate : NSObject
+{
+@public
+  NSUInteger displayed;
+}
+@end
+
+@implementation Delegate
+- (NSInteger) browser: (NSBrowser *)sender
+ numberOfRowsInColumn: (NSInteger)column
+{
+  return 100000;
+}
+
+- (void) browser: (NSBrowser *)sender
+ willDisplayCell: (id)cell
+           atRow: (NSInteger)row
+          column: (NSInteger)column
+{
+  displayed++;
+  [cell setStringValue: [NSString stringWithFormat: @"%ld", (long)row]];
+  [cell setLeaf: YES];
+}
+@end
+
+int
+main(int argc, char **argv)
+{
+  NSBrowser *browser;
+  Delegate *delegate;
+  id cell0, cell500, cell;
+  NSUInteger displayed;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  delegate = AUTORELEASE([Delegate new]);
+  browser = AUTORELEASE([[NSBrowser alloc]
+    initWithFrame: NSMakeRect(0, 0, 300, 200)]);
+  [browser setLoadsColumnsLazily: YES];
+  [browser setReusesColumns: YES];
+  [browser setDelegate: delegate];
+  [browser loadColumnZero];
+  pass([[browser matrixInColumn: 0] numberOfRows] == 100000
+       && delegate->displayed <= 1,
+       "loading a column doesn't load all its cells");
+
+  displayed = delegate->displayed;
+  cell0 = [browser loadedCellAtRow: 0 column: 0];
+  cell500 = [browser loadedCellAtRow: 500 column: 0];
+  pass([[cell500 stringValue] isEqualToString: @"500"]
+       && delegate->displayed == displayed + 1,
+       "a cell is loaded when it is asked for");
+  pass([browser loadedCellAtRow: 500 column: 0] == cell500
+       && delegate->displayed == displayed + 1,
+       "a cell is loaded once");
+
+  [browser reloadColumn: 0];
+  cell = [browser loadedCellAtRow: 7 column: 0];
+  pass((cell == cell0 || cell == cell500)
+       && [[cell stringValue] isEqualToString: @"7"],
+       "cells are reused when a column is reloaded");
+
+  [browser selectRow: 500 inColumn: 0];
+  cell = [browser loadedCellAtRow: 500 column: 0];
+  [browser reloadColumn: 0];
+  pass([browser selectedRowInColumn: 0] == 500
+       && [browser selectedCellInColumn: 0] == cell
+       && [[cell stringValue] isEqualToString: @"500"],
+       "reloading a column keeps the selected row");
+
+  DESTROY(arp);
+  return 0;
+}
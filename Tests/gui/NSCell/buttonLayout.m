@@ -0,0 +1,72 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that a button cell reuses its title between draws and lays out its
+contents again once its title, image or image position changes.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSAttributedString.h>
+#import <AppKit/NSButton.h>
+#import <AppKit/NSButtonCell.h>
+#import <AppKit/NSFont.h>
+#import <AppKit/NSImage.h>
+#import <AppKit/NSWindow.h>
+
+int
+main(int argc, char **argv)
+{
+  NSWindow *window;
+  NSButton *button;
+  NSButtonCell *cell;
+  NSAttributedString *title;
+  NSSize size;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+  window = [[NSWindow alloc] initWithContentRect: NSMakeRect(100, 100, 200, 100)
+                                       styleMask: NSBorderlessWindowMask
+                                         backing: NSBackingStoreBuffered
+                                           defer: NO];
+  button = AUTORELEASE([[NSButton alloc]
+    initWithFrame: NSMakeRect(10, 10, 150, 40)]);
+  [[window contentView] addSubview: button];
+  cell = [button cell];
+  [cell setTitle: @"Short"];
+
+  title = [cell attributedTitle];
+  pass([cell attributedTitle] == title, "an unchanged title is reused");
+  [button display];
+  [button display];
+  size = [cell cellSize];
+  pass(NSEqualSizes([cell cellSize], size), "the size of a cell is stable");
+
+  [cell setTitle: @"A much longer title"];
+  pass([cell attributedTitle] != title
+       && [[[cell attributedTitle] string] isEqual: @"A much longer title"],
+       "a new title is built again");
+  [button display];
+  pass([cell cellSize].width > size.width, "a longer title makes a wider cell");
+
+  size = [cell cellSize];
+  [cell setFont: [NSFont systemFontOfSize: 2 * [[cell font] pointSize]]];
+  [button display];
+  pass([cell cellSize].height > size.height, "a larger font makes a taller cell");
+
+  [cell setImage: [NSImage imageNamed: @"common_ArrowRight"]];
+  [cell setImagePosition: NSImageLeft];
+  [button display];
+  size = [cell cellSize];
+  [cell setImagePosition: NSImageAbove];
+  [button display];
+  testHopeful = YES;
+  pass([cell cellSize].height > size.height,
+       "an image above the title makes a taller cell");
+  testHopeful = NO;
+
+  RELEASE(window);
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,76 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that a cell reuses the attributed string it builds from its title,
+and builds it again once the title, font, alignment or enabled state
+changes.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSDictionary.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSAttributedString.h>
+#import <AppKit/NSCell.h>
+#import <AppKit/NSColor.h>
+#import <AppKit/NSFont.h>
+#import <AppKit/NSParagraphStyle.h>
+
+int
+main(int argc, char **argv)
+{
+  NSCell *cell;
+  NSCell *copy;
+  NSAttributedString *title;
+  NSAttributedString *other;
+  NSSize size;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+  cell = [[NSCell alloc] initTextCell: @"Cached title"];
+
+  title = [cell attributedStringValue];
+  pass([cell attributedStringValue] == title,
+       "an unchanged cell reuses its title");
+  size = [cell cellSize];
+  pass(NSEqualSizes([cell cellSize], size), "the size of a cell is stable");
+
+  [cell setStringValue: @"Another title"];
+  other = [cell attributedStringValue];
+  pass(other != title && [[other string] isEqual: @"Another title"],
+       "a new title is built again");
+
+  title = other;
+  [cell setFont: [NSFont boldSystemFontOfSize: 20]];
+  other = [cell attributedStringValue];
+  pass(other != title
+       && [[other attribute: NSFontAttributeName atIndex: 0
+		effectiveRange: NULL] isEqual: [cell font]],
+       "a new font is used in the title");
+  pass([cell cellSize].height > size.height,
+       "a larger font makes a larger cell");
+
+  title = other;
+  [cell setAlignment: NSRightTextAlignment];
+  other = [cell attributedStringValue];
+  pass([[other attribute: NSParagraphStyleAttributeName atIndex: 0
+	     effectiveRange: NULL] alignment] == NSRightTextAlignment,
+       "a new alignment is used in the title");
+
+  title = other;
+  [cell setEnabled: NO];
+  other = [cell attributedStringValue];
+  pass(other != title
+       && [[other attribute: NSForegroundColorAttributeName atIndex: 0
+		effectiveRange: NULL] isEqual: [cell textColor]],
+       "a disabled cell uses the disabled text colour");
+
+  copy = [cell copy];
+  pass([[[copy attributedStringValue] string] isEqual: @"Another title"],
+       "a copy builds its own title");
+  RELEASE(copy);
+
+  RELEASE(cell);
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,81 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that a collection view lays out items arithmetically, only loads
+the items of the rows it shows and reuses items when scrolled.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSArray.h>
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSValue.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSCollectionView.h>
+#import <AppKit/NSCollectionViewItem.h>
+
+@interface NSCollectionView (Private)
+- (void) _loadItemsInRect: (NSRect)rect;
+@end
+
+int
+main(int argc, char **argv)
+{
+  NSCollectionView *cv;
+  NSCollectionViewItem *prototype;
+  NSMutableArray *content, *items;
+  NSRect frame;
+  NSUInteger i;
+  BOOL reused = YES;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  content = [NSMutableArray array];
+  for (i = 0; i < 50000; i++)
+    {
+      [content addObject: [NSNumber numberWithUnsignedInteger: i]];
+    }
+
+  prototype = AUTORELEASE([NSCollectionViewItem new]);
+  [prototype setView:
+    AUTORELEASE([[NSView alloc] initWithFrame: NSMakeRect(0, 0, 100, 50)])];
+  cv = AUTORELEASE([[NSCollectionView alloc]
+    initWithFrame: NSMakeRect(0, 0, 400, 300)]);
+  [cv setItemPrototype: prototype];
+  [cv setContent: content];
+
+  frame = [cv frameForItemAtIndex: 4999];
+  pass(NSHeight([cv frame]) == 12500 * 50
+       && NSEqualRects(frame, NSMakeRect(300, 1249 * 50, 100, 50)),
+       "items are laid out in rows of four");
+  pass([[cv subviews] count] == 0, "setting the content loads no items");
+
+  [cv _loadItemsInRect: NSMakeRect(0, 1000, 400, 300)];
+  pass([[cv subviews] count] == 28
+       && [[[cv itemAtIndex: 85] representedObject] isEqual:
+	 [content objectAtIndex: 85]],
+       "the items of the rows in a rect are loaded");
+
+  items = [NSMutableArray array];
+  for (i = 80; i < 108; i++)
+    {
+      [items addObject: [cv itemAtIndex: i]];
+    }
+  [cv _loadItemsInRect: NSMakeRect(0, 200000, 400, 300)];
+  for (i = 16000; i < 16028; i++)
+    {
+      NSCollectionViewItem *item = [cv itemAtIndex: i];
+
+      if ([items indexOfObjectIdenticalTo: item] == NSNotFound
+	  || ![[item representedObject] isEqual: [content objectAtIndex: i]]
+	  || !NSEqualRects([[item view] frame], [cv frameForItemAtIndex: i]))
+	{
+	  reused = NO;
+	}
+    }
+  pass(reused && [[cv subviews] count] == 28,
+       "scrolling reuses the items which went out of view");
+
+  DESTROY(arp);
+  return 0;
+}
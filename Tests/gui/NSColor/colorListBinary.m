@@ -0,0 +1,67 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that a color list written in the binary format is read back with
+its colors in order, and that a truncated binary list is rejected.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSData.h>
+#import <Foundation/NSPathUtilities.h>
+#import <Foundation/NSProcessInfo.h>
+#import <Foundation/NSFileManager.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSColor.h>
+#import <AppKit/NSColorList.h>
+
+int
+main(int argc, char **argv)
+{
+  NSColorList *list, *read;
+  NSString *path;
+  NSData *data;
+  NSColor *c;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  list = AUTORELEASE([[NSColorList alloc] initWithName: @"Binary"]);
+  [list setColor: [NSColor colorWithCalibratedRed: 1 green: 0.5 blue: 0
+					    alpha: 1]
+	  forKey: @"Orange"];
+  [list setColor: [NSColor colorWithCalibratedWhite: 0.25 alpha: 0.5]
+	  forKey: @"Grey"];
+  data = [list binaryRepresentation];
+  pass(data != nil && [data length] == 9 + 2 * (2 + 16) + 6 + 4,
+       "a color list has a compact binary representation");
+
+  path = [NSTemporaryDirectory() stringByAppendingPathComponent:
+    [[[NSProcessInfo processInfo] globallyUniqueString]
+      stringByAppendingPathExtension: @"clr"]];
+  [data writeToFile: path atomically: NO];
+  read = AUTORELEASE([[NSColorList alloc] initWithName: @"Binary"
+					      fromFile: path]);
+  pass([[read allKeys] isEqual: [list allKeys]],
+       "the binary list is read with its keys in order");
+  c = [read colorWithKey: @"Orange"];
+  pass([c greenComponent] == 0.5 && [c alphaComponent] == 1,
+       "the binary list is read with its colors");
+  c = [[read colorWithKey: @"Grey"]
+    colorUsingColorSpaceName: NSCalibratedWhiteColorSpace];
+  pass([c whiteComponent] == 0.25 && [c alphaComponent] == 0.5,
+       "colors in other color spaces are kept");
+
+  [[data subdataWithRange: NSMakeRange(0, [data length] - 1)]
+    writeToFile: path atomically: NO];
+  read = AUTORELEASE([[NSColorList alloc] initWithName: @"Binary"
+					      fromFile: path]);
+  pass([[read allKeys] count] == 0, "a truncated binary list is rejected");
+
+  pass([NSColorList colorListNamed: @"System"] != nil,
+       "the available lists are found by name");
+
+  [[NSFileManager defaultManager] removeFileAtPath: path handler: nil];
+  DESTROY(arp);
+  return 0;
+}
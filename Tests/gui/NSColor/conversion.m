@@ -0,0 +1,49 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that converting a colour to another colour space gives the same
+colour each time it is asked for, and that copies of a colour convert
+by themselves.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSColor.h>
+
+int
+main(int argc, char **argv)
+{
+  NSColor *color;
+  NSColor *device;
+  NSColor *copy;
+  CGFloat r, g, b, a;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  color = [NSColor colorWithCalibratedRed: 0.2 green: 0.4 blue: 0.6 alpha: 1];
+  device = [color colorUsingColorSpaceName: NSDeviceRGBColorSpace];
+  pass([[device colorSpaceName] isEqualToString: NSDeviceRGBColorSpace],
+       "colour converts to device RGB");
+  pass([color colorUsingColorSpaceName: NSDeviceRGBColorSpace] == device,
+       "converting again gives the same colour");
+  pass([color colorUsingColorSpaceName: NSCalibratedRGBColorSpace] == color,
+       "converting to its own colour space gives the colour itself");
+
+  copy = [color colorWithAlphaComponent: 0.5];
+  device = [copy colorUsingColorSpaceName: NSDeviceRGBColorSpace];
+  [device getRed: &r green: &g blue: &b alpha: &a];
+  pass(fabs(r - 0.2) < 0.001 && fabs(a - 0.5) < 0.001,
+       "a copy with another alpha converts with its own alpha");
+
+  color = [NSColor controlColor];
+  device = [color colorUsingColorSpaceName: NSDeviceRGBColorSpace];
+  pass(device != nil
+       && [color colorUsingColorSpaceName: NSCalibratedRGBColorSpace] != nil
+       && [color colorUsingColorSpaceName: NSDeviceRGBColorSpace] == device,
+       "system colour converts to the same colour in turn");
+
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,80 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that combo box cells complete strings to the first item which
+extends them, for their own items and for a data source, and that the
+completions follow changes to the items.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSString.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSComboBoxCell.h>
+
+@interface Source : NSObject
+{
+@public
+  NSInteger count;
+}
+@end
+
+@implementation Source
+- (NSInteger) numberOfItemsInComboBoxCell: (NSComboBoxCell *)cell
+{
+  return count;
+}
+- (id) comboBoxCell: (NSComboBoxCell *)cell objectValueForItemAtIndex: (NSInteger)index
+{
+  return [NSString stringWithFormat: @"item %06ld", (long)(count - 1 - index)];
+}
+@end
+
+int
+main(int argc, char **argv)
+{
+  NSComboBoxCell *cell;
+  Source *source;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  cell = [[NSComboBoxCell alloc] initTextCell: @""];
+  [cell addItemsWithObjectValues:
+    [NSArray arrayWithObjects: @"pear", @"apple", @"apricot", @"ap", nil]];
+  pass([[cell completedString: @"ap"] isEqual: @"apple"],
+       "completes to the first item extending the string");
+  pass([[cell completedString: @"apr"] isEqual: @"apricot"],
+       "longer string narrows the completion");
+  pass([[cell completedString: @"pear"] isEqual: @"pear"],
+       "string of a whole item is not completed");
+  pass([[cell completedString: @"Ap"] isEqual: @"Ap"],
+       "completion is case sensitive");
+  pass([[cell completedString: @"x"] isEqual: @"x"],
+       "string no item extends is returned");
+
+  [cell insertItemWithObjectValue: @"apex" atIndex: 0];
+  pass([[cell completedString: @"ap"] isEqual: @"apex"],
+       "completion follows inserted items");
+  [cell removeItemAtIndex: 0];
+  pass([[cell completedString: @"ap"] isEqual: @"apple"],
+       "completion follows removed items");
+  [cell release];
+
+  source = [Source new];
+  source->count = 100000;
+  cell = [[NSComboBoxCell alloc] initTextCell: @""];
+  [cell setUsesDataSource: YES];
+  [cell setDataSource: source];
+  pass([[cell completedString: @"item 00000"] isEqual: @"item 000009"],
+       "completes from the items of a data source");
+  source->count = 100001;
+  [cell reloadData];
+  pass([[cell completedString: @"item 1"] isEqual: @"item 100000"],
+       "reloading the data source updates the completions");
+
+  [cell release];
+  [source release];
+  DESTROY(arp);
+  return 0;
+}
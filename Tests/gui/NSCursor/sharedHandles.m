@@ -0,0 +1,66 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that cursors made from the same image and hot spot share their
+backend cursor, and that a recolored cursor gets one of its own.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSColor.h>
+#import <AppKit/NSCursor.h>
+#import <AppKit/NSImage.h>
+
+@interface NSCursor (Private)
+- (void *) _cid;
+@end
+
+int
+main(int argc, char **argv)
+{
+  NSImage *image;
+  NSCursor *a;
+  NSCursor *b;
+  NSCursor *c;
+  NSCursor *d;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  image = [[NSImage alloc] initWithSize: NSMakeSize(16, 16)];
+  [image lockFocus];
+  [[NSColor blackColor] set];
+  NSRectFill(NSMakeRect(0, 0, 16, 16));
+  [image unlockFocus];
+
+  a = [[NSCursor alloc] initWithImage: image hotSpot: NSMakePoint(1, 1)];
+  b = [[NSCursor alloc] initWithImage: image hotSpot: NSMakePoint(1, 1)];
+  c = [[NSCursor alloc] initWithImage: image hotSpot: NSMakePoint(2, 2)];
+  testHopeful = YES;
+  pass([a _cid] != NULL, "the backend makes cursors from images");
+  testHopeful = NO;
+  pass([a _cid] == [b _cid], "the same image and hot spot share a cursor");
+  pass([c _cid] != [a _cid] || [a _cid] == NULL,
+       "another hot spot gets another cursor");
+
+  d = [[NSCursor alloc] initWithImage: image
+		  foregroundColorHint: [NSColor redColor]
+		  backgroundColorHint: nil
+			      hotSpot: NSMakePoint(1, 1)];
+  pass([d _cid] != [a _cid] || [a _cid] == NULL,
+       "a recolored cursor does not share its cursor");
+
+  RELEASE(a);
+  a = [[NSCursor alloc] initWithImage: image hotSpot: NSMakePoint(1, 1)];
+  pass([a _cid] == [b _cid],
+       "a shared cursor stays while any cursor uses it");
+
+  RELEASE(a);
+  RELEASE(b);
+  RELEASE(c);
+  RELEASE(d);
+  RELEASE(image);
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,81 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that consecutive mouse moved events are collapsed into one when
+mouse coalescing is enabled, and that the events they stand for can
+still be had.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSArray.h>
+#import <Foundation/NSDate.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSEvent.h>
+
+static NSEvent *
+moved(CGFloat x, NSInteger window)
+{
+  return [NSEvent mouseEventWithType: NSMouseMoved
+                            location: NSMakePoint(x, 0.0)
+                       modifierFlags: 0
+                           timestamp: x
+                        windowNumber: window
+                             context: nil
+                         eventNumber: 0
+                          clickCount: 0
+                            pressure: 0.0
+                        buttonNumber: 0
+                              deltaX: 1.0
+                              deltaY: 2.0
+                              deltaZ: 0.0];
+}
+
+static NSEvent *
+next(void)
+{
+  return [NSApp nextEventMatchingMask: NSAnyEventMask
+                            untilDate: [NSDate distantPast]
+                               inMode: NSDefaultRunLoopMode
+                              dequeue: YES];
+}
+
+int
+main(int argc, char **argv)
+{
+  NSEvent *ev;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  pass([NSEvent isMouseCoalescingEnabled] == NO,
+       "mouse coalescing is off by default");
+  [NSApp postEvent: moved(1.0, 1) atStart: NO];
+  [NSApp postEvent: moved(2.0, 1) atStart: NO];
+  ev = next();
+  pass([ev locationInWindow].x == 1.0 && [[ev coalescedEvents] count] == 1,
+       "motion events are delivered one by one without coalescing");
+  next();
+
+  [NSEvent setMouseCoalescingEnabled: YES];
+  [NSApp postEvent: moved(1.0, 1) atStart: NO];
+  [NSApp postEvent: moved(2.0, 1) atStart: NO];
+  [NSApp postEvent: moved(3.0, 1) atStart: NO];
+  [NSApp postEvent: moved(4.0, 2) atStart: NO];
+  ev = next();
+  pass([ev type] == NSMouseMoved && [ev locationInWindow].x == 3.0
+       && [ev timestamp] == 3.0,
+       "coalesced event has the location and time of the latest event");
+  pass([ev deltaX] == 3.0 && [ev deltaY] == 6.0,
+       "coalesced event has the sum of the deltas");
+  pass([[ev coalescedEvents] count] == 3
+       && [[[ev coalescedEvents] objectAtIndex: 0] locationInWindow].x == 1.0,
+       "coalesced event keeps the intermediate events in order");
+  ev = next();
+  pass([ev windowNumber] == 2 && [[ev coalescedEvents] count] == 1,
+       "events for another window are not coalesced");
+  [NSEvent setMouseCoalescingEnabled: NO];
+
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,72 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that a mouse event nobody holds on to any more is used again for
+the next one, with nothing left over from its last use, and that an
+event which is kept is not.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSEvent.h>
+
+static NSEvent *
+moved(CGFloat x, CGFloat dx)
+{
+  return [NSEvent mouseEventWithType: NSMouseMoved
+			    location: NSMakePoint(x, 0.0)
+		       modifierFlags: 0
+			   timestamp: 0
+			windowNumber: 0
+			     context: nil
+			 eventNumber: 0
+			  clickCount: 0
+			    pressure: 0.0
+			buttonNumber: 0
+			      deltaX: dx
+			      deltaY: 0.0
+			      deltaZ: 0.0];
+}
+
+int
+main(int argc, char **argv)
+{
+  NSAutoreleasePool *pool;
+  NSEvent *first;
+  NSEvent *ev;
+  NSUInteger i;
+  BOOL reused = NO;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  pool = [NSAutoreleasePool new];
+  first = moved(1.0, 5.0);
+  [pool release];
+  pool = [NSAutoreleasePool new];
+  for (i = 0; i < 32 && reused == NO; i++)
+    {
+      ev = moved(2.0, 0.0);
+      reused = (ev == first);
+    }
+  pass(reused, "an event nobody keeps is used again");
+  pass([ev locationInWindow].x == 2.0 && [ev deltaX] == 0.0,
+       "a reused event has the new values only");
+  RETAIN(ev);
+  [pool release];
+
+  pool = [NSAutoreleasePool new];
+  reused = NO;
+  for (i = 0; i < 32; i++)
+    {
+      reused = reused || (moved(3.0, 0.0) == ev);
+    }
+  pass(reused == NO, "a kept event is not reused");
+  pass([ev locationInWindow].x == 2.0, "a kept event keeps its values");
+  [pool release];
+  RELEASE(ev);
+
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,66 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that a directory wrapper read from disk keeps the contents of its
+files, and that unchanged files are linked rather than copied when the
+wrapper is written somewhere else.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSData.h>
+#import <Foundation/NSDictionary.h>
+#import <Foundation/NSFileManager.h>
+#import <Foundation/NSPathUtilities.h>
+#import <Foundation/NSProcessInfo.h>
+#import <Foundation/NSString.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSFileWrapper.h>
+
+int
+main(int argc, char **argv)
+{
+  NSFileManager *mgr = [NSFileManager defaultManager];
+  NSData *data = [@"some contents" dataUsingEncoding: NSUTF8StringEncoding];
+  NSString *dir;
+  NSString *src;
+  NSString *dst;
+  NSFileWrapper *wrapper;
+  NSFileWrapper *child;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+  dir = [NSTemporaryDirectory() stringByAppendingPathComponent:
+    [[NSProcessInfo processInfo] globallyUniqueString]];
+  src = [dir stringByAppendingPathComponent: @"src"];
+  dst = [dir stringByAppendingPathComponent: @"dst"];
+  [mgr createDirectoryAtPath: dir attributes: nil];
+  [mgr createDirectoryAtPath: src attributes: nil];
+  [data writeToFile: [src stringByAppendingPathComponent: @"a"]
+	 atomically: NO];
+
+  wrapper = AUTORELEASE([[NSFileWrapper alloc] initWithPath: src]);
+  child = [[wrapper fileWrappers] objectForKey: @"a"];
+  pass([[child regularFileContents] isEqual: data],
+       "a file in a directory wrapper has its contents");
+
+  [wrapper addRegularFileWithContents: data preferredFilename: @"b"];
+  pass([wrapper writeToFile: dst atomically: NO updateFilenames: NO],
+       "the wrapper can be written elsewhere");
+  pass([[NSData dataWithContentsOfFile:
+    [dst stringByAppendingPathComponent: @"a"]] isEqual: data]
+       && [[NSData dataWithContentsOfFile:
+    [dst stringByAppendingPathComponent: @"b"]] isEqual: data],
+       "the written wrapper has the contents of its files");
+  testHopeful = YES;
+  pass([[[mgr fileAttributesAtPath: [dst stringByAppendingPathComponent: @"a"]
+		      traverseLink: NO] fileSystemFileNumber]
+    == [[[mgr fileAttributesAtPath: [src stringByAppendingPathComponent: @"a"]
+			traverseLink: NO] fileSystemFileNumber],
+       "an unchanged file is linked to the file it was read from");
+  testHopeful = NO;
+
+  [mgr removeFileAtPath: dir handler: nil];
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,63 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check the colours a gradient interpolates between its stops, and that a
+copy interpolates the same colours.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSColor.h>
+#import <AppKit/NSGradient.h>
+
+static BOOL
+near(NSColor *c, CGFloat red, CGFloat green, CGFloat blue)
+{
+  CGFloat r, g, b, a;
+
+  [[c colorUsingColorSpaceName: NSCalibratedRGBColorSpace]
+    getRed: &r green: &g blue: &b alpha: &a];
+  return fabs(r - red) < 0.01 && fabs(g - green) < 0.01
+    && fabs(b - blue) < 0.01;
+}
+
+int
+main(int argc, char **argv)
+{
+  NSGradient *gradient;
+  NSGradient *copy;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  gradient = [[NSGradient alloc]
+    initWithStartingColor: [NSColor colorWithCalibratedRed: 0 green: 0
+                                                      blue: 0 alpha: 1]
+              endingColor: [NSColor colorWithCalibratedRed: 1 green: 1
+                                                      blue: 1 alpha: 1]];
+  pass(near([gradient interpolatedColorAtLocation: 0.25], 0.25, 0.25, 0.25),
+       "colour a quarter of the way is a quarter of the way to the end");
+  pass(near([gradient interpolatedColorAtLocation: -1.0], 0, 0, 0)
+       && near([gradient interpolatedColorAtLocation: 2.0], 1, 1, 1),
+       "colours outside the stops are the end colours");
+
+  copy = [gradient copy];
+  pass(near([copy interpolatedColorAtLocation: 0.75], 0.75, 0.75, 0.75),
+       "copy interpolates the same colours");
+  [copy release];
+  [gradient release];
+
+  gradient = [[NSGradient alloc] initWithColorsAndLocations:
+    [NSColor colorWithCalibratedRed: 1 green: 0 blue: 0 alpha: 1], 0.0,
+    [NSColor colorWithCalibratedRed: 0 green: 1 blue: 0 alpha: 1], 0.2,
+    [NSColor colorWithCalibratedRed: 0 green: 0 blue: 1 alpha: 1], 1.0,
+    nil];
+  pass(near([gradient interpolatedColorAtLocation: 0.1], 0.5, 0.5, 0)
+       && near([gradient interpolatedColorAtLocation: 0.6], 0, 0.5, 0.5),
+       "colours between uneven stops are interpolated");
+  [gradient release];
+
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,38 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check the statistics of the image cache with a small byte budget.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSDictionary.h>
+#import <Foundation/NSValue.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSImage.h>
+
+int
+main(int argc, char **argv)
+{
+  NSDictionary *stats;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  [NSImage setImageCacheByteBudget: 1024 * 1024];
+  pass([NSImage imageCacheByteBudget] == 1024 * 1024,
+       "image cache byte budget can be set");
+
+  stats = [NSImage imageCacheStatistics];
+  pass([[stats objectForKey: @"ByteBudget"] unsignedIntegerValue]
+       == 1024 * 1024, "statistics report the budget");
+  pass([[stats objectForKey: @"BytesInUse"] unsignedIntegerValue]
+       <= 1024 * 1024, "caches stay within the budget");
+  pass([stats objectForKey: @"Entries"] != nil
+       && [stats objectForKey: @"Evictions"] != nil
+       && [stats objectForKey: @"Recaches"] != nil,
+       "statistics report entries, evictions and recaches");
+
+  DESTROY(arp);
+  return 0;
+}
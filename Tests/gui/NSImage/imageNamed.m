@@ -0,0 +1,35 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that +imageNamed: finds system images with and without their
+extension, and returns nil for names that don't exist.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSString.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSImage.h>
+
+int
+main(int argc, char **argv)
+{
+  NSImage *image;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  image = [NSImage imageNamed: @"GNUstep"];
+  pass(image != nil, "system image is found without extension");
+  pass([NSImage imageNamed: @"GNUstep.tiff"] != nil,
+       "system image is found with extension");
+  pass([NSImage imageNamed: @"GNUstep.png"] == nil,
+       "system image is not found with another extension");
+  pass([NSImage imageNamed: @"NoSuchImageAnywhere"] == nil,
+       "missing image is not found");
+  pass([NSImage imageNamed: @"GNUstep"] == image,
+       "image found again is the same");
+
+  DESTROY(arp);
+  return 0;
+}
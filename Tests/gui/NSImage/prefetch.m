@@ -0,0 +1,43 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that images prefetched for a model are loaded from their files
+when first used, and that missing names are ignored.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSArray.h>
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSString.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSImage.h>
+#import <AppKit/NSImageRep.h>
+
+@interface NSImage (Private)
++ (void) _prefetchImagesNamed: (NSArray *)names;
+@end
+
+int
+main(int argc, char **argv)
+{
+  NSImage *image;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  [NSImage _prefetchImagesNamed:
+    [NSArray arrayWithObjects: @"GNUstep", @"NoSuchImageAnywhere", nil]];
+  image = [NSImage imageNamed: @"GNUstep"];
+  pass(image != nil && [[image representations] count] > 0,
+       "prefetched image has representations");
+  pass(NSEqualSizes([image size],
+                    [[[image representations] objectAtIndex: 0] size]),
+       "prefetched image takes its size from the file");
+
+  [NSImage _prefetchImagesNamed: [NSArray arrayWithObject: @"GNUstep"]];
+  pass([[image representations] count] > 0,
+       "prefetching a loaded image keeps its representations");
+
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,72 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that an image referencing a file reads it again after its data
+was purged, and that an image made from data keeps its representations.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSArray.h>
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSData.h>
+#import <Foundation/NSFileManager.h>
+#import <Foundation/NSPathUtilities.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSBitmapImageRep.h>
+#import <AppKit/NSGraphics.h>
+#import <AppKit/NSImage.h>
+
+int
+main(int argc, char **argv)
+{
+  NSBitmapImageRep *bitmap;
+  NSImage *referencing, *retained;
+  NSString *path;
+  NSData *data;
+  NSImageRep *rep;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  bitmap = [[NSBitmapImageRep alloc]
+    initWithBitmapDataPlanes: NULL
+                  pixelsWide: 4
+                  pixelsHigh: 4
+               bitsPerSample: 8
+             samplesPerPixel: 3
+                    hasAlpha: NO
+                    isPlanar: NO
+              colorSpaceName: NSDeviceRGBColorSpace
+                 bytesPerRow: 0
+                bitsPerPixel: 0];
+  data = [bitmap TIFFRepresentation];
+  path = [NSTemporaryDirectory()
+    stringByAppendingPathComponent: @"purge-test.tiff"];
+  [data writeToFile: path atomically: NO];
+
+  referencing = [[NSImage alloc] initByReferencingFile: path];
+  rep = [[referencing representations] lastObject];
+  pass(rep != nil, "referenced file is loaded on use");
+  [referencing purgeImageData];
+  pass([[referencing representations] count] == 1
+       && [[referencing representations] lastObject] != rep,
+       "purged image loads its file again");
+
+  retained = [[NSImage alloc] initWithData: data];
+  rep = [[retained representations] lastObject];
+  [retained purgeImageData];
+  pass([[retained representations] count] == 1
+       && [[retained representations] lastObject] == rep,
+       "image made from data keeps its representations");
+
+  [NSImage purgeImageDataUnusedFor: 0];
+  pass([[referencing representations] count] == 1,
+       "purging all unused images leaves images usable");
+
+  [[NSFileManager defaultManager] removeFileAtPath: path handler: nil];
+  RELEASE(referencing);
+  RELEASE(retained);
+  RELEASE(bitmap);
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,86 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that an image view which animates steps the frames of an animated
+GIF while it is shown, and pauses while it is hidden.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSData.h>
+#import <Foundation/NSDate.h>
+#import <Foundation/NSRunLoop.h>
+#import <Foundation/NSValue.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSBitmapImageRep.h>
+#import <AppKit/NSImage.h>
+#import <AppKit/NSImageView.h>
+#import <AppKit/NSWindow.h>
+
+/* A 1x1 animation with a red and a blue frame, shown for 0.1 and 0.2
+   seconds and looping forever. */
+static const unsigned char animation[] = {
+  'G', 'I', 'F', '8', '9', 'a', 1, 0, 1, 0, 0x80, 0, 0,
+  0xff, 0x00, 0x00, 0x00, 0x00, 0xff,
+  0x21, 0xff, 11, 'N', 'E', 'T', 'S', 'C', 'A', 'P', 'E', '2', '.', '0',
+  3, 1, 0, 0, 0,
+  0x21, 0xf9, 4, 0, 10, 0, 0, 0,
+  0x2c, 0, 0, 0, 0, 1, 0, 1, 0, 0, 2, 2, 0x44, 0x01, 0,
+  0x21, 0xf9, 4, 0, 20, 0, 0, 0,
+  0x2c, 0, 0, 0, 0, 1, 0, 1, 0, 0, 2, 2, 0x4c, 0x01, 0,
+  0x3b
+};
+
+static void
+run(NSTimeInterval seconds)
+{
+  [[NSRunLoop currentRunLoop] runUntilDate:
+    [NSDate dateWithTimeIntervalSinceNow: seconds]];
+}
+
+int
+main(int argc, char **argv)
+{
+  NSWindow *window;
+  NSImageView *view;
+  NSImage *image;
+  NSBitmapImageRep *rep;
+  int frame;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  image = AUTORELEASE([[NSImage alloc] initWithData:
+    [NSData dataWithBytes: animation length: sizeof(animation)]]);
+  rep = (NSBitmapImageRep *)[[image representations] objectAtIndex: 0];
+  window = [[NSWindow alloc] initWithContentRect: NSMakeRect(100, 100, 50, 50)
+				       styleMask: NSBorderlessWindowMask
+					 backing: NSBackingStoreBuffered
+					   defer: NO];
+  view = AUTORELEASE([[NSImageView alloc]
+    initWithFrame: NSMakeRect(0, 0, 50, 50)]);
+  [view setImage: image];
+  [[window contentView] addSubview: view];
+  [window orderFront: nil];
+
+  pass(![view animates], "an image view does not animate by default");
+  [view setAnimates: YES];
+  pass([view animates], "an image view can be made to animate");
+
+  testHopeful = YES;
+  run(0.15);
+  pass([[rep valueForProperty: NSImageCurrentFrame] intValue] == 1,
+       "the frames are stepped while the view is shown");
+
+  [view setHidden: YES];
+  frame = [[rep valueForProperty: NSImageCurrentFrame] intValue];
+  run(0.5);
+  pass([[rep valueForProperty: NSImageCurrentFrame] intValue] == frame,
+       "the animation pauses while the view is hidden");
+  testHopeful = NO;
+
+  [view setAnimates: NO];
+  RELEASE(window);
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,92 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that key binding tables find single and multi-stroke bindings,
+honour overridden and disabled bindings, and keep working as many
+bindings are added.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSDictionary.h>
+#import <Foundation/NSString.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSEvent.h>
+
+/* GSKeyBindingTable is private to the library.  */
+@interface GSKeyBindingTable : NSObject
+- (void) loadBindingsFromDictionary: (NSDictionary *)dict;
+- (void) bindKey: (id)key  toAction: (id)action;
+- (BOOL) lookupKeyStroke: (unichar)character
+	       modifiers: (NSUInteger)flags
+       returningActionIn: (id *)action
+		 tableIn: (GSKeyBindingTable **)table;
+@end
+
+int
+main(int argc, char **argv)
+{
+  GSKeyBindingTable *t;
+  GSKeyBindingTable *next;
+  id action;
+  BOOL allFound = YES;
+  int i;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  t = [GSKeyBindingTable new];
+  [t loadBindingsFromDictionary:
+    [NSDictionary dictionaryWithObjectsAndKeys:
+      @"moveForward:", @"Control-f",
+      [NSDictionary dictionaryWithObject: @"save:" forKey: @"Control-s"],
+      @"Control-x",
+      @"deleteForward:", @"Control-d",
+      nil]];
+
+  action = nil;
+  next = nil;
+  pass([t lookupKeyStroke: 'f' modifiers: NSControlKeyMask
+        returningActionIn: &action tableIn: &next]
+       && action != nil && next == nil,
+       "single stroke binding is found");
+  pass(![t lookupKeyStroke: 'f' modifiers: 0
+         returningActionIn: &action tableIn: &next],
+       "modifiers are part of the keystroke");
+
+  action = nil;
+  next = nil;
+  pass([t lookupKeyStroke: 'x' modifiers: NSControlKeyMask
+        returningActionIn: &action tableIn: &next]
+       && action == nil && next != nil,
+       "prefix of a multi-stroke binding returns a table");
+  pass([next lookupKeyStroke: 's' modifiers: NSControlKeyMask
+           returningActionIn: &action tableIn: &next]
+       && action != nil,
+       "second stroke is found in the nested table");
+
+  [t bindKey: @"Control-d" toAction: @""];
+  pass(![t lookupKeyStroke: 'd' modifiers: NSControlKeyMask
+         returningActionIn: &action tableIn: &next],
+       "disabled binding is not found");
+
+  for (i = 0; i < 500; i++)
+    {
+      [t bindKey: [NSString stringWithFormat: @"Control-%C", (unichar)(0x400 + i)]
+        toAction: @"moveUp:"];
+    }
+  for (i = 0; i < 500; i++)
+    {
+      if (![t lookupKeyStroke: 0x400 + i modifiers: NSControlKeyMask
+            returningActionIn: &action tableIn: &next])
+        allFound = NO;
+    }
+  pass(allFound, "bindings are found after the table grows");
+  pass([t lookupKeyStroke: 'f' modifiers: NSControlKeyMask
+        returningActionIn: &action tableIn: &next],
+       "earlier bindings survive the table growing");
+
+  [t release];
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,102 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that changes made inside a controller batch, and changes to a
+binding that coalesces them, update the bound object only once.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSDate.h>
+#import <Foundation/NSDictionary.h>
+#import <Foundation/NSRunLoop.h>
+#import <Foundation/NSValue.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSController.h>
+#import <AppKit/NSKeyValueBinding.h>
+
+@interface Model : NSController
+{
+  int n;
+}
+- (int) n;
+- (void) setN: (int)value;
+@end
+
+@implementation Model
+- (int) n
+{
+  return n;
+}
+- (void) setN: (int)value
+{
+  n = value;
+}
+@end
+
+@interface Sink : NSObject
+{
+@public
+  int level;
+  int updates;
+}
+@end
+
+@implementation Sink
++ (void) initialize
+{
+  [self exposeBinding: @"level"];
+}
+- (void) setLevel: (int)value
+{
+  level = value;
+  updates++;
+}
+@end
+
+int
+main(int argc, char **argv)
+{
+  Model *model;
+  Sink *sink;
+  int i;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  model = AUTORELEASE([Model new]);
+  sink = AUTORELEASE([Sink new]);
+  [sink bind: @"level" toObject: model withKeyPath: @"n" options: nil];
+  sink->updates = 0;
+  [model setN: 1];
+  pass(sink->updates == 1 && sink->level == 1,
+       "changes outside a batch update the bound object at once");
+
+  sink->updates = 0;
+  [model beginBatchedChanges];
+  [model beginBatchedChanges];
+  for (i = 0; i < 100; i++)
+    [model setN: i];
+  [model endBatchedChanges];
+  pass(sink->updates == 0, "changes in a batch are held back");
+  [model endBatchedChanges];
+  pass(sink->updates == 1 && sink->level == 99,
+       "the bound object is updated once when the batch ends");
+  [sink unbind: @"level"];
+
+  [sink bind: @"level" toObject: model withKeyPath: @"n"
+     options: [NSDictionary dictionaryWithObject: [NSNumber numberWithBool: YES]
+                                          forKey: GSCoalescesChangesBindingOption]];
+  sink->updates = 0;
+  for (i = 0; i < 100; i++)
+    [model setN: i + 1];
+  pass(sink->updates == 0, "coalesced changes wait for the run loop");
+  [[NSRunLoop currentRunLoop] runUntilDate:
+    [NSDate dateWithTimeIntervalSinceNow: 0.1]];
+  pass(sink->updates == 1 && sink->level == 100,
+       "coalesced changes update the bound object once");
+  [sink unbind: @"level"];
+
+  DESTROY(arp);
+  return 0;
+}
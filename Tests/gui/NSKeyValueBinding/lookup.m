@@ -0,0 +1,74 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that exposed bindings include those of the superclasses, also
+when bindings are exposed after the list was first asked for, and that
+binding lookups follow binding and unbinding.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSArray.h>
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSDictionary.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSKeyValueBinding.h>
+
+@interface Base : NSObject
+{
+  id level;
+}
+@end
+
+@implementation Base
+@end
+
+@interface Derived : Base
+{
+  id title;
+}
+@end
+
+@implementation Derived
+@end
+
+int
+main(int argc, char **argv)
+{
+  Derived *a, *b;
+  NSDictionary *model;
+  NSArray *exposed;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  [Base exposeBinding: @"level"];
+  a = AUTORELEASE([Derived new]);
+  b = AUTORELEASE([Derived new]);
+  exposed = [a exposedBindings];
+  pass([exposed containsObject: @"level"],
+       "exposed bindings include those of the superclass");
+
+  [Derived exposeBinding: @"title"];
+  exposed = [a exposedBindings];
+  pass([exposed count] == 2 && [exposed containsObject: @"title"]
+       && [exposed containsObject: @"level"],
+       "bindings exposed later are listed too");
+
+  model = [NSDictionary dictionaryWithObject: @"x" forKey: @"name"];
+  pass([a infoForBinding: @"title"] == nil, "unbound binding has no info");
+  [a bind: @"title" toObject: model withKeyPath: @"name" options: nil];
+  pass([b infoForBinding: @"title"] == nil
+       && [[a infoForBinding: @"title"] objectForKey: NSObservedObjectKey]
+         == model,
+       "binding info belongs to the bound object");
+  [b bind: @"level" toObject: model withKeyPath: @"name" options: nil];
+  pass([a infoForBinding: @"level"] == nil
+       && [b infoForBinding: @"level"] != nil,
+       "lookups switch between bound objects");
+  [a unbind: @"title"];
+  pass([a infoForBinding: @"title"] == nil, "unbinding removes the info");
+  [b unbind: @"level"];
+
+  DESTROY(arp);
+  return 0;
+}
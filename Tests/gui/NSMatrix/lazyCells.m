@@ -0,0 +1,73 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that a matrix making cells lazily only makes a cell of its own for
+cells which are asked for or selected.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSActionCell.h>
+#import <AppKit/NSMatrix.h>
+
+static NSUInteger made;
+
+@interface CountingCell : NSActionCell
+@end
+
+@implementation CountingCell
+- (id) copyWithZone: (NSZone *)zone
+{
+  made++;
+  return [super copyWithZone: zone];
+}
+@end
+
+int
+main(int argc, char **argv)
+{
+  NSMatrix *m;
+  id cell;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  m = [[NSMatrix alloc] initWithFrame: NSMakeRect(0, 0, 100, 100)
+				 mode: NSRadioModeMatrix
+			    prototype: AUTORELEASE([CountingCell new])
+			 numberOfRows: 0
+		      numberOfColumns: 0];
+  [m setCreatesCellsLazily: YES];
+  made = 0;
+  [m renewRows: 300 columns: 300];
+  pass([m createsCellsLazily] && made == 0
+       && [m numberOfRows] == 300 && [m numberOfColumns] == 300,
+       "renewing a lazy matrix makes no cells");
+
+  cell = [m cellAtRow: 5 column: 7];
+  [cell setStringValue: @"x"];
+  pass(made == 1 && [m cellAtRow: 5 column: 7] == cell
+       && ![[[m cellAtRow: 5 column: 8] stringValue] isEqualToString: @"x"],
+       "a cell asked for gets an object of its own");
+
+  made = 0;
+  [m selectCellAtRow: 10 column: 10];
+  pass(made == 1 && [[m selectedCell] state] == NSOnState
+       && [[m cellAtRow: 10 column: 11] state] == NSOffState,
+       "selecting a cell gives it an object of its own");
+
+  [m setEnabled: NO];
+  pass([[m cellAtRow: 200 column: 200] isEnabled] == NO,
+       "changes to all cells apply to cells not made yet");
+
+  made = 0;
+  [m setCreatesCellsLazily: NO];
+  pass(![m createsCellsLazily] && made == 300 * 300 - 5
+       && [m cellAtRow: 299 column: 298] != [m cellAtRow: 299 column: 299],
+       "turning lazy cells off gives every cell an object of its own");
+
+  RELEASE(m);
+  DESTROY(arp);
+  return 0;
+}
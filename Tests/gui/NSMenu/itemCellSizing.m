@@ -0,0 +1,51 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that menu item cells measure their item again when its title or
+key equivalent changes, and keep their size when it doesn't.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSMenu.h>
+#import <AppKit/NSMenuItem.h>
+#import <AppKit/NSMenuItemCell.h>
+#import <AppKit/NSMenuView.h>
+
+int
+main(int argc, char **argv)
+{
+  NSMenu *menu;
+  NSMenuItem *item;
+  NSMenuItemCell *cell;
+  CGFloat width, keyWidth;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  menu = [[NSMenu alloc] initWithTitle: @"Menu"];
+  item = [menu addItemWithTitle: @"Short" action: NULL keyEquivalent: @""];
+  cell = [[menu menuRepresentation] menuItemCellForItemAtIndex: 0];
+  width = [cell titleWidth];
+  keyWidth = [cell keyEquivalentWidth];
+  pass(width > 0, "cell measures the title of its item");
+
+  [item setState: NSOnState];
+  [cell setNeedsSizing: YES];
+  pass([cell titleWidth] == width, "unchanged title keeps its width");
+
+  [item setTitle: @"A much longer title"];
+  [cell setNeedsSizing: YES];
+  pass([cell titleWidth] > width, "changed title is measured again");
+
+  [item setKeyEquivalent: @"q"];
+  [cell setNeedsSizing: YES];
+  pass([cell keyEquivalentWidth] > keyWidth,
+       "changed key equivalent is measured again");
+
+  [menu release];
+
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,85 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that key equivalents are found in submenus, and that changes to
+key equivalents and to the items of submenus are taken into account.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSEvent.h>
+#import <AppKit/NSMenu.h>
+#import <AppKit/NSMenuItem.h>
+
+@interface Target : NSObject
+{
+@public
+  int fired;
+}
+@end
+
+@implementation Target
+- (void) fire: (id)sender
+{
+  fired++;
+}
+@end
+
+static BOOL
+press(NSMenu *menu, NSString *key)
+{
+  NSEvent *e = [NSEvent keyEventWithType: NSKeyDown
+                                location: NSZeroPoint
+                           modifierFlags: NSCommandKeyMask
+                               timestamp: 0
+                            windowNumber: 0
+                                 context: nil
+                              characters: key
+             charactersIgnoringModifiers: key
+                               isARepeat: NO
+                                 keyCode: 0];
+
+  return [menu performKeyEquivalent: e];
+}
+
+int
+main(int argc, char **argv)
+{
+  NSMenu *main, *sub;
+  NSMenuItem *item;
+  Target *target;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  target = AUTORELEASE([Target new]);
+  main = AUTORELEASE([[NSMenu alloc] initWithTitle: @"Main"]);
+  sub = AUTORELEASE([[NSMenu alloc] initWithTitle: @"Edit"]);
+  item = [main addItemWithTitle: @"Edit" action: NULL keyEquivalent: @""];
+  [main setSubmenu: sub forItem: item];
+  item = [sub addItemWithTitle: @"Fire" action: @selector(fire:)
+                 keyEquivalent: @"f"];
+  [item setTarget: target];
+
+  pass(press(main, @"f") && target->fired == 1,
+       "key equivalent of a submenu item is performed");
+  pass(!press(main, @"g") && target->fired == 1,
+       "other keys are not handled");
+
+  [item setKeyEquivalent: @"g"];
+  pass(!press(main, @"f") && press(main, @"g") && target->fired == 2,
+       "changed key equivalents are used");
+
+  item = [sub addItemWithTitle: @"Fire again" action: @selector(fire:)
+                 keyEquivalent: @"h"];
+  [item setTarget: target];
+  pass(press(main, @"h") && target->fired == 3,
+       "key equivalents of added items are used");
+
+  [sub removeItem: item];
+  pass(!press(main, @"h"), "key equivalents of removed items are gone");
+
+  DESTROY(arp);
+  return 0;
+}
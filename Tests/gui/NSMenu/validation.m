@@ -0,0 +1,77 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that updating a menu validates the submenus which are not on
+screen at most once per GSMenuValidationInterval, and that the number of
+validations is counted.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSUserDefaults.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSMenu.h>
+#import <AppKit/NSMenuItem.h>
+
+@interface Validator : NSObject
+{
+@public
+  int validated;
+}
+@end
+
+@implementation Validator
+- (void) fire: (id)sender
+{
+}
+- (BOOL) validateMenuItem: (NSMenuItem *)item
+{
+  validated++;
+  return YES;
+}
+@end
+
+int
+main(int argc, char **argv)
+{
+  NSMenu *menu, *sub;
+  NSMenuItem *item;
+  Validator *v;
+  int i;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [[NSUserDefaults standardUserDefaults]
+    setDouble: 3600 forKey: @"GSMenuValidationInterval"];
+  [NSApplication sharedApplication];
+
+  v = [Validator new];
+  menu = [[NSMenu alloc] initWithTitle: @"Main"];
+  sub = [[NSMenu alloc] initWithTitle: @"Sub"];
+  for (i = 0; i < 10; i++)
+    {
+      item = [sub addItemWithTitle: @"Item" action: @selector(fire:)
+                     keyEquivalent: @""];
+      [item setTarget: v];
+    }
+  item = [menu addItemWithTitle: @"Sub" action: NULL keyEquivalent: @""];
+  [menu setSubmenu: sub forItem: item];
+
+  [menu update];
+  pass(v->validated == 10, "first update validates the submenu");
+  pass([NSMenu lastUpdateValidationCount] == 11,
+       "validations of the menu and its submenu are counted");
+
+  [menu update];
+  pass(v->validated == 10, "submenu off screen is not validated again");
+  pass([NSMenu lastUpdateValidationCount] == 1,
+       "count covers only the last update");
+
+  [sub update];
+  pass(v->validated == 20, "updating the submenu itself validates it");
+
+  [menu release];
+  [sub release];
+  [v release];
+  DESTROY(arp);
+  return 0;
+}
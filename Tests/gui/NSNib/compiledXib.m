@@ -0,0 +1,95 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that a xib decodes the same from its compiled form as from the
+XML, and that the compiled form is refused for a changed source file.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSArray.h>
+#import <Foundation/NSData.h>
+#import <Foundation/NSDate.h>
+#import <Foundation/NSDictionary.h>
+#import <Foundation/NSFileManager.h>
+#import <Foundation/NSString.h>
+#import <Foundation/NSValue.h>
+#import <AppKit/NSApplication.h>
+#import <GNUstepGUI/GSXibLoading.h>
+
+static NSString *xib =
+  @"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+  @"<archive type=\"com.apple.InterfaceBuilder3.Cocoa.XIB\" version=\"7.10\">\n"
+  @" <data>\n"
+  @"  <int key=\"IBDocument.SystemTarget\">1050</int>\n"
+  @"  <object class=\"NSMutableArray\" key=\"IBDocument.RootObjects\" id=\"1\">\n"
+  @"   <string id=\"2\">cafe</string>\n"
+  @"   <integer value=\"42\"/>\n"
+  @"   <reference ref=\"2\"/>\n"
+  @"  </object>\n"
+  @" </data>\n"
+  @"</archive>\n";
+
+int
+main(int argc, char **argv)
+{
+  NSData *data = [xib dataUsingEncoding: NSUTF8StringEncoding];
+  NSDictionary *attrs;
+  NSDictionary *changed;
+  GSXibKeyedUnarchiver *unarchiver;
+  NSData *compiled;
+  NSArray *fromXML;
+  NSArray *fromCompiled;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  attrs = [NSDictionary dictionaryWithObjectsAndKeys:
+    [NSNumber numberWithUnsignedInt: [data length]], NSFileSize,
+    [NSDate dateWithTimeIntervalSinceReferenceDate: 1000],
+    NSFileModificationDate, nil];
+  changed = [NSDictionary dictionaryWithObjectsAndKeys:
+    [NSNumber numberWithUnsignedInt: [data length]], NSFileSize,
+    [NSDate dateWithTimeIntervalSinceReferenceDate: 2000],
+    NSFileModificationDate, nil];
+
+  unarchiver = [[GSXibKeyedUnarchiver alloc] initForReadingWithData: data];
+  compiled = [unarchiver compiledDataForSourcePath: @"/tmp/test.xib"
+                                  sourceAttributes: attrs];
+  pass(compiled != nil, "xib can be compiled");
+  fromXML = [unarchiver decodeObjectForKey: @"IBDocument.RootObjects"];
+  RELEASE(unarchiver);
+
+  unarchiver = [[GSXibKeyedUnarchiver alloc]
+    initForReadingWithCompiledData: compiled
+                        sourcePath: @"/tmp/test.xib"
+                  sourceAttributes: attrs];
+  pass(unarchiver != nil, "compiled xib is accepted for its source file");
+  fromCompiled = [unarchiver decodeObjectForKey: @"IBDocument.RootObjects"];
+  pass([fromCompiled isEqual: fromXML] && [fromCompiled count] == 3
+       && [fromCompiled objectAtIndex: 0] == [fromCompiled objectAtIndex: 2],
+       "compiled xib decodes the same objects and references");
+  pass([unarchiver decodeIntForKey: @"IBDocument.SystemTarget"] == 1050,
+       "compiled xib keeps element values");
+  RELEASE(unarchiver);
+
+  unarchiver = [[GSXibKeyedUnarchiver alloc]
+    initForReadingWithCompiledData: compiled
+                        sourcePath: @"/tmp/test.xib"
+                  sourceAttributes: changed];
+  pass(unarchiver == nil, "compiled xib is refused for a modified file");
+  unarchiver = [[GSXibKeyedUnarchiver alloc]
+    initForReadingWithCompiledData: compiled
+                        sourcePath: @"/tmp/other.xib"
+                  sourceAttributes: attrs];
+  pass(unarchiver == nil, "compiled xib is refused for another file");
+  unarchiver = [[GSXibKeyedUnarchiver alloc]
+    initForReadingWithCompiledData:
+      [compiled subdataWithRange: NSMakeRange(0, [compiled length] - 3)]
+                        sourcePath: @"/tmp/test.xib"
+                  sourceAttributes: attrs];
+  pass(unarchiver == nil, "truncated compiled xib is refused");
+
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,85 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that model load profiling records the steps and classes timed by
+the loaders, keeps nested timings out of the enclosing class, and does
+nothing when the GSModelLoadProfile default is not set.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSArray.h>
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSDate.h>
+#import <Foundation/NSDictionary.h>
+#import <Foundation/NSString.h>
+#import <Foundation/NSUserDefaults.h>
+#import <Foundation/NSValue.h>
+#import <AppKit/NSApplication.h>
+#import <GNUstepGUI/GSModelLoaderFactory.h>
+
+static void
+spin(void)
+{
+  NSTimeInterval end = [NSDate timeIntervalSinceReferenceDate] + 0.05;
+
+  while ([NSDate timeIntervalSinceReferenceDate] < end)
+    ;
+}
+
+int
+main(int argc, char **argv)
+{
+  NSUserDefaults *defaults;
+  NSDictionary *report;
+  NSDictionary *classes;
+  NSTimeInterval step, outer, inner;
+  NSObject *object = AUTORELEASE([NSObject new]);
+  NSArray *array = [NSArray arrayWithObject: object];
+  id profile;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+  defaults = [NSUserDefaults standardUserDefaults];
+
+  profile = GSModelLoadProfileOpen(@"Unprofiled.nib");
+  step = GSModelLoadProfileBegin();
+  pass(step == 0.0, "nothing is timed without the default");
+  GSModelLoadProfileEndStep(step, @"read");
+  GSModelLoadProfileClose(profile);
+  pass([[GSModelLoader loadProfileReports] count] == 0,
+       "no report is made without the default");
+
+  [defaults setObject: @"YES" forKey: @"GSModelLoadProfile"];
+  profile = GSModelLoadProfileOpen(@"Test.nib");
+  step = GSModelLoadProfileBegin();
+  outer = GSModelLoadProfileBegin();
+  inner = GSModelLoadProfileBegin();
+  spin();
+  GSModelLoadProfileEnd(inner, @"decode", object);
+  GSModelLoadProfileEnd(outer, @"decode", array);
+  GSModelLoadProfileEndStep(step, @"decode");
+  GSModelLoadProfileClose(profile);
+  [defaults removeObjectForKey: @"GSModelLoadProfile"];
+
+  report = [[GSModelLoader loadProfileReports] lastObject];
+  pass([[report objectForKey: @"file"] isEqual: @"Test.nib"],
+       "report names the model file");
+  classes = [[[report objectForKey: @"steps"] objectForKey: @"decode"]
+              objectForKey: @"classes"];
+  pass([classes count] == 2,
+       "report has an entry for each class timed in a step");
+  pass([[[[report objectForKey: @"steps"] objectForKey: @"decode"]
+          objectForKey: @"time"] doubleValue] >= 0.05,
+       "step time includes the time of its objects");
+  pass([[[classes objectForKey: @"NSObject"] objectForKey: @"time"]
+          doubleValue] >= 0.05
+       && [[[classes objectForKey: @"NSObject"] objectForKey: @"count"]
+            intValue] == 1,
+       "inner object is timed and counted once");
+  pass([[[classes objectForKey: [array className]] objectForKey: @"time"]
+          doubleValue] < 0.05,
+       "outer object time leaves out nested timings");
+
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,122 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that the children of a huge node are got from the data source
+only when they are shown, and that children loaded in the background
+replace a placeholder row once they arrive.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSDate.h>
+#import <Foundation/NSRunLoop.h>
+#import <Foundation/NSString.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSOutlineView.h>
+#import <AppKit/NSTableColumn.h>
+
+/* The root has the children "0" to "9", and "0" has count children,
+   "0.0" and so on.  */
+@interface Tree : NSObject
+{
+@public
+  NSInteger count;
+  NSUInteger asked;
+}
+@end
+
+@implementation Tree
+- (NSInteger) outlineView: (NSOutlineView *)ov
+   numberOfChildrenOfItem: (id)item
+{
+  if (item == nil)
+    return 10;
+  return [item isEqual: @"0"] ? count : 0;
+}
+
+- (id) outlineView: (NSOutlineView *)ov child: (NSInteger)index ofItem: (id)item
+{
+  asked++;
+  if (item == nil)
+    return [NSString stringWithFormat: @"%ld", (long)index];
+  return [NSString stringWithFormat: @"%@.%ld", item, (long)index];
+}
+
+- (BOOL) outlineView: (NSOutlineView *)ov isItemExpandable: (id)item
+{
+  return [item isEqual: @"0"];
+}
+
+- (id) outlineView: (NSOutlineView *)ov
+objectValueForTableColumn: (NSTableColumn *)column
+            byItem: (id)item
+{
+  return item;
+}
+@end
+
+static NSOutlineView *
+makeOutlineView(Tree *tree)
+{
+  NSOutlineView *ov;
+  NSTableColumn *column;
+
+  ov = [[NSOutlineView alloc] initWithFrame: NSMakeRect(0, 0, 200, 200)];
+  column = AUTORELEASE([[NSTableColumn alloc] initWithIdentifier: @"a"]);
+  [ov addTableColumn: column];
+  [ov setOutlineTableColumn: column];
+  [ov setDataSource: tree];
+  return AUTORELEASE(ov);
+}
+
+int
+main(int argc, char **argv)
+{
+  NSOutlineView *ov;
+  NSDate *limit;
+  Tree *tree;
+  id item;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  tree = AUTORELEASE([Tree new]);
+  tree->count = 100000;
+  ov = makeOutlineView(tree);
+  [ov setLazyChildrenThreshold: 1000];
+  tree->asked = 0;
+  [ov expandItem: @"0"];
+  pass([ov numberOfRows] == 100010 && tree->asked == 0,
+       "expanding a huge node doesn't get its children");
+  item = [ov itemAtRow: 500];
+  pass([item isEqual: @"0.499"] && tree->asked == 1
+       && [ov rowForItem: item] == 500 && [ov levelForRow: 500] == 1,
+       "a shown child is got when its row is asked for");
+  pass([ov itemAtRow: 500] == item && tree->asked == 1,
+       "a child is got once");
+
+  tree->count = 300;
+  ov = makeOutlineView(tree);
+  [ov setLoadsChildrenInBackground: YES];
+  [ov expandItem: @"0"];
+  item = [ov itemAtRow: 1];
+  pass([ov numberOfRows] == 11 && item != nil
+       && [ov isExpandable: item] == NO && [ov levelForRow: 1] == 1,
+       "a placeholder row is shown while children load");
+
+  limit = [NSDate dateWithTimeIntervalSinceNow: 10];
+  while ([ov numberOfRows] != 310 && [limit timeIntervalSinceNow] > 0)
+    {
+      [[NSRunLoop currentRunLoop]
+	runMode: NSDefaultRunLoopMode
+	beforeDate: [NSDate dateWithTimeIntervalSinceNow: 0.01]];
+    }
+  pass([ov numberOfRows] == 310
+       && [[ov itemAtRow: 1] isEqual: @"0.0"]
+       && [[ov itemAtRow: 300] isEqual: @"0.299"]
+       && [ov rowForItem: @"1"] == 301,
+       "loaded children replace the placeholder row");
+
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,126 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that the rows of an outline view and the row of each item stay
+right while items are expanded, collapsed and reloaded.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSString.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSOutlineView.h>
+#import <AppKit/NSTableColumn.h>
+
+/* Items are strings.  The root has the children "0" to "9", and an item
+   with fewer than three dots has the children "<item>.0" to "<item>.2".
+   */
+@interface Tree : NSObject
+@end
+
+@implementation Tree
+- (NSInteger) outlineView: (NSOutlineView *)ov
+   numberOfChildrenOfItem: (id)item
+{
+  if (item == nil)
+    return 10;
+  return ([[item componentsSeparatedByString: @"."] count] < 3) ? 3 : 0;
+}
+
+- (id) outlineView: (NSOutlineView *)ov child: (NSInteger)index ofItem: (id)item
+{
+  if (item == nil)
+    return [NSString stringWithFormat: @"%ld", (long)index];
+  return [NSString stringWithFormat: @"%@.%ld", item, (long)index];
+}
+
+- (BOOL) outlineView: (NSOutlineView *)ov isItemExpandable: (id)item
+{
+  return ([[item componentsSeparatedByString: @"."] count] < 3);
+}
+
+- (id) outlineView: (NSOutlineView *)ov
+objectValueForTableColumn: (NSTableColumn *)column
+            byItem: (id)item
+{
+  return item;
+}
+@end
+
+/* YES if every row holds the item -rowForItem: gives for it.  */
+static BOOL
+consistent(NSOutlineView *ov)
+{
+  NSInteger row;
+
+  for (row = [ov numberOfRows] - 1; row >= 0; row--)
+    {
+      if ([ov rowForItem: [ov itemAtRow: row]] != row)
+        return NO;
+    }
+  return YES;
+}
+
+int
+main(int argc, char **argv)
+{
+  NSOutlineView *ov;
+  NSTableColumn *column;
+  Tree *tree;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  tree = [Tree new];
+  ov = [[NSOutlineView alloc] initWithFrame: NSMakeRect(0, 0, 200, 200)];
+  column = AUTORELEASE([[NSTableColumn alloc] initWithIdentifier: @"a"]);
+  [ov addTableColumn: column];
+  [ov setOutlineTableColumn: column];
+  [ov setDataSource: tree];
+
+  pass([ov numberOfRows] == 10 && [ov rowForItem: @"9"] == 9,
+       "the top level items are shown");
+
+  [ov expandItem: @"5"];
+  pass([ov numberOfRows] == 13 && [ov rowForItem: @"5.0"] == 6
+       && [ov rowForItem: @"9"] == 12 && consistent(ov),
+       "expanding an item inserts its children after it");
+
+  [ov expandItem: @"2" expandChildren: YES];
+  pass([ov numberOfRows] == 25 && [ov rowForItem: @"2.1.2"] == 10
+       && [ov rowForItem: @"5.0"] == 18 && consistent(ov),
+       "expanding an item and its children inserts all of them");
+
+  [ov collapseItem: @"2"];
+  pass([ov numberOfRows] == 13 && [ov rowForItem: @"2.1"] == -1
+       && [ov rowForItem: @"5.2"] == 8 && consistent(ov),
+       "collapsing an item removes the rows under it");
+
+  [ov expandItem: @"2"];
+  pass([ov numberOfRows] == 25 && [ov rowForItem: @"2.2.0"] == 12
+       && consistent(ov),
+       "expanded children are shown again with their parent");
+
+  [ov collapseItem: @"2" collapseChildren: YES];
+  [ov collapseItem: @"5"];
+  [ov expandItem: @"2.1"];
+  pass([ov numberOfRows] == 10 && [ov rowForItem: @"2.1.0"] == -1
+       && consistent(ov),
+       "expanding a hidden item shows no rows");
+
+  [ov expandItem: @"2"];
+  pass([ov numberOfRows] == 16 && [ov rowForItem: @"2.1.0"] == 5
+       && consistent(ov),
+       "the children of an item expanded while hidden are shown later");
+
+  [ov reloadItem: @"5" reloadChildren: YES];
+  [ov expandItem: @"5"];
+  pass([ov numberOfRows] == 19 && [ov rowForItem: @"5.1"] == 13
+       && consistent(ov),
+       "a reloaded item can be expanded");
+
+  [ov release];
+  [tree release];
+  DESTROY(arp);
+  return 0;
+}
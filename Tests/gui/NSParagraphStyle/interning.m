@@ -0,0 +1,66 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that immutable copies of equal paragraph styles are the same
+object, and that styles which differ stay apart.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSParagraphStyle.h>
+
+static NSMutableParagraphStyle *
+makeStyle(void)
+{
+  NSMutableParagraphStyle *style;
+
+  style = AUTORELEASE([[NSParagraphStyle defaultParagraphStyle] mutableCopy]);
+  [style setAlignment: NSCenterTextAlignment];
+  [style setHeadIndent: 12.0];
+  [style addTabStop: AUTORELEASE([[NSTextTab alloc]
+    initWithType: NSRightTabStopType location: 400.0])];
+  return style;
+}
+
+int
+main(int argc, char **argv)
+{
+  NSMutableParagraphStyle *style;
+  NSParagraphStyle *a;
+  NSParagraphStyle *b;
+  NSParagraphStyle *c;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  a = AUTORELEASE([makeStyle() copy]);
+  b = AUTORELEASE([makeStyle() copy]);
+  pass(a == b, "copies of equal styles are the same object");
+  style = AUTORELEASE([a mutableCopy]);
+  pass(AUTORELEASE([style copy]) == a,
+       "a mutable copy of a style copies back to the same style");
+  pass([a copy] == a && [a retainCount] > 1, "copying a style retains it");
+  RELEASE(a);
+
+  style = makeStyle();
+  [style setBaseWritingDirection: NSWritingDirectionRightToLeft];
+  c = AUTORELEASE([style copy]);
+  pass(c != a && [c isEqual: a] == NO,
+       "styles with different writing directions stay apart");
+
+  style = makeStyle();
+  [style setHeadIndent: 13.0];
+  c = AUTORELEASE([style copy]);
+  pass(c != a && [c hash] != 0 && [c isEqual: a] == NO,
+       "styles with different indents stay apart");
+  pass([makeStyle() isEqual: a] && [makeStyle() hash] == [a hash],
+       "a mutable style is equal to its interned copy and hashes alike");
+
+  DESTROY(arp);
+
+  arp = [NSAutoreleasePool new];
+  a = [makeStyle() copy];
+  pass([a alignment] == NSCenterTextAlignment && [a headIndent] == 12.0,
+       "a style can be interned again once all copies are gone");
+  RELEASE(a);
+  DESTROY(arp);
+  return 0;
+}
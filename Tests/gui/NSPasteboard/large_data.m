@@ -0,0 +1,73 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that large data written to a pasteboard reads back unchanged,
+also through streams, and that declaring new types doesn't disturb data
+already read.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSArray.h>
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSData.h>
+#import <Foundation/NSStream.h>
+#import <Foundation/NSString.h>
+#import <AppKit/NSPasteboard.h>
+
+#define SIZE (8 * 1024 * 1024 + 13)
+
+int
+main(int argc, char **argv)
+{
+  NSPasteboard *pb;
+  NSMutableData *data;
+  NSMutableData *streamed;
+  NSInputStream *stream;
+  NSData *d;
+  uint8_t buffer[4096];
+  NSInteger n;
+  unsigned char *p;
+  NSUInteger i;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  data = [NSMutableData dataWithLength: SIZE];
+  p = [data mutableBytes];
+  for (i = 0; i < SIZE; i++)
+    p[i] = (unsigned char)(i * 7);
+
+  pb = [NSPasteboard pasteboardWithName: @"large data test"];
+  [pb declareTypes: [NSArray arrayWithObject: NSTIFFPboardType] owner: nil];
+  pass([pb setData: data forType: NSTIFFPboardType],
+       "large data can be written to a pasteboard");
+  d = [pb dataForType: NSTIFFPboardType];
+  pass([d isEqual: data], "large data reads back unchanged");
+
+  stream = [pb inputStreamForType: NSTIFFPboardType];
+  streamed = [NSMutableData data];
+  [stream open];
+  while ((n = [stream read: buffer maxLength: sizeof(buffer)]) > 0)
+    [streamed appendBytes: buffer length: n];
+  [stream close];
+  pass([streamed isEqual: data], "large data can be read as a stream");
+
+  [pb declareTypes: [NSArray arrayWithObject: NSTIFFPboardType] owner: nil];
+  pass([pb setDataFromStream: [NSInputStream inputStreamWithData: data]
+                     forType: NSTIFFPboardType],
+       "large data can be written from a stream");
+  pass([[pb dataForType: NSTIFFPboardType] isEqual: data],
+       "data written from a stream reads back unchanged");
+
+  [pb declareTypes: [NSArray arrayWithObject: NSStringPboardType] owner: nil];
+  pass([d isEqual: data], "mapped data survives new types being declared");
+  [pb setString: @"small" forType: NSStringPboardType];
+  pass([[pb stringForType: NSStringPboardType] isEqual: @"small"],
+       "small data still goes to the server");
+  stream = [NSInputStream inputStreamWithData:
+    [@"tiny" dataUsingEncoding: NSASCIIStringEncoding]];
+  pass([pb setDataFromStream: stream forType: NSStringPboardType]
+       && [[pb stringForType: NSStringPboardType] isEqual: @"tiny"],
+       "small data can be written from a stream");
+
+  DESTROY(arp);
+  return 0;
+}
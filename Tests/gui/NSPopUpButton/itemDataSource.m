@@ -0,0 +1,90 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that a pop up button cell with an item data source holds only
+part of a long list in its menu, and that selection by index works
+across the whole list.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSString.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSMenu.h>
+#import <AppKit/NSMenuItem.h>
+#import <AppKit/NSPopUpButtonCell.h>
+
+@interface Zones : NSObject
+@end
+
+@implementation Zones
+- (NSInteger) numberOfItemsInPopUpButtonCell: (NSPopUpButtonCell *)cell
+{
+  return 10000;
+}
+- (NSString *) popUpButtonCell: (NSPopUpButtonCell *)cell
+            titleOfItemAtIndex: (NSInteger)index
+{
+  return [NSString stringWithFormat: @"Zone %ld", (long)index];
+}
+@end
+
+static NSMenuItem *
+moreItem(NSMenu *menu, BOOL following)
+{
+  NSInteger i = following ? [menu numberOfItems] - 1 : 0;
+  NSMenuItem *item = [menu itemAtIndex: i];
+
+  return sel_isEqual([item action], @selector(_showMoreItems:)) ? item : nil;
+}
+
+int
+main(int argc, char **argv)
+{
+  NSPopUpButtonCell *cell;
+  Zones *zones;
+  NSMenuItem *more;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  zones = [Zones new];
+  cell = [[NSPopUpButtonCell alloc] initTextCell: @"" pullsDown: NO];
+  [cell setItemDataSource: zones];
+
+  pass([cell numberOfItems] == 10000, "all items of the data source count");
+  pass([[cell menu] numberOfItems] < 100, "menu holds only some of them");
+  pass([cell indexOfSelectedItem] == 0
+       && [[cell titleOfSelectedItem] isEqual: @"Zone 0"],
+       "first item is selected");
+  pass(moreItem([cell menu], NO) == nil && moreItem([cell menu], YES) != nil,
+       "menu ends with an item to show following items");
+
+  [cell selectItemAtIndex: 5000];
+  pass([cell indexOfSelectedItem] == 5000
+       && [[cell titleOfSelectedItem] isEqual: @"Zone 5000"],
+       "item far down the list can be selected by index");
+  pass([[[cell selectedItem] title] isEqual: @"Zone 5000"]
+       && [[cell menu] indexOfItem: [cell selectedItem]] >= 0,
+       "menu holds the selected item");
+  pass([[cell itemTitleAtIndex: 9999] isEqual: @"Zone 9999"],
+       "titles come from the data source");
+  pass([cell itemAtIndex: 9999] == nil,
+       "items not held by the menu are nil");
+
+  more = moreItem([cell menu], YES);
+  [cell performSelector: @selector(_showMoreItems:) withObject: more];
+  pass([[cell itemAtIndex: 5050] title] != nil,
+       "following items are shown");
+  pass([cell indexOfSelectedItem] == 5000
+       && [[cell titleOfSelectedItem] isEqual: @"Zone 5000"],
+       "selection is kept when it is not shown");
+
+  [cell setItemDataSource: nil];
+  pass([cell numberOfItems] == 0, "removing the data source empties the menu");
+
+  [cell release];
+  [zones release];
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,84 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that a ruler only draws the strip which comes into sight when its
+client scrolls along it, and nothing when the client scrolls across it.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSClipView.h>
+#import <AppKit/NSRulerView.h>
+#import <AppKit/NSScrollView.h>
+#import <AppKit/NSView.h>
+#import <AppKit/NSWindow.h>
+
+static NSRect drawn;
+
+@interface RecordingRuler : NSRulerView
+@end
+
+@implementation RecordingRuler
+- (void) drawRect: (NSRect)rect
+{
+  drawn = NSUnionRect(drawn, rect);
+  [super drawRect: rect];
+}
+@end
+
+int
+main(int argc, char **argv)
+{
+  NSWindow *window;
+  NSScrollView *sv;
+  NSView *doc;
+  NSRulerView *ruler;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+  [NSScrollView setRulerViewClass: [RecordingRuler class]];
+
+  window = [[NSWindow alloc] initWithContentRect: NSMakeRect(100, 100, 300, 300)
+				       styleMask: NSBorderlessWindowMask
+					 backing: NSBackingStoreBuffered
+					   defer: NO];
+  sv = [[NSScrollView alloc] initWithFrame: NSMakeRect(0, 0, 300, 300)];
+  doc = [[NSView alloc] initWithFrame: NSMakeRect(0, 0, 1000, 1000)];
+  [sv setDocumentView: doc];
+  [sv setHasHorizontalRuler: YES];
+  [sv setHasVerticalRuler: NO];
+  [sv setRulersVisible: YES];
+  [[window contentView] addSubview: sv];
+  [window orderFront: nil];
+  [window display];
+
+  ruler = [sv horizontalRulerView];
+  pass([ruler isKindOfClass: [RecordingRuler class]], "the ruler class is used");
+
+  drawn = NSZeroRect;
+  [[sv contentView] scrollToPoint: NSMakePoint(10, 0)];
+  [window displayIfNeeded];
+  testHopeful = YES;
+  pass(NSIsEmptyRect(drawn) == NO && NSWidth(drawn) <= 10,
+       "scrolling along the ruler draws only the strip coming into sight");
+  testHopeful = NO;
+
+  drawn = NSZeroRect;
+  [[sv contentView] scrollToPoint: NSMakePoint(10, 20)];
+  [window displayIfNeeded];
+  pass(NSIsEmptyRect(drawn),
+       "scrolling across the ruler draws nothing");
+
+  drawn = NSZeroRect;
+  [ruler setOriginOffset: 5];
+  [window displayIfNeeded];
+  pass(NSEqualRects(drawn, [ruler visibleRect]),
+       "changing the hash marks draws all of the ruler");
+
+  RELEASE(doc);
+  RELEASE(sv);
+  RELEASE(window);
+  DESTROY(arp);
+  return 0;
+}
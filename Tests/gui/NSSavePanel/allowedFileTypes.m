@@ -0,0 +1,68 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that the browser of NSSavePanel only shows files with one of the
+allowed file types, whatever the case of their extension.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSArray.h>
+#import <Foundation/NSData.h>
+#import <Foundation/NSFileManager.h>
+#import <Foundation/NSPathUtilities.h>
+#import <Foundation/NSProcessInfo.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSBrowser.h>
+#import <AppKit/NSCell.h>
+#import <AppKit/NSMatrix.h>
+#import <AppKit/NSSavePanel.h>
+
+@implementation NSSavePanel (TestAllowedFileTypes)
+
+- (NSMatrix *)lastColumnMatrix
+{
+  return [_browser matrixInColumn: [_browser lastColumn]];
+}
+
+@end
+
+int
+main(int argc, char **argv)
+{
+  NSFileManager *mgr = [NSFileManager defaultManager];
+  NSArray *names = [NSArray arrayWithObjects: @"a.TXT", @"b.txt", @"c.rtf", nil];
+  NSString *dir;
+  NSSavePanel *p;
+  NSMatrix *m;
+  NSUInteger i;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+  dir = [NSTemporaryDirectory() stringByAppendingPathComponent:
+    [[NSProcessInfo processInfo] globallyUniqueString]];
+  [mgr createDirectoryAtPath: dir attributes: nil];
+  for (i = 0; i < [names count]; i++)
+    {
+      [[NSData data] writeToFile:
+	[dir stringByAppendingPathComponent: [names objectAtIndex: i]]
+		      atomically: NO];
+    }
+
+  p = [NSSavePanel savePanel];
+  [p setAllowedFileTypes: [NSArray arrayWithObject: @"txt"]];
+  [p setDirectory: dir];
+  m = [p lastColumnMatrix];
+  pass([m numberOfRows] == 2
+       && [[[m cellAtRow: 0 column: 0] stringValue] isEqual: @"a.TXT"]
+       && [[[m cellAtRow: 1 column: 0] stringValue] isEqual: @"b.txt"],
+       "only files of the allowed types are shown, ignoring case");
+
+  [p setAllowedFileTypes: nil];
+  m = [p lastColumnMatrix];
+  pass([m numberOfRows] == 3, "all files are shown without allowed types");
+
+  [mgr removeFileAtPath: dir handler: nil];
+  DESTROY(arp);
+  return 0;
+}
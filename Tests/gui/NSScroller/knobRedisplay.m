@@ -0,0 +1,71 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that moving the knob of a scroller only draws the old and new
+places of the knob again, not the whole slot.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSScroller.h>
+#import <AppKit/NSView.h>
+#import <AppKit/NSWindow.h>
+
+@interface RecordingScroller : NSScroller
+{
+@public
+  NSRect drawn;
+}
+@end
+
+@implementation RecordingScroller
+- (void) drawRect: (NSRect)rect
+{
+  drawn = NSUnionRect(drawn, rect);
+  [super drawRect: rect];
+}
+@end
+
+int
+main(int argc, char **argv)
+{
+  NSWindow *window;
+  RecordingScroller *scroller;
+  NSRect oldKnob, newKnob, slot;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  window = [[NSWindow alloc] initWithContentRect: NSMakeRect(100, 100, 100, 300)
+				       styleMask: NSBorderlessWindowMask
+					 backing: NSBackingStoreBuffered
+					   defer: NO];
+  scroller = [[RecordingScroller alloc] initWithFrame:
+    NSMakeRect(0, 0, [NSScroller scrollerWidth], 300)];
+  [[window contentView] addSubview: scroller];
+  [scroller setEnabled: YES];
+  [scroller setFloatValue: 0.0 knobProportion: 0.1];
+  [window orderFront: nil];
+  [window display];
+
+  slot = [scroller rectForPart: NSScrollerKnobSlot];
+  oldKnob = [scroller rectForPart: NSScrollerKnob];
+  scroller->drawn = NSZeroRect;
+  [scroller setDoubleValue: 0.5];
+  newKnob = [scroller rectForPart: NSScrollerKnob];
+  pass(NSEqualRects(oldKnob, newKnob) == NO, "the knob moves");
+  [window displayIfNeeded];
+  testHopeful = YES;
+  pass(NSIsEmptyRect(scroller->drawn) == NO
+       && NSContainsRect(NSInsetRect(NSUnionRect(oldKnob, newKnob), -1, -1),
+			 scroller->drawn)
+       && NSHeight(scroller->drawn) < NSHeight(slot),
+       "only the places of the knob are drawn again");
+  testHopeful = NO;
+
+  RELEASE(scroller);
+  RELEASE(window);
+  DESTROY(arp);
+  return 0;
+}
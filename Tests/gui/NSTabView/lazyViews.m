@@ -0,0 +1,86 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that a tab view asks its delegate for the view of an item without
+one when the item is first selected, and that the views of unselected
+items can be unloaded and are created again when needed.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSTabView.h>
+#import <AppKit/NSTabViewItem.h>
+
+@interface Provider : NSObject
+{
+@public
+  int created;
+  BOOL keep;
+}
+@end
+
+@implementation Provider
+- (NSView *) tabView: (NSTabView *)tabView
+  viewForTabViewItem: (NSTabViewItem *)item
+{
+  created++;
+  return AUTORELEASE([NSView new]);
+}
+
+- (BOOL) tabView: (NSTabView *)tabView
+shouldUnloadViewOfTabViewItem: (NSTabViewItem *)item
+{
+  return !keep;
+}
+@end
+
+int
+main(int argc, char **argv)
+{
+  NSTabView *tv;
+  NSTabViewItem *first, *second;
+  Provider *provider;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  tv = [[NSTabView alloc] initWithFrame: NSMakeRect(0, 0, 200, 200)];
+  provider = [Provider new];
+  [tv setDelegate: provider];
+  first = AUTORELEASE([[NSTabViewItem alloc] initWithIdentifier: @"1"]);
+  second = AUTORELEASE([[NSTabViewItem alloc] initWithIdentifier: @"2"]);
+  [first setView: nil];
+  [second setView: nil];
+  [tv addTabViewItem: first];
+  [tv addTabViewItem: second];
+
+  pass(provider->created == 1 && [first isViewLoaded]
+       && ![second isViewLoaded],
+       "only the view of the selected item is created");
+  pass([[first view] superview] == tv, "the created view is shown");
+
+  [tv selectTabViewItem: second];
+  pass(provider->created == 2 && [second isViewLoaded],
+       "the view of an item is created when it is first selected");
+  [tv selectTabViewItem: first];
+  pass(provider->created == 2, "a created view is kept");
+
+  provider->keep = YES;
+  [tv unloadUnselectedTabViews];
+  pass([second isViewLoaded], "the delegate can keep a view");
+
+  provider->keep = NO;
+  [tv unloadUnselectedTabViews];
+  pass(![second isViewLoaded] && [first isViewLoaded],
+       "the views of unselected items are unloaded");
+  [tv selectTabViewItem: second];
+  pass(provider->created == 3 && [second isViewLoaded],
+       "an unloaded view is created again when selected");
+
+  [tv setDelegate: nil];
+  RELEASE(provider);
+  RELEASE(tv);
+  DESTROY(arp);
+  return 0;
+}
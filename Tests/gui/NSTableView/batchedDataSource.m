@@ -0,0 +1,119 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that a table view gets the values of the visible rows with one
+message from a data source that can give several at once, and tells it
+about the rows around the visible ones.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSArray.h>
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSNull.h>
+#import <Foundation/NSValue.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSTableColumn.h>
+#import <AppKit/NSTableView.h>
+#import <AppKit/NSWindow.h>
+
+@interface NSTableView (Private)
+- (id) _cachedObjectValueAtColumn: (NSInteger)columnIndex
+                              row: (NSInteger)rowIndex;
+- (void) _prefetchRowsAroundVisibleRows;
+@end
+
+@interface Batches : NSObject
+{
+@public
+  NSUInteger single;
+  NSUInteger batches;
+  NSRange lastBatch;
+  NSUInteger prefetches;
+}
+@end
+
+@implementation Batches
+- (NSInteger) numberOfRowsInTableView: (NSTableView *)tv
+{
+  return 1000;
+}
+
+- (id) tableView: (NSTableView *)tv
+objectValueForTableColumn: (NSTableColumn *)column
+             row: (NSInteger)row
+{
+  single++;
+  return [NSNumber numberWithInteger: row];
+}
+
+- (NSArray *) tableView: (NSTableView *)tv
+objectValuesForTableColumns: (NSArray *)columns
+                   rows: (NSRange)rows
+{
+  NSMutableArray *a = [NSMutableArray array];
+  NSUInteger row, i;
+
+  batches++;
+  lastBatch = rows;
+  for (row = rows.location; row < NSMaxRange(rows); row++)
+    for (i = 0; i < [columns count]; i++)
+      [a addObject: (i == 0) ? (id)[NSNumber numberWithInteger: row]
+                             : (id)[NSNull null]];
+  return a;
+}
+
+- (void) tableView: (NSTableView *)tv prefetchRows: (NSRange)rows
+{
+  prefetches++;
+}
+@end
+
+int
+main(int argc, char **argv)
+{
+  NSWindow *window;
+  NSTableView *tv;
+  Batches *ds;
+  id value;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  ds = [Batches new];
+  tv = [[NSTableView alloc] initWithFrame: NSMakeRect(0, 0, 200, 200)];
+  [tv addTableColumn: AUTORELEASE([[NSTableColumn alloc]
+                                    initWithIdentifier: @"a"])];
+  [tv addTableColumn: AUTORELEASE([[NSTableColumn alloc]
+                                    initWithIdentifier: @"b"])];
+  [tv setDataSource: ds];
+  window = [[NSWindow alloc] initWithContentRect: NSMakeRect(100, 100, 200, 200)
+				       styleMask: NSBorderlessWindowMask
+					 backing: NSBackingStoreBuffered
+					   defer: NO];
+  [[window contentView] addSubview: tv];
+
+  value = [tv _cachedObjectValueAtColumn: 0 row: 2];
+  pass(ds->batches == 1 && ds->single == 0 && [value integerValue] == 2,
+       "a value comes from a batch");
+  pass(ds->lastBatch.location == 0 && ds->lastBatch.length > 2,
+       "the batch covers the visible rows");
+  pass([tv _cachedObjectValueAtColumn: 1 row: 3] == nil
+       && ds->batches == 1,
+       "other visible cells come from the same batch");
+
+  value = [tv _cachedObjectValueAtColumn: 0 row: 900];
+  pass(ds->batches == 2 && ds->lastBatch.location == 900
+       && [value integerValue] == 900,
+       "a row that is not visible is got by itself");
+
+  [tv _prefetchRowsAroundVisibleRows];
+  pass(ds->prefetches == 1, "the data source is told what to prefetch");
+  [tv _prefetchRowsAroundVisibleRows];
+  pass(ds->prefetches == 1, "it is told again only after scrolling");
+
+  [tv release];
+  [window release];
+  [ds release];
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,77 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that the column at a point and the column rects stay right when a
+column of a wide table is resized or moved.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSIndexSet.h>
+#import <Foundation/NSString.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSTableColumn.h>
+#import <AppKit/NSTableView.h>
+
+@interface NSTableView (Private)
+- (void) _userResizedTableColumn: (NSInteger)index
+                           width: (CGFloat)width;
+@end
+
+int
+main(int argc, char **argv)
+{
+  NSTableView *tv;
+  NSTableColumn *column;
+  NSInteger i;
+  BOOL ok = YES;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  tv = [[NSTableView alloc] initWithFrame: NSMakeRect(0, 0, 200, 200)];
+  for (i = 0; i < 300; i++)
+    {
+      column = [[NSTableColumn alloc] initWithIdentifier:
+        [NSString stringWithFormat: @"%ld", (long)i]];
+      [column setMinWidth: 1];
+      [column setWidth: 10];
+      [tv addTableColumn: column];
+      [column release];
+    }
+
+  for (i = 0; i < 300; i++)
+    {
+      if ([tv columnAtPoint: NSMakePoint(i * 10, 0)] != i
+          || [tv columnAtPoint: NSMakePoint(i * 10 + 9.5, 0)] != i)
+        ok = NO;
+    }
+  pass(ok, "the column at a point is found in a wide table");
+  pass([tv columnAtPoint: NSMakePoint(-1, 0)] == -1,
+       "there is no column left of the table");
+  pass(NSEqualRanges([tv columnsInRect: NSMakeRect(25, 0, 20, 10)],
+                     NSMakeRange(2, 3)),
+       "columns in a rect are found");
+
+  [tv _userResizedTableColumn: 100 width: 30];
+  pass(NSMinX([tv rectOfColumn: 100]) == 1000
+       && NSMinX([tv rectOfColumn: 101]) == 1030
+       && NSMinX([tv rectOfColumn: 299]) == 3010,
+       "columns after a resized column move");
+  pass(NSWidth([tv frame]) == 3020, "the table gets wider");
+  pass([tv columnAtPoint: NSMakePoint(1025, 0)] == 100,
+       "the resized column is found at its new width");
+
+  column = [[tv tableColumns] objectAtIndex: 100];
+  [tv moveColumn: 100 toColumn: 200];
+  pass([[tv tableColumns] objectAtIndex: 200] == column
+       && NSMinX([tv rectOfColumn: 100]) == 1000
+       && NSMinX([tv rectOfColumn: 200]) == 2000
+       && NSWidth([tv rectOfColumn: 200]) == 30
+       && NSMinX([tv rectOfColumn: 201]) == 2030,
+       "columns between a moved column's old and new place move");
+
+  [tv release];
+  DESTROY(arp);
+  return 0;
+}
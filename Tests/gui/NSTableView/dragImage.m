@@ -0,0 +1,78 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that the drag image for many rows shows only a few of them, so
+making it asks the data source for a bounded number of values.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSIndexSet.h>
+#import <Foundation/NSValue.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSImage.h>
+#import <AppKit/NSTableColumn.h>
+#import <AppKit/NSTableView.h>
+
+@interface Rows : NSObject
+{
+@public
+  NSUInteger asked;
+}
+@end
+
+@implementation Rows
+- (NSInteger) numberOfRowsInTableView: (NSTableView *)tv
+{
+  return 100000;
+}
+
+- (id) tableView: (NSTableView *)tv
+objectValueForTableColumn: (NSTableColumn *)column
+             row: (NSInteger)row
+{
+  asked++;
+  return [NSNumber numberWithInteger: row];
+}
+@end
+
+int
+main(int argc, char **argv)
+{
+  NSTableView *tv;
+  Rows *ds;
+  NSImage *image;
+  NSPoint offset;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  ds = AUTORELEASE([Rows new]);
+  tv = AUTORELEASE([[NSTableView alloc]
+                     initWithFrame: NSMakeRect(0, 0, 200, 200)]);
+  [tv addTableColumn: AUTORELEASE([[NSTableColumn alloc]
+                                    initWithIdentifier: @"a"])];
+  [tv setDataSource: ds];
+  [tv selectAll: nil];
+
+  ds->asked = 0;
+  image = [tv dragImageForRowsWithIndexes: [tv selectedRowIndexes]
+                             tableColumns: nil
+                                    event: nil
+                                   offset: &offset];
+  pass(image != nil && [image size].width > 0
+       && [image size].height <= 8 * ([tv rowHeight] + [tv intercellSpacing].height)
+       && [image size].height > 0,
+       "drag image of many rows shows only a few of them");
+  pass(ds->asked < 100, "drag image draws a bounded number of rows");
+
+  image = [tv dragImageForRowsWithIndexes: [NSIndexSet indexSetWithIndex: 3]
+                             tableColumns: nil
+                                    event: nil
+                                   offset: &offset];
+  pass(image != nil && [image size].height > 0,
+       "drag image of one row is made");
+
+  DESTROY(arp);
+  return 0;
+}
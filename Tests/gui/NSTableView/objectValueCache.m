@@ -0,0 +1,84 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that a table view caching object values asks the data source once
+per cell, and again after the data is reloaded.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSIndexSet.h>
+#import <Foundation/NSValue.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSTableColumn.h>
+#import <AppKit/NSTableView.h>
+
+@interface NSTableView (Private)
+- (id) _cachedObjectValueAtColumn: (NSInteger)columnIndex
+                              row: (NSInteger)rowIndex;
+@end
+
+@interface Values : NSObject
+{
+@public
+  NSUInteger asked;
+}
+@end
+
+@implementation Values
+- (NSInteger) numberOfRowsInTableView: (NSTableView *)tv
+{
+  return 10;
+}
+
+- (id) tableView: (NSTableView *)tv
+objectValueForTableColumn: (NSTableColumn *)column
+             row: (NSInteger)row
+{
+  asked++;
+  return [NSNumber numberWithInteger: row];
+}
+@end
+
+int
+main(int argc, char **argv)
+{
+  NSTableView *tv;
+  Values *values;
+  id value;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  values = [Values new];
+  tv = [[NSTableView alloc] initWithFrame: NSMakeRect(0, 0, 200, 200)];
+  [tv addTableColumn: AUTORELEASE([[NSTableColumn alloc]
+                                    initWithIdentifier: @"a"])];
+  [tv setDataSource: values];
+
+  [tv _cachedObjectValueAtColumn: 0 row: 3];
+  [tv _cachedObjectValueAtColumn: 0 row: 3];
+  pass(values->asked == 2 && [tv cachesObjectValues] == NO,
+       "values are not cached by default");
+
+  [tv setCachesObjectValues: YES];
+  values->asked = 0;
+  value = [tv _cachedObjectValueAtColumn: 0 row: 3];
+  [tv _cachedObjectValueAtColumn: 0 row: 3];
+  pass(values->asked == 1 && [value integerValue] == 3,
+       "a cached value is asked for once");
+
+  [tv reloadDataForRowIndexes: [NSIndexSet indexSetWithIndex: 3]
+                columnIndexes: [NSIndexSet indexSetWithIndex: 0]];
+  [tv _cachedObjectValueAtColumn: 0 row: 3];
+  pass(values->asked == 2, "reloading a cell asks for its value again");
+
+  [tv reloadData];
+  [tv _cachedObjectValueAtColumn: 0 row: 3];
+  pass(values->asked == 3, "reloading the data asks for values again");
+
+  [tv release];
+  [values release];
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,95 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that a table view whose delegate gives rows heights of their own
+places the rows one after another, finds the rows at points and in
+rects, and moves rows when the height of a row above them changes.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSIndexSet.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSTableColumn.h>
+#import <AppKit/NSTableView.h>
+
+#define ROWS 100000
+
+@interface Rows : NSObject
+{
+@public
+  CGFloat extra;
+}
+@end
+
+@implementation Rows
+- (NSInteger) numberOfRowsInTableView: (NSTableView *)tv
+{
+  return ROWS;
+}
+
+- (id) tableView: (NSTableView *)tv
+objectValueForTableColumn: (NSTableColumn *)column
+             row: (NSInteger)row
+{
+  return nil;
+}
+
+/* Even rows are 10 high, odd rows 20, and row 5 is extra higher */
+- (CGFloat) tableView: (NSTableView *)tv heightOfRow: (NSInteger)row
+{
+  return ((row % 2) ? 20.0 : 10.0) + ((row == 5) ? extra : 0.0);
+}
+@end
+
+int
+main(int argc, char **argv)
+{
+  NSTableView *tv;
+  Rows *rows;
+  NSRect r;
+  NSRange range;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  rows = [Rows new];
+  tv = [[NSTableView alloc] initWithFrame: NSMakeRect(0, 0, 200, 200)];
+  [tv addTableColumn: AUTORELEASE([[NSTableColumn alloc]
+                                    initWithIdentifier: @"a"])];
+  [tv setDelegate: rows];
+  [tv setDataSource: rows];
+  [tv reloadData];
+
+  r = [tv rectOfRow: 3];
+  pass(NSMinY(r) == 40.0 && NSHeight(r) == 20.0,
+       "rows are placed after the rows above them");
+  r = [tv rectOfRow: ROWS - 1];
+  pass(NSMaxY(r) == 15.0 * ROWS, "the last row ends at the sum of heights");
+  pass(NSHeight([tv frame]) >= 15.0 * ROWS,
+       "the table is as high as all its rows");
+  pass([tv rowAtPoint: NSMakePoint(5, 45)] == 3
+       && [tv rowAtPoint: NSMakePoint(5, 60)] == 4
+       && [tv rowAtPoint: NSMakePoint(5, 15.0 * 5000 + 1)] == 5000,
+       "rowAtPoint: finds rows of different heights");
+  range = [tv rowsInRect: NSMakeRect(0, 45, 200, 30)];
+  pass(range.location == 3 && NSMaxRange(range) == 6,
+       "rowsInRect: finds the rows the rect crosses");
+
+  rows->extra = 30.0;
+  [tv noteHeightOfRowsWithIndexesChanged: [NSIndexSet indexSetWithIndex: 5]];
+  r = [tv rectOfRow: 5];
+  pass(NSHeight(r) == 50.0, "a changed row gets its new height");
+  r = [tv rectOfRow: 6];
+  pass(NSMinY(r) == 120.0, "rows below a changed row move down");
+  pass(NSMinY([tv rectOfRow: 4]) == 60.0, "rows above it stay");
+
+  [tv setDelegate: nil];
+  pass(NSMinY([tv rectOfRow: 6]) == 6 * [tv rowHeight],
+       "without the delegate all rows have the row height");
+
+  [tv release];
+  [rows release];
+  DESTROY(arp);
+  return 0;
+}
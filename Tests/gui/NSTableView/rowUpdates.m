@@ -0,0 +1,117 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that inserting, removing and moving rows keeps the selection with
+its rows, resizes the table and asks the data source again only for the
+rows that changed.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSArray.h>
+#import <Foundation/NSIndexSet.h>
+#import <Foundation/NSValue.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSTableColumn.h>
+#import <AppKit/NSTableView.h>
+
+@interface NSTableView (Private)
+- (id) _cachedObjectValueAtColumn: (NSInteger)columnIndex
+                              row: (NSInteger)rowIndex;
+@end
+
+@interface Rows : NSObject
+{
+@public
+  NSMutableArray *rows;
+  NSUInteger asked;
+}
+@end
+
+@implementation Rows
+- (NSInteger) numberOfRowsInTableView: (NSTableView *)tv
+{
+  return [rows count];
+}
+
+- (id) tableView: (NSTableView *)tv
+objectValueForTableColumn: (NSTableColumn *)column
+             row: (NSInteger)row
+{
+  asked++;
+  return [rows objectAtIndex: row];
+}
+@end
+
+int
+main(int argc, char **argv)
+{
+  NSTableView *tv;
+  Rows *ds;
+  NSInteger i;
+  CGFloat height;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  ds = [Rows new];
+  ds->rows = [NSMutableArray new];
+  for (i = 0; i < 10; i++)
+    {
+      [ds->rows addObject: [NSNumber numberWithInteger: i]];
+    }
+  tv = [[NSTableView alloc] initWithFrame: NSMakeRect(0, 0, 200, 200)];
+  [tv addTableColumn: AUTORELEASE([[NSTableColumn alloc]
+                                    initWithIdentifier: @"a"])];
+  [tv setCachesObjectValues: YES];
+  [tv setDataSource: ds];
+  [tv selectRowIndexes: [NSIndexSet indexSetWithIndex: 5]
+  byExtendingSelection: NO];
+  height = NSHeight([tv frame]);
+
+  for (i = 0; i < 10; i++)
+    {
+      [tv _cachedObjectValueAtColumn: 0 row: i];
+    }
+  ds->asked = 0;
+  [ds->rows addObject: [NSNumber numberWithInteger: 10]];
+  [tv insertRowsAtIndexes: [NSIndexSet indexSetWithIndex: 10]
+            withAnimation: NSTableViewAnimationEffectNone];
+  for (i = 0; i < 11; i++)
+    {
+      [tv _cachedObjectValueAtColumn: 0 row: i];
+    }
+  pass([tv numberOfRows] == 11 && ds->asked == 1,
+       "appending a row asks only for the new row");
+  pass(NSHeight([tv frame]) > height, "appending a row makes the table taller");
+
+  [ds->rows insertObject: [NSNumber numberWithInteger: -1] atIndex: 0];
+  [tv insertRowsAtIndexes: [NSIndexSet indexSetWithIndex: 0]
+            withAnimation: NSTableViewAnimationEffectNone];
+  pass([tv selectedRow] == 6 && [[tv selectedRowIndexes] count] == 1,
+       "the selection moves with an inserted row before it");
+  pass([[tv _cachedObjectValueAtColumn: 0 row: 6] integerValue] == 5,
+       "rows after an inserted row get their new values");
+
+  [ds->rows removeObjectAtIndex: 6];
+  [tv beginUpdates];
+  [tv removeRowsAtIndexes: [NSIndexSet indexSetWithIndex: 6]
+            withAnimation: NSTableViewAnimationEffectNone];
+  [tv endUpdates];
+  pass([tv numberOfRows] == 11 && [tv selectedRow] == -1,
+       "removing a selected row deselects it");
+
+  [tv selectRowIndexes: [NSIndexSet indexSetWithIndex: 2]
+  byExtendingSelection: NO];
+  [ds->rows exchangeObjectAtIndex: 2 withObjectAtIndex: 3];
+  [tv moveRowAtIndex: 2 toIndex: 3];
+  pass([tv selectedRow] == 3
+       && [[tv _cachedObjectValueAtColumn: 0 row: 2] integerValue] == 2,
+       "a moved row keeps its selection");
+
+  [tv release];
+  [ds->rows release];
+  [ds release];
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,93 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that typing the start of a row's string selects the row, that
+characters typed quickly are matched together, and that reloading a
+row updates what it is matched by.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSArray.h>
+#import <Foundation/NSIndexSet.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSEvent.h>
+#import <AppKit/NSTableColumn.h>
+#import <AppKit/NSTableView.h>
+
+@interface Rows : NSObject
+{
+@public
+  NSMutableArray *rows;
+}
+@end
+
+@implementation Rows
+- (NSInteger) numberOfRowsInTableView: (NSTableView *)tv
+{
+  return [rows count];
+}
+
+- (id) tableView: (NSTableView *)tv
+objectValueForTableColumn: (NSTableColumn *)column
+             row: (NSInteger)row
+{
+  return [rows objectAtIndex: row];
+}
+@end
+
+static void
+type(NSTableView *tv, NSString *characters, NSTimeInterval time)
+{
+  NSEvent *e = [NSEvent keyEventWithType: NSKeyDown
+                                location: NSZeroPoint
+                           modifierFlags: 0
+                               timestamp: time
+                            windowNumber: 0
+                                 context: nil
+                              characters: characters
+             charactersIgnoringModifiers: characters
+                               isARepeat: NO
+                                 keyCode: 0];
+
+  [tv keyDown: e];
+}
+
+int
+main(int argc, char **argv)
+{
+  NSTableView *tv;
+  Rows *ds;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  ds = AUTORELEASE([Rows new]);
+  ds->rows = AUTORELEASE([[NSMutableArray alloc] initWithObjects:
+    @"Delta", @"alpha", @"Bravo", @"charlie", @"beta", @"alps", nil]);
+  tv = AUTORELEASE([[NSTableView alloc]
+                     initWithFrame: NSMakeRect(0, 0, 200, 200)]);
+  [tv addTableColumn: AUTORELEASE([[NSTableColumn alloc]
+                                    initWithIdentifier: @"a"])];
+  [tv setDataSource: ds];
+
+  type(tv, @"b", 10);
+  pass([tv selectedRow] == 2, "typing a character selects the first match");
+  type(tv, @"e", 10.2);
+  pass([tv selectedRow] == 4, "characters typed quickly are matched together");
+  type(tv, @"A", 20);
+  pass([tv selectedRow] == 5, "matching goes on from the selected row");
+  type(tv, @"l", 20.1);
+  pass([tv selectedRow] == 5, "a selected row that still matches stays");
+  type(tv, @"z", 30);
+  pass([tv selectedRow] == 5, "no match keeps the selection");
+
+  [ds->rows replaceObjectAtIndex: 0 withObject: @"zulu"];
+  [tv reloadDataForRowIndexes: [NSIndexSet indexSetWithIndex: 0]
+                columnIndexes: [NSIndexSet indexSetWithIndex: 0]];
+  type(tv, @"z", 40);
+  pass([tv selectedRow] == 0, "reloaded rows are matched by their new string");
+
+  DESTROY(arp);
+  return 0;
+}
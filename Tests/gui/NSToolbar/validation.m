@@ -0,0 +1,104 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that toolbar items keep asking the right validator when their
+target changes, and the toolbar validation interval accessors.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSToolbar.h>
+#import <AppKit/NSToolbarItem.h>
+
+@interface ToolbarValidator : NSObject
+{
+@public
+  BOOL answer;
+}
+@end
+
+@implementation ToolbarValidator
+- (void) fire: (id)sender
+{
+}
+- (BOOL) validateToolbarItem: (NSToolbarItem *)item
+{
+  return answer;
+}
+@end
+
+@interface InterfaceValidator : NSObject
+@end
+
+@implementation InterfaceValidator
+- (void) fire: (id)sender
+{
+}
+- (BOOL) validateUserInterfaceItem: (id)item
+{
+  return NO;
+}
+@end
+
+@interface Plain : NSObject
+@end
+
+@implementation Plain
+- (void) fire: (id)sender
+{
+}
+@end
+
+int
+main(int argc, char **argv)
+{
+  NSToolbar *toolbar;
+  NSToolbarItem *item;
+  ToolbarValidator *tv;
+  InterfaceValidator *iv;
+  Plain *plain;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  tv = [ToolbarValidator new];
+  iv = [InterfaceValidator new];
+  plain = [Plain new];
+  item = [[NSToolbarItem alloc] initWithItemIdentifier: @"Item"];
+  [item setAction: @selector(fire:)];
+
+  [item setTarget: tv];
+  tv->answer = YES;
+  [item validate];
+  pass([item isEnabled], "validateToolbarItem: can enable the item");
+  tv->answer = NO;
+  [item validate];
+  pass(![item isEnabled], "validator is asked on each validation");
+
+  [item setTarget: plain];
+  [item validate];
+  pass([item isEnabled], "target without a validation method enables");
+
+  [item setTarget: iv];
+  [item validate];
+  pass(![item isEnabled], "validateUserInterfaceItem: is used for a new target");
+
+  [item setTarget: plain];
+  [item setAction: @selector(doesNotExist:)];
+  [item validate];
+  pass(![item isEnabled], "item is disabled when no one performs its action");
+
+  toolbar = [[NSToolbar alloc] initWithIdentifier: @"ValidationTest"];
+  pass([toolbar validationInterval] == 0, "toolbar validates on every update");
+  [toolbar setValidationInterval: 0.5];
+  pass([toolbar validationInterval] == 0.5, "validation interval can be set");
+
+  [toolbar release];
+  [item release];
+  [tv release];
+  [iv release];
+  [plain release];
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,89 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that a clip view with an overdraw margin shows what it kept of its
+document view when it is scrolled back, instead of having it drawn
+again, and that it forgets what it kept once the document changes.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSDate.h>
+#import <Foundation/NSRunLoop.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSClipView.h>
+#import <AppKit/NSView.h>
+#import <AppKit/NSWindow.h>
+
+@interface FlippedView : NSView
+@end
+
+@implementation FlippedView
+- (BOOL) isFlipped
+{
+  return YES;
+}
+- (BOOL) isOpaque
+{
+  return YES;
+}
+@end
+
+static void
+settle(NSWindow *window)
+{
+  [window displayIfNeeded];
+  [[NSRunLoop currentRunLoop] runUntilDate:
+    [NSDate dateWithTimeIntervalSinceNow: 0.3]];
+}
+
+int
+main(int argc, char **argv)
+{
+  NSWindow *window;
+  NSClipView *clip;
+  NSView *doc;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  window = [[NSWindow alloc] initWithContentRect: NSMakeRect(100, 100, 200, 200)
+				       styleMask: NSBorderlessWindowMask
+					 backing: NSBackingStoreBuffered
+					   defer: NO];
+  clip = [[NSClipView alloc] initWithFrame: NSMakeRect(0, 0, 100, 100)];
+  doc = [[FlippedView alloc] initWithFrame: NSMakeRect(0, 0, 100, 1000)];
+  [clip setDocumentView: doc];
+  [[window contentView] addSubview: clip];
+  [window orderFront: nil];
+  [window display];
+
+  pass([clip overdrawMargin] == 0.0, "nothing is kept by default");
+  [clip setOverdrawMargin: 100.0];
+  pass([clip overdrawMargin] == 100.0, "the margin can be set");
+
+  settle(window);
+  [clip scrollToPoint: NSMakePoint(0, 50)];
+  pass([doc needsDisplay], "a strip scrolled into sight for the first time is drawn");
+  settle(window);
+  [clip scrollToPoint: NSMakePoint(0, 0)];
+  testHopeful = YES;
+  pass([doc needsDisplay] == NO,
+       "a strip scrolled back into sight is shown from what was kept");
+  testHopeful = NO;
+
+  settle(window);
+  [doc setNeedsDisplayInRect: NSMakeRect(0, 0, 10, 10)];
+  [window displayIfNeeded];
+  [clip scrollToPoint: NSMakePoint(0, 50)];
+  pass([doc needsDisplay], "what was kept is forgotten once the document changes");
+
+  [clip setOverdrawMargin: 0.0];
+  pass([clip overdrawMargin] == 0.0, "keeping can be turned off");
+
+  RELEASE(doc);
+  RELEASE(clip);
+  RELEASE(window);
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,116 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that converting arrays of points and rects between views gives the
+same results as converting them one at a time.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSView.h>
+#import <AppKit/NSWindow.h>
+
+#include <math.h>
+#include <string.h>
+
+#define N 16
+
+static BOOL
+close_points(NSPoint a, NSPoint b)
+{
+  return fabs(a.x - b.x) < 0.001 && fabs(a.y - b.y) < 0.001;
+}
+
+static BOOL
+close_rects(NSRect a, NSRect b)
+{
+  return close_points(a.origin, b.origin)
+    && fabs(a.size.width - b.size.width) < 0.001
+    && fabs(a.size.height - b.size.height) < 0.001;
+}
+
+static BOOL
+check(NSView *from, NSView *to)
+{
+  NSPoint points[N], to_points[N], from_points[N];
+  NSRect rects[N], to_rects[N], from_rects[N];
+  BOOL ok = YES;
+  int i;
+
+  for (i = 0; i < N; i++)
+    {
+      points[i] = NSMakePoint(i * 3.5, 40 - i * 2);
+      rects[i] = NSMakeRect(i, i * 2, 10 + i, 5);
+    }
+  memcpy(to_points, points, sizeof(points));
+  memcpy(from_points, points, sizeof(points));
+  memcpy(to_rects, rects, sizeof(rects));
+  memcpy(from_rects, rects, sizeof(rects));
+  [to convertPoints: from_points count: N fromView: from];
+  [to convertRects: from_rects count: N fromView: from];
+  if (from != nil)
+    {
+      [from convertPoints: to_points count: N toView: to];
+      [from convertRects: to_rects count: N toView: to];
+    }
+  else
+    {
+      memcpy(to_points, from_points, sizeof(points));
+      memcpy(to_rects, from_rects, sizeof(rects));
+    }
+
+  for (i = 0; i < N; i++)
+    {
+      NSPoint p = [to convertPoint: points[i] fromView: from];
+      NSRect r = [to convertRect: rects[i] fromView: from];
+
+      ok = ok && close_points(p, to_points[i])
+	&& close_points(p, from_points[i])
+	&& close_rects(r, to_rects[i]) && close_rects(r, from_rects[i]);
+    }
+  return ok;
+}
+
+@interface FlippedView : NSView
+@end
+
+@implementation FlippedView
+- (BOOL) isFlipped
+{
+  return YES;
+}
+@end
+
+int
+main(int argc, char **argv)
+{
+  NSWindow *window;
+  NSView *view1, *view2;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+  window = [[NSWindow alloc] initWithContentRect: NSMakeRect(100, 100, 200, 200)
+				       styleMask: NSClosableWindowMask
+					 backing: NSBackingStoreRetained
+					   defer: YES];
+  view1 = [[NSView alloc] initWithFrame: NSMakeRect(20, 20, 100, 100)];
+  view2 = [[FlippedView alloc] initWithFrame: NSMakeRect(25, 25, 50, 50)];
+  [view1 addSubview: view2];
+  [[window contentView] addSubview: view1];
+  [view2 setBoundsSize: NSMakeSize(25, 100)];
+
+  pass(check(view2, view1) && check(view1, view2),
+       "arrays convert between a view and its superview");
+  pass(check(nil, view2) && check(nil, view1),
+       "arrays convert between a view and its window");
+
+  [view2 setFrameRotation: 30.0];
+  pass(check(view2, view1) && check(view2, [window contentView]),
+       "arrays convert from a rotated view");
+
+  RELEASE(view1);
+  RELEASE(view2);
+  DESTROY(arp);
+  return 0;
+}
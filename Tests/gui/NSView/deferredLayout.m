@@ -0,0 +1,83 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that with deferred autoresizing a burst of frame changes
+autoresizes the subviews once, when the layout pass runs, and that the
+result is the same as autoresizing them each time.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSView.h>
+#import <AppKit/NSWindow.h>
+
+@interface NSView (DeferredLayout)
++ (NSUInteger) _savedAutoresizeCount;
+@end
+
+int
+main(int argc, char **argv)
+{
+  NSWindow *window;
+  NSView *container, *inner, *innermost;
+  NSUInteger saved;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  window = [[NSWindow alloc] initWithContentRect: NSMakeRect(100, 100, 300, 300)
+				       styleMask: NSBorderlessWindowMask
+					 backing: NSBackingStoreBuffered
+					   defer: YES];
+  container = [[NSView alloc] initWithFrame: NSMakeRect(0, 0, 100, 100)];
+  inner = [[NSView alloc] initWithFrame: NSMakeRect(10, 10, 80, 80)];
+  innermost = [[NSView alloc] initWithFrame: NSMakeRect(0, 0, 20, 80)];
+  [inner setAutoresizingMask: NSViewWidthSizable | NSViewHeightSizable];
+  [innermost setAutoresizingMask: NSViewMinXMargin | NSViewHeightSizable];
+  [inner addSubview: innermost];
+  [container addSubview: inner];
+  [[window contentView] addSubview: container];
+
+  pass([NSView defersAutoresizing] == NO,
+       "autoresizing is not deferred by default");
+  [container setFrameSize: NSMakeSize(110, 110)];
+  pass(NSEqualRects([inner frame], NSMakeRect(10, 10, 90, 90)),
+       "subviews are autoresized at once by default");
+
+  [NSView setDefersAutoresizing: YES];
+  saved = [NSView _savedAutoresizeCount];
+  [container setFrameSize: NSMakeSize(120, 120)];
+  [container setFrameSize: NSMakeSize(150, 130)];
+  [container setFrameSize: NSMakeSize(200, 140)];
+  pass([container needsLayout]
+       && NSEqualRects([inner frame], NSMakeRect(10, 10, 90, 90)),
+       "frame changes mark the view as needing layout");
+  pass([NSView _savedAutoresizeCount] - saved == 2,
+       "repeated frame changes are counted as saved passes");
+
+  [[window contentView] layoutSubtreeIfNeeded];
+  pass([container needsLayout] == NO && [inner needsLayout] == NO,
+       "the layout pass clears the marks");
+  pass(NSEqualRects([inner frame], NSMakeRect(10, 10, 180, 120)),
+       "the layout pass autoresizes the subviews");
+  pass(NSEqualRects([innermost frame], NSMakeRect(100, 0, 20, 120)),
+       "the layout pass works from the top down");
+
+  [container setFrameSize: NSMakeSize(100, 100)];
+  [container removeFromSuperview];
+  pass(NSEqualRects([inner frame], NSMakeRect(10, 10, 80, 80)),
+       "a view leaving its window is laid out first");
+
+  [container setFrameSize: NSMakeSize(110, 110)];
+  pass(NSEqualRects([inner frame], NSMakeRect(10, 10, 90, 90)),
+       "views outside a window are autoresized at once");
+  [NSView setDefersAutoresizing: NO];
+
+  RELEASE(innermost);
+  RELEASE(inner);
+  RELEASE(container);
+  RELEASE(window);
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,130 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that a view hierarchy that is not in a window can be drawn into a
+bitmap, in the main thread and in a worker thread, with its subviews in
+their places.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSDate.h>
+#import <Foundation/NSThread.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSBitmapImageRep.h>
+#import <AppKit/NSColor.h>
+#import <AppKit/NSGraphics.h>
+#import <AppKit/NSGraphicsContext.h>
+#import <AppKit/NSView.h>
+
+@interface FilledView : NSView
+{
+  NSColor *color;
+}
+- (id) initWithFrame: (NSRect)frame color: (NSColor *)aColor;
+@end
+
+@implementation FilledView
+- (id) initWithFrame: (NSRect)frame color: (NSColor *)aColor
+{
+  self = [super initWithFrame: frame];
+  color = [aColor retain];
+  return self;
+}
+
+- (void) dealloc
+{
+  [color release];
+  [super dealloc];
+}
+
+- (void) drawRect: (NSRect)rect
+{
+  [color set];
+  NSRectFill(rect);
+}
+@end
+
+@interface Renderer : NSObject
+{
+@public
+  NSView *view;
+  NSBitmapImageRep *bitmap;
+  BOOL done;
+}
+- (void) render: (id)sender;
+@end
+
+@implementation Renderer
+- (void) render: (id)sender
+{
+  CREATE_AUTORELEASE_POOL(arp);
+
+  bitmap = [[view bitmapImageRepForCachingDisplayInRect: [view bounds]]
+             retain];
+  [view cacheDisplayInRect: [view bounds] toBitmapImageRep: bitmap];
+  done = YES;
+  DESTROY(arp);
+}
+@end
+
+/* Returns YES if the pixel at x, y (counted from the bottom left) is
+   mostly red.  */
+static BOOL
+isRed(NSBitmapImageRep *bitmap, NSInteger x, NSInteger y)
+{
+  NSColor *c = [bitmap colorAtX: x y: [bitmap pixelsHigh] - 1 - y];
+
+  c = [c colorUsingColorSpaceName: NSCalibratedRGBColorSpace];
+  return [c redComponent] > 0.9 && [c greenComponent] < 0.1;
+}
+
+int
+main(int argc, char **argv)
+{
+  NSView *root, *sub;
+  NSBitmapImageRep *bitmap;
+  NSGraphicsContext *before;
+  Renderer *renderer;
+  NSDate *limit;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  root = [[FilledView alloc] initWithFrame: NSMakeRect(0, 0, 40, 40)
+                                     color: [NSColor whiteColor]];
+  sub = [[FilledView alloc] initWithFrame: NSMakeRect(20, 0, 20, 20)
+                                    color: [NSColor redColor]];
+  [root addSubview: sub];
+
+  before = [NSGraphicsContext currentContext];
+  bitmap = [root bitmapImageRepForCachingDisplayInRect: [root bounds]];
+  pass([bitmap pixelsWide] == 40 && [bitmap pixelsHigh] == 40,
+       "a bitmap for a detached view has the size of the rect");
+  [root cacheDisplayInRect: [root bounds] toBitmapImageRep: bitmap];
+  pass(isRed(bitmap, 30, 10) && !isRed(bitmap, 10, 30),
+       "a detached view hierarchy draws into the bitmap");
+  pass([NSGraphicsContext currentContext] == before,
+       "the bitmap context is not left current");
+
+  renderer = [Renderer new];
+  renderer->view = root;
+  [NSThread detachNewThreadSelector: @selector(render:)
+                           toTarget: renderer
+                         withObject: nil];
+  limit = [NSDate dateWithTimeIntervalSinceNow: 10.0];
+  while (!renderer->done && [limit timeIntervalSinceNow] > 0)
+    {
+      [NSThread sleepForTimeInterval: 0.01];
+    }
+  pass(renderer->done && isRed(renderer->bitmap, 30, 10)
+       && !isRed(renderer->bitmap, 10, 30),
+       "a detached view hierarchy draws in a worker thread");
+
+  [renderer->bitmap release];
+  [renderer release];
+  [sub release];
+  [root release];
+  DESTROY(arp);
+  return 0;
+}
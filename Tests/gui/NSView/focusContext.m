@@ -0,0 +1,72 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that locking focus on views makes the window context current and
+unlocking makes the previous context current again, also when graphics
+states are saved in between and when views give up private gstates.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSGraphicsContext.h>
+#import <AppKit/NSView.h>
+#import <AppKit/NSWindow.h>
+
+int
+main(int argc, char **argv)
+{
+  NSWindow *window;
+  NSView *outer, *inner;
+  NSGraphicsContext *before, *ctxt;
+  BOOL nested;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  window = [[NSWindow alloc] initWithContentRect: NSMakeRect(100, 100, 200, 200)
+				       styleMask: NSBorderlessWindowMask
+					 backing: NSBackingStoreBuffered
+					   defer: NO];
+  outer = [[NSView alloc] initWithFrame: NSMakeRect(10, 10, 100, 100)];
+  inner = [[NSView alloc] initWithFrame: NSMakeRect(10, 10, 50, 50)];
+  [[window contentView] addSubview: outer];
+  [outer addSubview: inner];
+  ctxt = [window graphicsContext];
+
+  before = [NSGraphicsContext currentContext];
+  [outer lockFocus];
+  pass([NSGraphicsContext currentContext] == ctxt,
+       "locking focus makes the window context current");
+  [inner lockFocus];
+  nested = ([NSGraphicsContext currentContext] == ctxt
+	    && [ctxt focusView] == inner);
+  [NSGraphicsContext saveGraphicsState];
+  [NSGraphicsContext restoreGraphicsState];
+  [inner unlockFocus];
+  pass(nested && [NSGraphicsContext currentContext] == ctxt
+       && [ctxt focusView] == outer,
+       "unlocking a nested focus keeps the outer view focused");
+  [outer unlockFocus];
+  pass([NSGraphicsContext currentContext] == before,
+       "unlocking focus makes the previous context current again");
+
+  [inner allocateGState];
+  [inner lockFocus];
+  [inner unlockFocus];
+  pass([inner gState] != 0, "a view allocates a private gstate");
+  [inner releaseGState];
+  pass([inner gState] == 0, "a released gstate is given up");
+  [outer allocateGState];
+  [outer lockFocus];
+  [outer unlockFocus];
+  pass([outer gState] != 0, "another view can allocate a gstate after that");
+  pass([NSGraphicsContext currentContext] == before,
+       "the current context is still the one we started with");
+
+  [inner release];
+  [outer release];
+  [window release];
+  DESTROY(arp);
+  return 0;
+}
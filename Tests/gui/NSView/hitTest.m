@@ -0,0 +1,110 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that hit testing a view with many subviews finds the same view as
+asking each subview in turn, also after subviews are moved, rotated,
+added and removed.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSArray.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSView.h>
+
+#include <stdlib.h>
+
+/* A view which takes hits anywhere in its superview.  */
+@interface GreedyView : NSView
+@end
+
+@implementation GreedyView
+- (NSView *) hitTest: (NSPoint)aPoint
+{
+  return self;
+}
+@end
+
+static NSView *
+expected(NSView *canvas, NSPoint p)
+{
+  NSArray *subviews = [canvas subviews];
+  NSUInteger i = [subviews count];
+
+  while (i-- > 0)
+    {
+      NSView *v = [[subviews objectAtIndex: i] hitTest: p];
+
+      if (v != nil)
+        return v;
+    }
+  return canvas;
+}
+
+static BOOL
+check(NSView *canvas)
+{
+  BOOL ok = YES;
+  int i;
+
+  for (i = 0; i < 2000; i++)
+    {
+      NSPoint p = NSMakePoint(rand() % 1100 - 50 + (rand() % 4) * 0.25,
+                              rand() % 1100 - 50);
+
+      ok = ok && [canvas hitTest: p] == expected(canvas, p);
+    }
+  return ok;
+}
+
+int
+main(int argc, char **argv)
+{
+  NSView *canvas, *view;
+  NSArray *subviews;
+  int i;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+  srand(1234);
+
+  canvas = [[NSView alloc] initWithFrame: NSMakeRect(0, 0, 1000, 1000)];
+  for (i = 0; i < 500; i++)
+    {
+      view = [[NSView alloc] initWithFrame:
+        NSMakeRect(rand() % 950, rand() % 950, 10 + rand() % 40,
+                   10 + rand() % 40)];
+      [canvas addSubview: view];
+      RELEASE(view);
+    }
+  pass(check(canvas), "hit testing many subviews finds the topmost one");
+
+  subviews = [canvas subviews];
+  for (i = 0; i < 100; i++)
+    {
+      [[subviews objectAtIndex: rand() % 500] setFrameOrigin:
+        NSMakePoint(rand() % 1100 - 50, rand() % 1100 - 50)];
+    }
+  [[subviews objectAtIndex: 10] setFrameSize: NSMakeSize(300, 300)];
+  pass(check(canvas), "hit testing follows moved subviews");
+
+  [[subviews objectAtIndex: 20] setFrameRotation: 45];
+  [[subviews objectAtIndex: 30] setFrame: NSMakeRect(400, 400, 100, 20)];
+  [[subviews objectAtIndex: 30] setBoundsRotation: 60];
+  pass(check(canvas), "hit testing finds rotated subviews");
+
+  view = [[GreedyView alloc] initWithFrame: NSMakeRect(0, 0, 1, 1)];
+  [canvas addSubview: view
+          positioned: NSWindowBelow
+          relativeTo: [subviews objectAtIndex: 250]];
+  RELEASE(view);
+  for (i = 0; i < 50; i++)
+    {
+      [[[canvas subviews] objectAtIndex: rand() % 400] removeFromSuperview];
+    }
+  pass(check(canvas), "hit testing follows added and removed subviews");
+
+  RELEASE(canvas);
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,58 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that with lazy tool tips a view with many tool tip rectangles has
+a single tracking rectangle, and that tips can still be counted and
+removed.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSArray.h>
+#import <Foundation/NSDictionary.h>
+#import <Foundation/NSUserDefaults.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSView.h>
+
+int
+main(int argc, char **argv)
+{
+  NSView *view;
+  NSToolTipTag first = 0, tag = 0;
+  int i;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [[NSUserDefaults standardUserDefaults] registerDefaults:
+    [NSDictionary dictionaryWithObject: @"YES" forKey: @"GSLazyToolTips"]];
+  [NSApplication sharedApplication];
+
+  view = [[NSView alloc] initWithFrame: NSMakeRect(0, 0, 100, 2000)];
+  for (i = 0; i < 1000; i++)
+    {
+      tag = [view addToolTipRect: NSMakeRect(0, i * 2, 100, 2)
+                           owner: @"cell"
+                        userData: NULL];
+      if (i == 0)
+        first = tag;
+    }
+  pass(tag != -1 && tag != first, "each tool tip gets a tag");
+  pass([[view _trackingRects] count] == 1,
+       "lazy tool tips share one tracking rectangle");
+
+  [view setToolTip: @"view"];
+  pass([[view toolTip] isEqual: @"view"], "the view tool tip is kept");
+  pass([[view _trackingRects] count] == 1,
+       "the view tool tip shares the tracking rectangle");
+
+  [view removeToolTip: first];
+  [view setToolTip: nil];
+  pass([view toolTip] == nil, "the view tool tip can be removed");
+
+  [view removeAllToolTips];
+  pass([[view _trackingRects] count] == 0,
+       "the tracking rectangle goes with the last tool tip");
+
+  RELEASE(view);
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,101 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check what views are told about a live resize of their window: the
+parts of a view which preserves its content that were newly exposed,
+and that a view which stretches its content is laid out once the resize
+is over.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSView.h>
+#import <AppKit/NSWindow.h>
+
+@interface PreservingView : NSView
+@end
+
+@implementation PreservingView
+- (BOOL) preservesContentDuringLiveResize
+{
+  return YES;
+}
+@end
+
+@interface StretchingView : NSView
+@end
+
+@implementation StretchingView
+- (BOOL) stretchesContentDuringLiveResize
+{
+  return YES;
+}
+@end
+
+int
+main(int argc, char **argv)
+{
+  NSWindow *window;
+  NSView *preserving, *stretching, *inner;
+  NSRect exposed[4];
+  NSInteger count;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  window = [[NSWindow alloc] initWithContentRect: NSMakeRect(100, 100, 300, 300)
+				       styleMask: NSBorderlessWindowMask
+					 backing: NSBackingStoreBuffered
+					   defer: NO];
+  preserving = [[PreservingView alloc] initWithFrame: NSMakeRect(0, 0, 100, 100)];
+  stretching = [[StretchingView alloc] initWithFrame: NSMakeRect(150, 0, 100, 100)];
+  inner = [[NSView alloc] initWithFrame: NSMakeRect(10, 10, 80, 80)];
+  [inner setAutoresizingMask: NSViewWidthSizable | NSViewHeightSizable];
+  [stretching addSubview: inner];
+  [[window contentView] addSubview: preserving];
+  [[window contentView] addSubview: stretching];
+  [window orderFront: nil];
+  [window display];
+
+  pass([window inLiveResize] == NO && [preserving inLiveResize] == NO,
+       "no live resize to begin with");
+  [preserving getRectsExposedDuringLiveResize: exposed count: &count];
+  pass(count == 1 && NSEqualRects(exposed[0], [preserving bounds]),
+       "all of a view is exposed outside a live resize");
+
+  [window _startLiveResize];
+  pass([window inLiveResize] && [preserving inLiveResize]
+       && [inner inLiveResize],
+       "all views know about a live resize");
+
+  [preserving setFrameSize: NSMakeSize(120, 110)];
+  pass(NSEqualRects([preserving rectPreservedDuringLiveResize],
+		    NSMakeRect(0, 0, 100, 100)),
+       "the old bounds are preserved");
+  [preserving getRectsExposedDuringLiveResize: exposed count: &count];
+  pass(count == 2
+       && NSEqualRects(exposed[0], NSMakeRect(0, 100, 120, 10))
+       && NSEqualRects(exposed[1], NSMakeRect(100, 0, 20, 100)),
+       "the new strips are exposed");
+  [preserving setFrameSize: NSMakeSize(90, 90)];
+  [preserving getRectsExposedDuringLiveResize: exposed count: &count];
+  pass(count == 0, "nothing is exposed when the view shrinks");
+
+  [stretching setFrameSize: NSMakeSize(200, 200)];
+  pass(NSEqualRects([inner frame], NSMakeRect(10, 10, 80, 80)),
+       "a stretching view is not laid out during the resize");
+
+  [window _endLiveResize];
+  pass([window inLiveResize] == NO && [preserving inLiveResize] == NO,
+       "the live resize ends");
+  pass(NSEqualRects([inner frame], NSMakeRect(10, 10, 180, 180)),
+       "a stretching view is laid out when the resize ends");
+
+  RELEASE(inner);
+  RELEASE(stretching);
+  RELEASE(preserving);
+  RELEASE(window);
+  DESTROY(arp);
+  return 0;
+}
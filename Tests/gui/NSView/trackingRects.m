@@ -0,0 +1,159 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that mouse moves send mouseEntered: and mouseExited: for each
+tracking rectangle the mouse crosses, also after views are moved and
+tracking rectangles are added and removed.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSArray.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSEvent.h>
+#import <AppKit/NSView.h>
+#import <AppKit/NSWindow.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_VIEWS 100
+#define NUM_RECTS (NUM_VIEWS + 1)
+
+static int entered[NUM_RECTS];
+static int exited[NUM_RECTS];
+static int expectedEntered[NUM_RECTS];
+static int expectedExited[NUM_RECTS];
+
+@interface Counter : NSObject
+@end
+
+@implementation Counter
+- (void) mouseEntered: (NSEvent *)theEvent
+{
+  entered[(intptr_t)[theEvent userData]]++;
+}
+
+- (void) mouseExited: (NSEvent *)theEvent
+{
+  exited[(intptr_t)[theEvent userData]]++;
+}
+@end
+
+static NSView *views[NUM_RECTS];
+static NSRect rects[NUM_RECTS];
+static NSTrackingRectTag tags[NUM_RECTS];
+
+static BOOL
+inside(int i, NSPoint p)
+{
+  if (views[i] == nil || [views[i] window] == nil)
+    return NO;
+  return NSPointInRect(p, [views[i] convertRect: rects[i] toView: nil]);
+}
+
+/* Moves the mouse through count random points, counting the rectangles
+   it should enter and exit on the way.  */
+static BOOL
+walk(NSWindow *window, NSPoint *last, int count)
+{
+  int i, j;
+
+  memset(entered, 0, sizeof(entered));
+  memset(exited, 0, sizeof(exited));
+  memset(expectedEntered, 0, sizeof(expectedEntered));
+  memset(expectedExited, 0, sizeof(expectedExited));
+  for (i = 0; i < count; i++)
+    {
+      NSPoint p = NSMakePoint(rand() % 420 - 10 + 0.5,
+                              rand() % 420 - 10 + 0.5);
+      NSEvent *e = [NSEvent mouseEventWithType: NSMouseMoved
+                                      location: p
+                                 modifierFlags: 0
+                                     timestamp: 0
+                                  windowNumber: [window windowNumber]
+                                       context: nil
+                                   eventNumber: 0
+                                    clickCount: 0
+                                      pressure: 0.0];
+
+      for (j = 0; j < NUM_RECTS; j++)
+        {
+          BOOL was = inside(j, *last), is = inside(j, p);
+
+          if (!was && is)
+            expectedEntered[j]++;
+          if (was && !is)
+            expectedExited[j]++;
+        }
+      [window sendEvent: e];
+      *last = p;
+    }
+  return memcmp(entered, expectedEntered, sizeof(entered)) == 0
+    && memcmp(exited, expectedExited, sizeof(exited)) == 0;
+}
+
+int
+main(int argc, char **argv)
+{
+  NSWindow *window;
+  NSView *content;
+  Counter *counter;
+  NSPoint last = NSMakePoint(-5.5, -5.5);
+  int i;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+  srand(99);
+
+  window = [[NSWindow alloc] initWithContentRect: NSMakeRect(100, 100, 400, 400)
+				       styleMask: NSBorderlessWindowMask
+					 backing: NSBackingStoreRetained
+					   defer: NO];
+  [window orderFront: nil];
+  content = [window contentView];
+  counter = [Counter new];
+  for (i = 0; i < NUM_VIEWS; i++)
+    {
+      views[i] = [[NSView alloc] initWithFrame:
+        NSMakeRect(rand() % 380, rand() % 380, 10 + rand() % 60,
+                   10 + rand() % 60)];
+      [content addSubview: views[i]];
+      RELEASE(views[i]);
+      rects[i] = [views[i] bounds];
+      tags[i] = [views[i] addTrackingRect: rects[i]
+                                    owner: counter
+                                 userData: (void *)(intptr_t)i
+                             assumeInside: NO];
+    }
+  pass(walk(window, &last, 500),
+       "mouse moves enter and exit the tracking rectangles they cross");
+
+  for (i = 0; i < 20; i++)
+    {
+      [views[rand() % NUM_VIEWS] setFrameOrigin:
+        NSMakePoint(rand() % 380, rand() % 380)];
+    }
+  [content setBoundsOrigin: NSMakePoint(30, -20)];
+  pass(walk(window, &last, 500),
+       "tracking rectangles move with their views");
+
+  [views[5] removeTrackingRect: tags[5]];
+  views[5] = nil;
+  [views[6] removeFromSuperview];
+  views[6] = nil;
+  views[NUM_VIEWS] = views[7];
+  rects[NUM_VIEWS] = NSMakeRect(0, 0, 5, 5);
+  [views[7] addTrackingRect: rects[NUM_VIEWS]
+                      owner: counter
+                   userData: (void *)(intptr_t)NUM_VIEWS
+               assumeInside: NO];
+  [views[8] setHidden: YES];
+  views[8] = nil;
+  pass(walk(window, &last, 500),
+       "tracking rectangles follow additions and removals");
+
+  RELEASE(counter);
+  DESTROY(arp);
+  return 0;
+}
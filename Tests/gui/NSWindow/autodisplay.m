@@ -0,0 +1,70 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that autodisplay keeps to the frame rate set for it while a view
+asks to be displayed much more often, and that windows record when they
+were displayed.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSDate.h>
+#import <Foundation/NSRunLoop.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSView.h>
+#import <AppKit/NSWindow.h>
+
+/* Marks view as needing display every few milliseconds for a second,
+   and returns how often its window was displayed meanwhile.  */
+static NSUInteger
+frames(NSWindow *window, NSView *view)
+{
+  NSUInteger count = [window autodisplayCount];
+  NSDate *end = [NSDate dateWithTimeIntervalSinceNow: 1.0];
+
+  while ([end timeIntervalSinceNow] > 0)
+    {
+      [view setNeedsDisplay: YES];
+      [[NSRunLoop currentRunLoop] runMode: NSDefaultRunLoopMode
+        beforeDate: [NSDate dateWithTimeIntervalSinceNow: 0.002]];
+    }
+  return [window autodisplayCount] - count;
+}
+
+int
+main(int argc, char **argv)
+{
+  NSWindow *window;
+  NSView *view;
+  NSUInteger count;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  window = [[NSWindow alloc] initWithContentRect: NSMakeRect(100, 100, 200, 200)
+				       styleMask: NSBorderlessWindowMask
+					 backing: NSBackingStoreBuffered
+					   defer: NO];
+  view = [[NSView alloc] initWithFrame: NSMakeRect(10, 10, 50, 50)];
+  [[window contentView] addSubview: view];
+  [window orderFront: nil];
+
+  [NSWindow setAutodisplayFrameRate: 20];
+  pass([NSWindow autodisplayFrameRate] == 20, "the frame rate can be set");
+  count = frames(window, view);
+  pass(count > 0 && count <= 22,
+       "autodisplay keeps to the frame rate");
+  pass([window lastAutodisplayDuration] >= 0
+       && -[[NSDate dateWithTimeIntervalSinceReferenceDate:
+         [window lastAutodisplayTime]] timeIntervalSinceNow] < 1.0,
+       "the window records its last autodisplay");
+
+  [NSWindow setAutodisplayFrameRate: 0];
+  pass([NSWindow autodisplayFrameRate] == 0,
+       "the frame rate can be turned off");
+
+  RELEASE(view);
+  RELEASE(window);
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,87 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that windows record display timings when asked to, including the
+views that took longest to draw, and forget them when reset.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSArray.h>
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSDate.h>
+#import <Foundation/NSDictionary.h>
+#import <Foundation/NSThread.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSView.h>
+#import <AppKit/NSWindow.h>
+
+@interface SlowView : NSView
+@end
+
+@implementation SlowView
+- (void) drawRect: (NSRect)rect
+{
+  [NSThread sleepForTimeInterval: 0.02];
+}
+@end
+
+int
+main(int argc, char **argv)
+{
+  NSWindow *window;
+  NSView *view;
+  NSDictionary *timings;
+  NSArray *views;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  window = [[NSWindow alloc] initWithContentRect: NSMakeRect(100, 100, 200, 200)
+				       styleMask: NSBorderlessWindowMask
+					 backing: NSBackingStoreBuffered
+					   defer: NO];
+  view = [[SlowView alloc] initWithFrame: NSMakeRect(10, 10, 50, 50)];
+  [[window contentView] addSubview: view];
+  [window orderFront: nil];
+
+  [NSWindow setRecordsDisplayTimings: NO];
+  [view setNeedsDisplay: YES];
+  [window displayIfNeeded];
+  pass([window displayTimings] == nil,
+       "windows record nothing while recording is off");
+
+  [NSWindow setRecordsDisplayTimings: YES];
+  pass([NSWindow recordsDisplayTimings], "recording can be turned on");
+  [view setNeedsDisplay: YES];
+  [window displayIfNeeded];
+  [view setNeedsDisplay: YES];
+  [window displayIfNeeded];
+  timings = [window displayTimings];
+  pass([[timings objectForKey: @"Frames"] intValue] == 2,
+       "each display is a frame");
+  pass([[timings objectForKey: @"SlowestDisplayTime"] doubleValue] >= 0.02,
+       "display time includes the drawing of the views");
+  pass([[timings objectForKey: @"LastViewsDrawn"] intValue] >= 1,
+       "the views drawn are counted");
+  views = [timings objectForKey: @"Views"];
+  pass([views count] > 0
+       && [[[views objectAtIndex: 0] objectForKey: @"View"]
+            hasPrefix: @"SlowView"]
+       && [[[views objectAtIndex: 0] objectForKey: @"Draws"] intValue] == 2,
+       "the slowest view comes first");
+
+  [window resetDisplayTimings];
+  timings = [window displayTimings];
+  pass([[timings objectForKey: @"Frames"] intValue] == 0
+       && [[timings objectForKey: @"Views"] count] == 0,
+       "resetting discards the timings");
+
+  [NSWindow setRecordsDisplayTimings: NO];
+  pass([window displayTimings] == nil,
+       "turning recording off discards the timings");
+
+  RELEASE(view);
+  RELEASE(window);
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,85 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that the time from an input event reaching the application to the
+next flush of its window is recorded when asked to, and forgotten when
+reset.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSDictionary.h>
+#import <Foundation/NSThread.h>
+#import <Foundation/NSValue.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSEvent.h>
+#import <AppKit/NSView.h>
+#import <AppKit/NSWindow.h>
+
+static void
+sendKey(NSWindow *window)
+{
+  NSEvent *event;
+
+  event = [NSEvent keyEventWithType: NSKeyDown
+			   location: NSZeroPoint
+		      modifierFlags: 0
+			  timestamp: 0
+		       windowNumber: [window windowNumber]
+			    context: nil
+			 characters: @"a"
+	charactersIgnoringModifiers: @"a"
+			  isARepeat: NO
+			    keyCode: 0];
+  [NSApp sendEvent: event];
+}
+
+int
+main(int argc, char **argv)
+{
+  NSWindow *window;
+  NSDictionary *stats;
+  NSDictionary *keys;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  window = [[NSWindow alloc] initWithContentRect: NSMakeRect(100, 100, 200, 200)
+				       styleMask: NSBorderlessWindowMask
+					 backing: NSBackingStoreBuffered
+					   defer: NO];
+  [window orderFront: nil];
+
+  [NSApplication setRecordsInputLatency: NO];
+  sendKey(window);
+  [[window contentView] setNeedsDisplay: YES];
+  [window displayIfNeeded];
+  pass([[NSApp inputLatencyStatistics] count] == 0,
+       "nothing is recorded while recording is off");
+
+  [NSApplication setRecordsInputLatency: YES];
+  pass([NSApplication recordsInputLatency], "recording can be turned on");
+  sendKey(window);
+  [NSThread sleepForTimeInterval: 0.02];
+  [[window contentView] setNeedsDisplay: YES];
+  [window displayIfNeeded];
+  stats = [NSApp inputLatencyStatistics];
+  keys = [stats objectForKey: @"KeyDown"];
+  testHopeful = YES;
+  pass([[keys objectForKey: @"Count"] intValue] == 1,
+       "a key down is measured at the next flush of its window");
+  pass([[keys objectForKey: @"MaxTime"] doubleValue] >= 0.02
+       && [[keys objectForKey: @"P99Time"] doubleValue]
+	 <= [[keys objectForKey: @"MaxTime"] doubleValue],
+       "the latency lasts until the flush");
+  testHopeful = NO;
+
+  [NSApp resetInputLatencyStatistics];
+  pass([[NSApp inputLatencyStatistics] count] == 0,
+       "resetting discards the latencies");
+
+  [NSApplication setRecordsInputLatency: NO];
+  RELEASE(window);
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,54 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that folder icons are cached and that noting a change to the file
+system makes the workspace look them up again.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSDictionary.h>
+#import <Foundation/NSFileManager.h>
+#import <Foundation/NSPathUtilities.h>
+#import <Foundation/NSValue.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSImage.h>
+#import <AppKit/NSWorkspace.h>
+
+static NSUInteger
+counter(NSWorkspace *ws, NSString *key)
+{
+  return [[[ws iconCacheStatistics] objectForKey: key] unsignedIntegerValue];
+}
+
+int
+main(int argc, char **argv)
+{
+  NSWorkspace *ws;
+  NSString *dir;
+  NSImage *icon;
+  NSUInteger hits, misses;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+  ws = [NSWorkspace sharedWorkspace];
+  dir = NSTemporaryDirectory();
+
+  icon = [ws iconForFile: dir];
+  hits = counter(ws, @"Hits");
+  pass(icon != nil && [ws iconForFile: dir] == icon
+       && counter(ws, @"Hits") == hits + 1,
+       "the icon of a folder is served from the cache");
+
+  misses = counter(ws, @"Misses");
+  [ws noteFileSystemChanged: dir];
+  [ws iconForFile: dir];
+  pass(counter(ws, @"Misses") == misses + 1,
+       "noting a change to a folder drops its cached icon");
+
+  pass(counter(ws, @"Entries") <= counter(ws, @"Capacity"),
+       "the icon cache stays within its capacity");
+
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,62 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that a folder whose icon is cached is watched for changes, so that
+its icon is looked up again once it changes, without anyone having to
+tell the workspace.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSData.h>
+#import <Foundation/NSDate.h>
+#import <Foundation/NSDictionary.h>
+#import <Foundation/NSFileManager.h>
+#import <Foundation/NSPathUtilities.h>
+#import <Foundation/NSProcessInfo.h>
+#import <Foundation/NSRunLoop.h>
+#import <Foundation/NSValue.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSImage.h>
+#import <AppKit/NSWorkspace.h>
+
+static NSUInteger
+counter(NSWorkspace *ws, NSString *key)
+{
+  return [[[ws iconCacheStatistics] objectForKey: key] unsignedIntegerValue];
+}
+
+int
+main(int argc, char **argv)
+{
+  NSFileManager *mgr = [NSFileManager defaultManager];
+  NSWorkspace *ws;
+  NSString *dir;
+  NSUInteger misses;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+  ws = [NSWorkspace sharedWorkspace];
+  dir = [NSTemporaryDirectory() stringByAppendingPathComponent:
+    [[NSProcessInfo processInfo] globallyUniqueString]];
+  [mgr createDirectoryAtPath: dir attributes: nil];
+
+  [ws iconForFile: dir];
+  misses = counter(ws, @"Misses");
+  [ws iconForFile: dir];
+  pass(counter(ws, @"Misses") == misses, "the icon of a folder is cached");
+
+  [[NSData data] writeToFile: [dir stringByAppendingPathComponent: @".dir.png"]
+		  atomically: NO];
+  [[NSRunLoop currentRunLoop] runUntilDate:
+    [NSDate dateWithTimeIntervalSinceNow: 0.5]];
+  [ws iconForFile: dir];
+  testHopeful = YES;
+  pass(counter(ws, @"Misses") == misses + 1,
+       "a change inside a watched folder drops its cached icon");
+  testHopeful = NO;
+
+  [mgr removeFileAtPath: dir handler: nil];
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,177 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Time a fixed set of text system scenarios on a large document: glyph
+generation, full layout, single character edits at the start, middle and
+end, caret seeks, and RTF save and load.
+
+Each scenario prints one tab separated line to stdout:
+
+  BENCHMARK <scenario> <seconds> <operations>
+
+If the GSTEST_BENCHMARK_FILE environment variable is set, the lines are
+appended to that file as well, so timings can be collected across runs.
+The text size defaults to 4 MB and may be changed by setting the
+GSTEST_TEXT_MB environment variable.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSData.h>
+#import <Foundation/NSDate.h>
+#import <Foundation/NSDictionary.h>
+#import <Foundation/NSProcessInfo.h>
+#import <Foundation/NSString.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSAttributedString.h>
+#import <AppKit/NSFont.h>
+#import <AppKit/NSLayoutManager.h>
+#import <AppKit/NSTextContainer.h>
+#import <AppKit/NSTextStorage.h>
+
+#define NUM_EDITS 100
+#define NUM_SEEKS 10000
+#define RTF_SIZE (1024 * 1024)
+
+static FILE *benchmarkFile;
+
+static void
+report(const char *scenario, NSDate *start, NSUInteger operations)
+{
+  double seconds = -[start timeIntervalSinceNow];
+
+  printf("BENCHMARK\t%s\t%f\t%lu\n",
+         scenario, seconds, (unsigned long)operations);
+  if (benchmarkFile != NULL)
+    fprintf(benchmarkFile, "BENCHMARK\t%s\t%f\t%lu\n",
+            scenario, seconds, (unsigned long)operations);
+}
+
+/* Makes a single character edit at index and lays out the text up to
+   the edited line again. */
+static BOOL
+editAt(NSTextStorage *ts, NSLayoutManager *lm, NSUInteger index)
+{
+  NSUInteger glyph;
+  NSRect r;
+
+  [ts replaceCharactersInRange: NSMakeRange(index, 0) withString: @"x"];
+  glyph = [lm glyphIndexForCharacterAtIndex: index];
+  r = [lm lineFragmentRectForGlyphAtIndex: glyph effectiveRange: NULL];
+  [ts replaceCharactersInRange: NSMakeRange(index, 1) withString: @""];
+  return !NSIsEmptyRect(r);
+}
+
+int
+main(int argc, char **argv)
+{
+  NSString *line = @"The quick brown box jumps over the lazy dog.\n";
+  NSDictionary *env;
+  NSMutableString *str;
+  NSTextStorage *ts;
+  NSLayoutManager *lm;
+  NSTextContainer *tc;
+  NSAttributedString *part;
+  NSAttributedString *loaded;
+  NSData *rtf;
+  NSDate *start;
+  NSRect used;
+  NSUInteger size, length, numGlyphs, i;
+  BOOL editsOk = YES, seeksOk = YES;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  env = [[NSProcessInfo processInfo] environment];
+  if ([env objectForKey: @"GSTEST_BENCHMARK_FILE"] != nil)
+    benchmarkFile = fopen([[env objectForKey: @"GSTEST_BENCHMARK_FILE"]
+                            fileSystemRepresentation], "a");
+  size = ([env objectForKey: @"GSTEST_TEXT_MB"] != nil
+          ? [[env objectForKey: @"GSTEST_TEXT_MB"] intValue] : 4)
+    * 1024 * 1024;
+  if (size == 0)
+    size = 1024 * 1024;
+
+  str = [NSMutableString stringWithCapacity: size];
+  while ([str length] < size)
+    [str appendString: line];
+  length = [str length];
+
+  ts = [[NSTextStorage alloc] initWithString: str];
+  lm = [NSLayoutManager new];
+  tc = [[NSTextContainer alloc] initWithContainerSize: NSMakeSize(500, 1e7)];
+  [lm addTextContainer: tc];
+  [ts addLayoutManager: lm];
+
+  start = [NSDate date];
+  numGlyphs = [lm numberOfGlyphs];
+  report("glyph-generation", start, length);
+  pass(numGlyphs > 0, "glyphs are generated for the document");
+
+  start = [NSDate date];
+  [lm ensureLayoutForTextContainer: tc];
+  used = [lm usedRectForTextContainer: tc];
+  report("full-layout", start, numGlyphs);
+  pass(NSHeight(used) > 0, "the document is laid out");
+
+  start = [NSDate date];
+  for (i = 0; i < NUM_EDITS; i++)
+    editsOk = editAt(ts, lm, 0) && editsOk;
+  report("edit-start", start, NUM_EDITS);
+
+  start = [NSDate date];
+  for (i = 0; i < NUM_EDITS; i++)
+    editsOk = editAt(ts, lm, length / 2) && editsOk;
+  report("edit-middle", start, NUM_EDITS);
+
+  start = [NSDate date];
+  for (i = 0; i < NUM_EDITS; i++)
+    editsOk = editAt(ts, lm, length - 1) && editsOk;
+  report("edit-end", start, NUM_EDITS);
+  pass(editsOk && [ts length] == length,
+       "edited lines are laid out again");
+
+  [lm ensureLayoutForTextContainer: tc];
+  used = [lm usedRectForTextContainer: tc];
+  srand(4711);
+  start = [NSDate date];
+  for (i = 0; i < NUM_SEEKS; i++)
+    {
+      NSPoint p = NSMakePoint(rand() % 500,
+                              (double)rand() / RAND_MAX * NSMaxY(used));
+      NSUInteger glyph = [lm glyphIndexForPoint: p inTextContainer: tc];
+
+      if (glyph >= numGlyphs)
+        seeksOk = NO;
+      else
+        [lm lineFragmentRectForGlyphAtIndex: glyph effectiveRange: NULL];
+    }
+  report("caret-seek", start, NUM_SEEKS);
+  pass(seeksOk, "caret seeks find a glyph");
+
+  [ts addAttribute: NSFontAttributeName
+             value: [NSFont boldSystemFontOfSize: 0]
+             range: NSMakeRange(0, length / 3)];
+  part = [ts attributedSubstringFromRange:
+    NSMakeRange(0, MIN(length, RTF_SIZE))];
+  start = [NSDate date];
+  rtf = [part RTFFromRange: NSMakeRange(0, [part length])
+        documentAttributes: nil];
+  report("rtf-save", start, [part length]);
+
+  start = [NSDate date];
+  loaded = [[NSAttributedString alloc] initWithRTF: rtf
+                                documentAttributes: NULL];
+  report("rtf-load", start, [rtf length]);
+  pass([[loaded string] isEqualToString: [part string]],
+       "RTF round trip keeps the text");
+
+  if (benchmarkFile != NULL)
+    fclose(benchmarkFile);
+  [loaded release];
+  [ts release];
+  [lm release];
+  [tc release];
+  DESTROY(arp);
+  return 0;
+}
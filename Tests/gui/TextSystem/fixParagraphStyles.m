@@ -0,0 +1,74 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that fixing the paragraph styles of a text gives each paragraph
+the style at its start, whether or not the paragraphs share a style.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSString.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSAttributedString.h>
+#import <AppKit/NSParagraphStyle.h>
+
+static NSParagraphStyle *
+styleAt(NSAttributedString *s, NSUInteger i, NSRange *r)
+{
+  return [s attribute: NSParagraphStyleAttributeName
+              atIndex: i
+longestEffectiveRange: r
+              inRange: NSMakeRange(0, [s length])];
+}
+
+int
+main(int argc, char **argv)
+{
+  NSMutableAttributedString *s;
+  NSMutableParagraphStyle *centred;
+  NSMutableParagraphStyle *right;
+  NSMutableString *text = [NSMutableString string];
+  NSUInteger i;
+  NSRange r;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+  for (i = 0; i < 100; i++)
+    [text appendString: @"A paragraph of text.\n"];
+
+  centred = AUTORELEASE([NSMutableParagraphStyle new]);
+  [centred setAlignment: NSCenterTextAlignment];
+  right = AUTORELEASE([NSMutableParagraphStyle new]);
+  [right setAlignment: NSRightTextAlignment];
+
+  s = AUTORELEASE([[NSMutableAttributedString alloc] initWithString: text]);
+  [s addAttribute: NSParagraphStyleAttributeName
+            value: centred
+            range: NSMakeRange(0, 21 * 50 + 5)];
+  [s addAttribute: NSParagraphStyleAttributeName
+            value: right
+            range: NSMakeRange(21 * 50 + 5, [s length] - 21 * 50 - 5)];
+  [s fixParagraphStyleAttributeInRange: NSMakeRange(0, [s length])];
+
+  pass([styleAt(s, 0, &r) isEqual: centred]
+       && NSEqualRanges(r, NSMakeRange(0, 21 * 51)),
+       "the paragraph where the style changes takes the style at its start");
+  pass([styleAt(s, 21 * 51, &r) isEqual: right]
+       && NSMaxRange(r) == [s length],
+       "the following paragraphs keep their style");
+
+  s = AUTORELEASE([[NSMutableAttributedString alloc] initWithString: text]);
+  [s addAttribute: NSParagraphStyleAttributeName
+            value: right
+            range: NSMakeRange(21 * 10 + 3, 2)];
+  [s fixParagraphStyleAttributeInRange: NSMakeRange(21 * 10, 21)];
+  pass([styleAt(s, 21 * 10, &r) isEqual: right]
+       && NSEqualRanges(r, NSMakeRange(21 * 10, 21)),
+       "a style set inside a paragraph covers the whole paragraph");
+  pass([styleAt(s, 0, &r) isEqual: [NSParagraphStyle defaultParagraphStyle]]
+       || styleAt(s, 0, &r) == nil,
+       "paragraphs outside the range are left alone");
+
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,94 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that a layout manager counts the glyphs it generates, the line
+fragments it lays out and reuses and its invalidations, and that the
+counts are added to the totals of all layout managers.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSDictionary.h>
+#import <Foundation/NSString.h>
+#import <Foundation/NSValue.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSLayoutManager.h>
+#import <AppKit/NSTextContainer.h>
+#import <AppKit/NSTextStorage.h>
+
+static NSUInteger
+count(NSDictionary *stats, NSString *key)
+{
+  return [[stats objectForKey: key] unsignedIntegerValue];
+}
+
+int
+main(int argc, char **argv)
+{
+  NSMutableString *str = [NSMutableString string];
+  NSTextStorage *ts;
+  NSLayoutManager *lm;
+  NSTextContainer *tc;
+  NSDictionary *stats;
+  NSUInteger laidOut, totalGlyphs, i;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  for (i = 0; i < 200; i++)
+    [str appendString: @"The quick brown box jumps over the lazy dog.\n"];
+
+  ts = [[NSTextStorage alloc] initWithString: str];
+  lm = [NSLayoutManager new];
+  tc = [[NSTextContainer alloc] initWithContainerSize: NSMakeSize(500, 1e7)];
+  [lm addTextContainer: tc];
+  [ts addLayoutManager: lm];
+
+  [lm resetLayoutStatistics];
+  [GSLayoutManager resetLayoutStatistics];
+  [lm glyphRangeForTextContainer: tc];
+  stats = [lm layoutStatistics];
+  pass(count(stats, @"GlyphsGenerated") == [lm numberOfGlyphs],
+       "every glyph generated is counted once");
+  pass(count(stats, @"RunsCreated") > 0, "created runs are counted");
+  laidOut = count(stats, @"LineFragmentsLaidOut");
+  pass(laidOut >= 200, "each line laid out is counted");
+  pass([[stats objectForKey: @"TypesetterTime"] doubleValue] > 0.0,
+       "time in the typesetter is counted");
+  pass(count(stats, @"GlyphCacheHits") + count(stats, @"GlyphCacheMisses")
+       >= [lm numberOfGlyphs],
+       "the typesetter reports its glyph cache lookups");
+  totalGlyphs = count([GSLayoutManager layoutStatistics], @"GlyphsGenerated");
+  pass(totalGlyphs == count(stats, @"GlyphsGenerated"),
+       "counts are added to the totals");
+
+  [ts replaceCharactersInRange: NSMakeRange(0, 0) withString: @"x"];
+  [lm glyphRangeForTextContainer: tc];
+  stats = [lm layoutStatistics];
+  pass(count(stats, @"SoftInvalidations") == 1,
+       "an edit at the start soft invalidates the layout after it");
+  pass(count(stats, @"LineFragmentsReused") > 0,
+       "soft invalidated line fragments are reused");
+  pass(count(stats, @"LineFragmentsLaidOut") - laidOut
+       < count(stats, @"LineFragmentsReused"),
+       "few line fragments are laid out again");
+
+  [tc setContainerSize: NSMakeSize(300, 1e7)];
+  pass(count([lm layoutStatistics], @"HardInvalidations") == 1,
+       "a change of the container geometry is a hard invalidation");
+
+  [lm resetLayoutStatistics];
+  stats = [lm layoutStatistics];
+  pass(count(stats, @"GlyphsGenerated") == 0
+       && count(stats, @"LineFragmentsLaidOut") == 0,
+       "resetting discards the counts");
+  pass(count([GSLayoutManager layoutStatistics], @"GlyphsGenerated")
+       >= totalGlyphs,
+       "resetting a layout manager keeps the totals");
+
+  RELEASE(tc);
+  RELEASE(lm);
+  RELEASE(ts);
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,58 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that the image of a text attachment is only decoded from its file
+wrapper when the attachment cell is first measured.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSData.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSBitmapImageRep.h>
+#import <AppKit/NSCell.h>
+#import <AppKit/NSFileWrapper.h>
+#import <AppKit/NSGraphics.h>
+#import <AppKit/NSTextAttachment.h>
+
+int
+main(int argc, char **argv)
+{
+  NSBitmapImageRep *bitmap;
+  NSFileWrapper *wrapper;
+  NSTextAttachment *attachment;
+  NSTextAttachmentCell *cell;
+  NSSize size;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  bitmap = AUTORELEASE([[NSBitmapImageRep alloc]
+    initWithBitmapDataPlanes: NULL
+                  pixelsWide: 12
+                  pixelsHigh: 8
+               bitsPerSample: 8
+             samplesPerPixel: 3
+                    hasAlpha: NO
+                    isPlanar: NO
+              colorSpaceName: NSDeviceRGBColorSpace
+                 bytesPerRow: 0
+                bitsPerPixel: 0]);
+  wrapper = AUTORELEASE([[NSFileWrapper alloc]
+    initRegularFileWithContents: [bitmap TIFFRepresentation]]);
+  [wrapper setPreferredFilename: @"image.tiff"];
+  attachment = AUTORELEASE([[NSTextAttachment alloc]
+    initWithFileWrapper: wrapper]);
+  cell = (NSTextAttachmentCell *)[attachment attachmentCell];
+
+  pass([cell type] != NSImageCellType,
+       "the image is not decoded when the attachment is made");
+  size = [cell cellSize];
+  pass(size.width >= 12 && size.height >= 8,
+       "the image is decoded when the cell is measured");
+  pass([cell type] == NSImageCellType && [cell image] != nil,
+       "the cell keeps the decoded image");
+
+  DESTROY(arp);
+  return 0;
+}
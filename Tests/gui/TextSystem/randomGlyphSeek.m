@@ -0,0 +1,100 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Seek randomly through a large text storage and check that glyph and
+character lookups agree with each other. This doubles as a benchmark for
+the run lookup in GSLayoutManager; the time spent on the seeks is logged.
+
+The text size defaults to 50 MB and may be changed by setting the
+GSTEST_TEXT_MB environment variable.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSDate.h>
+#import <Foundation/NSProcessInfo.h>
+#import <Foundation/NSString.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSLayoutManager.h>
+#import <AppKit/NSTextContainer.h>
+#import <AppKit/NSTextStorage.h>
+
+#define NUM_SEEKS 200000
+
+int
+main(int argc, char **argv)
+{
+  NSString *line = @"The quick brown box jumps over the lazy dog.\n";
+  NSMutableString *str;
+  NSTextStorage *ts;
+  NSLayoutManager *lm;
+  NSTextContainer *tc;
+  NSString *env;
+  NSDate *start;
+  NSUInteger size, length, numGlyphs, i;
+  BOOL glyphsOk = YES, charsOk = YES;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  env = [[[NSProcessInfo processInfo] environment]
+	  objectForKey: @"GSTEST_TEXT_MB"];
+  size = (env != nil ? [env intValue] : 50) * 1024 * 1024;
+  if (size == 0)
+    size = 1024 * 1024;
+
+  str = [NSMutableString stringWithCapacity: size];
+  while ([str length] < size)
+    [str appendString: line];
+  length = [str length];
+
+  ts = [[NSTextStorage alloc] initWithString: str];
+  lm = [NSLayoutManager new];
+  tc = [[NSTextContainer alloc] initWithContainerSize: NSMakeSize(500, 1e7)];
+  [lm addTextContainer: tc];
+  [ts addLayoutManager: lm];
+
+  srand(4711);
+
+  /* Seek while glyphs are still being generated. */
+  start = [NSDate date];
+  for (i = 0; i < 1000; i++)
+    {
+      NSUInteger c = i * (length / 1000);
+      NSRange r = [lm glyphRangeForCharacterRange: NSMakeRange(c, 1)
+			     actualCharacterRange: NULL];
+
+      if ([lm characterIndexForGlyphAtIndex: r.location] > c)
+	charsOk = NO;
+    }
+  numGlyphs = [lm numberOfGlyphs];
+  NSLog(@"Generated %lu glyphs for %lu characters in %g seconds",
+	(unsigned long)numGlyphs, (unsigned long)length,
+	-[start timeIntervalSinceNow]);
+
+  start = [NSDate date];
+  for (i = 0; i < NUM_SEEKS; i++)
+    {
+      NSUInteger g = (NSUInteger)rand() % numGlyphs;
+      NSUInteger c = [lm characterIndexForGlyphAtIndex: g];
+      NSRange r = [lm glyphRangeForCharacterRange: NSMakeRange(c, 1)
+			     actualCharacterRange: NULL];
+
+      if (c >= length)
+	charsOk = NO;
+      if (g < r.location || g >= NSMaxRange(r))
+	glyphsOk = NO;
+      [lm glyphAtIndex: g];
+    }
+  NSLog(@"%d random glyph seeks took %g seconds",
+	NUM_SEEKS, -[start timeIntervalSinceNow]);
+
+  pass(charsOk, "random seeks return valid character indexes");
+  pass(glyphsOk, "random seeks map characters back to the same glyph");
+
+  [ts release];
+  [lm release];
+  [tc release];
+  DESTROY(arp);
+  return 0;
+}
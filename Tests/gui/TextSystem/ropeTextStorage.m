@@ -0,0 +1,106 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Apply the same random edits to a text storage using the rope backing
+store and one using the default array backing store, and check that
+they keep the same characters and attributes.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSDictionary.h>
+#import <Foundation/NSString.h>
+#import <AppKit/NSTextStorage.h>
+
+#define NUM_EDITS 5000
+
+@interface NSTextStorage (Sanity)
+- (void) _sanity;
+@end
+
+static BOOL
+sameContents(NSTextStorage *a, NSTextStorage *b)
+{
+  NSUInteger length = [a length];
+  NSUInteger i;
+
+  if (length != [b length] || ![[a string] isEqualToString: [b string]])
+    return NO;
+  for (i = 0; i < length; i++)
+    {
+      if (![[a attributesAtIndex: i effectiveRange: NULL]
+	     isEqual: [b attributesAtIndex: i effectiveRange: NULL]])
+	return NO;
+    }
+  return YES;
+}
+
+int
+main(int argc, char **argv)
+{
+  NSTextStorage *rope;
+  NSTextStorage *array;
+  NSArray *attrs;
+  NSRange r;
+  NSUInteger i;
+  BOOL consistent = YES;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  attrs = [NSArray arrayWithObjects:
+    [NSDictionary dictionary],
+    [NSDictionary dictionaryWithObject: @"a" forKey: @"Key"],
+    [NSDictionary dictionaryWithObject: @"b" forKey: @"Key"],
+    nil];
+
+  rope = [[NSTextStorage allocWithBackingStore: @"Rope" zone: NULL]
+    initWithString: @"Hello world"];
+  array = [[NSTextStorage allocWithBackingStore: @"Array" zone: NULL]
+    initWithString: @"Hello world"];
+  pass([[rope string] isEqualToString: @"Hello world"],
+       "rope text storage keeps its initial string");
+
+  srand(4711);
+  for (i = 0; i < NUM_EDITS && consistent; i++)
+    {
+      NSUInteger length = [array length];
+      NSUInteger loc = length > 0 ? (NSUInteger)rand() % (length + 1) : 0;
+      NSUInteger len = (NSUInteger)rand() % 8;
+
+      if (loc + len > length)
+	len = length - loc;
+      r = NSMakeRange(loc, len);
+      if (rand() % 3 == 0 && len > 0)
+	{
+	  NSDictionary *d = [attrs objectAtIndex: rand() % [attrs count]];
+
+	  [rope setAttributes: d range: r];
+	  [array setAttributes: d range: r];
+	}
+      else
+	{
+	  NSString *s = [@"abcdefghij" substringToIndex: rand() % 10];
+
+	  if (length > 200)
+	    s = @"";
+	  [rope replaceCharactersInRange: r withString: s];
+	  [array replaceCharactersInRange: r withString: s];
+	}
+      [rope _sanity];
+      if (i % 50 == 0)
+	consistent = sameContents(rope, array);
+    }
+  pass(consistent && sameContents(rope, array),
+       "rope text storage matches array text storage after random edits");
+
+  r = NSMakeRange(0, [rope length]);
+  [rope replaceCharactersInRange: r withString: @""];
+  pass([rope length] == 0, "rope text storage can be emptied");
+  [rope replaceCharactersInRange: NSMakeRange(0, 0) withString: @"xyz"];
+  pass([[rope string] isEqualToString: @"xyz"],
+       "rope text storage accepts text after being emptied");
+
+  [rope release];
+  [array release];
+  DESTROY(arp);
+  return 0;
+}
@@ -0,0 +1,89 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that temporary attributes keep their place across edits to the
+text storage, and that characters inserted into or next to a highlighted
+range don't get its temporary attributes.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSString.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSAttributedString.h>
+#import <AppKit/NSColor.h>
+#import <AppKit/NSLayoutManager.h>
+#import <AppKit/NSTextContainer.h>
+#import <AppKit/NSTextStorage.h>
+
+static BOOL
+highlighted(NSLayoutManager *lm, NSUInteger index)
+{
+  return [lm temporaryAttribute: NSBackgroundColorAttributeName
+	       atCharacterIndex: index
+		 effectiveRange: NULL] != nil;
+}
+
+int
+main(int argc, char **argv)
+{
+  NSTextStorage *ts;
+  NSLayoutManager *lm;
+  NSTextContainer *tc;
+  NSRange r;
+  id value;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  ts = [[NSTextStorage alloc] initWithString: @"0123456789abcdefghij"];
+  lm = [NSLayoutManager new];
+  tc = [[NSTextContainer alloc] initWithContainerSize: NSMakeSize(500, 1e7)];
+  [lm addTextContainer: tc];
+  [ts addLayoutManager: lm];
+
+  [lm addTemporaryAttribute: NSBackgroundColorAttributeName
+		      value: [NSColor yellowColor]
+	  forCharacterRange: NSMakeRange(10, 5)];
+  value = [lm temporaryAttribute: NSBackgroundColorAttributeName
+		atCharacterIndex: 12
+		  effectiveRange: &r];
+  pass(value != nil && NSEqualRanges(r, NSMakeRange(10, 5)),
+       "temporary attribute covers the range it was added to");
+  [lm temporaryAttribute: NSBackgroundColorAttributeName
+	atCharacterIndex: 3
+	  effectiveRange: &r];
+  pass(NSEqualRanges(r, NSMakeRange(0, 10)),
+       "effective range of unhighlighted text ends at the highlight");
+
+  [ts replaceCharactersInRange: NSMakeRange(0, 0) withString: @"xyz"];
+  pass(!highlighted(lm, 12) && highlighted(lm, 13) && highlighted(lm, 17)
+       && !highlighted(lm, 18),
+       "temporary attributes move with text inserted before them");
+
+  [ts replaceCharactersInRange: NSMakeRange(15, 0) withString: @"--"];
+  pass(highlighted(lm, 14) && !highlighted(lm, 15) && !highlighted(lm, 16)
+       && highlighted(lm, 17) && highlighted(lm, 19),
+       "text inserted into a highlight is not highlighted");
+
+  [ts replaceCharactersInRange: NSMakeRange(15, 2) withString: @""];
+  [lm temporaryAttribute: NSBackgroundColorAttributeName
+	atCharacterIndex: 15
+	  effectiveRange: &r];
+  pass(NSEqualRanges(r, NSMakeRange(13, 5)),
+       "deleting the inserted text joins the highlight again");
+
+  [lm removeTemporaryAttribute: NSBackgroundColorAttributeName
+	     forCharacterRange: NSMakeRange(0, [ts length])];
+  [lm temporaryAttribute: NSBackgroundColorAttributeName
+	atCharacterIndex: 0
+	  effectiveRange: &r];
+  pass(NSEqualRanges(r, NSMakeRange(0, [ts length])),
+       "removing temporary attributes leaves no highlight");
+
+  [ts release];
+  [lm release];
+  [tc release];
+  DESTROY(arp);
+  return 0;
+}
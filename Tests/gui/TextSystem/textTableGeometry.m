@@ -0,0 +1,83 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that the cells of a text table are placed in their columns, and
+that the columns follow changes to the table.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSTextTable.h>
+
+int
+main(int argc, char **argv)
+{
+  NSTextTable *table;
+  NSTextTableBlock *cell;
+  NSTextTableBlock *wide;
+  NSRect rect = NSMakeRect(0, 0, 400, 1000);
+  NSRect r;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+  table = AUTORELEASE([NSTextTable new]);
+  [table setNumberOfColumns: 4];
+  cell = AUTORELEASE([[NSTextTableBlock alloc] initWithTable: table
+                                                 startingRow: 0
+                                                     rowSpan: 1
+                                              startingColumn: 1
+                                                  columnSpan: 1]);
+  wide = AUTORELEASE([[NSTextTableBlock alloc] initWithTable: table
+                                                 startingRow: 1
+                                                     rowSpan: 1
+                                              startingColumn: 2
+                                                  columnSpan: 2]);
+
+  r = [cell rectForLayoutAtPoint: NSMakePoint(0, 20)
+                          inRect: rect
+                   textContainer: nil
+                  characterRange: NSMakeRange(0, 1)];
+  pass(NSEqualRects(r, NSMakeRect(100, 20, 100, 980)),
+       "a cell fills its column");
+
+  r = [wide rectForLayoutAtPoint: NSMakePoint(0, 40)
+                          inRect: rect
+                   textContainer: nil
+                  characterRange: NSMakeRange(0, 1)];
+  pass(NSEqualRects(r, NSMakeRect(200, 40, 200, 960)),
+       "a cell spanning two columns fills both");
+
+  [wide setWidth: 5 type: NSTextBlockAbsoluteValueType
+        forLayer: NSTextBlockPadding];
+  r = [wide rectForLayoutAtPoint: NSMakePoint(0, 40)
+                          inRect: rect
+                   textContainer: nil
+                  characterRange: NSMakeRange(0, 1)];
+  pass(NSEqualRects(r, NSMakeRect(205, 45, 190, 950)),
+       "the padding of a cell is left around its text");
+  r = [wide boundsRectForContentRect: NSMakeRect(205, 45, 50, 20)
+                              inRect: rect
+                       textContainer: nil
+                      characterRange: NSMakeRange(0, 1)];
+  pass(NSEqualRects(r, NSMakeRect(200, 40, 200, 30)),
+       "the bounds of a cell span its columns");
+
+  [table setNumberOfColumns: 2];
+  r = [cell rectForLayoutAtPoint: NSMakePoint(0, 20)
+                          inRect: rect
+                   textContainer: nil
+                  characterRange: NSMakeRange(0, 1)];
+  pass(NSEqualRects(r, NSMakeRect(200, 20, 200, 980)),
+       "the columns follow the number of columns");
+
+  r = [cell rectForLayoutAtPoint: NSMakePoint(0, 20)
+                          inRect: NSMakeRect(0, 0, 200, 1000)
+                   textContainer: nil
+                  characterRange: NSMakeRange(0, 1)];
+  pass(NSEqualRects(r, NSMakeRect(100, 20, 100, 980)),
+       "the columns follow the width of the table");
+
+  DESTROY(arp);
+  return 0;
+}
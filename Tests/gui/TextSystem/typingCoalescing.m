@@ -0,0 +1,129 @@
+/*
+copyright 2026 Free Software Foundation, Inc.
+
+Check that key downs already queued when a text view gets a key down
+are typed with a single change, with the same text and undo as typing
+them one by one, and that a delegate vetting changes sees each of them.
+*/
+
+#import "Testing.h"
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSNotification.h>
+#import <Foundation/NSString.h>
+#import <Foundation/NSUndoManager.h>
+#import <AppKit/NSApplication.h>
+#import <AppKit/NSEvent.h>
+#import <AppKit/NSTextView.h>
+#import <AppKit/NSWindow.h>
+
+@interface Counter : NSObject
+{
+@public
+  int changes;
+  int vetted;
+}
+@end
+
+@implementation Counter
+- (void) textDidChange: (NSNotification *)n
+{
+  changes++;
+}
+@end
+
+@interface Vetter : Counter
+@end
+
+@implementation Vetter
+- (BOOL) textView: (NSTextView *)tv
+shouldChangeTextInRange: (NSRange)range
+replacementString: (NSString *)string
+{
+  vetted++;
+  return YES;
+}
+@end
+
+static NSEvent *
+key(NSWindow *window, NSString *chars)
+{
+  return [NSEvent keyEventWithType: NSKeyDown
+			  location: NSZeroPoint
+		     modifierFlags: 0
+			 timestamp: 0
+		      windowNumber: [window windowNumber]
+			   context: nil
+			characters: chars
+       charactersIgnoringModifiers: chars
+			 isARepeat: NO
+			   keyCode: 0];
+}
+
+static void
+type(NSWindow *window, NSTextView *tv)
+{
+  [NSApp postEvent: key(window, @"b") atStart: NO];
+  [NSApp postEvent: key(window, @"c") atStart: NO];
+  [tv keyDown: key(window, @"a")];
+}
+
+int
+main(int argc, char **argv)
+{
+  NSWindow *window;
+  NSTextView *tv;
+  Counter *counter;
+  Vetter *vetter;
+  NSUndoManager *undo;
+  NSEvent *e;
+  CREATE_AUTORELEASE_POOL(arp);
+
+  [NSApplication sharedApplication];
+
+  window = [[NSWindow alloc] initWithContentRect: NSMakeRect(100, 100, 200, 200)
+				       styleMask: NSBorderlessWindowMask
+					 backing: NSBackingStoreBuffered
+					   defer: NO];
+  tv = [[NSTextView alloc] initWithFrame: NSMakeRect(0, 0, 200, 200)];
+  [tv setAllowsUndo: YES];
+  [window setContentView: tv];
+  [window makeFirstResponder: tv];
+  undo = [tv undoManager];
+  [undo setGroupsByEvent: NO];
+
+  counter = [Counter new];
+  [tv setDelegate: (id)counter];
+  [undo beginUndoGrouping];
+  type(window, tv);
+  [undo endUndoGrouping];
+  pass([[tv string] isEqualToString: @"abc"],
+       "queued key downs are typed in order");
+  testHopeful = YES;
+  pass(counter->changes == 1, "queued key downs are typed with one change");
+  testHopeful = NO;
+  [undo undo];
+  pass([[tv string] length] == 0, "the typing is undone at once");
+
+  vetter = [Vetter new];
+  [tv setDelegate: (id)vetter];
+  type(window, tv);
+  pass(vetter->vetted == 1 && [[tv string] isEqualToString: @"a"],
+       "queued key downs are left alone with a vetting delegate");
+  while ((e = [NSApp nextEventMatchingMask: NSKeyDownMask
+				 untilDate: nil
+				    inMode: NSDefaultRunLoopMode
+				   dequeue: YES]) != nil)
+    {
+      [tv keyDown: e];
+    }
+  pass(vetter->vetted == 3 && [[tv string] isEqualToString: @"abc"],
+       "a vetting delegate sees each key down");
+  [tv setDelegate: nil];
+
+  RELEASE(vetter);
+  RELEASE(counter);
+  RELEASE(tv);
+  RELEASE(window);
+  DESTROY(arp);
+  return 0;
+}
@@ -33,7 +33,8 @@
 @class NSMutableArray;
 @class NSMutableAttributedString;
 
-@interface RTFConsumer: NSObject <GSTextConsumer>
+@interface RTFConsumer: NSObject <GSTextConsumer, GSStreamingTextConsumer,
+  GSFileWrapperTextConsumer>
 {
 @public
   NSStringEncoding encoding;
@@ -44,6 +45,7 @@
   NSMutableAttributedString *result;
   Class _class;
   int ignore;
+  BOOL cancelled;
 }
 
 @end
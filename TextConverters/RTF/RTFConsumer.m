@@ -54,6 +54,72 @@ readString (StringContext *ctxt)
   return ctxt->position < ctxt->length ? ctxt->string[ctxt->position++] : EOF;
 }
 
+/* and with one reading chunks from a stream */
+#define STREAM_BUFFER_SIZE	65536
+
+typedef struct {
+  NSInputStream			*stream;
+  NSMutableAttributedString	*target;
+  BOOL				*cancelled;
+  NSInteger			position;
+  NSInteger			length;
+  unsigned char			buffer[STREAM_BUFFER_SIZE];
+} StreamContext;
+
+static BOOL
+fillStreamContext (StreamContext *ctxt)
+{
+  NSInteger	n;
+
+  if (*ctxt->cancelled)
+    {
+      return NO;
+    }
+  n = [ctxt->stream read: ctxt->buffer maxLength: STREAM_BUFFER_SIZE];
+  ctxt->position = 0;
+  ctxt->length = (n > 0) ? n : 0;
+  return ctxt->length > 0;
+}
+
+static int
+readStream (StreamContext *ctxt)
+{
+  if (ctxt->position >= ctxt->length)
+    {
+      /* Let the target process the text read so far, so that a text
+       * storage shows the document while it is being read.
+       */
+      [ctxt->target endEditing];
+      [ctxt->target beginEditing];
+      if (!fillStreamContext(ctxt))
+	{
+	  return EOF;
+	}
+    }
+  return ctxt->buffer[ctxt->position++];
+}
+
+/* The encoding is given by the character set keyword following {\rtf1 */
+static NSStringEncoding
+encodingForHeader (const char *header)
+{
+  if (strncmp(header + 7, "mac", 3) == 0)
+    {
+      return NSMacOSRomanStringEncoding;
+    }
+  else if (strncmp(header + 7, "pc", 2) == 0)
+    {
+      // FIXME: Code page 437 kCFStringEncodingDOSLatinUS
+      return NSISOLatin1StringEncoding;
+    }
+  else if (strncmp(header + 7, "pca", 3) == 0)
+    {
+      // FIXME: Code page 850 kCFStringEncodingDOSLatin1
+      return NSISOLatin1StringEncoding;
+    }
+  return NSISOLatin1StringEncoding;
+}
+
 // Hold the attributs of the current run
 @interface RTFAttribute: NSObject <NSCopying>
 {
@@ -390,6 +456,7 @@ static BOOL classInheritsFromNSMutableAttributedString (Class c)
   attrs = nil;
   colours = nil;
   _class = Nil;
+  cancelled = NO;
 
   return self;
 }
@@ -475,21 +542,17 @@ static BOOL classInheritsFromNSMutableAttributedString (Class c)
       
       if (wrapper != nil)
         {
-          NSImage* image = [[NSImage alloc] initWithData: [wrapper regularFileContents]];
           NSTextAttachment* attachment;
           RTFAttribute* attr = [self attr];
           NSMutableDictionary* attributes = nil;
           NSMutableAttributedString* str = nil;
 
-          if (image != nil)
-            {
-              [wrapper setIcon: image];
-            }
+          /* The image is only read and decoded when the attachment
+             cell is first measured or drawn.  */
           attachment = [[NSTextAttachment alloc] initWithFileWrapper: wrapper];
           if (attachment == nil)
             {
               NSLog(@"No attachment at %d", oldPosition);
-              RELEASE(image);
               return;
             }
         
@@ -508,7 +571,6 @@ static BOOL classInheritsFromNSMutableAttributedString (Class c)
           attr->changed = YES;
           RELEASE(attributes);
           RELEASE(attachment);
-          RELEASE(image);
         }
     }
 }
@@ -574,7 +636,7 @@ static BOOL classInheritsFromNSMutableAttributedString (Class c)
   CREATE_AUTORELEASE_POOL(pool);
   RTFscannerCtxt scanner;
   StringContext stringCtxt;
-  char buffer[5];
+  char buffer[10];
 
   // We read in the first few characters to find out which
   // encoding we have
@@ -583,26 +645,8 @@ static BOOL classInheritsFromNSMutableAttributedString (Class c)
       // Too short to be an RTF
       return nil;
     }
-  [rtfData getBytes: buffer range: NSMakeRange(7, 3)];
-  if (strncmp(buffer, "mac", 3) == 0)
-    {
-      encoding = NSMacOSRomanStringEncoding;
-    }
-  else if (strncmp(buffer, "pc", 2) == 0)
-    {
-      // FIXME: Code page 437 kCFStringEncodingDOSLatinUS
-      encoding = NSISOLatin1StringEncoding;
-    }
-  else if (strncmp(buffer, "pca", 3) == 0)
-    {
-      // FIXME: Code page 850 kCFStringEncodingDOSLatin1
-      encoding = NSISOLatin1StringEncoding;
-    }
-  else
-    {
-      encoding = NSISOLatin1StringEncoding;
-    }
-
+  [rtfData getBytes: buffer range: NSMakeRange(0, 10)];
+  encoding = encodingForHeader(buffer);
 
   // Reset this RFTConsumer, as it might already have been used!
   _class = class;
@@ -639,6 +683,108 @@ static BOOL classInheritsFromNSMutableAttributedString (Class c)
     }
 }
 
+- (BOOL) parseStream: (NSInputStream *)stream
+intoAttributedString: (NSMutableAttributedString *)target
+  documentAttributes: (NSDictionary **)dict
+	       error: (NSError **)error
+{
+  CREATE_AUTORELEASE_POOL(pool);
+  RTFscannerCtxt scanner;
+  StreamContext *streamCtxt;
+  BOOL ok = YES;
+
+  /* The context holds the read buffer, so keep it off the stack. */
+  streamCtxt = NSZoneMalloc(NSDefaultMallocZone(), sizeof(StreamContext));
+  streamCtxt->stream = stream;
+  streamCtxt->target = target;
+  streamCtxt->cancelled = &cancelled;
+  streamCtxt->position = 0;
+  streamCtxt->length = 0;
+  cancelled = NO;
+
+  if ([stream streamStatus] == NSStreamStatusNotOpen)
+    {
+      [stream open];
+    }
+  // Read far enough to find out which encoding we have
+  while (streamCtxt->length < 10)
+    {
+      NSInteger n = [stream read: streamCtxt->buffer + streamCtxt->length
+		       maxLength: STREAM_BUFFER_SIZE - streamCtxt->length];
+
+      if (n <= 0)
+	break;
+      streamCtxt->length += n;
+    }
+  if (streamCtxt->length < 10)
+    {
+      // Too short to be an RTF
+      NSZoneFree(NSDefaultMallocZone(), streamCtxt);
+      RELEASE(pool);
+      if (error)
+	{
+	  *error = [NSError errorWithDomain: @"RTFConsumer"
+				       code: 0
+				   userInfo: nil];
+	}
+      return NO;
+    }
+  encoding = encodingForHeader((const char *)streamCtxt->buffer);
+
+  _class = [target class];
+  [self reset];
+  ASSIGN(result, target);
+
+  lexInitContext(&scanner, streamCtxt, (int (*)(void*))readStream);
+  [result beginEditing];
+  NS_DURING
+    GSRTFparse((void *)self, &scanner);
+  NS_HANDLER
+    NSLog(@"Problem during RTF Parsing: %@", 
+	  [localException reason]);
+    ok = NO;
+  NS_ENDHANDLER
+  [result endEditing];
+  NSZoneFree(NSDefaultMallocZone(), streamCtxt);
+  DESTROY(result);
+
+  if (cancelled)
+    {
+      ok = NO;
+      if (error)
+	{
+	  *error = [NSError errorWithDomain: NSCocoaErrorDomain
+				       code: NSUserCancelledError
+				   userInfo: nil];
+	}
+    }
+  else if (!ok && error)
+    {
+      *error = [NSError errorWithDomain: @"RTFConsumer"
+				   code: 0
+			       userInfo: nil];
+    }
+  if (error && *error)
+    {
+      RETAIN(*error);
+    }
+  RELEASE(pool);
+  if (error && *error)
+    {
+      AUTORELEASE(*error);
+    }
+  if (dict)
+    {
+      *dict = [self documentAttributes];
+    }
+  return ok;
+}
+
+- (void) cancel
+{
+  cancelled = YES;
+}
+
 - (void) appendString: (NSString*)string
 {
   int  oldPosition = [result length];
@@ -54,16 +54,19 @@
 - (NSDictionary *)_attributesOfLastRun;
 - (void)_setAttributesOfLastRun: (NSDictionary *)aDict;
 
-- (NSString *)_runStringForString: (NSString *)substring
-                       attributes: (NSDictionary *)attributes;
+- (NSString *)_deltaStringForAttributes: (NSDictionary *)attributes;
+- (void)_appendRTFCharacters: (const unichar *)buffer
+                      length: (NSUInteger)length
+                      toData: (NSMutableData *)resultData;
 
 - (NSString *)_ASCIIfiedString: (NSString *)string;
 - (NSString *)_headerString;
 - (NSString *)_trailerString;
-- (NSString *)_bodyString;
-- (NSString *)_RTFDStringFromAttributedString: (NSAttributedString *)aText
-                           documentAttributes: (NSDictionary *)dict
-                               inlineGraphics: (BOOL)inlineGraphics;
+- (void)_registerFontsAndColors;
+- (void)_appendBodyToData: (NSMutableData *)data;
+- (NSData *)_RTFDDataFromAttributedString: (NSAttributedString *)aText
+                       documentAttributes: (NSDictionary *)dict
+                           inlineGraphics: (BOOL)inlineGraphics;
 @end
 
 @implementation RTFDProducer
@@ -78,10 +81,9 @@
 
   producer = [[self alloc] init];
 
-  encodedText = [[producer _RTFDStringFromAttributedString: aText
-                                        documentAttributes: dict
-                                            inlineGraphics: NO]
-                   dataUsingEncoding: NSASCIIStringEncoding];
+  encodedText = [producer _RTFDDataFromAttributedString: aText
+                                     documentAttributes: dict
+                                         inlineGraphics: NO];
 
 //  if ([aText containsAttachments])
   if (YES)
@@ -182,10 +184,9 @@
   NSData *data;
 
   producer = [[self alloc] init];
-  data = [[producer _RTFDStringFromAttributedString: aText
-                                 documentAttributes: dict
-                                     inlineGraphics: YES]
-            dataUsingEncoding: NSASCIIStringEncoding];
+  data = [producer _RTFDDataFromAttributedString: aText
+                              documentAttributes: dict
+                                  inlineGraphics: YES];
 
   RELEASE(producer);
 
@@ -398,7 +399,7 @@
 
 - (NSString *)_headerString
 /*" It is essential that before this method is called the method
--_bodyString is called! "*/
+-_registerFontsAndColors is called! "*/
 {
   NSMutableString *result;
 
@@ -723,25 +724,13 @@
   return result;
 }
 
-- (NSString *)_stringWithRTFCharacters: (NSString *)string
+- (void)_appendRTFCharacters: (const unichar *)buffer
+                      length: (NSUInteger)length
+                      toData: (NSMutableData *)resultData
 {
-  NSString *result;
-  NSMutableData *resultData;
-  unichar *buffer;
-  int length, i;
+  NSUInteger i;
   BOOL uc_flagged = NO;
 
-  if (string == nil)
-    {
-      return nil;
-    }
-  
-  length = [string length];
-  buffer = NSZoneCalloc([self zone], length, sizeof(unichar));
-  [string getCharacters: buffer];
-  resultData = [[NSMutableData alloc]
-                               initWithCapacity: (int)(length * 1.2)];
-
   for (i = 0; i < length; i++)
     {
       unichar c;
@@ -815,13 +804,6 @@
                            length: strlen(unicodeCommand)];       
         }
     }
-
-  NSZoneFree([self zone], buffer);
-  result = AUTORELEASE([[NSString alloc] initWithData: resultData
-					 encoding: NSASCIIStringEncoding]);
-  RELEASE(resultData);
-
-  return result;
 }
 
 - (NSString *)_ASCIIfiedString: (NSString *)string;
@@ -1126,16 +1108,14 @@
   return result;
 }
 
-- (NSString *)_runStringForString: (NSString *)string
-                       attributes: (NSDictionary *)attributes
+- (NSString *)_deltaStringForAttributes: (NSDictionary *)attributes
 {
   NSMutableString *result;
   NSMutableDictionary *attributesToAdd, *attributesToRemove;
   NSEnumerator *enumerator;
   NSString *attributeName;
 
-  result = (NSMutableString *)[NSMutableString stringWithCapacity:
-                                            [string length] + 15];
+  result = (NSMutableString *)[NSMutableString stringWithCapacity: 15];
   attributesToAdd = [[NSMutableDictionary alloc] init];
   attributesToRemove = [[self _attributesOfLastRun] mutableCopy];
 
@@ -1183,26 +1163,65 @@
         }
     }
 
-  [result appendString: [self _stringWithRTFCharacters: string]];
-
   return result;
 }
 
-- (NSString *)_bodyString
+/*
+ * Register all fonts and colours used in the text before the body is
+ * written, so that the header with the font and colour tables can be
+ * written first.
+ */
+- (void)_registerFontsAndColors
+{
+  unsigned length = [text length];
+  NSRange effectiveRange = NSMakeRange(0, 0);
+
+  while (NSMaxRange(effectiveRange) < length)
+    {
+      NSDictionary *attributes;
+      NSFont *font;
+      NSColor *color;
+
+      attributes = [text attributesAtIndex: NSMaxRange(effectiveRange)
+                            effectiveRange: &effectiveRange];
+      if ((font = [attributes objectForKey: NSFontAttributeName]))
+        {
+          [self fontToken: [font familyName]];
+        }
+      color = [attributes objectForKey: NSForegroundColorAttributeName];
+      if (color && ! [color isEqual: fgColor])
+        {
+          [self numberForColor: color];
+        }
+      color = [attributes objectForKey: NSBackgroundColorAttributeName];
+      if (color && ! [color isEqual: bgColor])
+        {
+          [self numberForColor: color];
+        }
+      color = [attributes objectForKey: NSUnderlineColorAttributeName];
+      if (color)
+        {
+          [self numberForColor: color];
+        }
+    }
+}
+
+- (void)_appendBodyToData: (NSMutableData *)data
 {
   NSString *string;
-  NSMutableString *result;
   unsigned length;
   NSRange effectiveRange;
+  unichar *buffer = NULL;
+  NSUInteger bufferSize = 0;
 
   string = [text string];
-  result = (NSMutableString *)[NSMutableString string];
   length = [string length];
   effectiveRange = NSMakeRange(0, 0);
 
   while (effectiveRange.location < length)
     {
       NSDictionary *attributes;
+      NSData *delta;
       CREATE_AUTORELEASE_POOL(pool);
 
       attributes = [text attributesAtIndex: effectiveRange.location
@@ -1211,9 +1230,21 @@
                                                        length
                                                     - effectiveRange.location)];
 
-      [result appendString: [self _runStringForString:
-                           [string substringWithRange: effectiveRange]
-                                           attributes: attributes]];
+      delta = [[self _deltaStringForAttributes: attributes]
+                dataUsingEncoding: NSASCIIStringEncoding
+                allowLossyConversion: YES];
+      [data appendData: delta];
+
+      if (effectiveRange.length > bufferSize)
+        {
+          bufferSize = effectiveRange.length;
+          buffer = NSZoneRealloc([self zone], buffer,
+                                 bufferSize * sizeof(unichar));
+        }
+      [string getCharacters: buffer range: effectiveRange];
+      [self _appendRTFCharacters: buffer
+                          length: effectiveRange.length
+                          toData: data];
 
       effectiveRange = NSMakeRange(NSMaxRange(effectiveRange), 0);
 
@@ -1222,35 +1253,52 @@
       [pool drain];
     }
 
+  if (buffer != NULL)
+    {
+      NSZoneFree([self zone], buffer);
+    }
   [self _setAttributesOfLastRun: nil]; // cleanup, should be unneccessary
-
-  return result;
 }
 
-- (NSString *)_RTFDStringFromAttributedString: (NSAttributedString *)aText
-                           documentAttributes: (NSDictionary *)dict
-                               inlineGraphics: (BOOL)inlineGraphics
+- (NSData *)_RTFDDataFromAttributedString: (NSAttributedString *)aText
+                       documentAttributes: (NSDictionary *)dict
+                           inlineGraphics: (BOOL)inlineGraphics
 {
-  NSMutableString *output;
-  NSString *headerString;
-  NSString *trailerString;
-  NSString *bodyString;
+  NSMutableData *output;
+  NSData *header;
+  unsigned fontCount, colorCount;
 
   ASSIGN(text, aText);
   ASSIGN(docDict, dict);
 
-  output = (NSMutableString *)[NSMutableString string];
+  output = [NSMutableData dataWithCapacity: [aText length] + 1024];
   _inlineGraphics = inlineGraphics;
+
+  [self _registerFontsAndColors];
+  fontCount = [fontDict count];
+  colorCount = [colorDict count];
+
+  header = [[self _headerString] dataUsingEncoding: NSASCIIStringEncoding
+                                   allowLossyConversion: YES];
+  [output appendData: header];
+  [self _appendBodyToData: output];
+  [output appendData: [[self _trailerString]
+                        dataUsingEncoding: NSASCIIStringEncoding]];
+
   /*
-   * do not change order! (esp. body has to be generated first; builds context)
+   * Attributes not seen by -_registerFontsAndColors may have added fonts
+   * or colours while writing the body; the header must then be rewritten.
    */
-  bodyString = [self _bodyString];
-  trailerString = [self _trailerString];
-  headerString = [self _headerString];
+  if ([fontDict count] != fontCount || [colorDict count] != colorCount)
+    {
+      NSData *newHeader;
 
-  [output appendString: headerString];
-  [output appendString: bodyString];
-  [output appendString: trailerString];
+      newHeader = [[self _headerString] dataUsingEncoding: NSASCIIStringEncoding
+                                      allowLossyConversion: YES];
+      [output replaceBytesInRange: NSMakeRange(0, [header length])
+                        withBytes: [newHeader bytes]
+                           length: [newHeader length]];
+    }
 
   return output;
 }
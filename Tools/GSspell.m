@@ -87,12 +87,62 @@
 }
 @end
 
+// The private method of the server which NSSpellChecker calls for each
+// misspelling, and the one which finds all of them in one message.
+
+@interface NSSpellServer (PrivateMethods)
+- (NSRange) _findMisspelledWordInString: (NSString *)stringToCheck
+			       language: (NSString *)language
+			   ignoredWords: (NSArray *)ignoredWords
+			      wordCount: (NSInteger *)wordCount
+			      countOnly: (BOOL)countOnly;
+@end
+
+@interface NSSpellServer (BatchedChecking)
+- (bycopy NSArray *) _findMisspelledWordRangesInString: (bycopy NSString *)string
+					      language: (NSString *)language
+					  ignoredWords: (NSArray *)ignoredWords;
+@end
+
+@implementation NSSpellServer (BatchedChecking)
+/* Returns the ranges of all the misspelled words of string, so that a
+   paragraph costs the client one message instead of one per misspelling
+   and a last one to find there is none left.  */
+- (bycopy NSArray *) _findMisspelledWordRangesInString: (bycopy NSString *)string
+					      language: (NSString *)language
+					  ignoredWords: (NSArray *)ignoredWords
+{
+  NSMutableArray *ranges = [NSMutableArray array];
+  NSUInteger length = [string length];
+  NSUInteger start = 0;
+
+  while (start < length)
+    {
+      NSInteger count = 0;
+      NSRange r;
+
+      r = [self _findMisspelledWordInString: [string substringFromIndex: start]
+				   language: language
+			       ignoredWords: ignoredWords
+				  wordCount: &count
+				  countOnly: NO];
+      if (r.location == NSNotFound || r.length == 0)
+	break;
+      r.location += start;
+      [ranges addObject: [NSValue valueWithRange: r]];
+      start = NSMaxRange(r);
+    }
+  return ranges;
+}
+@end
+
 // The base class.  Its spell checker just provides a dumb spell checker
 // for American English as fallback if aspell is not available.
 
 @interface GNUSpellChecker : NSObject
 - (BOOL) registerLanguagesWithServer: (NSSpellServer *)aServer;
 - (NSArray *) languages;
+- (void) preloadLanguage: (NSString *)language;
 @end
 
 @implementation GNUSpellChecker
@@ -124,6 +174,12 @@
   return [NSArray arrayWithObject: @"AmericanEnglish"];
 }
 
+/* Loads what checking the spelling of language needs, so that the first
+   request does not have to wait for it.  */
+- (void) preloadLanguage: (NSString *)language
+{
+}
+
 - (BOOL) createBundleAtPath: (NSString *)path languages: (NSArray *)languages
 {
   NSDictionary *infoDict, *serviceDict;
@@ -377,6 +433,14 @@ aspell_dictionaries()
   return speller;
 }
 
+- (void) preloadLanguage: (NSString *)language
+{
+  if ([dictionaries objectForKey: language] != nil)
+    {
+      [self documentCheckerForLanguage: language];
+    }
+}
+
 - (AspellDocumentChecker *) documentCheckerForLanguage: (NSString *)language
 {
   AspellDocumentChecker *checker =
@@ -526,7 +590,16 @@ int main(int argc, char** argv)
   [aSpellChecker synchronizeLanguages];
   if ([aSpellChecker registerLanguagesWithServer: aServer])
     {
+      NSArray *userLanguages = [[NSUserDefaults standardUserDefaults]
+				 stringArrayForKey: @"NSLanguages"];
+
       [aServer setDelegate: aSpellChecker];
+      /* Load the dictionary of the user's language while starting up,
+	 rather than when the first word is checked.  */
+      if ([userLanguages count] > 0)
+	{
+	  [aSpellChecker preloadLanguage: [userLanguages objectAtIndex: 0]];
+	}
       NSLog(@"Spell server started and waiting.");
       [aServer run];
       NSLog(@"Unexpected death of spell checker");
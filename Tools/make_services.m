@@ -40,6 +40,8 @@
 #import <Foundation/NSAutoreleasePool.h>
 #import <Foundation/NSPathUtilities.h>
 #import <Foundation/NSSerialization.h>
+#import <Foundation/NSPropertyList.h>
+#import <Foundation/NSValue.h>
 
 static void scanApplications(NSMutableDictionary *services, NSString *path);
 static void scanServices(NSMutableDictionary *services, NSString *path);
@@ -49,6 +51,7 @@ static NSMutableDictionary *validateService(NSDictionary *service, NSString* pat
 
 static NSString		*appsName = @".GNUstepAppList";
 static NSString		*cacheName = @".GNUstepServices";
+static NSString		*manifestName = @".GNUstepScanManifest";
 
 static	int verbose = 1;
 static	NSMutableDictionary	*serviceMap;
@@ -59,6 +62,10 @@ static	NSMutableDictionary	*spellMap;
 static	NSMutableDictionary	*applicationMap;
 static	NSMutableDictionary	*extensionsMap;
 static	NSMutableDictionary	*schemesMap;
+static	NSDictionary		*oldManifest;
+static	NSMutableDictionary	*newManifest;
+static	unsigned		reused;
+static	unsigned		rescanned;
 
 static Class aClass;
 static Class dClass;
@@ -83,6 +90,127 @@ static BOOL CheckDirectory(NSString *path, NSError **error)
     }
 }
 
+/*
+ *	Returns the latest modification date of the file or bundle at path,
+ *	looking at the places an info property list may be found in a
+ *	bundle, or nil if there is nothing at path.
+ */
+static NSNumber *
+fileStamp(NSString *path)
+{
+  static NSString	*names[] = {
+    @"",
+    @"Info-gnustep.plist",
+    @"Info.plist",
+    @"Resources",
+    @"Resources/Info-gnustep.plist",
+    @"Resources/Info.plist",
+    @"Contents",
+    @"Contents/Info.plist",
+    nil
+  };
+  NSFileManager		*mgr = [NSFileManager defaultManager];
+  NSTimeInterval	latest = 0.0;
+  BOOL			found = NO;
+  unsigned		i;
+
+  for (i = 0; names[i] != nil; i++)
+    {
+      NSString		*p = path;
+      NSDictionary	*attr;
+
+      if ([names[i] length] > 0)
+	{
+	  p = [path stringByAppendingPathComponent: names[i]];
+	}
+      attr = [mgr fileAttributesAtPath: p traverseLink: YES];
+      if (attr != nil)
+	{
+	  NSTimeInterval	t;
+
+	  t = [[attr fileModificationDate] timeIntervalSinceReferenceDate];
+	  if (found == NO || t > latest)
+	    {
+	      latest = t;
+	    }
+	  found = YES;
+	}
+      else if (i == 0)
+	{
+	  return nil;
+	}
+    }
+  return [NSNumber numberWithDouble: latest];
+}
+
+/*
+ *	Returns the parts of the info dictionary of the bundle (or the
+ *	property list file) at path which we use.  If the path has not been
+ *	modified since the last run, they are taken from the manifest of that
+ *	run rather than by reading and parsing the property list again.
+ *	Either way they are noted in the manifest for the next run.
+ */
+static NSDictionary *
+infoAtPath(NSString *path, BOOL isBundle)
+{
+  static NSArray	*keys = nil;
+  NSNumber		*stamp = fileStamp(path);
+  NSDictionary		*entry = [oldManifest objectForKey: path];
+  NSMutableDictionary	*info;
+  NSDictionary		*full;
+  unsigned		i;
+
+  if (keys == nil)
+    {
+      keys = [[NSArray alloc] initWithObjects:
+	@"NSServices",
+	@"NSTypes",
+	@"NSExtensions",
+	@"CFBundleDocumentTypes",
+	@"CFBundleTypeExtensions",
+	@"CFBundleURLTypes",
+	nil];
+    }
+  if (stamp != nil && [stamp isEqual: [entry objectForKey: @"Stamp"]])
+    {
+      reused++;
+      full = [entry objectForKey: @"Info"];
+      [newManifest setObject: entry forKey: path];
+      return full;
+    }
+
+  rescanned++;
+  if (isBundle)
+    {
+      full = [[NSBundle bundleWithPath: path] infoDictionary];
+    }
+  else
+    {
+      full = [NSDictionary dictionaryWithContentsOfFile: path];
+    }
+  if (full == nil)
+    {
+      return nil;
+    }
+  info = [NSMutableDictionary dictionaryWithCapacity: [keys count]];
+  for (i = 0; i < [keys count]; i++)
+    {
+      NSString	*key = [keys objectAtIndex: i];
+      id	obj = [full objectForKey: key];
+
+      if (obj != nil)
+	{
+	  [info setObject: obj forKey: key];
+	}
+    }
+  if (stamp != nil)
+    {
+      [newManifest setObject: [NSDictionary dictionaryWithObjectsAndKeys:
+	stamp, @"Stamp", info, @"Info", nil] forKey: path];
+    }
+  return info;
+}
+
 int
 main(int argc, char** argv, char **env_c)
 {
@@ -100,6 +228,7 @@ main(int argc, char** argv, char **env_c)
   NSEnumerator		*enumerator;
   NSString		*path;
   NSError *error;
+  BOOL			rescan = NO;
 
 #ifdef GS_PASS_ARGUMENTS
   [NSProcessInfo initializeWithArguments:argv count:argc environment:env_c];
@@ -142,6 +271,10 @@ main(int argc, char** argv, char **env_c)
 	{
 	  verbose--;
 	}
+      if ([[args objectAtIndex: index] isEqual: @"--rescan"])
+	{
+	  rescan = YES;
+	}
       if ([[args objectAtIndex: index] isEqual: @"--help"])
 	{
 	  printf(
@@ -152,7 +285,9 @@ main(int argc, char** argv, char **env_c)
 "You may use 'make_services --test filename' to test that the property list\n"
 "in 'filename' contains a valid services definition.\n"
 "You may use 'make_services --verbose' to produce descriptive output.\n"
-"or --quiet to suppress any output (not recommended)\n",
+"or --quiet to suppress any output (not recommended).\n"
+"Bundles which have not changed since the last run are not read again,\n"
+"use 'make_services --rescan' to read all of them.\n",
 [cacheName cString]);
 	  exit(EXIT_SUCCESS);
 	}
@@ -202,6 +337,29 @@ main(int argc, char** argv, char **env_c)
       exit(EXIT_FAILURE);
     }
 
+  /*
+   *	Load the manifest of the bundles and files scanned by the last run,
+   *	so that we only need to read those which have changed since.
+   */
+  newManifest = [NSMutableDictionary dictionaryWithCapacity: 200];
+  str = [usrRoot stringByAppendingPathComponent: manifestName];
+  if (rescan == NO && [mgr fileExistsAtPath: str])
+    {
+      data = [NSData dataWithContentsOfFile: str];
+      if (data != nil)
+	{
+	  oldMap = [NSPropertyListSerialization
+	    propertyListFromData: data
+		mutabilityOption: NSPropertyListImmutable
+			  format: NULL
+		errorDescription: NULL];
+	  if ([oldMap isKindOfClass: dClass])
+	    {
+	      oldManifest = oldMap;
+	    }
+	}
+    }
+
   /*
    *	Before doing the main scan, we examine the 'Services' directory to
    *	see if any application has registered dynamic services - these take
@@ -286,6 +444,27 @@ main(int argc, char** argv, char **env_c)
 	}
     }
 
+  if (verbose > 1)
+    {
+      NSLog(@"read %u bundles and files, %u unchanged since the last run",
+	rescanned, reused);
+    }
+  if ([newManifest isEqual: oldManifest] == NO)
+    {
+      str = [usrRoot stringByAppendingPathComponent: manifestName];
+      data = [NSPropertyListSerialization
+	dataFromPropertyList: newManifest
+		      format: NSPropertyListBinaryFormat_v1_0
+	    errorDescription: NULL];
+      if (data == nil || [data writeToFile: str atomically: YES] == NO)
+	{
+	  /* Not fatal ... the next run just reads everything again.
+	   */
+	  if (verbose > 0)
+	    NSLog(@"couldn't write %@", str);
+	}
+    }
+
   exit(EXIT_SUCCESS);
 }
 
@@ -686,7 +865,6 @@ scanApplications(NSMutableDictionary *services, NSString *path)
 	  if ([mgr fileExistsAtPath: newPath isDirectory: &isDir] && isDir)
 	    {
 	      NSString		*oldPath;
-	      NSBundle		*bundle;
 	      NSDictionary	*info;
 
 	      /*
@@ -710,8 +888,7 @@ scanApplications(NSMutableDictionary *services, NSString *path)
                   continue;
                 }
 
-	      bundle = [NSBundle bundleWithPath: newPath];
-	      info = [bundle infoDictionary];
+	      info = infoAtPath(newPath, YES);
 	      if (info)
 		{
 		  id	obj;
@@ -785,7 +962,7 @@ scanDynamic(NSMutableDictionary *services, NSString *path)
 
       infPath = [path stringByAppendingPathComponent: name];
 
-      info = [NSDictionary dictionaryWithContentsOfFile: infPath];
+      info = infoAtPath(infPath, NO);
       if (info)
 	{
 	  id	svcs = [info objectForKey: @"NSServices"];
@@ -837,11 +1014,9 @@ scanServices(NSMutableDictionary *services, NSString *path)
 	  newPath = [newPath stringByStandardizingPath];
 	  if ([mgr fileExistsAtPath: newPath isDirectory: &isDir] && isDir)
 	    {
-	      NSBundle		*bundle;
 	      NSDictionary	*info;
 
-	      bundle = [NSBundle bundleWithPath: newPath];
-	      info = [bundle infoDictionary];
+	      info = infoAtPath(newPath, YES);
 	      if (info)
 		{
 		  id	svcs = [info objectForKey: @"NSServices"];
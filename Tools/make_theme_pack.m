@@ -0,0 +1,113 @@
+/* This tool packs the resources of a theme bundle into a single file
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of the GNUstep Project
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 3
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public
+   License along with this library; see the file COPYING.
+   If not, see <http://www.gnu.org/licenses/> or write to the
+   Free Software Foundation, 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include <stdlib.h>
+#import <Foundation/NSArray.h>
+#import <Foundation/NSAutoreleasePool.h>
+#import <Foundation/NSBundle.h>
+#import <Foundation/NSData.h>
+#import <Foundation/NSFileManager.h>
+#import <Foundation/NSProcessInfo.h>
+#import <Foundation/NSString.h>
+#import <GNUstepGUI/GSThemePack.h>
+
+int
+main(int argc, char** argv, char **env_c)
+{
+  NSAutoreleasePool	*pool;
+  NSArray		*args;
+  NSString		*output = nil;
+  int			status = EXIT_SUCCESS;
+  unsigned		index;
+  unsigned		done = 0;
+
+#ifdef GS_PASS_ARGUMENTS
+  [NSProcessInfo initializeWithArguments:argv count:argc environment:env_c];
+#endif
+  pool = [NSAutoreleasePool new];
+
+  args = [[NSProcessInfo processInfo] arguments];
+  for (index = 1; index < [args count]; index++)
+    {
+      NSString	*arg = [args objectAtIndex: index];
+      NSString	*path;
+      NSBundle	*bundle;
+      NSData	*data;
+
+      if ([arg isEqual: @"--help"])
+	{
+	  printf(
+"make_theme_pack packs the images and color lists of GNUstep theme bundles\n"
+"into a single ThemePack.gstp file in the resources of each bundle, which\n"
+"the theme then uses instead of reading the files one by one.\n"
+"\n"
+"Usage: make_theme_pack [--output file] theme ...\n"
+"\n"
+"Run it again whenever the resources of a theme change.\n");
+	  exit(EXIT_SUCCESS);
+	}
+      if ([arg isEqual: @"--output"])
+	{
+	  if (++index < [args count])
+	    {
+	      output = [args objectAtIndex: index];
+	    }
+	  continue;
+	}
+
+      bundle = [NSBundle bundleWithPath: arg];
+      if (bundle == nil)
+	{
+	  NSLog(@"%@ is not a bundle", arg);
+	  status = EXIT_FAILURE;
+	  continue;
+	}
+      data = [GSThemePack packDataForBundle: bundle];
+      if (data == nil)
+	{
+	  NSLog(@"%@ has no images or color lists to pack", arg);
+	  continue;
+	}
+      path = output;
+      output = nil;
+      if (path == nil)
+	{
+	  path = [[bundle resourcePath]
+	    stringByAppendingPathComponent: @"ThemePack.gstp"];
+	}
+      if ([data writeToFile: path atomically: YES] == NO)
+	{
+	  NSLog(@"couldn't write %@", path);
+	  status = EXIT_FAILURE;
+	  continue;
+	}
+      done++;
+    }
+  if (done == 0 && status == EXIT_SUCCESS && [args count] < 2)
+    {
+      NSLog(@"no theme given, try --help");
+      status = EXIT_FAILURE;
+    }
+  [pool drain];
+  return status;
+}